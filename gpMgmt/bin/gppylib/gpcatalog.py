@@ -25,6 +25,7 @@ class GPCatalogException(Exception):
 MASTER_ONLY_TABLES = [
     'gp_segment_configuration',
     'gp_configuration_history',
+    'gp_optimizer_cost_params',
     'gp_segment_configuration',
     'pg_description',
     'pg_partition',
@@ -0,0 +1,4 @@
+\echo Use "ALTER EXTENSION gp_replica_check UPDATE TO '0.0.2'" to load this file. \quit
+CREATE FUNCTION gp_replica_check(primarydirpath text, mirrordirpath text, include_types text, worker int, num_workers int) RETURNS boolean
+AS '$libdir/gp_replica_check', 'gp_replica_check'
+LANGUAGE C STRICT;
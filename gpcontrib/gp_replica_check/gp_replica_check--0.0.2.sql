@@ -2,3 +2,7 @@
 CREATE FUNCTION gp_replica_check(primarydirpath text, mirrordirpath text, include_types text) RETURNS boolean
 AS '$libdir/gp_replica_check', 'gp_replica_check'
 LANGUAGE C STRICT;
+
+CREATE FUNCTION gp_replica_check(primarydirpath text, mirrordirpath text, include_types text, worker int, num_workers int) RETURNS boolean
+AS '$libdir/gp_replica_check', 'gp_replica_check'
+LANGUAGE C STRICT;
@@ -5,6 +5,9 @@
 #include "access/nbtree.h"
 #include "access/gist_private.h"
 #include "access/gin.h"
+#include "access/aosegfiles.h"
+#include "access/aocssegfiles.h"
+#include "access/appendonlytid.h"
 #include "commands/sequence.h"
 #include "postmaster/bgwriter.h"
 #include "replication/walsender_private.h"
@@ -14,7 +17,9 @@
 #include "storage/fd.h"
 #include "utils/builtins.h"
 #include "utils/hsearch.h"
+#include "utils/rel.h"
 #include "utils/relmapper.h"
+#include "utils/snapmgr.h"
 #include "utils/tqual.h"
 
 /*
@@ -34,6 +39,12 @@
  */
 #define WAITS_PER_SEC 5
 
+/*
+ * How many blocks to read from each file at a time. Files are compared a
+ * chunk at a time, block by block only to report where a chunk differs.
+ */
+#define CHUNK_BLOCKS	32
+
 /*
  * Not all the FSM and VM changes are WAL-logged and its OK if they are out of
  * date. So it is OK to skip them for consistency check.
@@ -54,11 +65,16 @@ extern Datum gp_replica_check(PG_FUNCTION_ARGS);
 typedef struct RelfilenodeEntry
 {
 	Oid relfilenode;
+	Oid relid;
 	int relam;
 	int relkind;
 	char relname[NAMEDATALEN];
 	char relstorage;
 	List *segments;
+
+	/* committed EOF of each segment file of an AO table, by file number */
+	int64 *ao_eofs;
+	int num_ao_eofs;
 } RelfilenodeEntry;
 
 typedef struct RelationTypeData
@@ -83,7 +99,8 @@ static RelationTypeData relation_types[MAX_INCLUDE_RELATION_TYPES] = {
 static void init_relation_types(char *include_relation_types);
 static RelationTypeData get_relation_type_data(int relam, char relstorage, int relkind);
 static void mask_block(char *pagedata, BlockNumber blkno, int relam, int relkind);
-static bool compare_files(char* primaryfilepath, char* mirrorfilepath, RelfilenodeEntry *rentry);
+static int64 get_ao_eof(RelfilenodeEntry *rentry, int filenum);
+static bool compare_files(char* primaryfilepath, char* mirrorfilepath, RelfilenodeEntry *rentry, int filenum);
 static bool sync_wait(void);
 static HTAB* get_relfilenode_map();
 static RelfilenodeEntry* get_relfilenode_entry(char *relfilenode, HTAB *relfilenode_map);
@@ -266,8 +283,82 @@ sync_wait(void)
 	return false;
 }
 
+/*
+ * Return the committed EOF of segment file 'filenum' of an AO table, from its
+ * aoseg table. Anything past it is left over from aborted or in-progress
+ * inserts, which the primary and mirror are free to disagree on.
+ *
+ * The EOFs of all the segment files are looked up on first use.
+ */
+static int64
+get_ao_eof(RelfilenodeEntry *rentry, int filenum)
+{
+	if (rentry->ao_eofs == NULL)
+	{
+		Relation	rel;
+		Snapshot	appendOnlyMetaDataSnapshot;
+		int			totalsegs;
+		int			i;
+
+		rel = heap_open(rentry->relid, AccessShareLock);
+		appendOnlyMetaDataSnapshot = RegisterSnapshot(GetLatestSnapshot());
+
+		if (RelationIsAoRows(rel))
+		{
+			FileSegInfo **segInfo;
+
+			segInfo = GetAllFileSegInfo(rel, appendOnlyMetaDataSnapshot, &totalsegs);
+
+			rentry->num_ao_eofs = AOTupleId_MultiplierSegmentFileNum;
+			rentry->ao_eofs = palloc0(rentry->num_ao_eofs * sizeof(int64));
+			for (i = 0; i < totalsegs; i++)
+				rentry->ao_eofs[segInfo[i]->segno] = segInfo[i]->eof;
+
+			if (segInfo)
+			{
+				FreeAllSegFileInfo(segInfo, totalsegs);
+				pfree(segInfo);
+			}
+		}
+		else
+		{
+			AOCSFileSegInfo **segInfo;
+			int			natts = RelationGetNumberOfAttributes(rel);
+
+			segInfo = GetAllAOCSFileSegInfo(rel, appendOnlyMetaDataSnapshot, &totalsegs);
+
+			/* file number of column 'col' in segment 'segno' is col * 128 + segno */
+			rentry->num_ao_eofs = natts * AOTupleId_MultiplierSegmentFileNum;
+			rentry->ao_eofs = palloc0(rentry->num_ao_eofs * sizeof(int64));
+			for (i = 0; i < totalsegs; i++)
+			{
+				int			col;
+
+				for (col = 0; col < segInfo[i]->vpinfo.nEntry && col < natts; col++)
+					rentry->ao_eofs[col * AOTupleId_MultiplierSegmentFileNum + segInfo[i]->segno] =
+						segInfo[i]->vpinfo.entry[col].eof;
+			}
+
+			if (segInfo)
+			{
+				FreeAllAOCSSegFileInfo(segInfo, totalsegs);
+				pfree(segInfo);
+			}
+		}
+
+		UnregisterSnapshot(appendOnlyMetaDataSnapshot);
+		heap_close(rel, AccessShareLock);
+	}
+
+	/* a file that the aoseg table doesn't know of has nothing committed */
+	if (filenum < 0 || filenum >= rentry->num_ao_eofs)
+		return 0;
+
+	return rentry->ao_eofs[filenum];
+}
+
 static bool
-compare_files(char *primaryfilepath, char *mirrorfilepath, RelfilenodeEntry *rentry)
+compare_files(char *primaryfilepath, char *mirrorfilepath, RelfilenodeEntry *rentry, int filenum)
 {
 	File		primaryFile = -1;
 	File		mirrorFile = -1;
@@ -276,9 +367,19 @@ compare_files(char *primaryfilepath, char *mirrorfilepath, RelfilenodeEntry *ren
 	bool		any_retries = false;
 	bool		primaryFileExists;
 	bool		mirrorFileExists;
+	char	   *primaryFileBuf;
+	char	   *mirrorFileBuf;
+	int64		eof = -1;
 
 	blockno = 0;
 
+	/* Only the committed part of an AO segment file has to match */
+	if (relstorage_is_ao(rentry->relstorage))
+		eof = get_ao_eof(rentry, filenum);
+
+	primaryFileBuf = palloc(CHUNK_BLOCKS * BLCKSZ);
+	mirrorFileBuf = palloc(CHUNK_BLOCKS * BLCKSZ);
+
 	/*
 	 * If there's any discrepancy between the files below, we will loop back
 	 * here. If NUM_RETRIES is reached, return error.
@@ -304,6 +405,8 @@ retry:
 				(errmsg("%s files \"%s\" and \"%s\" for relation \"%s\" mismatch at blockno %d, gave up after %d retries",
 						get_relation_type_data(rentry->relam, rentry->relstorage, rentry->relkind).name,
 						primaryfilepath, mirrorfilepath, rentry->relname, blockno, attempts)));
+		pfree(primaryFileBuf);
+		pfree(mirrorFileBuf);
 		return false;
 	}
 	attempts++;
@@ -316,7 +419,11 @@ retry:
 		 * shared buffer to disk.
 		 */
 		if (!sync_wait())
+		{
+			pfree(primaryFileBuf);
+			pfree(mirrorFileBuf);
 			return false;
+		}
 	}
 
 	/*
@@ -346,6 +453,8 @@ retry:
 	if (!primaryFileExists && !mirrorFileExists)
 	{
 		elog(NOTICE, "file \"%s\" was concurrently deleted on primary and mirror", primaryfilepath);
+		pfree(primaryFileBuf);
+		pfree(mirrorFileBuf);
 		return true;
 	}
 
@@ -362,21 +471,31 @@ retry:
 	}
 
 	/*
-	 * Otherwise, both files were opened successfully. Compare them block-by block.
+	 * Otherwise, both files were opened successfully. Compare them a chunk
+	 * of blocks at a time.
 	 *
 	 * Note: if this is not the first attempt, we keep the block number across attempts,
 	 * rather than always starting from the beginning of the file.
 	 */
 	while (true)
 	{
-		char		primaryFileBuf[BLCKSZ];
-		char		mirrorFileBuf[BLCKSZ];
 		int			primaryFileBytesRead;
 		int			mirrorFileBytesRead;
-		int			diff;
+		int			bytesToRead = CHUNK_BLOCKS * BLCKSZ;
+		int			nblocks;
+		int			i;
 
 		CHECK_FOR_INTERRUPTS();
 
+		/* Stop at the committed EOF of an AO segment file */
+		if (eof >= 0)
+		{
+			if ((int64) blockno * BLCKSZ >= eof)
+				break;
+			if (eof - (int64) blockno * BLCKSZ < bytesToRead)
+				bytesToRead = (int) (eof - (int64) blockno * BLCKSZ);
+		}
+
 		if (FileSeek(primaryFile, (int64) blockno * BLCKSZ, SEEK_SET) < 0)
 		{
 			elog(NOTICE, "seek in file \"%s\" failed: %m", primaryfilepath);
@@ -384,17 +503,17 @@ retry:
 		}
 		if (FileSeek(mirrorFile, (int64) blockno * BLCKSZ, SEEK_SET) < 0)
 		{
-			elog(NOTICE, "seek in file \"%s\" failed: %m", mirrorFileBuf);
+			elog(NOTICE, "seek in file \"%s\" failed: %m", mirrorfilepath);
 			goto retry;
 		}
 
-		primaryFileBytesRead = FileRead(primaryFile, primaryFileBuf, sizeof(primaryFileBuf));
+		primaryFileBytesRead = FileRead(primaryFile, primaryFileBuf, bytesToRead);
 		if (primaryFileBytesRead < 0)
 		{
 			elog(NOTICE, "could not read from file \"%s\", block %u: %m", primaryfilepath, blockno);
 			goto retry;
 		}
-		mirrorFileBytesRead = FileRead(mirrorFile, mirrorFileBuf, sizeof(mirrorFileBuf));
+		mirrorFileBytesRead = FileRead(mirrorFile, mirrorFileBuf, bytesToRead);
 		if (mirrorFileBytesRead < 0)
 		{
 			elog(NOTICE, "could not read from file \"%s\", block %u: %m", mirrorfilepath, blockno);
@@ -415,50 +534,73 @@ retry:
 		if (primaryFileBytesRead == 0)
 			break; /* reached EOF */
 
+		nblocks = (primaryFileBytesRead + BLCKSZ - 1) / BLCKSZ;
+
 		if (rentry->relstorage == RELSTORAGE_HEAP)
 		{
-			if (primaryFileBytesRead != BLCKSZ)
+			if (primaryFileBytesRead % BLCKSZ != 0)
 			{
-				elog(NOTICE, "short read of %d bytes from heap file \"%s\", block %u: %m", primaryFileBytesRead, primaryfilepath, blockno);
-				goto retry;
-			}
-			/*
-			 * Perform some basic sanity checks before handing the block to
-			 * mask_block(). It might throw a hard ERROR on a bogus block,
-			 * so we better catch that here so we can retry.
-			 */
-			if (!PageIsVerified(primaryFileBuf, blockno))
-			{
-				elog(NOTICE, "invalid page header or checksum in heap file \"%s\", block %u: %m", primaryfilepath, blockno);
-				goto retry;
-			}
-			if (!PageIsVerified(mirrorFileBuf, blockno))
-			{
-				elog(NOTICE, "invalid page header or checksum in heap file \"%s\", block %u: %m", mirrorfilepath, blockno);
+				elog(NOTICE, "short read of %d bytes from heap file \"%s\", block %u: %m",
+					 primaryFileBytesRead % BLCKSZ, primaryfilepath, blockno + nblocks - 1);
 				goto retry;
 			}
 
-			if (!PageIsNew(primaryFileBuf) && !PageIsNew(mirrorFileBuf))
+			for (i = 0; i < nblocks; i++)
 			{
-				mask_block(primaryFileBuf, blockno, rentry->relam, rentry->relkind);
-				mask_block(mirrorFileBuf, blockno, rentry->relam, rentry->relkind);
+				char	   *primaryPage = primaryFileBuf + i * BLCKSZ;
+				char	   *mirrorPage = mirrorFileBuf + i * BLCKSZ;
+
+				/*
+				 * Perform some basic sanity checks before handing the block to
+				 * mask_block(). It might throw a hard ERROR on a bogus block,
+				 * so we better catch that here so we can retry.
+				 */
+				if (!PageIsVerified(primaryPage, blockno + i))
+				{
+					elog(NOTICE, "invalid page header or checksum in heap file \"%s\", block %u: %m", primaryfilepath, blockno + i);
+					goto retry;
+				}
+				if (!PageIsVerified(mirrorPage, blockno + i))
+				{
+					elog(NOTICE, "invalid page header or checksum in heap file \"%s\", block %u: %m", mirrorfilepath, blockno + i);
+					goto retry;
+				}
+
+				if (!PageIsNew(primaryPage) && !PageIsNew(mirrorPage))
+				{
+					mask_block(primaryPage, blockno + i, rentry->relam, rentry->relkind);
+					mask_block(mirrorPage, blockno + i, rentry->relam, rentry->relkind);
+				}
 			}
 		}
 
-		if ((diff = memcmp(primaryFileBuf, mirrorFileBuf, primaryFileBytesRead)) != 0)
+		if (memcmp(primaryFileBuf, mirrorFileBuf, primaryFileBytesRead) != 0)
 		{
-			/* different contents */
-			ereport(NOTICE,
-					(errmsg("%s files \"%s\" and \"%s\" for relation \"%s\" mismatch by %i at blockno %u",
-							get_relation_type_data(rentry->relam, rentry->relstorage, rentry->relkind).name,
-							primaryfilepath, mirrorfilepath, rentry->relname,
-							diff, blockno)));
+			/* different contents, find the first block that differs */
+			for (i = 0; i < nblocks; i++)
+			{
+				int			len = Min(BLCKSZ, primaryFileBytesRead - i * BLCKSZ);
+				int			diff;
+
+				if ((diff = memcmp(primaryFileBuf + i * BLCKSZ, mirrorFileBuf + i * BLCKSZ, len)) != 0)
+				{
+					ereport(NOTICE,
+							(errmsg("%s files \"%s\" and \"%s\" for relation \"%s\" mismatch by %i at blockno %u",
+									get_relation_type_data(rentry->relam, rentry->relstorage, rentry->relkind).name,
+									primaryfilepath, mirrorfilepath, rentry->relname,
+									diff, blockno + i)));
+					break;
+				}
+			}
+
+			/* the blocks before that one matched, resume the retry from it */
+			blockno += i;
 			goto retry;
 		}
 
-		/* Success! Advance to next block, and reset the retry-counter */
+		/* Success! Advance to next chunk, and reset the retry-counter */
 		attempts = 1;
-		blockno++;
+		blockno += nblocks;
 	}
 
 	/* Reached end of file successfully! */
@@ -467,6 +609,8 @@ retry:
 		FileClose(primaryFile);
 	if (mirrorFile != -1)
 		FileClose(mirrorFile);
+	pfree(primaryFileBuf);
+	pfree(mirrorFileBuf);
 
 	/*
 	 * The NOTICEs about differences can make the user think that something's
@@ -524,6 +668,10 @@ get_relfilenode_map()
 
 		rentry = hash_search(relfilenodemap, (void *)&rnode, HASH_ENTER, NULL);
 		rentry->relfilenode = rnode;
+		rentry->relid = HeapTupleGetOid(tup);
+		rentry->segments = NIL;
+		rentry->ao_eofs = NULL;
+		rentry->num_ao_eofs = 0;
 		rentry->relam = classtuple->relam;
 		rentry->relkind = classtuple->relkind;
 		rentry->relstorage = classtuple->relstorage;
@@ -557,11 +705,29 @@ gp_replica_check(PG_FUNCTION_ARGS)
 	char *primarydirpath = TextDatumGetCString(PG_GETARG_DATUM(0));
 	char *mirrordirpath = TextDatumGetCString(PG_GETARG_DATUM(1));
 	char *relation_types = TextDatumGetCString(PG_GETARG_DATUM(2));
+	int worker = 0;
+	int num_workers = 1;
 	struct dirent *dent = NULL;
 	bool dir_equal = true;
 	DIR		   *primarydir;
 	DIR		   *mirrordir;
 
+	/*
+	 * The files of a segment can be split between several backends that
+	 * compare them in parallel, with the same arguments but a different
+	 * worker number each. All the files of a relation go to the same worker.
+	 */
+	if (PG_NARGS() > 3)
+	{
+		worker = PG_GETARG_INT32(3);
+		num_workers = PG_GETARG_INT32(4);
+
+		if (num_workers < 1 || worker < 0 || worker >= num_workers)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("invalid worker %d of %d workers", worker, num_workers)));
+	}
+
 	init_relation_types(relation_types);
 
 	/* TODO: Currently, we only scan the default tablespace */
@@ -599,6 +765,7 @@ gp_replica_check(PG_FUNCTION_ARGS)
 		char mirrorfilename[MAXPGPATH] = {'\0'};
 		char *d_name_copy;
 		char *relfilenode;
+		int filenum = 0;
 		bool match;
 
 		if (should_skip(dent->d_name))
@@ -611,9 +778,10 @@ gp_replica_check(PG_FUNCTION_ARGS)
 		/* not a valid relfilenode */
 		if (rentry == NULL)
 		{
-			ereport(WARNING,
-					(errmsg("relfilenode %s not present in primary's pg_class",
-							relfilenode)));
+			if (worker == 0)
+				ereport(WARNING,
+						(errmsg("relfilenode %s not present in primary's pg_class",
+								relfilenode)));
 			continue;
 		}
 
@@ -621,15 +789,22 @@ gp_replica_check(PG_FUNCTION_ARGS)
 		if (!get_relation_type_data(rentry->relam, rentry->relstorage, rentry->relkind).include)
 			continue;
 
+		/* skip if another worker compares this relation */
+		if (rentry->relfilenode % num_workers != worker)
+			continue;
+
 		d_name_copy = strtok(NULL, ".");
 		if (d_name_copy != NULL)
-			rentry->segments = lappend_int(rentry->segments, atoi(d_name_copy));
+		{
+			filenum = atoi(d_name_copy);
+			rentry->segments = lappend_int(rentry->segments, filenum);
+		}
 
 		snprintf(primaryfilename, MAXPGPATH, "%s/%s", primarydirpath, dent->d_name);
 		snprintf(mirrorfilename, MAXPGPATH, "%s/%s", mirrordirpath, dent->d_name);
 
 		/* do the file comparison */
-		match = compare_files(primaryfilename, mirrorfilename, rentry);
+		match = compare_files(primaryfilename, mirrorfilename, rentry, filenum);
 		dir_equal = dir_equal && match;
 	}
 	FreeDir(primarydir);
@@ -652,6 +827,9 @@ gp_replica_check(PG_FUNCTION_ARGS)
 
 		if (rentry != NULL)
 		{
+			if (rentry->relfilenode % num_workers != worker)
+				continue;
+
 			d_name_copy = strtok(NULL, ".");
 			if (d_name_copy != NULL)
 			{
@@ -674,7 +852,7 @@ gp_replica_check(PG_FUNCTION_ARGS)
 									dent->d_name)));
 			}
 		}
-		else
+		else if (worker == 0)
 			ereport(WARNING,
 					(errmsg("found extra unknown file on mirror: %s/%s",
 							mirrordirpath, dent->d_name)));
@@ -15,6 +15,10 @@ will utilize the internal masking functions to ensure that false
 mismatches are not reported such as header or hint-bit mismatches. The
 user is able to specify what relation types and databases they would
 like to validate or it defaults to all.
+
+The checks of the segments run one after another, unless -p asks for
+several of them to run at once. With -w, the files of each segment are
+split between that many sessions, which compare them in parallel.
 ======================================================================
 
 Note:
@@ -26,6 +30,7 @@ gp_replica_check.py
 gp_replica_check.py -d "mydb1,mydb2,..."
 gp_replica_check.py -r "heap,ao,btree,..."
 gp_replica_check.py -d "mydb1,mydb2,..." -r "hash,bitmap,gist,..."
+gp_replica_check.py -p 8 -w 4
 '''
 
 import argparse
@@ -36,7 +41,7 @@ import Queue
 import pipes  # for shell-quoting, pipes.quote()
 
 class ReplicaCheck(threading.Thread):
-    def __init__(self, segrow, datname, relation_types):
+    def __init__(self, segrow, datname, relation_types, worker=0, num_workers=1, semaphore=None):
         super(ReplicaCheck, self).__init__()
         self.host = segrow[0]
         self.port = segrow[1]
@@ -46,27 +51,43 @@ class ReplicaCheck(threading.Thread):
         self.mloc = segrow[5]
         self.datname = datname
         self.relation_types = relation_types;
+        self.worker = worker
+        self.num_workers = num_workers
+        self.semaphore = semaphore
         self.result = False
 
     def __str__(self):
-        return 'Host: %s, Port: %s, Database: %s\n\
+        return 'Host: %s, Port: %s, Database: %s, Worker: %d of %d\n\
 Primary Data Directory Location: %s\n\
 Mirror Data Directory Location: %s' % (self.host, self.port, self.datname,
+                                          self.worker + 1, self.num_workers,
                                           self.ploc, self.mloc)
 
     def run(self):
-        print(self)
-        cmd = '''PGOPTIONS='-c gp_session_role=utility' psql -h %s -p %s -c "select * from gp_replica_check('%s', '%s', '%s')" %s''' % (self.host, self.port,
-                                                                                                                                        self.ploc, self.mloc,
-                                                                                                                                        self.relation_types,
-                                                                                                                                        pipes.quote(self.datname))
+        if self.semaphore:
+            with self.semaphore:
+                self.check()
+        else:
+            self.check()
+
+    def check(self):
+        if self.num_workers > 1:
+            args = "'%s', '%s', '%s', %d, %d" % (self.ploc, self.mloc, self.relation_types,
+                                                 self.worker, self.num_workers)
+        else:
+            args = "'%s', '%s', '%s'" % (self.ploc, self.mloc, self.relation_types)
+        cmd = '''PGOPTIONS='-c gp_session_role=utility' psql -h %s -p %s -c "select * from gp_replica_check(%s)" %s''' % (self.host, self.port,
+                                                                                                                  args,
+                                                                                                                  pipes.quote(self.datname))
 
         if self.primary_status.strip() == 'd':
             print "Primary segment for content %d is down" % self.content
         else:
             try:
                 res = subprocess.check_output(cmd, stderr=subprocess.STDOUT, shell=True)
-                print res
+                # print the header together with the output, so that the
+                # output of checks running at the same time doesn't interleave
+                print '%s\n%s' % (self, res)
                 self.result = True if res.strip().split('\n')[-2].strip() == 't' else False
             except subprocess.CalledProcessError, e:
                 print 'returncode: (%s), cmd: (%s), output: (%s)' % (e.returncode, e.cmd, e.output)
@@ -94,7 +115,7 @@ the test. Please check the server logs to find why.'''
 
 def install_extension(databases):
     get_datname_sql = ''' SELECT datname FROM pg_database WHERE datname != 'template0' '''
-    create_ext_sql = ''' CREATE EXTENSION IF NOT EXISTS gp_replica_check '''
+    create_ext_sql = ''' CREATE EXTENSION IF NOT EXISTS gp_replica_check; ALTER EXTENSION gp_replica_check UPDATE '''
 
     database_list = map(str.strip, databases.split(','))
     print "Creating gp_replica_check extension on databases if needed:"
@@ -143,15 +164,20 @@ SELECT datname FROM pg_catalog.pg_database WHERE datname != 'template0'
 
     return dblist
 
-def start_verification(segmap, dblist, relation_types):
+def start_verification(segmap, dblist, relation_types, parallel, workers):
     replica_check_list = []
+    semaphore = threading.BoundedSemaphore(parallel)
     for content, seglist in segmap.items():
         for segrow in seglist:
             for dbname in dblist:
-                replica_check = ReplicaCheck(segrow, dbname, relation_types)
-                replica_check_list.append(replica_check)
-                replica_check.start()
-                replica_check.join()
+                for worker in range(workers):
+                    replica_check = ReplicaCheck(segrow, dbname, relation_types,
+                                                 worker, workers, semaphore)
+                    replica_check_list.append(replica_check)
+                    replica_check.start()
+
+    for replica_check in replica_check_list:
+        replica_check.join()
 
     for replica_check in replica_check_list:
         if not replica_check.result:
@@ -166,6 +192,10 @@ def defargs():
                         help='Database names to run replication check on')
     parser.add_argument('--relation-types', '-r', type=str, required=False, default='all',
                         help='Relation types to run replication check on')
+    parser.add_argument('--parallel', '-p', type=int, required=False, default=1,
+                        help='Number of checks to run at the same time')
+    parser.add_argument('--workers', '-w', type=int, required=False, default=1,
+                        help='Number of sessions to split the check of each segment between')
 
     return parser.parse_args()
 
@@ -173,5 +203,6 @@ if __name__ == '__main__':
     args = defargs()
     install_extension(args.databases)
     create_restartpoint_on_ckpt_record_replay(True)
-    start_verification(get_segments(), get_databases(args.databases), args.relation_types)
+    start_verification(get_segments(), get_databases(args.databases), args.relation_types,
+                       max(args.parallel, 1), max(args.workers, 1))
     create_restartpoint_on_ckpt_record_replay(False)
@@ -304,3 +304,373 @@ void serializeSparseData(char *target, SparseData source)
 		((StringInfo)(SDATA_INDEX_SINFO(target)))->data = NULL;
 	}
 }
+
+/*------------------------------------------------------------------------------
+ * Kernels for vectors of float8 values
+ *
+ * The reductions keep SVEC_LANES partial results that the compiler vectorizes,
+ * SparseData.o is built with CFLAGS_VECTOR.  Where the compiler supports it,
+ * they are also built for AVX2 and AVX-512, and the loader picks the version
+ * the CPU supports.  Neither target enables FMA and the partial results are
+ * always added up in the same order, so every version returns the same result.
+ * Fewer than SVEC_LANES values are added up in order.
+ *
+ * Operations between two vectors of runs merge the runs of both, without
+ * branching on which of the runs ends first.
+ *------------------------------------------------------------------------------
+ */
+#define SVEC_LANES 8
+
+#if defined(__x86_64__) && defined(__GLIBC__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define SVEC_KERNEL __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef SVEC_KERNEL
+#define SVEC_KERNEL
+#endif
+
+/*
+ * Set accum to the sum of term(i) for i in 0..n-1, term being a macro
+ */
+#define SVEC_REDUCE(accum, n, term) \
+	do { \
+		double lanes_[SVEC_LANES] = {0.}; \
+		int i_ = 0; \
+		for (; i_ + SVEC_LANES <= (n); i_ += SVEC_LANES) \
+			for (int k_ = 0; k_ < SVEC_LANES; k_++) \
+				lanes_[k_] += term(i_ + k_); \
+		(accum) = 0.; \
+		for (int k_ = 0; k_ < SVEC_LANES; k_++) \
+			(accum) += lanes_[k_]; \
+		for (; i_ < (n); i_++) \
+			(accum) += term(i_); \
+	} while (0)
+
+#define dot_term(i)		(left[(i)]*right[(i)])
+#define sum_term(i)		(vals[(i)])
+#define sumsq_term(i)	(vals[(i)]*vals[(i)])
+#define sumabs_term(i)	(ABS(vals[(i)]))
+#define runs_sum_term(i)	(vals[(i)]*lens[(i)])
+#define runs_sumsq_term(i)	((vals[(i)]*vals[(i)])*lens[(i)])
+#define runs_sumabs_term(i)	(ABS(vals[(i)])*lens[(i)])
+
+SVEC_KERNEL double
+float8_dot(const double *left, const double *right, int n)
+{
+	double accum;
+	SVEC_REDUCE(accum, n, dot_term);
+	return accum;
+}
+
+SVEC_KERNEL double
+float8_sum(const double *vals, int n)
+{
+	double accum;
+	SVEC_REDUCE(accum, n, sum_term);
+	return accum;
+}
+
+SVEC_KERNEL double
+float8_sumsq(const double *vals, int n)
+{
+	double accum;
+	SVEC_REDUCE(accum, n, sumsq_term);
+	return accum;
+}
+
+SVEC_KERNEL double
+float8_sumabs(const double *vals, int n)
+{
+	double accum;
+	SVEC_REDUCE(accum, n, sumabs_term);
+	return accum;
+}
+
+SVEC_KERNEL double
+float8_runs_sum(const double *vals, const int64 *lens, int n)
+{
+	double accum;
+	SVEC_REDUCE(accum, n, runs_sum_term);
+	return accum;
+}
+
+SVEC_KERNEL double
+float8_runs_sumsq(const double *vals, const int64 *lens, int n)
+{
+	double accum;
+	SVEC_REDUCE(accum, n, runs_sumsq_term);
+	return accum;
+}
+
+SVEC_KERNEL double
+float8_runs_sumabs(const double *vals, const int64 *lens, int n)
+{
+	double accum;
+	SVEC_REDUCE(accum, n, runs_sumabs_term);
+	return accum;
+}
+
+/*
+ * Do one of subtract, add, multiply, or divide depending on the value of
+ * operation (0,1,2,3), between each of the n values of left and right
+ */
+SVEC_KERNEL void
+float8_op(int operation, const double *left, const double *right,
+		double *result, int n)
+{
+	switch (operation)
+	{
+		case 0:
+			for (int i=0; i<n; i++)
+				result[i] = left[i] - right[i];
+			break;
+		case 1:
+		default:
+			for (int i=0; i<n; i++)
+				result[i] = left[i] + right[i];
+			break;
+		case 2:
+			for (int i=0; i<n; i++)
+				result[i] = left[i] * right[i];
+			break;
+		case 3:
+			for (int i=0; i<n; i++)
+				result[i] = left[i] / right[i];
+			break;
+	}
+}
+
+/*
+ * Decode the run lengths of the index of sdata, followed by a 0 so that the
+ * run after the last one can be read, into buf if it has room for buflen
+ * lengths, otherwise into a palloc'd array.  Callers pfree the result if it
+ * isn't buf.
+ */
+int64 *
+sdata_run_lengths(SparseData sdata, int64 *buf, int buflen)
+{
+	int n = sdata->unique_value_count;
+	int64 *lens = (n + 1 <= buflen) ? buf :
+		(int64 *)palloc(sizeof(int64)*(n + 1));
+	char *ix = sdata->index->data;
+
+	for (int i=0; i<n; i++)
+	{
+		/* run lengths below 128 are a single byte, the common case */
+		if (ix != NULL && *ix <= 0)
+		{
+			lens[i] = -(*ix);
+			ix++;
+		}
+		else
+		{
+			lens[i] = compword_to_int8(ix);
+			ix += int8compstoragesize(ix);
+		}
+	}
+	lens[n] = 0;
+
+	return lens;
+}
+
+#define SVEC_RUNS_BUFLEN 256
+
+/*
+ * Dot product of the runs of two vectors of the same dimension
+ */
+static double
+float8_runs_dot(const double *lvals, const int64 *llens, int nl,
+		const double *rvals, const int64 *rlens, int nr)
+{
+	double accum = 0.;
+	int i = 0, j = 0;
+	int64 pos = 0;
+	int64 lend = llens[0], rend = rlens[0];
+
+	while (i < nl && j < nr)
+	{
+		int64 end = MIN(lend, rend);
+		int left_done = (lend == end);
+		int right_done = (rend == end);
+
+		accum += (lvals[i]*rvals[j])*(end - pos);
+		pos = end;
+
+		i += left_done;
+		j += right_done;
+		lend += left_done*llens[i];
+		rend += right_done*rlens[j];
+	}
+
+	return accum;
+}
+
+/*
+ * Do the operation (0,1,2,3 for subtract, add, multiply, divide) between the
+ * runs of two vectors of the same dimension.  The result has a run wherever
+ * either has one, it is returned in vals and lens, which have room for
+ * nl + nr runs, and the number of runs is returned.
+ */
+static int
+float8_runs_op(int operation, const double *lvals, const int64 *llens, int nl,
+		const double *rvals, const int64 *rlens, int nr,
+		double *vals, int64 *lens)
+{
+	int i = 0, j = 0, n = 0;
+	int64 pos = 0;
+	int64 lend = llens[0], rend = rlens[0];
+
+	while (i < nl && j < nr)
+	{
+		int64 end = MIN(lend, rend);
+		int left_done = (lend == end);
+		int right_done = (rend == end);
+
+		switch (operation)
+		{
+			case 0:
+				vals[n] = lvals[i] - rvals[j];
+				break;
+			case 1:
+			default:
+				vals[n] = lvals[i] + rvals[j];
+				break;
+			case 2:
+				vals[n] = lvals[i] * rvals[j];
+				break;
+			case 3:
+				vals[n] = lvals[i] / rvals[j];
+				break;
+		}
+		lens[n++] = end - pos;
+		pos = end;
+
+		i += left_done;
+		j += right_done;
+		lend += left_done*llens[i];
+		rend += right_done*rlens[j];
+	}
+
+	return n;
+}
+
+static inline bool
+sdata_is_dense(SparseData sdata)
+{
+	return sdata->unique_value_count == sdata->total_value_count;
+}
+
+/*
+ * Dot product of two SparseData of float8 values
+ */
+double
+float8_sdata_dot(SparseData left, SparseData right)
+{
+	int64 lbuf[SVEC_RUNS_BUFLEN], rbuf[SVEC_RUNS_BUFLEN];
+	int64 *llens, *rlens;
+	double accum;
+
+	check_sdata_dimensions(left,right);
+
+	if (sdata_is_dense(left) && sdata_is_dense(right))
+		return float8_dot((double *)left->vals->data,
+				(double *)right->vals->data, left->total_value_count);
+
+	llens = sdata_run_lengths(left, lbuf, SVEC_RUNS_BUFLEN);
+	rlens = sdata_run_lengths(right, rbuf, SVEC_RUNS_BUFLEN);
+
+	accum = float8_runs_dot((double *)left->vals->data, llens,
+			left->unique_value_count,
+			(double *)right->vals->data, rlens,
+			right->unique_value_count);
+
+	if (llens != lbuf)
+		pfree(llens);
+	if (rlens != rbuf)
+		pfree(rlens);
+
+	return accum;
+}
+
+/*
+ * Do one of subtract, add, multiply, or divide depending on the value of
+ * operation (0,1,2,3) between two SparseData of float8 values, see
+ * op_sdata_by_sdata()
+ */
+SparseData
+float8_op_sdata_by_sdata(int operation, SparseData left, SparseData right)
+{
+	int64 lbuf[SVEC_RUNS_BUFLEN], rbuf[SVEC_RUNS_BUFLEN];
+	int64 *llens, *rlens, *lens;
+	double *vals;
+	int n;
+	SparseData sdata;
+
+	check_sdata_dimensions(left,right);
+
+	if ((operation > 3)|| (operation < 0))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("operation not in range 0-3")));
+
+	if (left->total_value_count == 0)
+		return makeSparseData();
+
+	if (sdata_is_dense(left) && sdata_is_dense(right))
+	{
+		n = left->total_value_count;
+		vals = (double *)palloc(sizeof(double)*n);
+		float8_op(operation, (double *)left->vals->data,
+				(double *)right->vals->data, vals, n);
+		sdata = float8arr_to_sdata(vals, n);
+		pfree(vals);
+		return sdata;
+	}
+
+	llens = sdata_run_lengths(left, lbuf, SVEC_RUNS_BUFLEN);
+	rlens = sdata_run_lengths(right, rbuf, SVEC_RUNS_BUFLEN);
+
+	n = left->unique_value_count + right->unique_value_count;
+	vals = (double *)palloc(sizeof(double)*n);
+	lens = (int64 *)palloc(sizeof(int64)*n);
+
+	n = float8_runs_op(operation, (double *)left->vals->data, llens,
+			left->unique_value_count,
+			(double *)right->vals->data, rlens,
+			right->unique_value_count, vals, lens);
+
+	/*
+	 * Adjacent runs with the same value are one run of the result, like in
+	 * float8arr_to_sdata()
+	 */
+	sdata = makeSparseData();
+	sdata->type_of_data = FLOAT8OID;
+	{
+		int run = 0;
+		int64 run_len = lens[0];
+
+		for (int i=1; i<n; i++)
+		{
+			if (memcmp(&vals[i],&vals[run],sizeof(float8)))
+			{
+				add_run_to_sdata((char *)&vals[run], run_len,
+						sizeof(float8), sdata);
+				run = i;
+				run_len = lens[i];
+			}
+			else
+				run_len += lens[i];
+		}
+		add_run_to_sdata((char *)&vals[run], run_len, sizeof(float8), sdata);
+	}
+
+	if (llens != lbuf)
+		pfree(llens);
+	if (rlens != rbuf)
+		pfree(rlens);
+	pfree(vals);
+	pfree(lens);
+
+	return sdata;
+}
@@ -143,6 +143,20 @@ SparseData arr_to_sdata(char *array, size_t width, Oid type_of_data, int count);
 double *sdata_to_float8arr(SparseData sdata);
 StringInfo copyStringInfo(StringInfo source_sinfo);
 StringInfo makeStringInfoFromData(char *data,int len);
+
+double float8_dot(const double *left, const double *right, int n);
+double float8_sum(const double *vals, int n);
+double float8_sumsq(const double *vals, int n);
+double float8_sumabs(const double *vals, int n);
+double float8_runs_sum(const double *vals, const int64 *lens, int n);
+double float8_runs_sumsq(const double *vals, const int64 *lens, int n);
+double float8_runs_sumabs(const double *vals, const int64 *lens, int n);
+void float8_op(int operation, const double *left, const double *right,
+		double *result, int n);
+int64 *sdata_run_lengths(SparseData sdata, int64 *buf, int buflen);
+double float8_sdata_dot(SparseData left, SparseData right);
+SparseData float8_op_sdata_by_sdata(int operation, SparseData left,
+		SparseData right);
 static inline void int8_to_compword(int64 num, char entry[9]);
 
 static inline size_t
@@ -628,51 +642,43 @@ static inline bool sparsedata_eq(SparseData left, SparseData right)
 	return(1);
 }
 
-static inline double sum_sdata_values_double(SparseData sdata)
+/*
+ * Sum over the values of a SparseData of float8 values, weighted by their run
+ * lengths, with the kernel for dense values or the one for runs
+ */
+static inline double reduce_sdata_values_double(SparseData sdata,
+		double (*dense_kernel)(const double *, int),
+		double (*runs_kernel)(const double *, const int64 *, int))
 {
-	double accum=0.;
-	char *ix = sdata->index->data;
 	double *vals = (double *)sdata->vals->data;
-	int64 run_length;
+	int64 buf[64];
+	int64 *lens;
+	double accum;
 
-	for (int i=0;i<sdata->unique_value_count;i++)
-	{
-		run_length = compword_to_int8(ix);
-		accum += vals[i]*run_length;
-		ix+=int8compstoragesize(ix);
-	}
+	if (sdata->unique_value_count == sdata->total_value_count)
+		return (dense_kernel(vals, sdata->unique_value_count));
+
+	lens = sdata_run_lengths(sdata, buf, 64);
+	accum = runs_kernel(vals, lens, sdata->unique_value_count);
+	if (lens != buf)
+		pfree(lens);
 	return (accum);
 }
+
+static inline double sum_sdata_values_double(SparseData sdata)
+{
+	return (reduce_sdata_values_double(sdata, float8_sum, float8_runs_sum));
+}
 static inline double l2norm_sdata_values_double(SparseData sdata)
 {
-	double accum=0.;
-	char *ix = sdata->index->data;
-	double *vals = (double *)sdata->vals->data;
-	int64 run_length;
-
-	for (int i=0;i<sdata->unique_value_count;i++)
-	{
-		run_length = compword_to_int8(ix);
-		accum += (vals[i]*vals[i])*run_length;
-		ix+=int8compstoragesize(ix);
-	}
-	accum = sqrt(accum);
-	return (accum);
+	double accum = reduce_sdata_values_double(sdata, float8_sumsq,
+			float8_runs_sumsq);
+	return (sqrt(accum));
 }
 static inline double l1norm_sdata_values_double(SparseData sdata)
 {
-	double accum=0.;
-	char *ix = sdata->index->data;
-	double *vals = (double *)sdata->vals->data;
-	int64 run_length;
-
-	for (int i=0;i<sdata->unique_value_count;i++)
-	{
-		run_length = compword_to_int8(ix);
-		accum += ABS(vals[i])*run_length;
-		ix+=int8compstoragesize(ix);
-	}
-	return (accum);
+	return (reduce_sdata_values_double(sdata, float8_sumabs,
+			float8_runs_sumabs));
 }
 
 /*------------------------------------------------------------------------------
@@ -689,6 +695,10 @@ static inline double l1norm_sdata_values_double(SparseData sdata)
 static inline SparseData op_sdata_by_sdata(int operation,SparseData left,
 		SparseData right)
 {
+	/* float8 values, those of svec, have kernels of their own */
+	if (left->type_of_data == FLOAT8OID && right->type_of_data == FLOAT8OID)
+		return (float8_op_sdata_by_sdata(operation, left, right));
+
 	SparseData sdata = makeSparseData();
 
 	/*
@@ -457,13 +457,10 @@ svec_dot(PG_FUNCTION_ARGS)
 	SvecType *svec2 = PG_GETARG_SVECTYPE_P(1);
 	SparseData left  = sdata_from_svec(svec1);
 	SparseData right = sdata_from_svec(svec2);
-	SparseData mult_result;
 	double accum;
 	check_dimension(svec1,svec2,"svec_dot");
 
-	mult_result = op_sdata_by_sdata(2,left,right);
-	accum = sum_sdata_values_double(mult_result);
-	freeSparseDataAndData(mult_result);
+	accum = float8_sdata_dot(left,right);
 
 	PG_RETURN_FLOAT8(accum);
 }
@@ -819,14 +816,11 @@ float8arr_dot(PG_FUNCTION_ARGS) {
 	ArrayType *arr_right  = PG_GETARG_ARRAYTYPE_P(1);
 	SparseData left  = sdata_uncompressed_from_float8arr_internal(arr_left);
 	SparseData right = sdata_uncompressed_from_float8arr_internal(arr_right);
-	SparseData mult_result;
 	double accum;
 
-	mult_result = op_sdata_by_sdata(2,left,right);
-	accum = sum_sdata_values_double(mult_result);
+	accum = float8_sdata_dot(left,right);
 	freeSparseData(left);
 	freeSparseData(right);
-	freeSparseDataAndData(mult_result);
 
 	PG_RETURN_FLOAT8(accum);
 }
@@ -979,12 +973,9 @@ svec_dot_float8arr(PG_FUNCTION_ARGS)
 	ArrayType *arr = PG_GETARG_ARRAYTYPE_P(1);
 	SparseData right = sdata_uncompressed_from_float8arr_internal(arr);
 	SparseData left = sdata_from_svec(svec);
-	SparseData mult_result;
 	double accum;
-	mult_result = op_sdata_by_sdata(2,left,right);
-	accum = sum_sdata_values_double(mult_result);
+	accum = float8_sdata_dot(left,right);
 	freeSparseData(right);
-	freeSparseDataAndData(mult_result);
 
 	PG_RETURN_FLOAT8(accum);
 }
@@ -996,12 +987,9 @@ float8arr_dot_svec(PG_FUNCTION_ARGS)
 	SvecType *svec = PG_GETARG_SVECTYPE_P(1);
 	SparseData left = sdata_uncompressed_from_float8arr_internal(arr);
 	SparseData right = sdata_from_svec(svec);
-	SparseData mult_result;
 	double accum;
-	mult_result = op_sdata_by_sdata(2,left,right);
-	accum = sum_sdata_values_double(mult_result);
+	accum = float8_sdata_dot(left,right);
 	freeSparseData(left);
-	freeSparseDataAndData(mult_result);
 
 	PG_RETURN_FLOAT8(accum);
 }
@@ -11,9 +11,15 @@ volatile bool QueryCancelPending = false;
 static bool uploadS3(const char *urlWithOptions, const char *fileToUpload);
 static bool downloadS3(const char *urlWithOptions);
 static bool checkConfig(const char *urlWithOptions);
+static bool benchmarkS3(const char *urlWithOptions);
+static bool bulkDownloadS3(const char *urlWithOptions, uint64_t numOfWorkers,
+                           const string &outputDir);
+static bool bulkUploadS3(const char *urlWithOptions, const char *fileToUpload,
+                         uint64_t numOfWorkers);
 static void printBucketContents(const ListBucketResult &result);
 static void printTemplate();
 static void validateCommandLineArgs(map<char, string> &optionPairs);
+static uint64_t takeBulkOptions(map<char, string> &optionPairs, string &outputDir);
 static map<char, string> parseCommandLineArgs(int argc, char *argv[]);
 static void registerSignalHandler();
 static void printUsage(FILE *stream);
@@ -55,6 +61,15 @@ static void printUsage(FILE *stream) {
             "config=path_to_config_file [region=region_name]\", to download and output to stdout.\n"
             "       gpcheckcloud -u \"/path/to/file\" \"s3://endpoint/bucket/prefix "
             "config=path_to_config_file [region=region_name]\", to upload a file.\n"
+            "       gpcheckcloud -b \"s3://endpoint/bucket/prefix "
+            "config=path_to_config_file [region=region_name]\", to benchmark downloading and uploading.\n"
+            "       gpcheckcloud -d \"s3://endpoint/bucket/prefix "
+            "config=path_to_config_file [region=region_name]\" -p workers [-o /path/to/dir], "
+            "to download the keys in parallel, to stdout in the order of listing or to files in "
+            "the directory.\n"
+            "       gpcheckcloud -u \"/path/to/file\" \"s3://endpoint/bucket/prefix "
+            "config=path_to_config_file [region=region_name]\" -p workers, to upload parts of a "
+            "file in parallel, one key for each worker.\n"
             "       gpcheckcloud -t, to show the config template.\n"
             "       gpcheckcloud -h, to show this help.\n");
 }
@@ -64,10 +79,13 @@ static map<char, string> parseCommandLineArgs(int argc, char *argv[]) {
     int opt = 0;
     map<char, string> optionPairs;
 
-    while ((opt = getopt(argc, argv, "c:d:u:ht")) != -1) {
+    while ((opt = getopt(argc, argv, "b:c:d:o:p:u:ht")) != -1) {
         switch (opt) {
+            case 'b':
             case 'c':
             case 'd':
+            case 'o':
+            case 'p':
             case 'h':
             case 't':
                 if (optarg == NULL) {
@@ -84,9 +102,9 @@ static map<char, string> parseCommandLineArgs(int argc, char *argv[]) {
             case 'u':
                 if (optarg == NULL) {
                     optionPairs[opt] = "";
-                } else if (optind + 1 == argc) {      // has two option values
-                    optionPairs['f'] = optarg;        // value of option file
-                    optionPairs['u'] = argv[optind];  // value of option url
+                } else if ((optind < argc) && (argv[optind][0] != '-')) {  // has two option values
+                    optionPairs['f'] = optarg;                             // value of option file
+                    optionPairs['u'] = argv[optind++];                     // value of option url
                 } else {
                     fprintf(stderr, "Failed. Invalid arguments for -u, please check.\n\n");
                     printUsage(stderr);
@@ -135,6 +153,41 @@ static void validateCommandLineArgs(map<char, string> &optionPairs) {
     }
 }
 
+// Remove the options of the bulk mode, which go with -d or -u. Return the number of workers, 0 if
+// it is not the bulk mode.
+static uint64_t takeBulkOptions(map<char, string> &optionPairs, string &outputDir) {
+    if ((optionPairs.count('p') == 0) && (optionPairs.count('o') == 0)) {
+        return 0;
+    }
+
+    uint64_t numOfWorkers = BULK_DEFAULT_WORKERS;
+    if (optionPairs.count('p') != 0) {
+        char *end = NULL;
+        numOfWorkers = strtoull(optionPairs['p'].c_str(), &end, 10);
+        if ((*end != '\0') || (numOfWorkers == 0) || (numOfWorkers > BULK_MAX_WORKERS)) {
+            fprintf(stderr, "Failed. The number of workers must be in [1, %d].\n\n",
+                    BULK_MAX_WORKERS);
+            printUsage(stderr);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // -o only works with -d.
+    bool download = (optionPairs.count('d') != 0);
+    bool upload = (optionPairs.count('u') != 0) && (optionPairs.count('o') == 0);
+    if (!download && !upload) {
+        fprintf(stderr, "Failed. Option '-p' must work with '-d' or '-u', '-o' with '-d'.\n\n");
+        printUsage(stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    outputDir = optionPairs['o'];
+    optionPairs.erase('o');
+    optionPairs.erase('p');
+
+    return numOfWorkers;
+}
+
 static void printTemplate() {
     printf(
         "[default]\n"
@@ -147,8 +200,34 @@ static void printTemplate() {
         "encryption = true\n"
         "version = 1\n"
         "proxy = \"\"\n"
+        "list_cache_dir = \"\"\n"
+        "list_cache_ttl = 60\n"
+        "list_parallelism = 1\n"
+        "list_shard_prefixes = \"\"\n"
+        "read_cache_dir = \"\"\n"
+        "read_cache_size = 1024\n"
+        "retry_backoff = 100\n"
+        "request_rate = 0\n"
+        "request_rate_dir = /tmp\n"
+        "rollover_size = 0\n"
+        "prefetch_keys = 0\n"
+        "small_key_size = 1024\n"
+        "memory_pool_size = 0\n"
+        "memory_pool_idle_time = 60\n"
+        "row_group_size = 64\n"
+        "range_coalesce_gap = 1024\n"
+        "export_format = text\n"
+        "parquet_codec = gzip\n"
         "autocompress = true\n"
         "verifycert = true\n"
+        "adaptive_download = false\n"
+        "multiplex_io = false\n"
+        "hedged_fetch = false\n"
+        "s3_select = false\n"
+        "conditional_write = false\n"
+        "memory_pool_huge_pages = false\n"
+        "split_compressed = false\n"
+        "crc32c_checksum = false\n"
         "server_side_encryption = \"\"\n"
         "# gpcheckcloud config\n"
         "gpcheckcloud_newline = \"\\n\"\n");
@@ -278,6 +357,749 @@ static bool uploadS3(const char *urlWithOptions, const char *fileToUpload) {
     return ret;
 }
 
+// Counters of requests sent by each thread, to tell the throughput of a single connection.
+class BenchmarkRESTfulService : public S3RESTfulService {
+   public:
+    struct ThreadStats {
+        ThreadStats() : requests(0), bytes(0), busyUs(0) {
+        }
+
+        uint64_t requests;
+        uint64_t bytes;
+        uint64_t busyUs;
+    };
+
+    BenchmarkRESTfulService(const S3Params &params) : S3RESTfulService(params) {
+        pthread_mutex_init(&this->mutex, NULL);
+    }
+    virtual ~BenchmarkRESTfulService() {
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    virtual Response get(const string &url, HTTPHeaders &headers) {
+        uint64_t startUs = GetCurrentTimeUs();
+        Response response = S3RESTfulService::get(url, headers);
+        this->record(response.getRawData().size(), GetCurrentTimeUs() - startUs);
+        return response;
+    }
+
+    virtual Response put(const string &url, HTTPHeaders &headers, const S3VectorUInt8 &data) {
+        uint64_t startUs = GetCurrentTimeUs();
+        Response response = S3RESTfulService::put(url, headers, data);
+        this->record(data.size(), GetCurrentTimeUs() - startUs);
+        return response;
+    }
+
+    map<pthread_t, ThreadStats> getStats() {
+        UniqueLock lock(&this->mutex);
+        return this->stats;
+    }
+
+   private:
+    void record(uint64_t bytes, uint64_t busyUs) {
+        UniqueLock lock(&this->mutex);
+        ThreadStats &threadStats = this->stats[pthread_self()];
+        threadStats.requests++;
+        threadStats.bytes += bytes;
+        threadStats.busyUs += busyUs;
+    }
+
+    pthread_mutex_t mutex;
+    map<pthread_t, ThreadStats> stats;
+};
+
+class BenchmarkReader : public GPReader {
+   public:
+    BenchmarkReader(const S3Params &params) : GPReader(params), timedService(this->params) {
+        this->restfulServicePtr = &this->timedService;
+    }
+
+    BenchmarkRESTfulService timedService;
+};
+
+class BenchmarkWriter : public GPWriter {
+   public:
+    BenchmarkWriter(const S3Params &params, const string &fmt)
+        : GPWriter(params, fmt), timedService(this->params) {
+        this->restfulServicePtr = &this->timedService;
+    }
+
+    BenchmarkRESTfulService timedService;
+};
+
+// Lends data kept in memory, the upstream of decompression in the benchmark.
+class BenchmarkBufferReader : public Reader {
+   public:
+    BenchmarkBufferReader(const S3VectorUInt8 &data) : data(data), offset(0) {
+    }
+
+    virtual void open(const S3Params &params) {
+        this->offset = 0;
+    }
+
+    virtual uint64_t read(char *buf, uint64_t count) {
+        const char *view = NULL;
+        uint64_t len = this->readView(&view, count);
+        memcpy(buf, view, len);
+        return len;
+    }
+
+    virtual uint64_t readView(const char **view, uint64_t count) {
+        uint64_t len = std::min(count, (uint64_t)this->data.size() - this->offset);
+        *view = (const char *)this->data.data() + this->offset;
+        this->offset += len;
+        return len;
+    }
+
+    virtual void close() {
+    }
+
+   private:
+    const S3VectorUInt8 &data;
+    uint64_t offset;
+};
+
+// at most this many bytes of a compressed key are downloaded to measure decompression.
+#define BENCHMARK_DECOMPRESS_SAMPLE_SIZE (64 * 1024 * 1024)
+
+#define BENCHMARK_SIGN_ROUNDS 10000
+
+static double toMB(uint64_t bytes) {
+    return bytes / 1024.0 / 1024.0;
+}
+
+static double toMBps(uint64_t bytes, uint64_t us) {
+    return us == 0 ? 0 : toMB(bytes) * 1000000.0 / us;
+}
+
+static void printThreadStats(const map<pthread_t, BenchmarkRESTfulService::ThreadStats> &stats) {
+    int index = 0;
+    map<pthread_t, BenchmarkRESTfulService::ThreadStats>::const_iterator i;
+
+    for (i = stats.begin(); i != stats.end(); i++, index++) {
+        printf("    thread %d: %" PRIu64 " requests, %.2f MB, %.2f MB/s\n", index,
+               i->second.requests, toMB(i->second.bytes),
+               toMBps(i->second.bytes, i->second.busyUs));
+    }
+}
+
+static uint64_t countRequests(const map<pthread_t, BenchmarkRESTfulService::ThreadStats> &stats) {
+    uint64_t requests = 0;
+    map<pthread_t, BenchmarkRESTfulService::ThreadStats>::const_iterator i;
+
+    for (i = stats.begin(); i != stats.end(); i++) {
+        requests += i->second.requests;
+    }
+    return requests;
+}
+
+static void benchmarkDownload(const S3Params &params, uint64_t signUs) {
+    BenchmarkReader reader(params);
+    vector<char> buf(BUF_SIZE);
+    uint64_t bytes = 0;
+    uint64_t firstByteUs = 0;
+
+    uint64_t startUs = GetCurrentTimeUs();
+    reader.open(params);
+
+    while (!S3QueryIsAbortInProgress()) {
+        uint64_t len = reader.read(buf.data(), buf.size());
+        if (len == 0) {
+            break;
+        }
+
+        if (bytes == 0) {
+            firstByteUs = GetCurrentTimeUs() - startUs;
+        }
+        bytes += len;
+    }
+
+    uint64_t totalUs = GetCurrentTimeUs() - startUs;
+    reader.close();
+
+    map<pthread_t, BenchmarkRESTfulService::ThreadStats> stats = reader.timedService.getStats();
+    uint64_t requests = countRequests(stats);
+
+    printf("Download: %.2f MB in %.3f s, %.2f MB/s\n", toMB(bytes), totalUs / 1000000.0,
+           toMBps(bytes, totalUs));
+    printf("  time to first byte: %.3f ms\n", firstByteUs / 1000.0);
+    printf("  signing: %" PRIu64 " requests, %.3f ms\n", requests, requests * signUs / 1000.0);
+    if (params.isMultiplexIO()) {
+        printf("  requests of multiplex_io are not counted per thread\n");
+    }
+    printThreadStats(stats);
+}
+
+// sampleParams has no preallocated memory, the sample might be bigger than a chunk.
+static void benchmarkDecompress(S3Params &sampleParams, const ListBucketResult &keyList) {
+    S3RESTfulService restfulService(sampleParams);
+    S3InterfaceService s3InterfaceService(sampleParams);
+    s3InterfaceService.setRESTfulService(&restfulService);
+
+    for (size_t i = 0; i < keyList.contents.size(); i++) {
+        const BucketContent &key = keyList.contents[i];
+
+        string keyEncoded = UriEncode(key.getName());
+        FindAndReplace(keyEncoded, "%2F", "/");
+        S3Params keyParams = sampleParams.setPrefix(keyEncoded);
+
+        S3CompressionType type = s3InterfaceService.checkCompressionType(keyParams.getS3Url());
+        if ((type != S3_COMPRESSION_GZIP) && (type != S3_COMPRESSION_ZSTD) &&
+            (type != S3_COMPRESSION_LZ4)) {
+            continue;
+        }
+
+        uint64_t len = std::min(key.getSize(), (uint64_t)BENCHMARK_DECOMPRESS_SAMPLE_SIZE);
+        S3VectorUInt8 sample;
+        s3InterfaceService.fetchData(0, sample, len, keyParams.getS3Url());
+
+        BenchmarkBufferReader bufferReader(sample);
+        DecompressReader decompressReader;
+        decompressReader.setCompressionType(type);
+        decompressReader.setReader(&bufferReader);
+
+        vector<char> buf(BUF_SIZE);
+        uint64_t bytes = 0;
+        uint64_t startUs = GetCurrentTimeUs();
+
+        // a truncated sample might fail at its end, what is decompressed so far still counts.
+        try {
+            decompressReader.open(keyParams);
+            uint64_t readLen = 0;
+            while ((readLen = decompressReader.read(buf.data(), buf.size())) != 0) {
+                bytes += readLen;
+            }
+        } catch (S3Exception &e) {
+            S3DEBUG("Decompression of the sample stopped: %s", e.getMessage().c_str());
+        }
+
+        uint64_t totalUs = GetCurrentTimeUs() - startUs;
+        decompressReader.close();
+
+        printf("Decompression of %s: %.2f MB into %.2f MB in %.3f s, %.2f MB/s\n",
+               key.getName().c_str(), toMB(sample.size()), toMB(bytes), totalUs / 1000000.0,
+               toMBps(bytes, totalUs));
+        return;
+    }
+
+    printf("Decompression: no compressed key found\n");
+}
+
+static void benchmarkUpload(const S3Params &params, uint64_t signUs) {
+    string format = params.isAutoCompress() ? string(S3_DEFAULT_FORMAT) + ".gz" : S3_DEFAULT_FORMAT;
+    BenchmarkWriter writer(params, format);
+
+    // every uploading thread gets two parts, lines of text compress as real data.
+    uint64_t size = params.getChunkSize() * params.getNumOfChunks() * 2;
+    string line = "1234567890,gpcheckcloud,benchmark,";
+    vector<char> buf;
+    while (buf.size() < BUF_SIZE) {
+        stringstream ss;
+        ss << line << buf.size() << "\n";
+        string row = ss.str();
+        buf.insert(buf.end(), row.begin(), row.end());
+    }
+
+    uint64_t startUs = GetCurrentTimeUs();
+    writer.open(params);
+
+    uint64_t bytes = 0;
+    while ((bytes < size) && !S3QueryIsAbortInProgress()) {
+        uint64_t len = std::min((uint64_t)buf.size(), size - bytes);
+        writer.write(buf.data(), len);
+        bytes += len;
+    }
+
+    writer.close();
+    uint64_t totalUs = GetCurrentTimeUs() - startUs;
+
+    map<pthread_t, BenchmarkRESTfulService::ThreadStats> stats = writer.timedService.getStats();
+    uint64_t requests = countRequests(stats);
+
+    printf("Upload: %.2f MB in %.3f s, %.2f MB/s, compression %s\n", toMB(bytes),
+           totalUs / 1000000.0, toMBps(bytes, totalUs), params.isAutoCompress() ? "on" : "off");
+    const vector<string> &keys = writer.getKeyUrlsUploaded();
+    for (size_t i = 0; i < keys.size(); i++) {
+        printf("  key: %s, remove it when it's not needed\n", keys[i].c_str());
+    }
+    printf("  signing: %" PRIu64 " requests, %.3f ms\n", requests, requests * signUs / 1000.0);
+    if (params.isMultiplexIO()) {
+        printf("  requests of multiplex_io are not counted per thread\n");
+    }
+    printThreadStats(stats);
+}
+
+// Return average time of signing a request in microseconds.
+static uint64_t benchmarkSigning(const S3Params &params) {
+    const S3Url &s3Url = params.getS3Url();
+    uint64_t startUs = GetCurrentTimeUs();
+
+    for (int i = 0; i < BENCHMARK_SIGN_ROUNDS; i++) {
+        HTTPHeaders headers;
+        headers.Add(HOST, s3Url.getHostForCurl());
+        headers.Add(RANGE, "bytes=0-67108863");
+        headers.Add(X_AMZ_CONTENT_SHA256, "UNSIGNED-PAYLOAD");
+        SignRequestV4("GET", &headers, s3Url.getRegion(), s3Url.getPathForCurl(), "",
+                      params.getCred());
+    }
+
+    uint64_t totalUs = GetCurrentTimeUs() - startUs;
+    printf("Signing: %.3f us per request\n", (double)totalUs / BENCHMARK_SIGN_ROUNDS);
+
+    return totalUs / BENCHMARK_SIGN_ROUNDS;
+}
+
+static bool benchmarkS3(const char *urlWithOptions) {
+    if (!urlWithOptions) {
+        return false;
+    }
+
+    bool ret = true;
+    thread_setup();
+
+    try {
+        S3Params params = InitConfig(urlWithOptions);
+        S3Params sampleParams = params;
+        PrepareS3MemContext(params);
+
+        printf("threadnum = %" PRIu64 ", chunksize = %" PRIu64
+               ", autocompress = %s, multiplex_io = %s\n",
+               params.getNumOfChunks(), params.getChunkSize(),
+               params.isAutoCompress() ? "true" : "false",
+               params.isMultiplexIO() ? "true" : "false");
+
+        uint64_t signUs = benchmarkSigning(params);
+
+        S3RESTfulService restfulService(params);
+        S3InterfaceService s3InterfaceService(params);
+        s3InterfaceService.setRESTfulService(&restfulService);
+
+        // listBucket() changes the URL passed in.
+        S3Url listUrl = params.getS3Url();
+
+        uint64_t startUs = GetCurrentTimeUs();
+        ListBucketResult keyList = s3InterfaceService.listBucket(listUrl);
+        uint64_t listUs = GetCurrentTimeUs() - startUs;
+
+        uint64_t totalSize = 0;
+        for (size_t i = 0; i < keyList.contents.size(); i++) {
+            totalSize += keyList.contents[i].getSize();
+        }
+        printf("Listing: %zu keys, %.2f MB, %.3f ms\n", keyList.contents.size(), toMB(totalSize),
+               listUs / 1000.0);
+
+        benchmarkDownload(params, signUs);
+        benchmarkDecompress(sampleParams, keyList);
+        benchmarkUpload(params, signUs);
+    } catch (S3Exception &e) {
+        fprintf(stderr, "Benchmark failed: %s\n", e.getFullMessage().c_str());
+        ret = false;
+    }
+
+    thread_cleanup();
+
+    return ret;
+}
+
+struct BulkJob;
+
+// A worker of the bulk mode, it downloads the keys or uploads the part of a file given to it.
+struct BulkWorker {
+    BulkWorker()
+        : job(NULL), id(0), start(0), end(0), keys(0), bytes(0), busyUs(0), failed(false) {
+    }
+
+    BulkJob *job;
+    int id;
+    S3Params params;  // with the memory context of this worker
+
+    // of a file to upload, [start, end)
+    uint64_t start;
+    uint64_t end;
+
+    uint64_t keys;
+    uint64_t bytes;
+    uint64_t busyUs;
+    bool failed;
+    string error;
+};
+
+// Writes the keys downloaded by the workers to stdout in the order of the listing. The worker of
+// the key being written writes it out directly, the others buffer up to BULK_BUFFER_SIZE of their
+// keys and wait for their turn. Keys are taken in order, so the keys before a waiting one are all
+// being downloaded.
+class BulkOrderedOutput {
+   public:
+    BulkOrderedOutput() : nextKey(0), failed(false) {
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->cond, NULL);
+    }
+    ~BulkOrderedOutput() {
+        pthread_mutex_destroy(&this->mutex);
+        pthread_cond_destroy(&this->cond);
+    }
+
+    bool isTurnOf(uint64_t index) {
+        UniqueLock lock(&this->mutex);
+        return this->nextKey == index;
+    }
+
+    // Return false if another worker failed or the user interrupted.
+    bool waitForTurn(uint64_t index) {
+        UniqueLock lock(&this->mutex);
+        while ((this->nextKey != index) && !this->failed && !S3QueryIsAbortInProgress()) {
+            CondTimedWaitUs(&this->cond, &this->mutex, BULK_WAIT_US);
+        }
+        return !this->failed && !S3QueryIsAbortInProgress();
+    }
+
+    void finishKey(uint64_t index) {
+        UniqueLock lock(&this->mutex);
+        this->nextKey = index + 1;
+        pthread_cond_broadcast(&this->cond);
+    }
+
+    void fail() {
+        UniqueLock lock(&this->mutex);
+        this->failed = true;
+        pthread_cond_broadcast(&this->cond);
+    }
+
+   private:
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint64_t nextKey;
+    bool failed;
+};
+
+struct BulkJob {
+    BulkJob() : nextIndex(0) {
+    }
+
+    ListBucketResult keyList;
+    std::atomic<uint64_t> nextIndex;  // of the next key to download
+    string outputDir;                 // keys are written to stdout if it's empty
+    BulkOrderedOutput output;
+
+    string fileToUpload;
+};
+
+// Create the parent directories of path, like "mkdir -p".
+static void makeParentDirs(const string &path) {
+    for (size_t pos = path.find('/', 1); pos != string::npos; pos = path.find('/', pos + 1)) {
+        string dir = path.substr(0, pos);
+        if ((mkdir(dir.c_str(), 0755) != 0) && (errno != EEXIST)) {
+            S3_DIE(S3RuntimeError, "Failed to create directory " + dir + ": " + strerror(errno));
+        }
+    }
+}
+
+static void bulkDownloadKey(BulkWorker *worker, S3InterfaceService &s3InterfaceService,
+                            uint64_t index) {
+    BulkJob *job = worker->job;
+    const BucketContent &key = job->keyList.contents[index];
+
+    string keyEncoded = UriEncode(key.getName());
+    FindAndReplace(keyEncoded, "%2F", "/");
+    S3Params keyParams = worker->params.setPrefix(keyEncoded);
+    keyParams.setKeySize(key.getSize());
+    keyParams.setKeyETag(key.getETag());
+
+    FILE *file = NULL;
+    if (!job->outputDir.empty()) {
+        string path = job->outputDir + "/" + key.getName();
+        makeParentDirs(path);
+        file = fopen(path.c_str(), "w");
+        S3_CHECK_OR_DIE(file != NULL, S3RuntimeError,
+                        "Failed to open " + path + ": " + strerror(errno));
+    }
+
+    S3CommonReader reader;
+    reader.setS3InterfaceService(&s3InterfaceService);
+    vector<char> buf(BUF_SIZE);
+    vector<char> pending;
+
+    try {
+        reader.open(keyParams);
+
+        uint64_t len = 0;
+        while ((len = reader.read(buf.data(), buf.size())) != 0) {
+            worker->bytes += len;
+
+            if (file != NULL) {
+                S3_CHECK_OR_DIE(fwrite(buf.data(), len, 1, file) == 1, S3RuntimeError,
+                                "Failed to write " + key.getName());
+                continue;
+            }
+
+            if (!job->output.isTurnOf(index)) {
+                pending.insert(pending.end(), buf.data(), buf.data() + len);
+                if (pending.size() < BULK_BUFFER_SIZE) {
+                    continue;
+                }
+
+                S3_CHECK_OR_DIE(job->output.waitForTurn(index), S3QueryAbort, "");
+                fwrite(pending.data(), pending.size(), 1, stdout);
+                pending.clear();
+                continue;
+            }
+
+            if (!pending.empty()) {
+                fwrite(pending.data(), pending.size(), 1, stdout);
+                pending.clear();
+            }
+            fwrite(buf.data(), len, 1, stdout);
+        }
+
+        reader.close();
+
+        if (file == NULL) {
+            S3_CHECK_OR_DIE(job->output.waitForTurn(index), S3QueryAbort, "");
+            if (!pending.empty()) {
+                fwrite(pending.data(), pending.size(), 1, stdout);
+            }
+            job->output.finishKey(index);
+        }
+    } catch (...) {
+        if (file != NULL) {
+            fclose(file);
+        }
+        throw;
+    }
+
+    if (file != NULL) {
+        S3_CHECK_OR_DIE(fclose(file) == 0, S3RuntimeError, "Failed to write " + key.getName());
+    }
+
+    worker->keys++;
+}
+
+static void *bulkDownloadThreadFunc(void *data) {
+    BulkWorker *worker = (BulkWorker *)data;
+    BulkJob *job = worker->job;
+
+    S3RESTfulService restfulService(worker->params);
+    S3InterfaceService s3InterfaceService(worker->params);
+    s3InterfaceService.setRESTfulService(&restfulService);
+
+    uint64_t startUs = GetCurrentTimeUs();
+
+    try {
+        uint64_t index = 0;
+        while (((index = job->nextIndex.fetch_add(1)) < job->keyList.contents.size()) &&
+               !S3QueryIsAbortInProgress()) {
+            bulkDownloadKey(worker, s3InterfaceService, index);
+        }
+    } catch (S3Exception &e) {
+        worker->failed = true;
+        worker->error = e.getFullMessage();
+        job->output.fail();
+    }
+
+    worker->busyUs = GetCurrentTimeUs() - startUs;
+    return NULL;
+}
+
+static void *bulkUploadThreadFunc(void *data) {
+    BulkWorker *worker = (BulkWorker *)data;
+    BulkJob *job = worker->job;
+
+    uint64_t startUs = GetCurrentTimeUs();
+
+    int fd = ::open(job->fileToUpload.c_str(), O_RDONLY);
+    if (fd < 0) {
+        worker->failed = true;
+        worker->error = "Failed to open " + job->fileToUpload + ": " + strerror(errno);
+        return NULL;
+    }
+
+    try {
+        string format = worker->params.isAutoCompress() ? string(S3_DEFAULT_FORMAT) + ".gz"
+                                                        : S3_DEFAULT_FORMAT;
+        GPWriter writer(worker->params, format);
+        writer.open(worker->params);
+
+        vector<char> buf(BUF_SIZE);
+        uint64_t offset = worker->start;
+        while ((offset < worker->end) && !S3QueryIsAbortInProgress()) {
+            ssize_t len = pread(fd, buf.data(), std::min((uint64_t)buf.size(), worker->end - offset),
+                                offset);
+            S3_CHECK_OR_DIE(len > 0, S3RuntimeError, "Failed to read " + job->fileToUpload);
+
+            writer.write(buf.data(), len);
+            offset += len;
+            worker->bytes += len;
+        }
+
+        // the keys are aborted if the user interrupted.
+        writer.close();
+        worker->keys += writer.getKeyUrlsUploaded().size();
+    } catch (S3Exception &e) {
+        worker->failed = true;
+        worker->error = e.getFullMessage();
+    }
+
+    ::close(fd);
+    worker->busyUs = GetCurrentTimeUs() - startUs;
+    return NULL;
+}
+
+// Split the file into parts of whole lines, one for each worker.
+static void splitFileToUpload(const string &path, vector<BulkWorker> &workers) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    S3_CHECK_OR_DIE(fd >= 0, S3RuntimeError, "Failed to open " + path + ": " + strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        S3_DIE(S3RuntimeError, "Failed to stat " + path + ": " + strerror(errno));
+    }
+
+    uint64_t size = st.st_size;
+    char eol = eolString[strlen(eolString) - 1];
+    uint64_t start = 0;
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        uint64_t end = size * (i + 1) / workers.size();
+        end = std::max(end, start);
+
+        // a part ends after the EOL of its last line.
+        char c = 0;
+        while ((end > 0) && (end < size) && (pread(fd, &c, 1, end - 1) == 1) && (c != eol)) {
+            end++;
+        }
+
+        workers[i].start = start;
+        workers[i].end = end;
+        start = end;
+    }
+
+    ::close(fd);
+}
+
+// Run the workers, and print the throughput of each and of all, with the bytes sent or received
+// on the wire counted by wireCounter.
+static bool runBulkWorkers(vector<BulkWorker> &workers, void *(*func)(void *),
+                           const char *direction, S3IOCounter wireCounter) {
+    uint64_t startUs = GetCurrentTimeUs();
+    GetS3IOStats().reset();
+
+    vector<pthread_t> threads(workers.size());
+    for (size_t i = 0; i < workers.size(); i++) {
+        pthread_create(&threads[i], NULL, func, &workers[i]);
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    uint64_t totalUs = GetCurrentTimeUs() - startUs;
+    fflush(stdout);
+
+    bool ret = true;
+    uint64_t keys = 0;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (workers[i].failed) {
+            fprintf(stderr, "Worker %d failed: %s\n", workers[i].id, workers[i].error.c_str());
+            ret = false;
+        }
+        keys += workers[i].keys;
+        bytes += workers[i].bytes;
+    }
+
+    const S3IOStats &stats = GetS3IOStats();
+    uint64_t wireBytes = stats.get(wireCounter);
+
+    fprintf(stderr,
+            "%s %" PRIu64 " keys, %.2f MB in %.3f s, %.2f MB/s, %.2f MB/s on the wire, with %zu "
+            "workers\n",
+            direction, keys, toMB(bytes), totalUs / 1000000.0, toMBps(bytes, totalUs),
+            toMBps(wireBytes, totalUs), workers.size());
+    fprintf(stderr, "  requests: %" PRIu64 ", retries: %" PRIu64 ", throttled: %" PRIu64 "\n",
+            stats.get(S3IO_REQUESTS), stats.get(S3IO_RETRIES), stats.get(S3IO_THROTTLES));
+    for (size_t i = 0; i < workers.size(); i++) {
+        fprintf(stderr, "    worker %d: %" PRIu64 " keys, %.2f MB, %.2f MB/s\n", workers[i].id,
+                workers[i].keys, toMB(workers[i].bytes),
+                toMBps(workers[i].bytes, workers[i].busyUs));
+    }
+
+    return ret;
+}
+
+// Each worker has its own memory context, the downloading threads of its keys use it.
+static void prepareBulkWorkers(const S3Params &params, BulkJob *job, uint64_t numOfWorkers,
+                               vector<BulkWorker> &workers) {
+    workers.resize(numOfWorkers);
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].job = job;
+        workers[i].id = i;
+        workers[i].params = params;
+        PrepareS3MemContext(workers[i].params);
+    }
+}
+
+static bool bulkDownloadS3(const char *urlWithOptions, uint64_t numOfWorkers,
+                           const string &outputDir) {
+    bool ret = true;
+    thread_setup();
+
+    try {
+        S3Params params = InitConfig(urlWithOptions);
+
+        strncpy(eolString, params.getGpcheckcloud_newline().c_str(), EOL_CHARS_MAX_LEN);
+        eolString[EOL_CHARS_MAX_LEN] = '\0';
+
+        // the keys are listed once, and shared by the workers.
+        S3RESTfulService restfulService(params);
+        S3InterfaceService s3InterfaceService(params);
+        s3InterfaceService.setRESTfulService(&restfulService);
+
+        S3Url listUrl = params.getS3Url();
+        BulkJob job;
+        job.keyList = s3InterfaceService.listBucket(listUrl);
+        job.outputDir = outputDir;
+
+        vector<BulkWorker> workers;
+        prepareBulkWorkers(params, &job, numOfWorkers, workers);
+        ret = runBulkWorkers(workers, bulkDownloadThreadFunc, "Downloaded", S3IO_BYTES_DOWNLOADED);
+    } catch (S3Exception &e) {
+        fprintf(stderr, "Bulk download failed: %s\n", e.getFullMessage().c_str());
+        ret = false;
+    }
+
+    thread_cleanup();
+
+    return ret;
+}
+
+static bool bulkUploadS3(const char *urlWithOptions, const char *fileToUpload,
+                         uint64_t numOfWorkers) {
+    bool ret = true;
+    thread_setup();
+
+    try {
+        S3Params params = InitConfig(urlWithOptions);
+
+        strncpy(eolString, params.getGpcheckcloud_newline().c_str(), EOL_CHARS_MAX_LEN);
+        eolString[EOL_CHARS_MAX_LEN] = '\0';
+
+        BulkJob job;
+        job.fileToUpload = fileToUpload;
+
+        vector<BulkWorker> workers;
+        prepareBulkWorkers(params, &job, numOfWorkers, workers);
+        splitFileToUpload(job.fileToUpload, workers);
+        ret = runBulkWorkers(workers, bulkUploadThreadFunc, "Uploaded", S3IO_BYTES_UPLOADED);
+    } catch (S3Exception &e) {
+        fprintf(stderr, "Bulk upload failed: %s\n", e.getFullMessage().c_str());
+        ret = false;
+    }
+
+    thread_cleanup();
+
+    return ret;
+}
+
 int main(int argc, char *argv[]) {
     bool ret = true;
 
@@ -294,21 +1116,31 @@ int main(int argc, char *argv[]) {
 
     map<char, string> optionPairs = parseCommandLineArgs(argc, argv);
 
+    string outputDir;
+    uint64_t numOfWorkers = takeBulkOptions(optionPairs, outputDir);
+
     validateCommandLineArgs(optionPairs);
 
     if (!optionPairs.empty()) {
         const char *arg = optionPairs.begin()->second.c_str();
 
         switch (optionPairs.begin()->first) {
+            case 'b':
+                ret = benchmarkS3(arg);
+                break;
             case 'c':
                 ret = checkConfig(arg);
                 break;
             case 'd':
-                ret = downloadS3(arg);
+                ret = (numOfWorkers > 0) ? bulkDownloadS3(arg, numOfWorkers, outputDir)
+                                         : downloadS3(arg);
                 break;
             case 'u':
             case 'f':
-                ret = uploadS3(optionPairs['u'].c_str(), optionPairs['f'].c_str());
+                ret = (numOfWorkers > 0) ? bulkUploadS3(optionPairs['u'].c_str(),
+                                                        optionPairs['f'].c_str(), numOfWorkers)
+                                         : uploadS3(optionPairs['u'].c_str(),
+                                                    optionPairs['f'].c_str());
                 break;
             case 'h':
                 printUsage(stdout);
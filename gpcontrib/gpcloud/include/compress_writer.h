@@ -1,6 +1,7 @@
 #ifndef INCLUDE_COMPRESS_WRITER_H_
 #define INCLUDE_COMPRESS_WRITER_H_
 
+#include "decompress_reader.h"
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3macros.h"
@@ -9,6 +10,9 @@
 // 2MB by default
 extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 
+// Compress task input into concatenated BGZF members of up to S3_BGZF_MAX_INPUT_SIZE input each.
+BGZFTaskStatus DeflateBGZFTask(BGZFTask &task);
+
 class CompressWriter : public Writer {
    public:
     CompressWriter();
@@ -24,14 +28,32 @@ class CompressWriter : public Writer {
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
+    // End the gzip stream of the current key, so that each key can be decompressed on its own.
+    virtual void rollover(const S3Url &url);
+
     void setWriter(Writer *writer);
 
    private:
+    void initStream();
+    void finishStream();
     void flush();
     uint64_t writeOneChunk(const char *buf, uint64_t count);
 
+    // With more than one thread, S3_ZIP_COMPRESS_CHUNKSIZE blocks are compressed into BGZF
+    // members by workers, and written in order.
+    uint64_t writeParallel(const char *buf, uint64_t count);
+    void submitTask();
+    void flushTask();
+    void finishParallel();
+    void closeParallel();
+
     Writer *writer;
 
+    uint64_t numOfThreads;  // threads to compress data, 1 means not in parallel.
+    BGZFTaskPool deflater;
+    uint64_t fillIndex;   // task to fill with input.
+    uint64_t flushIndex;  // next task to write output from.
+
     // zlib related variables.
     z_stream zstream;
     char *out;  // Output buffer for compression.
@@ -4,12 +4,198 @@
 #include "reader.h"
 #include "s3common_headers.h"
 #include "s3exception.h"
+#include "s3interface.h"
 #include "s3macros.h"
 #include "s3params.h"
 
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+
+#ifdef USE_ISAL
+#include <isa-l/crc.h>
+#include <isa-l/igzip_lib.h>
+#endif
+
 // 2MB by default
 extern uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE;
 
+// Streaming decompression codec used by DecompressReader.
+class Decompressor {
+   public:
+    virtual ~Decompressor() {
+    }
+
+    virtual void init() = 0;
+
+    // Decompress input [*in, *in + *inLen) into out, advance *in and *inLen past the consumed
+    // input and return the number of bytes written to out. Throw exception if data is corrupted.
+    virtual uint64_t decompress(const char **in, uint64_t *inLen, char *out, uint64_t outLen) = 0;
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void end() = 0;
+};
+
+// zlib and gzip stream, concatenated gzip members are decompressed one after another.
+class ZlibDecompressor : public Decompressor {
+   public:
+    ZlibDecompressor() : initialized(false), memberEnded(false), finished(false) {
+    }
+    virtual ~ZlibDecompressor() {
+        this->end();
+    }
+
+    virtual void init();
+    virtual uint64_t decompress(const char **in, uint64_t *inLen, char *out, uint64_t outLen);
+    virtual void end();
+
+   private:
+    z_stream zstream;
+    bool initialized;
+    bool memberEnded;  // a gzip member ends, next one might follow.
+    bool finished;     // no more member, the rest of input is ignored.
+};
+
+#ifdef USE_ISAL
+// zlib and gzip stream by ISA-L igzip, which picks the implementation for the CPU at run time. Like
+// ZlibDecompressor, concatenated gzip members are decompressed one after another.
+class IsalDecompressor : public Decompressor {
+   public:
+    IsalDecompressor() : memberStarted(false), memberEnded(false), finished(false) {
+    }
+    virtual ~IsalDecompressor() {
+        this->end();
+    }
+
+    virtual void init();
+    virtual uint64_t decompress(const char **in, uint64_t *inLen, char *out, uint64_t outLen);
+    virtual void end();
+
+   private:
+    struct inflate_state state;
+    bool memberStarted;  // the wrapper of the member is known.
+    bool memberEnded;    // a gzip member ends, next one might follow.
+    bool finished;       // no more member, the rest of input is ignored.
+};
+#endif
+
+#ifdef USE_ZSTD
+// zstd frames
+class ZstdDecompressor : public Decompressor {
+   public:
+    ZstdDecompressor() : dstream(NULL) {
+    }
+    virtual ~ZstdDecompressor() {
+        this->end();
+    }
+
+    virtual void init();
+    virtual uint64_t decompress(const char **in, uint64_t *inLen, char *out, uint64_t outLen);
+    virtual void end();
+
+   private:
+    ZSTD_DStream *dstream;
+};
+#endif
+
+#ifdef USE_LZ4
+// lz4 frames
+class LZ4Decompressor : public Decompressor {
+   public:
+    LZ4Decompressor() : dctx(NULL) {
+    }
+    virtual ~LZ4Decompressor() {
+        this->end();
+    }
+
+    virtual void init();
+    virtual uint64_t decompress(const char **in, uint64_t *inLen, char *out, uint64_t outLen);
+    virtual void end();
+
+   private:
+    LZ4F_dctx *dctx;
+};
+#endif
+
+// BGZF (blocked gzip) members carry their own size in the 'BC' extra subfield. They can be located
+// without inflating, so they are decompressed by multiple threads.
+#define S3_BGZF_HEADER_LEN 18
+#define S3_BGZF_MAX_BLOCK_SIZE 65536
+// uncompressed data of one block, even stored blocks fit in S3_BGZF_MAX_BLOCK_SIZE.
+#define S3_BGZF_MAX_INPUT_SIZE 65280
+
+// Return size of the BGZF member whose header is at data, or 0 if data is not a BGZF header.
+uint64_t GetBGZFBlockSize(const char *data, uint64_t len);
+
+enum BGZFTaskStatus {
+    BGZFTaskEmpty,
+    BGZFTaskPending,
+    BGZFTaskDone,
+    BGZFTaskFailed,
+};
+
+// Whole BGZF members to decompress, or data to compress into BGZF members, by a worker thread.
+struct BGZFTask {
+    BGZFTask() : status(BGZFTaskEmpty) {
+    }
+
+    vector<char> input;
+    vector<char> output;
+    BGZFTaskStatus status;
+    string error;
+};
+
+// Process task.input into task.output, return BGZFTaskFailed with task.error set on errors.
+typedef BGZFTaskStatus (*BGZFTaskFunc)(BGZFTask &task);
+
+// Task input is whole blocks, task output is resized to the sum of their ISIZE.
+BGZFTaskStatus InflateBGZFTask(BGZFTask &task);
+
+// Process BGZF tasks by a pool of worker threads, tasks are consumed in the order of submission
+// by the only consumer thread.
+class BGZFTaskPool {
+   public:
+    BGZFTaskPool();
+    ~BGZFTaskPool();
+
+    void start(uint64_t numOfThreads, BGZFTaskFunc func);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    void stop();
+
+    bool isStarted() const {
+        return !this->threads.empty();
+    }
+
+    vector<BGZFTask> &getTasks() {
+        return tasks;
+    }
+
+    // Pass tasks[index] to workers.
+    void submit(uint64_t index);
+
+    // Wait tasks[index] to be done or failed.
+    void wait(uint64_t index);
+
+   private:
+    static void *WorkerThreadFunc(void *data);
+    void work();
+
+    BGZFTaskFunc func;
+    vector<BGZFTask> tasks;
+    std::deque<uint64_t> queue;  // indexes of tasks waiting for workers.
+    bool stopping;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t taskCondVar;
+    pthread_cond_t doneCondVar;
+    vector<pthread_t> threads;
+};
+
 class DecompressReader : public Reader {
    public:
     DecompressReader();
@@ -21,29 +207,111 @@ class DecompressReader : public Reader {
     // Return 0 if EOF. Throw exception if encounters errors.
     virtual uint64_t read(char *buf, uint64_t count);
 
+    // readView() lends decompressed data from the out buffer.
+    virtual uint64_t readView(const char **data, uint64_t count);
+
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
     void setReader(Reader *reader);
 
+    // Choose the codec before open(), gzip by default. Throw exception if gpcloud is built
+    // without support of the compression type.
+    void setCompressionType(S3CompressionType type);
+
     void resizeDecompressReaderBuffer(uint64_t size);
 
    private:
-    void decompress();
+    bool decompress();
+
+    // Found BGZF header at the beginning of gzip data, decompress blocks in parallel.
+    bool detectBGZF();
+    uint64_t readViewParallel(const char **data, uint64_t count);
+    bool fillTask(BGZFTask &task);
 
     uint64_t getDecompressedBytesNum() {
-        return S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out;
+        return this->outLen;
     }
 
     Reader *reader;
 
-    // zlib related variables.
-    z_stream zstream;
-    char *in;            // Input buffer for decompression.
+    S3CompressionType compressionType;
+    std::unique_ptr<Decompressor> decompressor;
+
+    uint64_t numOfThreads;  // threads to decompress BGZF blocks, 1 means not in parallel.
+    bool detected;          // whether detectBGZF() is done.
+    bool inputEOF;
+    BGZFTaskPool inflater;
+    vector<char> carry;  // partial block read by the last task.
+    uint64_t fillIndex;  // next task to fill with input.
+    uint64_t readIndex;  // task to read output from.
+
+    const char *in;      // Compressed data lent by reader.
+    uint64_t inLen;      // Length of compressed data not consumed yet.
     char *out;           // Output buffer for decompression.
+    uint64_t outLen;     // Length of decompressed data in out buffer.
     uint64_t outOffset;  // Next position to read in out buffer.
 
     bool isClosed;
 };
 
+// The zstd seekable format ends with a skippable frame holding the sizes of all frames.
+#define S3_ZSTD_SKIPPABLE_MAGIC 0x184D2A5E
+#define S3_ZSTD_SKIPPABLE_HEADER_LEN 8
+#define S3_ZSTD_SEEKABLE_MAGIC 0x8F92EAB1
+#define S3_ZSTD_SEEK_FOOTER_LEN 9
+
+// Return the offsets of the frames of a key in zstd seekable format, followed by the offset of its
+// seek table, or nothing if the footer is not a valid seek table.
+vector<uint64_t> ParseZstdSeekTable(const char *footer, const char *table, uint64_t tableLen,
+                                    uint64_t keySize);
+
+// Locate the members of a compressed key that start in the range of params: *memberStart and
+// *memberEnd are set to the offsets of the first members at or after the start and the end of the
+// range. Return false if the members can't be located, i.e. the key is neither BGZF nor in zstd
+// seekable format, then the key can't be split.
+bool LocateCompressedMembers(S3Interface *s3Interface, const S3Params &params,
+                             S3CompressionType type, uint64_t *memberStart, uint64_t *memberEnd);
+
+// Lines of a range of a compressed key split by its members, decompressed by reader from raw
+// ranges of the key. Like a range of a plain key, the first partial line is skipped, it belongs to
+// previous range, and reading goes on in the members after the range until its last line ends.
+class SplitDecompressReader : public Reader {
+   public:
+    SplitDecompressReader();
+    virtual ~SplitDecompressReader();
+
+    virtual void open(const S3Params &params);
+    virtual uint64_t read(char *buf, uint64_t count);
+    virtual uint64_t readView(const char **data, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    void setReader(Reader *reader) {
+        this->reader = reader;
+    }
+
+    // Choose the members to read before open(), see LocateCompressedMembers().
+    void setMemberRange(uint64_t memberStart, uint64_t memberEnd) {
+        this->memberStart = memberStart;
+        this->memberEnd = memberEnd;
+    }
+
+   private:
+    void openMembers(uint64_t start, uint64_t end);
+
+    Reader *reader;
+    S3Params params;
+
+    uint64_t memberStart;
+    uint64_t memberEnd;
+
+    bool isOpened;           // whether reader is opened
+    bool skippingFirstLine;  // the first partial line is not found yet
+    bool readingTail;        // reading members after memberEnd to finish the last line
+    bool finished;
+    EolScanner eolScanner;
+};
+
 #endif /* INCLUDE_DECOMPRESS_READER_H_ */
@@ -1,14 +1,29 @@
 #ifndef __GP_CHECK_CLOUD_H__
 #define __GP_CHECK_CLOUD_H__
 
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+
 #include "gpreader.h"
 #include "gpwriter.h"
 #include "s3common_headers.h"
 #include "s3interface.h"
+#include "s3iostats.h"
 #include "s3memory_mgmt.h"
 
 #define BUF_SIZE 64 * 1024
 
+// Workers of the bulk mode, each downloads or uploads with threadnum connections of its own.
+#define BULK_DEFAULT_WORKERS 4
+#define BULK_MAX_WORKERS 64
+
+// Data of a key a worker buffers before it's the key's turn to be written to stdout.
+#define BULK_BUFFER_SIZE (16 * 1024 * 1024)
+
+// Time between checks of interrupts while waiting for the turn.
+#define BULK_WAIT_US (100 * 1000)
+
 extern volatile bool QueryCancelPending;
 extern bool S3QueryIsAbortInProgress(void);
 
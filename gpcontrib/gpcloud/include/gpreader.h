@@ -23,6 +23,8 @@ class GPReader : public Reader {
     // Return 0 if EOF. Throw exception if encounters errors.
     virtual uint64_t read(char *buf, uint64_t count);
 
+    virtual uint64_t readView(const char **data, uint64_t count);
+
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
@@ -30,6 +32,10 @@ class GPReader : public Reader {
         return bucketReader.getKeyList();
     }
 
+    double getSampledFraction() {
+        return bucketReader.getSampledFraction();
+    }
+
     const S3Params &getParams() {
         return params;
     }
@@ -38,6 +44,7 @@ class GPReader : public Reader {
     S3Params params;
     S3BucketReader bucketReader;
     S3CommonReader commonReader;
+    S3CommonReader lookaheadReaders[S3_PREFETCH_KEYS_MAX];  // see S3Params::getPrefetchKeys()
     S3RESTfulService restfulService;
 
     S3InterfaceService s3InterfaceService;
@@ -48,7 +55,8 @@ class GPReader : public Reader {
 };
 
 // Following 3 functions are invoked by s3_import(), need to be exception safe
-GPReader *reader_init(const char *url_with_options);
+// scanDesc describes the external scan, NULL if unknown.
+GPReader *reader_init(const char *url_with_options, const S3ScanDesc *scanDesc = NULL);
 bool reader_transfer_data(GPReader *reader, char *data_buf, int &data_len);
 bool reader_cleanup(GPReader **reader);
 
@@ -32,13 +32,23 @@ class GPWriter : public Writer {
         return this->params.getS3Url().getFullUrlForCurl();
     }
 
+    // All keys written, more than one if rollover_size is set.
+    const vector<string> &getKeyUrlsUploaded() const {
+        return this->keyUrls;
+    }
+
    private:
     string constructRandomStr();
     string genUniqueKeyName(const S3Url &s3Url);
 
+    // Continue with a new key once the current one reaches rolloverSize.
+    void rolloverIfFull();
+
    protected:
     string format;
     S3Params params;
+    S3Url tableUrl;  // the URL keys are named after, params has the one of the current key
+    vector<string> keyUrls;
     S3RESTfulService restfulService;
     S3InterfaceService s3InterfaceService;
     S3CommonWriter commonWriter;
@@ -49,7 +59,9 @@ class GPWriter : public Writer {
 };
 
 // Following 3 functions are invoked by s3_export(), need to be exception safe
-GPWriter *writer_init(const char *url_with_options, const char *format = S3_DEFAULT_FORMAT);
+// scanDesc describes columns and format of the table, NULL if unknown.
+GPWriter *writer_init(const char *url_with_options, const char *format = S3_DEFAULT_FORMAT,
+                      const S3ScanDesc *scanDesc = NULL);
 bool writer_transfer_data(GPWriter *writer, char *data_buf, int data_len);
 bool writer_cleanup(GPWriter **writer);
 
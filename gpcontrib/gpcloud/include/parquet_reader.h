@@ -0,0 +1,364 @@
+#ifndef INCLUDE_PARQUET_READER_H_
+#define INCLUDE_PARQUET_READER_H_
+
+#include <cmath>
+
+#include "reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+#include "s3params.h"
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+// A Parquet file starts and ends with "PAR1", the footer is the file metadata, its length and
+// the magic.
+#define S3_PARQUET_MAGIC "PAR1"
+#define S3_PARQUET_MAGIC_LEN 4
+#define S3_PARQUET_FOOTER_LEN 8
+
+// Bytes read from the end of a file with the footer when ranges are coalesced, the metadata of
+// most files is in them too.
+#define S3_PARQUET_FOOTER_PREFETCH_LEN (64 * 1024)
+
+// Text generated from decoded row groups in a batch.
+#define S3_PARQUET_OUTPUT_CHUNKSIZE (1024 * 1024)
+
+// Enums below are values defined by parquet.thrift, only the supported ones are listed.
+enum ParquetType {
+    PARQUET_BOOLEAN = 0,
+    PARQUET_INT32 = 1,
+    PARQUET_INT64 = 2,
+    PARQUET_INT96 = 3,
+    PARQUET_FLOAT = 4,
+    PARQUET_DOUBLE = 5,
+    PARQUET_BYTE_ARRAY = 6,
+    PARQUET_FIXED_LEN_BYTE_ARRAY = 7,
+};
+
+enum ParquetConvertedType {
+    PARQUET_CONVERTED_NONE = -1,
+    PARQUET_CONVERTED_UTF8 = 0,
+    PARQUET_CONVERTED_DECIMAL = 5,
+    PARQUET_CONVERTED_DATE = 6,
+    PARQUET_CONVERTED_TIMESTAMP_MILLIS = 9,
+    PARQUET_CONVERTED_TIMESTAMP_MICROS = 10,
+};
+
+enum ParquetRepetition {
+    PARQUET_REQUIRED = 0,
+    PARQUET_OPTIONAL = 1,
+    PARQUET_REPEATED = 2,
+};
+
+enum ParquetCodec {
+    PARQUET_UNCOMPRESSED = 0,
+    PARQUET_SNAPPY = 1,
+    PARQUET_GZIP = 2,
+    PARQUET_ZSTD = 6,
+};
+
+enum ParquetEncoding {
+    PARQUET_PLAIN = 0,
+    PARQUET_PLAIN_DICTIONARY = 2,
+    PARQUET_RLE = 3,
+    PARQUET_RLE_DICTIONARY = 8,
+};
+
+enum ParquetPageType {
+    PARQUET_DATA_PAGE = 0,
+    PARQUET_INDEX_PAGE = 1,
+    PARQUET_DICTIONARY_PAGE = 2,
+    PARQUET_DATA_PAGE_V2 = 3,
+};
+
+// Field types of Thrift compact protocol.
+enum ThriftCompactType {
+    THRIFT_STOP = 0,
+    THRIFT_BOOL_TRUE = 1,
+    THRIFT_BOOL_FALSE = 2,
+    THRIFT_BYTE = 3,
+    THRIFT_I16 = 4,
+    THRIFT_I32 = 5,
+    THRIFT_I64 = 6,
+    THRIFT_DOUBLE = 7,
+    THRIFT_BINARY = 8,
+    THRIFT_LIST = 9,
+    THRIFT_SET = 10,
+    THRIFT_MAP = 11,
+    THRIFT_STRUCT = 12,
+};
+
+// Decoder of Thrift compact protocol, Parquet metadata is serialized with it. Throw exception if
+// data is truncated or malformed.
+class ThriftCompactReader {
+   public:
+    ThriftCompactReader(const char *data, uint64_t len);
+
+    void readStructBegin();
+    void readStructEnd();
+
+    // Read header of next field in current struct, return false if reaches the end of struct.
+    bool readFieldBegin(int16_t *id, uint8_t *type);
+
+    // Value of a bool field is in its field type.
+    bool readBool(uint8_t type);
+    int32_t readI32();
+    int64_t readI64();
+    double readDouble();
+    string readBinary();
+
+    // Return number of elements, elements are read one by one with their type.
+    uint64_t readListBegin(uint8_t *elemType);
+
+    void skip(uint8_t type);
+
+    uint64_t getPosition() const {
+        return pos;
+    }
+
+   private:
+    uint8_t readByte();
+    uint64_t readVarint();
+    int64_t readZigzag();
+
+    const char *data;
+    uint64_t len;
+    uint64_t pos;
+
+    int16_t lastFieldId;
+    vector<int16_t> lastFieldIds;  // of outer structs
+};
+
+struct ParquetStatistics {
+    ParquetStatistics()
+        : hasMin(false), hasMax(false), legacy(false), hasNullCount(false), nullCount(0) {
+    }
+
+    bool hasMin;
+    bool hasMax;
+    string min;  // plain encoded value
+    string max;
+    bool legacy;  // from deprecated min and max, signed order of the physical type
+    bool hasNullCount;
+    int64_t nullCount;
+};
+
+// A leaf column of a flat schema.
+struct ParquetColumnSchema {
+    ParquetColumnSchema()
+        : type(PARQUET_BYTE_ARRAY),
+          typeLength(0),
+          repetition(PARQUET_REQUIRED),
+          convertedType(PARQUET_CONVERTED_NONE),
+          scale(0) {
+    }
+
+    string name;
+    ParquetType type;
+    int32_t typeLength;
+    ParquetRepetition repetition;
+    int32_t convertedType;
+    int32_t scale;
+};
+
+struct ParquetColumnChunk {
+    ParquetColumnChunk()
+        : codec(PARQUET_UNCOMPRESSED),
+          numValues(0),
+          totalCompressedSize(0),
+          dataPageOffset(0),
+          dictionaryPageOffset(0) {
+    }
+
+    // Offset of the first page.
+    uint64_t getStartOffset() const;
+
+    int32_t codec;
+    int64_t numValues;
+    int64_t totalCompressedSize;
+    int64_t dataPageOffset;
+    int64_t dictionaryPageOffset;  // 0 if there is no dictionary page
+    ParquetStatistics stats;
+};
+
+struct ParquetRowGroup {
+    ParquetRowGroup() : numRows(0) {
+    }
+
+    vector<ParquetColumnChunk> columns;
+    int64_t numRows;
+};
+
+struct ParquetFileMetaData {
+    ParquetFileMetaData() : numRows(0) {
+    }
+
+    vector<ParquetColumnSchema> columns;
+    vector<ParquetRowGroup> rowGroups;
+    int64_t numRows;
+};
+
+void ParseParquetFileMetaData(const char *data, uint64_t len, ParquetFileMetaData &meta);
+
+struct ParquetPageHeader {
+    ParquetPageHeader()
+        : type(PARQUET_DATA_PAGE),
+          uncompressedSize(0),
+          compressedSize(0),
+          numValues(0),
+          encoding(PARQUET_PLAIN),
+          defLevelEncoding(PARQUET_RLE),
+          defLevelsLen(0),
+          repLevelsLen(0),
+          isCompressed(true) {
+    }
+
+    int32_t type;
+    int32_t uncompressedSize;
+    int32_t compressedSize;
+    int32_t numValues;
+    int32_t encoding;
+
+    // DATA_PAGE
+    int32_t defLevelEncoding;
+
+    // DATA_PAGE_V2, levels are not compressed.
+    int32_t defLevelsLen;
+    int32_t repLevelsLen;
+    bool isCompressed;
+};
+
+// Return length of the page header at data.
+uint64_t ParseParquetPageHeader(const char *data, uint64_t len, ParquetPageHeader &header);
+
+// Decompress a page into out, which is exactly outLen bytes after decompression.
+void DecompressParquetPage(int32_t codec, const char *in, uint64_t inLen, char *out,
+                           uint64_t outLen);
+
+// Decoder of the RLE/bit-packing hybrid encoding, used by definition levels and dictionary indexes.
+class ParquetRleDecoder {
+   public:
+    ParquetRleDecoder(const char *data, uint64_t len, uint32_t bitWidth);
+
+    // Return false if no value is left.
+    bool next(uint32_t *value);
+
+   private:
+    bool readHeader();
+
+    const char *data;
+    uint64_t len;
+    uint64_t pos;
+    uint32_t bitWidth;
+
+    uint64_t rleLeft;  // values left in current RLE run
+    uint32_t rleValue;
+    uint64_t packedLeft;    // values left in current bit-packed run
+    uint64_t packedBitPos;  // bit position of next packed value from data
+};
+
+// Format a plain encoded value as text of its logical type.
+string FormatParquetValue(const ParquetColumnSchema &column, const char *data, uint64_t len);
+
+// Decode plain encoded values, return number of bytes consumed.
+uint64_t DecodeParquetPlainValues(const ParquetColumnSchema &column, const char *data,
+                                  uint64_t len, uint64_t count, vector<string> &values);
+
+// Decode all pages of a column chunk, null values are reported by nulls.
+void DecodeParquetColumnChunk(const ParquetColumnSchema &column, const ParquetColumnChunk &chunk,
+                              const char *data, uint64_t len, vector<string> &values,
+                              vector<bool> &nulls);
+
+// Return false if statistics prove no row of the row group satisfies all quals. columnIndexes maps
+// table columns of the quals to columns in the file, -1 if not in the file.
+bool ParquetRowGroupMayMatch(const ParquetFileMetaData &meta, const ParquetRowGroup &rowGroup,
+                             const vector<int64_t> &columnIndexes, const vector<S3ScanQual> &quals);
+
+// Read a Parquet key and convert its rows into TEXT or CSV lines of the external table. Only column
+// chunks referenced by the scan are downloaded, row groups are skipped by quals pushed down from
+// the scan. Row groups starting in [keyRangeStart, keyRangeEnd) belong to this reader.
+class ParquetReader : public Reader {
+   public:
+    ParquetReader()
+        : s3Interface(NULL),
+          s3Url(""),
+          keySize(0),
+          rangeStart(0),
+          rangeEnd(0),
+          coalesced(false),
+          nextRowGroup(0),
+          numRows(0),
+          nextRow(0),
+          outOffset(0) {
+    }
+    virtual ~ParquetReader() {
+        this->close();
+    }
+
+    virtual void open(const S3Params &params);
+
+    // read() attempts to read up to count bytes into the buffer.
+    // Return 0 if EOF. Throw exception if encounters errors.
+    virtual uint64_t read(char *buf, uint64_t count);
+
+    virtual uint64_t readView(const char **data, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    void setS3InterfaceService(S3Interface *s3) {
+        this->s3Interface = s3;
+    }
+
+    const ParquetFileMetaData &getMetaData() const {
+        return meta;
+    }
+
+    // GETs sent for the file since it was opened.
+    uint64_t getNumOfRequests() const {
+        return fetcher.getNumOfRequests();
+    }
+
+   private:
+    void readMetaData();
+    void mapColumns();
+    bool loadRowGroup();
+    void fillOutput();
+    void appendValue(const string &value);
+    void appendNull();
+
+    S3Interface *s3Interface;
+    S3Url s3Url;
+    uint64_t keySize;
+    uint64_t rangeStart;
+    uint64_t rangeEnd;
+    S3ScanDesc scanDesc;
+
+    S3RangeFetcher fetcher;
+    bool coalesced;  // whether ranges of the file are coalesced
+
+    ParquetFileMetaData meta;
+
+    // For each output column, index of the file column, -1 if not in the file or not projected.
+    vector<int64_t> outputColumns;
+    vector<string> outputNames;
+
+    // For each table column, index of the file column, -1 if not in the file.
+    vector<int64_t> qualColumns;
+
+    uint64_t nextRowGroup;
+
+    // decoded columns of current row group, indexed by output column.
+    vector<vector<string> > values;
+    vector<vector<bool> > nulls;
+    uint64_t numRows;
+    uint64_t nextRow;
+
+    string out;
+    uint64_t outOffset;
+};
+
+#endif /* INCLUDE_PARQUET_READER_H_ */
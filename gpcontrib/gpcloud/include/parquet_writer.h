@@ -0,0 +1,230 @@
+#ifndef INCLUDE_PARQUET_WRITER_H_
+#define INCLUDE_PARQUET_WRITER_H_
+
+#include <unordered_map>
+
+#include "parquet_reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3macros.h"
+#include "writer.h"
+
+// Data pages are cut once their values reach this size.
+#define S3_PARQUET_PAGE_SIZE (1024 * 1024)
+
+// A column chunk falls back to plain encoding once its dictionary grows beyond this size.
+#define S3_PARQUET_DICTIONARY_MAX_SIZE (1024 * 1024)
+
+// Statistics of text columns are dropped if a value is longer than this.
+#define S3_PARQUET_STATISTICS_MAX_LEN 64
+
+#define S3_PARQUET_ZSTD_LEVEL 3
+
+// Encoder of Thrift compact protocol, Parquet metadata is serialized with it.
+class ThriftCompactWriter {
+   public:
+    ThriftCompactWriter() : lastFieldId(0) {
+    }
+
+    void structBegin();
+
+    // Write the stop field of current struct.
+    void structEnd();
+
+    void fieldBegin(int16_t id, uint8_t type);
+    void i32Field(int16_t id, int32_t value);
+    void i64Field(int16_t id, int64_t value);
+    void boolField(int16_t id, bool value);
+    void binaryField(int16_t id, const string &value);
+
+    // Elements follow one by one, as binary(), zigzag() or structs.
+    void listBegin(int16_t id, uint8_t elemType, uint64_t size);
+
+    void binary(const string &value);
+    void varint(uint64_t value);
+    void zigzag(int64_t value);
+
+    const string &getData() const {
+        return out;
+    }
+
+   private:
+    string out;
+
+    int16_t lastFieldId;
+    vector<int16_t> lastFieldIds;  // of outer structs
+};
+
+// Encode values with the RLE/bit-packing hybrid encoding, without length prefix.
+string EncodeParquetRle(const vector<uint32_t> &values, uint64_t start, uint64_t count,
+                        uint32_t bitWidth);
+
+// Compress a page, the counterpart of DecompressParquetPage().
+string CompressParquetPage(int32_t codec, const string &page);
+
+// Convert a field from the formatter into the plain encoding of the column, without the length
+// prefix of BYTE_ARRAY. Throw exception if it is not a valid value of the type.
+string EncodeParquetPlainValue(const ParquetColumnSchema &column, const string &text);
+
+// Column chunk written to a file, to be described in the footer.
+struct ParquetWrittenChunk {
+    ParquetWrittenChunk()
+        : codec(PARQUET_UNCOMPRESSED),
+          numValues(0),
+          totalUncompressedSize(0),
+          totalCompressedSize(0),
+          dataPageOffset(0),
+          dictionaryPageOffset(0) {
+    }
+
+    vector<int32_t> encodings;
+    int32_t codec;
+    int64_t numValues;
+    int64_t totalUncompressedSize;  // page headers included
+    int64_t totalCompressedSize;
+    int64_t dataPageOffset;
+    int64_t dictionaryPageOffset;  // 0 if there is no dictionary page
+    ParquetStatistics stats;
+};
+
+struct ParquetWrittenRowGroup {
+    ParquetWrittenRowGroup() : numRows(0), totalByteSize(0) {
+    }
+
+    vector<ParquetWrittenChunk> columns;
+    int64_t numRows;
+    int64_t totalByteSize;
+};
+
+// FileMetaData of the footer, every column is a leaf of the root.
+string SerializeParquetFileMetaData(const vector<ParquetColumnSchema> &columns,
+                                    const vector<ParquetWrittenRowGroup> &rowGroups);
+
+// Values of a column in the current row group. They are dictionary encoded until the dictionary
+// grows too large, booleans are always plain encoded.
+class ParquetColumnBuilder {
+   public:
+    explicit ParquetColumnBuilder(const ParquetColumnSchema &column);
+
+    void add(const string &text);
+    void addNull();
+
+    // Bytes of buffered values in plain encoding.
+    uint64_t getBufferedSize() const {
+        return bufferedSize;
+    }
+
+    // Append the column chunk of buffered values to out, which is at offset of the file, and reset
+    // the builder. The codec is not used if it doesn't make the chunk smaller.
+    ParquetWrittenChunk flush(int32_t codec, uint64_t offset, string &out);
+
+   private:
+    struct Page {
+        uint64_t numValues;
+        uint64_t numDefined;
+        uint64_t plainEnd;  // end of its values in plain, if not dictionary encoded
+    };
+
+    void appendPlain(const string &value);
+    void updateStatistics(const string &value);
+    void closePage();
+    void fallbackToPlain();
+    string encodePage(const Page &page, uint64_t valueStart, uint64_t definedStart,
+                      uint64_t plainStart, uint32_t bitWidth);
+    void reset();
+
+    ParquetColumnSchema column;
+
+    vector<uint32_t> definitionLevels;
+
+    bool useDictionary;
+    std::unordered_map<string, uint32_t> dictionary;
+    vector<const string *> dictionaryValues;  // keys of dictionary, by index
+    uint64_t dictionarySize;
+    vector<uint32_t> indexes;
+
+    string plain;  // one byte for each boolean, bit-packed when pages are encoded
+
+    vector<Page> pages;
+    Page currentPage;
+    uint64_t currentPageSize;
+
+    uint64_t bufferedSize;
+
+    ParquetStatistics stats;
+    bool hasLongValue;
+};
+
+// Convert TEXT or CSV lines of a writable external table into a Parquet file. Rows are buffered
+// into row groups of about rowGroupSize bytes, each column chunk is written to the upstream writer
+// as soon as its row group is full, the footer is written when the key is finished.
+class ParquetWriter : public Writer {
+   public:
+    ParquetWriter();
+    virtual ~ParquetWriter() {
+        this->close();
+    }
+
+    virtual void open(const S3Params &params);
+
+    // write() attempts to write up to count bytes from the buffer.
+    // Always return 0 if EOF, no matter how many times it's invoked. Throw exception if encounters
+    // errors.
+    virtual uint64_t write(const char *buf, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    // Finish the Parquet file of the current key, rows after it go to the one at url.
+    virtual void rollover(const S3Url &url);
+
+    void setWriter(Writer *writer) {
+        this->writer = writer;
+    }
+
+   private:
+    enum EscapeState { ESCAPE_NONE, ESCAPE_PENDING, ESCAPE_OCTAL, ESCAPE_HEX };
+
+    void parseText(char c);
+    bool parseTextEscape(char c);
+    void parseCSV(char c);
+    void appendRaw(char c);
+    void endField();
+    void endRow();
+
+    void beginFile();
+    void flushRowGroup();
+    void finishFile();
+    void writeOut(const string &data);
+
+    Writer *writer;
+
+    S3ScanDesc desc;
+    vector<ParquetColumnSchema> columns;
+    vector<ParquetColumnBuilder> builders;
+    int32_t codec;
+    uint64_t rowGroupSize;
+
+    uint64_t fileOffset;
+    vector<ParquetWrittenRowGroup> rowGroups;
+    int64_t numRows;  // in the current row group
+
+    // State of the line parser, the current field is decoded into field.
+    string field;
+    uint64_t fieldIndex;
+    uint64_t rawLen;    // bytes of the field as written by the formatter
+    bool rawMatchNull;  // whether the raw field is a prefix of the NULL string so far
+    bool quoted;        // CSV only, quoted fields are never NULL
+    bool inQuotes;
+    bool quotePending;  // a quote in quoted field, which ends it unless another quote follows
+    bool csvEscapePending;
+    EscapeState escapeState;
+    uint32_t escapeValue;
+    uint32_t escapeDigits;
+    bool afterCR;  // a CR ended the last row, the LF of its CRLF is skipped
+
+    bool hasError;  // rows may be partially added, the file is not finished then
+    bool isClosed;
+};
+
+#endif /* INCLUDE_PARQUET_WRITER_H_ */
@@ -16,8 +16,21 @@ class Reader {
     // errors.
     virtual uint64_t read(char *buf, uint64_t count) = 0;
 
+    // readView() is read() without copying: it lends up to count bytes kept by the reader, sets
+    // *data to point to them and returns their length. The data stays valid until the next
+    // read(), readView() or close(). Readers without a buffer to lend copy through read().
+    virtual uint64_t readView(const char **data, uint64_t count) {
+        this->viewBuffer.resize(count);
+        uint64_t readLen = this->read(this->viewBuffer.data(), count);
+        *data = this->viewBuffer.data();
+        return readLen;
+    }
+
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close() = 0;
+
+   private:
+    vector<char> viewBuffer;
 };
 
 #endif
@@ -127,6 +127,25 @@ class Response {
     S3VectorUInt8 dataBuffer;
 };
 
+// Completion of a request started by RESTfulService::getAsync() or putAsync().
+class RESTfulCallback {
+   public:
+    virtual ~RESTfulCallback() {
+    }
+
+    // Polled while the response is received, the transfer is stopped once it returns true.
+    virtual bool isCancelled() = 0;
+
+    // The request is not sent before this time of GetCurrentTimeUs(), e.g. to back off a retry.
+    virtual uint64_t getStartTimeUs() {
+        return 0;
+    }
+
+    // Called once on the I/O thread of the service. error holds the exception that get() or put()
+    // would throw for the same response, it is NULL otherwise.
+    virtual void onResponse(Response& response, std::exception_ptr error) = 0;
+};
+
 class RESTfulService {
    public:
     RESTfulService() {
@@ -143,6 +162,18 @@ class RESTfulService {
     virtual ResponseCode head(const string& url, HTTPHeaders& headers) = 0;
 
     virtual Response deleteRequest(const string& url, HTTPHeaders& headers) = 0;
+
+    // Start a GET or PUT and return without waiting for the response. headers, data and callback
+    // must stay valid until callback->onResponse() is called. Return false if the service doesn't
+    // support it, the caller then has to use the blocking get() or put().
+    virtual bool getAsync(const string& url, HTTPHeaders& headers, RESTfulCallback* callback) {
+        return false;
+    }
+
+    virtual bool putAsync(const string& url, HTTPHeaders& headers, const S3VectorUInt8& data,
+                          RESTfulCallback* callback) {
+        return false;
+    }
 };
 
 #endif /* INCLUDE_RESTFUL_SERVICE_H_ */
@@ -5,6 +5,56 @@
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3interface.h"
+#include "s3inventory.h"
+
+// A unit of work of one segment, the whole key or a line aligned byte range [start, end) of it.
+struct KeyRange {
+    KeyRange(uint64_t keyIndex, uint64_t start, uint64_t end)
+        : keyIndex(keyIndex), start(start), end(end) {
+    }
+
+    uint64_t getSize() const {
+        return end - start;
+    }
+
+    uint64_t keyIndex;  // index of ListBucketResult::contents
+    uint64_t start;
+    uint64_t end;
+};
+
+// Plan which keys, or ranges of keys, are read by segment segId. Keys larger than the average
+// load of segments (but no smaller than minRangeSize) are split into ranges if splitKeys is true,
+// and canSplitKey, if given, returns true for their index. Then ranges are assigned with
+// longest-processing-time-first bin packing.
+//
+// The plan only depends on the arguments, so all segments compute the same plan without
+// coordinating with each other. Returned ranges are in the order of keys.
+vector<KeyRange> ScheduleKeyRanges(
+    const vector<BucketContent> &keys, uint64_t segId, uint64_t segNum, uint64_t minRangeSize,
+    bool splitKeys, const std::function<bool(size_t)> &canSplitKey = std::function<bool(size_t)>());
+
+// Pick whole ranges in a pseudo-random order, determined by seed, until they hold at least fraction
+// of the bytes of ranges; at least one range is picked. Returned ranges keep their order, and
+// *sampledFraction is set to the fraction of the bytes they hold.
+vector<KeyRange> SampleKeyRanges(const vector<KeyRange> &ranges, double fraction, uint64_t seed,
+                                 double *sampledFraction);
+
+// Text form of a bucket list, to be shared by segments. Returns empty string if the list can't be
+// represented, e.g. a key name contains a newline.
+string SerializeKeyList(const ListBucketResult &keyList);
+
+// Parse the text made by SerializeKeyList(), return false if the text is malformed or truncated.
+bool DeserializeKeyList(const string &text, ListBucketResult &keyList);
+
+// List the bucket once for all segments sharing cachePath: the first segment takes the file lock,
+// lists the bucket and saves the list, the others wait for the lock and load the saved list. A
+// saved list is reused for ttl seconds. Falls back to listing directly if the file can't be used.
+ListBucketResult ListBucketWithCache(S3Interface *s3Interface, S3Url &s3Url,
+                                     const string &cachePath, uint64_t ttl);
+
+// Path of the list cache file in the list cache directory of params, for the location and the
+// access key of params.
+string KeyListCachePath(const S3Params &params);
 
 // S3BucketReader read multiple files in a bucket.
 class S3BucketReader : public Reader {
@@ -14,6 +64,7 @@ class S3BucketReader : public Reader {
 
     void open(const S3Params &params);
     uint64_t read(char *buf, uint64_t count);
+    uint64_t readView(const char **data, uint64_t count);
     void close();
 
     void setS3InterfaceService(S3Interface *s3) {
@@ -24,10 +75,25 @@ class S3BucketReader : public Reader {
         this->upstreamReader = reader;
     }
 
+    // Readers of the same kind as the upstream reader, each opens a key range ahead of the one
+    // being read, so the range starts downloading before the reader gets to it.
+    void setLookaheadReaders(const vector<Reader *> &readers) {
+        this->idleReaders = readers;
+    }
+
     const ListBucketResult &getKeyList() {
         return keyList;
     }
 
+    const vector<KeyRange> &getKeyRanges() {
+        return keyRanges;
+    }
+
+    // Fraction of the bytes of this segment's ranges that are read, see S3ScanDesc::sampleFraction.
+    double getSampledFraction() {
+        return sampledFraction;
+    }
+
    private:
     S3Params params;
 
@@ -37,19 +103,31 @@ class S3BucketReader : public Reader {
     Reader *upstreamReader;
     bool needNewReader;
 
+    // Lookahead readers, opened ones have the next key ranges in order.
+    vector<Reader *> idleReaders;
+    std::deque<Reader *> prefetchedReaders;
+    void prefetchKeyRanges();
+
     // when load multiple files on one segment and each of them has a header line,
-    // we should read header line only for the 1st file and ignore remainings.
+    // we should read header line only for the 1st file and ignore remainings. Ranges not at the
+    // beginning of a key have no header line to ignore.
     bool isFirstFile;
 
     // Skip the header line (terminated with eol) if necessary.
-    // copy valid data into buf and return its size.
-    uint64_t readWithoutHeaderLine(char *buf, uint64_t count);
+    // point data to valid data and return its size.
+    uint64_t readWithoutHeaderLine(const char **data, uint64_t count);
 
     ListBucketResult keyList;  // List of matched keys/files.
-    uint64_t keyIndex;         // BucketContent index of keylist->contents.
 
-    BucketContent &getNextKey();
-    S3Params constructReaderParams(BucketContent &key);
+    vector<KeyRange> keyRanges;  // Keys or ranges of keys to read by this segment.
+    uint64_t rangeIndex;         // Index of keyRanges to read next.
+    double sampledFraction;
+
+    ListBucketResult listBucket(S3Url &s3Url);
+
+    const KeyRange &getNextKeyRange();
+    S3Params constructReaderParams(const KeyRange &range);
+    bool canSplitKey(size_t keyIndex);
 };
 
 #endif
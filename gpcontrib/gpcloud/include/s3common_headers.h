@@ -13,6 +13,8 @@
 #include <algorithm>
 #include <csignal>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
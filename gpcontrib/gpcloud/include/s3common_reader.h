@@ -2,13 +2,15 @@
 #define INCLUDE_S3COMMON_READER_H_
 
 #include "decompress_reader.h"
+#include "parquet_reader.h"
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3key_reader.h"
+#include "s3select_reader.h"
 
 class S3CommonReader : public Reader {
    public:
-    S3CommonReader() : upstreamReader(NULL), s3InterfaceService(NULL) {
+    S3CommonReader() : upstreamReader(NULL), s3InterfaceService(NULL), smallKeyPending(false) {
     }
 
     virtual ~S3CommonReader() {
@@ -21,6 +23,8 @@ class S3CommonReader : public Reader {
     // Return 0 if EOF. Throw exception if encounters errors.
     virtual uint64_t read(char* buf, uint64_t count);
 
+    virtual uint64_t readView(const char** data, uint64_t count);
+
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
@@ -30,10 +34,27 @@ class S3CommonReader : public Reader {
     }
 
    protected:
+    // Open the reader of the key's compression type.
+    void openKey(const S3Params& params, S3CompressionType compressionType);
+
+    // Open the reader of a small key once its data arrives, see S3SmallKeyReader.
+    void openSmallKey();
+
+    // Open the reader of the members of a compressed key in the range, return false if the key
+    // can't be split.
+    bool openMembers(const S3Params& params, S3CompressionType compressionType);
+
     Reader* upstreamReader;
     S3Interface* s3InterfaceService;
     S3KeyReader keyReader;
     DecompressReader decompressReader;
+    SplitDecompressReader splitReader;
+    ParquetReader parquetReader;
+    S3SelectReader selectReader;
+
+    S3SmallKeyReader smallKeyReader;
+    S3Params smallKeyParams;
+    bool smallKeyPending;
 };
 
 #endif /* INCLUDE_S3COMMON_READER_H_ */
@@ -2,6 +2,7 @@
 #define INCLUDE_S3COMMON_WRITER_H_
 
 #include "compress_writer.h"
+#include "parquet_writer.h"
 #include "s3common_headers.h"
 #include "s3key_writer.h"
 #include "s3url.h"
@@ -25,6 +26,13 @@ class S3CommonWriter : public Writer {
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
+    virtual void rollover(const S3Url& url);
+
+    // Bytes written to the current key, compressed ones if compression is on.
+    uint64_t getKeySize() const {
+        return this->keyWriter.getKeySize();
+    }
+
     // Used by Mock, DO NOT call it in other places.
     void setS3InterfaceService(S3Interface* s3InterfaceService) {
         this->s3InterfaceService = s3InterfaceService;
@@ -35,6 +43,7 @@ class S3CommonWriter : public Writer {
     S3Interface* s3InterfaceService;
     S3KeyWriter keyWriter;
     CompressWriter compressWriter;
+    ParquetWriter parquetWriter;
 };
 
 #endif
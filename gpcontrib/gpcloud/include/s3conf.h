@@ -9,6 +9,10 @@ extern int32_t s3ext_segid;
 // total segment number
 extern int32_t s3ext_segnum;
 
+// session and command of the statement, same on all segments
+extern int32_t s3ext_sessionid;
+extern int32_t s3ext_commandid;
+
 // UDP socket to send log
 extern int32_t s3ext_logsock_udp;
 
@@ -30,4 +34,7 @@ extern struct sockaddr_in s3ext_logserveraddr;
 class S3Params;
 void CheckEssentialConfig(const S3Params& params);
 
+// Forget the configurations parsed by InitConfig(), so that config files are read again.
+void ClearConfigCache();
+
 #endif
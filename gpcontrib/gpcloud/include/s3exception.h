@@ -48,6 +48,18 @@ class S3ConnectionError : public S3Exception {
     string message;
 };
 
+// ServiceUnavailable or SlowDown, the server asks for a lower request rate
+class S3ThrottleError : public S3ConnectionError {
+   public:
+    S3ThrottleError(const string& msg) : S3ConnectionError(msg) {
+    }
+    virtual ~S3ThrottleError() {
+    }
+    virtual string getType() {
+        return "S3ThrottleError";
+    }
+};
+
 class S3ResolveError : public S3Exception {
    public:
     S3ResolveError(const string& msg) : message(msg) {
@@ -16,6 +16,11 @@ enum HeaderField {
     X_AMZ_DATE,
     X_AMZ_CONTENT_SHA256,
     X_AMZ_SERVER_SIDE_ENCRYPTION,
+    IF_NONE_MATCH,
+    X_AMZ_CHECKSUM_ALGORITHM,
+    X_AMZ_CHECKSUM_CRC32C,
+    X_AMZ_CHECKSUM_TYPE,
+    X_AMZ_OBJECT_ATTRIBUTES,
 };
 
 // HTTPHeaders wraps curl_slist using std::map to ease manipulating HTTP
@@ -5,6 +5,7 @@
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3log.h"
+#include "s3rate_limiter.h"
 #include "s3restful_service.h"
 #include "s3url.h"
 
@@ -13,19 +14,26 @@
 #define S3_REQUEST_NO_RETRY 1
 #define S3_REQUEST_MAX_RETRIES 5
 
+// Limit of the delay between retries, see S3Params::getRetryBackoff().
+#define S3_RETRY_BACKOFF_MAX_US (20 * 1000 * 1000)
+
 #define S3_RANGE_HEADER_STRING_LEN 128
 
 enum S3CompressionType {
     S3_COMPRESSION_GZIP,
+    S3_COMPRESSION_ZSTD,
+    S3_COMPRESSION_LZ4,
     S3_COMPRESSION_PLAIN,
+    S3_COMPRESSION_PARQUET,  // not a compression, but a file format detected by its magic
 };
 
 struct BucketContent {
     BucketContent() : name(""), size(0) {
     }
-    BucketContent(string name, uint64_t size) {
+    BucketContent(string name, uint64_t size, string etag = "") {
         this->name = name;
         this->size = size;
+        this->etag = etag;
     }
     ~BucketContent() {
     }
@@ -36,9 +44,13 @@ struct BucketContent {
     uint64_t getSize() const {
         return this->size;
     };
+    string getETag() const {
+        return this->etag;
+    };
 
     string name;
     uint64_t size;
+    string etag;  // changes when the key is overwritten, empty if unknown
 };
 
 struct ListBucketResult {
@@ -47,6 +59,50 @@ struct ListBucketResult {
     vector<BucketContent> contents;
 };
 
+// A part of the key space listed by a parallel listing: the keys under the prefix after startAfter,
+// up to and including last.
+struct ListShard {
+    ListShard(const string &encodedPrefix, const string &startAfter = "",
+              const string &last = "")
+        : encodedPrefix(encodedPrefix), startAfter(startAfter), last(last) {
+    }
+
+    string encodedPrefix;
+    string startAfter;  // empty to list from the first key
+    string last;        // empty to list to the last key
+};
+
+// Completion of S3Interface::fetchDataAsync().
+class S3FetchCallback {
+   public:
+    virtual ~S3FetchCallback() {
+    }
+
+    // The request is given up once it returns true.
+    virtual bool isCancelled() = 0;
+
+    // Called once, error is NULL if all requested bytes are fetched.
+    virtual void onFetched(std::exception_ptr error) = 0;
+};
+
+// Completion of S3Interface::uploadPartOfDataAsync().
+class S3UploadCallback {
+   public:
+    virtual ~S3UploadCallback() {
+    }
+
+    // Called once with the ETag of the uploaded part, or with the error of the upload.
+    virtual void onUploaded(const string &etag, std::exception_ptr error) = 0;
+};
+
+// Detect the compression type, or the file format, from the first bytes of a key.
+S3CompressionType GetCompressionTypeFromMagic(const uint8_t *data, uint64_t len);
+
+// Append payloads of the Records events in an S3 Select response to records. The response is a
+// sequence of messages of the AWS event stream encoding, throw exception if an error event is
+// received, a message is malformed or the End event is missing.
+void DecodeS3SelectEventStream(const uint8_t *data, uint64_t len, S3VectorUInt8 &records);
+
 class S3Interface {
    public:
     virtual ~S3Interface() {
@@ -63,13 +119,36 @@ class S3Interface {
 
     virtual string getUploadId(const S3Url &s3Url) = 0;
 
+    // checksum is the base64 encoded CRC32C of data, empty if the part is sent without one.
     virtual string uploadPartOfData(S3VectorUInt8 &data, const S3Url &s3Url, uint64_t partNumber,
-                                    const string &uploadId) = 0;
+                                    const string &uploadId, const string &checksum) = 0;
 
+    // checksumArray has the checksums of the parts, or is empty if they have none.
     virtual bool completeMultiPart(const S3Url &s3Url, const string &uploadId,
-                                   const vector<string> &etagArray) = 0;
+                                   const vector<string> &etagArray,
+                                   const vector<string> &checksumArray) = 0;
 
     virtual bool abortUpload(const S3Url &s3Url, const string &uploadId) = 0;
+
+    // Run a SelectObjectContentRequest on the key and append the records it returns to records.
+    virtual void selectObjectContent(const S3Url &s3Url, const string &request,
+                                     S3VectorUInt8 &records) = 0;
+
+    // The base64 encoded CRC32C that the store keeps of the whole key, or "" if it has none. By
+    // default keys have none.
+    virtual string getKeyChecksum(const S3Url &s3Url) {
+        return "";
+    }
+
+    // Asynchronous versions of fetchData() and uploadPartOfData(), data must stay valid until the
+    // callback is called. By default they block in the synchronous versions and call the callback
+    // before returning, interfaces with an I/O thread return at once and call it on that thread.
+    virtual void fetchDataAsync(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                                const S3Url &s3Url, S3FetchCallback *callback);
+
+    virtual void uploadPartOfDataAsync(S3VectorUInt8 &data, const S3Url &s3Url,
+                                       uint64_t partNumber, const string &uploadId,
+                                       const string &checksum, S3UploadCallback *callback);
 };
 
 class S3InterfaceService : public S3Interface {
@@ -86,6 +165,18 @@ class S3InterfaceService : public S3Interface {
 
     bool checkKeyExistence(const S3Url &s3Url);
 
+    void selectObjectContent(const S3Url &s3Url, const string &request, S3VectorUInt8 &records);
+
+    string getKeyChecksum(const S3Url &s3Url);
+
+    // Run by the I/O thread of the RESTful service if it supports asynchronous requests.
+    void fetchDataAsync(uint64_t offset, S3VectorUInt8 &data, uint64_t len, const S3Url &s3Url,
+                        S3FetchCallback *callback);
+
+    void uploadPartOfDataAsync(S3VectorUInt8 &data, const S3Url &s3Url, uint64_t partNumber,
+                               const string &uploadId, const string &checksum,
+                               S3UploadCallback *callback);
+
     void setRESTfulService(RESTfulService *restfullService) {
         this->restfulService = restfullService;
     }
@@ -110,25 +201,106 @@ class S3InterfaceService : public S3Interface {
     string getUploadId(const S3Url &s3Url);
 
     string uploadPartOfData(S3VectorUInt8 &data, const S3Url &s3Url, uint64_t partNumber,
-                            const string &uploadId);
+                            const string &uploadId, const string &checksum);
 
     bool completeMultiPart(const S3Url &s3Url, const string &uploadId,
-                           const vector<string> &etagArray);
+                           const vector<string> &etagArray, const vector<string> &checksumArray);
 
     bool abortUpload(const S3Url &s3Url, const string &uploadId);
 
    private:
-    bool parseBucketXML(ListBucketResult *result, xmlParserCtxtPtr xmlcontext, string &marker);
+    // Append keys of a page of the listing to result, marker is set to the key to list from if
+    // the listing is truncated. The common prefixes of a listing with a delimiter are appended to
+    // commonPrefixes, if it is not NULL.
+    bool parseBucketXML(ListBucketResult *result, const Response &response, string &marker,
+                        vector<string> *commonPrefixes = NULL);
 
     Response getBucketResponse(const S3Url &s3Url, const string &encodedQuery);
 
-    xmlParserCtxtPtr getXMLContext(Response &response);
+    // Thread requesting the next page of a listing, see ListPagePrefetch.
+    static void *ListPageThreadFunc(void *data);
+
+    // List the parts of the key space under the prefix with listParallelism threads.
+    ListBucketResult listBucketInParallel(const S3Url &s3Url, const string &prefix);
+
+    // Split the key space under the prefix into parts, the keys found while doing so that are in
+    // none of them are appended to result.
+    vector<ListShard> findListShards(const S3Url &s3Url, const string &prefix,
+                                     ListBucketResult &result);
+
+    // Append the keys of a part of the key space to result.
+    void listShard(const S3Url &s3Url, const ListShard &shard, ListBucketResult *result);
+
+    // Thread listing parts of a parallel listing, see ParallelListing.
+    static void *ListShardThreadFunc(void *data);
 
     bool isKeyExisted(ResponseCode code);
 
+    // Sleep before retrying a request after its attempt-th failure.
+    void waitBeforeRetry(uint64_t attempt);
+
+    // Sleep until the request rate of the bucket allows one more request.
+    void waitForRequestRate();
+
+    // Lower the request rate if the failure is a throttled request.
+    void checkThrottled(S3ConnectionError &e);
+
+    void prepareFetchHeaders(HTTPHeaders &headers, uint64_t offset, uint64_t len,
+                             const S3Url &s3Url);
+
+    string prepareUploadHeaders(HTTPHeaders &headers, const S3VectorUInt8 &data,
+                                const S3Url &s3Url, uint64_t partNumber, const string &uploadId,
+                                const string &checksum);
+
    private:
     RESTfulService *restfulService;
     S3Params params;
+    S3RateLimiter rateLimiter;
+};
+
+// Merged ranges of S3RangeFetcher are at most this long, unless a single range is longer.
+#define S3_RANGE_COALESCE_MAX_LEN (64 * 1024 * 1024)
+
+// Read ranges of a key with fewer requests, for readers of columnar files that need many small
+// ranges at once. Ranges planned together whose gaps are at most maxGap bytes are fetched by one
+// GET when the first of them is read, the others are served from its buffer. maxGap 0 disables
+// merging, each range is fetched on its own.
+class S3RangeFetcher {
+   public:
+    S3RangeFetcher() : s3Interface(NULL), s3Url(""), maxGap(0), numOfRequests(0) {
+    }
+
+    void reset(S3Interface *s3Interface, const S3Url &s3Url, uint64_t maxGap);
+
+    // Ranges of offset and length to read next, the buffers of the ranges planned before are
+    // freed unless new ranges are inside them, such ranges are not fetched again.
+    void plan(const vector<std::pair<uint64_t, uint64_t> > &ranges);
+
+    // Return the data of a range. It is valid until the next plan(), or the next fetch() of a
+    // range not covered by the planned ones.
+    const uint8_t *fetch(uint64_t offset, uint64_t len);
+
+    uint64_t getNumOfRequests() const {
+        return this->numOfRequests;
+    }
+
+   private:
+    struct Segment {
+        uint64_t offset;
+        uint64_t len;
+        bool fetched;
+        S3VectorUInt8 data;
+    };
+
+    void fetchSegment(Segment &segment);
+
+    S3Interface *s3Interface;
+    S3Url s3Url;
+    uint64_t maxGap;
+    uint64_t numOfRequests;
+
+    vector<Segment> segments;  // merged planned ranges
+    Segment unplanned;
 };
 
 #endif /* INCLUDE_S3INTERFACE_H_ */
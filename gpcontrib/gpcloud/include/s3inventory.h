@@ -0,0 +1,49 @@
+#ifndef INCLUDE_S3INVENTORY_H_
+#define INCLUDE_S3INVENTORY_H_
+
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+#include "s3params.h"
+
+// Columns of the Parquet files of an inventory read as the keys of a location, in this order.
+#define S3_INVENTORY_PARQUET_COLUMNS \
+    { "key", "size", "last_modified_date", "e_tag", "is_latest", "is_delete_marker" }
+
+// Field names of the CSV lines of the same columns, as in fileSchema of the manifest.
+#define S3_INVENTORY_PARQUET_SCHEMA \
+    { "Key", "Size", "LastModifiedDate", "ETag", "IsLatest", "IsDeleteMarker" }
+
+// manifest.json of an S3 Inventory report, it lists the data files holding the report.
+struct S3InventoryManifest {
+    string sourceBucket;        // bucket the report is of
+    string fileFormat;          // "CSV", "ORC" or "Parquet"
+    vector<string> fileSchema;  // field names of the CSV lines, in order
+    vector<BucketContent> files;  // data files, in the bucket of the manifest
+};
+
+// Parse the manifest, return false if it is malformed or lacks a field.
+bool ParseInventoryManifest(const string &json, S3InventoryManifest &manifest);
+
+// Keys of an inventory read as the keys of a location.
+struct S3InventoryFilter {
+    string prefix;          // of the location
+    string modifiedAfter;   // keys modified at or after it, empty if unbounded
+    string modifiedBefore;  // keys modified before it, empty if unbounded
+};
+
+// Make an ISO 8601 time of a report, or an option, comparable as a string with the others.
+string NormalizeInventoryTime(const string &time);
+
+// Append the keys in CSV lines of a report that pass the filter to contents. Keys of CSV reports
+// are URL encoded, those of Parquet files read as CSV are not.
+void ParseInventoryCSV(const char *data, uint64_t len, const vector<string> &schema,
+                       bool encodedKeys, const S3InventoryFilter &filter,
+                       vector<BucketContent> &contents);
+
+// List the keys of the location from the inventory report whose manifest is
+// params.getInventoryManifest(), instead of listing the bucket. Keys are in the order of a
+// listing.
+ListBucketResult ListBucketFromInventory(S3Interface *s3Interface, const S3Params &params);
+
+#endif
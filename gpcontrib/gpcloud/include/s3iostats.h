@@ -0,0 +1,59 @@
+#ifndef INCLUDE_S3IOSTATS_H_
+#define INCLUDE_S3IOSTATS_H_
+
+#include <atomic>
+
+#include "s3common_headers.h"
+
+enum S3IOCounter {
+    S3IO_REQUESTS,          // HTTP requests sent, retried ones included
+    S3IO_RETRIES,           // requests sent again after a retryable failure
+    S3IO_THROTTLES,         // 503 or SlowDown responses
+    S3IO_BYTES_DOWNLOADED,  // response bodies of successful GETs
+    S3IO_BYTES_UPLOADED,    // request bodies of successful PUTs and POSTs
+    S3IO_WAIT_US,           // time spent in HTTP requests, summed over all threads
+    S3IO_DECOMPRESS_US,     // time spent in decompression, summed over all threads
+    S3IO_NUM_COUNTERS
+};
+
+extern const char *S3IOCounterNames[S3IO_NUM_COUNTERS];
+
+// Counters of S3 I/O made by this process. They are updated by the reader and writer threads
+// and the curl multi thread at the same time, and reset by the caller at the start of a query.
+class S3IOStats {
+   public:
+    S3IOStats() {
+        this->reset();
+    }
+
+    void add(S3IOCounter counter, uint64_t n = 1) {
+        this->counters[counter].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t get(S3IOCounter counter) const {
+        return this->counters[counter].load(std::memory_order_relaxed);
+    }
+
+    void reset();
+
+    // "name=value" pairs of all counters, for logging.
+    string toString() const;
+
+   private:
+    std::atomic<uint64_t> counters[S3IO_NUM_COUNTERS];
+};
+
+S3IOStats &GetS3IOStats();
+
+// Add the time from its construction to its destruction to a counter of GetS3IOStats().
+class S3IOTimer {
+   public:
+    explicit S3IOTimer(S3IOCounter counter);
+    ~S3IOTimer();
+
+   private:
+    S3IOCounter counter;
+    uint64_t startUs;
+};
+
+#endif /* INCLUDE_S3IOSTATS_H_ */
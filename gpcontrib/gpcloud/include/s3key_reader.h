@@ -1,23 +1,100 @@
 #ifndef INCLUDE_S3KEY_READER_H_
 #define INCLUDE_S3KEY_READER_H_
 
+#include <atomic>
+
 #include "reader.h"
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3interface.h"
+#include "s3read_cache.h"
 
 struct Range {
     uint64_t offset;
     uint64_t length;
 };
 
+// Size of chunks to download beyond the soft end of a key range, they are only needed to finish
+// the last line of the range, so keep them small to avoid downloading data of next range.
+#define S3_RANGE_TAIL_CHUNKSIZE (1024 * 1024)
+
+// Smallest chunk to download in adaptive mode, smaller requests are dominated by latency.
+#define S3_ADAPTIVE_MIN_CHUNKSIZE (1024 * 1024)
+
+// Number of ranged GETs in flight at the beginning of adaptive downloading.
+#define S3_ADAPTIVE_INIT_FETCHES 2
+
+// Limit the number of ranged GETs in flight, and adjust the limit by the throughput and latency of
+// the requests. Each round of 'limit' finished requests, limit is increased if throughput grows,
+// and is decreased if throughput or latency degrades. Limit never exceeds the number of chunks,
+// so memory stays in the envelope of chunk buffers.
+class FetchLimiter {
+   public:
+    FetchLimiter();
+    ~FetchLimiter();
+
+    void reset(uint64_t maxLimit, uint64_t initLimit, uint64_t nowUs);
+
+    // Wait a free slot, return false if stopped.
+    bool acquire();
+
+    // A request holding a slot finished, with 'bytes' downloaded in 'latencyUs'.
+    void release(uint64_t bytes, uint64_t latencyUs, uint64_t nowUs);
+
+    // Wake up and fail all waiters of acquire().
+    void stop();
+
+    uint64_t getLimit();
+
+   private:
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    uint64_t limit;
+    uint64_t maxLimit;
+    uint64_t inFlight;
+    bool stopped;
+
+    uint64_t bestThroughput;  // bytes per second
+    uint64_t bestLatencyUs;   // average request latency while reaching best throughput
+
+    // requests finished in current round.
+    uint64_t roundStartUs;
+    uint64_t roundBytes;
+    uint64_t roundLatencyUs;
+    uint64_t roundRequests;
+};
+
+// Recent latencies kept to tell a straggling fetch, and the least of them needed to tell it.
+#define S3_HEDGE_LATENCY_WINDOW 64
+#define S3_HEDGE_MIN_SAMPLES 8
+// a fetch is hedged no sooner than this, however fast the others are.
+#define S3_HEDGE_MIN_DELAY_US (10 * 1000)
+
+// Latencies of the recent fetches of full chunks of a key, shared by all chunks.
+class LatencyTracker {
+   public:
+    LatencyTracker();
+    ~LatencyTracker();
+
+    void reset();
+
+    void add(uint64_t latencyUs);
+
+    // 95th percentile of the recent latencies, 0 if there are fewer than S3_HEDGE_MIN_SAMPLES.
+    uint64_t getP95();
+
+   private:
+    pthread_mutex_t mutex;
+    vector<uint64_t> samples;
+    uint64_t next;  // index of samples to overwrite once the window is full
+};
+
+// Hand out ranges of a key to chunks, getNextOffset() is lock free. Sizes are set before chunks
+// start to download.
 class OffsetMgr {
    public:
-    OffsetMgr() : keySize(0), chunkSize(0), curPos(0) {
-        pthread_mutex_init(&this->offsetLock, NULL);
-    }
-    ~OffsetMgr() {
-        pthread_mutex_destroy(&this->offsetLock);
+    OffsetMgr() : keySize(0), chunkSize(0), curPos(0), softEnd(0) {
     }
 
     Range getNextOffset();  // ret.length == 0 means EOF
@@ -39,24 +116,34 @@ class OffsetMgr {
     }
 
     void setCurPos(uint64_t curPos) {
-        this->curPos = curPos;
+        this->curPos.store(curPos);
+    }
+
+    // Offsets beyond softEnd are handed out in S3_RANGE_TAIL_CHUNKSIZE chunks, 0 means no soft end.
+    uint64_t getSoftEnd() const {
+        return softEnd;
+    }
+
+    void setSoftEnd(uint64_t softEnd) {
+        this->softEnd = softEnd;
     }
 
     void reset() {
         this->setCurPos(0);
         this->setChunkSize(0);
         this->setKeySize(0);
+        this->setSoftEnd(0);
     }
 
     uint64_t getCurPos() const {
-        return curPos;
+        return curPos.load();
     }
 
    private:
-    pthread_mutex_t offsetLock;
     uint64_t keySize;  // size of S3 key(file)
     uint64_t chunkSize;
-    uint64_t curPos;
+    std::atomic<uint64_t> curPos;
+    uint64_t softEnd;
 };
 
 enum ChunkStatus {
@@ -64,7 +151,12 @@ enum ChunkStatus {
     ReadyToFill,
 };
 
+// Times the reader yields while waiting for a chunk before parking on its condition variable,
+// chunks are usually filled soon after the reader gets to them.
+#define S3_CHUNK_SPIN_COUNT 100
+
 class ChunkBuffer;
+class ChunkFetch;
 
 class S3KeyReader : public Reader {
    public:
@@ -74,17 +166,37 @@ class S3KeyReader : public Reader {
           curReadingChunk(0),
           transferredKeyLen(0),
           s3Interface(NULL),
+          lentChunk(NULL),
           hasEol(false),
-          eolAppended(false) {
+          eolAppended(false),
+          readStart(0),
+          rangeEnd(0),
+          isRangeRead(false),
+          skippingFirstLine(false),
+          rangeFinished(false),
+          adaptive(false),
+          multiplexed(false),
+          fetchesInFlight(0),
+          hedged(false),
+          hedging(false),
+          verifying(false),
+          expectedCrc(0),
+          keyCrc(0),
+          crcChunks(0) {
         pthread_mutex_init(&this->mutexErrorMessage, NULL);
+        pthread_mutex_init(&this->fetchMutex, NULL);
+        pthread_cond_init(&this->fetchCond, NULL);
     }
     virtual ~S3KeyReader() {
         this->close();
         pthread_mutex_destroy(&this->mutexErrorMessage);
+        pthread_mutex_destroy(&this->fetchMutex);
+        pthread_cond_destroy(&this->fetchCond);
     }
 
     void open(const S3Params& params);
     uint64_t read(char* buf, uint64_t count);
+    uint64_t readView(const char** data, uint64_t count);
     void close();
 
     void setS3InterfaceService(S3Interface* s3) {
@@ -124,6 +236,16 @@ class S3KeyReader : public Reader {
         pthread_mutex_unlock(&this->mutexErrorMessage);
     }
 
+    // The first error is kept, later ones are usually caused by it, e.g. cancelled fetches.
+    void setSharedError(bool sharedError, std::exception_ptr e) {
+        pthread_mutex_lock(&this->mutexErrorMessage);
+        if (this->sharedException == NULL) {
+            this->sharedException = e;
+        }
+        this->sharedError = sharedError;
+        pthread_mutex_unlock(&this->mutexErrorMessage);
+    }
+
     const vector<pthread_t>& getThreads() const {
         return threads;
     }
@@ -140,6 +262,47 @@ class S3KeyReader : public Reader {
         return region;
     }
 
+    bool isAdaptive() const {
+        return adaptive;
+    }
+
+    FetchLimiter& getFetchLimiter() {
+        return fetchLimiter;
+    }
+
+    S3ReadCache& getReadCache() {
+        return readCache;
+    }
+
+    const string& getKeyETag() const {
+        return keyETag;
+    }
+
+    bool isMultiplexed() const {
+        return multiplexed;
+    }
+
+    // Count the fetches started by chunks, close() waits for all of them to finish.
+    void fetchStarted();
+    void fetchFinished();
+
+    bool isHedgedFetch() const {
+        return hedged;
+    }
+
+    LatencyTracker& getLatencyTracker() {
+        return latencyTracker;
+    }
+
+    // One chunk at a time races a hedged fetch, the memory context has one spare chunk for it.
+    // Return false if another chunk is racing.
+    bool tryStartHedge();
+    void hedgeFinished();
+
+    bool isVerifyingChecksum() const {
+        return verifying;
+    }
+
    private:
     pthread_mutex_t mutexErrorMessage;
 
@@ -160,16 +323,66 @@ class S3KeyReader : public Reader {
 
     S3Interface* s3Interface;
 
+    ChunkBuffer* lentChunk;  // chunk whose data is lent by the last readView()
+    void releaseLentChunk();
+
     void reset();
 
+    uint64_t readKey(const char** data, uint64_t count);
+    uint64_t readRange(const char** data, uint64_t count);
+
     bool hasEol;
     bool eolAppended;
+
+    // Reading a byte range of the key, see S3Params::getKeyRangeStart().
+    uint64_t readStart;  // offset of the first byte to download
+    uint64_t rangeEnd;
+    bool isRangeRead;
+    bool skippingFirstLine;  // first partial line belongs to previous range
+    bool rangeFinished;
+
+    // Quoting is ignored, whether a range starts in a quoted field is unknown without reading
+    // the key from its beginning.
+    EolScanner eolScanner;
+
+    // Adaptive mode, see S3Params::isAdaptiveDownload().
+    bool adaptive;
+    FetchLimiter fetchLimiter;
+
+    // Enabled by S3Params::getReadCacheDir() for keys with a known ETag.
+    S3ReadCache readCache;
+    string keyETag;
+
+    // Multiplexed mode, see S3Params::isMultiplexIO(). Chunks are filled by the I/O thread of
+    // s3Interface instead of downloading threads.
+    bool multiplexed;
+    pthread_mutex_t fetchMutex;
+    pthread_cond_t fetchCond;
+    uint64_t fetchesInFlight;
+    void waitForFetches();
+
+    // Hedged mode, see S3Params::isHedgedFetch(). hedging is protected by fetchMutex.
+    bool hedged;
+    bool hedging;
+    LatencyTracker latencyTracker;
+
+    // A whole key read with S3Params::isCrc32cChecksum() is checked against the CRC32C the store
+    // keeps of it. Chunks compute the CRC32C of their data when they are filled, the reader
+    // combines them in key order.
+    bool verifying;
+    uint32_t expectedCrc;
+    uint32_t keyCrc;
+    uint64_t crcChunks;  // chunks combined into keyCrc
+    void verifyChecksum();
 };
 
 class ChunkBuffer {
    public:
     ChunkBuffer(const S3Url& s3Url, S3KeyReader& reader, const S3MemoryContext& context);
 
+    // needed for vector, the copy has its own status lock.
+    ChunkBuffer(const ChunkBuffer& other);
+
     ~ChunkBuffer();
 
     // if a class has reference member, then it can't be
@@ -189,10 +402,29 @@ class ChunkBuffer {
     uint64_t read(char* buf, uint64_t len);
     uint64_t fill();
 
+    // Multiplexed version of fill(), it returns at once and the chunk becomes ReadyToRead when
+    // the fetch finishes.
+    void startFill();
+
+    // Called once by each fetch started by startFill() or by a hedge, the fetch is deleted then.
+    void finishFetch(ChunkFetch* fetch, std::exception_ptr error);
+
+    // Lend data of this chunk instead of copying, the chunk is not refilled until releaseView().
+    uint64_t readView(const char** data, uint64_t len);
+    void releaseView();
+
     void setS3InterfaceService(S3Interface* s3) {
         this->s3Interface = s3;
     }
 
+    S3Interface* getS3InterfaceService() {
+        return this->s3Interface;
+    }
+
+    const S3Url& getS3Url() const {
+        return this->s3Url;
+    }
+
     pthread_mutex_t* getStatMutex() {
         return &statusMutex;
     }
@@ -209,6 +441,15 @@ class ChunkBuffer {
         return status;
     }
 
+    // CRC32C of the data of the current range, if the reader verifies the key.
+    uint32_t getChunkCrc() const {
+        return chunkCrc;
+    }
+
+    uint64_t getChunkDataSize() const {
+        return chunkDataSize;
+    }
+
     void setSharedError(bool sharedError) {
         this->sharedKeyReader.setSharedError(sharedError);
     }
@@ -222,9 +463,25 @@ class ChunkBuffer {
     S3Url s3Url;
 
    private:
+    // The status lock must be held by the functions below.
+
+    // Set the chunk ReadyToRead, data of the current range is saved to the read cache if fetched.
+    void markReadyToRead(bool fetched);
+
+    // Take data of a fetch of the current range, if it's the first to finish. Return true if it
+    // is the last one of a hedged race.
+    bool completeFetch(uint64_t generation, bool hedge, uint64_t startUs, S3VectorUInt8& data,
+                       std::exception_ptr error);
+
+    // Time to start a hedged fetch of the current range, 0 if it is not to be hedged.
+    uint64_t getHedgeTimeUs();
+    void startHedge();
+
     bool eof;
+    bool drained;  // all data is read, waiting for releaseView() to be refilled.
 
-    ChunkStatus status;
+    // changed with the status lock held, atomic so that the reader can spin on it without the lock.
+    std::atomic<ChunkStatus> status;
 
     pthread_mutex_t statusMutex;
     pthread_cond_t statusCondVar;
@@ -232,11 +489,76 @@ class ChunkBuffer {
     uint64_t curFileOffset;
     uint64_t curChunkOffset;
     uint64_t chunkDataSize;
+    uint32_t chunkCrc;
 
     S3VectorUInt8 chunkData;
+
+    // Each range of the chunk is a new generation, fetches of older ones are dropped. A range is
+    // fetching from the start of its first fetch until one of its fetches finishes.
+    uint64_t generation;
+    bool fetching;
+    uint64_t fetchStartUs;
+    bool hedgeStarted;         // for the current range
+    uint64_t hedgeGeneration;  // generation of the last hedged range
+    uint64_t racers;           // fetches of hedgeGeneration not finished yet
+    bool filling;              // the downloading thread is fetching fillGeneration
+    uint64_t fillGeneration;
+    ChunkFetch* primaryFetch;  // multiplexed fetch of the current range
+    ChunkFetch* hedgeFetch;
+
     OffsetMgr& offsetMgr;
     S3Interface* s3Interface;
     S3KeyReader& sharedKeyReader;
 };
 
+// Read a small key as a whole with a single GET, without chunks and downloading threads. The GET
+// is sent by open() and the first read waits for it, so keys opened ahead are downloaded at the
+// same time if the I/O thread runs them, see S3Params::isMultiplexIO(). Like S3KeyReader, an EOL
+// is appended if the key doesn't end with one.
+class S3SmallKeyReader : public Reader, public S3FetchCallback {
+   public:
+    S3SmallKeyReader();
+    virtual ~S3SmallKeyReader();
+
+    // Opening an opened reader does nothing, so that the key can be read through another reader
+    // (e.g. DecompressReader) chosen after the data arrives.
+    void open(const S3Params& params);
+    uint64_t read(char* buf, uint64_t count);
+    uint64_t readView(const char** data, uint64_t count);
+    void close();
+
+    // Wait for the key, and detect its compression type from the data.
+    S3CompressionType getCompressionType();
+
+    void setS3InterfaceService(S3Interface* s3) {
+        this->s3Interface = s3;
+    }
+
+    bool isCancelled();
+    void onFetched(std::exception_ptr error);
+
+   private:
+    // Throw if the GET failed.
+    void waitForData();
+
+    S3Interface* s3Interface;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    // protected by mutex.
+    bool opened;
+    bool fetching;
+    bool cancelled;
+    std::exception_ptr error;
+
+    S3VectorUInt8 data;
+    uint64_t readOffset;
+    bool eolAppended;
+
+    // expected CRC32C of the key, checked once the GET finishes, see S3Params::isCrc32cChecksum().
+    bool verifying;
+    uint32_t expectedCrc;
+};
+
 #endif /* INCLUDE_S3KEYREADER_H_ */
@@ -8,9 +8,37 @@
 
 class WriterBuffer : public vector<uint8_t> {};
 
+struct ThreadParams;
+
+// A multipart upload of a key. After a rollover the parts of the previous keys are still being
+// uploaded while the next key is filled, a key is completed once all of its parts are uploaded.
+struct KeyUpload {
+    KeyUpload(const S3Url& url, const string& uploadId)
+        : url(url), uploadId(uploadId), partNumber(0), activeParts(0), size(0) {
+    }
+
+    S3Url url;
+    string uploadId;
+    map<uint64_t, string> etagList;
+    map<uint64_t, string> checksumList;  // of the parts, if they are uploaded with CRC32C
+    uint64_t partNumber;   // number of the last part queued
+    uint64_t activeParts;  // parts queued but not uploaded yet
+    uint64_t size;         // bytes queued
+};
+
 class S3KeyWriter : public Writer {
    public:
-    S3KeyWriter() : sharedError(false), s3Interface(NULL), partNumber(0), activeThreads(0) {
+    S3KeyWriter()
+        : sharedError(false),
+          s3Interface(NULL),
+          bufferCrc(0),
+          currentKey(NULL),
+          numOfKeys(0),
+          partNumber(0),
+          activeThreads(0),
+          ringStalls(0),
+          ringStallUs(0),
+          ringBusySum(0) {
         pthread_mutex_init(&this->mutex, NULL);
         pthread_cond_init(&this->cv, NULL);
         pthread_mutex_init(&this->exceptionMutex, NULL);
@@ -20,6 +48,8 @@ class S3KeyWriter : public Writer {
             this->close();
         } catch (...) {
         }
+        this->releaseRing();
+        this->releaseKeys();
         pthread_mutex_destroy(&this->mutex);
         pthread_cond_destroy(&this->cv);
         pthread_mutex_destroy(&this->exceptionMutex);
@@ -38,10 +68,50 @@ class S3KeyWriter : public Writer {
         this->s3Interface = s3;
     }
 
+    // Finish writing the current key and continue with a new one at url. The parts of the
+    // current key keep uploading, it is completed when they are finished.
+    void rollover(const S3Url& url);
+
+    // Bytes written to the current key so far.
+    uint64_t getKeySize() const {
+        return (this->currentKey == NULL) ? 0 : this->currentKey->size + this->buffer.size();
+    }
+
+    // Keys written so far, the current one included.
+    uint64_t getNumOfKeys() const {
+        return this->numOfKeys;
+    }
+
+    // Times the backend waited for a free part buffer, and how long it waited in total.
+    uint64_t getRingStalls() const {
+        return this->ringStalls;
+    }
+    uint64_t getRingStallUs() const {
+        return this->ringStallUs;
+    }
+
+    // Average percentage of the ring being uploaded when a part is queued.
+    uint64_t getRingUtilization() const;
+
    protected:
+    friend struct ThreadParams;
+
     static void* UploadThreadFunc(void* p);
 
+    // Record the result of uploading a part, called by the uploading thread or the I/O thread.
+    void finishPart(ThreadParams* part, const string& etag, std::exception_ptr error);
+
+    void prepareRing();
+    void releaseRing();
+
+    KeyUpload* startKey(const S3Url& url);
+    void completeKey(KeyUpload* key);
+    void completeUploadedKeys();
+    void abortKeys();
+    void releaseKeys();
+
     void flushBuffer();
+    void waitForUploads();
     void completeKeyWriting();
     void checkQueryCancelSignal();
 
@@ -52,15 +122,29 @@ class S3KeyWriter : public Writer {
     S3VectorUInt8 buffer;
     S3Interface* s3Interface;
 
-    string uploadId;
-    map<uint64_t, string> etagList;
+    // CRC32C of buffer, computed while the data is copied in, if crc32c_checksum is set.
+    uint32_t bufferCrc;
+
+    // the key being filled, and the rolled over keys whose parts are being uploaded.
+    KeyUpload* currentKey;
+    vector<KeyUpload*> rolledKeys;
+    uint64_t numOfKeys;
 
     vector<pthread_t> threadList;
     pthread_mutex_t mutex;
     pthread_cond_t cv;
-    uint64_t partNumber;
+    uint64_t partNumber;  // parts queued, of all keys
     uint64_t activeThreads;
 
+    // A ring of numOfChunks part buffers taken from the memory context, together with buffer it
+    // uses all chunks preallocated for the writer. A part being uploaded holds the data, the
+    // backend swaps buffer with a free part and keeps filling the recycled memory.
+    vector<ThreadParams*> parts;
+    vector<ThreadParams*> freeParts;
+    uint64_t ringStalls;
+    uint64_t ringStallUs;
+    uint64_t ringBusySum;
+
     S3Params params;
 };
 
@@ -1,6 +1,8 @@
 #ifndef __S3MEMORY_MGMT_H__
 #define __S3MEMORY_MGMT_H__
 
+#include <atomic>
+
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3macros.h"
@@ -8,40 +10,84 @@
 void* S3Alloc(size_t);
 void S3Free(void*);
 
+// Chunks kept by the backend across keys and queries, so that readers and writers don't allocate
+// and fault in their chunks every time they are opened. Chunks are mapped memory instead of
+// S3Alloc(), which lives as long as the query. A released chunk is kept while the pool holds no
+// more than capacity bytes, and is unmapped once it has been idle for idleTime seconds.
+class S3ChunkPool {
+   public:
+    S3ChunkPool();
+    ~S3ChunkPool();
+
+    // capacity 0 disables the pool, chunks kept so far are unmapped.
+    void configure(uint64_t capacity, uint64_t idleTime, bool hugePages);
+
+    bool isEnabled();
+
+    // Return NULL if the memory can't be mapped.
+    void* acquire(size_t size);
+    void release(void* p, size_t size);
+
+    // Unmap the chunks idle since before now - idleTime.
+    void trim(uint64_t now);
+
+    uint64_t getCachedBytes();
+
+   private:
+    struct IdleChunk {
+        void* p;
+        size_t size;
+        uint64_t releasedAt;
+    };
+
+    void unmap(void* p, size_t size);
+    void trimLocked(uint64_t now);
+
+    pthread_mutex_t mutex;
+
+    uint64_t capacity;
+    uint64_t idleTime;
+    bool hugePages;
+
+    vector<IdleChunk> idleChunks;  // the longest idle first
+    uint64_t cachedBytes;
+};
+
+S3ChunkPool& GetS3ChunkPool();
+
+// Chunks of the same size allocated once, Allocate() and Deallocate() are lock free, a chunk is
+// taken by setting its bit in the used mask.
 class PreAllocatedMemory {
    public:
-    PreAllocatedMemory(size_t chunkSize, size_t numOfChunk) {
+    PreAllocatedMemory(size_t chunkSize, size_t numOfChunk) : chunkSize(chunkSize), used(0) {
         maxSize = chunkSize * numOfChunk;
-        // we will have no more than 9 chunks, 8 for thread thunk, one for main buffer.
-        // Each chunk is limited to 128MB.
-        const uint64_t memoryLimit = 9 * 128 * 1024 * 1024;
+        // we will have no more than 10 chunks, 8 for thread thunk, one for main buffer, one for
+        // hedged fetch. Each chunk is limited to 128MB.
+        const uint64_t memoryLimit = 10 * 128 * 1024 * 1024;
         S3_CHECK_OR_DIE(maxSize <= memoryLimit, S3MemoryOverLimit, memoryLimit, maxSize);
+        S3_CHECK_OR_DIE(numOfChunk <= 64, S3RuntimeError, "Too many preallocated chunks");
+
+        pooled = GetS3ChunkPool().isEnabled();
 
-        used.resize(numOfChunk);
         chunks.resize(numOfChunk);
         for (size_t i = 0; i < numOfChunk; i++) {
-            chunks[i] = S3Alloc(chunkSize);
+            chunks[i] = allocChunk();
             if (chunks[i] == NULL) {
                 for (size_t j = 0; j < i; j++) {
-                    S3Free(chunks[j]);
+                    freeChunk(chunks[j]);
                 }
                 S3_DIE(S3AllocationError, chunkSize);
             }
-            used[i] = false;
         }
-
-        pthread_mutex_init(&memLock, NULL);
     }
 
     ~PreAllocatedMemory() {
         for (size_t i = 0; i < chunks.size(); i++) {
             if (chunks[i]) {
-                S3Free(chunks[i]);
+                freeChunk(chunks[i]);
                 chunks[i] = NULL;
             }
         }
-
-        pthread_mutex_destroy(&memLock);
     }
 
     size_t MaxSize() const {
@@ -49,22 +95,26 @@ class PreAllocatedMemory {
     }
 
     void* Allocate() {
-        UniqueLock lock(&memLock);
-        for (size_t i = 0; i < used.size(); i++) {
-            if (!used[i]) {
-                used[i] = true;
-                return chunks[i];
+        uint64_t all = (chunks.size() == 64) ? ~(uint64_t)0 : ((uint64_t)1 << chunks.size()) - 1;
+
+        uint64_t mask = used.load(std::memory_order_relaxed);
+        while (true) {
+            uint64_t freeMask = ~mask & all;
+            S3_CHECK_OR_DIE(freeMask != 0, S3RuntimeError,
+                            "Requested more than preallocated memory");
+
+            // lowest free chunk.
+            uint64_t bit = freeMask & (~freeMask + 1);
+            if (used.compare_exchange_weak(mask, mask | bit, std::memory_order_acquire)) {
+                return chunks[__builtin_ctzll(bit)];
             }
         }
-
-        S3_DIE(S3RuntimeError, "Requested more than preallocated memory");
     }
 
     void Deallocate(void* p) {
-        UniqueLock lock(&memLock);
-        for (size_t i = 0; i < used.size(); i++) {
+        for (size_t i = 0; i < chunks.size(); i++) {
             if (chunks[i] == p) {
-                used[i] = false;
+                used.fetch_and(~((uint64_t)1 << i), std::memory_order_release);
                 return;
             }
         }
@@ -77,10 +127,23 @@ class PreAllocatedMemory {
     PreAllocatedMemory(const PreAllocatedMemory&);
     PreAllocatedMemory& operator=(const PreAllocatedMemory&);
 
+    void* allocChunk() {
+        return pooled ? GetS3ChunkPool().acquire(chunkSize) : S3Alloc(chunkSize);
+    }
+
+    void freeChunk(void* p) {
+        if (pooled) {
+            GetS3ChunkPool().release(p, chunkSize);
+        } else {
+            S3Free(p);
+        }
+    }
+
     size_t maxSize;
-    vector<bool> used;
+    size_t chunkSize;
+    bool pooled;  // chunks are from S3ChunkPool, otherwise from S3Alloc()
+    std::atomic<uint64_t> used;  // bit i is set if chunks[i] is allocated
     vector<void*> chunks;
-    pthread_mutex_t memLock;
 };
 
 template <class T>
@@ -101,6 +164,9 @@ struct PGAllocator {
     typedef const T& const_reference;
     typedef T value_type;
 
+    // buffers of different contexts can be swapped, each keeps the allocator of its memory.
+    typedef std::true_type propagate_on_container_swap;
+
     size_type max_size() const {
         if (prealloc) {
             return prealloc->MaxSize();
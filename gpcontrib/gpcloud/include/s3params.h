@@ -7,21 +7,101 @@
 
 enum S3SSEType { SSE_NONE, SSE_S3 };
 
+enum S3ExportFormat { S3_EXPORT_TEXT, S3_EXPORT_PARQUET };
+
+// Types of table columns, those not listed are kept as text.
+enum S3ColumnType {
+    S3_COLUMN_TEXT,
+    S3_COLUMN_BOOL,
+    S3_COLUMN_INT32,
+    S3_COLUMN_INT64,
+    S3_COLUMN_DOUBLE,
+};
+
+enum S3QualOp { S3_QUAL_EQ, S3_QUAL_LT, S3_QUAL_LE, S3_QUAL_GT, S3_QUAL_GE };
+
+// "column op value" in the WHERE clause of the external scan, value is in text format.
+struct S3ScanQual {
+    S3ScanQual() : column(0), op(S3_QUAL_EQ), numeric(false) {
+    }
+
+    uint64_t column;  // index in S3ScanDesc::columns
+    S3QualOp op;
+    string value;
+    bool numeric;  // compared as numbers, otherwise as strings
+};
+
+// What the external scan needs from the table, used by readers and writers of columnar files.
+struct S3ScanDesc {
+    S3ScanDesc()
+        : csv(false),
+          delimiter('\t'),
+          nullString("\\N"),
+          escape('\\'),
+          quote('"'),
+          sampleFraction(1.0) {
+    }
+
+    vector<string> columns;      // names of table columns, empty if unknown
+    vector<S3ColumnType> types;  // types of columns, empty if unknown
+    vector<bool> projected;      // whether columns[i] is referenced by the scan
+    vector<S3ScanQual> quals;    // ANDed together
+
+    // Format of lines, same as the FORMAT clause of the table.
+    bool csv;
+    char delimiter;
+    string nullString;
+    char escape;  // '\0' if escaping is off
+    char quote;   // CSV only
+
+    // Fraction of the data the scan needs, e.g. for ANALYZE. Readers may read only about this
+    // much of it, in whole key ranges.
+    double sampleFraction;
+};
+
+// Limit of S3Params::getPrefetchKeys(), memory of readers grows with it.
+#define S3_PREFETCH_KEYS_MAX 2
+
 class S3Params {
    public:
     S3Params(const string& sourceUrl = "", bool useHttps = true, const string& version = "",
              const string& region = "")
         : s3Url(sourceUrl, useHttps, version, region),
           keySize(0),
+          keyRangeStart(0),
+          keyRangeEnd(0),
+          rawKeyRange(false),
           chunkSize(0),
           numOfChunks(0),
           lowSpeedLimit(0),
           lowSpeedTime(0),
           proxy(""),
+          listCacheTTL(0),
+          listParallelism(0),
+          readCacheSize(0),
+          retryBackoff(0),
+          requestRate(0),
+          rolloverSize(0),
+          prefetchKeys(0),
+          smallKeySize(0),
+          memoryPoolSize(0),
+          memoryPoolIdleTime(0),
+          rowGroupSize(0),
+          rangeCoalesceGap(0),
           debugCurl(false),
           autoCompress(false),
           verifyCert(false),
+          adaptiveDownload(false),
+          multiplexIO(false),
+          hedgedFetch(false),
+          s3Select(false),
+          conditionalWrite(false),
+          memoryPoolHugePages(false),
+          splitCompressed(false),
+          splitCsv(false),
+          crc32cChecksum(false),
           sseType(SSE_NONE),
+          exportFormat(S3_EXPORT_TEXT),
           gpcheckcloud_newline("") {
     }
 
@@ -72,6 +152,36 @@ class S3Params {
         this->keySize = size;
     }
 
+    const string& getKeyETag() const {
+        return keyETag;
+    }
+
+    void setKeyETag(const string& etag) {
+        this->keyETag = etag;
+    }
+
+    uint64_t getKeyRangeStart() const {
+        return keyRangeStart;
+    }
+
+    uint64_t getKeyRangeEnd() const {
+        return keyRangeEnd;
+    }
+
+    void setKeyRange(uint64_t start, uint64_t end) {
+        this->keyRangeStart = start;
+        this->keyRangeEnd = end;
+    }
+
+    // A raw range is read byte for byte from keyRangeStart to keyRangeEnd, e.g. compressed members.
+    bool isRawKeyRange() const {
+        return rawKeyRange;
+    }
+
+    void setRawKeyRange(bool rawKeyRange) {
+        this->rawKeyRange = rawKeyRange;
+    }
+
     uint64_t getLowSpeedLimit() const {
         return lowSpeedLimit;
     }
@@ -88,6 +198,78 @@ class S3Params {
         this->lowSpeedTime = lowSpeedTime;
     }
 
+    const string& getListCacheDir() const {
+        return listCacheDir;
+    }
+
+    void setListCacheDir(const string& listCacheDir) {
+        this->listCacheDir = listCacheDir;
+    }
+
+    uint64_t getListCacheTTL() const {
+        return listCacheTTL;
+    }
+
+    void setListCacheTTL(uint64_t listCacheTTL) {
+        this->listCacheTTL = listCacheTTL;
+    }
+
+    uint64_t getListParallelism() const {
+        return listParallelism;
+    }
+
+    void setListParallelism(uint64_t listParallelism) {
+        this->listParallelism = listParallelism;
+    }
+
+    const string& getListShardPrefixes() const {
+        return listShardPrefixes;
+    }
+
+    void setListShardPrefixes(const string& listShardPrefixes) {
+        this->listShardPrefixes = listShardPrefixes;
+    }
+
+    const string& getInventoryManifest() const {
+        return inventoryManifest;
+    }
+
+    void setInventoryManifest(const string& inventoryManifest) {
+        this->inventoryManifest = inventoryManifest;
+    }
+
+    const string& getInventoryModifiedAfter() const {
+        return inventoryModifiedAfter;
+    }
+
+    void setInventoryModifiedAfter(const string& inventoryModifiedAfter) {
+        this->inventoryModifiedAfter = inventoryModifiedAfter;
+    }
+
+    const string& getInventoryModifiedBefore() const {
+        return inventoryModifiedBefore;
+    }
+
+    void setInventoryModifiedBefore(const string& inventoryModifiedBefore) {
+        this->inventoryModifiedBefore = inventoryModifiedBefore;
+    }
+
+    const string& getReadCacheDir() const {
+        return readCacheDir;
+    }
+
+    void setReadCacheDir(const string& readCacheDir) {
+        this->readCacheDir = readCacheDir;
+    }
+
+    uint64_t getReadCacheSize() const {
+        return readCacheSize;
+    }
+
+    void setReadCacheSize(uint64_t readCacheSize) {
+        this->readCacheSize = readCacheSize;
+    }
+
     bool isDebugCurl() const {
         return debugCurl;
     }
@@ -111,6 +293,166 @@ class S3Params {
         this->autoCompress = autoCompress;
     }
 
+    bool isAdaptiveDownload() const {
+        return adaptiveDownload;
+    }
+
+    void setAdaptiveDownload(bool adaptiveDownload) {
+        this->adaptiveDownload = adaptiveDownload;
+    }
+
+    bool isMultiplexIO() const {
+        return multiplexIO;
+    }
+
+    void setMultiplexIO(bool multiplexIO) {
+        this->multiplexIO = multiplexIO;
+    }
+
+    uint64_t getRetryBackoff() const {
+        return retryBackoff;
+    }
+
+    void setRetryBackoff(uint64_t retryBackoff) {
+        this->retryBackoff = retryBackoff;
+    }
+
+    uint64_t getRequestRate() const {
+        return requestRate;
+    }
+
+    void setRequestRate(uint64_t requestRate) {
+        this->requestRate = requestRate;
+    }
+
+    const string& getRequestRateDir() const {
+        return requestRateDir;
+    }
+
+    void setRequestRateDir(const string& requestRateDir) {
+        this->requestRateDir = requestRateDir;
+    }
+
+    uint64_t getRolloverSize() const {
+        return rolloverSize;
+    }
+
+    void setRolloverSize(uint64_t rolloverSize) {
+        this->rolloverSize = rolloverSize;
+    }
+
+    uint64_t getPrefetchKeys() const {
+        return prefetchKeys;
+    }
+
+    void setPrefetchKeys(uint64_t prefetchKeys) {
+        this->prefetchKeys = prefetchKeys;
+    }
+
+    uint64_t getSmallKeySize() const {
+        return smallKeySize;
+    }
+
+    void setSmallKeySize(uint64_t smallKeySize) {
+        this->smallKeySize = smallKeySize;
+    }
+
+    uint64_t getMemoryPoolSize() const {
+        return memoryPoolSize;
+    }
+
+    void setMemoryPoolSize(uint64_t memoryPoolSize) {
+        this->memoryPoolSize = memoryPoolSize;
+    }
+
+    uint64_t getMemoryPoolIdleTime() const {
+        return memoryPoolIdleTime;
+    }
+
+    void setMemoryPoolIdleTime(uint64_t memoryPoolIdleTime) {
+        this->memoryPoolIdleTime = memoryPoolIdleTime;
+    }
+
+    uint64_t getRowGroupSize() const {
+        return rowGroupSize;
+    }
+
+    void setRowGroupSize(uint64_t rowGroupSize) {
+        this->rowGroupSize = rowGroupSize;
+    }
+
+    uint64_t getRangeCoalesceGap() const {
+        return rangeCoalesceGap;
+    }
+
+    void setRangeCoalesceGap(uint64_t rangeCoalesceGap) {
+        this->rangeCoalesceGap = rangeCoalesceGap;
+    }
+
+    bool isHedgedFetch() const {
+        return hedgedFetch;
+    }
+
+    void setHedgedFetch(bool hedgedFetch) {
+        this->hedgedFetch = hedgedFetch;
+    }
+
+    bool isS3Select() const {
+        return s3Select;
+    }
+
+    void setS3Select(bool s3Select) {
+        this->s3Select = s3Select;
+    }
+
+    bool isConditionalWrite() const {
+        return conditionalWrite;
+    }
+
+    void setConditionalWrite(bool conditionalWrite) {
+        this->conditionalWrite = conditionalWrite;
+    }
+
+    bool isMemoryPoolHugePages() const {
+        return memoryPoolHugePages;
+    }
+
+    void setMemoryPoolHugePages(bool memoryPoolHugePages) {
+        this->memoryPoolHugePages = memoryPoolHugePages;
+    }
+
+    bool isSplitCompressed() const {
+        return splitCompressed;
+    }
+
+    void setSplitCompressed(bool splitCompressed) {
+        this->splitCompressed = splitCompressed;
+    }
+
+    bool isSplitCsv() const {
+        return splitCsv;
+    }
+
+    void setSplitCsv(bool splitCsv) {
+        this->splitCsv = splitCsv;
+    }
+
+    bool isCrc32cChecksum() const {
+        return crc32cChecksum;
+    }
+
+    void setCrc32cChecksum(bool crc32cChecksum) {
+        this->crc32cChecksum = crc32cChecksum;
+    }
+
+    const S3ScanDesc& getScanDesc() const {
+        return scanDesc;
+    }
+
+    void setScanDesc(const S3ScanDesc& scanDesc) {
+        this->scanDesc = scanDesc;
+    }
+
     const S3MemoryContext& getMemoryContext() const {
         return memoryContext;
     }
@@ -131,6 +473,22 @@ class S3Params {
         this->sseType = sseType;
     }
 
+    S3ExportFormat getExportFormat() const {
+        return exportFormat;
+    }
+
+    void setExportFormat(S3ExportFormat exportFormat) {
+        this->exportFormat = exportFormat;
+    }
+
+    const string& getParquetCodec() const {
+        return parquetCodec;
+    }
+
+    void setParquetCodec(const string& parquetCodec) {
+        this->parquetCodec = parquetCodec;
+    }
+
     const string& getProxy() const {
         return proxy;
     }
@@ -151,6 +509,13 @@ class S3Params {
     S3Url s3Url;  // original url to read/write.
 
     uint64_t keySize;  // key/file size.
+    string keyETag;    // ETag of the key from the bucket list, empty if unknown.
+
+    // [keyRangeStart, keyRangeEnd) is the part of the key to read, lines starting inside it
+    // belong to this reader. keyRangeEnd == 0 means to read the whole key.
+    uint64_t keyRangeStart;
+    uint64_t keyRangeEnd;
+    bool rawKeyRange;  // whether the range is read as it is, instead of the lines starting in it
 
     S3Credential cred;  // S3 credential.
 
@@ -162,13 +527,53 @@ class S3Params {
 
     string proxy;  // proxy
 
+    string listCacheDir;    // directory to share the bucket list between segments, empty to disable
+    uint64_t listCacheTTL;  // seconds a shared bucket list stays valid
+
+    uint64_t listParallelism;  // parts of the key space listed at once, 1 to list sequentially
+    string listShardPrefixes;  // comma separated keys the parts start at, empty to find them
+
+    string inventoryManifest;        // manifest.json of an S3 Inventory to list keys from, or empty
+    string inventoryModifiedAfter;   // keys of the inventory modified at or after it, or empty
+    string inventoryModifiedBefore;  // keys of the inventory modified before it, or empty
+
+    string readCacheDir;     // directory to cache downloaded data, empty to disable
+    uint64_t readCacheSize;  // bytes the read cache may use
+
+    uint64_t retryBackoff;  // milliseconds, base of the delay before retrying a request, 0 to disable
+
+    uint64_t requestRate;   // requests per second the cluster may send to a bucket, 0 to disable
+    string requestRateDir;  // directory of the files sharing the request rate between segments
+
+    uint64_t rolloverSize;  // bytes after which a writer starts a new key, 0 to write a single key
+    uint64_t prefetchKeys;  // keys opened ahead of the one being read
+    uint64_t smallKeySize;  // keys up to this size are fetched with a single GET, 0 to disable
+    uint64_t memoryPoolSize;      // bytes of chunks kept by the backend between queries, 0 to disable
+    uint64_t memoryPoolIdleTime;  // seconds a kept chunk may stay unused before it is unmapped
+    uint64_t rowGroupSize;  // bytes of values buffered by a Parquet writer before a row group
+    uint64_t rangeCoalesceGap;  // bytes between ranges of a Parquet key read by one GET
+
     bool debugCurl;     // debug curl or not
     bool autoCompress;  // whether to compress data before uploading
     bool verifyCert;  // This option determines whether curl verifies the authenticity of the peer's
                       // certificate.
+    bool adaptiveDownload;  // whether to size chunks and in-flight requests per key
+    bool multiplexIO;       // whether requests are run by one I/O thread instead of one per chunk
+    bool hedgedFetch;       // whether a slow ranged GET is raced by a duplicate one
+    bool s3Select;          // whether CSV keys are filtered by S3 Select before downloading
+    bool conditionalWrite;  // whether uploads fail instead of overwriting an existing key
+    bool memoryPoolHugePages;  // whether kept chunks are backed by transparent huge pages
+    bool splitCompressed;  // whether BGZF and seekable zstd keys are split into ranges by members
+    bool splitCsv;         // whether CSV keys are split into ranges, no quoted field has a newline
+    bool crc32cChecksum;   // whether uploaded parts and whole keys read are checked with CRC32C
 
     S3SSEType sseType;
 
+    S3ExportFormat exportFormat;  // of keys written by writable tables
+    string parquetCodec;          // compression of Parquet pages, "none", "gzip" or "zstd"
+
+    S3ScanDesc scanDesc;
+
     S3MemoryContext memoryContext;
 
     string gpcheckcloud_newline;  // newline LF, CRLF, CR
@@ -177,8 +582,14 @@ class S3Params {
 inline void PrepareS3MemContext(const S3Params& params) {
     S3MemoryContext& memoryContext = const_cast<S3MemoryContext&>(params.getMemoryContext());
 
-    // We need one more chunk of memory for writer to prepare data to upload.
-    memoryContext.prepare(params.getChunkSize(), params.getNumOfChunks() + 1);
+    // We need one more chunk of memory for writer to prepare data to upload, and another one for
+    // the duplicate of a hedged fetch. Each key opened ahead has chunks of its own.
+    uint64_t numOfChunks = params.getNumOfChunks() * (params.getPrefetchKeys() + 1) +
+                           (params.isHedgedFetch() ? 2 : 1);
+
+    GetS3ChunkPool().configure(params.getMemoryPoolSize(), params.getMemoryPoolIdleTime(),
+                               params.isMemoryPoolHugePages());
+    memoryContext.prepare(params.getChunkSize(), numOfChunks);
 }
 
 #endif
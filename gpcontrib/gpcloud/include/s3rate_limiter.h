@@ -0,0 +1,80 @@
+#ifndef INCLUDE_S3RATE_LIMITER_H_
+#define INCLUDE_S3RATE_LIMITER_H_
+
+#include "s3common_headers.h"
+
+#define S3_RATE_LIMITER_MAGIC 0x67707274
+#define S3_RATE_LIMITER_MAX_SLOTS 64
+
+// After a throttled request the rate is halved, at most once per interval and down to the minimal
+// fraction of the configured rate. It grows back linearly once the interval passes without any.
+#define S3_RATE_DECREASE_INTERVAL_US (1000 * 1000)
+#define S3_RATE_MIN_FACTOR (1.0 / 64)
+#define S3_RATE_INCREASE_PER_SECOND 0.1
+
+// State of a rate limiter, in a file mapped by all the processes on a host using the same location.
+struct S3RateLimiterState {
+    uint32_t magic;
+    uint32_t numOfSegments;  // distinct segments attached
+
+    int32_t segIds[S3_RATE_LIMITER_MAX_SLOTS];
+    int32_t pids[S3_RATE_LIMITER_MAX_SLOTS];  // 0 if the slot is free
+
+    double tokens;  // requests that can be sent at once, negative if reserved ahead
+    double factor;  // fraction of the configured rate after throttled requests, (0, 1]
+    uint64_t updatedUs;
+    uint64_t throttledUs;
+};
+
+// Token bucket for requests to a location, shared by the segments of a host. The cluster may send
+// rate requests per second to the location, each segment gets rate / segNum of it, and a host's
+// bucket is filled with the shares of the segments attached to it, so that the busy segments of a
+// host use what the idle ones leave. Throttled requests (503 Slow Down) lower the rate of the host.
+//
+// Times are of GetCurrentTimeUs(), which is the same for all processes on a host.
+class S3RateLimiter {
+   public:
+    S3RateLimiter();
+    ~S3RateLimiter();
+
+    // Attach to the state in the file at path, or to a state of this object if path is empty or
+    // the file can't be used. rate 0 disables the limiter.
+    void setup(const string &path, uint64_t rate, int32_t segId, uint64_t segNum, uint64_t nowUs);
+
+    bool isEnabled() const {
+        return this->rate > 0;
+    }
+
+    // Take a token for a request, return the time in microseconds to wait before sending it.
+    uint64_t reserve(uint64_t nowUs);
+
+    // Give back the token of a request that is not sent.
+    void unreserve();
+
+    // A request was throttled by the server.
+    void throttled(uint64_t nowUs);
+
+    // Current requests per second of this host.
+    double getHostRate(uint64_t nowUs);
+
+   private:
+    void attach(uint64_t nowUs);
+    void detach();
+    void refill(uint64_t nowUs);
+    double hostRateLocked();
+
+    void lock();
+    void unlock();
+
+    pthread_mutex_t mutex;  // between threads, the file lock is between processes
+    int fd;
+    S3RateLimiterState *state;
+    S3RateLimiterState localState;
+
+    uint64_t rate;
+    uint64_t segNum;
+    int32_t segId;
+    int slot;  // of this object in state, -1 if it has none
+};
+
+#endif /* INCLUDE_S3RATE_LIMITER_H_ */
@@ -0,0 +1,50 @@
+#ifndef INCLUDE_S3READ_CACHE_H_
+#define INCLUDE_S3READ_CACHE_H_
+
+#include "s3common_headers.h"
+#include "s3log.h"
+#include "s3memory_mgmt.h"
+#include "s3url.h"
+
+// All files of the read cache start with it, other files in the directory are left alone.
+#define S3_READ_CACHE_PREFIX "gpcloud_data_"
+
+// Downloaded ranges of keys saved in a local directory, shared by all processes using the same
+// directory. An entry is named by the hash of the key URL, its ETag and the range, so a key that
+// is overwritten never hits the entries of its old content. Least recently used entries are
+// removed when the directory grows beyond the capacity. Errors of the cache are logged and taken
+// as misses, they never fail the query.
+class S3ReadCache {
+   public:
+    S3ReadCache() : capacity(0) {
+    }
+
+    // An empty dir disables the cache.
+    void setup(const string& dir, uint64_t capacity) {
+        this->dir = dir;
+        this->capacity = capacity;
+    }
+
+    bool isEnabled() const {
+        return !dir.empty();
+    }
+
+    // Load [offset, offset + len) of the key into data, return false if it is not cached.
+    bool load(const S3Url& s3Url, const string& etag, uint64_t offset, uint64_t len,
+              S3VectorUInt8& data);
+
+    // Save data downloaded from offset of the key, then evict entries if the cache is full.
+    void save(const S3Url& s3Url, const string& etag, uint64_t offset, const S3VectorUInt8& data);
+
+    // Remove least recently used entries until the cache is no larger than the capacity.
+    void evict();
+
+    string getEntryPath(const S3Url& s3Url, const string& etag, uint64_t offset,
+                        uint64_t len) const;
+
+   private:
+    string dir;
+    uint64_t capacity;
+};
+
+#endif /* INCLUDE_S3READ_CACHE_H_ */
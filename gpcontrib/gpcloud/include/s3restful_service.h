@@ -10,6 +10,113 @@
 #include "s3macros.h"
 #include "s3params.h"
 
+// CURLHandlePool keeps finished curl easy handles, so that later requests reuse their live
+// connections instead of paying a fresh TCP and TLS handshake every time. All handles of the
+// pool also share one DNS, TLS session and connection cache through the curl share interface.
+//
+// It is thread safe, downloading and uploading threads acquire and release handles concurrently.
+class CURLHandlePool {
+   public:
+    CURLHandlePool();
+    ~CURLHandlePool();
+
+    // Return an idle handle, or a newly created one if there is no idle handle.
+    CURL* acquire();
+
+    // Give the handle back. Handles whose transfer failed are not reusable and get destroyed,
+    // the connection they hold might be in an unknown state.
+    void release(CURL* curl, bool reusable);
+
+    // Destroy all idle handles and the share object, must be called before curl_global_cleanup().
+    void clear();
+
+    uint64_t getIdleCount();
+
+   private:
+    CURLHandlePool(const CURLHandlePool&);
+    CURLHandlePool& operator=(const CURLHandlePool&);
+
+    static void lockShareData(CURL* curl, curl_lock_data data, curl_lock_access access,
+                              void* userp);
+    static void unlockShareData(CURL* curl, curl_lock_data data, void* userp);
+
+    void initShare();
+
+    CURLSH* share;
+    pthread_mutex_t shareLocks[CURL_LOCK_DATA_LAST];
+
+    pthread_mutex_t poolLock;
+    vector<CURL*> idleHandles;
+};
+
+// A transfer run by CURLMultiDriver.
+class CURLTransfer {
+   public:
+    virtual ~CURLTransfer() {
+    }
+
+    virtual CURL* getHandle() = 0;
+
+    // The transfer is delayed until this time of GetCurrentTimeUs(), 0 to start it at once.
+    virtual uint64_t getStartTimeUs() {
+        return 0;
+    }
+
+    // Called on the I/O thread with the result of the transfer, it is deleted right after.
+    virtual void finish(CURLcode result) = 0;
+};
+
+// CURLMultiDriver runs the transfers of many easy handles on a single I/O thread with the curl
+// multi interface, instead of blocking one thread per request in curl_easy_perform(). Transfers
+// to the same host are multiplexed as streams of one HTTP/2 connection if the server supports it.
+//
+// The I/O thread is started by the first submit(). submit() is thread safe and can be called by
+// finish() of another transfer, e.g. to retry a request.
+class CURLMultiDriver {
+   public:
+    CURLMultiDriver();
+    ~CURLMultiDriver();
+
+    // Take the ownership of transfer, it is deleted after finish().
+    void submit(CURLTransfer* transfer);
+
+    // Wait for all transfers to finish and stop the I/O thread.
+    void stop();
+
+    // Number of transfers submitted but not finished.
+    uint64_t getActiveCount();
+
+   private:
+    CURLMultiDriver(const CURLMultiDriver&);
+    CURLMultiDriver& operator=(const CURLMultiDriver&);
+
+    static void* IOThreadFunc(void* p);
+    void run();
+    void finishTransfers();
+    void complete(CURLTransfer* transfer, CURLcode result);
+
+    // Add transfers whose start time is reached to the multi handle, return the time until the
+    // next delayed one in microseconds, or 0 if there is none.
+    uint64_t startTransfers(vector<CURLTransfer*>& newTransfers);
+
+    CURLM* multi;
+    pthread_t thread;
+    bool started;
+    bool stopping;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    vector<CURLTransfer*> pendingTransfers;
+    uint64_t activeCount;
+
+    // only accessed by the I/O thread.
+    std::map<CURL*, CURLTransfer*> runningTransfers;
+    vector<CURLTransfer*> delayedTransfers;
+};
+
+struct CURLWrapper;
+class S3AsyncTransfer;
+
 class S3RESTfulService : public RESTfulService {
    public:
     S3RESTfulService();
@@ -27,6 +134,12 @@ class S3RESTfulService : public RESTfulService {
 
     Response deleteRequest(const string& url, HTTPHeaders& headers);
 
+    // Only supported with S3Params::isMultiplexIO(), the requests are run by the I/O thread.
+    bool getAsync(const string& url, HTTPHeaders& headers, RESTfulCallback* callback);
+
+    bool putAsync(const string& url, HTTPHeaders& headers, const S3VectorUInt8& data,
+                  RESTfulCallback* callback);
+
    private:
     uint64_t lowSpeedLimit;
     uint64_t lowSpeedTime;
@@ -35,11 +148,18 @@ class S3RESTfulService : public RESTfulService {
 
     bool debugCurl;
     bool verifyCert;
+    bool multiplexIO;
 
     uint64_t chunkBufferSize;
     S3MemoryContext s3MemContext;
 
-    void performCurl(CURL* curl, Response& response);
+    CURLHandlePool curlPool;
+    CURLMultiDriver multiDriver;
+
+    void performCurl(CURLWrapper& wrapper, Response& response);
+
+    S3AsyncTransfer* createTransfer(const string& url, HTTPHeaders& headers,
+                                    RESTfulCallback* callback, S3MemoryContext& context);
 };
 
 class S3MessageParser {
@@ -56,6 +176,9 @@ class S3MessageParser {
     }
     string parseS3Tag(const string& tag);
 
+    // Content of tag in the parent element under the root, "" if there is none.
+    string parseS3Tag(const string& parent, const string& tag);
+
    private:
     xmlParserCtxtPtr xmlptr;
     string message;
@@ -0,0 +1,80 @@
+#ifndef INCLUDE_S3SELECT_READER_H_
+#define INCLUDE_S3SELECT_READER_H_
+
+#include <cmath>
+
+#include "gpcommon.h"
+#include "reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+#include "s3params.h"
+
+// Whether S3 Select helps the scan, it needs a CSV table with quals or unreferenced columns.
+bool S3SelectCanPushDown(const S3ScanDesc &scanDesc);
+
+// SQL expression returning every column of the table, unreferenced ones as the NULL string, from
+// rows which may satisfy the quals.
+string BuildS3SelectExpression(const S3ScanDesc &scanDesc);
+
+// Body of SelectObjectContentRequest, records starting in [start, end) are selected. The whole key
+// is scanned if end is 0.
+string BuildS3SelectRequest(const S3ScanDesc &scanDesc, const string &expression, bool gzip,
+                            uint64_t start, uint64_t end);
+
+// Read a CSV key through S3 Select, only rows which may satisfy the quals are returned by S3, and
+// columns not referenced by the scan are replaced by the NULL string. Uncompressed keys are
+// selected chunk by chunk with scan ranges, gzip keys and keys with a header line are selected
+// in one request.
+class S3SelectReader : public Reader {
+   public:
+    S3SelectReader()
+        : s3Interface(NULL),
+          s3Url(""),
+          gzip(false),
+          chunkSize(0),
+          rangeEnd(0),
+          nextOffset(0),
+          outOffset(0) {
+    }
+    virtual ~S3SelectReader() {
+        this->close();
+    }
+
+    virtual void open(const S3Params &params);
+
+    // read() attempts to read up to count bytes into the buffer.
+    // Return 0 if EOF. Throw exception if encounters errors.
+    virtual uint64_t read(char *buf, uint64_t count);
+
+    virtual uint64_t readView(const char **data, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    void setS3InterfaceService(S3Interface *s3) {
+        this->s3Interface = s3;
+    }
+
+    void setCompressionType(S3CompressionType type) {
+        this->gzip = (type == S3_COMPRESSION_GZIP);
+    }
+
+   private:
+    void fillOutput();
+
+    S3Interface *s3Interface;
+    S3Url s3Url;
+    S3ScanDesc scanDesc;
+    string expression;
+    bool gzip;
+
+    uint64_t chunkSize;  // bytes of the key scanned by each request, 0 to scan the whole range
+    uint64_t rangeEnd;
+    uint64_t nextOffset;  // start of the next scan range
+
+    S3VectorUInt8 out;
+    uint64_t outOffset;
+};
+
+#endif /* INCLUDE_S3SELECT_READER_H_ */
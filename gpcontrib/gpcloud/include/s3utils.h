@@ -73,6 +73,10 @@ string UriDecode(const string& src);
 
 void FindAndReplace(string& str, const string& find, const string& replace);
 
+// Derive the SigV4 signing key of date (YYYYMMDD) and region, keys are cached for the day.
+void GetSigningKeyV4(const string& secret, const string& date, const string& region,
+                     unsigned char key[SHA256_DIGEST_LENGTH]);
+
 void SignRequestV4(const string& method, HTTPHeaders* headers, const string& origRegion,
                    const string& path, const string& query, const S3Credential& cred);
 
@@ -80,4 +84,59 @@ string GetOptS3(const string& options, const string& key);
 
 string TruncateOptions(const string& url_with_options);
 
+// Monotonic time in microseconds.
+uint64_t GetCurrentTimeUs();
+
+// pthread_cond_timedwait() for at most timeoutUs microseconds, the mutex must be locked.
+void CondTimedWaitUs(pthread_cond_t* cond, pthread_mutex_t* mutex, uint64_t timeoutUs);
+
+// Delay before the retry following the attempt-th failure (counted from 1): a random time in
+// [0, min(baseUs * 2^(attempt - 1), maxUs)], so that clients throttled at the same time don't
+// come back at the same time.
+uint64_t GetBackoffWithJitterUs(uint64_t baseUs, uint64_t maxUs, uint64_t attempt);
+
+// Return index of the first byte in buf[0, len) equal to a, b or c, or len if there is none.
+// It's vectorized with AVX2 (if the CPU supports it) or SSE2 on x86-64, and NEON on ARM.
+uint64_t FindAnyOf(const char* buf, uint64_t len, char a, char b, char c);
+
+// CRC32C (Castagnoli) of data[0, len) continued from crc, which is 0 for a new checksum. It uses
+// the crc32 instruction of SSE4.2 (if the CPU has it) on x86-64, and of the CRC extension on ARMv8
+// if it's enabled for the build.
+uint32_t Crc32c(uint32_t crc, const void* data, uint64_t len);
+
+// CRC32C of the data of crcA followed by lenB bytes of data of crcB.
+uint32_t Crc32cCombine(uint32_t crcA, uint32_t crcB, uint64_t lenB);
+
+// The base64 encoding of a CRC32C in big-endian, as in x-amz-checksum-crc32c.
+string Crc32cToBase64(uint32_t crc);
+
+// Return false if str is not a base64 encoded CRC32C.
+bool Crc32cFromBase64(const string& str, uint32_t* crc);
+
+// Scanner of line terminators in CSV/TEXT data, its state is kept across buffers, so a terminator
+// or a quoted field might span two buffers. If quote is not '\0', terminators in quoted fields
+// are not taken as line ends, escape (the quote by default) escapes a char in quoted fields.
+class EolScanner {
+   public:
+    EolScanner(const char* eol = "\n", char quote = '\0', char escape = '\0');
+
+    void reset() {
+        this->matched = 0;
+        this->inQuote = false;
+        this->escaped = false;
+    }
+
+    // Return index next to the first terminator found in buf[from, len), or uint64_t(-1).
+    uint64_t find(const char* buf, uint64_t len, uint64_t from = 0);
+
+   private:
+    string eol;
+    char quote;
+    char escape;
+
+    uint64_t matched;  // number of matched terminator chars
+    bool inQuote;
+    bool escaped;
+};
+
 #endif  // __S3_UTILS_H__
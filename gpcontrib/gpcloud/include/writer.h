@@ -2,6 +2,8 @@
 #define __S3_WRITER_H__
 
 #include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3macros.h"
 #include "s3params.h"
 
 class Writer {
@@ -18,6 +20,11 @@ class Writer {
 
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close() = 0;
+
+    // Finish the key written so far and continue writing to a new key at url.
+    virtual void rollover(const S3Url &url) {
+        S3_DIE(S3RuntimeError, "Writer doesn't support writing more than one key");
+    }
 };
 
 #endif
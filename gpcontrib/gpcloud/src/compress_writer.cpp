@@ -2,7 +2,146 @@
 
 uint64_t S3_ZIP_COMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
-CompressWriter::CompressWriter() : writer(NULL), isClosed(true) {
+// Empty BGZF block marks the end of file.
+static const unsigned char BGZFEOFBlock[] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C',
+                                             2, 0, 0x1b, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static void setLittleEndian16(char *data, uint16_t value) {
+    unsigned char *p = (unsigned char *)data;
+    p[0] = value & 0xff;
+    p[1] = value >> 8;
+}
+
+static void setLittleEndian32(char *data, uint32_t value) {
+    unsigned char *p = (unsigned char *)data;
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = value >> 24;
+}
+
+#ifdef USE_ISAL
+// igzip level 1 deflates several times faster than zlib, and still compresses about as well as
+// zlib's fast levels.
+#define S3_ISAL_DEFLATE_LEVEL 1
+
+BGZFTaskStatus DeflateBGZFTask(BGZFTask &task) {
+    struct isal_zstream stream;
+    vector<uint8_t> levelBuf(ISAL_DEF_LVL1_DEFAULT);
+
+    task.output.clear();
+
+    BGZFTaskStatus status = BGZFTaskDone;
+
+    uint64_t inPos = 0;
+    while ((status == BGZFTaskDone) && (inPos < task.input.size())) {
+        const char *data = task.input.data() + inPos;
+        uint64_t len = std::min(task.input.size() - inPos, (uint64_t)S3_BGZF_MAX_INPUT_SIZE);
+
+        uint64_t outPos = task.output.size();
+        task.output.resize(outPos + S3_BGZF_MAX_BLOCK_SIZE);
+        char *block = task.output.data() + outPos;
+
+        // raw deflate, gzip header and trailer are made here to carry the 'BC' subfield.
+        isal_deflate_stateless_init(&stream);
+        stream.level = S3_ISAL_DEFLATE_LEVEL;
+        stream.level_buf = levelBuf.data();
+        stream.level_buf_size = levelBuf.size();
+        stream.gzip_flag = IGZIP_DEFLATE;
+        stream.end_of_stream = 1;
+        stream.flush = NO_FLUSH;
+        stream.next_in = (uint8_t *)data;
+        stream.avail_in = len;
+        stream.next_out = (uint8_t *)block + S3_BGZF_HEADER_LEN;
+        stream.avail_out = S3_BGZF_MAX_BLOCK_SIZE - S3_BGZF_HEADER_LEN - 8;
+
+        // incompressible input is written as stored blocks, which always fit.
+        int ret = isal_deflate_stateless(&stream);
+        if (ret != COMP_OK) {
+            task.error = string("Failed to compress data: ") + std::to_string((long long)ret);
+            status = BGZFTaskFailed;
+            break;
+        }
+
+        uint64_t blockSize = S3_BGZF_MAX_BLOCK_SIZE - stream.avail_out;
+
+        // ID1 ID2 CM FLG(FEXTRA) MTIME(4) XFL OS XLEN(6) 'B' 'C' SLEN(2) BSIZE(2)
+        memcpy(block, BGZFEOFBlock, S3_BGZF_HEADER_LEN);
+        setLittleEndian16(block + 16, blockSize - 1);
+
+        // CRC32 ISIZE
+        setLittleEndian32(block + blockSize - 8,
+                          crc32_gzip_refl(0, (const unsigned char *)data, len));
+        setLittleEndian32(block + blockSize - 4, len);
+
+        task.output.resize(outPos + blockSize);
+        inPos += len;
+    }
+
+    return status;
+}
+#else
+BGZFTaskStatus DeflateBGZFTask(BGZFTask &task) {
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+
+    task.output.clear();
+
+    // raw deflate, gzip header and trailer are made here to carry the 'BC' subfield.
+    if (deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        task.error = "failed to initialize zlib library";
+        return BGZFTaskFailed;
+    }
+
+    BGZFTaskStatus status = BGZFTaskDone;
+
+    uint64_t inPos = 0;
+    while ((status == BGZFTaskDone) && (inPos < task.input.size())) {
+        const char *data = task.input.data() + inPos;
+        uint64_t len = std::min(task.input.size() - inPos, (uint64_t)S3_BGZF_MAX_INPUT_SIZE);
+
+        uint64_t outPos = task.output.size();
+        task.output.resize(outPos + S3_BGZF_MAX_BLOCK_SIZE);
+        char *block = task.output.data() + outPos;
+
+        deflateReset(&zstream);
+        zstream.next_in = (Byte *)data;
+        zstream.avail_in = len;
+        zstream.next_out = (Byte *)block + S3_BGZF_HEADER_LEN;
+        zstream.avail_out = S3_BGZF_MAX_BLOCK_SIZE - S3_BGZF_HEADER_LEN - 8;
+
+        int ret = deflate(&zstream, Z_FINISH);
+        if (ret != Z_STREAM_END) {
+            task.error = string("Failed to compress data: ") + std::to_string((long long)ret);
+            status = BGZFTaskFailed;
+            break;
+        }
+
+        uint64_t blockSize = S3_BGZF_MAX_BLOCK_SIZE - zstream.avail_out;
+
+        // ID1 ID2 CM FLG(FEXTRA) MTIME(4) XFL OS XLEN(6) 'B' 'C' SLEN(2) BSIZE(2)
+        memcpy(block, BGZFEOFBlock, S3_BGZF_HEADER_LEN);
+        setLittleEndian16(block + 16, blockSize - 1);
+
+        // CRC32 ISIZE
+        setLittleEndian32(block + blockSize - 8, crc32(0, (const Byte *)data, len));
+        setLittleEndian32(block + blockSize - 4, len);
+
+        task.output.resize(outPos + blockSize);
+        inPos += len;
+    }
+
+    deflateEnd(&zstream);
+
+    return status;
+}
+#endif
+
+CompressWriter::CompressWriter()
+    : writer(NULL), numOfThreads(1), fillIndex(0), flushIndex(0), isClosed(true) {
     this->out = new char[S3_ZIP_COMPRESS_CHUNKSIZE];
 }
 
@@ -15,6 +154,27 @@ CompressWriter::~CompressWriter() {
 }
 
 void CompressWriter::open(const S3Params& params) {
+    this->numOfThreads = std::max(params.getNumOfChunks(), (uint64_t)1);
+
+    if (this->numOfThreads > 1) {
+        S3DEBUG("Compress data into BGZF blocks with %" PRIu64 " threads", this->numOfThreads);
+
+        this->deflater.start(this->numOfThreads, DeflateBGZFTask);
+        this->fillIndex = 0;
+        this->flushIndex = 0;
+        this->isClosed = false;
+
+        this->writer->open(params);
+        return;
+    }
+
+    this->initStream();
+    this->isClosed = false;
+
+    this->writer->open(params);
+}
+
+void CompressWriter::initStream() {
     this->zstream.zalloc = Z_NULL;
     this->zstream.zfree = Z_NULL;
     this->zstream.opaque = Z_NULL;
@@ -23,8 +183,6 @@ void CompressWriter::open(const S3Params& params) {
     int ret = deflateInit2(&this->zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
                            S3_DEFLATE_WINDOWSBITS, 8, Z_DEFAULT_STRATEGY);
 
-    this->isClosed = false;
-
     // init them here to get ready for both writer() and close()
     this->zstream.next_in = NULL;
     this->zstream.avail_in = 0;
@@ -33,8 +191,6 @@ void CompressWriter::open(const S3Params& params) {
 
     S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError,
                     string("Failed to initialize zlib library: ") + this->zstream.msg);
-
-    this->writer->open(params);
 }
 
 uint64_t CompressWriter::writeOneChunk(const char* buf, uint64_t count) {
@@ -74,6 +230,10 @@ uint64_t CompressWriter::write(const char* buf, uint64_t count) {
         return 0;
     }
 
+    if (this->deflater.isStarted()) {
+        return this->writeParallel(buf, count);
+    }
+
     uint64_t writtenLen = 0;
 
     for (uint64_t i = 0; i < (count / S3_ZIP_COMPRESS_CHUNKSIZE); i++) {
@@ -92,6 +252,34 @@ void CompressWriter::close() {
         return;
     }
 
+    if (this->deflater.isStarted()) {
+        this->closeParallel();
+
+        this->writer->close();
+        this->isClosed = true;
+        return;
+    }
+
+    this->finishStream();
+
+    this->writer->close();
+    this->isClosed = true;
+}
+
+void CompressWriter::rollover(const S3Url& url) {
+    // every key is a gzip file on its own.
+    if (this->deflater.isStarted()) {
+        this->finishParallel();
+        this->writer->rollover(url);
+        return;
+    }
+
+    this->finishStream();
+    this->writer->rollover(url);
+    this->initStream();
+}
+
+void CompressWriter::finishStream() {
     int status;
     do {
         status = deflate(&this->zstream, Z_FINISH);
@@ -107,9 +295,6 @@ void CompressWriter::close() {
     }
 
     S3DEBUG("Compression finished: Z_STREAM_END.");
-
-    this->writer->close();
-    this->isClosed = true;
 }
 
 void CompressWriter::setWriter(Writer* writer) {
@@ -123,3 +308,74 @@ void CompressWriter::flush() {
         this->zstream.avail_out = S3_ZIP_COMPRESS_CHUNKSIZE;
     }
 }
+
+uint64_t CompressWriter::writeParallel(const char* buf, uint64_t count) {
+    vector<BGZFTask>& tasks = this->deflater.getTasks();
+
+    uint64_t writtenLen = 0;
+    while (writtenLen < count) {
+        vector<char>& input = tasks[this->fillIndex % tasks.size()].input;
+
+        uint64_t len = std::min(count - writtenLen, S3_ZIP_COMPRESS_CHUNKSIZE - input.size());
+        input.insert(input.end(), buf + writtenLen, buf + writtenLen + len);
+        writtenLen += len;
+
+        if (input.size() == S3_ZIP_COMPRESS_CHUNKSIZE) {
+            this->submitTask();
+        }
+    }
+
+    return writtenLen;
+}
+
+void CompressWriter::submitTask() {
+    vector<BGZFTask>& tasks = this->deflater.getTasks();
+
+    this->deflater.submit(this->fillIndex % tasks.size());
+    this->fillIndex++;
+
+    // the next task to fill is not written out yet.
+    if (this->fillIndex - this->flushIndex == tasks.size()) {
+        this->flushTask();
+    }
+}
+
+void CompressWriter::flushTask() {
+    vector<BGZFTask>& tasks = this->deflater.getTasks();
+    BGZFTask& task = tasks[this->flushIndex % tasks.size()];
+
+    this->deflater.wait(this->flushIndex % tasks.size());
+
+    S3_CHECK_OR_DIE(task.status != BGZFTaskFailed, S3RuntimeError, task.error);
+
+    if (!task.output.empty()) {
+        this->writer->write(task.output.data(), task.output.size());
+    }
+
+    task.input.clear();
+    task.output.clear();
+    task.status = BGZFTaskEmpty;
+    this->flushIndex++;
+}
+
+void CompressWriter::closeParallel() {
+    this->finishParallel();
+
+    this->deflater.stop();
+}
+
+void CompressWriter::finishParallel() {
+    vector<BGZFTask>& tasks = this->deflater.getTasks();
+
+    if (!tasks[this->fillIndex % tasks.size()].input.empty()) {
+        this->submitTask();
+    }
+
+    while (this->flushIndex < this->fillIndex) {
+        this->flushTask();
+    }
+
+    this->writer->write((const char*)BGZFEOFBlock, sizeof(BGZFEOFBlock));
+
+    S3DEBUG("Compression finished: %" PRIu64 " BGZF tasks.", this->fillIndex);
+}
@@ -1,51 +1,511 @@
 #include "decompress_reader.h"
 
+#include "s3iostats.h"
+#include "s3key_reader.h"
+
 uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
-DecompressReader::DecompressReader() : isClosed(true) {
+void ZlibDecompressor::init() {
+    // allocate inflate state for zlib
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    zstream.next_in = Z_NULL;
+    zstream.avail_in = 0;
+
+    this->memberEnded = false;
+    this->finished = false;
+
+    // with S3_INFLATE_WINDOWSBITS, it could recognize and decode both zlib and gzip stream.
+    int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
+    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+
+    this->initialized = true;
+}
+
+uint64_t ZlibDecompressor::decompress(const char **in, uint64_t *inLen, char *out,
+                                      uint64_t outLen) {
+    if (this->memberEnded && (*inLen > 0)) {
+        this->memberEnded = false;
+
+        if ((unsigned char)**in == 0x1f) {
+            S3DEBUG("Decompress next gzip member");
+            inflateReset(&this->zstream);
+        } else {
+            S3WARN("Ignore trailing data after the end of gzip stream");
+            this->finished = true;
+        }
+    }
+
+    if (this->finished) {
+        *in += *inLen;
+        *inLen = 0;
+        return 0;
+    }
+
+    this->zstream.next_in = (Byte *)*in;
+    this->zstream.avail_in = *inLen;
+    this->zstream.next_out = (Byte *)out;
+    this->zstream.avail_out = outLen;
+
+    int status = inflate(&this->zstream, Z_NO_FLUSH);
+    if (status == Z_STREAM_END) {
+        S3DEBUG("Decompression finished: Z_STREAM_END.");
+        this->memberEnded = true;
+    } else if (status < 0 || status == Z_NEED_DICT) {
+        S3_CHECK_OR_DIE(
+            false, S3RuntimeError,
+            string("Failed to decompress data: ") + std::to_string((unsigned long long)status));
+    }
+
+    *in = (const char *)this->zstream.next_in;
+    *inLen = this->zstream.avail_in;
+
+    return outLen - this->zstream.avail_out;
+}
+
+void ZlibDecompressor::end() {
+    if (this->initialized) {
+        inflateEnd(&this->zstream);
+        this->initialized = false;
+    }
+}
+
+#ifdef USE_ISAL
+void IsalDecompressor::init() {
+    isal_inflate_init(&this->state);
+
+    this->memberStarted = false;
+    this->memberEnded = false;
+    this->finished = false;
+}
+
+uint64_t IsalDecompressor::decompress(const char **in, uint64_t *inLen, char *out,
+                                      uint64_t outLen) {
+    if (this->memberEnded && (*inLen > 0)) {
+        this->memberEnded = false;
+
+        if ((unsigned char)**in == 0x1f) {
+            S3DEBUG("Decompress next gzip member");
+            isal_inflate_reset(&this->state);
+            this->state.crc_flag = ISAL_GZIP;
+        } else {
+            S3WARN("Ignore trailing data after the end of gzip stream");
+            this->finished = true;
+        }
+    }
+
+    if (this->finished || (*inLen == 0)) {
+        *in += *inLen;
+        *inLen = 0;
+        return 0;
+    }
+
+    // like inflate() with S3_INFLATE_WINDOWSBITS, recognize both zlib and gzip stream.
+    if (!this->memberStarted) {
+        this->state.crc_flag = ((unsigned char)**in == 0x1f) ? ISAL_GZIP : ISAL_ZLIB;
+        this->memberStarted = true;
+    }
+
+    this->state.next_in = (uint8_t *)*in;
+    this->state.avail_in = std::min(*inLen, (uint64_t)UINT32_MAX);
+    this->state.next_out = (uint8_t *)out;
+    this->state.avail_out = std::min(outLen, (uint64_t)UINT32_MAX);
+    uint32_t availOut = this->state.avail_out;
+
+    int status = isal_inflate(&this->state);
+    if ((status != ISAL_DECOMP_OK) && (status != ISAL_END_INPUT) &&
+        (status != ISAL_OUT_OVERFLOW)) {
+        S3_CHECK_OR_DIE(
+            false, S3RuntimeError,
+            string("Failed to decompress data: ") + std::to_string((long long)status));
+    }
+
+    if (this->state.block_state == ISAL_BLOCK_FINISH) {
+        S3DEBUG("Decompression finished: ISAL_BLOCK_FINISH.");
+        this->memberEnded = true;
+    }
+
+    *inLen -= (const char *)this->state.next_in - *in;
+    *in = (const char *)this->state.next_in;
+
+    return availOut - this->state.avail_out;
+}
+
+void IsalDecompressor::end() {
+    // the state holds no allocated memory.
+}
+#endif
+
+// gzip is decompressed by ISA-L if gpcloud is built with it.
+static Decompressor *NewGzipDecompressor() {
+#ifdef USE_ISAL
+    return new IsalDecompressor();
+#else
+    return new ZlibDecompressor();
+#endif
+}
+
+#ifdef USE_ZSTD
+void ZstdDecompressor::init() {
+    if (this->dstream == NULL) {
+        this->dstream = ZSTD_createDStream();
+        S3_CHECK_OR_DIE(this->dstream != NULL, S3RuntimeError, "failed to create zstd stream");
+    }
+
+    size_t ret = ZSTD_initDStream(this->dstream);
+    S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                    string("failed to initialize zstd stream: ") + ZSTD_getErrorName(ret));
+}
+
+uint64_t ZstdDecompressor::decompress(const char **in, uint64_t *inLen, char *out,
+                                      uint64_t outLen) {
+    ZSTD_inBuffer input = {*in, *inLen, 0};
+    ZSTD_outBuffer output = {out, outLen, 0};
+
+    // frames concatenated in one key are decompressed one after another.
+    size_t ret = ZSTD_decompressStream(this->dstream, &output, &input);
+    S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                    string("Failed to decompress data: ") + ZSTD_getErrorName(ret));
+
+    *in += input.pos;
+    *inLen -= input.pos;
+
+    return output.pos;
+}
+
+void ZstdDecompressor::end() {
+    if (this->dstream != NULL) {
+        ZSTD_freeDStream(this->dstream);
+        this->dstream = NULL;
+    }
+}
+#endif
+
+#ifdef USE_LZ4
+void LZ4Decompressor::init() {
+    // a freshly created context, previous one might stop in the middle of a frame.
+    this->end();
+
+    LZ4F_errorCode_t ret = LZ4F_createDecompressionContext(&this->dctx, LZ4F_VERSION);
+    S3_CHECK_OR_DIE(!LZ4F_isError(ret), S3RuntimeError,
+                    string("failed to initialize lz4 context: ") + LZ4F_getErrorName(ret));
+}
+
+uint64_t LZ4Decompressor::decompress(const char **in, uint64_t *inLen, char *out,
+                                     uint64_t outLen) {
+    size_t srcSize = *inLen;
+    size_t dstSize = outLen;
+
+    // frames concatenated in one key are decompressed one after another.
+    size_t ret = LZ4F_decompress(this->dctx, out, &dstSize, *in, &srcSize, NULL);
+    S3_CHECK_OR_DIE(!LZ4F_isError(ret), S3RuntimeError,
+                    string("Failed to decompress data: ") + LZ4F_getErrorName(ret));
+
+    *in += srcSize;
+    *inLen -= srcSize;
+
+    return dstSize;
+}
+
+void LZ4Decompressor::end() {
+    if (this->dctx != NULL) {
+        LZ4F_freeDecompressionContext(this->dctx);
+        this->dctx = NULL;
+    }
+}
+#endif
+
+static uint32_t getLittleEndian32(const char *data) {
+    const unsigned char *p = (const unsigned char *)data;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t GetBGZFBlockSize(const char *data, uint64_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+
+    // ID1 ID2 CM FLG(FEXTRA) MTIME(4) XFL OS XLEN(6) 'B' 'C' SLEN(2) BSIZE(2)
+    if ((len < S3_BGZF_HEADER_LEN) || (p[0] != 0x1f) || (p[1] != 0x8b) || (p[2] != 8) ||
+        ((p[3] & 0x04) == 0) || (p[10] != 6) || (p[11] != 0) || (p[12] != 'B') ||
+        (p[13] != 'C') || (p[14] != 2) || (p[15] != 0)) {
+        return 0;
+    }
+
+    uint64_t blockSize = (p[16] | (p[17] << 8)) + 1;
+
+    // header and trailer (CRC32, ISIZE) at least.
+    return blockSize >= S3_BGZF_HEADER_LEN + 8 ? blockSize : 0;
+}
+
+BGZFTaskPool::BGZFTaskPool() : func(NULL), stopping(false) {
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->taskCondVar, NULL);
+    pthread_cond_init(&this->doneCondVar, NULL);
+}
+
+BGZFTaskPool::~BGZFTaskPool() {
+    this->stop();
+
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->taskCondVar);
+    pthread_cond_destroy(&this->doneCondVar);
+}
+
+void BGZFTaskPool::start(uint64_t numOfThreads, BGZFTaskFunc func) {
+    this->stop();
+
+    this->func = func;
+    this->stopping = false;
+
+    // double buffering, workers go on with next tasks while the consumer reads one.
+    this->tasks.assign(numOfThreads * 2, BGZFTask());
+
+    for (uint64_t i = 0; i < numOfThreads; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, WorkerThreadFunc, this);
+        this->threads.push_back(thread);
+    }
+}
+
+void BGZFTaskPool::stop() {
+    if (this->threads.empty()) {
+        return;
+    }
+
+    {
+        UniqueLock lock(&this->mutex);
+        this->stopping = true;
+        pthread_cond_broadcast(&this->taskCondVar);
+    }
+
+    for (uint64_t i = 0; i < this->threads.size(); i++) {
+        pthread_join(this->threads[i], NULL);
+    }
+
+    this->threads.clear();
+    this->queue.clear();
+    this->tasks.clear();
+}
+
+void BGZFTaskPool::submit(uint64_t index) {
+    UniqueLock lock(&this->mutex);
+
+    this->tasks[index].status = BGZFTaskPending;
+    this->queue.push_back(index);
+
+    pthread_cond_signal(&this->taskCondVar);
+}
+
+void BGZFTaskPool::wait(uint64_t index) {
+    UniqueLock lock(&this->mutex);
+
+    while (this->tasks[index].status == BGZFTaskPending) {
+        pthread_cond_wait(&this->doneCondVar, &this->mutex);
+    }
+}
+
+void *BGZFTaskPool::WorkerThreadFunc(void *data) {
+    MaskThreadSignals();
+
+    static_cast<BGZFTaskPool *>(data)->work();
+    return NULL;
+}
+
+void BGZFTaskPool::work() {
+    while (true) {
+        uint64_t index;
+        {
+            UniqueLock lock(&this->mutex);
+            while (this->queue.empty() && !this->stopping) {
+                pthread_cond_wait(&this->taskCondVar, &this->mutex);
+            }
+
+            if (this->stopping) {
+                return;
+            }
+
+            index = this->queue.front();
+            this->queue.pop_front();
+        }
+
+        // a pending task is only touched by its worker.
+        BGZFTask &task = this->tasks[index];
+        BGZFTaskStatus status = this->func(task);
+
+        UniqueLock lock(&this->mutex);
+        task.status = status;
+        pthread_cond_broadcast(&this->doneCondVar);
+    }
+}
+
+#ifdef USE_ISAL
+BGZFTaskStatus InflateBGZFTask(BGZFTask &task) {
+    S3IOTimer timer(S3IO_DECOMPRESS_US);
+
+    struct inflate_state state;
+    BGZFTaskStatus status = BGZFTaskDone;
+
+    uint64_t inPos = 0;
+    uint64_t outPos = 0;
+    while ((status == BGZFTaskDone) && (inPos < task.input.size())) {
+        char *block = task.input.data() + inPos;
+        uint64_t blockSize = GetBGZFBlockSize(block, task.input.size() - inPos);
+        uint32_t uncompressedSize = getLittleEndian32(block + blockSize - 4);
+
+        // the header of a BGZF member is known, the trailer (CRC32, ISIZE) is verified by igzip.
+        char dummy;
+        isal_inflate_init(&state);
+        state.crc_flag = ISAL_GZIP_NO_HDR_VER;
+        state.next_in = (uint8_t *)block + S3_BGZF_HEADER_LEN;
+        state.avail_in = blockSize - S3_BGZF_HEADER_LEN;
+        state.next_out = (uint8_t *)(uncompressedSize ? task.output.data() + outPos : &dummy);
+        state.avail_out = uncompressedSize;
+
+        int ret = isal_inflate(&state);
+        if ((ret != ISAL_DECOMP_OK) || (state.block_state != ISAL_BLOCK_FINISH) ||
+            (state.avail_out != 0) || (state.avail_in != 0)) {
+            task.error =
+                string("Failed to decompress data: ") + std::to_string((long long)ret);
+            status = BGZFTaskFailed;
+        }
+
+        inPos += blockSize;
+        outPos += uncompressedSize;
+    }
+
+    return status;
+}
+#else
+BGZFTaskStatus InflateBGZFTask(BGZFTask &task) {
+    S3IOTimer timer(S3IO_DECOMPRESS_US);
+
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    zstream.next_in = Z_NULL;
+    zstream.avail_in = 0;
+
+    BGZFTaskStatus status = BGZFTaskDone;
+
+    if (inflateInit2(&zstream, MAX_WBITS + 16) != Z_OK) {
+        task.error = "failed to initialize zlib library";
+        status = BGZFTaskFailed;
+    }
+
+    uint64_t inPos = 0;
+    uint64_t outPos = 0;
+    while ((status == BGZFTaskDone) && (inPos < task.input.size())) {
+        char *block = task.input.data() + inPos;
+        uint64_t blockSize = GetBGZFBlockSize(block, task.input.size() - inPos);
+        uint32_t uncompressedSize = getLittleEndian32(block + blockSize - 4);
+
+        // an empty block still needs a valid output pointer.
+        char dummy;
+        inflateReset(&zstream);
+        zstream.next_in = (Byte *)block;
+        zstream.avail_in = blockSize;
+        zstream.next_out = (Byte *)(uncompressedSize ? task.output.data() + outPos : &dummy);
+        zstream.avail_out = uncompressedSize;
+
+        int ret = inflate(&zstream, Z_FINISH);
+        if ((ret != Z_STREAM_END) || (zstream.avail_out != 0) || (zstream.avail_in != 0)) {
+            task.error =
+                string("Failed to decompress data: ") + std::to_string((long long)ret);
+            status = BGZFTaskFailed;
+        }
+
+        inPos += blockSize;
+        outPos += uncompressedSize;
+    }
+
+    inflateEnd(&zstream);
+
+    return status;
+}
+#endif
+
+DecompressReader::DecompressReader()
+    : compressionType(S3_COMPRESSION_GZIP),
+      decompressor(NewGzipDecompressor()),
+      numOfThreads(1),
+      detected(false),
+      inputEOF(false),
+      fillIndex(0),
+      readIndex(0),
+      isClosed(true) {
     this->reader = NULL;
-    this->in = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
+    this->in = NULL;
+    this->inLen = 0;
     this->out = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
+    this->outLen = 0;
     this->outOffset = 0;
 }
 
 DecompressReader::~DecompressReader() {
     this->close();
 
-    delete this->in;
     delete this->out;
 }
 
 // Used for unit test to adjust buffer size
 void DecompressReader::resizeDecompressReaderBuffer(uint64_t size) {
-    delete this->in;
     delete this->out;
-    this->in = new char[size];
     this->out = new char[size];
+    this->outLen = 0;
     this->outOffset = 0;
-    this->zstream.avail_out = size;
 }
 
 void DecompressReader::setReader(Reader *reader) {
     this->reader = reader;
 }
 
-void DecompressReader::open(const S3Params &params) {
-    // allocate inflate state for zlib
-    zstream.zalloc = Z_NULL;
-    zstream.zfree = Z_NULL;
-    zstream.opaque = Z_NULL;
-    zstream.next_in = Z_NULL;
-    zstream.next_out = (Byte *)this->out;
+void DecompressReader::setCompressionType(S3CompressionType type) {
+    if (type == this->compressionType) {
+        return;
+    }
 
-    zstream.avail_in = 0;
-    zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
+    switch (type) {
+        case S3_COMPRESSION_GZIP:
+            this->decompressor.reset(NewGzipDecompressor());
+            break;
+        case S3_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+            this->decompressor.reset(new ZstdDecompressor());
+            break;
+#else
+            S3_DIE(S3RuntimeError, "zstd compressed file is not supported, gpcloud is built "
+                                   "without zstd");
+#endif
+        case S3_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+            this->decompressor.reset(new LZ4Decompressor());
+            break;
+#else
+            S3_DIE(S3RuntimeError, "lz4 compressed file is not supported, gpcloud is built "
+                                   "without lz4");
+#endif
+        default:
+            S3_DIE(S3RuntimeError, "unknown compression type");
+    }
+
+    this->compressionType = type;
+}
 
+void DecompressReader::open(const S3Params &params) {
+    this->in = NULL;
+    this->inLen = 0;
+    this->outLen = 0;
     this->outOffset = 0;
 
-    // with S3_INFLATE_WINDOWSBITS, it could recognize and decode both zlib and gzip stream.
-    int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
-    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+    this->numOfThreads = std::max(params.getNumOfChunks(), (uint64_t)1);
+    this->detected = false;
+    this->inputEOF = false;
+    this->carry.clear();
+    this->fillIndex = 0;
+    this->readIndex = 0;
+
+    this->decompressor->init();
 
     this->isClosed = false;
 
@@ -53,80 +513,439 @@ void DecompressReader::open(const S3Params &params) {
 }
 
 uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
+    const char *data = NULL;
+
+    uint64_t count = this->readView(&data, bufSize);
+    if (count != 0) {
+        memcpy(buf, data, count);
+    }
+
+    return count;
+}
+
+uint64_t DecompressReader::readView(const char **data, uint64_t bufSize) {
+    if (!this->detected) {
+        this->detected = true;
+
+        if (this->detectBGZF()) {
+            S3DEBUG("Decompress BGZF blocks with %" PRIu64 " threads", this->numOfThreads);
+            this->inflater.start(this->numOfThreads, InflateBGZFTask);
+        }
+    }
+
+    if (this->inflater.isStarted()) {
+        return this->readViewParallel(data, bufSize);
+    }
+
     uint64_t remainingOutLen = this->getDecompressedBytesNum() - this->outOffset;
 
-    if (remainingOutLen == 0) {
-        this->decompress();
+    // codec might consume a small piece of input without any output, keep feeding it until there
+    // is output or it can't go further.
+    while (remainingOutLen == 0) {
         this->outOffset = 0;  // reset cursor for out buffer to read from beginning.
+        if (!this->decompress()) {
+            break;
+        }
         remainingOutLen = this->getDecompressedBytesNum();
     }
 
     uint64_t count = std::min(remainingOutLen, bufSize);
-    memcpy(buf, this->out + outOffset, count);
+    *data = this->out + this->outOffset;
 
     this->outOffset += count;
 
     return count;
 }
 
-// Read compressed data from underlying reader and decompress to this->out buffer.
-// If no more data to consume, this->zstream.avail_out == S3_ZIP_DECOMPRESS_CHUNKSIZE;
-void DecompressReader::decompress() {
-    if (this->zstream.avail_in == 0) {
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
+// Decompress compressed data from underlying reader to this->out buffer, compressed data is lent by
+// underlying reader and decompressed in place.
+// Return false if no more data to consume, this->outLen == 0 then.
+bool DecompressReader::decompress() {
+    this->outLen = 0;
 
-        // read S3_ZIP_DECOMPRESS_CHUNKSIZE data from underlying reader and put into this->in
-        // buffer. read() might happen more than once when reaching EOF, make sure every time read()
+    if (this->inLen == 0) {
+        // read() might happen more than once when reaching EOF, make sure every time read()
         // will return 0.
-        uint64_t hasRead = this->reader->read(this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
+        uint64_t hasRead = this->reader->readView(&this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
 
         // EOF, no more data to decompress.
         if (hasRead == 0) {
-            S3DEBUG(
-                "No more data to decompress: avail_in = %u, avail_out = %u, total_in = %u, "
-                "total_out = %u",
-                zstream.avail_in, zstream.avail_out,
-		(unsigned int) zstream.total_in, (unsigned int) zstream.total_out);
-            return;
+            S3DEBUG("No more data to decompress");
+            return false;
         }
 
-        // Fill this->in as possible as it could, otherwise data in this->in might not be able to be
-        // inflated.
-        while (hasRead < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
-            uint64_t count =
-                this->reader->read(this->in + hasRead, S3_ZIP_DECOMPRESS_CHUNKSIZE - hasRead);
+        this->inLen = hasRead;
+    }
+
+    uint64_t availIn = this->inLen;
+
+    S3IOTimer timer(S3IO_DECOMPRESS_US);
+    this->outLen = this->decompressor->decompress(&this->in, &this->inLen, this->out,
+                                                  S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    // no progress, e.g. data after the end of stream.
+    return (this->inLen != availIn) || (this->outLen != 0);
+}
+
+bool DecompressReader::detectBGZF() {
+    if ((this->compressionType != S3_COMPRESSION_GZIP) || (this->numOfThreads <= 1)) {
+        return false;
+    }
 
-            if (count == 0) {
+    // the lent data is decompressed later, in parallel or not.
+    this->inLen = this->reader->readView(&this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    return GetBGZFBlockSize(this->in, this->inLen) != 0;
+}
+
+// Move whole blocks of about S3_ZIP_DECOMPRESS_CHUNKSIZE decompressed bytes into task, the partial
+// block at the end is carried to next task. Return false if there is no more block.
+bool DecompressReader::fillTask(BGZFTask &task) {
+    task.input.swap(this->carry);
+    this->carry.clear();
+
+    uint64_t parsed = 0;
+    uint64_t outputLen = 0;
+
+    while (true) {
+        while (parsed + S3_BGZF_HEADER_LEN <= task.input.size()) {
+            const char *block = task.input.data() + parsed;
+            uint64_t blockSize = GetBGZFBlockSize(block, task.input.size() - parsed);
+            S3_CHECK_OR_DIE(blockSize != 0, S3RuntimeError,
+                            "Failed to decompress data: invalid BGZF block");
+
+            if (parsed + blockSize > task.input.size()) {
                 break;
             }
 
-            hasRead += count;
+            outputLen += getLittleEndian32(block + blockSize - 4);
+            parsed += blockSize;
+        }
+
+        if ((outputLen >= S3_ZIP_DECOMPRESS_CHUNKSIZE) || this->inputEOF) {
+            break;
+        }
+
+        if (this->inLen == 0) {
+            this->inLen = this->reader->readView(&this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
+            if (this->inLen == 0) {
+                this->inputEOF = true;
+                continue;
+            }
         }
 
-        this->zstream.next_in = (Byte *)this->in;
-        this->zstream.avail_in = hasRead;
-    } else {
-        // Still have more data in 'in' buffer to decode.
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
+        // a block at a time, to keep tasks in similar size.
+        uint64_t len = std::min(this->inLen, (uint64_t)S3_BGZF_MAX_BLOCK_SIZE);
+        task.input.insert(task.input.end(), this->in, this->in + len);
+        this->in += len;
+        this->inLen -= len;
     }
 
-    int status = inflate(&this->zstream, Z_NO_FLUSH);
-    if (status == Z_STREAM_END) {
-        S3DEBUG("Decompression finished: Z_STREAM_END.");
-    } else if (status < 0 || status == Z_NEED_DICT) {
-        inflateEnd(&this->zstream);
-        S3_CHECK_OR_DIE(
-            false, S3RuntimeError,
-            string("Failed to decompress data: ") + std::to_string((unsigned long long)status));
+    S3_CHECK_OR_DIE(!this->inputEOF || (parsed == task.input.size()), S3RuntimeError,
+                    "Failed to decompress data: truncated BGZF block");
+
+    this->carry.assign(task.input.begin() + parsed, task.input.end());
+    task.input.resize(parsed);
+    task.output.resize(outputLen);
+
+    return parsed > 0;
+}
+
+uint64_t DecompressReader::readViewParallel(const char **data, uint64_t count) {
+    vector<BGZFTask> &tasks = this->inflater.getTasks();
+
+    while (true) {
+        // keep workers busy, tasks are filled and read in the same order.
+        while ((this->fillIndex - this->readIndex < tasks.size()) &&
+               this->fillTask(tasks[this->fillIndex % tasks.size()])) {
+            this->inflater.submit(this->fillIndex % tasks.size());
+            this->fillIndex++;
+        }
+
+        // all tasks are read.
+        if (this->readIndex == this->fillIndex) {
+            return 0;
+        }
+
+        BGZFTask &task = tasks[this->readIndex % tasks.size()];
+        this->inflater.wait(this->readIndex % tasks.size());
+
+        S3_CHECK_OR_DIE(task.status != BGZFTaskFailed, S3RuntimeError, task.error);
+
+        if (this->outOffset < task.output.size()) {
+            uint64_t len = std::min(count, task.output.size() - this->outOffset);
+            *data = task.output.data() + this->outOffset;
+            this->outOffset += len;
+            return len;
+        }
+
+        task.status = BGZFTaskEmpty;
+        this->outOffset = 0;
+        this->readIndex++;
     }
 }
 
 void DecompressReader::close() {
     if (!this->isClosed) {
-        inflateEnd(&zstream);
+        this->inflater.stop();
+        this->decompressor->end();
         this->reader->close();
         this->isClosed = true;
     }
 }
+
+vector<uint64_t> ParseZstdSeekTable(const char *footer, const char *table, uint64_t tableLen,
+                                    uint64_t keySize) {
+    vector<uint64_t> offsets;
+
+    // Number_Of_Frames(4) Seek_Table_Descriptor(1) Seekable_Magic_Number(4)
+    uint64_t numOfFrames = getLittleEndian32(footer);
+    uint8_t descriptor = (uint8_t)footer[4];
+    uint64_t entrySize = (descriptor & 0x80) ? 12 : 8;
+    if ((getLittleEndian32(footer + 5) != S3_ZSTD_SEEKABLE_MAGIC) || ((descriptor & 0x7c) != 0) ||
+        (tableLen != S3_ZSTD_SKIPPABLE_HEADER_LEN + numOfFrames * entrySize +
+                         S3_ZSTD_SEEK_FOOTER_LEN) ||
+        (tableLen > keySize) || (getLittleEndian32(table) != S3_ZSTD_SKIPPABLE_MAGIC) ||
+        (getLittleEndian32(table + 4) != tableLen - S3_ZSTD_SKIPPABLE_HEADER_LEN)) {
+        return offsets;
+    }
+
+    // Compressed_Size(4) Decompressed_Size(4) [Checksum(4)]
+    uint64_t offset = 0;
+    offsets.reserve(numOfFrames + 1);
+    for (uint64_t i = 0; i < numOfFrames; i++) {
+        offsets.push_back(offset);
+        offset += getLittleEndian32(table + S3_ZSTD_SKIPPABLE_HEADER_LEN + i * entrySize);
+    }
+    offsets.push_back(offset);
+
+    // frames must be followed by the seek table immediately.
+    if (offset != keySize - tableLen) {
+        offsets.clear();
+    }
+
+    return offsets;
+}
+
+// Return the offsets of the frames of a zstd key and its seek table, empty if it is not seekable.
+static vector<uint64_t> readZstdSeekTable(S3Interface *s3Interface, const S3Url &s3Url,
+                                          uint64_t keySize) {
+    vector<uint64_t> offsets;
+    if (keySize < S3_ZSTD_SKIPPABLE_HEADER_LEN + S3_ZSTD_SEEK_FOOTER_LEN) {
+        return offsets;
+    }
+
+    S3VectorUInt8 footer;
+    uint64_t footerOffset = keySize - S3_ZSTD_SEEK_FOOTER_LEN;
+    if (s3Interface->fetchData(footerOffset, footer, S3_ZSTD_SEEK_FOOTER_LEN, s3Url) !=
+        S3_ZSTD_SEEK_FOOTER_LEN) {
+        return offsets;
+    }
+
+    const char *p = (const char *)footer.data();
+    if (getLittleEndian32(p + 5) != S3_ZSTD_SEEKABLE_MAGIC) {
+        return offsets;
+    }
+
+    uint64_t entrySize = (p[4] & 0x80) ? 12 : 8;
+    uint64_t tableLen = S3_ZSTD_SKIPPABLE_HEADER_LEN + getLittleEndian32(p) * entrySize +
+                        S3_ZSTD_SEEK_FOOTER_LEN;
+    if (tableLen > keySize) {
+        return offsets;
+    }
+
+    S3VectorUInt8 table;
+    if (s3Interface->fetchData(keySize - tableLen, table, tableLen, s3Url) != tableLen) {
+        return offsets;
+    }
+
+    return ParseZstdSeekTable(p, (const char *)table.data(), tableLen, keySize);
+}
+
+// Return the offset of the first BGZF block at or after offset. A block is recognized by its
+// header and the header of the block after it, or the end of the key.
+static uint64_t findBGZFBlock(S3Interface *s3Interface, const S3Url &s3Url, uint64_t keySize,
+                              uint64_t offset) {
+    if ((offset == 0) || (offset >= keySize)) {
+        return std::min(offset, keySize);
+    }
+
+    // the next block starts within a block size, and its successor within another one.
+    uint64_t len = std::min(keySize - offset,
+                            (uint64_t)(2 * S3_BGZF_MAX_BLOCK_SIZE + S3_BGZF_HEADER_LEN));
+    S3VectorUInt8 data;
+    S3_CHECK_OR_DIE(s3Interface->fetchData(offset, data, len, s3Url) == len, S3RuntimeError,
+                    "Failed to fetch BGZF blocks");
+
+    const char *p = (const char *)data.data();
+    for (uint64_t i = 0; i + S3_BGZF_HEADER_LEN <= len; i++) {
+        uint64_t next = i + GetBGZFBlockSize(p + i, len - i);
+        if ((next == i) || (next > len)) {
+            continue;
+        }
+
+        if ((offset + next == keySize) || (GetBGZFBlockSize(p + next, len - next) != 0)) {
+            return offset + i;
+        }
+    }
+
+    // no block starts in the rest of the key.
+    S3_CHECK_OR_DIE(offset + len == keySize, S3RuntimeError,
+                    "Failed to decompress data: invalid BGZF block");
+    return keySize;
+}
+
+bool LocateCompressedMembers(S3Interface *s3Interface, const S3Params &params,
+                             S3CompressionType type, uint64_t *memberStart, uint64_t *memberEnd) {
+    const S3Url &s3Url = params.getS3Url();
+    uint64_t keySize = params.getKeySize();
+    uint64_t start = std::min(params.getKeyRangeStart(), keySize);
+    uint64_t end = params.getKeyRangeEnd();
+    if ((end == 0) || (end > keySize)) {
+        end = keySize;
+    }
+
+    if (type == S3_COMPRESSION_GZIP) {
+        S3VectorUInt8 header;
+        if ((keySize < S3_BGZF_HEADER_LEN) ||
+            (s3Interface->fetchData(0, header, S3_BGZF_HEADER_LEN, s3Url) != S3_BGZF_HEADER_LEN) ||
+            (GetBGZFBlockSize((const char *)header.data(), S3_BGZF_HEADER_LEN) == 0)) {
+            return false;
+        }
+
+        *memberStart = findBGZFBlock(s3Interface, s3Url, keySize, start);
+        *memberEnd = findBGZFBlock(s3Interface, s3Url, keySize, end);
+        return true;
+    }
+
+    if (type == S3_COMPRESSION_ZSTD) {
+        vector<uint64_t> offsets = readZstdSeekTable(s3Interface, s3Url, keySize);
+        if (offsets.empty()) {
+            return false;
+        }
+
+        // the seek table itself belongs to the last range.
+        *memberStart = (start == 0) ? 0 : *std::lower_bound(offsets.begin(), offsets.end(), start);
+        *memberEnd = (end == keySize) ? keySize
+                                      : *std::lower_bound(offsets.begin(), offsets.end(), end);
+        return true;
+    }
+
+    return false;
+}
+
+SplitDecompressReader::SplitDecompressReader()
+    : reader(NULL),
+      memberStart(0),
+      memberEnd(0),
+      isOpened(false),
+      skippingFirstLine(false),
+      readingTail(false),
+      finished(true) {
+}
+
+SplitDecompressReader::~SplitDecompressReader() {
+    this->close();
+}
+
+void SplitDecompressReader::open(const S3Params &params) {
+    this->params = params;
+
+    this->skippingFirstLine = params.getKeyRangeStart() > 0;
+    this->readingTail = false;
+    this->eolScanner = EolScanner(eolString);
+
+    // a member larger than the range might cover it, the lines are read by a previous range.
+    this->finished = this->memberStart >= this->memberEnd;
+    if (this->finished) {
+        S3DEBUG("No member starts in range [%" PRIu64 ", %" PRIu64 ")", params.getKeyRangeStart(),
+                params.getKeyRangeEnd());
+        return;
+    }
+
+    this->openMembers(this->memberStart, this->memberEnd);
+}
+
+void SplitDecompressReader::openMembers(uint64_t start, uint64_t end) {
+    S3Params readerParams = this->params;
+    readerParams.setKeyRange(start, end);
+    readerParams.setRawKeyRange(true);
+
+    // only a line is needed from the tail, don't download ahead in large chunks.
+    if (this->readingTail) {
+        readerParams.setChunkSize(
+            std::min(readerParams.getChunkSize(), (uint64_t)S3_RANGE_TAIL_CHUNKSIZE));
+    }
+
+    this->isOpened = true;
+    this->reader->open(readerParams);
+}
+
+uint64_t SplitDecompressReader::read(char *buf, uint64_t count) {
+    const char *data = NULL;
+
+    uint64_t readLen = this->readView(&data, count);
+    if (readLen != 0) {
+        memcpy(buf, data, readLen);
+    }
+
+    return readLen;
+}
+
+uint64_t SplitDecompressReader::readView(const char **data, uint64_t count) {
+    while (!this->finished) {
+        uint64_t readLen = this->reader->readView(data, count);
+        if (readLen == 0) {
+            // the last line might go on in the members after the range, unless the first line
+            // never ended, then no line starts in this range.
+            if (this->readingTail || this->skippingFirstLine ||
+                (this->memberEnd >= this->params.getKeySize())) {
+                this->finished = true;
+                break;
+            }
+
+            // the next range scans the same data for its first line, start over the same way.
+            this->reader->close();
+            this->readingTail = true;
+            this->eolScanner.reset();
+            this->openMembers(this->memberEnd, this->params.getKeySize());
+            continue;
+        }
+
+        const char *buf = *data;
+        uint64_t begin = 0;
+        if (this->skippingFirstLine) {
+            begin = this->eolScanner.find(buf, readLen);
+            if (begin == (uint64_t)-1) {
+                continue;
+            }
+
+            this->skippingFirstLine = false;
+        }
+
+        uint64_t end = readLen;
+        if (this->readingTail) {
+            uint64_t found = this->eolScanner.find(buf, readLen, begin);
+            if (found != (uint64_t)-1) {
+                end = found;
+                this->finished = true;
+            }
+        }
+
+        if (end > begin) {
+            *data = buf + begin;
+            return end - begin;
+        }
+    }
+
+    return 0;
+}
+
+void SplitDecompressReader::close() {
+    if (this->isOpened) {
+        this->reader->close();
+        this->isOpened = false;
+    }
+
+    this->finished = true;
+}
@@ -12,14 +12,21 @@ extern "C" {
 #endif
 
 #include "access/extprotocol.h"
+#include "access/fileam.h"
+#include "access/htup_details.h"
 #include "access/xact.h"
 #include "catalog/pg_exttable.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbvars.h"
 #include "fmgr.h"
 #include "funcapi.h"
+#include "nodes/nodeFuncs.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
 #include "utils/resowner.h"
 
 #ifdef __clang__
@@ -30,13 +37,16 @@ extern "C" {
 PG_MODULE_MAGIC;
 PG_FUNCTION_INFO_V1(s3_export);
 PG_FUNCTION_INFO_V1(s3_import);
+PG_FUNCTION_INFO_V1(gpcloud_stats);
 
 Datum s3_export(PG_FUNCTION_ARGS);
 Datum s3_import(PG_FUNCTION_ARGS);
+Datum gpcloud_stats(PG_FUNCTION_ARGS);
 }
 
 #include "gpreader.h"
 #include "gpwriter.h"
+#include "s3iostats.h"
 
 string s3extErrorMessage;
 
@@ -171,6 +181,252 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
     }
 }
 
+// Get value of a quoted option in fmtopts, e.g. "delimiter '|'".
+static bool getQuotedFormatOpt(const char *fmtopts, const char *name, string &value) {
+    string pattern = string(name) + " '";
+    const char *first = strstr(fmtopts, pattern.c_str());
+    if (first == NULL) {
+        return false;
+    }
+
+    first += pattern.size();
+    const char *second = strchr(first, '\'');
+    if (second == NULL) {
+        return false;
+    }
+
+    value.assign(first, second - first);
+    return true;
+}
+
+static bool collectVarAttnos(Node *node, vector<bool> *projected) {
+    if (node == NULL) {
+        return false;
+    }
+
+    if (IsA(node, Var)) {
+        AttrNumber attno = ((Var *)node)->varattno;
+        if (attno > 0 && (uint64_t)attno <= projected->size()) {
+            (*projected)[attno - 1] = true;
+        } else if (attno == InvalidAttrNumber) {
+            // whole-row reference
+            projected->assign(projected->size(), true);
+        }
+        return false;
+    }
+
+    return expression_tree_walker(node, (bool (*)())collectVarAttnos, (void *)projected);
+}
+
+// Convert "Var op Const" into a qual, return false if it can't be pushed down.
+static bool getScanQual(OpExpr *expr, S3ScanQual &qual) {
+    if (list_length(expr->args) != 2) {
+        return false;
+    }
+
+    Node *left = (Node *)linitial(expr->args);
+    Node *right = (Node *)lsecond(expr->args);
+    Oid opno = expr->opno;
+
+    if (IsA(left, Const) && IsA(right, Var)) {
+        std::swap(left, right);
+        opno = get_commutator(opno);
+        if (opno == InvalidOid) {
+            return false;
+        }
+    }
+
+    if (!IsA(left, Var) || !IsA(right, Const) || ((Const *)right)->constisnull) {
+        return false;
+    }
+
+    Var *var = (Var *)left;
+    Const *constant = (Const *)right;
+    if (var->varattno <= 0) {
+        return false;
+    }
+
+    char *opname = get_opname(opno);
+    if (opname == NULL) {
+        return false;
+    }
+
+    if (strcmp(opname, "=") == 0) {
+        qual.op = S3_QUAL_EQ;
+    } else if (strcmp(opname, "<") == 0) {
+        qual.op = S3_QUAL_LT;
+    } else if (strcmp(opname, "<=") == 0) {
+        qual.op = S3_QUAL_LE;
+    } else if (strcmp(opname, ">") == 0) {
+        qual.op = S3_QUAL_GT;
+    } else if (strcmp(opname, ">=") == 0) {
+        qual.op = S3_QUAL_GE;
+    } else {
+        return false;
+    }
+
+    // order of strings depends on collation, only equality is pushed down for them.
+    switch (var->vartype) {
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+        case FLOAT4OID:
+        case FLOAT8OID:
+        case NUMERICOID:
+            break;
+        case TEXTOID:
+        case VARCHAROID:
+            if (qual.op != S3_QUAL_EQ) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    // numbers are compared as numbers, both sides must be of the same kind.
+    if ((var->vartype == TEXTOID || var->vartype == VARCHAROID) !=
+        (constant->consttype == TEXTOID || constant->consttype == VARCHAROID)) {
+        return false;
+    }
+
+    Oid typOutput;
+    bool typIsVarlena;
+    getTypeOutputInfo(constant->consttype, &typOutput, &typIsVarlena);
+
+    qual.column = var->varattno - 1;
+    qual.numeric = (var->vartype != TEXTOID) && (var->vartype != VARCHAROID);
+    qual.value = OidOutputFunctionCall(typOutput, constant->constvalue);
+    return true;
+}
+
+// Format of lines in the table, from the FORMAT clause.
+static void getLineFormat(ExtTableEntry *exttbl, S3ScanDesc &scanDesc) {
+    scanDesc.csv = fmttype_is_csv(exttbl->fmtcode);
+    if (scanDesc.csv) {
+        scanDesc.nullString = "";
+        scanDesc.escape = '"';
+    }
+
+    string value;
+    if (getQuotedFormatOpt(exttbl->fmtopts, "delimiter", value) && value.size() == 1) {
+        scanDesc.delimiter = value[0];
+    }
+    if (getQuotedFormatOpt(exttbl->fmtopts, "null", value)) {
+        scanDesc.nullString = value;
+    }
+    if (getQuotedFormatOpt(exttbl->fmtopts, "escape", value)) {
+        scanDesc.escape = (pg_strcasecmp(value.c_str(), "off") == 0) ? '\0' : value[0];
+    }
+    if (getQuotedFormatOpt(exttbl->fmtopts, "quote", value) && value.size() == 1) {
+        scanDesc.quote = value[0];
+    }
+}
+
+// Describe columns, projection and quals of the scan, used by readers of columnar files.
+static S3ScanDesc getScanDesc(FunctionCallInfo fcinfo) {
+    Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
+    ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
+    ExternalSelectDesc desc = EXTPROTOCOL_GET_EXTERNAL_SELECT_DESC(fcinfo);
+
+    S3ScanDesc scanDesc;
+    getLineFormat(exttbl, scanDesc);
+
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    for (int i = 0; i < tupdesc->natts; i++) {
+        scanDesc.columns.push_back(NameStr(tupdesc->attrs[i]->attname));
+    }
+
+    // without projection info, every column is in the output.
+    ProjectionInfo *projInfo = (desc != NULL) ? desc->projInfo : NULL;
+    if (projInfo == NULL) {
+        scanDesc.projected.assign(tupdesc->natts, true);
+    } else {
+        scanDesc.projected.assign(tupdesc->natts, false);
+
+        for (int i = 0; i < projInfo->pi_numSimpleVars; i++) {
+            int attno = projInfo->pi_varNumbers[i];
+            if (attno > 0 && attno <= tupdesc->natts) {
+                scanDesc.projected[attno - 1] = true;
+            }
+        }
+
+        ListCell *lc;
+        foreach (lc, projInfo->pi_targetlist) {
+            GenericExprState *gstate = (GenericExprState *)lfirst(lc);
+            collectVarAttnos((Node *)gstate->arg->expr, &scanDesc.projected);
+        }
+    }
+
+    if (desc != NULL) {
+        scanDesc.sampleFraction = desc->sample_fraction;
+    }
+
+    // quals are still evaluated by the scan, they only help to skip data here.
+    List *quals = (desc != NULL) ? desc->filter_quals : NIL;
+    ListCell *lc;
+    foreach (lc, quals) {
+        Node *node = (Node *)lfirst(lc);
+        collectVarAttnos(node, &scanDesc.projected);
+
+        S3ScanQual qual;
+        if (IsA(node, OpExpr) && getScanQual((OpExpr *)node, qual)) {
+            scanDesc.quals.push_back(qual);
+        }
+    }
+
+    // dropped columns are still in the line, but never referenced.
+    for (int i = 0; i < tupdesc->natts; i++) {
+        if (tupdesc->attrs[i]->attisdropped) {
+            scanDesc.projected[i] = false;
+        }
+    }
+
+    return scanDesc;
+}
+
+// Describe columns and their types as they are in the lines to export, used by writers of
+// columnar files. Dropped columns are not written by the formatter.
+static S3ScanDesc getExportDesc(FunctionCallInfo fcinfo) {
+    Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
+    ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
+
+    S3ScanDesc exportDesc;
+    getLineFormat(exttbl, exportDesc);
+
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    for (int i = 0; i < tupdesc->natts; i++) {
+        if (tupdesc->attrs[i]->attisdropped) {
+            continue;
+        }
+
+        S3ColumnType type;
+        switch (tupdesc->attrs[i]->atttypid) {
+            case BOOLOID:
+                type = S3_COLUMN_BOOL;
+                break;
+            case INT2OID:
+            case INT4OID:
+                type = S3_COLUMN_INT32;
+                break;
+            case INT8OID:
+                type = S3_COLUMN_INT64;
+                break;
+            case FLOAT4OID:
+            case FLOAT8OID:
+                type = S3_COLUMN_DOUBLE;
+                break;
+            default:
+                type = S3_COLUMN_TEXT;
+        }
+
+        exportDesc.columns.push_back(NameStr(tupdesc->attrs[i]->attname));
+        exportDesc.types.push_back(type);
+    }
+
+    return exportDesc;
+}
+
 typedef struct gpcloudResHandle {
     GPReader *gpreader;
     GPWriter *gpwriter;
@@ -260,6 +516,19 @@ static void gpcloudAbortCallback(ResourceReleasePhase phase, bool isCommit, bool
     }
 }
 
+/*
+ * The I/O statistics cover all gpcloud external tables scanned by a query, they are reset when the
+ * first of them is opened by a new command.
+ */
+static int statsCommandCount = -1;
+
+static void resetS3IOStatsForNewCommand(void) {
+    if (statsCommandCount != gp_command_count) {
+        GetS3IOStats().reset();
+        statsCommandCount = gp_command_count;
+    }
+}
+
 /*
  * Import data into GPDB.
  * invoked by GPDB, be careful with C++ exceptions.
@@ -295,8 +564,11 @@ Datum s3_import(PG_FUNCTION_ARGS) {
         parseFormatOpts(fcinfo);
 
         thread_setup();
+        resetS3IOStatsForNewCommand();
+
+        S3ScanDesc scanDesc = getScanDesc(fcinfo);
 
-        resHandle->gpreader = reader_init(url_with_options);
+        resHandle->gpreader = reader_init(url_with_options, &scanDesc);
         if (!resHandle->gpreader) {
             ereport(ERROR, (0, errmsg("Failed to init gpcloud extension (segid = %d, "
                                       "segnum = %d), please check your "
@@ -304,6 +576,12 @@ Datum s3_import(PG_FUNCTION_ARGS) {
                                       s3ext_segid, s3ext_segnum, s3extErrorMessage.c_str())));
         }
 
+        // the scan samples the rows of the ranges read to make up the rest.
+        ExternalSelectDesc desc = EXTPROTOCOL_GET_EXTERNAL_SELECT_DESC(fcinfo);
+        if (desc != NULL) {
+            desc->sample_read_fraction = resHandle->gpreader->getSampledFraction();
+        }
+
         EXTPROTOCOL_SET_USER_CTX(fcinfo, resHandle);
     }
 
@@ -350,8 +628,11 @@ Datum s3_export(PG_FUNCTION_ARGS) {
         const char *format = getFormatStr(fcinfo);
 
         thread_setup();
+        resetS3IOStatsForNewCommand();
+
+        S3ScanDesc exportDesc = getExportDesc(fcinfo);
 
-        resHandle->gpwriter = writer_init(url_with_options, format);
+        resHandle->gpwriter = writer_init(url_with_options, format, &exportDesc);
         if (!resHandle->gpwriter) {
             ereport(ERROR, (0, errmsg("Failed to init gpcloud extension (segid = %d, "
                                       "segnum = %d), please check your "
@@ -372,3 +653,44 @@ Datum s3_export(PG_FUNCTION_ARGS) {
 
     PG_RETURN_INT32(data_len);
 }
+
+/*
+ * Return the S3 I/O statistics of the last query that scanned gpcloud external tables in this
+ * segment, one row per segment when it is executed on all segments.
+ */
+Datum gpcloud_stats(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+
+    if (SRF_IS_FIRSTCALL()) {
+        funcctx = SRF_FIRSTCALL_INIT();
+        MemoryContext oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        TupleDesc tupdesc;
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE) {
+            elog(ERROR, "gpcloud_stats: return type must be a row type");
+        }
+        if (tupdesc->natts != S3IO_NUM_COUNTERS + 1) {
+            elog(ERROR, "gpcloud_stats: return type must have %d columns", S3IO_NUM_COUNTERS + 1);
+        }
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    if (funcctx->call_cntr > 0) {
+        SRF_RETURN_DONE(funcctx);
+    }
+
+    Datum values[S3IO_NUM_COUNTERS + 1];
+    bool nulls[S3IO_NUM_COUNTERS + 1];
+    memset(nulls, 0, sizeof(nulls));
+
+    values[0] = Int32GetDatum(GpIdentity.segindex);
+    for (int i = 0; i < S3IO_NUM_COUNTERS; i++) {
+        values[i + 1] = Int64GetDatum((int64)GetS3IOStats().get((S3IOCounter)i));
+    }
+
+    HeapTuple tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+    SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+}
@@ -1,4 +1,5 @@
 #include "gpreader.h"
+#include "s3iostats.h"
 #include "s3memory_mgmt.h"
 
 // Thread related functions, called only by gpreader and gpcheckcloud
@@ -68,6 +69,14 @@ void GPReader::open(const S3Params& params) {
     this->bucketReader.setS3InterfaceService(&this->s3InterfaceService);
     this->bucketReader.setUpstreamReader(&this->commonReader);
     this->commonReader.setS3InterfaceService(&this->s3InterfaceService);
+
+    vector<Reader*> lookahead;
+    for (uint64_t i = 0; i < this->params.getPrefetchKeys(); i++) {
+        this->lookaheadReaders[i].setS3InterfaceService(&this->s3InterfaceService);
+        lookahead.push_back(&this->lookaheadReaders[i]);
+    }
+    this->bucketReader.setLookaheadReaders(lookahead);
+
     this->bucketReader.open(this->params);
 }
 
@@ -77,13 +86,17 @@ uint64_t GPReader::read(char* buf, uint64_t count) {
     return this->bucketReader.read(buf, count);
 }
 
+uint64_t GPReader::readView(const char** data, uint64_t count) {
+    return this->bucketReader.readView(data, count);
+}
+
 // This should be reentrant, has no side effects when called multiple times.
 void GPReader::close() {
     this->bucketReader.close();
 }
 
 // invoked by s3_import(), need to be exception safe
-GPReader* reader_init(const char* url_with_options) {
+GPReader* reader_init(const char* url_with_options, const S3ScanDesc* scanDesc) {
     GPReader* reader = NULL;
     s3extErrorMessage.clear();
 
@@ -95,6 +108,9 @@ GPReader* reader_init(const char* url_with_options) {
         string urlWithOptions(url_with_options);
 
         S3Params params = InitConfig(urlWithOptions);
+        if (scanDesc != NULL) {
+            params.setScanDesc(*scanDesc);
+        }
 
         InitRemoteLog();
 
@@ -133,7 +149,13 @@ bool reader_transfer_data(GPReader* reader, char* data_buf, int& data_len) {
             return false;
         }
 
-        uint64_t read_len = reader->read(data_buf, data_len);
+        // data_buf is owned by the external table scan, copy into it straight from the buffer
+        // where the data is downloaded or decompressed.
+        const char* data = NULL;
+        uint64_t read_len = reader->readView(&data, data_len);
+        if (read_len != 0) {
+            memcpy(data_buf, data, read_len);
+        }
 
         // sure read_len <= data_len here, hence truncation will never happen
         data_len = (int)read_len;
@@ -160,6 +182,9 @@ bool reader_cleanup(GPReader** reader) {
             (*reader)->close();
             delete *reader;
             *reader = NULL;
+
+            S3INFO("S3 I/O statistics of segment %%d: %%s", s3ext_segid,
+                   GetS3IOStats().toString().c_str());
         } else {
             result = false;
         }
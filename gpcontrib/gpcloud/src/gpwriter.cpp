@@ -1,40 +1,57 @@
 #include "gpwriter.h"
+#include "s3iostats.h"
 #include "s3memory_mgmt.h"
 
 GPWriter::GPWriter(const S3Params& params, string fmt)
-    : format(fmt), params(params), restfulService(this->params), s3InterfaceService(this->params) {
+    : format(fmt),
+      params(params),
+      tableUrl(params.getS3Url()),
+      restfulService(this->params),
+      s3InterfaceService(this->params) {
     restfulServicePtr = &restfulService;
 }
 
 void GPWriter::open(const S3Params& params) {
     this->s3InterfaceService.setRESTfulService(this->restfulServicePtr);
-    this->params = this->params.setPrefix(this->genUniqueKeyName(this->params.getS3Url()));
+    this->params = this->params.setPrefix(this->genUniqueKeyName(this->tableUrl));
+    this->keyUrls.assign(1, this->getKeyUrlToUpload());
     this->commonWriter.setS3InterfaceService(&this->s3InterfaceService);
     this->commonWriter.open(this->params);
 }
 
 uint64_t GPWriter::write(const char* buf, uint64_t count) {
+    this->rolloverIfFull();
     return this->commonWriter.write(buf, count);
 }
 
+// s3_export() writes a row at a time, rolling over before a row keeps every row in one key.
+void GPWriter::rolloverIfFull() {
+    uint64_t rolloverSize = this->params.getRolloverSize();
+    if ((rolloverSize == 0) || (this->commonWriter.getKeySize() < rolloverSize)) {
+        return;
+    }
+
+    this->params = this->params.setPrefix(this->genUniqueKeyName(this->tableUrl));
+    this->commonWriter.rollover(this->params.getS3Url());
+    this->keyUrls.push_back(this->getKeyUrlToUpload());
+
+    S3DEBUG("Segment %d rolled over to \"%s\"", s3ext_segid,
+            this->params.getS3Url().getFullUrlForCurl().c_str());
+}
+
 void GPWriter::close() {
     this->commonWriter.close();
 }
 
+// Segment, session and command tell the keys of a statement from the keys of other statements of
+// the cluster, the number of keys written so far tells the keys of rollovers apart. The random
+// part is for other clusters and restarts, the name is not checked against the bucket.
 string GPWriter::genUniqueKeyName(const S3Url& s3Url) {
-    string fullUrl = s3Url.getFullUrlForCurl();
-
-    while (true) {
-        stringstream ss;
-        ss << s3ext_segid << this->constructRandomStr() << "." << this->format;
+    stringstream ss;
+    ss << s3ext_segid << "_" << s3ext_sessionid << "_" << s3ext_commandid << "_"
+       << this->keyUrls.size() << "_" << this->constructRandomStr() << "." << this->format;
 
-        if (!this->s3InterfaceService.checkKeyExistence(
-                S3Url((fullUrl + ss.str()), (s3Url.getSchema() == "https"), s3Url.getVersion(),
-                      s3Url.getRegion()))) {
-            string keyName = ss.str();
-            return s3Url.getPrefix() + keyName;
-        }
-    }
+    return s3Url.getPrefix() + ss.str();
 }
 
 string GPWriter::constructRandomStr() {
@@ -62,7 +79,8 @@ string GPWriter::constructRandomStr() {
 }
 
 // invoked by s3_export(), need to be exception safe
-GPWriter* writer_init(const char* url_with_options, const char* format) {
+GPWriter* writer_init(const char* url_with_options, const char* format,
+                      const S3ScanDesc* scanDesc) {
     GPWriter* writer = NULL;
     s3extErrorMessage.clear();
 
@@ -74,6 +92,9 @@ GPWriter* writer_init(const char* url_with_options, const char* format) {
         string urlWithOptions(url_with_options);
 
         S3Params params = InitConfig(urlWithOptions);
+        if (scanDesc != NULL) {
+            params.setScanDesc(*scanDesc);
+        }
 
         InitRemoteLog();
 
@@ -81,6 +102,9 @@ GPWriter* writer_init(const char* url_with_options, const char* format) {
         PrepareS3MemContext(params);
 
         string extName = params.isAutoCompress() ? string(format) + ".gz" : format;
+        if (params.getExportFormat() == S3_EXPORT_PARQUET) {
+            extName = "parquet";
+        }
         writer = new GPWriter(params, extName);
         if (writer == NULL) {
             return NULL;
@@ -140,6 +164,9 @@ bool writer_cleanup(GPWriter** writer) {
             (*writer)->close();
             delete *writer;
             *writer = NULL;
+
+            S3INFO("S3 I/O statistics of segment %%d: %%s", s3ext_segid,
+                   GetS3IOStats().toString().c_str());
         } else {
             result = false;
         }
@@ -0,0 +1,1446 @@
+#include "parquet_reader.h"
+
+static uint32_t getLittleEndian32(const char *data) {
+    const unsigned char *p = (const unsigned char *)data;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t getLittleEndian64(const char *data) {
+    return getLittleEndian32(data) | ((uint64_t)getLittleEndian32(data + 4) << 32);
+}
+
+ThriftCompactReader::ThriftCompactReader(const char *data, uint64_t len)
+    : data(data), len(len), pos(0), lastFieldId(0) {
+}
+
+uint8_t ThriftCompactReader::readByte() {
+    S3_CHECK_OR_DIE(this->pos < this->len, S3RuntimeError, "Parquet metadata is truncated");
+    return (uint8_t)this->data[this->pos++];
+}
+
+uint64_t ThriftCompactReader::readVarint() {
+    uint64_t value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = this->readByte();
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    S3_DIE(S3RuntimeError, "Parquet metadata has an invalid varint");
+}
+
+int64_t ThriftCompactReader::readZigzag() {
+    uint64_t value = this->readVarint();
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+void ThriftCompactReader::readStructBegin() {
+    // malformed data should not exhaust the stack.
+    S3_CHECK_OR_DIE(this->lastFieldIds.size() < 64, S3RuntimeError,
+                    "Parquet metadata is nested too deep");
+
+    this->lastFieldIds.push_back(this->lastFieldId);
+    this->lastFieldId = 0;
+}
+
+void ThriftCompactReader::readStructEnd() {
+    this->lastFieldId = this->lastFieldIds.back();
+    this->lastFieldIds.pop_back();
+}
+
+bool ThriftCompactReader::readFieldBegin(int16_t *id, uint8_t *type) {
+    uint8_t byte = this->readByte();
+    if (byte == THRIFT_STOP) {
+        return false;
+    }
+
+    // field id is a delta to the last one in the high 4 bits, or follows as zigzag varint.
+    *type = byte & 0x0f;
+    uint8_t delta = byte >> 4;
+    *id = delta ? this->lastFieldId + delta : (int16_t)this->readZigzag();
+    this->lastFieldId = *id;
+
+    return true;
+}
+
+bool ThriftCompactReader::readBool(uint8_t type) {
+    return type == THRIFT_BOOL_TRUE;
+}
+
+int32_t ThriftCompactReader::readI32() {
+    return (int32_t)this->readZigzag();
+}
+
+int64_t ThriftCompactReader::readI64() {
+    return this->readZigzag();
+}
+
+double ThriftCompactReader::readDouble() {
+    S3_CHECK_OR_DIE(this->len - this->pos >= sizeof(double), S3RuntimeError,
+                    "Parquet metadata is truncated");
+
+    uint64_t bits = getLittleEndian64(this->data + this->pos);
+    this->pos += sizeof(double);
+
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+string ThriftCompactReader::readBinary() {
+    uint64_t size = this->readVarint();
+    S3_CHECK_OR_DIE(size <= this->len - this->pos, S3RuntimeError,
+                    "Parquet metadata is truncated");
+
+    string value(this->data + this->pos, size);
+    this->pos += size;
+    return value;
+}
+
+uint64_t ThriftCompactReader::readListBegin(uint8_t *elemType) {
+    uint8_t byte = this->readByte();
+    uint64_t size = byte >> 4;
+    *elemType = byte & 0x0f;
+    if (size == 15) {
+        size = this->readVarint();
+    }
+
+    // each element takes one byte at least.
+    S3_CHECK_OR_DIE(size <= this->len - this->pos, S3RuntimeError,
+                    "Parquet metadata is truncated");
+    return size;
+}
+
+void ThriftCompactReader::skip(uint8_t type) {
+    switch (type) {
+        case THRIFT_BOOL_TRUE:
+        case THRIFT_BOOL_FALSE:
+            // value of bool field is in the field header.
+            break;
+        case THRIFT_BYTE:
+            this->readByte();
+            break;
+        case THRIFT_I16:
+        case THRIFT_I32:
+        case THRIFT_I64:
+            this->readVarint();
+            break;
+        case THRIFT_DOUBLE:
+            this->readDouble();
+            break;
+        case THRIFT_BINARY:
+            this->readBinary();
+            break;
+        case THRIFT_LIST:
+        case THRIFT_SET: {
+            uint8_t elemType;
+            uint64_t size = this->readListBegin(&elemType);
+            for (uint64_t i = 0; i < size; i++) {
+                // bool elements take one byte each.
+                if (elemType == THRIFT_BOOL_TRUE || elemType == THRIFT_BOOL_FALSE) {
+                    this->readByte();
+                } else {
+                    this->skip(elemType);
+                }
+            }
+            break;
+        }
+        case THRIFT_MAP: {
+            uint64_t size = this->readVarint();
+            if (size == 0) {
+                break;
+            }
+
+            uint8_t types = this->readByte();
+            for (uint64_t i = 0; i < size; i++) {
+                this->skip(types >> 4);
+                this->skip(types & 0x0f);
+            }
+            break;
+        }
+        case THRIFT_STRUCT: {
+            int16_t id;
+            uint8_t fieldType;
+            this->readStructBegin();
+            while (this->readFieldBegin(&id, &fieldType)) {
+                this->skip(fieldType);
+            }
+            this->readStructEnd();
+            break;
+        }
+        default:
+            S3_DIE(S3RuntimeError, "Parquet metadata has an invalid field type");
+    }
+}
+
+uint64_t ParquetColumnChunk::getStartOffset() const {
+    if ((this->dictionaryPageOffset > 0) && (this->dictionaryPageOffset < this->dataPageOffset)) {
+        return this->dictionaryPageOffset;
+    }
+
+    return this->dataPageOffset;
+}
+
+// Schema elements, the first one is the root of the others.
+struct ParquetSchemaElement {
+    ParquetSchemaElement() : hasType(false), numChildren(0) {
+    }
+
+    ParquetColumnSchema column;
+    bool hasType;
+    int32_t numChildren;
+};
+
+static void parseSchemaElement(ThriftCompactReader &reader, ParquetSchemaElement &element) {
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            element.column.type = (ParquetType)reader.readI32();
+            element.hasType = true;
+        } else if (id == 2 && type == THRIFT_I32) {
+            element.column.typeLength = reader.readI32();
+        } else if (id == 3 && type == THRIFT_I32) {
+            element.column.repetition = (ParquetRepetition)reader.readI32();
+        } else if (id == 4 && type == THRIFT_BINARY) {
+            element.column.name = reader.readBinary();
+        } else if (id == 5 && type == THRIFT_I32) {
+            element.numChildren = reader.readI32();
+        } else if (id == 6 && type == THRIFT_I32) {
+            element.column.convertedType = reader.readI32();
+        } else if (id == 7 && type == THRIFT_I32) {
+            element.column.scale = reader.readI32();
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+static void parseStatistics(ThriftCompactReader &reader, ParquetStatistics &stats) {
+    int16_t id;
+    uint8_t type;
+
+    // min_value and max_value are in the sort order of the logical type, min and max are
+    // deprecated ones in signed order of the physical type.
+    bool hasMinValue = false;
+    bool hasMaxValue = false;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_BINARY) {
+            string value = reader.readBinary();
+            if (!hasMaxValue) {
+                stats.max = value;
+                stats.hasMax = true;
+                stats.legacy = true;
+            }
+        } else if (id == 2 && type == THRIFT_BINARY) {
+            string value = reader.readBinary();
+            if (!hasMinValue) {
+                stats.min = value;
+                stats.hasMin = true;
+                stats.legacy = true;
+            }
+        } else if (id == 3 && type == THRIFT_I64) {
+            stats.nullCount = reader.readI64();
+            stats.hasNullCount = true;
+        } else if (id == 5 && type == THRIFT_BINARY) {
+            stats.max = reader.readBinary();
+            stats.hasMax = true;
+            hasMaxValue = true;
+        } else if (id == 6 && type == THRIFT_BINARY) {
+            stats.min = reader.readBinary();
+            stats.hasMin = true;
+            hasMinValue = true;
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+
+    // don't mix the legacy and the new one.
+    if (hasMinValue || hasMaxValue) {
+        stats.hasMin = hasMinValue;
+        stats.hasMax = hasMaxValue;
+        stats.legacy = false;
+    }
+}
+
+static void parseColumnMetaData(ThriftCompactReader &reader, ParquetColumnChunk &chunk) {
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 4 && type == THRIFT_I32) {
+            chunk.codec = reader.readI32();
+        } else if (id == 5 && type == THRIFT_I64) {
+            chunk.numValues = reader.readI64();
+        } else if (id == 7 && type == THRIFT_I64) {
+            chunk.totalCompressedSize = reader.readI64();
+        } else if (id == 9 && type == THRIFT_I64) {
+            chunk.dataPageOffset = reader.readI64();
+        } else if (id == 11 && type == THRIFT_I64) {
+            chunk.dictionaryPageOffset = reader.readI64();
+        } else if (id == 12 && type == THRIFT_STRUCT) {
+            parseStatistics(reader, chunk.stats);
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+static void parseColumnChunk(ThriftCompactReader &reader, ParquetColumnChunk &chunk) {
+    int16_t id;
+    uint8_t type;
+    bool hasMetaData = false;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_BINARY) {
+            S3_CHECK_OR_DIE(reader.readBinary().empty(), S3RuntimeError,
+                            "Parquet column chunks in other files are not supported");
+        } else if (id == 3 && type == THRIFT_STRUCT) {
+            parseColumnMetaData(reader, chunk);
+            hasMetaData = true;
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+
+    S3_CHECK_OR_DIE(hasMetaData, S3RuntimeError, "Parquet column chunk has no metadata");
+}
+
+static void parseRowGroup(ThriftCompactReader &reader, ParquetRowGroup &rowGroup) {
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size = reader.readListBegin(&elemType);
+            rowGroup.columns.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                parseColumnChunk(reader, rowGroup.columns[i]);
+            }
+        } else if (id == 3 && type == THRIFT_I64) {
+            rowGroup.numRows = reader.readI64();
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void ParseParquetFileMetaData(const char *data, uint64_t len, ParquetFileMetaData &meta) {
+    ThriftCompactReader reader(data, len);
+    vector<ParquetSchemaElement> schema;
+
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 2 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size = reader.readListBegin(&elemType);
+            schema.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                parseSchemaElement(reader, schema[i]);
+            }
+        } else if (id == 3 && type == THRIFT_I64) {
+            meta.numRows = reader.readI64();
+        } else if (id == 4 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size = reader.readListBegin(&elemType);
+            meta.rowGroups.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                parseRowGroup(reader, meta.rowGroups[i]);
+            }
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+
+    S3_CHECK_OR_DIE(!schema.empty(), S3RuntimeError, "Parquet file has no schema");
+
+    // only flat schema is supported, all children of root are primitive columns.
+    S3_CHECK_OR_DIE((uint64_t)schema[0].numChildren == schema.size() - 1, S3RuntimeError,
+                    "Nested Parquet schema is not supported");
+
+    meta.columns.clear();
+    for (uint64_t i = 1; i < schema.size(); i++) {
+        S3_CHECK_OR_DIE(schema[i].hasType && (schema[i].numChildren == 0) &&
+                            (schema[i].column.repetition != PARQUET_REPEATED),
+                        S3RuntimeError, "Nested Parquet schema is not supported");
+        meta.columns.push_back(schema[i].column);
+    }
+
+    for (uint64_t i = 0; i < meta.rowGroups.size(); i++) {
+        S3_CHECK_OR_DIE(meta.rowGroups[i].columns.size() == meta.columns.size(), S3RuntimeError,
+                        "Parquet row group doesn't match the schema");
+    }
+}
+
+static void parseDataPageHeader(ThriftCompactReader &reader, ParquetPageHeader &header) {
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            header.numValues = reader.readI32();
+        } else if (id == 2 && type == THRIFT_I32) {
+            header.encoding = reader.readI32();
+        } else if (id == 3 && type == THRIFT_I32) {
+            header.defLevelEncoding = reader.readI32();
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+static void parseDictionaryPageHeader(ThriftCompactReader &reader, ParquetPageHeader &header) {
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            header.numValues = reader.readI32();
+        } else if (id == 2 && type == THRIFT_I32) {
+            header.encoding = reader.readI32();
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+static void parseDataPageHeaderV2(ThriftCompactReader &reader, ParquetPageHeader &header) {
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            header.numValues = reader.readI32();
+        } else if (id == 4 && type == THRIFT_I32) {
+            header.encoding = reader.readI32();
+        } else if (id == 5 && type == THRIFT_I32) {
+            header.defLevelsLen = reader.readI32();
+        } else if (id == 6 && type == THRIFT_I32) {
+            header.repLevelsLen = reader.readI32();
+        } else if (id == 7 && (type == THRIFT_BOOL_TRUE || type == THRIFT_BOOL_FALSE)) {
+            header.isCompressed = reader.readBool(type);
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+uint64_t ParseParquetPageHeader(const char *data, uint64_t len, ParquetPageHeader &header) {
+    ThriftCompactReader reader(data, len);
+
+    int16_t id;
+    uint8_t type;
+
+    reader.readStructBegin();
+    while (reader.readFieldBegin(&id, &type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            header.type = reader.readI32();
+        } else if (id == 2 && type == THRIFT_I32) {
+            header.uncompressedSize = reader.readI32();
+        } else if (id == 3 && type == THRIFT_I32) {
+            header.compressedSize = reader.readI32();
+        } else if (id == 5 && type == THRIFT_STRUCT) {
+            parseDataPageHeader(reader, header);
+        } else if (id == 7 && type == THRIFT_STRUCT) {
+            parseDictionaryPageHeader(reader, header);
+        } else if (id == 8 && type == THRIFT_STRUCT) {
+            parseDataPageHeaderV2(reader, header);
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+
+    S3_CHECK_OR_DIE((header.compressedSize >= 0) && (header.uncompressedSize >= 0) &&
+                        (header.numValues >= 0) && (header.defLevelsLen >= 0) &&
+                        (header.repLevelsLen >= 0),
+                    S3RuntimeError, "Parquet page header is invalid");
+
+    return reader.getPosition();
+}
+
+// Raw snappy block: uncompressed length in varint, then literals and back references.
+static void snappyUncompress(const char *in, uint64_t inLen, char *out, uint64_t outLen) {
+    const unsigned char *p = (const unsigned char *)in;
+    uint64_t pos = 0;
+
+    uint64_t length = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7) {
+        S3_CHECK_OR_DIE(pos < inLen, S3RuntimeError, "Failed to decompress data: snappy");
+        length |= (uint64_t)(p[pos] & 0x7f) << shift;
+        if ((p[pos++] & 0x80) == 0) {
+            break;
+        }
+    }
+    S3_CHECK_OR_DIE(length == outLen, S3RuntimeError, "Failed to decompress data: snappy");
+
+    uint64_t outPos = 0;
+    while (pos < inLen) {
+        uint8_t tag = p[pos++];
+        uint64_t len = 0;
+        uint64_t offset = 0;
+
+        switch (tag & 3) {
+            case 0: {  // literal
+                len = (tag >> 2) + 1;
+                if (len > 60) {
+                    uint64_t bytes = len - 60;
+                    S3_CHECK_OR_DIE(inLen - pos >= bytes, S3RuntimeError,
+                                    "Failed to decompress data: snappy");
+                    len = 0;
+                    for (uint64_t i = 0; i < bytes; i++) {
+                        len |= (uint64_t)p[pos++] << (8 * i);
+                    }
+                    len++;
+                }
+
+                S3_CHECK_OR_DIE((inLen - pos >= len) && (outLen - outPos >= len), S3RuntimeError,
+                                "Failed to decompress data: snappy");
+                memcpy(out + outPos, p + pos, len);
+                pos += len;
+                outPos += len;
+                continue;
+            }
+            case 1:
+                S3_CHECK_OR_DIE(inLen - pos >= 1, S3RuntimeError,
+                                "Failed to decompress data: snappy");
+                len = ((tag >> 2) & 7) + 4;
+                offset = ((uint64_t)(tag >> 5) << 8) | p[pos];
+                pos += 1;
+                break;
+            case 2:
+                S3_CHECK_OR_DIE(inLen - pos >= 2, S3RuntimeError,
+                                "Failed to decompress data: snappy");
+                len = (tag >> 2) + 1;
+                offset = p[pos] | (p[pos + 1] << 8);
+                pos += 2;
+                break;
+            default:
+                S3_CHECK_OR_DIE(inLen - pos >= 4, S3RuntimeError,
+                                "Failed to decompress data: snappy");
+                len = (tag >> 2) + 1;
+                offset = getLittleEndian32(in + pos);
+                pos += 4;
+                break;
+        }
+
+        S3_CHECK_OR_DIE((offset > 0) && (offset <= outPos) && (outLen - outPos >= len),
+                        S3RuntimeError, "Failed to decompress data: snappy");
+
+        // source and destination might overlap, copy byte by byte.
+        for (uint64_t i = 0; i < len; i++) {
+            out[outPos + i] = out[outPos - offset + i];
+        }
+        outPos += len;
+    }
+
+    S3_CHECK_OR_DIE(outPos == outLen, S3RuntimeError, "Failed to decompress data: snappy");
+}
+
+static void gzipUncompress(const char *in, uint64_t inLen, char *out, uint64_t outLen) {
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    zstream.next_in = (Byte *)in;
+    zstream.avail_in = inLen;
+
+    // automatic detection of gzip and zlib header.
+    int ret = inflateInit2(&zstream, MAX_WBITS + 32);
+    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+
+    // an empty page still needs a valid output pointer.
+    char dummy;
+    zstream.next_out = (Byte *)(outLen ? out : &dummy);
+    zstream.avail_out = outLen;
+
+    ret = inflate(&zstream, Z_FINISH);
+    uint64_t availOut = zstream.avail_out;
+    inflateEnd(&zstream);
+
+    S3_CHECK_OR_DIE((ret == Z_STREAM_END) && (availOut == 0), S3RuntimeError,
+                    string("Failed to decompress data: ") + std::to_string((long long)ret));
+}
+
+void DecompressParquetPage(int32_t codec, const char *in, uint64_t inLen, char *out,
+                           uint64_t outLen) {
+    switch (codec) {
+        case PARQUET_UNCOMPRESSED:
+            S3_CHECK_OR_DIE(inLen == outLen, S3RuntimeError, "Parquet page size mismatch");
+            if (outLen != 0) {
+                memcpy(out, in, outLen);
+            }
+            break;
+        case PARQUET_SNAPPY:
+            snappyUncompress(in, inLen, out, outLen);
+            break;
+        case PARQUET_GZIP:
+            gzipUncompress(in, inLen, out, outLen);
+            break;
+#ifdef USE_ZSTD
+        case PARQUET_ZSTD: {
+            size_t ret = ZSTD_decompress(out, outLen, in, inLen);
+            S3_CHECK_OR_DIE(!ZSTD_isError(ret) && (ret == outLen), S3RuntimeError,
+                            string("Failed to decompress data: ") +
+                                (ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "size mismatch"));
+            break;
+        }
+#endif
+        default:
+            S3_DIE(S3RuntimeError, "Parquet compression codec " +
+                                       std::to_string((long long)codec) + " is not supported");
+    }
+}
+
+ParquetRleDecoder::ParquetRleDecoder(const char *data, uint64_t len, uint32_t bitWidth)
+    : data(data),
+      len(len),
+      pos(0),
+      bitWidth(bitWidth),
+      rleLeft(0),
+      rleValue(0),
+      packedLeft(0),
+      packedBitPos(0) {
+    S3_CHECK_OR_DIE(bitWidth <= 32, S3RuntimeError, "Parquet RLE bit width is invalid");
+}
+
+bool ParquetRleDecoder::readHeader() {
+    while (this->rleLeft == 0 && this->packedLeft == 0) {
+        if (this->pos >= this->len) {
+            return false;
+        }
+
+        uint64_t header = 0;
+        for (uint32_t shift = 0;; shift += 7) {
+            S3_CHECK_OR_DIE((this->pos < this->len) && (shift < 64), S3RuntimeError,
+                            "Parquet RLE data is truncated");
+            uint8_t byte = this->data[this->pos++];
+            header |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        if (header & 1) {
+            // groups of 8 values packed in bitWidth bytes.
+            uint64_t groups = header >> 1;
+            this->packedLeft = groups * 8;
+            this->packedBitPos = this->pos * 8;
+            this->pos += groups * this->bitWidth;
+        } else {
+            uint64_t bytes = (this->bitWidth + 7) / 8;
+            S3_CHECK_OR_DIE(this->len - this->pos >= bytes, S3RuntimeError,
+                            "Parquet RLE data is truncated");
+
+            this->rleLeft = header >> 1;
+            this->rleValue = 0;
+            for (uint64_t i = 0; i < bytes; i++) {
+                this->rleValue |= (uint32_t)(uint8_t)this->data[this->pos++] << (8 * i);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ParquetRleDecoder::next(uint32_t *value) {
+    if (!this->readHeader()) {
+        return false;
+    }
+
+    if (this->rleLeft > 0) {
+        this->rleLeft--;
+        *value = this->rleValue;
+        return true;
+    }
+
+    // the last group might be cut short by writers.
+    if (this->packedBitPos + this->bitWidth > this->len * 8) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (uint32_t i = 0; i < this->bitWidth; i++) {
+        uint64_t bit = this->packedBitPos + i;
+        result |= (uint64_t)((this->data[bit / 8] >> (bit % 8)) & 1) << i;
+    }
+
+    this->packedBitPos += this->bitWidth;
+    this->packedLeft--;
+
+    *value = (uint32_t)result;
+    return true;
+}
+
+static string formatDecimal(__int128 unscaled, int32_t scale) {
+    bool negative = unscaled < 0;
+    unsigned __int128 value = negative ? -(unsigned __int128)unscaled : unscaled;
+
+    string digits;
+    do {
+        digits.insert(digits.begin(), '0' + (char)(value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    if (scale > 0) {
+        if (digits.size() <= (uint64_t)scale) {
+            digits.insert(0, scale + 1 - digits.size(), '0');
+        }
+        digits.insert(digits.size() - scale, ".");
+    }
+
+    return negative ? "-" + digits : digits;
+}
+
+static int64_t floorDiv(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+// days since 1970-01-01 to year, month and day in proleptic Gregorian calendar.
+static string formatDate(int64_t days) {
+    int64_t z = days + 719468;
+    int64_t era = floorDiv(z, 146097);
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    int64_t year = yoe + era * 400 + (month <= 2);
+
+    // room for any year, the month and the day fit in an int
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%04" PRId64 "-%02d-%02d", year, (int)month, (int)day);
+    return buf;
+}
+
+// microseconds since 1970-01-01 00:00:00 UTC.
+static string formatTimestamp(int64_t micros) {
+    const int64_t microsPerDay = 86400LL * 1000000;
+    int64_t days = floorDiv(micros, microsPerDay);
+    int64_t rest = micros - days * microsPerDay;
+
+    char buf[48];
+    snprintf(buf, sizeof(buf), " %02d:%02d:%02d", (int)(rest / 3600000000LL),
+             (int)(rest / 60000000 % 60), (int)(rest / 1000000 % 60));
+
+    string result = formatDate(days) + buf;
+    if (rest % 1000000 != 0) {
+        snprintf(buf, sizeof(buf), ".%06d", (int)(rest % 1000000));
+        result += buf;
+    }
+
+    return result;
+}
+
+static string formatDouble(double value, int precision) {
+    if (std::isnan(value)) {
+        return "NaN";
+    } else if (std::isinf(value)) {
+        return value > 0 ? "Infinity" : "-Infinity";
+    }
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*g", precision, value);
+    return buf;
+}
+
+static bool isUnsigned(int32_t convertedType) {
+    // UINT_8, UINT_16, UINT_32 and UINT_64
+    return convertedType >= 11 && convertedType <= 14;
+}
+
+string FormatParquetValue(const ParquetColumnSchema &column, const char *data, uint64_t len) {
+    switch (column.type) {
+        case PARQUET_BOOLEAN:
+            return (data[0] & 1) ? "true" : "false";
+        case PARQUET_INT32: {
+            int32_t value = (int32_t)getLittleEndian32(data);
+            if (column.convertedType == PARQUET_CONVERTED_DATE) {
+                return formatDate(value);
+            } else if (column.convertedType == PARQUET_CONVERTED_DECIMAL) {
+                return formatDecimal(value, column.scale);
+            } else if (isUnsigned(column.convertedType)) {
+                return std::to_string((unsigned long long)(uint32_t)value);
+            }
+            return std::to_string((long long)value);
+        }
+        case PARQUET_INT64: {
+            int64_t value = (int64_t)getLittleEndian64(data);
+            if (column.convertedType == PARQUET_CONVERTED_TIMESTAMP_MILLIS) {
+                return formatTimestamp(value * 1000);
+            } else if (column.convertedType == PARQUET_CONVERTED_TIMESTAMP_MICROS) {
+                return formatTimestamp(value);
+            } else if (column.convertedType == PARQUET_CONVERTED_DECIMAL) {
+                return formatDecimal(value, column.scale);
+            } else if (isUnsigned(column.convertedType)) {
+                return std::to_string((unsigned long long)value);
+            }
+            return std::to_string((long long)value);
+        }
+        case PARQUET_INT96: {
+            // nanoseconds of the day, then Julian day number.
+            int64_t nanos = (int64_t)getLittleEndian64(data);
+            int64_t julianDay = getLittleEndian32(data + 8);
+            return formatTimestamp((julianDay - 2440588) * 86400LL * 1000000 + nanos / 1000);
+        }
+        case PARQUET_FLOAT: {
+            uint32_t bits = getLittleEndian32(data);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return formatDouble(value, 9);
+        }
+        case PARQUET_DOUBLE: {
+            uint64_t bits = getLittleEndian64(data);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return formatDouble(value, 17);
+        }
+        case PARQUET_FIXED_LEN_BYTE_ARRAY:
+            // big-endian two's complement.
+            if ((column.convertedType == PARQUET_CONVERTED_DECIMAL) && (len > 0) && (len <= 16)) {
+                __int128 value = (signed char)data[0];
+                for (uint64_t i = 1; i < len; i++) {
+                    value = value * 256 + (uint8_t)data[i];
+                }
+                return formatDecimal(value, column.scale);
+            }
+            return string(data, len);
+        case PARQUET_BYTE_ARRAY:
+        default:
+            return string(data, len);
+    }
+}
+
+static uint64_t getPlainValueSize(const ParquetColumnSchema &column) {
+    switch (column.type) {
+        case PARQUET_INT32:
+        case PARQUET_FLOAT:
+            return 4;
+        case PARQUET_INT64:
+        case PARQUET_DOUBLE:
+            return 8;
+        case PARQUET_INT96:
+            return 12;
+        case PARQUET_FIXED_LEN_BYTE_ARRAY:
+            return column.typeLength;
+        default:
+            return 0;
+    }
+}
+
+uint64_t DecodeParquetPlainValues(const ParquetColumnSchema &column, const char *data,
+                                  uint64_t len, uint64_t count, vector<string> &values) {
+    uint64_t pos = 0;
+
+    if (column.type == PARQUET_BOOLEAN) {
+        // bit-packed, the least significant bit first.
+        S3_CHECK_OR_DIE((count + 7) / 8 <= len, S3RuntimeError, "Parquet page is truncated");
+        for (uint64_t i = 0; i < count; i++) {
+            char bit = (data[i / 8] >> (i % 8)) & 1;
+            values.push_back(FormatParquetValue(column, &bit, 1));
+        }
+        return (count + 7) / 8;
+    }
+
+    if (column.type == PARQUET_BYTE_ARRAY) {
+        for (uint64_t i = 0; i < count; i++) {
+            S3_CHECK_OR_DIE(len - pos >= 4, S3RuntimeError, "Parquet page is truncated");
+            uint64_t size = getLittleEndian32(data + pos);
+            pos += 4;
+
+            S3_CHECK_OR_DIE(len - pos >= size, S3RuntimeError, "Parquet page is truncated");
+            values.push_back(FormatParquetValue(column, data + pos, size));
+            pos += size;
+        }
+        return pos;
+    }
+
+    uint64_t size = getPlainValueSize(column);
+    S3_CHECK_OR_DIE(size > 0, S3RuntimeError, "Parquet type is not supported");
+    S3_CHECK_OR_DIE(count <= len / size, S3RuntimeError, "Parquet page is truncated");
+
+    for (uint64_t i = 0; i < count; i++) {
+        values.push_back(FormatParquetValue(column, data + pos, size));
+        pos += size;
+    }
+
+    return pos;
+}
+
+// Decode values of a data page, defined[i] tells whether the i-th value is not null.
+static void decodePageValues(const ParquetColumnSchema &column, int32_t encoding, const char *data,
+                             uint64_t len, const vector<bool> &defined, uint64_t numDefined,
+                             const vector<string> &dictionary, vector<string> &values,
+                             vector<bool> &nulls) {
+    vector<string> pageValues;
+    pageValues.reserve(numDefined);
+
+    if (encoding == PARQUET_PLAIN) {
+        DecodeParquetPlainValues(column, data, len, numDefined, pageValues);
+    } else if (encoding == PARQUET_PLAIN_DICTIONARY || encoding == PARQUET_RLE_DICTIONARY) {
+        S3_CHECK_OR_DIE(len >= 1 || numDefined == 0, S3RuntimeError, "Parquet page is truncated");
+
+        ParquetRleDecoder decoder(data + 1, len ? len - 1 : 0, len ? (uint8_t)data[0] : 0);
+        for (uint64_t i = 0; i < numDefined; i++) {
+            uint32_t index;
+            S3_CHECK_OR_DIE(decoder.next(&index) && (index < dictionary.size()), S3RuntimeError,
+                            "Parquet dictionary index is invalid");
+            pageValues.push_back(dictionary[index]);
+        }
+    } else {
+        S3_DIE(S3RuntimeError, "Parquet encoding " + std::to_string((long long)encoding) +
+                                   " is not supported");
+    }
+
+    uint64_t next = 0;
+    for (uint64_t i = 0; i < defined.size(); i++) {
+        if (defined[i]) {
+            values.push_back(std::move(pageValues[next++]));
+            nulls.push_back(false);
+        } else {
+            values.push_back(string());
+            nulls.push_back(true);
+        }
+    }
+}
+
+// Definition levels of a flat column are 0 (null) or 1, return number of non-null values.
+static uint64_t decodeDefinitionLevels(const char *data, uint64_t len, uint64_t numValues,
+                                       vector<bool> &defined) {
+    ParquetRleDecoder decoder(data, len, 1);
+    uint64_t numDefined = 0;
+
+    defined.resize(numValues);
+    for (uint64_t i = 0; i < numValues; i++) {
+        uint32_t level;
+        S3_CHECK_OR_DIE(decoder.next(&level), S3RuntimeError,
+                        "Parquet definition levels are truncated");
+        defined[i] = level != 0;
+        numDefined += defined[i];
+    }
+
+    return numDefined;
+}
+
+void DecodeParquetColumnChunk(const ParquetColumnSchema &column, const ParquetColumnChunk &chunk,
+                              const char *data, uint64_t len, vector<string> &values,
+                              vector<bool> &nulls) {
+    bool optional = column.repetition == PARQUET_OPTIONAL;
+    vector<string> dictionary;
+    vector<char> page;
+
+    values.clear();
+    nulls.clear();
+
+    uint64_t pos = 0;
+    while ((pos < len) && ((int64_t)values.size() < chunk.numValues)) {
+        ParquetPageHeader header;
+        pos += ParseParquetPageHeader(data + pos, len - pos, header);
+
+        S3_CHECK_OR_DIE((uint64_t)header.compressedSize <= len - pos, S3RuntimeError,
+                        "Parquet page is truncated");
+        const char *payload = data + pos;
+        pos += header.compressedSize;
+
+        if (header.type == PARQUET_DICTIONARY_PAGE) {
+            page.resize(header.uncompressedSize);
+            DecompressParquetPage(chunk.codec, payload, header.compressedSize, page.data(),
+                                  page.size());
+
+            dictionary.clear();
+            DecodeParquetPlainValues(column, page.data(), page.size(), header.numValues,
+                                     dictionary);
+        } else if (header.type == PARQUET_DATA_PAGE) {
+            page.resize(header.uncompressedSize);
+            DecompressParquetPage(chunk.codec, payload, header.compressedSize, page.data(),
+                                  page.size());
+
+            // no repetition levels in flat schema, definition levels are prefixed by length.
+            const char *valuesData = page.data();
+            uint64_t valuesLen = page.size();
+
+            vector<bool> defined;
+            uint64_t numDefined = header.numValues;
+            if (optional) {
+                S3_CHECK_OR_DIE(header.defLevelEncoding == PARQUET_RLE, S3RuntimeError,
+                                "Parquet definition level encoding is not supported");
+                S3_CHECK_OR_DIE(valuesLen >= 4, S3RuntimeError, "Parquet page is truncated");
+
+                uint64_t levelsLen = getLittleEndian32(valuesData);
+                S3_CHECK_OR_DIE(levelsLen <= valuesLen - 4, S3RuntimeError,
+                                "Parquet page is truncated");
+
+                numDefined =
+                    decodeDefinitionLevels(valuesData + 4, levelsLen, header.numValues, defined);
+                valuesData += 4 + levelsLen;
+                valuesLen -= 4 + levelsLen;
+            } else {
+                defined.assign(header.numValues, true);
+            }
+
+            decodePageValues(column, header.encoding, valuesData, valuesLen, defined, numDefined,
+                             dictionary, values, nulls);
+        } else if (header.type == PARQUET_DATA_PAGE_V2) {
+            // levels are not compressed and have no length prefix.
+            uint64_t levelsLen = (uint64_t)header.repLevelsLen + header.defLevelsLen;
+            S3_CHECK_OR_DIE((levelsLen <= (uint64_t)header.compressedSize) &&
+                                (levelsLen <= (uint64_t)header.uncompressedSize),
+                            S3RuntimeError, "Parquet page is truncated");
+
+            vector<bool> defined;
+            uint64_t numDefined = header.numValues;
+            if (optional) {
+                numDefined = decodeDefinitionLevels(payload + header.repLevelsLen,
+                                                    header.defLevelsLen, header.numValues,
+                                                    defined);
+            } else {
+                defined.assign(header.numValues, true);
+            }
+
+            const char *valuesData = payload + levelsLen;
+            uint64_t valuesLen = header.compressedSize - levelsLen;
+            if (header.isCompressed) {
+                page.resize(header.uncompressedSize - levelsLen);
+                DecompressParquetPage(chunk.codec, valuesData, valuesLen, page.data(),
+                                      page.size());
+                valuesData = page.data();
+                valuesLen = page.size();
+            }
+
+            decodePageValues(column, header.encoding, valuesData, valuesLen, defined, numDefined,
+                             dictionary, values, nulls);
+        }
+        // index pages and unknown pages are skipped.
+    }
+
+    S3_CHECK_OR_DIE((int64_t)values.size() == chunk.numValues, S3RuntimeError,
+                    "Parquet column chunk is truncated");
+}
+
+// Decode plain encoded statistics of numeric columns, return false if not comparable as numbers.
+static bool getNumericStat(const ParquetColumnSchema &column, const string &stat,
+                           long double *value) {
+    bool isInteger = (column.convertedType == PARQUET_CONVERTED_NONE) ||
+                     (column.convertedType >= 11 && column.convertedType <= 18);
+
+    if (column.type == PARQUET_INT32 && isInteger && stat.size() == 4) {
+        uint32_t bits = getLittleEndian32(stat.data());
+        *value = isUnsigned(column.convertedType) ? (long double)bits
+                                                  : (long double)(int32_t)bits;
+    } else if (column.type == PARQUET_INT64 && isInteger && stat.size() == 8) {
+        uint64_t bits = getLittleEndian64(stat.data());
+        *value = isUnsigned(column.convertedType) ? (long double)bits
+                                                  : (long double)(int64_t)bits;
+    } else if (column.type == PARQUET_FLOAT && stat.size() == 4) {
+        uint32_t bits = getLittleEndian32(stat.data());
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        *value = f;
+    } else if (column.type == PARQUET_DOUBLE && stat.size() == 8) {
+        uint64_t bits = getLittleEndian64(stat.data());
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        *value = d;
+    } else {
+        return false;
+    }
+
+    return !std::isnan(*value);
+}
+
+static bool parseNumber(const string &text, long double *value) {
+    const char *begin = text.c_str();
+    char *end = NULL;
+
+    errno = 0;
+    *value = strtold(begin, &end);
+    if ((end == begin) || (errno != 0) || std::isnan(*value)) {
+        return false;
+    }
+
+    while (isspace(*end)) {
+        end++;
+    }
+    return *end == '\0';
+}
+
+// Return false if no value in [min, max] satisfies "value op qual".
+template <typename T>
+static bool rangeMayMatch(const T &min, const T &max, S3QualOp op, const T &qual) {
+    switch (op) {
+        case S3_QUAL_EQ:
+            return !(qual < min) && !(max < qual);
+        case S3_QUAL_LT:
+            return min < qual;
+        case S3_QUAL_LE:
+            return !(qual < min);
+        case S3_QUAL_GT:
+            return qual < max;
+        case S3_QUAL_GE:
+            return !(max < qual);
+        default:
+            return true;
+    }
+}
+
+bool ParquetRowGroupMayMatch(const ParquetFileMetaData &meta, const ParquetRowGroup &rowGroup,
+                             const vector<int64_t> &columnIndexes, const vector<S3ScanQual> &quals) {
+    for (uint64_t i = 0; i < quals.size(); i++) {
+        const S3ScanQual &qual = quals[i];
+        if (qual.column >= columnIndexes.size()) {
+            continue;
+        }
+
+        // comparison with NULL is never true.
+        int64_t index = columnIndexes[qual.column];
+        if (index < 0) {
+            return false;
+        }
+
+        const ParquetColumnSchema &column = meta.columns[index];
+        const ParquetStatistics &stats = rowGroup.columns[index].stats;
+
+        if (stats.hasNullCount && (stats.nullCount >= rowGroup.numRows)) {
+            return false;
+        }
+
+        if (!stats.hasMin || !stats.hasMax) {
+            continue;
+        }
+
+        long double min, max, value;
+        if (qual.numeric) {
+            if (getNumericStat(column, stats.min, &min) &&
+                getNumericStat(column, stats.max, &max) &&
+                (!stats.legacy || !isUnsigned(column.convertedType)) &&
+                parseNumber(qual.value, &value) && !rangeMayMatch(min, max, qual.op, value)) {
+                return false;
+            }
+        } else if ((column.type == PARQUET_BYTE_ARRAY) && !stats.legacy &&
+                   ((column.convertedType == PARQUET_CONVERTED_NONE) ||
+                    (column.convertedType == PARQUET_CONVERTED_UTF8))) {
+            // strings are ordered by bytes in statistics, only equality doesn't depend on
+            // collation.
+            if ((qual.op == S3_QUAL_EQ) &&
+                !rangeMayMatch(stats.min, stats.max, qual.op, qual.value)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ParquetReader::open(const S3Params &params) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+
+    this->s3Url = params.getS3Url();
+    this->keySize = params.getKeySize();
+    this->rangeStart = params.getKeyRangeStart();
+    this->rangeEnd = params.getKeyRangeEnd();
+    if (this->rangeEnd == 0 || this->rangeEnd > this->keySize) {
+        this->rangeEnd = this->keySize;
+    }
+    this->scanDesc = params.getScanDesc();
+
+    this->coalesced = (params.getRangeCoalesceGap() > 0);
+    this->fetcher.reset(this->s3Interface, this->s3Url, params.getRangeCoalesceGap());
+
+    this->readMetaData();
+    this->mapColumns();
+
+    this->nextRowGroup = 0;
+    this->numRows = 0;
+    this->nextRow = 0;
+    this->out.clear();
+    this->outOffset = 0;
+
+    // header line is expected by S3BucketReader, which skips it. Ranges after the first one of a
+    // key don't have it.
+    if (hasHeader && (this->rangeStart == 0)) {
+        for (uint64_t i = 0; i < this->outputNames.size(); i++) {
+            if (i > 0) {
+                this->out.push_back(this->scanDesc.delimiter);
+            }
+            this->appendValue(this->outputNames[i]);
+        }
+        this->out.append(eolString);
+    }
+}
+
+void ParquetReader::readMetaData() {
+    S3_CHECK_OR_DIE(this->keySize >= S3_PARQUET_MAGIC_LEN + S3_PARQUET_FOOTER_LEN, S3RuntimeError,
+                    "Invalid Parquet file");
+
+    // the size is known from the listing, so the metadata is read along with the footer.
+    uint64_t tailLen = S3_PARQUET_FOOTER_LEN;
+    if (this->coalesced) {
+        tailLen = std::min(this->keySize, (uint64_t)S3_PARQUET_FOOTER_PREFETCH_LEN);
+    }
+
+    vector<std::pair<uint64_t, uint64_t> > tail;
+    tail.push_back(std::make_pair(this->keySize - tailLen, tailLen));
+    this->fetcher.plan(tail);
+
+    const char *footer = (const char *)this->fetcher.fetch(this->keySize - S3_PARQUET_FOOTER_LEN,
+                                                           S3_PARQUET_FOOTER_LEN);
+    S3_CHECK_OR_DIE(memcmp(footer + 4, S3_PARQUET_MAGIC, S3_PARQUET_MAGIC_LEN) == 0,
+                    S3RuntimeError, "Invalid Parquet file");
+
+    uint64_t metaLen = getLittleEndian32(footer);
+    S3_CHECK_OR_DIE(metaLen <= this->keySize - S3_PARQUET_MAGIC_LEN - S3_PARQUET_FOOTER_LEN,
+                    S3RuntimeError, "Invalid Parquet file");
+
+    const char *metaData = (const char *)this->fetcher.fetch(
+        this->keySize - S3_PARQUET_FOOTER_LEN - metaLen, metaLen);
+
+    this->meta = ParquetFileMetaData();
+    ParseParquetFileMetaData(metaData, metaLen, this->meta);
+
+    S3DEBUG("Parquet file has %" PRIu64 " columns, %" PRIu64 " row groups",
+            (uint64_t)this->meta.columns.size(), (uint64_t)this->meta.rowGroups.size());
+}
+
+void ParquetReader::mapColumns() {
+    this->outputColumns.clear();
+    this->outputNames.clear();
+    this->qualColumns.clear();
+
+    // no table definition, output every column of the file.
+    if (this->scanDesc.columns.empty()) {
+        for (uint64_t i = 0; i < this->meta.columns.size(); i++) {
+            this->outputColumns.push_back(i);
+            this->outputNames.push_back(this->meta.columns[i].name);
+        }
+        return;
+    }
+
+    // unquoted identifiers are folded to lower case, match names case-insensitively.
+    for (uint64_t i = 0; i < this->scanDesc.columns.size(); i++) {
+        const string &name = this->scanDesc.columns[i];
+
+        int64_t index = -1;
+        for (uint64_t j = 0; j < this->meta.columns.size() && index < 0; j++) {
+            if (strcasecmp(name.c_str(), this->meta.columns[j].name.c_str()) == 0) {
+                index = j;
+            }
+        }
+
+        if (index < 0) {
+            S3INFO("Column %s is not in the Parquet file, it's read as NULL", name.c_str());
+        }
+
+        bool projected = (i >= this->scanDesc.projected.size()) || this->scanDesc.projected[i];
+
+        this->qualColumns.push_back(index);
+        this->outputColumns.push_back(projected ? index : -1);
+        this->outputNames.push_back(name);
+    }
+}
+
+bool ParquetReader::loadRowGroup() {
+    while (this->nextRowGroup < this->meta.rowGroups.size()) {
+        const ParquetRowGroup &rowGroup = this->meta.rowGroups[this->nextRowGroup++];
+
+        // a row group belongs to the range where its data starts.
+        uint64_t start = this->keySize;
+        for (uint64_t i = 0; i < rowGroup.columns.size(); i++) {
+            start = std::min(start, rowGroup.columns[i].getStartOffset());
+        }
+        if ((start < this->rangeStart) || (start >= this->rangeEnd)) {
+            continue;
+        }
+
+        if (!ParquetRowGroupMayMatch(this->meta, rowGroup, this->qualColumns,
+                                     this->scanDesc.quals)) {
+            S3DEBUG("Skip Parquet row group %" PRIu64 " by statistics", this->nextRowGroup - 1);
+            continue;
+        }
+
+        this->values.assign(this->outputColumns.size(), vector<string>());
+        this->nulls.assign(this->outputColumns.size(), vector<bool>());
+
+        // only download column chunks referenced by the scan, nearby ones with one request.
+        vector<std::pair<uint64_t, uint64_t> > ranges;
+        for (uint64_t i = 0; i < this->outputColumns.size(); i++) {
+            int64_t index = this->outputColumns[i];
+            if (index < 0) {
+                continue;
+            }
+
+            const ParquetColumnChunk &chunk = rowGroup.columns[index];
+            uint64_t offset = chunk.getStartOffset();
+            uint64_t size = chunk.totalCompressedSize;
+            S3_CHECK_OR_DIE((offset <= this->keySize) && (size <= this->keySize - offset),
+                            S3RuntimeError, "Parquet column chunk is out of file");
+
+            ranges.push_back(std::make_pair(offset, size));
+        }
+        this->fetcher.plan(ranges);
+
+        for (uint64_t i = 0; i < this->outputColumns.size(); i++) {
+            int64_t index = this->outputColumns[i];
+            if (index < 0) {
+                continue;
+            }
+
+            const ParquetColumnChunk &chunk = rowGroup.columns[index];
+            uint64_t size = chunk.totalCompressedSize;
+            const uint8_t *data = this->fetcher.fetch(chunk.getStartOffset(), size);
+
+            DecodeParquetColumnChunk(this->meta.columns[index], chunk, (const char *)data, size,
+                                     this->values[i], this->nulls[i]);
+            S3_CHECK_OR_DIE(this->values[i].size() == (uint64_t)rowGroup.numRows, S3RuntimeError,
+                            "Parquet column chunk doesn't match the row group");
+        }
+
+        this->numRows = rowGroup.numRows;
+        this->nextRow = 0;
+        return true;
+    }
+
+    return false;
+}
+
+void ParquetReader::appendValue(const string &value) {
+    char delimiter = this->scanDesc.delimiter;
+
+    if (this->scanDesc.csv) {
+        // quote values that would otherwise be parsed differently, including the empty string.
+        bool quoted = value.empty() || (value == this->scanDesc.nullString) ||
+                      (value.find_first_of(string(1, delimiter) + this->scanDesc.quote + "\r\n") !=
+                       string::npos);
+        if (!quoted) {
+            this->out.append(value);
+            return;
+        }
+
+        this->out.push_back(this->scanDesc.quote);
+        for (uint64_t i = 0; i < value.size(); i++) {
+            if ((value[i] == this->scanDesc.quote) || (value[i] == this->scanDesc.escape)) {
+                this->out.push_back(this->scanDesc.escape);
+            }
+            this->out.push_back(value[i]);
+        }
+        this->out.push_back(this->scanDesc.quote);
+        return;
+    }
+
+    char escape = this->scanDesc.escape;
+    if (escape == '\0') {
+        this->out.append(value);
+        return;
+    }
+
+    for (uint64_t i = 0; i < value.size(); i++) {
+        char c = value[i];
+        if (c == '\n') {
+            this->out.push_back(escape);
+            this->out.push_back('n');
+        } else if (c == '\r') {
+            this->out.push_back(escape);
+            this->out.push_back('r');
+        } else {
+            if (c == escape || c == delimiter) {
+                this->out.push_back(escape);
+            }
+            this->out.push_back(c);
+        }
+    }
+}
+
+void ParquetReader::appendNull() {
+    this->out.append(this->scanDesc.nullString);
+}
+
+void ParquetReader::fillOutput() {
+    this->out.clear();
+    this->outOffset = 0;
+
+    while (this->out.size() < S3_PARQUET_OUTPUT_CHUNKSIZE) {
+        if (this->nextRow >= this->numRows) {
+            if (!this->loadRowGroup()) {
+                break;
+            }
+            continue;
+        }
+
+        for (uint64_t i = 0; i < this->outputColumns.size(); i++) {
+            if (i > 0) {
+                this->out.push_back(this->scanDesc.delimiter);
+            }
+
+            if (this->outputColumns[i] < 0 || this->nulls[i][this->nextRow]) {
+                this->appendNull();
+            } else {
+                this->appendValue(this->values[i][this->nextRow]);
+            }
+        }
+        this->out.append(eolString);
+
+        this->nextRow++;
+    }
+}
+
+uint64_t ParquetReader::read(char *buf, uint64_t count) {
+    const char *data = NULL;
+
+    uint64_t len = this->readView(&data, count);
+    if (len != 0) {
+        memcpy(buf, data, len);
+    }
+
+    return len;
+}
+
+uint64_t ParquetReader::readView(const char **data, uint64_t count) {
+    if (this->outOffset >= this->out.size()) {
+        this->fillOutput();
+    }
+
+    uint64_t len = std::min(count, (uint64_t)(this->out.size() - this->outOffset));
+    *data = this->out.data() + this->outOffset;
+    this->outOffset += len;
+
+    return len;
+}
+
+void ParquetReader::close() {
+    this->meta = ParquetFileMetaData();
+    this->values.clear();
+    this->nulls.clear();
+    this->numRows = 0;
+    this->nextRow = 0;
+    this->nextRowGroup = 0;
+    this->out.clear();
+    this->outOffset = 0;
+
+    // free the buffers of the planned ranges.
+    this->fetcher.plan(vector<std::pair<uint64_t, uint64_t> >());
+}
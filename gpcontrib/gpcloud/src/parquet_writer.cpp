@@ -0,0 +1,1042 @@
+#include "parquet_writer.h"
+
+static string encodeLittleEndian32(uint32_t value) {
+    char data[4];
+    for (int i = 0; i < 4; i++) {
+        data[i] = (char)(value >> (8 * i));
+    }
+    return string(data, sizeof(data));
+}
+
+static string encodeLittleEndian64(uint64_t value) {
+    return encodeLittleEndian32((uint32_t)value) + encodeLittleEndian32((uint32_t)(value >> 32));
+}
+
+void ThriftCompactWriter::structBegin() {
+    this->lastFieldIds.push_back(this->lastFieldId);
+    this->lastFieldId = 0;
+}
+
+void ThriftCompactWriter::structEnd() {
+    this->out.push_back(THRIFT_STOP);
+    this->lastFieldId = this->lastFieldIds.back();
+    this->lastFieldIds.pop_back();
+}
+
+void ThriftCompactWriter::fieldBegin(int16_t id, uint8_t type) {
+    // field id is a delta to the last one in the high 4 bits, or follows as zigzag varint.
+    int16_t delta = id - this->lastFieldId;
+    if (delta > 0 && delta <= 15) {
+        this->out.push_back((char)((delta << 4) | type));
+    } else {
+        this->out.push_back((char)type);
+        this->zigzag(id);
+    }
+    this->lastFieldId = id;
+}
+
+void ThriftCompactWriter::i32Field(int16_t id, int32_t value) {
+    this->fieldBegin(id, THRIFT_I32);
+    this->zigzag(value);
+}
+
+void ThriftCompactWriter::i64Field(int16_t id, int64_t value) {
+    this->fieldBegin(id, THRIFT_I64);
+    this->zigzag(value);
+}
+
+void ThriftCompactWriter::boolField(int16_t id, bool value) {
+    // value of a bool field is in its field type.
+    this->fieldBegin(id, value ? THRIFT_BOOL_TRUE : THRIFT_BOOL_FALSE);
+}
+
+void ThriftCompactWriter::binaryField(int16_t id, const string &value) {
+    this->fieldBegin(id, THRIFT_BINARY);
+    this->binary(value);
+}
+
+void ThriftCompactWriter::listBegin(int16_t id, uint8_t elemType, uint64_t size) {
+    this->fieldBegin(id, THRIFT_LIST);
+    if (size < 15) {
+        this->out.push_back((char)((size << 4) | elemType));
+    } else {
+        this->out.push_back((char)(0xf0 | elemType));
+        this->varint(size);
+    }
+}
+
+void ThriftCompactWriter::binary(const string &value) {
+    this->varint(value.size());
+    this->out.append(value);
+}
+
+void ThriftCompactWriter::varint(uint64_t value) {
+    while (value >= 0x80) {
+        this->out.push_back((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    this->out.push_back((char)value);
+}
+
+void ThriftCompactWriter::zigzag(int64_t value) {
+    this->varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void appendVarint(string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+// Whether a run of 8 equal values, worth an RLE run, starts at pos.
+static bool isRleRun(const vector<uint32_t> &values, uint64_t pos, uint64_t end) {
+    if (end - pos < 8) {
+        return false;
+    }
+    for (uint64_t i = pos + 1; i < pos + 8; i++) {
+        if (values[i] != values[pos]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+string EncodeParquetRle(const vector<uint32_t> &values, uint64_t start, uint64_t count,
+                        uint32_t bitWidth) {
+    string out;
+    uint64_t end = start + count;
+    uint64_t pos = start;
+
+    while (pos < end) {
+        if (isRleRun(values, pos, end)) {
+            uint64_t runEnd = pos + 8;
+            while (runEnd < end && values[runEnd] == values[pos]) {
+                runEnd++;
+            }
+
+            appendVarint(out, (runEnd - pos) << 1);
+            for (uint32_t i = 0; i < (bitWidth + 7) / 8; i++) {
+                out.push_back((char)(values[pos] >> (8 * i)));
+            }
+            pos = runEnd;
+            continue;
+        }
+
+        // groups of 8 values until an RLE run starts, the last group is padded with 0.
+        uint64_t groupEnd = pos;
+        do {
+            groupEnd += 8;
+        } while (groupEnd < end && !isRleRun(values, groupEnd, end));
+
+        uint64_t groups = (groupEnd - pos) / 8;
+        appendVarint(out, (groups << 1) | 1);
+
+        uint64_t packedStart = out.size();
+        out.append(groups * bitWidth, '\0');
+        for (uint64_t i = pos; i < std::min(groupEnd, end); i++) {
+            uint64_t bitPos = (i - pos) * bitWidth;
+            for (uint32_t bit = 0; bit < bitWidth; bit++, bitPos++) {
+                if ((values[i] >> bit) & 1) {
+                    out[packedStart + bitPos / 8] |= (char)(1 << (bitPos % 8));
+                }
+            }
+        }
+        pos = std::min(groupEnd, end);
+    }
+
+    return out;
+}
+
+static string gzipCompress(const string &page) {
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+
+    // gzip header, as GZIP codec of Parquet requires.
+    int ret = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                           Z_DEFAULT_STRATEGY);
+    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+
+    string out(deflateBound(&zstream, page.size()), '\0');
+    zstream.next_in = (Byte *)page.data();
+    zstream.avail_in = page.size();
+    zstream.next_out = (Byte *)&out[0];
+    zstream.avail_out = out.size();
+
+    ret = deflate(&zstream, Z_FINISH);
+    uint64_t outLen = out.size() - zstream.avail_out;
+    deflateEnd(&zstream);
+
+    S3_CHECK_OR_DIE(ret == Z_STREAM_END, S3RuntimeError,
+                    string("Failed to compress data: ") + std::to_string((long long)ret));
+
+    out.resize(outLen);
+    return out;
+}
+
+string CompressParquetPage(int32_t codec, const string &page) {
+    switch (codec) {
+        case PARQUET_UNCOMPRESSED:
+            return page;
+        case PARQUET_GZIP:
+            return gzipCompress(page);
+#ifdef USE_ZSTD
+        case PARQUET_ZSTD: {
+            string out(ZSTD_compressBound(page.size()), '\0');
+            size_t ret =
+                ZSTD_compress(&out[0], out.size(), page.data(), page.size(), S3_PARQUET_ZSTD_LEVEL);
+            S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                            string("Failed to compress data: ") + ZSTD_getErrorName(ret));
+            out.resize(ret);
+            return out;
+        }
+#endif
+        default:
+            S3_DIE(S3RuntimeError, "Parquet compression codec " +
+                                       std::to_string((long long)codec) + " is not supported");
+    }
+}
+
+string EncodeParquetPlainValue(const ParquetColumnSchema &column, const string &text) {
+    const char *begin = text.c_str();
+    char *end = NULL;
+    errno = 0;
+
+    switch (column.type) {
+        case PARQUET_BOOLEAN:
+            // "t" and "f" from the formatter, other spellings of the input functions as well.
+            if (text == "t" || text == "true" || text == "1") {
+                return string(1, '\1');
+            } else if (text == "f" || text == "false" || text == "0") {
+                return string(1, '\0');
+            }
+            break;
+        case PARQUET_INT32: {
+            long long value = strtoll(begin, &end, 10);
+            if (!text.empty() && *end == '\0' && errno == 0 && value >= INT32_MIN &&
+                value <= INT32_MAX) {
+                return encodeLittleEndian32((uint32_t)value);
+            }
+            break;
+        }
+        case PARQUET_INT64: {
+            long long value = strtoll(begin, &end, 10);
+            if (!text.empty() && *end == '\0' && errno == 0) {
+                return encodeLittleEndian64((uint64_t)value);
+            }
+            break;
+        }
+        case PARQUET_DOUBLE: {
+            // NaN and Infinity are accepted by strtod(), overflow is not possible with output of
+            // float8out().
+            double value = strtod(begin, &end);
+            if (!text.empty() && *end == '\0') {
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                return encodeLittleEndian64(bits);
+            }
+            break;
+        }
+        case PARQUET_BYTE_ARRAY:
+        default:
+            return text;
+    }
+
+    S3_DIE(S3RuntimeError,
+           "Invalid value \"" + text + "\" of column \"" + column.name + "\" for Parquet");
+}
+
+string SerializeParquetFileMetaData(const vector<ParquetColumnSchema> &columns,
+                                    const vector<ParquetWrittenRowGroup> &rowGroups) {
+    ThriftCompactWriter writer;
+
+    int64_t numRows = 0;
+    for (uint64_t i = 0; i < rowGroups.size(); i++) {
+        numRows += rowGroups[i].numRows;
+    }
+
+    writer.structBegin();
+    writer.i32Field(1, 1);
+
+    writer.listBegin(2, THRIFT_STRUCT, columns.size() + 1);
+    writer.structBegin();
+    writer.binaryField(4, "schema");
+    writer.i32Field(5, columns.size());
+    writer.structEnd();
+    for (uint64_t i = 0; i < columns.size(); i++) {
+        writer.structBegin();
+        writer.i32Field(1, columns[i].type);
+        writer.i32Field(3, columns[i].repetition);
+        writer.binaryField(4, columns[i].name);
+        if (columns[i].convertedType != PARQUET_CONVERTED_NONE) {
+            writer.i32Field(6, columns[i].convertedType);
+        }
+        writer.structEnd();
+    }
+
+    writer.i64Field(3, numRows);
+
+    writer.listBegin(4, THRIFT_STRUCT, rowGroups.size());
+    for (uint64_t i = 0; i < rowGroups.size(); i++) {
+        const ParquetWrittenRowGroup &rowGroup = rowGroups[i];
+
+        writer.structBegin();
+        writer.listBegin(1, THRIFT_STRUCT, rowGroup.columns.size());
+        for (uint64_t j = 0; j < rowGroup.columns.size(); j++) {
+            const ParquetWrittenChunk &chunk = rowGroup.columns[j];
+            int64_t startOffset =
+                chunk.dictionaryPageOffset ? chunk.dictionaryPageOffset : chunk.dataPageOffset;
+
+            // ColumnChunk
+            writer.structBegin();
+            writer.i64Field(2, startOffset);
+
+            // ColumnMetaData
+            writer.fieldBegin(3, THRIFT_STRUCT);
+            writer.structBegin();
+            writer.i32Field(1, columns[j].type);
+            writer.listBegin(2, THRIFT_I32, chunk.encodings.size());
+            for (uint64_t k = 0; k < chunk.encodings.size(); k++) {
+                writer.zigzag(chunk.encodings[k]);
+            }
+            writer.listBegin(3, THRIFT_BINARY, 1);
+            writer.binary(columns[j].name);
+            writer.i32Field(4, chunk.codec);
+            writer.i64Field(5, chunk.numValues);
+            writer.i64Field(6, chunk.totalUncompressedSize);
+            writer.i64Field(7, chunk.totalCompressedSize);
+            writer.i64Field(9, chunk.dataPageOffset);
+            if (chunk.dictionaryPageOffset) {
+                writer.i64Field(11, chunk.dictionaryPageOffset);
+            }
+
+            // Statistics, min_value and max_value are in the order of the logical type.
+            writer.fieldBegin(12, THRIFT_STRUCT);
+            writer.structBegin();
+            if (chunk.stats.hasNullCount) {
+                writer.i64Field(3, chunk.stats.nullCount);
+            }
+            if (chunk.stats.hasMax) {
+                writer.binaryField(5, chunk.stats.max);
+            }
+            if (chunk.stats.hasMin) {
+                writer.binaryField(6, chunk.stats.min);
+            }
+            writer.structEnd();
+
+            writer.structEnd();
+            writer.structEnd();
+        }
+        writer.i64Field(2, rowGroup.totalByteSize);
+        writer.i64Field(3, rowGroup.numRows);
+        writer.structEnd();
+    }
+
+    writer.binaryField(6, "gpcloud");
+    writer.structEnd();
+
+    return writer.getData();
+}
+
+static string encodePageHeader(int32_t type, uint64_t uncompressedSize, uint64_t compressedSize,
+                               uint64_t numValues, int32_t encoding) {
+    ThriftCompactWriter writer;
+
+    writer.structBegin();
+    writer.i32Field(1, type);
+    writer.i32Field(2, uncompressedSize);
+    writer.i32Field(3, compressedSize);
+    if (type == PARQUET_DICTIONARY_PAGE) {
+        writer.fieldBegin(7, THRIFT_STRUCT);
+        writer.structBegin();
+        writer.i32Field(1, numValues);
+        writer.i32Field(2, encoding);
+        writer.structEnd();
+    } else {
+        writer.fieldBegin(5, THRIFT_STRUCT);
+        writer.structBegin();
+        writer.i32Field(1, numValues);
+        writer.i32Field(2, encoding);
+        writer.i32Field(3, PARQUET_RLE);
+        writer.i32Field(4, PARQUET_RLE);
+        writer.structEnd();
+    }
+    writer.structEnd();
+
+    return writer.getData();
+}
+
+// Order of plain encoded values of the column.
+static bool lessThan(const ParquetColumnSchema &column, const string &a, const string &b) {
+    switch (column.type) {
+        case PARQUET_INT32: {
+            int32_t x, y;
+            memcpy(&x, a.data(), sizeof(x));
+            memcpy(&y, b.data(), sizeof(y));
+            return x < y;
+        }
+        case PARQUET_INT64: {
+            int64_t x, y;
+            memcpy(&x, a.data(), sizeof(x));
+            memcpy(&y, b.data(), sizeof(y));
+            return x < y;
+        }
+        case PARQUET_DOUBLE: {
+            double x, y;
+            memcpy(&x, a.data(), sizeof(x));
+            memcpy(&y, b.data(), sizeof(y));
+            return x < y;
+        }
+        default:
+            // unsigned byte order.
+            return a < b;
+    }
+}
+
+ParquetColumnBuilder::ParquetColumnBuilder(const ParquetColumnSchema &column) : column(column) {
+    this->reset();
+}
+
+void ParquetColumnBuilder::reset() {
+    this->definitionLevels.clear();
+
+    this->useDictionary = (this->column.type != PARQUET_BOOLEAN);
+    this->dictionaryValues.clear();
+    this->dictionary.clear();
+    this->dictionarySize = 0;
+    this->indexes.clear();
+
+    this->plain.clear();
+
+    this->pages.clear();
+    this->currentPage.numValues = 0;
+    this->currentPage.numDefined = 0;
+    this->currentPage.plainEnd = 0;
+    this->currentPageSize = 0;
+
+    this->bufferedSize = 0;
+
+    this->stats = ParquetStatistics();
+    this->stats.hasNullCount = true;
+    this->hasLongValue = false;
+}
+
+void ParquetColumnBuilder::appendPlain(const string &value) {
+    if (this->column.type == PARQUET_BYTE_ARRAY) {
+        this->plain.append(encodeLittleEndian32(value.size()));
+    }
+    this->plain.append(value);
+}
+
+void ParquetColumnBuilder::updateStatistics(const string &value) {
+    if (this->column.type == PARQUET_BOOLEAN || this->hasLongValue) {
+        return;
+    }
+
+    if (this->column.type == PARQUET_BYTE_ARRAY && value.size() > S3_PARQUET_STATISTICS_MAX_LEN) {
+        this->hasLongValue = true;
+        this->stats.hasMin = this->stats.hasMax = false;
+        return;
+    }
+
+    // NaN is not ordered, it is left out.
+    if (this->column.type == PARQUET_DOUBLE) {
+        double x;
+        memcpy(&x, value.data(), sizeof(x));
+        if (std::isnan(x)) {
+            return;
+        }
+    }
+
+    if (!this->stats.hasMin || lessThan(this->column, value, this->stats.min)) {
+        this->stats.min = value;
+        this->stats.hasMin = true;
+    }
+    if (!this->stats.hasMax || lessThan(this->column, this->stats.max, value)) {
+        this->stats.max = value;
+        this->stats.hasMax = true;
+    }
+}
+
+void ParquetColumnBuilder::add(const string &text) {
+    string value = EncodeParquetPlainValue(this->column, text);
+    uint64_t plainSize = value.size() + ((this->column.type == PARQUET_BYTE_ARRAY) ? 4 : 0);
+
+    this->updateStatistics(value);
+
+    if (this->useDictionary) {
+        std::pair<std::unordered_map<string, uint32_t>::iterator, bool> result =
+            this->dictionary.emplace(value, this->dictionaryValues.size());
+        if (result.second) {
+            this->dictionaryValues.push_back(&result.first->first);
+            this->dictionarySize += plainSize;
+        }
+        this->indexes.push_back(result.first->second);
+
+        if (this->dictionarySize > S3_PARQUET_DICTIONARY_MAX_SIZE) {
+            this->fallbackToPlain();
+        }
+    } else {
+        this->appendPlain(value);
+    }
+
+    this->definitionLevels.push_back(1);
+    this->currentPage.numValues++;
+    this->currentPage.numDefined++;
+    this->currentPageSize += plainSize;
+    this->bufferedSize += plainSize;
+
+    if (this->currentPageSize >= S3_PARQUET_PAGE_SIZE) {
+        this->closePage();
+    }
+}
+
+void ParquetColumnBuilder::addNull() {
+    this->definitionLevels.push_back(0);
+    this->currentPage.numValues++;
+    this->stats.nullCount++;
+}
+
+void ParquetColumnBuilder::closePage() {
+    if (this->currentPage.numValues == 0) {
+        return;
+    }
+
+    this->currentPage.plainEnd = this->plain.size();
+    this->pages.push_back(this->currentPage);
+
+    this->currentPage.numValues = 0;
+    this->currentPage.numDefined = 0;
+    this->currentPageSize = 0;
+}
+
+// Values encoded so far are converted as well, so that all pages of the chunk are plain encoded.
+void ParquetColumnBuilder::fallbackToPlain() {
+    S3DEBUG("Dictionary of Parquet column \"%s\" is full, fall back to plain encoding",
+            this->column.name.c_str());
+
+    this->plain.clear();
+
+    uint64_t next = 0;
+    for (uint64_t i = 0; i < this->pages.size(); i++) {
+        for (uint64_t j = 0; j < this->pages[i].numDefined; j++) {
+            this->appendPlain(*this->dictionaryValues[this->indexes[next++]]);
+        }
+        this->pages[i].plainEnd = this->plain.size();
+    }
+    while (next < this->indexes.size()) {
+        this->appendPlain(*this->dictionaryValues[this->indexes[next++]]);
+    }
+
+    this->useDictionary = false;
+    this->dictionaryValues.clear();
+    this->dictionary.clear();
+    this->dictionarySize = 0;
+    this->indexes.clear();
+}
+
+// Definition levels prefixed by their length, then values of the page.
+string ParquetColumnBuilder::encodePage(const Page &page, uint64_t valueStart,
+                                        uint64_t definedStart, uint64_t plainStart,
+                                        uint32_t bitWidth) {
+    string levels = EncodeParquetRle(this->definitionLevels, valueStart, page.numValues, 1);
+    string body = encodeLittleEndian32(levels.size()) + levels;
+
+    if (this->useDictionary) {
+        body.push_back((char)bitWidth);
+        body.append(EncodeParquetRle(this->indexes, definedStart, page.numDefined, bitWidth));
+    } else if (this->column.type == PARQUET_BOOLEAN) {
+        // bit-packed, the least significant bit first.
+        string packed((page.numDefined + 7) / 8, '\0');
+        for (uint64_t i = 0; i < page.numDefined; i++) {
+            if (this->plain[plainStart + i]) {
+                packed[i / 8] |= (char)(1 << (i % 8));
+            }
+        }
+        body.append(packed);
+    } else {
+        body.append(this->plain, plainStart, page.plainEnd - plainStart);
+    }
+
+    return body;
+}
+
+ParquetWrittenChunk ParquetColumnBuilder::flush(int32_t codec, uint64_t offset, string &out) {
+    this->closePage();
+
+    // a dictionary without values is not worth a page.
+    if (this->dictionaryValues.empty()) {
+        this->useDictionary = false;
+    }
+
+    ParquetWrittenChunk chunk;
+    chunk.numValues = this->definitionLevels.size();
+    chunk.stats = this->stats;
+
+    // raw pages, the dictionary page first.
+    vector<string> pageData;
+    uint32_t bitWidth = 1;
+    if (this->useDictionary) {
+        while (bitWidth < 32 && ((uint64_t)1 << bitWidth) < this->dictionaryValues.size()) {
+            bitWidth++;
+        }
+
+        this->plain.clear();
+        for (uint64_t i = 0; i < this->dictionaryValues.size(); i++) {
+            this->appendPlain(*this->dictionaryValues[i]);
+        }
+        pageData.push_back(this->plain);
+    }
+
+    uint64_t valueStart = 0, definedStart = 0, plainStart = 0;
+    for (uint64_t i = 0; i < this->pages.size(); i++) {
+        pageData.push_back(
+            this->encodePage(this->pages[i], valueStart, definedStart, plainStart, bitWidth));
+
+        valueStart += this->pages[i].numValues;
+        definedStart += this->pages[i].numDefined;
+        plainStart = this->pages[i].plainEnd;
+    }
+
+    // compression is decided for the whole column chunk by its size.
+    vector<string> compressedData;
+    uint64_t rawSize = 0, compressedSize = 0;
+    if (codec != PARQUET_UNCOMPRESSED) {
+        for (uint64_t i = 0; i < pageData.size(); i++) {
+            compressedData.push_back(CompressParquetPage(codec, pageData[i]));
+            rawSize += pageData[i].size();
+            compressedSize += compressedData.back().size();
+        }
+    }
+    chunk.codec = (compressedSize < rawSize) ? codec : (int32_t)PARQUET_UNCOMPRESSED;
+
+    for (uint64_t i = 0; i < pageData.size(); i++) {
+        const string &payload =
+            (chunk.codec == PARQUET_UNCOMPRESSED) ? pageData[i] : compressedData[i];
+
+        string header;
+        if (this->useDictionary && i == 0) {
+            chunk.dictionaryPageOffset = offset + out.size();
+            header = encodePageHeader(PARQUET_DICTIONARY_PAGE, pageData[i].size(), payload.size(),
+                                      this->dictionaryValues.size(), PARQUET_PLAIN);
+        } else {
+            if (chunk.dataPageOffset == 0) {
+                chunk.dataPageOffset = offset + out.size();
+            }
+            const Page &page = this->pages[i - (this->useDictionary ? 1 : 0)];
+            header = encodePageHeader(PARQUET_DATA_PAGE, pageData[i].size(), payload.size(),
+                                      page.numValues,
+                                      this->useDictionary ? PARQUET_RLE_DICTIONARY : PARQUET_PLAIN);
+        }
+
+        out.append(header);
+        out.append(payload);
+        chunk.totalUncompressedSize += header.size() + pageData[i].size();
+        chunk.totalCompressedSize += header.size() + payload.size();
+    }
+
+    chunk.encodings.push_back(PARQUET_PLAIN);
+    chunk.encodings.push_back(PARQUET_RLE);
+    if (this->useDictionary) {
+        chunk.encodings.push_back(PARQUET_RLE_DICTIONARY);
+    }
+
+    this->reset();
+    return chunk;
+}
+
+ParquetWriter::ParquetWriter()
+    : writer(NULL),
+      codec(PARQUET_UNCOMPRESSED),
+      rowGroupSize(0),
+      fileOffset(0),
+      numRows(0),
+      fieldIndex(0),
+      rawLen(0),
+      rawMatchNull(true),
+      quoted(false),
+      inQuotes(false),
+      quotePending(false),
+      csvEscapePending(false),
+      escapeState(ESCAPE_NONE),
+      escapeValue(0),
+      escapeDigits(0),
+      afterCR(false),
+      hasError(false),
+      isClosed(true) {
+}
+
+void ParquetWriter::open(const S3Params &params) {
+    S3_CHECK_OR_DIE(this->writer != NULL, S3RuntimeError, "writer must not be NULL");
+
+    this->desc = params.getScanDesc();
+    S3_CHECK_OR_DIE(!this->desc.columns.empty(), S3ConfigError,
+                    "\"FATAL: export_format parquet needs columns of the table\"",
+                    "export_format");
+
+    const string &codecName = params.getParquetCodec();
+    if (codecName == "gzip") {
+        this->codec = PARQUET_GZIP;
+    } else if (codecName == "zstd") {
+#ifndef USE_ZSTD
+        S3_DIE(S3ConfigError, "\"FATAL: gpcloud is built without zstd\"", "parquet_codec");
+#endif
+        this->codec = PARQUET_ZSTD;
+    } else {
+        this->codec = PARQUET_UNCOMPRESSED;
+    }
+
+    this->rowGroupSize = params.getRowGroupSize();
+
+    // every column is nullable, types without a Parquet counterpart are written as UTF8.
+    this->columns.clear();
+    this->builders.clear();
+    for (uint64_t i = 0; i < this->desc.columns.size(); i++) {
+        ParquetColumnSchema column;
+        column.name = this->desc.columns[i];
+        column.repetition = PARQUET_OPTIONAL;
+
+        S3ColumnType type = (i < this->desc.types.size()) ? this->desc.types[i] : S3_COLUMN_TEXT;
+        switch (type) {
+            case S3_COLUMN_BOOL:
+                column.type = PARQUET_BOOLEAN;
+                break;
+            case S3_COLUMN_INT32:
+                column.type = PARQUET_INT32;
+                break;
+            case S3_COLUMN_INT64:
+                column.type = PARQUET_INT64;
+                break;
+            case S3_COLUMN_DOUBLE:
+                column.type = PARQUET_DOUBLE;
+                break;
+            case S3_COLUMN_TEXT:
+            default:
+                column.type = PARQUET_BYTE_ARRAY;
+                column.convertedType = PARQUET_CONVERTED_UTF8;
+        }
+
+        this->columns.push_back(column);
+        this->builders.push_back(ParquetColumnBuilder(column));
+    }
+
+    this->field.clear();
+    this->fieldIndex = 0;
+    this->rawLen = 0;
+    this->rawMatchNull = true;
+    this->quoted = false;
+    this->inQuotes = false;
+    this->quotePending = false;
+    this->csvEscapePending = false;
+    this->escapeState = ESCAPE_NONE;
+    this->afterCR = false;
+    this->hasError = false;
+
+    this->writer->open(params);
+    this->isClosed = false;
+
+    this->beginFile();
+}
+
+uint64_t ParquetWriter::write(const char *buf, uint64_t count) {
+    if (this->isClosed) {
+        return 0;
+    }
+
+    try {
+        for (uint64_t i = 0; i < count; i++) {
+            if (this->afterCR) {
+                this->afterCR = false;
+                if (buf[i] == '\n') {
+                    continue;
+                }
+            }
+
+            if (this->desc.csv) {
+                this->parseCSV(buf[i]);
+            } else {
+                this->parseText(buf[i]);
+            }
+        }
+    } catch (...) {
+        this->hasError = true;
+        throw;
+    }
+
+    return count;
+}
+
+// NULL is told by the field as written, before escapes are decoded.
+void ParquetWriter::appendRaw(char c) {
+    const string &nullString = this->desc.nullString;
+    if (this->rawMatchNull &&
+        ((this->rawLen >= nullString.size()) || (nullString[this->rawLen] != c))) {
+        this->rawMatchNull = false;
+    }
+    this->rawLen++;
+}
+
+// Return false if c is not part of the escape sequence, it is parsed as usual then.
+bool ParquetWriter::parseTextEscape(char c) {
+    switch (this->escapeState) {
+        case ESCAPE_PENDING:
+            this->escapeState = ESCAPE_NONE;
+            switch (c) {
+                case 'b':
+                    this->field.push_back('\b');
+                    break;
+                case 'f':
+                    this->field.push_back('\f');
+                    break;
+                case 'n':
+                    this->field.push_back('\n');
+                    break;
+                case 'r':
+                    this->field.push_back('\r');
+                    break;
+                case 't':
+                    this->field.push_back('\t');
+                    break;
+                case 'v':
+                    this->field.push_back('\v');
+                    break;
+                case 'x':
+                    this->escapeState = ESCAPE_HEX;
+                    this->escapeValue = 0;
+                    this->escapeDigits = 0;
+                    break;
+                default:
+                    if (c >= '0' && c <= '7') {
+                        this->escapeState = ESCAPE_OCTAL;
+                        this->escapeValue = c - '0';
+                        this->escapeDigits = 1;
+                    } else {
+                        this->field.push_back(c);
+                    }
+            }
+            return true;
+        case ESCAPE_OCTAL:
+            if (c >= '0' && c <= '7') {
+                this->escapeValue = this->escapeValue * 8 + (c - '0');
+                if (++this->escapeDigits == 3) {
+                    this->field.push_back((char)this->escapeValue);
+                    this->escapeState = ESCAPE_NONE;
+                }
+                return true;
+            }
+            this->field.push_back((char)this->escapeValue);
+            this->escapeState = ESCAPE_NONE;
+            return false;
+        case ESCAPE_HEX:
+            if (isxdigit((unsigned char)c)) {
+                this->escapeValue =
+                    this->escapeValue * 16 + (isdigit((unsigned char)c) ? c - '0'
+                                                                         : tolower(c) - 'a' + 10);
+                if (++this->escapeDigits == 2) {
+                    this->field.push_back((char)this->escapeValue);
+                    this->escapeState = ESCAPE_NONE;
+                }
+                return true;
+            }
+            // "\x" without hex digits is "x".
+            this->field.push_back(this->escapeDigits ? (char)this->escapeValue : 'x');
+            this->escapeState = ESCAPE_NONE;
+            return false;
+        case ESCAPE_NONE:
+        default:
+            return false;
+    }
+}
+
+void ParquetWriter::parseText(char c) {
+    if (this->parseTextEscape(c)) {
+        this->appendRaw(c);
+        return;
+    }
+
+    if (c == this->desc.delimiter) {
+        this->endField();
+    } else if (c == '\n' || c == '\r') {
+        this->endRow();
+        this->afterCR = (c == '\r');
+    } else {
+        if (this->desc.escape != '\0' && c == this->desc.escape) {
+            this->escapeState = ESCAPE_PENDING;
+        } else {
+            this->field.push_back(c);
+        }
+        this->appendRaw(c);
+    }
+}
+
+void ParquetWriter::parseCSV(char c) {
+    char quote = this->desc.quote;
+    char escape = this->desc.escape;
+
+    if (this->quotePending) {
+        // a doubled quote is a quote, otherwise the quoted part ends.
+        this->quotePending = false;
+        if (c == quote) {
+            this->field.push_back(c);
+            this->appendRaw(c);
+            return;
+        }
+        this->inQuotes = false;
+    } else if (this->csvEscapePending) {
+        this->csvEscapePending = false;
+        if (c != quote && c != escape) {
+            this->field.push_back(escape);
+        }
+        this->field.push_back(c);
+        this->appendRaw(c);
+        return;
+    }
+
+    if (this->inQuotes) {
+        if (c == quote) {
+            if (escape == quote) {
+                this->quotePending = true;
+            } else {
+                this->inQuotes = false;
+            }
+        } else if (c == escape) {
+            this->csvEscapePending = true;
+        } else {
+            this->field.push_back(c);
+        }
+        this->appendRaw(c);
+        return;
+    }
+
+    if (c == this->desc.delimiter) {
+        this->endField();
+    } else if (c == '\n' || c == '\r') {
+        this->endRow();
+        this->afterCR = (c == '\r');
+    } else {
+        if (c == quote) {
+            this->inQuotes = true;
+            this->quoted = true;
+        } else {
+            this->field.push_back(c);
+        }
+        this->appendRaw(c);
+    }
+}
+
+void ParquetWriter::endField() {
+    S3_CHECK_OR_DIE(this->fieldIndex < this->builders.size(), S3RuntimeError,
+                    "Row has more fields than the " +
+                        std::to_string((unsigned long long)this->builders.size()) +
+                        " columns of the table");
+
+    bool isNull =
+        this->rawMatchNull && (this->rawLen == this->desc.nullString.size()) && !this->quoted;
+    if (isNull) {
+        this->builders[this->fieldIndex].addNull();
+    } else {
+        this->builders[this->fieldIndex].add(this->field);
+    }
+
+    this->field.clear();
+    this->fieldIndex++;
+    this->rawLen = 0;
+    this->rawMatchNull = true;
+    this->quoted = false;
+}
+
+void ParquetWriter::endRow() {
+    this->endField();
+
+    S3_CHECK_OR_DIE(this->fieldIndex == this->builders.size(), S3RuntimeError,
+                    "Row has " + std::to_string((unsigned long long)this->fieldIndex) +
+                        " fields, but the table has " +
+                        std::to_string((unsigned long long)this->builders.size()) + " columns");
+    this->fieldIndex = 0;
+    this->numRows++;
+
+    uint64_t bufferedSize = 0;
+    for (uint64_t i = 0; i < this->builders.size(); i++) {
+        bufferedSize += this->builders[i].getBufferedSize();
+    }
+    if (bufferedSize >= this->rowGroupSize) {
+        this->flushRowGroup();
+    }
+}
+
+void ParquetWriter::writeOut(const string &data) {
+    uint64_t written = 0;
+    while (written < data.size()) {
+        written += this->writer->write(data.data() + written, data.size() - written);
+    }
+    this->fileOffset += data.size();
+}
+
+void ParquetWriter::beginFile() {
+    this->fileOffset = 0;
+    this->rowGroups.clear();
+    this->numRows = 0;
+
+    this->writeOut(string(S3_PARQUET_MAGIC, S3_PARQUET_MAGIC_LEN));
+}
+
+void ParquetWriter::flushRowGroup() {
+    if (this->numRows == 0) {
+        return;
+    }
+
+    ParquetWrittenRowGroup rowGroup;
+    rowGroup.numRows = this->numRows;
+
+    // column chunks are uploaded one by one, only one of them is encoded in memory at a time.
+    for (uint64_t i = 0; i < this->builders.size(); i++) {
+        string data;
+        rowGroup.columns.push_back(this->builders[i].flush(this->codec, this->fileOffset, data));
+        rowGroup.totalByteSize += rowGroup.columns.back().totalUncompressedSize;
+        this->writeOut(data);
+    }
+
+    S3DEBUG("Segment %d wrote a Parquet row group of %" PRId64 " rows", s3ext_segid,
+            rowGroup.numRows);
+
+    this->rowGroups.push_back(rowGroup);
+    this->numRows = 0;
+}
+
+void ParquetWriter::finishFile() {
+    // the last line may have no EOL, its pending escape sequence ends with it.
+    if (this->escapeState == ESCAPE_OCTAL || this->escapeState == ESCAPE_HEX) {
+        this->parseTextEscape('\n');
+    }
+    if (this->fieldIndex > 0 || this->rawLen > 0 || this->quoted) {
+        this->endRow();
+    }
+
+    this->flushRowGroup();
+
+    string footer = SerializeParquetFileMetaData(this->columns, this->rowGroups);
+    this->writeOut(footer + encodeLittleEndian32(footer.size()) +
+                   string(S3_PARQUET_MAGIC, S3_PARQUET_MAGIC_LEN));
+}
+
+void ParquetWriter::rollover(const S3Url &url) {
+    this->finishFile();
+    this->writer->rollover(url);
+    this->beginFile();
+}
+
+void ParquetWriter::close() {
+    if (this->isClosed) {
+        return;
+    }
+
+    // a throwing close() is not retried, the key is given up.
+    this->isClosed = true;
+    if (!this->hasError) {
+        this->finishFile();
+    }
+    this->writer->close();
+}
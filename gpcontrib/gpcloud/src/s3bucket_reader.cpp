@@ -1,7 +1,338 @@
 #include "s3bucket_reader.h"
 
+#include <queue>
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define S3_KEY_LIST_MAGIC "gpcloud key list v2"
+
+// placeholder of an unknown ETag in the key list, a real ETag is a quoted string.
+#define S3_KEY_LIST_NO_ETAG "-"
+
+// Bigger ranges go first, ties are broken by key order to keep the plan deterministic.
+static bool isLongerKeyRange(const KeyRange &a, const KeyRange &b) {
+    if (a.getSize() != b.getSize()) {
+        return a.getSize() > b.getSize();
+    }
+    if (a.keyIndex != b.keyIndex) {
+        return a.keyIndex < b.keyIndex;
+    }
+    return a.start < b.start;
+}
+
+static bool isPrecedingKeyRange(const KeyRange &a, const KeyRange &b) {
+    if (a.keyIndex != b.keyIndex) {
+        return a.keyIndex < b.keyIndex;
+    }
+    return a.start < b.start;
+}
+
+vector<KeyRange> ScheduleKeyRanges(const vector<BucketContent> &keys, uint64_t segId,
+                                   uint64_t segNum, uint64_t minRangeSize, bool splitKeys,
+                                   const std::function<bool(size_t)> &canSplitKey) {
+    vector<KeyRange> ranges;
+    vector<KeyRange> result;
+
+    if (segNum == 0) {
+        return result;
+    }
+
+    uint64_t totalSize = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        totalSize += keys[i].getSize();
+    }
+
+    uint64_t rangeSize = std::max((totalSize + segNum - 1) / segNum, minRangeSize);
+
+    ranges.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint64_t keySize = keys[i].getSize();
+
+        if (!splitKeys || rangeSize == 0 || keySize <= rangeSize ||
+            (canSplitKey && !canSplitKey(i))) {
+            ranges.emplace_back(i, 0, keySize);
+            continue;
+        }
+
+        // split evenly, so that the last range is not a tiny one
+        uint64_t numOfRanges = (keySize + rangeSize - 1) / rangeSize;
+        uint64_t step = (keySize + numOfRanges - 1) / numOfRanges;
+        for (uint64_t start = 0; start < keySize; start += step) {
+            ranges.emplace_back(i, start, std::min(start + step, keySize));
+        }
+    }
+
+    std::stable_sort(ranges.begin(), ranges.end(), isLongerKeyRange);
+
+    // min-heap of (load, segment id), the least loaded segment with smallest id on top.
+    typedef std::pair<uint64_t, uint64_t> SegmentLoad;
+    std::priority_queue<SegmentLoad, vector<SegmentLoad>, std::greater<SegmentLoad> > loads;
+    for (uint64_t i = 0; i < segNum; i++) {
+        loads.push(SegmentLoad(0, i));
+    }
+
+    for (size_t i = 0; i < ranges.size(); i++) {
+        SegmentLoad least = loads.top();
+        loads.pop();
+
+        if (least.second == segId) {
+            result.push_back(ranges[i]);
+        }
+
+        least.first += ranges[i].getSize();
+        loads.push(least);
+    }
+
+    std::sort(result.begin(), result.end(), isPrecedingKeyRange);
+
+    return result;
+}
+
+vector<KeyRange> SampleKeyRanges(const vector<KeyRange> &ranges, double fraction, uint64_t seed,
+                                 double *sampledFraction) {
+    uint64_t totalSize = 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        totalSize += ranges[i].getSize();
+    }
+
+    if (fraction >= 1.0 || totalSize == 0) {
+        *sampledFraction = 1.0;
+        return ranges;
+    }
+
+    // Fisher-Yates shuffle with splitmix64, deterministic for a seed on every platform.
+    vector<size_t> order(ranges.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    uint64_t state = seed;
+    for (size_t i = order.size(); i > 1; i--) {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z = z ^ (z >> 31);
+        std::swap(order[i - 1], order[z % i]);
+    }
+
+    uint64_t targetSize = (uint64_t)(fraction * totalSize);
+    uint64_t sampledSize = 0;
+    size_t numSampled = 0;
+    while (numSampled < order.size() && (numSampled == 0 || sampledSize < targetSize)) {
+        sampledSize += ranges[order[numSampled]].getSize();
+        numSampled++;
+    }
+
+    // keep the order of keys
+    order.resize(numSampled);
+    std::sort(order.begin(), order.end());
+
+    vector<KeyRange> result;
+    result.reserve(numSampled);
+    for (size_t i = 0; i < order.size(); i++) {
+        result.push_back(ranges[order[i]]);
+    }
+
+    *sampledFraction = (double)sampledSize / totalSize;
+    return result;
+}
+
+string SerializeKeyList(const ListBucketResult &keyList) {
+    std::stringstream ss;
+
+    if ((keyList.Name.find('\n') != string::npos) || (keyList.Prefix.find('\n') != string::npos)) {
+        return "";
+    }
+
+    ss << S3_KEY_LIST_MAGIC << '\n'
+       << keyList.Name << '\n'
+       << keyList.Prefix << '\n'
+       << keyList.contents.size() << '\n';
+
+    for (size_t i = 0; i < keyList.contents.size(); i++) {
+        const BucketContent &key = keyList.contents[i];
+        if ((key.getName().find('\n') != string::npos) ||
+            (key.getETag().find_first_of(" \n") != string::npos)) {
+            return "";
+        }
+
+        string etag = key.getETag().empty() ? S3_KEY_LIST_NO_ETAG : key.getETag();
+        ss << key.getSize() << ' ' << etag << ' ' << key.getName() << '\n';
+    }
+
+    return ss.str();
+}
+
+bool DeserializeKeyList(const string &text, ListBucketResult &keyList) {
+    std::stringstream ss(text);
+    string line;
+
+    if (!std::getline(ss, line) || (line != S3_KEY_LIST_MAGIC)) {
+        return false;
+    }
+
+    ListBucketResult result;
+    uint64_t count = 0;
+
+    if (!std::getline(ss, result.Name) || !std::getline(ss, result.Prefix) ||
+        !std::getline(ss, line) || (sscanf(line.c_str(), "%" SCNu64, &count) != 1)) {
+        return false;
+    }
+
+    result.contents.reserve(count);
+    while (std::getline(ss, line)) {
+        uint64_t size = 0;
+        size_t pos = line.find(' ');
+        size_t namePos = (pos == string::npos) ? string::npos : line.find(' ', pos + 1);
+        if ((namePos == string::npos) || (sscanf(line.c_str(), "%" SCNu64, &size) != 1)) {
+            return false;
+        }
+
+        string etag = line.substr(pos + 1, namePos - pos - 1);
+        if (etag == S3_KEY_LIST_NO_ETAG) {
+            etag.clear();
+        }
+        result.contents.emplace_back(line.substr(namePos + 1), size, etag);
+    }
+
+    // the last line is incomplete, or some lines are missing.
+    if ((result.contents.size() != count) || (!text.empty() && (*text.rbegin() != '\n'))) {
+        return false;
+    }
+
+    keyList = result;
+    return true;
+}
+
+static bool readWholeFile(int fd, string &text) {
+    char buf[4096];
+    ssize_t len;
+
+    text.clear();
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        text.append(buf, len);
+    }
+
+    return len == 0;
+}
+
+static bool writeWholeFile(int fd, const string &text) {
+    const char *p = text.data();
+    size_t remaining = text.size();
+
+    if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0) {
+        return false;
+    }
+
+    while (remaining > 0) {
+        ssize_t len = write(fd, p, remaining);
+        if (len <= 0) {
+            return false;
+        }
+        p += len;
+        remaining -= len;
+    }
+
+    return true;
+}
+
+// Hold the exclusive lock of the cache file, released even when listing throws.
+class KeyListCacheFile {
+   public:
+    KeyListCacheFile(const string &path) : fd(-1) {
+        this->fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        if (this->fd < 0) {
+            S3WARN("Failed to open list cache file '%s': %s", path.c_str(), strerror(errno));
+            return;
+        }
+
+        if (flock(this->fd, LOCK_EX) != 0) {
+            S3WARN("Failed to lock list cache file '%s': %s", path.c_str(), strerror(errno));
+            ::close(this->fd);
+            this->fd = -1;
+        }
+    }
+
+    ~KeyListCacheFile() {
+        if (this->fd >= 0) {
+            flock(this->fd, LOCK_UN);
+            ::close(this->fd);
+        }
+    }
+
+    int getFd() const {
+        return fd;
+    }
+
+   private:
+    int fd;
+};
+
+// ListBucketWithCache() of any source of keys, listKeys() lists them.
+template <typename ListKeys>
+static ListBucketResult listKeysWithCache(ListKeys listKeys, const string &cachePath,
+                                         uint64_t ttl) {
+    KeyListCacheFile cacheFile(cachePath);
+    if (cacheFile.getFd() < 0) {
+        return listKeys();
+    }
+
+    struct stat st;
+    if ((fstat(cacheFile.getFd(), &st) == 0) && (st.st_size > 0) &&
+        ((uint64_t)(time(NULL) - st.st_mtime) < ttl)) {
+        ListBucketResult keyList;
+        string text;
+
+        if (readWholeFile(cacheFile.getFd(), text) && DeserializeKeyList(text, keyList)) {
+            S3DEBUG("Loaded %zu keys from list cache file '%s'", keyList.contents.size(),
+                    cachePath.c_str());
+            return keyList;
+        }
+
+        S3WARN("List cache file '%s' is corrupted, list the bucket again", cachePath.c_str());
+    }
+
+    ListBucketResult keyList = listKeys();
+
+    string text = SerializeKeyList(keyList);
+    if (text.empty() || !writeWholeFile(cacheFile.getFd(), text)) {
+        // make sure other segments don't load a partial list.
+        if (ftruncate(cacheFile.getFd(), 0) != 0) {
+            S3WARN("Failed to truncate list cache file '%s'", cachePath.c_str());
+        }
+    }
+
+    return keyList;
+}
+
+ListBucketResult ListBucketWithCache(S3Interface *s3Interface, S3Url &s3Url,
+                                     const string &cachePath, uint64_t ttl) {
+    return listKeysWithCache([&]() { return s3Interface->listBucket(s3Url); }, cachePath, ttl);
+}
+
+string KeyListCachePath(const S3Params &params) {
+    const S3Url &s3Url = params.getS3Url();
+
+    // segments reading the same location with the same access key share one cache file, a key
+    // pair must not be served a list that another one got.
+    string location = s3Url.getFullUrlForCurl() + "\n" + s3Url.getRegion() + "\n" +
+                      params.getCred().accessID;
+    if (!params.getInventoryManifest().empty()) {
+        location += "\n" + params.getInventoryManifest() + "\n" +
+                    params.getInventoryModifiedAfter() + "\n" +
+                    params.getInventoryModifiedBefore();
+    }
+    char hash[SHA256_DIGEST_STRING_LENGTH];
+    sha256_hex(location.c_str(), hash);
+
+    return params.getListCacheDir() + "/gpcloud_list_" + string(hash);
+}
+
 S3BucketReader::S3BucketReader() : Reader() {
-    this->keyIndex = 0;  // doesn't matter, be set in open()
+    this->rangeIndex = 0;  // doesn't matter, be set in open()
+    this->sampledFraction = 1.0;
 
     this->s3Interface = NULL;
     this->upstreamReader = NULL;
@@ -17,7 +348,7 @@ S3BucketReader::~S3BucketReader() {
 void S3BucketReader::open(const S3Params& params) {
     this->params = params;
 
-    this->keyIndex = s3ext_segid;  // we may change it in unit tests
+    this->rangeIndex = 0;
 
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface is NULL");
 
@@ -26,16 +357,77 @@ void S3BucketReader::open(const S3Params& params) {
     S3_CHECK_OR_DIE(s3Url.isValidUrl(), S3ConfigError, s3Url.getFullUrlForCurl() + " is not valid",
                     s3Url.getFullUrlForCurl());
 
-    this->keyList = this->s3Interface->listBucket(s3Url);
+    this->keyList = this->listBucket(s3Url);
+
+    // A range not starting at a key's beginning has no header line, readView() gives the segment
+    // one to skip if its first range is such a range. S3 Select only skips the header line at the
+    // start of a key.
+    //
+    // A range starts at the first EOL after its offset, which is not where a line starts if the
+    // EOL is in a quoted CSV field. That can't be told without reading the key from its start, so
+    // CSV keys are split only if the user says no quoted field has a newline.
+    bool splitKeys = (!hasHeader || !this->params.isS3Select()) &&
+                     (!this->params.getScanDesc().csv || this->params.isSplitCsv());
+    this->keyRanges =
+        ScheduleKeyRanges(this->keyList.contents, s3ext_segid, s3ext_segnum,
+                          this->params.getChunkSize(), splitKeys,
+                          [this](size_t keyIndex) { return this->canSplitKey(keyIndex); });
+
+    double sampleFraction = this->params.getScanDesc().sampleFraction;
+    if (sampleFraction < 1.0) {
+        uint64_t totalRanges = this->keyRanges.size();
+        this->keyRanges = SampleKeyRanges(this->keyRanges, sampleFraction, s3ext_segid,
+                                          &this->sampledFraction);
+        S3INFO("Sampled %" PRIu64 " of %" PRIu64 " key ranges, %.4f of the data",
+               (uint64_t)this->keyRanges.size(), totalRanges, this->sampledFraction);
+    } else {
+        this->sampledFraction = 1.0;
+    }
 }
 
-BucketContent& S3BucketReader::getNextKey() {
-    BucketContent& key = this->keyList.contents[this->keyIndex];
-    this->keyIndex += s3ext_segnum;
-    return key;
+ListBucketResult S3BucketReader::listBucket(S3Url& s3Url) {
+    const string& cacheDir = this->params.getListCacheDir();
+    bool fromInventory = !this->params.getInventoryManifest().empty();
+    if (cacheDir.empty()) {
+        return fromInventory ? ListBucketFromInventory(this->s3Interface, this->params)
+                             : this->s3Interface->listBucket(s3Url);
+    }
+
+    string cachePath = KeyListCachePath(this->params);
+    if (fromInventory) {
+        return listKeysWithCache(
+            [&]() { return ListBucketFromInventory(this->s3Interface, this->params); }, cachePath,
+            this->params.getListCacheTTL());
+    }
+
+    return ListBucketWithCache(this->s3Interface, s3Url, cachePath,
+                               this->params.getListCacheTTL());
 }
 
-S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
+// Only keys that would be split are checked, every segment gets the same compression type of a key.
+// A compressed stream is decompressed from its start, so the range starting at 0 of a compressed
+// key reads it all and the other ranges read nothing, unless the key is read by its members.
+bool S3BucketReader::canSplitKey(size_t keyIndex) {
+    const BucketContent& key = this->keyList.contents[keyIndex];
+    S3Params keyParams = this->constructReaderParams(KeyRange(keyIndex, 0, key.getSize()));
+
+    switch (this->s3Interface->checkCompressionType(keyParams.getS3Url())) {
+        case S3_COMPRESSION_PLAIN:
+        case S3_COMPRESSION_PARQUET:
+            return true;
+        default:
+            // S3 Select decompresses gzip keys itself, from their start.
+            return this->params.isSplitCompressed() && !this->params.isS3Select();
+    }
+}
+
+const KeyRange& S3BucketReader::getNextKeyRange() {
+    return this->keyRanges[this->rangeIndex++];
+}
+
+S3Params S3BucketReader::constructReaderParams(const KeyRange& range) {
+    BucketContent& key = this->keyList.contents[range.keyIndex];
+
     // encode the key name but leave the "/"
     // "/encoded_path/encoded_name"
     string keyEncoded = UriEncode(key.getName());
@@ -44,79 +436,92 @@ S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
     S3Params readerParams = this->params.setPrefix(keyEncoded);
 
     readerParams.setKeySize(key.getSize());
+    readerParams.setKeyETag(key.getETag());
 
-    S3DEBUG("key: %s, size: %" PRIu64, readerParams.getS3Url().getFullUrlForCurl().c_str(),
-            readerParams.getKeySize());
+    if (range.getSize() < key.getSize()) {
+        readerParams.setKeyRange(range.start, range.end);
+    }
+
+    S3DEBUG("key: %s, size: %" PRIu64 ", range: [%" PRIu64 ", %" PRIu64 ")",
+            readerParams.getS3Url().getFullUrlForCurl().c_str(), readerParams.getKeySize(),
+            range.start, range.end);
     return readerParams;
 }
 
-uint64_t S3BucketReader::readWithoutHeaderLine(char* buf, uint64_t count) {
-    char* current = NULL;
-    char* end = NULL;
-    char* currentEOL = eolString;
-
-    // check one char at a time
-    while (*currentEOL != '\0') {
-        if (current == end) {
-            uint64_t readCount = this->upstreamReader->read(buf, count);
-            // we have reach the end of file but found no matching EOL.
-            if (readCount == 0) {
-                S3WARN("%s", "Reach end of file before matching line terminator");
-                return 0;
-            }
+uint64_t S3BucketReader::readWithoutHeaderLine(const char** data, uint64_t count) {
+    // a CSV header might have quoted column names with newlines.
+    const S3ScanDesc& scanDesc = this->params.getScanDesc();
+    EolScanner scanner(eolString, scanDesc.csv ? scanDesc.quote : '\0',
+                       scanDesc.csv ? scanDesc.escape : '\0');
 
-            current = buf;
-            end = buf + readCount;
+    while (true) {
+        uint64_t readCount = this->upstreamReader->readView(data, count);
+        // we have reach the end of file but found no matching EOL.
+        if (readCount == 0) {
+            S3WARN("%s", "Reach end of file before matching line terminator");
+            return 0;
         }
 
-        // skip until we met next newline char
-        for (; current != end; current++) {
-            if (*current == *currentEOL) {
-                currentEOL++;
-                current++;
-                break;
-            } else {
-                currentEOL = eolString;
-            }
+        uint64_t found = scanner.find(*data, readCount);
+        if (found != (uint64_t)-1) {
+            // remained data starts after the header line.
+            *data += found;
+            return readCount - found;
         }
     }
+}
+
+uint64_t S3BucketReader::read(char* buf, uint64_t count) {
+    const char* data = NULL;
 
-    // move remained data to front.
-    uint64_t remain = end - current;
-    char* p = buf;
-    while (current != end) {
-        *p = *current;
-        p++;
-        current++;
+    uint64_t readCount = this->readView(&data, count);
+    if (readCount != 0) {
+        memcpy(buf, data, readCount);
     }
 
-    return remain;
+    return readCount;
 }
 
-uint64_t S3BucketReader::read(char* buf, uint64_t count) {
+uint64_t S3BucketReader::readView(const char** data, uint64_t count) {
     S3_CHECK_OR_DIE(this->upstreamReader != NULL, S3RuntimeError, "upstreamReader is NULL");
     uint64_t readCount = 0;
     while (true) {
         if (this->needNewReader) {
-            if (this->keyIndex >= this->keyList.contents.size()) {
+            if (!this->prefetchedReaders.empty()) {
+                this->idleReaders.push_back(this->upstreamReader);
+                this->upstreamReader = this->prefetchedReaders.front();
+                this->prefetchedReaders.pop_front();
+            } else if (this->rangeIndex >= this->keyRanges.size()) {
                 S3DEBUG("Read finished for segment: %d", s3ext_segid);
                 return 0;
-            }
-            BucketContent& key = this->getNextKey();
+            } else {
+                const KeyRange& range = this->getNextKeyRange();
 
-            this->upstreamReader->open(constructReaderParams(key));
+                this->upstreamReader->open(constructReaderParams(range));
+            }
             this->needNewReader = false;
 
-            // ignore header line if it is not the first file
-            if (hasHeader && !this->isFirstFile) {
-                readCount = readWithoutHeaderLine(buf, count);
+            // readers are opened in the order of the ranges, the prefetched ones follow this one.
+            uint64_t rangeStart =
+                this->keyRanges[this->rangeIndex - this->prefetchedReaders.size() - 1].start;
+
+            this->prefetchKeyRanges();
+
+            if (hasHeader && (rangeStart == 0) && !this->isFirstFile) {
+                // ignore header line if it is not the first file
+                readCount = readWithoutHeaderLine(data, count);
                 if (readCount != 0) {
                     return readCount;
                 }
+            } else if (hasHeader && (rangeStart != 0) && this->isFirstFile) {
+                // the line skipped as header of the segment has to be a line of no data.
+                this->isFirstFile = false;
+                *data = eolString;
+                return strlen(eolString);
             }
         }
 
-        readCount = this->upstreamReader->read(buf, count);
+        readCount = this->upstreamReader->readView(data, count);
         if (readCount != 0) {
             return readCount;
         }
@@ -128,7 +533,24 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
     }
 }
 
+void S3BucketReader::prefetchKeyRanges() {
+    while (!this->idleReaders.empty() && (this->rangeIndex < this->keyRanges.size())) {
+        Reader* reader = this->idleReaders.back();
+        this->idleReaders.pop_back();
+
+        // the reader is not lost if open() throws, close() is reentrant.
+        this->prefetchedReaders.push_back(reader);
+        reader->open(constructReaderParams(this->getNextKeyRange()));
+    }
+}
+
 void S3BucketReader::close() {
+    while (!this->prefetchedReaders.empty()) {
+        this->prefetchedReaders.front()->close();
+        this->idleReaders.push_back(this->prefetchedReaders.front());
+        this->prefetchedReaders.pop_front();
+    }
+
     if (this->upstreamReader != NULL) {
         this->upstreamReader->close();
         this->upstreamReader = NULL;
@@ -137,4 +559,6 @@ void S3BucketReader::close() {
     if (!this->keyList.contents.empty()) {
         this->keyList.contents.clear();
     }
+
+    this->keyRanges.clear();
 }
\ No newline at end of file
@@ -1,15 +1,114 @@
 #include "s3common_reader.h"
 
+// A small key is read as a whole from memory, the compression type is detected from its data
+// instead of a separate GET of the magic bytes. Keys to be filtered by S3 Select, or to be
+// cached, are read as usual.
+static bool IsSmallKey(const S3Params &params) {
+    uint64_t keySize = params.getKeySize();
+    uint64_t limit = std::min(params.getSmallKeySize(), params.getChunkSize());
+    bool wholeKey = (params.getKeyRangeStart() == 0) &&
+                    ((params.getKeyRangeEnd() == 0) || (params.getKeyRangeEnd() >= keySize));
+
+    return (keySize > 0) && (keySize <= limit) && wholeKey && !params.isS3Select() &&
+           params.getReadCacheDir().empty();
+}
+
+static bool IsPartOfKey(const S3Params &params) {
+    uint64_t keySize = params.getKeySize();
+    uint64_t rangeEnd = params.getKeyRangeEnd();
+
+    return (params.getKeyRangeStart() > 0) || ((rangeEnd != 0) && (rangeEnd < keySize));
+}
+
 void S3CommonReader::open(const S3Params &params) {
     this->keyReader.setS3InterfaceService(s3InterfaceService);
 
-    S3CompressionType compressionType = s3InterfaceService->checkCompressionType(params.getS3Url());
+    if (IsSmallKey(params)) {
+        // the reader is chosen by the first read, when the data has arrived.
+        this->smallKeyReader.setS3InterfaceService(s3InterfaceService);
+        this->smallKeyReader.open(params);
+        this->smallKeyParams = params;
+        this->smallKeyPending = true;
+        return;
+    }
+
+    this->openKey(params, s3InterfaceService->checkCompressionType(params.getS3Url()));
+}
 
+void S3CommonReader::openSmallKey() {
+    this->smallKeyPending = false;
+
+    S3CompressionType compressionType = this->smallKeyReader.getCompressionType();
     switch (compressionType) {
         case S3_COMPRESSION_GZIP:
+        case S3_COMPRESSION_ZSTD:
+        case S3_COMPRESSION_LZ4:
+            this->decompressReader.setCompressionType(compressionType);
+
+            this->upstreamReader = &this->decompressReader;
+            this->decompressReader.setReader(&this->smallKeyReader);
+            this->decompressReader.open(this->smallKeyParams);
+            break;
+        case S3_COMPRESSION_PARQUET:
+            // row groups are fetched by their offsets.
+            this->smallKeyReader.close();
+            this->openKey(this->smallKeyParams, compressionType);
+            break;
+        default:
+            this->upstreamReader = &this->smallKeyReader;
+            break;
+    }
+}
+
+void S3CommonReader::openKey(const S3Params &params, S3CompressionType compressionType) {
+    S3Params readerParams = params;
+
+    // S3 Select reads CSV and gzip compressed CSV, other keys are read as usual.
+    bool selectable =
+        (compressionType == S3_COMPRESSION_PLAIN) || (compressionType == S3_COMPRESSION_GZIP);
+    if (params.isS3Select() && selectable && S3SelectCanPushDown(params.getScanDesc())) {
+        if (compressionType == S3_COMPRESSION_GZIP) {
+            if (params.getKeyRangeStart() > 0) {
+                S3DEBUG("Skip range of compressed key, it is read by the first range");
+                return;
+            }
+            readerParams.setKeyRange(0, 0);
+        }
+
+        this->selectReader.setS3InterfaceService(s3InterfaceService);
+        this->selectReader.setCompressionType(compressionType);
+        this->upstreamReader = &this->selectReader;
+        this->upstreamReader->open(readerParams);
+        return;
+    }
+
+    switch (compressionType) {
+        case S3_COMPRESSION_GZIP:
+        case S3_COMPRESSION_ZSTD:
+        case S3_COMPRESSION_LZ4:
+            if (params.isSplitCompressed() && IsPartOfKey(params) &&
+                this->openMembers(params, compressionType)) {
+                return;
+            }
+
+            // Compressed stream can't be split, the range starting at 0 reads the whole key,
+            // others have nothing to read.
+            if (params.getKeyRangeStart() > 0) {
+                S3DEBUG("Skip range of compressed key, it is read by the first range");
+                return;
+            }
+            readerParams.setKeyRange(0, 0);
+
+            this->decompressReader.setCompressionType(compressionType);
+
             this->upstreamReader = &this->decompressReader;
             this->decompressReader.setReader(&this->keyReader);
             break;
+        case S3_COMPRESSION_PARQUET:
+            // row groups are assigned to ranges by their offsets.
+            this->parquetReader.setS3InterfaceService(s3InterfaceService);
+            this->upstreamReader = &this->parquetReader;
+            break;
         case S3_COMPRESSION_PLAIN:
             this->upstreamReader = &this->keyReader;
             break;
@@ -17,17 +116,64 @@ void S3CommonReader::open(const S3Params &params) {
             S3_CHECK_OR_DIE(false, S3RuntimeError, "unknown file type");
     };
 
+    this->upstreamReader->open(readerParams);
+}
+
+// BGZF blocks and frames of zstd seekable format are decompressed independently, every range reads
+// the members starting in it.
+bool S3CommonReader::openMembers(const S3Params &params, S3CompressionType compressionType) {
+    uint64_t memberStart = 0;
+    uint64_t memberEnd = 0;
+    if (!LocateCompressedMembers(s3InterfaceService, params, compressionType, &memberStart,
+                                 &memberEnd)) {
+        S3DEBUG("Members of compressed key can't be located, it is read by the first range");
+        return false;
+    }
+
+    this->decompressReader.setCompressionType(compressionType);
+    this->decompressReader.setReader(&this->keyReader);
+
+    this->splitReader.setReader(&this->decompressReader);
+    this->splitReader.setMemberRange(memberStart, memberEnd);
+
+    this->upstreamReader = &this->splitReader;
     this->upstreamReader->open(params);
+    return true;
 }
 
 // read() attempts to read up to count bytes into the buffer.
 // Return 0 if EOF. Throw exception if encounters errors.
 uint64_t S3CommonReader::read(char *buf, uint64_t count) {
+    if (this->smallKeyPending) {
+        this->openSmallKey();
+    }
+
+    if (this->upstreamReader == NULL) {
+        return 0;
+    }
+
     return this->upstreamReader->read(buf, count);
 }
 
+uint64_t S3CommonReader::readView(const char **data, uint64_t count) {
+    if (this->smallKeyPending) {
+        this->openSmallKey();
+    }
+
+    if (this->upstreamReader == NULL) {
+        return 0;
+    }
+
+    return this->upstreamReader->readView(data, count);
+}
+
 // This should be reentrant, has no side effects when called multiple times.
 void S3CommonReader::close() {
+    if (this->smallKeyPending) {
+        this->smallKeyReader.close();
+        this->smallKeyPending = false;
+    }
+
     if (this->upstreamReader != NULL) {
         this->upstreamReader->close();
         this->upstreamReader = NULL;
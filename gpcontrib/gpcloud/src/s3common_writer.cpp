@@ -3,7 +3,11 @@
 void S3CommonWriter::open(const S3Params& params) {
     this->keyWriter.setS3InterfaceService(this->s3InterfaceService);
 
-    if (params.isAutoCompress()) {
+    // Parquet pages are compressed on their own.
+    if (params.getExportFormat() == S3_EXPORT_PARQUET) {
+        this->upstreamWriter = &this->parquetWriter;
+        this->parquetWriter.setWriter(&this->keyWriter);
+    } else if (params.isAutoCompress()) {
         this->upstreamWriter = &this->compressWriter;
         this->compressWriter.setWriter(&this->keyWriter);
     } else {
@@ -13,6 +17,10 @@ void S3CommonWriter::open(const S3Params& params) {
     this->upstreamWriter->open(params);
 }
 
+void S3CommonWriter::rollover(const S3Url& url) {
+    this->upstreamWriter->rollover(url);
+}
+
 uint64_t S3CommonWriter::write(const char* buf, uint64_t count) {
     return this->upstreamWriter->write(buf, count);
 }
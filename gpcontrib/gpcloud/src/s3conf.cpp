@@ -3,6 +3,7 @@
 #include "s3params.h"
 
 #include <arpa/inet.h>
+#include <sys/stat.h>
 
 #ifndef S3_STANDALONE
 extern "C" {
@@ -22,6 +23,8 @@ extern int getgpsegmentCount(void);
 // configurable parameters
 int32_t s3ext_segid = -1;
 int32_t s3ext_segnum = -1;
+int32_t s3ext_sessionid = 0;
+int32_t s3ext_commandid = 0;
 
 string s3ext_logserverhost;
 int32_t s3ext_loglevel = EXT_WARNING;
@@ -30,13 +33,53 @@ int32_t s3ext_logserverport = -1;
 int32_t s3ext_logsock_udp = -1;
 struct sockaddr_in s3ext_logserveraddr;
 
+// Configuration parsed from a location string, with the global log settings read along with it.
+struct S3ConfigCacheEntry {
+    S3Params params;
+    int32_t loglevel;
+    int32_t logtype;
+    string logserverhost;
+    int32_t logserverport;
+
+    // of the config file when it was parsed
+    struct timespec mtime;
+    off_t size;
+};
+
+// Parsed configurations of this backend, by location string. An entry is used as long as its
+// config file is not changed.
+static std::map<string, S3ConfigCacheEntry> s3ConfigCache;
+
+#define S3_CONFIG_CACHE_MAX_ENTRIES 16
+
+static S3Params ParseConfig(const string& urlWithOptions, const string& configPath);
+
+static string GetConfigPath(const string& urlWithOptions) {
+    string configPath = GetOptS3(urlWithOptions, "config");
+    if (configPath.empty()) {
+        S3WARN("The 'config' parameter is not provided, use default value 's3/s3.conf'.");
+        configPath = "s3/s3.conf";
+    }
+    return configPath;
+}
+
+void ClearConfigCache() {
+    s3ConfigCache.clear();
+}
+
+// Called by the main thread of a backend for every scan of a table, the config file is parsed
+// again only if it has changed since the last scan of the location.
 S3Params InitConfig(const string& urlWithOptions) {
 #ifdef S3_STANDALONE
     s3ext_segid = 0;
     s3ext_segnum = 1;
+    s3ext_sessionid = getpid();
+    s3ext_commandid = 0;
 #else
     s3ext_segid = GpIdentity.segindex;
     s3ext_segnum = getgpsegmentCount();
+    s3ext_sessionid = gp_session_id;
+    s3ext_commandid = gp_command_count;
 #endif
 
     if (s3ext_segid == -1 && s3ext_segnum > 0) {
@@ -44,15 +87,54 @@ S3Params InitConfig(const string& urlWithOptions) {
         s3ext_segnum = 1;
     }
 
-    string sourceUrl = TruncateOptions(urlWithOptions);
-    S3_CHECK_OR_DIE(!sourceUrl.empty(), S3RuntimeError, "URL not found from location string");
+    string configPath = GetConfigPath(urlWithOptions);
 
-    string configPath = GetOptS3(urlWithOptions, "config");
-    if (configPath.empty()) {
-        S3WARN("The 'config' parameter is not provided, use default value 's3/s3.conf'.");
-        configPath = "s3/s3.conf";
+    struct stat st;
+    bool statOK = (stat(configPath.c_str(), &st) == 0);
+
+    std::map<string, S3ConfigCacheEntry>::iterator it = s3ConfigCache.find(urlWithOptions);
+    if (statOK && (it != s3ConfigCache.end()) && (it->second.mtime.tv_sec == st.st_mtim.tv_sec) &&
+        (it->second.mtime.tv_nsec == st.st_mtim.tv_nsec) && (it->second.size == st.st_size)) {
+        const S3ConfigCacheEntry& entry = it->second;
+        s3ext_loglevel = entry.loglevel;
+        s3ext_logtype = entry.logtype;
+        s3ext_logserverhost = entry.logserverhost;
+        s3ext_logserverport = entry.logserverport;
+
+        CheckEssentialConfig(entry.params);
+        return entry.params;
+    }
+
+    if (it != s3ConfigCache.end()) {
+        s3ConfigCache.erase(it);
+    }
+
+    S3Params params = ParseConfig(urlWithOptions, configPath);
+
+    CheckEssentialConfig(params);
+
+    if (statOK) {
+        if (s3ConfigCache.size() >= S3_CONFIG_CACHE_MAX_ENTRIES) {
+            s3ConfigCache.clear();
+        }
+
+        S3ConfigCacheEntry& entry = s3ConfigCache[urlWithOptions];
+        entry.params = params;
+        entry.loglevel = s3ext_loglevel;
+        entry.logtype = s3ext_logtype;
+        entry.logserverhost = s3ext_logserverhost;
+        entry.logserverport = s3ext_logserverport;
+        entry.mtime = st.st_mtim;
+        entry.size = st.st_size;
     }
 
+    return params;
+}
+
+static S3Params ParseConfig(const string& urlWithOptions, const string& configPath) {
+    string sourceUrl = TruncateOptions(urlWithOptions);
+    S3_CHECK_OR_DIE(!sourceUrl.empty(), S3RuntimeError, "URL not found from location string");
+
     string configSection = GetOptS3(urlWithOptions, "section");
     if (configSection.empty()) {
         configSection = "default";
@@ -108,10 +190,98 @@ S3Params InitConfig(const string& urlWithOptions) {
 
     params.setProxy(s3Cfg.Get(configSection, "proxy", ""));
 
+    params.setListCacheDir(s3Cfg.Get(configSection, "list_cache_dir", ""));
+
+    int64_t listCacheTTL = s3Cfg.SafeScan("list_cache_ttl", configSection, 60, 0, INT_MAX);
+    params.setListCacheTTL(listCacheTTL);
+
+    int64_t listParallelism = s3Cfg.SafeScan("list_parallelism", configSection, 1, 1, 64);
+    params.setListParallelism(listParallelism);
+
+    params.setListShardPrefixes(s3Cfg.Get(configSection, "list_shard_prefixes", ""));
+
+    // an S3 Inventory report is of one table, so it's an option of the URL.
+    params.setInventoryManifest(GetOptS3(urlWithOptions, "inventory"));
+    params.setInventoryModifiedAfter(GetOptS3(urlWithOptions, "modified_after"));
+    params.setInventoryModifiedBefore(GetOptS3(urlWithOptions, "modified_before"));
+    S3_CHECK_OR_DIE(!params.getInventoryManifest().empty() ||
+                        (params.getInventoryModifiedAfter().empty() &&
+                         params.getInventoryModifiedBefore().empty()),
+                    S3ConfigError, "modified_after and modified_before need inventory",
+                    "inventory");
+
+    params.setReadCacheDir(s3Cfg.Get(configSection, "read_cache_dir", ""));
+
+    int64_t readCacheSize = s3Cfg.SafeScan("read_cache_size", configSection, 1024, 1, INT_MAX);
+    params.setReadCacheSize(readCacheSize * 1024 * 1024);
+
+    int64_t retryBackoff = s3Cfg.SafeScan("retry_backoff", configSection, 100, 0, 60000);
+    params.setRetryBackoff(retryBackoff);
+
+    int64_t requestRate = s3Cfg.SafeScan("request_rate", configSection, 0, 0, 1000000);
+    params.setRequestRate(requestRate);
+
+    params.setRequestRateDir(s3Cfg.Get(configSection, "request_rate_dir", "/tmp"));
+
+    int64_t rolloverSize = s3Cfg.SafeScan("rollover_size", configSection, 0, 0, 5 * 1024 * 1024);
+    params.setRolloverSize(rolloverSize * 1024 * 1024);
+
+    int64_t prefetchKeys =
+        s3Cfg.SafeScan("prefetch_keys", configSection, 0, 0, S3_PREFETCH_KEYS_MAX);
+    params.setPrefetchKeys(prefetchKeys);
+
+    int64_t smallKeySize = s3Cfg.SafeScan("small_key_size", configSection, 1024, 0, 128 * 1024);
+    params.setSmallKeySize(smallKeySize * 1024);
+
+    int64_t memoryPoolSize = s3Cfg.SafeScan("memory_pool_size", configSection, 0, 0, 8 * 1024);
+    params.setMemoryPoolSize(memoryPoolSize * 1024 * 1024);
+
+    int64_t memoryPoolIdleTime =
+        s3Cfg.SafeScan("memory_pool_idle_time", configSection, 60, 0, 24 * 3600);
+    params.setMemoryPoolIdleTime(memoryPoolIdleTime);
+
+    int64_t rowGroupSize = s3Cfg.SafeScan("row_group_size", configSection, 64, 1, 1024);
+    params.setRowGroupSize(rowGroupSize * 1024 * 1024);
+
+    int64_t rangeCoalesceGap =
+        s3Cfg.SafeScan("range_coalesce_gap", configSection, 1024, 0, 64 * 1024);
+    params.setRangeCoalesceGap(rangeCoalesceGap * 1024);
+
+    string exportFormat = s3Cfg.Get(configSection, "export_format", "text");
+    if (exportFormat == "parquet") {
+        params.setExportFormat(S3_EXPORT_PARQUET);
+    } else {
+        S3_CHECK_OR_DIE(exportFormat == "text", S3ConfigError,
+                        "\"FATAL: export_format is invalid\"", "export_format");
+        params.setExportFormat(S3_EXPORT_TEXT);
+    }
+
+    string parquetCodec = s3Cfg.Get(configSection, "parquet_codec", "gzip");
+    S3_CHECK_OR_DIE(parquetCodec == "none" || parquetCodec == "gzip" || parquetCodec == "zstd",
+                    S3ConfigError, "\"FATAL: parquet_codec is invalid\"", "parquet_codec");
+    params.setParquetCodec(parquetCodec);
+
     params.setAutoCompress(s3Cfg.GetBool(configSection, "autocompress", "true"));
 
     params.setVerifyCert(s3Cfg.GetBool(configSection, "verifycert", "true"));
 
+    params.setAdaptiveDownload(s3Cfg.GetBool(configSection, "adaptive_download", "false"));
+
+    params.setMultiplexIO(s3Cfg.GetBool(configSection, "multiplex_io", "false"));
+
+    params.setHedgedFetch(s3Cfg.GetBool(configSection, "hedged_fetch", "false"));
+
+    params.setS3Select(s3Cfg.GetBool(configSection, "s3_select", "false"));
+
+    params.setConditionalWrite(s3Cfg.GetBool(configSection, "conditional_write", "false"));
+
+    params.setSplitCompressed(s3Cfg.GetBool(configSection, "split_compressed", "false"));
+    params.setSplitCsv(s3Cfg.GetBool(configSection, "split_csv", "false"));
+    params.setCrc32cChecksum(s3Cfg.GetBool(configSection, "crc32c_checksum", "false"));
+
+    params.setMemoryPoolHugePages(
+        s3Cfg.GetBool(configSection, "memory_pool_huge_pages", "false"));
+
     string sse_type = s3Cfg.Get(configSection, "server_side_encryption", "");
     if (sse_type == "sse-s3") {
         params.setSSEType(SSE_S3);
@@ -121,8 +291,6 @@ S3Params InitConfig(const string& urlWithOptions) {
 
     params.setGpcheckcloud_newline(s3Cfg.Get(configSection, "gpcheckcloud_newline", "\n"));
 
-    CheckEssentialConfig(params);
-
     return params;
 }
 
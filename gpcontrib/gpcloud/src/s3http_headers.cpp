@@ -83,6 +83,16 @@ const char *GetFieldString(HeaderField f) {
             return "x-amz-content-sha256";
         case X_AMZ_SERVER_SIDE_ENCRYPTION:
             return "x-amz-server-side-encryption";
+        case IF_NONE_MATCH:
+            return "If-None-Match";
+        case X_AMZ_CHECKSUM_ALGORITHM:
+            return "x-amz-checksum-algorithm";
+        case X_AMZ_CHECKSUM_CRC32C:
+            return "x-amz-checksum-crc32c";
+        case X_AMZ_CHECKSUM_TYPE:
+            return "x-amz-checksum-type";
+        case X_AMZ_OBJECT_ATTRIBUTES:
+            return "x-amz-object-attributes";
         default:
             return "Unknown";
     }
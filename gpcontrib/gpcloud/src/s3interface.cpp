@@ -1,20 +1,8 @@
 #include "s3interface.h"
 
-// use destructor ~XMLContextHolder() to do the cleanup
-class XMLContextHolder {
-   public:
-    XMLContextHolder(xmlParserCtxtPtr ctx) : context(ctx) {
-    }
-    ~XMLContextHolder() {
-        if (context != NULL) {
-            xmlFreeDoc(context->myDoc);
-            xmlFreeParserCtxt(context);
-        }
-    }
+#include <zlib.h>
 
-   private:
-    xmlParserCtxtPtr context;
-};
+#include "s3iostats.h"
 
 S3InterfaceService::S3InterfaceService() : restfulService(NULL), params("") {
     xmlInitParser();
@@ -22,6 +10,18 @@ S3InterfaceService::S3InterfaceService() : restfulService(NULL), params("") {
 
 S3InterfaceService::S3InterfaceService(const S3Params &p) : restfulService(NULL), params(p) {
     xmlInitParser();
+
+    if (p.getRequestRate() > 0) {
+        // processes sending requests to the same bucket share one rate limiter file.
+        const S3Url &s3Url = p.getS3Url();
+        string location = s3Url.getSchema() + "://" + s3Url.getHost() + "/" + s3Url.getBucket() +
+                          "\n" + s3Url.getRegion();
+        char hash[SHA256_DIGEST_STRING_LENGTH];
+        sha256_hex(location.c_str(), hash);
+
+        this->rateLimiter.setup(p.getRequestRateDir() + "/gpcloud_rate_" + string(hash),
+                                p.getRequestRate(), s3ext_segid, s3ext_segnum, GetCurrentTimeUs());
+    }
 }
 
 S3InterfaceService::~S3InterfaceService() {
@@ -36,14 +36,28 @@ Response S3InterfaceService::getResponseWithRetries(const string &url, HTTPHeade
     uint64_t retry = retries;
 
     while (retry--) {
+        if (retry + 1 < retries) {
+            GetS3IOStats().add(S3IO_RETRIES);
+        }
         try {
-            return this->restfulService->get(url, headers);
+            this->waitForRequestRate();
+            S3IOTimer timer(S3IO_WAIT_US);
+            GetS3IOStats().add(S3IO_REQUESTS);
+            Response response = this->restfulService->get(url, headers);
+            if (response.isSuccess()) {
+                GetS3IOStats().add(S3IO_BYTES_DOWNLOADED, response.getRawData().size());
+            }
+            return response;
         } catch (S3ConnectionError &e) {
             message = e.getMessage();
+            this->checkThrottled(e);
             if (S3QueryIsAbortInProgress()) {
                 S3_DIE(S3QueryAbort, "Downloading is interrupted");
             }
             S3WARN("Failed to get a good response in GET from '%s', retrying ...", url.c_str());
+            if (retry > 0) {
+                this->waitBeforeRetry(retries - retry);
+            }
         } catch (S3LogicError &e) {
             code = e.getCode();
             if (code == "NoSuchKey") {
@@ -64,14 +78,28 @@ Response S3InterfaceService::putResponseWithRetries(const string &url, HTTPHeade
     uint64_t retry = retries;
 
     while (retry--) {
+        if (retry + 1 < retries) {
+            GetS3IOStats().add(S3IO_RETRIES);
+        }
         try {
-            return this->restfulService->put(url, headers, data);
+            this->waitForRequestRate();
+            S3IOTimer timer(S3IO_WAIT_US);
+            GetS3IOStats().add(S3IO_REQUESTS);
+            Response response = this->restfulService->put(url, headers, data);
+            if (response.isSuccess()) {
+                GetS3IOStats().add(S3IO_BYTES_UPLOADED, data.size());
+            }
+            return response;
         } catch (S3ConnectionError &e) {
             message = e.getMessage();
+            this->checkThrottled(e);
             if (S3QueryIsAbortInProgress()) {
                 S3_DIE(S3QueryAbort, "Uploading is interrupted");
             }
             S3WARN("Failed to get a good response in PUT from '%s', retrying ...", url.c_str());
+            if (retry > 0) {
+                this->waitBeforeRetry(retries - retry);
+            }
         }
     };
 
@@ -85,20 +113,65 @@ Response S3InterfaceService::postResponseWithRetries(const string &url, HTTPHead
     uint64_t retry = retries;
 
     while (retry--) {
+        if (retry + 1 < retries) {
+            GetS3IOStats().add(S3IO_RETRIES);
+        }
         try {
-            return this->restfulService->post(url, headers, data);
+            this->waitForRequestRate();
+            S3IOTimer timer(S3IO_WAIT_US);
+            GetS3IOStats().add(S3IO_REQUESTS);
+            Response response = this->restfulService->post(url, headers, data);
+            if (response.isSuccess()) {
+                GetS3IOStats().add(S3IO_BYTES_UPLOADED, data.size());
+            }
+            return response;
         } catch (S3ConnectionError &e) {
             message = e.getMessage();
+            this->checkThrottled(e);
             if (S3QueryIsAbortInProgress()) {
                 S3_DIE(S3QueryAbort, "Uploading is interrupted");
             }
             S3WARN("Failed to get a good response in POST from '%s', retrying ...", url.c_str());
+            if (retry > 0) {
+                this->waitBeforeRetry(retries - retry);
+            }
         }
     };
 
     S3_DIE(S3FailedAfterRetry, url, retries, message);
 }
 
+// Sleep for delayUs, but wake up in time for query cancellation.
+static void SleepUnlessAborted(uint64_t delayUs) {
+    while ((delayUs > 0) && !S3QueryIsAbortInProgress()) {
+        uint64_t stepUs = std::min(delayUs, (uint64_t)100 * 1000);
+        usleep(stepUs);
+        delayUs -= stepUs;
+    }
+}
+
+void S3InterfaceService::waitBeforeRetry(uint64_t attempt) {
+    uint64_t delayUs = GetBackoffWithJitterUs(this->params.getRetryBackoff() * 1000,
+                                              S3_RETRY_BACKOFF_MAX_US, attempt);
+    if (delayUs > 0) {
+        S3DEBUG("Retry in %" PRIu64 " ms", delayUs / 1000);
+    }
+
+    SleepUnlessAborted(delayUs);
+}
+
+void S3InterfaceService::waitForRequestRate() {
+    if (this->rateLimiter.isEnabled()) {
+        SleepUnlessAborted(this->rateLimiter.reserve(GetCurrentTimeUs()));
+    }
+}
+
+void S3InterfaceService::checkThrottled(S3ConnectionError &e) {
+    if (dynamic_cast<S3ThrottleError *>(&e) != NULL) {
+        this->rateLimiter.throttled(GetCurrentTimeUs());
+    }
+}
+
 bool S3InterfaceService::isKeyExisted(ResponseCode code) {
     return isSuccessfulResponse(code);
 }
@@ -109,15 +182,25 @@ ResponseCode S3InterfaceService::headResponseWithRetries(const string &url, HTTP
     uint64_t retry = retries;
 
     while (retry--) {
+        if (retry + 1 < retries) {
+            GetS3IOStats().add(S3IO_RETRIES);
+        }
         try {
+            this->waitForRequestRate();
+            S3IOTimer timer(S3IO_WAIT_US);
+            GetS3IOStats().add(S3IO_REQUESTS);
             return this->restfulService->head(url, headers);
         } catch (S3ConnectionError &e) {
             message = e.getMessage();
+            this->checkThrottled(e);
             if (S3QueryIsAbortInProgress()) {
                 S3_DIE(S3QueryAbort, "Uploading is interrupted");
             }
 
             S3WARN("Failed to get a good response in HEAD from '%s', retrying ...", url.c_str());
+            if (retry > 0) {
+                this->waitBeforeRetry(retries - retry);
+            }
         }
     };
 
@@ -130,32 +213,30 @@ Response S3InterfaceService::deleteRequestWithRetries(const string &url, HTTPHea
     uint64_t retry = retries;
 
     while (retry--) {
+        if (retry + 1 < retries) {
+            GetS3IOStats().add(S3IO_RETRIES);
+        }
         try {
+            this->waitForRequestRate();
+            S3IOTimer timer(S3IO_WAIT_US);
+            GetS3IOStats().add(S3IO_REQUESTS);
             return this->restfulService->deleteRequest(url, headers);
         } catch (S3ConnectionError &e) {
             message = e.getMessage();
+            this->checkThrottled(e);
             if (S3QueryIsAbortInProgress()) {
                 S3_DIE(S3QueryAbort, "Uploading is interrupted");
             }
             S3WARN("Failed to get a good response in DELETE from '%s', retrying ...", url.c_str());
+            if (retry > 0) {
+                this->waitBeforeRetry(retries - retry);
+            }
         }
     };
 
     S3_DIE(S3FailedAfterRetry, url, retries, message);
 };
 
-xmlParserCtxtPtr S3InterfaceService::getXMLContext(Response &response) {
-    xmlParserCtxtPtr xmlptr =
-        xmlCreatePushParserCtxt(NULL, NULL, (const char *)(response.getRawData().data()),
-                                response.getRawData().size(), "getXMLContext.xml");
-    if (xmlptr != NULL) {
-        xmlParseChunk(xmlptr, "", 0, 1);
-    } else {
-        S3ERROR("Failed to create XML parser context");
-    }
-    return xmlptr;
-}
-
 // require curl 7.17 higher
 // http://docs.aws.amazon.com/AmazonS3/latest/API/RESTBucketGET.html
 Response S3InterfaceService::getBucketResponse(const S3Url &s3Url, const string &encodedQuery) {
@@ -175,100 +256,378 @@ Response S3InterfaceService::getBucketResponse(const S3Url &s3Url, const string
     return this->getResponseWithRetries(urlWithQuery.str(), headers);
 }
 
-bool S3InterfaceService::parseBucketXML(ListBucketResult *result, xmlParserCtxtPtr xmlcontext,
-                                        string &marker) {
-    if ((result == NULL) || (xmlcontext == NULL)) {
+// Elements of a ListBucketResult the listing needs.
+enum BucketListElement {
+    BUCKET_LIST_OTHER,
+    BUCKET_LIST_NAME,
+    BUCKET_LIST_PREFIX,
+    BUCKET_LIST_IS_TRUNCATED,
+    BUCKET_LIST_NEXT_MARKER,
+    BUCKET_LIST_CONTENTS,
+    BUCKET_LIST_KEY,
+    BUCKET_LIST_SIZE,
+    BUCKET_LIST_ETAG,
+    BUCKET_LIST_COMMON_PREFIXES,
+    BUCKET_LIST_COMMON_PREFIX,
+};
+
+// State of the SAX parser of a ListBucketResult page. Keys are appended to the result as their
+// Contents end, text buffers are reused so no tree or per-node allocation is made.
+struct BucketListParser {
+    BucketListParser(ListBucketResult *result, vector<string> *commonPrefixes)
+        : result(result),
+          commonPrefixes(commonPrefixes),
+          depth(0),
+          element(BUCKET_LIST_OTHER),
+          parent(BUCKET_LIST_OTHER),
+          size(0),
+          isTruncated(false) {
+    }
+
+    ListBucketResult *result;
+    vector<string> *commonPrefixes;
+
+    int depth;  // 1 for the root element
+    BucketListElement element;
+    BucketListElement parent;  // Contents or CommonPrefixes the element is in
+    string text;               // of current element
+
+    string key;
+    uint64_t size;
+    string etag;
+
+    bool isTruncated;
+    string nextMarker;
+    string lastKey;
+};
+
+static BucketListElement GetBucketListElement(int depth, const char *name) {
+    if (depth == 2) {
+        if (strcmp(name, "Contents") == 0) {
+            return BUCKET_LIST_CONTENTS;
+        } else if (strcmp(name, "IsTruncated") == 0) {
+            return BUCKET_LIST_IS_TRUNCATED;
+        } else if (strcmp(name, "Name") == 0) {
+            return BUCKET_LIST_NAME;
+        } else if (strcmp(name, "Prefix") == 0) {
+            return BUCKET_LIST_PREFIX;
+        } else if (strcmp(name, "NextMarker") == 0) {
+            return BUCKET_LIST_NEXT_MARKER;
+        } else if (strcmp(name, "CommonPrefixes") == 0) {
+            return BUCKET_LIST_COMMON_PREFIXES;
+        }
+    } else if (depth == 3) {
+        if (strcmp(name, "Key") == 0) {
+            return BUCKET_LIST_KEY;
+        } else if (strcmp(name, "Size") == 0) {
+            return BUCKET_LIST_SIZE;
+        } else if (strcmp(name, "ETag") == 0) {
+            return BUCKET_LIST_ETAG;
+        } else if (strcmp(name, "Prefix") == 0) {
+            return BUCKET_LIST_COMMON_PREFIX;
+        }
+    }
+
+    return BUCKET_LIST_OTHER;
+}
+
+// Whether an element of depth 3 is one the listing needs in its parent.
+static bool IsBucketListChild(BucketListElement parent, BucketListElement element) {
+    if (parent == BUCKET_LIST_CONTENTS) {
+        return (element == BUCKET_LIST_KEY) || (element == BUCKET_LIST_SIZE) ||
+               (element == BUCKET_LIST_ETAG);
+    }
+    return (parent == BUCKET_LIST_COMMON_PREFIXES) && (element == BUCKET_LIST_COMMON_PREFIX);
+}
+
+static void BucketListStartElement(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+                                   const xmlChar *URI, int nbNamespaces, const xmlChar **namespaces,
+                                   int nbAttributes, int nbDefaulted, const xmlChar **attributes) {
+    xmlParserCtxtPtr xmlcontext = (xmlParserCtxtPtr)ctx;
+    BucketListParser *parser = (BucketListParser *)xmlcontext->_private;
+
+    parser->depth++;
+
+    BucketListElement element = GetBucketListElement(parser->depth, (const char *)localname);
+    if (element == BUCKET_LIST_CONTENTS) {
+        parser->key.clear();
+        parser->size = 0;
+        parser->etag.clear();
+    } else if ((parser->depth == 3) &&
+               ((parser->element != parser->parent) ||
+                !IsBucketListChild(parser->parent, element))) {
+        // Key, Size and ETag only matter in Contents, Prefix in CommonPrefixes.
+        element = BUCKET_LIST_OTHER;
+    }
+
+    if (parser->depth == 2) {
+        parser->parent = element;
+    }
+
+    if (element != BUCKET_LIST_OTHER) {
+        parser->element = element;
+        parser->text.clear();
+    }
+}
+
+static void BucketListEndElement(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+                                 const xmlChar *URI) {
+    xmlParserCtxtPtr xmlcontext = (xmlParserCtxtPtr)ctx;
+    BucketListParser *parser = (BucketListParser *)xmlcontext->_private;
+
+    BucketListElement element = GetBucketListElement(parser->depth, (const char *)localname);
+    parser->depth--;
+
+    if ((element == BUCKET_LIST_OTHER) || (element != parser->element)) {
+        return;
+    }
+
+    switch (element) {
+        case BUCKET_LIST_NAME:
+            parser->result->Name = parser->text;
+            break;
+        case BUCKET_LIST_PREFIX:
+            parser->result->Prefix = parser->text;
+            break;
+        case BUCKET_LIST_IS_TRUNCATED:
+            parser->isTruncated = (parser->text.compare(0, 4, "true") == 0);
+            break;
+        case BUCKET_LIST_NEXT_MARKER:
+            parser->nextMarker.swap(parser->text);
+            break;
+        case BUCKET_LIST_COMMON_PREFIX:
+            if (parser->commonPrefixes != NULL) {
+                parser->commonPrefixes->push_back(parser->text);
+            }
+            // a common prefix sorts where its keys would, the next page lists after it.
+            parser->lastKey.swap(parser->text);
+            break;
+        case BUCKET_LIST_KEY:
+            parser->key.swap(parser->text);
+            break;
+        case BUCKET_LIST_SIZE:
+            // Size of S3 file is a natural number, don't worry
+            parser->size = (uint64_t)atoll(parser->text.c_str());
+            break;
+        case BUCKET_LIST_ETAG:
+            parser->etag.swap(parser->text);
+            break;
+        case BUCKET_LIST_CONTENTS:
+            if (parser->size > 0) {  // skip empty item
+                parser->result->contents.emplace_back(parser->key, parser->size, parser->etag);
+            } else {
+                S3INFO("Size of \"%s\" is %" PRIu64 ", skip it", parser->key.c_str(),
+                       parser->size);
+            }
+            parser->lastKey.swap(parser->key);
+            break;
+        default:
+            break;
+    }
+
+    // children of Contents and CommonPrefixes return to it.
+    parser->element = (parser->depth == 2) ? parser->parent : BUCKET_LIST_OTHER;
+}
+
+static void BucketListCharacters(void *ctx, const xmlChar *ch, int len) {
+    xmlParserCtxtPtr xmlcontext = (xmlParserCtxtPtr)ctx;
+    BucketListParser *parser = (BucketListParser *)xmlcontext->_private;
+
+    if ((parser->element != BUCKET_LIST_OTHER) && (parser->element != BUCKET_LIST_CONTENTS) &&
+        (parser->element != BUCKET_LIST_COMMON_PREFIXES)) {
+        parser->text.append((const char *)ch, len);
+    }
+}
+
+// Errors are reported by the result of parsing, not printed.
+static void BucketListError(void *userData, xmlErrorPtr error) {
+}
+
+bool S3InterfaceService::parseBucketXML(ListBucketResult *result, const Response &response,
+                                        string &marker, vector<string> *commonPrefixes) {
+    if (result == NULL) {
+        return false;
+    }
+
+    xmlSAXHandler handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.initialized = XML_SAX2_MAGIC;
+    handler.startElementNs = BucketListStartElement;
+    handler.endElementNs = BucketListEndElement;
+    handler.characters = BucketListCharacters;
+    handler.serror = BucketListError;
+
+    xmlParserCtxtPtr xmlcontext = xmlCreatePushParserCtxt(&handler, NULL, NULL, 0, NULL);
+    if (xmlcontext == NULL) {
+        S3ERROR("Failed to create XML parser context");
         return false;
     }
 
-    xmlNode *rootElement = xmlDocGetRootElement(xmlcontext->myDoc);
-    if (rootElement == NULL) {
+    BucketListParser parser(result, commonPrefixes);
+    xmlcontext->_private = &parser;
+    xmlParseChunk(xmlcontext, (const char *)response.getRawData().data(),
+                  response.getRawData().size(), 1);
+    bool wellFormed = xmlcontext->wellFormed;
+    xmlFreeParserCtxt(xmlcontext);
+
+    if (!wellFormed) {
         S3WARN("Failed to parse returned xml of bucket list");
         return false;
     }
 
-    xmlNodePtr cur;
-    bool is_truncated = false;
-    char *content = NULL;
-    char *key = NULL;
-    char *key_size = NULL;
+    // NextMarker is only returned with a delimiter, it is the last key or common prefix.
+    if (!parser.isTruncated) {
+        marker = "";
+    } else {
+        marker = parser.nextMarker.empty() ? parser.lastKey : parser.nextMarker;
+    }
 
-    cur = rootElement->xmlChildrenNode;
-    while (cur != NULL) {
-        if (key) {
-            xmlFree(key);
-            key = NULL;
-        }
+    return true;
+}
 
-        if (!xmlStrcmp(cur->name, (const xmlChar *)"IsTruncated")) {
-            content = (char *)xmlNodeGetContent(cur);
-            if (content) {
-                if (!strncmp(content, "true", 4)) {
-                    is_truncated = true;
-                }
-                xmlFree(content);
-            }
+static string BuildListQuery(const string &marker, const string &encodedPrefix,
+                             bool delimited = false) {
+    // S3 requires query parameters specified alphabetically.
+
+    // marker and prefix are used as the values of query parameters here
+    // so URI encode their whole string, "/" also.
+    stringstream querySs;
+    if (delimited) {
+        querySs << "delimiter=%2F";
+    }
+
+    if (!marker.empty()) {
+        querySs << (delimited ? "&marker=" : "marker=") << UriEncode(marker);
+    }
+
+    if (!encodedPrefix.empty()) {
+        querySs << ((delimited || !marker.empty()) ? "&prefix=" : "prefix=") << encodedPrefix;
+    }
+
+    return querySs.str();
+}
+
+static void CheckListResponse(Response &resp) {
+    if (resp.getStatus() == RESPONSE_ERROR) {
+        S3MessageParser s3msg(resp);
+        S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
+    } else if (resp.getStatus() != RESPONSE_OK) {
+        S3_DIE(S3RuntimeError, "unexpected response status");
+    }
+}
+
+static const char *FindLast(const char *begin, const char *end, const string &pattern) {
+    const char *found = std::find_end(begin, end, pattern.begin(), pattern.end());
+    return (found == end) ? NULL : found;
+}
+
+// Replace references of escaped text, return false if an unknown one is found.
+static bool UnescapeXMLText(const string &text, string &value) {
+    static const char *entities[][2] = {
+        {"&amp;", "&"}, {"&lt;", "<"}, {"&gt;", ">"}, {"&quot;", "\""}, {"&apos;", "'"},
+    };
+
+    value.clear();
+    for (uint64_t i = 0; i < text.size();) {
+        if (text[i] != '&') {
+            value.push_back(text[i++]);
+            continue;
         }
 
-        if (!xmlStrcmp(cur->name, (const xmlChar *)"Name")) {
-            content = (char *)xmlNodeGetContent(cur);
-            if (content) {
-                result->Name = content;
-                xmlFree(content);
-            }
+        uint64_t end = text.find(';', i);
+        if (end == string::npos) {
+            return false;
         }
 
-        if (!xmlStrcmp(cur->name, (const xmlChar *)"Prefix")) {
-            content = (char *)xmlNodeGetContent(cur);
-            if (content) {
-                result->Prefix = content;
-                xmlFree(content);
-                // content is not used anymore in this loop
-                content = NULL;
+        bool known = false;
+        for (uint64_t e = 0; e < sizeof(entities) / sizeof(entities[0]); e++) {
+            if (text.compare(i, end + 1 - i, entities[e][0]) == 0) {
+                value.append(entities[e][1]);
+                known = true;
+                break;
             }
         }
+        if (!known) {
+            return false;
+        }
 
-        if (!xmlStrcmp(cur->name, (const xmlChar *)"Contents")) {
-            xmlNodePtr contNode = cur->xmlChildrenNode;
-            uint64_t size = 0;
-
-            while (contNode != NULL) {
-                // no memleak here, every content has only one Key/Size node
-                if (!xmlStrcmp(contNode->name, (const xmlChar *)"Key")) {
-                    key = (char *)xmlNodeGetContent(contNode);
-                }
-                if (!xmlStrcmp(contNode->name, (const xmlChar *)"Size")) {
-                    key_size = (char *)xmlNodeGetContent(contNode);
-                    // Size of S3 file is a natural number, don't worry
-                    size = (uint64_t)atoll((const char *)key_size);
-                }
-                contNode = contNode->next;
-            }
+        i = end + 1;
+    }
 
-            if (key) {
-                if (size > 0) {  // skip empty item
-                    result->contents.emplace_back(key, size);
-                } else {
-                    S3INFO("Size of \"%s\" is %" PRIu64 ", skip it", key, size);
-                }
-            }
+    return true;
+}
 
-            if (key_size) {
-                xmlFree(key_size);
-                key_size = NULL;
-            }
+// Guess the marker of the next page from the raw XML, so the next page can be requested before
+// this one is parsed. Return empty string if the listing is not truncated or the guess fails, the
+// parsed marker is always checked against the guess.
+static string GuessListMarker(const Response &response) {
+    const char *begin = (const char *)response.getRawData().data();
+    const char *end = begin + response.getRawData().size();
+
+    // text can't contain '<', tags are found by plain search.
+    if (FindLast(begin, end, "<IsTruncated>true</IsTruncated>") == NULL) {
+        return "";
+    }
+
+    const char *keyBegin = FindLast(begin, end, "<Key>");
+    const char *keyEnd = FindLast(begin, end, "</Key>");
+    if ((keyBegin == NULL) || (keyEnd == NULL) || (keyEnd < keyBegin)) {
+        return "";
+    }
+    keyBegin += strlen("<Key>");
+
+    string marker;
+    return UnescapeXMLText(string(keyBegin, keyEnd), marker) ? marker : "";
+}
+
+// Request of the next page of a listing, run by a thread while the current page is parsed. The
+// thread is started by listBucket() and joined by wait() or the destructor.
+struct ListPagePrefetch {
+    ListPagePrefetch(S3InterfaceService *service, const S3Url &s3Url)
+        : service(service), s3Url(s3Url), response(RESPONSE_ERROR), started(false) {
+    }
+
+    ~ListPagePrefetch() {
+        this->join();
+    }
+
+    void join() {
+        if (this->started) {
+            pthread_join(this->thread, NULL);
+            this->started = false;
         }
+    }
 
-        cur = cur->next;
+    Response wait() {
+        this->join();
+        if (this->error) {
+            std::rethrow_exception(this->error);
+        }
+        return std::move(this->response);
     }
 
-    marker = (is_truncated && key) ? key : "";
+    S3InterfaceService *service;
+    S3Url s3Url;
+    string marker;
+    string query;
 
-    if (key) {
-        xmlFree(key);
+    Response response;
+    std::exception_ptr error;
+
+    pthread_t thread;
+    bool started;
+};
+
+void *S3InterfaceService::ListPageThreadFunc(void *data) {
+    ListPagePrefetch *prefetch = (ListPagePrefetch *)data;
+
+    try {
+        prefetch->response = prefetch->service->getBucketResponse(prefetch->s3Url, prefetch->query);
+    } catch (...) {
+        prefetch->error = std::current_exception();
     }
 
-    return true;
+    return NULL;
 }
 
 // ListBucket lists all keys in given bucket with given prefix.
@@ -281,52 +640,251 @@ ListBucketResult S3InterfaceService::listBucket(S3Url &s3Url) {
     ListBucketResult result;
 
     string marker = "";
-    string encodedPrefix = s3Url.getPrefix();
+    string prefix = s3Url.getPrefix();
+    string encodedPrefix = prefix;
     FindAndReplace(encodedPrefix, "/", "%2F");
-    do {
-        // To get next set(up to 1000) keys in one iteration.
-        // S3 requires query parameters specified alphabetically.
 
-        // marker and prefix are used as the values of query parameters here
-        // so URI encode their whole string, "/" also.
+    // transfer /bucket/prefix to /bucket/?prefix=prefix because we need to "GET" a real thing
+    s3Url.setPrefix("");
+
+    // To get next set(up to 1000) keys in one iteration.
+    if (this->params.getListParallelism() > 1) {
+        return this->listBucketInParallel(s3Url, prefix);
+    }
+
+    Response resp = getBucketResponse(s3Url, BuildListQuery(marker, encodedPrefix));
+    while (true) {
+        CheckListResponse(resp);
+
+        // fetching of the next page overlaps parsing of this one.
+        ListPagePrefetch prefetch(this, s3Url);
+        string nextMarker = GuessListMarker(resp);
+        if (!nextMarker.empty()) {
+            prefetch.marker = nextMarker;
+            prefetch.query = BuildListQuery(nextMarker, encodedPrefix);
+            prefetch.started =
+                (pthread_create(&prefetch.thread, NULL, ListPageThreadFunc, &prefetch) == 0);
+        }
 
-        // transfer /bucket/prefix to /bucket/?prefix=prefix because we need to "GET" a real thing
-        stringstream querySs;
-        if (!marker.empty()) {
-            querySs << "marker=" << UriEncode(marker);
+        if (!parseBucketXML(&result, resp, marker) || marker.empty()) {
+            return result;
         }
 
-        if (!encodedPrefix.empty()) {
-            querySs << (marker.empty() ? "prefix=" : "&prefix=") << encodedPrefix;
+        if (prefetch.started && (prefetch.marker == marker)) {
+            resp = prefetch.wait();
+        } else {
+            prefetch.join();
+            resp = getBucketResponse(s3Url, BuildListQuery(marker, encodedPrefix));
         }
-        s3Url.setPrefix("");
-        string queryStr = querySs.str();
+    }
+}
 
-        Response resp = getBucketResponse(s3Url, queryStr);
+// Levels of single subdirectories findListShards() descends to find some to list in parallel.
+#define S3_LIST_SHARD_MAX_DEPTH 4
 
-        if (resp.getStatus() == RESPONSE_OK) {
-            xmlParserCtxtPtr xmlContext = getXMLContext(resp);
-            XMLContextHolder holder(xmlContext);
-            if (parseBucketXML(&result, xmlContext, marker)) {
-                continue;
+// Parts of the key space listed by the threads of listBucketInParallel(). Each thread takes the
+// next part not taken yet, until all are listed.
+struct ParallelListing {
+    ParallelListing(S3InterfaceService *service, const S3Url &s3Url,
+                    const vector<ListShard> &shards)
+        : service(service), s3Url(s3Url), shards(shards), results(shards.size()), next(0) {
+        pthread_mutex_init(&this->mutex, NULL);
+    }
+
+    ~ParallelListing() {
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    // Index of the next part to list, or the number of parts if there is none left.
+    uint64_t take() {
+        UniqueLock lock(&this->mutex);
+        return (this->next < this->shards.size()) ? this->next++ : this->shards.size();
+    }
+
+    void fail(std::exception_ptr e) {
+        UniqueLock lock(&this->mutex);
+        if (!this->error) {
+            this->error = e;
+        }
+        this->next = this->shards.size();  // the others are not worth listing anymore
+    }
+
+    S3InterfaceService *service;
+    S3Url s3Url;
+    vector<ListShard> shards;
+    vector<ListBucketResult> results;  // of each part
+
+    pthread_mutex_t mutex;
+    uint64_t next;
+    std::exception_ptr error;
+};
+
+void *S3InterfaceService::ListShardThreadFunc(void *data) {
+    ParallelListing *listing = (ParallelListing *)data;
+
+    try {
+        uint64_t i;
+        while ((i = listing->take()) < listing->shards.size()) {
+            listing->service->listShard(listing->s3Url, listing->shards[i], &listing->results[i]);
+        }
+    } catch (...) {
+        listing->fail(std::current_exception());
+    }
+
+    return NULL;
+}
+
+void S3InterfaceService::listShard(const S3Url &s3Url, const ListShard &shard,
+                                   ListBucketResult *result) {
+    string marker = shard.startAfter;
+
+    while (true) {
+        Response resp = this->getBucketResponse(s3Url, BuildListQuery(marker, shard.encodedPrefix));
+        CheckListResponse(resp);
+
+        if (!this->parseBucketXML(result, resp, marker)) {
+            return;
+        }
+
+        if (!shard.last.empty()) {
+            // keys after the last one belong to the next part.
+            while (!result->contents.empty() && (result->contents.back().name > shard.last)) {
+                result->contents.pop_back();
+            }
+            if (marker >= shard.last) {
+                return;
             }
-        } else if (resp.getStatus() == RESPONSE_ERROR) {
-            S3MessageParser s3msg(resp);
-            S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
-        } else {
-            S3_DIE(S3RuntimeError, "unexpected response status");
         }
 
-        return result;
-    } while (!marker.empty());
+        if (marker.empty()) {
+            return;
+        }
+    }
+}
 
-    return result;
+vector<ListShard> S3InterfaceService::findListShards(const S3Url &s3Url, const string &prefix,
+                                                     ListBucketResult &result) {
+    vector<ListShard> shards;
+    string encodedPrefix = prefix;
+    FindAndReplace(encodedPrefix, "/", "%2F");
+
+    // configured prefixes split the key space in ranges, any key is in one of them.
+    const string &configured = this->params.getListShardPrefixes();
+    if (!configured.empty()) {
+        vector<string> bounds;
+        stringstream ss(configured);
+        string item;
+        while (std::getline(ss, item, ',')) {
+            if (!item.empty()) {
+                bounds.push_back(prefix + item);
+            }
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+        string startAfter;
+        for (uint64_t i = 0; i < bounds.size(); i++) {
+            shards.push_back(ListShard(encodedPrefix, startAfter, bounds[i]));
+            startAfter = bounds[i];
+        }
+        shards.push_back(ListShard(encodedPrefix, startAfter));
+        return shards;
+    }
+
+    // otherwise the keys of each subdirectory are a part.
+    string dirPrefix = prefix;
+    for (int depth = 0; depth < S3_LIST_SHARD_MAX_DEPTH; depth++) {
+        vector<string> commonPrefixes;
+        string marker;
+
+        do {
+            Response resp =
+                this->getBucketResponse(s3Url, BuildListQuery(marker, encodedPrefix, true));
+            CheckListResponse(resp);
+
+            if (!this->parseBucketXML(&result, resp, marker, &commonPrefixes)) {
+                break;
+            }
+        } while (!marker.empty());
+
+        // descend into a single subdirectory, there is nothing to list in parallel.
+        if ((commonPrefixes.size() == 1) && (commonPrefixes[0].size() > dirPrefix.size())) {
+            dirPrefix = commonPrefixes[0];
+            encodedPrefix = UriEncode(dirPrefix);
+            continue;
+        }
+
+        for (uint64_t i = 0; i < commonPrefixes.size(); i++) {
+            shards.push_back(ListShard(UriEncode(commonPrefixes[i])));
+        }
+        return shards;
+    }
+
+    shards.push_back(ListShard(encodedPrefix));
+    return shards;
 }
 
-uint64_t S3InterfaceService::fetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
-                                       const S3Url &s3Url) {
-    HTTPHeaders headers;
+ListBucketResult S3InterfaceService::listBucketInParallel(const S3Url &s3Url,
+                                                          const string &prefix) {
+    ListBucketResult result;
 
+    vector<ListShard> shards = this->findListShards(s3Url, prefix, result);
+    result.Prefix = prefix;
+
+    ParallelListing listing(this, s3Url, shards);
+    vector<pthread_t> threads;
+    uint64_t numOfThreads = std::min(this->params.getListParallelism(), (uint64_t)shards.size());
+
+    for (uint64_t i = 0; i < numOfThreads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, ListShardThreadFunc, &listing) != 0) {
+            break;
+        }
+        threads.push_back(thread);
+    }
+
+    // list the parts no thread could be started for here, if any.
+    if (threads.size() < numOfThreads) {
+        ListShardThreadFunc(&listing);
+    }
+
+    for (uint64_t i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (listing.error) {
+        std::rethrow_exception(listing.error);
+    }
+
+    S3INFO("Listed %" PRIu64 " parts of prefix \"%s\" with %" PRIu64 " threads",
+           (uint64_t)shards.size(), prefix.c_str(), (uint64_t)threads.size());
+
+    // the parts are disjoint ranges in order, the keys found outside of them are merged in.
+    uint64_t numOfOthers = result.contents.size();
+    for (uint64_t i = 0; i < listing.results.size(); i++) {
+        vector<BucketContent> &contents = listing.results[i].contents;
+        if (result.Name.empty()) {
+            result.Name = listing.results[i].Name;
+        }
+        std::move(contents.begin(), contents.end(), std::back_inserter(result.contents));
+        contents.clear();
+    }
+
+    if (numOfOthers > 0) {
+        auto byName = [](const BucketContent &a, const BucketContent &b) {
+            return a.name < b.name;
+        };
+        // the ones found in several levels of subdirectories are not in order yet.
+        std::sort(result.contents.begin(), result.contents.begin() + numOfOthers, byName);
+        std::inplace_merge(result.contents.begin(), result.contents.begin() + numOfOthers,
+                           result.contents.end(), byName);
+    }
+
+    return result;
+}
+
+void S3InterfaceService::prepareFetchHeaders(HTTPHeaders &headers, uint64_t offset, uint64_t len,
+                                             const S3Url &s3Url) {
     char rangeBuf[S3_RANGE_HEADER_STRING_LEN] = {0};
     snprintf(rangeBuf, sizeof(rangeBuf), "bytes=%" PRIu64 "-%" PRIu64, offset, offset + len - 1);
     headers.Add(HOST, s3Url.getHostForCurl());
@@ -338,6 +896,12 @@ uint64_t S3InterfaceService::fetchData(uint64_t offset, S3VectorUInt8 &data, uin
 
     SignRequestV4("GET", &headers, s3Url.getRegion(), s3Url.getPathForCurl(), "",
                   this->params.getCred());
+}
+
+uint64_t S3InterfaceService::fetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                                       const S3Url &s3Url) {
+    HTTPHeaders headers;
+    this->prepareFetchHeaders(headers, offset, len, s3Url);
 
     Response resp = this->getResponseWithRetries(s3Url.getFullUrlForCurl(), headers);
     if (resp.getStatus() == RESPONSE_OK) {
@@ -352,6 +916,33 @@ uint64_t S3InterfaceService::fetchData(uint64_t offset, S3VectorUInt8 &data, uin
     }
 }
 
+S3CompressionType GetCompressionTypeFromMagic(const uint8_t *data, uint64_t len) {
+    if (len < S3_MAGIC_BYTES_NUM) {
+        return S3_COMPRESSION_PLAIN;
+    }
+
+    if ((data[0] == 0x1f) && (data[1] == 0x8b)) {
+        return S3_COMPRESSION_GZIP;
+    }
+
+    // zstd frame magic number 0xFD2FB528, in little-endian
+    if ((data[0] == 0x28) && (data[1] == 0xb5) && (data[2] == 0x2f) && (data[3] == 0xfd)) {
+        return S3_COMPRESSION_ZSTD;
+    }
+
+    // lz4 frame magic number 0x184D2204, in little-endian
+    if ((data[0] == 0x04) && (data[1] == 0x22) && (data[2] == 0x4d) && (data[3] == 0x18)) {
+        return S3_COMPRESSION_LZ4;
+    }
+
+    // Parquet file magic "PAR1"
+    if ((data[0] == 'P') && (data[1] == 'A') && (data[2] == 'R') && (data[3] == '1')) {
+        return S3_COMPRESSION_PARQUET;
+    }
+
+    return S3_COMPRESSION_PLAIN;
+}
+
 S3CompressionType S3InterfaceService::checkCompressionType(const S3Url &s3Url) {
     HTTPHeaders headers;
 
@@ -378,9 +969,7 @@ S3CompressionType S3InterfaceService::checkCompressionType(const S3Url &s3Url) {
         S3_CHECK_OR_DIE(responseData.size() == S3_MAGIC_BYTES_NUM, S3PartialResponseError,
                         S3_MAGIC_BYTES_NUM, responseData.size());
 
-        if ((responseData[0] == 0x1f) && (responseData[1] == 0x8b)) {
-            return S3_COMPRESSION_GZIP;
-        }
+        return GetCompressionTypeFromMagic(responseData.data(), responseData.size());
     } else if (resp.getStatus() == RESPONSE_ERROR) {
         S3MessageParser s3msg(resp);
         S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
@@ -406,6 +995,116 @@ bool S3InterfaceService::checkKeyExistence(const S3Url &s3Url) {
     return isKeyExisted(headResponseWithRetries(s3Url.getFullUrlForCurl(), headers));
 }
 
+// Lengths of the parts of an event stream message besides its headers and payload.
+#define S3_EVENT_PRELUDE_LEN 12
+#define S3_EVENT_CRC_LEN 4
+
+// Type of header values in the event stream, S3 Select only sends strings.
+#define S3_EVENT_HEADER_STRING 7
+
+static uint32_t ReadUInt32BE(const uint8_t *data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) |
+           (uint32_t)data[3];
+}
+
+static void ParseEventHeaders(const uint8_t *data, uint64_t len, map<string, string> &headers) {
+    uint64_t pos = 0;
+    while (pos < len) {
+        uint8_t nameLen = data[pos++];
+        S3_CHECK_OR_DIE(pos + nameLen + 3 <= len, S3RuntimeError,
+                        "Malformed header in S3 Select response");
+        string name((const char *)data + pos, nameLen);
+        pos += nameLen;
+
+        S3_CHECK_OR_DIE(data[pos] == S3_EVENT_HEADER_STRING, S3RuntimeError,
+                        "Unsupported header type in S3 Select response");
+        uint16_t valueLen = ((uint16_t)data[pos + 1] << 8) | data[pos + 2];
+        pos += 3;
+        S3_CHECK_OR_DIE(pos + valueLen <= len, S3RuntimeError,
+                        "Malformed header in S3 Select response");
+
+        headers[name] = string((const char *)data + pos, valueLen);
+        pos += valueLen;
+    }
+}
+
+void DecodeS3SelectEventStream(const uint8_t *data, uint64_t len, S3VectorUInt8 &records) {
+    uint64_t pos = 0;
+    bool ended = false;
+
+    while (pos < len) {
+        S3_CHECK_OR_DIE(len - pos >= S3_EVENT_PRELUDE_LEN + S3_EVENT_CRC_LEN, S3RuntimeError,
+                        "Truncated message in S3 Select response");
+
+        const uint8_t *message = data + pos;
+        uint32_t totalLen = ReadUInt32BE(message);
+        uint32_t headersLen = ReadUInt32BE(message + 4);
+        S3_CHECK_OR_DIE(crc32(0, message, 8) == ReadUInt32BE(message + 8), S3RuntimeError,
+                        "Prelude CRC mismatch in S3 Select response");
+        S3_CHECK_OR_DIE((totalLen <= len - pos) &&
+                            (totalLen >= S3_EVENT_PRELUDE_LEN + headersLen + S3_EVENT_CRC_LEN),
+                        S3RuntimeError, "Truncated message in S3 Select response");
+        S3_CHECK_OR_DIE(crc32(0, message, totalLen - S3_EVENT_CRC_LEN) ==
+                            ReadUInt32BE(message + totalLen - S3_EVENT_CRC_LEN),
+                        S3RuntimeError, "Message CRC mismatch in S3 Select response");
+
+        map<string, string> headers;
+        ParseEventHeaders(message + S3_EVENT_PRELUDE_LEN, headersLen, headers);
+
+        const uint8_t *payload = message + S3_EVENT_PRELUDE_LEN + headersLen;
+        uint64_t payloadLen = totalLen - S3_EVENT_PRELUDE_LEN - headersLen - S3_EVENT_CRC_LEN;
+
+        if (headers[":message-type"] == "error") {
+            S3_DIE(S3LogicError, headers[":error-code"], headers[":error-message"]);
+        }
+
+        // Stats, Progress and Cont events carry nothing to read.
+        const string &eventType = headers[":event-type"];
+        if (eventType == "Records") {
+            records.insert(records.end(), payload, payload + payloadLen);
+        } else if (eventType == "End") {
+            ended = true;
+        }
+
+        pos += totalLen;
+    }
+
+    S3_CHECK_OR_DIE(ended, S3RuntimeError, "S3 Select response ends without End event");
+}
+
+void S3InterfaceService::selectObjectContent(const S3Url &s3Url, const string &request,
+                                             S3VectorUInt8 &records) {
+    HTTPHeaders headers;
+
+    headers.Add(HOST, s3Url.getHostForCurl());
+    headers.Add(CONTENTTYPE, "application/xml");
+
+    char contentSha256[SHA256_DIGEST_STRING_LENGTH];  // 65
+    sha256_hex(request.c_str(), contentSha256);
+    headers.Add(X_AMZ_CONTENT_SHA256, contentSha256);
+
+    headers.Add(CONTENTLENGTH, std::to_string((unsigned long long)request.length()));
+
+    SignRequestV4("POST", &headers, s3Url.getRegion(), s3Url.getPathForCurl(),
+                  "select=&select-type=2", this->params.getCred());
+
+    stringstream urlWithQuery;
+    urlWithQuery << s3Url.getFullUrlForCurl() << "?select&select-type=2";
+
+    Response resp = this->postResponseWithRetries(urlWithQuery.str(), headers,
+                                                  vector<uint8_t>(request.begin(), request.end()));
+
+    if (resp.getStatus() == RESPONSE_OK) {
+        GetS3IOStats().add(S3IO_BYTES_DOWNLOADED, resp.getRawData().size());
+        DecodeS3SelectEventStream(resp.getRawData().data(), resp.getRawData().size(), records);
+    } else if (resp.getStatus() == RESPONSE_ERROR) {
+        S3MessageParser s3msg(resp);
+        S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
+    } else {
+        S3_DIE(S3RuntimeError, "unexpected response status");
+    }
+}
+
 string S3InterfaceService::getUploadId(const S3Url &s3Url) {
     HTTPHeaders headers;
 
@@ -420,6 +1119,12 @@ string S3InterfaceService::getUploadId(const S3Url &s3Url) {
         headers.Add(X_AMZ_SERVER_SIDE_ENCRYPTION, "AES256");
     }
 
+    // the store checks the CRC32C of each part, and combines them into the CRC32C of the key.
+    if (params.isCrc32cChecksum()) {
+        headers.Add(X_AMZ_CHECKSUM_ALGORITHM, "CRC32C");
+        headers.Add(X_AMZ_CHECKSUM_TYPE, "FULL_OBJECT");
+    }
+
     SignRequestV4("POST", &headers, s3Url.getRegion(), s3Url.getPathForCurl(),
                   "uploads=", this->params.getCred());
 
@@ -439,20 +1144,57 @@ string S3InterfaceService::getUploadId(const S3Url &s3Url) {
     }
 }
 
-string S3InterfaceService::uploadPartOfData(S3VectorUInt8 &data, const S3Url &s3Url,
-                                            uint64_t partNumber, const string &uploadId) {
-    HTTPHeaders headers;
+// Return the ETag header of the response, header names are lower case in HTTP/2.
+static string GetETagHeader(Response &resp) {
+    string headers(resp.getRawHeaders().begin(), resp.getRawHeaders().end());
+
+    // RFC 2616 states "HTTP/1.1 defines the sequence CR LF as the end-of-line
+    // marker for all protocol elements except the entity-body"
+    uint64_t lineStart = 0;
+    while (lineStart < headers.size()) {
+        uint64_t lineEnd = headers.find("\r\n", lineStart);
+        if (lineEnd == string::npos) {
+            lineEnd = headers.size();
+        }
+
+        if (strncasecmp(headers.c_str() + lineStart, "ETag:", 5) == 0) {
+            uint64_t valueStart = headers.find_first_not_of(' ', lineStart + 5);
+            if ((valueStart == string::npos) || (valueStart >= lineEnd)) {
+                return "";
+            }
+            return headers.substr(valueStart, lineEnd - valueStart);
+        }
+
+        lineStart = lineEnd + 2;
+    }
+
+    return "";
+}
+
+string S3InterfaceService::prepareUploadHeaders(HTTPHeaders &headers, const S3VectorUInt8 &data,
+                                                const S3Url &s3Url, uint64_t partNumber,
+                                                const string &uploadId, const string &checksum) {
     stringstream queryString;
 
     headers.Add(HOST, s3Url.getHostForCurl());
 
-    char contentSha256[SHA256_DIGEST_STRING_LENGTH];  // 65
-    sha256_hex((const char *)data.data(), data.size(), contentSha256);
-    headers.Add(X_AMZ_CONTENT_SHA256, contentSha256);
+    // TLS protects the part already, hashing it would take another pass over the whole part
+    // before uploading.
+    if (s3Url.getSchema() == "https") {
+        headers.Add(X_AMZ_CONTENT_SHA256, "UNSIGNED-PAYLOAD");
+    } else {
+        char contentSha256[SHA256_DIGEST_STRING_LENGTH];  // 65
+        sha256_hex((const char *)data.data(), data.size(), contentSha256);
+        headers.Add(X_AMZ_CONTENT_SHA256, contentSha256);
+    }
 
     headers.Add(CONTENTTYPE, "text/plain");
     // headers.Add(CONTENTLENGTH, std::to_string((unsigned long long)data.size()));
 
+    if (!checksum.empty()) {
+        headers.Add(X_AMZ_CHECKSUM_CRC32C, checksum);
+    }
+
     queryString << "partNumber=" << partNumber << "&uploadId=" << uploadId;
 
     SignRequestV4("PUT", &headers, s3Url.getRegion(), s3Url.getPathForCurl(), queryString.str(),
@@ -462,17 +1204,18 @@ string S3InterfaceService::uploadPartOfData(S3VectorUInt8 &data, const S3Url &s3
     urlWithQuery << s3Url.getFullUrlForCurl() << "?partNumber=" << partNumber
                  << "&uploadId=" << uploadId;
 
-    Response resp = this->putResponseWithRetries(urlWithQuery.str(), headers, data);
-    if (resp.getStatus() == RESPONSE_OK) {
-        string headers(resp.getRawHeaders().begin(), resp.getRawHeaders().end());
+    return urlWithQuery.str();
+}
 
-        uint64_t etagStartPos = headers.find("ETag: ") + 6;
-        string etagToEnd = headers.substr(etagStartPos);
-        // RFC 2616 states "HTTP/1.1 defines the sequence CR LF as the end-of-line
-        // marker for all protocol elements except the entity-body"
-        uint64_t etagStrLen = etagToEnd.find("\r");
+string S3InterfaceService::uploadPartOfData(S3VectorUInt8 &data, const S3Url &s3Url,
+                                            uint64_t partNumber, const string &uploadId,
+                                            const string &checksum) {
+    HTTPHeaders headers;
+    string url = this->prepareUploadHeaders(headers, data, s3Url, partNumber, uploadId, checksum);
 
-        return etagToEnd.substr(0, etagStrLen);
+    Response resp = this->putResponseWithRetries(url, headers, data);
+    if (resp.getStatus() == RESPONSE_OK) {
+        return GetETagHeader(resp);
     } else if (resp.getStatus() == RESPONSE_ERROR) {
         S3MessageParser s3msg(resp);
         S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
@@ -482,7 +1225,8 @@ string S3InterfaceService::uploadPartOfData(S3VectorUInt8 &data, const S3Url &s3
 }
 
 bool S3InterfaceService::completeMultiPart(const S3Url &s3Url, const string &uploadId,
-                                           const vector<string> &etagArray) {
+                                           const vector<string> &etagArray,
+                                           const vector<string> &checksumArray) {
     HTTPHeaders headers;
     stringstream queryString;
 
@@ -494,10 +1238,18 @@ bool S3InterfaceService::completeMultiPart(const S3Url &s3Url, const string &upl
         return false;
     }
 
+    bool withChecksums = !checksumArray.empty();
+    S3_CHECK_OR_DIE(!withChecksums || (checksumArray.size() == etagArray.size()), S3RuntimeError,
+                    "checksums don't match the parts of the upload");
+
     body << "<CompleteMultipartUpload>\n";
     for (uint64_t i = 0; i < etagArray.size(); ++i) {
         body << "  <Part>\n    <PartNumber>" << i + 1 << "</PartNumber>\n    <ETag>" << etagArray[i]
-             << "</ETag>\n  </Part>\n";
+             << "</ETag>\n";
+        if (withChecksums) {
+            body << "    <ChecksumCRC32C>" << checksumArray[i] << "</ChecksumCRC32C>\n";
+        }
+        body << "  </Part>\n";
     }
     body << "</CompleteMultipartUpload>";
 
@@ -510,6 +1262,15 @@ bool S3InterfaceService::completeMultiPart(const S3Url &s3Url, const string &upl
 
     headers.Add(CONTENTLENGTH, std::to_string((unsigned long long)body.str().length()));
 
+    // the store refuses to complete the upload if the key exists, with 412 PreconditionFailed.
+    if (this->params.isConditionalWrite()) {
+        headers.Add(IF_NONE_MATCH, "*");
+    }
+
+    if (withChecksums) {
+        headers.Add(X_AMZ_CHECKSUM_TYPE, "FULL_OBJECT");
+    }
+
     queryString << "uploadId=" << uploadId;
 
     SignRequestV4("POST", &headers, s3Url.getRegion(), s3Url.getPathForCurl(), queryString.str(),
@@ -532,6 +1293,41 @@ bool S3InterfaceService::completeMultiPart(const S3Url &s3Url, const string &upl
     }
 }
 
+string S3InterfaceService::getKeyChecksum(const S3Url &s3Url) {
+    HTTPHeaders headers;
+
+    headers.Add(HOST, s3Url.getHostForCurl());
+    headers.Add(X_AMZ_CONTENT_SHA256,
+                "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");  // sha256hex
+                                                                                      // of empty
+                                                                                      // string
+    headers.Add(X_AMZ_OBJECT_ATTRIBUTES, "Checksum");
+
+    SignRequestV4("GET", &headers, s3Url.getRegion(), s3Url.getPathForCurl(), "attributes=",
+                  this->params.getCred());
+
+    stringstream urlWithQuery;
+    urlWithQuery << s3Url.getFullUrlForCurl() << "?attributes";
+
+    Response resp = this->getResponseWithRetries(urlWithQuery.str(), headers);
+    if (resp.getStatus() == RESPONSE_ERROR) {
+        S3MessageParser s3msg(resp);
+        S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
+    } else if (resp.getStatus() != RESPONSE_OK) {
+        S3_DIE(S3RuntimeError, "unexpected response status");
+    }
+
+    S3MessageParser s3msg(resp);
+
+    // a composite checksum is of the checksums of the parts, not of the data of the key.
+    string checksum = s3msg.parseS3Tag("Checksum", "ChecksumCRC32C");
+    if ((s3msg.parseS3Tag("Checksum", "ChecksumType") == "COMPOSITE") ||
+        (checksum.find('-') != string::npos)) {
+        return "";
+    }
+    return checksum;
+}
+
 bool S3InterfaceService::abortUpload(const S3Url &s3Url, const string &uploadId) {
     HTTPHeaders headers;
     stringstream queryString;
@@ -564,3 +1360,353 @@ bool S3InterfaceService::abortUpload(const S3Url &s3Url, const string &uploadId)
         S3_DIE(S3RuntimeError, "unexpected response status");
     }
 }
+
+void S3Interface::fetchDataAsync(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                                 const S3Url &s3Url, S3FetchCallback *callback) {
+    std::exception_ptr error;
+
+    try {
+        uint64_t readLen = this->fetchData(offset, data, len, s3Url);
+        S3_CHECK_OR_DIE(readLen == len, S3PartialResponseError, len, readLen);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    callback->onFetched(error);
+}
+
+void S3Interface::uploadPartOfDataAsync(S3VectorUInt8 &data, const S3Url &s3Url,
+                                        uint64_t partNumber, const string &uploadId,
+                                        const string &checksum, S3UploadCallback *callback) {
+    string etag;
+    std::exception_ptr error;
+
+    try {
+        etag = this->uploadPartOfData(data, s3Url, partNumber, uploadId, checksum);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    callback->onUploaded(etag, error);
+}
+
+// A request run by the I/O thread of the RESTful service. Like the *ResponseWithRetries()
+// functions, it is resubmitted after connection errors. It deletes itself when it is done.
+class S3AsyncRequest : public RESTfulCallback {
+   public:
+    S3AsyncRequest(RESTfulService *service, const string &url, uint64_t retryBackoffUs,
+                   S3RateLimiter *rateLimiter)
+        : url(url),
+          service(service),
+          rateLimiter(rateLimiter),
+          retries(S3_REQUEST_MAX_RETRIES),
+          retryBackoffUs(retryBackoffUs),
+          startTimeUs(0),
+          sentUs(0) {
+    }
+    virtual ~S3AsyncRequest() {
+    }
+
+    // Return false if the service can't run the request asynchronously.
+    bool send() {
+        // like the delay of a retry, the wait for the request rate postpones the start.
+        uint64_t nowUs = GetCurrentTimeUs();
+        if (this->rateLimiter->isEnabled()) {
+            this->startTimeUs =
+                std::max(this->startTimeUs, nowUs + this->rateLimiter->reserve(nowUs));
+        }
+
+        this->sentUs = std::max(nowUs, this->startTimeUs);
+        if (this->submit()) {
+            return true;
+        }
+
+        this->rateLimiter->unreserve();
+        return false;
+    }
+
+    uint64_t getStartTimeUs() {
+        return this->startTimeUs;
+    }
+
+    void onResponse(Response &response, std::exception_ptr error) {
+        std::exception_ptr result;
+
+        GetS3IOStats().add(S3IO_REQUESTS);
+        GetS3IOStats().add(S3IO_WAIT_US, GetCurrentTimeUs() - this->sentUs);
+
+        try {
+            if (error != NULL) {
+                std::rethrow_exception(error);
+            }
+            this->handleResponse(response);
+        } catch (S3ConnectionError &e) {
+            if (dynamic_cast<S3ThrottleError *>(&e) != NULL) {
+                this->rateLimiter->throttled(GetCurrentTimeUs());
+            }
+            result = this->retry(e.getMessage());
+            if (result == NULL) {
+                return;
+            }
+        } catch (...) {
+            result = std::current_exception();
+        }
+
+        this->finish(result);
+        delete this;
+    }
+
+    string url;
+    HTTPHeaders headers;
+
+   protected:
+    virtual bool submit() = 0;
+
+    // Throw if the response is a failure.
+    virtual void handleResponse(Response &response) = 0;
+
+    virtual void finish(std::exception_ptr error) = 0;
+
+    // Return NULL if the request is resubmitted, or the error to give up with.
+    std::exception_ptr retry(const string &message) {
+        if (S3QueryIsAbortInProgress() || this->isCancelled()) {
+            return std::make_exception_ptr(S3QueryAbort());
+        }
+
+        if (--this->retries > 0) {
+            S3WARN("Failed to get a good response from '%s', retrying ...", this->url.c_str());
+            GetS3IOStats().add(S3IO_RETRIES);
+
+            // the I/O thread must not sleep, it starts the request after the delay instead.
+            uint64_t attempt = S3_REQUEST_MAX_RETRIES - this->retries;
+            this->startTimeUs =
+                GetCurrentTimeUs() +
+                GetBackoffWithJitterUs(this->retryBackoffUs, S3_RETRY_BACKOFF_MAX_US, attempt);
+            if (this->send()) {
+                return std::exception_ptr();
+            }
+        }
+
+        return std::make_exception_ptr(
+            S3FailedAfterRetry(this->url, S3_REQUEST_MAX_RETRIES, message));
+    }
+
+    RESTfulService *service;
+    S3RateLimiter *rateLimiter;
+    uint64_t retries;
+    uint64_t retryBackoffUs;
+    uint64_t startTimeUs;
+    uint64_t sentUs;
+};
+
+class S3AsyncFetch : public S3AsyncRequest {
+   public:
+    S3AsyncFetch(RESTfulService *service, const string &url, uint64_t retryBackoffUs,
+                 S3RateLimiter *rateLimiter, S3VectorUInt8 &data, uint64_t len,
+                 S3FetchCallback *callback)
+        : S3AsyncRequest(service, url, retryBackoffUs, rateLimiter),
+          data(data),
+          len(len),
+          callback(callback) {
+    }
+
+    bool submit() {
+        return this->service->getAsync(this->url, this->headers, this);
+    }
+
+    bool isCancelled() {
+        return this->callback->isCancelled();
+    }
+
+   protected:
+    void handleResponse(Response &response) {
+        if (response.getStatus() == RESPONSE_OK) {
+            this->data.swap(response.getRawData());
+            GetS3IOStats().add(S3IO_BYTES_DOWNLOADED, this->data.size());
+            S3_CHECK_OR_DIE(this->data.size() == this->len, S3PartialResponseError, this->len,
+                            this->data.size());
+        } else {
+            S3MessageParser s3msg(response);
+            S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
+        }
+    }
+
+    void finish(std::exception_ptr error) {
+        this->callback->onFetched(error);
+    }
+
+   private:
+    S3VectorUInt8 &data;
+    uint64_t len;
+    S3FetchCallback *callback;
+};
+
+class S3AsyncUpload : public S3AsyncRequest {
+   public:
+    S3AsyncUpload(RESTfulService *service, uint64_t retryBackoffUs, S3RateLimiter *rateLimiter,
+                  const S3VectorUInt8 &data, S3UploadCallback *callback)
+        : S3AsyncRequest(service, "", retryBackoffUs, rateLimiter),
+          data(data),
+          callback(callback) {
+    }
+
+    bool submit() {
+        return this->service->putAsync(this->url, this->headers, this->data, this);
+    }
+
+    bool isCancelled() {
+        return false;
+    }
+
+   protected:
+    void handleResponse(Response &response) {
+        if (response.getStatus() == RESPONSE_OK) {
+            this->etag = GetETagHeader(response);
+            GetS3IOStats().add(S3IO_BYTES_UPLOADED, this->data.size());
+        } else {
+            S3MessageParser s3msg(response);
+            S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
+        }
+    }
+
+    void finish(std::exception_ptr error) {
+        this->callback->onUploaded(this->etag, error);
+    }
+
+   private:
+    const S3VectorUInt8 &data;
+    S3UploadCallback *callback;
+    string etag;
+};
+
+void S3InterfaceService::fetchDataAsync(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                                        const S3Url &s3Url, S3FetchCallback *callback) {
+    S3AsyncFetch *fetch = new S3AsyncFetch(this->restfulService, s3Url.getFullUrlForCurl(),
+                                           this->params.getRetryBackoff() * 1000,
+                                           &this->rateLimiter, data, len, callback);
+    this->prepareFetchHeaders(fetch->headers, offset, len, s3Url);
+
+    if (!fetch->send()) {
+        delete fetch;
+        S3Interface::fetchDataAsync(offset, data, len, s3Url, callback);
+    }
+}
+
+void S3InterfaceService::uploadPartOfDataAsync(S3VectorUInt8 &data, const S3Url &s3Url,
+                                               uint64_t partNumber, const string &uploadId,
+                                               const string &checksum,
+                                               S3UploadCallback *callback) {
+    S3AsyncUpload *upload =
+        new S3AsyncUpload(this->restfulService, this->params.getRetryBackoff() * 1000,
+                          &this->rateLimiter, data, callback);
+    upload->url =
+        this->prepareUploadHeaders(upload->headers, data, s3Url, partNumber, uploadId, checksum);
+
+    if (!upload->send()) {
+        delete upload;
+        S3Interface::uploadPartOfDataAsync(data, s3Url, partNumber, uploadId, checksum, callback);
+    }
+}
+
+void S3RangeFetcher::reset(S3Interface *s3Interface, const S3Url &s3Url, uint64_t maxGap) {
+    this->s3Interface = s3Interface;
+    this->s3Url = s3Url;
+    this->maxGap = maxGap;
+    this->numOfRequests = 0;
+    this->segments.clear();
+    this->unplanned = Segment();
+}
+
+void S3RangeFetcher::plan(const vector<std::pair<uint64_t, uint64_t> > &ranges) {
+    vector<std::pair<uint64_t, uint64_t> > sorted(ranges);
+    std::sort(sorted.begin(), sorted.end());
+
+    vector<Segment> merged;
+    for (uint64_t i = 0; i < sorted.size(); i++) {
+        uint64_t offset = sorted[i].first;
+        uint64_t end = offset + sorted[i].second;
+        if (sorted[i].second == 0) {
+            continue;
+        }
+
+        if (!merged.empty()) {
+            Segment &last = merged.back();
+            uint64_t lastEnd = last.offset + last.len;
+
+            // overlapping ranges are always merged, close ones if maxGap allows.
+            bool close = (this->maxGap > 0) && (offset <= lastEnd + this->maxGap) &&
+                         (std::max(end, lastEnd) - last.offset <= S3_RANGE_COALESCE_MAX_LEN);
+            if ((offset < lastEnd) || close) {
+                last.len = std::max(end, lastEnd) - last.offset;
+                continue;
+            }
+        }
+
+        Segment segment;
+        segment.offset = offset;
+        segment.len = end - offset;
+        segment.fetched = false;
+        merged.push_back(segment);
+    }
+
+    // data already downloaded for the ranges planned before is kept if new ranges are inside it,
+    // e.g. column chunks in the end of a file read with its footer.
+    vector<Segment> fetched;
+    fetched.swap(this->segments);
+
+    vector<bool> kept(fetched.size(), false);
+    for (uint64_t i = 0; i < merged.size(); i++) {
+        bool covered = false;
+        for (uint64_t j = 0; j < fetched.size() && !covered; j++) {
+            covered = fetched[j].fetched && (fetched[j].offset <= merged[i].offset) &&
+                      (merged[i].offset + merged[i].len <= fetched[j].offset + fetched[j].len);
+            kept[j] = kept[j] || covered;
+        }
+
+        if (!covered) {
+            this->segments.push_back(merged[i]);
+        }
+    }
+
+    for (uint64_t j = 0; j < fetched.size(); j++) {
+        if (kept[j]) {
+            this->segments.push_back(Segment());
+            this->segments.back().offset = fetched[j].offset;
+            this->segments.back().len = fetched[j].len;
+            this->segments.back().fetched = true;
+            this->segments.back().data.swap(fetched[j].data);
+        }
+    }
+}
+
+void S3RangeFetcher::fetchSegment(Segment &segment) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+
+    uint64_t readLen =
+        this->s3Interface->fetchData(segment.offset, segment.data, segment.len, this->s3Url);
+    S3_CHECK_OR_DIE(readLen == segment.len, S3PartialResponseError, segment.len, readLen);
+
+    segment.fetched = true;
+    this->numOfRequests++;
+}
+
+const uint8_t *S3RangeFetcher::fetch(uint64_t offset, uint64_t len) {
+    if (len == 0) {
+        return NULL;
+    }
+
+    for (uint64_t i = 0; i < this->segments.size(); i++) {
+        Segment &segment = this->segments[i];
+        if ((segment.offset <= offset) && (offset + len <= segment.offset + segment.len)) {
+            if (!segment.fetched) {
+                this->fetchSegment(segment);
+            }
+            return segment.data.data() + (offset - segment.offset);
+        }
+    }
+
+    this->unplanned.offset = offset;
+    this->unplanned.len = len;
+    this->fetchSegment(this->unplanned);
+    return this->unplanned.data.data();
+}
@@ -0,0 +1,546 @@
+#include "s3inventory.h"
+
+#include "decompress_reader.h"
+#include "parquet_reader.h"
+#include "s3utils.h"
+
+// Nesting of arrays and objects a manifest may have, deeper ones are malformed.
+#define S3_INVENTORY_JSON_MAX_DEPTH 16
+
+// Value of the JSON of a manifest. Numbers, booleans and null keep their text.
+struct JSONValue {
+    enum Type { JSON_SCALAR, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+    JSONValue() : type(JSON_SCALAR) {
+    }
+
+    // member of an object, NULL if it is not an object or has no such member.
+    const JSONValue *get(const string &name) const {
+        for (uint64_t i = 0; (this->type == JSON_OBJECT) && (i < this->names.size()); i++) {
+            if (this->names[i] == name) {
+                return &this->items[i];
+            }
+        }
+        return NULL;
+    }
+
+    Type type;
+    string text;
+    vector<JSONValue> items;  // of arrays and objects
+    vector<string> names;     // of the members of objects
+};
+
+static void skipJSONSpace(const string &json, uint64_t &pos) {
+    while ((pos < json.size()) && isspace((unsigned char)json[pos])) {
+        pos++;
+    }
+}
+
+static void appendUTF8(string &out, uint32_t c) {
+    if (c < 0x80) {
+        out.push_back(c);
+    } else if (c < 0x800) {
+        out.push_back(0xc0 | (c >> 6));
+        out.push_back(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+        out.push_back(0xe0 | (c >> 12));
+        out.push_back(0x80 | ((c >> 6) & 0x3f));
+        out.push_back(0x80 | (c & 0x3f));
+    } else {
+        out.push_back(0xf0 | (c >> 18));
+        out.push_back(0x80 | ((c >> 12) & 0x3f));
+        out.push_back(0x80 | ((c >> 6) & 0x3f));
+        out.push_back(0x80 | (c & 0x3f));
+    }
+}
+
+static bool parseJSONHex4(const string &json, uint64_t pos, uint32_t &c) {
+    if (pos + 4 > json.size()) {
+        return false;
+    }
+
+    c = 0;
+    for (uint64_t i = pos; i < pos + 4; i++) {
+        char h = json[i];
+        c <<= 4;
+        if (h >= '0' && h <= '9') {
+            c |= h - '0';
+        } else if (h >= 'a' && h <= 'f') {
+            c |= h - 'a' + 10;
+        } else if (h >= 'A' && h <= 'F') {
+            c |= h - 'A' + 10;
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// pos is at the opening quote, it's moved past the closing one.
+static bool parseJSONString(const string &json, uint64_t &pos, string &out) {
+    out.clear();
+    pos++;
+
+    while (pos < json.size()) {
+        char c = json[pos++];
+        if (c == '"') {
+            return true;
+        } else if (c != '\\') {
+            out.push_back(c);
+            continue;
+        }
+
+        if (pos >= json.size()) {
+            return false;
+        }
+
+        c = json[pos++];
+        switch (c) {
+            case '"':
+            case '\\':
+            case '/':
+                out.push_back(c);
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u': {
+                uint32_t code;
+                if (!parseJSONHex4(json, pos, code)) {
+                    return false;
+                }
+                pos += 4;
+
+                // a surrogate pair is one character.
+                uint32_t low;
+                if ((code >= 0xd800) && (code < 0xdc00) && (pos + 6 <= json.size()) &&
+                    (json[pos] == '\\') && (json[pos + 1] == 'u') &&
+                    parseJSONHex4(json, pos + 2, low) && (low >= 0xdc00) && (low < 0xe000)) {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    pos += 6;
+                }
+                appendUTF8(out, code);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    return false;
+}
+
+static bool parseJSONValue(const string &json, uint64_t &pos, JSONValue &value, int depth) {
+    skipJSONSpace(json, pos);
+    if ((pos >= json.size()) || (depth > S3_INVENTORY_JSON_MAX_DEPTH)) {
+        return false;
+    }
+
+    char c = json[pos];
+    if (c == '"') {
+        value.type = JSONValue::JSON_STRING;
+        return parseJSONString(json, pos, value.text);
+    }
+
+    if ((c == '[') || (c == '{')) {
+        bool isObject = (c == '{');
+        char close = isObject ? '}' : ']';
+
+        value.type = isObject ? JSONValue::JSON_OBJECT : JSONValue::JSON_ARRAY;
+        pos++;
+
+        skipJSONSpace(json, pos);
+        if ((pos < json.size()) && (json[pos] == close)) {
+            pos++;
+            return true;
+        }
+
+        while (true) {
+            if (isObject) {
+                string name;
+                skipJSONSpace(json, pos);
+                if ((pos >= json.size()) || (json[pos] != '"') ||
+                    !parseJSONString(json, pos, name)) {
+                    return false;
+                }
+
+                skipJSONSpace(json, pos);
+                if ((pos >= json.size()) || (json[pos] != ':')) {
+                    return false;
+                }
+                pos++;
+                value.names.push_back(name);
+            }
+
+            value.items.push_back(JSONValue());
+            if (!parseJSONValue(json, pos, value.items.back(), depth + 1)) {
+                return false;
+            }
+
+            skipJSONSpace(json, pos);
+            if (pos >= json.size()) {
+                return false;
+            } else if (json[pos] == close) {
+                pos++;
+                return true;
+            } else if (json[pos] != ',') {
+                return false;
+            }
+            pos++;
+        }
+    }
+
+    // numbers, true, false and null.
+    uint64_t end = pos;
+    while ((end < json.size()) && (isalnum((unsigned char)json[end]) || json[end] == '-' ||
+                                   json[end] == '+' || json[end] == '.')) {
+        end++;
+    }
+    if (end == pos) {
+        return false;
+    }
+
+    value.type = JSONValue::JSON_SCALAR;
+    value.text = json.substr(pos, end - pos);
+    pos = end;
+    return true;
+}
+
+static string trimSpaces(const string &s) {
+    uint64_t begin = s.find_first_not_of(" \t");
+    if (begin == string::npos) {
+        return "";
+    }
+    return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+bool ParseInventoryManifest(const string &json, S3InventoryManifest &manifest) {
+    JSONValue root;
+    uint64_t pos = 0;
+    if (!parseJSONValue(json, pos, root, 0) || (root.type != JSONValue::JSON_OBJECT)) {
+        return false;
+    }
+
+    const JSONValue *sourceBucket = root.get("sourceBucket");
+    const JSONValue *fileFormat = root.get("fileFormat");
+    const JSONValue *fileSchema = root.get("fileSchema");
+    const JSONValue *files = root.get("files");
+    if ((sourceBucket == NULL) || (fileFormat == NULL) || (files == NULL) ||
+        (files->type != JSONValue::JSON_ARRAY)) {
+        return false;
+    }
+
+    manifest.sourceBucket = sourceBucket->text;
+    manifest.fileFormat = fileFormat->text;
+
+    // only CSV reports need the schema, Parquet ones have it in their files.
+    manifest.fileSchema.clear();
+    if (fileSchema != NULL) {
+        stringstream ss(fileSchema->text);
+        string field;
+        while (std::getline(ss, field, ',')) {
+            manifest.fileSchema.push_back(trimSpaces(field));
+        }
+    }
+
+    manifest.files.clear();
+    for (uint64_t i = 0; i < files->items.size(); i++) {
+        const JSONValue *key = files->items[i].get("key");
+        const JSONValue *size = files->items[i].get("size");
+        if ((key == NULL) || (key->type != JSONValue::JSON_STRING) || (size == NULL)) {
+            return false;
+        }
+
+        manifest.files.push_back(BucketContent(key->text, strtoull(size->text.c_str(), NULL, 10)));
+    }
+
+    return true;
+}
+
+string NormalizeInventoryTime(const string &time) {
+    // "2024-01-31T12:00:00.000Z" of CSV reports, "2024-01-31 12:00:00" of Parquet ones.
+    string normalized = time;
+    if ((normalized.size() > 10) && (normalized[10] == 'T')) {
+        normalized[10] = ' ';
+    }
+    if (!normalized.empty() && (normalized.back() == 'Z')) {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
+// Key names of CSV reports are URL encoded like form values, spaces are "+".
+static string decodeInventoryKey(const string &key) {
+    string decoded = key;
+    std::replace(decoded.begin(), decoded.end(), '+', ' ');
+    return UriDecode(decoded);
+}
+
+static int64_t findField(const vector<string> &schema, const char *name) {
+    for (uint64_t i = 0; i < schema.size(); i++) {
+        if (strcasecmp(schema[i].c_str(), name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool isInventoryTrue(const vector<string> &fields, int64_t index) {
+    return (index >= 0) && ((uint64_t)index < fields.size()) &&
+           (strcasecmp(fields[index].c_str(), "true") == 0);
+}
+
+static bool isInventoryFalse(const vector<string> &fields, int64_t index) {
+    return (index >= 0) && ((uint64_t)index < fields.size()) &&
+           (strcasecmp(fields[index].c_str(), "false") == 0);
+}
+
+void ParseInventoryCSV(const char *data, uint64_t len, const vector<string> &schema,
+                       bool encodedKeys, const S3InventoryFilter &filter,
+                       vector<BucketContent> &contents) {
+    int64_t keyIndex = findField(schema, "Key");
+    int64_t sizeIndex = findField(schema, "Size");
+    int64_t modifiedIndex = findField(schema, "LastModifiedDate");
+    int64_t etagIndex = findField(schema, "ETag");
+    int64_t latestIndex = findField(schema, "IsLatest");
+    int64_t deleteMarkerIndex = findField(schema, "IsDeleteMarker");
+
+    S3_CHECK_OR_DIE((keyIndex >= 0) && (sizeIndex >= 0), S3RuntimeError,
+                    "Inventory report has no Key or Size field");
+
+    string after = NormalizeInventoryTime(filter.modifiedAfter);
+    string before = NormalizeInventoryTime(filter.modifiedBefore);
+    S3_CHECK_OR_DIE(after.empty() || (modifiedIndex >= 0), S3RuntimeError,
+                    "Inventory report has no LastModifiedDate field");
+    S3_CHECK_OR_DIE(before.empty() || (modifiedIndex >= 0), S3RuntimeError,
+                    "Inventory report has no LastModifiedDate field");
+
+    vector<string> fields;
+    string field;
+    bool quoted = false;
+    uint64_t i = 0;
+
+    while (i <= len) {
+        char c = (i < len) ? data[i] : '\n';
+        i++;
+
+        if (quoted) {
+            if (c != '"') {
+                field.push_back(c);
+            } else if ((i < len) && (data[i] == '"')) {
+                field.push_back('"');
+                i++;
+            } else {
+                quoted = false;
+            }
+            continue;
+        }
+
+        if (c == '"') {
+            quoted = true;
+            continue;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+            continue;
+        } else if (c == '\r') {
+            continue;
+        } else if (c != '\n') {
+            field.push_back(c);
+            continue;
+        }
+
+        // end of a line.
+        fields.push_back(field);
+        field.clear();
+
+        if (fields.size() > (uint64_t)std::max(keyIndex, sizeIndex)) {
+            const string &size = fields[sizeIndex];
+            bool isSize = !size.empty() && (size.find_first_not_of("0123456789") == string::npos);
+
+            // header lines and deleted keys are skipped.
+            if (isSize && !isInventoryTrue(fields, deleteMarkerIndex) &&
+                !isInventoryFalse(fields, latestIndex)) {
+                string key = encodedKeys ? decodeInventoryKey(fields[keyIndex]) : fields[keyIndex];
+                uint64_t keySize = strtoull(size.c_str(), NULL, 10);
+
+                string modified;
+                if ((modifiedIndex >= 0) && ((uint64_t)modifiedIndex < fields.size())) {
+                    modified = NormalizeInventoryTime(fields[modifiedIndex]);
+                }
+
+                string etag;
+                if ((etagIndex >= 0) && ((uint64_t)etagIndex < fields.size()) &&
+                    !fields[etagIndex].empty()) {
+                    // listings return it quoted.
+                    etag = "\"" + fields[etagIndex] + "\"";
+                }
+
+                if ((key.compare(0, filter.prefix.size(), filter.prefix) == 0) && (keySize > 0) &&
+                    (after.empty() || (modified >= after)) &&
+                    (before.empty() || (modified < before))) {
+                    contents.emplace_back(key, keySize, etag);
+                }
+            }
+        }
+
+        fields.clear();
+    }
+}
+
+// Decompress a gzip data file of a CSV report.
+static void decompressInventoryFile(const S3VectorUInt8 &data, string &text) {
+    ZlibDecompressor decompressor;
+    decompressor.init();
+
+    const char *in = (const char *)data.data();
+    uint64_t inLen = data.size();
+    vector<char> out(S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    text.clear();
+    while (inLen > 0) {
+        uint64_t outLen = decompressor.decompress(&in, &inLen, out.data(), out.size());
+        text.append(out.data(), outLen);
+    }
+
+    decompressor.end();
+}
+
+static void readParquetInventoryFile(S3Interface *s3Interface, const S3Params &params,
+                                     const S3Url &fileUrl, uint64_t size,
+                                     const S3InventoryFilter &filter,
+                                     vector<BucketContent> &contents) {
+    S3Params fileParams = params;
+    fileParams.getS3Url() = fileUrl;
+    fileParams.setKeySize(size);
+    fileParams.setKeyRange(0, 0);
+
+    S3ScanDesc scanDesc;
+    scanDesc.columns = S3_INVENTORY_PARQUET_COLUMNS;
+    scanDesc.csv = true;
+    scanDesc.delimiter = ',';
+    scanDesc.escape = '"';
+    scanDesc.quote = '"';
+    fileParams.setScanDesc(scanDesc);
+
+    ParquetReader reader;
+    reader.setS3InterfaceService(s3Interface);
+    reader.open(fileParams);
+
+    string text;
+    const char *data;
+    uint64_t count;
+    while ((count = reader.readView(&data, S3_PARQUET_OUTPUT_CHUNKSIZE)) > 0) {
+        text.append(data, count);
+    }
+    reader.close();
+
+    ParseInventoryCSV(text.data(), text.size(), S3_INVENTORY_PARQUET_SCHEMA, false, filter,
+                      contents);
+}
+
+ListBucketResult ListBucketFromInventory(S3Interface *s3Interface, const S3Params &params) {
+    const S3Url &s3Url = params.getS3Url();
+    S3Url manifestUrl(params.getInventoryManifest(), s3Url.getSchema() == "https",
+                      s3Url.getVersion(), s3Url.getRegion());
+
+    S3_CHECK_OR_DIE(manifestUrl.isValidUrl() && !manifestUrl.getPrefix().empty(), S3ConfigError,
+                    params.getInventoryManifest() + " is not a valid inventory manifest URL",
+                    "inventory");
+
+    // the size of the manifest is found by listing it.
+    S3Url listUrl = manifestUrl;
+    ListBucketResult manifestList = s3Interface->listBucket(listUrl);
+    uint64_t manifestSize = 0;
+    for (uint64_t i = 0; i < manifestList.contents.size(); i++) {
+        if (UriEncode(manifestList.contents[i].getName()) ==
+            UriEncode(UriDecode(manifestUrl.getPrefix()))) {
+            manifestSize = manifestList.contents[i].getSize();
+        }
+    }
+    S3_CHECK_OR_DIE(manifestSize > 0, S3RuntimeError,
+                    "Inventory manifest " + params.getInventoryManifest() + " is not found");
+
+    S3VectorUInt8 manifestData;
+    s3Interface->fetchData(0, manifestData, manifestSize, manifestUrl);
+
+    S3InventoryManifest manifest;
+    S3_CHECK_OR_DIE(ParseInventoryManifest(string(manifestData.begin(), manifestData.end()),
+                                           manifest),
+                    S3RuntimeError, "Failed to parse inventory manifest");
+
+    S3_CHECK_OR_DIE(manifest.sourceBucket == s3Url.getBucket(), S3ConfigError,
+                    "Inventory manifest is of bucket " + manifest.sourceBucket + ", not of " +
+                        s3Url.getBucket(),
+                    "inventory");
+
+    S3InventoryFilter filter;
+    filter.prefix = UriDecode(s3Url.getPrefix());
+    filter.modifiedAfter = params.getInventoryModifiedAfter();
+    filter.modifiedBefore = params.getInventoryModifiedBefore();
+
+    bool isCSV = (strcasecmp(manifest.fileFormat.c_str(), "CSV") == 0);
+    bool isParquet = (strcasecmp(manifest.fileFormat.c_str(), "Parquet") == 0);
+    S3_CHECK_OR_DIE(isCSV || isParquet, S3ConfigError,
+                    "Inventory reports of format " + manifest.fileFormat + " are not supported",
+                    "inventory");
+
+    ListBucketResult result;
+    result.Name = s3Url.getBucket();
+    result.Prefix = filter.prefix;
+
+    for (uint64_t i = 0; i < manifest.files.size(); i++) {
+        const BucketContent &file = manifest.files[i];
+
+        // data files are in the bucket of the manifest.
+        string keyEncoded = UriEncode(file.getName());
+        FindAndReplace(keyEncoded, "%2F", "/");
+        S3Url fileUrl = manifestUrl;
+        fileUrl.setPrefix(keyEncoded);
+
+        if (file.getSize() == 0) {
+            continue;
+        }
+
+        if (isParquet) {
+            readParquetInventoryFile(s3Interface, params, fileUrl, file.getSize(), filter,
+                                     result.contents);
+            continue;
+        }
+
+        S3VectorUInt8 data;
+        s3Interface->fetchData(0, data, file.getSize(), fileUrl);
+
+        if (GetCompressionTypeFromMagic(data.data(), data.size()) == S3_COMPRESSION_GZIP) {
+            string text;
+            decompressInventoryFile(data, text);
+            ParseInventoryCSV(text.data(), text.size(), manifest.fileSchema, true, filter,
+                              result.contents);
+        } else {
+            ParseInventoryCSV((const char *)data.data(), data.size(), manifest.fileSchema, true,
+                              filter, result.contents);
+        }
+    }
+
+    std::sort(result.contents.begin(), result.contents.end(),
+              [](const BucketContent &a, const BucketContent &b) { return a.name < b.name; });
+
+    S3INFO("Read %" PRIu64 " keys from %" PRIu64 " files of inventory %s",
+           (uint64_t)result.contents.size(), (uint64_t)manifest.files.size(),
+           params.getInventoryManifest().c_str());
+
+    return result;
+}
@@ -0,0 +1,34 @@
+#include "s3iostats.h"
+
+#include "s3utils.h"
+
+const char *S3IOCounterNames[S3IO_NUM_COUNTERS] = {
+    "requests",       "retries", "throttles",     "bytes_downloaded",
+    "bytes_uploaded", "wait_us", "decompress_us",
+};
+
+void S3IOStats::reset() {
+    for (int i = 0; i < S3IO_NUM_COUNTERS; i++) {
+        this->counters[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+string S3IOStats::toString() const {
+    stringstream ss;
+    for (int i = 0; i < S3IO_NUM_COUNTERS; i++) {
+        ss << (i ? ", " : "") << S3IOCounterNames[i] << "=" << this->get((S3IOCounter)i);
+    }
+    return ss.str();
+}
+
+S3IOStats &GetS3IOStats() {
+    static S3IOStats stats;
+    return stats;
+}
+
+S3IOTimer::S3IOTimer(S3IOCounter counter) : counter(counter), startUs(GetCurrentTimeUs()) {
+}
+
+S3IOTimer::~S3IOTimer() {
+    GetS3IOStats().add(this->counter, GetCurrentTimeUs() - this->startUs);
+}
@@ -5,30 +5,241 @@
 Range OffsetMgr::getNextOffset() {
     Range ret;
 
-    pthread_mutex_lock(&this->offsetLock);
-    ret.offset = std::min(this->curPos, this->keySize);
+    // size of the next range depends on where it starts, so it can't be a plain fetch_add.
+    uint64_t curPos = this->curPos.load(std::memory_order_relaxed);
+    uint64_t nextPos;
+    do {
+        ret.offset = std::min(curPos, this->keySize);
+
+        uint64_t end = this->keySize;
+        uint64_t size = this->chunkSize;
+
+        if (this->softEnd != 0 && this->softEnd < this->keySize) {
+            if (curPos < this->softEnd) {
+                end = this->softEnd;
+            } else {
+                size = std::min(this->chunkSize, (uint64_t)S3_RANGE_TAIL_CHUNKSIZE);
+            }
+        }
+
+        if (curPos + size > end) {
+            ret.length = end - ret.offset;
+            nextPos = std::max(curPos, end);
+        } else {
+            ret.length = size;
+            nextPos = curPos + size;
+        }
+    } while ((nextPos != curPos) &&
+             !this->curPos.compare_exchange_weak(curPos, nextPos, std::memory_order_relaxed));
+
+    return ret;
+}
+
+FetchLimiter::FetchLimiter() {
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->cond, NULL);
+    this->reset(1, 1, 0);
+}
+
+FetchLimiter::~FetchLimiter() {
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->cond);
+}
+
+void FetchLimiter::reset(uint64_t maxLimit, uint64_t initLimit, uint64_t nowUs) {
+    UniqueLock lock(&this->mutex);
+
+    this->maxLimit = std::max(maxLimit, (uint64_t)1);
+    this->limit = std::max(std::min(initLimit, this->maxLimit), (uint64_t)1);
+    this->inFlight = 0;
+    this->stopped = false;
+
+    this->bestThroughput = 0;
+    this->bestLatencyUs = 0;
+
+    this->roundStartUs = nowUs;
+    this->roundBytes = 0;
+    this->roundLatencyUs = 0;
+    this->roundRequests = 0;
+}
+
+bool FetchLimiter::acquire() {
+    UniqueLock lock(&this->mutex);
 
-    if (this->curPos + this->chunkSize > this->keySize) {
-        ret.length = this->keySize - this->curPos;
-        this->curPos = this->keySize;
+    while (this->inFlight >= this->limit && !this->stopped) {
+        pthread_cond_wait(&this->cond, &this->mutex);
+    }
+
+    if (this->stopped) {
+        return false;
+    }
+
+    this->inFlight++;
+    return true;
+}
+
+void FetchLimiter::release(uint64_t bytes, uint64_t latencyUs, uint64_t nowUs) {
+    UniqueLock lock(&this->mutex);
+
+    this->inFlight--;
+
+    this->roundBytes += bytes;
+    this->roundLatencyUs += latencyUs;
+    this->roundRequests++;
+
+    if (this->roundRequests >= this->limit) {
+        uint64_t elapsedUs = std::max(nowUs - this->roundStartUs, (uint64_t)1);
+        uint64_t throughput = this->roundBytes * 1000000 / elapsedUs;
+        uint64_t latency = this->roundLatencyUs / this->roundRequests;
+
+        if (throughput > this->bestThroughput + this->bestThroughput / 10) {
+            // more requests in flight still help.
+            this->bestThroughput = throughput;
+            this->bestLatencyUs = latency;
+            if (this->limit < this->maxLimit) {
+                this->limit++;
+            }
+        } else if ((throughput < this->bestThroughput - this->bestThroughput / 5) ||
+                   (latency > this->bestLatencyUs * 2)) {
+            // bandwidth is saturated or the server is throttling, start over from here.
+            this->bestThroughput = throughput;
+            this->bestLatencyUs = latency;
+            if (this->limit > 1) {
+                this->limit--;
+            }
+        }
+
+        S3DEBUG("Fetched %" PRIu64 " bytes/s with %" PRIu64 " us latency, %" PRIu64
+                " requests in flight at most",
+                throughput, latency, this->limit);
+
+        this->roundStartUs = nowUs;
+        this->roundBytes = 0;
+        this->roundLatencyUs = 0;
+        this->roundRequests = 0;
+    }
+
+    pthread_cond_broadcast(&this->cond);
+}
+
+void FetchLimiter::stop() {
+    UniqueLock lock(&this->mutex);
+
+    this->stopped = true;
+    pthread_cond_broadcast(&this->cond);
+}
+
+uint64_t FetchLimiter::getLimit() {
+    UniqueLock lock(&this->mutex);
+    return this->limit;
+}
+
+LatencyTracker::LatencyTracker() : next(0) {
+    pthread_mutex_init(&this->mutex, NULL);
+}
+
+LatencyTracker::~LatencyTracker() {
+    pthread_mutex_destroy(&this->mutex);
+}
+
+void LatencyTracker::reset() {
+    UniqueLock lock(&this->mutex);
+    this->samples.clear();
+    this->next = 0;
+}
+
+void LatencyTracker::add(uint64_t latencyUs) {
+    UniqueLock lock(&this->mutex);
+
+    if (this->samples.size() < S3_HEDGE_LATENCY_WINDOW) {
+        this->samples.push_back(latencyUs);
     } else {
-        ret.length = this->chunkSize;
-        this->curPos += this->chunkSize;
+        this->samples[this->next] = latencyUs;
+        this->next = (this->next + 1) % S3_HEDGE_LATENCY_WINDOW;
     }
-    pthread_mutex_unlock(&this->offsetLock);
+}
 
-    return ret;
+uint64_t LatencyTracker::getP95() {
+    vector<uint64_t> sorted;
+    {
+        UniqueLock lock(&this->mutex);
+        if (this->samples.size() < S3_HEDGE_MIN_SAMPLES) {
+            return 0;
+        }
+        sorted = this->samples;
+    }
+
+    uint64_t index = (sorted.size() * 95 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return std::max(sorted[index], (uint64_t)1);
 }
 
+// A fetch of a range of a chunk into its own buffer, so that the chunk can take the data of the
+// first to finish while a hedged fetch races it.
+class ChunkFetch : public S3FetchCallback {
+   public:
+    ChunkFetch(ChunkBuffer* chunk, uint64_t generation, bool hedge, uint64_t offset, uint64_t len,
+               const S3MemoryContext& context)
+        : chunk(chunk),
+          generation(generation),
+          hedge(hedge),
+          superseded(false),
+          offset(offset),
+          len(len),
+          startUs(GetCurrentTimeUs()),
+          data(context) {
+    }
+
+    bool isCancelled() {
+        return this->superseded || this->chunk->isError();
+    }
+
+    void onFetched(std::exception_ptr error) {
+        this->chunk->finishFetch(this, error);
+    }
+
+    ChunkBuffer* chunk;
+    uint64_t generation;
+    bool hedge;
+    bool superseded;  // the other fetch of the race finished first
+    uint64_t offset;
+    uint64_t len;
+    uint64_t startUs;
+    S3VectorUInt8 data;
+};
+
 ChunkBuffer::ChunkBuffer(const S3Url& s3Url, S3KeyReader& reader, const S3MemoryContext& context)
     : s3Url(s3Url), chunkData(context), offsetMgr(reader.getOffsetMgr()), sharedKeyReader(reader) {
     s3Interface = NULL;
     Range range = offsetMgr.getNextOffset();
     curFileOffset = range.offset;
     chunkDataSize = range.length;
+    chunkCrc = 0;
     status = ReadyToFill;
     eof = false;
+    drained = false;
     curChunkOffset = 0;
+    generation = 0;
+    fetching = false;
+    fetchStartUs = 0;
+    hedgeStarted = false;
+    hedgeGeneration = 0;
+    racers = 0;
+    filling = false;
+    fillGeneration = 0;
+    primaryFetch = NULL;
+    hedgeFetch = NULL;
+    pthread_mutex_init(&this->statusMutex, NULL);
+    pthread_cond_init(&this->statusCondVar, NULL);
+}
+
+ChunkBuffer::ChunkBuffer(const ChunkBuffer& other)
+    : s3Url(other.s3Url),
+      chunkData(other.chunkData),
+      offsetMgr(other.offsetMgr),
+      s3Interface(other.s3Interface),
+      sharedKeyReader(other.sharedKeyReader) {
+    *this = other;
     pthread_mutex_init(&this->statusMutex, NULL);
     pthread_cond_init(&this->statusCondVar, NULL);
 }
@@ -41,10 +252,22 @@ ChunkBuffer::~ChunkBuffer() {
 ChunkBuffer& ChunkBuffer::operator=(const ChunkBuffer& other) {
     this->s3Url = other.s3Url;
     this->eof = other.eof;
-    this->status = other.status;
+    this->drained = other.drained;
+    this->status = other.status.load();
     this->curFileOffset = other.curFileOffset;
     this->curChunkOffset = other.curChunkOffset;
     this->chunkDataSize = other.chunkDataSize;
+    this->chunkCrc = other.chunkCrc;
+    this->generation = other.generation;
+    this->fetching = other.fetching;
+    this->fetchStartUs = other.fetchStartUs;
+    this->hedgeStarted = other.hedgeStarted;
+    this->hedgeGeneration = other.hedgeGeneration;
+    this->racers = other.racers;
+    this->filling = other.filling;
+    this->fillGeneration = other.fillGeneration;
+    this->primaryFetch = other.primaryFetch;
+    this->hedgeFetch = other.hedgeFetch;
 
     return *this;
 }
@@ -52,15 +275,32 @@ ChunkBuffer& ChunkBuffer::operator=(const ChunkBuffer& other) {
 // ret < len means EMPTY
 // that's why it checks if leftLen is larger than *or equal to* len below[1], provides a chance ret
 // is 0, which is smaller than len. Otherwise, other functions won't know when to read next buffer.
-uint64_t ChunkBuffer::read(char* buf, uint64_t len) {
+uint64_t ChunkBuffer::readView(const char** data, uint64_t len) {
     // GPDB abort signal stops s3_import(), this check is not needed if s3_import() every time calls
     // ChunkBuffer->Read() only once, otherwise(as we did in downstreamReader->read() for
     // decompression feature before), first call sets buffer to ReadyToFill, second call hangs.
     S3_CHECK_OR_DIE(!S3QueryIsAbortInProgress(), S3QueryAbort, "");
 
+    // waking up from the condition variable takes longer than a chunk filled meanwhile.
+    for (int i = 0; (i < S3_CHUNK_SPIN_COUNT) && (this->status.load() != ReadyToRead); i++) {
+        sched_yield();
+    }
+
     UniqueLock statusLock(&this->statusMutex);
     while (this->status != ReadyToRead) {
-        pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
+        // the reader waits for chunks in order, race a straggling fetch instead of waiting it.
+        uint64_t hedgeTimeUs = this->getHedgeTimeUs();
+        if (hedgeTimeUs == 0) {
+            pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
+            continue;
+        }
+
+        uint64_t nowUs = GetCurrentTimeUs();
+        if (nowUs >= hedgeTimeUs) {
+            this->startHedge();
+        } else {
+            CondTimedWaitUs(&this->statusCondVar, &this->statusMutex, hedgeTimeUs - nowUs);
+        }
     }
 
     // Error is shared between all chunks.
@@ -71,13 +311,29 @@ uint64_t ChunkBuffer::read(char* buf, uint64_t len) {
     uint64_t leftLen = this->chunkDataSize - this->curChunkOffset;
     uint64_t lenToRead = std::min(len, leftLen);
 
-    if (lenToRead != 0) {
-        memcpy(buf, this->chunkData.data() + this->curChunkOffset, lenToRead);
-    }
+    *data = (const char*)this->chunkData.data() + this->curChunkOffset;
 
     if (len <= leftLen) {                   // [1]
         this->curChunkOffset += lenToRead;  // not empty
-    } else {                                // empty, reset everything
+    } else {                                // empty, reset everything in releaseView()
+        this->drained = true;
+    }
+
+    return lenToRead;
+}
+
+void ChunkBuffer::releaseView() {
+    if (!this->drained) {
+        return;
+    }
+
+    bool refill = false;
+    bool raceFinished = false;
+
+    {
+        UniqueLock statusLock(&this->statusMutex);
+
+        this->drained = false;
         this->curChunkOffset = 0;
 
         if (!this->isEOF()) {
@@ -89,59 +345,375 @@ uint64_t ChunkBuffer::read(char* buf, uint64_t len) {
             Range range = this->offsetMgr.getNextOffset();
             this->curFileOffset = range.offset;
             this->chunkDataSize = range.length;
+            this->generation++;
+
+            // the downloading thread is still in a fetch of an older range, which lost a hedged
+            // race, let the reader hedge the new range as well instead of waiting for it.
+            if (this->filling) {
+                this->fetching = true;
+                this->fetchStartUs = GetCurrentTimeUs();
+                this->hedgeStarted = false;
+
+                // the data of the winner is released, the memory the loser holds is what this
+                // chunk uses anyway.
+                if ((this->racers > 0) && (this->fillGeneration == this->hedgeGeneration)) {
+                    this->racers = 0;
+                    raceFinished = true;
+                }
+            }
 
             pthread_cond_signal(&this->statusCondVar);
+
+            refill = this->sharedKeyReader.isMultiplexed();
         }
     }
 
+    if (raceFinished) {
+        this->sharedKeyReader.hedgeFinished();
+    }
+
+    // there is no downloading thread waiting for ReadyToFill in multiplexed mode.
+    if (refill) {
+        this->startFill();
+    }
+}
+
+uint64_t ChunkBuffer::read(char* buf, uint64_t len) {
+    const char* data = NULL;
+
+    uint64_t lenToRead = this->readView(&data, len);
+    if (lenToRead != 0) {
+        memcpy(buf, data, lenToRead);
+    }
+
+    this->releaseView();
+
     return lenToRead;
 }
 
 // returning uint64_t(-1) means error
 uint64_t ChunkBuffer::fill() {
-    UniqueLock statusLock(&this->statusMutex);
+    S3ReadCache& readCache = this->sharedKeyReader.getReadCache();
+    const string& etag = this->sharedKeyReader.getKeyETag();
+    bool adaptive = this->sharedKeyReader.isAdaptive();
+    FetchLimiter& limiter = this->sharedKeyReader.getFetchLimiter();
 
-    while (this->status != ReadyToFill) {
-        pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
-    }
+    uint64_t offset = 0;
+    uint64_t leftLen = 0;
+    uint64_t generation = 0;
+    uint64_t startUs = 0;
 
-    if (S3QueryIsAbortInProgress() || this->isError()) {
-        this->setSharedError(true);
-        this->status = ReadyToRead;
+    {
+        UniqueLock statusLock(&this->statusMutex);
+
+        while (this->status != ReadyToFill) {
+            pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
+        }
+
+        if (S3QueryIsAbortInProgress() || this->isError()) {
+            this->setSharedError(true);
+            this->status = ReadyToRead;
+            pthread_cond_signal(&this->statusCondVar);
+            return -1;
+        }
+
+        offset = this->curFileOffset;
+        leftLen = this->chunkDataSize;
+
+        bool cached = false;
+        if ((leftLen != 0) && readCache.load(this->s3Url, etag, offset, leftLen, this->chunkData)) {
+            S3DEBUG("Got %" PRIu64 " bytes from read cache", leftLen);
+            cached = true;
+        }
+
+        if ((leftLen == 0) || cached) {
+            this->markReadyToRead(false);
+            return this->eof ? 0 : leftLen;
+        }
+
+        // stopped by close().
+        if (adaptive && !limiter.acquire()) {
+            this->setSharedError(true);
+            this->status = ReadyToRead;
+            pthread_cond_signal(&this->statusCondVar);
+            return -1;
+        }
+
+        generation = this->generation;
+        startUs = GetCurrentTimeUs();
+        if (!this->fetching) {
+            this->fetchStartUs = startUs;
+            this->hedgeStarted = false;
+        } else if ((this->racers > 0) && (this->hedgeGeneration == generation)) {
+            // joins the race of a hedged fetch started while this thread was busy.
+            this->racers++;
+        }
+        this->fetching = true;
+        this->filling = true;
+        this->fillGeneration = generation;
+
+        // the reader might be waiting for this range without a time to hedge it.
         pthread_cond_signal(&this->statusCondVar);
-        return -1;
     }
 
-    uint64_t offset = this->curFileOffset;
-    uint64_t leftLen = this->chunkDataSize;
-
+    // the status lock is not held while downloading, a hedged fetch might finish the range first.
+    S3VectorUInt8 data(this->chunkData.get_allocator());
+    std::exception_ptr error;
     uint64_t readLen = 0;
 
-    if (leftLen != 0) {
-        try {
-            readLen = this->s3Interface->fetchData(offset, this->chunkData, leftLen, this->s3Url);
-            if (readLen != leftLen) {
-                S3DEBUG("Failed to fetch expected data from S3");
-                this->setSharedError(true, S3PartialResponseError(leftLen, readLen));
-            } else {
-                S3DEBUG("Got %" PRIu64 " bytes from S3", readLen);
-            }
-        } catch (S3Exception& e) {
+    try {
+        readLen = this->s3Interface->fetchData(offset, data, leftLen, this->s3Url);
+        if (readLen != leftLen) {
             S3DEBUG("Failed to fetch expected data from S3");
+            error = std::make_exception_ptr(S3PartialResponseError(leftLen, readLen));
+        } else {
+            S3DEBUG("Got %" PRIu64 " bytes from S3", readLen);
+        }
+    } catch (S3Exception& e) {
+        S3DEBUG("Failed to fetch expected data from S3");
+        error = std::current_exception();
+    }
+
+    if (adaptive) {
+        uint64_t endUs = GetCurrentTimeUs();
+        limiter.release(readLen, endUs - startUs, endUs);
+    }
+
+    bool raceFinished = false;
+    bool eof = false;
+    {
+        UniqueLock statusLock(&this->statusMutex);
+        this->filling = false;
+        raceFinished = this->completeFetch(generation, false, startUs, data, error);
+        eof = this->eof;
+    }
+
+    if (raceFinished) {
+        this->sharedKeyReader.hedgeFinished();
+    }
+
+    if (this->isError()) {
+        return -1;
+    }
+
+    // Nothing to read at EOF
+    return eof ? 0 : leftLen;
+}
+
+void ChunkBuffer::startFill() {
+    ChunkFetch* fetch = NULL;
+
+    {
+        UniqueLock statusLock(&this->statusMutex);
+
+        if (S3QueryIsAbortInProgress() || this->isError()) {
             this->setSharedError(true);
+            this->markReadyToRead(false);
+            return;
+        }
+
+        uint64_t offset = this->curFileOffset;
+        uint64_t len = this->chunkDataSize;
+
+        S3ReadCache& readCache = this->sharedKeyReader.getReadCache();
+        const string& etag = this->sharedKeyReader.getKeyETag();
+
+        if (len == 0) {
+            this->markReadyToRead(false);
+            return;
+        } else if (readCache.load(this->s3Url, etag, offset, len, this->chunkData)) {
+            S3DEBUG("Got %" PRIu64 " bytes from read cache", len);
+            this->markReadyToRead(false);
+            return;
+        }
+
+        fetch = new ChunkFetch(this, this->generation, false, offset, len,
+                               this->chunkData.get_allocator());
+        this->primaryFetch = fetch;
+        this->fetching = true;
+        this->fetchStartUs = fetch->startUs;
+        this->hedgeStarted = false;
+    }
+
+    // fetch is deleted by finishFetch(), which is called after the fetch is sent.
+    this->sharedKeyReader.fetchStarted();
+    this->s3Interface->fetchDataAsync(fetch->offset, fetch->data, fetch->len, this->s3Url, fetch);
+}
+
+void ChunkBuffer::finishFetch(ChunkFetch* fetch, std::exception_ptr error) {
+    if (error != NULL) {
+        S3DEBUG("Failed to fetch expected data from S3");
+    } else {
+        S3DEBUG("Got %" PRIu64 " bytes from S3", fetch->len);
+    }
+
+    bool raceFinished = false;
+    {
+        UniqueLock statusLock(&this->statusMutex);
+
+        if (this->primaryFetch == fetch) {
+            this->primaryFetch = NULL;
+        }
+        if (this->hedgeFetch == fetch) {
+            this->hedgeFetch = NULL;
+        }
+
+        raceFinished =
+            this->completeFetch(fetch->generation, fetch->hedge, fetch->startUs, fetch->data, error);
+    }
+
+    delete fetch;
+
+    if (raceFinished) {
+        this->sharedKeyReader.hedgeFinished();
+    }
+
+    // must be the last, the reader might be closed as soon as all fetches are finished.
+    this->sharedKeyReader.fetchFinished();
+}
+
+bool ChunkBuffer::completeFetch(uint64_t generation, bool hedge, uint64_t startUs,
+                                S3VectorUInt8& data, std::exception_ptr error) {
+    bool raceFinished = false;
+    if ((this->racers > 0) && (generation == this->hedgeGeneration)) {
+        this->racers--;
+        raceFinished = (this->racers == 0);
+    }
+
+    // the other fetch of the race finished the range first.
+    if ((generation != this->generation) || !this->fetching) {
+        S3DEBUG("Drop the fetch of a range which is finished already");
+        return raceFinished;
+    }
+
+    if (error != NULL) {
+        // the first fetch is still running, and it has retries of its own.
+        if (hedge) {
+            S3DEBUG("Hedged fetch failed, wait for the first one");
+            return raceFinished;
         }
+
+        this->setSharedError(true, error);
+        this->fetching = false;
+        this->markReadyToRead(false);
+        return raceFinished;
     }
 
-    if (offset + leftLen >= offsetMgr.getKeySize()) {
-        readLen = 0;  // Nothing to read, EOF
+    if (this->primaryFetch != NULL) {
+        this->primaryFetch->superseded = true;
+    }
+    if (this->hedgeFetch != NULL) {
+        this->hedgeFetch->superseded = true;
+    }
+
+    if (hedge) {
+        S3DEBUG("Hedged fetch of %" PRIu64 " bytes finished first", this->chunkDataSize);
+    }
+
+    if (this->chunkDataSize == this->offsetMgr.getChunkSize()) {
+        this->sharedKeyReader.getLatencyTracker().add(GetCurrentTimeUs() - startUs);
+    }
+
+    this->chunkData.swap(data);
+    this->fetching = false;
+    this->markReadyToRead(true);
+
+    return raceFinished;
+}
+
+void ChunkBuffer::markReadyToRead(bool fetched) {
+    if (fetched && !this->isError()) {
+        this->sharedKeyReader.getReadCache().save(
+            this->s3Url, this->sharedKeyReader.getKeyETag(), this->curFileOffset, this->chunkData);
+    }
+
+    // computed by the filling thread, so the reader only combines the CRC32C of chunks.
+    this->chunkCrc = 0;
+    if (this->sharedKeyReader.isVerifyingChecksum() && !this->isError() &&
+        (this->chunkData.size() >= this->chunkDataSize)) {
+        this->chunkCrc = Crc32c(0, this->chunkData.data(), this->chunkDataSize);
+    }
+
+    if (this->curFileOffset + this->chunkDataSize >= this->offsetMgr.getKeySize()) {
         S3DEBUG("Reached the end of file");
         this->eof = true;
     }
 
     this->status = ReadyToRead;
     pthread_cond_signal(&this->statusCondVar);
+}
+
+uint64_t ChunkBuffer::getHedgeTimeUs() {
+    // only full chunks are hedged, the latencies of smaller ones are not comparable.
+    if (!this->sharedKeyReader.isHedgedFetch() || !this->fetching || this->hedgeStarted ||
+        (this->chunkDataSize != this->offsetMgr.getChunkSize())) {
+        return 0;
+    }
+
+    uint64_t p95 = this->sharedKeyReader.getLatencyTracker().getP95();
+    if (p95 == 0) {
+        return 0;
+    }
 
-    return (this->isError()) ? -1 : readLen;
+    return this->fetchStartUs + std::max(p95, (uint64_t)S3_HEDGE_MIN_DELAY_US);
+}
+
+static void* HedgeThreadFunc(void* data) {
+    MaskThreadSignals();
+
+    ChunkFetch* fetch = static_cast<ChunkFetch*>(data);
+    S3Interface* s3Interface = fetch->chunk->getS3InterfaceService();
+
+    std::exception_ptr error;
+    try {
+        uint64_t readLen = s3Interface->fetchData(fetch->offset, fetch->data, fetch->len,
+                                                  fetch->chunk->getS3Url());
+        if (readLen != fetch->len) {
+            error = std::make_exception_ptr(S3PartialResponseError(fetch->len, readLen));
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    fetch->onFetched(error);
+    return NULL;
+}
+
+void ChunkBuffer::startHedge() {
+    // another chunk is racing, try again after another delay.
+    if (!this->sharedKeyReader.tryStartHedge()) {
+        this->fetchStartUs = GetCurrentTimeUs();
+        return;
+    }
+    this->hedgeStarted = true;
+
+    S3DEBUG("Fetch of %" PRIu64 " bytes at %" PRIu64 " is slow, start a hedged one",
+            this->chunkDataSize, this->curFileOffset);
+
+    // the hedge runs the blocking fetchData() on a thread of its own in both modes, so that it
+    // never runs on the reader even if s3Interface can't fetch asynchronously.
+    ChunkFetch* fetch = new ChunkFetch(this, this->generation, true, this->curFileOffset,
+                                       this->chunkDataSize, this->chunkData.get_allocator());
+    this->hedgeFetch = fetch;
+    this->hedgeGeneration = this->generation;
+    // the range might still wait for its downloading thread.
+    bool primaryRunning = (this->primaryFetch != NULL) ||
+                          (this->filling && (this->fillGeneration == this->generation));
+    this->racers = primaryRunning ? 2 : 1;
+
+    this->sharedKeyReader.fetchStarted();
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, HedgeThreadFunc, fetch) != 0) {
+        S3WARN("Failed to create a thread for hedged fetch");
+        this->hedgeFetch = NULL;
+        this->racers = 0;
+        delete fetch;
+        this->sharedKeyReader.hedgeFinished();
+        this->sharedKeyReader.fetchFinished();
+        return;
+    }
+    pthread_detach(thread);
 }
 
 static void* DownloadThreadFunc(void* data) {
@@ -189,18 +761,95 @@ void S3KeyReader::open(const S3Params& params) {
     this->numOfChunks = params.getNumOfChunks();
     S3_CHECK_OR_DIE(this->numOfChunks > 0, S3RuntimeError, "numOfChunks must not be zero");
 
-    this->offsetMgr.setKeySize(params.getKeySize());
-    this->offsetMgr.setChunkSize(params.getChunkSize());
+    uint64_t keySize = params.getKeySize();
+    uint64_t rangeStart = std::min(params.getKeyRangeStart(), keySize);
+    uint64_t rangeEnd = params.getKeyRangeEnd();
+    if (rangeEnd == 0 || rangeEnd > keySize) {
+        rangeEnd = keySize;
+    }
+
+    // Start a little earlier than the range to catch an EOL that ends exactly at rangeStart,
+    // in that case the first line of the range is a complete one. A raw range is not text, it is
+    // read exactly and nothing is appended to it.
+    bool raw = params.isRawKeyRange();
+    uint64_t eolLen = strlen(eolString);
+    if (raw) {
+        this->readStart = rangeStart;
+    } else {
+        this->readStart = rangeStart > eolLen ? rangeStart - eolLen : 0;
+    }
+    this->rangeEnd = rangeEnd;
+    this->isRangeRead = !raw && ((rangeStart > 0) || (rangeEnd < keySize));
+    this->skippingFirstLine = !raw && (rangeStart > 0);
+    this->eolAppended = raw;
+    this->rangeFinished = false;
+    this->eolScanner = EolScanner(eolString);
 
     S3_CHECK_OR_DIE(params.getChunkSize() > 0, S3RuntimeError,
                     "chunk size must be greater than zero");
 
+    // Adaptive mode spreads the key over the threads with chunks no larger than configured, and
+    // drops threads that have nothing to download, so memory never grows beyond chunk buffers.
+    uint64_t chunkSize = params.getChunkSize();
+    this->adaptive = params.isAdaptiveDownload();
+    if (this->adaptive) {
+        uint64_t readLen = rangeEnd - this->readStart;
+        uint64_t perChunk = (readLen + this->numOfChunks - 1) / this->numOfChunks;
+        chunkSize = std::min(chunkSize, std::max(perChunk, (uint64_t)S3_ADAPTIVE_MIN_CHUNKSIZE));
+        this->numOfChunks =
+            std::max(std::min(this->numOfChunks, (readLen + chunkSize - 1) / chunkSize),
+                     (uint64_t)1);
+
+        this->fetchLimiter.reset(this->numOfChunks, S3_ADAPTIVE_INIT_FETCHES, GetCurrentTimeUs());
+
+        S3DEBUG("Download %" PRIu64 " bytes with %" PRIu64 " chunks of %" PRIu64 " bytes",
+                readLen, this->numOfChunks, chunkSize);
+    }
+
+    // changes of a key without ETag can't be detected, it is never cached.
+    this->keyETag = params.getKeyETag();
+    this->readCache.setup(this->keyETag.empty() ? "" : params.getReadCacheDir(),
+                          params.getReadCacheSize());
+
+    this->offsetMgr.setKeySize(raw ? rangeEnd : keySize);
+    this->offsetMgr.setChunkSize(chunkSize);
+    this->offsetMgr.setCurPos(this->readStart);
+    if (!raw && (rangeEnd < keySize)) {
+        this->offsetMgr.setSoftEnd(rangeEnd);
+    }
+
+    this->hedged = params.isHedgedFetch();
+
+    // ranged GETs carry no checksum, only the whole key can be checked.
+    this->verifying = false;
+    this->keyCrc = 0;
+    this->crcChunks = 0;
+    if (params.isCrc32cChecksum() && (rangeStart == 0) && (rangeEnd == keySize)) {
+        string checksum = this->s3Interface->getKeyChecksum(params.getS3Url());
+        if (Crc32cFromBase64(checksum, &this->expectedCrc)) {
+            this->verifying = true;
+        } else {
+            S3DEBUG("Key %s has no CRC32C checksum to verify",
+                    params.getS3Url().getFullUrlForCurl().c_str());
+        }
+    }
+
     this->chunkBuffers.reserve(this->numOfChunks);
 
     for (uint64_t i = 0; i < this->numOfChunks; i++) {
         this->chunkBuffers.emplace_back(params.getS3Url(), *this, params.getMemoryContext());
     }
 
+    // All chunks are in flight at once, the adaptive limiter only throttles downloading threads.
+    this->multiplexed = params.isMultiplexIO();
+    if (this->multiplexed) {
+        for (uint64_t i = 0; i < this->numOfChunks; i++) {
+            this->chunkBuffers[i].setS3InterfaceService(this->s3Interface);
+            this->chunkBuffers[i].startFill();
+        }
+        return;
+    }
+
     for (uint64_t i = 0; i < this->numOfChunks; i++) {
         this->chunkBuffers[i].setS3InterfaceService(this->s3Interface);
 
@@ -211,19 +860,106 @@ void S3KeyReader::open(const S3Params& params) {
 }
 
 uint64_t S3KeyReader::read(char* buf, uint64_t count) {
-    uint64_t fileLen = this->offsetMgr.getKeySize();
+    const char* data = NULL;
+
+    uint64_t readLen = this->readView(&data, count);
+    if (readLen != 0) {
+        memcpy(buf, data, readLen);
+    }
+
+    // let the chunk be refilled as early as possible, data is copied out already.
+    this->releaseLentChunk();
+
+    return readLen;
+}
+
+uint64_t S3KeyReader::readView(const char** data, uint64_t count) {
+    if (this->isRangeRead) {
+        return this->readRange(data, count);
+    }
+
+    return this->readKey(data, count);
+}
+
+void S3KeyReader::releaseLentChunk() {
+    if (this->lentChunk != NULL) {
+        this->lentChunk->releaseView();
+        this->lentChunk = NULL;
+    }
+}
+
+// A line belongs to the range where its first byte is. Therefore the first partial line of
+// a range is skipped (it's read by previous range), and reading continues beyond the range end
+// until the last line is finished.
+uint64_t S3KeyReader::readRange(const char** data, uint64_t count) {
+    uint64_t eolLen = strlen(eolString);
+
+    while (!this->rangeFinished) {
+        // file offset of buf[0]
+        uint64_t pos = this->readStart + this->transferredKeyLen;
+
+        uint64_t readLen = this->readKey(data, count);
+        const char* buf = *data;
+        if (readLen == 0) {
+            this->rangeFinished = true;
+            break;
+        }
+
+        uint64_t begin = 0;
+        if (this->skippingFirstLine) {
+            begin = this->eolScanner.find(buf, readLen);
+            if (begin == (uint64_t)-1) {
+                continue;
+            }
+
+            this->skippingFirstLine = false;
+
+            // first complete line starts beyond range, it belongs to next range
+            if (pos + begin >= this->rangeEnd) {
+                this->rangeFinished = true;
+                break;
+            }
+        }
+
+        // only an EOL ending at or after rangeEnd can finish the last line of this range
+        uint64_t end = readLen;
+        uint64_t threshold = this->rangeEnd > eolLen ? this->rangeEnd - eolLen : 0;
+        uint64_t from = std::max(begin, threshold > pos ? threshold - pos : 0);
+        if (from < readLen) {
+            uint64_t found = this->eolScanner.find(buf, readLen, from);
+            if (found != (uint64_t)-1) {
+                end = found;
+                this->rangeFinished = true;
+            }
+        }
+
+        if (end > begin) {
+            *data = buf + begin;
+            return end - begin;
+        }
+    }
+
+    return 0;
+}
+
+uint64_t S3KeyReader::readKey(const char** data, uint64_t count) {
+    uint64_t fileLen = this->offsetMgr.getKeySize() - this->readStart;
     uint64_t readLen = 0;
 
+    // data lent last time is not used anymore.
+    this->releaseLentChunk();
+
     do {
         // confirm there is no more available data, done with this file
         if (this->transferredKeyLen >= fileLen) {
+            this->verifyChecksum();
+
             if (!this->hasEol && !this->eolAppended) {
-                uint64_t eolLen = strlen(eolString);
-                strncpy(buf, eolString, eolLen);
+                *data = eolString;
 
                 this->eolAppended = true;
 
-                return eolLen;
+                return strlen(eolString);
             }
 
             return 0;
@@ -231,7 +967,7 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
 
         ChunkBuffer& buffer = chunkBuffers[this->curReadingChunk % this->numOfChunks];
 
-        readLen = buffer.read(buf, count);
+        readLen = buffer.readView(data, count);
 
         if (this->isSharedError()) {
             if (this->sharedException != NULL) {
@@ -241,8 +977,16 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
             }
         }
 
+        // the first read of a chunk combines its CRC32C, chunks are read in key order.
+        if (this->verifying && (this->crcChunks == this->curReadingChunk)) {
+            this->keyCrc =
+                Crc32cCombine(this->keyCrc, buffer.getChunkCrc(), buffer.getChunkDataSize());
+            this->crcChunks++;
+        }
+
         this->transferredKeyLen += readLen;
         if (this->transferredKeyLen == fileLen) {
+            const char* buf = *data;
             if (buf[readLen - 1] == '\r' || buf[readLen - 1] == '\n') {
                 this->hasEol = true;
             }
@@ -252,6 +996,12 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
             this->curReadingChunk++;
         }
 
+        if (readLen == 0) {
+            buffer.releaseView();
+        } else {
+            this->lentChunk = &buffer;
+        }
+
         count -= readLen;
     } while (readLen == 0);  // retry to confirm whether thread reading is finished or chunk size is
                              // divisible by get()'s buffer size
@@ -259,11 +1009,23 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
     return readLen;
 }
 
+void S3KeyReader::verifyChecksum() {
+    if (!this->verifying) {
+        return;
+    }
+    this->verifying = false;
+
+    S3_CHECK_OR_DIE(this->keyCrc == this->expectedCrc, S3RuntimeError,
+                    "CRC32C of the key is " + Crc32cToBase64(this->keyCrc) + ", expected " +
+                        Crc32cToBase64(this->expectedCrc));
+}
+
 // reset marks before reading next key
 void S3KeyReader::reset() {
     this->sharedError = false;
     this->curReadingChunk = 0;
     this->transferredKeyLen = 0;
+    this->lentChunk = NULL;
 
     this->offsetMgr.reset();
 
@@ -272,13 +1034,32 @@ void S3KeyReader::reset() {
 
     this->hasEol = false;
     this->eolAppended = false;
+
+    this->readStart = 0;
+    this->rangeEnd = 0;
+    this->isRangeRead = false;
+    this->skippingFirstLine = false;
+    this->rangeFinished = false;
+    this->eolScanner.reset();
+
+    this->adaptive = false;
+    this->multiplexed = false;
+    this->hedged = false;
+    this->hedging = false;
+    this->latencyTracker.reset();
+
+    this->verifying = false;
+    this->keyCrc = 0;
+    this->crcChunks = 0;
 }
 
 void S3KeyReader::close() {
     // to interupt downlading thread, we must: (check ChunkBuffer::fill())
     // 1. set condition to ReadyToFill and signal conditional_variable.
     // 2. set the shared error status to prevent download thread from continuing.
+    // 3. wake up threads waiting for a slot to fetch, they hold the status lock of their chunks.
     this->sharedError = true;
+    this->fetchLimiter.stop();
 
     for (uint64_t i = 0; i < this->chunkBuffers.size(); i++) {
         UniqueLock lock(this->chunkBuffers[i].getStatMutex());
@@ -296,5 +1077,177 @@ void S3KeyReader::close() {
         this->threads[i] = 0;
     }
 
+    // fetches in flight still refer to the chunks.
+    this->waitForFetches();
+
     this->reset();
 }
+
+void S3KeyReader::fetchStarted() {
+    UniqueLock lock(&this->fetchMutex);
+    this->fetchesInFlight++;
+}
+
+void S3KeyReader::fetchFinished() {
+    UniqueLock lock(&this->fetchMutex);
+    this->fetchesInFlight--;
+    pthread_cond_broadcast(&this->fetchCond);
+}
+
+bool S3KeyReader::tryStartHedge() {
+    UniqueLock lock(&this->fetchMutex);
+    if (this->hedging) {
+        return false;
+    }
+
+    this->hedging = true;
+    return true;
+}
+
+void S3KeyReader::hedgeFinished() {
+    UniqueLock lock(&this->fetchMutex);
+    this->hedging = false;
+}
+
+void S3KeyReader::waitForFetches() {
+    UniqueLock lock(&this->fetchMutex);
+    while (this->fetchesInFlight > 0) {
+        pthread_cond_wait(&this->fetchCond, &this->fetchMutex);
+    }
+}
+
+S3SmallKeyReader::S3SmallKeyReader()
+    : s3Interface(NULL),
+      opened(false),
+      fetching(false),
+      cancelled(false),
+      readOffset(0),
+      eolAppended(false),
+      verifying(false),
+      expectedCrc(0) {
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->cond, NULL);
+}
+
+S3SmallKeyReader::~S3SmallKeyReader() {
+    this->close();
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->cond);
+}
+
+void S3SmallKeyReader::open(const S3Params& params) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+
+    {
+        UniqueLock lock(&this->mutex);
+        if (this->opened) {
+            return;
+        }
+
+        this->opened = true;
+        this->fetching = true;
+        this->cancelled = false;
+        this->error = std::exception_ptr();
+    }
+
+    S3VectorUInt8(params.getMemoryContext()).swap(this->data);
+    this->readOffset = 0;
+    this->eolAppended = false;
+
+    this->verifying = false;
+    if (params.isCrc32cChecksum()) {
+        string checksum = this->s3Interface->getKeyChecksum(params.getS3Url());
+        this->verifying = Crc32cFromBase64(checksum, &this->expectedCrc);
+    }
+
+    // onFetched() might be called before it returns, if the GET can't be run asynchronously.
+    this->s3Interface->fetchDataAsync(0, this->data, params.getKeySize(), params.getS3Url(), this);
+}
+
+bool S3SmallKeyReader::isCancelled() {
+    UniqueLock lock(&this->mutex);
+    return this->cancelled;
+}
+
+void S3SmallKeyReader::onFetched(std::exception_ptr error) {
+    UniqueLock lock(&this->mutex);
+    this->error = error;
+    this->fetching = false;
+    pthread_cond_signal(&this->cond);
+}
+
+void S3SmallKeyReader::waitForData() {
+    S3_CHECK_OR_DIE(!S3QueryIsAbortInProgress(), S3QueryAbort, "");
+
+    UniqueLock lock(&this->mutex);
+    while (this->fetching) {
+        pthread_cond_wait(&this->cond, &this->mutex);
+    }
+
+    if (this->error != NULL) {
+        std::rethrow_exception(this->error);
+    }
+
+    if (this->verifying) {
+        this->verifying = false;
+
+        uint32_t crc = Crc32c(0, this->data.data(), this->data.size());
+        S3_CHECK_OR_DIE(crc == this->expectedCrc, S3RuntimeError,
+                        "CRC32C of the key is " + Crc32cToBase64(crc) + ", expected " +
+                            Crc32cToBase64(this->expectedCrc));
+    }
+}
+
+S3CompressionType S3SmallKeyReader::getCompressionType() {
+    this->waitForData();
+    return GetCompressionTypeFromMagic(this->data.data(), this->data.size());
+}
+
+uint64_t S3SmallKeyReader::read(char* buf, uint64_t count) {
+    const char* data = NULL;
+
+    uint64_t readLen = this->readView(&data, count);
+    if (readLen != 0) {
+        memcpy(buf, data, readLen);
+    }
+
+    return readLen;
+}
+
+uint64_t S3SmallKeyReader::readView(const char** data, uint64_t count) {
+    this->waitForData();
+
+    uint64_t keyLen = this->data.size();
+    if (this->readOffset >= keyLen) {
+        char last = keyLen > 0 ? this->data[keyLen - 1] : '\0';
+        if ((last != '\r') && (last != '\n') && !this->eolAppended) {
+            *data = eolString;
+
+            this->eolAppended = true;
+
+            return strlen(eolString);
+        }
+
+        return 0;
+    }
+
+    uint64_t readLen = std::min(count, keyLen - this->readOffset);
+    *data = (const char*)this->data.data() + this->readOffset;
+    this->readOffset += readLen;
+
+    return readLen;
+}
+
+// The GET in flight refers to data, wait for it to finish before the buffer is released.
+void S3SmallKeyReader::close() {
+    {
+        UniqueLock lock(&this->mutex);
+        this->cancelled = true;
+        while (this->fetching) {
+            pthread_cond_wait(&this->cond, &this->mutex);
+        }
+        this->opened = false;
+    }
+
+    this->data.release();
+}
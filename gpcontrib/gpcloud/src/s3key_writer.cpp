@@ -1,18 +1,114 @@
 #include "s3key_writer.h"
 
+// A part of the ring, it goes back to the free parts of the writer once the upload is finished.
+struct ThreadParams : public S3UploadCallback {
+    ThreadParams(S3KeyWriter* keyWriter, const S3MemoryContext& context)
+        : keyWriter(keyWriter), data(context), key(NULL), currentNumber(0) {
+    }
+
+    S3KeyWriter* keyWriter;
+    S3VectorUInt8 data;
+    KeyUpload* key;
+    uint64_t currentNumber;
+    string checksum;  // base64 encoded CRC32C of data, empty if the part has none
+
+    void onUploaded(const string& etag, std::exception_ptr error) {
+        this->keyWriter->finishPart(this, etag, error);
+    }
+};
+
 void S3KeyWriter::open(const S3Params& params) {
     this->params = params;
 
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
     S3_CHECK_OR_DIE(this->params.getChunkSize() > 0, S3RuntimeError, "chunkSize must not be zero");
 
-    buffer.reserve(this->params.getChunkSize());
+    this->prepareRing();
+
+    this->releaseKeys();
+    this->currentKey = this->startKey(this->params.getS3Url());
+}
+
+KeyUpload* S3KeyWriter::startKey(const S3Url& url) {
+    string uploadId = this->s3Interface->getUploadId(url);
+    S3_CHECK_OR_DIE(!uploadId.empty(), S3RuntimeError, "Failed to get upload id");
+
+    S3DEBUG("key: %s, upload id: %s", url.getFullUrlForCurl().c_str(), uploadId.c_str());
+
+    this->numOfKeys++;
+    return new KeyUpload(url, uploadId);
+}
+
+// Must be called when no part is being uploaded.
+void S3KeyWriter::abortKeys() {
+    if (this->currentKey != NULL) {
+        this->rolledKeys.push_back(this->currentKey);
+        this->currentKey = NULL;
+    }
+
+    for (size_t i = 0; i < this->rolledKeys.size(); i++) {
+        KeyUpload* key = this->rolledKeys[i];
+
+        S3DEBUG("Start aborting multipart uploading (uploadID: %s, %lu parts uploaded)",
+                key->uploadId.c_str(), key->etagList.size());
+        this->s3Interface->abortUpload(key->url, key->uploadId);
+        S3DEBUG("Finished aborting multipart uploading (uploadID: %s)", key->uploadId.c_str());
+    }
+
+    this->releaseKeys();
+}
+
+void S3KeyWriter::releaseKeys() {
+    for (size_t i = 0; i < this->rolledKeys.size(); i++) {
+        delete this->rolledKeys[i];
+    }
+    this->rolledKeys.clear();
+
+    delete this->currentKey;
+    this->currentKey = NULL;
+    this->numOfKeys = 0;
+}
+
+void S3KeyWriter::prepareRing() {
+    this->releaseRing();
 
-    this->uploadId = this->s3Interface->getUploadId(this->params.getS3Url());
-    S3_CHECK_OR_DIE(!this->uploadId.empty(), S3RuntimeError, "Failed to get upload id");
+    // all buffers are reserved up front, so no part allocates memory while uploading.
+    const S3MemoryContext& context = this->params.getMemoryContext();
+    S3VectorUInt8(context).swap(this->buffer);
+    this->buffer.reserve(this->params.getChunkSize());
+    this->bufferCrc = 0;
 
-    S3DEBUG("key: %s, upload id: %s", this->params.getS3Url().getFullUrlForCurl().c_str(),
-            this->uploadId.c_str());
+    for (uint64_t i = 0; i < this->params.getNumOfChunks(); i++) {
+        ThreadParams* part = new ThreadParams(this, context);
+        part->data.reserve(this->params.getChunkSize());
+
+        this->parts.push_back(part);
+        this->freeParts.push_back(part);
+    }
+
+    this->ringStalls = 0;
+    this->ringStallUs = 0;
+    this->ringBusySum = 0;
+}
+
+// Must be called when no part is being uploaded.
+void S3KeyWriter::releaseRing() {
+    for (size_t i = 0; i < this->parts.size(); i++) {
+        delete this->parts[i];
+    }
+    this->parts.clear();
+    this->freeParts.clear();
+
+    this->buffer.release();
+}
+
+uint64_t S3KeyWriter::getRingUtilization() const {
+    uint64_t ringSize = this->params.getNumOfChunks();
+    if ((this->partNumber == 0) || (ringSize == 0)) {
+        return 0;
+    }
+
+    return this->ringBusySum * 100 / (this->partNumber * ringSize);
 }
 
 // write() first fills up the data buffer before flush it out
@@ -32,6 +128,9 @@ uint64_t S3KeyWriter::write(const char* buf, uint64_t count) {
         uint64_t dataToBuffer = bufferRemaining < dataRemaining ? bufferRemaining : dataRemaining;
 
         this->buffer.insert(this->buffer.end(), buf + offset, buf + offset + dataToBuffer);
+        if (this->params.isCrc32cChecksum()) {
+            this->bufferCrc = Crc32c(this->bufferCrc, buf + offset, dataToBuffer);
+        }
 
         if (this->buffer.size() == this->params.getChunkSize()) {
             this->flushBuffer();
@@ -45,13 +144,88 @@ uint64_t S3KeyWriter::write(const char* buf, uint64_t count) {
 
 // This should be reentrant, has no side effects when called multiple times.
 void S3KeyWriter::close() {
-    if (!this->uploadId.empty()) {
+    if (this->currentKey != NULL) {
         this->completeKeyWriting();
     }
 }
 
+void S3KeyWriter::rollover(const S3Url& url) {
+    S3_CHECK_OR_DIE(this->currentKey != NULL, S3RuntimeError, "Writer is not opened");
+    if (this->sharedError) {
+        std::rethrow_exception(this->sharedException);
+    }
+
+    // the last part of the key might be smaller than chunkSize, which S3 allows.
+    this->flushBuffer();
+
+    KeyUpload* key = this->startKey(url);
+    {
+        UniqueLock lock(&this->mutex);
+        this->rolledKeys.push_back(this->currentKey);
+        this->currentKey = key;
+    }
+
+    this->completeUploadedKeys();
+}
+
+void S3KeyWriter::completeKey(KeyUpload* key) {
+    vector<string> etags;
+    // it is equivalent to foreach(e in etagList) push_back(e.second);
+    // transform(etagList.begin(), etagList.end(), etags.begin(),
+    //          [](std::pair<const uint64_t, string>& p) { return p.second; });
+    etags.reserve(key->etagList.size());
+
+    for (map<uint64_t, string>::iterator i = key->etagList.begin(); i != key->etagList.end();
+         i++) {
+        etags.push_back(i->second);
+    }
+
+    if (!key->etagList.empty()) {
+        vector<string> checksums;
+        if (key->checksumList.size() == key->etagList.size()) {
+            for (map<uint64_t, string>::iterator i = key->checksumList.begin();
+                 i != key->checksumList.end(); i++) {
+                checksums.push_back(i->second);
+            }
+        }
+
+        this->s3Interface->completeMultiPart(key->url, key->uploadId, etags, checksums);
+    }
+
+    S3DEBUG("Segment %d has finished uploading \"%s\"", s3ext_segid,
+            key->url.getFullUrlForCurl().c_str());
+}
+
+// Complete the rolled over keys whose parts are all uploaded, called by the backend only.
+void S3KeyWriter::completeUploadedKeys() {
+    vector<std::unique_ptr<KeyUpload>> uploaded;
+    {
+        UniqueLock lock(&this->mutex);
+
+        // a key with a failed part must not be completed, it's aborted by close().
+        if (this->sharedError) {
+            return;
+        }
+
+        vector<KeyUpload*>::iterator it = this->rolledKeys.begin();
+        while (it != this->rolledKeys.end()) {
+            if ((*it)->activeParts == 0) {
+                uploaded.emplace_back(*it);
+                it = this->rolledKeys.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    // the keys are not in rolledKeys any more, they are freed even if completing fails.
+    for (size_t i = 0; i < uploaded.size(); i++) {
+        this->completeKey(uploaded[i].get());
+    }
+}
+
 void S3KeyWriter::checkQueryCancelSignal() {
-    if (S3QueryIsAbortInProgress() && !this->uploadId.empty()) {
+    if (S3QueryIsAbortInProgress() && (this->currentKey != NULL)) {
         // to avoid dead-lock when other upload threads hold the lock
         pthread_mutex_unlock(&this->mutex);
 
@@ -64,23 +238,55 @@ void S3KeyWriter::checkQueryCancelSignal() {
         // to avoid double unlock as other parts may lock it
         pthread_mutex_lock(&this->mutex);
 
-        S3DEBUG("Start aborting multipart uploading (uploadID: %s, %lu parts uploaded)",
-                this->uploadId.c_str(), this->etagList.size());
-        this->s3Interface->abortUpload(this->params.getS3Url(), this->uploadId);
-        S3DEBUG("Finished aborting multipart uploading (uploadID: %s)", this->uploadId.c_str());
+        // parts uploaded by the I/O thread have no thread to join.
+        while (this->activeThreads > 0) {
+            pthread_cond_wait(&this->cv, &this->mutex);
+        }
 
-        this->etagList.clear();
-        this->uploadId.clear();
+        this->abortKeys();
 
         S3_DIE(S3QueryAbort, "Uploading is interrupted");
     }
 }
 
-struct ThreadParams {
-    S3KeyWriter* keyWriter;
-    S3VectorUInt8 data;
-    uint64_t currentNumber;
-};
+void S3KeyWriter::finishPart(ThreadParams* part, const string& etag, std::exception_ptr error) {
+    if (error != NULL) {
+        try {
+            std::rethrow_exception(error);
+        } catch (S3Exception& e) {
+            S3ERROR("Upload thread error: %s", e.getMessage().c_str());
+        } catch (...) {
+            S3ERROR("Upload thread error: unknown exception");
+        }
+
+        UniqueLock exceptLock(&this->exceptionMutex);
+        this->sharedError = true;
+        this->sharedException = error;
+    }
+
+    // when unique_lock destructs it will automatically unlock the mutex.
+    UniqueLock threadLock(&this->mutex);
+
+    // etag is empty if the query is cancelled by user.
+    if ((error == NULL) && !etag.empty()) {
+        part->key->etagList[part->currentNumber] = etag;
+        if (!part->checksum.empty()) {
+            part->key->checksumList[part->currentNumber] = part->checksum;
+        }
+    }
+    part->key->activeParts--;
+
+    S3DEBUG("Upload part finish: %" PRIX64 ", eTag: %s, part number: %" PRIu64,
+            (uint64_t)pthread_self(), etag.c_str(), part->currentNumber);
+
+    // clear() keeps the memory, the part is filled again without reallocation.
+    part->data.clear();
+    this->freeParts.push_back(part);
+
+    // notify the flushBuffer, otherwise it will be locked when trying to queue a new part.
+    this->activeThreads--;
+    pthread_cond_broadcast(&this->cv);
+}
 
 void* S3KeyWriter::UploadThreadFunc(void* data) {
     MaskThreadSignals();
@@ -88,43 +294,32 @@ void* S3KeyWriter::UploadThreadFunc(void* data) {
     ThreadParams* params = (ThreadParams*)data;
     S3KeyWriter* writer = params->keyWriter;
 
-    try {
-        S3DEBUG("Upload thread start: %" PRIX64 ", part number: %" PRIu64 ", data size: %zu",
-                (uint64_t) pthread_self(), params->currentNumber, params->data.size());
-        string etag = writer->s3Interface->uploadPartOfData(
-            params->data, writer->params.getS3Url(), params->currentNumber, writer->uploadId);
+    S3DEBUG("Upload thread start: %" PRIX64 ", part number: %" PRIu64 ", data size: %zu",
+            (uint64_t)pthread_self(), params->currentNumber, params->data.size());
 
-        // when unique_lock destructs it will automatically unlock the mutex.
-        UniqueLock threadLock(&writer->mutex);
+    // blocks in uploadPartOfData(), params is recycled by onUploaded().
+    writer->s3Interface->S3Interface::uploadPartOfDataAsync(
+        params->data, params->key->url, params->currentNumber, params->key->uploadId,
+        params->checksum, params);
 
-        // etag is empty if the query is cancelled by user.
-        if (!etag.empty()) {
-            writer->etagList[params->currentNumber] = etag;
-        }
-        writer->activeThreads--;
-        pthread_cond_broadcast(&writer->cv);
-        S3DEBUG("Upload part finish: %" PRIX64 ", eTag: %s, part number: %" PRIu64, (uint64_t) pthread_self(),
-                etag.c_str(), params->currentNumber);
-    } catch (S3Exception& e) {
-        S3ERROR("Upload thread error: %s", e.getMessage().c_str());
-        UniqueLock exceptLock(&writer->exceptionMutex);
-        writer->sharedError = true;
-        writer->sharedException = std::current_exception();
-
-        // notify the flushBuffer, otherwise it will be locked when trying to create a new thread.
-        writer->activeThreads--;
-        pthread_cond_broadcast(&writer->cv);
-    }
-
-    delete params;
     return NULL;
 }
 
 void S3KeyWriter::flushBuffer() {
+    ThreadParams* part = NULL;
+
     if (!this->buffer.empty()) {
         UniqueLock queueLock(&this->mutex);
-        while (this->activeThreads >= this->params.getNumOfChunks()) {
-            pthread_cond_wait(&this->cv, &this->mutex);
+
+        // every part of the ring is being uploaded, wait for one of them to be recycled.
+        if (this->freeParts.empty()) {
+            uint64_t startUs = GetCurrentTimeUs();
+            while (this->freeParts.empty()) {
+                pthread_cond_wait(&this->cv, &this->mutex);
+            }
+
+            this->ringStalls++;
+            this->ringStallUs += GetCurrentTimeUs() - startUs;
         }
 
         // Most time query is canceled during uploadPartOfData(). This is the first chance to cancel
@@ -132,16 +327,48 @@ void S3KeyWriter::flushBuffer() {
         this->checkQueryCancelSignal();
 
         this->activeThreads++;
+        this->ringBusySum += this->activeThreads;
 
-        pthread_t writerThread;
-        ThreadParams* params = new ThreadParams();
-        params->keyWriter = this;
+        ThreadParams* params = this->freeParts.back();
+        this->freeParts.pop_back();
+
+        // the part takes the data, and buffer takes the recycled memory of the part.
         params->data.swap(this->buffer);
-        params->currentNumber = ++this->partNumber;
-        pthread_create(&writerThread, NULL, UploadThreadFunc, params);
-        threadList.emplace_back(writerThread);
+        params->checksum =
+            this->params.isCrc32cChecksum() ? Crc32cToBase64(this->bufferCrc) : string();
+        this->bufferCrc = 0;
+        params->key = this->currentKey;
+        params->currentNumber = ++this->currentKey->partNumber;
+        this->currentKey->activeParts++;
+        this->currentKey->size += params->data.size();
+        this->partNumber++;
+
+        // in multiplexed mode the part is uploaded by the I/O thread of s3Interface.
+        if (this->params.isMultiplexIO()) {
+            part = params;
+        } else {
+            pthread_t writerThread;
+            pthread_create(&writerThread, NULL, UploadThreadFunc, params);
+            threadList.emplace_back(writerThread);
+        }
+    }
 
-        this->buffer.reserve(this->params.getChunkSize());
+    // without the lock, the part might be finished before uploadPartOfDataAsync() returns.
+    if (part != NULL) {
+        this->s3Interface->uploadPartOfDataAsync(part->data, part->key->url, part->currentNumber,
+                                                 part->key->uploadId, part->checksum, part);
+    }
+
+    // only the backend changes rolledKeys.
+    if (!this->rolledKeys.empty()) {
+        this->completeUploadedKeys();
+    }
+}
+
+void S3KeyWriter::waitForUploads() {
+    UniqueLock lock(&this->mutex);
+    while (this->activeThreads > 0) {
+        pthread_cond_wait(&this->cv, &this->mutex);
     }
 }
 
@@ -154,27 +381,27 @@ void S3KeyWriter::completeKeyWriting() {
         pthread_join(threadList[i], NULL);
     }
     this->threadList.clear();
+    this->waitForUploads();
 
     this->checkQueryCancelSignal();
 
-    vector<string> etags;
-    // it is equivalent to foreach(e in etagList) push_back(e.second);
-    // transform(etagList.begin(), etagList.end(), etags.begin(),
-    //          [](std::pair<const uint64_t, string>& p) { return p.second; });
-    etags.reserve(etagList.size());
-
-    for (map<uint64_t, string>::iterator i = etagList.begin(); i != etagList.end(); i++) {
-        etags.push_back(i->second);
+    // keys with a failed part are not completed.
+    if (this->sharedError) {
+        this->abortKeys();
+        this->releaseRing();
+        return;
     }
 
-    if (!this->etagList.empty() && !this->uploadId.empty()) {
-        this->s3Interface->completeMultiPart(this->params.getS3Url(), this->uploadId, etags);
-    }
+    this->rolledKeys.push_back(this->currentKey);
+    this->currentKey = NULL;
+    this->completeUploadedKeys();
 
-    S3DEBUG("Segment %d has finished uploading \"%s\"", s3ext_segid,
-            this->params.getS3Url().getFullUrlForCurl().c_str());
+    S3DEBUG("Uploaded %" PRIu64 " parts of %" PRIu64 " keys with a ring of %" PRIu64
+            " buffers, %" PRIu64 "%% of the ring was busy on average, backend waited %" PRIu64
+            " times (%" PRIu64 " us) for a free buffer",
+            this->partNumber, this->numOfKeys, this->params.getNumOfChunks(),
+            this->getRingUtilization(), this->ringStalls, this->ringStallUs);
 
-    this->buffer.clear();
-    this->etagList.clear();
-    this->uploadId.clear();
+    this->releaseRing();
+    this->releaseKeys();
 }
@@ -0,0 +1,121 @@
+#include "s3memory_mgmt.h"
+
+#include <sys/mman.h>
+#include <time.h>
+
+// Chunks are mapped in whole huge pages, so that they can be backed by transparent huge pages.
+#define S3_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static size_t MappedSize(size_t size) {
+    return (size + S3_HUGE_PAGE_SIZE - 1) / S3_HUGE_PAGE_SIZE * S3_HUGE_PAGE_SIZE;
+}
+
+S3ChunkPool::S3ChunkPool() : capacity(0), idleTime(0), hugePages(false), cachedBytes(0) {
+    pthread_mutex_init(&this->mutex, NULL);
+}
+
+S3ChunkPool::~S3ChunkPool() {
+    for (size_t i = 0; i < this->idleChunks.size(); i++) {
+        this->unmap(this->idleChunks[i].p, this->idleChunks[i].size);
+    }
+    pthread_mutex_destroy(&this->mutex);
+}
+
+void S3ChunkPool::configure(uint64_t capacity, uint64_t idleTime, bool hugePages) {
+    UniqueLock lock(&this->mutex);
+
+    this->capacity = capacity;
+    this->idleTime = idleTime;
+    this->hugePages = hugePages;
+
+    // keep the longest idle chunks that fit in the new capacity.
+    while (this->cachedBytes > this->capacity) {
+        IdleChunk& chunk = this->idleChunks.front();
+        this->cachedBytes -= chunk.size;
+        this->unmap(chunk.p, chunk.size);
+        this->idleChunks.erase(this->idleChunks.begin());
+    }
+
+    this->trimLocked(time(NULL));
+}
+
+bool S3ChunkPool::isEnabled() {
+    UniqueLock lock(&this->mutex);
+    return this->capacity > 0;
+}
+
+void* S3ChunkPool::acquire(size_t size) {
+    {
+        UniqueLock lock(&this->mutex);
+
+        // the most recently released chunk is the most likely to be still resident.
+        for (size_t i = this->idleChunks.size(); i > 0; i--) {
+            if (this->idleChunks[i - 1].size == size) {
+                void* p = this->idleChunks[i - 1].p;
+                this->cachedBytes -= size;
+                this->idleChunks.erase(this->idleChunks.begin() + (i - 1));
+                return p;
+            }
+        }
+    }
+
+    void* p = mmap(NULL, MappedSize(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                   -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (this->hugePages && (madvise(p, MappedSize(size), MADV_HUGEPAGE) != 0)) {
+        S3DEBUG("Failed to use huge pages for a chunk of %zu bytes", size);
+    }
+#endif
+
+    return p;
+}
+
+void S3ChunkPool::release(void* p, size_t size) {
+    UniqueLock lock(&this->mutex);
+
+    uint64_t now = time(NULL);
+    if (this->cachedBytes + size > this->capacity) {
+        this->unmap(p, size);
+    } else {
+        IdleChunk chunk = {p, size, now};
+        this->idleChunks.push_back(chunk);
+        this->cachedBytes += size;
+    }
+
+    this->trimLocked(now);
+}
+
+void S3ChunkPool::trim(uint64_t now) {
+    UniqueLock lock(&this->mutex);
+    this->trimLocked(now);
+}
+
+void S3ChunkPool::trimLocked(uint64_t now) {
+    size_t expired = 0;
+    while ((expired < this->idleChunks.size()) &&
+           (this->idleChunks[expired].releasedAt + this->idleTime <= now)) {
+        this->cachedBytes -= this->idleChunks[expired].size;
+        this->unmap(this->idleChunks[expired].p, this->idleChunks[expired].size);
+        expired++;
+    }
+
+    this->idleChunks.erase(this->idleChunks.begin(), this->idleChunks.begin() + expired);
+}
+
+uint64_t S3ChunkPool::getCachedBytes() {
+    UniqueLock lock(&this->mutex);
+    return this->cachedBytes;
+}
+
+void S3ChunkPool::unmap(void* p, size_t size) {
+    munmap(p, MappedSize(size));
+}
+
+S3ChunkPool& GetS3ChunkPool() {
+    static S3ChunkPool pool;
+    return pool;
+}
@@ -0,0 +1,243 @@
+#include "s3rate_limiter.h"
+
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "s3log.h"
+
+// Distinct segments of the taken slots, at least one.
+static uint32_t countSegments(const S3RateLimiterState *s) {
+    uint32_t numOfSegments = 0;
+    for (int i = 0; i < S3_RATE_LIMITER_MAX_SLOTS; i++) {
+        bool counted = (s->pids[i] == 0);
+        for (int j = 0; j < i && !counted; j++) {
+            counted = (s->pids[j] != 0) && (s->segIds[j] == s->segIds[i]);
+        }
+        numOfSegments += counted ? 0 : 1;
+    }
+
+    return std::max(numOfSegments, (uint32_t)1);
+}
+
+S3RateLimiter::S3RateLimiter() : fd(-1), state(NULL), rate(0), segNum(1), segId(0), slot(-1) {
+    pthread_mutex_init(&this->mutex, NULL);
+}
+
+S3RateLimiter::~S3RateLimiter() {
+    this->setup("", 0, 0, 1, 0);
+    pthread_mutex_destroy(&this->mutex);
+}
+
+void S3RateLimiter::setup(const string &path, uint64_t rate, int32_t segId, uint64_t segNum,
+                          uint64_t nowUs) {
+    this->detach();
+    if (this->state != &this->localState && this->state != NULL) {
+        munmap(this->state, sizeof(S3RateLimiterState));
+    }
+    if (this->fd >= 0) {
+        ::close(this->fd);
+        this->fd = -1;
+    }
+    this->state = NULL;
+
+    this->rate = rate;
+    this->segId = segId;
+    this->segNum = std::max(segNum, (uint64_t)1);
+    if (rate == 0) {
+        return;
+    }
+
+    if (!path.empty()) {
+        this->fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        if (this->fd < 0) {
+            S3WARN("Failed to open rate limiter file '%s': %s", path.c_str(), strerror(errno));
+        } else if (ftruncate(this->fd, sizeof(S3RateLimiterState)) != 0) {
+            S3WARN("Failed to resize rate limiter file '%s': %s", path.c_str(), strerror(errno));
+        } else {
+            void *p = mmap(NULL, sizeof(S3RateLimiterState), PROT_READ | PROT_WRITE, MAP_SHARED,
+                           this->fd, 0);
+            if (p == MAP_FAILED) {
+                S3WARN("Failed to map rate limiter file '%s': %s", path.c_str(), strerror(errno));
+            } else {
+                this->state = (S3RateLimiterState *)p;
+            }
+        }
+
+        if ((this->state == NULL) && (this->fd >= 0)) {
+            ::close(this->fd);
+            this->fd = -1;
+        }
+    }
+
+    // requests of this process are limited on their own.
+    if (this->state == NULL) {
+        memset(&this->localState, 0, sizeof(this->localState));
+        this->state = &this->localState;
+    }
+
+    this->attach(nowUs);
+}
+
+void S3RateLimiter::lock() {
+    pthread_mutex_lock(&this->mutex);
+    if (this->fd >= 0) {
+        flock(this->fd, LOCK_EX);
+    }
+}
+
+void S3RateLimiter::unlock() {
+    if (this->fd >= 0) {
+        flock(this->fd, LOCK_UN);
+    }
+    pthread_mutex_unlock(&this->mutex);
+}
+
+// Take a slot of the state, and count the segments attached to it. Slots of processes that are
+// gone are freed.
+void S3RateLimiter::attach(uint64_t nowUs) {
+    this->lock();
+
+    S3RateLimiterState *s = this->state;
+
+    // a new file is zeroed, the state is initialized by the first process.
+    bool initialized = (s->magic == S3_RATE_LIMITER_MAGIC);
+    if (!initialized) {
+        memset(s, 0, sizeof(*s));
+        s->magic = S3_RATE_LIMITER_MAGIC;
+        s->factor = 1.0;
+        s->updatedUs = nowUs;
+    }
+
+    for (int i = 0; i < S3_RATE_LIMITER_MAX_SLOTS; i++) {
+        if ((s->pids[i] != 0) && (kill(s->pids[i], 0) != 0) && (errno == ESRCH)) {
+            s->pids[i] = 0;
+        }
+        if ((this->slot < 0) && (s->pids[i] == 0)) {
+            s->pids[i] = getpid();
+            s->segIds[i] = this->segId;
+            this->slot = i;
+        }
+    }
+
+    s->numOfSegments = countSegments(s);
+
+    // the bucket starts full.
+    if (!initialized) {
+        s->tokens = std::max(this->hostRateLocked(), 1.0);
+    }
+    this->refill(nowUs);
+
+    this->unlock();
+}
+
+void S3RateLimiter::detach() {
+    if ((this->state == NULL) || (this->slot < 0)) {
+        return;
+    }
+
+    this->lock();
+
+    S3RateLimiterState *s = this->state;
+    s->pids[this->slot] = 0;
+    this->slot = -1;
+
+    s->numOfSegments = countSegments(s);
+
+    this->unlock();
+}
+
+double S3RateLimiter::hostRateLocked() {
+    return (double)this->rate * this->state->numOfSegments / this->segNum * this->state->factor;
+}
+
+// Add the tokens of the time passed, up to a second of requests.
+void S3RateLimiter::refill(uint64_t nowUs) {
+    S3RateLimiterState *s = this->state;
+    if (nowUs <= s->updatedUs) {
+        return;
+    }
+
+    // the rate grows from the end of the interval after the last throttled request.
+    uint64_t growFromUs = std::max(s->updatedUs, s->throttledUs + S3_RATE_DECREASE_INTERVAL_US);
+    if (nowUs > growFromUs) {
+        double growth = (nowUs - growFromUs) / 1000000.0 * S3_RATE_INCREASE_PER_SECOND;
+        s->factor = std::min(s->factor + growth, 1.0);
+    }
+
+    double elapsed = (nowUs - s->updatedUs) / 1000000.0;
+
+    double hostRate = this->hostRateLocked();
+    s->tokens = std::min(s->tokens + elapsed * hostRate, std::max(hostRate, 1.0));
+    s->updatedUs = nowUs;
+}
+
+uint64_t S3RateLimiter::reserve(uint64_t nowUs) {
+    if (!this->isEnabled()) {
+        return 0;
+    }
+
+    this->lock();
+
+    this->refill(nowUs);
+    this->state->tokens -= 1;
+
+    // the request waits for the tokens reserved before it to be filled.
+    uint64_t waitUs = 0;
+    if (this->state->tokens < 0) {
+        waitUs = (uint64_t)(-this->state->tokens / this->hostRateLocked() * 1000000);
+    }
+
+    this->unlock();
+
+    return waitUs;
+}
+
+void S3RateLimiter::unreserve() {
+    if (!this->isEnabled()) {
+        return;
+    }
+
+    this->lock();
+    this->state->tokens += 1;
+    this->unlock();
+}
+
+void S3RateLimiter::throttled(uint64_t nowUs) {
+    if (!this->isEnabled()) {
+        return;
+    }
+
+    this->lock();
+
+    this->refill(nowUs);
+
+    // the requests in flight when the server starts throttling are throttled together, count them
+    // as one.
+    S3RateLimiterState *s = this->state;
+    if ((s->throttledUs == 0) || (nowUs - s->throttledUs >= S3_RATE_DECREASE_INTERVAL_US)) {
+        s->factor = std::max(s->factor / 2, S3_RATE_MIN_FACTOR);
+        s->tokens = std::min(s->tokens, 0.0);
+        s->throttledUs = nowUs;
+
+        S3INFO("Requests are throttled, lower the rate of this host to %.1f requests/s",
+               this->hostRateLocked());
+    }
+
+    this->unlock();
+}
+
+double S3RateLimiter::getHostRate(uint64_t nowUs) {
+    if (!this->isEnabled()) {
+        return 0;
+    }
+
+    this->lock();
+    this->refill(nowUs);
+    double hostRate = this->hostRateLocked();
+    this->unlock();
+
+    return hostRate;
+}
@@ -0,0 +1,171 @@
+#include "s3read_cache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "s3utils.h"
+
+static bool readFully(int fd, uint8_t *buf, uint64_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, buf, len);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+static bool writeFully(int fd, const uint8_t *buf, uint64_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+string S3ReadCache::getEntryPath(const S3Url &s3Url, const string &etag, uint64_t offset,
+                                 uint64_t len) const {
+    stringstream ss;
+    ss << s3Url.getFullUrlForCurl() << '\n'
+       << s3Url.getRegion() << '\n'
+       << etag << '\n'
+       << offset << '\n'
+       << len;
+
+    char hash[SHA256_DIGEST_STRING_LENGTH];
+    sha256_hex(ss.str().c_str(), hash);
+
+    return this->dir + "/" + S3_READ_CACHE_PREFIX + hash;
+}
+
+bool S3ReadCache::load(const S3Url &s3Url, const string &etag, uint64_t offset, uint64_t len,
+                       S3VectorUInt8 &data) {
+    if (!this->isEnabled()) {
+        return false;
+    }
+
+    string path = this->getEntryPath(s3Url, etag, offset, len);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    bool loaded = false;
+    if ((fstat(fd, &st) == 0) && ((uint64_t)st.st_size == len)) {
+        data.resize(len);
+        loaded = readFully(fd, data.data(), len);
+    }
+
+    if (loaded) {
+        // mark it as recently used.
+        futimens(fd, NULL);
+    } else {
+        S3WARN("Read cache entry '%s' is corrupted, remove it", path.c_str());
+        unlink(path.c_str());
+        data.release();
+    }
+
+    ::close(fd);
+    return loaded;
+}
+
+void S3ReadCache::save(const S3Url &s3Url, const string &etag, uint64_t offset,
+                       const S3VectorUInt8 &data) {
+    if (!this->isEnabled() || data.empty()) {
+        return;
+    }
+
+    string path = this->getEntryPath(s3Url, etag, offset, data.size());
+
+    // other processes never see a partial entry, it is renamed after all data is written.
+    stringstream ss;
+    ss << path << ".tmp." << getpid() << "." << (uint64_t)pthread_self();
+    string tmpPath = ss.str();
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        S3WARN("Failed to create read cache entry '%s': %s", tmpPath.c_str(), strerror(errno));
+        return;
+    }
+
+    bool written = writeFully(fd, data.data(), data.size());
+    written = (::close(fd) == 0) && written;
+
+    if (!written || (rename(tmpPath.c_str(), path.c_str()) != 0)) {
+        S3WARN("Failed to save read cache entry '%s': %s", path.c_str(), strerror(errno));
+        unlink(tmpPath.c_str());
+        return;
+    }
+
+    this->evict();
+}
+
+struct ReadCacheEntry {
+    string path;
+    uint64_t size;
+    struct timespec mtime;
+};
+
+static bool isLessRecentlyUsed(const ReadCacheEntry &a, const ReadCacheEntry &b) {
+    if (a.mtime.tv_sec != b.mtime.tv_sec) {
+        return a.mtime.tv_sec < b.mtime.tv_sec;
+    }
+    return a.mtime.tv_nsec < b.mtime.tv_nsec;
+}
+
+void S3ReadCache::evict() {
+    DIR *dirp = opendir(this->dir.c_str());
+    if (dirp == NULL) {
+        S3WARN("Failed to open read cache directory '%s': %s", this->dir.c_str(), strerror(errno));
+        return;
+    }
+
+    vector<ReadCacheEntry> entries;
+    uint64_t total = 0;
+
+    struct dirent *ent;
+    while ((ent = readdir(dirp)) != NULL) {
+        if (strncmp(ent->d_name, S3_READ_CACHE_PREFIX, strlen(S3_READ_CACHE_PREFIX)) != 0) {
+            continue;
+        }
+
+        ReadCacheEntry entry;
+        entry.path = this->dir + "/" + ent->d_name;
+
+        struct stat st;
+        if ((stat(entry.path.c_str(), &st) != 0) || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        entry.size = st.st_size;
+        entry.mtime = st.st_mtim;
+        entries.push_back(entry);
+        total += entry.size;
+    }
+    closedir(dirp);
+
+    if (total <= this->capacity) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), isLessRecentlyUsed);
+
+    // entries might be removed by other processes at the same time.
+    for (size_t i = 0; (i < entries.size()) && (total > this->capacity); i++) {
+        if ((unlink(entries[i].path.c_str()) == 0) || (errno == ENOENT)) {
+            total -= entries[i].size;
+        }
+    }
+
+    S3DEBUG("Read cache '%s' is evicted to %" PRIu64 " bytes", this->dir.c_str(), total);
+}
@@ -1,11 +1,14 @@
 #include "s3restful_service.h"
 
+#include "s3iostats.h"
+
 S3RESTfulService::S3RESTfulService()
     : lowSpeedLimit(0),
       lowSpeedTime(0),
       proxy(""),
       debugCurl(false),
       verifyCert(true),
+      multiplexIO(false),
       chunkBufferSize(64 * 1024) {
 }
 
@@ -15,6 +18,7 @@ S3RESTfulService::S3RESTfulService(const string &proxy)
       proxy(proxy),
       debugCurl(false),
       verifyCert(true),
+      multiplexIO(false),
       chunkBufferSize(64 * 1024) {
 }
 
@@ -30,9 +34,16 @@ S3RESTfulService::S3RESTfulService(const S3Params &params)
     this->chunkBufferSize = params.getChunkSize();
     this->verifyCert = params.isVerifyCert();
     this->proxy = params.getProxy();
+    this->multiplexIO = params.isMultiplexIO();
 }
 
 S3RESTfulService::~S3RESTfulService() {
+    // Handles of in-flight transfers go back to the pool when they finish.
+    this->multiDriver.stop();
+
+    // Pooled handles must be cleaned up before the global cleanup below.
+    this->curlPool.clear();
+
     // This function is not thread safe, must NOT call it when any other
     // threads are running, that is, do NOT put it in threads.
     curl_global_cleanup();
@@ -94,12 +105,123 @@ static size_t RESTfulServiceReadFuncCallback(char *ptr, size_t size, size_t nmem
     return copiedItemNum;
 }
 
-struct CURLWrapper {
-    CURLWrapper(const string &url, curl_slist *headers, uint64_t lowSpeedLimit,
-                uint64_t lowSpeedTime, bool debugCurl, string proxy) {
+CURLHandlePool::CURLHandlePool() : share(NULL) {
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&this->shareLocks[i], NULL);
+    }
+    pthread_mutex_init(&this->poolLock, NULL);
+}
+
+CURLHandlePool::~CURLHandlePool() {
+    this->clear();
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&this->shareLocks[i]);
+    }
+    pthread_mutex_destroy(&this->poolLock);
+}
+
+void CURLHandlePool::lockShareData(CURL *curl, curl_lock_data data, curl_lock_access access,
+                                   void *userp) {
+    CURLHandlePool *pool = (CURLHandlePool *)userp;
+    pthread_mutex_lock(&pool->shareLocks[data]);
+}
+
+void CURLHandlePool::unlockShareData(CURL *curl, curl_lock_data data, void *userp) {
+    CURLHandlePool *pool = (CURLHandlePool *)userp;
+    pthread_mutex_unlock(&pool->shareLocks[data]);
+}
+
+// must be called with poolLock held.
+void CURLHandlePool::initShare() {
+    this->share = curl_share_init();
+    if (this->share == NULL) {
+        S3WARN("Failed to initialize curl share interface, DNS and TLS session are not shared");
+        return;
+    }
+
+    curl_share_setopt(this->share, CURLSHOPT_LOCKFUNC, CURLHandlePool::lockShareData);
+    curl_share_setopt(this->share, CURLSHOPT_UNLOCKFUNC, CURLHandlePool::unlockShareData);
+    curl_share_setopt(this->share, CURLSHOPT_USERDATA, (void *)this);
+
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900  // connection cache sharing requires curl 7.57.0
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+
+CURL *CURLHandlePool::acquire() {
+    CURL *curl = NULL;
+
+    {
+        UniqueLock lock(&this->poolLock);
+
+        if (this->share == NULL) {
+            this->initShare();
+        }
+
+        if (!this->idleHandles.empty()) {
+            curl = this->idleHandles.back();
+            this->idleHandles.pop_back();
+        }
+    }
+
+    if (curl == NULL) {
         curl = curl_easy_init();
+        S3_CHECK_OR_DIE(curl != NULL, S3RuntimeError, "Failed to create curl handle");
+    }
+
+    if (this->share != NULL) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, this->share);
+    }
+
+    return curl;
+}
+
+void CURLHandlePool::release(CURL *curl, bool reusable) {
+    if (curl == NULL) {
+        return;
+    }
+
+    if (!reusable) {
+        curl_easy_cleanup(curl);
+        return;
+    }
+
+    // curl_easy_reset() clears all options but keeps live connections and caches.
+    curl_easy_reset(curl);
+
+    UniqueLock lock(&this->poolLock);
+    this->idleHandles.push_back(curl);
+}
+
+void CURLHandlePool::clear() {
+    UniqueLock lock(&this->poolLock);
+
+    for (size_t i = 0; i < this->idleHandles.size(); i++) {
+        curl_easy_cleanup(this->idleHandles[i]);
+    }
+    this->idleHandles.clear();
+
+    if (this->share != NULL) {
+        curl_share_cleanup(this->share);
+        this->share = NULL;
+    }
+}
+
+uint64_t CURLHandlePool::getIdleCount() {
+    UniqueLock lock(&this->poolLock);
+    return this->idleHandles.size();
+}
+
+struct CURLWrapper {
+    CURLWrapper(CURLHandlePool &pool, const string &url, curl_slist *headers,
+                uint64_t lowSpeedLimit, uint64_t lowSpeedTime, bool debugCurl, string proxy)
+        : pool(pool), reusable(false) {
+        curl = pool.acquire();
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
         curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, lowSpeedLimit);
@@ -114,13 +236,18 @@ struct CURLWrapper {
         }
     }
     ~CURLWrapper() {
-        curl_easy_cleanup(curl);
+        pool.release(curl, reusable);
     }
     CURL *curl;
+    CURLHandlePool &pool;
+
+    // set only after a completed transfer, the connection of a failed one is not trusted.
+    bool reusable;
 };
 
-void S3RESTfulService::performCurl(CURL *curl, Response &response) {
-    CURLcode res = curl_easy_perform(curl);
+// Fill response with the result of a finished transfer, or throw the error of the transfer.
+static void FillCurlResponse(CURLWrapper &wrapper, CURLcode res, Response &response) {
+    CURL *curl = wrapper.curl;
     if (res != CURLE_OK) {
         if (res == CURLE_COULDNT_RESOLVE_HOST || res == CURLE_COULDNT_RESOLVE_PROXY) {
             S3_DIE(S3ResolveError, curl_easy_strerror(res));
@@ -135,7 +262,354 @@ void S3RESTfulService::performCurl(CURL *curl, Response &response) {
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
 
         response.FillResponse(responseCode);
+        wrapper.reusable = true;
+    }
+}
+
+void S3RESTfulService::performCurl(CURLWrapper &wrapper, Response &response) {
+    FillCurlResponse(wrapper, curl_easy_perform(wrapper.curl), response);
+}
+
+// Throw S3ConnectionError for failed responses worth retrying, S3ThrottleError for the throttled
+// ones.
+static void CheckRetryableResponse(const Response &response) {
+    S3MessageParser s3msg(response);
+    ResponseCode responseCode = response.getResponseCode();
+
+    if ((responseCode == 503) || (s3msg.getCode().compare("SlowDown") == 0)) {
+        GetS3IOStats().add(S3IO_THROTTLES);
+    }
+    if (responseCode == 503) {
+        S3_DIE(S3ThrottleError, s3msg.getMessage());
+    }
+    if (responseCode == 500) {
+        S3_DIE(S3ConnectionError, s3msg.getMessage());
+    }
+    if (responseCode == 400) {
+        if (s3msg.getCode().compare("RequestTimeout") == 0) {
+            S3_DIE(S3ConnectionError, s3msg.getMessage());
+        }
+    }
+}
+
+CURLMultiDriver::CURLMultiDriver()
+    : multi(NULL), thread(0), started(false), stopping(false), activeCount(0) {
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->cond, NULL);
+}
+
+CURLMultiDriver::~CURLMultiDriver() {
+    this->stop();
+
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->cond);
+}
+
+void *CURLMultiDriver::IOThreadFunc(void *p) {
+    MaskThreadSignals();
+
+    CURLMultiDriver *driver = (CURLMultiDriver *)p;
+    S3DEBUG("I/O thread starts");
+    driver->run();
+    S3DEBUG("I/O thread ended");
+
+    return NULL;
+}
+
+void CURLMultiDriver::submit(CURLTransfer *transfer) {
+    UniqueLock lock(&this->mutex);
+
+    if (!this->started) {
+        this->multi = curl_multi_init();
+        if (this->multi == NULL) {
+            delete transfer;
+            S3_DIE(S3RuntimeError, "Failed to create curl multi handle");
+        }
+
+#ifdef CURLPIPE_MULTIPLEX
+        curl_multi_setopt(this->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+        this->stopping = false;
+        pthread_create(&this->thread, NULL, CURLMultiDriver::IOThreadFunc, this);
+        this->started = true;
     }
+
+    this->pendingTransfers.push_back(transfer);
+    this->activeCount++;
+
+#if LIBCURL_VERSION_NUM >= 0x074400  // curl_multi_wakeup() requires curl 7.68.0
+    curl_multi_wakeup(this->multi);
+#endif
+    pthread_cond_signal(&this->cond);
+}
+
+void CURLMultiDriver::stop() {
+    {
+        UniqueLock lock(&this->mutex);
+        if (!this->started) {
+            return;
+        }
+
+        this->stopping = true;
+        pthread_cond_signal(&this->cond);
+    }
+
+    pthread_join(this->thread, NULL);
+
+    curl_multi_cleanup(this->multi);
+    this->multi = NULL;
+    this->started = false;
+}
+
+uint64_t CURLMultiDriver::getActiveCount() {
+    UniqueLock lock(&this->mutex);
+    return this->activeCount;
+}
+
+void CURLMultiDriver::run() {
+    uint64_t delayUs = 0;
+
+    while (true) {
+        vector<CURLTransfer *> newTransfers;
+
+        {
+            UniqueLock lock(&this->mutex);
+            while (this->pendingTransfers.empty() && this->runningTransfers.empty()) {
+                if (!this->delayedTransfers.empty()) {
+                    // only delayed transfers are left, sleep until the first of them is due.
+                    CondTimedWaitUs(&this->cond, &this->mutex, delayUs);
+                    break;
+                }
+                if (this->stopping) {
+                    return;
+                }
+                pthread_cond_wait(&this->cond, &this->mutex);
+            }
+            newTransfers.swap(this->pendingTransfers);
+        }
+
+        delayUs = this->startTransfers(newTransfers);
+
+        int running = 0;
+        curl_multi_perform(this->multi, &running);
+
+        this->finishTransfers();
+
+        if (!this->runningTransfers.empty()) {
+            uint64_t timeoutMs = 1000;
+            if (delayUs > 0) {
+                timeoutMs = std::min(timeoutMs, delayUs / 1000 + 1);
+            }
+#if LIBCURL_VERSION_NUM >= 0x074400  // curl_multi_poll() requires curl 7.68.0
+            curl_multi_poll(this->multi, NULL, 0, timeoutMs, NULL);
+#else
+            curl_multi_wait(this->multi, NULL, 0, std::min(timeoutMs, (uint64_t)10), NULL);
+#endif
+        }
+    }
+}
+
+uint64_t CURLMultiDriver::startTransfers(vector<CURLTransfer *> &newTransfers) {
+    uint64_t nowUs = GetCurrentTimeUs();
+    uint64_t delayUs = 0;
+
+    newTransfers.insert(newTransfers.end(), this->delayedTransfers.begin(),
+                        this->delayedTransfers.end());
+    this->delayedTransfers.clear();
+
+    for (size_t i = 0; i < newTransfers.size(); i++) {
+        uint64_t startUs = newTransfers[i]->getStartTimeUs();
+        if (startUs > nowUs) {
+            this->delayedTransfers.push_back(newTransfers[i]);
+            delayUs = (delayUs == 0) ? startUs - nowUs : std::min(delayUs, startUs - nowUs);
+            continue;
+        }
+
+        CURL *curl = newTransfers[i]->getHandle();
+        this->runningTransfers[curl] = newTransfers[i];
+
+        if (curl_multi_add_handle(this->multi, curl) != CURLM_OK) {
+            this->runningTransfers.erase(curl);
+            this->complete(newTransfers[i], CURLE_FAILED_INIT);
+        }
+    }
+
+    return delayUs;
+}
+
+void CURLMultiDriver::finishTransfers() {
+    CURLMsg *msg = NULL;
+    int left = 0;
+
+    while ((msg = curl_multi_info_read(this->multi, &left)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        // msg is freed by curl_multi_remove_handle().
+        CURL *curl = msg->easy_handle;
+        CURLcode result = msg->data.result;
+
+        std::map<CURL *, CURLTransfer *>::iterator it = this->runningTransfers.find(curl);
+        if (it == this->runningTransfers.end()) {
+            continue;
+        }
+
+        CURLTransfer *transfer = it->second;
+        this->runningTransfers.erase(it);
+        curl_multi_remove_handle(this->multi, curl);
+
+        this->complete(transfer, result);
+    }
+}
+
+void CURLMultiDriver::complete(CURLTransfer *transfer, CURLcode result) {
+    try {
+        transfer->finish(result);
+    } catch (...) {
+        S3ERROR("Unexpected error in finishing a transfer");
+    }
+    delete transfer;
+
+    UniqueLock lock(&this->mutex);
+    this->activeCount--;
+    pthread_cond_broadcast(&this->cond);
+}
+
+// A GET or PUT run by the I/O thread, see S3RESTfulService::getAsync().
+class S3AsyncTransfer : public CURLTransfer {
+   public:
+    S3AsyncTransfer(CURLHandlePool &pool, const string &url, curl_slist *headers,
+                    uint64_t lowSpeedLimit, uint64_t lowSpeedTime, bool debugCurl, string proxy,
+                    RESTfulCallback *callback, S3MemoryContext &context)
+        : wrapper(pool, url, headers, lowSpeedLimit, lowSpeedTime, debugCurl, proxy),
+          response(RESPONSE_ERROR, context),
+          uploadData(NULL),
+          callback(callback) {
+    }
+    virtual ~S3AsyncTransfer() {
+        delete uploadData;
+    }
+
+    CURL *getHandle() {
+        return wrapper.curl;
+    }
+
+    uint64_t getStartTimeUs() {
+        // a cancelled transfer is started at once to finish soon.
+        if (S3QueryIsAbortInProgress() || this->callback->isCancelled()) {
+            return 0;
+        }
+        return this->callback->getStartTimeUs();
+    }
+
+    void finish(CURLcode result) {
+        std::exception_ptr error;
+
+        try {
+            FillCurlResponse(this->wrapper, result, this->response);
+            if (!this->response.isSuccess()) {
+                CheckRetryableResponse(this->response);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        this->callback->onResponse(this->response, error);
+    }
+
+    CURLWrapper wrapper;
+    Response response;
+    UploadData *uploadData;
+    RESTfulCallback *callback;
+};
+
+// curl's write function callback of asynchronous requests.
+static size_t AsyncWriteFuncCallback(char *ptr, size_t size, size_t nmemb, void *userp) {
+    S3AsyncTransfer *transfer = (S3AsyncTransfer *)userp;
+    if (S3QueryIsAbortInProgress() || transfer->callback->isCancelled()) {
+        return 0;
+    }
+
+    size_t realsize = size * nmemb;
+    transfer->response.appendDataBuffer(ptr, realsize);
+    return realsize;
+}
+
+// curl's headers write function callback of asynchronous requests.
+static size_t AsyncHeadersWriteFuncCallback(char *ptr, size_t size, size_t nmemb, void *userp) {
+    S3AsyncTransfer *transfer = (S3AsyncTransfer *)userp;
+    if (S3QueryIsAbortInProgress() || transfer->callback->isCancelled()) {
+        return 0;
+    }
+
+    size_t realsize = size * nmemb;
+    transfer->response.appendHeadersBuffer(ptr, realsize);
+    return realsize;
+}
+
+S3AsyncTransfer *S3RESTfulService::createTransfer(const string &url, HTTPHeaders &headers,
+                                                  RESTfulCallback *callback,
+                                                  S3MemoryContext &context) {
+    // headers might be reused by a retry of the same request.
+    headers.FreeList();
+    headers.CreateList();
+
+    S3AsyncTransfer *transfer = new S3AsyncTransfer(
+        this->curlPool, url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
+        this->debugCurl, this->proxy, callback, context);
+    CURL *curl = transfer->getHandle();
+
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)transfer);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, AsyncWriteFuncCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)transfer);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, AsyncHeadersWriteFuncCallback);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, this->verifyCert);
+
+#ifdef CURL_HTTP_VERSION_2TLS
+    // HTTP/2 is negotiated over TLS only, HTTP/1.1 is used if the server doesn't support it.
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+
+    // wait for a connection that can be multiplexed instead of opening another one.
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+#endif
+
+    return transfer;
+}
+
+bool S3RESTfulService::getAsync(const string &url, HTTPHeaders &headers,
+                                RESTfulCallback *callback) {
+    if (!this->multiplexIO) {
+        return false;
+    }
+
+    S3AsyncTransfer *transfer = this->createTransfer(url, headers, callback, this->s3MemContext);
+    transfer->response.getRawData().reserve(this->chunkBufferSize);
+
+    this->multiDriver.submit(transfer);
+    return true;
+}
+
+bool S3RESTfulService::putAsync(const string &url, HTTPHeaders &headers,
+                                const S3VectorUInt8 &data, RESTfulCallback *callback) {
+    if (!this->multiplexIO) {
+        return false;
+    }
+
+    // the response of an upload is small, it must not take a chunk preallocated for the parts.
+    S3MemoryContext responseContext;
+    S3AsyncTransfer *transfer = this->createTransfer(url, headers, callback, responseContext);
+    CURL *curl = transfer->getHandle();
+
+    transfer->uploadData = new UploadData(data);
+    curl_easy_setopt(curl, CURLOPT_READDATA, (void *)transfer->uploadData);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, RESTfulServiceReadFuncCallback);
+    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)data.size());
+    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+
+    this->multiDriver.submit(transfer);
+    return true;
 }
 
 // get() will execute HTTP GET RESTful API with given url/headers/params,
@@ -148,31 +622,21 @@ Response S3RESTfulService::get(const string &url, HTTPHeaders &headers) {
     response.getRawData().reserve(this->chunkBufferSize);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, RESTfulServiceWriteFuncCallback);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, this->verifyCert);
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response;
     }
 
-    S3MessageParser s3msg(response);
-    ResponseCode responseCode = response.getResponseCode();
-
-    if ((responseCode == 500) || (responseCode == 503)) {
-        S3_DIE(S3ConnectionError, s3msg.getMessage());
-    }
-    if (responseCode == 400) {
-        if (s3msg.getCode().compare("RequestTimeout") == 0) {
-            S3_DIE(S3ConnectionError, s3msg.getMessage());
-        }
-    }
+    CheckRetryableResponse(response);
 
     return response;
 }
@@ -181,8 +645,8 @@ Response S3RESTfulService::put(const string &url, HTTPHeaders &headers, const S3
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -198,23 +662,13 @@ Response S3RESTfulService::put(const string &url, HTTPHeaders &headers, const S3
     curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)&response);
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, RESTfulServiceHeadersWriteFuncCallback);
 
-    this->performCurl(curl, response);
-
-    S3MessageParser s3msg(response);
-    ResponseCode responseCode = response.getResponseCode();
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response;
     }
 
-    if ((responseCode == 500) || (responseCode == 503)) {
-        S3_DIE(S3ConnectionError, s3msg.getMessage());
-    }
-    if (responseCode == 400) {
-        if (s3msg.getCode().compare("RequestTimeout") == 0) {
-            S3_DIE(S3ConnectionError, s3msg.getMessage());
-        }
-    }
+    CheckRetryableResponse(response);
 
     return response;
 }
@@ -224,8 +678,8 @@ Response S3RESTfulService::post(const string &url, HTTPHeaders &headers,
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -239,23 +693,13 @@ Response S3RESTfulService::post(const string &url, HTTPHeaders &headers,
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, RESTfulServiceReadFuncCallback);
     curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)data.size());
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response;
     }
 
-    S3MessageParser s3msg(response);
-    ResponseCode responseCode = response.getResponseCode();
-
-    if ((responseCode == 500) || (responseCode == 503)) {
-        S3_DIE(S3ConnectionError, s3msg.getMessage());
-    }
-    if (responseCode == 400) {
-        if (s3msg.getCode().compare("RequestTimeout") == 0) {
-            S3_DIE(S3ConnectionError, s3msg.getMessage());
-        }
-    }
+    CheckRetryableResponse(response);
 
     return response;
 }
@@ -269,41 +713,31 @@ ResponseCode S3RESTfulService::head(const string &url, HTTPHeaders &headers) {
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "HEAD");
     curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, this->verifyCert);
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response.getResponseCode();
     }
 
-    S3MessageParser s3msg(response);
-    ResponseCode responseCode = response.getResponseCode();
-
-    if ((responseCode == 500) || (responseCode == 503)) {
-        S3_DIE(S3ConnectionError, s3msg.getMessage());
-    }
-    if (responseCode == 400) {
-        if (s3msg.getCode().compare("RequestTimeout") == 0) {
-            S3_DIE(S3ConnectionError, s3msg.getMessage());
-        }
-    }
+    CheckRetryableResponse(response);
 
-    return responseCode;
+    return response.getResponseCode();
 }
 
 Response S3RESTfulService::deleteRequest(const string &url, HTTPHeaders &headers) {
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -317,23 +751,13 @@ Response S3RESTfulService::deleteRequest(const string &url, HTTPHeaders &headers
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, RESTfulServiceReadFuncCallback);
     curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)data.size());
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response;
     }
 
-    S3MessageParser s3msg(response);
-    ResponseCode responseCode = response.getResponseCode();
-
-    if ((responseCode == 500) || (responseCode == 503)) {
-        S3_DIE(S3ConnectionError, s3msg.getMessage());
-    }
-    if (responseCode == 400) {
-        if (s3msg.getCode().compare("RequestTimeout") == 0) {
-            S3_DIE(S3ConnectionError, s3msg.getMessage());
-        }
-    }
+    CheckRetryableResponse(response);
 
     return response;
 }
@@ -385,3 +809,33 @@ string S3MessageParser::parseS3Tag(const string &tag) {
     }
     return contentStr;
 }
+
+string S3MessageParser::parseS3Tag(const string &parent, const string &tag) {
+    string contentStr;
+
+    xmlNode *rootElement = (xmlptr == NULL) ? NULL : xmlDocGetRootElement(xmlptr->myDoc);
+    if (rootElement == NULL) {
+        return contentStr;
+    }
+
+    for (xmlNodePtr parentNode = rootElement->xmlChildrenNode; parentNode != NULL;
+         parentNode = parentNode->next) {
+        if (xmlStrcmp(parentNode->name, (const xmlChar *)parent.c_str()) != 0) {
+            continue;
+        }
+
+        for (xmlNodePtr curNode = parentNode->xmlChildrenNode; curNode != NULL;
+             curNode = curNode->next) {
+            if (xmlStrcmp(curNode->name, (const xmlChar *)tag.c_str()) == 0) {
+                char *content = (char *)xmlNodeGetContent(curNode);
+                if (content != NULL) {
+                    contentStr = content;
+                    xmlFree(content);
+                }
+                return contentStr;
+            }
+        }
+    }
+
+    return contentStr;
+}
@@ -0,0 +1,275 @@
+#include "s3select_reader.h"
+
+static string QuoteSQLString(const string &value) {
+    string quoted = "'";
+    for (uint64_t i = 0; i < value.size(); i++) {
+        if (value[i] == '\'') {
+            quoted.push_back('\'');
+        }
+        quoted.push_back(value[i]);
+    }
+    quoted.push_back('\'');
+
+    return quoted;
+}
+
+static string ColumnRef(uint64_t column) {
+    return "s._" + std::to_string((unsigned long long)column + 1);
+}
+
+// Condition of S3 Select that keeps every row satisfying the qual, return false if the qual can't
+// be expressed. Rows are still checked by the scan, so the condition may keep more rows.
+static bool BuildQualCondition(const S3ScanDesc &scanDesc, const S3ScanQual &qual,
+                               string &condition) {
+    if (qual.column >= scanDesc.columns.size()) {
+        return false;
+    }
+
+    string column = ColumnRef(qual.column);
+
+    if (!qual.numeric) {
+        if (qual.op != S3_QUAL_EQ) {
+            return false;
+        }
+        condition = column + " = " + QuoteSQLString(qual.value);
+        return true;
+    }
+
+    // NaN or Infinity can't be cast by S3 Select.
+    char *end = NULL;
+    double value = strtod(qual.value.c_str(), &end);
+    if (qual.value.empty() || (*end != '\0') || !std::isfinite(value)) {
+        return false;
+    }
+
+    // values are compared as FLOAT, two numbers may be equal after rounding, so strict comparisons
+    // are relaxed to keep them.
+    const char *op = NULL;
+    switch (qual.op) {
+        case S3_QUAL_EQ:
+            op = " = ";
+            break;
+        case S3_QUAL_LT:
+        case S3_QUAL_LE:
+            op = " <= ";
+            break;
+        case S3_QUAL_GT:
+        case S3_QUAL_GE:
+            op = " >= ";
+            break;
+        default:
+            return false;
+    }
+
+    // NULL fields fail the qual, CAST would reject them.
+    condition = "CASE WHEN " + column + " = " + QuoteSQLString(scanDesc.nullString) +
+                " THEN FALSE ELSE CAST(" + column + " AS FLOAT)" + op + "CAST(" +
+                QuoteSQLString(qual.value) + " AS FLOAT) END";
+    return true;
+}
+
+bool S3SelectCanPushDown(const S3ScanDesc &scanDesc) {
+    if (!scanDesc.csv || scanDesc.columns.empty() ||
+        (scanDesc.projected.size() != scanDesc.columns.size())) {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < scanDesc.projected.size(); i++) {
+        if (!scanDesc.projected[i]) {
+            return true;
+        }
+    }
+
+    string condition;
+    for (uint64_t i = 0; i < scanDesc.quals.size(); i++) {
+        if (BuildQualCondition(scanDesc, scanDesc.quals[i], condition)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+string BuildS3SelectExpression(const S3ScanDesc &scanDesc) {
+    stringstream sql;
+
+    // columns keep their positions in the line, unreferenced ones are replaced by NULL.
+    sql << "SELECT ";
+    for (uint64_t i = 0; i < scanDesc.columns.size(); i++) {
+        if (i > 0) {
+            sql << ", ";
+        }
+        if (scanDesc.projected[i]) {
+            sql << ColumnRef(i);
+        } else {
+            sql << QuoteSQLString(scanDesc.nullString);
+        }
+    }
+    sql << " FROM S3Object s";
+
+    string condition;
+    bool hasWhere = false;
+    for (uint64_t i = 0; i < scanDesc.quals.size(); i++) {
+        if (BuildQualCondition(scanDesc, scanDesc.quals[i], condition)) {
+            sql << (hasWhere ? " AND " : " WHERE ") << condition;
+            hasWhere = true;
+        }
+    }
+
+    return sql.str();
+}
+
+// Escape text of XML elements, control characters such as the EOL are written as references.
+static string EscapeXML(const string &value) {
+    stringstream escaped;
+    for (uint64_t i = 0; i < value.size(); i++) {
+        unsigned char c = value[i];
+        switch (c) {
+            case '&':
+                escaped << "&amp;";
+                break;
+            case '<':
+                escaped << "&lt;";
+                break;
+            case '>':
+                escaped << "&gt;";
+                break;
+            default:
+                if (c < 0x20) {
+                    escaped << "&#" << (int)c << ";";
+                } else {
+                    escaped << c;
+                }
+        }
+    }
+
+    return escaped.str();
+}
+
+// CSV settings of both input and output, they are in the format of the table.
+static string BuildCSVFormat(const S3ScanDesc &scanDesc) {
+    stringstream csv;
+
+    csv << "<RecordDelimiter>" << EscapeXML(eolString) << "</RecordDelimiter>"
+        << "<FieldDelimiter>" << EscapeXML(string(1, scanDesc.delimiter)) << "</FieldDelimiter>"
+        << "<QuoteCharacter>" << EscapeXML(string(1, scanDesc.quote)) << "</QuoteCharacter>";
+    if (scanDesc.escape != '\0') {
+        csv << "<QuoteEscapeCharacter>" << EscapeXML(string(1, scanDesc.escape))
+            << "</QuoteEscapeCharacter>";
+    }
+
+    return csv.str();
+}
+
+string BuildS3SelectRequest(const S3ScanDesc &scanDesc, const string &expression, bool gzip,
+                            uint64_t start, uint64_t end) {
+    stringstream body;
+
+    body << "<SelectObjectContentRequest xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+         << "<Expression>" << EscapeXML(expression) << "</Expression>"
+         << "<ExpressionType>SQL</ExpressionType>"
+         << "<InputSerialization>"
+         << "<CompressionType>" << (gzip ? "GZIP" : "NONE") << "</CompressionType>"
+         << "<CSV><FileHeaderInfo>" << (hasHeader ? "IGNORE" : "NONE") << "</FileHeaderInfo>"
+         << BuildCSVFormat(scanDesc) << "</CSV>"
+         << "</InputSerialization>"
+         << "<OutputSerialization>"
+         << "<CSV><QuoteFields>ASNEEDED</QuoteFields>" << BuildCSVFormat(scanDesc) << "</CSV>"
+         << "</OutputSerialization>";
+
+    // End of ScanRange is inclusive.
+    if (end > start) {
+        body << "<ScanRange><Start>" << start << "</Start><End>" << end - 1 << "</End></ScanRange>";
+    }
+
+    body << "</SelectObjectContentRequest>";
+
+    return body.str();
+}
+
+void S3SelectReader::open(const S3Params &params) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+
+    this->s3Url = params.getS3Url();
+    this->scanDesc = params.getScanDesc();
+    this->expression = BuildS3SelectExpression(this->scanDesc);
+
+    this->nextOffset = params.getKeyRangeStart();
+    this->rangeEnd = params.getKeyRangeEnd();
+    if (this->rangeEnd == 0 || this->rangeEnd > params.getKeySize()) {
+        this->rangeEnd = params.getKeySize();
+    }
+
+    // Scan ranges are not supported for compressed keys, and the header line is only skipped by
+    // S3 at the start of the key.
+    this->chunkSize = (this->gzip || hasHeader) ? 0 : params.getChunkSize();
+
+    this->out.clear();
+    this->outOffset = 0;
+
+    S3DEBUG("Selecting '%s' with \"%s\"", this->s3Url.getFullUrlForCurl().c_str(),
+            this->expression.c_str());
+
+    // header line is expected by S3BucketReader, which skips it. Keys are not split if the table
+    // has header line.
+    if (hasHeader && (this->nextOffset == 0)) {
+        for (uint64_t i = 0; i < this->scanDesc.columns.size(); i++) {
+            if (i > 0) {
+                this->out.push_back(this->scanDesc.delimiter);
+            }
+            this->out.insert(this->out.end(), this->scanDesc.columns[i].begin(),
+                             this->scanDesc.columns[i].end());
+        }
+        this->out.insert(this->out.end(), eolString, eolString + strlen(eolString));
+    }
+}
+
+void S3SelectReader::fillOutput() {
+    this->out.clear();
+    this->outOffset = 0;
+
+    // A scan range may have no selected row, go on with the next one.
+    while (this->out.empty() && (this->nextOffset < this->rangeEnd)) {
+        uint64_t start = 0;
+        uint64_t end = 0;
+        if (this->chunkSize > 0) {
+            start = this->nextOffset;
+            end = std::min(start + this->chunkSize, this->rangeEnd);
+        }
+        this->nextOffset = (this->chunkSize > 0) ? end : this->rangeEnd;
+
+        string request =
+            BuildS3SelectRequest(this->scanDesc, this->expression, this->gzip, start, end);
+        this->s3Interface->selectObjectContent(this->s3Url, request, this->out);
+    }
+}
+
+uint64_t S3SelectReader::read(char *buf, uint64_t count) {
+    const char *data = NULL;
+
+    uint64_t len = this->readView(&data, count);
+    if (len != 0) {
+        memcpy(buf, data, len);
+    }
+
+    return len;
+}
+
+uint64_t S3SelectReader::readView(const char **data, uint64_t count) {
+    if (this->outOffset >= this->out.size()) {
+        this->fillOutput();
+    }
+
+    uint64_t len = std::min(count, (uint64_t)(this->out.size() - this->outOffset));
+    *data = (const char *)this->out.data() + this->outOffset;
+    this->outOffset += len;
+
+    return len;
+}
+
+void S3SelectReader::close() {
+    this->out.release();
+    this->outOffset = 0;
+    this->nextOffset = 0;
+    this->rangeEnd = 0;
+}
@@ -1,12 +1,32 @@
 #include "s3utils.h"
 
 #include <iomanip>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 #ifndef S3_STANDALONE
 extern "C" {
 void write_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 }
 #endif
 
+// out must have room for 2 * len + 1 chars.
+static void HexEncode(const unsigned char *in, int len, char *out) {
+    static const char digits[] = "0123456789abcdef";
+
+    for (int i = 0; i < len; i++) {
+        out[i * 2] = digits[in[i] >> 4];
+        out[i * 2 + 1] = digits[in[i] & 0x0f];
+    }
+    out[len * 2] = 0;
+}
+
 // not returning the normal hex result, might have '\0'
 bool sha1hmac(const char *str, unsigned char out_hash[SHA_DIGEST_LENGTH], const char *secret,
               int secret_len) {
@@ -26,10 +46,7 @@ bool sha1hmac_hex(const char *str, char out_hash_hex[SHA_DIGEST_STRING_LENGTH],
 
     sha1hmac(str, hash, secret, secret_len);
 
-    for (int i = 0; i < SHA_DIGEST_LENGTH; i++) {
-        sprintf(out_hash_hex + (i * 2), "%02x", hash[i]);
-    }
-    out_hash_hex[SHA_DIGEST_STRING_LENGTH - 1] = 0;
+    HexEncode(hash, SHA_DIGEST_LENGTH, out_hash_hex);
 
     return true;
 }
@@ -42,10 +59,7 @@ bool sha256_hex(const char *string, uint64_t length,
 
     SHA256((unsigned char *)string, length, hash);
 
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(out_hash_hex + (i * 2), "%02x", hash[i]);
-    }
-    out_hash_hex[SHA256_DIGEST_STRING_LENGTH - 1] = 0;
+    HexEncode(hash, SHA256_DIGEST_LENGTH, out_hash_hex);
 
     return true;
 }
@@ -69,10 +83,7 @@ bool sha256hmac_hex(const char *str, char out_hash_hex[65], const char *secret,
 
     sha256hmac(str, hash, secret, secret_len);
 
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(out_hash_hex + (i * 2), "%02x", hash[i]);
-    }
-    out_hash_hex[SHA256_DIGEST_STRING_LENGTH - 1] = 0;
+    HexEncode(hash, SHA256_DIGEST_LENGTH, out_hash_hex);
 
     return true;
 }
@@ -322,6 +333,64 @@ void FindAndReplace(string &str, const string &find, const string &replace) {
 // Note: better to sort queries automatically
 // for more information refer to Amazon S3 document:
 // http://docs.aws.amazon.com/AmazonS3/latest/API/sigv4-query-string-auth.html
+// Signing keys of SigV4 only change with the day and the region, they are shared by all threads
+// of the process, so a request normally costs one HMAC instead of five. Keys of previous days
+// are dropped when a new day starts.
+class SigningKeyCache {
+   public:
+    SigningKeyCache() {
+        pthread_mutex_init(&this->mutex, NULL);
+    }
+    ~SigningKeyCache() {
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    void get(const string &secret, const string &date, const string &region,
+             unsigned char key[SHA256_DIGEST_LENGTH]) {
+        string name = region + "\n" + secret;
+
+        {
+            UniqueLock lock(&this->mutex);
+            if (this->date == date) {
+                map<string, string>::iterator it = this->keys.find(name);
+                if (it != this->keys.end()) {
+                    memcpy(key, it->second.data(), SHA256_DIGEST_LENGTH);
+                    return;
+                }
+            }
+        }
+
+        unsigned char keyDate[SHA256_DIGEST_LENGTH];
+        unsigned char keyRegion[SHA256_DIGEST_LENGTH];
+        unsigned char keyService[SHA256_DIGEST_LENGTH];
+
+        string kSecret = "AWS4" + secret;
+        sha256hmac(date.c_str(), keyDate, kSecret.c_str(), kSecret.size());
+        sha256hmac(region.c_str(), keyRegion, (char *)keyDate, SHA256_DIGEST_LENGTH);
+        sha256hmac("s3", keyService, (char *)keyRegion, SHA256_DIGEST_LENGTH);
+        sha256hmac("aws4_request", key, (char *)keyService, SHA256_DIGEST_LENGTH);
+
+        UniqueLock lock(&this->mutex);
+        if (this->date != date) {
+            this->date = date;
+            this->keys.clear();
+        }
+        this->keys[name] = string((char *)key, SHA256_DIGEST_LENGTH);
+    }
+
+   private:
+    pthread_mutex_t mutex;
+    string date;
+    map<string, string> keys;  // region and secret -> signing key
+};
+
+static SigningKeyCache signingKeyCache;
+
+void GetSigningKeyV4(const string &secret, const string &date, const string &region,
+                     unsigned char key[SHA256_DIGEST_LENGTH]) {
+    signingKeyCache.get(secret, date, region, key);
+}
+
 void SignRequestV4(const string &method, HTTPHeaders *headers, const string &origRegion,
                    const string &path, const string &query, const S3Credential &cred) {
     struct tm tm_info;
@@ -331,9 +400,6 @@ void SignRequestV4(const string &method, HTTPHeaders *headers, const string &ori
     char canonical_hex[SHA256_DIGEST_STRING_LENGTH] = {0};
     char signature_hex[SHA256_DIGEST_STRING_LENGTH] = {0};
 
-    unsigned char key_date[SHA256_DIGEST_LENGTH] = {0};
-    unsigned char key_region[SHA256_DIGEST_LENGTH] = {0};
-    unsigned char key_service[SHA256_DIGEST_LENGTH] = {0};
     unsigned char signing_key[SHA256_DIGEST_LENGTH] = {0};
 
     // YYYYMMDD'T'HHMMSS'Z'
@@ -349,28 +415,34 @@ void SignRequestV4(const string &method, HTTPHeaders *headers, const string &ori
 
     stringstream canonical_str;
 
-    canonical_str << method << "\n"
-                  << path << "\n"
-                  << query << "\nhost:" << headers->Get(HOST)
-                  << "\nx-amz-content-sha256:" << headers->Get(X_AMZ_CONTENT_SHA256)
-                  << "\nx-amz-date:" << headers->Get(X_AMZ_DATE);
+    canonical_str << method << "\n" << path << "\n" << query << "\n";
+
+    // all x-amz-* headers of the request must be signed, in the order of their names.
+    static const HeaderField signedFields[] = {HOST,
+                                               X_AMZ_CHECKSUM_ALGORITHM,
+                                               X_AMZ_CHECKSUM_CRC32C,
+                                               X_AMZ_CHECKSUM_TYPE,
+                                               X_AMZ_CONTENT_SHA256,
+                                               X_AMZ_DATE,
+                                               X_AMZ_OBJECT_ATTRIBUTES,
+                                               X_AMZ_SERVER_SIDE_ENCRYPTION};
 
     string signed_headers;
-    if (headers->Get(X_AMZ_SERVER_SIDE_ENCRYPTION) != NULL) {
-        canonical_str << "\nx-amz-server-side-encryption:"
-                      << headers->Get(X_AMZ_SERVER_SIDE_ENCRYPTION) << "\n\n"
-                      << "host;x-amz-content-sha256;x-amz-date;x-amz-server-side-encryption\n"
-                      << headers->Get(X_AMZ_CONTENT_SHA256);
+    for (size_t i = 0; i < sizeof(signedFields) / sizeof(signedFields[0]); i++) {
+        const char *value = headers->Get(signedFields[i]);
+        if (value == NULL) {
+            continue;
+        }
 
-        signed_headers = "host;x-amz-content-sha256;x-amz-date;x-amz-server-side-encryption";
-    } else {
-        canonical_str << "\n\n"
-                      << "host;x-amz-content-sha256;x-amz-date\n"
-                      << headers->Get(X_AMZ_CONTENT_SHA256);
+        string name = GetFieldString(signedFields[i]);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
 
-        signed_headers = "host;x-amz-content-sha256;x-amz-date";
+        canonical_str << name << ":" << value << "\n";
+        signed_headers += (signed_headers.empty() ? "" : ";") + name;
     }
 
+    canonical_str << "\n" << signed_headers << "\n" << headers->Get(X_AMZ_CONTENT_SHA256);
+
     sha256_hex(canonical_str.str().c_str(), canonical_hex);
 
     // http://docs.aws.amazon.com/general/latest/gr/rande.html#s3_region
@@ -383,13 +455,7 @@ void SignRequestV4(const string &method, HTTPHeaders *headers, const string &ori
                     << date_str << "/" << region << "/s3/aws4_request\n"
                     << canonical_hex;
 
-    stringstream kSecret;
-    kSecret << "AWS4" << cred.secret;
-
-    sha256hmac(date_str, key_date, kSecret.str().c_str(), strlen(kSecret.str().c_str()));
-    sha256hmac(region.c_str(), key_region, (char *)key_date, SHA256_DIGEST_LENGTH);
-    sha256hmac("s3", key_service, (char *)key_region, SHA256_DIGEST_LENGTH);
-    sha256hmac("aws4_request", signing_key, (char *)key_service, SHA256_DIGEST_LENGTH);
+    GetSigningKeyV4(cred.secret, date_str, region, signing_key);
     sha256hmac_hex(string2sign_str.str().c_str(), signature_hex, (char *)signing_key,
                    SHA256_DIGEST_LENGTH);
 
@@ -434,3 +500,373 @@ string TruncateOptions(const string &urlWithOptions) {
         return urlWithOptions.substr(0, firstSpace);
     }
 }
+
+uint64_t GetCurrentTimeUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void CondTimedWaitUs(pthread_cond_t *cond, pthread_mutex_t *mutex, uint64_t timeoutUs) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    deadline.tv_sec += timeoutUs / 1000000;
+    deadline.tv_nsec += (timeoutUs % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(cond, mutex, &deadline);
+}
+
+uint64_t GetBackoffWithJitterUs(uint64_t baseUs, uint64_t maxUs, uint64_t attempt) {
+    static __thread uint32_t seed = 0;
+    if (seed == 0) {
+        seed = (uint32_t)(GetCurrentTimeUs() ^ (uint64_t)pthread_self()) | 1;
+    }
+
+    uint64_t capUs = baseUs;
+    for (uint64_t i = 1; (i < attempt) && (capUs < maxUs); i++) {
+        capUs *= 2;
+    }
+    capUs = std::min(capUs, maxUs);
+
+    if (capUs == 0) {
+        return 0;
+    }
+
+    uint64_t r = ((uint64_t)rand_r(&seed) << 31) | (uint64_t)rand_r(&seed);
+    return r % (capUs + 1);
+}
+
+static uint64_t FindAnyOfScalar(const char *buf, uint64_t from, uint64_t len, char a, char b,
+                                char c) {
+    for (uint64_t i = from; i < len; i++) {
+        if ((buf[i] == a) || (buf[i] == b) || (buf[i] == c)) {
+            return i;
+        }
+    }
+
+    return len;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) static uint64_t FindAnyOfAVX2(const char *buf, uint64_t len,
+                                                              char a, char b, char c) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+
+    uint64_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+        __m256i eq = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+            _mm256_cmpeq_epi8(v, vc));
+
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(eq);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+
+    return FindAnyOfScalar(buf, i, len, a, b, c);
+}
+
+static uint64_t FindAnyOfSSE2(const char *buf, uint64_t len, char a, char b, char c) {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+
+    uint64_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                                  _mm_cmpeq_epi8(v, vc));
+
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(eq);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+
+    return FindAnyOfScalar(buf, i, len, a, b, c);
+}
+
+typedef uint64_t (*FindAnyOfFunc)(const char *, uint64_t, char, char, char);
+
+// SSE2 is always available on x86-64, AVX2 is picked once if the CPU has it.
+static FindAnyOfFunc ChooseFindAnyOf() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? FindAnyOfAVX2 : FindAnyOfSSE2;
+}
+
+uint64_t FindAnyOf(const char *buf, uint64_t len, char a, char b, char c) {
+    static const FindAnyOfFunc func = ChooseFindAnyOf();
+    return func(buf, len, a, b, c);
+}
+#elif defined(__ARM_NEON)
+uint64_t FindAnyOf(const char *buf, uint64_t len, char a, char b, char c) {
+    const uint8x16_t va = vdupq_n_u8((uint8_t)a);
+    const uint8x16_t vb = vdupq_n_u8((uint8_t)b);
+    const uint8x16_t vc = vdupq_n_u8((uint8_t)c);
+
+    uint64_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(buf + i));
+        uint8x16_t eq = vorrq_u8(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)), vceqq_u8(v, vc));
+
+        // narrow every byte of the result to 4 bits of a 64-bit mask.
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask != 0) {
+            return i + (__builtin_ctzll(mask) >> 2);
+        }
+    }
+
+    return FindAnyOfScalar(buf, i, len, a, b, c);
+}
+#else
+uint64_t FindAnyOf(const char *buf, uint64_t len, char a, char b, char c) {
+    return FindAnyOfScalar(buf, 0, len, a, b, c);
+}
+#endif
+
+// reversed polynomial of CRC32C
+#define CRC32C_POLY 0x82f63b78
+
+static uint32_t Crc32cTable[256];
+
+static bool InitCrc32cTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        Crc32cTable[i] = crc;
+    }
+
+    return true;
+}
+
+// crc is not inverted, like the ones of the instructions.
+static uint32_t Crc32cScalar(uint32_t crc, const uint8_t *data, uint64_t len) {
+    static const bool initialized = InitCrc32cTable();
+    (void)initialized;
+
+    for (uint64_t i = 0; i < len; i++) {
+        crc = Crc32cTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) static uint32_t Crc32cSSE42(uint32_t crc, const uint8_t *data,
+                                                              uint64_t len) {
+    uint64_t crc64 = crc;
+    uint64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t v;
+        memcpy(&v, data + i, sizeof(v));
+        crc64 = _mm_crc32_u64(crc64, v);
+    }
+
+    crc = (uint32_t)crc64;
+    for (; i < len; i++) {
+        crc = _mm_crc32_u8(crc, data[i]);
+    }
+
+    return crc;
+}
+
+typedef uint32_t (*Crc32cFunc)(uint32_t, const uint8_t *, uint64_t);
+
+static Crc32cFunc ChooseCrc32c() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") ? Crc32cSSE42 : Crc32cScalar;
+}
+
+uint32_t Crc32c(uint32_t crc, const void *data, uint64_t len) {
+    static const Crc32cFunc func = ChooseCrc32c();
+    return ~func(~crc, (const uint8_t *)data, len);
+}
+#elif defined(__ARM_FEATURE_CRC32)
+uint32_t Crc32c(uint32_t crc, const void *data, uint64_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc = ~crc;
+    uint64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t v;
+        memcpy(&v, p + i, sizeof(v));
+        crc = __crc32cd(crc, v);
+    }
+    for (; i < len; i++) {
+        crc = __crc32cb(crc, p[i]);
+    }
+
+    return ~crc;
+}
+#else
+uint32_t Crc32c(uint32_t crc, const void *data, uint64_t len) {
+    return ~Crc32cScalar(~crc, (const uint8_t *)data, len);
+}
+#endif
+
+static uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    for (int i = 0; vec != 0; i++, vec >>= 1) {
+        if (vec & 1) {
+            sum ^= mat[i];
+        }
+    }
+
+    return sum;
+}
+
+static void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+    for (int i = 0; i < 32; i++) {
+        square[i] = Gf2MatrixTimes(mat, mat[i]);
+    }
+}
+
+// Same as crc32_combine() of zlib, crcA is shifted over lenB zero bytes by squaring the operator
+// of one zero bit, then crcB is added.
+uint32_t Crc32cCombine(uint32_t crcA, uint32_t crcB, uint64_t lenB) {
+    uint32_t even[32];
+    uint32_t odd[32];
+
+    if (lenB == 0) {
+        return crcA;
+    }
+
+    odd[0] = CRC32C_POLY;
+    uint32_t row = 1;
+    for (int i = 1; i < 32; i++) {
+        odd[i] = row;
+        row <<= 1;
+    }
+
+    // operators of two and four zero bits.
+    Gf2MatrixSquare(even, odd);
+    Gf2MatrixSquare(odd, even);
+
+    do {
+        Gf2MatrixSquare(even, odd);
+        if (lenB & 1) {
+            crcA = Gf2MatrixTimes(even, crcA);
+        }
+        lenB >>= 1;
+        if (lenB == 0) {
+            break;
+        }
+
+        Gf2MatrixSquare(odd, even);
+        if (lenB & 1) {
+            crcA = Gf2MatrixTimes(odd, crcA);
+        }
+        lenB >>= 1;
+    } while (lenB != 0);
+
+    return crcA ^ crcB;
+}
+
+string Crc32cToBase64(uint32_t crc) {
+    unsigned char in[4] = {(unsigned char)(crc >> 24), (unsigned char)(crc >> 16),
+                           (unsigned char)(crc >> 8), (unsigned char)crc};
+    unsigned char out[9] = {0};
+
+    EVP_EncodeBlock(out, in, sizeof(in));
+
+    return string((const char *)out);
+}
+
+bool Crc32cFromBase64(const string &str, uint32_t *crc) {
+    unsigned char out[6] = {0};
+
+    // 4 bytes are 8 chars with padding, which are decoded into 6 bytes.
+    if ((str.size() != 8) || (str.compare(6, 2, "==") != 0) ||
+        (EVP_DecodeBlock(out, (const unsigned char *)str.data(), str.size()) != 6)) {
+        return false;
+    }
+
+    *crc = ((uint32_t)out[0] << 24) | ((uint32_t)out[1] << 16) | ((uint32_t)out[2] << 8) | out[3];
+
+    return true;
+}
+
+EolScanner::EolScanner(const char *eol, char quote, char escape)
+    : eol(eol), quote(quote), escape(escape != '\0' ? escape : quote) {
+    this->reset();
+}
+
+uint64_t EolScanner::find(const char *buf, uint64_t len, uint64_t from) {
+    if (this->eol.empty()) {
+        return (uint64_t)-1;
+    }
+
+    // without quoting, only the first char of the terminator needs to be searched.
+    char open = (this->quote != '\0') ? this->quote : this->eol[0];
+
+    uint64_t i = from;
+    while (i < len) {
+        // terminator started in a previous buffer or at last char.
+        if (this->matched > 0) {
+            if (buf[i] == this->eol[this->matched]) {
+                i++;
+                if (++this->matched == this->eol.size()) {
+                    this->matched = 0;
+                    return i;
+                }
+                continue;
+            }
+
+            // buf[i] might start another terminator, check it again.
+            this->matched = 0;
+        }
+
+        if (this->inQuote) {
+            if (this->escaped) {
+                this->escaped = false;
+                i++;
+                continue;
+            }
+
+            i += FindAnyOf(buf + i, len - i, this->quote, this->escape, this->quote);
+            if (i == len) {
+                break;
+            }
+
+            // a doubled quote closes and reopens the quoted field.
+            if (buf[i] == this->quote) {
+                this->inQuote = false;
+            } else {
+                this->escaped = true;
+            }
+            i++;
+            continue;
+        }
+
+        i += FindAnyOf(buf + i, len - i, this->eol[0], open, this->eol[0]);
+        if (i == len) {
+            break;
+        }
+
+        if ((this->quote != '\0') && (buf[i] == this->quote)) {
+            this->inQuote = true;
+            i++;
+            continue;
+        }
+
+        i++;
+        if (this->eol.size() == 1) {
+            return i;
+        }
+        this->matched = 1;
+    }
+
+    return (uint64_t)-1;
+}
@@ -23,6 +23,14 @@ class MockWriter : public Writer {
         // this->data.clear();
     }
 
+    virtual void rollover(const S3Url &url) {
+        this->rolledData.push_back(this->data);
+        this->data.clear();
+    }
+
+    // data of the keys before each rollover.
+    vector<vector<char>> rolledData;
+
     const char *getRawData() const {
         return this->data.data();
     }
@@ -157,6 +165,25 @@ TEST_F(CompressWriterTest, AbleToWriteServeralTimesBeforeClose) {
     }
 }
 
+TEST_F(CompressWriterTest, RolloverStartsNewGzipStream) {
+    const char input1[] = "The quick brown fox jumps over the lazy dog";
+    const char input2[] = "Pack my box with five dozen liquor jugs";
+
+    compressWriter.write(input1, sizeof(input1));
+    compressWriter.rollover(S3Url("s3://abc/def/2"));
+    compressWriter.write(input2, sizeof(input2));
+    compressWriter.close();
+
+    ASSERT_EQ((uint64_t)1, writer.rolledData.size());
+
+    // each key decompresses on its own.
+    this->simpleUncompress(writer.rolledData[0].data(), writer.rolledData[0].size());
+    EXPECT_STREQ(input1, (const char *)this->out);
+
+    this->simpleUncompress(writer.getRawData(), writer.getDataSize());
+    EXPECT_STREQ(input2, (const char *)this->out);
+}
+
 TEST_F(CompressWriterTest, AbleToWriteLargerThanCompressChunkSize) {
     const char pangram[] = "The quick brown fox jumps over the lazy dog";
     uint64_t times = S3_ZIP_COMPRESS_CHUNKSIZE / (sizeof(pangram) - 1) + 1;
@@ -210,3 +237,181 @@ TEST_F(CompressWriterTest, CompressCompressedData) {
 
     EXPECT_TRUE(memcmp(compressedData.data(), result.get(), compressedData.size()) == 0);
 }
+
+class BufferReader : public Reader {
+   public:
+    BufferReader(const vector<char> &data) : data(data), offset(0) {
+    }
+
+    virtual void open(const S3Params &params) {
+    }
+
+    virtual uint64_t read(char *buf, uint64_t count) {
+        uint64_t len = std::min(count, (uint64_t)(this->data.size() - this->offset));
+        memcpy(buf, this->data.data() + this->offset, len);
+        this->offset += len;
+        return len;
+    }
+
+    virtual void close() {
+    }
+
+   private:
+    const vector<char> &data;
+    uint64_t offset;
+};
+
+class ParallelCompressWriterTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        S3Params params("s3://abc/def/");
+        params.setNumOfChunks(4);
+
+        compressWriter.setWriter(&writer);
+        compressWriter.open(params);
+    }
+
+    virtual void TearDown() {
+        compressWriter.close();
+    }
+
+    // Uncompress concatenated gzip members like gunzip does.
+    string gunzip(const vector<char> &input) {
+        z_stream zstream;
+        zstream.zalloc = Z_NULL;
+        zstream.zfree = Z_NULL;
+        zstream.opaque = Z_NULL;
+        zstream.next_in = (Byte *)input.data();
+        zstream.avail_in = input.size();
+
+        int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
+        S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+
+        string result;
+        char buf[4096];
+        while (zstream.avail_in > 0) {
+            zstream.next_out = (Byte *)buf;
+            zstream.avail_out = sizeof(buf);
+
+            ret = inflate(&zstream, Z_NO_FLUSH);
+            result.append(buf, sizeof(buf) - zstream.avail_out);
+
+            if (ret == Z_STREAM_END) {
+                inflateReset(&zstream);
+            } else if (ret != Z_OK) {
+                break;
+            }
+        }
+
+        inflateEnd(&zstream);
+        EXPECT_EQ(Z_STREAM_END, ret);
+
+        return result;
+    }
+
+    CompressWriter compressWriter;
+    MockWriter writer;
+};
+
+TEST_F(ParallelCompressWriterTest, CompressEmptyData) {
+    compressWriter.close();
+
+    // only the EOF block.
+    ASSERT_EQ(sizeof(BGZFEOFBlock), writer.getDataSize());
+    EXPECT_EQ(sizeof(BGZFEOFBlock), GetBGZFBlockSize(writer.getRawData(), writer.getDataSize()));
+    EXPECT_EQ("", this->gunzip(writer.getRawDataVector()));
+}
+
+TEST_F(ParallelCompressWriterTest, CompressIntoBGZFBlocks) {
+    const char pangram[] = "The quick brown fox jumps over the lazy dog\n";
+    uint64_t times = S3_ZIP_COMPRESS_CHUNKSIZE * 10 / (sizeof(pangram) - 1) + 1;
+
+    string input;
+    for (uint64_t i = 0; i < times; i++) {
+        input.append(pangram);
+        input.append(std::to_string((unsigned long long)i));
+    }
+
+    // write in pieces not aligned to chunks.
+    for (uint64_t pos = 0; pos < input.length(); pos += 100000) {
+        compressWriter.write(input.data() + pos, std::min((uint64_t)100000, input.length() - pos));
+    }
+    compressWriter.close();
+
+    const vector<char> &output = writer.getRawDataVector();
+
+    uint64_t blocks = 0;
+    for (uint64_t pos = 0; pos < output.size(); blocks++) {
+        uint64_t blockSize = GetBGZFBlockSize(output.data() + pos, output.size() - pos);
+        ASSERT_NE((uint64_t)0, blockSize);
+        pos += blockSize;
+    }
+
+    EXPECT_LE((input.length() + S3_BGZF_MAX_INPUT_SIZE - 1) / S3_BGZF_MAX_INPUT_SIZE + 1, blocks);
+    EXPECT_TRUE(input == this->gunzip(output));
+}
+
+TEST_F(ParallelCompressWriterTest, CompressIncompressibleData) {
+    std::default_random_engine re(1);
+
+    vector<uint32_t> data(S3_ZIP_COMPRESS_CHUNKSIZE);
+    for (uint64_t i = 0; i < data.size(); i++) {
+        data[i] = re();
+    }
+
+    compressWriter.write((const char *)data.data(), data.size() * sizeof(uint32_t));
+    compressWriter.close();
+
+    string result = this->gunzip(writer.getRawDataVector());
+    ASSERT_EQ(data.size() * sizeof(uint32_t), result.length());
+    EXPECT_TRUE(memcmp(data.data(), result.data(), result.length()) == 0);
+}
+
+TEST_F(ParallelCompressWriterTest, ReadByDecompressReader) {
+    string input;
+    for (uint64_t i = 0; input.length() < S3_ZIP_COMPRESS_CHUNKSIZE * 5; i++) {
+        input.append(std::to_string((unsigned long long)i * i));
+        input.append(",abc\n");
+    }
+
+    compressWriter.write(input.data(), input.length());
+    compressWriter.close();
+
+    S3Params params("s3://abc/def/");
+    params.setNumOfChunks(4);
+
+    BufferReader bufferReader(writer.getRawDataVector());
+    DecompressReader decompressReader;
+    decompressReader.setReader(&bufferReader);
+    decompressReader.open(params);
+
+    string result;
+    char buf[10000];
+    uint64_t len;
+    while ((len = decompressReader.read(buf, sizeof(buf))) > 0) {
+        result.append(buf, len);
+    }
+    decompressReader.close();
+
+    EXPECT_TRUE(input == result);
+}
+
+TEST_F(ParallelCompressWriterTest, RolloverEndsBGZFFile) {
+    string input1(S3_ZIP_COMPRESS_CHUNKSIZE + 100, 'a');
+    string input2(100, 'b');
+
+    compressWriter.write(input1.data(), input1.length());
+    compressWriter.rollover(S3Url("s3://abc/def/2"));
+    compressWriter.write(input2.data(), input2.length());
+    compressWriter.close();
+
+    ASSERT_EQ((uint64_t)1, writer.rolledData.size());
+
+    const vector<char> &key1 = writer.rolledData[0];
+    ASSERT_LT(sizeof(BGZFEOFBlock), key1.size());
+    EXPECT_EQ(0, memcmp(key1.data() + key1.size() - sizeof(BGZFEOFBlock), BGZFEOFBlock,
+                        sizeof(BGZFEOFBlock)));
+
+    EXPECT_TRUE(input1 == this->gunzip(key1));
+    EXPECT_TRUE(input2 == this->gunzip(writer.getRawDataVector()));
+}
@@ -112,6 +112,25 @@ TEST_F(DecompressReaderTest, AbleToDecompressSmallCompressedData) {
     EXPECT_EQ(0, strncmp(hello, buf, count));
 }
 
+TEST_F(DecompressReaderTest, ReadViewLendsDecompressedData) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+    setBufReaderByRawData(hello, sizeof(hello));
+
+    // feed inflate() a byte at a time, most of them produce no output.
+    this->bufReader.setChunkSize(1);
+
+    string result;
+    const char *data = NULL;
+    uint64_t count = 0;
+    while ((count = decompressReader.readView(&data, 10)) != 0) {
+        EXPECT_LE(count, (uint64_t)10);
+        result.append(data, count);
+    }
+
+    EXPECT_EQ(sizeof(hello), result.size());
+    EXPECT_EQ(0, strncmp(hello, result.c_str(), result.size()));
+}
+
 TEST_F(DecompressReaderTest, AbleToDecompressFragmentalCompressedData) {
     // Fragmental data might not be decompressed, this case makes sure following data will be read
     // to compose a decompressable unit.
@@ -311,3 +330,291 @@ TEST_F(DecompressReaderTest, AbleToDecompressWithIncorrectEncodedStream) {
 
     EXPECT_THROW(decompressReader.read(outputBuffer, sizeof(outputBuffer)), S3RuntimeError);
 }
+
+TEST_F(DecompressReaderTest, AbleToDecompressGzipWithFileName) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                 Z_DEFAULT_STRATEGY);
+
+    // like gzip(1), the header carries the name of the file.
+    gz_header header;
+    memset(&header, 0, sizeof(header));
+    header.name = (Bytef *)"hello.txt";
+    deflateSetHeader(&zstream, &header);
+
+    zstream.next_in = (Byte *)hello;
+    zstream.avail_in = sizeof(hello);
+    zstream.next_out = compressionBuff;
+    zstream.avail_out = sizeof(compressionBuff);
+    deflate(&zstream, Z_FINISH);
+    this->bufReader.setData(compressionBuff, sizeof(compressionBuff) - zstream.avail_out);
+    deflateEnd(&zstream);
+
+    char buf[10000];
+    uint64_t count = decompressReader.read(buf, sizeof(buf));
+
+    EXPECT_EQ(sizeof(hello), count);
+    EXPECT_EQ(0, strncmp(hello, buf, count));
+}
+
+TEST_F(DecompressReaderTest, UnsupportedCompressionType) {
+    EXPECT_THROW(decompressReader.setCompressionType(S3_COMPRESSION_PLAIN), S3RuntimeError);
+#ifndef USE_ZSTD
+    EXPECT_THROW(decompressReader.setCompressionType(S3_COMPRESSION_ZSTD), S3RuntimeError);
+#endif
+#ifndef USE_LZ4
+    EXPECT_THROW(decompressReader.setCompressionType(S3_COMPRESSION_LZ4), S3RuntimeError);
+#endif
+}
+
+#ifdef USE_ZSTD
+TEST_F(DecompressReaderTest, AbleToDecompressZstdFrames) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+    char frames[1024];
+
+    // two frames in one stream
+    size_t len = ZSTD_compress(frames, sizeof(frames), hello, sizeof(hello), 1);
+    ASSERT_FALSE(ZSTD_isError(len));
+    size_t len2 = ZSTD_compress(frames + len, sizeof(frames) - len, hello, sizeof(hello), 1);
+    ASSERT_FALSE(ZSTD_isError(len2));
+
+    decompressReader.close();
+    decompressReader.setCompressionType(S3_COMPRESSION_ZSTD);
+    decompressReader.open(S3Params("s3://abc/def"));
+
+    this->bufReader.setData(frames, len + len2);
+    this->bufReader.setChunkSize(3);
+
+    string result;
+    char buf[10];
+    uint64_t count = 0;
+    while ((count = decompressReader.read(buf, sizeof(buf))) != 0) {
+        result.append(buf, count);
+    }
+
+    EXPECT_EQ(string(hello, sizeof(hello)) + string(hello, sizeof(hello)), result);
+}
+
+TEST_F(DecompressReaderTest, ZstdWithIncorrectEncodedStream) {
+    decompressReader.close();
+    decompressReader.setCompressionType(S3_COMPRESSION_ZSTD);
+    decompressReader.open(S3Params("s3://abc/def"));
+
+    char data[] = "\x28\xb5\x2f\xfd abcdefghigklmnopqrstuvwxyz";
+    this->bufReader.setData(data, sizeof(data));
+
+    char buf[128];
+    EXPECT_THROW(decompressReader.read(buf, sizeof(buf)), S3RuntimeError);
+}
+#endif
+
+#ifdef USE_LZ4
+TEST_F(DecompressReaderTest, AbleToDecompressLZ4Frames) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+    char frames[1024];
+
+    // two frames in one stream
+    size_t len = LZ4F_compressFrame(frames, sizeof(frames), hello, sizeof(hello), NULL);
+    ASSERT_FALSE(LZ4F_isError(len));
+    size_t len2 = LZ4F_compressFrame(frames + len, sizeof(frames) - len, hello, sizeof(hello), NULL);
+    ASSERT_FALSE(LZ4F_isError(len2));
+
+    decompressReader.close();
+    decompressReader.setCompressionType(S3_COMPRESSION_LZ4);
+    decompressReader.open(S3Params("s3://abc/def"));
+
+    this->bufReader.setData(frames, len + len2);
+    this->bufReader.setChunkSize(3);
+
+    string result;
+    char buf[10];
+    uint64_t count = 0;
+    while ((count = decompressReader.read(buf, sizeof(buf))) != 0) {
+        result.append(buf, count);
+    }
+
+    EXPECT_EQ(string(hello, sizeof(hello)) + string(hello, sizeof(hello)), result);
+}
+
+TEST_F(DecompressReaderTest, LZ4WithIncorrectEncodedStream) {
+    decompressReader.close();
+    decompressReader.setCompressionType(S3_COMPRESSION_LZ4);
+    decompressReader.open(S3Params("s3://abc/def"));
+
+    char data[] = "\x04\x22\x4d\x18 abcdefghigklmnopqrstuvwxyz";
+    this->bufReader.setData(data, sizeof(data));
+
+    char buf[128];
+    EXPECT_THROW(decompressReader.read(buf, sizeof(buf)), S3RuntimeError);
+}
+#endif
+
+// Compress data into BGZF blocks, each of them has at most blockInputSize bytes of input.
+static string compressBGZF(const string &data, uint64_t blockInputSize) {
+    string result;
+
+    for (uint64_t pos = 0; pos == 0 || pos < data.size(); pos += blockInputSize) {
+        uint64_t len = std::min(blockInputSize, data.size() - pos);
+
+        z_stream zstream;
+        zstream.zalloc = Z_NULL;
+        zstream.zfree = Z_NULL;
+        zstream.opaque = Z_NULL;
+        deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY);
+
+        vector<char> deflated(deflateBound(&zstream, len));
+        zstream.next_in = (Byte *)data.data() + pos;
+        zstream.avail_in = len;
+        zstream.next_out = (Byte *)deflated.data();
+        zstream.avail_out = deflated.size();
+        deflate(&zstream, Z_FINISH);
+        uint64_t deflatedLen = deflated.size() - zstream.avail_out;
+        deflateEnd(&zstream);
+
+        uint64_t blockSize = S3_BGZF_HEADER_LEN + deflatedLen + 8;
+        uint32_t crc = crc32(0, (const Byte *)data.data() + pos, len);
+
+        const char header[] = {0x1f, (char)0x8b, 8, 4, 0, 0, 0, 0,
+                               0, (char)0xff, 6, 0, 'B', 'C', 2, 0};
+        result.append(header, sizeof(header));
+        result.push_back((char)((blockSize - 1) & 0xff));
+        result.push_back((char)((blockSize - 1) >> 8));
+        result.append(deflated.data(), deflatedLen);
+        for (int i = 0; i < 4; i++) {
+            result.push_back((char)((crc >> (8 * i)) & 0xff));
+        }
+        for (int i = 0; i < 4; i++) {
+            result.push_back((char)((len >> (8 * i)) & 0xff));
+        }
+    }
+
+    return result;
+}
+
+static string makeSampleText(uint64_t size) {
+    string text;
+    for (uint64_t i = 0; text.size() < size; i++) {
+        text += std::to_string(i * 7919) + ",abcdefg,hijklmn\n";
+    }
+    text.resize(size);
+    return text;
+}
+
+class ParallelDecompressReaderTest : public DecompressReaderTest {
+   protected:
+    void openWithThreads(uint64_t numOfThreads) {
+        S3Params params("s3://abc/def");
+        params.setNumOfChunks(numOfThreads);
+
+        decompressReader.close();
+        decompressReader.open(params);
+    }
+
+    string readAll(uint64_t bufSize) {
+        string result;
+        vector<char> buf(bufSize);
+        uint64_t count = 0;
+        while ((count = decompressReader.read(buf.data(), buf.size())) != 0) {
+            result.append(buf.data(), count);
+        }
+        return result;
+    }
+};
+
+TEST_F(ParallelDecompressReaderTest, GetBGZFBlockSize) {
+    string bgzf = compressBGZF("hello", 1024);
+
+    EXPECT_EQ(bgzf.size(), GetBGZFBlockSize(bgzf.data(), bgzf.size()));
+    EXPECT_EQ((uint64_t)0, GetBGZFBlockSize(bgzf.data(), S3_BGZF_HEADER_LEN - 1));
+
+    // an ordinary gzip header
+    const char gzip[] = {0x1f, (char)0x8b, 8, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ((uint64_t)0, GetBGZFBlockSize(gzip, sizeof(gzip)));
+}
+
+TEST_F(ParallelDecompressReaderTest, DecompressBlocksInParallel) {
+    string text = makeSampleText(S3_ZIP_DECOMPRESS_CHUNKSIZE * 5 + 12345);
+    string bgzf = compressBGZF(text, 65280);
+
+    this->bufReader.setData(bgzf.data(), bgzf.size());
+    this->bufReader.setChunkSize(100000);
+    openWithThreads(4);
+
+    EXPECT_TRUE(text == readAll(64 * 1024));
+}
+
+TEST_F(ParallelDecompressReaderTest, DecompressEmptyBlocks) {
+    // BGZF data ends with an empty block as EOF marker
+    string bgzf = compressBGZF("hello", 1024) + compressBGZF("", 1024);
+
+    this->bufReader.setData(bgzf.data(), bgzf.size());
+    openWithThreads(2);
+
+    EXPECT_EQ("hello", readAll(3));
+}
+
+TEST_F(ParallelDecompressReaderTest, DecompressBGZFInOneThread) {
+    string text = makeSampleText(300000);
+    string bgzf = compressBGZF(text, 65280);
+
+    this->bufReader.setData(bgzf.data(), bgzf.size());
+    openWithThreads(1);
+
+    EXPECT_TRUE(text == readAll(10000));
+}
+
+TEST_F(ParallelDecompressReaderTest, DecompressConcatenatedGzipMembers) {
+    Byte first[1024];
+    Byte second[1024];
+    const char hello[] = "hello,";
+    const char world[] = "world";
+
+    // not BGZF, decompressed in sequence
+    z_stream zstream;
+    uLong firstLen, secondLen;
+    for (int i = 0; i < 2; i++) {
+        zstream.zalloc = Z_NULL;
+        zstream.zfree = Z_NULL;
+        zstream.opaque = Z_NULL;
+        deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                     Z_DEFAULT_STRATEGY);
+        zstream.next_in = (Byte *)(i == 0 ? hello : world);
+        zstream.avail_in = (i == 0 ? strlen(hello) : strlen(world));
+        zstream.next_out = (i == 0 ? first : second);
+        zstream.avail_out = 1024;
+        deflate(&zstream, Z_FINISH);
+        (i == 0 ? firstLen : secondLen) = 1024 - zstream.avail_out;
+        deflateEnd(&zstream);
+    }
+
+    string data = string((char *)first, firstLen) + string((char *)second, secondLen);
+    this->bufReader.setData(data.data(), data.size());
+    openWithThreads(4);
+
+    EXPECT_EQ("hello,world", readAll(100));
+}
+
+TEST_F(ParallelDecompressReaderTest, TruncatedBlock) {
+    string bgzf = compressBGZF(makeSampleText(100000), 65280);
+
+    this->bufReader.setData(bgzf.data(), bgzf.size() - 1);
+    openWithThreads(4);
+
+    EXPECT_THROW(readAll(1000), S3RuntimeError);
+}
+
+TEST_F(ParallelDecompressReaderTest, CorruptedBlock) {
+    string bgzf = compressBGZF(makeSampleText(100000), 65280);
+    bgzf[S3_BGZF_HEADER_LEN + 10] ^= 0xff;
+
+    this->bufReader.setData(bgzf.data(), bgzf.size());
+    openWithThreads(4);
+
+    EXPECT_THROW(readAll(1000), S3RuntimeError);
+}
@@ -125,9 +125,7 @@ TEST_F(GPReaderTest, ReadSmallData) {
 
     EXPECT_CALL(mockRESTfulService, get(_, _))
         .WillOnce(Return(listBucketResponse))
-        // first 4 bytes is retrieved once for format detection.
-        .WillOnce(Return(keyReaderResponse))
-        // whole file content
+        // a small key is fetched as a whole, its format is detected from the content.
         .WillOnce(Return(keyReaderResponse));
 
     gpreader.open(p);
@@ -35,7 +35,7 @@ TEST_F(GPWriterTest, ConstructKeyName) {
 
     MockS3RESTfulService mockRESTfulService(p);
     MockGPWriter gpwriter(p, &mockRESTfulService);
-    EXPECT_CALL(mockRESTfulService, head(_, _)).WillOnce(Return(404));
+    EXPECT_CALL(mockRESTfulService, head(_, _)).Times(0);
 
     uint8_t xml[] =
         "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
@@ -52,8 +52,13 @@ TEST_F(GPWriterTest, ConstructKeyName) {
 
     gpwriter.open(p);
 
-    // "0"+".data"'s length is 6
-    EXPECT_EQ((uint64_t)8, gpwriter.getKeyUrlToUpload().length() - url.length() - 6);
+    // segment, session, command, number of keys written and 8 random hex digits.
+    stringstream ss;
+    ss << url << "0_" << s3ext_sessionid << "_" << s3ext_commandid << "_0_";
+    string keyUrl = gpwriter.getKeyUrlToUpload();
+    EXPECT_EQ(ss.str(), keyUrl.substr(0, ss.str().length()));
+    EXPECT_EQ(".data", keyUrl.substr(keyUrl.length() - 5));
+    EXPECT_EQ((uint64_t)8, keyUrl.length() - ss.str().length() - 5);
 }
 
 TEST_F(GPWriterTest, GenerateUniqueKeyName) {
@@ -63,7 +68,7 @@ TEST_F(GPWriterTest, GenerateUniqueKeyName) {
 
     MockS3RESTfulService mockRESTfulService(p);
     MockGPWriter gpwriter(p, &mockRESTfulService);
-    EXPECT_CALL(mockRESTfulService, head(_, _)).Times(AtLeast(1)).WillRepeatedly(Return(404));
+    EXPECT_CALL(mockRESTfulService, head(_, _)).Times(0);
 
     uint8_t xml[] =
         "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
@@ -83,40 +88,8 @@ TEST_F(GPWriterTest, GenerateUniqueKeyName) {
     gpwriter.open(p);
 
     MockGPWriter gpwriter2(p, &mockRESTfulService);
-    EXPECT_CALL(mockRESTfulService, head(gpwriter.getKeyUrlToUpload(), _))
-        .Times(AtMost(1))
-        .WillOnce(Return(200));
-
     gpwriter2.open(p);
 
     EXPECT_NE(gpwriter.getKeyUrlToUpload(), gpwriter2.getKeyUrlToUpload());
 }
 
-TEST_F(GPWriterTest, ReGenerateKeyName) {
-    string url = "https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/dataset1/normal";
-
-    S3Params p = InitConfig(url + " config=data/s3test.conf");
-    p.setAutoCompress(false);
-
-    MockS3RESTfulService mockRESTfulService(p);
-    MockGPWriter gpwriter(p, &mockRESTfulService);
-
-    EXPECT_CALL(mockRESTfulService, head(_, _)).WillOnce(Return(200)).WillOnce(Return(404));
-
-    uint8_t xml[] =
-        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
-        "<InitiateMultipartUploadResult"
-        " xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
-        "<Bucket>example-bucket</Bucket>"
-        "<Key>example-object</Key>"
-        "<UploadId>VXBsb2FkIElEIGZvciA2aWWpbmcncyBteS1tb3ZpZS5tMnRzIHVwbG9hZA</UploadId>"
-        "</InitiateMultipartUploadResult>";
-    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
-    Response response(RESPONSE_OK, raw);
-
-    EXPECT_CALL(mockRESTfulService, post(_, _, vector<uint8_t>())).WillOnce(Return(response));
-
-    gpwriter.open(p);
-
-    // expect the restfulService->head() was called twice
-}
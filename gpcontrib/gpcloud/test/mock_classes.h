@@ -21,15 +21,20 @@ class MockS3Interface : public S3Interface {
 
     MOCK_METHOD1(getUploadId, string(const S3Url&));
 
-    MOCK_METHOD4(uploadPartOfData, string(S3VectorUInt8&, const S3Url&,
-                            uint64_t partNumber, const string& uploadId));
+    MOCK_METHOD5(uploadPartOfData, string(S3VectorUInt8&, const S3Url&,
+                            uint64_t partNumber, const string& uploadId, const string& checksum));
 
-    MOCK_METHOD3(completeMultiPart, bool(const S3Url&,
-                           const string&, const vector<string>&));
+    MOCK_METHOD4(completeMultiPart, bool(const S3Url&,
+                           const string&, const vector<string>&, const vector<string>&));
 
     MOCK_METHOD2(abortUpload, bool(const S3Url &,
                  const string &));
 
+    MOCK_METHOD3(selectObjectContent, void(const S3Url &, const string &,
+                 S3VectorUInt8 &));
+
+    MOCK_METHOD1(getKeyChecksum, string(const S3Url &));
+
 };
 
 class MockS3RESTfulService : public S3RESTfulService {
@@ -47,6 +52,11 @@ class MockS3RESTfulService : public S3RESTfulService {
                                 const vector<uint8_t> &));
 
     MOCK_METHOD2(deleteRequest, Response(const string &, HTTPHeaders &));
+
+    MOCK_METHOD3(getAsync, bool(const string &, HTTPHeaders &, RESTfulCallback *));
+
+    MOCK_METHOD4(putAsync, bool(const string &, HTTPHeaders &, const S3VectorUInt8 &,
+                                RESTfulCallback *));
 };
 
 class XMLGenerator {
@@ -87,8 +97,11 @@ class XMLGenerator {
         for (vector<BucketContent>::iterator it = contents.begin(); it != contents.end(); it++) {
             sstr << "<Contents>"
                  << "<Key>" << it->name << "</Key>"
-                 << "<Size>" << it->size << "</Size>"
-                 << "</Contents>";
+                 << "<Size>" << it->size << "</Size>";
+            if (!it->etag.empty()) {
+                sstr << "<ETag>" << it->etag << "</ETag>";
+            }
+            sstr << "</Contents>";
         }
         sstr << "</ListBucketResult>";
         string xml = sstr.str();
@@ -0,0 +1,701 @@
+#include "parquet_reader.cpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+#include "parquet_writer.h"
+
+#include <limits>
+
+using ::testing::_;
+using ::testing::AtLeast;
+using ::testing::Invoke;
+using ::testing::Return;
+
+static string encodeInt64(int64_t value) {
+    return string((const char *)&value, sizeof(value));
+}
+
+static string encodeInt32(int32_t value) {
+    return string((const char *)&value, sizeof(value));
+}
+
+// Rows of a test file, "id" is INT64 REQUIRED, "name" is UTF8 BYTE_ARRAY OPTIONAL.
+struct TestRowGroup {
+    vector<int64_t> ids;
+    vector<string> names;
+    vector<bool> nameNulls;
+};
+
+struct TestChunk {
+    uint64_t offset;
+    uint64_t size;
+    string min;
+    string max;
+    int64_t nullCount;
+};
+
+static string writePage(const string &payload, int32_t numValues) {
+    ThriftCompactWriter writer;
+    writer.structBegin();
+    writer.i32Field(1, PARQUET_DATA_PAGE);
+    writer.i32Field(2, payload.size());
+    writer.i32Field(3, payload.size());
+    writer.fieldBegin(5, THRIFT_STRUCT);
+    writer.structBegin();
+    writer.i32Field(1, numValues);
+    writer.i32Field(2, PARQUET_PLAIN);
+    writer.i32Field(3, PARQUET_RLE);
+    writer.i32Field(4, PARQUET_RLE);
+    writer.structEnd();
+    writer.structEnd();
+
+    return writer.getData() + payload;
+}
+
+static void writeColumnChunk(ThriftCompactWriter &writer, const TestChunk &chunk, int64_t numValues,
+                             int32_t type, const string &name) {
+    writer.structBegin();
+    writer.i64Field(2, chunk.offset);
+    writer.fieldBegin(3, THRIFT_STRUCT);
+    writer.structBegin();
+    writer.i32Field(1, type);
+    writer.listBegin(2, THRIFT_I32, 1);
+    writer.zigzag(PARQUET_PLAIN);
+    writer.listBegin(3, THRIFT_BINARY, 1);
+    writer.binary(name);
+    writer.i32Field(4, PARQUET_UNCOMPRESSED);
+    writer.i64Field(5, numValues);
+    writer.i64Field(6, chunk.size);
+    writer.i64Field(7, chunk.size);
+    writer.i64Field(9, chunk.offset);
+    writer.fieldBegin(12, THRIFT_STRUCT);
+    writer.structBegin();
+    writer.i64Field(3, chunk.nullCount);
+    if (!chunk.max.empty() || !chunk.min.empty()) {
+        writer.binaryField(5, chunk.max);
+        writer.binaryField(6, chunk.min);
+    }
+    writer.structEnd();
+    writer.structEnd();
+    writer.structEnd();
+}
+
+static string buildParquetFile(const vector<TestRowGroup> &rowGroups) {
+    string file = S3_PARQUET_MAGIC;
+    vector<std::pair<TestChunk, TestChunk> > chunks;
+
+    for (uint64_t i = 0; i < rowGroups.size(); i++) {
+        const TestRowGroup &rowGroup = rowGroups[i];
+
+        TestChunk idChunk = {file.size(), 0, "", "", 0};
+        string ids;
+        for (uint64_t j = 0; j < rowGroup.ids.size(); j++) {
+            ids += encodeInt64(rowGroup.ids[j]);
+        }
+        if (!rowGroup.ids.empty()) {
+            idChunk.min = encodeInt64(*std::min_element(rowGroup.ids.begin(), rowGroup.ids.end()));
+            idChunk.max = encodeInt64(*std::max_element(rowGroup.ids.begin(), rowGroup.ids.end()));
+        }
+        file += writePage(ids, rowGroup.ids.size());
+        idChunk.size = file.size() - idChunk.offset;
+
+        // one RLE run for each definition level.
+        TestChunk nameChunk = {file.size(), 0, "", "", 0};
+        string levels, names;
+        for (uint64_t j = 0; j < rowGroup.names.size(); j++) {
+            levels.push_back(2);
+            levels.push_back(rowGroup.nameNulls[j] ? 0 : 1);
+            if (rowGroup.nameNulls[j]) {
+                nameChunk.nullCount++;
+                continue;
+            }
+
+            names += encodeInt32(rowGroup.names[j].size()) + rowGroup.names[j];
+            if (nameChunk.min.empty() || rowGroup.names[j] < nameChunk.min) {
+                nameChunk.min = rowGroup.names[j];
+            }
+            if (rowGroup.names[j] > nameChunk.max) {
+                nameChunk.max = rowGroup.names[j];
+            }
+        }
+        file += writePage(encodeInt32(levels.size()) + levels + names, rowGroup.names.size());
+        nameChunk.size = file.size() - nameChunk.offset;
+
+        chunks.push_back(std::make_pair(idChunk, nameChunk));
+    }
+
+    ThriftCompactWriter writer;
+    int64_t totalRows = 0;
+
+    writer.structBegin();
+    writer.i32Field(1, 1);
+    writer.listBegin(2, THRIFT_STRUCT, 3);
+
+    writer.structBegin();
+    writer.binaryField(4, "schema");
+    writer.i32Field(5, 2);
+    writer.structEnd();
+
+    writer.structBegin();
+    writer.i32Field(1, PARQUET_INT64);
+    writer.i32Field(3, PARQUET_REQUIRED);
+    writer.binaryField(4, "id");
+    writer.structEnd();
+
+    writer.structBegin();
+    writer.i32Field(1, PARQUET_BYTE_ARRAY);
+    writer.i32Field(3, PARQUET_OPTIONAL);
+    writer.binaryField(4, "Name");
+    writer.i32Field(6, PARQUET_CONVERTED_UTF8);
+    writer.structEnd();
+
+    for (uint64_t i = 0; i < rowGroups.size(); i++) {
+        totalRows += rowGroups[i].ids.size();
+    }
+    writer.i64Field(3, totalRows);
+
+    writer.listBegin(4, THRIFT_STRUCT, rowGroups.size());
+    for (uint64_t i = 0; i < rowGroups.size(); i++) {
+        writer.structBegin();
+        writer.listBegin(1, THRIFT_STRUCT, 2);
+        writeColumnChunk(writer, chunks[i].first, rowGroups[i].ids.size(), PARQUET_INT64, "id");
+        writeColumnChunk(writer, chunks[i].second, rowGroups[i].names.size(), PARQUET_BYTE_ARRAY,
+                         "Name");
+        writer.i64Field(2, chunks[i].first.size + chunks[i].second.size);
+        writer.i64Field(3, rowGroups[i].ids.size());
+        writer.structEnd();
+    }
+    writer.binaryField(6, "gpcloud test");
+    writer.structEnd();
+
+    return file + writer.getData() + encodeInt32(writer.getData().size()) + S3_PARQUET_MAGIC;
+}
+
+static vector<TestRowGroup> makeTestRowGroups() {
+    vector<TestRowGroup> rowGroups(2);
+
+    rowGroups[0].ids = {1, 2, 3};
+    rowGroups[0].names = {"apple", "", "tab\tand\\"};
+    rowGroups[0].nameNulls = {false, true, false};
+
+    rowGroups[1].ids = {10, 20};
+    rowGroups[1].names = {"say \"hi\", bye", "line\nbreak"};
+    rowGroups[1].nameNulls = {false, false};
+
+    return rowGroups;
+}
+
+TEST(ThriftCompactReader, ReadFieldsAndSkipUnknown) {
+    ThriftCompactWriter writer;
+    writer.structBegin();
+    writer.i32Field(1, -5);
+    writer.binaryField(2, "abc");
+    writer.boolField(3, true);
+    writer.i64Field(40, 1LL << 40);
+    writer.listBegin(41, THRIFT_I32, 20);
+    for (int i = 0; i < 20; i++) {
+        writer.zigzag(i);
+    }
+    writer.fieldBegin(42, THRIFT_STRUCT);
+    writer.structBegin();
+    writer.binaryField(1, "nested");
+    writer.structEnd();
+    writer.i32Field(43, 7);
+    writer.structEnd();
+
+    ThriftCompactReader reader(writer.getData().data(), writer.getData().size());
+
+    int16_t id;
+    uint8_t type;
+    reader.readStructBegin();
+
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_EQ(1, id);
+    EXPECT_EQ(-5, reader.readI32());
+
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_EQ(2, id);
+    EXPECT_EQ("abc", reader.readBinary());
+
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_EQ(3, id);
+    EXPECT_TRUE(reader.readBool(type));
+
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_EQ(40, id);
+    EXPECT_EQ(1LL << 40, reader.readI64());
+
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_EQ(41, id);
+    reader.skip(type);
+
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_EQ(42, id);
+    reader.skip(type);
+
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_EQ(43, id);
+    EXPECT_EQ(7, reader.readI32());
+
+    EXPECT_FALSE(reader.readFieldBegin(&id, &type));
+    reader.readStructEnd();
+    EXPECT_EQ(writer.getData().size(), reader.getPosition());
+}
+
+TEST(ThriftCompactReader, ThrowOnTruncatedData) {
+    ThriftCompactWriter writer;
+    writer.structBegin();
+    writer.binaryField(1, "abcdef");
+    writer.structEnd();
+
+    ThriftCompactReader reader(writer.getData().data(), writer.getData().size() - 3);
+
+    int16_t id;
+    uint8_t type;
+    reader.readStructBegin();
+    ASSERT_TRUE(reader.readFieldBegin(&id, &type));
+    EXPECT_THROW(reader.readBinary(), S3RuntimeError);
+}
+
+TEST(ParquetRleDecoder, DecodeBitPackedAndRleRuns) {
+    // 0..7 bit-packed in 3 bits, then 5 times of 4.
+    const char data[] = {3, (char)0x88, (char)0xc6, (char)0xfa, 10, 4};
+    ParquetRleDecoder decoder(data, sizeof(data), 3);
+
+    uint32_t value;
+    for (uint32_t i = 0; i < 8; i++) {
+        ASSERT_TRUE(decoder.next(&value));
+        EXPECT_EQ(i, value);
+    }
+    for (uint32_t i = 0; i < 5; i++) {
+        ASSERT_TRUE(decoder.next(&value));
+        EXPECT_EQ(4u, value);
+    }
+    EXPECT_FALSE(decoder.next(&value));
+}
+
+TEST(DecompressParquetPage, Snappy) {
+    // literal "abc", then copy 6 bytes from 3 bytes before.
+    const char data[] = {9, 8, 'a', 'b', 'c', 0x09, 3};
+    char out[9];
+
+    DecompressParquetPage(PARQUET_SNAPPY, data, sizeof(data), out, sizeof(out));
+    EXPECT_EQ("abcabcabc", string(out, sizeof(out)));
+
+    EXPECT_THROW(DecompressParquetPage(PARQUET_SNAPPY, data, sizeof(data) - 1, out, sizeof(out)),
+                 S3RuntimeError);
+}
+
+TEST(DecompressParquetPage, Gzip) {
+    const char text[] = "hello parquet hello parquet";
+    char compressed[128];
+    uLongf compressedLen = sizeof(compressed);
+    ASSERT_EQ(Z_OK, compress((Bytef *)compressed, &compressedLen, (const Bytef *)text,
+                             sizeof(text) - 1));
+
+    char out[sizeof(text) - 1];
+    DecompressParquetPage(PARQUET_GZIP, compressed, compressedLen, out, sizeof(out));
+    EXPECT_EQ(text, string(out, sizeof(out)));
+}
+
+TEST(DecompressParquetPage, ThrowOnUnsupportedCodec) {
+    char out[1];
+    EXPECT_THROW(DecompressParquetPage(4, "x", 1, out, 1), S3RuntimeError);
+}
+
+TEST(FormatParquetValue, LogicalTypes) {
+    ParquetColumnSchema column;
+
+    column.type = PARQUET_INT32;
+    column.convertedType = PARQUET_CONVERTED_DATE;
+    EXPECT_EQ("1970-01-01", FormatParquetValue(column, encodeInt32(0).data(), 4));
+    EXPECT_EQ("2022-01-08", FormatParquetValue(column, encodeInt32(19000).data(), 4));
+    EXPECT_EQ("1969-12-31", FormatParquetValue(column, encodeInt32(-1).data(), 4));
+
+    column.convertedType = PARQUET_CONVERTED_DECIMAL;
+    column.scale = 2;
+    EXPECT_EQ("123.45", FormatParquetValue(column, encodeInt32(12345).data(), 4));
+    column.scale = 3;
+    EXPECT_EQ("-0.005", FormatParquetValue(column, encodeInt32(-5).data(), 4));
+
+    column.convertedType = 13;  // UINT_32
+    EXPECT_EQ("4294967295", FormatParquetValue(column, encodeInt32(-1).data(), 4));
+
+    column.type = PARQUET_INT64;
+    column.convertedType = PARQUET_CONVERTED_TIMESTAMP_MICROS;
+    EXPECT_EQ("1970-01-01 00:00:01.500000",
+              FormatParquetValue(column, encodeInt64(1500000).data(), 8));
+    column.convertedType = PARQUET_CONVERTED_TIMESTAMP_MILLIS;
+    EXPECT_EQ("2001-09-09 01:46:40",
+              FormatParquetValue(column, encodeInt64(1000000000000LL).data(), 8));
+
+    column.type = PARQUET_INT96;
+    string int96 = encodeInt64(3600LL * 1000000000) + encodeInt32(2440588);
+    EXPECT_EQ("1970-01-01 01:00:00", FormatParquetValue(column, int96.data(), 12));
+
+    column.type = PARQUET_FIXED_LEN_BYTE_ARRAY;
+    column.convertedType = PARQUET_CONVERTED_DECIMAL;
+    column.scale = 1;
+    EXPECT_EQ("-0.2", FormatParquetValue(column, "\xff\xfe", 2));
+
+    column.type = PARQUET_DOUBLE;
+    column.convertedType = PARQUET_CONVERTED_NONE;
+    double d = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ("NaN", FormatParquetValue(column, (const char *)&d, 8));
+    d = -std::numeric_limits<double>::infinity();
+    EXPECT_EQ("-Infinity", FormatParquetValue(column, (const char *)&d, 8));
+    d = 0.1;
+    EXPECT_EQ(0.1, strtod(FormatParquetValue(column, (const char *)&d, 8).c_str(), NULL));
+
+    column.type = PARQUET_BOOLEAN;
+    EXPECT_EQ("true", FormatParquetValue(column, "\x01", 1));
+}
+
+TEST(ParseParquetFileMetaData, FlatSchema) {
+    string file = buildParquetFile(makeTestRowGroups());
+    uint64_t metaLen = getLittleEndian32(file.data() + file.size() - S3_PARQUET_FOOTER_LEN);
+
+    ParquetFileMetaData meta;
+    ParseParquetFileMetaData(file.data() + file.size() - S3_PARQUET_FOOTER_LEN - metaLen, metaLen,
+                             meta);
+
+    ASSERT_EQ(2u, meta.columns.size());
+    EXPECT_EQ("id", meta.columns[0].name);
+    EXPECT_EQ(PARQUET_INT64, meta.columns[0].type);
+    EXPECT_EQ("Name", meta.columns[1].name);
+    EXPECT_EQ(PARQUET_OPTIONAL, meta.columns[1].repetition);
+    EXPECT_EQ(PARQUET_CONVERTED_UTF8, meta.columns[1].convertedType);
+
+    EXPECT_EQ(5, meta.numRows);
+    ASSERT_EQ(2u, meta.rowGroups.size());
+    EXPECT_EQ(3, meta.rowGroups[0].numRows);
+    EXPECT_EQ(4u, meta.rowGroups[0].columns[0].getStartOffset());
+    EXPECT_EQ(1, meta.rowGroups[0].columns[1].stats.nullCount);
+    EXPECT_EQ("apple", meta.rowGroups[0].columns[1].stats.min);
+    EXPECT_FALSE(meta.rowGroups[0].columns[1].stats.legacy);
+}
+
+TEST(ParseParquetFileMetaData, ThrowOnNestedSchema) {
+    ThriftCompactWriter writer;
+    writer.structBegin();
+    writer.listBegin(2, THRIFT_STRUCT, 3);
+
+    writer.structBegin();
+    writer.binaryField(4, "schema");
+    writer.i32Field(5, 1);
+    writer.structEnd();
+
+    writer.structBegin();
+    writer.binaryField(4, "group");
+    writer.i32Field(5, 1);
+    writer.structEnd();
+
+    writer.structBegin();
+    writer.i32Field(1, PARQUET_INT32);
+    writer.binaryField(4, "leaf");
+    writer.structEnd();
+
+    writer.structEnd();
+
+    ParquetFileMetaData meta;
+    EXPECT_THROW(ParseParquetFileMetaData(writer.getData().data(), writer.getData().size(), meta),
+                 S3RuntimeError);
+}
+
+TEST(DecodeParquetColumnChunk, OptionalColumn) {
+    string file = buildParquetFile(makeTestRowGroups());
+    uint64_t metaLen = getLittleEndian32(file.data() + file.size() - S3_PARQUET_FOOTER_LEN);
+
+    ParquetFileMetaData meta;
+    ParseParquetFileMetaData(file.data() + file.size() - S3_PARQUET_FOOTER_LEN - metaLen, metaLen,
+                             meta);
+
+    const ParquetColumnChunk &chunk = meta.rowGroups[0].columns[1];
+    vector<string> values;
+    vector<bool> nulls;
+    DecodeParquetColumnChunk(meta.columns[1], chunk, file.data() + chunk.getStartOffset(),
+                             chunk.totalCompressedSize, values, nulls);
+
+    ASSERT_EQ(3u, values.size());
+    EXPECT_EQ("apple", values[0]);
+    EXPECT_TRUE(nulls[1]);
+    EXPECT_EQ("tab\tand\\", values[2]);
+    EXPECT_FALSE(nulls[2]);
+}
+
+class ParquetRowGroupMayMatchTest : public ::testing::Test {
+   protected:
+    virtual void SetUp() {
+        ParquetColumnSchema id;
+        id.name = "id";
+        id.type = PARQUET_INT64;
+
+        ParquetColumnSchema name;
+        name.name = "name";
+        name.type = PARQUET_BYTE_ARRAY;
+        name.repetition = PARQUET_OPTIONAL;
+
+        meta.columns = {id, name};
+
+        rowGroup.numRows = 10;
+        rowGroup.columns.resize(2);
+        setStats(rowGroup.columns[0].stats, encodeInt64(10), encodeInt64(20));
+        setStats(rowGroup.columns[1].stats, "bar", "foo");
+
+        columnIndexes = {0, 1, -1};
+    }
+
+    void setStats(ParquetStatistics &stats, const string &min, const string &max) {
+        stats.hasMin = stats.hasMax = true;
+        stats.min = min;
+        stats.max = max;
+        stats.hasNullCount = true;
+        stats.nullCount = 0;
+    }
+
+    bool mayMatch(uint64_t column, S3QualOp op, const string &value, bool numeric) {
+        S3ScanQual qual;
+        qual.column = column;
+        qual.op = op;
+        qual.value = value;
+        qual.numeric = numeric;
+
+        return ParquetRowGroupMayMatch(meta, rowGroup, columnIndexes, {qual});
+    }
+
+    ParquetFileMetaData meta;
+    ParquetRowGroup rowGroup;
+    vector<int64_t> columnIndexes;
+};
+
+TEST_F(ParquetRowGroupMayMatchTest, NumericRange) {
+    EXPECT_TRUE(mayMatch(0, S3_QUAL_EQ, "15", true));
+    EXPECT_FALSE(mayMatch(0, S3_QUAL_EQ, "21", true));
+    EXPECT_FALSE(mayMatch(0, S3_QUAL_EQ, "9.5", true));
+
+    EXPECT_FALSE(mayMatch(0, S3_QUAL_LT, "10", true));
+    EXPECT_TRUE(mayMatch(0, S3_QUAL_LE, "10", true));
+    EXPECT_FALSE(mayMatch(0, S3_QUAL_GT, "20", true));
+    EXPECT_TRUE(mayMatch(0, S3_QUAL_GE, "20", true));
+
+    // not a number, can't tell
+    EXPECT_TRUE(mayMatch(0, S3_QUAL_EQ, "abc", true));
+    EXPECT_TRUE(mayMatch(0, S3_QUAL_EQ, "NaN", true));
+
+    // strings are not compared with numeric statistics.
+    EXPECT_TRUE(mayMatch(0, S3_QUAL_EQ, "30", false));
+}
+
+TEST_F(ParquetRowGroupMayMatchTest, StringEquality) {
+    EXPECT_TRUE(mayMatch(1, S3_QUAL_EQ, "cat", false));
+    EXPECT_FALSE(mayMatch(1, S3_QUAL_EQ, "zoo", false));
+
+    // order of strings depends on collation
+    EXPECT_TRUE(mayMatch(1, S3_QUAL_LT, "abc", false));
+
+    this->rowGroup.columns[1].stats.legacy = true;
+    EXPECT_TRUE(mayMatch(1, S3_QUAL_EQ, "zoo", false));
+}
+
+TEST_F(ParquetRowGroupMayMatchTest, NullColumns) {
+    // column not in the file is NULL
+    EXPECT_FALSE(mayMatch(2, S3_QUAL_EQ, "1", true));
+
+    this->rowGroup.columns[1].stats.nullCount = 10;
+    EXPECT_FALSE(mayMatch(1, S3_QUAL_EQ, "cat", false));
+}
+
+TEST_F(ParquetRowGroupMayMatchTest, NoStatistics) {
+    this->rowGroup.columns[0].stats = ParquetStatistics();
+    EXPECT_TRUE(mayMatch(0, S3_QUAL_EQ, "100", true));
+}
+
+class MockS3InterfaceForParquet : public MockS3Interface {
+   public:
+    uint64_t mockFetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                           const S3Url &s3Url) {
+        this->fetched.push_back(std::make_pair(offset, len));
+
+        data.clear();
+        data.insert(data.end(), this->file.begin() + offset, this->file.begin() + offset + len);
+        return len;
+    }
+
+    // total length of fetched data in [start, end)
+    uint64_t fetchedIn(uint64_t start, uint64_t end) {
+        uint64_t total = 0;
+        for (uint64_t i = 0; i < this->fetched.size(); i++) {
+            uint64_t from = std::max(start, this->fetched[i].first);
+            uint64_t to = std::min(end, this->fetched[i].first + this->fetched[i].second);
+            total += to > from ? to - from : 0;
+        }
+        return total;
+    }
+
+    string file;
+    vector<std::pair<uint64_t, uint64_t> > fetched;
+};
+
+class ParquetReaderTest : public ::testing::Test {
+   protected:
+    virtual void SetUp() {
+        mockS3Interface.file = buildParquetFile(makeTestRowGroups());
+        reader.setS3InterfaceService(&mockS3Interface);
+
+        EXPECT_CALL(mockS3Interface, fetchData(_, _, _, _))
+            .WillRepeatedly(Invoke(&mockS3Interface, &MockS3InterfaceForParquet::mockFetchData));
+
+        params.setKeySize(mockS3Interface.file.size());
+        params.setKeyRange(0, mockS3Interface.file.size());
+
+        eolString[0] = '\n';
+        eolString[1] = '\0';
+        hasHeader = false;
+    }
+
+    virtual void TearDown() {
+        reader.close();
+        hasHeader = false;
+    }
+
+    string readAll() {
+        reader.open(params);
+
+        string result;
+        char buf[7];
+        uint64_t len;
+        while ((len = reader.read(buf, sizeof(buf))) > 0) {
+            result.append(buf, len);
+        }
+        return result;
+    }
+
+    S3Params params;
+    MockS3InterfaceForParquet mockS3Interface;
+    ParquetReader reader;
+};
+
+TEST_F(ParquetReaderTest, ReadAllColumnsAsText) {
+    EXPECT_EQ(
+        "1\tapple\n"
+        "2\t\\N\n"
+        "3\ttab\\\tand\\\\\n"
+        "10\tsay \"hi\", bye\n"
+        "20\tline\\nbreak\n",
+        this->readAll());
+}
+
+TEST_F(ParquetReaderTest, ReadAsCSV) {
+    S3ScanDesc scanDesc;
+    scanDesc.csv = true;
+    scanDesc.delimiter = ',';
+    scanDesc.nullString = "";
+    scanDesc.escape = '"';
+    scanDesc.columns = {"name", "id"};
+    params.setScanDesc(scanDesc);
+
+    EXPECT_EQ(
+        "apple,1\n"
+        ",2\n"
+        "tab\tand\\,3\n"
+        "\"say \"\"hi\"\", bye\",10\n"
+        "\"line\nbreak\",20\n",
+        this->readAll());
+}
+
+TEST_F(ParquetReaderTest, HeaderLine) {
+    hasHeader = true;
+
+    S3ScanDesc scanDesc;
+    scanDesc.columns = {"id"};
+    params.setScanDesc(scanDesc);
+
+    EXPECT_EQ("id\n1\n2\n3\n10\n20\n", this->readAll());
+}
+
+TEST_F(ParquetReaderTest, OnlyFetchProjectedColumns) {
+    S3ScanDesc scanDesc;
+    scanDesc.columns = {"id", "name", "missing"};
+    scanDesc.projected = {true, false, true};
+    params.setScanDesc(scanDesc);
+
+    EXPECT_EQ("1\t\\N\t\\N\n2\t\\N\t\\N\n3\t\\N\t\\N\n10\t\\N\t\\N\n20\t\\N\t\\N\n",
+              this->readAll());
+
+    const ParquetFileMetaData &meta = reader.getMetaData();
+    for (uint64_t i = 0; i < meta.rowGroups.size(); i++) {
+        const ParquetColumnChunk &id = meta.rowGroups[i].columns[0];
+        const ParquetColumnChunk &name = meta.rowGroups[i].columns[1];
+
+        EXPECT_EQ((uint64_t)id.totalCompressedSize,
+                  mockS3Interface.fetchedIn(id.getStartOffset(),
+                                            id.getStartOffset() + id.totalCompressedSize));
+        EXPECT_EQ(0u, mockS3Interface.fetchedIn(name.getStartOffset(),
+                                                name.getStartOffset() + name.totalCompressedSize));
+    }
+}
+
+TEST_F(ParquetReaderTest, SkipRowGroupsByQuals) {
+    S3ScanQual qual;
+    qual.column = 0;
+    qual.op = S3_QUAL_GE;
+    qual.value = "5";
+    qual.numeric = true;
+
+    S3ScanDesc scanDesc;
+    scanDesc.columns = {"id", "name"};
+    scanDesc.quals = {qual};
+    params.setScanDesc(scanDesc);
+
+    // rows of a matching row group are all returned, the scan filters them again.
+    EXPECT_EQ("10\tsay \"hi\", bye\n20\tline\\nbreak\n", this->readAll());
+
+    const ParquetColumnChunk &first = reader.getMetaData().rowGroups[0].columns[0];
+    EXPECT_EQ(0u, mockS3Interface.fetchedIn(first.getStartOffset(),
+                                            first.getStartOffset() + first.totalCompressedSize));
+}
+
+TEST_F(ParquetReaderTest, RowGroupsInRange) {
+    reader.open(params);
+    uint64_t secondStart = reader.getMetaData().rowGroups[1].columns[0].getStartOffset();
+    reader.close();
+
+    params.setKeyRange(0, secondStart);
+    EXPECT_EQ("1\tapple\n2\t\\N\n3\ttab\\\tand\\\\\n", this->readAll());
+    reader.close();
+
+    params.setKeyRange(secondStart, mockS3Interface.file.size());
+    EXPECT_EQ("10\tsay \"hi\", bye\n20\tline\\nbreak\n", this->readAll());
+}
+
+TEST_F(ParquetReaderTest, RequestPerRange) {
+    this->readAll();
+
+    // footer, metadata, and a column chunk of each column of the two row groups.
+    EXPECT_EQ(6u, mockS3Interface.fetched.size());
+    EXPECT_EQ(6u, reader.getNumOfRequests());
+}
+
+TEST_F(ParquetReaderTest, CoalesceRanges) {
+    params.setRangeCoalesceGap(1024 * 1024);
+
+    EXPECT_EQ(
+        "1\tapple\n"
+        "2\t\\N\n"
+        "3\ttab\\\tand\\\\\n"
+        "10\tsay \"hi\", bye\n"
+        "20\tline\\nbreak\n",
+        this->readAll());
+
+    // the file is smaller than the footer read ahead, all of it is read with the footer.
+    ASSERT_EQ(1u, mockS3Interface.fetched.size());
+    EXPECT_EQ(0u, mockS3Interface.fetched[0].first);
+    EXPECT_EQ(mockS3Interface.file.size(), mockS3Interface.fetched[0].second);
+}
+
+TEST_F(ParquetReaderTest, ThrowOnInvalidFile) {
+    mockS3Interface.file = "PAR1 not a parquet file";
+    params.setKeySize(mockS3Interface.file.size());
+
+    EXPECT_THROW(reader.open(params), S3RuntimeError);
+}
@@ -0,0 +1,320 @@
+#include "parquet_writer.cpp"
+#include "gtest/gtest.h"
+
+// Keep the keys written, one string for each key.
+class KeysWriter : public Writer {
+   public:
+    KeysWriter() : keys(1) {
+    }
+
+    virtual void open(const S3Params &params) {
+    }
+
+    virtual uint64_t write(const char *buf, uint64_t count) {
+        this->keys.back().append(buf, count);
+        return count;
+    }
+
+    virtual void close() {
+    }
+
+    virtual void rollover(const S3Url &url) {
+        this->keys.push_back(string());
+    }
+
+    vector<string> keys;
+};
+
+// Decoded columns of a Parquet file.
+struct DecodedFile {
+    ParquetFileMetaData meta;
+    vector<vector<string> > values;
+    vector<vector<bool> > nulls;
+};
+
+static DecodedFile decodeFile(const string &file) {
+    DecodedFile decoded;
+
+    EXPECT_EQ(S3_PARQUET_MAGIC, file.substr(0, S3_PARQUET_MAGIC_LEN));
+    EXPECT_EQ(S3_PARQUET_MAGIC, file.substr(file.size() - S3_PARQUET_MAGIC_LEN));
+
+    uint32_t footerLen;
+    memcpy(&footerLen, file.data() + file.size() - S3_PARQUET_FOOTER_LEN, sizeof(footerLen));
+    ParseParquetFileMetaData(file.data() + file.size() - S3_PARQUET_FOOTER_LEN - footerLen,
+                             footerLen, decoded.meta);
+
+    decoded.values.resize(decoded.meta.columns.size());
+    decoded.nulls.resize(decoded.meta.columns.size());
+    for (uint64_t i = 0; i < decoded.meta.rowGroups.size(); i++) {
+        for (uint64_t j = 0; j < decoded.meta.columns.size(); j++) {
+            const ParquetColumnChunk &chunk = decoded.meta.rowGroups[i].columns[j];
+
+            vector<string> values;
+            vector<bool> nulls;
+            DecodeParquetColumnChunk(decoded.meta.columns[j], chunk,
+                                     file.data() + chunk.getStartOffset(),
+                                     chunk.totalCompressedSize, values, nulls);
+
+            decoded.values[j].insert(decoded.values[j].end(), values.begin(), values.end());
+            decoded.nulls[j].insert(decoded.nulls[j].end(), nulls.begin(), nulls.end());
+        }
+    }
+
+    return decoded;
+}
+
+TEST(ParquetRle, EncodeRunsAndPackedValues) {
+    vector<uint32_t> values;
+    for (uint32_t i = 0; i < 13; i++) {
+        values.push_back(i % 5);
+    }
+    values.insert(values.end(), 100, 3);
+    values.push_back(1);
+
+    string encoded = EncodeParquetRle(values, 0, values.size(), 3);
+
+    ParquetRleDecoder decoder(encoded.data(), encoded.size(), 3);
+    for (uint64_t i = 0; i < values.size(); i++) {
+        uint32_t value;
+        ASSERT_TRUE(decoder.next(&value));
+        EXPECT_EQ(values[i], value);
+    }
+
+    // the long run is encoded as one RLE run of 2 bytes.
+    EXPECT_GT((uint64_t)16, encoded.size());
+}
+
+TEST(ParquetRle, EncodePartOfValues) {
+    vector<uint32_t> values;
+    for (uint32_t i = 0; i < 20; i++) {
+        values.push_back(i * 1000);
+    }
+
+    string encoded = EncodeParquetRle(values, 5, 10, 15);
+
+    ParquetRleDecoder decoder(encoded.data(), encoded.size(), 15);
+    for (uint64_t i = 5; i < 15; i++) {
+        uint32_t value;
+        ASSERT_TRUE(decoder.next(&value));
+        EXPECT_EQ(values[i], value);
+    }
+}
+
+TEST(ParquetPlainValue, EncodeValuesByType) {
+    ParquetColumnSchema column;
+    column.name = "c";
+
+    column.type = PARQUET_INT32;
+    EXPECT_EQ("-42", FormatParquetValue(column, EncodeParquetPlainValue(column, "-42").data(), 4));
+    EXPECT_THROW(EncodeParquetPlainValue(column, "4294967296"), S3RuntimeError);
+    EXPECT_THROW(EncodeParquetPlainValue(column, "12a"), S3RuntimeError);
+    EXPECT_THROW(EncodeParquetPlainValue(column, ""), S3RuntimeError);
+
+    column.type = PARQUET_INT64;
+    EXPECT_EQ("-9223372036854775808",
+              FormatParquetValue(
+                  column, EncodeParquetPlainValue(column, "-9223372036854775808").data(), 8));
+
+    column.type = PARQUET_DOUBLE;
+    EXPECT_EQ("1.5", FormatParquetValue(column, EncodeParquetPlainValue(column, "1.5").data(), 8));
+    EXPECT_EQ("NaN", FormatParquetValue(column, EncodeParquetPlainValue(column, "NaN").data(), 8));
+
+    column.type = PARQUET_BOOLEAN;
+    EXPECT_EQ(string(1, '\1'), EncodeParquetPlainValue(column, "t"));
+    EXPECT_EQ(string(1, '\0'), EncodeParquetPlainValue(column, "f"));
+    EXPECT_THROW(EncodeParquetPlainValue(column, "maybe"), S3RuntimeError);
+
+    column.type = PARQUET_BYTE_ARRAY;
+    EXPECT_EQ("any text", EncodeParquetPlainValue(column, "any text"));
+}
+
+class ParquetWriterTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        S3ScanDesc desc;
+        desc.columns.push_back("id");
+        desc.types.push_back(S3_COLUMN_INT64);
+        desc.columns.push_back("name");
+        desc.types.push_back(S3_COLUMN_TEXT);
+        desc.columns.push_back("flag");
+        desc.types.push_back(S3_COLUMN_BOOL);
+        desc.columns.push_back("score");
+        desc.types.push_back(S3_COLUMN_DOUBLE);
+
+        params.setScanDesc(desc);
+        params.setParquetCodec("none");
+        params.setRowGroupSize(64 * 1024 * 1024);
+
+        writer.setWriter(&keys);
+    }
+
+    void writeLine(const string &line) {
+        EXPECT_EQ(line.size(), writer.write(line.data(), line.size()));
+    }
+
+    S3Params params;
+    KeysWriter keys;
+    ParquetWriter writer;
+};
+
+TEST_F(ParquetWriterTest, WriteTextLines) {
+    writer.open(params);
+    writeLine("1\talice\tt\t1.5\n");
+    writeLine("2\t\\N\tf\t\\N\n");
+    writeLine("3\ttab\\there\\\\\t\\N\t-2\n");
+    writer.close();
+
+    ASSERT_EQ((uint64_t)1, keys.keys.size());
+    DecodedFile file = decodeFile(keys.keys[0]);
+
+    EXPECT_EQ(3, file.meta.numRows);
+    ASSERT_EQ((uint64_t)1, file.meta.rowGroups.size());
+    ASSERT_EQ((uint64_t)4, file.meta.columns.size());
+
+    EXPECT_EQ("id", file.meta.columns[0].name);
+    EXPECT_EQ(PARQUET_INT64, file.meta.columns[0].type);
+    EXPECT_EQ(PARQUET_BYTE_ARRAY, file.meta.columns[1].type);
+    EXPECT_EQ(PARQUET_CONVERTED_UTF8, file.meta.columns[1].convertedType);
+    EXPECT_EQ(PARQUET_BOOLEAN, file.meta.columns[2].type);
+    EXPECT_EQ(PARQUET_DOUBLE, file.meta.columns[3].type);
+
+    EXPECT_EQ("1", file.values[0][0]);
+    EXPECT_EQ("3", file.values[0][2]);
+    EXPECT_EQ("alice", file.values[1][0]);
+    EXPECT_TRUE(file.nulls[1][1]);
+    EXPECT_EQ("tab\there\\", file.values[1][2]);
+    EXPECT_EQ("true", file.values[2][0]);
+    EXPECT_EQ("false", file.values[2][1]);
+    EXPECT_TRUE(file.nulls[2][2]);
+    EXPECT_EQ("1.5", file.values[3][0]);
+    EXPECT_TRUE(file.nulls[3][1]);
+    EXPECT_EQ("-2", file.values[3][2]);
+
+    // statistics of the id column.
+    const ParquetStatistics &stats = file.meta.rowGroups[0].columns[0].stats;
+    ASSERT_TRUE(stats.hasMin && stats.hasMax && stats.hasNullCount);
+    EXPECT_EQ("1", FormatParquetValue(file.meta.columns[0], stats.min.data(), 8));
+    EXPECT_EQ("3", FormatParquetValue(file.meta.columns[0], stats.max.data(), 8));
+    EXPECT_EQ(0, stats.nullCount);
+    EXPECT_EQ(1, file.meta.rowGroups[0].columns[1].stats.nullCount);
+}
+
+TEST_F(ParquetWriterTest, WriteCSVLines) {
+    S3ScanDesc desc = params.getScanDesc();
+    desc.csv = true;
+    desc.delimiter = ',';
+    desc.nullString = "";
+    desc.escape = '"';
+    params.setScanDesc(desc);
+
+    writer.open(params);
+    writeLine("1,\"a,\"\"b\"\"\nc\",t,\r\n");
+    writeLine("2,,f,3\r\n");
+    writeLine("3,\"\",t,4");
+    writer.close();
+
+    DecodedFile file = decodeFile(keys.keys[0]);
+    ASSERT_EQ(3, file.meta.numRows);
+
+    EXPECT_EQ("a,\"b\"\nc", file.values[1][0]);
+    EXPECT_TRUE(file.nulls[3][0]);
+    EXPECT_TRUE(file.nulls[1][1]);
+
+    // a quoted empty string is not NULL.
+    EXPECT_FALSE(file.nulls[1][2]);
+    EXPECT_EQ("", file.values[1][2]);
+    EXPECT_EQ("4", file.values[3][2]);
+}
+
+TEST_F(ParquetWriterTest, DictionaryAndCompression) {
+    params.setParquetCodec("gzip");
+    writer.open(params);
+    for (int i = 0; i < 10000; i++) {
+        writeLine(std::to_string((long long)i) + "\tname" + std::to_string((long long)(i % 3)) +
+                  "\tt\t0\n");
+    }
+    writer.close();
+
+    DecodedFile file = decodeFile(keys.keys[0]);
+    ASSERT_EQ(10000, file.meta.numRows);
+    EXPECT_EQ("name2", file.values[1][9998]);
+
+    // repeated names are dictionary encoded, both compress well.
+    const ParquetColumnChunk &names = file.meta.rowGroups[0].columns[1];
+    EXPECT_NE(0, names.dictionaryPageOffset);
+    EXPECT_EQ(PARQUET_GZIP, names.codec);
+    EXPECT_GT(1000, names.totalCompressedSize);
+}
+
+TEST_F(ParquetWriterTest, DictionaryFallsBackToPlain) {
+    writer.open(params);
+    string padding(60, 'x');
+    for (int i = 0; i < 20000; i++) {
+        writeLine(std::to_string((long long)i) + "\t" + padding + std::to_string((long long)i) +
+                  "\tf\t1\n");
+    }
+    writer.close();
+
+    DecodedFile file = decodeFile(keys.keys[0]);
+    ASSERT_EQ(20000, file.meta.numRows);
+    EXPECT_EQ(padding + "0", file.values[1][0]);
+    EXPECT_EQ(padding + "19999", file.values[1][19999]);
+
+    EXPECT_EQ(0, file.meta.rowGroups[0].columns[1].dictionaryPageOffset);
+}
+
+TEST_F(ParquetWriterTest, SplitIntoRowGroups) {
+    params.setRowGroupSize(1024);
+    writer.open(params);
+    for (int i = 0; i < 1000; i++) {
+        writeLine(std::to_string((long long)i) + "\tname\tt\t0\n");
+    }
+    writer.close();
+
+    DecodedFile file = decodeFile(keys.keys[0]);
+    EXPECT_EQ(1000, file.meta.numRows);
+    EXPECT_LT((uint64_t)10, file.meta.rowGroups.size());
+    EXPECT_EQ("999", file.values[0][999]);
+}
+
+TEST_F(ParquetWriterTest, RolloverFinishesFile) {
+    writer.open(params);
+    writeLine("1\ta\tt\t1\n");
+    writer.rollover(S3Url("https://s3-us-west-2.amazonaws.com/bucket/next"));
+    writeLine("2\tb\tf\t2\n");
+    writer.close();
+
+    ASSERT_EQ((uint64_t)2, keys.keys.size());
+    DecodedFile first = decodeFile(keys.keys[0]);
+    DecodedFile second = decodeFile(keys.keys[1]);
+    EXPECT_EQ(1, first.meta.numRows);
+    EXPECT_EQ("a", first.values[1][0]);
+    EXPECT_EQ(1, second.meta.numRows);
+    EXPECT_EQ("b", second.values[1][0]);
+}
+
+TEST_F(ParquetWriterTest, WrongNumberOfFields) {
+    writer.open(params);
+    EXPECT_THROW(writeLine("1\ta\tt\n"), S3RuntimeError);
+
+    KeysWriter otherKeys;
+    ParquetWriter other;
+    other.setWriter(&otherKeys);
+    other.open(params);
+    string line = "1\ta\tt\t1\textra\n";
+    EXPECT_THROW(other.write(line.data(), line.size()), S3RuntimeError);
+}
+
+TEST_F(ParquetWriterTest, EmptyFile) {
+    writer.open(params);
+    writer.close();
+
+    DecodedFile file = decodeFile(keys.keys[0]);
+    EXPECT_EQ(0, file.meta.numRows);
+    EXPECT_EQ((uint64_t)4, file.meta.columns.size());
+}
+
+TEST_F(ParquetWriterTest, NeedsColumns) {
+    params.setScanDesc(S3ScanDesc());
+    EXPECT_THROW(writer.open(params), S3ConfigError);
+}
@@ -0,0 +1,937 @@
+// Throughput benchmark of the gpcloud readers and writers against a mock S3 server running in
+// the same process. The server answers the requests the stages send on 127.0.0.1, with latency,
+// bandwidth and errors that can be configured, so the numbers don't depend on a real bucket.
+//
+// Every stage reports MB/s and the CPU time it used per byte. The CPU time of the server threads
+// is subtracted, what's left is what gpcloud itself spends. gpcheckcloud -b measures the same
+// stages against a real bucket.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <atomic>
+
+#include "compress_writer.h"
+#include "decompress_reader.h"
+#include "gpreader.h"
+#include "s3conf.h"
+#include "s3interface.h"
+#include "s3key_reader.h"
+#include "s3key_writer.h"
+#include "s3restful_service.h"
+
+bool hasHeader;
+
+char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
+
+string s3extErrorMessage;
+
+volatile bool QueryCancelPending = false;
+
+bool S3QueryIsAbortInProgress(void) {
+    return QueryCancelPending;
+}
+
+void MaskThreadSignals() {
+}
+
+void *S3Alloc(size_t size) {
+    return malloc(size);
+}
+
+void S3Free(void *p) {
+    free(p);
+}
+
+// Bytes are sent in slices of this size when the bandwidth is limited.
+#define MOCK_S3_SEND_SLICE (64 * 1024)
+
+#define MOCK_S3_BUCKET "bucket"
+
+// Bytes a stage reads or writes at a time, the size of the buffer of an external table.
+#define MOCK_S3_BUF_SIZE (64 * 1024)
+
+static uint64_t GetCPUTimeNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double toMB(uint64_t bytes) {
+    return bytes / 1024.0 / 1024.0;
+}
+
+static double toMBps(uint64_t bytes, uint64_t us) {
+    return us == 0 ? 0 : toMB(bytes) * 1000000.0 / us;
+}
+
+struct MockS3Config {
+    MockS3Config() : latencyUs(0), bandwidth(0), errorRate(0) {
+    }
+
+    uint64_t latencyUs;  // before the response of every request
+    uint64_t bandwidth;  // bytes per second of each connection, 0 if unlimited
+    double errorRate;    // chance of a request failing with 500
+};
+
+// A minimal S3 server on HTTP/1.1 with keep-alive, one thread per connection. It supports what
+// gpcloud sends: listing, HEAD, ranged GET and multipart upload. Objects are kept in memory,
+// uploaded parts are only counted.
+class MockS3Server {
+   public:
+    MockS3Server(const MockS3Config &config)
+        : config(config),
+          listenFd(-1),
+          port(0),
+          stopping(false),
+          nextUploadId(0),
+          randomState(0x5eed),
+          serverCPUNs(0),
+          requests(0),
+          errors(0) {
+        pthread_mutex_init(&this->mutex, NULL);
+    }
+
+    ~MockS3Server() {
+        this->stop();
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    void start() {
+        this->listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        S3_CHECK_OR_DIE(this->listenFd >= 0, S3RuntimeError, "Failed to create socket");
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+
+        socklen_t len = sizeof(addr);
+        S3_CHECK_OR_DIE(bind(this->listenFd, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+                            listen(this->listenFd, 128) == 0 &&
+                            getsockname(this->listenFd, (struct sockaddr *)&addr, &len) == 0,
+                        S3RuntimeError, "Failed to listen on 127.0.0.1");
+        this->port = ntohs(addr.sin_port);
+
+        pthread_create(&this->acceptThread, NULL, AcceptThreadFunc, this);
+    }
+
+    void stop() {
+        if (this->listenFd < 0) {
+            return;
+        }
+
+        this->stopping = true;
+        shutdown(this->listenFd, SHUT_RDWR);
+        pthread_join(this->acceptThread, NULL);
+        close(this->listenFd);
+        this->listenFd = -1;
+
+        vector<pthread_t> threads;
+        {
+            UniqueLock lock(&this->mutex);
+            for (size_t i = 0; i < this->connections.size(); i++) {
+                shutdown(this->connections[i], SHUT_RDWR);
+            }
+            threads.swap(this->connectionThreads);
+        }
+        for (size_t i = 0; i < threads.size(); i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    void putObject(const string &key, const string &data) {
+        UniqueLock lock(&this->mutex);
+        this->objects[key] = data;
+    }
+
+    int getPort() const {
+        return this->port;
+    }
+
+    string getUrl(const string &prefix) const {
+        stringstream ss;
+        ss << "s3://127.0.0.1:" << this->port << "/" MOCK_S3_BUCKET "/" << prefix;
+        return ss.str();
+    }
+
+    // CPU time of the server threads, it's not spent by gpcloud.
+    uint64_t getServerCPUNs() const {
+        return this->serverCPUNs;
+    }
+
+    uint64_t getRequests() const {
+        return this->requests;
+    }
+
+    uint64_t getErrors() const {
+        return this->errors;
+    }
+
+   private:
+    struct Request {
+        string method;
+        string path;  // without the bucket
+        string query;
+        uint64_t rangeStart;
+        uint64_t rangeEnd;  // inclusive
+        bool hasRange;
+        string body;
+    };
+
+    struct Connection {
+        MockS3Server *server;
+        int fd;
+        string buffer;  // received but not parsed yet
+    };
+
+    static void *AcceptThreadFunc(void *p) {
+        MockS3Server *server = (MockS3Server *)p;
+
+        while (!server->stopping) {
+            int fd = accept(server->listenFd, NULL, NULL);
+            if (fd < 0) {
+                break;
+            }
+
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            Connection *conn = new Connection();
+            conn->server = server;
+            conn->fd = fd;
+
+            UniqueLock lock(&server->mutex);
+            pthread_t thread;
+            pthread_create(&thread, NULL, ConnectionThreadFunc, conn);
+            server->connections.push_back(fd);
+            server->connectionThreads.push_back(thread);
+        }
+
+        return NULL;
+    }
+
+    static void *ConnectionThreadFunc(void *p) {
+        Connection *conn = (Connection *)p;
+        Request request;
+        uint64_t lastCPUNs = GetCPUTimeNs(CLOCK_THREAD_CPUTIME_ID);
+
+        // blocking on the socket takes no CPU time, parsing uploads does.
+        while (conn->server->readRequest(conn, request)) {
+            bool alive = conn->server->handle(conn->fd, request);
+
+            uint64_t cpuNs = GetCPUTimeNs(CLOCK_THREAD_CPUTIME_ID);
+            conn->server->serverCPUNs += cpuNs - lastCPUNs;
+            lastCPUNs = cpuNs;
+
+            if (!alive) {
+                break;
+            }
+        }
+
+        // the fd is closed by nobody else, stop() only shuts it down.
+        {
+            UniqueLock lock(&conn->server->mutex);
+            vector<int> &fds = conn->server->connections;
+            fds.erase(std::remove(fds.begin(), fds.end(), conn->fd), fds.end());
+        }
+        close(conn->fd);
+        delete conn;
+        return NULL;
+    }
+
+    // Receive until buffer has at least len bytes, return false if the connection is closed.
+    bool receive(Connection *conn, size_t len) {
+        char buf[MOCK_S3_SEND_SLICE];
+        while (conn->buffer.size() < len) {
+            ssize_t n = recv(conn->fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                return false;
+            }
+            conn->buffer.append(buf, n);
+        }
+        return true;
+    }
+
+    // Receive one line ending with CRLF, without the CRLF.
+    bool receiveLine(Connection *conn, string &line) {
+        size_t end;
+        while ((end = conn->buffer.find("\r\n")) == string::npos) {
+            if (!this->receive(conn, conn->buffer.size() + 1)) {
+                return false;
+            }
+        }
+        line = conn->buffer.substr(0, end);
+        conn->buffer.erase(0, end + 2);
+        return true;
+    }
+
+    bool readRequest(Connection *conn, Request &request) {
+        string line;
+        if (!this->receiveLine(conn, line)) {
+            return false;
+        }
+
+        // "GET /bucket/key?query HTTP/1.1"
+        size_t methodEnd = line.find(' ');
+        size_t targetEnd = line.rfind(' ');
+        if (methodEnd == string::npos || targetEnd <= methodEnd) {
+            return false;
+        }
+        request.method = line.substr(0, methodEnd);
+        string target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+
+        size_t queryStart = target.find('?');
+        string path = target.substr(0, queryStart);
+        request.query = queryStart == string::npos ? "" : target.substr(queryStart + 1);
+
+        string bucketPath = "/" MOCK_S3_BUCKET "/";
+        request.path = path.compare(0, bucketPath.size(), bucketPath) == 0
+                           ? path.substr(bucketPath.size())
+                           : path;
+
+        uint64_t contentLength = 0;
+        bool chunked = false;
+        bool expectContinue = false;
+        request.hasRange = false;
+
+        while (true) {
+            if (!this->receiveLine(conn, line)) {
+                return false;
+            }
+            if (line.empty()) {
+                break;
+            }
+
+            size_t colon = line.find(':');
+            if (colon == string::npos) {
+                continue;
+            }
+            string name = line.substr(0, colon);
+            string value = line.substr(line.find_first_not_of(' ', colon + 1));
+
+            if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+                contentLength = strtoull(value.c_str(), NULL, 10);
+            } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) {
+                chunked = (strcasecmp(value.c_str(), "chunked") == 0);
+            } else if (strcasecmp(name.c_str(), "Expect") == 0) {
+                expectContinue = (strcasecmp(value.c_str(), "100-continue") == 0);
+            } else if (strcasecmp(name.c_str(), "Range") == 0) {
+                request.hasRange = (sscanf(value.c_str(), "bytes=%" SCNu64 "-%" SCNu64,
+                                           &request.rangeStart, &request.rangeEnd) == 2);
+            }
+        }
+
+        if (expectContinue) {
+            this->sendAll(conn->fd, "HTTP/1.1 100 Continue\r\n\r\n");
+        }
+
+        request.body.clear();
+        uint64_t bodyStartUs = GetCurrentTimeUs();
+        if (chunked) {
+            while (true) {
+                if (!this->receiveLine(conn, line)) {
+                    return false;
+                }
+                uint64_t chunkLen = strtoull(line.c_str(), NULL, 16);
+                if (!this->receive(conn, chunkLen + 2)) {
+                    return false;
+                }
+                request.body.append(conn->buffer, 0, chunkLen);
+                conn->buffer.erase(0, chunkLen + 2);
+                if (chunkLen == 0) {
+                    break;
+                }
+            }
+        } else {
+            if (!this->receive(conn, contentLength)) {
+                return false;
+            }
+            request.body.assign(conn->buffer, 0, contentLength);
+            conn->buffer.erase(0, contentLength);
+        }
+
+        // uploads are as slow as downloads, the socket buffers would absorb a part otherwise.
+        this->throttle(bodyStartUs, request.body.size());
+
+        return true;
+    }
+
+    bool sendAll(int fd, const char *data, size_t len) {
+        while (len > 0) {
+            ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    bool sendAll(int fd, const string &data) {
+        return this->sendAll(fd, data.data(), data.size());
+    }
+
+    // Sleep until bytes transferred since startUs are within the bandwidth of a connection.
+    void throttle(uint64_t startUs, uint64_t bytes) {
+        if (this->config.bandwidth == 0) {
+            return;
+        }
+
+        uint64_t dueUs = startUs + bytes * 1000000 / this->config.bandwidth;
+        uint64_t nowUs = GetCurrentTimeUs();
+        if (dueUs > nowUs) {
+            usleep(dueUs - nowUs);
+        }
+    }
+
+    // Send the body no faster than the bandwidth of a connection.
+    bool sendThrottled(int fd, const char *data, size_t len) {
+        if (this->config.bandwidth == 0) {
+            return this->sendAll(fd, data, len);
+        }
+
+        uint64_t startUs = GetCurrentTimeUs();
+        size_t sent = 0;
+        while (sent < len) {
+            size_t slice = std::min(len - sent, (size_t)MOCK_S3_SEND_SLICE);
+            if (!this->sendAll(fd, data + sent, slice)) {
+                return false;
+            }
+            sent += slice;
+            this->throttle(startUs, sent);
+        }
+        return true;
+    }
+
+    bool respond(int fd, int status, const string &headers, const char *body, size_t len,
+                 bool hasBody = true) {
+        const char *reason = (status == 200)   ? "OK"
+                             : (status == 204) ? "No Content"
+                             : (status == 206) ? "Partial Content"
+                             : (status == 404) ? "Not Found"
+                                               : "Internal Server Error";
+        stringstream ss;
+        ss << "HTTP/1.1 " << status << " " << reason << "\r\n"
+           << headers << "Content-Length: " << len << "\r\n\r\n";
+
+        if (!this->sendAll(fd, ss.str())) {
+            return false;
+        }
+        return !hasBody || this->sendThrottled(fd, body, len);
+    }
+
+    bool respond(int fd, int status, const string &body) {
+        return this->respond(fd, status, "Content-Type: application/xml\r\n", body.data(),
+                             body.size());
+    }
+
+    bool respondError(int fd, int status, const string &code, bool hasBody) {
+        string body = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Error><Code>" + code +
+                      "</Code><Message>" + code + "</Message></Error>";
+        return this->respond(fd, status, "Content-Type: application/xml\r\n", body.data(),
+                             body.size(), hasBody);
+    }
+
+    // Deterministic so that runs with the same options see about the same errors.
+    bool injectError() {
+        if (this->config.errorRate <= 0) {
+            return false;
+        }
+
+        UniqueLock lock(&this->mutex);
+        this->randomState = this->randomState * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (this->randomState >> 11) * (1.0 / (1ULL << 53)) < this->config.errorRate;
+    }
+
+    bool handle(int fd, const Request &request) {
+        this->requests++;
+
+        if (this->config.latencyUs > 0) {
+            usleep(this->config.latencyUs);
+        }
+
+        bool head = (request.method == "HEAD");
+        if (this->injectError()) {
+            this->errors++;
+            return this->respondError(fd, 500, "InternalError", !head);
+        }
+
+        if (request.method == "GET" && request.path.empty()) {
+            return this->handleList(fd, request);
+        } else if (request.method == "GET" || head) {
+            return this->handleGet(fd, request, head);
+        } else if (request.method == "POST" && request.query == "uploads") {
+            stringstream ss;
+            ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<InitiateMultipartUploadResult>"
+               << "<Bucket>" MOCK_S3_BUCKET "</Bucket><Key>" << request.path << "</Key><UploadId>"
+               << ++this->nextUploadId << "</UploadId></InitiateMultipartUploadResult>";
+            return this->respond(fd, 200, ss.str());
+        } else if (request.method == "PUT") {
+            stringstream headers;
+            headers << "ETag: \"" << std::hex << crc32(0, (const Bytef *)request.body.data(),
+                                                        request.body.size())
+                    << "\"\r\n";
+            return this->respond(fd, 200, headers.str(), NULL, 0);
+        } else if (request.method == "POST") {
+            return this->respond(fd, 200,
+                                 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                 "<CompleteMultipartUploadResult><Bucket>" MOCK_S3_BUCKET
+                                 "</Bucket><Key>" +
+                                     request.path + "</Key></CompleteMultipartUploadResult>");
+        } else if (request.method == "DELETE") {
+            return this->respond(fd, 204, "", NULL, 0);
+        }
+
+        return this->respondError(fd, 500, "NotImplemented", true);
+    }
+
+    bool handleList(int fd, const Request &request) {
+        string prefix;
+        if (request.query.compare(0, strlen("prefix="), "prefix=") == 0) {
+            prefix = UriDecode(request.query.substr(strlen("prefix=")));
+        }
+
+        stringstream ss;
+        ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<ListBucketResult>"
+           << "<Name>" MOCK_S3_BUCKET "</Name><Prefix>" << prefix
+           << "</Prefix><IsTruncated>false</IsTruncated>";
+        {
+            UniqueLock lock(&this->mutex);
+            map<string, string>::const_iterator i;
+            for (i = this->objects.lower_bound(prefix);
+                 i != this->objects.end() && i->first.compare(0, prefix.size(), prefix) == 0;
+                 i++) {
+                ss << "<Contents><Key>" << i->first << "</Key><Size>" << i->second.size()
+                   << "</Size><ETag>\"" << std::hex << i->second.size() << std::dec
+                   << "\"</ETag></Contents>";
+            }
+        }
+        ss << "</ListBucketResult>";
+
+        return this->respond(fd, 200, ss.str());
+    }
+
+    bool handleGet(int fd, const Request &request, bool head) {
+        const string *data = NULL;
+        {
+            // objects are not changed while stages run, the pointer stays valid.
+            UniqueLock lock(&this->mutex);
+            map<string, string>::const_iterator i = this->objects.find(UriDecode(request.path));
+            if (i != this->objects.end()) {
+                data = &i->second;
+            }
+        }
+
+        if (data == NULL) {
+            return this->respondError(fd, 404, "NoSuchKey", !head);
+        }
+
+        if (head || !request.hasRange) {
+            return this->respond(fd, 200, "", data->data(), data->size(), !head);
+        }
+
+        uint64_t start = std::min(request.rangeStart, (uint64_t)data->size());
+        uint64_t end = std::min(request.rangeEnd + 1, (uint64_t)data->size());
+        stringstream headers;
+        headers << "Content-Range: bytes " << start << "-" << end - 1 << "/" << data->size()
+                << "\r\n";
+        return this->respond(fd, 206, headers.str(), data->data() + start, end - start);
+    }
+
+    MockS3Config config;
+
+    int listenFd;
+    int port;
+    volatile bool stopping;
+    pthread_t acceptThread;
+
+    pthread_mutex_t mutex;
+    vector<int> connections;
+    vector<pthread_t> connectionThreads;
+    map<string, string> objects;
+    std::atomic<uint64_t> nextUploadId;
+    uint64_t randomState;
+
+    std::atomic<uint64_t> serverCPUNs;
+    std::atomic<uint64_t> requests;
+    std::atomic<uint64_t> errors;
+};
+
+// Lends data kept in memory, the upstream of decompression.
+class BufferReader : public Reader {
+   public:
+    BufferReader(const string &data) : data(data), offset(0) {
+    }
+
+    virtual void open(const S3Params &params) {
+        this->offset = 0;
+    }
+
+    virtual uint64_t read(char *buf, uint64_t count) {
+        const char *view = NULL;
+        uint64_t len = this->readView(&view, count);
+        memcpy(buf, view, len);
+        return len;
+    }
+
+    virtual uint64_t readView(const char **view, uint64_t count) {
+        uint64_t len = std::min(count, (uint64_t)this->data.size() - this->offset);
+        *view = this->data.data() + this->offset;
+        this->offset += len;
+        return len;
+    }
+
+    virtual void close() {
+    }
+
+   private:
+    const string &data;
+    uint64_t offset;
+};
+
+// Drops everything, the downstream of compression.
+class NullWriter : public Writer {
+   public:
+    NullWriter() : bytes(0) {
+    }
+
+    virtual void open(const S3Params &params) {
+        this->bytes = 0;
+    }
+
+    virtual uint64_t write(const char *buf, uint64_t count) {
+        this->bytes += count;
+        return count;
+    }
+
+    virtual void close() {
+    }
+
+    uint64_t bytes;
+};
+
+struct BenchmarkOptions {
+    BenchmarkOptions() : size(64 * 1024 * 1024), keys(8), chunkSize(8 * 1024 * 1024), threads(4) {
+    }
+
+    uint64_t size;  // bytes of data each stage processes
+    uint64_t keys;  // the data of bucket reader stages is split into this many keys
+    uint64_t chunkSize;
+    uint64_t threads;
+};
+
+// Measures the wall time and the CPU time gpcloud spends in a stage.
+class StageTimer {
+   public:
+    StageTimer(const MockS3Server &server) : server(server) {
+        this->startUs = GetCurrentTimeUs();
+        this->startCPUNs = GetCPUTimeNs(CLOCK_PROCESS_CPUTIME_ID);
+        this->startServerCPUNs = server.getServerCPUNs();
+        this->startRequests = server.getRequests();
+        this->startErrors = server.getErrors();
+    }
+
+    void report(const char *stage, uint64_t bytes) {
+        uint64_t totalUs = GetCurrentTimeUs() - this->startUs;
+        uint64_t cpuNs = GetCPUTimeNs(CLOCK_PROCESS_CPUTIME_ID) - this->startCPUNs;
+        uint64_t serverCPUNs = this->server.getServerCPUNs() - this->startServerCPUNs;
+        cpuNs = cpuNs > serverCPUNs ? cpuNs - serverCPUNs : 0;
+
+        printf("%-26s %10.2f MB %10.3f s %10.2f MB/s %10.3f ns/byte %8" PRIu64
+               " requests %6" PRIu64 " errors\n",
+               stage, toMB(bytes), totalUs / 1000000.0, toMBps(bytes, totalUs),
+               bytes == 0 ? 0 : (double)cpuNs / bytes, this->server.getRequests() - this->startRequests,
+               this->server.getErrors() - this->startErrors);
+    }
+
+   private:
+    const MockS3Server &server;
+    uint64_t startUs;
+    uint64_t startCPUNs;
+    uint64_t startServerCPUNs;
+    uint64_t startRequests;
+    uint64_t startErrors;
+};
+
+// Lines of text, they compress about as well as real table data.
+static string GenerateText(uint64_t size) {
+    string text;
+    text.reserve(size + 128);
+
+    char line[128];
+    for (uint64_t i = 0; text.size() < size; i++) {
+        int len = snprintf(line, sizeof(line), "%" PRIu64 ",s3benchmark,%" PRIu64 ",%08" PRIx64
+                                               ",2026-10-14 12:00:00\n",
+                           i, i * 7919 % 100000, i * 2654435761ULL);
+        text.append(line, len);
+    }
+    text.resize(size);
+    return text;
+}
+
+static string GzipCompress(const string &data) {
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+    S3_CHECK_OR_DIE(deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8,
+                                 Z_DEFAULT_STRATEGY) == Z_OK,
+                    S3RuntimeError, "Failed to initialize zlib");
+
+    string out(deflateBound(&zstream, data.size()), '\0');
+    zstream.next_in = (Bytef *)data.data();
+    zstream.avail_in = data.size();
+    zstream.next_out = (Bytef *)&out[0];
+    zstream.avail_out = out.size();
+
+    int status = deflate(&zstream, Z_FINISH);
+    out.resize(zstream.total_out);
+    deflateEnd(&zstream);
+
+    S3_CHECK_OR_DIE(status == Z_STREAM_END, S3RuntimeError, "Failed to compress data");
+    return out;
+}
+
+static S3Params MakeParams(const MockS3Server &server, const string &prefix,
+                           const BenchmarkOptions &options) {
+    S3Params params(server.getUrl(prefix), false);
+    params.setCred("s3benchmark", "s3benchmark", "");
+    params.setChunkSize(options.chunkSize);
+    params.setNumOfChunks(options.threads);
+    params.setRetryBackoff(1);
+    return params;
+}
+
+static uint64_t DrainReader(Reader &reader) {
+    vector<char> buf(MOCK_S3_BUF_SIZE);
+    uint64_t bytes = 0;
+    uint64_t len;
+    while ((len = reader.read(buf.data(), buf.size())) != 0) {
+        bytes += len;
+    }
+    return bytes;
+}
+
+static void FeedWriter(Writer &writer, const string &data) {
+    for (uint64_t offset = 0; offset < data.size(); offset += MOCK_S3_BUF_SIZE) {
+        writer.write(data.data() + offset, std::min((uint64_t)MOCK_S3_BUF_SIZE, data.size() - offset));
+    }
+}
+
+static void BenchmarkKeyReader(const MockS3Server &server, const BenchmarkOptions &options,
+                               uint64_t keySize) {
+    S3Params params = MakeParams(server, "single/data", options);
+    params.setKeySize(keySize);
+    PrepareS3MemContext(params);
+
+    S3RESTfulService restfulService(params);
+    S3InterfaceService s3InterfaceService(params);
+    s3InterfaceService.setRESTfulService(&restfulService);
+
+    S3KeyReader keyReader;
+    keyReader.setS3InterfaceService(&s3InterfaceService);
+
+    StageTimer timer(server);
+    keyReader.open(params);
+    uint64_t bytes = DrainReader(keyReader);
+    keyReader.close();
+    timer.report("S3KeyReader", bytes);
+}
+
+static void BenchmarkDecompressReader(const MockS3Server &server, const BenchmarkOptions &options,
+                                      const string &compressed) {
+    S3Params params = MakeParams(server, "", options);
+    BufferReader bufferReader(compressed);
+
+    DecompressReader decompressReader;
+    decompressReader.setCompressionType(S3_COMPRESSION_GZIP);
+    decompressReader.setReader(&bufferReader);
+
+    StageTimer timer(server);
+    decompressReader.open(params);
+    uint64_t bytes = DrainReader(decompressReader);
+    decompressReader.close();
+    timer.report("DecompressReader", bytes);
+}
+
+// The whole chain of a segment: S3BucketReader, S3CommonReader, DecompressReader if the keys are
+// compressed, and S3KeyReader.
+static void BenchmarkBucketReader(const MockS3Server &server, const BenchmarkOptions &options,
+                                  const string &prefix, const char *stage) {
+    S3Params params = MakeParams(server, prefix, options);
+    PrepareS3MemContext(params);
+
+    GPReader reader(params);
+
+    StageTimer timer(server);
+    reader.open(params);
+    uint64_t bytes = DrainReader(reader);
+    reader.close();
+    timer.report(stage, bytes);
+}
+
+static void BenchmarkCompressWriter(const MockS3Server &server, const BenchmarkOptions &options,
+                                    const string &text) {
+    S3Params params = MakeParams(server, "", options);
+    NullWriter nullWriter;
+
+    CompressWriter compressWriter;
+    compressWriter.setWriter(&nullWriter);
+
+    StageTimer timer(server);
+    compressWriter.open(params);
+    FeedWriter(compressWriter, text);
+    compressWriter.close();
+    timer.report("CompressWriter", text.size());
+}
+
+static void BenchmarkKeyWriter(const MockS3Server &server, const BenchmarkOptions &options,
+                               const string &text, bool compress) {
+    S3Params params = MakeParams(server, compress ? "upload/data.gz" : "upload/data", options);
+
+    S3RESTfulService restfulService(params);
+    S3InterfaceService s3InterfaceService(params);
+    s3InterfaceService.setRESTfulService(&restfulService);
+
+    S3KeyWriter keyWriter;
+    keyWriter.setS3InterfaceService(&s3InterfaceService);
+
+    CompressWriter compressWriter;
+    compressWriter.setWriter(&keyWriter);
+    Writer &writer = compress ? (Writer &)compressWriter : (Writer &)keyWriter;
+
+    StageTimer timer(server);
+    if (compress) {
+        keyWriter.open(params);
+    }
+    writer.open(params);
+    FeedWriter(writer, text);
+    writer.close();
+    if (compress) {
+        keyWriter.close();
+    }
+    timer.report(compress ? "CompressWriter+S3KeyWriter" : "S3KeyWriter", text.size());
+}
+
+static void printUsage(FILE *stream) {
+    fprintf(stream,
+            "Usage: s3benchmark [-s size_mb] [-k keys] [-c chunk_mb] [-t threads]\n"
+            "                   [-l latency_ms] [-b bandwidth_mbps] [-e error_rate]\n"
+            "  -s  MB of data each stage processes, 64 by default\n"
+            "  -k  number of keys the bucket reader stages read, 8 by default\n"
+            "  -c  chunk size in MB, 8 by default\n"
+            "  -t  threads of readers and writers, 4 by default\n"
+            "  -l  latency of the mock server before every response, in ms\n"
+            "  -b  bandwidth of each connection to the mock server, in MB/s\n"
+            "  -e  chance of a request failing with 500, between 0 and 1\n");
+}
+
+int main(int argc, char *argv[]) {
+    BenchmarkOptions options;
+    MockS3Config config;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:k:c:t:l:b:e:h")) != -1) {
+        switch (opt) {
+            case 's':
+                options.size = strtoull(optarg, NULL, 10) * 1024 * 1024;
+                break;
+            case 'k':
+                options.keys = std::max(strtoull(optarg, NULL, 10), 1ULL);
+                break;
+            case 'c':
+                options.chunkSize = strtoull(optarg, NULL, 10) * 1024 * 1024;
+                break;
+            case 't':
+                options.threads = std::max(strtoull(optarg, NULL, 10), 1ULL);
+                break;
+            case 'l':
+                config.latencyUs = strtoull(optarg, NULL, 10) * 1000;
+                break;
+            case 'b':
+                config.bandwidth = strtoull(optarg, NULL, 10) * 1024 * 1024;
+                break;
+            case 'e':
+                config.errorRate = strtod(optarg, NULL);
+                break;
+            case 'h':
+                printUsage(stdout);
+                return 0;
+            default:
+                printUsage(stderr);
+                return 1;
+        }
+    }
+
+    if (options.size == 0 || options.chunkSize == 0 || config.errorRate < 0 ||
+        config.errorRate >= 1) {
+        printUsage(stderr);
+        return 1;
+    }
+
+    // the bucket reader gets all keys as the only segment.
+    s3ext_segid = 0;
+    s3ext_segnum = 1;
+    s3ext_loglevel = EXT_ERROR;
+    s3ext_logtype = STDERR_LOG;
+
+    thread_setup();
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    int ret = 0;
+    try {
+        string text = GenerateText(options.size);
+        string compressed = GzipCompress(text);
+
+        MockS3Server server(config);
+        server.putObject("single/data", text);
+
+        uint64_t keySize = (text.size() + options.keys - 1) / options.keys;
+        for (uint64_t i = 0; i < options.keys; i++) {
+            string part = text.substr(std::min(i * keySize, (uint64_t)text.size()), keySize);
+            // keys read by a segment are lines, each of them ends with a complete line.
+            part += "\n";
+
+            stringstream plainKey, gzipKey;
+            plainKey << "plain/data" << i;
+            gzipKey << "gzip/data" << i << ".gz";
+            server.putObject(plainKey.str(), part);
+            server.putObject(gzipKey.str(), GzipCompress(part));
+        }
+
+        server.start();
+
+        printf("mock S3 on 127.0.0.1:%d, latency %.1f ms, bandwidth %.2f MB/s per connection "
+               "(0 is unlimited), error rate %.3f\n",
+               server.getPort(), config.latencyUs / 1000.0, toMB(config.bandwidth),
+               config.errorRate);
+        printf("%.2f MB of text, %.2f MB gzipped, %" PRIu64 " keys, chunk %.2f MB, %" PRIu64
+               " threads\n\n",
+               toMB(text.size()), toMB(compressed.size()), options.keys, toMB(options.chunkSize),
+               options.threads);
+
+        BenchmarkKeyReader(server, options, text.size());
+        BenchmarkDecompressReader(server, options, compressed);
+        BenchmarkBucketReader(server, options, "plain/", "S3BucketReader");
+        BenchmarkBucketReader(server, options, "gzip/", "S3BucketReader (gzip)");
+        BenchmarkCompressWriter(server, options, text);
+        BenchmarkKeyWriter(server, options, text, false);
+        BenchmarkKeyWriter(server, options, text, true);
+
+        server.stop();
+    } catch (S3Exception &e) {
+        fprintf(stderr, "Failed: %s\n", e.getFullMessage().c_str());
+        ret = 1;
+    }
+
+    curl_global_cleanup();
+    thread_cleanup();
+
+    return ret;
+}
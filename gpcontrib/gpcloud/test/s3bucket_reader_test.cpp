@@ -17,6 +17,318 @@ class MockS3Reader : public Reader {
     }
 };
 
+// ================== ScheduleKeyRanges ===================
+
+static uint64_t sumOfRangeSize(const vector<KeyRange>& ranges) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        total += ranges[i].getSize();
+    }
+    return total;
+}
+
+TEST(ScheduleKeyRanges, RoundRobinForEqualSizedKeys) {
+    vector<BucketContent> keys;
+    for (int i = 0; i < 10; i++) {
+        keys.emplace_back(std::to_string(i), 100);
+    }
+
+    vector<KeyRange> ranges = ScheduleKeyRanges(keys, 1, 4, 0, true);
+
+    ASSERT_EQ((uint64_t)3, ranges.size());
+    EXPECT_EQ((uint64_t)1, ranges[0].keyIndex);
+    EXPECT_EQ((uint64_t)5, ranges[1].keyIndex);
+    EXPECT_EQ((uint64_t)9, ranges[2].keyIndex);
+}
+
+TEST(ScheduleKeyRanges, SplitHugeKeyAcrossSegments) {
+    vector<BucketContent> keys;
+    keys.emplace_back("huge", 4000);
+    for (int i = 0; i < 100; i++) {
+        keys.emplace_back(std::to_string(i), 1);
+    }
+
+    uint64_t total = 0;
+    for (uint64_t seg = 0; seg < 4; seg++) {
+        vector<KeyRange> ranges = ScheduleKeyRanges(keys, seg, 4, 0, true);
+        uint64_t load = sumOfRangeSize(ranges);
+
+        // every segment gets about a quarter of data
+        EXPECT_LE(load, (uint64_t)1026);
+        EXPECT_GE(load, (uint64_t)1000);
+        total += load;
+
+        for (size_t i = 1; i < ranges.size(); i++) {
+            EXPECT_TRUE(isPrecedingKeyRange(ranges[i - 1], ranges[i]));
+        }
+    }
+    EXPECT_EQ((uint64_t)4100, total);
+}
+
+TEST(ScheduleKeyRanges, NoSplitOfKeyThatCantBeSplit) {
+    vector<BucketContent> keys;
+    keys.emplace_back("huge.gz", 4000);
+    keys.emplace_back("huge", 4000);
+
+    vector<size_t> checked;
+    auto canSplitKey = [&](size_t i) {
+        checked.push_back(i);
+        return i != 0;
+    };
+
+    uint64_t wholeKeys = 0;
+    for (uint64_t seg = 0; seg < 4; seg++) {
+        vector<KeyRange> ranges = ScheduleKeyRanges(keys, seg, 4, 0, true, canSplitKey);
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (ranges[i].keyIndex == 0) {
+                EXPECT_EQ((uint64_t)4000, ranges[i].getSize());
+                wholeKeys++;
+            }
+        }
+    }
+    EXPECT_EQ((uint64_t)1, wholeKeys);
+    EXPECT_EQ((size_t)8, checked.size());
+
+    // keys not to be split anyway are not checked
+    checked.clear();
+    ScheduleKeyRanges(keys, 0, 4, 4000, true, canSplitKey);
+    ScheduleKeyRanges(keys, 0, 4, 0, false, canSplitKey);
+    EXPECT_TRUE(checked.empty());
+}
+
+TEST(ScheduleKeyRanges, NoSplitWhenDisabledOrBelowMinRangeSize) {
+    vector<BucketContent> keys;
+    keys.emplace_back("huge", 4000);
+    keys.emplace_back("small", 10);
+
+    vector<KeyRange> ranges = ScheduleKeyRanges(keys, 0, 4, 0, false);
+    ASSERT_EQ((uint64_t)1, ranges.size());
+    EXPECT_EQ((uint64_t)0, ranges[0].start);
+    EXPECT_EQ((uint64_t)4000, ranges[0].end);
+
+    ranges = ScheduleKeyRanges(keys, 0, 4, 4000, true);
+    ASSERT_EQ((uint64_t)1, ranges.size());
+    EXPECT_EQ((uint64_t)4000, ranges[0].getSize());
+
+    // the small key goes to the next idle segment
+    ranges = ScheduleKeyRanges(keys, 1, 4, 4000, true);
+    ASSERT_EQ((uint64_t)1, ranges.size());
+    EXPECT_EQ((uint64_t)1, ranges[0].keyIndex);
+}
+
+TEST(ScheduleKeyRanges, RangesCoverKeyWithoutGapOrOverlap) {
+    vector<BucketContent> keys;
+    keys.emplace_back("huge", 1001);
+
+    vector<KeyRange> all;
+    for (uint64_t seg = 0; seg < 3; seg++) {
+        vector<KeyRange> ranges = ScheduleKeyRanges(keys, seg, 3, 0, true);
+        all.insert(all.end(), ranges.begin(), ranges.end());
+    }
+    std::sort(all.begin(), all.end(), isPrecedingKeyRange);
+
+    ASSERT_EQ((uint64_t)3, all.size());
+    EXPECT_EQ((uint64_t)0, all[0].start);
+    EXPECT_EQ(all[0].end, all[1].start);
+    EXPECT_EQ(all[1].end, all[2].start);
+    EXPECT_EQ((uint64_t)1001, all[2].end);
+}
+
+TEST(ScheduleKeyRanges, ZeroSegment) {
+    vector<BucketContent> keys;
+    keys.emplace_back("foo", 10);
+
+    EXPECT_TRUE(ScheduleKeyRanges(keys, 0, 0, 0, true).empty());
+}
+
+// ================== SampleKeyRanges ===================
+
+static vector<KeyRange> equalSizedRanges(uint64_t num, uint64_t size) {
+    vector<KeyRange> ranges;
+    for (uint64_t i = 0; i < num; i++) {
+        ranges.emplace_back(i, 0, size);
+    }
+    return ranges;
+}
+
+TEST(SampleKeyRanges, AllRangesForWholeFraction) {
+    vector<KeyRange> ranges = equalSizedRanges(10, 100);
+    double sampled = 0;
+
+    vector<KeyRange> result = SampleKeyRanges(ranges, 1.0, 0, &sampled);
+    EXPECT_EQ((uint64_t)10, result.size());
+    EXPECT_DOUBLE_EQ(1.0, sampled);
+}
+
+TEST(SampleKeyRanges, PickFractionOfBytesInKeyOrder) {
+    vector<KeyRange> ranges = equalSizedRanges(100, 100);
+    double sampled = 0;
+
+    vector<KeyRange> result = SampleKeyRanges(ranges, 0.1, 3, &sampled);
+    ASSERT_EQ((uint64_t)10, result.size());
+    EXPECT_DOUBLE_EQ(0.1, sampled);
+    for (size_t i = 1; i < result.size(); i++) {
+        EXPECT_TRUE(isPrecedingKeyRange(result[i - 1], result[i]));
+    }
+}
+
+TEST(SampleKeyRanges, SameSeedSameSample) {
+    vector<KeyRange> ranges = equalSizedRanges(100, 100);
+    double sampled = 0;
+
+    vector<KeyRange> a = SampleKeyRanges(ranges, 0.2, 7, &sampled);
+    vector<KeyRange> b = SampleKeyRanges(ranges, 0.2, 7, &sampled);
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        EXPECT_EQ(a[i].keyIndex, b[i].keyIndex);
+    }
+}
+
+TEST(SampleKeyRanges, AtLeastOneRange) {
+    vector<KeyRange> ranges;
+    ranges.emplace_back(0, 0, 1000);
+    ranges.emplace_back(1, 0, 3000);
+    double sampled = 0;
+
+    vector<KeyRange> result = SampleKeyRanges(ranges, 0.0001, 0, &sampled);
+    ASSERT_EQ((uint64_t)1, result.size());
+    EXPECT_DOUBLE_EQ((double)result[0].getSize() / 4000, sampled);
+}
+
+// ================== KeyList cache ===================
+
+TEST(KeyListCache, SerializeAndDeserialize) {
+    ListBucketResult keyList;
+    keyList.Name = "bucket";
+    keyList.Prefix = "prefix";
+    keyList.contents.emplace_back("prefix/a", 1024, "\"b54357faf0632cce46e942fa68356b38\"");
+    keyList.contents.emplace_back("prefix/name with space", 0);
+
+    string text = SerializeKeyList(keyList);
+
+    ListBucketResult result;
+    ASSERT_TRUE(DeserializeKeyList(text, result));
+    EXPECT_EQ("bucket", result.Name);
+    EXPECT_EQ("prefix", result.Prefix);
+    ASSERT_EQ((uint64_t)2, result.contents.size());
+    EXPECT_EQ("prefix/a", result.contents[0].getName());
+    EXPECT_EQ((uint64_t)1024, result.contents[0].getSize());
+    EXPECT_EQ("\"b54357faf0632cce46e942fa68356b38\"", result.contents[0].getETag());
+    EXPECT_EQ("prefix/name with space", result.contents[1].getName());
+    EXPECT_EQ((uint64_t)0, result.contents[1].getSize());
+    EXPECT_EQ("", result.contents[1].getETag());
+
+    // truncated text is rejected
+    EXPECT_FALSE(DeserializeKeyList(text.substr(0, text.size() - 1), result));
+    EXPECT_FALSE(DeserializeKeyList(text.substr(0, text.find("prefix/name")), result));
+    EXPECT_FALSE(DeserializeKeyList("", result));
+}
+
+TEST(KeyListCache, SerializeKeyWithNewline) {
+    ListBucketResult keyList;
+    keyList.contents.emplace_back("bad\nkey", 1024);
+
+    EXPECT_EQ("", SerializeKeyList(keyList));
+}
+
+TEST(KeyListCache, SerializeETagWithSpace) {
+    ListBucketResult keyList;
+    keyList.contents.emplace_back("foo", 1024, "bad etag");
+
+    EXPECT_EQ("", SerializeKeyList(keyList));
+}
+
+class KeyListCacheTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        char dir[] = "/tmp/gpcloud_list_cache_XXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        cachePath = string(dir) + "/list";
+        cacheDir = dir;
+
+        keyList.Name = "bucket";
+        keyList.contents.emplace_back("foo", 456);
+    }
+
+    virtual void TearDown() {
+        unlink(cachePath.c_str());
+        rmdir(cacheDir.c_str());
+    }
+
+    string cacheDir;
+    string cachePath;
+    ListBucketResult keyList;
+    MockS3Interface s3Interface;
+    S3Url s3Url{"https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever"};
+};
+
+TEST_F(KeyListCacheTest, ListOnlyOnce) {
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(keyList));
+
+    ListBucketResult first = ListBucketWithCache(&s3Interface, s3Url, cachePath, 60);
+    ListBucketResult second = ListBucketWithCache(&s3Interface, s3Url, cachePath, 60);
+
+    ASSERT_EQ((uint64_t)1, second.contents.size());
+    EXPECT_EQ("foo", second.contents[0].getName());
+    EXPECT_EQ((uint64_t)456, second.contents[0].getSize());
+}
+
+TEST_F(KeyListCacheTest, ListAgainAfterExpired) {
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(2).WillRepeatedly(Return(keyList));
+
+    ListBucketWithCache(&s3Interface, s3Url, cachePath, 0);
+    ListBucketWithCache(&s3Interface, s3Url, cachePath, 0);
+}
+
+TEST_F(KeyListCacheTest, ListAgainIfCorrupted) {
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(keyList));
+
+    FILE* f = fopen(cachePath.c_str(), "w");
+    ASSERT_TRUE(f != NULL);
+    fputs("garbage\n", f);
+    fclose(f);
+
+    ListBucketResult result = ListBucketWithCache(&s3Interface, s3Url, cachePath, 60);
+    ASSERT_EQ((uint64_t)1, result.contents.size());
+}
+
+TEST_F(KeyListCacheTest, ListDirectlyIfCacheUnavailable) {
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(2).WillRepeatedly(Return(keyList));
+
+    string badPath = cacheDir + "/not/exist";
+    ListBucketWithCache(&s3Interface, s3Url, badPath, 60);
+    ListBucketResult result = ListBucketWithCache(&s3Interface, s3Url, badPath, 60);
+    EXPECT_EQ((uint64_t)1, result.contents.size());
+}
+
+TEST_F(KeyListCacheTest, ListFailureLeavesNoCache) {
+    EXPECT_CALL(s3Interface, listBucket(_))
+        .Times(2)
+        .WillOnce(Throw(S3LogicError("failed to list", "")))
+        .WillOnce(Return(keyList));
+
+    EXPECT_THROW(ListBucketWithCache(&s3Interface, s3Url, cachePath, 60), S3LogicError);
+
+    ListBucketResult result = ListBucketWithCache(&s3Interface, s3Url, cachePath, 60);
+    EXPECT_EQ((uint64_t)1, result.contents.size());
+}
+
+TEST(KeyListCache, PathDependsOnAccessKey) {
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setListCacheDir("/tmp");
+    params.setCred("accessid", "secret", "");
+
+    S3Params sameKey = params;
+    sameKey.setCred("accessid", "other secret", "");
+
+    S3Params otherKey = params;
+    otherKey.setCred("other accessid", "secret", "");
+
+    EXPECT_EQ(0u, KeyListCachePath(params).find("/tmp/gpcloud_list_"));
+    EXPECT_EQ(KeyListCachePath(params), KeyListCachePath(sameKey));
+    EXPECT_NE(KeyListCachePath(params), KeyListCachePath(otherKey));
+}
+
 // ================== S3BucketReaderTest ===================
 
 class S3BucketReaderTest : public testing::Test {
@@ -27,6 +339,9 @@ class S3BucketReaderTest : public testing::Test {
 
         bucketReader = new S3BucketReader();
         bucketReader->setS3InterfaceService(&s3Interface);
+
+        ON_CALL(s3Interface, checkCompressionType(_))
+            .WillByDefault(Return(S3_COMPRESSION_PLAIN));
     }
 
     // TearDown() is invoked immediately after a test finishes.
@@ -41,7 +356,7 @@ class S3BucketReaderTest : public testing::Test {
     }
 
     S3BucketReader* bucketReader;
-    char buf[64];
+    char buf[1024];
 
     MockS3Interface s3Interface;
     MockS3Reader s3Reader;
@@ -148,6 +463,115 @@ TEST_F(S3BucketReaderTest, ReaderShouldSkipIfFileIsNotForThisSegment) {
     EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
 }
 
+TEST_F(S3BucketReaderTest, ReadRangeOfHugeKey) {
+    ListBucketResult result;
+    result.contents.emplace_back("huge", 1000);
+    result.contents.emplace_back("small", 10);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    s3ext_segid = 1;
+    s3ext_segnum = 2;
+
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges()[0].keyIndex);
+    EXPECT_EQ((uint64_t)500, bucketReader->getKeyRanges()[0].start);
+    EXPECT_EQ((uint64_t)1000, bucketReader->getKeyRanges()[0].end);
+}
+
+TEST_F(S3BucketReaderTest, NoSplitOfCSVKey) {
+    ListBucketResult result;
+    result.contents.emplace_back("huge", 1000);
+    result.contents.emplace_back("small", 10);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    S3ScanDesc scanDesc;
+    scanDesc.csv = true;
+    params.setScanDesc(scanDesc);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    s3ext_segid = 0;
+    s3ext_segnum = 2;
+
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges()[0].keyIndex);
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges()[0].start);
+    EXPECT_EQ((uint64_t)1000, bucketReader->getKeyRanges()[0].end);
+}
+
+TEST_F(S3BucketReaderTest, ReadRangeOfCSVKeyWithSplitCsv) {
+    ListBucketResult result;
+    result.contents.emplace_back("huge", 1000);
+    result.contents.emplace_back("small", 10);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    S3ScanDesc scanDesc;
+    scanDesc.csv = true;
+    params.setScanDesc(scanDesc);
+    params.setSplitCsv(true);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    s3ext_segid = 1;
+    s3ext_segnum = 2;
+
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges()[0].keyIndex);
+    EXPECT_EQ((uint64_t)500, bucketReader->getKeyRanges()[0].start);
+    EXPECT_EQ((uint64_t)1000, bucketReader->getKeyRanges()[0].end);
+}
+
+TEST_F(S3BucketReaderTest, NoSplitOfCompressedKey) {
+    ListBucketResult result;
+    result.contents.emplace_back("huge.gz", 1000);
+    result.contents.emplace_back("small", 10);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_GZIP));
+
+    s3ext_segid = 0;
+    s3ext_segnum = 2;
+
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges()[0].keyIndex);
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges()[0].start);
+    EXPECT_EQ((uint64_t)1000, bucketReader->getKeyRanges()[0].end);
+}
+
+TEST_F(S3BucketReaderTest, ReadRangeOfCompressedKeyWithSplitCompressed) {
+    ListBucketResult result;
+    result.contents.emplace_back("huge.gz", 1000);
+    result.contents.emplace_back("small", 10);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitCompressed(true);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_GZIP));
+
+    s3ext_segid = 1;
+    s3ext_segnum = 2;
+
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_EQ((uint64_t)500, bucketReader->getKeyRanges()[0].start);
+    EXPECT_EQ((uint64_t)1000, bucketReader->getKeyRanges()[0].end);
+}
+
 TEST_F(S3BucketReaderTest, UpstreamReaderThrowException) {
     ListBucketResult result;
     result.contents.emplace_back("foo", 0);
@@ -285,3 +709,161 @@ TEST_F(S3BucketReaderTest, ReadBucketFileWithHeaderAndFuzyMatch) {
     eolString[0] = '\n';
     eolString[1] = '\0';
 }
+
+TEST_F(S3BucketReaderTest, ReadBucketFileWithQuotedNewlineInCSVHeader) {
+    hasHeader = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 10);
+    result.contents.emplace_back("bar", 10);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    EXPECT_CALL(s3Reader, read(_, _))
+        .WillOnce(Invoke(MockRead("\"a\nb\",c\n1\n")))
+        .WillOnce(Return(0))
+        .WillOnce(Invoke(MockRead("\"a\nb\",c\n2\n")))
+        .WillOnce(Return(0));
+
+    EXPECT_CALL(s3Reader, open(_)).Times(2);
+
+    s3ext_segid = 0;
+    s3ext_segnum = 1;
+    S3ScanDesc scanDesc;
+    scanDesc.csv = true;
+    scanDesc.escape = '"';
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setScanDesc(scanDesc);
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)10, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ((uint64_t)2, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, memcmp(buf, "2\n", 2));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    // reset to test following tests
+    hasHeader = false;
+}
+
+TEST_F(S3BucketReaderTest, ReadRangeOfKeyWithHeader) {
+    hasHeader = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("huge", 1000);
+    result.contents.emplace_back("small", 10);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    EXPECT_CALL(s3Reader, read(_, _))
+        .WillOnce(Invoke(MockRead("abc\ndef\n")))
+        .WillOnce(Return(0));
+
+    EXPECT_CALL(s3Reader, open(_)).Times(1);
+
+    s3ext_segid = 1;
+    s3ext_segnum = 2;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_EQ((uint64_t)500, bucketReader->getKeyRanges()[0].start);
+
+    // the range has no header line, an empty line is skipped as the header of the segment.
+    EXPECT_EQ((uint64_t)1, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ('\n', buf[0]);
+    EXPECT_EQ((uint64_t)8, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, memcmp(buf, "abc\ndef\n", 8));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    // reset to test following tests
+    hasHeader = false;
+}
+
+TEST_F(S3BucketReaderTest, NoSplitOfKeyWithHeaderForS3Select) {
+    hasHeader = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("huge", 1000);
+    result.contents.emplace_back("small", 10);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    s3ext_segid = 0;
+    s3ext_segnum = 2;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setS3Select(true);
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges()[0].start);
+    EXPECT_EQ((uint64_t)1000, bucketReader->getKeyRanges()[0].end);
+
+    // reset to test following tests
+    hasHeader = false;
+}
+
+// Return the name of the opened key as its content, and log the order keys are opened in.
+class KeyNameReader : public Reader {
+   public:
+    KeyNameReader(vector<string>& log) : openLog(log), offset(0) {
+    }
+    void open(const S3Params& params) {
+        this->name = params.getS3Url().getPrefix();
+        this->offset = 0;
+        this->openLog.push_back(this->name);
+    }
+    uint64_t read(char* buf, uint64_t count) {
+        uint64_t len = std::min(count, (uint64_t)(this->name.size() - this->offset));
+        memcpy(buf, this->name.data() + this->offset, len);
+        this->offset += len;
+        return len;
+    }
+    void close() {
+    }
+
+   private:
+    vector<string>& openLog;
+    string name;
+    uint64_t offset;
+};
+
+TEST_F(S3BucketReaderTest, ReadBucketWithLookaheadReader) {
+    ListBucketResult result;
+    result.contents.emplace_back("key0", 4);
+    result.contents.emplace_back("key1", 4);
+    result.contents.emplace_back("key2", 4);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    vector<string> openLog;
+    KeyNameReader upstream(openLog);
+    KeyNameReader lookahead(openLog);
+
+    s3ext_segid = 0;
+    s3ext_segnum = 1;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&upstream);
+    bucketReader->setLookaheadReaders(vector<Reader*>(1, &lookahead));
+
+    // the next key is opened as soon as the first one is.
+    EXPECT_EQ((uint64_t)4, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, strncmp(buf, "key0", 4));
+    ASSERT_EQ((size_t)2, openLog.size());
+    EXPECT_EQ("key1", openLog[1]);
+
+    // the reader of key0 is reused for key2.
+    EXPECT_EQ((uint64_t)4, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, strncmp(buf, "key1", 4));
+    ASSERT_EQ((size_t)3, openLog.size());
+    EXPECT_EQ("key2", openLog[2]);
+
+    EXPECT_EQ((uint64_t)4, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, strncmp(buf, "key2", 4));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ((size_t)3, openLog.size());
+
+    bucketReader->close();
+}
@@ -19,9 +19,65 @@ class MockS3InterfaceForCompressionRead : public MockS3Interface {
         return data.size();
     }
 
+    // serve ranged GETs of the key in data.
+    uint64_t mockFetchRange(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                            const S3Url &s3Url) {
+        data.assign(this->data.begin() + offset, this->data.begin() + offset + len);
+        return len;
+    }
+
     S3VectorUInt8 data;
 };
 
+// Compress data into BGZF blocks of at most blockInputSize bytes of input each.
+static string compressBGZF(const string &data, uint64_t blockInputSize) {
+    string result;
+
+    for (uint64_t pos = 0; pos < data.size(); pos += blockInputSize) {
+        uint64_t len = std::min(blockInputSize, data.size() - pos);
+
+        z_stream zstream;
+        zstream.zalloc = Z_NULL;
+        zstream.zfree = Z_NULL;
+        zstream.opaque = Z_NULL;
+        deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY);
+
+        vector<char> deflated(deflateBound(&zstream, len));
+        zstream.next_in = (Byte *)data.data() + pos;
+        zstream.avail_in = len;
+        zstream.next_out = (Byte *)deflated.data();
+        zstream.avail_out = deflated.size();
+        deflate(&zstream, Z_FINISH);
+        uint64_t deflatedLen = deflated.size() - zstream.avail_out;
+        deflateEnd(&zstream);
+
+        uint64_t blockSize = S3_BGZF_HEADER_LEN + deflatedLen + 8;
+        uint32_t crc = crc32(0, (const Byte *)data.data() + pos, len);
+
+        const char header[] = {0x1f, (char)0x8b, 8, 4, 0, 0, 0, 0,
+                               0, (char)0xff, 6, 0, 'B', 'C', 2, 0};
+        result.append(header, sizeof(header));
+        result.push_back((char)((blockSize - 1) & 0xff));
+        result.push_back((char)((blockSize - 1) >> 8));
+        result.append(deflated.data(), deflatedLen);
+        for (int i = 0; i < 4; i++) {
+            result.push_back((char)((crc >> (8 * i)) & 0xff));
+        }
+        for (int i = 0; i < 4; i++) {
+            result.push_back((char)((len >> (8 * i)) & 0xff));
+        }
+    }
+
+    return result;
+}
+
+static void appendLittleEndian32(string &data, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        data.push_back((char)((value >> (8 * i)) & 0xff));
+    }
+}
+
 class S3CommonReaderTest : public ::testing::Test, public S3CommonReader {
    protected:
     // Remember that SetUp() is run immediately before a test starts.
@@ -61,6 +117,21 @@ TEST_F(S3CommonReaderTest, OpenPlain) {
     ASSERT_TRUE(NULL != dynamic_cast<S3KeyReader *>(this->upstreamReader));
 }
 
+TEST_F(S3CommonReaderTest, SkipRangeOfGZipKey) {
+    // compressed key can't be split, only the range starting at 0 reads it.
+    EXPECT_CALL(mockS3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_GZIP));
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setChunkSize(1024 * 1024 * 2);
+    params.setKeySize(1024);
+    params.setKeyRange(512, 1024);
+    this->open(params);
+
+    char buf[0x100];
+    ASSERT_TRUE(NULL == this->upstreamReader);
+    EXPECT_EQ((uint64_t)0, this->read(buf, sizeof(buf)));
+}
+
 TEST_F(S3CommonReaderTest, ReadGZip) {
     Byte compressionBuff[0x100];
     uLong compressedLen = sizeof(compressionBuff);
@@ -86,3 +157,264 @@ TEST_F(S3CommonReaderTest, ReadGZip) {
     EXPECT_EQ((uint64_t)0, this->upstreamReader->read(result, sizeof(result)));
     EXPECT_EQ(0, memcmp(result, hello, sizeof(hello)));
 }
+
+TEST_F(S3CommonReaderTest, OpenS3Select) {
+    EXPECT_CALL(mockS3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+    S3Params params("s3://abc/def");
+    params.setChunkSize(1024 * 1024 * 2);
+    params.setS3Select(true);
+
+    S3ScanDesc scanDesc;
+    scanDesc.csv = true;
+    scanDesc.columns = {"id", "name"};
+    scanDesc.projected = {true, false};
+    params.setScanDesc(scanDesc);
+    this->open(params);
+
+    ASSERT_EQ(this->upstreamReader, &this->selectReader);
+}
+
+TEST_F(S3CommonReaderTest, OpenS3SelectWithoutPushDown) {
+    // nothing to filter for a TEXT table, keys are read as usual.
+    EXPECT_CALL(mockS3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setChunkSize(1024 * 1024 * 2);
+    params.setS3Select(true);
+
+    S3ScanDesc scanDesc;
+    scanDesc.columns = {"id", "name"};
+    scanDesc.projected = {true, false};
+    params.setScanDesc(scanDesc);
+    this->open(params);
+
+    ASSERT_EQ(this->upstreamReader, &this->keyReader);
+}
+
+TEST_F(S3CommonReaderTest, ReadSmallPlainKey) {
+    // a small key is fetched with a single GET, without probing its magic bytes.
+    const char hello[] = "The quick brown fox jumps over the lazy dog\n";
+    mockS3Interface.setData((Byte *)hello, strlen(hello));
+
+    EXPECT_CALL(mockS3Interface, checkCompressionType(_)).Times(0);
+    EXPECT_CALL(mockS3Interface, fetchData(0, _, strlen(hello), _))
+        .WillOnce(Invoke(&mockS3Interface, &MockS3InterfaceForCompressionRead::mockFetchData));
+
+    char result[0x100];
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setChunkSize(1024 * 1024 * 2);
+    params.setSmallKeySize(1024);
+    params.setKeySize(strlen(hello));
+    this->open(params);
+
+    EXPECT_EQ(strlen(hello), this->read(result, sizeof(result)));
+    EXPECT_EQ(this->upstreamReader, &this->smallKeyReader);
+    EXPECT_EQ(0, memcmp(result, hello, strlen(hello)));
+    EXPECT_EQ((uint64_t)0, this->read(result, sizeof(result)));
+}
+
+TEST_F(S3CommonReaderTest, ReadSmallGZipKey) {
+    Byte compressionBuff[0x100];
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+
+    // gzip format, so that it is detected from the magic bytes.
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                 Z_DEFAULT_STRATEGY);
+    zstream.next_in = (Byte *)hello;
+    zstream.avail_in = sizeof(hello);
+    zstream.next_out = compressionBuff;
+    zstream.avail_out = sizeof(compressionBuff);
+    deflate(&zstream, Z_FINISH);
+    uLong compressedLen = sizeof(compressionBuff) - zstream.avail_out;
+    deflateEnd(&zstream);
+
+    mockS3Interface.setData(compressionBuff, compressedLen);
+
+    EXPECT_CALL(mockS3Interface, checkCompressionType(_)).Times(0);
+    EXPECT_CALL(mockS3Interface, fetchData(_, _, _, _))
+        .WillOnce(Invoke(&mockS3Interface, &MockS3InterfaceForCompressionRead::mockFetchData));
+
+    char result[0x100];
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setChunkSize(1024 * 1024 * 2);
+    params.setSmallKeySize(1024);
+    params.setKeySize(compressedLen);
+    this->open(params);
+
+    EXPECT_EQ(sizeof(hello), this->read(result, sizeof(result)));
+    EXPECT_EQ(this->upstreamReader, &this->decompressReader);
+    EXPECT_EQ((uint64_t)0, this->read(result, sizeof(result)));
+    EXPECT_EQ(0, memcmp(result, hello, sizeof(hello)));
+}
+
+TEST_F(S3CommonReaderTest, OpenRangeOfSmallKey) {
+    // a range of a key is read as usual.
+    EXPECT_CALL(mockS3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setChunkSize(1024 * 1024 * 2);
+    params.setSmallKeySize(1024 * 1024);
+    params.setKeySize(1024);
+    params.setKeyRange(512, 1024);
+    EXPECT_CALL(mockS3Interface, fetchData(_, _, _, _)).WillRepeatedly(Return(0));
+    this->open(params);
+
+    ASSERT_EQ(this->upstreamReader, &this->keyReader);
+}
+
+class S3CommonReaderSplitTest : public S3CommonReaderTest {
+   protected:
+    void setKey(const string &key) {
+        this->keySize = key.size();
+        mockS3Interface.setData((Byte *)key.data(), key.size());
+        EXPECT_CALL(mockS3Interface, checkCompressionType(_))
+            .WillRepeatedly(Return(S3_COMPRESSION_GZIP));
+        EXPECT_CALL(mockS3Interface, fetchData(_, _, _, _))
+            .WillRepeatedly(
+                Invoke(&mockS3Interface, &MockS3InterfaceForCompressionRead::mockFetchRange));
+    }
+
+    string readRange(uint64_t start, uint64_t end) {
+        S3Params params("s3://abc/def");
+        params.setNumOfChunks(2);
+        params.setChunkSize(4096);
+        params.setKeySize(this->keySize);
+        params.setKeyRange(start, end);
+        params.setSplitCompressed(true);
+
+        this->close();
+        this->open(params);
+
+        string result;
+        char buf[1000];
+        uint64_t count = 0;
+        while ((count = this->read(buf, sizeof(buf))) != 0) {
+            result.append(buf, count);
+        }
+        return result;
+    }
+
+    uint64_t keySize;
+};
+
+TEST_F(S3CommonReaderSplitTest, ReadRangesOfBGZFKey) {
+    string text;
+    for (int i = 0; i < 2000; i++) {
+        text += "row " + std::to_string(i * 7919) + ",abcdefghijklmnopqrstuvwxyz\n";
+    }
+    string key = compressBGZF(text, 1000);
+    setKey(key);
+
+    // every line is read once, by the range of the block where it starts.
+    uint64_t bounds[] = {0, 1, key.size() / 3, key.size() / 3 + 5, key.size() / 2, key.size()};
+    string result;
+    for (size_t i = 0; i + 1 < sizeof(bounds) / sizeof(bounds[0]); i++) {
+        string part = readRange(bounds[i], bounds[i + 1]);
+        ASSERT_TRUE(part.empty() || (*part.rbegin() == '\n'));
+        result += part;
+        EXPECT_EQ(this->upstreamReader, &this->splitReader);
+    }
+
+    EXPECT_EQ(text.size(), result.size());
+    EXPECT_TRUE(text == result);
+}
+
+TEST_F(S3CommonReaderSplitTest, ReadRangesOfLongLines) {
+    // lines span several blocks, and some blocks have no line starting in them.
+    string text;
+    for (int i = 0; i < 20; i++) {
+        text += string(2500 + i * 100, 'a' + i) + "\n";
+    }
+    string key = compressBGZF(text, 1000);
+    setKey(key);
+
+    string result;
+    uint64_t step = key.size() / 7;
+    for (uint64_t start = 0; start < key.size(); start += step) {
+        result += readRange(start, std::min(start + step, key.size()));
+    }
+
+    EXPECT_TRUE(text == result);
+}
+
+TEST_F(S3CommonReaderSplitTest, ReadRangeOfPlainGZipKey) {
+    // members of a plain gzip key can't be located, the first range reads the whole key.
+    string text = "The quick brown fox jumps over the lazy dog\n";
+    Byte compressed[0x100];
+
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                 Z_DEFAULT_STRATEGY);
+    zstream.next_in = (Byte *)text.data();
+    zstream.avail_in = text.size();
+    zstream.next_out = compressed;
+    zstream.avail_out = sizeof(compressed);
+    deflate(&zstream, Z_FINISH);
+    uint64_t compressedLen = sizeof(compressed) - zstream.avail_out;
+    deflateEnd(&zstream);
+
+    setKey(string((const char *)compressed, compressedLen));
+
+    EXPECT_EQ(text, readRange(0, compressedLen / 2));
+    EXPECT_EQ(this->upstreamReader, &this->decompressReader);
+    EXPECT_EQ("", readRange(compressedLen / 2, compressedLen));
+}
+
+TEST_F(S3CommonReaderSplitTest, LocateFramesOfZstdSeekableKey) {
+    // frames of 100, 200 and 300 bytes, followed by the seek table with checksums.
+    string key(600, 'x');
+    string table;
+    appendLittleEndian32(table, S3_ZSTD_SKIPPABLE_MAGIC);
+    appendLittleEndian32(table, 3 * 12 + S3_ZSTD_SEEK_FOOTER_LEN);
+    for (uint32_t i = 1; i <= 3; i++) {
+        appendLittleEndian32(table, i * 100);
+        appendLittleEndian32(table, i * 1000);
+        appendLittleEndian32(table, 0);
+    }
+    appendLittleEndian32(table, 3);
+    table.push_back((char)0x80);
+    appendLittleEndian32(table, S3_ZSTD_SEEKABLE_MAGIC);
+    key += table;
+    setKey(key);
+
+    S3Params params("s3://abc/def");
+    params.setKeySize(key.size());
+
+    uint64_t memberStart = 0;
+    uint64_t memberEnd = 0;
+    params.setKeyRange(50, 300);
+    EXPECT_TRUE(LocateCompressedMembers(&mockS3Interface, params, S3_COMPRESSION_ZSTD,
+                                        &memberStart, &memberEnd));
+    EXPECT_EQ((uint64_t)100, memberStart);
+    EXPECT_EQ((uint64_t)300, memberEnd);
+
+    params.setKeyRange(301, key.size());
+    EXPECT_TRUE(LocateCompressedMembers(&mockS3Interface, params, S3_COMPRESSION_ZSTD,
+                                        &memberStart, &memberEnd));
+    EXPECT_EQ((uint64_t)600, memberStart);
+    EXPECT_EQ((uint64_t)key.size(), memberEnd);
+}
+
+TEST_F(S3CommonReaderSplitTest, LocateFramesOfZstdKeyWithoutSeekTable) {
+    setKey(string(600, 'x'));
+
+    S3Params params("s3://abc/def");
+    params.setKeySize(600);
+    params.setKeyRange(50, 300);
+
+    uint64_t memberStart = 0;
+    uint64_t memberEnd = 0;
+    EXPECT_FALSE(LocateCompressedMembers(&mockS3Interface, params, S3_COMPRESSION_ZSTD,
+                                         &memberStart, &memberEnd));
+    EXPECT_FALSE(LocateCompressedMembers(&mockS3Interface, params, S3_COMPRESSION_LZ4,
+                                         &memberStart, &memberEnd));
+}
@@ -36,14 +36,15 @@ class MockS3InterfaceForCompressionWrite : public MockS3Interface {
     }
 
     string mockUploadPartOfData(S3VectorUInt8 &data, const S3Url &s3Url, uint64_t partNumber,
-                                const string &uploadId) {
+                                const string &uploadId, const string &checksum) {
         UniqueLock uniqueLock(&this->lock);
         this->dataMap[partNumber] = data;
         return this->uploadID;
     }
 
     bool mockCompleteMultiPart(const S3Url &s3Url, const string &uploadId,
-                               const vector<string> &etagArray) {
+                               const vector<string> &etagArray,
+                               const vector<string> &checksumArray) {
         map<uint64_t, S3VectorUInt8>::iterator it;
         for (it = this->dataMap.begin(); it != this->dataMap.end(); it++) {
             this->data.insert(this->data.end(), it->second.begin(), it->second.end());
@@ -109,10 +110,10 @@ class S3CommonWriteTest : public ::testing::Test, public S3CommonWriter {
 TEST_F(S3CommonWriteTest, UsingGZip) {
     EXPECT_CALL(mockS3Interface, getUploadId(_))
         .WillOnce(Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockGetUploadId));
-    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _))
+    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _, _))
         .WillOnce(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockUploadPartOfData));
-    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _))
+    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _, _))
         .WillOnce(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockCompleteMultiPart));
 
@@ -146,10 +147,10 @@ TEST_F(S3CommonWriteTest, UsingPlain) {
 TEST_F(S3CommonWriteTest, WritePlainData) {
     EXPECT_CALL(mockS3Interface, getUploadId(_))
         .WillOnce(Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockGetUploadId));
-    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _))
+    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _, _))
         .WillOnce(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockUploadPartOfData));
-    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _))
+    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _, _))
         .WillOnce(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockCompleteMultiPart));
 
@@ -171,10 +172,10 @@ TEST_F(S3CommonWriteTest, WritePlainData) {
 TEST_F(S3CommonWriteTest, WriteGZipData) {
     EXPECT_CALL(mockS3Interface, getUploadId(_))
         .WillOnce(Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockGetUploadId));
-    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _))
+    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _, _))
         .WillOnce(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockUploadPartOfData));
-    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _))
+    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _, _))
         .WillOnce(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockCompleteMultiPart));
 
@@ -199,10 +200,10 @@ TEST_F(S3CommonWriteTest, WriteGZipDataMultipleTimes) {
     EXPECT_CALL(mockS3Interface, getUploadId(_))
         .WillRepeatedly(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockGetUploadId));
-    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _))
+    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _, _))
         .WillRepeatedly(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockUploadPartOfData));
-    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _))
+    EXPECT_CALL(mockS3Interface, completeMultiPart(_, _, _, _))
         .WillRepeatedly(
             Invoke(&mockS3Interface, &MockS3InterfaceForCompressionWrite::mockCompleteMultiPart));
 
@@ -33,8 +33,37 @@ TEST(Config, Basic) {
 
     EXPECT_EQ("", params.getProxy());
 
+    EXPECT_EQ("", params.getListCacheDir());
+    EXPECT_EQ((uint64_t)60, params.getListCacheTTL());
+    EXPECT_EQ((uint64_t)1, params.getListParallelism());
+    EXPECT_EQ("", params.getListShardPrefixes());
+
+    EXPECT_EQ("", params.getReadCacheDir());
+    EXPECT_EQ((uint64_t)1024 * 1024 * 1024, params.getReadCacheSize());
+
     EXPECT_TRUE(params.isAutoCompress());
     EXPECT_TRUE(params.isVerifyCert());
+    EXPECT_FALSE(params.isAdaptiveDownload());
+    EXPECT_FALSE(params.isMultiplexIO());
+    EXPECT_FALSE(params.isHedgedFetch());
+    EXPECT_FALSE(params.isS3Select());
+    EXPECT_FALSE(params.isConditionalWrite());
+    EXPECT_FALSE(params.isMemoryPoolHugePages());
+    EXPECT_FALSE(params.isSplitCompressed());
+    EXPECT_FALSE(params.isSplitCsv());
+    EXPECT_FALSE(params.isCrc32cChecksum());
+    EXPECT_EQ((uint64_t)100, params.getRetryBackoff());
+    EXPECT_EQ((uint64_t)0, params.getRequestRate());
+    EXPECT_EQ("/tmp", params.getRequestRateDir());
+    EXPECT_EQ((uint64_t)0, params.getRolloverSize());
+    EXPECT_EQ((uint64_t)0, params.getPrefetchKeys());
+    EXPECT_EQ((uint64_t)1024 * 1024, params.getSmallKeySize());
+    EXPECT_EQ((uint64_t)0, params.getMemoryPoolSize());
+    EXPECT_EQ((uint64_t)60, params.getMemoryPoolIdleTime());
+    EXPECT_EQ((uint64_t)64 * 1024 * 1024, params.getRowGroupSize());
+    EXPECT_EQ((uint64_t)1024 * 1024, params.getRangeCoalesceGap());
+    EXPECT_EQ(S3_EXPORT_TEXT, params.getExportFormat());
+    EXPECT_EQ("gzip", params.getParquetCodec());
 
     EXPECT_EQ(SSE_S3, params.getSSEType());
 
@@ -73,6 +102,31 @@ TEST(Config, SpecialSwitches) {
 
     EXPECT_TRUE(params.isDebugCurl());
     EXPECT_FALSE(params.isAutoCompress());
+    EXPECT_TRUE(params.isAdaptiveDownload());
+    EXPECT_TRUE(params.isMultiplexIO());
+    EXPECT_TRUE(params.isHedgedFetch());
+    EXPECT_TRUE(params.isS3Select());
+    EXPECT_TRUE(params.isConditionalWrite());
+    EXPECT_TRUE(params.isMemoryPoolHugePages());
+    EXPECT_TRUE(params.isSplitCompressed());
+    EXPECT_TRUE(params.isSplitCsv());
+    EXPECT_TRUE(params.isCrc32cChecksum());
+    EXPECT_EQ((uint64_t)0, params.getRetryBackoff());
+    EXPECT_EQ((uint64_t)3500, params.getRequestRate());
+    EXPECT_EQ("/tmp/gpcloud_rate", params.getRequestRateDir());
+    EXPECT_EQ((uint64_t)256 * 1024 * 1024, params.getRolloverSize());
+    EXPECT_EQ((uint64_t)1, params.getPrefetchKeys());
+    EXPECT_EQ((uint64_t)0, params.getSmallKeySize());
+    EXPECT_EQ((uint64_t)512 * 1024 * 1024, params.getMemoryPoolSize());
+    EXPECT_EQ((uint64_t)10, params.getMemoryPoolIdleTime());
+    EXPECT_EQ((uint64_t)8 * 1024 * 1024, params.getRowGroupSize());
+    EXPECT_EQ((uint64_t)0, params.getRangeCoalesceGap());
+    EXPECT_EQ(S3_EXPORT_PARQUET, params.getExportFormat());
+    EXPECT_EQ("none", params.getParquetCodec());
+    EXPECT_EQ("/tmp/gpcloud_read_cache", params.getReadCacheDir());
+    EXPECT_EQ((uint64_t)16 * 1024 * 1024, params.getReadCacheSize());
+    EXPECT_EQ((uint64_t)16, params.getListParallelism());
+    EXPECT_EQ("0,4,8,c", params.getListShardPrefixes());
 }
 
 TEST(Config, SectionExist) {
@@ -121,3 +175,52 @@ TEST(Config, Gpcheckcloud_eol) {
         InitConfig("s3://abc/a config=data/s3test.conf section=gpcheckcloud_newline_error"),
         S3ConfigError);
 }
+
+TEST(Config, Inventory) {
+    S3Params params = InitConfig("s3://abc/a config=data/s3test.conf section=default");
+    EXPECT_EQ("", params.getInventoryManifest());
+
+    params = InitConfig(
+        "s3://abc/a config=data/s3test.conf inventory=s3://inv/abc/daily/manifest.json "
+        "modified_after=2024-01-01T00:00:00Z modified_before=2024-02-01");
+    EXPECT_EQ("s3://inv/abc/daily/manifest.json", params.getInventoryManifest());
+    EXPECT_EQ("2024-01-01T00:00:00Z", params.getInventoryModifiedAfter());
+    EXPECT_EQ("2024-02-01", params.getInventoryModifiedBefore());
+
+    EXPECT_THROW(InitConfig("s3://abc/a config=data/s3test.conf modified_after=2024-01-01"),
+                 S3ConfigError);
+}
+
+static void WriteConfigFile(const string &path, const string &content) {
+    FILE *fp = fopen(path.c_str(), "w");
+    ASSERT_TRUE(fp != NULL);
+    fputs(content.c_str(), fp);
+    fclose(fp);
+}
+
+TEST(Config, CachedUntilFileChanged) {
+    char dirTemplate[] = "/tmp/gpcloud_conf_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dirTemplate) != NULL);
+    string path = string(dirTemplate) + "/s3.conf";
+    string url = "s3://abc/a config=" + path;
+
+    WriteConfigFile(path, "[default]\naccessid = id\nsecret = key\nthreadnum = 2\nloglevel = DEBUG\n");
+    S3Params params = InitConfig(url);
+    EXPECT_EQ((uint64_t)2, params.getNumOfChunks());
+
+    // the log settings of the location are set again when the cached one is used.
+    s3ext_loglevel = EXT_WARNING;
+    params = InitConfig(url);
+    EXPECT_EQ((uint64_t)2, params.getNumOfChunks());
+    EXPECT_EQ(EXT_DEBUG, s3ext_loglevel);
+
+    WriteConfigFile(path, "[default]\naccessid = id\nsecret = key\nthreadnum = 5\nloglevel = DEBUG\n\n");
+    params = InitConfig(url);
+    EXPECT_EQ((uint64_t)5, params.getNumOfChunks());
+
+    unlink(path.c_str());
+    EXPECT_THROW(InitConfig(url), S3RuntimeError);
+
+    rmdir(dirTemplate);
+    ClearConfigCache();
+}
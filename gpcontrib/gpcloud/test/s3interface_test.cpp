@@ -5,6 +5,7 @@
 
 using ::testing::_;
 using ::testing::AtLeast;
+using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::Throw;
 
@@ -122,6 +123,30 @@ TEST_F(S3InterfaceServiceTest, PutResponseWithRetriesAndSuccess) {
     EXPECT_EQ(RESPONSE_OK, this->putResponseWithRetries(url, headers, data).getStatus());
 }
 
+TEST_F(S3InterfaceServiceTest, CountRequestsRetriesAndBytes) {
+    string url = "https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever";
+    HTTPHeaders headers;
+
+    S3VectorUInt8 data(16);
+    vector<uint8_t> raw(32);
+
+    EXPECT_CALL(mockRESTfulService, put(_, _, _))
+        .Times(2)
+        .WillOnce(Throw(S3ConnectionError("")))
+        .WillOnce(Return(Response(RESPONSE_OK)));
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(Response(RESPONSE_OK, raw)));
+
+    GetS3IOStats().reset();
+    this->putResponseWithRetries(url, headers, data);
+    this->getResponseWithRetries(url, headers);
+
+    EXPECT_EQ(3u, GetS3IOStats().get(S3IO_REQUESTS));
+    EXPECT_EQ(1u, GetS3IOStats().get(S3IO_RETRIES));
+    EXPECT_EQ(16u, GetS3IOStats().get(S3IO_BYTES_UPLOADED));
+    EXPECT_EQ(32u, GetS3IOStats().get(S3IO_BYTES_DOWNLOADED));
+    GetS3IOStats().reset();
+}
+
 TEST_F(S3InterfaceServiceTest, HeadResponseWithZeroRetry) {
     string url = "https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever";
     HTTPHeaders headers;
@@ -231,6 +256,25 @@ TEST_F(S3InterfaceServiceTest, ListBucketWithNormalBucket) {
     EXPECT_EQ((uint64_t)1, result.contents.size());
 }
 
+TEST_F(S3InterfaceServiceTest, ListBucketWithETag) {
+    XMLGenerator generator;
+    XMLGenerator *gen = &generator;
+    gen->setName("s3test.pivotal.io")
+        ->setPrefix("threebytes/")
+        ->setIsTruncated(false)
+        ->pushBuckentContent(BucketContent("threebytes/threebytes", 3, "&quot;a1b2&quot;"))
+        ->pushBuckentContent(BucketContent("threebytes/noetag", 3));
+
+    Response response(RESPONSE_OK, gen->toXML());
+
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    result = this->listBucket(this->params.getS3Url());
+    ASSERT_EQ((uint64_t)2, result.contents.size());
+    EXPECT_EQ("\"a1b2\"", result.contents[0].getETag());
+    EXPECT_EQ("", result.contents[1].getETag());
+}
+
 TEST_F(S3InterfaceServiceTest, ListBucketWithBucketWith1000Keys) {
     EXPECT_CALL(mockRESTfulService, get(_, _))
         .WillOnce(Return(this->buildListBucketResponse(1000, false)));
@@ -323,6 +367,88 @@ TEST_F(S3InterfaceServiceTest, ListBucketWithNonRootXML) {
     EXPECT_THROW(this->listBucket(this->params.getS3Url()), S3LogicError);
 }
 
+static vector<uint8_t> ToBytes(const string &text) {
+    return vector<uint8_t>(text.begin(), text.end());
+}
+
+TEST_F(S3InterfaceServiceTest, ListBucketWithFullResponse) {
+    // elements not used by the listing are skipped, keys are unescaped.
+    string page1 =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<ListBucketResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">\n"
+        "  <Name>bucket</Name><Prefix>data/</Prefix><Marker></Marker><MaxKeys>2</MaxKeys>\n"
+        "  <IsTruncated>true</IsTruncated>\n"
+        "  <Contents><Key>data/a&amp;b</Key><LastModified>2016-01-01T00:00:00.000Z</LastModified>"
+        "<ETag>&quot;e1&quot;</ETag><Size>10</Size>"
+        "<Owner><ID>id</ID><DisplayName>Key</DisplayName></Owner>"
+        "<StorageClass>STANDARD</StorageClass></Contents>\n"
+        "  <CommonPrefixes><Prefix>data/sub/</Prefix></CommonPrefixes>\n"
+        "  <Contents><Key>data/c&lt;d</Key><Size>20</Size></Contents>\n"
+        "</ListBucketResult>";
+    string page2 =
+        "<ListBucketResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+        "<Name>bucket</Name><Prefix>data/</Prefix><IsTruncated>false</IsTruncated>"
+        "<Contents><Key>data/e</Key><Size>30</Size></Contents></ListBucketResult>";
+
+    EXPECT_CALL(mockRESTfulService, get(::testing::HasSubstr("?prefix=data%2F"), _))
+        .WillOnce(Return(Response(RESPONSE_OK, ToBytes(page1))));
+    EXPECT_CALL(mockRESTfulService,
+                get(::testing::HasSubstr("?marker=data%2Fc%3Cd&prefix=data%2F"), _))
+        .WillOnce(Return(Response(RESPONSE_OK, ToBytes(page2))));
+
+    S3Url s3Url("s3://s3-us-west-2.amazonaws.com/bucket/data/");
+    result = this->listBucket(s3Url);
+
+    EXPECT_EQ("bucket", result.Name);
+    EXPECT_EQ("data/", result.Prefix);
+    ASSERT_EQ((uint64_t)3, result.contents.size());
+    EXPECT_EQ("data/a&b", result.contents[0].getName());
+    EXPECT_EQ((uint64_t)10, result.contents[0].getSize());
+    EXPECT_EQ("\"e1\"", result.contents[0].getETag());
+    EXPECT_EQ("data/c<d", result.contents[1].getName());
+    EXPECT_EQ("data/e", result.contents[2].getName());
+}
+
+TEST_F(S3InterfaceServiceTest, ListBucketWithUnguessedMarker) {
+    // the next page is requested after parsing if the marker can't be found in raw XML.
+    string page1 =
+        "<ListBucketResult><IsTruncated>true</IsTruncated>"
+        "<Contents><Key>a&#38;b</Key><Size>1</Size></Contents></ListBucketResult>";
+    string page2 =
+        "<ListBucketResult><IsTruncated>false</IsTruncated>"
+        "<Contents><Key>c</Key><Size>1</Size></Contents></ListBucketResult>";
+
+    EXPECT_CALL(mockRESTfulService, get(::testing::EndsWith("?"), _))
+        .WillOnce(Return(Response(RESPONSE_OK, ToBytes(page1))));
+    EXPECT_CALL(mockRESTfulService, get(::testing::EndsWith("?marker=a%26b"), _))
+        .WillOnce(Return(Response(RESPONSE_OK, ToBytes(page2))));
+
+    result = this->listBucket(this->params.getS3Url());
+
+    ASSERT_EQ((uint64_t)2, result.contents.size());
+    EXPECT_EQ("a&b", result.contents[0].getName());
+}
+
+TEST_F(S3InterfaceServiceTest, ListBucketWithMalformedXML) {
+    EXPECT_CALL(mockRESTfulService, get(_, _))
+        .WillOnce(Return(Response(RESPONSE_OK, ToBytes("<ListBucketResult><Contents>"))));
+
+    result = this->listBucket(this->params.getS3Url());
+    EXPECT_EQ((uint64_t)0, result.contents.size());
+}
+
+TEST(S3ListMarker, GuessFromRawXML) {
+    EXPECT_EQ("b&<c", GuessListMarker(Response(
+                          RESPONSE_OK, ToBytes("<IsTruncated>true</IsTruncated><Key>a</Key>"
+                                               "<Key>b&amp;&lt;c</Key><Size>1</Size>"))));
+    EXPECT_EQ("", GuessListMarker(Response(
+                      RESPONSE_OK, ToBytes("<IsTruncated>false</IsTruncated><Key>a</Key>"))));
+    EXPECT_EQ("", GuessListMarker(Response(
+                      RESPONSE_OK, ToBytes("<IsTruncated>true</IsTruncated><Key>&#97;</Key>"))));
+    EXPECT_EQ("",
+              GuessListMarker(Response(RESPONSE_OK, ToBytes("<IsTruncated>true</IsTruncated>"))));
+}
+
 TEST_F(S3InterfaceServiceTest, fetchDataRoutine) {
     vector<uint8_t> raw;
 
@@ -409,6 +535,34 @@ TEST_F(S3InterfaceServiceTest, checkItsGzipCompressed) {
     EXPECT_EQ(S3_COMPRESSION_GZIP, this->checkCompressionType(s3Url));
 }
 
+TEST_F(S3InterfaceServiceTest, checkItsZstdCompressed) {
+    vector<uint8_t> raw;
+    raw.resize(4);
+    raw[0] = 0x28;
+    raw[1] = 0xb5;
+    raw[2] = 0x2f;
+    raw[3] = 0xfd;
+    Response response(RESPONSE_OK, raw);
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    S3Url s3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    EXPECT_EQ(S3_COMPRESSION_ZSTD, this->checkCompressionType(s3Url));
+}
+
+TEST_F(S3InterfaceServiceTest, checkItsLZ4Compressed) {
+    vector<uint8_t> raw;
+    raw.resize(4);
+    raw[0] = 0x04;
+    raw[1] = 0x22;
+    raw[2] = 0x4d;
+    raw[3] = 0x18;
+    Response response(RESPONSE_OK, raw);
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    S3Url s3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    EXPECT_EQ(S3_COMPRESSION_LZ4, this->checkCompressionType(s3Url));
+}
+
 TEST_F(S3InterfaceServiceTest, checkItsNotCompressed) {
     vector<uint8_t> raw;
     raw.resize(4);
@@ -585,7 +739,7 @@ TEST_F(S3InterfaceServiceTest, uploadPartOfDataRoutine) {
     EXPECT_EQ("\"b54357faf0632cce46e942fa68356b38\"",
               this->uploadPartOfData(
                   raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), 11,
-                  "xyz"));
+                  "xyz", ""));
 }
 
 TEST_F(S3InterfaceServiceTest, uploadPartOfDataFailedResponse) {
@@ -595,7 +749,8 @@ TEST_F(S3InterfaceServiceTest, uploadPartOfDataFailedResponse) {
 
     EXPECT_THROW(
         this->uploadPartOfData(
-            raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), 11, "xyz"),
+            raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), 11, "xyz",
+            ""),
         S3FailedAfterRetry);
 }
 
@@ -620,7 +775,7 @@ TEST_F(S3InterfaceServiceTest, uploadPartOfDataErrorResponse) {
     S3VectorUInt8 data;
     EXPECT_THROW(this->uploadPartOfData(
                      data, S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"),
-                     11, "xyz"),
+                     11, "xyz", ""),
                  S3LogicError);
 }
 
@@ -632,7 +787,8 @@ TEST_F(S3InterfaceServiceTest, uploadPartOfDataAbortResponse) {
 
     EXPECT_THROW(
         this->uploadPartOfData(
-            raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), 11, "xyz"),
+            raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), 11, "xyz",
+            ""),
         S3QueryAbort);
 }
 
@@ -645,7 +801,8 @@ TEST_F(S3InterfaceServiceTest, completeMultiPartRoutine) {
     vector<string> etagArray = {"\"abc\"", "\"def\""};
 
     EXPECT_TRUE(this->completeMultiPart(
-        S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz", etagArray));
+        S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz", etagArray,
+        vector<string>()));
 }
 
 TEST_F(S3InterfaceServiceTest, completeMultiPartFailedResponse) {
@@ -657,7 +814,7 @@ TEST_F(S3InterfaceServiceTest, completeMultiPartFailedResponse) {
 
     EXPECT_THROW(this->completeMultiPart(
                      S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz",
-                     etagArray),
+                     etagArray, vector<string>()),
                  S3FailedAfterRetry);
 }
 
@@ -683,7 +840,7 @@ TEST_F(S3InterfaceServiceTest, completeMultiPartErrorResponse) {
 
     EXPECT_THROW(this->completeMultiPart(
                      S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz",
-                     etagArray),
+                     etagArray, vector<string>()),
                  S3LogicError);
 }
 
@@ -697,10 +854,252 @@ TEST_F(S3InterfaceServiceTest, completeMultiPartAbortResponse) {
 
     EXPECT_THROW(this->completeMultiPart(
                      S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz",
-                     etagArray),
+                     etagArray, vector<string>()),
                  S3QueryAbort);
 }
 
+class S3InterfaceServiceWithParams : public S3InterfaceService {
+   public:
+    S3InterfaceServiceWithParams(const S3Params &params) : S3InterfaceService(params) {
+    }
+
+    using S3InterfaceService::completeMultiPart;
+};
+
+static Response CheckIfNoneMatch(const string &url, HTTPHeaders &headers,
+                                 const vector<uint8_t> &data) {
+    const char *value = headers.Get(IF_NONE_MATCH);
+    EXPECT_TRUE(value != NULL);
+    EXPECT_STREQ("*", value);
+
+    return Response(RESPONSE_OK, vector<uint8_t>(100));
+}
+
+TEST(S3InterfaceService, completeMultiPartConditionalWrite) {
+    S3Params params("s3://a/a");
+    params.setConditionalWrite(true);
+
+    MockS3RESTfulService mockRESTfulService(params);
+    S3InterfaceServiceWithParams service(params);
+    service.setRESTfulService(&mockRESTfulService);
+
+    EXPECT_CALL(mockRESTfulService, post(_, _, _)).WillOnce(Invoke(CheckIfNoneMatch));
+
+    vector<string> etagArray = {"\"abc\""};
+    EXPECT_TRUE(service.completeMultiPart(
+        S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz", etagArray,
+        vector<string>()));
+}
+
+class S3InterfaceServiceParallelListTest : public testing::Test {
+   public:
+    S3InterfaceServiceParallelListTest()
+        : params("s3://a/a"),
+          mockRESTfulService(params),
+          s3Url("s3://s3-us-west-2.amazonaws.com/bucket/data/") {
+        this->params.setListParallelism(4);
+    }
+
+   protected:
+    void expectPage(const string &query, const string &xml) {
+        EXPECT_CALL(mockRESTfulService, get(::testing::EndsWith(query), _))
+            .WillOnce(Return(Response(RESPONSE_OK, ToBytes(xml))));
+    }
+
+    ListBucketResult listBucket() {
+        S3InterfaceServiceWithParams service(this->params);
+        service.setRESTfulService(&mockRESTfulService);
+        return service.listBucket(this->s3Url);
+    }
+
+    S3Params params;
+    MockS3RESTfulService mockRESTfulService;
+    S3Url s3Url;
+};
+
+TEST_F(S3InterfaceServiceParallelListTest, BySubdirectories) {
+    expectPage("?delimiter=%2F&prefix=data%2F",
+               "<ListBucketResult><Name>bucket</Name><Prefix>data/</Prefix>"
+               "<IsTruncated>true</IsTruncated><NextMarker>data/a/</NextMarker>"
+               "<Contents><Key>data/0</Key><Size>1</Size></Contents>"
+               "<CommonPrefixes><Prefix>data/a/</Prefix></CommonPrefixes></ListBucketResult>");
+    expectPage("?delimiter=%2F&marker=data%2Fa%2F&prefix=data%2F",
+               "<ListBucketResult><Name>bucket</Name><Prefix>data/</Prefix>"
+               "<IsTruncated>false</IsTruncated>"
+               "<CommonPrefixes><Prefix>data/b/</Prefix></CommonPrefixes>"
+               "<Contents><Key>data/c</Key><Size>3</Size></Contents></ListBucketResult>");
+    expectPage("?prefix=data%2Fa%2F",
+               "<ListBucketResult><Prefix>data/a/</Prefix><IsTruncated>false</IsTruncated>"
+               "<Contents><Key>data/a/1</Key><Size>1</Size></Contents>"
+               "<Contents><Key>data/a/2</Key><Size>2</Size></Contents></ListBucketResult>");
+    expectPage("?prefix=data%2Fb%2F",
+               "<ListBucketResult><Prefix>data/b/</Prefix><IsTruncated>false</IsTruncated>"
+               "<Contents><Key>data/b/1</Key><Size>1</Size></Contents></ListBucketResult>");
+
+    ListBucketResult result = this->listBucket();
+
+    EXPECT_EQ("bucket", result.Name);
+    EXPECT_EQ("data/", result.Prefix);
+    ASSERT_EQ((uint64_t)5, result.contents.size());
+    EXPECT_EQ("data/0", result.contents[0].getName());
+    EXPECT_EQ("data/a/1", result.contents[1].getName());
+    EXPECT_EQ("data/a/2", result.contents[2].getName());
+    EXPECT_EQ("data/b/1", result.contents[3].getName());
+    EXPECT_EQ("data/c", result.contents[4].getName());
+}
+
+TEST_F(S3InterfaceServiceParallelListTest, IntoSingleSubdirectory) {
+    expectPage("?delimiter=%2F&prefix=data%2F",
+               "<ListBucketResult><IsTruncated>false</IsTruncated>"
+               "<CommonPrefixes><Prefix>data/x/</Prefix></CommonPrefixes></ListBucketResult>");
+    expectPage("?delimiter=%2F&prefix=data%2Fx%2F",
+               "<ListBucketResult><IsTruncated>false</IsTruncated>"
+               "<Contents><Key>data/x/0</Key><Size>1</Size></Contents></ListBucketResult>");
+
+    ListBucketResult result = this->listBucket();
+
+    ASSERT_EQ((uint64_t)1, result.contents.size());
+    EXPECT_EQ("data/x/0", result.contents[0].getName());
+}
+
+TEST_F(S3InterfaceServiceParallelListTest, ByConfiguredPrefixes) {
+    this->params.setListShardPrefixes("m,,m");
+
+    // the part up to data/m stops at the first page past it.
+    expectPage("?prefix=data%2F",
+               "<ListBucketResult><Name>bucket</Name><IsTruncated>true</IsTruncated>"
+               "<Contents><Key>data/a</Key><Size>1</Size></Contents>"
+               "<Contents><Key>data/m</Key><Size>1</Size></Contents>"
+               "<Contents><Key>data/n</Key><Size>1</Size></Contents></ListBucketResult>");
+    expectPage("?marker=data%2Fm&prefix=data%2F",
+               "<ListBucketResult><Name>bucket</Name><IsTruncated>false</IsTruncated>"
+               "<Contents><Key>data/n</Key><Size>1</Size></Contents>"
+               "<Contents><Key>data/z</Key><Size>1</Size></Contents></ListBucketResult>");
+
+    ListBucketResult result = this->listBucket();
+
+    EXPECT_EQ("bucket", result.Name);
+    ASSERT_EQ((uint64_t)4, result.contents.size());
+    EXPECT_EQ("data/a", result.contents[0].getName());
+    EXPECT_EQ("data/m", result.contents[1].getName());
+    EXPECT_EQ("data/n", result.contents[2].getName());
+    EXPECT_EQ("data/z", result.contents[3].getName());
+}
+
+TEST_F(S3InterfaceServiceParallelListTest, FailedPart) {
+    this->params.setListShardPrefixes("m");
+
+    expectPage("?prefix=data%2F",
+               "<ListBucketResult><IsTruncated>false</IsTruncated>"
+               "<Contents><Key>data/a</Key><Size>1</Size></Contents></ListBucketResult>");
+    EXPECT_CALL(mockRESTfulService, get(::testing::EndsWith("?marker=data%2Fm&prefix=data%2F"), _))
+        .WillOnce(Return(Response(RESPONSE_ERROR, ToBytes("whatever"))));
+
+    EXPECT_THROW(this->listBucket(), S3LogicError);
+}
+
+static Response CheckPartChecksum(const string &url, HTTPHeaders &headers,
+                                  const S3VectorUInt8 &data) {
+    const char *value = headers.Get(X_AMZ_CHECKSUM_CRC32C);
+    EXPECT_TRUE(value != NULL);
+    EXPECT_STREQ("4waSgw==", value);
+
+    uint8_t raw[] = "ETag: \"abc\"\r\n";
+    return Response(RESPONSE_OK, vector<uint8_t>(raw, raw + sizeof(raw) - 1), S3VectorUInt8());
+}
+
+TEST_F(S3InterfaceServiceTest, uploadPartOfDataWithChecksum) {
+    string content = "123456789";
+    S3VectorUInt8 raw;
+    raw.insert(raw.end(), content.begin(), content.end());
+
+    EXPECT_CALL(mockRESTfulService, put(_, _, _)).WillOnce(Invoke(CheckPartChecksum));
+
+    EXPECT_EQ("\"abc\"",
+              this->uploadPartOfData(raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                                     1, "xyz", "4waSgw=="));
+}
+
+static Response CheckCompleteChecksums(const string &url, HTTPHeaders &headers,
+                                       const vector<uint8_t> &data) {
+    const char *value = headers.Get(X_AMZ_CHECKSUM_TYPE);
+    EXPECT_TRUE(value != NULL);
+    EXPECT_STREQ("FULL_OBJECT", value);
+
+    string body(data.begin(), data.end());
+    EXPECT_NE(string::npos, body.find("<ETag>\"abc\"</ETag>\n    <ChecksumCRC32C>AAAAAA==</"
+                                      "ChecksumCRC32C>"));
+    EXPECT_NE(string::npos, body.find("<ETag>\"def\"</ETag>\n    <ChecksumCRC32C>4waSgw==</"
+                                      "ChecksumCRC32C>"));
+
+    return Response(RESPONSE_OK, vector<uint8_t>(100));
+}
+
+TEST_F(S3InterfaceServiceTest, completeMultiPartWithChecksums) {
+    EXPECT_CALL(mockRESTfulService, post(_, _, _)).WillOnce(Invoke(CheckCompleteChecksums));
+
+    vector<string> etagArray = {"\"abc\"", "\"def\""};
+    vector<string> checksumArray = {"AAAAAA==", "4waSgw=="};
+    EXPECT_TRUE(this->completeMultiPart(S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                                        "xyz", etagArray, checksumArray));
+}
+
+TEST_F(S3InterfaceServiceTest, getKeyChecksumRoutine) {
+    uint8_t xml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<GetObjectAttributesResponse>"
+        "<Checksum><ChecksumCRC32C>4waSgw==</ChecksumCRC32C>"
+        "<ChecksumType>FULL_OBJECT</ChecksumType></Checksum>"
+        "</GetObjectAttributesResponse>";
+    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
+
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(Response(RESPONSE_OK, raw)));
+
+    EXPECT_EQ("4waSgw==",
+              this->getKeyChecksum(S3Url("https://s3-us-west-2.amazonaws.com/s3test/key")));
+}
+
+TEST_F(S3InterfaceServiceTest, getKeyChecksumOfCompositeKey) {
+    uint8_t xml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<GetObjectAttributesResponse>"
+        "<Checksum><ChecksumCRC32C>4waSgw==-2</ChecksumCRC32C>"
+        "<ChecksumType>COMPOSITE</ChecksumType></Checksum>"
+        "</GetObjectAttributesResponse>";
+    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
+
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(Response(RESPONSE_OK, raw)));
+
+    EXPECT_EQ("", this->getKeyChecksum(S3Url("https://s3-us-west-2.amazonaws.com/s3test/key")));
+}
+
+TEST(S3InterfaceService, completeMultiPartExistingKey) {
+    uint8_t xml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<Error>"
+        "<Code>PreconditionFailed</Code>"
+        "<Message>At least one of the pre-conditions you specified did not hold</Message>"
+        "<Condition>If-None-Match</Condition>"
+        "</Error>";
+    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
+    Response response(RESPONSE_ERROR, raw);
+
+    S3Params params("s3://a/a");
+    params.setConditionalWrite(true);
+
+    MockS3RESTfulService mockRESTfulService(params);
+    S3InterfaceServiceWithParams service(params);
+    service.setRESTfulService(&mockRESTfulService);
+
+    EXPECT_CALL(mockRESTfulService, post(_, _, _)).WillOnce(Return(response));
+
+    vector<string> etagArray = {"\"abc\""};
+    EXPECT_THROW(service.completeMultiPart(
+                     S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz",
+                     etagArray, vector<string>()),
+                 S3LogicError);
+}
+
 TEST_F(S3InterfaceServiceTest, abortUploadRoutine) {
     vector<uint8_t> raw;
     raw.resize(100);
@@ -744,3 +1143,419 @@ TEST_F(S3InterfaceServiceTest, abortUploadErrorResponse) {
                      S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz"),
                  S3LogicError);
 }
+
+// ================== asynchronous requests ===================
+
+class AsyncResultRecorder : public S3FetchCallback, public S3UploadCallback {
+   public:
+    AsyncResultRecorder(bool cancelled = false) : cancelled(cancelled), calls(0) {
+    }
+
+    bool isCancelled() {
+        return cancelled;
+    }
+
+    void onFetched(std::exception_ptr error) {
+        this->calls++;
+        this->error = error;
+    }
+
+    void onUploaded(const string &etag, std::exception_ptr error) {
+        this->calls++;
+        this->etag = etag;
+        this->error = error;
+    }
+
+    bool cancelled;
+    uint64_t calls;
+    string etag;
+    std::exception_ptr error;
+};
+
+// Respond to an asynchronous request at once, as if the I/O thread has run it.
+class MockAsyncResponse {
+   public:
+    MockAsyncResponse(const Response &response, std::exception_ptr error = std::exception_ptr())
+        : response(response), error(error) {
+    }
+
+    bool operator()(const string &url, HTTPHeaders &headers, RESTfulCallback *callback) {
+        Response resp(this->response);
+        callback->onResponse(resp, this->error);
+        return true;
+    }
+
+    bool operator()(const string &url, HTTPHeaders &headers, const S3VectorUInt8 &data,
+                    RESTfulCallback *callback) {
+        return (*this)(url, headers, callback);
+    }
+
+   private:
+    Response response;
+    std::exception_ptr error;
+};
+
+static std::exception_ptr ConnectionErrorPtr() {
+    return std::make_exception_ptr(S3ConnectionError("connection reset"));
+}
+
+TEST_F(S3InterfaceServiceTest, fetchDataAsyncFallbackToGet) {
+    vector<uint8_t> raw(100);
+    Response response(RESPONSE_OK, raw);
+    S3VectorUInt8 buffer;
+    AsyncResultRecorder recorder;
+
+    EXPECT_CALL(mockRESTfulService, getAsync(_, _, _)).WillOnce(Return(false));
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    this->fetchDataAsync(0, buffer, 100, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                         &recorder);
+
+    EXPECT_EQ((uint64_t)1, recorder.calls);
+    EXPECT_TRUE(recorder.error == NULL);
+    EXPECT_EQ((uint64_t)100, buffer.size());
+}
+
+TEST_F(S3InterfaceServiceTest, fetchDataAsyncRetryConnectionError) {
+    vector<uint8_t> raw(100);
+    Response response(RESPONSE_OK, raw);
+    S3VectorUInt8 buffer;
+    AsyncResultRecorder recorder;
+
+    EXPECT_CALL(mockRESTfulService, getAsync(_, _, _))
+        .WillOnce(Invoke(MockAsyncResponse(Response(RESPONSE_ERROR), ConnectionErrorPtr())))
+        .WillOnce(Invoke(MockAsyncResponse(response)));
+
+    this->fetchDataAsync(0, buffer, 100, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                         &recorder);
+
+    EXPECT_EQ((uint64_t)1, recorder.calls);
+    EXPECT_TRUE(recorder.error == NULL);
+    EXPECT_EQ((uint64_t)100, buffer.size());
+}
+
+TEST_F(S3InterfaceServiceTest, fetchDataAsyncFailedAfterRetry) {
+    S3VectorUInt8 buffer;
+    AsyncResultRecorder recorder;
+
+    EXPECT_CALL(mockRESTfulService, getAsync(_, _, _))
+        .Times(S3_REQUEST_MAX_RETRIES)
+        .WillRepeatedly(Invoke(MockAsyncResponse(Response(RESPONSE_ERROR), ConnectionErrorPtr())));
+
+    this->fetchDataAsync(0, buffer, 100, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                         &recorder);
+
+    EXPECT_EQ((uint64_t)1, recorder.calls);
+    EXPECT_THROW(std::rethrow_exception(recorder.error), S3FailedAfterRetry);
+}
+
+TEST_F(S3InterfaceServiceTest, fetchDataAsyncCancelled) {
+    S3VectorUInt8 buffer;
+    AsyncResultRecorder recorder(true);
+
+    EXPECT_CALL(mockRESTfulService, getAsync(_, _, _))
+        .WillOnce(Invoke(MockAsyncResponse(Response(RESPONSE_ERROR), ConnectionErrorPtr())));
+
+    this->fetchDataAsync(0, buffer, 100, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                         &recorder);
+
+    EXPECT_EQ((uint64_t)1, recorder.calls);
+    EXPECT_THROW(std::rethrow_exception(recorder.error), S3QueryAbort);
+}
+
+TEST_F(S3InterfaceServiceTest, fetchDataAsyncPartialResponse) {
+    vector<uint8_t> raw(80);
+    S3VectorUInt8 buffer;
+    AsyncResultRecorder recorder;
+
+    EXPECT_CALL(mockRESTfulService, getAsync(_, _, _))
+        .WillOnce(Invoke(MockAsyncResponse(Response(RESPONSE_OK, raw))));
+
+    this->fetchDataAsync(0, buffer, 100, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                         &recorder);
+
+    EXPECT_THROW(std::rethrow_exception(recorder.error), S3PartialResponseError);
+}
+
+TEST_F(S3InterfaceServiceTest, fetchDataAsyncErrorResponse) {
+    uint8_t xml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<Error><Code>NoSuchKey</Code><Message>The specified key does not exist.</Message></Error>";
+    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
+    S3VectorUInt8 buffer;
+    AsyncResultRecorder recorder;
+
+    EXPECT_CALL(mockRESTfulService, getAsync(_, _, _))
+        .WillOnce(Invoke(MockAsyncResponse(Response(RESPONSE_ERROR, raw))));
+
+    this->fetchDataAsync(0, buffer, 100, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"),
+                         &recorder);
+
+    EXPECT_THROW(std::rethrow_exception(recorder.error), S3LogicError);
+}
+
+TEST_F(S3InterfaceServiceTest, uploadPartOfDataAsyncWithHTTP2Headers) {
+    vector<uint8_t> body;
+    S3VectorUInt8 raw;
+    raw.resize(100);
+
+    // HTTP/2 header names are lower case.
+    uint8_t headers[] =
+        "HTTP/2 200\r\n"
+        "x-amz-request-id: 656c76696e6727732072657175657374\r\n"
+        "etag: \"b54357faf0632cce46e942fa68356b38\"\r\n"
+        "content-length: 0\r\n";
+    vector<uint8_t> data(headers, headers + sizeof(headers) - 1);
+    AsyncResultRecorder recorder;
+
+    EXPECT_CALL(mockRESTfulService, putAsync(_, _, _, _))
+        .WillOnce(Invoke(MockAsyncResponse(Response(RESPONSE_ERROR), ConnectionErrorPtr())))
+        .WillOnce(Invoke(MockAsyncResponse(Response(RESPONSE_OK, data, S3VectorUInt8(body)))));
+
+    this->uploadPartOfDataAsync(raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"), 11,
+                                "xyz", "", &recorder);
+
+    EXPECT_EQ((uint64_t)1, recorder.calls);
+    EXPECT_TRUE(recorder.error == NULL);
+    EXPECT_EQ("\"b54357faf0632cce46e942fa68356b38\"", recorder.etag);
+}
+
+TEST_F(S3InterfaceServiceTest, uploadPartOfDataAsyncFallbackToPut) {
+    S3VectorUInt8 raw;
+    raw.resize(100);
+    AsyncResultRecorder recorder;
+
+    EXPECT_CALL(mockRESTfulService, putAsync(_, _, _, _)).WillOnce(Return(false));
+    EXPECT_CALL(mockRESTfulService, put(_, _, _)).WillRepeatedly(Throw(S3ConnectionError("")));
+
+    this->uploadPartOfDataAsync(raw, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"), 11,
+                                "xyz", "", &recorder);
+
+    EXPECT_EQ((uint64_t)1, recorder.calls);
+    EXPECT_THROW(std::rethrow_exception(recorder.error), S3FailedAfterRetry);
+}
+
+// Encode a message of the AWS event stream with string headers.
+static void AppendEventMessage(vector<uint8_t> &stream,
+                               const vector<std::pair<string, string>> &headers,
+                               const string &payload) {
+    vector<uint8_t> headerBytes;
+    for (auto &header : headers) {
+        headerBytes.push_back(header.first.size());
+        headerBytes.insert(headerBytes.end(), header.first.begin(), header.first.end());
+        headerBytes.push_back(S3_EVENT_HEADER_STRING);
+        headerBytes.push_back(header.second.size() >> 8);
+        headerBytes.push_back(header.second.size() & 0xff);
+        headerBytes.insert(headerBytes.end(), header.second.begin(), header.second.end());
+    }
+
+    auto appendUInt32 = [](vector<uint8_t> &out, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back((value >> shift) & 0xff);
+        }
+    };
+
+    vector<uint8_t> message;
+    appendUInt32(message, S3_EVENT_PRELUDE_LEN + headerBytes.size() + payload.size() +
+                              S3_EVENT_CRC_LEN);
+    appendUInt32(message, headerBytes.size());
+    appendUInt32(message, crc32(0, message.data(), 8));
+    message.insert(message.end(), headerBytes.begin(), headerBytes.end());
+    message.insert(message.end(), payload.begin(), payload.end());
+    appendUInt32(message, crc32(0, message.data(), message.size()));
+
+    stream.insert(stream.end(), message.begin(), message.end());
+}
+
+static void AppendEvent(vector<uint8_t> &stream, const string &eventType,
+                        const string &payload = "") {
+    AppendEventMessage(stream, {{":message-type", "event"}, {":event-type", eventType}}, payload);
+}
+
+TEST(S3SelectEventStream, RecordsOfAllEvents) {
+    vector<uint8_t> stream;
+    AppendEvent(stream, "Records", "1,a\n2,");
+    AppendEvent(stream, "Cont");
+    AppendEvent(stream, "Records", "b\n");
+    AppendEvent(stream, "Stats", "<Stats></Stats>");
+    AppendEvent(stream, "End");
+
+    S3VectorUInt8 records;
+    DecodeS3SelectEventStream(stream.data(), stream.size(), records);
+
+    EXPECT_EQ("1,a\n2,b\n", string(records.begin(), records.end()));
+}
+
+TEST(S3SelectEventStream, ErrorEvent) {
+    vector<uint8_t> stream;
+    AppendEvent(stream, "Records", "1,a\n");
+    AppendEventMessage(stream, {{":message-type", "error"},
+                                {":error-code", "CastFailed"},
+                                {":error-message", "Attempt to convert failed"}},
+                       "");
+
+    S3VectorUInt8 records;
+    EXPECT_THROW(DecodeS3SelectEventStream(stream.data(), stream.size(), records), S3LogicError);
+}
+
+TEST(S3SelectEventStream, MissingEndEvent) {
+    vector<uint8_t> stream;
+    AppendEvent(stream, "Records", "1,a\n");
+
+    S3VectorUInt8 records;
+    EXPECT_THROW(DecodeS3SelectEventStream(stream.data(), stream.size(), records), S3RuntimeError);
+}
+
+TEST(S3SelectEventStream, CorruptedMessage) {
+    vector<uint8_t> stream;
+    AppendEvent(stream, "Records", "1,a\n");
+    AppendEvent(stream, "End");
+    stream[S3_EVENT_PRELUDE_LEN + 30] ^= 1;
+
+    S3VectorUInt8 records;
+    EXPECT_THROW(DecodeS3SelectEventStream(stream.data(), stream.size(), records), S3RuntimeError);
+
+    stream.resize(stream.size() - 1);
+    EXPECT_THROW(DecodeS3SelectEventStream(stream.data(), stream.size(), records), S3RuntimeError);
+}
+
+TEST_F(S3InterfaceServiceTest, SelectObjectContent) {
+    vector<uint8_t> stream;
+    AppendEvent(stream, "Records", "1,a\n");
+    AppendEvent(stream, "End");
+    Response response(RESPONSE_OK, stream);
+
+    string request = "<SelectObjectContentRequest></SelectObjectContentRequest>";
+    EXPECT_CALL(mockRESTfulService,
+                post("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever?select&select-"
+                     "type=2",
+                     _, vector<uint8_t>(request.begin(), request.end())))
+        .WillOnce(Return(response));
+
+    S3VectorUInt8 records;
+    this->selectObjectContent(
+        S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), request, records);
+
+    EXPECT_EQ("1,a\n", string(records.begin(), records.end()));
+}
+
+TEST_F(S3InterfaceServiceTest, SelectObjectContentErrorResponse) {
+    uint8_t xml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<Error><Code>InvalidTextEncoding</Code><Message>UTF-8 encoding is required.</Message>"
+        "</Error>";
+    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
+    Response response(RESPONSE_ERROR, raw);
+
+    EXPECT_CALL(mockRESTfulService, post(_, _, _)).WillOnce(Return(response));
+
+    S3VectorUInt8 records;
+    EXPECT_THROW(this->selectObjectContent(
+                     S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"),
+                     "<SelectObjectContentRequest/>", records),
+                 S3LogicError);
+}
+
+class S3RangeFetcherTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        for (int i = 0; i < 256; i++) {
+            this->file.push_back((char)i);
+        }
+
+        EXPECT_CALL(mockS3Interface, fetchData(_, _, _, _))
+            .WillRepeatedly(Invoke(this, &S3RangeFetcherTest::mockFetchData));
+    }
+
+    uint64_t mockFetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                           const S3Url &s3Url) {
+        this->fetched.push_back(std::make_pair(offset, len));
+
+        data.clear();
+        data.insert(data.end(), this->file.begin() + offset, this->file.begin() + offset + len);
+        return len;
+    }
+
+    void expectRange(uint64_t offset, uint64_t len) {
+        const uint8_t *data = this->fetcher.fetch(offset, len);
+        ASSERT_TRUE(data != NULL);
+        EXPECT_EQ(this->file.substr(offset, len), string((const char *)data, len));
+    }
+
+    string file;
+    vector<std::pair<uint64_t, uint64_t> > fetched;
+    MockS3Interface mockS3Interface;
+    S3RangeFetcher fetcher;
+};
+
+TEST_F(S3RangeFetcherTest, MergeRangesWithinGap) {
+    fetcher.reset(&mockS3Interface, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"), 10);
+
+    vector<std::pair<uint64_t, uint64_t> > ranges;
+    ranges.push_back(std::make_pair(30, 10));
+    ranges.push_back(std::make_pair(10, 10));
+    ranges.push_back(std::make_pair(100, 5));
+    fetcher.plan(ranges);
+
+    expectRange(30, 10);
+    expectRange(10, 10);
+    expectRange(100, 5);
+
+    // [10, 20) and [30, 40) are merged, [100, 105) is too far from them.
+    ASSERT_EQ(2u, fetched.size());
+    EXPECT_EQ(std::make_pair((uint64_t)10, (uint64_t)30), fetched[0]);
+    EXPECT_EQ(std::make_pair((uint64_t)100, (uint64_t)5), fetched[1]);
+    EXPECT_EQ(2u, fetcher.getNumOfRequests());
+}
+
+TEST_F(S3RangeFetcherTest, NoMergeWithoutGap) {
+    fetcher.reset(&mockS3Interface, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"), 0);
+
+    vector<std::pair<uint64_t, uint64_t> > ranges;
+    ranges.push_back(std::make_pair(0, 10));
+    ranges.push_back(std::make_pair(10, 10));
+    fetcher.plan(ranges);
+
+    expectRange(0, 10);
+    expectRange(10, 10);
+    EXPECT_EQ(2u, fetched.size());
+}
+
+TEST_F(S3RangeFetcherTest, ReuseFetchedRanges) {
+    fetcher.reset(&mockS3Interface, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"), 10);
+
+    vector<std::pair<uint64_t, uint64_t> > tail;
+    tail.push_back(std::make_pair(128, 128));
+    fetcher.plan(tail);
+    expectRange(248, 8);
+
+    vector<std::pair<uint64_t, uint64_t> > ranges;
+    ranges.push_back(std::make_pair(130, 20));
+    ranges.push_back(std::make_pair(100, 20));
+    fetcher.plan(ranges);
+
+    // [100, 150) is merged and not inside the tail, it's fetched again.
+    expectRange(130, 20);
+    expectRange(100, 20);
+    EXPECT_EQ(2u, fetched.size());
+
+    ranges.clear();
+    ranges.push_back(std::make_pair(140, 5));
+    fetcher.plan(ranges);
+    expectRange(140, 5);
+    EXPECT_EQ(2u, fetched.size());
+}
+
+TEST_F(S3RangeFetcherTest, FetchUnplannedRange) {
+    fetcher.reset(&mockS3Interface, S3Url("https://s3-us-west-2.amazonaws.com/s3test/key"), 10);
+
+    vector<std::pair<uint64_t, uint64_t> > ranges;
+    ranges.push_back(std::make_pair(0, 10));
+    fetcher.plan(ranges);
+
+    expectRange(5, 10);
+    ASSERT_EQ(1u, fetched.size());
+    EXPECT_EQ(std::make_pair((uint64_t)5, (uint64_t)10), fetched[0]);
+
+    EXPECT_TRUE(fetcher.fetch(0, 0) == NULL);
+}
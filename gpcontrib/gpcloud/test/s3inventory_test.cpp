@@ -0,0 +1,259 @@
+#include "s3inventory.cpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+
+#define TEST_INVENTORY_SCHEMA {"Bucket", "Key", "Size", "LastModifiedDate", "ETag"}
+
+// ================== ParseInventoryManifest ===================
+
+TEST(ParseInventoryManifest, ParseCSVManifest) {
+    string json =
+        "{\n"
+        "  \"sourceBucket\" : \"example-source-bucket\",\n"
+        "  \"destinationBucket\" : \"arn:aws:s3:::example-inventory-destination-bucket\",\n"
+        "  \"version\" : \"2016-11-30\",\n"
+        "  \"creationTimestamp\" : \"1514944800000\",\n"
+        "  \"fileFormat\" : \"CSV\",\n"
+        "  \"fileSchema\" : \"Bucket, Key, VersionId, IsLatest, IsDeleteMarker, Size\",\n"
+        "  \"files\" : [ {\n"
+        "    \"key\" : \"Inventory/example/data/d794c570.csv.gz\",\n"
+        "    \"size\" : 1643,\n"
+        "    \"MD5checksum\" : \"8ca7a2e4412f\"\n"
+        "  }, {\n"
+        "    \"key\" : \"Inventory/example/data/\\u00e9t\\u00e9.csv.gz\",\n"
+        "    \"size\" : 42,\n"
+        "    \"MD5checksum\" : null\n"
+        "  } ]\n"
+        "}\n";
+
+    S3InventoryManifest manifest;
+    ASSERT_TRUE(ParseInventoryManifest(json, manifest));
+
+    EXPECT_EQ("example-source-bucket", manifest.sourceBucket);
+    EXPECT_EQ("CSV", manifest.fileFormat);
+
+    ASSERT_EQ((uint64_t)6, manifest.fileSchema.size());
+    EXPECT_EQ("Bucket", manifest.fileSchema[0]);
+    EXPECT_EQ("Key", manifest.fileSchema[1]);
+    EXPECT_EQ("Size", manifest.fileSchema[5]);
+
+    ASSERT_EQ((uint64_t)2, manifest.files.size());
+    EXPECT_EQ("Inventory/example/data/d794c570.csv.gz", manifest.files[0].getName());
+    EXPECT_EQ((uint64_t)1643, manifest.files[0].getSize());
+    EXPECT_EQ("Inventory/example/data/\xc3\xa9t\xc3\xa9.csv.gz", manifest.files[1].getName());
+    EXPECT_EQ((uint64_t)42, manifest.files[1].getSize());
+}
+
+TEST(ParseInventoryManifest, RejectMalformedManifest) {
+    S3InventoryManifest manifest;
+
+    EXPECT_FALSE(ParseInventoryManifest("", manifest));
+    EXPECT_FALSE(ParseInventoryManifest("[]", manifest));
+    EXPECT_FALSE(ParseInventoryManifest("{\"sourceBucket\": \"b\", \"fileFormat\": \"CSV\"}",
+                                        manifest));
+    EXPECT_FALSE(ParseInventoryManifest(
+        "{\"sourceBucket\": \"b\", \"fileFormat\": \"CSV\", \"files\": [{\"key\": \"a\", ",
+        manifest));
+    EXPECT_FALSE(ParseInventoryManifest(
+        "{\"sourceBucket\": \"b\", \"fileFormat\": \"CSV\", \"files\": [{\"size\": 1}]}",
+        manifest));
+}
+
+// ================== ParseInventoryCSV ===================
+
+TEST(NormalizeInventoryTime, CSVAndParquetTimesCompareEqual) {
+    EXPECT_EQ("2024-01-31 12:00:00.000", NormalizeInventoryTime("2024-01-31T12:00:00.000Z"));
+    EXPECT_EQ("2024-01-31 12:00:00", NormalizeInventoryTime("2024-01-31 12:00:00"));
+    EXPECT_EQ("2024-01-31", NormalizeInventoryTime("2024-01-31"));
+    EXPECT_EQ("", NormalizeInventoryTime(""));
+}
+
+TEST(ParseInventoryCSV, ParseKeysWithFilter) {
+    string csv =
+        "\"bucket\",\"data/a.csv\",\"100\",\"2024-01-01T00:00:00.000Z\",\"etag1\"\n"
+        "\"bucket\",\"data/b%2Cc+d.csv\",\"200\",\"2024-02-01T00:00:00.000Z\",\"etag2\"\r\n"
+        "\"bucket\",\"data/empty.csv\",\"0\",\"2024-02-01T00:00:00.000Z\",\"etag3\"\n"
+        "\"bucket\",\"other/x.csv\",\"300\",\"2024-02-01T00:00:00.000Z\",\"etag4\"\n"
+        "\"bucket\",\"data/c.csv\",\"400\",\"2024-03-01T00:00:00.000Z\",\"\"\n";
+
+    S3InventoryFilter filter;
+    filter.prefix = "data/";
+    filter.modifiedAfter = "2024-01-15T00:00:00Z";
+    filter.modifiedBefore = "2024-03-01T00:00:00Z";
+
+    vector<BucketContent> contents;
+    ParseInventoryCSV(csv.data(), csv.size(), TEST_INVENTORY_SCHEMA, true, filter, contents);
+
+    ASSERT_EQ((uint64_t)1, contents.size());
+    EXPECT_EQ("data/b,c d.csv", contents[0].getName());
+    EXPECT_EQ((uint64_t)200, contents[0].getSize());
+    EXPECT_EQ("\"etag2\"", contents[0].getETag());
+
+    filter.modifiedAfter.clear();
+    filter.modifiedBefore.clear();
+    contents.clear();
+    ParseInventoryCSV(csv.data(), csv.size(), TEST_INVENTORY_SCHEMA, true, filter, contents);
+
+    ASSERT_EQ((uint64_t)3, contents.size());
+    EXPECT_EQ("data/a.csv", contents[0].getName());
+    EXPECT_EQ("data/c.csv", contents[2].getName());
+    EXPECT_EQ("", contents[2].getETag());
+}
+
+TEST(ParseInventoryCSV, SkipHeaderAndDeletedKeys) {
+    string csv =
+        "key,size,last_modified_date,e_tag,is_latest,is_delete_marker\n"
+        "\"a \"\"quoted\"\", key\",10,2024-01-01 00:00:00,e1,true,false\n"
+        "old,20,2024-01-01 00:00:00,e2,false,false\n"
+        "deleted,30,2024-01-01 00:00:00,e3,true,true\n"
+        "data%20c,40,2024-01-01 00:00:00,e4,,\n";
+
+    vector<BucketContent> contents;
+    ParseInventoryCSV(csv.data(), csv.size(), S3_INVENTORY_PARQUET_SCHEMA, false,
+                      S3InventoryFilter(), contents);
+
+    ASSERT_EQ((uint64_t)2, contents.size());
+    EXPECT_EQ("a \"quoted\", key", contents[0].getName());
+    EXPECT_EQ((uint64_t)10, contents[0].getSize());
+    EXPECT_EQ("data%20c", contents[1].getName());
+}
+
+TEST(ParseInventoryCSV, ThrowIfSchemaHasNoKey) {
+    string csv = "\"bucket\",\"100\"\n";
+    vector<string> schema = {"Bucket", "Size"};
+    vector<BucketContent> contents;
+
+    EXPECT_THROW(ParseInventoryCSV(csv.data(), csv.size(), schema, true, S3InventoryFilter(),
+                                   contents),
+                 S3RuntimeError);
+}
+
+// ================== ListBucketFromInventory ===================
+
+class MockS3InterfaceForInventory : public MockS3Interface {
+   public:
+    ListBucketResult mockListBucket(S3Url &s3Url) {
+        ListBucketResult result;
+        result.Name = s3Url.getBucket();
+        result.Prefix = s3Url.getPrefix();
+        for (std::map<string, string>::iterator it = files.begin(); it != files.end(); it++) {
+            if (it->first.compare(0, s3Url.getPrefix().size(), s3Url.getPrefix()) == 0) {
+                result.contents.emplace_back(it->first, it->second.size());
+            }
+        }
+        return result;
+    }
+
+    uint64_t mockFetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                           const S3Url &s3Url) {
+        const string &file = files.at(UriDecode(s3Url.getPrefix()));
+        data.resize(len);
+        memcpy(data.data(), file.data() + offset, len);
+        return len;
+    }
+
+    std::map<string, string> files;
+};
+
+static string gzipString(const string &text) {
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+    deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                 Z_DEFAULT_STRATEGY);
+
+    vector<char> out(deflateBound(&zstream, text.size()));
+    zstream.next_in = (Byte *)text.data();
+    zstream.avail_in = text.size();
+    zstream.next_out = (Byte *)out.data();
+    zstream.avail_out = out.size();
+    deflate(&zstream, Z_FINISH);
+
+    string compressed(out.data(), out.size() - zstream.avail_out);
+    deflateEnd(&zstream);
+    return compressed;
+}
+
+class ListBucketFromInventoryTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        params = S3Params("s3://s3-us-west-2.amazonaws.com/source-bucket/data/");
+        params.setInventoryManifest(
+            "s3://s3-us-west-2.amazonaws.com/inventory-bucket/source-bucket/daily/manifest.json");
+
+        EXPECT_CALL(s3Interface, listBucket(_))
+            .WillRepeatedly(Invoke(&s3Interface, &MockS3InterfaceForInventory::mockListBucket));
+        EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+            .WillRepeatedly(Invoke(&s3Interface, &MockS3InterfaceForInventory::mockFetchData));
+    }
+
+    void addManifest(const string &sourceBucket, const string &fileFormat,
+                     const vector<string> &dataFiles) {
+        string json = "{\"sourceBucket\": \"" + sourceBucket + "\", \"fileFormat\": \"" +
+                      fileFormat + "\", \"fileSchema\": \"Bucket, Key, Size, LastModifiedDate, " +
+                      "ETag\", \"files\": [";
+        for (uint64_t i = 0; i < dataFiles.size(); i++) {
+            json += (i > 0) ? ", " : "";
+            json += "{\"key\": \"" + dataFiles[i] + "\", \"size\": " +
+                    std::to_string(s3Interface.files[dataFiles[i]].size()) + "}";
+        }
+        json += "]}";
+
+        s3Interface.files["source-bucket/daily/manifest.json"] = json;
+    }
+
+    S3Params params;
+    MockS3InterfaceForInventory s3Interface;
+};
+
+TEST_F(ListBucketFromInventoryTest, ListKeysOfCSVReport) {
+    s3Interface.files["source-bucket/daily/data/1.csv.gz"] =
+        gzipString("\"source-bucket\",\"data/b.csv\",\"20\",\"2024-01-02T00:00:00.000Z\",\"e2\"\n"
+                   "\"source-bucket\",\"logs/x.csv\",\"30\",\"2024-01-02T00:00:00.000Z\",\"e3\"\n");
+    s3Interface.files["source-bucket/daily/data/2 copy.csv"] =
+        "\"source-bucket\",\"data/a.csv\",\"10\",\"2024-01-01T00:00:00.000Z\",\"e1\"\n";
+    addManifest("source-bucket", "CSV",
+                {"source-bucket/daily/data/1.csv.gz", "source-bucket/daily/data/2 copy.csv"});
+
+    ListBucketResult result = ListBucketFromInventory(&s3Interface, params);
+
+    EXPECT_EQ("source-bucket", result.Name);
+    EXPECT_EQ("data/", result.Prefix);
+    ASSERT_EQ((uint64_t)2, result.contents.size());
+    EXPECT_EQ("data/a.csv", result.contents[0].getName());
+    EXPECT_EQ((uint64_t)10, result.contents[0].getSize());
+    EXPECT_EQ("\"e1\"", result.contents[0].getETag());
+    EXPECT_EQ("data/b.csv", result.contents[1].getName());
+}
+
+TEST_F(ListBucketFromInventoryTest, FilterByModifiedTime) {
+    s3Interface.files["source-bucket/daily/data/1.csv"] =
+        "\"source-bucket\",\"data/a.csv\",\"10\",\"2024-01-01T00:00:00.000Z\",\"e1\"\n"
+        "\"source-bucket\",\"data/b.csv\",\"20\",\"2024-01-02T00:00:00.000Z\",\"e2\"\n";
+    addManifest("source-bucket", "CSV", {"source-bucket/daily/data/1.csv"});
+    params.setInventoryModifiedAfter("2024-01-01T12:00:00Z");
+
+    ListBucketResult result = ListBucketFromInventory(&s3Interface, params);
+
+    ASSERT_EQ((uint64_t)1, result.contents.size());
+    EXPECT_EQ("data/b.csv", result.contents[0].getName());
+}
+
+TEST_F(ListBucketFromInventoryTest, ThrowIfReportIsOfOtherBucket) {
+    addManifest("other-bucket", "CSV", {});
+
+    EXPECT_THROW(ListBucketFromInventory(&s3Interface, params), S3ConfigError);
+}
+
+TEST_F(ListBucketFromInventoryTest, ThrowIfFormatIsNotSupported) {
+    addManifest("source-bucket", "ORC", {});
+
+    EXPECT_THROW(ListBucketFromInventory(&s3Interface, params), S3ConfigError);
+}
+
+TEST_F(ListBucketFromInventoryTest, ThrowIfManifestIsNotFound) {
+    EXPECT_THROW(ListBucketFromInventory(&s3Interface, params), S3RuntimeError);
+}
@@ -0,0 +1,62 @@
+#include "s3iostats.cpp"
+
+#include "gtest/gtest.h"
+
+TEST(S3IOStats, AddAndReset) {
+    S3IOStats stats;
+    EXPECT_EQ(0u, stats.get(S3IO_REQUESTS));
+
+    stats.add(S3IO_REQUESTS);
+    stats.add(S3IO_REQUESTS);
+    stats.add(S3IO_BYTES_DOWNLOADED, 100);
+    EXPECT_EQ(2u, stats.get(S3IO_REQUESTS));
+    EXPECT_EQ(100u, stats.get(S3IO_BYTES_DOWNLOADED));
+    EXPECT_EQ(0u, stats.get(S3IO_RETRIES));
+
+    stats.reset();
+    EXPECT_EQ(0u, stats.get(S3IO_REQUESTS));
+    EXPECT_EQ(0u, stats.get(S3IO_BYTES_DOWNLOADED));
+}
+
+TEST(S3IOStats, ToString) {
+    S3IOStats stats;
+    stats.add(S3IO_RETRIES, 3);
+    stats.add(S3IO_DECOMPRESS_US, 7);
+
+    EXPECT_EQ(
+        "requests=0, retries=3, throttles=0, bytes_downloaded=0, bytes_uploaded=0, wait_us=0, "
+        "decompress_us=7",
+        stats.toString());
+}
+
+static void *AddRequests(void *arg) {
+    S3IOStats *stats = (S3IOStats *)arg;
+    for (int i = 0; i < 10000; i++) {
+        stats->add(S3IO_REQUESTS);
+    }
+    return NULL;
+}
+
+TEST(S3IOStats, AddFromThreads) {
+    S3IOStats stats;
+    pthread_t threads[4];
+
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, AddRequests, &stats);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    EXPECT_EQ(40000u, stats.get(S3IO_REQUESTS));
+}
+
+TEST(S3IOStats, TimerAddsElapsedTime) {
+    GetS3IOStats().reset();
+    {
+        S3IOTimer timer(S3IO_WAIT_US);
+        usleep(1000);
+    }
+    EXPECT_GE(GetS3IOStats().get(S3IO_WAIT_US), 1000u);
+    GetS3IOStats().reset();
+}
@@ -216,6 +216,154 @@ TEST(OffsetMgr, reset) {
     EXPECT_EQ((uint64_t)0, o.getCurPos());
 }
 
+TEST(OffsetMgr, SmallChunksBeyondSoftEnd) {
+    OffsetMgr o;
+    o.setKeySize(8 * 1024 * 1024);
+    o.setChunkSize(3 * 1024 * 1024);
+    o.setCurPos(1024);
+    o.setSoftEnd(4 * 1024 * 1024);
+
+    Range r = o.getNextOffset();
+    EXPECT_EQ((uint64_t)1024, r.offset);
+    EXPECT_EQ((uint64_t)3 * 1024 * 1024, r.length);
+
+    // truncated at soft end
+    r = o.getNextOffset();
+    EXPECT_EQ((uint64_t)3 * 1024 * 1024 + 1024, r.offset);
+    EXPECT_EQ((uint64_t)1024 * 1024 - 1024, r.length);
+
+    r = o.getNextOffset();
+    EXPECT_EQ((uint64_t)4 * 1024 * 1024, r.offset);
+    EXPECT_EQ((uint64_t)S3_RANGE_TAIL_CHUNKSIZE, r.length);
+
+    o.reset();
+    EXPECT_EQ((uint64_t)0, o.getSoftEnd());
+}
+
+static void *CollectRangesThreadFunc(void *data) {
+    std::pair<OffsetMgr *, vector<Range> > *arg = (std::pair<OffsetMgr *, vector<Range> > *)data;
+
+    Range r;
+    while ((r = arg->first->getNextOffset()).length > 0) {
+        arg->second.push_back(r);
+    }
+
+    return NULL;
+}
+
+TEST(OffsetMgr, ConcurrentRangesCoverKey) {
+    OffsetMgr o;
+    o.setKeySize(64 * 1024 * 1024 + 1);
+    o.setChunkSize(64 * 1024);
+    o.setSoftEnd(48 * 1024 * 1024);
+
+    const int numOfThreads = 8;
+    std::pair<OffsetMgr *, vector<Range> > args[numOfThreads];
+    pthread_t threads[numOfThreads];
+    for (int i = 0; i < numOfThreads; i++) {
+        args[i].first = &o;
+        pthread_create(&threads[i], NULL, CollectRangesThreadFunc, &args[i]);
+    }
+
+    map<uint64_t, uint64_t> ranges;
+    for (int i = 0; i < numOfThreads; i++) {
+        pthread_join(threads[i], NULL);
+        for (auto &r : args[i].second) {
+            EXPECT_TRUE(ranges.emplace(r.offset, r.length).second);
+        }
+    }
+
+    // ranges are disjoint and leave no gap.
+    uint64_t pos = 0;
+    for (auto &r : ranges) {
+        ASSERT_EQ(pos, r.first);
+        pos += r.second;
+    }
+    EXPECT_EQ(o.getKeySize(), pos);
+}
+
+TEST(PreAllocatedMemory, AllocateAndDeallocate) {
+    PreAllocatedMemory memory(16, 3);
+
+    void *a = memory.Allocate();
+    void *b = memory.Allocate();
+    void *c = memory.Allocate();
+    EXPECT_TRUE((a != b) && (b != c) && (a != c));
+    EXPECT_THROW(memory.Allocate(), S3RuntimeError);
+
+    memory.Deallocate(b);
+    EXPECT_EQ(b, memory.Allocate());
+
+    int x;
+    EXPECT_THROW(memory.Deallocate(&x), S3RuntimeError);
+
+    memory.Deallocate(a);
+    memory.Deallocate(b);
+    memory.Deallocate(c);
+}
+
+// Finish one round of 'limit' requests, each downloads 'bytes' in 'latencyUs'.
+static void finishFetchRound(FetchLimiter &limiter, uint64_t bytes, uint64_t latencyUs,
+                             uint64_t &nowUs) {
+    uint64_t limit = limiter.getLimit();
+
+    for (uint64_t i = 0; i < limit; i++) {
+        ASSERT_TRUE(limiter.acquire());
+    }
+
+    nowUs += latencyUs;
+    for (uint64_t i = 0; i < limit; i++) {
+        limiter.release(bytes, latencyUs, nowUs);
+    }
+}
+
+TEST(FetchLimiter, RampUpWhileThroughputGrows) {
+    FetchLimiter limiter;
+    uint64_t nowUs = 1000;
+    limiter.reset(4, 2, nowUs);
+    EXPECT_EQ((uint64_t)2, limiter.getLimit());
+
+    // same latency with more requests in flight, throughput grows until maxLimit.
+    for (uint64_t i = 0; i < 5; i++) {
+        finishFetchRound(limiter, 1000, 1000, nowUs);
+    }
+
+    EXPECT_EQ((uint64_t)4, limiter.getLimit());
+}
+
+TEST(FetchLimiter, BackOffWhenSaturated) {
+    FetchLimiter limiter;
+    uint64_t nowUs = 1000;
+    limiter.reset(8, 2, nowUs);
+
+    finishFetchRound(limiter, 1000, 1000, nowUs);
+    ASSERT_EQ((uint64_t)3, limiter.getLimit());
+
+    // bandwidth is saturated, more requests in flight only add latency.
+    finishFetchRound(limiter, 1000, 3000, nowUs);
+    EXPECT_EQ((uint64_t)2, limiter.getLimit());
+
+    // stay while throughput is stable.
+    finishFetchRound(limiter, 1000, 2000, nowUs);
+    EXPECT_EQ((uint64_t)2, limiter.getLimit());
+
+    // never goes below one request.
+    for (uint64_t i = 0; i < 5; i++) {
+        finishFetchRound(limiter, 1000, 100000 << i, nowUs);
+    }
+    EXPECT_EQ((uint64_t)1, limiter.getLimit());
+}
+
+TEST(FetchLimiter, StopWakesUpWaiters) {
+    FetchLimiter limiter;
+    limiter.reset(1, 1, 0);
+
+    ASSERT_TRUE(limiter.acquire());
+
+    limiter.stop();
+    EXPECT_FALSE(limiter.acquire());
+}
+
 TEST_F(S3KeyReaderTest, OpenWithZeroChunk) {
     S3Params params("s3://abc/def");
 
@@ -263,6 +411,33 @@ TEST_F(S3KeyReaderTest, ReadWithSingleChunk) {
     EXPECT_EQ((uint64_t)0, this->read(buffer, 64 * 1024));
 }
 
+TEST_F(S3KeyReaderTest, ReadViewLendsChunkData) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setKeySize(255);
+    params.setChunkSize(128);
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillOnce(Invoke(MockFetchData(128, 128)))
+        .WillOnce(Invoke(MockFetchData(127, 128)));
+
+    this->open(params);
+
+    const char* first = NULL;
+    const char* data = NULL;
+    EXPECT_EQ((uint64_t)100, this->readView(&first, 100));
+    EXPECT_EQ((uint64_t)28, this->readView(&data, 100));
+    EXPECT_EQ(first + 100, data);
+
+    // chunk is refilled only after its data is not lent anymore
+    EXPECT_EQ((uint64_t)100, this->readView(&data, 100));
+    EXPECT_EQ((uint64_t)27, this->readView(&data, 100));
+    EXPECT_EQ((uint64_t)1, this->readView(&data, 100));
+    EXPECT_EQ('\n', data[0]);
+    EXPECT_EQ((uint64_t)0, this->readView(&data, 100));
+    EXPECT_EQ((uint64_t)255, this->getTransferredKeyLen());
+}
+
 TEST_F(S3KeyReaderTest, ReadWithSingleChunkNormalCase) {
     // Read buffer < chunk size < key size
     S3Params params("s3://abc/def");
@@ -847,3 +1022,659 @@ TEST(ChunkBuffer, ChunkBufferOperatorEqual) {
 
     EXPECT_EQ(ReadyToFill, buf1.getStatus());
 }
+
+// Mock function object of fetchData, returns requested range of content.
+class MockFetchContent {
+   public:
+    MockFetchContent(const string &content) : content(content) {
+    }
+
+    uint64_t operator()(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                        const S3Url &sourceUrl) {
+        data.clear();
+        data.insert(data.end(), content.begin() + offset, content.begin() + offset + len);
+        return len;
+    }
+
+   private:
+    string content;
+};
+
+static string readKeyRange(const string &content, uint64_t start, uint64_t end) {
+    MockS3Interface s3Interface;
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(4);
+    params.setKeySize(content.size());
+    params.setKeyRange(start, end);
+
+    S3KeyReader reader;
+    reader.setS3InterfaceService(&s3Interface);
+    reader.open(params);
+
+    string result;
+    char buf[3];
+    uint64_t len;
+    while ((len = reader.read(buf, sizeof(buf))) != 0) {
+        result.append(buf, len);
+    }
+    reader.close();
+
+    return result;
+}
+
+TEST_F(S3KeyReaderTest, ReadRangeWithLineBoundary) {
+    const string content = "aaa\nbbbb\ncc\ndddd\n";
+
+    EXPECT_EQ("aaa\nbbbb\n", readKeyRange(content, 0, 6));
+    EXPECT_EQ("cc\n", readKeyRange(content, 6, 12));
+    EXPECT_EQ("dddd\n", readKeyRange(content, 12, content.size()));
+
+    // range starts right after an EOL
+    EXPECT_EQ("bbbb\ncc\n", readKeyRange(content, 4, 10));
+
+    // no line starts inside the range
+    EXPECT_EQ("", readKeyRange(content, 5, 8));
+}
+
+TEST_F(S3KeyReaderTest, ReadRangesCoverWholeKey) {
+    const string content = "a\nbbb\n\ncccccccc\nd\neeeee";
+
+    for (uint64_t i = 1; i < content.size(); i++) {
+        for (uint64_t j = i + 1; j < content.size(); j++) {
+            string result = readKeyRange(content, 0, i) + readKeyRange(content, i, j) +
+                            readKeyRange(content, j, content.size());
+            EXPECT_EQ(content + "\n", result) << "ranges split at " << i << " and " << j;
+        }
+    }
+}
+
+TEST_F(S3KeyReaderTest, ReadRangesCoverWholeKeyWithCRLF) {
+    eolString[0] = '\r';
+    eolString[1] = '\n';
+    eolString[2] = '\0';
+
+    const string content = "a\r\nb\rb\r\r\n\r\ncccc\ncccc\r\nd\r\n";
+
+    for (uint64_t i = 1; i < content.size(); i++) {
+        string result = readKeyRange(content, 0, i) + readKeyRange(content, i, content.size());
+        EXPECT_EQ(content, result) << "range split at " << i;
+    }
+
+    eolString[0] = '\n';
+    eolString[1] = '\0';
+}
+
+TEST_F(S3KeyReaderTest, AdaptiveChunkSizeFromKeySize) {
+    string content;
+    for (uint64_t i = 0; content.size() < 3 * 1024 * 1024; i++) {
+        content.append(std::to_string((unsigned long long)i) + "\n");
+    }
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(8);
+    params.setChunkSize(64 * 1024 * 1024);
+    params.setKeySize(content.size());
+    params.setAdaptiveDownload(true);
+
+    this->open(params);
+
+    // a few small chunks instead of one large chunk.
+    EXPECT_TRUE(this->isAdaptive());
+    EXPECT_EQ((uint64_t)S3_ADAPTIVE_MIN_CHUNKSIZE, this->getOffsetMgr().getChunkSize());
+    EXPECT_EQ((uint64_t)4, this->getChunkBuffers().size());
+
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, sizeof(buffer))) != 0) {
+        result.append(buffer, len);
+    }
+
+    EXPECT_TRUE(content == result);
+}
+
+TEST_F(S3KeyReaderTest, AdaptiveChunkSizeNotLargerThanConfigured) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(4);
+    params.setChunkSize(8 * 1024 * 1024);
+    params.setKeySize(1024 * 1024 * 1024);
+    params.setAdaptiveDownload(true);
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchData(8 * 1024 * 1024, 8 * 1024 * 1024)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)8 * 1024 * 1024, this->getOffsetMgr().getChunkSize());
+    EXPECT_EQ((uint64_t)4, this->getChunkBuffers().size());
+}
+
+TEST_F(S3KeyReaderTest, AdaptiveReadRangesCoverWholeKey) {
+    const string content = "a\nbbb\n\ncccccccc\nd\neeeee\n";
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    string result;
+    for (uint64_t start = 0; start < content.size(); start += 7) {
+        S3Params params("s3://abc/def");
+        params.setNumOfChunks(3);
+        params.setChunkSize(4);
+        params.setKeySize(content.size());
+        params.setKeyRange(start, std::min(start + 7, (uint64_t)content.size()));
+        params.setAdaptiveDownload(true);
+
+        this->open(params);
+
+        uint64_t len;
+        while ((len = this->read(buffer, 3)) != 0) {
+            result.append(buffer, len);
+        }
+        this->close();
+    }
+
+    EXPECT_EQ(content, result);
+}
+
+TEST_F(S3KeyReaderTest, ReadCacheHitSkipsDownload) {
+    const string content = "a\nbbb\n\ncccccccc\nd\neeeee\n";
+
+    char dir[] = "/tmp/gpcloud_read_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+    // 4 chunks are downloaded only by the first read.
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .Times(4)
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(7);
+    params.setKeySize(content.size());
+    params.setKeyETag("\"etag\"");
+    params.setReadCacheDir(dir);
+    params.setReadCacheSize(1024);
+
+    for (int i = 0; i < 2; i++) {
+        this->open(params);
+
+        string result;
+        uint64_t len;
+        while ((len = this->read(buffer, sizeof(buffer))) != 0) {
+            result.append(buffer, len);
+        }
+        this->close();
+
+        EXPECT_EQ(content, result);
+    }
+
+    for (uint64_t offset = 0; offset < content.size(); offset += 7) {
+        uint64_t len = std::min((uint64_t)7, content.size() - offset);
+        unlink(this->getReadCache().getEntryPath(params.getS3Url(), "\"etag\"", offset, len).c_str());
+    }
+    rmdir(dir);
+}
+
+TEST_F(S3KeyReaderTest, VerifyChecksumOfWholeKey) {
+    const string content = "a\nbbb\n\ncccccccc\nd\neeeee\n";
+
+    EXPECT_CALL(s3Interface, getKeyChecksum(_))
+        .WillOnce(Return(Crc32cToBase64(Crc32c(0, content.data(), content.size()))));
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .Times(4)
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(3);
+    params.setChunkSize(7);
+    params.setKeySize(content.size());
+    params.setCrc32cChecksum(true);
+
+    this->open(params);
+
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, 5)) != 0) {
+        result.append(buffer, len);
+    }
+
+    EXPECT_EQ(content, result);
+}
+
+TEST_F(S3KeyReaderTest, ChecksumMismatchOfWholeKey) {
+    const string content = "a\nbbb\n\ncccccccc\nd\neeeee\n";
+
+    EXPECT_CALL(s3Interface, getKeyChecksum(_)).WillOnce(Return("4waSgw=="));
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .Times(4)
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(7);
+    params.setKeySize(content.size());
+    params.setCrc32cChecksum(true);
+
+    this->open(params);
+
+    EXPECT_THROW(
+        {
+            while (this->read(buffer, sizeof(buffer)) != 0) {
+            }
+        },
+        S3RuntimeError);
+}
+
+TEST_F(S3KeyReaderTest, NoChecksumOfKeyRange) {
+    const string content = "a\nbbb\n\ncccccccc\nd\neeeee\n";
+
+    EXPECT_CALL(s3Interface, getKeyChecksum(_)).Times(0);
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(7);
+    params.setKeySize(content.size());
+    params.setKeyRange(7, content.size());
+    params.setCrc32cChecksum(true);
+
+    this->open(params);
+
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, sizeof(buffer))) != 0) {
+        result.append(buffer, len);
+    }
+
+    EXPECT_EQ("cccccccc\nd\neeeee\n", result);
+}
+
+TEST_F(S3KeyReaderTest, ReadCacheDisabledWithoutETag) {
+    const string content = "a\nbbb\n";
+
+    char dir[] = "/tmp/gpcloud_read_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setChunkSize(64);
+    params.setKeySize(content.size());
+    params.setReadCacheDir(dir);
+    params.setReadCacheSize(1024);
+
+    for (int i = 0; i < 2; i++) {
+        this->open(params);
+        EXPECT_FALSE(this->getReadCache().isEnabled());
+        EXPECT_EQ(content.size(), this->read(buffer, sizeof(buffer)));
+        this->close();
+    }
+
+    EXPECT_EQ(0, rmdir(dir));
+}
+
+// Run fetches on a thread of its own, as the I/O thread of S3InterfaceService does.
+class MockAsyncS3Interface : public MockS3Interface {
+   public:
+    MockAsyncS3Interface() : stopping(false) {
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->cond, NULL);
+        pthread_create(&this->thread, NULL, MockAsyncS3Interface::IOThreadFunc, this);
+    }
+    ~MockAsyncS3Interface() {
+        {
+            UniqueLock lock(&this->mutex);
+            this->stopping = true;
+            pthread_cond_signal(&this->cond);
+        }
+        pthread_join(this->thread, NULL);
+
+        pthread_mutex_destroy(&this->mutex);
+        pthread_cond_destroy(&this->cond);
+    }
+
+    void fetchDataAsync(uint64_t offset, S3VectorUInt8 &data, uint64_t len, const S3Url &s3Url,
+                        S3FetchCallback *callback) {
+        UniqueLock lock(&this->mutex);
+
+        PendingFetch fetch = {offset, &data, len, &s3Url, callback};
+        this->fetches.push_back(fetch);
+        pthread_cond_signal(&this->cond);
+    }
+
+   private:
+    struct PendingFetch {
+        uint64_t offset;
+        S3VectorUInt8 *data;
+        uint64_t len;
+        const S3Url *s3Url;
+        S3FetchCallback *callback;
+    };
+
+    static void *IOThreadFunc(void *p) {
+        ((MockAsyncS3Interface *)p)->run();
+        return NULL;
+    }
+
+    void run() {
+        while (true) {
+            PendingFetch fetch;
+
+            {
+                UniqueLock lock(&this->mutex);
+                while (this->fetches.empty() && !this->stopping) {
+                    pthread_cond_wait(&this->cond, &this->mutex);
+                }
+                if (this->fetches.empty()) {
+                    return;
+                }
+
+                fetch = this->fetches.front();
+                this->fetches.pop_front();
+            }
+
+            if (fetch.callback->isCancelled()) {
+                fetch.callback->onFetched(std::make_exception_ptr(S3QueryAbort()));
+            } else {
+                S3Interface::fetchDataAsync(fetch.offset, *fetch.data, fetch.len, *fetch.s3Url,
+                                            fetch.callback);
+            }
+        }
+    }
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool stopping;
+    std::deque<PendingFetch> fetches;
+};
+
+TEST_F(S3KeyReaderTest, MultiplexedReadWithoutThreads) {
+    const string content = "a\nbbb\n\ncccccccc\nd\neeeee\n";
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .Times(4)
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(7);
+    params.setKeySize(content.size());
+    params.setMultiplexIO(true);
+
+    this->open(params);
+
+    EXPECT_TRUE(this->isMultiplexed());
+    EXPECT_TRUE(this->getThreads().empty());
+
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, 3)) != 0) {
+        result.append(buffer, len);
+    }
+
+    EXPECT_EQ(content, result);
+}
+
+TEST_F(S3KeyReaderTest, MultiplexedReadOnIOThread) {
+    string content;
+    for (uint64_t i = 0; content.size() < 1024 * 1024; i++) {
+        content.append(std::to_string((unsigned long long)i) + "\n");
+    }
+
+    MockAsyncS3Interface asyncInterface;
+    EXPECT_CALL(asyncInterface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+    this->setS3InterfaceService(&asyncInterface);
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(4);
+    params.setChunkSize(64 * 1024);
+    params.setKeySize(content.size());
+    params.setMultiplexIO(true);
+
+    this->open(params);
+
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, sizeof(buffer))) != 0) {
+        result.append(buffer, len);
+    }
+    this->close();
+
+    EXPECT_TRUE(content == result);
+}
+
+TEST_F(S3KeyReaderTest, MultiplexedReadWithFetchError) {
+    MockAsyncS3Interface asyncInterface;
+    EXPECT_CALL(asyncInterface, fetchData(_, _, _, _))
+        .WillRepeatedly(Throw(S3FailedAfterRetry("", 1, "")));
+    this->setS3InterfaceService(&asyncInterface);
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(64);
+    params.setKeySize(1024);
+    params.setMultiplexIO(true);
+
+    this->open(params);
+
+    EXPECT_THROW(this->read(buffer, sizeof(buffer)), S3FailedAfterRetry);
+    this->close();
+}
+
+TEST_F(S3KeyReaderTest, MultiplexedCloseWithFetchesInFlight) {
+    string content(64 * 1024, 'x');
+
+    MockAsyncS3Interface asyncInterface;
+    EXPECT_CALL(asyncInterface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+    this->setS3InterfaceService(&asyncInterface);
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(8);
+    params.setChunkSize(1024);
+    params.setKeySize(content.size());
+    params.setMultiplexIO(true);
+
+    this->open(params);
+    EXPECT_EQ(sizeof(buffer), this->read(buffer, sizeof(buffer)));
+
+    // waits for fetches referring to the chunks.
+    this->close();
+    EXPECT_TRUE(this->getChunkBuffers().empty());
+}
+
+TEST(LatencyTracker, P95OfRecentSamples) {
+    LatencyTracker tracker;
+    for (uint64_t i = 1; i < S3_HEDGE_MIN_SAMPLES; i++) {
+        tracker.add(i);
+    }
+    EXPECT_EQ((uint64_t)0, tracker.getP95());
+
+    for (uint64_t i = S3_HEDGE_MIN_SAMPLES; i <= 20; i++) {
+        tracker.add(i);
+    }
+    EXPECT_EQ((uint64_t)19, tracker.getP95());
+
+    // old samples fall out of the window.
+    for (uint64_t i = 0; i < S3_HEDGE_LATENCY_WINDOW; i++) {
+        tracker.add(1000);
+    }
+    EXPECT_EQ((uint64_t)1000, tracker.getP95());
+
+    tracker.reset();
+    EXPECT_EQ((uint64_t)0, tracker.getP95());
+}
+
+class MockSlowFetchContent : public MockFetchContent {
+   public:
+    MockSlowFetchContent(const string &content, uint64_t delayMs)
+        : MockFetchContent(content), delayMs(delayMs) {
+    }
+
+    uint64_t operator()(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                        const S3Url &sourceUrl) {
+        usleep(this->delayMs * 1000);
+        return MockFetchContent::operator()(offset, data, len, sourceUrl);
+    }
+
+   private:
+    uint64_t delayMs;
+};
+
+TEST_F(S3KeyReaderTest, HedgedFetchOvertakesSlowChunk) {
+    string content;
+    for (uint64_t i = 0; content.size() < 64 * 64; i++) {
+        content.append(std::to_string((unsigned long long)i) + "\n");
+    }
+    content.resize(64 * 64 - 1);
+    content.append("\n");
+
+    // the first fetch of the chunk at 32 * 64 stalls.
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+    EXPECT_CALL(s3Interface, fetchData(32 * 64, _, _, _))
+        .WillOnce(Invoke(MockSlowFetchContent(content, 2000)))
+        .WillOnce(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(64);
+    params.setKeySize(content.size());
+    params.setHedgedFetch(true);
+
+    this->open(params);
+
+    uint64_t startUs = GetCurrentTimeUs();
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, sizeof(buffer))) != 0) {
+        result.append(buffer, len);
+    }
+    EXPECT_LT(GetCurrentTimeUs() - startUs, (uint64_t)1000 * 1000);
+
+    EXPECT_TRUE(content == result);
+}
+
+TEST_F(S3KeyReaderTest, HedgedFetchDisabledByDefault) {
+    string content(64 * 16 - 1, 'x');
+    content.append("\n");
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .Times(16)
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setChunkSize(64);
+    params.setKeySize(content.size());
+
+    this->open(params);
+    EXPECT_FALSE(this->isHedgedFetch());
+
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, sizeof(buffer))) != 0) {
+        result.append(buffer, len);
+    }
+
+    EXPECT_TRUE(content == result);
+}
+
+// ================== S3SmallKeyReaderTest ===================
+class S3SmallKeyReaderTest : public testing::Test, public S3SmallKeyReader {
+   protected:
+    virtual void SetUp() {
+        eolString[0] = '\n';
+        eolString[1] = '\0';
+
+        QueryCancelPending = false;
+
+        this->setS3InterfaceService(&s3Interface);
+    }
+
+    virtual void TearDown() {
+        this->close();
+    }
+
+    char buffer[256];
+
+    MockS3Interface s3Interface;
+};
+
+TEST_F(S3SmallKeyReaderTest, ReadWithSingleFetch) {
+    string content = "abc\ndef";
+    EXPECT_CALL(s3Interface, fetchData(0, _, content.size(), _))
+        .WillOnce(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setKeySize(content.size());
+    this->open(params);
+
+    // opened already, e.g. by a DecompressReader on it.
+    this->open(params);
+
+    EXPECT_EQ(S3_COMPRESSION_PLAIN, this->getCompressionType());
+
+    EXPECT_EQ((uint64_t)5, this->read(buffer, 5));
+    EXPECT_EQ(0, memcmp(buffer, "abc\nd", 5));
+    EXPECT_EQ((uint64_t)2, this->read(buffer, sizeof(buffer)));
+    EXPECT_EQ(0, memcmp(buffer, "ef", 2));
+
+    // EOL is appended to the last line.
+    EXPECT_EQ((uint64_t)1, this->read(buffer, sizeof(buffer)));
+    EXPECT_EQ('\n', buffer[0]);
+    EXPECT_EQ((uint64_t)0, this->read(buffer, sizeof(buffer)));
+}
+
+TEST_F(S3SmallKeyReaderTest, DetectCompressionFromData) {
+    string content("\x1f\x8b\x08\x00", 4);
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _)).WillOnce(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setKeySize(content.size());
+    this->open(params);
+
+    EXPECT_EQ(S3_COMPRESSION_GZIP, this->getCompressionType());
+}
+
+TEST_F(S3SmallKeyReaderTest, ReadWithFetchError) {
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillOnce(Throw(S3FailedAfterRetry("", 1, "")));
+
+    S3Params params("s3://abc/def");
+    params.setKeySize(16);
+    this->open(params);
+
+    EXPECT_THROW(this->read(buffer, sizeof(buffer)), S3FailedAfterRetry);
+}
+
+TEST_F(S3SmallKeyReaderTest, ReadOnIOThread) {
+    string content = "line1\nline2\n";
+
+    MockAsyncS3Interface asyncInterface;
+    EXPECT_CALL(asyncInterface, fetchData(_, _, _, _))
+        .WillOnce(Invoke(MockFetchContent(content)));
+    this->setS3InterfaceService(&asyncInterface);
+
+    S3Params params("s3://abc/def");
+    params.setKeySize(content.size());
+    this->open(params);
+
+    EXPECT_EQ(content.size(), this->read(buffer, sizeof(buffer)));
+    EXPECT_EQ(0, memcmp(buffer, content.c_str(), content.size()));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, sizeof(buffer)));
+
+    this->close();
+}
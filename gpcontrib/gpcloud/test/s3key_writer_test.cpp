@@ -1,4 +1,7 @@
 #include "s3key_writer.cpp"
+
+#include <set>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "mock_classes.h"
@@ -6,6 +9,7 @@
 using ::testing::_;
 using ::testing::AtLeast;
 using ::testing::AtMost;
+using ::testing::ElementsAre;
 using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::Throw;
@@ -69,8 +73,8 @@ TEST_F(S3KeyWriterTest, TestSmallWrite) {
 
     char data[0x10];
     EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadId"));
-    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, _, _)).WillOnce(Return("\"etag\""));
-    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _)).WillOnce(Return(true));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, _, _, _)).WillOnce(Return("\"etag\""));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _, _)).WillOnce(Return(true));
 
     this->open(testParams);
     ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
@@ -80,13 +84,34 @@ TEST_F(S3KeyWriterTest, TestSmallWrite) {
     this->close();
 }
 
+TEST_F(S3KeyWriterTest, TestUploadWithChecksums) {
+    testParams.setChunkSize(5);
+    testParams.setCrc32cChecksum(true);
+
+    EXPECT_CALL(mockS3Interface, getUploadId(_)).WillOnce(Return("uploadId"));
+    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, 1, _, Crc32cToBase64(Crc32c(0, "12345", 5))))
+        .WillOnce(Return("\"etag1\""));
+    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, 2, _, Crc32cToBase64(Crc32c(0, "6789", 4))))
+        .WillOnce(Return("\"etag2\""));
+    EXPECT_CALL(this->mockS3Interface,
+                completeMultiPart(_, _, ElementsAre("\"etag1\"", "\"etag2\""),
+                                  ElementsAre(Crc32cToBase64(Crc32c(0, "12345", 5)),
+                                              Crc32cToBase64(Crc32c(0, "6789", 4)))))
+        .WillOnce(Return(true));
+
+    this->open(testParams);
+    EXPECT_EQ((uint64_t)3, this->write("123", 3));
+    EXPECT_EQ((uint64_t)6, this->write("456789", 6));
+    this->close();
+}
+
 TEST_F(S3KeyWriterTest, TestChunkSizeSmallerThanInput) {
     testParams.setChunkSize(0x100);
     EXPECT_CALL(mockS3Interface, getUploadId(_)).WillOnce(Return("uploadId"));
-    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _))
+    EXPECT_CALL(mockS3Interface, uploadPartOfData(_, _, _, _, _))
         .WillOnce(Return("\"etag1\""))
         .WillOnce(Return("\"etag2\""));
-    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _)).WillOnce(Return(true));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _, _)).WillOnce(Return(true));
 
     char data[0x101];
     this->open(testParams);
@@ -104,7 +129,7 @@ class MockUploadPartOfData {
     }
 
     string operator()(S3VectorUInt8 &data, const S3Url &s3Url, uint64_t partNumber,
-                      const string &uploadId) {
+                      const string &uploadId, const string &checksum) {
         EXPECT_EQ(data.size(), expectedLength);
         return "\"etag\"";
     }
@@ -118,11 +143,11 @@ TEST_F(S3KeyWriterTest, TestBufferedWrite) {
 
     char data[0x100];
     EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadid1"));
-    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid1"))
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid1", _))
         .WillOnce(Invoke(MockUploadPartOfData(0x100)));
-    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 2, "uploadid1"))
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 2, "uploadid1", _))
         .WillOnce(Invoke(MockUploadPartOfData(0x1)));
-    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _)).WillOnce(Return(true));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _, _)).WillOnce(Return(true));
 
     this->open(testParams);
     ASSERT_EQ((uint64_t)0x80, this->write(data, 0x80));
@@ -139,8 +164,8 @@ TEST_F(S3KeyWriterTest, TestUploadContent) {
 
     char data[] = "The quick brown fox jumps over the lazy dog";
     EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadId"));
-    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, _, _)).WillOnce(Return("\"etag\""));
-    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _)).WillOnce(Return(true));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, _, _, _)).WillOnce(Return("\"etag\""));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _, _)).WillOnce(Return(true));
 
     this->open(testParams);
     ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
@@ -171,7 +196,7 @@ TEST_F(S3KeyWriterTest, TestWriteAbortInClosing) {
 
     char data[0x100];
     EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadid1"));
-    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid1"))
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid1", _))
         .WillOnce(Invoke(MockUploadPartOfData(0x100)));
     EXPECT_CALL(this->mockS3Interface, abortUpload(_, _)).WillOnce(Return(true));
 
@@ -186,3 +211,187 @@ TEST_F(S3KeyWriterTest, TestWriteAbortInClosing) {
     EXPECT_THROW(this->close(), S3QueryAbort);
     QueryCancelPending = false;
 }
+
+TEST_F(S3KeyWriterTest, TestMultiplexedUpload) {
+    testParams.setChunkSize(0x100);
+    testParams.setMultiplexIO(true);
+
+    char data[0x201];
+    EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadid1"));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid1", _))
+        .WillOnce(Return("\"etag1\""));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 2, "uploadid1", _))
+        .WillOnce(Return("\"etag2\""));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 3, "uploadid1", _))
+        .WillOnce(Invoke(MockUploadPartOfData(0x1)));
+    EXPECT_CALL(this->mockS3Interface,
+                completeMultiPart(_, "uploadid1",
+                                  ElementsAre("\"etag1\"", "\"etag2\"", "\"etag\""), _))
+        .WillOnce(Return(true));
+
+    this->open(testParams);
+    ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
+
+    // no uploading thread is created.
+    EXPECT_TRUE(this->threadList.empty());
+
+    this->close();
+    EXPECT_EQ((uint64_t)0, this->activeThreads);
+}
+
+TEST_F(S3KeyWriterTest, TestMultiplexedUploadError) {
+    testParams.setChunkSize(0x100);
+    testParams.setMultiplexIO(true);
+
+    char data[0x201];
+    EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadid1"));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid1", _))
+        .WillOnce(Throw(S3FailedAfterRetry("", 3, "")));
+    EXPECT_CALL(this->mockS3Interface, abortUpload(_, "uploadid1")).WillOnce(Return(true));
+
+    this->open(testParams);
+    EXPECT_THROW(this->write(data, sizeof(data)), S3FailedAfterRetry);
+    EXPECT_EQ((uint64_t)0, this->activeThreads);
+
+    // the key missing a part is aborted instead of completed.
+    this->close();
+}
+
+class RecordPartBuffer {
+   public:
+    RecordPartBuffer(std::set<const uint8_t *> &buffers) : buffers(buffers) {
+    }
+
+    string operator()(S3VectorUInt8 &data, const S3Url &s3Url, uint64_t partNumber,
+                      const string &uploadId, const string &checksum) {
+        this->buffers.insert(data.data());
+        EXPECT_EQ(data.capacity(), (uint64_t)0x100);
+        return "\"etag\"";
+    }
+
+   private:
+    std::set<const uint8_t *> &buffers;
+};
+
+TEST_F(S3KeyWriterTest, TestRingRecyclesPartBuffers) {
+    testParams.setChunkSize(0x100);
+    testParams.setMultiplexIO(true);
+
+    // parts of the ring and the buffer use all chunks preallocated for the writer.
+    PrepareS3MemContext(testParams);
+
+    std::set<const uint8_t *> buffers;
+    char data[0x500];
+    EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadid1"));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, _, "uploadid1", _))
+        .Times(5)
+        .WillRepeatedly(Invoke(RecordPartBuffer(buffers)));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, "uploadid1", _, _))
+        .WillOnce(Return(true));
+
+    this->open(testParams);
+    ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
+
+    // each part is finished before the next one is queued, so two buffers are swapped in turn.
+    EXPECT_EQ((uint64_t)2, buffers.size());
+    EXPECT_EQ((uint64_t)3, this->freeParts.size());
+    EXPECT_EQ((uint64_t)0, this->getRingStalls());
+    EXPECT_EQ((uint64_t)100 / 3, this->getRingUtilization());
+
+    this->close();
+    EXPECT_TRUE(this->parts.empty());
+}
+
+string SlowUploadPartOfData(S3VectorUInt8 &data, const S3Url &s3Url, uint64_t partNumber,
+                            const string &uploadId, const string &checksum) {
+    usleep(50 * 1000);
+    return "\"etag\"";
+}
+
+TEST_F(S3KeyWriterTest, TestRingStallsWhenFull) {
+    testParams.setChunkSize(0x100);
+    testParams.setNumOfChunks(1);
+
+    char data[0x200];
+    EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadid1"));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, _, "uploadid1", _))
+        .Times(2)
+        .WillRepeatedly(Invoke(SlowUploadPartOfData));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, "uploadid1", _, _))
+        .WillOnce(Return(true));
+
+    this->open(testParams);
+    ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
+
+    // the second part waits for the only part of the ring to be uploaded.
+    EXPECT_EQ((uint64_t)1, this->getRingStalls());
+    EXPECT_LT((uint64_t)0, this->getRingStallUs());
+    EXPECT_EQ((uint64_t)100, this->getRingUtilization());
+
+    this->close();
+}
+
+TEST_F(S3KeyWriterTest, TestRolloverStartsNewUpload) {
+    testParams.setChunkSize(0x100);
+    testParams.setMultiplexIO(true);
+
+    char data[0x180];
+    EXPECT_CALL(this->mockS3Interface, getUploadId(_))
+        .WillOnce(Return("uploadid1"))
+        .WillOnce(Return("uploadid2"));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid1", _))
+        .WillOnce(Invoke(MockUploadPartOfData(0x100)));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 2, "uploadid1", _))
+        .WillOnce(Invoke(MockUploadPartOfData(0x80)));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, "uploadid2", _))
+        .WillOnce(Invoke(MockUploadPartOfData(0x100)));
+    EXPECT_CALL(this->mockS3Interface,
+                completeMultiPart(_, "uploadid1", ElementsAre("\"etag\"", "\"etag\""), _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(this->mockS3Interface,
+                completeMultiPart(_, "uploadid2", ElementsAre("\"etag\""), _))
+        .WillOnce(Return(true));
+
+    this->open(testParams);
+    ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
+    EXPECT_EQ((uint64_t)0x180, this->getKeySize());
+
+    // the last part of the first key is smaller than the chunk.
+    this->rollover(S3Url("s3://abc/def2"));
+    EXPECT_EQ((uint64_t)0, this->getKeySize());
+    EXPECT_EQ((uint64_t)2, this->getNumOfKeys());
+
+    // parts of the first key are uploaded, it's completed at once.
+    EXPECT_TRUE(this->rolledKeys.empty());
+
+    ASSERT_EQ((uint64_t)0x100, this->write(data, 0x100));
+    this->close();
+}
+
+TEST_F(S3KeyWriterTest, TestRolloverWhilePartsUploading) {
+    testParams.setChunkSize(0x100);
+
+    char data[0x100];
+    EXPECT_CALL(this->mockS3Interface, getUploadId(_))
+        .WillOnce(Return("uploadid1"))
+        .WillOnce(Return("uploadid2"));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, 1, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke(SlowUploadPartOfData));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, "uploadid1", _, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, "uploadid2", _, _))
+        .WillOnce(Return(true));
+
+    this->open(testParams);
+    ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
+    this->rollover(S3Url("s3://abc/def2"));
+    ASSERT_EQ(sizeof(data), this->write(data, sizeof(data)));
+
+    // the part of the first key is still being uploaded together with the one of the second.
+    EXPECT_EQ((uint64_t)1, this->rolledKeys.size());
+    EXPECT_EQ((uint64_t)2, this->activeThreads);
+
+    this->close();
+    EXPECT_TRUE(this->rolledKeys.empty());
+}
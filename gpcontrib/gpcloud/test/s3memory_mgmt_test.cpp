@@ -0,0 +1,119 @@
+#include "s3memory_mgmt.cpp"
+
+#include "gtest/gtest.h"
+
+#define CHUNK_SIZE (1024 * 1024)
+
+TEST(S3ChunkPool, ReuseReleasedChunk) {
+    S3ChunkPool pool;
+    pool.configure(4 * CHUNK_SIZE, 60, false);
+
+    void* p = pool.acquire(CHUNK_SIZE);
+    ASSERT_TRUE(p != NULL);
+    memset(p, 'a', CHUNK_SIZE);
+
+    pool.release(p, CHUNK_SIZE);
+    EXPECT_EQ((uint64_t)CHUNK_SIZE, pool.getCachedBytes());
+
+    EXPECT_EQ(p, pool.acquire(CHUNK_SIZE));
+    EXPECT_EQ((uint64_t)0, pool.getCachedBytes());
+
+    pool.release(p, CHUNK_SIZE);
+}
+
+TEST(S3ChunkPool, NoReuseOfOtherSize) {
+    S3ChunkPool pool;
+    pool.configure(4 * CHUNK_SIZE, 60, false);
+
+    void* p = pool.acquire(CHUNK_SIZE);
+    ASSERT_TRUE(p != NULL);
+    pool.release(p, CHUNK_SIZE);
+
+    void* q = pool.acquire(2 * CHUNK_SIZE);
+    ASSERT_TRUE(q != NULL);
+    EXPECT_EQ((uint64_t)CHUNK_SIZE, pool.getCachedBytes());
+
+    pool.release(q, 2 * CHUNK_SIZE);
+    EXPECT_EQ((uint64_t)3 * CHUNK_SIZE, pool.getCachedBytes());
+}
+
+TEST(S3ChunkPool, KeepNoMoreThanCapacity) {
+    S3ChunkPool pool;
+    pool.configure(2 * CHUNK_SIZE, 60, false);
+
+    void* chunks[3];
+    for (int i = 0; i < 3; i++) {
+        chunks[i] = pool.acquire(CHUNK_SIZE);
+        ASSERT_TRUE(chunks[i] != NULL);
+    }
+    for (int i = 0; i < 3; i++) {
+        pool.release(chunks[i], CHUNK_SIZE);
+    }
+
+    EXPECT_EQ((uint64_t)2 * CHUNK_SIZE, pool.getCachedBytes());
+}
+
+TEST(S3ChunkPool, TrimIdleChunks) {
+    S3ChunkPool pool;
+    pool.configure(4 * CHUNK_SIZE, 60, false);
+
+    pool.release(pool.acquire(CHUNK_SIZE), CHUNK_SIZE);
+    EXPECT_EQ((uint64_t)CHUNK_SIZE, pool.getCachedBytes());
+
+    pool.trim(time(NULL) + 30);
+    EXPECT_EQ((uint64_t)CHUNK_SIZE, pool.getCachedBytes());
+
+    pool.trim(time(NULL) + 61);
+    EXPECT_EQ((uint64_t)0, pool.getCachedBytes());
+}
+
+TEST(S3ChunkPool, DisableUnmapsChunks) {
+    S3ChunkPool pool;
+    pool.configure(4 * CHUNK_SIZE, 60, false);
+    EXPECT_TRUE(pool.isEnabled());
+
+    pool.release(pool.acquire(CHUNK_SIZE), CHUNK_SIZE);
+    pool.configure(0, 60, false);
+
+    EXPECT_FALSE(pool.isEnabled());
+    EXPECT_EQ((uint64_t)0, pool.getCachedBytes());
+}
+
+TEST(S3ChunkPool, HugePages) {
+    S3ChunkPool pool;
+    pool.configure(4 * CHUNK_SIZE, 60, true);
+
+    void* p = pool.acquire(3 * CHUNK_SIZE);
+    ASSERT_TRUE(p != NULL);
+    memset(p, 'a', 3 * CHUNK_SIZE);
+
+    pool.release(p, 3 * CHUNK_SIZE);
+    EXPECT_EQ((uint64_t)3 * CHUNK_SIZE, pool.getCachedBytes());
+}
+
+TEST(S3ChunkPool, PreAllocatedMemoryKeepsChunks) {
+    GetS3ChunkPool().configure(4 * CHUNK_SIZE, 60, false);
+
+    void* first;
+    {
+        PreAllocatedMemory memory(CHUNK_SIZE, 2);
+        first = memory.Allocate();
+        ASSERT_TRUE(first != NULL);
+        memory.Deallocate(first);
+    }
+    EXPECT_EQ((uint64_t)2 * CHUNK_SIZE, GetS3ChunkPool().getCachedBytes());
+
+    {
+        PreAllocatedMemory memory(CHUNK_SIZE, 2);
+        EXPECT_EQ((uint64_t)0, GetS3ChunkPool().getCachedBytes());
+
+        void* p = memory.Allocate();
+        void* q = memory.Allocate();
+        EXPECT_TRUE((p == first) || (q == first));
+        memory.Deallocate(p);
+        memory.Deallocate(q);
+    }
+
+    GetS3ChunkPool().configure(0, 60, false);
+    EXPECT_EQ((uint64_t)0, GetS3ChunkPool().getCachedBytes());
+}
@@ -0,0 +1,153 @@
+#include "s3rate_limiter.cpp"
+
+#include "gtest/gtest.h"
+
+#define SECOND_US (1000 * 1000)
+
+class S3RateLimiterTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        char dirTemplate[] = "/tmp/gpcloud_rate_test_XXXXXX";
+        ASSERT_TRUE(mkdtemp(dirTemplate) != NULL);
+        this->dir = dirTemplate;
+        this->path = this->dir + "/rate";
+    }
+
+    virtual void TearDown() {
+        unlink(this->path.c_str());
+        rmdir(this->dir.c_str());
+    }
+
+    string dir;
+    string path;
+};
+
+TEST_F(S3RateLimiterTest, DisabledByZeroRate) {
+    S3RateLimiter limiter;
+    limiter.setup(this->path, 0, 0, 1, SECOND_US);
+
+    EXPECT_FALSE(limiter.isEnabled());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ((uint64_t)0, limiter.reserve(SECOND_US));
+    }
+}
+
+TEST_F(S3RateLimiterTest, WaitAfterBurst) {
+    S3RateLimiter limiter;
+    limiter.setup(this->path, 10, 0, 1, SECOND_US);
+
+    // a second of requests is sent at once.
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ((uint64_t)0, limiter.reserve(SECOND_US));
+    }
+
+    EXPECT_EQ((uint64_t)SECOND_US / 10, limiter.reserve(SECOND_US));
+    EXPECT_EQ((uint64_t)SECOND_US * 2 / 10, limiter.reserve(SECOND_US));
+
+    // tokens reserved ahead are filled as time passes.
+    EXPECT_EQ((uint64_t)SECOND_US / 10, limiter.reserve(SECOND_US * 12 / 10));
+}
+
+TEST_F(S3RateLimiterTest, ShareOfSegments) {
+    S3RateLimiter first;
+    first.setup(this->path, 40, 0, 4, SECOND_US);
+    EXPECT_DOUBLE_EQ(10, first.getHostRate(SECOND_US));
+
+    // a second segment on the host adds its share.
+    S3RateLimiter second;
+    second.setup(this->path, 40, 1, 4, SECOND_US);
+    EXPECT_DOUBLE_EQ(20, first.getHostRate(SECOND_US));
+    EXPECT_DOUBLE_EQ(20, second.getHostRate(SECOND_US));
+
+    // but more processes of the same segment don't.
+    S3RateLimiter third;
+    third.setup(this->path, 40, 1, 4, SECOND_US);
+    EXPECT_DOUBLE_EQ(20, third.getHostRate(SECOND_US));
+
+    second.setup("", 0, 0, 1, SECOND_US);
+    third.setup("", 0, 0, 1, SECOND_US);
+    EXPECT_DOUBLE_EQ(10, first.getHostRate(SECOND_US));
+}
+
+TEST_F(S3RateLimiterTest, ShareTokensThroughFile) {
+    S3RateLimiter first;
+    first.setup(this->path, 10, 0, 1, SECOND_US);
+
+    S3RateLimiter second;
+    second.setup(this->path, 10, 0, 1, SECOND_US);
+
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ((uint64_t)0, first.reserve(SECOND_US));
+        EXPECT_EQ((uint64_t)0, second.reserve(SECOND_US));
+    }
+
+    EXPECT_EQ((uint64_t)SECOND_US / 10, first.reserve(SECOND_US));
+    EXPECT_EQ((uint64_t)SECOND_US * 2 / 10, second.reserve(SECOND_US));
+}
+
+TEST_F(S3RateLimiterTest, LocalStateWithoutFile) {
+    S3RateLimiter limiter;
+    limiter.setup(this->dir + "/not_exist/rate", 10, 0, 1, SECOND_US);
+
+    EXPECT_TRUE(limiter.isEnabled());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ((uint64_t)0, limiter.reserve(SECOND_US));
+    }
+    EXPECT_EQ((uint64_t)SECOND_US / 10, limiter.reserve(SECOND_US));
+}
+
+TEST_F(S3RateLimiterTest, UnreserveGivesBackToken) {
+    S3RateLimiter limiter;
+    limiter.setup(this->path, 10, 0, 1, SECOND_US);
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ((uint64_t)0, limiter.reserve(SECOND_US));
+    }
+    EXPECT_EQ((uint64_t)SECOND_US / 10, limiter.reserve(SECOND_US));
+
+    limiter.unreserve();
+    EXPECT_EQ((uint64_t)SECOND_US / 10, limiter.reserve(SECOND_US));
+}
+
+TEST_F(S3RateLimiterTest, HalveRateWhenThrottled) {
+    S3RateLimiter limiter;
+    limiter.setup(this->path, 64, 0, 1, SECOND_US);
+
+    limiter.throttled(SECOND_US);
+    EXPECT_DOUBLE_EQ(32, limiter.getHostRate(SECOND_US));
+
+    // the bucket is emptied.
+    EXPECT_EQ((uint64_t)SECOND_US / 32, limiter.reserve(SECOND_US));
+
+    // requests throttled together lower the rate once.
+    limiter.throttled(SECOND_US + 1000);
+    limiter.throttled(SECOND_US + 2000);
+    EXPECT_DOUBLE_EQ(32, limiter.getHostRate(SECOND_US + 2000));
+
+    limiter.throttled(SECOND_US * 2);
+    EXPECT_DOUBLE_EQ(16, limiter.getHostRate(SECOND_US * 2));
+}
+
+TEST_F(S3RateLimiterTest, KeepMinimalRate) {
+    S3RateLimiter limiter;
+    limiter.setup(this->path, 64, 0, 1, SECOND_US);
+
+    for (int i = 1; i <= 10; i++) {
+        limiter.throttled((uint64_t)SECOND_US * i);
+    }
+    EXPECT_DOUBLE_EQ(1, limiter.getHostRate(SECOND_US * 10));
+}
+
+TEST_F(S3RateLimiterTest, RecoverAfterThrottled) {
+    S3RateLimiter limiter;
+    limiter.setup(this->path, 100, 0, 1, SECOND_US);
+
+    limiter.throttled(SECOND_US);
+    EXPECT_DOUBLE_EQ(50, limiter.getHostRate(SECOND_US));
+
+    // no growth within the interval after the throttled request.
+    EXPECT_DOUBLE_EQ(50, limiter.getHostRate(SECOND_US * 15 / 10));
+
+    EXPECT_DOUBLE_EQ(55, limiter.getHostRate(SECOND_US * 25 / 10));
+    EXPECT_DOUBLE_EQ(100, limiter.getHostRate(SECOND_US * 20));
+}
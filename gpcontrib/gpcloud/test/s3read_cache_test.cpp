@@ -0,0 +1,158 @@
+#include "s3read_cache.cpp"
+
+#include <sys/time.h>
+
+#include "gtest/gtest.h"
+
+class S3ReadCacheTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        char tmpl[] = "/tmp/gpcloud_read_cache_XXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl) != NULL);
+        dir = tmpl;
+    }
+
+    virtual void TearDown() {
+        DIR *dirp = opendir(dir.c_str());
+        if (dirp != NULL) {
+            struct dirent *ent;
+            while ((ent = readdir(dirp)) != NULL) {
+                if ((strcmp(ent->d_name, ".") != 0) && (strcmp(ent->d_name, "..") != 0)) {
+                    unlink((dir + "/" + ent->d_name).c_str());
+                }
+            }
+            closedir(dirp);
+        }
+        rmdir(dir.c_str());
+    }
+
+    S3VectorUInt8 makeData(uint64_t len, uint8_t c) {
+        S3VectorUInt8 data(len);
+        memset(data.data(), c, len);
+        return data;
+    }
+
+    bool exists(const string &path) {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0;
+    }
+
+    void setMtime(const string &path, time_t sec) {
+        struct timeval tv[2] = {{sec, 0}, {sec, 0}};
+        ASSERT_EQ(0, utimes(path.c_str(), tv));
+    }
+
+    string dir;
+    S3ReadCache cache;
+    S3Url s3Url{"https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever"};
+};
+
+TEST_F(S3ReadCacheTest, DisabledByDefault) {
+    S3VectorUInt8 data;
+
+    EXPECT_FALSE(cache.isEnabled());
+
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+    EXPECT_FALSE(cache.load(s3Url, "etag", 0, 16, data));
+}
+
+TEST_F(S3ReadCacheTest, MissThenHit) {
+    cache.setup(dir, 1024);
+    ASSERT_TRUE(cache.isEnabled());
+
+    S3VectorUInt8 data;
+    EXPECT_FALSE(cache.load(s3Url, "etag", 0, 16, data));
+
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+    ASSERT_TRUE(cache.load(s3Url, "etag", 0, 16, data));
+    EXPECT_TRUE(this->makeData(16, 'a') == data);
+}
+
+TEST_F(S3ReadCacheTest, MissOnDifferentETagOrRange) {
+    cache.setup(dir, 1024);
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+
+    S3VectorUInt8 data;
+    EXPECT_FALSE(cache.load(s3Url, "new etag", 0, 16, data));
+    EXPECT_FALSE(cache.load(s3Url, "etag", 16, 16, data));
+    EXPECT_FALSE(cache.load(s3Url, "etag", 0, 8, data));
+
+    S3Url other("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/other");
+    EXPECT_FALSE(cache.load(other, "etag", 0, 16, data));
+
+    EXPECT_TRUE(cache.load(s3Url, "etag", 0, 16, data));
+}
+
+TEST_F(S3ReadCacheTest, RemoveCorruptedEntry) {
+    cache.setup(dir, 1024);
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+
+    string path = cache.getEntryPath(s3Url, "etag", 0, 16);
+    ASSERT_EQ(0, truncate(path.c_str(), 8));
+
+    S3VectorUInt8 data;
+    EXPECT_FALSE(cache.load(s3Url, "etag", 0, 16, data));
+    EXPECT_TRUE(data.empty());
+    EXPECT_FALSE(this->exists(path));
+}
+
+TEST_F(S3ReadCacheTest, EvictLeastRecentlyUsed) {
+    cache.setup(dir, 40);
+
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+    cache.save(s3Url, "etag", 16, this->makeData(16, 'b'));
+
+    string first = cache.getEntryPath(s3Url, "etag", 0, 16);
+    string second = cache.getEntryPath(s3Url, "etag", 16, 16);
+    this->setMtime(first, 2000);
+    this->setMtime(second, 1000);
+
+    // the second entry is the least recently used one.
+    cache.save(s3Url, "etag", 32, this->makeData(16, 'c'));
+
+    EXPECT_TRUE(this->exists(first));
+    EXPECT_FALSE(this->exists(second));
+    EXPECT_TRUE(this->exists(cache.getEntryPath(s3Url, "etag", 32, 16)));
+}
+
+TEST_F(S3ReadCacheTest, LoadMarksEntryRecentlyUsed) {
+    cache.setup(dir, 40);
+
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+    cache.save(s3Url, "etag", 16, this->makeData(16, 'b'));
+
+    string first = cache.getEntryPath(s3Url, "etag", 0, 16);
+    string second = cache.getEntryPath(s3Url, "etag", 16, 16);
+    this->setMtime(first, 1000);
+    this->setMtime(second, 2000);
+
+    S3VectorUInt8 data;
+    ASSERT_TRUE(cache.load(s3Url, "etag", 0, 16, data));
+
+    cache.save(s3Url, "etag", 32, this->makeData(16, 'c'));
+
+    EXPECT_TRUE(this->exists(first));
+    EXPECT_FALSE(this->exists(second));
+}
+
+TEST_F(S3ReadCacheTest, EvictLeavesOtherFilesAlone) {
+    string other = dir + "/other_file";
+    int fd = ::open(other.c_str(), O_WRONLY | O_CREAT, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(writeFully(fd, this->makeData(64, 'x').data(), 64));
+    ::close(fd);
+
+    cache.setup(dir, 16);
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+
+    EXPECT_TRUE(this->exists(other));
+    EXPECT_TRUE(this->exists(cache.getEntryPath(s3Url, "etag", 0, 16)));
+}
+
+TEST_F(S3ReadCacheTest, EntryLargerThanCapacityIsNotKept) {
+    cache.setup(dir, 8);
+    cache.save(s3Url, "etag", 0, this->makeData(16, 'a'));
+
+    S3VectorUInt8 data;
+    EXPECT_FALSE(cache.load(s3Url, "etag", 0, 16, data));
+}
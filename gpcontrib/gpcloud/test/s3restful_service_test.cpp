@@ -338,3 +338,215 @@ TEST(S3RESTfulService, GetWithWrongProxyUrl) {
 
     EXPECT_THROW(service.get(url, headers), S3ResolveError);
 }
+
+TEST(CURLHandlePool, ReuseReleasedHandle) {
+    CURLHandlePool pool;
+
+    CURL *curl = pool.acquire();
+    EXPECT_TRUE(curl != NULL);
+    EXPECT_EQ((uint64_t)0, pool.getIdleCount());
+
+    pool.release(curl, true);
+    EXPECT_EQ((uint64_t)1, pool.getIdleCount());
+
+    EXPECT_EQ(curl, pool.acquire());
+    EXPECT_EQ((uint64_t)0, pool.getIdleCount());
+
+    pool.release(curl, true);
+}
+
+TEST(CURLHandlePool, DropUnreusableHandle) {
+    CURLHandlePool pool;
+
+    CURL *curl = pool.acquire();
+    pool.release(curl, false);
+
+    EXPECT_EQ((uint64_t)0, pool.getIdleCount());
+}
+
+TEST(CURLHandlePool, ClearIdleHandles) {
+    CURLHandlePool pool;
+
+    CURL *first = pool.acquire();
+    CURL *second = pool.acquire();
+    EXPECT_NE(first, second);
+
+    pool.release(first, true);
+    pool.release(second, true);
+    EXPECT_EQ((uint64_t)2, pool.getIdleCount());
+
+    pool.clear();
+    EXPECT_EQ((uint64_t)0, pool.getIdleCount());
+
+    // pool is still usable after clear()
+    pool.release(pool.acquire(), true);
+    EXPECT_EQ((uint64_t)1, pool.getIdleCount());
+}
+
+TEST(CURLHandlePool, ReleaseNullHandle) {
+    CURLHandlePool pool;
+
+    pool.release(NULL, true);
+    EXPECT_EQ((uint64_t)0, pool.getIdleCount());
+}
+
+// Records responses of asynchronous requests, wait() returns once 'expected' of them arrived.
+class AsyncResponseRecorder : public RESTfulCallback {
+   public:
+    AsyncResponseRecorder(uint64_t expected, bool cancelled = false)
+        : expected(expected), cancelled(cancelled), startTimeUs(0), errors(0) {
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->cond, NULL);
+    }
+    ~AsyncResponseRecorder() {
+        pthread_mutex_destroy(&this->mutex);
+        pthread_cond_destroy(&this->cond);
+    }
+
+    bool isCancelled() {
+        return cancelled;
+    }
+
+    uint64_t getStartTimeUs() {
+        return startTimeUs;
+    }
+
+    void onResponse(Response &response, std::exception_ptr error) {
+        UniqueLock lock(&this->mutex);
+
+        if (error != NULL) {
+            this->errors++;
+        }
+        this->data.push_back(
+            string(response.getRawData().begin(), response.getRawData().end()));
+        this->threads.push_back(pthread_self());
+
+        pthread_cond_signal(&this->cond);
+    }
+
+    void wait() {
+        UniqueLock lock(&this->mutex);
+        while (this->data.size() < this->expected) {
+            pthread_cond_wait(&this->cond, &this->mutex);
+        }
+    }
+
+    uint64_t expected;
+    bool cancelled;
+    uint64_t startTimeUs;
+    uint64_t errors;
+    vector<string> data;
+    vector<pthread_t> threads;
+
+   private:
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+class S3RESTfulServiceAsyncTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        char tmpl[] = "/tmp/gpcloud_async_XXXXXX";
+        int fd = mkstemp(tmpl);
+        ASSERT_GE(fd, 0);
+        path = tmpl;
+
+        for (int i = 0; content.size() < 256 * 1024; i++) {
+            content.append(std::to_string((long long)i) + "\n");
+        }
+        ASSERT_EQ((ssize_t)content.size(), ::write(fd, content.data(), content.size()));
+        ::close(fd);
+
+        params.setMultiplexIO(true);
+        params.setChunkSize(64 * 1024);
+    }
+
+    virtual void TearDown() {
+        unlink(path.c_str());
+    }
+
+    string path;
+    string content;
+    S3Params params;
+};
+
+TEST_F(S3RESTfulServiceAsyncTest, NotSupportedWithoutMultiplexIO) {
+    HTTPHeaders headers;
+    S3RESTfulService service;
+    AsyncResponseRecorder recorder(0);
+
+    EXPECT_FALSE(service.getAsync("file://" + path, headers, &recorder));
+    EXPECT_FALSE(service.putAsync("file://" + path, headers, S3VectorUInt8(), &recorder));
+}
+
+TEST_F(S3RESTfulServiceAsyncTest, GetOnIOThread) {
+    S3RESTfulService service(params);
+    AsyncResponseRecorder recorder(8);
+
+    HTTPHeaders headers[8];
+    for (int i = 0; i < 8; i++) {
+        ASSERT_TRUE(service.getAsync("file://" + path, headers[i], &recorder));
+    }
+    recorder.wait();
+
+    EXPECT_EQ((uint64_t)0, recorder.errors);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(content == recorder.data[i]);
+
+        // all requests are run by the same thread, which is not the caller.
+        EXPECT_FALSE(pthread_equal(pthread_self(), recorder.threads[i]));
+        EXPECT_TRUE(pthread_equal(recorder.threads[0], recorder.threads[i]));
+    }
+}
+
+TEST_F(S3RESTfulServiceAsyncTest, CancelledGetFails) {
+    S3RESTfulService service(params);
+    AsyncResponseRecorder recorder(1, true);
+
+    HTTPHeaders headers;
+    ASSERT_TRUE(service.getAsync("file://" + path, headers, &recorder));
+    recorder.wait();
+
+    EXPECT_EQ((uint64_t)1, recorder.errors);
+}
+
+TEST_F(S3RESTfulServiceAsyncTest, GetFromWrongURLFails) {
+    S3RESTfulService service(params);
+    AsyncResponseRecorder recorder(1);
+
+    HTTPHeaders headers;
+    ASSERT_TRUE(service.getAsync("file://" + path + ".missing", headers, &recorder));
+    recorder.wait();
+
+    EXPECT_EQ((uint64_t)1, recorder.errors);
+}
+
+TEST_F(S3RESTfulServiceAsyncTest, DelayedGetStartsAtStartTime) {
+    S3RESTfulService service(params);
+    AsyncResponseRecorder delayed(1);
+    AsyncResponseRecorder immediate(1);
+
+    uint64_t startUs = GetCurrentTimeUs();
+    delayed.startTimeUs = startUs + 200 * 1000;
+
+    HTTPHeaders headers[2];
+    ASSERT_TRUE(service.getAsync("file://" + path, headers[0], &delayed));
+    ASSERT_TRUE(service.getAsync("file://" + path, headers[1], &immediate));
+
+    // the delayed one doesn't hold back others.
+    immediate.wait();
+    EXPECT_LT(GetCurrentTimeUs() - startUs, (uint64_t)200 * 1000);
+
+    delayed.wait();
+    EXPECT_GE(GetCurrentTimeUs() - startUs, (uint64_t)200 * 1000);
+    EXPECT_EQ((uint64_t)0, delayed.errors);
+    EXPECT_TRUE(content == delayed.data[0]);
+}
+
+TEST(CURLMultiDriver, StopWithoutTransfers) {
+    CURLMultiDriver driver;
+
+    EXPECT_EQ((uint64_t)0, driver.getActiveCount());
+    driver.stop();
+    driver.stop();
+}
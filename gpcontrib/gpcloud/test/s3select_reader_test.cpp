@@ -0,0 +1,254 @@
+#include "s3select_reader.cpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+
+// Return the rows of a CSV key in each requested scan range, requests are remembered.
+class MockS3InterfaceForSelect : public MockS3Interface {
+   public:
+    void mockSelect(const S3Url &s3Url, const string &request, S3VectorUInt8 &records) {
+        this->requests.push_back(request);
+
+        string rows;
+        if (!this->results.empty()) {
+            rows = this->results.front();
+            this->results.erase(this->results.begin());
+        }
+        records.insert(records.end(), rows.begin(), rows.end());
+    }
+
+    vector<string> results;
+    vector<string> requests;
+};
+
+static S3ScanDesc MakeCSVScanDesc() {
+    S3ScanDesc scanDesc;
+    scanDesc.csv = true;
+    scanDesc.delimiter = ',';
+    scanDesc.nullString = "";
+    scanDesc.escape = '"';
+    scanDesc.columns = {"id", "name", "price"};
+    scanDesc.projected = {true, true, true};
+    return scanDesc;
+}
+
+static S3ScanQual MakeQual(uint64_t column, S3QualOp op, const string &value, bool numeric) {
+    S3ScanQual qual;
+    qual.column = column;
+    qual.op = op;
+    qual.value = value;
+    qual.numeric = numeric;
+    return qual;
+}
+
+TEST(S3SelectExpression, ProjectedColumns) {
+    S3ScanDesc scanDesc = MakeCSVScanDesc();
+    scanDesc.projected = {true, false, true};
+
+    EXPECT_EQ("SELECT s._1, '', s._3 FROM S3Object s", BuildS3SelectExpression(scanDesc));
+
+    scanDesc.nullString = "it's null";
+    EXPECT_EQ("SELECT s._1, 'it''s null', s._3 FROM S3Object s",
+              BuildS3SelectExpression(scanDesc));
+}
+
+TEST(S3SelectExpression, Quals) {
+    S3ScanDesc scanDesc = MakeCSVScanDesc();
+    scanDesc.quals.push_back(MakeQual(1, S3_QUAL_EQ, "O'Neil", false));
+    scanDesc.quals.push_back(MakeQual(2, S3_QUAL_LT, "1.5", true));
+    scanDesc.quals.push_back(MakeQual(0, S3_QUAL_GE, "10", true));
+
+    EXPECT_EQ(
+        "SELECT s._1, s._2, s._3 FROM S3Object s WHERE s._2 = 'O''Neil' AND "
+        "CASE WHEN s._3 = '' THEN FALSE ELSE CAST(s._3 AS FLOAT) <= CAST('1.5' AS FLOAT) END AND "
+        "CASE WHEN s._1 = '' THEN FALSE ELSE CAST(s._1 AS FLOAT) >= CAST('10' AS FLOAT) END",
+        BuildS3SelectExpression(scanDesc));
+}
+
+TEST(S3SelectExpression, QualsNotPushedDown) {
+    S3ScanDesc scanDesc = MakeCSVScanDesc();
+    scanDesc.quals.push_back(MakeQual(1, S3_QUAL_LT, "abc", false));
+    scanDesc.quals.push_back(MakeQual(2, S3_QUAL_EQ, "NaN", true));
+    scanDesc.quals.push_back(MakeQual(2, S3_QUAL_GT, "1e400", true));
+    scanDesc.quals.push_back(MakeQual(5, S3_QUAL_EQ, "1", true));
+
+    EXPECT_EQ("SELECT s._1, s._2, s._3 FROM S3Object s", BuildS3SelectExpression(scanDesc));
+    EXPECT_FALSE(S3SelectCanPushDown(scanDesc));
+
+    scanDesc.quals.push_back(MakeQual(0, S3_QUAL_EQ, "1", true));
+    EXPECT_TRUE(S3SelectCanPushDown(scanDesc));
+}
+
+TEST(S3SelectExpression, CanPushDown) {
+    S3ScanDesc scanDesc = MakeCSVScanDesc();
+    EXPECT_FALSE(S3SelectCanPushDown(scanDesc));
+
+    scanDesc.projected = {true, false, true};
+    EXPECT_TRUE(S3SelectCanPushDown(scanDesc));
+
+    scanDesc.csv = false;
+    EXPECT_FALSE(S3SelectCanPushDown(scanDesc));
+
+    // gpcheckcloud knows nothing about the table.
+    EXPECT_FALSE(S3SelectCanPushDown(S3ScanDesc()));
+}
+
+class S3SelectRequestTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        eolString[0] = '\n';
+        eolString[1] = '\0';
+        hasHeader = false;
+    }
+
+    virtual void TearDown() {
+        hasHeader = false;
+    }
+};
+
+TEST_F(S3SelectRequestTest, ScanRange) {
+    string request =
+        BuildS3SelectRequest(MakeCSVScanDesc(), "SELECT * FROM S3Object s", false, 100, 200);
+
+    EXPECT_EQ(
+        "<SelectObjectContentRequest xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+        "<Expression>SELECT * FROM S3Object s</Expression>"
+        "<ExpressionType>SQL</ExpressionType>"
+        "<InputSerialization><CompressionType>NONE</CompressionType>"
+        "<CSV><FileHeaderInfo>NONE</FileHeaderInfo>"
+        "<RecordDelimiter>&#10;</RecordDelimiter><FieldDelimiter>,</FieldDelimiter>"
+        "<QuoteCharacter>\"</QuoteCharacter><QuoteEscapeCharacter>\"</QuoteEscapeCharacter>"
+        "</CSV></InputSerialization>"
+        "<OutputSerialization><CSV><QuoteFields>ASNEEDED</QuoteFields>"
+        "<RecordDelimiter>&#10;</RecordDelimiter><FieldDelimiter>,</FieldDelimiter>"
+        "<QuoteCharacter>\"</QuoteCharacter><QuoteEscapeCharacter>\"</QuoteEscapeCharacter>"
+        "</CSV></OutputSerialization>"
+        "<ScanRange><Start>100</Start><End>199</End></ScanRange>"
+        "</SelectObjectContentRequest>",
+        request);
+}
+
+TEST_F(S3SelectRequestTest, GZipWithHeader) {
+    hasHeader = true;
+    eolString[0] = '\r';
+    eolString[1] = '\n';
+    eolString[2] = '\0';
+
+    S3ScanDesc scanDesc = MakeCSVScanDesc();
+    scanDesc.delimiter = '|';
+    scanDesc.escape = '\0';
+
+    string request = BuildS3SelectRequest(
+        scanDesc, "SELECT s._1 FROM S3Object s WHERE CAST(s._1 AS FLOAT) <= 1", true, 0, 0);
+
+    EXPECT_NE(string::npos, request.find("<Expression>SELECT s._1 FROM S3Object s WHERE "
+                                         "CAST(s._1 AS FLOAT) &lt;= 1</Expression>"));
+    EXPECT_NE(string::npos, request.find("<CompressionType>GZIP</CompressionType>"));
+    EXPECT_NE(string::npos, request.find("<FileHeaderInfo>IGNORE</FileHeaderInfo>"));
+    EXPECT_NE(string::npos, request.find("<RecordDelimiter>&#13;&#10;</RecordDelimiter>"));
+    EXPECT_NE(string::npos, request.find("<FieldDelimiter>|</FieldDelimiter>"));
+    EXPECT_EQ(string::npos, request.find("QuoteEscapeCharacter"));
+    EXPECT_EQ(string::npos, request.find("ScanRange"));
+}
+
+class S3SelectReaderTest : public S3SelectRequestTest {
+   protected:
+    virtual void SetUp() {
+        S3SelectRequestTest::SetUp();
+
+        reader.setS3InterfaceService(&mockS3Interface);
+        EXPECT_CALL(mockS3Interface, selectObjectContent(_, _, _))
+            .WillRepeatedly(Invoke(&mockS3Interface, &MockS3InterfaceForSelect::mockSelect));
+
+        S3ScanDesc scanDesc = MakeCSVScanDesc();
+        scanDesc.projected = {true, false, true};
+        params.setScanDesc(scanDesc);
+        params.setKeySize(100);
+        params.setKeyRange(0, 100);
+        params.setChunkSize(40);
+    }
+
+    virtual void TearDown() {
+        reader.close();
+        S3SelectRequestTest::TearDown();
+    }
+
+    string readAll() {
+        reader.open(params);
+
+        string result;
+        char buf[3];
+        uint64_t len;
+        while ((len = reader.read(buf, sizeof(buf))) > 0) {
+            result.append(buf, len);
+        }
+        return result;
+    }
+
+    bool hasScanRange(uint64_t i, uint64_t start, uint64_t end) {
+        stringstream range;
+        range << "<ScanRange><Start>" << start << "</Start><End>" << end << "</End></ScanRange>";
+        return mockS3Interface.requests[i].find(range.str()) != string::npos;
+    }
+
+    S3Params params;
+    MockS3InterfaceForSelect mockS3Interface;
+    S3SelectReader reader;
+};
+
+TEST_F(S3SelectReaderTest, SelectRangeByChunks) {
+    mockS3Interface.results = {"1,,9.5\n2,,3\n", "", "7,,1\n"};
+
+    EXPECT_EQ("1,,9.5\n2,,3\n7,,1\n", this->readAll());
+
+    ASSERT_EQ((uint64_t)3, mockS3Interface.requests.size());
+    EXPECT_TRUE(this->hasScanRange(0, 0, 39));
+    EXPECT_TRUE(this->hasScanRange(1, 40, 79));
+    EXPECT_TRUE(this->hasScanRange(2, 80, 99));
+    EXPECT_NE(string::npos,
+              mockS3Interface.requests[0].find("SELECT s._1, '', s._3 FROM S3Object s"));
+}
+
+TEST_F(S3SelectReaderTest, SelectPartOfKey) {
+    params.setKeyRange(50, 90);
+    mockS3Interface.results = {"2,,3\n"};
+
+    EXPECT_EQ("2,,3\n", this->readAll());
+
+    ASSERT_EQ((uint64_t)1, mockS3Interface.requests.size());
+    EXPECT_TRUE(this->hasScanRange(0, 50, 89));
+}
+
+TEST_F(S3SelectReaderTest, SelectGZipKeyInOneRequest) {
+    reader.setCompressionType(S3_COMPRESSION_GZIP);
+    params.setKeyRange(0, 0);
+    mockS3Interface.results = {"1,,9.5\n2,,3\n"};
+
+    EXPECT_EQ("1,,9.5\n2,,3\n", this->readAll());
+
+    ASSERT_EQ((uint64_t)1, mockS3Interface.requests.size());
+    EXPECT_EQ(string::npos, mockS3Interface.requests[0].find("ScanRange"));
+    EXPECT_NE(string::npos,
+              mockS3Interface.requests[0].find("<CompressionType>GZIP</CompressionType>"));
+}
+
+TEST_F(S3SelectReaderTest, HeaderLine) {
+    hasHeader = true;
+    mockS3Interface.results = {"1,,9.5\n"};
+
+    EXPECT_EQ("id,name,price\n1,,9.5\n", this->readAll());
+
+    ASSERT_EQ((uint64_t)1, mockS3Interface.requests.size());
+    EXPECT_EQ(string::npos, mockS3Interface.requests[0].find("ScanRange"));
+}
+
+TEST_F(S3SelectReaderTest, EmptyKey) {
+    params.setKeySize(0);
+    params.setKeyRange(0, 0);
+
+    EXPECT_EQ("", this->readAll());
+    EXPECT_TRUE(mockS3Interface.requests.empty());
+}
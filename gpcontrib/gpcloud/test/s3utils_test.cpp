@@ -262,3 +262,196 @@ TEST(Common, TruncateOptions) {
                                      "blah= accessid=\".\\!@#$%^&*()DFGHJK\" "
                                      "chunksize=3456789 testKey=testValue")));
 }
+
+TEST(Common, FindAnyOf) {
+    // cover the vectorized loops and the scalar tail with every position of the match.
+    for (uint64_t len = 0; len < 100; len++) {
+        string buf(len, 'x');
+        EXPECT_EQ(len, FindAnyOf(buf.data(), len, '\n', '"', '\r'));
+
+        for (uint64_t pos = 0; pos < len; pos++) {
+            buf.assign(len, 'x');
+            buf[pos] = '"';
+            EXPECT_EQ(pos, FindAnyOf(buf.data(), len, '\n', '"', '\r'));
+
+            // the first one is found.
+            if (pos + 1 < len) {
+                buf[pos + 1] = '\n';
+                EXPECT_EQ(pos, FindAnyOf(buf.data(), len, '\n', '"', '\r'));
+            }
+        }
+    }
+}
+
+TEST(Common, FindAnyOfHighBytes) {
+    string buf(64, '\x80');
+    buf[40] = '\xff';
+    EXPECT_EQ((uint64_t)40, FindAnyOf(buf.data(), buf.size(), '\xff', '\xff', '\xff'));
+}
+
+TEST(Common, EolScannerLF) {
+    EolScanner scanner("\n");
+    const char *buf = "abc\ndef\n";
+
+    EXPECT_EQ((uint64_t)4, scanner.find(buf, 8));
+    EXPECT_EQ((uint64_t)8, scanner.find(buf, 8, 4));
+    EXPECT_EQ((uint64_t)-1, scanner.find(buf, 3));
+}
+
+TEST(Common, EolScannerCRLFAcrossBuffers) {
+    EolScanner scanner("\r\n");
+
+    EXPECT_EQ((uint64_t)-1, scanner.find("a\r\rb\r", 5));
+    EXPECT_EQ((uint64_t)1, scanner.find("\nc", 2));
+
+    // a lone CR is not a terminator.
+    EXPECT_EQ((uint64_t)-1, scanner.find("\rx\n", 3));
+    EXPECT_EQ((uint64_t)4, scanner.find("x\r\r\n", 4));
+}
+
+TEST(Common, EolScannerQuoted) {
+    EolScanner scanner("\n", '"', '"');
+    const char *buf = "\"a\nb\",\"c\"\"\n\"\nd\n";
+
+    EXPECT_EQ((uint64_t)13, scanner.find(buf, strlen(buf)));
+
+    // without quoting, the first newline ends the line.
+    EolScanner plain("\n");
+    EXPECT_EQ((uint64_t)3, plain.find(buf, strlen(buf)));
+}
+
+TEST(Common, EolScannerQuotedAcrossBuffers) {
+    EolScanner scanner("\r\n", '"', '\\');
+
+    EXPECT_EQ((uint64_t)-1, scanner.find("\"a\r\nb\\", 6));
+    EXPECT_EQ((uint64_t)-1, scanner.find("\"\r\n\"", 4));
+    EXPECT_EQ((uint64_t)2, scanner.find("\r\nx", 3));
+
+    scanner.reset();
+    EXPECT_EQ((uint64_t)3, scanner.find("a\r\n", 3));
+}
+
+TEST(Common, GetSigningKeyV4) {
+    unsigned char keyDate[SHA256_DIGEST_LENGTH];
+    unsigned char keyRegion[SHA256_DIGEST_LENGTH];
+    unsigned char keyService[SHA256_DIGEST_LENGTH];
+    unsigned char expected[SHA256_DIGEST_LENGTH];
+
+    sha256hmac("20150830", keyDate, "AWS4secret/bar", strlen("AWS4secret/bar"));
+    sha256hmac("us-east-1", keyRegion, (char *)keyDate, SHA256_DIGEST_LENGTH);
+    sha256hmac("s3", keyService, (char *)keyRegion, SHA256_DIGEST_LENGTH);
+    sha256hmac("aws4_request", expected, (char *)keyService, SHA256_DIGEST_LENGTH);
+
+    // the second one is from the cache.
+    for (int i = 0; i < 2; i++) {
+        unsigned char key[SHA256_DIGEST_LENGTH];
+        GetSigningKeyV4("secret/bar", "20150830", "us-east-1", key);
+        EXPECT_EQ(0, memcmp(expected, key, SHA256_DIGEST_LENGTH));
+    }
+
+    unsigned char other[SHA256_DIGEST_LENGTH];
+    GetSigningKeyV4("secret/bar", "20150830", "us-west-2", other);
+    EXPECT_NE(0, memcmp(expected, other, SHA256_DIGEST_LENGTH));
+
+    GetSigningKeyV4("secret/foo", "20150830", "us-east-1", other);
+    EXPECT_NE(0, memcmp(expected, other, SHA256_DIGEST_LENGTH));
+
+    // keys of a new day replace the old ones.
+    GetSigningKeyV4("secret/bar", "20150831", "us-east-1", other);
+    EXPECT_NE(0, memcmp(expected, other, SHA256_DIGEST_LENGTH));
+}
+
+TEST(Common, SignRequestV4TwiceWithCachedKey) {
+    S3Credential cred = {"keyid/foo", "secret/bar", ""};
+
+    for (int i = 0; i < 2; i++) {
+        HTTPHeaders h;
+        h.Add(HOST, "iam.amazonaws.com");
+        h.Add(X_AMZ_DATE, "20150830T123600Z");
+        h.Add(X_AMZ_CONTENT_SHA256, "UNSIGNED-PAYLOAD");
+
+        SignRequestV4("GET", &h, "us-east-1", "/where/ever",
+                      "parameter1=whatever1&parameter2=whatever2", cred);
+
+        EXPECT_STREQ(
+            "AWS4-HMAC-SHA256 "
+            "Credential=keyid/foo/20150830/us-east-1/s3/"
+            "aws4_request,SignedHeaders=host;x-amz-content-sha256;x-amz-date,"
+            "Signature="
+            "bb2410787ac51cc7c41b679378d2586a557188ce2017569f5fc94a9b9bb901f8",
+            h.Get(AUTHORIZATION));
+    }
+}
+
+TEST(Utils, BackoffWithJitterGrowsUpToMax) {
+    for (int i = 0; i < 100; i++) {
+        EXPECT_LE(GetBackoffWithJitterUs(100, 10000, 1), (uint64_t)100);
+        EXPECT_LE(GetBackoffWithJitterUs(100, 10000, 3), (uint64_t)400);
+        EXPECT_LE(GetBackoffWithJitterUs(100, 10000, 30), (uint64_t)10000);
+    }
+
+    // jitter spreads the delays of the same attempt.
+    std::set<uint64_t> delays;
+    for (int i = 0; i < 100; i++) {
+        delays.insert(GetBackoffWithJitterUs(1000000, 10000000, 2));
+    }
+    EXPECT_LT((uint64_t)50, delays.size());
+}
+
+TEST(Utils, BackoffWithZeroBase) {
+    EXPECT_EQ((uint64_t)0, GetBackoffWithJitterUs(0, 10000, 1));
+    EXPECT_EQ((uint64_t)0, GetBackoffWithJitterUs(0, 10000, 5));
+}
+
+TEST(Utils, Crc32cCheckValue) {
+    EXPECT_EQ((uint32_t)0xE3069283, Crc32c(0, "123456789", 9));
+    EXPECT_EQ((uint32_t)0, Crc32c(0, "", 0));
+
+    // unaligned data and a tail shorter than 8 bytes.
+    char buf[64];
+    for (int i = 0; i < 64; i++) {
+        buf[i] = i * 7;
+    }
+    EXPECT_EQ(Crc32cScalar(~0U, (const uint8_t *)buf + 3, 53) ^ ~0U, Crc32c(0, buf + 3, 53));
+}
+
+TEST(Utils, Crc32cCombine) {
+    const char *data = "The quick brown fox jumps over the lazy dog";
+    uint64_t len = strlen(data);
+    uint32_t whole = Crc32c(0, data, len);
+
+    for (uint64_t split = 0; split <= len; split++) {
+        uint32_t crcA = Crc32c(0, data, split);
+        uint32_t crcB = Crc32c(0, data + split, len - split);
+        EXPECT_EQ(whole, Crc32cCombine(crcA, crcB, len - split));
+        EXPECT_EQ(whole, Crc32c(crcA, data + split, len - split));
+    }
+}
+
+TEST(Utils, Crc32cBase64) {
+    // checksum of "123456789" in the format of x-amz-checksum-crc32c.
+    EXPECT_EQ("4waSgw==", Crc32cToBase64(0xE3069283));
+
+    uint32_t crc = 0;
+    EXPECT_TRUE(Crc32cFromBase64("4waSgw==", &crc));
+    EXPECT_EQ((uint32_t)0xE3069283, crc);
+
+    EXPECT_FALSE(Crc32cFromBase64("", &crc));
+    EXPECT_FALSE(Crc32cFromBase64("4waSgw", &crc));
+    EXPECT_FALSE(Crc32cFromBase64("4waSgw==-2", &crc));
+}
+
+TEST(Utils, SignRequestV4WithChecksumHeader) {
+    HTTPHeaders h;
+    h.Add(HOST, "iam.amazonaws.com");
+    h.Add(X_AMZ_DATE, "20150830T123600Z");
+    h.Add(X_AMZ_CONTENT_SHA256, "UNSIGNED-PAYLOAD");
+    h.Add(X_AMZ_CHECKSUM_CRC32C, "4waSgw==");
+
+    S3Credential cred = {"keyid/foo", "secret/bar", ""};
+    SignRequestV4("PUT", &h, "us-east-1", "/where/ever", "partNumber=1&uploadId=xyz", cred);
+
+    EXPECT_TRUE(strstr(h.Get(AUTHORIZATION),
+                       "SignedHeaders=host;x-amz-checksum-crc32c;x-amz-content-sha256;x-amz-date,") !=
+                NULL);
+}
@@ -204,6 +204,9 @@ typedef struct {
 	mapred_plist_t     *parameters;     /* points into input plist */
 	mapred_plist_t     *grouping;
 	mapred_plist_t     *returns;
+
+	/* generated query of an execution, kept in streaming mode */
+	char               *query;
 } mapred_task_t;
 
 
@@ -238,6 +241,7 @@ typedef struct {
 	int             id;
 	char           *prefix;
 	buffer_t       *errors;
+	buffer_t       *pipeline;   /* WITH list of the tasks, streaming mode */
 } mapred_document_t;
 
 /* Union of all mapred object types */
@@ -275,6 +279,7 @@ extern int global_verbose_flag;
 extern int global_debug_flag;
 extern int global_print_flag;
 extern int global_explain_flag;
+extern int global_stream_flag;
 extern mapred_plist_t *global_plist;
 
 /* Flags set in global_explain_flag */
@@ -24,6 +24,7 @@ int             global_print_flag   = 0;
 int             global_debug_flag   = 0;
 int             global_verbose_flag = 0;
 int             global_explain_flag = 0;
+int             global_stream_flag  = 0;
 mapred_plist_t *global_plist        = NULL;
 
 /* libPQ cancel context */
@@ -60,6 +61,8 @@ void usage(char *procname, boolean full)
 			"  -x | --explain                do not run jobs, but produce explain plans\n"
 			"  -X | --explain-analyze        run jobs and produce explain-analyze plans\n"
 			"  -k | --key <name>=<value>     sets a yaml variable\n"
+			"  -s | --stream                 run each job as a single query and\n"
+			"                                stream its output\n"
 			"\n"
 			"Connection options:\n"
 			"  -h | --host <hostname>        database server host or socket directory\n"
@@ -103,6 +106,7 @@ int main (int argc, char *argv[])
 		{"password", no_argument,       0, 'W'},
 		{"explain",  no_argument,       0, 'x'},
 		{"explain-analyze", no_argument, 0, 'X'},
+		{"stream",   no_argument,       0, 's'},
 
 		{"username", required_argument, 0, 'U'},
 		{"host",     required_argument, 0, 'h'},
@@ -114,7 +118,7 @@ int main (int argc, char *argv[])
 		{0, 0, 0, 0}
 	};
 
-	static char* short_options = "VvWxXU:h:p:f:k:?PD";
+	static char* short_options = "VvWxXsU:h:p:f:k:?PD";
 
 	while (1)
 	{
@@ -156,6 +160,10 @@ int main (int argc, char *argv[])
 				global_explain_flag |= global_explain | global_analyze;
 				break;
 
+			case 's':  /* --stream */
+				global_stream_flag = 1;
+				break;
+
 			case 'P':  /* --print */
 				global_print_flag = 1;
 				break;
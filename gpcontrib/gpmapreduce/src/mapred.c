@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <ctype.h>
 #include <unistd.h>     /* for file "access" test */
 #include <errno.h>
 
@@ -85,6 +86,7 @@ void             mapred_free(void *ptr);
 buffer_t *        makebuffer(size_t bufsize, size_t grow);
 void                bufreset(buffer_t *b);
 void                  bufcat(buffer_t **bufp, char* fmt);
+void          bufcat_literal(buffer_t **bufp, char* str);
 void   ignore_notice_handler(void *arg, const PGresult *res);
 void    print_notice_handler(void *arg, const PGresult *res);
 void    mapred_setup_columns(PGconn *conn, mapred_object_t *obj);
@@ -94,6 +96,8 @@ boolean mapred_create_object(PGconn *conn, mapred_document_t *doc,
 void    mapred_remove_object(PGconn *conn, mapred_document_t *doc,
 							 mapred_object_t *obj);
 void      mapred_run_queries(PGconn *conn, mapred_document_t *doc);
+void     mapred_pipeline_add(mapred_document_t *doc, mapred_object_t *obj,
+							 char *query);
 
 void mapred_resolve_dependencies(PGconn *conn, mapred_document_t *doc);
 void mapred_resolve_ref(mapred_olist_t *olist, mapred_reference_t *ref);
@@ -283,6 +287,24 @@ void bufcat(buffer_t **bufp, char* str)
 	b->buffer[b->position] = '\0';
 }
 
+/* Append a string as a quoted SQL literal */
+void bufcat_literal(buffer_t **bufp, char* str)
+{
+	char  c[2] = {'\0', '\0'};
+
+	XASSERT(str);
+
+	bufcat(bufp, "'");
+	for (; *str; str++)
+	{
+		c[0] = *str;
+		bufcat(bufp, c);
+		if (*str == '\'')
+			bufcat(bufp, c);
+	}
+	bufcat(bufp, "'");
+}
+
 
 /*
  * Currently we just ignore all warnings, may eventually do something
@@ -1146,6 +1168,12 @@ void mapred_run_document(PGconn *conn, mapred_document_t *doc)
 	}
 	XFINALLY
 	{
+		if (doc->pipeline)
+		{
+			mapred_free(doc->pipeline);
+			doc->pipeline = NULL;
+		}
+
 		/* Remove all the objects that we created */
 		if (global_print_flag || global_debug_flag)
 			printf("\n");
@@ -2098,6 +2126,7 @@ void mapred_destroy_object(mapred_object_t **objh)
 			scalarfree(obj->u.task.mapper.name);
 			scalarfree(obj->u.task.reducer.name);
 			scalarfree(obj->u.task.output.name);
+			scalarfree(obj->u.task.query);
 			break;
 
 		/*
@@ -2192,6 +2221,51 @@ void mapred_destroy_plist(mapred_plist_t **plisth)
 /* -------------------------------------------------------------------------- */
 /* Functions that get things done                                             */
 /* -------------------------------------------------------------------------- */
+/*
+ * In streaming mode an execution doesn't read the views of the tasks it
+ * depends on, they are inlined as common table expressions instead.  The job
+ * is then planned as one query, so GPORCA can turn a task that is read more
+ * than once into a shared scan, and no intermediate result is materialized
+ * unless the plan needs it.
+ *
+ * Objects are created in dependency order, which is also the order the WITH
+ * list has to refer to them in.  The query of an execution is kept on the
+ * execution itself, since it has to come last.
+ */
+void mapred_pipeline_add(mapred_document_t *doc, mapred_object_t *obj,
+						 char *query)
+{
+	char   *copy;
+	size_t  len;
+
+	XASSERT(obj->name);
+	XASSERT(query);
+
+	/* a trailing semicolon of a user query isn't valid within a CTE */
+	copy = copyscalar(query);
+	len  = strlen(copy);
+	while (len > 0 &&
+		   (copy[len-1] == ';' || isspace((unsigned char) copy[len-1])))
+		copy[--len] = '\0';
+
+	if (obj->kind == MAPRED_EXECUTION)
+	{
+		scalarfree(obj->u.task.query);
+		obj->u.task.query = copy;
+		return;
+	}
+
+	if (!doc->pipeline)
+		doc->pipeline = makebuffer(1024, 1024);
+	else
+		bufcat(&doc->pipeline, ",\n");
+	bufcat(&doc->pipeline, obj->name);
+	bufcat(&doc->pipeline, " AS (\n");
+	bufcat(&doc->pipeline, copy);
+	bufcat(&doc->pipeline, "\n)");
+	mapred_free(copy);
+}
+
 void mapred_run_queries(PGconn *conn, mapred_document_t *doc)
 {
 	mapred_olist_t  *olist;
@@ -2212,6 +2286,7 @@ void mapred_run_queries(PGconn *conn, mapred_document_t *doc)
 			if (olist->object->kind == MAPRED_EXECUTION)
 			{
 				boolean exists = false;
+				boolean copy   = false;
 
 				XASSERT(olist->object->name);
 
@@ -2220,6 +2295,15 @@ void mapred_run_queries(PGconn *conn, mapred_document_t *doc)
 
 				output = olist->object->u.task.output.object;
 
+				/*
+				 * In streaming mode rows that go to the client are fetched
+				 * with COPY, which hands them over as they are produced
+				 * rather than once the whole result has been collected.
+				 */
+				if (global_stream_flag && !global_explain_flag &&
+					!(output && output->u.output.type == MAPRED_OUTPUT_TABLE))
+					copy = true;
+
 				/*
 				 *  [CREATE TABLE <name> AS ]
 				 *    SELECT * FROM <name>
@@ -2307,6 +2391,28 @@ void mapred_run_queries(PGconn *conn, mapred_document_t *doc)
 					bufcat(&buffer, "EXPLAIN ");
 				}
 
+				/*
+				 *  [COPY (]
+				 *    [WITH <task> AS (...), ... <name> AS (...)]
+				 */
+				if (copy)
+					bufcat(&buffer, "COPY (");
+				if (global_stream_flag)
+				{
+					XASSERT(olist->object->u.task.query);
+
+					bufcat(&buffer, "WITH ");
+					if (doc->pipeline)
+					{
+						bufcat(&buffer, doc->pipeline->buffer);
+						bufcat(&buffer, ",\n");
+					}
+					bufcat(&buffer, olist->object->name);
+					bufcat(&buffer, " AS (\n");
+					bufcat(&buffer, olist->object->u.task.query);
+					bufcat(&buffer, "\n)\n");
+				}
+
 				bufcat(&buffer, "SELECT * FROM ");
 				bufcat(&buffer, olist->object->name);
 
@@ -2369,6 +2475,31 @@ void mapred_run_queries(PGconn *conn, mapred_document_t *doc)
 						}
 					}
 				}
+
+				/*
+				 *  [) TO STDOUT <format>]
+				 *
+				 * Rows for STDOUT are separated by "|" as PQprint() would,
+				 * just not aligned, and files keep their delimiter.
+				 */
+				if (copy)
+				{
+					bufcat(&buffer, ") TO STDOUT");
+					if (output && output->u.output.format == MAPRED_FORMAT_CSV)
+						bufcat(&buffer, " CSV");
+					else
+						bufcat(&buffer, " NULL ''");
+
+					if (!output)
+					{
+						bufcat(&buffer, " DELIMITER '|'");
+					}
+					else if (output->u.output.delimiter)
+					{
+						bufcat(&buffer, " DELIMITER ");
+						bufcat_literal(&buffer, output->u.output.delimiter);
+					}
+				}
 				bufcat(&buffer, ";\n");
 
 				/* Tell the user what job we are running */
@@ -2461,6 +2592,31 @@ void mapred_run_queries(PGconn *conn, mapred_document_t *doc)
 							break;
 						}
 
+						/* Streaming output to STDOUT or FILE */
+						case PGRES_COPY_OUT:
+						{
+							char *row;
+							int   len;
+
+							while ((len = PQgetCopyData(conn, &row, 0)) > 0)
+							{
+								fwrite(row, 1, len, outfile);
+								PQfreemem(row);
+							}
+
+							/* then collect the status of the COPY itself */
+							PQclear(result);
+							while ((result = PQgetResult(conn)) != NULL)
+							{
+								if (PQresultStatus(result) != PGRES_COMMAND_OK)
+									XRAISE(MAPRED_SQL_ERROR, "Execution Failure");
+								PQclear(result);
+							}
+							if (len == -2)
+								XRAISE(MAPRED_SQL_ERROR, "Execution Failure");
+							break;
+						}
+
 						/* OUTPUT is a table */
 						case PGRES_COMMAND_OK:
 							fprintf(stderr, "DONE\n");
@@ -3727,6 +3883,17 @@ boolean mapred_create_object(PGconn *conn, mapred_document_t *doc,
 			{
 				obj->created = true;
 				PQexec(conn, "RELEASE SAVEPOINT mapreduce_save");
+
+				/* In streaming mode remember the query behind the view */
+				if (global_stream_flag)
+				{
+					if (obj->kind == MAPRED_TASK ||
+						obj->kind == MAPRED_EXECUTION)
+						mapred_pipeline_add(doc, obj, qbuffer->buffer);
+					else if (obj->kind == MAPRED_INPUT &&
+							 obj->u.input.type == MAPRED_INPUT_QUERY)
+						mapred_pipeline_add(doc, obj, obj->u.input.desc);
+				}
 			}
 			else
 			{
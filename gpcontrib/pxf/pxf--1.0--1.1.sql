@@ -0,0 +1,7 @@
+------------------------------------------------------------------
+-- PXF Formatters
+------------------------------------------------------------------
+
+CREATE OR REPLACE FUNCTION pg_catalog.pxfcolumnar_import() RETURNS record
+AS '$libdir/pxf.so', 'gpdbcolumnarformatter_import'
+LANGUAGE C STABLE;
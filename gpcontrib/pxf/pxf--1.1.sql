@@ -22,6 +22,10 @@ CREATE OR REPLACE FUNCTION pg_catalog.pxfwritable_export(record) RETURNS bytea
 AS '$libdir/pxf.so', 'gpdbwritableformatter_export'
 LANGUAGE C STABLE;
 
+CREATE OR REPLACE FUNCTION pg_catalog.pxfcolumnar_import() RETURNS record
+AS '$libdir/pxf.so', 'gpdbcolumnarformatter_import'
+LANGUAGE C STABLE;
+
 CREATE TRUSTED PROTOCOL pxf (
   writefunc     = pxf_write,
   readfunc      = pxf_read,
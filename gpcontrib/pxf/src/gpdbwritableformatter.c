@@ -11,6 +11,10 @@
  * The deserialization gpwritableformatter_import can deserialize the
  * bytes produced by gpdbwritableformatter_export and GPDBWritable.write.
  *
+ * gpdbcolumnarformatter_import deserializes the columnar format, in which the
+ * rows come in batches holding the values of each column together, so that
+ * a whole column of a batch is decoded in one loop.
+ *
  *
  * Licensed to the Apache Software Foundation (ASF) under one
  * or more contributor license agreements.  See the NOTICE file
@@ -49,8 +53,10 @@
 
 PG_FUNCTION_INFO_V1(gpdbwritableformatter_export);
 PG_FUNCTION_INFO_V1(gpdbwritableformatter_import);
+PG_FUNCTION_INFO_V1(gpdbcolumnarformatter_import);
 Datum		gpdbwritableformatter_import(PG_FUNCTION_ARGS);
 Datum		gpdbwritableformatter_export(PG_FUNCTION_ARGS);
+Datum		gpdbcolumnarformatter_import(PG_FUNCTION_ARGS);
 
 static const int ERR_COL_OFFSET = 9;
 static const int FIRST_LINE_NUM = 1;
@@ -82,6 +88,26 @@ typedef struct
 	Oid		   *typioparams;
 } format_t;
 
+typedef struct
+{
+	/* The Datum/null of the tuple */
+	Datum	   *values;
+	bool	   *nulls;
+
+	int			lineno;
+
+	/* The Datum/null of each column of the current batch, and its size */
+	Datum	  **batch_values;
+	bool	  **batch_nulls;
+	int			batch_nrows;
+	int			batch_row;		/* next row of the batch to return */
+	MemoryContext batch_ctx;
+
+	/* Input functions of the columns not decoded by the formatter itself */
+	FmgrInfo   *io_functions;
+	Oid		   *typioparams;
+} format_columnar_t;
+
 
 /*
  * Serialize the object using the following format:
@@ -100,6 +126,27 @@ typedef struct
 /* Bit flag */
 #define GPDBWRITABLE_BITFLAG_ISNULL 1	/* Column is null */
 
+/*
+ * The columnar format sends the rows in batches using the following format:
+ * Total Length | Version | error	| #columns | #rows  | Col type | Col type |... | Padding
+ * 4 byte		| 2 byte	1 byte	| 2 byte	 4 byte	  1 byte	 1 byte			  to 8 byte
+ *
+ * followed, for each column, by the null bit array of the rows, ceil(#rows/8)
+ * byte, and the values of the rows, each padded to 8 byte:
+ *
+ * For fixed length type, #rows values of the type length, in network byte
+ * order.  The values of the null rows are ignored.
+ * For var length type, #rows + 1 int4 offsets, then the payload of the
+ * values; the value of row i spans offsets i to i + 1 of the payload.  In
+ * text format it includes the '\0', like in GPDBWritable.
+ *
+ * The col types are the ones of GPDBWritable, and the padding is relative to
+ * the start of the batch.  A batch with the error flag set has the error
+ * message right after the header.
+ */
+#define GPDBCOLUMNAR_VERSION 1
+#define GPDBCOLUMNAR_HEADER_LEN 13
+
 /*
  * appendStringInfoFill
  *
@@ -147,6 +194,19 @@ readIntFromBuffer(char *buffer, int *offset)
 	return ntohl(n32);
 }
 
+/*
+ * Read a int8 from the buffer, given the offset;
+ * it will return the int value and increase the offset
+ */
+static int64
+readInt8FromBuffer(char *buffer, int *offset)
+{
+	uint32		h32 = (uint32) readIntFromBuffer(buffer, offset);
+	uint32		l32 = (uint32) readIntFromBuffer(buffer, offset);
+
+	return (int64) (((uint64) h32 << 32) | l32);
+}
+
 /*
  * Write a int2 to the buffer
  */
@@ -841,3 +901,370 @@ gpdbwritableformatter_import(PG_FUNCTION_ARGS)
 	FORMATTER_SET_TUPLE(fcinfo, tuple);
 	FORMATTER_RETURN_TUPLE(tuple);
 }
+
+/*
+ * Error out on a batch of the columnar format that doesn't fit its length
+ */
+static void
+checkBatchBounds(int64 offset, int batchlen)
+{
+	if (offset < 0 || offset > batchlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_EXCEPTION),
+				 errmsg("ill-formatted batch: offset " INT64_FORMAT " is out of the batch of %d bytes",
+						offset, batchlen)));
+}
+
+/*
+ * Decode the values of a column of fixed length binary type, that starts at
+ * bufidx in the batch
+ */
+static void
+decodeFixedLengthColumn(Oid type, char *batch, int *bufidx, int nrows,
+						Datum *values)
+{
+	int			i;
+
+	switch (type)
+	{
+		case INT8OID:
+			for (i = 0; i < nrows; i++)
+				values[i] = Int64GetDatum(readInt8FromBuffer(batch, bufidx));
+			break;
+		case INT4OID:
+			for (i = 0; i < nrows; i++)
+				values[i] = Int32GetDatum(readIntFromBuffer(batch, bufidx));
+			break;
+		case INT2OID:
+			for (i = 0; i < nrows; i++)
+				values[i] = Int16GetDatum((int16) readInt2FromBuffer(batch, bufidx));
+			break;
+		case BOOLOID:
+			for (i = 0; i < nrows; i++)
+				values[i] = BoolGetDatum(readInt1FromBuffer(batch, bufidx) != 0);
+			break;
+		case FLOAT8OID:
+			for (i = 0; i < nrows; i++)
+			{
+				int64		n64 = readInt8FromBuffer(batch, bufidx);
+				float8		f8;
+
+				memcpy(&f8, &n64, sizeof(float8));
+				values[i] = Float8GetDatum(f8);
+			}
+			break;
+		case FLOAT4OID:
+			for (i = 0; i < nrows; i++)
+			{
+				int32		n32 = readIntFromBuffer(batch, bufidx);
+				float4		f4;
+
+				memcpy(&f4, &n32, sizeof(float4));
+				values[i] = Float4GetDatum(f4);
+			}
+			break;
+		default:
+			elog(ERROR, "unexpected fixed length type %u", type);
+	}
+}
+
+/*
+ * Decode the values of a column of var length type, whose offsets start at
+ * bufidx in the batch
+ */
+static void
+decodeVariableLengthColumn(Form_pg_attribute attr, FmgrInfo *iofunc,
+						   Oid typioparam, char *batch, int batchlen,
+						   int *bufidx, int nrows, Datum *values, bool *nulls)
+{
+	int			payload;
+	int			start;
+	int			end;
+	int			i;
+
+	checkBatchBounds(*bufidx + (int64) (nrows + 1) * sizeof(int32), batchlen);
+	payload = *bufidx + (nrows + 1) * sizeof(int32);
+
+	start = readIntFromBuffer(batch, bufidx);
+	checkBatchBounds((int64) payload + start, batchlen);
+	for (i = 0; i < nrows; i++)
+	{
+		end = readIntFromBuffer(batch, bufidx);
+		if (end < start)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_EXCEPTION),
+					 errmsg("ill-formatted batch: decreasing offsets in column \"%s\"",
+							NameStr(attr->attname))));
+		checkBatchBounds((int64) payload + end, batchlen);
+
+		if (!nulls[i])
+		{
+			char	   *val = batch + payload + start;
+			int			len = end - start;
+
+			if (attr->atttypid == BYTEAOID)
+			{
+				StringInfoData tmpbuf;
+
+				tmpbuf.data = val;
+				tmpbuf.maxlen = len;
+				tmpbuf.len = len;
+				tmpbuf.cursor = 0;
+
+				values[i] = ReceiveFunctionCall(iofunc, &tmpbuf, typioparam,
+												attr->atttypmod);
+			}
+			else
+			{
+				if (len == 0 || val[len - 1] != '\0')
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_EXCEPTION),
+							 errmsg("ill-formatted batch: unterminated value in column \"%s\"",
+									NameStr(attr->attname))));
+
+				values[i] = InputFunctionCall(iofunc, val, typioparam,
+											  attr->atttypmod);
+			}
+		}
+		start = end;
+	}
+
+	*bufidx = payload + start;
+}
+
+/*
+ * Decode the batch of the columnar format at the start of batch into the
+ * batch_values and batch_nulls of myData
+ */
+static void
+decodeColumnarBatch(format_columnar_t *myData, TupleDesc tupdesc, char *batch,
+					int batchlen)
+{
+	AttrNumber	ncolumns = tupdesc->natts;
+	AttrNumber	i;
+	int			bufidx = sizeof(int32);
+	int16		version;
+	int8		error_flag;
+	int16		ncolumns_remote;
+	int			nrows;
+	MemoryContext oldcontext;
+
+	version = readInt2FromBuffer(batch, &bufidx);
+	if (version != GPDBCOLUMNAR_VERSION)
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						errmsg("cannot import columnar data version %d", version)));
+
+	error_flag = readInt1FromBuffer(batch, &bufidx);
+	if (error_flag)
+		ereport(ERROR, (errcode(ERRCODE_DATA_EXCEPTION),
+						errmsg("%.*s", batchlen - GPDBCOLUMNAR_HEADER_LEN,
+							   batch + GPDBCOLUMNAR_HEADER_LEN)));
+
+	ncolumns_remote = readInt2FromBuffer(batch, &bufidx);
+	nrows = readIntFromBuffer(batch, &bufidx);
+	if (nrows < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_EXCEPTION),
+				 errmsg("ill-formatted batch: negative row count (%d)", nrows)));
+
+	checkBatchBounds(bufidx + ncolumns, batchlen);
+
+	/* Verify once on the first batch */
+	if (FIRST_LINE_NUM == myData->lineno++)
+		verifyExternalTableDefinition(ncolumns_remote, ncolumns, tupdesc, batch, &bufidx);
+	/* Skipping the columns' enum types */
+	else
+		bufidx += ncolumns;
+
+	MemoryContextReset(myData->batch_ctx);
+	oldcontext = MemoryContextSwitchTo(myData->batch_ctx);
+
+	for (i = 0; i < ncolumns; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[i];
+		Datum	   *values;
+		bool	   *nulls;
+		int			nullByteLen = getNullByteArraySize(nrows);
+
+		/* Extract null bit array */
+		bufidx = DOUBLEALIGN(bufidx);
+		checkBatchBounds((int64) bufidx + nullByteLen, batchlen);
+		values = palloc0(sizeof(Datum) * nrows);
+		nulls = palloc(sizeof(bool) * nrows);
+		byteArrayToBoolArray((bits8 *) (batch + bufidx), nullByteLen, &nulls, nrows);
+		bufidx += nullByteLen;
+
+		/* extract column values */
+		bufidx = DOUBLEALIGN(bufidx);
+		if (isVariableLength(attr->atttypid))
+			decodeVariableLengthColumn(attr, &myData->io_functions[i],
+									   myData->typioparams[i], batch, batchlen,
+									   &bufidx, nrows, values, nulls);
+		else
+		{
+			checkBatchBounds(bufidx + (int64) nrows * attr->attlen, batchlen);
+			decodeFixedLengthColumn(attr->atttypid, batch, &bufidx, nrows,
+									values);
+		}
+
+		myData->batch_values[i] = values;
+		myData->batch_nulls[i] = nulls;
+	}
+	bufidx = DOUBLEALIGN(bufidx);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (batchlen != bufidx)
+		ereport(ERROR,
+				(errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+				 errmsg("batchlen != bufidx: %d:%d", batchlen, bufidx)));
+
+	myData->batch_nrows = nrows;
+	myData->batch_row = 0;
+}
+
+Datum
+gpdbcolumnarformatter_import(PG_FUNCTION_ARGS)
+{
+	HeapTuple	tuple;
+	TupleDesc	tupdesc;
+	format_columnar_t *myData;
+	AttrNumber	ncolumns = 0;
+	AttrNumber	i;
+	char	   *data_buf;
+	int			data_cur;
+	int			data_len;
+	int			batchlen = 0;
+	int			bufidx = 0;
+	int			remaining = 0;
+
+	/* Must be called via the external table format manager */
+	if (!CALLED_AS_FORMATTER(fcinfo))
+		ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+						errmsg("cannot execute gpdbcolumnarformatter_import outside format manager")));
+
+	tupdesc = FORMATTER_GET_TUPDESC(fcinfo);
+
+	/* Get our internal description of the formatter */
+	ncolumns = tupdesc->natts;
+	myData = (format_columnar_t *) FORMATTER_GET_USER_CTX(fcinfo);
+
+	/*
+	 * Initialize the context structure
+	 */
+	if (myData == NULL)
+	{
+		if (FORMATTER_GET_EXTENCODING(fcinfo) != PG_UTF8)
+			ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+							errmsg("gpdbcolumnar formatter can only import UTF8 formatted data. Define the external table with ENCODING UTF8")));
+
+		myData = palloc0(sizeof(format_columnar_t));
+		myData->values = palloc(sizeof(Datum) * ncolumns);
+		myData->nulls = palloc(sizeof(bool) * ncolumns);
+		myData->lineno = FIRST_LINE_NUM;
+		myData->batch_values = palloc0(sizeof(Datum *) * ncolumns);
+		myData->batch_nulls = palloc0(sizeof(bool *) * ncolumns);
+		myData->batch_ctx = AllocSetContextCreate(CurrentMemoryContext,
+												  "gpdbcolumnar formatter batch",
+												  ALLOCSET_DEFAULT_MINSIZE,
+												  ALLOCSET_DEFAULT_INITSIZE,
+												  ALLOCSET_DEFAULT_MAXSIZE);
+		myData->typioparams = (Oid *) palloc0(ncolumns * sizeof(Oid));
+		myData->io_functions = palloc0(sizeof(FmgrInfo) * ncolumns);
+
+		for (i = 0; i < ncolumns; i++)
+		{
+			Oid			type = tupdesc->attrs[i]->atttypid;
+			Oid			functionId;
+
+			/* External table do not support dropped columns; error out now */
+			if (tupdesc->attrs[i]->attisdropped)
+				ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+								errmsg("cannot handle external table with dropped columns")));
+
+			/* Fixed length binary types are decoded by decodeFixedLengthColumn */
+			if (!isVariableLength(type))
+				continue;
+
+			/* Get the text/binary "receive" function */
+			if (isBinaryFormatType(type))
+				getTypeBinaryInputInfo(type, &(functionId), &myData->typioparams[i]);
+			else
+				getTypeInputInfo(type, &(functionId), &myData->typioparams[i]);
+			fmgr_info(functionId, &(myData->io_functions[i]));
+		}
+
+		FORMATTER_SET_USER_CTX(fcinfo, myData);
+	}
+
+	/*
+	 * Decode the next batch once all the rows of the current one have been
+	 * returned, skipping the empty ones.
+	 */
+	while (myData->batch_row >= myData->batch_nrows)
+	{
+		/* get our input data buf and number of valid bytes in it */
+		data_buf = FORMATTER_GET_DATABUF(fcinfo);
+		data_len = FORMATTER_GET_DATALEN(fcinfo);
+		data_cur = FORMATTER_GET_DATACURSOR(fcinfo);
+
+		remaining = data_len - data_cur;
+		bufidx = data_cur;
+
+		/* See the unexpected EOF error handling of gpdbwritableformatter_import */
+		if (remaining == 0 && FORMATTER_GET_SAW_EOF(fcinfo))
+			FORMATTER_RETURN_NOTIFICATION(fcinfo, FMT_NEED_MORE_DATA);
+
+		if (remaining < GPDBCOLUMNAR_HEADER_LEN)
+		{
+			if (FORMATTER_GET_SAW_EOF(fcinfo))
+			{
+				FORMATTER_SET_BAD_ROW_DATA(fcinfo, data_buf + data_cur, remaining);
+				ereport(ERROR, (errcode(ERRCODE_DATA_EXCEPTION),
+								errmsg("unexpected end of file")));
+			}
+			FORMATTER_RETURN_NOTIFICATION(fcinfo, FMT_NEED_MORE_DATA);
+		}
+
+		batchlen = readIntFromBuffer(data_buf, &bufidx);
+		if (batchlen < GPDBCOLUMNAR_HEADER_LEN)
+		{
+			FORMATTER_SET_BAD_ROW_DATA(fcinfo, data_buf + data_cur, remaining);
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_EXCEPTION),
+					 errmsg("ill-formatted batch: invalid length (%d)", batchlen)));
+		}
+
+		/* Now, make sure we've received the entire batch */
+		if (remaining < batchlen)
+		{
+			if (FORMATTER_GET_SAW_EOF(fcinfo))
+			{
+				FORMATTER_SET_BAD_ROW_DATA(fcinfo, data_buf + data_cur, remaining);
+				ereport(ERROR, (errcode(ERRCODE_DATA_EXCEPTION),
+								errmsg("unexpected end of file")));
+			}
+			FORMATTER_RETURN_NOTIFICATION(fcinfo, FMT_NEED_MORE_DATA);
+		}
+
+		/* We got here. So, we've the ENTIRE batch in the buffer */
+		FORMATTER_SET_BAD_ROW_DATA(fcinfo, data_buf + data_cur, batchlen);
+
+		decodeColumnarBatch(myData, tupdesc, data_buf + data_cur, batchlen);
+
+		/* The batch is decoded, its bytes aren't needed anymore */
+		FORMATTER_SET_DATACURSOR(fcinfo, data_cur + batchlen);
+		FORMATTER_SET_BAD_ROW_DATA(fcinfo, NULL, 0);
+	}
+
+	for (i = 0; i < ncolumns; i++)
+	{
+		myData->values[i] = myData->batch_values[i][myData->batch_row];
+		myData->nulls[i] = myData->batch_nulls[i][myData->batch_row];
+	}
+	myData->batch_row++;
+
+	tuple = heap_form_tuple(tupdesc, myData->values, myData->nulls);
+	FORMATTER_SET_TUPLE(fcinfo, tuple);
+	FORMATTER_RETURN_TUPLE(tuple);
+}
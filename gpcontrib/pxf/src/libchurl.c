@@ -42,6 +42,17 @@ typedef struct
 
 } churl_buffer;
 
+/*
+ * curl multi API handle shared by parallel downloads
+ */
+typedef struct
+{
+	CURLM	   *multi_handle;
+
+	/* number of downloads on the multi handle */
+	int			refcount;
+} churl_shared_multi;
+
 /*
  * internal context of libchurl
  */
@@ -55,6 +66,12 @@ typedef struct
 	 */
 	CURLM	   *multi_handle;
 
+	/*
+	 * set if multi_handle is shared with other downloads, their transfers
+	 * then progress whenever any of them is read
+	 */
+	churl_shared_multi *shared_multi;
+
 	/*
 	 * curl API puts internal errors in this buffer used for error reporting
 	 */
@@ -74,6 +91,18 @@ typedef struct
 
 	/* true on upload, false on download */
 	bool		upload;
+
+	/*
+	 * bytes of download to buffer before the transfer pauses until they are
+	 * read, 0 if unlimited
+	 */
+	size_t		max_buffered;
+
+	/* true while the transfer is paused */
+	bool		paused;
+
+	/* result of the transfer, once done on a shared multi handle */
+	CURLcode	curl_result;
 } churl_context;
 
 /*
@@ -91,6 +120,7 @@ static void		set_curl_option(churl_context *context, CURLoption option, const vo
 static size_t	read_callback(void *ptr, size_t size, size_t nmemb, void *userdata);
 static void		setup_multi_handle(churl_context *context);
 static void		multi_perform(churl_context *context);
+static void		collect_done_transfers(CURLM *multi_handle);
 static bool		internal_buffer_large_enough(churl_buffer *buffer, size_t required);
 static void		flush_internal_buffer(churl_context *context);
 static char	   *get_dest_address(CURL * curl_handle);
@@ -105,6 +135,7 @@ static void		churl_headers_set(churl_context *context, CHURL_HEADERS settings);
 static void		check_response_status(churl_context *context);
 static void		check_response_code(churl_context *context);
 static void		check_response(churl_context *context);
+static void		report_transfer_error(CURL *curl_handle, long status);
 static size_t	header_callback(char *buffer, size_t size, size_t nitems, void *userp);
 static void		compact_internal_buffer(churl_buffer *buffer);
 static void		realloc_internal_buffer(churl_buffer *buffer, size_t required);
@@ -368,6 +399,38 @@ churl_init_download(const char *url, CHURL_HEADERS headers)
 	return (CHURL_HANDLE) context;
 }
 
+CHURL_HANDLE
+churl_init_download_parallel(const char *url, CHURL_HEADERS headers,
+							 CHURL_HANDLE share, size_t max_buffered)
+{
+	churl_context *context = churl_init(url, headers);
+	churl_context *share_context = (churl_context *) share;
+
+	context->upload = false;
+	context->max_buffered = max_buffered;
+
+	if (share_context != NULL)
+	{
+		Assert(share_context->shared_multi != NULL);
+		context->shared_multi = share_context->shared_multi;
+	}
+	else
+	{
+		context->shared_multi = palloc0(sizeof(churl_shared_multi));
+		if (!(context->shared_multi->multi_handle = curl_multi_init()))
+			elog(ERROR, "internal error: curl_multi_init failed");
+	}
+	context->shared_multi->refcount++;
+	context->multi_handle = context->shared_multi->multi_handle;
+
+	/* lets collect_done_transfers() find the context of a done transfer */
+	set_curl_option(context, CURLOPT_PRIVATE, context);
+
+	print_http_headers(headers);
+	setup_multi_handle(context);
+	return (CHURL_HANDLE) context;
+}
+
 void
 churl_download_restart(CHURL_HANDLE handle, const char *url, CHURL_HEADERS headers)
 {
@@ -540,6 +603,18 @@ setup_multi_handle(churl_context *context)
 		if (!(context->multi_handle = curl_multi_init()))
 			elog(ERROR, "internal error: curl_multi_init failed");
 
+	/*
+	 * curl_multi_perform() counts the transfers of all the downloads on a
+	 * shared multi handle, this one runs until collect_done_transfers() says
+	 * otherwise
+	 */
+	if (context->shared_multi)
+	{
+		context->curl_still_running = 1;
+		context->curl_result = CURLE_OK;
+		context->paused = false;
+	}
+
 	/* add the easy handle to the multi handle */
 	/* don't blame me, blame libcurl */
 	if (CURLM_OK != (curl_error = curl_multi_add_handle(context->multi_handle, context->curl_handle)))
@@ -560,13 +635,44 @@ static void
 multi_perform(churl_context *context)
 {
 	int			curl_error;
+	int			running_handles;
+	int		   *still_running = context->shared_multi ?
+		&running_handles : &context->curl_still_running;
 
 	while (CURLM_CALL_MULTI_PERFORM ==
-		   (curl_error = curl_multi_perform(context->multi_handle, &context->curl_still_running)));
+		   (curl_error = curl_multi_perform(context->multi_handle, still_running)));
 
 	if (curl_error != CURLM_OK)
 		elog(ERROR, "internal error: curl_multi_perform failed (%d - %s)",
 			 curl_error, curl_easy_strerror(curl_error));
+
+	if (context->shared_multi)
+		collect_done_transfers(context->multi_handle);
+}
+
+/*
+ * Mark the downloads whose transfers on the shared multi handle are done,
+ * and keep their results for check_response_status().
+ */
+static void
+collect_done_transfers(CURLM *multi_handle)
+{
+	CURLMsg    *msg;
+	int			msgs_left;
+
+	while ((msg = curl_multi_info_read(multi_handle, &msgs_left)))
+	{
+		churl_context *done = NULL;
+
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+		if (CURLE_OK != curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &done) ||
+			done == NULL)
+			continue;
+
+		done->curl_still_running = 0;
+		done->curl_result = msg->data.result;
+	}
 }
 
 static bool
@@ -663,8 +769,17 @@ cleanup_curl_handle(churl_context *context)
 		multi_remove_handle(context);
 	curl_easy_cleanup(context->curl_handle);
 	context->curl_handle = NULL;
-	curl_multi_cleanup(context->multi_handle);
+
+	/* the last download on a shared multi handle cleans it up */
+	if (context->shared_multi == NULL)
+		curl_multi_cleanup(context->multi_handle);
+	else if (--context->shared_multi->refcount == 0)
+	{
+		curl_multi_cleanup(context->multi_handle);
+		pfree(context->shared_multi);
+	}
 	context->multi_handle = NULL;
+	context->shared_multi = NULL;
 }
 
 static void
@@ -706,6 +821,8 @@ churl_cleanup_context(churl_context *context)
  * Called by libcurl perform during a download.
  * Stores data from libcurl's buffer into the internal buffer.
  * If internal buffer is not large enough, increases it.
+ * Pauses the transfer instead once max_buffered bytes wait to be read,
+ * libcurl then holds on to the data until fill_internal_buffer() resumes it.
  */
 static size_t
 write_callback(char *buffer, size_t size, size_t nitems, void *userp)
@@ -714,6 +831,13 @@ write_callback(char *buffer, size_t size, size_t nitems, void *userp)
 	churl_buffer *context_buffer = context->download_buffer;
 	const int	nbytes = size * nitems;
 
+	if (context->max_buffered > 0 &&
+		context_buffer->top - context_buffer->bot >= context->max_buffered)
+	{
+		context->paused = true;
+		return CURL_WRITEFUNC_PAUSE;
+	}
+
 	if (!internal_buffer_large_enough(context_buffer, nbytes))
 	{
 		compact_internal_buffer(context_buffer);
@@ -741,6 +865,20 @@ fill_internal_buffer(churl_context *context, int want)
 	int			maxfd;
 	int			curl_error;
 
+	/* the buffer of a paused transfer must have room for what is wanted */
+	if (context->max_buffered > 0 && want > context->max_buffered)
+		context->max_buffered = want;
+
+	if (context->paused &&
+		(context->download_buffer->top - context->download_buffer->bot) < want)
+	{
+		context->paused = false;
+		curl_error = curl_easy_pause(context->curl_handle, CURLPAUSE_CONT);
+		if (CURLE_OK != curl_error)
+			elog(ERROR, "internal error: curl_easy_pause failed (%d - %s)",
+				 curl_error, curl_easy_strerror(curl_error));
+	}
+
 	/* attempt to fill buffer */
 	while (context->curl_still_running &&
 		   ((context->download_buffer->top - context->download_buffer->bot) < want))
@@ -821,6 +959,14 @@ check_response_status(churl_context *context)
 	int			msgs_left;		/* how many messages are left */
 	long		status;
 
+	/* collect_done_transfers() already picked up the messages */
+	if (context->shared_multi)
+	{
+		if (context->curl_still_running == 0 && context->curl_result != CURLE_OK)
+			report_transfer_error(context->curl_handle, context->curl_result);
+		return;
+	}
+
 	while ((msg = curl_multi_info_read(context->multi_handle, &msgs_left)))
 	{
 		int			i = 0;
@@ -829,24 +975,28 @@ check_response_status(churl_context *context)
 		if (msg->msg != CURLMSG_DONE)
 			continue;
 		if (CURLE_OK != (status = msg->data.result))
-		{
-			char	   *addr = get_dest_address(msg->easy_handle);
-			StringInfoData err;
+			report_transfer_error(msg->easy_handle, status);
+		elog(DEBUG2, "check_response_status: msg %d done with status OK", i++);
+	}
+}
 
-			initStringInfo(&err);
+static void
+report_transfer_error(CURL *curl_handle, long status)
+{
+	char	   *addr = get_dest_address(curl_handle);
+	StringInfoData err;
 
-			appendStringInfo(&err, "transfer error (%ld): %s",
-							 status, curl_easy_strerror(status));
+	initStringInfo(&err);
 
-			if (addr)
-			{
-				appendStringInfo(&err, " from %s", addr);
-				pfree(addr);
-			}
-			elog(ERROR, "%s", err.data);
-		}
-		elog(DEBUG2, "check_response_status: msg %d done with status OK", i++);
+	appendStringInfo(&err, "transfer error (%ld): %s",
+					 status, curl_easy_strerror(status));
+
+	if (addr)
+	{
+		appendStringInfo(&err, " from %s", addr);
+		pfree(addr);
 	}
+	elog(ERROR, "%s", err.data);
 }
 
 /*
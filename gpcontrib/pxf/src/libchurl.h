@@ -25,7 +25,8 @@
 /*
  * CHunked cURL API
  * NOTES:
- * 1) Does not multi thread
+ * 1) Does not multi thread, parallel downloads progress whenever one of
+ *    them is read
  * 2) Does not talk IPv6
  */
 typedef void *CHURL_HEADERS;
@@ -112,6 +113,16 @@ CHURL_HANDLE churl_init_upload(const char *url, CHURL_HEADERS headers);
  */
 CHURL_HANDLE churl_init_download(const char *url, CHURL_HEADERS headers);
 
+/*
+ * Start a download to url that runs in parallel with the download of share,
+ * over the same connections, or with none if share is NULL.
+ * The transfer pauses while max_buffered bytes of it wait to be read,
+ * 0 means no limit.
+ * returns a handle to churl transfer
+ */
+CHURL_HANDLE churl_init_download_parallel(const char *url, CHURL_HEADERS headers,
+										  CHURL_HANDLE share, size_t max_buffered);
+
 /*
  * Restart a session to a new URL
  * This will use the same headers
@@ -22,11 +22,20 @@
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
 
+/*
+ * Bytes of a fragment downloaded ahead of the one being read, before its
+ * transfer pauses until it is read
+ */
+#define PXF_DOWNLOAD_AHEAD_SIZE (1024 * 1024)
+
 /* helper function declarations */
 static void build_uri_for_read(gphadoop_context *context);
 static void build_uri_for_write(gphadoop_context *context);
-static void add_querydata_to_http_headers(gphadoop_context *context);
+static void add_querydata_to_http_headers(gphadoop_context *context, CHURL_HEADERS headers);
 static void set_current_fragment_headers(gphadoop_context *context);
+static void set_fragment_headers(gphadoop_context *context, CHURL_HEADERS headers, ListCell *fragment);
+static void start_parallel_downloads(gphadoop_context *context, int num_downloads);
+static void next_parallel_download(gphadoop_context *context);
 static size_t fill_buffer(gphadoop_context *context, char *start, size_t size);
 
 /*
@@ -38,6 +47,23 @@ gpbridge_cleanup(gphadoop_context *context)
 	if (context == NULL)
 		return;
 
+	/* fragments downloaded ahead are not read anymore */
+	if (context->num_downloads > 0)
+	{
+		for (int i = 0; i < context->num_downloads; i++)
+		{
+			if (context->download_handles[i] == context->churl_handle)
+				continue;
+			churl_cleanup(context->download_handles[i], true);
+			churl_headers_cleanup(context->download_headers[i]);
+		}
+		pfree(context->download_handles);
+		pfree(context->download_headers);
+		context->download_handles = NULL;
+		context->download_headers = NULL;
+		context->num_downloads = 0;
+	}
+
 	churl_cleanup(context->churl_handle, false);
 	context->churl_handle = NULL;
 
@@ -63,17 +89,27 @@ gpbridge_cleanup(gphadoop_context *context)
 void
 gpbridge_import_start(gphadoop_context *context)
 {
+	int			num_fragments;
+	int			num_downloads = 1;
+
 	if (context->gphd_uri->fragments == NULL)
 		return;
 
 	context->current_fragment = list_head(context->gphd_uri->fragments);
 	build_uri_for_read(context);
 	context->churl_headers = churl_headers_init();
-	add_querydata_to_http_headers(context);
+	add_querydata_to_http_headers(context, context->churl_headers);
 
 	set_current_fragment_headers(context);
 
-	context->churl_handle = churl_init_download(context->uri.data, context->churl_headers);
+	num_fragments = list_length(context->gphd_uri->fragments);
+	if (num_fragments > 1)
+		num_downloads = Min(get_pxf_fragments_in_flight(), num_fragments);
+
+	if (num_downloads > 1)
+		start_parallel_downloads(context, num_downloads);
+	else
+		context->churl_handle = churl_init_download(context->uri.data, context->churl_headers);
 
 	/* read some bytes to make sure the connection is established */
 	churl_read_check_connectivity(context->churl_handle);
@@ -88,7 +124,7 @@ gpbridge_export_start(gphadoop_context *context)
 	elog(DEBUG2, "pxf: file name for write: %s", context->gphd_uri->data);
 	build_uri_for_write(context);
 	context->churl_headers = churl_headers_init();
-	add_querydata_to_http_headers(context);
+	add_querydata_to_http_headers(context, context->churl_headers);
 
 	context->churl_handle = churl_init_upload(context->uri.data, context->churl_headers);
 }
@@ -117,8 +153,13 @@ gpbridge_read(gphadoop_context *context, char *databuf, int datalen)
 		if (context->current_fragment == NULL)
 			return 0;
 
-		set_current_fragment_headers(context);
-		churl_download_restart(context->churl_handle, context->uri.data, context->churl_headers);
+		if (context->num_downloads > 0)
+			next_parallel_download(context);
+		else
+		{
+			set_current_fragment_headers(context);
+			churl_download_restart(context->churl_handle, context->uri.data, context->churl_headers);
+		}
 
 		/* read some bytes to make sure the connection is established */
 		churl_read_check_connectivity(context->churl_handle);
@@ -177,16 +218,17 @@ build_uri_for_write(gphadoop_context *context)
  * by the remote component.
  */
 static void
-add_querydata_to_http_headers(gphadoop_context *context)
+add_querydata_to_http_headers(gphadoop_context *context, CHURL_HEADERS headers)
 {
 	PxfInputData inputData = {0};
 
-	inputData.headers   = context->churl_headers;
+	inputData.headers   = headers;
 	inputData.gphduri   = context->gphd_uri;
 	inputData.rel       = context->relation;
 	inputData.filterstr = context->filterstr;
 	inputData.proj_info = context->proj_info;
 	inputData.quals     = context->quals;
+	inputData.agg_type  = context->agg_type;
 	build_http_headers(&inputData);
 }
 
@@ -203,35 +245,45 @@ add_querydata_to_http_headers(gphadoop_context *context)
 static void
 set_current_fragment_headers(gphadoop_context *context)
 {
-	FragmentData *frag_data = (FragmentData *) lfirst(context->current_fragment);
+	set_fragment_headers(context, context->churl_headers, context->current_fragment);
+}
+
+/*
+ * Change the headers with the information of the given fragment, as
+ * set_current_fragment_headers does for the current one
+ */
+static void
+set_fragment_headers(gphadoop_context *context, CHURL_HEADERS headers, ListCell *fragment)
+{
+	FragmentData *frag_data = (FragmentData *) lfirst(fragment);
 	int fragment_count = list_length(context->gphd_uri->fragments);
 
 	elog(DEBUG2, "pxf: set_current_fragment_source_name: source_name %s, index %s, has user data: %s ",
 		 frag_data->source_name, frag_data->index, frag_data->user_data ? "TRUE" : "FALSE");
 
-	churl_headers_override(context->churl_headers, "X-GP-DATA-DIR", frag_data->source_name);
-	churl_headers_override(context->churl_headers, "X-GP-DATA-FRAGMENT", frag_data->index);
-	churl_headers_override(context->churl_headers, "X-GP-FRAGMENT-METADATA", frag_data->fragment_md);
-	churl_headers_override(context->churl_headers, "X-GP-FRAGMENT-INDEX", frag_data->index);
+	churl_headers_override(headers, "X-GP-DATA-DIR", frag_data->source_name);
+	churl_headers_override(headers, "X-GP-DATA-FRAGMENT", frag_data->index);
+	churl_headers_override(headers, "X-GP-FRAGMENT-METADATA", frag_data->fragment_md);
+	churl_headers_override(headers, "X-GP-FRAGMENT-INDEX", frag_data->index);
 
 	if (frag_data->fragment_idx == fragment_count)
 	{
-		churl_headers_override(context->churl_headers, "X-GP-LAST-FRAGMENT", "true");
+		churl_headers_override(headers, "X-GP-LAST-FRAGMENT", "true");
 	}
 
 	if (frag_data->user_data)
 	{
-		churl_headers_override(context->churl_headers, "X-GP-FRAGMENT-USER-DATA", frag_data->user_data);
+		churl_headers_override(headers, "X-GP-FRAGMENT-USER-DATA", frag_data->user_data);
 	}
 	else
 	{
-		churl_headers_remove(context->churl_headers, "X-GP-FRAGMENT-USER-DATA", true);
+		churl_headers_remove(headers, "X-GP-FRAGMENT-USER-DATA", true);
 	}
 
 	if (frag_data->profile)
 	{
 		/* if current fragment has optimal profile set it */
-		churl_headers_override(context->churl_headers, "X-GP-PROFILE", frag_data->profile);
+		churl_headers_override(headers, "X-GP-PROFILE", frag_data->profile);
 		elog(DEBUG2, "pxf: set_current_fragment_headers: using profile: %s", frag_data->profile);
 
 	}
@@ -241,7 +293,7 @@ set_current_fragment_headers(gphadoop_context *context)
 		 * if current fragment doesn't have any optimal profile, set to use
 		 * profile from url
 		 */
-		churl_headers_override(context->churl_headers, "X-GP-PROFILE", context->gphd_uri->profile);
+		churl_headers_override(headers, "X-GP-PROFILE", context->gphd_uri->profile);
 		elog(DEBUG2, "pxf: set_current_fragment_headers: using profile: %s", context->gphd_uri->profile);
 	}
 
@@ -252,6 +304,69 @@ set_current_fragment_headers(gphadoop_context *context)
 
 }
 
+/*
+ * Start downloading the current fragment and the num_downloads - 1 fragments
+ * after it at once, over the same connections to the PXF server.  They are
+ * still read one after the other, so the formatter sees the data of each
+ * fragment in one piece, and in the order of the fragments.
+ */
+static void
+start_parallel_downloads(gphadoop_context *context, int num_downloads)
+{
+	ListCell   *fragment = lnext(context->current_fragment);
+
+	elog(DEBUG2, "pxf: downloading %d fragments at once", num_downloads);
+
+	context->download_handles = palloc0(num_downloads * sizeof(CHURL_HANDLE));
+	context->download_headers = palloc0(num_downloads * sizeof(CHURL_HEADERS));
+	context->num_downloads = num_downloads;
+	context->download_head = 0;
+
+	context->churl_handle = churl_init_download_parallel(context->uri.data, context->churl_headers,
+														 NULL, PXF_DOWNLOAD_AHEAD_SIZE);
+	context->download_handles[0] = context->churl_handle;
+	context->download_headers[0] = context->churl_headers;
+
+	for (int i = 1; i < num_downloads; i++)
+	{
+		CHURL_HEADERS headers = churl_headers_init();
+
+		add_querydata_to_http_headers(context, headers);
+		set_fragment_headers(context, headers, fragment);
+
+		context->download_handles[i] = churl_init_download_parallel(context->uri.data, headers,
+																	context->churl_handle,
+																	PXF_DOWNLOAD_AHEAD_SIZE);
+		context->download_headers[i] = headers;
+		fragment = lnext(fragment);
+	}
+
+	context->next_fragment = fragment;
+}
+
+/*
+ * Move on to the download of the current fragment, which is already in
+ * flight, and reuse the download of the fragment just read, with the
+ * connection it keeps open, for the first fragment not requested yet.
+ */
+static void
+next_parallel_download(gphadoop_context *context)
+{
+	int			done = context->download_head;
+
+	if (context->next_fragment != NULL)
+	{
+		set_fragment_headers(context, context->download_headers[done], context->next_fragment);
+		churl_download_restart(context->download_handles[done], context->uri.data,
+							   context->download_headers[done]);
+		context->next_fragment = lnext(context->next_fragment);
+	}
+
+	context->download_head = (done + 1) % context->num_downloads;
+	context->churl_handle = context->download_handles[context->download_head];
+	context->churl_headers = context->download_headers[context->download_head];
+}
+
 /*
  * Read data from churl until the buffer is full or there is no more data to be read
  */
@@ -42,6 +42,20 @@ typedef struct
 	char           *filterstr;
 	ProjectionInfo *proj_info;
 	List           *quals;
+	ExternalScanAggType agg_type;
+
+	/*
+	 * Downloads of the fragments after current_fragment, in flight while it
+	 * is read.  The num_downloads handles form a ring, the one at
+	 * download_head is churl_handle and those after it download the fragments
+	 * that follow, up to next_fragment, the first one not requested yet.
+	 * num_downloads is 0 if fragments are downloaded one at a time.
+	 */
+	CHURL_HANDLE   *download_handles;
+	CHURL_HEADERS  *download_headers;
+	int            num_downloads;
+	int            download_head;
+	ListCell       *next_fragment;
 } gphadoop_context;
 
 /*
@@ -27,7 +27,7 @@
 static void add_alignment_size_httpheader(CHURL_HEADERS headers);
 static void add_tuple_desc_httpheader(CHURL_HEADERS headers, Relation rel);
 static void add_location_options_httpheader(CHURL_HEADERS headers, GPHDUri *gphduri);
-static char *get_format_name(char fmtcode);
+static char *get_format_name(char fmtcode, char *fmtopts);
 static void add_projection_desc_httpheader(CHURL_HEADERS headers, ProjectionInfo *projInfo, List *qualsAttributes);
 static bool add_attnums_from_targetList(Node *node, List *attnums);
 static void add_projection_index_header(CHURL_HEADERS pVoid, StringInfoData data, int attno, char number[32]);
@@ -53,7 +53,7 @@ build_http_headers(PxfInputData *input)
 		ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
 
 		/* pxf treats CSV as TEXT */
-		char *format = get_format_name(exttbl->fmtcode);
+		char *format = get_format_name(exttbl->fmtcode, exttbl->fmtopts);
 
 		churl_headers_append(headers, "X-GP-FORMAT", format);
 
@@ -115,6 +115,15 @@ build_http_headers(PxfInputData *input)
 	}
 	else
 		churl_headers_append(headers, "X-GP-HAS-FILTER", "0");
+
+	/*
+	 * aggregates computed over all the rows of the fragment, which the
+	 * service may answer from its statistics instead of sending the rows
+	 */
+	if (input->agg_type == EXTSCAN_AGG_COUNT)
+		churl_headers_append(headers, "X-GP-AGG-TYPE", "count");
+	else if (input->agg_type == EXTSCAN_AGG_MINMAX)
+		churl_headers_append(headers, "X-GP-AGG-TYPE", "minmax");
 }
 
 /* Report alignment size to remote component
@@ -374,10 +383,11 @@ add_location_options_httpheader(CHURL_HEADERS headers, GPHDUri *gphduri)
 }
 
 /*
- * Converts a character code for the format name into a string of format definition
+ * Converts a character code for the format name into a string of format definition.
+ * Custom formats are GPDBWritable, unless read by the columnar formatter.
  */
 static char *
-get_format_name(char fmtcode)
+get_format_name(char fmtcode, char *fmtopts)
 {
 	char	   *formatName = NULL;
 
@@ -387,7 +397,10 @@ get_format_name(char fmtcode)
 	}
 	else if (fmttype_is_custom(fmtcode))
 	{
-		formatName = GpdbWritableFormatName;
+		if (fmtopts != NULL && strstr(fmtopts, GpdbColumnarFormatterName) != NULL)
+			formatName = GpdbColumnarFormatName;
+		else
+			formatName = GpdbWritableFormatName;
 	}
 	else
 	{
@@ -21,6 +21,8 @@
 #define _PXFHEADERS_H_
 
 #define GpdbWritableFormatName "GPDBWritable"
+#define GpdbColumnarFormatName "GPDBColumnar"
+#define GpdbColumnarFormatterName "pxfcolumnar_import"
 #define TextFormatName "TEXT"
 
 #include "libchurl.h"
@@ -41,6 +43,7 @@ typedef struct sPxfInputData
 	char           *filterstr;
 	ProjectionInfo *proj_info;
 	List           *quals;
+	ExternalScanAggType agg_type;
 } PxfInputData;
 
 /*
@@ -157,12 +157,14 @@ create_context(PG_FUNCTION_ARGS, bool is_import)
 	List           *filter_quals = NULL;
 	ProjectionInfo *proj_info    = NULL;
 	char           *filterstr    = NULL;
+	ExternalScanAggType agg_type = EXTSCAN_AGG_NONE;
 	ExternalSelectDescData *desc = EXTPROTOCOL_GET_EXTERNAL_SELECT_DESC(fcinfo);
 
 	if (desc != NULL)
 	{
 		filter_quals = desc->filter_quals;
 		proj_info    = desc->projInfo;
+		agg_type     = desc->agg_type;
 
 		if (filter_quals != NULL)
 		{
@@ -186,6 +188,7 @@ create_context(PG_FUNCTION_ARGS, bool is_import)
 	context->filterstr = filterstr;
 	context->proj_info = proj_info;
 	context->quals     = filter_quals;
+	context->agg_type  = agg_type;
 	return context;
 }
 
@@ -106,4 +106,31 @@ get_pxf_port(void)
 	}
 
 	return port;
-}
\ No newline at end of file
+}
+
+/* Returns the number of fragments a segment downloads at once, defined in
+ * the PXF_FRAGMENTS_IN_FLIGHT environment variable or the default when undefined
+ */
+int
+get_pxf_fragments_in_flight(void)
+{
+	char *endptr = NULL;
+	char *nStr = getenv(ENV_PXF_FRAGMENTS_IN_FLIGHT);
+	int fragments = PXF_DEFAULT_FRAGMENTS_IN_FLIGHT;
+
+	if (nStr) {
+		fragments = (int) strtol(nStr, &endptr, 10);
+
+		if (nStr == endptr || fragments < 1)
+			elog(ERROR, "unable to parse number of PXF fragments in flight %s=%s",
+				 ENV_PXF_FRAGMENTS_IN_FLIGHT, nStr);
+		else
+			elog(DEBUG3, "read environment variable %s=%s", ENV_PXF_FRAGMENTS_IN_FLIGHT, nStr);
+	}
+	else
+	{
+		elog(DEBUG3, "environment variable %s was not supplied", ENV_PXF_FRAGMENTS_IN_FLIGHT);
+	}
+
+	return fragments;
+}
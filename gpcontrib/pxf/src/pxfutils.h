@@ -25,6 +25,11 @@ const char *get_pxf_host(void);
  */
 const int  get_pxf_port(void);
 
+/* Returns the number of fragments a segment downloads at once, defined in
+ * the PXF_FRAGMENTS_IN_FLIGHT environment variable or the default when undefined
+ */
+int			get_pxf_fragments_in_flight(void);
+
 #define PXF_PROFILE       "PROFILE"
 #define FRAGMENTER        "FRAGMENTER"
 #define ACCESSOR          "ACCESSOR"
@@ -32,7 +37,9 @@ const int  get_pxf_port(void);
 #define ANALYZER          "ANALYZER"
 #define ENV_PXF_HOST      "PXF_HOST"
 #define ENV_PXF_PORT      "PXF_PORT"
+#define ENV_PXF_FRAGMENTS_IN_FLIGHT "PXF_FRAGMENTS_IN_FLIGHT"
 #define PXF_DEFAULT_HOST  "localhost"
 #define PXF_DEFAULT_PORT  5888
+#define PXF_DEFAULT_FRAGMENTS_IN_FLIGHT 4
 
 #endif							/* _PXFUTILS_H_ */
@@ -55,6 +55,16 @@ churl_init_download(const char* url, CHURL_HEADERS headers)
     return (CHURL_HANDLE) mock();
 }
 
+CHURL_HANDLE
+churl_init_download_parallel(const char* url, CHURL_HEADERS headers, CHURL_HANDLE share, size_t max_buffered)
+{
+    check_expected(url);
+    check_expected(headers);
+    check_expected(share);
+    check_expected(max_buffered);
+    return (CHURL_HANDLE) mock();
+}
+
 void
 churl_download_restart(CHURL_HANDLE handle, const char* url, CHURL_HEADERS headers)
 {
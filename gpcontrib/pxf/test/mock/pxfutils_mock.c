@@ -23,4 +23,10 @@ char*
 get_authority(void)
 {
 	return (char*) mock();
+}
+
+int
+get_pxf_fragments_in_flight(void)
+{
+	return (int) mock();
 }
\ No newline at end of file
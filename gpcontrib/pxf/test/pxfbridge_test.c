@@ -296,6 +296,9 @@ test_gpbridge_read_first_fragment_buffer(void **state)
 	expect_set_headers_call(headers, "X-GP-FRAGMENT-USER-DATA", fragment->user_data);
 	expect_set_headers_call(headers, "X-GP-PROFILE", context->gphd_uri->profile);
 
+	/* fragments are downloaded one at a time */
+	will_return(get_pxf_fragments_in_flight, 1);
+
 	CHURL_HANDLE handle = (CHURL_HANDLE) palloc0(sizeof(CHURL_HANDLE));
 
 	expect_value(churl_init_download, url, context->uri.data);
@@ -417,6 +420,216 @@ test_gpbridge_read_next_fragment_buffer(void **state)
 	pfree(context);
 }
 
+void
+test_gpbridge_import_start_parallel(void **state)
+{
+	/* init data in context that will be cleaned up */
+	gphadoop_context *context = (gphadoop_context *) palloc0(sizeof(gphadoop_context));
+
+	initStringInfo(&context->uri);
+
+	/* setup list of fragments */
+	FragmentData *fragment = (FragmentData *) palloc0(sizeof(FragmentData));
+	FragmentData *next_fragment = (FragmentData *) palloc0(sizeof(FragmentData));
+
+	fragment->authority = AUTHORITY;
+	fragment->fragment_md = "md";
+	fragment->index = "1";
+	fragment->profile = NULL;
+	fragment->source_name = "source";
+	fragment->user_data = "user_data";
+	fragment->fragment_idx = 1;
+
+	next_fragment->authority = AUTHORITY;
+	next_fragment->fragment_md = "md";
+	next_fragment->index = "2";
+	next_fragment->profile = NULL;
+	next_fragment->source_name = "next_source";
+	next_fragment->user_data = "next_user_data";
+	next_fragment->fragment_idx = 2;
+
+	context->gphd_uri = (GPHDUri *) palloc0(sizeof(GPHDUri));
+	List	   *list = list_make2(fragment, next_fragment);
+
+	context->gphd_uri->fragments = list;
+	context->gphd_uri->profile = "profile";
+
+	CHURL_HEADERS headers = (CHURL_HEADERS) palloc0(sizeof(CHURL_HEADERS));
+	CHURL_HEADERS next_headers = (CHURL_HEADERS) palloc0(sizeof(CHURL_HEADERS));
+
+	will_return(churl_headers_init, headers);
+	will_return(churl_headers_init, next_headers);
+
+	expect_any_count(build_http_headers, input, 2);
+	/* might verify params later */
+	will_be_called_count(build_http_headers, 2);
+
+	expect_set_headers_call(headers, "X-GP-DATA-DIR", fragment->source_name);
+	expect_set_headers_call(headers, "X-GP-DATA-FRAGMENT", fragment->index);
+	expect_set_headers_call(headers, "X-GP-FRAGMENT-METADATA", fragment->fragment_md);
+	expect_set_headers_call(headers, "X-GP-FRAGMENT-INDEX", fragment->index);
+	expect_set_headers_call(headers, "X-GP-FRAGMENT-USER-DATA", fragment->user_data);
+	expect_set_headers_call(headers, "X-GP-PROFILE", context->gphd_uri->profile);
+
+	/* more fragments may be in flight than there are */
+	will_return(get_pxf_fragments_in_flight, 4);
+
+	CHURL_HANDLE handle = (CHURL_HANDLE) palloc0(sizeof(CHURL_HANDLE));
+	CHURL_HANDLE next_handle = (CHURL_HANDLE) palloc0(sizeof(CHURL_HANDLE));
+
+	expect_value(churl_init_download_parallel, url, context->uri.data);
+	expect_value(churl_init_download_parallel, headers, headers);
+	expect_value(churl_init_download_parallel, share, NULL);
+	expect_value(churl_init_download_parallel, max_buffered, PXF_DOWNLOAD_AHEAD_SIZE);
+	will_return(churl_init_download_parallel, handle);
+
+	/* the next fragment is downloaded alongside the first one */
+	expect_set_headers_call(next_headers, "X-GP-DATA-DIR", next_fragment->source_name);
+	expect_set_headers_call(next_headers, "X-GP-DATA-FRAGMENT", next_fragment->index);
+	expect_set_headers_call(next_headers, "X-GP-FRAGMENT-METADATA", next_fragment->fragment_md);
+	expect_set_headers_call(next_headers, "X-GP-FRAGMENT-INDEX", next_fragment->index);
+	expect_set_headers_call(next_headers, "X-GP-LAST-FRAGMENT", "true");
+	expect_set_headers_call(next_headers, "X-GP-FRAGMENT-USER-DATA", next_fragment->user_data);
+	expect_set_headers_call(next_headers, "X-GP-PROFILE", context->gphd_uri->profile);
+
+	expect_value(churl_init_download_parallel, url, context->uri.data);
+	expect_value(churl_init_download_parallel, headers, next_headers);
+	expect_value(churl_init_download_parallel, share, handle);
+	expect_value(churl_init_download_parallel, max_buffered, PXF_DOWNLOAD_AHEAD_SIZE);
+	will_return(churl_init_download_parallel, next_handle);
+
+	expect_value(churl_read_check_connectivity, handle, handle);
+	will_be_called(churl_read_check_connectivity);
+
+	/* call function under test */
+	gpbridge_import_start(context);
+
+	/* assert call results */
+	assert_int_equal(context->current_fragment, list_head(context->gphd_uri->fragments));
+	assert_int_equal(context->churl_headers, headers);
+	assert_int_equal(context->churl_handle, handle);
+	assert_int_equal(context->num_downloads, 2);
+	assert_int_equal(context->download_head, 0);
+	assert_int_equal(context->download_handles[1], next_handle);
+	assert_int_equal(context->download_headers[1], next_headers);
+	assert_int_equal(context->next_fragment, NULL);
+
+	/* cleanup */
+	list_free_deep(list);
+	pfree(context->download_handles);
+	pfree(context->download_headers);
+	pfree(handle);
+	pfree(next_handle);
+	pfree(headers);
+	pfree(next_headers);
+	pfree(context->gphd_uri);
+	pfree(context);
+}
+
+void
+test_gpbridge_read_next_fragment_parallel(void **state)
+{
+	/* init data in context, with the first two fragments in flight */
+	gphadoop_context *context = (gphadoop_context *) palloc0(sizeof(gphadoop_context));
+	CHURL_HANDLE handle = (CHURL_HANDLE) palloc0(sizeof(CHURL_HANDLE));
+	CHURL_HANDLE next_handle = (CHURL_HANDLE) palloc0(sizeof(CHURL_HANDLE));
+	CHURL_HEADERS headers = (CHURL_HEADERS) palloc0(sizeof(CHURL_HEADERS));
+	CHURL_HEADERS next_headers = (CHURL_HEADERS) palloc0(sizeof(CHURL_HEADERS));
+
+	initStringInfo(&context->uri);
+
+	/* setup list of fragments */
+	FragmentData *prev_fragment = (FragmentData *) palloc0(sizeof(FragmentData));
+	FragmentData *fragment = (FragmentData *) palloc0(sizeof(FragmentData));
+	FragmentData *last_fragment = (FragmentData *) palloc0(sizeof(FragmentData));
+
+	last_fragment->authority = AUTHORITY;
+	last_fragment->fragment_md = "md";
+	last_fragment->index = "3";
+	last_fragment->profile = NULL;
+	last_fragment->source_name = "source";
+	last_fragment->user_data = "user_data";
+	last_fragment->fragment_idx = 3;
+
+	List	   *list = list_make3(prev_fragment, fragment, last_fragment);
+
+	context->current_fragment = list_head(list);
+	context->next_fragment = lnext(lnext(list_head(list)));
+
+	context->gphd_uri = (GPHDUri *) palloc0(sizeof(GPHDUri));
+	context->gphd_uri->profile = "profile";
+	context->gphd_uri->fragments = list;
+
+	context->download_handles = palloc0(2 * sizeof(CHURL_HANDLE));
+	context->download_headers = palloc0(2 * sizeof(CHURL_HEADERS));
+	context->download_handles[0] = handle;
+	context->download_headers[0] = headers;
+	context->download_handles[1] = next_handle;
+	context->download_headers[1] = next_headers;
+	context->num_downloads = 2;
+	context->download_head = 0;
+	context->churl_handle = handle;
+	context->churl_headers = headers;
+
+	int			datalen = 10;
+	char	   *databuf = (char *) palloc0(datalen);
+
+	/* first call for current fragment returns 0 as no more data available */
+	expect_value(churl_read, handle, handle);
+	expect_value(churl_read, buf, databuf);
+	expect_value(churl_read, max_size, datalen);
+	will_return(churl_read, 0);
+
+	expect_value(churl_read_check_connectivity, handle, handle);
+	will_be_called(churl_read_check_connectivity);
+
+	/* the download of the fragment just read moves on to the last one */
+	expect_set_headers_call(headers, "X-GP-DATA-DIR", last_fragment->source_name);
+	expect_set_headers_call(headers, "X-GP-DATA-FRAGMENT", last_fragment->index);
+	expect_set_headers_call(headers, "X-GP-FRAGMENT-METADATA", last_fragment->fragment_md);
+	expect_set_headers_call(headers, "X-GP-FRAGMENT-INDEX", last_fragment->index);
+	expect_set_headers_call(headers, "X-GP-LAST-FRAGMENT", "true");
+	expect_set_headers_call(headers, "X-GP-FRAGMENT-USER-DATA", last_fragment->user_data);
+	expect_set_headers_call(headers, "X-GP-PROFILE", context->gphd_uri->profile);
+
+	expect_value(churl_download_restart, handle, handle);
+	expect_value(churl_download_restart, url, context->uri.data);
+	expect_value(churl_download_restart, headers, headers);
+	will_be_called(churl_download_restart);
+
+	/* and the second fragment, already in flight, is read */
+	expect_value(churl_read_check_connectivity, handle, next_handle);
+	will_be_called(churl_read_check_connectivity);
+
+	expect_value(churl_read, handle, next_handle);
+	expect_value(churl_read, buf, databuf);
+	expect_value(churl_read, max_size, datalen);
+	will_return(churl_read, 10);
+
+	/* call function under test */
+	int			bytes_read = gpbridge_read(context, databuf, datalen);
+
+	/* assert call results */
+	assert_int_equal(bytes_read, 10);
+	assert_int_equal(context->current_fragment, lnext(list_head(list)));
+	assert_int_equal(context->churl_handle, next_handle);
+	assert_int_equal(context->churl_headers, next_headers);
+	assert_int_equal(context->download_head, 1);
+	assert_int_equal(context->next_fragment, NULL);
+
+	/* cleanup */
+	list_free_deep(list);
+	pfree(context->download_handles);
+	pfree(context->download_headers);
+	pfree(handle);
+	pfree(next_handle);
+	pfree(headers);
+	pfree(next_headers);
+	pfree(databuf);
+	pfree(context->gphd_uri);
+	pfree(context);
+}
+
 void
 test_gpbridge_read_last_fragment_finished(void **state)
 {
@@ -545,6 +758,8 @@ main(int argc, char *argv[])
 		unit_test(test_gpbridge_read_one_fragment_buffer),
 		unit_test(test_gpbridge_read_first_fragment_buffer),
 		unit_test(test_gpbridge_read_next_fragment_buffer),
+		unit_test(test_gpbridge_import_start_parallel),
+		unit_test(test_gpbridge_read_next_fragment_parallel),
 		unit_test(test_gpbridge_read_last_fragment_finished),
 		unit_test(test_gpbridge_export_start),
 		unit_test(test_gpbridge_write_data),
@@ -170,6 +170,34 @@ test_build_http_headers(void **state)
 	/* no asserts as the function just calls to set headers */
 }
 
+void
+test_build_http_headers_agg_type(void **state)
+{
+	char		alignment[3];
+	pg_ltoa(sizeof(char *), alignment);
+
+	input_data->agg_type = EXTSCAN_AGG_MINMAX;
+
+	pfree(input_data->rel);
+	input_data->rel = NULL;
+
+	expect_external_vars();
+
+	expect_headers_append(input_data->headers, "X-GP-USER", "pxfuser");
+	expect_headers_append(input_data->headers, "X-GP-SEGMENT-ID", mock_extvar.GP_SEGMENT_ID);
+	expect_headers_append(input_data->headers, "X-GP-SEGMENT-COUNT", mock_extvar.GP_SEGMENT_COUNT);
+	expect_headers_append(input_data->headers, "X-GP-XID", mock_extvar.GP_XID);
+	expect_headers_append(input_data->headers, "X-GP-ALIGNMENT", alignment);
+	expect_headers_append(input_data->headers, "X-GP-URL-HOST", gphd_uri->host);
+	expect_headers_append(input_data->headers, "X-GP-URL-PORT", gphd_uri->port);
+	expect_headers_append(input_data->headers, "X-GP-DATA-DIR", gphd_uri->data);
+	expect_headers_append(input_data->headers, "X-GP-URI", gphd_uri->uri);
+	expect_headers_append(input_data->headers, "X-GP-HAS-FILTER", "0");
+	expect_headers_append(input_data->headers, "X-GP-AGG-TYPE", "minmax");
+
+	build_http_headers(input_data);
+}
+
 void
 test_build_http_headers_no_user_error(void **state)
 {
@@ -393,21 +421,24 @@ test_add_tuple_desc_httpheader(void **state)
 void
 test_get_format_name(void **state)
 {
-	char	   *formatName = get_format_name('t');
+	char	   *formatName = get_format_name('t', NULL);
 
 	assert_string_equal(formatName, TextFormatName);
 
-	formatName = get_format_name('c');
+	formatName = get_format_name('c', NULL);
 	assert_string_equal(formatName, TextFormatName);
 
-	formatName = get_format_name('b');
+	formatName = get_format_name('b', "formatter 'pxfwritable_import' ");
 	assert_string_equal(formatName, GpdbWritableFormatName);
 
+	formatName = get_format_name('b', "formatter 'pxfcolumnar_import' ");
+	assert_string_equal(formatName, GpdbColumnarFormatName);
+
 	MemoryContext old_context = CurrentMemoryContext;
 
 	PG_TRY();
 	{
-		formatName = get_format_name('x');
+		formatName = get_format_name('x', NULL);
 		assert_false("Expected Exception");
 	}
 	PG_CATCH();
@@ -439,6 +470,7 @@ main(int argc, char *argv[])
 	const		UnitTest tests[] = {
 		unit_test(test_get_format_name),
 		unit_test_setup_teardown(test_build_http_headers, common_setup, common_teardown),
+		unit_test_setup_teardown(test_build_http_headers_agg_type, common_setup, common_teardown),
 		unit_test_setup_teardown(test_build_http_headers_no_user_error, common_setup, common_teardown),
 		unit_test_setup_teardown(test_build_http_headers_empty_user_error, common_setup, common_teardown),
 		unit_test_setup_teardown(test__build_http_header__where_is_not_supported, common_setup, common_teardown),
@@ -0,0 +1,38 @@
+--
+-- Test compression with trained dictionaries.
+--
+
+CREATE TABLE zstd_dict_test (id int4, j text)
+WITH (appendonly=true, compresstype=zstd, orientation=column) DISTRIBUTED BY (id);
+
+INSERT INTO zstd_dict_test SELECT g, '{"id": ' || g || ', "name": "customer ' || g % 100 || '", "status": "active"}' FROM generate_series(1, 1000) g;
+
+-- Train a dictionary for column j, used by the blocks written from now on
+SELECT gp_zstd_train_dictionary('zstd_dict_test', 'j', 4096) IS NOT NULL AS trained;
+SELECT attnum, active FROM gp_zstd_dictionary WHERE relid = 'zstd_dict_test'::regclass;
+
+INSERT INTO zstd_dict_test SELECT g, '{"id": ' || g || ', "name": "customer ' || g % 100 || '", "status": "closed"}' FROM generate_series(1001, 2000) g;
+
+-- Training again keeps the previous dictionary, for the blocks that use it
+SELECT gp_zstd_train_dictionary('zstd_dict_test', 'j', 4096) IS NOT NULL AS trained;
+SELECT attnum, active, count(*) FROM gp_zstd_dictionary WHERE relid = 'zstd_dict_test'::regclass GROUP BY attnum, active ORDER BY active;
+
+INSERT INTO zstd_dict_test SELECT g, '{"id": ' || g || ', "name": "customer ' || g % 100 || '", "status": "new"}' FROM generate_series(2001, 3000) g;
+
+-- Check contents, of the blocks compressed without and with each dictionary
+SELECT count(*), count(DISTINCT j) FROM zstd_dict_test;
+SELECT * FROM zstd_dict_test WHERE id IN (1, 1500, 3000) ORDER BY id;
+
+-- A dictionary can be trained for a table before loading it, from a sample
+CREATE TABLE zstd_dict_test_2 (LIKE zstd_dict_test)
+WITH (appendonly=true, compresstype=zstd, orientation=column) DISTRIBUTED BY (id);
+SELECT gp_zstd_train_dictionary('zstd_dict_test_2', 'j', 4096, 'SELECT j FROM zstd_dict_test') IS NOT NULL AS trained;
+INSERT INTO zstd_dict_test_2 SELECT * FROM zstd_dict_test;
+SELECT count(*), count(DISTINCT j) FROM zstd_dict_test_2;
+
+-- Errors
+SELECT gp_zstd_train_dictionary('zstd_dict_test', 'nosuchcol');
+SELECT gp_zstd_train_dictionary('zstd_dict_test', 'j', 4096, 'SELECT id, j FROM zstd_dict_test');
+
+DROP TABLE zstd_dict_test;
+DROP TABLE zstd_dict_test_2;
@@ -11,39 +11,246 @@
 #include "postgres.h"
 
 #include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/xact.h"
+#include "catalog/namespace.h"
 #include "catalog/pg_compression.h"
+#include "catalog/pg_namespace.h"
+#include "cdb/cdbdisp_query.h"
+#include "cdb/cdbvars.h"
+#include "executor/spi.h"
 #include "fmgr.h"
+#include "miscadmin.h"
 #include "storage/gp_compress.h"
+#include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
 
 #include <zstd.h>
 #include <zstd_errors.h>
+#include <zdict.h>
 
 Datum		zstd_constructor(PG_FUNCTION_ARGS);
 Datum		zstd_destructor(PG_FUNCTION_ARGS);
 Datum		zstd_compress(PG_FUNCTION_ARGS);
 Datum		zstd_decompress(PG_FUNCTION_ARGS);
 Datum		zstd_validator(PG_FUNCTION_ARGS);
+Datum		zstd_train_dictionary(PG_FUNCTION_ARGS);
+Datum		zstd_store_dictionary(PG_FUNCTION_ARGS);
 
 PG_FUNCTION_INFO_V1(zstd_constructor);
 PG_FUNCTION_INFO_V1(zstd_destructor);
 PG_FUNCTION_INFO_V1(zstd_compress);
 PG_FUNCTION_INFO_V1(zstd_decompress);
 PG_FUNCTION_INFO_V1(zstd_validator);
+PG_FUNCTION_INFO_V1(zstd_train_dictionary);
+PG_FUNCTION_INFO_V1(zstd_store_dictionary);
 
 #ifndef UNIT_TESTING
 PG_MODULE_MAGIC;
 #endif
 
+/*
+ * Trained dictionaries are kept in the gp_zstd_dictionary table, created in
+ * every database, on the master and on each segment, by
+ * zstd_compression.sql.  Each row is a dictionary for a column of an
+ * append-only table, or for the rows of a row oriented one (attnum 0).  Only
+ * the active dictionary of a column is used to compress new blocks, but the
+ * older ones are kept for the blocks compressed with them.  Blocks refer to
+ * their dictionary by the dictionary ID that zstd writes in the frame header.
+ */
+#define ZSTD_DICTIONARY_RELNAME			"gp_zstd_dictionary"
+
+#define Natts_gp_zstd_dictionary		5
+#define Anum_gp_zstd_dictionary_dictid	1
+#define Anum_gp_zstd_dictionary_relid	2
+#define Anum_gp_zstd_dictionary_attnum	3
+#define Anum_gp_zstd_dictionary_active	4
+#define Anum_gp_zstd_dictionary_dict	5
+
+/* Largest sample to train a dictionary from, in rows */
+#define ZSTD_DICTIONARY_SAMPLE_ROWS		100000
+/* ... and in multiples of the dictionary size */
+#define ZSTD_DICTIONARY_SAMPLE_FACTOR	100
+
+/*
+ * A dictionary used by this backend.  The dictionaries are cached for the
+ * life of the backend, they never change once stored.
+ */
+typedef struct zstd_dictionary
+{
+	unsigned	dictid;			/* zstd dictionary ID */
+	char	   *data;			/* the trained dictionary */
+	size_t		size;
+
+	ZSTD_CDict *cdict;			/* digested for compression at cdict_level */
+	int			cdict_level;
+	ZSTD_DDict *ddict;			/* digested for decompression */
+
+	struct zstd_dictionary *next;
+} zstd_dictionary;
+
+static zstd_dictionary *zstd_dictionaries = NULL;
+
+/*
+ * ZSTD compression/decompression contexts of this backend, reused by all the
+ * blocks.  A backend compresses or decompresses one block at a time, and
+ * each call resets the context, so they can be shared by all the streams.
+ */
+static ZSTD_CCtx *zstd_cctx = NULL;
+static ZSTD_DCtx *zstd_dctx = NULL;
+
 /* Internal state for zstd */
 typedef struct zstd_state
 {
 	int			level;			/* Compression level */
 	bool		compress;		/* Compress if true, decompress otherwise */
 
-	zstd_context *ctx;			/* ZSTD compression/decompresion contexts */
+	zstd_dictionary *dict;		/* Dictionary to compress with, or NULL */
 } zstd_state;
 
+/*
+ * Look for a dictionary in gp_zstd_dictionary: the active one of column
+ * attnum of relid if relid is valid, the one with the given dictid
+ * otherwise.  Returns NULL if there's no such dictionary.
+ */
+static zstd_dictionary *
+zstd_lookup_dictionary(Oid relid, AttrNumber attnum, unsigned dictid)
+{
+	zstd_dictionary *dict;
+	Oid			dictrelid;
+	Relation	rel;
+	SysScanDesc scan;
+	ScanKeyData key[3];
+	int			nkeys;
+	HeapTuple	tuple;
+
+	if (!OidIsValid(relid))
+	{
+		for (dict = zstd_dictionaries; dict != NULL; dict = dict->next)
+		{
+			if (dict->dictid == dictid)
+				return dict;
+		}
+	}
+
+	dictrelid = get_relname_relid(ZSTD_DICTIONARY_RELNAME, PG_CATALOG_NAMESPACE);
+	if (!OidIsValid(dictrelid))
+		return NULL;
+
+	if (OidIsValid(relid))
+	{
+		ScanKeyInit(&key[0],
+					Anum_gp_zstd_dictionary_relid,
+					BTEqualStrategyNumber, F_OIDEQ,
+					ObjectIdGetDatum(relid));
+		ScanKeyInit(&key[1],
+					Anum_gp_zstd_dictionary_attnum,
+					BTEqualStrategyNumber, F_INT2EQ,
+					Int16GetDatum(attnum));
+		ScanKeyInit(&key[2],
+					Anum_gp_zstd_dictionary_active,
+					BTEqualStrategyNumber, F_BOOLEQ,
+					BoolGetDatum(true));
+		nkeys = 3;
+	}
+	else
+	{
+		ScanKeyInit(&key[0],
+					Anum_gp_zstd_dictionary_dictid,
+					BTEqualStrategyNumber, F_OIDEQ,
+					ObjectIdGetDatum(dictid));
+		nkeys = 1;
+	}
+
+	rel = heap_open(dictrelid, AccessShareLock);
+	scan = systable_beginscan(rel, InvalidOid, false, NULL, nkeys, key);
+
+	dict = NULL;
+	if (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		bool		isnull;
+		Datum		datum;
+
+		datum = heap_getattr(tuple, Anum_gp_zstd_dictionary_dictid,
+							 RelationGetDescr(rel), &isnull);
+		Assert(!isnull);
+		dictid = DatumGetObjectId(datum);
+
+		for (dict = zstd_dictionaries; dict != NULL; dict = dict->next)
+		{
+			if (dict->dictid == dictid)
+				break;
+		}
+
+		if (dict == NULL)
+		{
+			bytea	   *data;
+
+			datum = heap_getattr(tuple, Anum_gp_zstd_dictionary_dict,
+								 RelationGetDescr(rel), &isnull);
+			if (isnull)
+				elog(ERROR, "zstd dictionary %u has no data", dictid);
+			data = DatumGetByteaP(datum);
+
+			dict = MemoryContextAllocZero(TopMemoryContext, sizeof(zstd_dictionary));
+			dict->dictid = dictid;
+			dict->size = VARSIZE(data) - VARHDRSZ;
+			dict->data = MemoryContextAlloc(TopMemoryContext, dict->size);
+			memcpy(dict->data, VARDATA(data), dict->size);
+
+			dict->next = zstd_dictionaries;
+			zstd_dictionaries = dict;
+		}
+	}
+
+	systable_endscan(scan);
+	heap_close(rel, AccessShareLock);
+
+	return dict;
+}
+
+static ZSTD_CDict *
+zstd_get_cdict(zstd_dictionary *dict, int level)
+{
+	if (dict->cdict != NULL && dict->cdict_level != level)
+	{
+		ZSTD_freeCDict(dict->cdict);
+		dict->cdict = NULL;
+	}
+
+	if (dict->cdict == NULL)
+	{
+		dict->cdict = ZSTD_createCDict(dict->data, dict->size, level);
+		if (dict->cdict == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+		dict->cdict_level = level;
+	}
+
+	return dict->cdict;
+}
+
+static ZSTD_DDict *
+zstd_get_ddict(zstd_dictionary *dict)
+{
+	if (dict->ddict == NULL)
+	{
+		dict->ddict = ZSTD_createDDict(dict->data, dict->size);
+		if (dict->ddict == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+	}
+
+	return dict->ddict;
+}
+
 Datum
 zstd_constructor(PG_FUNCTION_ARGS)
 {
@@ -66,9 +273,27 @@ zstd_constructor(PG_FUNCTION_ARGS)
 	state->level = sa->complevel;
 	state->compress = compress;
 
-	state->ctx = zstd_alloc_context();
-	state->ctx->cctx = ZSTD_createCCtx();
-	state->ctx->dctx = ZSTD_createDCtx();
+	if (compress)
+	{
+		if (zstd_cctx == NULL)
+			zstd_cctx = ZSTD_createCCtx();
+		if (zstd_cctx == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+
+		if (OidIsValid(sa->relid))
+			state->dict = zstd_lookup_dictionary(sa->relid, sa->attnum, 0);
+	}
+	else
+	{
+		if (zstd_dctx == NULL)
+			zstd_dctx = ZSTD_createDCtx();
+		if (zstd_dctx == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+	}
 
 	PG_RETURN_POINTER(cs);
 }
@@ -82,7 +307,6 @@ zstd_destructor(PG_FUNCTION_ARGS)
 	{
 		zstd_state *state = (zstd_state *) cs->opaque;
 
-		zstd_free_context(state->ctx);
 		pfree(state);
 	}
 
@@ -109,10 +333,17 @@ zstd_compress(PG_FUNCTION_ARGS)
 
 	unsigned long dst_length_used;
 
-	dst_length_used = ZSTD_compressCCtx(state->ctx->cctx,
-										dst, dst_sz,
-										src, src_sz,
-										state->level);
+	if (state->dict != NULL)
+		dst_length_used = ZSTD_compress_usingCDict(zstd_cctx,
+												   dst, dst_sz,
+												   src, src_sz,
+												   zstd_get_cdict(state->dict,
+																  state->level));
+	else
+		dst_length_used = ZSTD_compressCCtx(zstd_cctx,
+											dst, dst_sz,
+											src, src_sz,
+											state->level);
 
 	if (ZSTD_isError(dst_length_used))
 	{
@@ -143,19 +374,38 @@ zstd_decompress(PG_FUNCTION_ARGS)
 	void	   *dst = PG_GETARG_POINTER(2);
 	int32		dst_sz = PG_GETARG_INT32(3);
 	int32	   *dst_used = (int32 *) PG_GETARG_POINTER(4);
-	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(5);
-	zstd_state *state = (zstd_state *) cs->opaque;
+
+	/* PG_GETARG_POINTER(5) is the CompressionState, unused */
 
 	unsigned long dst_length_used;
+	unsigned	dictid;
 
 	if (src_sz <= 0)
 		elog(ERROR, "invalid source buffer size %d", src_sz);
 	if (dst_sz <= 0)
 		elog(ERROR, "invalid destination buffer size %d", dst_sz);
 
-	dst_length_used = ZSTD_decompressDCtx(state->ctx->dctx,
-										  dst, dst_sz,
-										  src, src_sz);
+	/* A block compressed with a dictionary has its ID in the frame header */
+	dictid = ZSTD_getDictID_fromFrame(src, src_sz);
+	if (dictid != 0)
+	{
+		zstd_dictionary *dict = zstd_lookup_dictionary(InvalidOid, 0, dictid);
+
+		if (dict == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("zstd dictionary %u of compressed block not found",
+							dictid)));
+
+		dst_length_used = ZSTD_decompress_usingDDict(zstd_dctx,
+													 dst, dst_sz,
+													 src, src_sz,
+													 zstd_get_ddict(dict));
+	}
+	else
+		dst_length_used = ZSTD_decompressDCtx(zstd_dctx,
+											  dst, dst_sz,
+											  src, src_sz);
 
 	if (ZSTD_isError(dst_length_used))
 	{
@@ -172,3 +422,263 @@ zstd_validator(PG_FUNCTION_ARGS)
 {
 	PG_RETURN_VOID();
 }
+
+/*
+ * Store a dictionary in the local gp_zstd_dictionary, as the active one of
+ * its column
+ */
+static void
+zstd_store_dictionary_local(unsigned dictid, Oid relid, AttrNumber attnum,
+							bytea *data)
+{
+	Oid			dictrelid;
+	Relation	rel;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	Datum		values[Natts_gp_zstd_dictionary];
+	bool		nulls[Natts_gp_zstd_dictionary];
+	bool		replaces[Natts_gp_zstd_dictionary];
+
+	dictrelid = get_relname_relid(ZSTD_DICTIONARY_RELNAME, PG_CATALOG_NAMESPACE);
+	if (!OidIsValid(dictrelid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_TABLE),
+				 errmsg("relation \"%s\" does not exist", ZSTD_DICTIONARY_RELNAME)));
+
+	rel = heap_open(dictrelid, RowExclusiveLock);
+
+	MemSet(values, 0, sizeof(values));
+	MemSet(nulls, false, sizeof(nulls));
+	MemSet(replaces, false, sizeof(replaces));
+
+	/* The previous dictionary of the column stays, for its blocks */
+	scan = systable_beginscan(rel, InvalidOid, false, NULL, 0, NULL);
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		TupleDesc	tupdesc = RelationGetDescr(rel);
+		bool		isnull;
+
+		if (DatumGetObjectId(heap_getattr(tuple, Anum_gp_zstd_dictionary_dictid,
+										  tupdesc, &isnull)) == dictid)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("zstd dictionary %u already exists", dictid),
+					 errhint("Train the dictionary again.")));
+
+		if (DatumGetObjectId(heap_getattr(tuple, Anum_gp_zstd_dictionary_relid,
+										  tupdesc, &isnull)) == relid &&
+			DatumGetInt16(heap_getattr(tuple, Anum_gp_zstd_dictionary_attnum,
+									   tupdesc, &isnull)) == attnum &&
+			DatumGetBool(heap_getattr(tuple, Anum_gp_zstd_dictionary_active,
+									  tupdesc, &isnull)))
+		{
+			HeapTuple	newtuple;
+
+			values[Anum_gp_zstd_dictionary_active - 1] = BoolGetDatum(false);
+			replaces[Anum_gp_zstd_dictionary_active - 1] = true;
+			newtuple = heap_modify_tuple(tuple, tupdesc, values, nulls, replaces);
+			simple_heap_update(rel, &tuple->t_self, newtuple);
+			heap_freetuple(newtuple);
+		}
+	}
+	systable_endscan(scan);
+
+	values[Anum_gp_zstd_dictionary_dictid - 1] = ObjectIdGetDatum(dictid);
+	values[Anum_gp_zstd_dictionary_relid - 1] = ObjectIdGetDatum(relid);
+	values[Anum_gp_zstd_dictionary_attnum - 1] = Int16GetDatum(attnum);
+	values[Anum_gp_zstd_dictionary_active - 1] = BoolGetDatum(true);
+	values[Anum_gp_zstd_dictionary_dict - 1] = PointerGetDatum(data);
+
+	tuple = heap_form_tuple(RelationGetDescr(rel), values, nulls);
+	simple_heap_insert(rel, tuple);
+	heap_freetuple(tuple);
+
+	heap_close(rel, NoLock);
+
+	CommandCounterIncrement();
+}
+
+/*
+ * gp_zstd_train_dictionary(rel regclass, attname name, dict_size int4,
+ *							sample text)
+ *
+ * Train a dictionary for the blocks of column attname of rel, or for the
+ * rows of rel if attname is NULL, and make it the one its new blocks are
+ * compressed with.  The dictionary is trained from the values of the column,
+ * or from the values returned by the query sample if it's given, so that a
+ * table can get its dictionary before it is loaded, from another table.
+ *
+ * Returns the ID of the dictionary.
+ */
+Datum
+zstd_train_dictionary(PG_FUNCTION_ARGS)
+{
+	Oid			relid;
+	AttrNumber	attnum = 0;
+	int32		dict_size;
+	char	   *relname;
+	StringInfoData query;
+	StringInfoData samples;
+	size_t	   *sample_sizes;
+	unsigned	nsamples = 0;
+	bytea	   *dict;
+	size_t		trained_size;
+	unsigned	dictid;
+	uint64		i;
+	int			ret;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(2))
+		PG_RETURN_NULL();
+
+	relid = PG_GETARG_OID(0);
+	dict_size = PG_GETARG_INT32(2);
+
+	if (Gp_role == GP_ROLE_EXECUTE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("gp_zstd_train_dictionary() can only be called on the master")));
+
+	relname = get_rel_name(relid);
+	if (relname == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_TABLE),
+				 errmsg("relation with OID %u does not exist", relid)));
+
+	if (!pg_class_ownercheck(relid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS, relname);
+
+	if (dict_size < 256 || dict_size > MaxAllocSize - VARHDRSZ)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid zstd dictionary size %d", dict_size)));
+
+	if (!PG_ARGISNULL(1))
+	{
+		char	   *attname = NameStr(*PG_GETARG_NAME(1));
+
+		attnum = get_attnum(relid, attname);
+		if (attnum == InvalidAttrNumber)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("column \"%s\" of relation \"%s\" does not exist",
+							attname, relname)));
+	}
+
+	initStringInfo(&query);
+	if (!PG_ARGISNULL(3))
+		appendStringInfoString(&query, text_to_cstring(PG_GETARG_TEXT_PP(3)));
+	else
+	{
+		char	   *qualname =
+			quote_qualified_identifier(get_namespace_name(get_rel_namespace(relid)),
+									   relname);
+
+		if (attnum != 0)
+			appendStringInfo(&query, "SELECT %s FROM %s",
+							 quote_identifier(get_attname(relid, attnum)),
+							 qualname);
+		else
+			appendStringInfo(&query, "SELECT t FROM %s t", qualname);
+	}
+
+	if ((ret = SPI_connect()) < 0)
+		elog(ERROR, "SPI_connect failed: error code %d", ret);
+
+	ret = SPI_execute(query.data, true, ZSTD_DICTIONARY_SAMPLE_ROWS);
+	if (ret != SPI_OK_SELECT)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("could not sample the values to train a zstd dictionary from"),
+				 errdetail("The sample must be a query returning one column.")));
+	if (SPI_tuptable->tupdesc->natts != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("the sample to train a zstd dictionary from must return one column")));
+
+	/* The samples are the text of the values, one after the other */
+	initStringInfo(&samples);
+	sample_sizes = palloc(sizeof(size_t) * Max(SPI_processed, 1));
+	for (i = 0; i < SPI_processed; i++)
+	{
+		char	   *value = SPI_getvalue(SPI_tuptable->vals[i],
+										 SPI_tuptable->tupdesc, 1);
+		int			len;
+
+		if (value == NULL)
+			continue;
+
+		len = strlen(value);
+		if ((int64) samples.len + len >
+			(int64) dict_size * ZSTD_DICTIONARY_SAMPLE_FACTOR)
+			break;
+
+		appendBinaryStringInfo(&samples, value, len);
+		sample_sizes[nsamples++] = len;
+		pfree(value);
+	}
+
+	dict = (bytea *) SPI_palloc(dict_size + VARHDRSZ);
+	trained_size = ZDICT_trainFromBuffer(VARDATA(dict), dict_size,
+										 samples.data, sample_sizes, nsamples);
+	if (ZDICT_isError(trained_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("could not train zstd dictionary from %u values: %s",
+						nsamples, ZDICT_getErrorName(trained_size))));
+	SET_VARSIZE(dict, trained_size + VARHDRSZ);
+
+	dictid = ZDICT_getDictID(VARDATA(dict), trained_size);
+
+	SPI_finish();
+
+	zstd_store_dictionary_local(dictid, relid, attnum, dict);
+
+	if (Gp_role == GP_ROLE_DISPATCH)
+	{
+		char	   *hex = palloc(trained_size * 2 + 1);
+		char	   *sql;
+
+		hex[hex_encode(VARDATA(dict), trained_size, hex)] = '\0';
+		sql = psprintf("SELECT pg_catalog.gp_zstd_store_dictionary(%u, %u, %d, decode('%s', 'hex'))",
+					   dictid, relid, attnum, hex);
+
+		CdbDispatchCommand(sql,
+						   DF_CANCEL_ON_ERROR |
+						   DF_NEED_TWO_PHASE |
+						   DF_WITH_SNAPSHOT,
+						   NULL);
+
+		pfree(sql);
+		pfree(hex);
+	}
+
+	PG_RETURN_OID(dictid);
+}
+
+/*
+ * gp_zstd_store_dictionary(dictid oid, relid oid, attnum int2, dict bytea)
+ *
+ * The segments' part of gp_zstd_train_dictionary: store the dictionary
+ * trained on the master.
+ */
+Datum
+zstd_store_dictionary(PG_FUNCTION_ARGS)
+{
+	unsigned	dictid = PG_GETARG_OID(0);
+	Oid			relid = PG_GETARG_OID(1);
+	AttrNumber	attnum = PG_GETARG_INT16(2);
+	bytea	   *dict = PG_GETARG_BYTEA_P(3);
+
+	if (Gp_role == GP_ROLE_DISPATCH)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("gp_zstd_store_dictionary() cannot be called on the master"),
+				 errhint("Use gp_zstd_train_dictionary().")));
+
+	if (!pg_class_ownercheck(relid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS, get_rel_name(relid));
+
+	zstd_store_dictionary_local(dictid, relid, attnum, dict);
+
+	PG_RETURN_VOID();
+}
@@ -20,3 +20,15 @@ COMMENT ON FUNCTION gp_zstd_validator(internal) IS 'zstdcompression validator';
 
 INSERT INTO pg_catalog.pg_compression (compname, compconstructor, compdestructor, compcompressor, compdecompressor, compvalidator, compowner)
 VALUES ('zstd', 'gp_zstd_constructor', 'gp_zstd_destructor', 'gp_zstd_compress', 'gp_zstd_decompress', 'gp_zstd_validator', 10 /* BOOTSTRAP_SUPERUSERID */);
+
+-- Trained dictionaries, see gp_zstd_train_dictionary()
+CREATE TABLE pg_catalog.gp_zstd_dictionary (dictid oid, relid oid, attnum int2, active bool, dict bytea);
+COMMENT ON TABLE pg_catalog.gp_zstd_dictionary IS 'zstd dictionaries of append-only columns';
+
+CREATE FUNCTION gp_zstd_train_dictionary(rel regclass, attname name, dict_size int4 DEFAULT 112640, sample text DEFAULT NULL) RETURNS oid
+LANGUAGE C VOLATILE AS '$libdir/gp_zstd_compression.so', 'zstd_train_dictionary';
+COMMENT ON FUNCTION gp_zstd_train_dictionary(regclass, name, int4, text) IS 'train the zstd dictionary new blocks of a column are compressed with';
+
+CREATE FUNCTION gp_zstd_store_dictionary(oid, oid, int2, bytea) RETURNS void
+LANGUAGE C VOLATILE STRICT AS '$libdir/gp_zstd_compression.so', 'zstd_store_dictionary';
+COMMENT ON FUNCTION gp_zstd_store_dictionary(oid, oid, int2, bytea) IS 'store a zstd dictionary trained on the master';
@@ -304,6 +304,8 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	AOTupleId  *aoTupleId;
 	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
+	int64		delayMovedTupleCount = 0;
+	double		bytesPerTuple = 0;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoCols(aorel));
@@ -314,6 +316,12 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	{
 		tuplePerPage = fsinfo->total_tupcount / fsinfo->varblockcount;
 	}
+	if (fsinfo->total_tupcount > 0)
+	{
+		for (i = 0; i < fsinfo->vpinfo.nEntry; ++i)
+			bytesPerTuple += getAOCSVPEntry(fsinfo, i)->eof;
+		bytesPerTuple /= fsinfo->total_tupcount;
+	}
 	relname = RelationGetRelationName(aorel);
 
 	AppendOnlyVisimap_Init(&visiMap,
@@ -380,7 +388,9 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 		tupleCount++;
 		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			AppendOnlyCompaction_DelayPoint(tuplePerPage * bytesPerTuple,
+											(movedTupleCount - delayMovedTupleCount) * bytesPerTuple);
+			delayMovedTupleCount = movedTupleCount;
 		}
 	}
 
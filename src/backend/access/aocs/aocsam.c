@@ -25,8 +25,11 @@
 #include "catalog/catalog.h"
 #include "catalog/gp_fastsequence.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_appendonly_fn.h"
 #include "catalog/pg_attribute_encoding.h"
+#include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "cdb/cdbaocsam.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbappendonlyblockdirectory.h"
@@ -34,16 +37,20 @@
 #include "cdb/cdbappendonlystorageread.h"
 #include "cdb/cdbappendonlystoragewrite.h"
 #include "cdb/cdbvars.h"
+#include "commands/defrem.h"
+#include "executor/executor.h"
 #include "fmgr.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/procarray.h"
 #include "storage/smgr.h"
+#include "utils/array.h"
 #include "utils/datumstream.h"
 #include "utils/faultinjector.h"
 #include "utils/guc.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/relcache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
@@ -55,6 +62,51 @@ static AOCSScanDesc aocs_beginscan_internal(Relation relation,
 						Snapshot snapshot,
 						Snapshot appendOnlyMetaDataSnapshot,
 						TupleDesc relationTupleDesc, bool *proj);
+static void init_zonemap_skip_ranges(AOCSScanDesc scan,
+						 AOCSFileSegInfo *segInfo);
+static void reset_zonemap_skip_ranges(AOCSScanDesc scan);
+static bool skip_column_to_row(AOCSScanDesc scan, int attno, int64 rowNum);
+static bool skip_to_row(AOCSScanDesc scan, int64 rowNum);
+static void reset_dictionary_quals(AOCSScanDesc scan);
+static void init_late_materialization(AOCSScanDesc scan,
+						  AOCSFileSegInfo *segInfo);
+static bool dictionary_quals_may_match(AOCSScanDesc scan, Datum *d,
+						   bool *null);
+
+/*
+ * A qual of a scan that can be checked against the zone maps: the column
+ * compared with a constant by a btree operator, or an IS NULL test of the
+ * column if strategy is InvalidStrategy.
+ */
+typedef struct AOCSZoneMapQual
+{
+	int			attno;			/* column number, starting from 0 */
+	StrategyNumber strategy;
+	int64		value;
+} AOCSZoneMapQual;
+
+/* Results of an AOCSDictionaryQual for the codes of a block */
+#define DICTIONARY_QUAL_UNKNOWN	0
+#define DICTIONARY_QUAL_TRUE	1
+#define DICTIONARY_QUAL_FALSE	2
+
+/*
+ * A qual of a scan that can be checked once for each code of a
+ * dictionary-compressed block: the column compared with a constant by an
+ * operator, or with any element of a constant array.
+ */
+typedef struct AOCSDictionaryQual
+{
+	int			attno;			/* column number, starting from 0 */
+	FmgrInfo	flinfo;
+	Oid			collation;
+	bool		varOnLeft;
+	Datum	   *values;			/* satisfied if any of them matches */
+	int			nvalues;
+	int64		blockFileOffset;	/* of the block of the results, or -1 */
+	char	   *results;		/* by code, DICTIONARY_QUAL_* */
+	int32		maxResults;
+} AOCSDictionaryQual;
 
 /*
  * Open the segment file for a specified column associated with the datum
@@ -165,6 +217,8 @@ open_ds_write(Relation rel, DatumStreamWrite **ds, TupleDesc relationTupleDesc,
 										/* title */ titleBuf.data,
 										RelationNeedsWAL(rel));
 
+		if (CanBulkLoadAOSegmentFiles(rel))
+			AppendOnlyStorageWrite_SetBulkLoad(&ds[i]->ao_write);
 	}
 }
 
@@ -347,6 +401,18 @@ open_next_scan_seg(AOCSScanDesc scan)
 												  scan->num_proj_atts,
 												  scan->blockDirectory);
 
+				if (scan->zonemapQuals != NIL)
+					init_zonemap_skip_ranges(scan, curSegInfo);
+				init_late_materialization(scan, curSegInfo);
+
+				/*
+				 * Load the visibility map entries of the segment file at
+				 * once, so that the runs of hidden rows can be skipped.
+				 */
+				if (scan->snapshot != SnapshotAny)
+					AppendOnlyVisimap_LoadSegmentFile(&scan->visibilityMap,
+													  curSegInfo->segno);
+
 				return scan->cur_seg;
 			}
 		}
@@ -372,6 +438,10 @@ close_cur_scan_seg(AOCSScanDesc scan)
 
 	if (scan->blockDirectory)
 		AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
+
+	reset_zonemap_skip_ranges(scan);
+	reset_dictionary_quals(scan);
+	scan->lateMaterialize = false;
 }
 
 /*
@@ -502,6 +572,785 @@ aocs_beginscan_internal(Relation relation,
 	return scan;
 }
 
+/*
+ * Make an AOCSZoneMapQual of a qual if it can be checked against the zone
+ * maps, otherwise return NULL.
+ */
+static AOCSZoneMapQual *
+make_zonemap_qual(AOCSScanDesc scan, Expr *qual)
+{
+	TupleDesc	tupdesc = scan->relationTupleDesc;
+	AOCSZoneMapQual *zq;
+	Var		   *var;
+
+	if (IsA(qual, NullTest))
+	{
+		NullTest   *ntest = (NullTest *) qual;
+
+		if (ntest->nulltesttype != IS_NULL || ntest->argisrow ||
+			!IsA(ntest->arg, Var))
+			return NULL;
+		var = (Var *) ntest->arg;
+		if (var->varattno <= 0 || var->varattno > tupdesc->natts ||
+			!AppendOnlyBlockDirectory_ZoneMapType(var->vartype))
+			return NULL;
+
+		zq = palloc0(sizeof(AOCSZoneMapQual));
+		zq->attno = var->varattno - 1;
+		zq->strategy = InvalidStrategy;
+		return zq;
+	}
+	else if (IsA(qual, OpExpr) && list_length(((OpExpr *) qual)->args) == 2)
+	{
+		OpExpr	   *opexpr = (OpExpr *) qual;
+		Node	   *left = linitial(opexpr->args);
+		Node	   *right = lsecond(opexpr->args);
+		Const	   *con;
+		bool		varOnLeft;
+		Oid			opclass;
+		int			strategy;
+
+		if (IsA(left, Var) && IsA(right, Const))
+		{
+			var = (Var *) left;
+			con = (Const *) right;
+			varOnLeft = true;
+		}
+		else if (IsA(left, Const) && IsA(right, Var))
+		{
+			var = (Var *) right;
+			con = (Const *) left;
+			varOnLeft = false;
+		}
+		else
+			return NULL;
+
+		if (var->varattno <= 0 || var->varattno > tupdesc->natts ||
+			con->constisnull ||
+			var->vartype != tupdesc->attrs[var->varattno - 1]->atttypid ||
+			!AppendOnlyBlockDirectory_ZoneMapType(var->vartype) ||
+			!AppendOnlyBlockDirectory_ZoneMapType(con->consttype))
+			return NULL;
+
+		/*
+		 * The values of different types are only comparable in the zone
+		 * maps if both are integers.
+		 */
+		if (var->vartype != con->consttype &&
+			!((var->vartype == INT2OID || var->vartype == INT4OID ||
+			   var->vartype == INT8OID) &&
+			  (con->consttype == INT2OID || con->consttype == INT4OID ||
+			   con->consttype == INT8OID)))
+			return NULL;
+
+		opclass = GetDefaultOpClass(var->vartype, BTREE_AM_OID);
+		if (!OidIsValid(opclass))
+			return NULL;
+		strategy = get_op_opfamily_strategy(opexpr->opno,
+											get_opclass_family(opclass));
+		if (strategy == InvalidStrategy)
+			return NULL;
+
+		/* Make it the column compared with the constant */
+		if (!varOnLeft)
+		{
+			switch (strategy)
+			{
+				case BTLessStrategyNumber:
+					strategy = BTGreaterStrategyNumber;
+					break;
+				case BTLessEqualStrategyNumber:
+					strategy = BTGreaterEqualStrategyNumber;
+					break;
+				case BTGreaterEqualStrategyNumber:
+					strategy = BTLessEqualStrategyNumber;
+					break;
+				case BTGreaterStrategyNumber:
+					strategy = BTLessStrategyNumber;
+					break;
+				default:
+					break;
+			}
+		}
+
+		zq = palloc0(sizeof(AOCSZoneMapQual));
+		zq->attno = var->varattno - 1;
+		zq->strategy = strategy;
+		zq->value = AppendOnlyBlockDirectory_ZoneMapValue(con->consttype,
+														  con->constvalue);
+		return zq;
+	}
+
+	return NULL;
+}
+
+/*
+ * aocs_set_zonemap_quals
+ *
+ * Let the scan skip the blocks that the zone maps in the block directory
+ * show have no rows satisfying the quals, an implicitly-ANDed list of
+ * expressions on the columns of the relation. The quals must still be
+ * checked on the rows returned.
+ *
+ * Only those of the quals that compare a column with a constant, or test a
+ * column for NULL, are used. Nothing is skipped unless gp_appendonly_zone_maps
+ * is on and the relation has a block directory.
+ */
+void
+aocs_set_zonemap_quals(AOCSScanDesc scan, List *quals)
+{
+	ListCell   *lc;
+
+	if (!gp_appendonly_zone_maps ||
+		!OidIsValid(scan->aos_rel->rd_appendonly->blkdirrelid))
+		return;
+
+	foreach(lc, quals)
+	{
+		Expr	   *qual = (Expr *) lfirst(lc);
+		AOCSZoneMapQual *zq;
+
+		if (IsA(qual, BoolExpr) && ((BoolExpr *) qual)->boolop == AND_EXPR)
+		{
+			aocs_set_zonemap_quals(scan, ((BoolExpr *) qual)->args);
+			continue;
+		}
+
+		zq = make_zonemap_qual(scan, qual);
+		if (zq != NULL)
+			scan->zonemapQuals = lappend(scan->zonemapQuals, zq);
+	}
+
+	if (scan->zonemapQuals != NIL && scan->zonemapContext == NULL)
+		scan->zonemapContext = AllocSetContextCreate(CurrentMemoryContext,
+													 "AOCS zone map context",
+													 ALLOCSET_SMALL_MINSIZE,
+													 ALLOCSET_SMALL_INITSIZE,
+													 ALLOCSET_DEFAULT_MAXSIZE);
+}
+
+/*
+ * Make an AOCSDictionaryQual of a qual if it can be checked for the codes of
+ * the dictionary-compressed blocks, otherwise return NULL.
+ *
+ * Only operators that are leakproof and not volatile are used, so that
+ * evaluating them ahead of the other quals of the scan cannot raise errors
+ * or have effects that the quals would not have had.
+ */
+static AOCSDictionaryQual *
+make_dictionary_qual(AOCSScanDesc scan, Expr *qual)
+{
+	TupleDesc	tupdesc = scan->relationTupleDesc;
+	AOCSDictionaryQual *dq;
+	Node	   *left;
+	Node	   *right;
+	Oid			opno;
+	Oid			collation;
+	Var		   *var;
+	Const	   *con;
+	bool		varOnLeft;
+	Oid			funcid;
+	int			i;
+
+	if (IsA(qual, OpExpr) && list_length(((OpExpr *) qual)->args) == 2)
+	{
+		OpExpr	   *opexpr = (OpExpr *) qual;
+
+		left = linitial(opexpr->args);
+		right = lsecond(opexpr->args);
+		opno = opexpr->opno;
+		collation = opexpr->inputcollid;
+	}
+	else if (IsA(qual, ScalarArrayOpExpr) &&
+			 ((ScalarArrayOpExpr *) qual)->useOr)
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) qual;
+
+		left = linitial(saop->args);
+		right = lsecond(saop->args);
+		if (!IsA(right, Const))
+			return NULL;
+		opno = saop->opno;
+		collation = saop->inputcollid;
+	}
+	else
+		return NULL;
+
+	/* Binary-compatible casts of the column don't change its datums */
+	while (IsA(left, RelabelType))
+		left = (Node *) ((RelabelType *) left)->arg;
+	while (IsA(right, RelabelType))
+		right = (Node *) ((RelabelType *) right)->arg;
+
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		con = (Const *) right;
+		varOnLeft = true;
+	}
+	else if (IsA(left, Const) && IsA(right, Var) && IsA(qual, OpExpr))
+	{
+		var = (Var *) right;
+		con = (Const *) left;
+		varOnLeft = false;
+	}
+	else
+		return NULL;
+
+	if (var->varattno <= 0 || var->varattno > tupdesc->natts ||
+		con->constisnull ||
+		var->vartype != tupdesc->attrs[var->varattno - 1]->atttypid ||
+		tupdesc->attrs[var->varattno - 1]->attlen != -1)
+		return NULL;
+
+	/* The column must be read by the scan */
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		if (scan->proj_atts[i] == var->varattno - 1)
+			break;
+	}
+	if (i == scan->num_proj_atts)
+		return NULL;
+
+	funcid = get_opcode(opno);
+	if (!OidIsValid(funcid) ||
+		!get_func_leakproof(funcid) ||
+		func_volatile(funcid) == PROVOLATILE_VOLATILE)
+		return NULL;
+
+	dq = palloc0(sizeof(AOCSDictionaryQual));
+	dq->attno = var->varattno - 1;
+	fmgr_info(funcid, &dq->flinfo);
+	dq->collation = collation;
+	dq->varOnLeft = varOnLeft;
+	dq->blockFileOffset = -1;
+
+	if (IsA(qual, ScalarArrayOpExpr))
+	{
+		ArrayType  *arr = DatumGetArrayTypeP(con->constvalue);
+		int16		elmlen;
+		bool		elmbyval;
+		char		elmalign;
+		Datum	   *values;
+		bool	   *nulls;
+		int			nvalues;
+
+		get_typlenbyvalalign(ARR_ELEMTYPE(arr), &elmlen, &elmbyval, &elmalign);
+		deconstruct_array(arr, ARR_ELEMTYPE(arr), elmlen, elmbyval, elmalign,
+						  &values, &nulls, &nvalues);
+
+		/* NULL elements never make the qual true */
+		dq->values = palloc(sizeof(Datum) * Max(nvalues, 1));
+		for (i = 0; i < nvalues; i++)
+		{
+			if (!nulls[i])
+				dq->values[dq->nvalues++] = values[i];
+		}
+		pfree(values);
+		pfree(nulls);
+	}
+	else
+	{
+		dq->values = palloc(sizeof(Datum));
+		dq->values[0] = con->constvalue;
+		dq->nvalues = 1;
+	}
+
+	return dq;
+}
+
+/*
+ * aocs_set_dictionary_quals
+ *
+ * Let the scan check the quals, an implicitly-ANDed list of expressions on
+ * the columns of the relation, once for each code of the dictionary-compressed
+ * blocks it reads, rather than for each row. The rows the quals can't be
+ * satisfied for are skipped, before their visibility is checked. The quals
+ * must still be checked on the rows returned.
+ *
+ * Only those of the quals that compare a column with a constant, or with the
+ * elements of a constant array with ANY, are used.
+ */
+void
+aocs_set_dictionary_quals(AOCSScanDesc scan, List *quals)
+{
+	ListCell   *lc;
+
+	foreach(lc, quals)
+	{
+		Expr	   *qual = (Expr *) lfirst(lc);
+		AOCSDictionaryQual *dq;
+
+		if (IsA(qual, BoolExpr) && ((BoolExpr *) qual)->boolop == AND_EXPR)
+		{
+			aocs_set_dictionary_quals(scan, ((BoolExpr *) qual)->args);
+			continue;
+		}
+
+		dq = make_dictionary_qual(scan, qual);
+		if (dq != NULL)
+			scan->dictionaryQuals = lappend(scan->dictionaryQuals, dq);
+	}
+
+	if (scan->dictionaryQuals != NIL && scan->dictionaryContext == NULL)
+		scan->dictionaryContext = AllocSetContextCreate(CurrentMemoryContext,
+														"AOCS dictionary qual context",
+														ALLOCSET_SMALL_MINSIZE,
+														ALLOCSET_SMALL_INITSIZE,
+														ALLOCSET_DEFAULT_MAXSIZE);
+}
+
+/*
+ * Forget the results of the dictionary quals, the blocks of the next segment
+ * file may be at the same offsets.
+ */
+static void
+reset_dictionary_quals(AOCSScanDesc scan)
+{
+	ListCell   *lc;
+
+	foreach(lc, scan->dictionaryQuals)
+		((AOCSDictionaryQual *) lfirst(lc))->blockFileOffset = -1;
+}
+
+/*
+ * Whether the row read into d and null may satisfy the dictionary quals.
+ *
+ * The result of a qual for the code of a value is computed the first time the
+ * code is seen in the block, and used for the rest of the values of the block
+ * with the same code.
+ */
+static bool
+dictionary_quals_may_match(AOCSScanDesc scan, Datum *d, bool *null)
+{
+	ListCell   *lc;
+
+	foreach(lc, scan->dictionaryQuals)
+	{
+		AOCSDictionaryQual *dq = (AOCSDictionaryQual *) lfirst(lc);
+		DatumStreamRead *ds = scan->ds[dq->attno];
+		int32		code;
+
+		if (null[dq->attno])
+			continue;
+		code = datumstreamread_dictionary_code(ds);
+		if (code < 0)
+			continue;
+
+		if (dq->blockFileOffset != ds->blockFileOffset)
+		{
+			int32		count = datumstreamread_dictionary_count(ds);
+
+			if (count > dq->maxResults)
+			{
+				if (dq->results != NULL)
+					pfree(dq->results);
+				dq->results = MemoryContextAlloc(GetMemoryChunkContext(dq),
+												 count);
+				dq->maxResults = count;
+			}
+			memset(dq->results, DICTIONARY_QUAL_UNKNOWN, count);
+			dq->blockFileOffset = ds->blockFileOffset;
+			MemoryContextReset(scan->dictionaryContext);
+		}
+
+		if (dq->results[code] == DICTIONARY_QUAL_UNKNOWN)
+		{
+			MemoryContext oldcxt;
+			bool		match = false;
+			int			i;
+
+			oldcxt = MemoryContextSwitchTo(scan->dictionaryContext);
+			for (i = 0; i < dq->nvalues && !match; i++)
+			{
+				Datum		result;
+
+				if (dq->varOnLeft)
+					result = FunctionCall2Coll(&dq->flinfo, dq->collation,
+											   d[dq->attno], dq->values[i]);
+				else
+					result = FunctionCall2Coll(&dq->flinfo, dq->collation,
+											   dq->values[i], d[dq->attno]);
+				match = DatumGetBool(result);
+			}
+			MemoryContextSwitchTo(oldcxt);
+
+			dq->results[code] = match ? DICTIONARY_QUAL_TRUE :
+				DICTIONARY_QUAL_FALSE;
+		}
+
+		if (dq->results[code] == DICTIONARY_QUAL_FALSE)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * aocs_set_late_quals
+ *
+ * Let the scan read the columns that the quals don't use only for the rows
+ * that satisfy the quals. qualCols marks the columns the quals use, qualstate
+ * are their ExprStates, evaluated in econtext with the scan slot as the scan
+ * tuple. The quals must still be checked on the rows returned.
+ *
+ * The quals must not be volatile, nor use the system columns, which are
+ * only set when the row is returned. Nothing is read late unless
+ * gp_appendonly_late_materialization is on, and there are projected columns
+ * both used and not used by the quals. Segment files of older formats are
+ * read as usual, see init_late_materialization().
+ */
+void
+aocs_set_late_quals(AOCSScanDesc scan, bool *qualCols, List *qualstate,
+					ExprContext *econtext)
+{
+	int			i;
+
+	if (!gp_appendonly_late_materialization || qualstate == NIL)
+		return;
+
+	scan->qual_atts = palloc(sizeof(int) * Max(scan->num_proj_atts, 1));
+	scan->late_atts = palloc(sizeof(int) * Max(scan->num_proj_atts, 1));
+	scan->num_qual_atts = 0;
+	scan->num_late_atts = 0;
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		if (qualCols[attno])
+			scan->qual_atts[scan->num_qual_atts++] = attno;
+		else
+			scan->late_atts[scan->num_late_atts++] = attno;
+	}
+
+	if (scan->num_qual_atts == 0 || scan->num_late_atts == 0)
+	{
+		pfree(scan->qual_atts);
+		pfree(scan->late_atts);
+		scan->qual_atts = NULL;
+		scan->late_atts = NULL;
+		scan->num_qual_atts = 0;
+		scan->num_late_atts = 0;
+		return;
+	}
+
+	scan->lateQuals = qualstate;
+	scan->lateEcontext = econtext;
+}
+
+/*
+ * Decide whether the columns of the quals are read first in the segment file
+ * being opened.
+ *
+ * The other columns are positioned at the rows that satisfy the quals by
+ * their row numbers, which the blocks of older formats may not have. Scans
+ * that build the block directory must read every block.
+ */
+static void
+init_late_materialization(AOCSScanDesc scan, AOCSFileSegInfo *segInfo)
+{
+	scan->lateMaterialize = (scan->lateQuals != NIL &&
+							 scan->blockDirectory == NULL &&
+							 segInfo->formatversion >= AORelationVersion_GetLatest());
+}
+
+/*
+ * Read the values of the late columns of row rowNum, which the columns of the
+ * quals have just been read at.
+ *
+ * The blocks of a column before the row are skipped without decompressing
+ * them, with the help of the block directory entries loaded for the zone
+ * maps if there are any.
+ */
+static void
+read_late_columns(AOCSScanDesc scan, int64 rowNum, Datum *d, bool *null)
+{
+	int			i;
+
+	for (i = 0; i < scan->num_late_atts; i++)
+	{
+		int			attno = scan->late_atts[i];
+		DatumStreamRead *ds = scan->ds[attno];
+		int			err;
+
+		if (!skip_column_to_row(scan, attno, rowNum))
+			elog(ERROR, "could not find row " INT64_FORMAT " in column %d of the segment file",
+				 rowNum, attno + 1);
+
+		err = datumstreamread_advance(ds);
+		if (err == 0)
+		{
+			err = datumstreamread_block(ds, NULL, attno);
+			if (err >= 0)
+				err = datumstreamread_advance(ds);
+		}
+		if (err <= 0 || ds->blockFirstRowNum + datumstreamread_nth(ds) != rowNum)
+			elog(ERROR, "could not find row " INT64_FORMAT " in column %d of the segment file",
+				 rowNum, attno + 1);
+
+		datumstreamread_get(ds, &d[attno], &null[attno]);
+	}
+}
+
+/*
+ * Whether the blocks of a zone map may have rows that satisfy the qual.
+ */
+static bool
+zonemap_qual_may_match(AOCSZoneMapQual *zq, MinipageZoneMap *zonemap)
+{
+	if (!(zonemap->flags & ZONEMAP_VALID))
+		return true;
+
+	if (zq->strategy == InvalidStrategy)
+		return (zonemap->flags & ZONEMAP_HAS_NULLS) != 0;
+
+	/* the operators are strict, NULLs never satisfy them */
+	if (!(zonemap->flags & ZONEMAP_HAS_VALUES))
+		return false;
+
+	switch (zq->strategy)
+	{
+		case BTLessStrategyNumber:
+			return zonemap->minValue < zq->value;
+		case BTLessEqualStrategyNumber:
+			return zonemap->minValue <= zq->value;
+		case BTEqualStrategyNumber:
+			return zonemap->minValue <= zq->value &&
+				zonemap->maxValue >= zq->value;
+		case BTGreaterEqualStrategyNumber:
+			return zonemap->maxValue >= zq->value;
+		case BTGreaterStrategyNumber:
+			return zonemap->maxValue > zq->value;
+		default:
+			return true;
+	}
+}
+
+static int
+compare_skip_ranges(const void *a, const void *b)
+{
+	int64		first_a = *(const int64 *) a;
+	int64		first_b = *(const int64 *) b;
+
+	if (first_a < first_b)
+		return -1;
+	if (first_a > first_b)
+		return 1;
+	return 0;
+}
+
+/*
+ * Find the rows of the segment file that the zone maps show can't satisfy
+ * the quals, for skip_to_row().
+ *
+ * Segment files of older formats are never skipped in, their blocks may not
+ * have row numbers.
+ */
+static void
+init_zonemap_skip_ranges(AOCSScanDesc scan, AOCSFileSegInfo *segInfo)
+{
+	int			nvp = scan->relationTupleDesc->natts;
+	MemoryContext oldcxt;
+	MinipageEntry **entries;
+	MinipageZoneMap **zonemaps;
+	int		   *numEntries;
+	int			maxRanges = 0;
+	int			numRanges = 0;
+	int64	   *ranges;
+	ListCell   *lc;
+	int			i;
+
+	if (segInfo->formatversion < AORelationVersion_GetLatest())
+		return;
+
+	oldcxt = MemoryContextSwitchTo(scan->zonemapContext);
+
+	entries = palloc0(sizeof(MinipageEntry *) * nvp);
+	zonemaps = palloc0(sizeof(MinipageZoneMap *) * nvp);
+	numEntries = palloc0(sizeof(int) * nvp);
+
+	foreach(lc, scan->zonemapQuals)
+	{
+		AOCSZoneMapQual *zq = (AOCSZoneMapQual *) lfirst(lc);
+
+		if (entries[zq->attno] == NULL)
+		{
+			entries[zq->attno] =
+				AppendOnlyBlockDirectory_GetSegmentEntries(scan->aos_rel,
+														   scan->appendOnlyMetaDataSnapshot,
+														   segInfo->segno,
+														   zq->attno,
+														   getAOCSVPEntry(segInfo, zq->attno)->eof,
+														   &zonemaps[zq->attno],
+														   &numEntries[zq->attno]);
+			maxRanges += numEntries[zq->attno];
+		}
+	}
+
+	/* The entries none of whose rows satisfy some qual */
+	ranges = palloc(sizeof(int64) * 2 * Max(maxRanges, 1));
+	for (i = 0; i < nvp; i++)
+	{
+		int			entryNo;
+
+		for (entryNo = 0; entryNo < numEntries[i]; entryNo++)
+		{
+			foreach(lc, scan->zonemapQuals)
+			{
+				AOCSZoneMapQual *zq = (AOCSZoneMapQual *) lfirst(lc);
+
+				if (zq->attno == i &&
+					!zonemap_qual_may_match(zq, &zonemaps[i][entryNo]))
+				{
+					ranges[2 * numRanges] = entries[i][entryNo].firstRowNum;
+					ranges[2 * numRanges + 1] = entries[i][entryNo].firstRowNum +
+						entries[i][entryNo].rowCount - 1;
+					numRanges++;
+					break;
+				}
+			}
+		}
+	}
+
+	/* Sort and merge them, the ranges of different columns overlap */
+	if (numRanges > 1)
+	{
+		int			merged = 0;
+
+		qsort(ranges, numRanges, sizeof(int64) * 2, compare_skip_ranges);
+		for (i = 1; i < numRanges; i++)
+		{
+			if (ranges[2 * i] <= ranges[2 * merged + 1] + 1)
+				ranges[2 * merged + 1] = Max(ranges[2 * merged + 1],
+											 ranges[2 * i + 1]);
+			else
+			{
+				merged++;
+				ranges[2 * merged] = ranges[2 * i];
+				ranges[2 * merged + 1] = ranges[2 * i + 1];
+			}
+		}
+		numRanges = merged + 1;
+	}
+
+	scan->skipRanges = ranges;
+	scan->numSkipRanges = numRanges;
+	scan->nextSkipRange = 0;
+
+	/* Where the projected columns continue after a range */
+	if (numRanges > 0)
+	{
+		scan->skipEntries = palloc0(sizeof(MinipageEntry *) * nvp);
+		scan->numSkipEntries = palloc0(sizeof(int) * nvp);
+		for (i = 0; i < scan->num_proj_atts; i++)
+		{
+			int			attno = scan->proj_atts[i];
+
+			if (entries[attno] != NULL)
+			{
+				scan->skipEntries[attno] = entries[attno];
+				scan->numSkipEntries[attno] = numEntries[attno];
+			}
+			else
+				scan->skipEntries[attno] =
+					AppendOnlyBlockDirectory_GetSegmentEntries(scan->aos_rel,
+															   scan->appendOnlyMetaDataSnapshot,
+															   segInfo->segno,
+															   attno,
+															   getAOCSVPEntry(segInfo, attno)->eof,
+															   &zonemaps[attno],
+															   &scan->numSkipEntries[attno]);
+		}
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+static void
+reset_zonemap_skip_ranges(AOCSScanDesc scan)
+{
+	if (scan->zonemapContext != NULL)
+		MemoryContextReset(scan->zonemapContext);
+
+	scan->skipRanges = NULL;
+	scan->numSkipRanges = 0;
+	scan->nextSkipRange = 0;
+	scan->skipEntries = NULL;
+	scan->numSkipEntries = NULL;
+}
+
+/*
+ * Position a column so that the next row read is rowNum, or the first one
+ * after it. Returns false if there are no rows left in the segment file.
+ *
+ * The block directory entries loaded for the zone maps tell where to
+ * continue reading, if there are any. Otherwise the headers of the blocks
+ * before the row are read.
+ */
+static bool
+skip_column_to_row(AOCSScanDesc scan, int attno, int64 rowNum)
+{
+	MinipageEntry *entries = NULL;
+	int			start = 0;
+	int			end = -1;
+	int64		fileOffset = -1;
+	int64		firstRowNum = -1;
+
+	if (scan->skipEntries != NULL)
+	{
+		entries = scan->skipEntries[attno];
+		end = scan->numSkipEntries[attno] - 1;
+	}
+
+	/* The last entry of the column that starts at or before the row */
+	while (start <= end)
+	{
+		int			mid = start + (end - start) / 2;
+
+		if (entries[mid].firstRowNum <= rowNum)
+		{
+			fileOffset = entries[mid].fileOffset;
+			firstRowNum = entries[mid].firstRowNum;
+			start = mid + 1;
+		}
+		else
+			end = mid - 1;
+	}
+
+	return datumstreamread_skip_to_row(scan->ds[attno], rowNum,
+									   fileOffset, firstRowNum);
+}
+
+/*
+ * Position the columns read for each row so that the next row read is
+ * rowNum, or the first one after it. Returns false if there are no rows left
+ * in the segment file.
+ *
+ * With late materialization, those are the columns of the quals, the others
+ * are positioned when a row satisfies the quals.
+ */
+static bool
+skip_to_row(AOCSScanDesc scan, int64 rowNum)
+{
+	int		   *atts = scan->proj_atts;
+	int			natts = scan->num_proj_atts;
+	int			i;
+
+	if (scan->lateMaterialize)
+	{
+		atts = scan->qual_atts;
+		natts = scan->num_qual_atts;
+	}
+
+	for (i = 0; i < natts; i++)
+	{
+		if (!skip_column_to_row(scan, atts[i], rowNum))
+			return false;
+	}
+
+	return true;
+}
+
 void
 aocs_rescan(AOCSScanDesc scan)
 {
@@ -514,6 +1363,7 @@ void
 aocs_endscan(AOCSScanDesc scan)
 {
 	int			i;
+	ListCell   *lc;
 
 	RelationDecrementReferenceCount(scan->aos_rel);
 
@@ -536,6 +1386,27 @@ aocs_endscan(AOCSScanDesc scan)
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
 
+	if (scan->zonemapContext != NULL)
+		MemoryContextDelete(scan->zonemapContext);
+	list_free_deep(scan->zonemapQuals);
+
+	if (scan->dictionaryContext != NULL)
+		MemoryContextDelete(scan->dictionaryContext);
+	foreach(lc, scan->dictionaryQuals)
+	{
+		AOCSDictionaryQual *dq = (AOCSDictionaryQual *) lfirst(lc);
+
+		pfree(dq->values);
+		if (dq->results != NULL)
+			pfree(dq->results);
+	}
+	list_free_deep(scan->dictionaryQuals);
+
+	if (scan->qual_atts != NULL)
+		pfree(scan->qual_atts);
+	if (scan->late_atts != NULL)
+		pfree(scan->late_atts);
+
 	pfree(scan);
 }
 
@@ -624,6 +1495,8 @@ aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 	int			err = 0;
 	int			i;
 	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
+	int		   *read_atts;
+	int			num_read_atts;
 
 	Assert(ScanDirectionIsForward(direction));
 
@@ -652,10 +1525,22 @@ ReadNext:
 		Assert(scan->cur_seg >= 0);
 		curseginfo = scan->seginfo[scan->cur_seg];
 
+		/* With late materialization, the columns of the quals are read first */
+		if (scan->lateMaterialize)
+		{
+			read_atts = scan->qual_atts;
+			num_read_atts = scan->num_qual_atts;
+		}
+		else
+		{
+			read_atts = scan->proj_atts;
+			num_read_atts = scan->num_proj_atts;
+		}
+
 		/* Read from cur_seg */
-		for (i = 0; i < scan->num_proj_atts; i++)
+		for (i = 0; i < num_read_atts; i++)
 		{
-			int			attno = scan->proj_atts[i];
+			int			attno = read_atts[i];
 
 			err = datumstreamread_advance(scan->ds[attno]);
 			Assert(err >= 0);
@@ -709,11 +1594,89 @@ ReadNext:
 			AOTupleIdInit(&aoTupleId, curseginfo->segno, rowNum);
 		}
 
+		/*
+		 * If the zone maps show that no row of the range the row is in
+		 * satisfies the quals, continue after the range.
+		 */
+		if (scan->nextSkipRange < scan->numSkipRanges &&
+			rowNum != INT64CONST(-1))
+		{
+			while (scan->nextSkipRange < scan->numSkipRanges &&
+				   scan->skipRanges[2 * scan->nextSkipRange + 1] < rowNum)
+				scan->nextSkipRange++;
+
+			if (scan->nextSkipRange < scan->numSkipRanges &&
+				scan->skipRanges[2 * scan->nextSkipRange] <= rowNum)
+			{
+				if (!skip_to_row(scan,
+										scan->skipRanges[2 * scan->nextSkipRange + 1] + 1))
+				{
+					close_cur_scan_seg(scan);
+					err = -1;
+				}
+				rowNum = INT64CONST(-1);
+				goto ReadNext;
+			}
+		}
+
+		/*
+		 * Skip the row if the dictionary codes of its values show it doesn't
+		 * satisfy the quals.
+		 */
+		if (scan->dictionaryQuals != NIL &&
+			!dictionary_quals_may_match(scan, d, null))
+		{
+			rowNum = INT64CONST(-1);
+			goto ReadNext;
+		}
+
 		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, &aoTupleId))
 		{
+			/*
+			 * If the rows hidden after the row go beyond the current block,
+			 * continue after them without reading the blocks in between.
+			 */
+			if (rowNum != INT64CONST(-1) && num_read_atts > 0 &&
+				scan->blockDirectory == NULL &&
+				curseginfo->formatversion >= AORelationVersion_GetLatest())
+			{
+				DatumStreamRead *ds = scan->ds[read_atts[0]];
+				int64		nextRowNum;
+
+				nextRowNum = AppendOnlyVisimap_GetNextVisibleRowNum(&scan->visibilityMap,
+																	curseginfo->segno,
+																	rowNum + 1);
+				if (nextRowNum >= ds->blockFirstRowNum + ds->blockRowCount &&
+					!skip_to_row(scan, nextRowNum))
+				{
+					close_cur_scan_seg(scan);
+					err = -1;
+				}
+			}
 			rowNum = INT64CONST(-1);
 			goto ReadNext;
 		}
+
+		/*
+		 * Check the quals on the columns read so far, and read the other
+		 * columns only if the row satisfies them.
+		 */
+		if (scan->lateMaterialize)
+		{
+			ExprContext *econtext = scan->lateEcontext;
+
+			TupSetVirtualTupleNValid(slot, ncol);
+			econtext->ecxt_scantuple = slot;
+			if (!ExecQual(scan->lateQuals, econtext, false))
+			{
+				ResetExprContext(econtext);
+				rowNum = INT64CONST(-1);
+				goto ReadNext;
+			}
+
+			read_late_columns(scan, rowNum, d, null);
+		}
+
 		scan->cdb_fake_ctid = *((ItemPointer) &aoTupleId);
 
 		TupSetVirtualTupleNValid(slot, ncol);
@@ -861,6 +1824,7 @@ aocs_insert_init(Relation rel, int segno, bool update_mode)
 						 desc->rowCount + 1,
 						 NUM_FAST_SEQUENCES);
 	desc->numSequences = NUM_FAST_SEQUENCES;
+	desc->sequenceBatch = NUM_FAST_SEQUENCES;
 
 	/* Set last_sequence value */
 	Assert(firstSequence > desc->rowCount);
@@ -983,15 +1947,29 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 			GetFastSequences(rel->rd_appendonly->segrelid,
 							 idesc->cur_segno,
 							 idesc->lastSequence + 1,
-							 NUM_FAST_SEQUENCES);
+							 idesc->sequenceBatch);
 
 		Assert(firstSequence == idesc->lastSequence + 1);
-		idesc->numSequences = NUM_FAST_SEQUENCES;
+		idesc->numSequences = idesc->sequenceBatch;
 	}
 
 	return InvalidOid;
 }
 
+/*
+ * Tell the insert how many rows it is expected to insert, so that fast
+ * sequences are requested in batches of that size.  See
+ * appendonly_insert_set_expected_rows.
+ */
+void
+aocs_insert_set_expected_rows(AOCSInsertDesc desc, double rows)
+{
+	if (rows > MAX_NUM_FAST_SEQUENCES)
+		rows = MAX_NUM_FAST_SEQUENCES;
+	if (rows > desc->sequenceBatch)
+		desc->sequenceBatch = (int64) rows;
+}
+
 void
 aocs_insert_finish(AOCSInsertDesc idesc)
 {
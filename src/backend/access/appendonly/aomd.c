@@ -210,6 +210,25 @@ TruncateAOSegmentFile(File fd, Relation rel, int32 segFileNum, int64 offset)
 	}
 }
 
+/*
+ * Can the writes to the segment files of an AO/AOCS relation use the bulk
+ * load mode of AppendOnlyStorageWrite?
+ *
+ * Like the WAL skipping of heap inserts, that requires the relfilenode to be
+ * created in the current transaction, by CREATE TABLE (AS) or TRUNCATE, so
+ * that nothing but the transaction itself sees the files before they are
+ * logged, and that they are dropped if it aborts.
+ */
+bool
+CanBulkLoadAOSegmentFiles(Relation rel)
+{
+	if (!gp_appendonly_bulk_load || !RelationNeedsWAL(rel))
+		return false;
+
+	return rel->rd_createSubid != InvalidSubTransactionId ||
+		rel->rd_newRelfilenodeSubid != InvalidSubTransactionId;
+}
+
 struct mdunlink_ao_callback_ctx {
 	char *segPath;
 	char *segpathSuffixPosition;
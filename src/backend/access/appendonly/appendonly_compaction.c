@@ -23,6 +23,8 @@
 
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/aomd.h"
 #include "access/aosegfiles.h"
 #include "access/appendonly_compaction.h"
@@ -107,6 +109,28 @@ AppendOnlyCompaction_GetHideRatio(int64 hiddenTupcount, int64 totalTupcount)
 	return hideRatio;
 }
 
+/*
+ * Charges the vacuum cost of the I/O done to compact a segment file since
+ * the last call, and sleeps if the cost limit is reached.
+ *
+ * Append-optimized tables are read and written without going through the
+ * shared buffers, so their I/O isn't charged by the buffer manager, and
+ * vacuum_cost_delay wouldn't throttle the compaction otherwise.  The pages
+ * read are charged as misses, and the pages the moved tuples are written to
+ * as dirtied ones, like VACUUM of a heap table does.
+ */
+void
+AppendOnlyCompaction_DelayPoint(double bytesRead, double bytesWritten)
+{
+	if (VacuumCostActive)
+	{
+		VacuumCostBalance += VacuumCostPageMiss * (int) ceil(bytesRead / BLCKSZ);
+		VacuumCostBalance += VacuumCostPageDirty * (int) ceil(bytesWritten / BLCKSZ);
+	}
+
+	vacuum_delay_point();
+}
+
 /*
  * Returns true iff the given segment file should be compacted.
  */
@@ -357,6 +381,8 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	AOTupleId  *aoTupleId;
 	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
+	int64		delayMovedTupleCount = 0;
+	double		bytesPerTuple = 0;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoRows(aorel));
@@ -367,6 +393,10 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	{
 		tuplePerPage = fsinfo->total_tupcount / fsinfo->varblockcount;
 	}
+	if (fsinfo->total_tupcount > 0)
+	{
+		bytesPerTuple = (double) fsinfo->eof / fsinfo->total_tupcount;
+	}
 	relname = RelationGetRelationName(aorel);
 
 	AppendOnlyVisimap_Init(&visiMap,
@@ -439,7 +469,9 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		tupleCount++;
 		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			AppendOnlyCompaction_DelayPoint(tuplePerPage * bytesPerTuple,
+											(movedTupleCount - delayMovedTupleCount) * bytesPerTuple);
+			delayMovedTupleCount = movedTupleCount;
 		}
 	}
 
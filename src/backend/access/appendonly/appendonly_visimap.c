@@ -18,10 +18,13 @@
 #include "access/appendonly_visimap_store.h"
 #include "access/appendonlytid.h"
 #include "access/hash.h"
+#include "catalog/aovisimap.h"
 #include "cdb/cdbappendonlyblockdirectory.h"
+#include "miscadmin.h"
 #include "storage/fd.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
+#include "utils/fmgroids.h"
 #include "utils/snapmgr.h"
 
 /*
@@ -78,6 +81,10 @@ static void AppendOnlyVisimap_Find(
 					   AppendOnlyVisimap *visiMap,
 					   AOTupleId *tupleId);
 
+static AppendOnlyVisimapCacheEntry *AppendOnlyVisimap_FindCacheEntry(
+								 AppendOnlyVisimap *visiMap,
+								 int64 rowNum);
+
 /*
  * Finishes the visimap operations.
  * No other function should be called with the given
@@ -140,6 +147,12 @@ AppendOnlyVisimap_Init(
 								appendOnlyMetaDataSnapshot,
 								visiMap->memoryContext);
 
+	visiMap->cacheContext = NULL;
+	visiMap->cacheSegno = -1;
+	visiMap->cacheEntries = NULL;
+	visiMap->numCacheEntries = 0;
+	visiMap->currentCacheEntry = 0;
+
 	MemoryContextSwitchTo(oldContext);
 }
 
@@ -198,6 +211,18 @@ AppendOnlyVisimap_IsVisible(
 		   "(tupleId) = %s",
 		   AOTupleIdToString(aoTupleId));
 
+	if (visiMap->cacheSegno >= 0 &&
+		visiMap->cacheSegno == AOTupleIdGet_segmentFileNum(aoTupleId))
+	{
+		AppendOnlyVisimapCacheEntry *cacheEntry;
+		int64		rowNum = AOTupleIdGet_rowNum(aoTupleId);
+
+		cacheEntry = AppendOnlyVisimap_FindCacheEntry(visiMap, rowNum);
+		return (cacheEntry == NULL ||
+				!bms_is_member((int) (rowNum - cacheEntry->firstRowNum),
+							   cacheEntry->bitmap));
+	}
+
 	if (!AppendOnlyVisimapEntry_CoversTuple(&visiMap->visimapEntry,
 											aoTupleId))
 	{
@@ -215,6 +240,251 @@ AppendOnlyVisimap_IsVisible(
 											aoTupleId);
 }
 
+/*
+ * Loads the entries with hidden rows of a segment file into the cache of the
+ * visibility map, in place of those of the segment file loaded before.
+ * Visibility checks of the tuples of the segment file then use the cached
+ * bitmaps, instead of looking up the entries in the visimap relation as the
+ * checks move from one range of rows to the next.
+ *
+ * Only for visibility maps that are just read, like those of scans, as the
+ * cache isn't updated when tuples are hidden. Nothing is cached if the
+ * bitmaps would take more than work_mem.
+ */
+void
+AppendOnlyVisimap_LoadSegmentFile(
+								  AppendOnlyVisimap *visiMap,
+								  int segno)
+{
+	ScanKeyData scanKey;
+	IndexScanDesc indexScan;
+	MemoryContext oldContext;
+	Size		cacheSize = 0;
+	int			maxEntries = 0;
+	bool		tooLarge = false;
+
+	Assert(visiMap);
+	Assert(!AppendOnlyVisimapEntry_HasChanged(&visiMap->visimapEntry));
+
+	if (visiMap->cacheContext == NULL)
+		visiMap->cacheContext = AllocSetContextCreate(
+													  visiMap->memoryContext,
+													  "VisiMapCacheContext",
+													  ALLOCSET_DEFAULT_MINSIZE,
+													  ALLOCSET_DEFAULT_INITSIZE,
+													  ALLOCSET_DEFAULT_MAXSIZE);
+	else
+		MemoryContextReset(visiMap->cacheContext);
+
+	visiMap->cacheSegno = -1;
+	visiMap->cacheEntries = NULL;
+	visiMap->numCacheEntries = 0;
+	visiMap->currentCacheEntry = 0;
+
+	ScanKeyInit(&scanKey,
+				Anum_pg_aovisimap_segno,	/* segno */
+				BTEqualStrategyNumber,
+				F_INT4EQ,
+				Int32GetDatum(segno));
+
+	/* The index returns the entries ordered by first row number */
+	indexScan = AppendOnlyVisimapStore_BeginScan(
+												 &visiMap->visimapStore,
+												 1,
+												 &scanKey);
+
+	while (AppendOnlyVisimapStore_GetNext(&visiMap->visimapStore,
+										  indexScan,
+										  ForwardScanDirection,
+										  &visiMap->visimapEntry,
+										  NULL))
+	{
+		AppendOnlyVisimapEntry *visimapEntry = &visiMap->visimapEntry;
+		AppendOnlyVisimapCacheEntry *cacheEntry;
+
+		if (bms_is_empty(visimapEntry->bitmap))
+			continue;
+
+		cacheSize += sizeof(AppendOnlyVisimapCacheEntry) +
+			offsetof(Bitmapset, words) +
+			visimapEntry->bitmap->nwords * sizeof(bitmapword);
+		if (cacheSize > (Size) work_mem * 1024L)
+		{
+			tooLarge = true;
+			break;
+		}
+
+		oldContext = MemoryContextSwitchTo(visiMap->cacheContext);
+
+		if (visiMap->numCacheEntries >= maxEntries)
+		{
+			maxEntries = Max(2 * maxEntries, 16);
+			if (visiMap->cacheEntries == NULL)
+				visiMap->cacheEntries = (AppendOnlyVisimapCacheEntry *)
+					palloc(maxEntries * sizeof(AppendOnlyVisimapCacheEntry));
+			else
+				visiMap->cacheEntries = (AppendOnlyVisimapCacheEntry *)
+					repalloc(visiMap->cacheEntries,
+							 maxEntries * sizeof(AppendOnlyVisimapCacheEntry));
+		}
+
+		cacheEntry = &visiMap->cacheEntries[visiMap->numCacheEntries++];
+		cacheEntry->firstRowNum = visimapEntry->firstRowNum;
+		cacheEntry->bitmap = bms_copy(visimapEntry->bitmap);
+
+		MemoryContextSwitchTo(oldContext);
+	}
+	AppendOnlyVisimapStore_EndScan(&visiMap->visimapStore, indexScan);
+
+	/* The current entry has to be searched again if it is needed */
+	AppendOnlyVisimapEntry_Reset(&visiMap->visimapEntry);
+
+	if (tooLarge)
+	{
+		MemoryContextReset(visiMap->cacheContext);
+		visiMap->cacheEntries = NULL;
+		visiMap->numCacheEntries = 0;
+
+		elogif(Debug_appendonly_print_visimap, LOG,
+			   "Append-only visi map: Entries of segment file %d not cached, "
+			   "they take more than work_mem", segno);
+		return;
+	}
+
+	visiMap->cacheSegno = segno;
+
+	elogif(Debug_appendonly_print_visimap, LOG,
+		   "Append-only visi map: Cached %d entries of segment file %d",
+		   visiMap->numCacheEntries, segno);
+}
+
+/*
+ * Returns the cached entry that covers the row number of the loaded segment
+ * file, or NULL if no rows of its range are hidden.
+ */
+static AppendOnlyVisimapCacheEntry *
+AppendOnlyVisimap_FindCacheEntry(
+								 AppendOnlyVisimap *visiMap,
+								 int64 rowNum)
+{
+	AppendOnlyVisimapCacheEntry *cacheEntries = visiMap->cacheEntries;
+	int64		firstRowNum;
+	int			i;
+
+	if (visiMap->numCacheEntries == 0)
+		return NULL;
+
+	firstRowNum = (rowNum / APPENDONLY_VISIMAP_MAX_RANGE) *
+		APPENDONLY_VISIMAP_MAX_RANGE;
+
+	/*
+	 * Scans move forward, from the last entry looked up to the next ones.
+	 * Search all the entries otherwise.
+	 */
+	i = visiMap->currentCacheEntry;
+	if (cacheEntries[i].firstRowNum <= firstRowNum)
+	{
+		while (i + 1 < visiMap->numCacheEntries &&
+			   cacheEntries[i + 1].firstRowNum <= firstRowNum)
+			i++;
+	}
+	else
+	{
+		int			start = 0;
+		int			end = visiMap->numCacheEntries - 1;
+
+		i = -1;
+		while (start <= end)
+		{
+			int			mid = start + (end - start) / 2;
+
+			if (cacheEntries[mid].firstRowNum <= firstRowNum)
+			{
+				i = mid;
+				start = mid + 1;
+			}
+			else
+				end = mid - 1;
+		}
+
+		if (i < 0)
+		{
+			visiMap->currentCacheEntry = 0;
+			return NULL;
+		}
+	}
+
+	visiMap->currentCacheEntry = i;
+	if (cacheEntries[i].firstRowNum != firstRowNum)
+		return NULL;
+	return &cacheEntries[i];
+}
+
+/*
+ * Returns the first row number at or after the given one of the segment file
+ * that the visibility map doesn't hide, so that scans can skip over the runs
+ * of hidden rows. The row number may be beyond the last row of the segment
+ * file.
+ *
+ * Returns the given row number if the segment file hasn't been loaded by
+ * AppendOnlyVisimap_LoadSegmentFile().
+ */
+int64
+AppendOnlyVisimap_GetNextVisibleRowNum(
+									   AppendOnlyVisimap *visiMap,
+									   int segno,
+									   int64 rowNum)
+{
+	Assert(visiMap);
+	Assert(rowNum >= 0);
+
+	if (visiMap->cacheSegno < 0 || visiMap->cacheSegno != segno)
+		return rowNum;
+
+	for (;;)
+	{
+		AppendOnlyVisimapCacheEntry *cacheEntry;
+		Bitmapset  *bitmap;
+		int			offset;
+		int			wordnum;
+
+		cacheEntry = AppendOnlyVisimap_FindCacheEntry(visiMap, rowNum);
+		if (cacheEntry == NULL)
+			return rowNum;
+
+		bitmap = cacheEntry->bitmap;
+		offset = (int) (rowNum - cacheEntry->firstRowNum);
+		wordnum = offset / BITS_PER_BITMAPWORD;
+
+		while (wordnum < bitmap->nwords)
+		{
+			/* The visible rows at or after the offset */
+			bitmapword	w = ~bitmap->words[wordnum] &
+				(~((bitmapword) 0) << (offset % BITS_PER_BITMAPWORD));
+
+			if (w != 0)
+			{
+				offset = wordnum * BITS_PER_BITMAPWORD;
+				while ((w & 1) == 0)
+				{
+					w >>= 1;
+					offset++;
+				}
+				return cacheEntry->firstRowNum + offset;
+			}
+
+			wordnum++;
+			offset = wordnum * BITS_PER_BITMAPWORD;
+		}
+
+		/* The rows after the bitmap are visible */
+		if (offset < APPENDONLY_VISIMAP_MAX_RANGE)
+			return cacheEntry->firstRowNum + offset;
+
+		rowNum = cacheEntry->firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE;
+	}
+}
+
 /*
  * Stores the current visibility map entry information
  * in the relation either as update or delete.
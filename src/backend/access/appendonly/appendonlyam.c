@@ -138,6 +138,8 @@ static void AppendOnlyExecutorReadBlock_Finish(
 static void AppendOnlyExecutorReadBlock_ResetCounts(
 										AppendOnlyExecutorReadBlock *executorReadBlock);
 
+static void cacheCurrentBlock(AppendOnlyFetchDesc aoFetchDesc);
+
 /* ----------------
  *		initscan - scan code common to appendonly_beginscan and appendonly_rescan
  * ----------------
@@ -216,6 +218,8 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 			sa.comptype = scan->storageAttributes.compressType;
 			sa.complevel = scan->storageAttributes.compressLevel;
 			sa.blocksize = scan->usableBlockSize;
+			sa.relid = RelationGetRelid(reln);
+			sa.attnum = 0;
 
 			/*
 			 * The relation's tuple descriptor allows the compression
@@ -333,6 +337,13 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 												 &scan->executorReadBlock,
 												  /* blockFirstRowNum */ 1);
 
+	/*
+	 * Load the visibility map entries of the segment file at once, so that
+	 * getNextBlock() can skip the blocks whose rows are all hidden.
+	 */
+	if (scan->snapshot != SnapshotAny)
+		AppendOnlyVisimap_LoadSegmentFile(&scan->visibilityMap, segno);
+
 	/* ready to go! */
 	scan->aos_need_new_segfile = false;
 
@@ -1253,19 +1264,43 @@ getNextBlock(AppendOnlyScanDesc scan)
 			return false;
 	}
 
-	if (!AppendOnlyExecutorReadBlock_GetBlockInfo(
-												  &scan->storageRead,
-												  &scan->executorReadBlock))
+	for (;;)
 	{
-		if (scan->blockDirectory)
+		AppendOnlyExecutorReadBlock *executorReadBlock = &scan->executorReadBlock;
+
+		if (!AppendOnlyExecutorReadBlock_GetBlockInfo(
+													  &scan->storageRead,
+													  executorReadBlock))
 		{
-			AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
+			if (scan->blockDirectory)
+			{
+				AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
+			}
+
+			/* done reading the file */
+			CloseScannedFileSeg(scan);
+
+			return false;
 		}
 
-		/* done reading the file */
-		CloseScannedFileSeg(scan);
+		/*
+		 * Skip the block without reading its contents if the visibility map
+		 * hides all its rows, unless the block directory is being built.
+		 */
+		if (scan->blockDirectory == NULL &&
+			!executorReadBlock->isLarge &&
+			executorReadBlock->rowCount > 0 &&
+			AppendOnlyVisimap_GetNextVisibleRowNum(&scan->visibilityMap,
+												   executorReadBlock->segmentFileNum,
+												   executorReadBlock->blockFirstRowNum) >=
+			executorReadBlock->blockFirstRowNum + executorReadBlock->rowCount)
+		{
+			AppendOnlyExecutionReadBlock_FinishedScanBlock(executorReadBlock);
+			AppendOnlyStorageRead_SkipCurrentBlock(&scan->storageRead);
+			continue;
+		}
 
-		return false;
+		break;
 	}
 
 	if (scan->blockDirectory)
@@ -1938,6 +1973,8 @@ fetchFromCurrentBlock(AppendOnlyFetchDesc aoFetchDesc,
 		AppendOnlyExecutorReadBlock_GetContents(&aoFetchDesc->executorReadBlock);
 
 		aoFetchDesc->currentBlock.gotContents = true;
+
+		cacheCurrentBlock(aoFetchDesc);
 	}
 
 	return AppendOnlyExecutorReadBlock_FetchTuple(&aoFetchDesc->executorReadBlock,
@@ -1947,6 +1984,127 @@ fetchFromCurrentBlock(AppendOnlyFetchDesc aoFetchDesc,
 												  slot);
 }
 
+/*
+ * The cached block that has the row, if any.
+ */
+static AppendOnlyFetchCachedBlock *
+findCachedBlock(AppendOnlyFetchDesc aoFetchDesc,
+				int segmentFileNum,
+				int64 rowNum)
+{
+	int			i;
+
+	for (i = 0; i < APPENDONLY_FETCH_CACHED_BLOCKS; i++)
+	{
+		AppendOnlyFetchCachedBlock *block = &aoFetchDesc->cachedBlocks[i];
+
+		if (block->valid &&
+			block->segmentFileNum == segmentFileNum &&
+			rowNum >= block->firstRowNum &&
+			rowNum <= block->lastRowNum)
+		{
+			block->lastUsed = ++aoFetchDesc->cachedBlockClock;
+			return block;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Keep the contents of the current block, in place of the least recently
+ * used cached block.
+ *
+ * The blocks of large rows are not kept, they can be as large as a row.
+ */
+static void
+cacheCurrentBlock(AppendOnlyFetchDesc aoFetchDesc)
+{
+	AppendOnlyExecutorReadBlock *executorReadBlock =
+	&aoFetchDesc->executorReadBlock;
+	AppendOnlyFetchCachedBlock *block = &aoFetchDesc->cachedBlocks[0];
+	int			i;
+
+	if (executorReadBlock->isLarge)
+		return;
+
+	for (i = 1; i < APPENDONLY_FETCH_CACHED_BLOCKS && block->valid; i++)
+	{
+		if (!aoFetchDesc->cachedBlocks[i].valid ||
+			aoFetchDesc->cachedBlocks[i].lastUsed < block->lastUsed)
+			block = &aoFetchDesc->cachedBlocks[i];
+	}
+
+	if (block->dataBufferLen < executorReadBlock->dataLen)
+	{
+		if (block->data != NULL)
+			pfree(block->data);
+		block->data = NULL;
+		block->dataBufferLen = Max(executorReadBlock->dataLen,
+								   aoFetchDesc->usableBlockSize);
+		block->data = MemoryContextAlloc(aoFetchDesc->initContext,
+										 block->dataBufferLen);
+	}
+
+	memcpy(block->data, executorReadBlock->dataBuffer,
+		   executorReadBlock->dataLen);
+	block->dataLen = executorReadBlock->dataLen;
+
+	block->segmentFileNum = aoFetchDesc->currentSegmentFile.num;
+	block->formatVersion = aoFetchDesc->storageRead.formatVersion;
+	block->firstRowNum = aoFetchDesc->currentBlock.firstRowNum;
+	block->lastRowNum = aoFetchDesc->currentBlock.lastRowNum;
+	block->executorBlockKind = executorReadBlock->executorBlockKind;
+	if (block->executorBlockKind == AoExecutorBlockKind_VarBlock)
+		VarBlockReaderInit(&block->varBlockReader, block->data, block->dataLen);
+
+	block->lastUsed = ++aoFetchDesc->cachedBlockClock;
+	block->valid = true;
+}
+
+static bool
+fetchFromCachedBlock(AppendOnlyFetchDesc aoFetchDesc,
+					 AppendOnlyFetchCachedBlock *block,
+					 int64 rowNum,
+					 TupleTableSlot *slot)
+{
+	ItemPointerData fake_ctid;
+	AOTupleId  *aoTupleId = (AOTupleId *) &fake_ctid;
+	MemTuple	tuple;
+	bool		shouldFree = false;
+
+	if (slot == NULL)
+		return true;
+
+	if (block->executorBlockKind == AoExecutorBlockKind_VarBlock)
+	{
+		int			itemLen;
+
+		tuple = (MemTuple) VarBlockReaderGetItemPtr(&block->varBlockReader,
+													(int) (rowNum - block->firstRowNum),
+													&itemLen);
+		Assert(tuple != NULL);
+	}
+	else
+	{
+		Assert(block->executorBlockKind == AoExecutorBlockKind_SingleRow);
+		Assert(rowNum == block->firstRowNum);
+		tuple = (MemTuple) block->data;
+	}
+
+	/* If the tuple is not in the latest format, convert it */
+	if (block->formatVersion < AORelationVersion_GetLatest())
+		tuple = upgrade_tuple(&aoFetchDesc->executorReadBlock, tuple,
+							  slot->tts_mt_bind, block->formatVersion,
+							  &shouldFree);
+	ExecStoreMinimalTuple(tuple, slot, shouldFree);
+
+	AOTupleIdInit(aoTupleId, block->segmentFileNum, rowNum);
+	slot_set_ctid(slot, &fake_ctid);
+
+	return true;
+}
+
 static void
 positionFirstBlockOfRange(AppendOnlyFetchDesc aoFetchDesc)
 {
@@ -2171,6 +2329,8 @@ appendonly_fetch_init(Relation relation,
 		sa.comptype = NameStr(relation->rd_appendonly->compresstype);
 		sa.complevel = relation->rd_appendonly->compresslevel;
 		sa.blocksize = relation->rd_appendonly->blocksize;
+		sa.relid = RelationGetRelid(relation);
+		sa.attnum = 0;
 
 
 		cs = callCompressionConstructor(cons, RelationGetDescr(relation),
@@ -2221,6 +2381,25 @@ appendonly_fetch(AppendOnlyFetchDesc aoFetchDesc,
 	int			segmentFileNum = AOTupleIdGet_segmentFileNum(aoTupleId);
 	int64		rowNum = AOTupleIdGet_rowNum(aoTupleId);
 	bool		isSnapshotAny = (aoFetchDesc->snapshot == SnapshotAny);
+	AppendOnlyFetchCachedBlock *cachedBlock;
+
+	/*
+	 * Is the tuple in one of the blocks read last?  Then it needs neither
+	 * the block directory nor reading the block again.
+	 */
+	cachedBlock = findCachedBlock(aoFetchDesc, segmentFileNum, rowNum);
+	if (cachedBlock != NULL)
+	{
+		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&aoFetchDesc->visibilityMap, aoTupleId))
+		{
+			if (slot != NULL)
+			{
+				ExecClearTuple(slot);
+			}
+			return false;		/* row has been deleted or updated. */
+		}
+		return fetchFromCachedBlock(aoFetchDesc, cachedBlock, rowNum, slot);
+	}
 
 	/*
 	 * Do we have a current block?  If it has the requested tuple, that would
@@ -2398,6 +2577,8 @@ appendonly_fetch(AppendOnlyFetchDesc aoFetchDesc,
 void
 appendonly_fetch_finish(AppendOnlyFetchDesc aoFetchDesc)
 {
+	int			i;
+
 	RelationDecrementReferenceCount(aoFetchDesc->relation);
 
 	AppendOnlyStorageRead_CloseFile(&aoFetchDesc->storageRead);
@@ -2417,6 +2598,16 @@ appendonly_fetch_finish(AppendOnlyFetchDesc aoFetchDesc)
 
 	AppendOnlyVisimap_Finish(&aoFetchDesc->visibilityMap, AccessShareLock);
 
+	for (i = 0; i < APPENDONLY_FETCH_CACHED_BLOCKS; i++)
+	{
+		if (aoFetchDesc->cachedBlocks[i].data != NULL)
+		{
+			pfree(aoFetchDesc->cachedBlocks[i].data);
+			aoFetchDesc->cachedBlocks[i].data = NULL;
+		}
+		aoFetchDesc->cachedBlocks[i].valid = false;
+	}
+
 	pfree(aoFetchDesc->segmentFileName);
 	aoFetchDesc->segmentFileName = NULL;
 
@@ -2671,6 +2862,8 @@ appendonly_insert_init(Relation rel, int segno, bool update_mode)
 		sa.comptype = NameStr(rel->rd_appendonly->compresstype);
 		sa.complevel = rel->rd_appendonly->compresslevel;
 		sa.blocksize = rel->rd_appendonly->blocksize;
+		sa.relid = RelationGetRelid(rel);
+		sa.attnum = 0;
 
 		cs = callCompressionConstructor(cons, RelationGetDescr(rel),
 										&sa,
@@ -2712,6 +2905,9 @@ appendonly_insert_init(Relation rel, int segno, bool update_mode)
 								&aoInsertDesc->storageAttributes,
                                 RelationNeedsWAL(aoInsertDesc->aoi_rel));
 
+	if (CanBulkLoadAOSegmentFiles(aoInsertDesc->aoi_rel))
+		AppendOnlyStorageWrite_SetBulkLoad(&aoInsertDesc->storageWrite);
+
 	aoInsertDesc->storageWrite.compression_functions = fns;
 	aoInsertDesc->storageWrite.compressionState = cs;
 	aoInsertDesc->storageWrite.verifyWriteCompressionState = verifyCs;
@@ -2769,6 +2965,7 @@ appendonly_insert_init(Relation rel, int segno, bool update_mode)
 						 aoInsertDesc->rowCount + 1,
 						 NUM_FAST_SEQUENCES);
 	aoInsertDesc->numSequences = NUM_FAST_SEQUENCES;
+	aoInsertDesc->sequenceBatch = NUM_FAST_SEQUENCES;
 
 	/* Set last_sequence value */
 	Assert(firstSequence > aoInsertDesc->rowCount);
@@ -3040,10 +3237,10 @@ appendonly_insert(AppendOnlyInsertDesc aoInsertDesc,
 			GetFastSequences(aoInsertDesc->aoi_rel->rd_appendonly->segrelid,
 							 aoInsertDesc->cur_segno,
 							 aoInsertDesc->lastSequence + 1,
-							 NUM_FAST_SEQUENCES);
+							 aoInsertDesc->sequenceBatch);
 
 		Assert(firstSequence == aoInsertDesc->lastSequence + 1);
-		aoInsertDesc->numSequences = NUM_FAST_SEQUENCES;
+		aoInsertDesc->numSequences = aoInsertDesc->sequenceBatch;
 	}
 
 	elogif(Debug_appendonly_print_insert_tuple, LOG,
@@ -3061,6 +3258,24 @@ appendonly_insert(AppendOnlyInsertDesc aoInsertDesc,
 	return tupleOid;
 }
 
+/*
+ * appendonly_insert_set_expected_rows
+ *
+ * Tell the insert how many rows it is expected to insert, e.g. the planner's
+ * estimate for a CREATE TABLE AS.  Fast sequences are then requested in
+ * batches sized to that, instead of updating gp_fastsequence every
+ * NUM_FAST_SEQUENCES rows.
+ */
+void
+appendonly_insert_set_expected_rows(AppendOnlyInsertDesc aoInsertDesc,
+									double rows)
+{
+	if (rows > MAX_NUM_FAST_SEQUENCES)
+		rows = MAX_NUM_FAST_SEQUENCES;
+	if (rows > aoInsertDesc->sequenceBatch)
+		aoInsertDesc->sequenceBatch = (int64) rows;
+}
+
 /*
  * appendonly_insert_finish
  *
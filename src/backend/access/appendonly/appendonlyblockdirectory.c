@@ -19,6 +19,7 @@
 #include "access/heapam.h"
 #include "access/genam.h"
 #include "catalog/indexing.h"
+#include "catalog/pg_type.h"
 #include "parser/parse_oper.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -28,6 +29,7 @@
 
 int			gp_blockdirectory_entry_min_range = 0;
 int			gp_blockdirectory_minipage_size = NUM_MINIPAGE_ENTRIES;
+bool		gp_appendonly_zone_maps = false;
 
 static inline uint32
 minipage_size(uint32 nEntry)
@@ -36,6 +38,12 @@ minipage_size(uint32 nEntry)
 		sizeof(MinipageEntry) * nEntry;
 }
 
+static inline uint32
+minipage_zonemap_size(uint32 nEntry)
+{
+	return minipage_size(nEntry) + sizeof(MinipageZoneMap) * nEntry;
+}
+
 static void load_last_minipage(
 				   AppendOnlyBlockDirectory *blockDirectory,
 				   int64 lastSequence,
@@ -61,7 +69,11 @@ static bool insert_new_entry(AppendOnlyBlockDirectory *blockDirectory,
 				 int64 firstRowNum,
 				 int64 fileOffset,
 				 int64 rowCount,
+				 MinipageZoneMap *zonemap,
 				 bool addColAction);
+static void parse_minipage(struct varlena *value,
+			   Minipage *minipage,
+			   MinipageZoneMap *zonemaps);
 
 void
 AppendOnlyBlockDirectoryEntry_GetBeginRange(
@@ -151,6 +163,8 @@ init_internal(AppendOnlyBlockDirectory *blockDirectory)
 
 		minipageInfo->minipage =
 			palloc0(minipage_size(NUM_MINIPAGE_ENTRIES));
+		minipageInfo->zonemaps =
+			palloc0(sizeof(MinipageZoneMap) * NUM_MINIPAGE_ENTRIES);
 		minipageInfo->numMinipageEntries = 0;
 	}
 
@@ -673,7 +687,59 @@ AppendOnlyBlockDirectory_InsertEntry(
 									 bool addColAction)
 {
 	return insert_new_entry(blockDirectory, columnGroupNo, firstRowNum,
-							fileOffset, rowCount, addColAction);
+							fileOffset, rowCount, NULL, addColAction);
+}
+
+/*
+ * AppendOnlyBlockDirectory_InsertEntryWithZoneMap
+ *
+ * Same as AppendOnlyBlockDirectory_InsertEntry, but also record the zone map
+ * of the values in the blocks of the entry. If the entry is merged into the
+ * latest existing one, the zone map of that entry is widened to include it.
+ */
+bool
+AppendOnlyBlockDirectory_InsertEntryWithZoneMap(
+												AppendOnlyBlockDirectory *blockDirectory,
+												int columnGroupNo,
+												int64 firstRowNum,
+												int64 fileOffset,
+												int64 rowCount,
+												MinipageZoneMap *zonemap,
+												bool addColAction)
+{
+	return insert_new_entry(blockDirectory, columnGroupNo, firstRowNum,
+							fileOffset, rowCount, zonemap, addColAction);
+}
+
+/*
+ * Widen the zone map to include the values of another one.
+ */
+static void
+merge_zonemap(MinipageZoneMap *zonemap, MinipageZoneMap *other)
+{
+	if (!(zonemap->flags & ZONEMAP_VALID))
+		return;
+
+	if (other == NULL || !(other->flags & ZONEMAP_VALID))
+	{
+		zonemap->flags = 0;
+		return;
+	}
+
+	if (other->flags & ZONEMAP_HAS_VALUES)
+	{
+		if (!(zonemap->flags & ZONEMAP_HAS_VALUES))
+		{
+			zonemap->minValue = other->minValue;
+			zonemap->maxValue = other->maxValue;
+		}
+		else
+		{
+			zonemap->minValue = Min(zonemap->minValue, other->minValue);
+			zonemap->maxValue = Max(zonemap->maxValue, other->maxValue);
+		}
+	}
+	zonemap->flags |= other->flags;
 }
 
 /*
@@ -688,6 +754,7 @@ insert_new_entry(
 				 int64 firstRowNum,
 				 int64 fileOffset,
 				 int64 rowCount,
+				 MinipageZoneMap *zonemap,
 				 bool addColAction)
 {
 	MinipageEntry *entry = NULL;
@@ -733,7 +800,11 @@ insert_new_entry(
 
 		if (gp_blockdirectory_entry_min_range > 0 &&
 			fileOffset - entry->fileOffset < gp_blockdirectory_entry_min_range)
+		{
+			/* The rows of the new blocks now belong to the latest entry */
+			merge_zonemap(&minipageInfo->zonemaps[lastEntryNo], zonemap);
 			return true;
+		}
 
 		/* Update the rowCount in the latest entry */
 		Assert(entry->rowCount <= firstRowNum - entry->firstRowNum);
@@ -764,6 +835,8 @@ insert_new_entry(
 		 */
 		MemSet(minipageInfo->minipage->entry, 0,
 			   minipageInfo->numMinipageEntries * sizeof(MinipageEntry));
+		MemSet(minipageInfo->zonemaps, 0,
+			   minipageInfo->numMinipageEntries * sizeof(MinipageZoneMap));
 		minipageInfo->numMinipageEntries = 0;
 	}
 
@@ -774,6 +847,12 @@ insert_new_entry(
 	entry->fileOffset = fileOffset;
 	entry->rowCount = rowCount;
 
+	if (zonemap != NULL)
+		minipageInfo->zonemaps[minipageInfo->numMinipageEntries] = *zonemap;
+	else
+		MemSet(&minipageInfo->zonemaps[minipageInfo->numMinipageEntries], 0,
+			   sizeof(MinipageZoneMap));
+
 	minipageInfo->numMinipageEntries++;
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -832,6 +911,182 @@ AppendOnlyBlockDirectory_DeleteSegmentFile(Relation aoRel,
 
 }
 
+/*
+ * AppendOnlyBlockDirectory_GetSegmentEntries
+ *
+ * Return the entries of a column group of a segment file from all of its
+ * minipages, in row number order, and their zone maps in *zonemaps. Entries
+ * not before eof are out-of-date and left out. Returns NULL if the relation
+ * has no block directory.
+ */
+MinipageEntry *
+AppendOnlyBlockDirectory_GetSegmentEntries(Relation aoRel,
+										   Snapshot appendOnlyMetaDataSnapshot,
+										   int segno,
+										   int columnGroupNo,
+										   int64 eof,
+										   MinipageZoneMap **zonemaps,
+										   int *numEntries)
+{
+	Relation	blkdirRel;
+	Relation	blkdirIdx;
+	TupleDesc	heapTupleDesc;
+	ScanKeyData scanKeys[2];
+	IndexScanDesc indexScan;
+	HeapTuple	tuple;
+	Minipage   *minipage;
+	MinipageZoneMap *minipageZonemaps;
+	MinipageEntry *entries;
+	int			maxEntries = NUM_MINIPAGE_ENTRIES;
+
+	*numEntries = 0;
+	*zonemaps = NULL;
+
+	if (!OidIsValid(aoRel->rd_appendonly->blkdirrelid))
+		return NULL;
+
+	blkdirRel = heap_open(aoRel->rd_appendonly->blkdirrelid, AccessShareLock);
+	blkdirIdx = index_open(aoRel->rd_appendonly->blkdiridxid, AccessShareLock);
+	heapTupleDesc = RelationGetDescr(blkdirRel);
+
+	minipage = palloc(minipage_size(NUM_MINIPAGE_ENTRIES));
+	minipageZonemaps = palloc(sizeof(MinipageZoneMap) * NUM_MINIPAGE_ENTRIES);
+	entries = palloc(sizeof(MinipageEntry) * maxEntries);
+	*zonemaps = palloc(sizeof(MinipageZoneMap) * maxEntries);
+
+	ScanKeyInit(&scanKeys[0],
+				Anum_pg_aoblkdir_segno,
+				BTEqualStrategyNumber,
+				F_INT4EQ,
+				Int32GetDatum(segno));
+	ScanKeyInit(&scanKeys[1],
+				Anum_pg_aoblkdir_columngroupno,
+				BTEqualStrategyNumber,
+				F_INT4EQ,
+				Int32GetDatum(columnGroupNo));
+
+	indexScan = index_beginscan(blkdirRel, blkdirIdx,
+								appendOnlyMetaDataSnapshot, 2, 0);
+	index_rescan(indexScan, scanKeys, 2, NULL, 0);
+
+	while ((tuple = index_getnext(indexScan, ForwardScanDirection)) != NULL)
+	{
+		Datum		value;
+		bool		isnull;
+		struct varlena *detoast_value;
+		uint32		i;
+
+		value = heap_getattr(tuple, Anum_pg_aoblkdir_minipage,
+							 heapTupleDesc, &isnull);
+		Assert(!isnull);
+		detoast_value = pg_detoast_datum((struct varlena *) DatumGetPointer(value));
+		parse_minipage(detoast_value, minipage, minipageZonemaps);
+		if (detoast_value != (struct varlena *) DatumGetPointer(value))
+			pfree(detoast_value);
+
+		for (i = 0; i < minipage->nEntry; i++)
+		{
+			if (minipage->entry[i].fileOffset >= eof)
+				break;
+
+			if (*numEntries >= maxEntries)
+			{
+				maxEntries *= 2;
+				entries = repalloc(entries, sizeof(MinipageEntry) * maxEntries);
+				*zonemaps = repalloc(*zonemaps,
+									 sizeof(MinipageZoneMap) * maxEntries);
+			}
+			entries[*numEntries] = minipage->entry[i];
+			(*zonemaps)[*numEntries] = minipageZonemaps[i];
+			(*numEntries)++;
+		}
+	}
+
+	index_endscan(indexScan);
+	index_close(blkdirIdx, AccessShareLock);
+	heap_close(blkdirRel, AccessShareLock);
+
+	pfree(minipage);
+	pfree(minipageZonemaps);
+
+	return entries;
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneMapType
+ *
+ * Whether zone maps are kept for the values of the type.
+ */
+bool
+AppendOnlyBlockDirectory_ZoneMapType(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+#ifdef HAVE_INT64_TIMESTAMP
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+#endif
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneMapValue
+ *
+ * The value of a datum of a zone map type in the zone maps. The values of
+ * the integer types compare with each other the same way as their datums.
+ */
+int64
+AppendOnlyBlockDirectory_ZoneMapValue(Oid typid, Datum value)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return (int64) DatumGetInt16(value);
+		case INT4OID:
+		case DATEOID:
+			return (int64) DatumGetInt32(value);
+		case INT8OID:
+#ifdef HAVE_INT64_TIMESTAMP
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+#endif
+			return DatumGetInt64(value);
+		default:
+			elog(ERROR, "type %u has no zone maps", typid);
+			return 0;
+	}
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneMapAdd
+ *
+ * Add a value to the zone map.
+ */
+void
+AppendOnlyBlockDirectory_ZoneMapAdd(MinipageZoneMap *zonemap,
+									int64 value, bool isnull)
+{
+	if (isnull)
+		zonemap->flags |= ZONEMAP_HAS_NULLS;
+	else if (!(zonemap->flags & ZONEMAP_HAS_VALUES))
+	{
+		zonemap->minValue = value;
+		zonemap->maxValue = value;
+		zonemap->flags |= ZONEMAP_HAS_VALUES;
+	}
+	else if (value < zonemap->minValue)
+		zonemap->minValue = value;
+	else if (value > zonemap->maxValue)
+		zonemap->maxValue = value;
+}
+
 /*
  * init_scankeys
  *
@@ -916,17 +1171,48 @@ copy_out_minipage(MinipagePerColumnGroup *minipageInfo,
 	value = (struct varlena *)
 		DatumGetPointer(minipage_value);
 	detoast_value = pg_detoast_datum(value);
-	Assert(VARSIZE(detoast_value) <= minipage_size(NUM_MINIPAGE_ENTRIES));
 
-	memcpy(minipageInfo->minipage, detoast_value, VARSIZE(detoast_value));
+	parse_minipage(detoast_value, minipageInfo->minipage,
+				   minipageInfo->zonemaps);
 	if (detoast_value != value)
 		pfree(detoast_value);
 
-	Assert(minipageInfo->minipage->nEntry <= NUM_MINIPAGE_ENTRIES);
-
 	minipageInfo->numMinipageEntries = minipageInfo->minipage->nEntry;
 }
 
+/*
+ * parse_minipage
+ *
+ * Copy the entries of a stored minipage to minipage, and their zone maps to
+ * zonemaps. Both must have room for NUM_MINIPAGE_ENTRIES entries. Minipages
+ * written without zone maps get invalid ones.
+ */
+static void
+parse_minipage(struct varlena *value, Minipage *minipage,
+			   MinipageZoneMap *zonemaps)
+{
+	Minipage   *stored = (Minipage *) value;
+	uint32		nEntry = stored->nEntry;
+
+	if (nEntry > NUM_MINIPAGE_ENTRIES ||
+		(stored->version == MINIPAGE_VERSION_ORIGINAL &&
+		 VARSIZE(stored) != minipage_size(nEntry)) ||
+		(stored->version == MINIPAGE_VERSION_ZONEMAP &&
+		 VARSIZE(stored) != minipage_zonemap_size(nEntry)) ||
+		stored->version > MINIPAGE_VERSION_ZONEMAP)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid block directory minipage: version %d, %u entries, size %u",
+						stored->version, nEntry, VARSIZE(stored))));
+
+	memcpy(minipage, stored, minipage_size(nEntry));
+	if (stored->version == MINIPAGE_VERSION_ZONEMAP)
+		memcpy(zonemaps, ((char *) stored) + minipage_size(nEntry),
+			   sizeof(MinipageZoneMap) * nEntry);
+	else
+		MemSet(zonemaps, 0, sizeof(MinipageZoneMap) * nEntry);
+}
+
 
 /*
  * extract_minipage
@@ -1141,6 +1427,8 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 	bool	   *nulls = blockDirectory->nulls;
 	Relation	blkdirRel = blockDirectory->blkdirRel;
 	TupleDesc	heapTupleDesc = RelationGetDescr(blkdirRel);
+	Minipage   *zonemapMinipage = NULL;
+	uint32		i;
 
 	Assert(minipageInfo->numMinipageEntries > 0);
 
@@ -1162,11 +1450,36 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 
 	SET_VARSIZE(minipageInfo->minipage,
 				minipage_size(minipageInfo->numMinipageEntries));
+	minipageInfo->minipage->version = MINIPAGE_VERSION_ORIGINAL;
 	minipageInfo->minipage->nEntry = minipageInfo->numMinipageEntries;
 	values[Anum_pg_aoblkdir_minipage - 1] =
 		PointerGetDatum(minipageInfo->minipage);
 	nulls[Anum_pg_aoblkdir_minipage - 1] = false;
 
+	/*
+	 * The zone maps are only stored if some entry has one, so that the
+	 * minipages of tables not using them stay in the original format.
+	 */
+	for (i = 0; i < minipageInfo->numMinipageEntries; i++)
+	{
+		if (minipageInfo->zonemaps[i].flags & ZONEMAP_VALID)
+			break;
+	}
+	if (i < minipageInfo->numMinipageEntries)
+	{
+		uint32		nEntry = minipageInfo->numMinipageEntries;
+
+		zonemapMinipage = palloc(minipage_zonemap_size(nEntry));
+		memcpy(zonemapMinipage, minipageInfo->minipage, minipage_size(nEntry));
+		memcpy(((char *) zonemapMinipage) + minipage_size(nEntry),
+			   minipageInfo->zonemaps, sizeof(MinipageZoneMap) * nEntry);
+		SET_VARSIZE(zonemapMinipage, minipage_zonemap_size(nEntry));
+		zonemapMinipage->version = MINIPAGE_VERSION_ZONEMAP;
+
+		values[Anum_pg_aoblkdir_minipage - 1] =
+			PointerGetDatum(zonemapMinipage);
+	}
+
 	tuple = heaptuple_form_to(heapTupleDesc,
 							  values,
 							  nulls,
@@ -1206,6 +1519,8 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 	CatalogUpdateIndexes(blkdirRel, tuple);
 
 	heap_freetuple(tuple);
+	if (zonemapMinipage != NULL)
+		pfree(zonemapMinipage);
 
 	MemoryContextSwitchTo(oldcxt);
 }
@@ -1236,6 +1551,7 @@ AppendOnlyBlockDirectory_End_forInsert(
 		}
 
 		pfree(minipageInfo->minipage);
+		pfree(minipageInfo->zonemaps);
 	}
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -1272,6 +1588,8 @@ AppendOnlyBlockDirectory_End_forSearch(
 	{
 		if (blockDirectory->minipages[groupNo].minipage != NULL)
 			pfree(blockDirectory->minipages[groupNo].minipage);
+		if (blockDirectory->minipages[groupNo].zonemaps != NULL)
+			pfree(blockDirectory->minipages[groupNo].zonemaps);
 	}
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -1321,6 +1639,7 @@ AppendOnlyBlockDirectory_End_addCol(
 							  groupNo, minipageInfo->numMinipageEntries)));
 		}
 		pfree(minipageInfo->minipage);
+		pfree(minipageInfo->zonemaps);
 	}
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
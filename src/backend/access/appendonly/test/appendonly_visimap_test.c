@@ -65,6 +65,57 @@ test__AppendOnlyVisimapDelete_Finish_outoforder(void **state)
 	assert_int_equal(val.workFileOffset, INT64_MAX);
 }
 
+static Bitmapset *
+make_hidden_bitmap(int nwords, int first, int last)
+{
+	Bitmapset  *bitmap;
+	int			i;
+
+	bitmap = palloc0(offsetof(Bitmapset, words) + nwords * sizeof(bitmapword));
+	bitmap->nwords = nwords;
+	for (i = first; i <= last; i++)
+		bitmap->words[i / BITS_PER_BITMAPWORD] |=
+			((bitmapword) 1 << (i % BITS_PER_BITMAPWORD));
+	return bitmap;
+}
+
+/*
+ * Runs of hidden rows found in the cached entries of a segment file, within
+ * an entry and across entries.
+ */
+void
+test__AppendOnlyVisimap_GetNextVisibleRowNum(void **state)
+{
+	AppendOnlyVisimap visiMap;
+	AppendOnlyVisimapCacheEntry cacheEntries[2];
+
+	cacheEntries[0].firstRowNum = 0;
+	cacheEntries[0].bitmap = make_hidden_bitmap(4, 5, 70);
+	cacheEntries[1].firstRowNum = APPENDONLY_VISIMAP_MAX_RANGE;
+	cacheEntries[1].bitmap =
+		make_hidden_bitmap(APPENDONLY_VISIMAP_MAX_RANGE / BITS_PER_BITMAPWORD,
+						   0, APPENDONLY_VISIMAP_MAX_RANGE - 1);
+
+	visiMap.cacheSegno = 2;
+	visiMap.cacheEntries = cacheEntries;
+	visiMap.numCacheEntries = 2;
+	visiMap.currentCacheEntry = 0;
+
+	assert_true(AppendOnlyVisimap_GetNextVisibleRowNum(&visiMap, 2, 3) == 3);
+	assert_true(AppendOnlyVisimap_GetNextVisibleRowNum(&visiMap, 2, 5) == 71);
+	assert_true(AppendOnlyVisimap_GetNextVisibleRowNum(&visiMap, 2, 70) == 71);
+	assert_true(AppendOnlyVisimap_GetNextVisibleRowNum(&visiMap, 2, 100) == 100);
+	assert_true(AppendOnlyVisimap_GetNextVisibleRowNum(&visiMap, 2,
+													   APPENDONLY_VISIMAP_MAX_RANGE + 10) ==
+				2 * APPENDONLY_VISIMAP_MAX_RANGE);
+
+	/* Looking up an earlier entry again */
+	assert_true(AppendOnlyVisimap_GetNextVisibleRowNum(&visiMap, 2, 6) == 71);
+
+	/* Other segment files aren't loaded */
+	assert_true(AppendOnlyVisimap_GetNextVisibleRowNum(&visiMap, 1, 5) == 5);
+}
+
 
 int
 main(int argc, char *argv[])
@@ -72,7 +123,8 @@ main(int argc, char *argv[])
 	cmockery_parse_arguments(argc, argv);
 
 	const		UnitTest tests[] = {
-		unit_test(test__AppendOnlyVisimapDelete_Finish_outoforder)
+		unit_test(test__AppendOnlyVisimapDelete_Finish_outoforder),
+		unit_test(test__AppendOnlyVisimap_GetNextVisibleRowNum)
 	};
 
 	MemoryContextInit();
@@ -26,6 +26,10 @@
 static void _bitmap_findnextword(BMBatchWords* words, uint64 nextReadNo);
 static void _bitmap_resetWord(BMBatchWords *words, uint32 prevStartNo);
 static uint8 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos);
+static uint32 union_run_length(BMBatchWords *bch, uint32 maxRun,
+				 bool *isFill);
+static bool union_runs(BMBatchWords **batches, uint32 numBatches,
+		   uint64 *nextReadNo, BMBatchWords *result);
 
 /*
  * _bitmap_formitem() -- construct a LOV entry.
@@ -508,6 +512,17 @@ fast_forward(uint32 nbatches, BMBatchWords **batches, BMBatchWords *result)
 	Assert(result != NULL);
 	Assert(nbatches == 0 || batches != NULL);
 
+	/*
+	 * A batch may not have been read up to the next read position, if a
+	 * fill of ones of another batch ended the last union.
+	 */
+	for (i = 0; i < nbatches; i++)
+	{
+		_bitmap_findnextword(batches[i], batches[0]->nextread);
+		if (batches[i]->nwords == 0)
+			return batches[0]->nextread;
+	}
+
 	for (i = 0; i < nbatches; i++)
 	{
 		BM_HRL_WORD word = batches[i]->cwords[batches[i]->startNo];
@@ -551,6 +566,121 @@ fast_forward(uint32 nbatches, BMBatchWords **batches, BMBatchWords *result)
 	return batches[0]->nextread;
 }
 
+/*
+ * The number of words from the read position of a batch that are either all
+ * literal words, or all in the compressed zeros of the current fill word,
+ * up to maxRun. 0 for compressed ones, which end the union.
+ */
+static uint32
+union_run_length(BMBatchWords *bch, uint32 maxRun, bool *isFill)
+{
+	BM_HRL_WORD word = bch->cwords[bch->startNo];
+	uint32		n;
+
+	if (CUR_WORD_IS_FILL(bch))
+	{
+		*isFill = true;
+		if (GET_FILL_BIT(word) == 1)
+			return 0;
+		return (uint32) Min(FILL_LENGTH(word), (BM_HRL_WORD) maxRun);
+	}
+
+	*isFill = false;
+	for (n = 1; n < maxRun && n < bch->nwords; n++)
+	{
+		if (IS_FILL_WORD(bch->hwords, bch->startNo + n))
+			break;
+	}
+	return n;
+}
+
+/*
+ * union_runs() -- union the words of all batches up to the first position
+ * where the run of literal words or of compressed zeros of one of them ends.
+ *
+ * This is what _bitmap_union() does one word at a time, done for the whole
+ * run: the literal words are ORed in a loop over arrays that the compiler
+ * can vectorize, and compressed zeros common to all batches stay compressed
+ * in the result. Returns false, without reading any words, if a batch is at
+ * compressed ones or has no words left.
+ */
+static bool
+union_runs(BMBatchWords **batches, uint32 numBatches, uint64 *nextReadNo,
+		   BMBatchWords *result)
+{
+	uint32		run = result->maxNumOfWords - result->nwords;
+	bool		allFill = true;
+	bool		firstLiteral = true;
+	BM_HRL_WORD *dst = &result->cwords[result->nwords];
+	uint32		batchNo;
+	uint32		i;
+
+	for (batchNo = 0; batchNo < numBatches && run > 0; batchNo++)
+	{
+		BMBatchWords *bch = batches[batchNo];
+		bool		isFill;
+
+		_bitmap_findnextword(bch, *nextReadNo);
+		if (bch->nwords == 0)
+			return false;
+
+		run = union_run_length(bch, run, &isFill);
+		allFill = allFill && isFill;
+	}
+
+	/* a run of one word is no faster than the word at a time */
+	if (run <= 1)
+		return false;
+
+	for (batchNo = 0; batchNo < numBatches; batchNo++)
+	{
+		BMBatchWords *bch = batches[batchNo];
+
+		if (CUR_WORD_IS_FILL(bch))
+		{
+			/* the compressed zeros add nothing */
+			if (FILL_LENGTH(bch->cwords[bch->startNo]) == run)
+			{
+				bch->startNo++;
+				bch->nwords--;
+			}
+			else
+				bch->cwords[bch->startNo] -= run;
+		}
+		else
+		{
+			BM_HRL_WORD *src = &bch->cwords[bch->startNo];
+
+			if (firstLiteral)
+				memcpy(dst, src, run * sizeof(BM_HRL_WORD));
+			else
+			{
+				for (i = 0; i < run; i++)
+					dst[i] |= src[i];
+			}
+			firstLiteral = false;
+
+			bch->startNo += run;
+			bch->nwords -= run;
+		}
+		bch->nwordsread += run;
+	}
+
+	if (allFill)
+	{
+		result->hwords[result->nwords / BM_HRL_WORD_SIZE] |=
+			WORDNO_GET_HEADER_BIT(result->nwords);
+		result->cwords[result->nwords] = BM_MAKE_FILL_WORD(0, run);
+		result->nwords++;
+	}
+	else
+		result->nwords += run;
+
+	*nextReadNo += run;
+
+	return true;
+}
+
 /*
  * _bitmap_union() -- union 'numBatches' bitmaps
  *
@@ -585,6 +715,9 @@ _bitmap_union(BMBatchWords **batches, uint32 numBatches, BMBatchWords *result)
 		BM_HRL_WORD	word;
 		bool		orWordIsLiteral = true;
 
+		if (union_runs(batches, numBatches, &nextReadNo, result))
+			continue;
+
 		for (batchNo = 0; batchNo < numBatches; batchNo++)
 		{
 			BMBatchWords *bch = batches[batchNo];
@@ -760,22 +893,27 @@ _bitmap_resetWord(BMBatchWords *words, uint32 prevStartNo)
 static uint8
 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos)
 {
-	uint8 pos = lastPos + 1;
-	BM_HRL_WORD	rightmostBitWord;
+	uint8		pos = lastPos + 1;
 
 	if (pos > BM_HRL_WORD_SIZE)
 	  return 0;
 
-	rightmostBitWord = (((BM_HRL_WORD)1) << (pos-1));
+	/* the bits from pos on, skipping the zero bytes */
+	word >>= (pos - 1);
+	if (word == 0)
+		return 0;
 
-	while (pos <= BM_HRL_WORD_SIZE && (word & rightmostBitWord) == 0)
+	while ((word & 0xFF) == 0)
 	{
-		rightmostBitWord <<= 1;
-		pos++;
+		word >>= 8;
+		pos += 8;
 	}
 
-	if (pos > BM_HRL_WORD_SIZE)
-		pos = 0;
+	while ((word & 1) == 0)
+	{
+		word >>= 1;
+		pos++;
+	}
 
 	return pos;
 }
@@ -1150,6 +1150,28 @@ slot_deform_tuple(TupleTableSlot *slot, int natts)
 
 	tp = (char *) tup + tup->t_hoff;
 
+	/*
+	 * Without nulls, the leading fixed-width attributes are at the offsets
+	 * cached in the tuple descriptor by the previous tuples, so they can be
+	 * fetched without the bookkeeping of the loop below.
+	 */
+	if (attnum == 0 && !hasnulls)
+	{
+		while (attnum < natts &&
+			   att[attnum]->attcacheoff >= 0 &&
+			   att[attnum]->attlen > 0)
+		{
+			Form_pg_attribute thisatt = att[attnum];
+
+			isnull[attnum] = false;
+			values[attnum] = fetchatt(thisatt, tp + thisatt->attcacheoff);
+			attnum++;
+		}
+
+		if (attnum > 0)
+			off = att[attnum - 1]->attcacheoff + att[attnum - 1]->attlen;
+	}
+
 	for (; attnum < natts; attnum++)
 	{
 		Form_pg_attribute thisatt = att[attnum];
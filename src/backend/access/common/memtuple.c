@@ -13,6 +13,7 @@
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
 #include "access/memtup.h"
 #include "access/tupmacs.h"
 #include "access/transam.h"
@@ -941,16 +942,87 @@ MemTuple memtuple_copy_to(MemTuple mtup, MemTuple dest, uint32 *destlen)
 	return dest;
 }
 
-static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull, bool use_null_saves_aligned)
+/*
+ * Extract the first natts attributes of a memtuple.
+ *
+ * memtuple_getattr() adds up the space saved by the nulls physically
+ * preceding the attribute, byte by byte of the null bitmap, for every
+ * attribute.  Here the space saved by the nulls of the bytes before each
+ * byte is added up once for the tuple, so the locating of each attribute
+ * only looks at its own byte of the null bitmap.
+ */
+static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, int natts, Datum *datum, bool *isnull, bool use_null_saves_aligned)
 {
+	bool hasnull = memtuple_get_hasnull(mtup);
+	unsigned char *nullp = hasnull ? memtuple_get_nullp(mtup, pbind) : NULL; 
+	char *start = (char *) mtup + (hasnull ? pbind->null_bitmap_extra_size : 0);
+	MemTupleBindingCols *colbind = memtuple_get_islarge(mtup) ? &pbind->large_bind : &pbind->bind;
+	short *null_saves = (use_null_saves_aligned ? colbind->null_saves_aligned : colbind->null_saves);
+	Form_pg_attribute *attrs = pbind->tupdesc->attrs;
+	int byte_saves[(MaxTupleAttributeNumber + 7) / 8];
 	int i;
-	for(i=0; i<pbind->tupdesc->natts; ++i)
-		datum[i] = memtuple_getattr_by_alignment(mtup, pbind, i+1, &isnull[i], use_null_saves_aligned);
+
+	Assert(mtup && pbind && pbind->tupdesc);
+	Assert(natts >= 0 && natts <= pbind->tupdesc->natts);
+	Assert(null_saves);
+
+	if(hasnull)
+	{
+		int nbytes = (pbind->tupdesc->natts + 7) / 8;
+		int saved = 0;
+
+		for(i=0; i<nbytes; ++i)
+		{
+			byte_saves[i] = saved;
+			saved += compute_null_save_b(null_saves + 32 * i, nullp[i]);
+		}
+	}
+
+	for(i=0; i<natts; ++i)
+	{
+		MemTupleAttrBinding *attrbind = &colbind->bindings[i];
+		char *p = start + attrbind->offset;
+
+		if(hasnull)
+		{
+			int nbyte = attrbind->null_byte;
+
+			if(nullp[nbyte] & attrbind->null_mask)
+			{
+				datum[i] = 0;
+				isnull[i] = true;
+				continue;
+			}
+
+			p -= byte_saves[nbyte] +
+				compute_null_save_b(null_saves + 32 * nbyte, nullp[nbyte] & (attrbind->null_mask - 1));
+		}
+
+		if(attrbind->flag != MTB_ByVal_Native && attrbind->flag != MTB_ByVal_Ptr)
+		{
+			if(attrbind->len == 2)
+				p = start + *(uint16 *) p;
+			else
+			{
+				Assert(attrbind->len == 4);
+				p = start + *(uint32 *) p;
+			}
+		}
+
+		datum[i] = fetchatt(attrs[i], p);
+		isnull[i] = false;
+	}
 }
 
 void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull)
 {
-	memtuple_get_values(mtup, pbind, datum, isnull, true /* aligned */);
+	memtuple_get_values(mtup, pbind, pbind->tupdesc->natts, datum, isnull, true /* aligned */);
+}
+
+/* Like memtuple_deform(), but only the first natts attributes */
+void memtuple_getsomeattrs(MemTuple mtup, MemTupleBinding *pbind, int natts, Datum *datum, bool *isnull)
+{
+	memtuple_get_values(mtup, pbind, natts, datum, isnull, true /* aligned */);
 }
 
 
@@ -966,7 +1038,7 @@ void
 memtuple_deform_misaligned(MemTuple mtup, MemTupleBinding *pbind,
 						   Datum *datum, bool *isnull)
 {
-	memtuple_get_values(mtup, pbind, datum, isnull, false /* aligned */);
+	memtuple_get_values(mtup, pbind, pbind->tupdesc->natts, datum, isnull, false /* aligned */);
 }
 
 /*
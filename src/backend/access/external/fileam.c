@@ -158,6 +158,7 @@ external_beginscan(Relation relation, uint32 scancounter,
 	scan->fs_rd = relation;
 	scan->fs_scancounter = scancounter;
 	scan->fs_noop = false;
+	scan->fs_sample_keep = 1.0;
 	scan->fs_file = NULL;
 	/*
 	 * GPDB_91_MERGE_FIXME: scan->raw_buf_done is used for custom external
@@ -487,6 +488,8 @@ external_getnext_init(PlanState *state)
 		desc = (ExternalSelectDesc) palloc0(sizeof(ExternalSelectDescData));
 	if (state != NULL)
 		desc->projInfo = state->ps_ProjInfo;
+	desc->sample_fraction = gp_external_scan_sample_fraction;
+	desc->sample_read_fraction = 1.0;
 	return desc;
 }
 
@@ -500,6 +503,7 @@ HeapTuple
 external_getnext(FileScanDesc scan, ScanDirection direction, ExternalSelectDesc desc)
 {
 	HeapTuple	tuple;
+	bool		sample_pending = false;
 
 	if (scan->fs_noop)
 		return NULL;
@@ -517,13 +521,37 @@ external_getnext(FileScanDesc scan, ScanDirection direction, ExternalSelectDesc
 	 * only.
 	 */
 	if (!scan->fs_file)
+	{
 		open_external_readable_source(scan, desc);
+		sample_pending = true;
+	}
 
 	/* Note: no locking manipulations needed */
 	FILEDEBUG_1;
 
-	tuple = externalgettup(scan, direction);
+	for (;;)
+	{
+		tuple = externalgettup(scan, direction);
 
+		/*
+		 * A protocol reports the fraction of its data it reads on its first
+		 * call, which reads the first row.  Return rows at the rate that
+		 * makes up the rest of the sample.  desc is rebuilt for every call,
+		 * so remember the rate in the scan.
+		 */
+		if (sample_pending)
+		{
+			if (desc != NULL && desc->sample_fraction < 1.0 &&
+				desc->sample_read_fraction > desc->sample_fraction)
+				scan->fs_sample_keep = desc->sample_fraction /
+					desc->sample_read_fraction;
+			sample_pending = false;
+		}
+
+		if (tuple == NULL || scan->fs_sample_keep >= 1.0 ||
+			(double) random() / MAX_RANDOM_VALUE < scan->fs_sample_keep)
+			break;
+	}
 
 	if (tuple == NULL)
 	{
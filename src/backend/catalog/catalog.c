@@ -51,6 +51,7 @@
 #include "catalog/pg_trigger.h"
 
 #include "catalog/gp_configuration_history.h"
+#include "catalog/gp_optimizer_cost_params.h"
 #include "catalog/gp_segment_config.h"
 #include "catalog/pg_stat_last_operation.h"
 #include "catalog/pg_stat_last_shoperation.h"
@@ -370,6 +371,7 @@ IsSharedRelation(Oid relationId)
 		relationId == ResGroupCapabilityRelationId ||
 		relationId == GpConfigHistoryRelationId ||
 		relationId == GpSegmentConfigRelationId ||
+		relationId == GpOptimizerCostParamsRelationId ||
 
 		relationId == AuthTimeConstraintRelationId)
 		return true;
@@ -63,13 +63,21 @@ typedef struct zlib_state
 						uLong sourceLen,
 						int level);
 
-	int (*decompress_fn) (Bytef *dest,
-						  uLongf *destLen,
-						  const Bytef *source,
-						  uLong sourceLen);
+	/*
+	 * Decompression reuses one inflate stream for all the blocks, rather
+	 * than setting up and tearing down a new one for each like uncompress()
+	 * does.  Its memory is allocated in the context the state was created
+	 * in, so it's released on abort along with the state.
+	 */
+	bool stream_initialized;
+	z_stream stream;
+	MemoryContext mcxt;
 
 } zlib_state;
 
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size);
+static void zlib_free(voidpf opaque, voidpf address);
+
 static NameData
 comptype_to_name(char *comptype)
 {
@@ -221,6 +229,8 @@ callCompressionValidator(PGFunction func, char *comptype, int32 complevel,
 	sa.complevel = complevel;
 	sa.blocksize = blocksize;
 	sa.typid = typid;
+	sa.relid = InvalidOid;
+	sa.attnum = 0;
 	(void)DirectFunctionCall1(func, PointerGetDatum(&sa));
 }
 
@@ -247,7 +257,8 @@ zlib_constructor(PG_FUNCTION_ARGS)
 	state->level = sa->complevel;
 	state->compress = compress;
 	state->compress_fn = compress2;
-	state->decompress_fn = uncompress;
+	state->stream_initialized = false;
+	state->mcxt = CurrentMemoryContext;
 
 	PG_RETURN_POINTER(cs);
 
@@ -260,6 +271,10 @@ zlib_destructor(PG_FUNCTION_ARGS)
 
 	if (cs != NULL && cs->opaque != NULL)
  	{
+		zlib_state *state = (zlib_state *) cs->opaque;
+
+		if (state->stream_initialized)
+			inflateEnd(&state->stream);
 		pfree(cs->opaque);
 	}
 
@@ -325,16 +340,43 @@ zlib_decompress(PG_FUNCTION_ARGS)
 	int32		   *dst_used = (int32 *) PG_GETARG_POINTER(4);
 	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(5);
 	zlib_state	   *state = (zlib_state *) cs->opaque;
+	z_stream	   *stream = &state->stream;
 	int				last_error;
-	unsigned long amount_available_used = dst_sz;
 
 	Insist(src_sz > 0 && dst_sz > 0);
 
+	if (!state->stream_initialized)
+	{
+		stream->zalloc = zlib_alloc;
+		stream->zfree = zlib_free;
+		stream->opaque = (voidpf) state->mcxt;
+		stream->next_in = Z_NULL;
+		stream->avail_in = 0;
+
+		last_error = inflateInit(stream);
+		if (last_error != Z_OK)
+			elog(ERROR, "could not initialize zlib decompression");
+		state->stream_initialized = true;
+	}
+	else
+		inflateReset(stream);
+
+	stream->next_in = (Bytef *) src;
+	stream->avail_in = src_sz;
+	stream->next_out = (Bytef *) dst;
+	stream->avail_out = dst_sz;
 
-	last_error = state->decompress_fn(dst, &amount_available_used,
-									  (const Bytef *) src, src_sz);
+	/* The whole block is decompressed in one call, as in uncompress() */
+	last_error = inflate(stream, Z_FINISH);
+	if (last_error == Z_STREAM_END)
+		last_error = Z_OK;
+	else if (last_error == Z_NEED_DICT ||
+			 (last_error == Z_BUF_ERROR && stream->avail_out > 0))
+		last_error = Z_DATA_ERROR;
+	else if (last_error == Z_OK)
+		last_error = Z_BUF_ERROR;
 
-	*dst_used = amount_available_used;
+	*dst_used = dst_sz - stream->avail_out;
 
 	if (last_error != Z_OK)
 	{
@@ -379,6 +421,19 @@ zlib_validator(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+/* Allocator of the zlib decompression stream, opaque is its MemoryContext */
+static voidpf
+zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+	return MemoryContextAlloc((MemoryContext) opaque, (Size) items * size);
+}
+
+static void
+zlib_free(voidpf opaque, voidpf address)
+{
+	pfree(address);
+}
+
 Datum
 rle_type_constructor(PG_FUNCTION_ARGS)
 {
@@ -115,6 +115,7 @@ AppendOnlyStorageRead_Init(AppendOnlyStorageRead *storageRead,
 					 memoryLen,
 					 storageRead->maxBufferLen,
 					 storageRead->largeReadLen,
+					 gp_appendonly_read_ahead,
 					 relationName);
 
 	elogif(Debug_appendonly_print_scan || Debug_appendonly_print_read_block, LOG,
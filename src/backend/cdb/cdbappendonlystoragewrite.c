@@ -177,6 +177,26 @@ AppendOnlyStorageWrite_Init(AppendOnlyStorageWrite *storageWrite,
 	storageWrite->isActive = true;
 }
 
+/*
+ * Switch a storage write session to bulk load mode.
+ *
+ * Only valid for segment files whose relfilenode was created in the current
+ * transaction, so that they are dropped if it aborts, and before any file
+ * of the session is created or opened.  The writes then skip their WAL
+ * records; each segment file is fsync'd once when it is closed and, if WAL
+ * is needed for the mirrors, its new part is logged in large records.
+ */
+void
+AppendOnlyStorageWrite_SetBulkLoad(AppendOnlyStorageWrite *storageWrite)
+{
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+	Assert(storageWrite->file == -1);
+
+	storageWrite->bulkLoadNeedsWAL = storageWrite->needsWAL && XLogIsNeeded();
+	storageWrite->needsWAL = false;
+}
+
 /*
  * Finish using the AppendOnlyStorageWrite session created with ~Init.
  */
@@ -502,6 +522,18 @@ AppendOnlyStorageWrite_FlushAndCloseFile(
 						storageWrite->segmentFileName,
 						storageWrite->relationName)));
 
+	/*
+	 * In bulk load mode, the data is durable now, log what was written for
+	 * the mirror.
+	 */
+	if (storageWrite->bulkLoadNeedsWAL)
+		xlog_ao_insert_file(storageWrite->file,
+							storageWrite->relFileNode.node,
+							storageWrite->segmentFileNum,
+							storageWrite->startEof,
+							*newLogicalEof,
+							storageWrite->segmentFileName);
+
 	storageWrite->file = -1;
 	storageWrite->formatVersion = -1;
 
@@ -25,6 +25,10 @@
 #include "utils/faultinjector.h"
 #include "utils/faultinjector_lists.h"
 #include "access/xlogutils.h"
+#include "miscadmin.h"
+
+/* Size of the records that xlog_ao_insert_file() logs a segment file in */
+#define AO_INSERT_FILE_CHUNK_SIZE (1024 * 1024)
 
 /*
  * Insert an AO XLOG/AOCO record.
@@ -62,6 +66,59 @@ xlog_ao_insert(RelFileNode relFileNode, int32 segmentFileNum,
 	XLogInsert(RM_APPEND_ONLY_ID, XLOG_APPENDONLY_INSERT, rdata);
 }
 
+/*
+ * Log the bytes [startOffset, endOffset) of an AO/AOCS segment file that was
+ * written without WAL, in bulk load mode, in large AO insert records.
+ *
+ * The caller has already fsync'd the file.  Each record is replayed with one
+ * write and one fsync, so shipping the file in large chunks saves the mirror
+ * most of the fsyncs that logging every write would cost.
+ */
+void
+xlog_ao_insert_file(File file, RelFileNode relFileNode, int32 segmentFileNum,
+					int64 startOffset, int64 endOffset, char *filePathName)
+{
+	char	   *buffer;
+	int64		offset;
+
+	Assert(startOffset <= endOffset);
+
+	/* Still create an empty new segfile on the mirror, for gp_replica_check */
+	if (startOffset == endOffset)
+	{
+		if (startOffset == 0)
+			xlog_ao_insert(relFileNode, segmentFileNum, 0, NULL, 0);
+		return;
+	}
+
+	if (FileSeek(file, startOffset, SEEK_SET) != startOffset)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek to position " INT64_FORMAT " in file \"%s\": %m",
+						startOffset, filePathName)));
+
+	buffer = palloc(AO_INSERT_FILE_CHUNK_SIZE);
+
+	for (offset = startOffset; offset < endOffset;)
+	{
+		int			len = (int) Min(endOffset - offset, AO_INSERT_FILE_CHUNK_SIZE);
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (FileRead(file, buffer, len) != len)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read %d bytes from file \"%s\": %m",
+							len, filePathName)));
+
+		xlog_ao_insert(relFileNode, segmentFileNum, offset, buffer, len);
+
+		offset += len;
+	}
+
+	pfree(buffer);
+}
+
 static void
 ao_insert_replay(XLogRecord *record)
 {
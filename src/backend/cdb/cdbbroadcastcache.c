@@ -0,0 +1,912 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbbroadcastcache.c
+ *	  Cache of the tuples of small broadcast relations on the segments.
+ *
+ * Queries that join a big table with the same small tables usually broadcast
+ * the small ones, so every segment scans its part of them and sends it to all
+ * the others, for every query.  With gp_broadcast_cache_relations set, the
+ * processes of a session on the segments keep the tuples that such a
+ * broadcast Motion received, up to gp_broadcast_cache_size, and replay them
+ * when a later query of the session broadcasts the same tuples again.  The
+ * receiver then tells the senders to stop right away, as if it was squelched.
+ *
+ * Only a Motion that broadcasts a SeqScan of a table, optionally under a
+ * Result, is cached, and only when its target lists and quals have no
+ * parameters, subplans or mutable functions, so that its tuples depend only
+ * on the rows of the table.  A segment keys them by the expressions of those
+ * nodes, and by the version of the table the master dispatches with the plan.
+ *
+ * The master keeps the version of the tables written since it started in
+ * shared memory.  A transaction that locks a table in a mode that writes it
+ * becomes one of its writers, and the version of the table is bumped as it
+ * begins to write, and again as it ends.  A Motion is only cached when no
+ * transaction is writing its table, and all the ones that did are older than
+ * the oldest one the snapshot of the query sees as running; the tuples of such
+ * a query are the same for any snapshot that gets the same version.  Tables
+ * that don't fit in the hash table share a single version.
+ *
+ * The functions a query runs on the segments may write tables the master
+ * never locks.  A transaction that dispatches a query calling a volatile
+ * function that isn't built in, or with allow_segment_DML, is a writer of
+ * every table, with a version of its own that is bumped the same way and that
+ * the versions of all the tables include.  Writes made in utility mode on a
+ * segment are not seen.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbbroadcastcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/memtup.h"
+#include "access/transam.h"
+#include "access/xact.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbbroadcastcache.h"
+#include "cdb/cdbtm.h"
+#include "cdb/cdbvars.h"
+#include "lib/ilist.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/planmain.h"
+#include "optimizer/walkers.h"
+#include "parser/parsetree.h"
+#include "rewrite/rewriteManip.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/snapshot.h"
+
+/* Room for the tuples of a new entry, doubled as it fills */
+#define BROADCAST_CACHE_INITIAL_TUPLES 64
+
+typedef struct BroadcastCacheRelKey
+{
+	Oid			dbid;
+	Oid			relid;
+} BroadcastCacheRelKey;
+
+/* Writes of a table on the master */
+typedef struct BroadcastCacheRel
+{
+	BroadcastCacheRelKey key;	/* hash key, must be first */
+	uint64		version;		/* bumped as a write begins and ends */
+	int			writers;		/* transactions writing it */
+	DistributedTransactionId maxWriterGxid;	/* newest that has written it */
+} BroadcastCacheRel;
+
+typedef struct BroadcastCacheSharedData
+{
+	uint64		lastVersion;	/* last version given to a table */
+	int			nrels;			/* entries of the hash table */
+
+	/* The tables that didn't fit in the hash table */
+	uint64		overflowVersion;
+	int			overflowWriters;
+	DistributedTransactionId overflowMaxWriterGxid;
+
+	/* Writes the functions on the segments may make, to any table */
+	uint64		segmentVersion;
+	int			segmentWriters;
+	DistributedTransactionId segmentMaxWriterGxid;
+} BroadcastCacheSharedData;
+
+/* Tuples a receiving Motion has cached on a segment */
+typedef struct BroadcastCacheEntry
+{
+	dlist_node	node;			/* in broadcast_cache_lru */
+	MemoryContext context;		/* holds the entry and its tuples */
+	Oid			relid;
+	uint64		version;
+	uint64		overflowVersion;
+	char	   *fingerprint;	/* expressions the tuples are made of */
+	GenericTuple *tuples;
+	int			ntuples;
+	int			maxtuples;
+	Size		bytes;			/* memory used by the entry */
+	int			pins;			/* Motions replaying it */
+} BroadcastCacheEntry;
+
+/* On the master */
+static BroadcastCacheSharedData *BroadcastCacheShared = NULL;
+static HTAB *BroadcastCacheHash = NULL;
+
+/* Tables the current transaction writes, in TopTransactionContext */
+static List *broadcast_cache_written = NIL;
+
+/* Does the current transaction write on the segments? */
+static bool broadcast_cache_segment_writer = false;
+
+/* On the segments, the entries used most recently first */
+static MemoryContext BroadcastCacheContext = NULL;
+static dlist_head broadcast_cache_lru = DLIST_STATIC_INIT(broadcast_cache_lru);
+static Size broadcast_cache_bytes = 0;
+
+static bool broadcast_cache_callback_registered = false;
+
+static void broadcast_cache_xact_callback(XactEvent event, void *arg);
+
+static bool
+BroadcastCacheEnabled(void)
+{
+	return Gp_role == GP_ROLE_DISPATCH && gp_broadcast_cache_relations > 0;
+}
+
+static Size
+broadcast_cache_limit(void)
+{
+	return mul_size((Size) gp_broadcast_cache_size, 1024);
+}
+
+static void
+broadcast_cache_register_callback(void)
+{
+	if (!broadcast_cache_callback_registered)
+	{
+		RegisterXactCallback(broadcast_cache_xact_callback, NULL);
+		broadcast_cache_callback_registered = true;
+	}
+}
+
+/*
+ * BroadcastCacheShmemSize -- estimate size the versions of the tables will
+ * need in shared memory.
+ */
+Size
+BroadcastCacheShmemSize(void)
+{
+	if (!BroadcastCacheEnabled())
+		return 0;
+
+	return add_size(MAXALIGN(sizeof(BroadcastCacheSharedData)),
+					hash_estimate_size(gp_broadcast_cache_relations,
+									   sizeof(BroadcastCacheRel)));
+}
+
+/*
+ * BroadcastCacheShmemInit -- initialize the versions of the tables.
+ */
+void
+BroadcastCacheShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (!BroadcastCacheEnabled())
+		return;
+
+	BroadcastCacheShared = (BroadcastCacheSharedData *)
+		ShmemInitStruct("Broadcast Cache Data",
+						sizeof(BroadcastCacheSharedData),
+						&found);
+	if (!found)
+		MemSet(BroadcastCacheShared, 0, sizeof(BroadcastCacheSharedData));
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(BroadcastCacheRelKey);
+	info.entrysize = sizeof(BroadcastCacheRel);
+	info.hash = tag_hash;
+
+	BroadcastCacheHash = ShmemInitHash("Broadcast Cache Hash",
+									   gp_broadcast_cache_relations,
+									   gp_broadcast_cache_relations,
+									   &info,
+									   HASH_ELEM | HASH_FUNCTION);
+}
+
+/*
+ * BroadcastCacheNoteLock -- note that the current transaction is going to
+ * write a table it locks in the mode.
+ *
+ * Called by the lock manager on the master for the tables it locks.  The
+ * modes that don't let other transactions write the table but don't change
+ * its rows, those of VACUUM, ANALYZE and CREATE INDEX, are not writes.
+ */
+void
+BroadcastCacheNoteLock(Oid relid, LOCKMODE lockmode)
+{
+	BroadcastCacheRelKey key;
+	BroadcastCacheRel *rel;
+	DistributedTransactionId gxid;
+	MemoryContext oldcxt;
+
+	if (BroadcastCacheShared == NULL || Gp_role != GP_ROLE_DISPATCH)
+		return;
+	if (lockmode < RowExclusiveLock ||
+		lockmode == ShareUpdateExclusiveLock || lockmode == ShareLock)
+		return;
+	if (relid < FirstNormalObjectId || !IsTransactionState())
+		return;
+	if (list_member_oid(broadcast_cache_written, relid))
+		return;
+
+	broadcast_cache_register_callback();
+
+	gxid = getDistributedTransactionId();
+	if (gxid == InvalidDistributedTransactionId)
+		gxid = *shmGIDSeq;
+
+	/* remembered first, so that a write counted is always ended */
+	oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+	broadcast_cache_written = lappend_oid(broadcast_cache_written, relid);
+	MemoryContextSwitchTo(oldcxt);
+
+	key.dbid = MyDatabaseId;
+	key.relid = relid;
+
+	LWLockAcquire(BroadcastCacheLock, LW_EXCLUSIVE);
+
+	rel = (BroadcastCacheRel *) hash_search(BroadcastCacheHash, &key,
+											HASH_FIND, NULL);
+	if (rel == NULL &&
+		BroadcastCacheShared->nrels < gp_broadcast_cache_relations)
+	{
+		rel = (BroadcastCacheRel *) hash_search(BroadcastCacheHash, &key,
+												HASH_ENTER_NULL, NULL);
+		if (rel != NULL)
+		{
+			rel->writers = 0;
+			rel->maxWriterGxid = InvalidDistributedTransactionId;
+			BroadcastCacheShared->nrels++;
+		}
+	}
+
+	if (rel != NULL)
+	{
+		rel->writers++;
+		if (gxid > rel->maxWriterGxid)
+			rel->maxWriterGxid = gxid;
+		rel->version = ++BroadcastCacheShared->lastVersion;
+	}
+	else
+	{
+		BroadcastCacheShared->overflowWriters++;
+		if (gxid > BroadcastCacheShared->overflowMaxWriterGxid)
+			BroadcastCacheShared->overflowMaxWriterGxid = gxid;
+		BroadcastCacheShared->overflowVersion = ++BroadcastCacheShared->lastVersion;
+	}
+
+	LWLockRelease(BroadcastCacheLock);
+}
+
+/*
+ * Note that the current transaction runs functions on the segments that may
+ * write any table.
+ */
+static void
+broadcast_cache_note_segment_writes(void)
+{
+	DistributedTransactionId gxid;
+
+	if (broadcast_cache_segment_writer || !IsTransactionState())
+		return;
+
+	broadcast_cache_register_callback();
+
+	gxid = getDistributedTransactionId();
+	if (gxid == InvalidDistributedTransactionId)
+		gxid = *shmGIDSeq;
+
+	/* remembered first, so that a write counted is always ended */
+	broadcast_cache_segment_writer = true;
+
+	LWLockAcquire(BroadcastCacheLock, LW_EXCLUSIVE);
+
+	BroadcastCacheShared->segmentWriters++;
+	if (gxid > BroadcastCacheShared->segmentMaxWriterGxid)
+		BroadcastCacheShared->segmentMaxWriterGxid = gxid;
+	BroadcastCacheShared->segmentVersion = ++BroadcastCacheShared->lastVersion;
+
+	LWLockRelease(BroadcastCacheLock);
+}
+
+/* End the writes of the current transaction, as it commits or aborts */
+static void
+broadcast_cache_end_writes(void)
+{
+	BroadcastCacheRelKey key;
+	BroadcastCacheRel *rel;
+	ListCell   *lc;
+
+	key.dbid = MyDatabaseId;
+
+	LWLockAcquire(BroadcastCacheLock, LW_EXCLUSIVE);
+
+	if (broadcast_cache_segment_writer)
+	{
+		BroadcastCacheShared->segmentWriters--;
+		BroadcastCacheShared->segmentVersion = ++BroadcastCacheShared->lastVersion;
+	}
+
+	foreach(lc, broadcast_cache_written)
+	{
+		key.relid = lfirst_oid(lc);
+
+		/* entries are never removed, so one not found is an overflow */
+		rel = (BroadcastCacheRel *) hash_search(BroadcastCacheHash, &key,
+												HASH_FIND, NULL);
+		if (rel != NULL)
+		{
+			rel->writers--;
+			rel->version = ++BroadcastCacheShared->lastVersion;
+		}
+		else
+		{
+			BroadcastCacheShared->overflowWriters--;
+			BroadcastCacheShared->overflowVersion = ++BroadcastCacheShared->lastVersion;
+		}
+	}
+
+	LWLockRelease(BroadcastCacheLock);
+
+	broadcast_cache_written = NIL;
+	broadcast_cache_segment_writer = false;
+}
+
+/*
+ * The writes of a transaction end when it commits or aborts.  A prepared
+ * transaction is still running for the snapshots taken until it commits, so
+ * its writes can end as it's prepared.
+ */
+static void
+broadcast_cache_xact_callback(XactEvent event, void *arg)
+{
+	dlist_iter	iter;
+
+	if (event != XACT_EVENT_COMMIT && event != XACT_EVENT_ABORT &&
+		event != XACT_EVENT_PREPARE)
+		return;
+
+	if (broadcast_cache_written != NIL || broadcast_cache_segment_writer)
+		broadcast_cache_end_writes();
+
+	/* the Motions of the transaction are done with the entries */
+	dlist_foreach(iter, &broadcast_cache_lru)
+	{
+		BroadcastCacheEntry *entry = dlist_container(BroadcastCacheEntry,
+													 node, iter.cur);
+
+		entry->pins = 0;
+	}
+}
+
+/*
+ * The scan whose tuples a broadcast Motion sends, if the Motion is one the
+ * cache can serve: a SeqScan, optionally under a Result.
+ */
+static Scan *
+broadcast_cache_scan(Motion *motion, Result **result)
+{
+	Plan	   *plan;
+
+	if (motion->motionType != MOTIONTYPE_FIXED || !motion->isBroadcast ||
+		motion->sendSorted)
+		return NULL;
+
+	plan = outerPlan(motion);
+	*result = NULL;
+	if (plan != NULL && IsA(plan, Result) && innerPlan(plan) == NULL)
+	{
+		*result = (Result *) plan;
+		plan = outerPlan(plan);
+	}
+
+	if (plan == NULL || !IsA(plan, SeqScan) ||
+		outerPlan(plan) != NULL || innerPlan(plan) != NULL)
+		return NULL;
+
+	return (Scan *) plan;
+}
+
+static bool
+contain_params_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param) || IsA(node, SubLink) ||
+		IsA(node, SubPlan) || IsA(node, AlternativeSubPlan))
+		return true;
+	return expression_tree_walker(node, contain_params_walker, context);
+}
+
+/* Returns true if the expressions depend on nothing but the rows scanned */
+static bool
+broadcast_cache_stable_exprs(Node *node)
+{
+	return !contain_params_walker(node, NULL) &&
+		!contain_mutable_functions(node);
+}
+
+static bool
+broadcast_cache_stable_plan(Plan *plan)
+{
+	if (plan->initPlan != NIL ||
+		!bms_is_empty(plan->extParam) || !bms_is_empty(plan->allParam))
+		return false;
+	if (IsA(plan, Result) &&
+		!broadcast_cache_stable_exprs(((Result *) plan)->resconstantqual))
+		return false;
+	return broadcast_cache_stable_exprs((Node *) plan->targetlist) &&
+		broadcast_cache_stable_exprs((Node *) plan->qual);
+}
+
+/*
+ * The version of the table for a query with the distributed snapshot, in
+ * *version and *overflowVersion.  Returns false if the tuples of the query may
+ * differ from those of another one with the same version.
+ */
+static bool
+broadcast_cache_version(Oid relid, DistributedSnapshot *ds,
+						uint64 *version, uint64 *overflowVersion)
+{
+	BroadcastCacheRelKey key;
+	BroadcastCacheRel *rel;
+	bool		cacheable;
+
+	key.dbid = MyDatabaseId;
+	key.relid = relid;
+
+	LWLockAcquire(BroadcastCacheLock, LW_SHARED);
+
+	rel = (BroadcastCacheRel *) hash_search(BroadcastCacheHash, &key,
+											HASH_FIND, NULL);
+	if (rel != NULL)
+	{
+		cacheable = rel->writers == 0 && rel->maxWriterGxid < ds->xmin;
+		*version = rel->version;
+		*overflowVersion = 0;
+	}
+	else
+	{
+		cacheable = BroadcastCacheShared->overflowWriters == 0 &&
+			BroadcastCacheShared->overflowMaxWriterGxid < ds->xmin;
+		*version = 0;
+		*overflowVersion = BroadcastCacheShared->overflowVersion;
+	}
+
+	/*
+	 * The versions all come from lastVersion, so the newest of the two
+	 * changes whenever either is bumped.
+	 */
+	cacheable = cacheable &&
+		BroadcastCacheShared->segmentWriters == 0 &&
+		BroadcastCacheShared->segmentMaxWriterGxid < ds->xmin;
+	if (rel != NULL)
+		*version = Max(*version, BroadcastCacheShared->segmentVersion);
+	else
+		*overflowVersion = Max(*overflowVersion,
+							   BroadcastCacheShared->segmentVersion);
+
+	LWLockRelease(BroadcastCacheLock);
+
+	return cacheable;
+}
+
+static bool
+broadcast_cache_user_volatile(Oid funcid)
+{
+	return funcid >= FirstNormalObjectId &&
+		func_volatile(funcid) == PROVOLATILE_VOLATILE;
+}
+
+/* Does the plan call a function that may write tables on the segments? */
+static bool
+broadcast_cache_segment_writes_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, FuncExpr) &&
+		broadcast_cache_user_volatile(((FuncExpr *) node)->funcid))
+		return true;
+	if (IsA(node, OpExpr) || IsA(node, DistinctExpr) || IsA(node, NullIfExpr))
+	{
+		set_opfuncid((OpExpr *) node);	/* rely on struct equivalence */
+		if (broadcast_cache_user_volatile(((OpExpr *) node)->opfuncid))
+			return true;
+	}
+	if (IsA(node, Aggref) &&
+		broadcast_cache_user_volatile(((Aggref *) node)->aggfnoid))
+		return true;
+	return plan_tree_walker(node, broadcast_cache_segment_writes_walker,
+							context);
+}
+
+/*
+ * BroadcastCacheDispatchKeys -- the BroadcastCacheKeys of the broadcast
+ * Motions of the query that the segments may serve from their caches.
+ *
+ * Also notes that the transaction writes on the segments if the query may.
+ */
+List *
+BroadcastCacheDispatchKeys(QueryDesc *queryDesc)
+{
+	PlannedStmt *stmt = queryDesc->plannedstmt;
+	Snapshot	snapshot = queryDesc->snapshot;
+	List	   *motions;
+	List	   *keys = NIL;
+	ListCell   *lc;
+
+	if (BroadcastCacheShared == NULL)
+		return NIL;
+
+	if (!broadcast_cache_segment_writer)
+	{
+		plan_tree_base_prefix base;
+
+		exec_init_plan_tree_base(&base, stmt);
+		if (allow_segment_DML ||
+			broadcast_cache_segment_writes_walker((Node *) stmt->planTree, &base))
+			broadcast_cache_note_segment_writes();
+	}
+
+	if (gp_broadcast_cache_size <= 0)
+		return NIL;
+	if (snapshot == NULL || !snapshot->haveDistribSnapshot)
+		return NIL;
+
+	motions = extract_nodes_plan(stmt->planTree, T_Motion, false);
+	foreach(lc, stmt->subplans)
+	{
+		Plan	   *subplan = (Plan *) lfirst(lc);
+
+		if (subplan != NULL)
+			motions = list_concat(motions,
+								  extract_nodes_plan(subplan, T_Motion, false));
+	}
+
+	foreach(lc, motions)
+	{
+		Motion	   *motion = (Motion *) lfirst(lc);
+		Result	   *result;
+		Scan	   *scan;
+		RangeTblEntry *rte;
+		BroadcastCacheKey *key;
+		uint64		version;
+		uint64		overflowVersion;
+		char		relstorage;
+
+		scan = broadcast_cache_scan(motion, &result);
+		if (scan == NULL)
+			continue;
+
+		if (!broadcast_cache_stable_plan((Plan *) motion) ||
+			(result != NULL && !broadcast_cache_stable_plan((Plan *) result)) ||
+			!broadcast_cache_stable_plan((Plan *) scan))
+			continue;
+
+		rte = rt_fetch(scan->scanrelid, stmt->rtable);
+		if (rte->rtekind != RTE_RELATION || rte->relid < FirstNormalObjectId)
+			continue;
+
+		relstorage = get_rel_relstorage(rte->relid);
+		if (get_rel_relkind(rte->relid) != RELKIND_RELATION ||
+			(relstorage != RELSTORAGE_HEAP && relstorage != RELSTORAGE_AOROWS &&
+			 relstorage != RELSTORAGE_AOCOLS))
+			continue;
+
+		if (!broadcast_cache_version(rte->relid,
+									 &snapshot->distribSnapshotWithLocalMapping.ds,
+									 &version, &overflowVersion))
+			continue;
+
+		key = makeNode(BroadcastCacheKey);
+		key->motionID = motion->motionID;
+		key->relid = rte->relid;
+		key->version = version;
+		key->overflowVersion = overflowVersion;
+		keys = lappend(keys, key);
+	}
+
+	list_free(motions);
+
+	return keys;
+}
+
+/*
+ * The expressions the tuples of the Motion are computed with.  The Vars of
+ * the table refer to the first range table entry, wherever the query has it.
+ */
+static char *
+broadcast_cache_fingerprint(Motion *motion, Result *result, Scan *scan)
+{
+	List	   *exprs;
+	List	   *scanexprs;
+
+	exprs = list_make1(motion->plan.targetlist);
+	if (result != NULL)
+		exprs = lappend(lappend(lappend(exprs, result->plan.targetlist),
+								result->plan.qual),
+						result->resconstantqual);
+
+	scanexprs = (List *) copyObject(list_make2(scan->plan.targetlist,
+											   scan->plan.qual));
+	ChangeVarNodes((Node *) scanexprs, scan->scanrelid, 1, 0);
+	exprs = lappend(exprs, scanexprs);
+
+	return nodeToString(exprs);
+}
+
+static void
+broadcast_cache_drop(BroadcastCacheEntry *entry)
+{
+	Assert(entry->pins == 0);
+
+	dlist_delete(&entry->node);
+	broadcast_cache_bytes -= entry->bytes;
+	MemoryContextDelete(entry->context);
+}
+
+/*
+ * BroadcastCacheBeginMotion -- set up a receiving broadcast Motion to replay
+ * the tuples it has cached, or to cache the tuples it receives.  Returns NULL
+ * if the cache doesn't serve the Motion.
+ */
+BroadcastCacheState *
+BroadcastCacheBeginMotion(EState *estate, Motion *motion, TupleDesc tupdesc)
+{
+	BroadcastCacheKey *key = NULL;
+	BroadcastCacheState *state;
+	BroadcastCacheEntry *entry;
+	Result	   *result;
+	Scan	   *scan;
+	MemoryContext cxt;
+	dlist_mutable_iter iter;
+	ListCell   *lc;
+	char	   *fingerprint;
+	int			i;
+
+	foreach(lc, estate->es_broadcastCacheKeys)
+	{
+		if (((BroadcastCacheKey *) lfirst(lc))->motionID == motion->motionID)
+		{
+			key = (BroadcastCacheKey *) lfirst(lc);
+			break;
+		}
+	}
+	if (key == NULL || gp_broadcast_cache_size <= 0)
+		return NULL;
+
+	scan = broadcast_cache_scan(motion, &result);
+	if (scan == NULL)
+		return NULL;
+
+	/* the typmods of anonymous records are only valid in this query */
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		if (tupdesc->attrs[i]->atttypid == RECORDOID ||
+			tupdesc->attrs[i]->atttypid == RECORDARRAYOID)
+			return NULL;
+	}
+
+	if (BroadcastCacheContext == NULL)
+	{
+		BroadcastCacheContext = AllocSetContextCreate(TopMemoryContext,
+													  "BroadcastCache",
+													  ALLOCSET_DEFAULT_MINSIZE,
+													  ALLOCSET_DEFAULT_INITSIZE,
+													  ALLOCSET_DEFAULT_MAXSIZE);
+		broadcast_cache_register_callback();
+	}
+
+	fingerprint = broadcast_cache_fingerprint(motion, result, scan);
+	state = (BroadcastCacheState *) palloc0(sizeof(BroadcastCacheState));
+
+	dlist_foreach_modify(iter, &broadcast_cache_lru)
+	{
+		entry = dlist_container(BroadcastCacheEntry, node, iter.cur);
+
+		if (entry->relid != key->relid ||
+			strcmp(entry->fingerprint, fingerprint) != 0)
+			continue;
+
+		if (entry->version == key->version &&
+			entry->overflowVersion == key->overflowVersion)
+		{
+			entry->pins++;
+			dlist_move_head(&broadcast_cache_lru, &entry->node);
+			state->entry = entry;
+			state->hit = true;
+			pfree(fingerprint);
+			return state;
+		}
+
+		/* the table has been written since */
+		if (entry->pins == 0)
+			broadcast_cache_drop(entry);
+	}
+
+	/*
+	 * Fill a new entry.  It belongs to the query until the end of the stream,
+	 * so that it goes away with the query if it fails.
+	 */
+	cxt = AllocSetContextCreate(estate->es_query_cxt,
+								"BroadcastCacheEntry",
+								ALLOCSET_DEFAULT_MINSIZE,
+								ALLOCSET_DEFAULT_INITSIZE,
+								ALLOCSET_DEFAULT_MAXSIZE);
+	entry = (BroadcastCacheEntry *) MemoryContextAllocZero(cxt, sizeof(BroadcastCacheEntry));
+	entry->context = cxt;
+	entry->relid = key->relid;
+	entry->version = key->version;
+	entry->overflowVersion = key->overflowVersion;
+	entry->fingerprint = MemoryContextStrdup(cxt, fingerprint);
+	entry->maxtuples = BROADCAST_CACHE_INITIAL_TUPLES;
+	entry->tuples = (GenericTuple *)
+		MemoryContextAlloc(cxt, entry->maxtuples * sizeof(GenericTuple));
+	entry->bytes = sizeof(BroadcastCacheEntry) + strlen(fingerprint) + 1 +
+		entry->maxtuples * sizeof(GenericTuple);
+	pfree(fingerprint);
+
+	if (entry->bytes > broadcast_cache_limit())
+	{
+		MemoryContextDelete(cxt);
+		pfree(state);
+		return NULL;
+	}
+
+	state->entry = entry;
+	return state;
+}
+
+/*
+ * BroadcastCacheNext -- the next tuple of the entry to replay, NULL at its
+ * end.  The tuple belongs to the cache.
+ */
+GenericTuple
+BroadcastCacheNext(BroadcastCacheState *state)
+{
+	Assert(state->hit);
+
+	if (state->next >= state->entry->ntuples)
+		return NULL;
+
+	return state->entry->tuples[state->next++];
+}
+
+/*
+ * BroadcastCacheAddTuple -- cache a tuple the Motion has received.  An entry
+ * that grows bigger than the cache is given up.
+ */
+void
+BroadcastCacheAddTuple(BroadcastCacheState *state, GenericTuple tuple)
+{
+	BroadcastCacheEntry *entry = state->entry;
+	MemoryContext oldcxt;
+	uint32		size;
+
+	if (state->hit || entry == NULL)
+		return;
+
+	if (is_memtuple(tuple))
+		size = memtuple_get_size((MemTuple) tuple);
+	else
+		size = heaptuple_get_size((HeapTuple) tuple);
+
+	entry->bytes += size;
+	if (entry->ntuples == entry->maxtuples)
+		entry->bytes += entry->maxtuples * sizeof(GenericTuple);
+
+	if (entry->bytes > broadcast_cache_limit())
+	{
+		MemoryContextDelete(entry->context);
+		state->entry = NULL;
+		return;
+	}
+
+	oldcxt = MemoryContextSwitchTo(entry->context);
+
+	if (entry->ntuples == entry->maxtuples)
+	{
+		entry->maxtuples *= 2;
+		entry->tuples = (GenericTuple *)
+			repalloc(entry->tuples, entry->maxtuples * sizeof(GenericTuple));
+	}
+
+	if (is_memtuple(tuple))
+	{
+		MemTuple	copy = (MemTuple) palloc(size);
+
+		memcpy(copy, tuple, size);
+		entry->tuples[entry->ntuples++] = (GenericTuple) copy;
+	}
+	else
+		entry->tuples[entry->ntuples++] =
+			(GenericTuple) heap_copytuple((HeapTuple) tuple);
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * BroadcastCacheEndOfStream -- the Motion has received all its tuples, add
+ * them to the cache, dropping the entries used least recently to make room.
+ */
+void
+BroadcastCacheEndOfStream(BroadcastCacheState *state)
+{
+	BroadcastCacheEntry *entry = state->entry;
+	dlist_iter	iter;
+
+	if (state->hit || entry == NULL)
+		return;
+
+	state->entry = NULL;
+
+	/* another Motion of the query may have cached the same tuples */
+	dlist_foreach(iter, &broadcast_cache_lru)
+	{
+		BroadcastCacheEntry *other = dlist_container(BroadcastCacheEntry,
+													 node, iter.cur);
+
+		if (other->relid == entry->relid &&
+			other->version == entry->version &&
+			other->overflowVersion == entry->overflowVersion &&
+			strcmp(other->fingerprint, entry->fingerprint) == 0)
+		{
+			MemoryContextDelete(entry->context);
+			return;
+		}
+	}
+
+	while (broadcast_cache_bytes + entry->bytes > broadcast_cache_limit())
+	{
+		BroadcastCacheEntry *victim = NULL;
+
+		dlist_reverse_foreach(iter, &broadcast_cache_lru)
+		{
+			BroadcastCacheEntry *other = dlist_container(BroadcastCacheEntry,
+														 node, iter.cur);
+
+			if (other->pins == 0)
+			{
+				victim = other;
+				break;
+			}
+		}
+
+		/* the rest is being replayed */
+		if (victim == NULL)
+		{
+			MemoryContextDelete(entry->context);
+			return;
+		}
+
+		broadcast_cache_drop(victim);
+	}
+
+	MemoryContextSetParent(entry->context, BroadcastCacheContext);
+	dlist_push_head(&broadcast_cache_lru, &entry->node);
+	broadcast_cache_bytes += entry->bytes;
+}
+
+/*
+ * BroadcastCacheEndMotion -- release the entry the Motion replayed, or
+ * discard the one it didn't finish.
+ */
+void
+BroadcastCacheEndMotion(BroadcastCacheState *state)
+{
+	if (state->entry == NULL)
+		return;
+
+	if (state->hit)
+	{
+		if (state->entry->pins > 0)
+			state->entry->pins--;
+	}
+	else
+		MemoryContextDelete(state->entry->context);
+
+	state->entry = NULL;
+}
@@ -22,6 +22,8 @@
 
 static void BufferedReadIo(
 			   BufferedRead *bufferedRead);
+static void BufferedReadPrefetch(
+					 BufferedRead *bufferedRead);
 static uint8 *BufferedReadUseBeforeBuffer(
 							BufferedRead *bufferedRead,
 							int32 maxReadAheadLen,
@@ -58,12 +60,14 @@ BufferedReadInit(
 				 int32 memoryLen,
 				 int32 maxBufferLen,
 				 int32 maxLargeReadLen,
+				 int32 readAheadCount,
 				 char *relationName)
 {
 	Assert(bufferedRead != NULL);
 	Assert(memory != NULL);
 	Assert(maxBufferLen > 0);
 	Assert(maxLargeReadLen >= maxBufferLen);
+	Assert(readAheadCount >= 0);
 	Assert(memoryLen >= BufferedReadMemoryLen(maxBufferLen, maxLargeReadLen));
 
 	memset(bufferedRead, 0, sizeof(BufferedRead));
@@ -106,6 +110,12 @@ BufferedReadInit(
 	 */
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
+
+	/*
+	 * Read-ahead support.
+	 */
+	bufferedRead->readAheadCount = readAheadCount;
+	bufferedRead->prefetchPosition = 0;
 }
 
 /*
@@ -139,6 +149,8 @@ BufferedReadSetFile(
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
 
+	bufferedRead->prefetchPosition = 0;
+
 	if (fileLen > 0)
 	{
 		/*
@@ -190,6 +202,9 @@ BufferedReadIo(
 	}
 #endif
 
+	if (bufferedRead->readAheadCount > 0)
+		BufferedReadPrefetch(bufferedRead);
+
 	offset = 0;
 	while (largeReadLen > 0)
 	{
@@ -241,6 +256,57 @@ BufferedReadIo(
 		VacuumCostBalance += VacuumCostPageMiss;
 }
 
+/*
+ * Ask the kernel to read the large reads following the current one, so
+ * that they are in the OS cache by the time they are done.
+ *
+ * Each call only asks for the part of the read-ahead window not asked for
+ * yet, so a sequential scan asks for one large read at a time once the
+ * window is filled.  The window doesn't go past the temporary limit, if
+ * there is one.
+ */
+static void
+BufferedReadPrefetch(
+					 BufferedRead *bufferedRead)
+{
+	int64		inEffectFileLen;
+	int64		nextPosition;
+	int64		windowEnd;
+
+	if (bufferedRead->haveTemporaryLimitInEffect)
+		inEffectFileLen = bufferedRead->temporaryLimitFileLen;
+	else
+		inEffectFileLen = bufferedRead->fileLen;
+
+	nextPosition = bufferedRead->largeReadPosition + bufferedRead->largeReadLen;
+	windowEnd = nextPosition +
+		(int64) bufferedRead->readAheadCount * bufferedRead->maxLargeReadLen;
+	if (windowEnd > inEffectFileLen)
+		windowEnd = inEffectFileLen;
+
+	/* Start over after a seek out of the window */
+	if (bufferedRead->prefetchPosition < nextPosition ||
+		bufferedRead->prefetchPosition > windowEnd)
+		bufferedRead->prefetchPosition = nextPosition;
+
+	if (windowEnd <= bufferedRead->prefetchPosition)
+		return;
+
+	(void) FilePrefetch(bufferedRead->file,
+						bufferedRead->prefetchPosition,
+						(int) (windowEnd - bufferedRead->prefetchPosition));
+
+	elogif(Debug_appendonly_print_read_block, LOG,
+		   "Append-Only storage read-ahead: table \"%s\", segment file \"%s\", "
+		   "prefetch position " INT64_FORMAT ", prefetch length " INT64_FORMAT,
+		   bufferedRead->relationName,
+		   bufferedRead->filePathName,
+		   bufferedRead->prefetchPosition,
+		   windowEnd - bufferedRead->prefetchPosition);
+
+	bufferedRead->prefetchPosition = windowEnd;
+}
+
 static uint8 *
 BufferedReadUseBeforeBuffer(
 							BufferedRead *bufferedRead,
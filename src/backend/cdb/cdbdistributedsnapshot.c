@@ -24,32 +24,82 @@
 #include "storage/procarray.h"
 
 /*
- * DistributedSnapshotWithLocalMapping_CommittedTest
- *		Is the given XID still-in-progress according to the
- *      distributed snapshot?  Or, is the transaction strictly local
- *      and needs to be tested with the local snapshot?
- *
- * The caller should've checked that the XID is committed (in clog),
- * otherwise the result of this function is undefined.
+ * Find a local xid in the sorted cache of the local xids of in-progress
+ * distributed transactions.  Returns true if found, and the position it is
+ * at, or would be inserted at, in *pos.
  */
-DistributedSnapshotCommitted
-DistributedSnapshotWithLocalMapping_CommittedTest(
-												  DistributedSnapshotWithLocalMapping *dslm,
-												  TransactionId localXid,
-												  bool isVacuumCheck)
+static bool
+LocalXidCacheSearch(DistributedSnapshotWithLocalMapping *dslm,
+					TransactionId localXid, int32 *pos)
 {
-	DistributedSnapshot *ds = &dslm->ds;
-	uint32		i;
-	DistributedTransactionId distribXid = InvalidDistributedTransactionId;
+	int32		low = 0;
+	int32		high = dslm->currentLocalXidsCount;
 
-	Assert(!IS_QUERY_DISPATCHER());
+	while (low < high)
+	{
+		int32		mid = low + (high - low) / 2;
+		TransactionId xid = dslm->inProgressMappedLocalXids[mid];
+
+		Assert(TransactionIdIsValid(xid));
+
+		if (TransactionIdEquals(localXid, xid))
+		{
+			*pos = mid;
+			return true;
+		}
+		if (TransactionIdPrecedes(localXid, xid))
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	*pos = low;
+	return false;
+}
+
+/*
+ * Is the distributed xid in the in-progress array of the distributed
+ * snapshot?
+ */
+static bool
+DistributedSnapshotInProgress(DistributedSnapshot *ds,
+							  DistributedTransactionId distribXid)
+{
+	int32		low = 0;
+	int32		high = ds->count;
 
 	/*
-	 * Return early if local xid is not normal as it cannot have distributed
-	 * xid associated with it.
+	 * ds->inProgressXidArray is sorted in ascending order based on
+	 * distribXid while creating the snapshot in CreateDistributedSnapshot().
 	 */
-	if (!TransactionIdIsNormal(localXid))
-		return DISTRIBUTEDSNAPSHOT_COMMITTED_IGNORE;
+	while (low < high)
+	{
+		int32		mid = low + (high - low) / 2;
+
+		if (distribXid == ds->inProgressXidArray[mid])
+			return true;
+		if (distribXid < ds->inProgressXidArray[mid])
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	return false;
+}
+
+/*
+ * The work of DistributedSnapshotWithLocalMapping_CommittedTest, for a normal
+ * local xid.
+ */
+static DistributedSnapshotCommitted
+DistributedSnapshotWithLocalMapping_CommittedTestInternal(
+														  DistributedSnapshotWithLocalMapping *dslm,
+														  TransactionId localXid,
+														  bool isVacuumCheck)
+{
+	DistributedSnapshot *ds = &dslm->ds;
+	int32		pos;
+	DistributedTransactionId distribXid = InvalidDistributedTransactionId;
 
 	/*
 	 * Checking the distributed committed log can be expensive, so make a scan
@@ -70,14 +120,10 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		if (TransactionIdFollows(localXid, dslm->minCachedLocalXid) &&
 			TransactionIdPrecedes(localXid, dslm->maxCachedLocalXid))
 		{
-			for (i = 0; i < dslm->currentLocalXidsCount; i++)
-			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-				Assert(TransactionIdIsValid(dslm->inProgressMappedLocalXids[i]));
+			Assert(dslm->inProgressMappedLocalXids != NULL);
 
-				if (TransactionIdEquals(localXid, dslm->inProgressMappedLocalXids[i]))
-					return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
-			}
+			if (LocalXidCacheSearch(dslm, localXid, &pos))
+				return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 		}
 	}
 
@@ -188,45 +234,40 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
-	for (i = 0; i < ds->count; i++)
+	if (DistributedSnapshotInProgress(ds, distribXid))
 	{
-		if (distribXid == ds->inProgressXidArray[i])
+		/*
+		 * Save the relationship to the local xid so we may avoid checking
+		 * the distributed committed log in a subsequent check. We can only
+		 * record local xids till cache size permits.  Keep the cache sorted.
+		 */
+		if (dslm->currentLocalXidsCount < ds->count)
 		{
-			/*
-			 * Save the relationship to the local xid so we may avoid checking
-			 * the distributed committed log in a subsequent check. We can
-			 * only record local xids till cache size permits.
-			 */
-			if (dslm->currentLocalXidsCount < ds->count)
+			Assert(dslm->inProgressMappedLocalXids != NULL);
+
+			if (!LocalXidCacheSearch(dslm, localXid, &pos))
 			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-				dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount++] =
-					localXid;
-
-				if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
-					TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
-				{
-					dslm->minCachedLocalXid = localXid;
-				}
-
-				if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
-					TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
-				{
-					dslm->maxCachedLocalXid = localXid;
-				}
+				memmove(&dslm->inProgressMappedLocalXids[pos + 1],
+						&dslm->inProgressMappedLocalXids[pos],
+						(dslm->currentLocalXidsCount - pos) * sizeof(TransactionId));
+				dslm->inProgressMappedLocalXids[pos] = localXid;
+				dslm->currentLocalXidsCount++;
 			}
 
-			return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
+			if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
+				TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
+			{
+				dslm->minCachedLocalXid = localXid;
+			}
+
+			if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
+				TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
+			{
+				dslm->maxCachedLocalXid = localXid;
+			}
 		}
 
-		/*
-		 * Leverage the fact that ds->inProgressXidArray is sorted in
-		 * ascending order based on distribXid while creating the snapshot in
-		 * CreateDistributedSnapshot(). So, can fail fast once known are
-		 * lower than rest of them.
-		 */
-		if (distribXid < ds->inProgressXidArray[i])
-			break;
+		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
 	/*
@@ -235,6 +276,54 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 	return DISTRIBUTEDSNAPSHOT_COMMITTED_VISIBLE;
 }
 
+/*
+ * DistributedSnapshotWithLocalMapping_CommittedTest
+ *		Is the given XID still-in-progress according to the
+ *      distributed snapshot?  Or, is the transaction strictly local
+ *      and needs to be tested with the local snapshot?
+ *
+ * The caller should've checked that the XID is committed (in clog),
+ * otherwise the result of this function is undefined.
+ */
+DistributedSnapshotCommitted
+DistributedSnapshotWithLocalMapping_CommittedTest(
+												  DistributedSnapshotWithLocalMapping *dslm,
+												  TransactionId localXid,
+												  bool isVacuumCheck)
+{
+	DistributedSnapshotCommitted result;
+
+	Assert(!IS_QUERY_DISPATCHER());
+
+	/*
+	 * Return early if local xid is not normal as it cannot have distributed
+	 * xid associated with it.
+	 */
+	if (!TransactionIdIsNormal(localXid))
+		return DISTRIBUTEDSNAPSHOT_COMMITTED_IGNORE;
+
+	/* Same xid as the last one found visible or to be ignored? */
+	if (!isVacuumCheck &&
+		TransactionIdEquals(localXid, dslm->lastCommittedLocalXid))
+		return (DistributedSnapshotCommitted) dslm->lastCommittedResult;
+
+	result = DistributedSnapshotWithLocalMapping_CommittedTestInternal(dslm,
+																	   localXid,
+																	   isVacuumCheck);
+
+	/*
+	 * The in-progress ones are remembered in the in-progress cache of the
+	 * snapshot already.  The answers to vacuum differ, don't keep them.
+	 */
+	if (!isVacuumCheck && result != DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS)
+	{
+		dslm->lastCommittedLocalXid = localXid;
+		dslm->lastCommittedResult = (int32) result;
+	}
+
+	return result;
+}
+
 /*
  * Reset all fields except maxCount and the malloc'd pointer for
  * inProgressXidArray.
@@ -51,6 +51,93 @@ bool gp_use_legacy_hashops = false;
 /* local function declarations */
 static int	ispowof2(int numsegs);
 static inline int32 jump_consistent_hash(uint64 key, int32 num_segments);
+static CdbHashFastFunc cdb_fast_hash_function(Oid funcid);
+
+/*================================================================
+ *
+ * BUILT-IN HASH FUNCTIONS
+ *
+ * Every row sent by a Redistribute Motion, or checked by the hash filter of
+ * a Result, hashes its distribution keys.  The hash functions of the most
+ * common distribution key types are cheap compared to setting up a function
+ * call through fmgr, so those are called directly.  They must return the
+ * same values as hashint2(), hashint4() and so on, which decide where the
+ * rows of the tables are stored.
+ *
+ *================================================================
+ */
+
+static uint32
+cdb_fast_hashint2(Datum datum)
+{
+	return DatumGetUInt32(hash_uint32((int32) DatumGetInt16(datum)));
+}
+
+/* also used by the date opclass */
+static uint32
+cdb_fast_hashint4(Datum datum)
+{
+	return DatumGetUInt32(hash_uint32(DatumGetInt32(datum)));
+}
+
+static uint32
+cdb_fast_hashint8(Datum datum)
+{
+	/* see hashint8() */
+	int64		val = DatumGetInt64(datum);
+	uint32		lohalf = (uint32) val;
+	uint32		hihalf = (uint32) (val >> 32);
+
+	lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+
+	return DatumGetUInt32(hash_uint32(lohalf));
+}
+
+static uint32
+cdb_fast_hashoid(Datum datum)
+{
+	return DatumGetUInt32(hash_uint32((uint32) DatumGetObjectId(datum)));
+}
+
+static uint32
+cdb_fast_hashtext(Datum datum)
+{
+	text	   *key = DatumGetTextPP(datum);
+	uint32		result;
+
+	result = DatumGetUInt32(hash_any((unsigned char *) VARDATA_ANY(key),
+									 VARSIZE_ANY_EXHDR(key)));
+
+	/* Avoid leaking memory for toasted inputs */
+	if ((Pointer) key != DatumGetPointer(datum))
+		pfree(key);
+
+	return result;
+}
+
+/*
+ * The direct call of the hash function, or NULL if it has to be called
+ * through fmgr.
+ */
+static CdbHashFastFunc
+cdb_fast_hash_function(Oid funcid)
+{
+	switch (funcid)
+	{
+		case F_HASHINT2:
+			return cdb_fast_hashint2;
+		case F_HASHINT4:
+			return cdb_fast_hashint4;
+		case F_HASHINT8:
+			return cdb_fast_hashint8;
+		case F_HASHOID:
+			return cdb_fast_hashoid;
+		case F_HASHTEXT:
+			return cdb_fast_hashtext;
+		default:
+			return NULL;
+	}
+}
 
 /*================================================================
  *
@@ -97,6 +184,7 @@ makeCdbHash(int numsegs, int natts, Oid *hashfuncs)
 
 	/* Load hash function info */
 	h->hashfuncs = (FmgrInfo *) palloc(natts * sizeof(FmgrInfo));
+	h->fasthashfuncs = (CdbHashFastFunc *) palloc(natts * sizeof(CdbHashFastFunc));
 	for (i = 0; i < natts; i++)
 	{
 		Oid			funcid = hashfuncs[i];
@@ -105,6 +193,7 @@ makeCdbHash(int numsegs, int natts, Oid *hashfuncs)
 			is_legacy_hash = true;
 
 		fmgr_info(funcid, &h->hashfuncs[i]);
+		h->fasthashfuncs[i] = cdb_fast_hash_function(funcid);
 	}
 	h->natts = natts;
 	h->is_legacy_hash = is_legacy_hash;
@@ -183,7 +272,9 @@ cdbhash(CdbHash *h, int attno, Datum datum, bool isnull)
 		/* rotate hashkey left 1 bit at each step */
 		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
 
-		if (!isnull)
+		if (!isnull && h->fasthashfuncs[attno - 1] != NULL)
+			hashkey ^= h->fasthashfuncs[attno - 1] (datum);
+		else if (!isnull)
 		{
 			FunctionCallInfoData fcinfo;
 			uint32		hkey;
@@ -4312,27 +4312,40 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 			rs->lefuncs_inverse[keyno].fn_oid = InvalidOid;
 		}
 
-		/*
-		 * Unrolling the rules into an array currently works for the top level
-		 * partition only
-		 */
-		if (partnode->part->parlevel == 0)
-		{
-			int			i = 0;
-			ListCell   *lc;
-
-			rs->rules = palloc(sizeof(PartitionRule *) * list_length(rules));
-
-			foreach(lc, rules)
-				rs->rules[i++] = (PartitionRule *) lfirst(lc);
-		}
-		else
-			rs->rules = NULL;
+		rs->rules = NULL;
+		rs->rules_node = NULL;
+		rs->nrules = 0;
+		rs->rules_size = 0;
 	}
 
 	if (accessMethods && accessMethods->part_cxt)
 		oldcxt = MemoryContextSwitchTo(accessMethods->part_cxt);
 
+	/*
+	 * Unroll the rules into an array for the binary search. Below the top
+	 * level, the state is shared by all the partitions of the level, so the
+	 * array is refilled whenever the rules of another partition are searched.
+	 */
+	if (rs->rules_node != partnode || rs->nrules != list_length(rules))
+	{
+		int			i = 0;
+		ListCell   *lc;
+
+		if (rs->rules_size < list_length(rules))
+		{
+			if (rs->rules)
+				pfree(rs->rules);
+			rs->rules_size = list_length(rules);
+			rs->rules = palloc(sizeof(PartitionRule *) * rs->rules_size);
+		}
+
+		foreach(lc, rules)
+			rs->rules[i++] = (PartitionRule *) lfirst(lc);
+
+		rs->rules_node = partnode;
+		rs->nrules = i;
+	}
+
 	*foundOid = InvalidOid;
 
 	/*
@@ -4362,10 +4375,7 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 
 		mid = low + (high - low) / 2;
 
-		if (rs->rules)
-			rule = rs->rules[mid];
-		else
-			rule = (PartitionRule *) list_nth(rules, mid);
+		rule = rs->rules[mid];
 
 		if (isnull[attno - 1])
 		{
@@ -4438,7 +4448,7 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 				int			ret;
 
 				if (j != mid)
-					rule = (PartitionRule *) list_nth(rules, j);
+					rule = rs->rules[j];
 
 				if (isnull[attno - 1])
 				{
@@ -4498,7 +4508,7 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 				Datum		d = values[attno - 1];
 				int			ret;
 
-				rule = (PartitionRule *) list_nth(rules, j);
+				rule = rs->rules[j];
 
 				if (isnull[attno - 1])
 				{
@@ -592,6 +592,8 @@ plan_tree_mutator(Node *node,
 				COPYARRAY(newsort, sort, numCols, sortColIdx);
 				COPYARRAY(newsort, sort, numCols, sortOperators);
 				COPYARRAY(newsort, sort, numCols, nullsFirst);
+				MUTATE(newsort->limitOffset, sort->limitOffset, Node *);
+				MUTATE(newsort->limitCount, sort->limitCount, Node *);
 				return (Node *) newsort;
 			}
 			break;
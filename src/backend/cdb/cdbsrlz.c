@@ -15,7 +15,9 @@
 
 #include "postgres.h"
 
+#include "access/hash.h"
 #include "cdb/cdbsrlz.h"
+#include "cdb/cdbvars.h"
 #include "nodes/nodes.h"
 #include "utils/memaccounting.h"
 #include "utils/memutils.h"
@@ -28,11 +30,40 @@
 static char *compress_string(const char *src, int uncompressed_size, int *compressed_size_p);
 static char *uncompress_string(const char *src, int size, int *uncompressed_size_p);
 
-/* zstandard compression level to use. */
+/*
+ * zstandard compression levels to use.  Small trees are compressed at the
+ * fastest level, for the compression is most of their dispatch time.  The
+ * larger ones are sent to many QEs, and worth compressing better.
+ */
+#define COMPRESS_LEVEL_FAST 1
 #define COMPRESS_LEVEL 3
+#define COMPRESS_FAST_LIMIT (64 * 1024)
 
 #endif			/* HAVE_LIBZSTD */
 
+/*
+ * The QEs of a session keep the last few trees they received deserialized,
+ * by the bytes they were received as.  When the QD executes a prepared
+ * statement again, it dispatches the same plan bytes, with the parameters
+ * sent apart, so the QEs copy the tree they have instead of decompressing
+ * and reading it again.  gp_enable_qe_plan_cache turns this off.
+ */
+#define NODE_CACHE_ENTRIES 8
+#define NODE_CACHE_MAX_SIZE (64 * 1024)	/* of the bytes received */
+
+typedef struct NodeCacheEntry
+{
+	MemoryContext mcxt;			/* holds bytes and node, NULL if unused */
+	uint32		hash;			/* hash of the bytes */
+	int			size;
+	char	   *bytes;
+	Node	   *node;
+	uint64		lastused;		/* node_cache_clock when last found */
+} NodeCacheEntry;
+
+static NodeCacheEntry node_cache[NODE_CACHE_ENTRIES];
+static uint64 node_cache_clock = 0;
+
 /*
  * This is used by dispatcher to serialize Plan and Query Trees for
  * dispatching to qExecs.
@@ -101,6 +132,69 @@ deserializeNode(const char *strNode, int size)
 	return node;
 }
 
+/*
+ * Like deserializeNode, but for a tree that is likely to be received again,
+ * like a plan.  The returned node is a copy, palloc'ed in the current memory
+ * context, that the caller may scribble on.
+ */
+Node *
+deserializeNodeCached(const char *strNode, int size)
+{
+	NodeCacheEntry *entry;
+	NodeCacheEntry *victim = NULL;
+	MemoryContext mcxt;
+	MemoryContext oldcxt;
+	Node	   *node;
+	uint32		hash;
+	int			i;
+
+	Assert(strNode != NULL);
+
+	if (!gp_enable_qe_plan_cache || size > NODE_CACHE_MAX_SIZE)
+		return deserializeNode(strNode, size);
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) strNode, size));
+
+	for (i = 0; i < NODE_CACHE_ENTRIES; i++)
+	{
+		entry = &node_cache[i];
+
+		if (entry->mcxt != NULL && entry->hash == hash &&
+			entry->size == size && memcmp(entry->bytes, strNode, size) == 0)
+		{
+			entry->lastused = ++node_cache_clock;
+			return copyObject(entry->node);
+		}
+
+		if (victim == NULL || entry->mcxt == NULL ||
+			(victim->mcxt != NULL && entry->lastused < victim->lastused))
+			victim = entry;
+	}
+
+	node = deserializeNode(strNode, size);
+
+	entry = victim;
+	if (entry->mcxt != NULL)
+		MemoryContextDelete(entry->mcxt);
+	entry->mcxt = NULL;
+
+	mcxt = AllocSetContextCreate(TopMemoryContext,
+								 "Deserialized node cache",
+								 ALLOCSET_START_SMALL_SIZES);
+	oldcxt = MemoryContextSwitchTo(mcxt);
+	entry->bytes = palloc(size);
+	memcpy(entry->bytes, strNode, size);
+	entry->node = copyObject(node);
+	MemoryContextSwitchTo(oldcxt);
+
+	entry->mcxt = mcxt;
+	entry->hash = hash;
+	entry->size = size;
+	entry->lastused = ++node_cache_clock;
+
+	return node;
+}
+
 #ifdef HAVE_LIBZSTD
 /*
  * Compress a (binary) string using libzstd
@@ -114,6 +208,7 @@ compress_string(const char *src, int uncompressed_size, int *size)
 	size_t		compressed_size;
 	size_t		dst_length_used;
 	char	   *result;
+	int			level;
 
 	if (!cxt)
 	{
@@ -126,10 +221,11 @@ compress_string(const char *src, int uncompressed_size, int *size)
 
 	result = palloc(compressed_size);
 
+	level = uncompressed_size < COMPRESS_FAST_LIMIT ? COMPRESS_LEVEL_FAST : COMPRESS_LEVEL;
 	dst_length_used = ZSTD_compressCCtx(cxt,
 										result, compressed_size,
 										src, uncompressed_size,
-										COMPRESS_LEVEL);
+										level);
 	if (ZSTD_isError(dst_length_used))
 		elog(ERROR, "Compression failed: %s uncompressed len %d",
 			 ZSTD_getErrorName(dst_length_used), uncompressed_size);
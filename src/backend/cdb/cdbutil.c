@@ -1022,10 +1022,11 @@ cdb_cleanup(int code __attribute__((unused)), Datum arg
 	{
 		if (cdb_total_plans > 0)
 		{
-			elog(DEBUG1, "session dispatched %d plans %d slices (%f), largest plan %d",
+			elog(DEBUG1, "session dispatched %d plans %d slices (%f), largest plan %d, %d plans (%.1f%%) direct dispatched",
 				 cdb_total_plans, cdb_total_slices,
 				 ((double) cdb_total_slices / (double) cdb_total_plans),
-				 cdb_max_slices);
+				 cdb_max_slices, cdb_total_direct_dispatch_plans,
+				 100.0 * cdb_total_direct_dispatch_plans / cdb_total_plans);
 		}
 	}
 
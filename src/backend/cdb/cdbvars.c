@@ -191,6 +191,9 @@ bool		gp_interconnect_aggressive_retry = true;	/* fast-track app-level
 														 * retry */
 
 bool		gp_interconnect_full_crc = false;	/* sanity check UDP data. */
+bool		gp_interconnect_compression = false;
+int			gp_interconnect_compression_threshold = 65536;	/* kB */
+bool		gp_interconnect_local_sockets = true;
 
 bool		gp_interconnect_log_stats = false;	/* emit stats at log-level */
 
@@ -234,7 +237,8 @@ double		gp_selectivity_damping_factor = 1;
 bool		gp_selectivity_damping_sigsort = true;
 
 int			gp_hashjoin_tuples_per_bucket = 5;
-int			gp_hashagg_groups_per_bucket = 5;
+bool		gp_hashjoin_bloomfilter = true;
+bool		gp_enable_index_skip_scan = true;
 
 /* Analyzing aid */
 int			gp_motion_slice_noop = 0;
@@ -279,6 +283,12 @@ int			gp_workfile_limit_per_query = 0;
 /* Maximum number of workfiles to be created by a query */
 int			gp_workfile_limit_files_per_query = 0;
 
+/* Maximum shared memory for tuplestores shared across slices on a segment, in kilobytes */
+int			gp_shareinput_shmem_size = 65536;
+
+/* Memory to buffer inserts into partitioned tables per DML node, in kilobytes */
+int			gp_dml_insert_batch_mem = 0;
+
 /* Gpmon */
 bool		gp_enable_gpperfmon = false;
 int			gp_gpperfmon_send_interval = 1;
@@ -290,6 +300,9 @@ bool		gp_enable_fast_sri = true;
 /* Enable single-mirror pair dispatch. */
 bool		gp_enable_direct_dispatch = true;
 
+/* Keep the last plans received deserialized on the QEs. */
+bool		gp_enable_qe_plan_cache = true;
+
 /* Force core dump on memory context error */
 bool		coredump_on_memerror = false;
 
@@ -338,6 +351,7 @@ GpId		GpIdentity = {UNINITIALIZED_GP_IDENTITY_VALUE, UNINITIALIZED_GP_IDENTITY_V
 int			cdb_total_slices = 0;
 int			cdb_total_plans = 0;
 int			cdb_max_slices = 0;
+int			cdb_total_direct_dispatch_plans = 0;
 
 /*
  * Local macro to provide string values of numeric defines.
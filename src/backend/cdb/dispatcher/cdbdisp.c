@@ -324,6 +324,16 @@ cdbdisp_makeDispatchParams(CdbDispatcherState *ds,
 	MemoryContextSwitchTo(oldContext);
 }
 
+void
+cdbdisp_setDispatchQueryText(CdbDispatcherState *ds,
+							 char *queryText,
+							 int queryTextLen)
+{
+	Assert(ds->dispatchParams);
+
+	(pDispatchFuncs->setQueryText) (ds->dispatchParams, queryText, queryTextLen);
+}
+
 /*
  * Free memory in CdbDispatcherState
  *
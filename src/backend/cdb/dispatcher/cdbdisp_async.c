@@ -23,6 +23,10 @@
 #ifdef HAVE_SYS_POLL_H
 #include <sys/poll.h>
 #endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#define DISPATCH_EPOLL
+#endif
 
 #include "storage/ipc.h"		/* For proc_exit_inprogress  */
 #include "tcop/tcopprot.h"
@@ -48,6 +52,23 @@
  */
 #define DISPATCH_WAIT_CANCEL_TIMEOUT_MSEC 100
 
+/*
+ * When waiting for this many QEs or more, they are watched with epoll, so
+ * that each wakeup costs the QEs that have something to say, instead of
+ * all the QEs still running as with poll().  Setting up the epoll set costs
+ * a system call per QE, so it's not worth it for few QEs.
+ */
+#define DISPATCH_EPOLL_MIN_QES 16
+
+#ifdef DISPATCH_EPOLL
+/*
+ * The epoll set of the wait in progress.  It's not closed if the wait is
+ * left with an error, the next wait closes it then.  A wait nested in
+ * another one leaves the outer one with poll().
+ */
+static int	dispatchEpollFd = -1;
+#endif
+
 typedef struct CdbDispatchCmdAsync
 {
 
@@ -82,6 +103,7 @@ typedef struct CdbDispatchCmdAsync
 } CdbDispatchCmdAsync;
 
 static void *cdbdisp_makeDispatchParams_async(int maxSlices, int largestGangSize, char *queryText, int len);
+static void cdbdisp_setQueryText_async(void *dispatchParams, char *queryText, int len);
 
 static void cdbdisp_checkDispatchResult_async(struct CdbDispatcherState *ds,
 								  DispatchWaitMode waitMode);
@@ -99,6 +121,7 @@ DispatcherInternalFuncs DispatcherAsyncFuncs =
 	cdbdisp_checkForCancel_async,
 	cdbdisp_getWaitSocketFd_async,
 	cdbdisp_makeDispatchParams_async,
+	cdbdisp_setQueryText_async,
 	cdbdisp_checkDispatchResult_async,
 	cdbdisp_dispatchToGang_async,
 	cdbdisp_waitDispatchFinish_async
@@ -126,6 +149,15 @@ static void
 static void
 			handlePollSuccess(CdbDispatchCmdAsync *pParms, struct pollfd *fds);
 
+static void
+			handleQEInput(CdbDispatchCmdAsync *pParms, int i);
+
+#ifdef DISPATCH_EPOLL
+static void
+			handleEpollSuccess(CdbDispatchCmdAsync *pParms,
+							   struct epoll_event *events, int nevents);
+#endif
+
 /*
  * Check dispatch result.
  * Don't wait all dispatch commands to complete.
@@ -366,6 +398,19 @@ cdbdisp_makeDispatchParams_async(int maxSlices, int largestGangSize, char *query
 	return (void *) pParms;
 }
 
+/*
+ * Change the query text of a CdbDispatchCmdAsync, for the gangs dispatched
+ * to after this.
+ */
+static void
+cdbdisp_setQueryText_async(void *dispatchParams, char *queryText, int len)
+{
+	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) dispatchParams;
+
+	pParms->query_text = queryText;
+	pParms->query_text_len = len;
+}
+
 /*
  * Receive and process results from all running QEs.
  *
@@ -389,10 +434,31 @@ checkDispatchResult(CdbDispatcherState *ds,
 	bool		sentSignal = false;
 	struct pollfd *fds;
 	uint8 ftsVersion = 0;
+#ifdef DISPATCH_EPOLL
+	struct epoll_event *events = NULL;
+	bool	   *watched = NULL;
+#endif
 
 	db_count = pParms->dispatchCount;
 	fds = (struct pollfd *) palloc(db_count * sizeof(struct pollfd));
 
+#ifdef DISPATCH_EPOLL
+	if (dispatchEpollFd >= 0)
+	{
+		close(dispatchEpollFd);
+		dispatchEpollFd = -1;
+	}
+
+	/* if it can't be set up, poll() does it all */
+	if (wait && db_count >= DISPATCH_EPOLL_MIN_QES)
+		dispatchEpollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (dispatchEpollFd >= 0)
+	{
+		events = (struct epoll_event *) palloc(db_count * sizeof(struct epoll_event));
+		watched = (bool *) palloc0(db_count * sizeof(bool));
+	}
+#endif
+
 	/*
 	 * OK, we are finished submitting the command to the segdbs. Now, we have
 	 * to wait for them to finish.
@@ -432,7 +498,16 @@ checkDispatchResult(CdbDispatcherState *ds,
 			 * Already finished with this QE?
 			 */
 			if (!dispatchResult->stillRunning)
+			{
+#ifdef DISPATCH_EPOLL
+				/* a closed connection has left the epoll set already */
+				if (dispatchEpollFd >= 0 && watched[i] && conn != NULL)
+					epoll_ctl(dispatchEpollFd, EPOLL_CTL_DEL, PQsocket(conn), NULL);
+				if (dispatchEpollFd >= 0)
+					watched[i] = false;
+#endif
 				continue;
+			}
 
 			Assert(!cdbconn_isBadConnection(segdbDesc));
 
@@ -460,6 +535,25 @@ checkDispatchResult(CdbDispatcherState *ds,
 			fds[nfds].fd = sock;
 			fds[nfds].events = POLLIN;
 			nfds++;
+
+#ifdef DISPATCH_EPOLL
+			if (dispatchEpollFd >= 0 && !watched[i])
+			{
+				struct epoll_event ev;
+
+				ev.events = EPOLLIN;
+				ev.data.u32 = i;
+				if (epoll_ctl(dispatchEpollFd, EPOLL_CTL_ADD, sock, &ev) == 0)
+					watched[i] = true;
+				else
+				{
+					elog(LOG, "could not add socket of %s to epoll set, waiting with poll(): %m",
+						 segdbDesc->whoami);
+					close(dispatchEpollFd);
+					dispatchEpollFd = -1;
+				}
+			}
+#endif
 		}
 
 		/*
@@ -483,7 +577,12 @@ checkDispatchResult(CdbDispatcherState *ds,
 		else
 			timeout = DISPATCH_WAIT_CANCEL_TIMEOUT_MSEC;
 
-		n = poll(fds, nfds, timeout);
+#ifdef DISPATCH_EPOLL
+		if (dispatchEpollFd >= 0)
+			n = epoll_wait(dispatchEpollFd, events, db_count, timeout);
+		else
+#endif
+			n = poll(fds, nfds, timeout);
 
 		/*
 		 * poll returns with an error, including one due to an interrupted
@@ -543,10 +642,25 @@ checkDispatchResult(CdbDispatcherState *ds,
 				break;
 		}
 		/* We have data waiting on one or more of the connections. */
+#ifdef DISPATCH_EPOLL
+		else if (dispatchEpollFd >= 0)
+			handleEpollSuccess(pParms, events, n);
+#endif
 		else
 			handlePollSuccess(pParms, fds);
 	}
 
+#ifdef DISPATCH_EPOLL
+	if (dispatchEpollFd >= 0)
+	{
+		close(dispatchEpollFd);
+		dispatchEpollFd = -1;
+	}
+	if (events)
+		pfree(events);
+	if (watched)
+		pfree(watched);
+#endif
 	pfree(fds);
 }
 
@@ -661,7 +775,6 @@ handlePollSuccess(CdbDispatchCmdAsync *pParms,
 	 */
 	for (i = 0; i < pParms->dispatchCount; i++)
 	{
-		bool		finished;
 		int			sock;
 		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
 		SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
@@ -688,42 +801,88 @@ handlePollSuccess(CdbDispatchCmdAsync *pParms,
 		ELOG_DISPATCHER_DEBUG("PQsocket says there are results from %d of %d (%s)",
 							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
 
-		/*
-		 * Receive and process results from this QE.
-		 */
-		finished = processResults(dispatchResult);
+		handleQEInput(pParms, i);
+	}
+}
+
+#ifdef DISPATCH_EPOLL
+/*
+ * Receive and process results from the QEs epoll_wait() says have input.
+ */
+static void
+handleEpollSuccess(CdbDispatchCmdAsync *pParms,
+				   struct epoll_event *events, int nevents)
+{
+	int			k;
+
+	for (k = 0; k < nevents; k++)
+	{
+		int			i = events[k].data.u32;
+
+		Assert(i < pParms->dispatchCount);
 
 		/*
-		 * Are we through with this QE now?
+		 * Skip if it finished since it was watched, it leaves the epoll set
+		 * in the next round.
 		 */
-		if (finished)
-		{
-			dispatchResult->stillRunning = false;
+		if (!pParms->dispatchResultPtrArray[i]->stillRunning)
+			continue;
 
-			ELOG_DISPATCHER_DEBUG("processResults says we are finished with %d of %d (%s)",
-								  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+		ELOG_DISPATCHER_DEBUG("epoll says there are results from %d of %d (%s)",
+							  i + 1, pParms->dispatchCount,
+							  pParms->dispatchResultPtrArray[i]->segdbDesc->whoami);
 
-			if (DEBUG1 >= log_min_messages)
-			{
-				char		msec_str[32];
+		/* a hangup or an error is seen by PQconsumeInput() */
+		handleQEInput(pParms, i);
+	}
+}
+#endif
 
-				switch (check_log_duration(msec_str, false))
-				{
-					case 1:
-					case 2:
-						elog(LOG, "duration to dispatch result received from %d (seg %d): %s ms",
-							 i + 1, dispatchResult->segdbDesc->segindex, msec_str);
-						break;
-				}
-			}
+/*
+ * Receive and process results from the i'th QE, which has input available.
+ */
+static void
+handleQEInput(CdbDispatchCmdAsync *pParms, int i)
+{
+	bool		finished;
+	CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
+	SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
+
+	/*
+	 * Receive and process results from this QE.
+	 */
+	finished = processResults(dispatchResult);
+
+	/*
+	 * Are we through with this QE now?
+	 */
+	if (finished)
+	{
+		dispatchResult->stillRunning = false;
+
+		ELOG_DISPATCHER_DEBUG("processResults says we are finished with %d of %d (%s)",
+							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+
+		if (DEBUG1 >= log_min_messages)
+		{
+			char		msec_str[32];
 
-			if (PQisBusy(dispatchResult->segdbDesc->conn))
-				elog(LOG, "We thought we were done, because finished==true, but libpq says we are still busy");
+			switch (check_log_duration(msec_str, false))
+			{
+				case 1:
+				case 2:
+					elog(LOG, "duration to dispatch result received from %d (seg %d): %s ms",
+						 i + 1, dispatchResult->segdbDesc->segindex, msec_str);
+					break;
+			}
 		}
-		else
-			ELOG_DISPATCHER_DEBUG("processResults says we have more to do with %d of %d (%s)",
-								  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+
+		if (PQisBusy(dispatchResult->segdbDesc->conn))
+			elog(LOG, "We thought we were done, because finished==true, but libpq says we are still busy");
 	}
+	else
+		ELOG_DISPATCHER_DEBUG("processResults says we have more to do with %d of %d (%s)",
+							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
 }
 
 /*
@@ -102,6 +102,7 @@ static char *buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 				   int *finalLen);
 
 static DispatchCommandQueryParms *cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc, bool planRequiresTxn);
+static char *serializeSlicePlan(struct QueryDesc *queryDesc, int sliceIndex, int *len_p);
 static DispatchCommandQueryParms *cdbdisp_buildUtilityQueryParms(struct Node *stmt, int flags, List *oid_assignments);
 static DispatchCommandQueryParms *cdbdisp_buildCommandQueryParms(const char *strCommand, int flags);
 
@@ -542,13 +543,10 @@ static DispatchCommandQueryParms *
 cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 							bool planRequiresTxn)
 {
-	char	   *splan,
-			   *sddesc,
+	char	   *sddesc,
 			   *sparams;
 
-	int			splan_len,
-				splan_len_uncompressed,
-				sddesc_len,
+	int			sddesc_len,
 				sparams_len,
 				rootIdx;
 
@@ -565,29 +563,11 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	DispatchCommandQueryParms *pQueryParms = (DispatchCommandQueryParms *) palloc0(sizeof(*pQueryParms));
 
 	/*
-	 * serialized plan tree. Note that we're called for a single slice tree
+	 * The serialized plan tree is filled in by the caller, see
+	 * serializeSlicePlan(). Note that we're called for a single slice tree
 	 * (corresponding to an initPlan or the main plan), so the parameters are
 	 * fixed and we can include them in the prefix.
 	 */
-	splan = serializeNode((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
-
-	uint64		plan_size_in_kb = ((uint64) splan_len_uncompressed) / (uint64) 1024;
-
-	elog(((gp_log_gang >= GPVARS_VERBOSITY_TERSE) ? LOG : DEBUG1),
-		 "Query plan size to dispatch: " UINT64_FORMAT "KB", plan_size_in_kb);
-
-	if (0 < gp_max_plan_size && plan_size_in_kb > gp_max_plan_size)
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_STATEMENT_TOO_COMPLEX),
-				 (errmsg("Query plan size limit exceeded, current size: "
-						 UINT64_FORMAT "KB, max allowed size: %dKB",
-						 plan_size_in_kb, gp_max_plan_size),
-				  errhint("Size controlled by gp_max_plan_size"))));
-	}
-
-	Assert(splan != NULL && splan_len > 0 && splan_len_uncompressed > 0);
-
 	if (queryDesc->params != NULL && queryDesc->params->numParams > 0)
 	{
 		sparams = serializeParamListInfo(queryDesc->params, &sparams_len);
@@ -603,8 +583,8 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	pQueryParms->strCommand = queryDesc->sourceText;
 	pQueryParms->serializedQuerytree = NULL;
 	pQueryParms->serializedQuerytreelen = 0;
-	pQueryParms->serializedPlantree = splan;
-	pQueryParms->serializedPlantreelen = splan_len;
+	pQueryParms->serializedPlantree = NULL;
+	pQueryParms->serializedPlantreelen = 0;
 	pQueryParms->serializedParams = sparams;
 	pQueryParms->serializedParamslen = sparams_len;
 	pQueryParms->serializedQueryDispatchDesc = sddesc;
@@ -626,6 +606,136 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	return pQueryParms;
 }
 
+/*
+ * Context of pruneSlicePlanWalker: the Motions whose subtree is detached
+ * while the plan is serialized for one slice, and their subtrees.
+ */
+typedef struct SlicePlanPruneContext
+{
+	plan_tree_base_prefix base; /* Required prefix for plan_tree_walker */
+	int			sliceIndex;		/* slice the plan is serialized for */
+	bool		found;			/* sending Motion of the slice seen */
+	List	   *motions;
+	List	   *subtrees;
+} SlicePlanPruneContext;
+
+/*
+ * Find the Motions below which nothing runs in the slice: those that are
+ * not the sending Motion of the slice, nor above it.
+ *
+ * The QEs of the slice start executing at its sending Motion, and a
+ * receiving Motion doesn't initialize its subtree when alien plan nodes
+ * are eliminated, so these subtrees are never looked at.  Only the
+ * outermost of such Motions is remembered.
+ */
+static bool
+pruneSlicePlanWalker(Node *node, SlicePlanPruneContext *ctx)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Motion))
+	{
+		Motion	   *motion = (Motion *) node;
+		bool		found_outer = ctx->found;
+		int			nmotions = list_length(ctx->motions);
+
+		ctx->found = false;
+		plan_tree_walker(node, pruneSlicePlanWalker, ctx);
+
+		if (motion->motionID == ctx->sliceIndex)
+			ctx->found = true;
+
+		if (!ctx->found && motion->plan.lefttree != NULL)
+		{
+			ctx->motions = list_truncate(ctx->motions, nmotions);
+			ctx->subtrees = list_truncate(ctx->subtrees, nmotions);
+			ctx->motions = lappend(ctx->motions, motion);
+			ctx->subtrees = lappend(ctx->subtrees, motion->plan.lefttree);
+		}
+
+		ctx->found = ctx->found || found_outer;
+		return false;
+	}
+
+	return plan_tree_walker(node, pruneSlicePlanWalker, ctx);
+}
+
+/*
+ * Serialize the plan to dispatch to the QEs of a slice.
+ *
+ * If sliceIndex is -1, the whole plan is serialized. Otherwise the subtrees
+ * the slice doesn't execute are left out: each slice's own subtree is
+ * shipped only to its own gang, instead of every gang receiving every
+ * slice. The range table and the rest of the PlannedStmt are shared by the
+ * slices, they are always included. The subtrees are detached only while
+ * the plan is serialized, the plan is left as it was.
+ */
+static char *
+serializeSlicePlan(struct QueryDesc *queryDesc, int sliceIndex, int *len_p)
+{
+	PlannedStmt *stmt = queryDesc->plannedstmt;
+	SlicePlanPruneContext ctx;
+	char	   *splan;
+	int			splan_len_uncompressed;
+	ListCell   *lcm;
+	ListCell   *lcs;
+
+	ctx.base.node = (Node *) stmt;
+	ctx.sliceIndex = sliceIndex;
+	ctx.found = false;
+	ctx.motions = NIL;
+	ctx.subtrees = NIL;
+
+	if (sliceIndex >= 0)
+		pruneSlicePlanWalker((Node *) stmt->planTree, &ctx);
+
+	PG_TRY();
+	{
+		foreach(lcm, ctx.motions)
+			((Motion *) lfirst(lcm))->plan.lefttree = NULL;
+
+		splan = serializeNode((Node *) stmt, len_p, &splan_len_uncompressed);
+	}
+	PG_CATCH();
+	{
+		forboth(lcm, ctx.motions, lcs, ctx.subtrees)
+			((Motion *) lfirst(lcm))->plan.lefttree = (Plan *) lfirst(lcs);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	forboth(lcm, ctx.motions, lcs, ctx.subtrees)
+		((Motion *) lfirst(lcm))->plan.lefttree = (Plan *) lfirst(lcs);
+
+	list_free(ctx.motions);
+	list_free(ctx.subtrees);
+
+	uint64		plan_size_in_kb = ((uint64) splan_len_uncompressed) / (uint64) 1024;
+
+	if (sliceIndex >= 0)
+		elog(((gp_log_gang >= GPVARS_VERBOSITY_TERSE) ? LOG : DEBUG1),
+			 "Query plan size to dispatch to slice %d: " UINT64_FORMAT "KB",
+			 sliceIndex, plan_size_in_kb);
+	else
+		elog(((gp_log_gang >= GPVARS_VERBOSITY_TERSE) ? LOG : DEBUG1),
+			 "Query plan size to dispatch: " UINT64_FORMAT "KB", plan_size_in_kb);
+
+	if (0 < gp_max_plan_size && plan_size_in_kb > gp_max_plan_size)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_STATEMENT_TOO_COMPLEX),
+				 (errmsg("Query plan size limit exceeded, current size: "
+						 UINT64_FORMAT "KB, max allowed size: %dKB",
+						 plan_size_in_kb, gp_max_plan_size),
+				  errhint("Size controlled by gp_max_plan_size"))));
+	}
+
+	Assert(splan != NULL && *len_p > 0 && splan_len_uncompressed > 0);
+
+	return splan;
+}
+
 /*
  * Three Helper functions for cdbdisp_dispatchX:
  *
@@ -1034,6 +1144,9 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	CdbDispatcherState *ds;
 	ErrorData *qeError = NULL;
 	DispatchCommandQueryParms *pQueryParms;
+	bool		sliceplans;
+	bool		directDispatch = true;
+	int			nDispatchSlices = 0;
 
 	if (log_dispatch_stats)
 		ResetUsage();
@@ -1069,8 +1182,32 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	sliceVector = palloc0(nTotalSlices * sizeof(SliceVec));
 	nSlices = fillSliceVector(sliceTbl, rootIdx, sliceVector, nTotalSlices);
 
+	for (iSlice = 0; iSlice < nSlices; iSlice++)
+	{
+		Slice	   *slice = sliceVector[iSlice].slice;
+
+		if (slice->gangType != GANGTYPE_UNALLOCATED)
+		{
+			nDispatchSlices++;
+			if (!slice->directDispatch.isDirectDispatch)
+				directDispatch = false;
+		}
+	}
+
+	/*
+	 * If more than one gang is dispatched to, send each of them the plan of
+	 * its own slice only. The QEs don't look at the subtrees of the other
+	 * slices, as long as they eliminate alien plan nodes.
+	 */
+	sliceplans = execute_pruned_plan && nDispatchSlices > 1;
+
 	pQueryParms = cdbdisp_buildPlanQueryParms(queryDesc, planRequiresTxn);
-	queryText = buildGpQueryString(pQueryParms, &queryTextLength);
+	if (!sliceplans)
+	{
+		pQueryParms->serializedPlantree =
+			serializeSlicePlan(queryDesc, -1, &pQueryParms->serializedPlantreelen);
+		queryText = buildGpQueryString(pQueryParms, &queryTextLength);
+	}
 
 	/*
 	 * Allocate result array with enough slots for QEs of primary gangs.
@@ -1080,6 +1217,8 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 
 	cdb_total_plans++;
 	cdb_total_slices += nSlices;
+	if (directDispatch && nDispatchSlices > 0)
+		cdb_total_direct_dispatch_plans++;
 	if (nSlices > cdb_max_slices)
 		cdb_max_slices = nSlices;
 
@@ -1143,6 +1282,18 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 		}
 		SIMPLE_FAULT_INJECTOR("before_one_slice_dispatched");
 
+		/*
+		 * The query text is sent without being copied, each slice's one must
+		 * live until the dispatch is finished.
+		 */
+		if (sliceplans)
+		{
+			pQueryParms->serializedPlantree =
+				serializeSlicePlan(queryDesc, si, &pQueryParms->serializedPlantreelen);
+			queryText = buildGpQueryString(pQueryParms, &queryTextLength);
+			cdbdisp_setDispatchQueryText(ds, queryText, queryTextLength);
+		}
+
 		cdbdisp_dispatchToGang(ds, primaryGang, si);
 		if (planRequiresTxn || isDtxExplicitBegin())
 			addToGxactTwophaseSegments(primaryGang);
@@ -173,6 +173,7 @@ createMotionLayerState(int maxMotNodeID)
 	 */
 	s_eos_chunk_data->p_next = NULL;
 	s_eos_chunk_data->inplace = NULL;
+	s_eos_chunk_data->sendref = NULL;
 	s_eos_chunk_data->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
 
 	pData = s_eos_chunk_data->chunk_data;
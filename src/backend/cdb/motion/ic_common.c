@@ -194,6 +194,7 @@ RecvTupleChunk(MotionConn *conn, ChunkTransportState *transportStates)
 		tcItem->p_next = NULL;
 		tcItem->chunk_length = tcSize;
 		tcItem->inplace = (char *) (conn->msgPos + bytesProcessed);
+		tcItem->sendref = NULL;
 
 		bytesProcessed += TYPEALIGN(TUPLE_CHUNK_ALIGN, tcSize);
 
@@ -504,13 +505,34 @@ DeregisterReadInterest(ChunkTransportState *transportStates,
 		 * deadlock the entire query (QEs wait in their Teardown calls, while
 		 * the QD waits for them to finish)
 		 */
-		shutdown(conn->sockfd, SHUT_WR);
+		markTCPConnInactive(conn);
 
 		MPP_FD_CLR(conn->sockfd, &pEntry->readSet);
 	}
 	return;
 }
 
+/*
+ * CompressMotionPackets is called on sending nodes of a motion which is
+ * expected to send a lot of data, to compress the packets it sends.  Only
+ * the UDPIFC interconnect compresses them, receivers decompress the packets
+ * that are marked compressed.
+ */
+void
+CompressMotionPackets(ChunkTransportState *transportStates, int motNodeID)
+{
+	ChunkTransportStateEntry *pEntry = NULL;
+
+	if (!transportStates || !transportStates->activated)
+		return;
+
+	if (Gp_interconnect_type != INTERCONNECT_TYPE_UDPIFC)
+		return;
+
+	getChunkTransportState(transportStates, motNodeID, &pEntry);
+	pEntry->compressPackets = true;
+}
+
 void
 SetupInterconnect(EState *estate)
 {
@@ -658,6 +680,7 @@ createChunkTransportState(ChunkTransportState *transportStates,
 	pEntry->scanStart = 0;
 	pEntry->sendSlice = sendSlice;
 	pEntry->recvSlice = recvSlice;
+	pEntry->compressPackets = false;
 
 	pEntry->conns = palloc0(pEntry->numConns * sizeof(pEntry->conns[0]));
 
@@ -21,6 +21,7 @@
 #include "libpq/libpq-be.h"
 #include "libpq/ip.h"
 #include "utils/builtins.h"
+#include "utils/memutils.h"
 
 #include "cdb/cdbselect.h"
 #include "cdb/tupchunklist.h"
@@ -46,6 +47,38 @@
 /* listener backlog is calculated at listener-creation time */
 int			listenerBacklog = 128;
 
+/* gp_interconnect_tcp_connection_pool_size */
+int			tcpConnectionPoolSize = 0;
+
+/*
+ * The reuse message a receiver answers the EOS message with, when it keeps
+ * the connection open for the next query.  The sender keeps it open too
+ * when it reads this instead of the end of the connection.
+ */
+#define REUSE_MESSAGE	'R'
+
+/*
+ * Connections kept open at the end of a query, for the next queries of the
+ * session to use instead of connecting again.  A sender registers a pooled
+ * outgoing connection to the same receiving process again, with the
+ * registration message of the new query, and the receiver waits on its
+ * pooled incoming connections for registration messages along with the
+ * listener.  The gangs of a session stay the same across its queries, so
+ * most connections of a plan are found in the pool.
+ */
+typedef struct PooledConn
+{
+	int			sockfd;
+	bool		outgoing;
+	int			remotePid;		/* of the receiver of outgoing connections */
+	char		remoteHostAndPort[128];
+	char		localHostAndPort[128];
+} PooledConn;
+
+static PooledConn *connPool = NULL;
+static int	connPoolCount = 0;
+static int	connPoolAllocated = 0;
+
 /* our timeout value for select() and other socket operations. */
 static struct timeval tval;
 
@@ -96,6 +129,12 @@ static bool flushBuffer(ChunkTransportState *transportStates,
 
 static void doSendStopMessageTCP(ChunkTransportState *transportStates, int16 motNodeID);
 
+static bool pooledConnectionAlive(int sockfd, bool outgoing);
+static void poolConnection(MotionConn *conn, bool outgoing);
+static int	takePooledOutgoingConnection(MotionConn *conn);
+static void takePooledIncomingConnections(ChunkTransportState *transportStates);
+static void closeConnectionPool(void);
+
 #ifdef AMS_VERBOSE_LOGGING
 static void dumpEntryConnections(int elevel, ChunkTransportStateEntry *pEntry);
 static void print_connection(ChunkTransportState *transportStates, int fd, const char *msg);
@@ -290,10 +329,200 @@ InitMotionTCP(int *listenerSocketFd, uint16 *listenerPort)
 void
 CleanupMotionTCP(void)
 {
-	/* nothing to do. */
+	closeConnectionPool();
 	return;
 }
 
+/*
+ * Is a pooled connection still usable?  Nothing is expected on an outgoing
+ * one, but a sender of the next query may have sent its registration
+ * message on an incoming one already.
+ */
+static bool
+pooledConnectionAlive(int sockfd, bool outgoing)
+{
+	char		c;
+	int			n;
+
+	n = recv(sockfd, &c, sizeof(c), MSG_PEEK | MSG_DONTWAIT);
+	if (n > 0)
+		return !outgoing;
+	if (n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR))
+		return true;
+
+	/* closed by the peer, or broken */
+	return false;
+}
+
+/*
+ * Keep the socket of a connection open for the next queries, if the pool
+ * has room for it, or close it.
+ */
+static void
+poolConnection(MotionConn *conn, bool outgoing)
+{
+	PooledConn *pc;
+
+	Assert(conn->sockfd >= 0);
+
+	if (connPoolCount >= tcpConnectionPoolSize)
+	{
+		closesocket(conn->sockfd);
+		conn->sockfd = -1;
+		return;
+	}
+
+	if (connPoolAllocated < tcpConnectionPoolSize)
+	{
+		if (connPool == NULL)
+			connPool = MemoryContextAlloc(TopMemoryContext,
+										  tcpConnectionPoolSize * sizeof(PooledConn));
+		else
+			connPool = repalloc(connPool,
+								tcpConnectionPoolSize * sizeof(PooledConn));
+		connPoolAllocated = tcpConnectionPoolSize;
+	}
+
+	pc = &connPool[connPoolCount++];
+	pc->sockfd = conn->sockfd;
+	pc->outgoing = outgoing;
+	pc->remotePid = (outgoing && conn->cdbProc) ? conn->cdbProc->pid : 0;
+	strlcpy(pc->remoteHostAndPort, conn->remoteHostAndPort,
+			sizeof(pc->remoteHostAndPort));
+	strlcpy(pc->localHostAndPort, conn->localHostAndPort,
+			sizeof(pc->localHostAndPort));
+
+	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+		elog(DEBUG3, "Interconnect keeping %s connection %s sockfd=%d for reuse",
+			 outgoing ? "outgoing" : "incoming",
+			 conn->remoteHostAndPort, conn->sockfd);
+
+	conn->sockfd = -1;
+}
+
+/*
+ * Find a pooled connection to the receiving process of an outgoing
+ * connection.  Returns its socket, or -1 if there is none.
+ */
+static int
+takePooledOutgoingConnection(MotionConn *conn)
+{
+	int			i;
+
+	for (i = 0; i < connPoolCount; i++)
+	{
+		PooledConn *pc = &connPool[i];
+		int			sockfd = pc->sockfd;
+
+		if (!pc->outgoing ||
+			pc->remotePid != conn->cdbProc->pid ||
+			strcmp(pc->remoteHostAndPort, conn->remoteHostAndPort) != 0)
+			continue;
+
+		strlcpy(conn->localHostAndPort, pc->localHostAndPort,
+				sizeof(conn->localHostAndPort));
+		connPool[i] = connPool[--connPoolCount];
+
+		if (!pooledConnectionAlive(sockfd, true))
+		{
+			closesocket(sockfd);
+			return -1;
+		}
+
+		return sockfd;
+	}
+
+	return -1;
+}
+
+/*
+ * Check the pooled connections at the start of a query, and wait on the
+ * incoming ones for registration messages like on the accepted ones.  The
+ * ones a sender did not register again by the end of the setup go back to
+ * the pool.
+ */
+static void
+takePooledIncomingConnections(ChunkTransportState *transportStates)
+{
+	int			i = 0;
+
+	if (tcpConnectionPoolSize == 0)
+	{
+		closeConnectionPool();
+		return;
+	}
+
+	while (i < connPoolCount)
+	{
+		PooledConn *pc = &connPool[i];
+		MotionConn *conn;
+
+		if (!pooledConnectionAlive(pc->sockfd, pc->outgoing))
+		{
+			closesocket(pc->sockfd);
+			connPool[i] = connPool[--connPoolCount];
+			continue;
+		}
+
+		if (pc->outgoing)
+		{
+			i++;
+			continue;
+		}
+
+		conn = palloc0(sizeof(MotionConn));
+		conn->sockfd = pc->sockfd;
+		conn->pBuff = palloc(Gp_max_packet_size);
+		conn->stillActive = false;
+		conn->reusable = true;
+		conn->state = mcsRecvRegMsg;
+		conn->msgSize = sizeof(RegisterMessage);
+		conn->msgPos = conn->pBuff;
+		conn->remoteContentId = -2;
+		conn->remapper = CreateTupleRemapper();
+		strlcpy(conn->remoteHostAndPort, pc->remoteHostAndPort,
+				sizeof(conn->remoteHostAndPort));
+		strlcpy(conn->localHostAndPort, pc->localHostAndPort,
+				sizeof(conn->localHostAndPort));
+
+		transportStates->incompleteConns = lappend(transportStates->incompleteConns, conn);
+		connPool[i] = connPool[--connPoolCount];
+	}
+}
+
+/* Close all the pooled connections. */
+static void
+closeConnectionPool(void)
+{
+	while (connPoolCount > 0)
+		closesocket(connPool[--connPoolCount].sockfd);
+}
+
+/*
+ * markTCPConnInactive
+ *
+ * Called by DeregisterReadInterest when a receiver needs no more data from a
+ * sender.  Tell the sender with the end of the connection, or, after the EOS
+ * message, that the connection is kept open for the next query.
+ */
+void
+markTCPConnInactive(MotionConn *conn)
+{
+	char		m = REUSE_MESSAGE;
+
+	if (conn->sockfd < 0 || conn->reusable)
+		return;
+
+	if (tcpConnectionPoolSize > 0 && !conn->stopRequested &&
+		send(conn->sockfd, &m, sizeof(m), 0) == sizeof(m))
+	{
+		conn->reusable = true;
+		return;
+	}
+
+	shutdown(conn->sockfd, SHUT_WR);
+}
+
 /* Function readPacket() is used to read in the next packet from the given
  * MotionConn.
  *
@@ -589,6 +818,26 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 		conn->sockfd = -1;
 	}
 
+	/* Is the connection to the receiver of an earlier query still open? */
+	if (connPoolCount > 0)
+	{
+		conn->sockfd = takePooledOutgoingConnection(conn);
+		if (conn->sockfd >= 0)
+		{
+			if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+				ereport(DEBUG1, (errmsg("Interconnect reusing connection to seg%d slice%d %s "
+										"pid=%d sockfd=%d",
+										conn->remoteContentId,
+										pEntry->recvSlice->sliceIndex,
+										conn->remoteHostAndPort,
+										conn->cdbProc->pid,
+										conn->sockfd)));
+
+			sendRegisterMessage(transportStates, pEntry, conn);
+			return;
+		}
+	}
+
 	/* Initialize hint structure */
 	MemSet(&hint, 0, sizeof(hint));
 	hint.ai_socktype = SOCK_STREAM;
@@ -889,8 +1138,10 @@ readRegisterMessage(ChunkTransportState *transportStates,
 			conn->msgPos += bytesReceived;
 		else if (bytesReceived == 0)
 		{
-			elog(LOG, "Interconnect error reading register message from %s: connection closed",
-				 conn->remoteHostAndPort);
+			/* the sender dropped a pooled connection, nothing to report */
+			if (!conn->reusable || conn->msgPos != conn->pBuff)
+				elog(LOG, "Interconnect error reading register message from %s: connection closed",
+					 conn->remoteHostAndPort);
 
 			/* maybe this peer is already retrying ? */
 			goto old_conn;
@@ -1041,6 +1292,7 @@ readRegisterMessage(ChunkTransportState *transportStates,
 
 	newConn->cdbProc = cdbproc;
 	newConn->remoteContentId = msg.srcContentId;
+	newConn->reusable = false;
 
 	/*
 	 * The caller's MotionConn object is no longer valid.
@@ -1260,6 +1512,10 @@ SetupTCPInterconnect(EState *estate)
 
 	gp_set_monotonic_begin_time(&startTime);
 
+	/* Check the connections kept open by earlier queries. */
+	if (connPoolCount > 0 || tcpConnectionPoolSize == 0)
+		takePooledIncomingConnections(interconnect_context);
+
 	/* Initiate outgoing connections. */
 	if (mySlice->parentIndex != -1)
 		sendingChunkTransportState = startOutgoingConnections(interconnect_context, mySlice, &expectedTotalOutgoing);
@@ -1736,6 +1992,11 @@ SetupTCPInterconnect(EState *estate)
 		{
 			conn = (MotionConn *) lfirst(cell);
 
+			/* pooled connections that no sender registered go back */
+			if (conn->sockfd != -1 &&
+				conn->reusable && conn->msgPos == conn->pBuff)
+				poolConnection(conn, false);
+
 			if (conn->sockfd != -1)
 			{
 				flushIncomingData(conn->sockfd);
@@ -1793,6 +2054,7 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 	int			i;
 	Slice	   *mySlice;
 	MotionConn *conn;
+	bool		reuse;
 
 	if (transportStates == NULL || transportStates->sliceTable == NULL)
 	{
@@ -1809,6 +2071,9 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 
 	mySlice = (Slice *) list_nth(transportStates->sliceTable->slices, transportStates->sliceId);
 
+	/* connections of queries that end normally may be kept for the next */
+	reuse = tcpConnectionPoolSize > 0 && !forceEOS && !hasError;
+
 	/* Log the start of TeardownInterconnect. */
 	if (gp_log_interconnect >= GPVARS_VERBOSITY_TERSE)
 	{
@@ -1910,7 +2175,9 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 		for (i = 0; i < pEntry->numConns; i++)
 		{
 			conn = pEntry->conns + i;
-			if (conn->sockfd >= 0)
+
+			/* the receiver closes the connection, or keeps it for reuse */
+			if (conn->sockfd >= 0 && !reuse)
 				shutdown(conn->sockfd, SHUT_WR);
 
 			/* free up the tuple remapper */
@@ -1950,11 +2217,17 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 
 			if (conn->sockfd >= 0)
 			{
-				flushIncomingData(conn->sockfd);
-				shutdown(conn->sockfd, SHUT_WR);
+				/* the sender keeps it too, once told to, see markTCPConnInactive */
+				if (conn->reusable && !hasError)
+					poolConnection(conn, false);
+				else
+				{
+					flushIncomingData(conn->sockfd);
+					shutdown(conn->sockfd, SHUT_WR);
 
-				closesocket(conn->sockfd);
-				conn->sockfd = -1;
+					closesocket(conn->sockfd);
+					conn->sockfd = -1;
+				}
 
 				/* free up the tuple remapper */
 				if (conn->remapper)
@@ -1999,6 +2272,9 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 		{
 			conn = pEntry->conns + i;
 
+			if (conn->sockfd >= 0 && reuse && conn->reusable)
+				poolConnection(conn, true);
+
 			if (conn->sockfd >= 0)
 			{
 				closesocket(conn->sockfd);
@@ -2307,8 +2583,10 @@ waitOnOutbound(ChunkTransportStateEntry *pEntry)
 
 				if (count == 0 || count == 1) /* done ! */
 				{
-					/* got a stop message */
-					AssertImply(count == 1, buf == 'S');
+					/* got a stop message, or the receiver keeps the connection */
+					AssertImply(count == 1, buf == 'S' || buf == REUSE_MESSAGE);
+					if (count == 1 && buf == REUSE_MESSAGE)
+						conn->reusable = true;
 
 					MPP_FD_CLR(conn->sockfd, &waitset);
 					/* we may have finished */
@@ -2380,6 +2658,9 @@ doSendStopMessageTCP(ChunkTransportState *transportStates, int16 motNodeID)
 				 */
 				elog(LOG, "SendStopMessage: failed on write.  %m");
 			}
+
+			/* the sender may have data in flight, don't reuse the connection */
+			conn->stopRequested = true;
 		}
 		/* CRITICAL TO AVOID DEADLOCK */
 		DeregisterReadInterest(transportStates, motNodeID, i,
@@ -2755,7 +3036,7 @@ SendChunkTCP(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEn
 			return false;
 	}
 
-	memcpy(conn->pBuff + conn->msgSize, tcItem->chunk_data, tcItem->chunk_length);
+	CopyChunkToBuffer(conn->pBuff + conn->msgSize, tcItem);
 	conn->msgSize += length;
 
 	conn->tupleCount++;
@@ -51,6 +51,10 @@
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbicudpfaultinjection.h"
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
 #include <fcntl.h>
 #include <limits.h>
 #include <unistd.h>
@@ -58,6 +62,30 @@
 #include "pgtime.h"
 #include <netinet/in.h>
 
+/*
+ * Packets to the receivers on the same host are sent through Unix domain
+ * datagram sockets, named in the abstract namespace of Linux.
+ */
+#if defined(__linux__) && defined(HAVE_UNIX_SOCKETS)
+#define IC_LOCAL_SOCKETS
+#include <sys/un.h>
+#endif
+
+/*
+ * The rx thread reads the packets waiting on its socket, and a sender sends
+ * the packets that a connection may send, with one recvmmsg()/sendmmsg()
+ * call, where Linux has them.  The packets stay as they are, so the acks and
+ * retransmits work the same.
+ */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define IC_MMSG
+#define UDPIC_RX_BATCH_SIZE		32
+#define UDPIC_TX_BATCH_SIZE		32
+#else
+#define UDPIC_RX_BATCH_SIZE		1
+#define UDPIC_TX_BATCH_SIZE		1
+#endif
+
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN
 #ifndef _WIN32_WINNT
@@ -149,6 +177,14 @@ int
 #define UDPIC_FLAGS_DISORDER    		(32)
 #define UDPIC_FLAGS_DUPLICATE   		(64)
 #define UDPIC_FLAGS_CAPACITY    		(128)
+#define UDPIC_FLAGS_COMPRESSED			(256)
+
+/*
+ * Packets with less data than this are never compressed, nor the packets
+ * compressed to more than 7/8 of their size.
+ */
+#define IC_COMPRESS_MIN_SIZE			(256)
+#define IC_COMPRESS_LEVEL				(1)
 
 /*
  * ConnHtabBin
@@ -325,7 +361,7 @@ struct RxBufferPool
  * maxCount is set to 1 to make sure there is always a buffer
  * for picking packets from OS buffer.
  */
-static RxBufferPool rx_buffer_pool = {1, 0, NULL};
+static RxBufferPool rx_buffer_pool = {UDPIC_RX_BATCH_SIZE, 0, NULL};
 
 /*
  * SendBufferPool
@@ -571,6 +607,20 @@ static int	ICSenderSocket = -1;
 static uint16 ICSenderPort = 0;
 static int	ICSenderFamily = 0;
 
+/*
+ * Unix domain sockets for the peers on the same host, or -1.  Receivers
+ * listen on ICLocalListenerSocket, named after their pid and listener port.
+ * Senders send from ICLocalSenderSocket, named after the address of
+ * ICSenderSocket, which is where receivers send the acks to, as for remote
+ * peers.
+ */
+static int	ICLocalListenerSocket = -1;
+static int	ICLocalSenderSocket = -1;
+
+#define IC_LOCAL_LISTENER_PREFIX	"gpic-r"
+#define IC_LOCAL_SENDER_PREFIX		"gpic-s"
+#define IC_LOCAL_SENDER_PREFIX_LEN	(sizeof(IC_LOCAL_SENDER_PREFIX) - 1)
+
 /*
  * AckSendParam
  *
@@ -660,6 +710,10 @@ static void getSockAddr(struct sockaddr_storage *peer, socklen_t *peer_len, cons
 static void setXmitSocketOptions(int txfd);
 static uint32 setSocketBufferSize(int fd, int type, int expectedSize, int leastSize);
 static void setupUDPListeningSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily);
+static void setupLocalSockets(uint16 listenerPort, int listenerFamily);
+static void getLocalListenerAddr(struct sockaddr_storage *addr, socklen_t *addr_len, int pid, int port);
+static bool isLocalPeer(ChunkTransportStateEntry *pEntry, CdbProcess *cdbProc);
+static bool getLocalSenderAckAddr(struct sockaddr_storage *peer, socklen_t *peer_len);
 static ChunkTransportStateEntry *startOutgoingUDPConnections(ChunkTransportState *transportStates,
 							Slice *sendSlice,
 							int *pOutgoingCount);
@@ -729,6 +783,8 @@ static void checkQDConnectionAlive(void);
 
 
 static void *rxThreadFunc(void *arg);
+static int	receivePackets(int fd, icpkthdr **pkts, int npkts, struct sockaddr_storage *peers, socklen_t *peerlens, int *lens);
+static bool handleRxPacket(int rxfd, icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t *peerlen);
 
 static bool handleMismatch(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len);
 static void handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now);
@@ -739,11 +795,14 @@ static bool handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_st
 static bool handleAckForDuplicatePkt(MotionConn *conn, icpkthdr *pkt);
 static bool handleAckForDisorderPkt(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, icpkthdr *pkt);
 
-static inline void prepareXmit(MotionConn *conn);
+static inline void prepareXmit(MotionConn *conn, bool compress);
+static void compressPacket(icpkthdr *pkt);
+static void decompressPacket(MotionConn *conn);
 static inline void addCRC(icpkthdr *pkt);
 static inline bool checkCRC(icpkthdr *pkt);
 static void sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn);
 static void sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn);
+static void sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, ICBuffer **bufs, int nbufs);
 static inline uint64 computeExpirationPeriod(MotionConn *conn, uint32 retry);
 
 static ICBuffer *getSndBuffer(MotionConn *conn);
@@ -1323,6 +1382,184 @@ error:
 	return;
 }
 
+/*
+ * getLocalListenerAddr
+ * 		Get the address of the local socket of the receiver with the pid and
+ * 		listener port.
+ */
+static void
+getLocalListenerAddr(struct sockaddr_storage *addr, socklen_t *addr_len, int pid, int port)
+{
+#ifdef IC_LOCAL_SOCKETS
+	struct sockaddr_un *un = (struct sockaddr_un *) addr;
+	int			len;
+
+	StaticAssertStmt(sizeof(struct sockaddr_un) <= sizeof(struct sockaddr_storage),
+					 "sockaddr_un doesn't fit in sockaddr_storage");
+
+	MemSet(addr, 0, sizeof(*addr));
+	un->sun_family = AF_UNIX;
+
+	/* the leading NUL of sun_path puts it in the abstract namespace */
+	len = snprintf(un->sun_path + 1, sizeof(un->sun_path) - 1, "%s.%d.%d",
+				   IC_LOCAL_LISTENER_PREFIX, pid, port);
+	*addr_len = offsetof(struct sockaddr_un, sun_path) + 1 + len;
+#else
+	*addr_len = 0;
+#endif
+}
+
+/*
+ * setupLocalSockets
+ * 		Setup the Unix domain sockets for the peers on the same host.
+ *
+ * This is best effort, if the sockets can't be set up, all packets are sent
+ * through UDP.
+ */
+static void
+setupLocalSockets(uint16 listenerPort, int listenerFamily)
+{
+#ifdef IC_LOCAL_SOCKETS
+	struct sockaddr_storage addr;
+	socklen_t	addr_len;
+	struct sockaddr_storage udp_addr;
+	socklen_t	udp_addr_len;
+	struct sockaddr_un *un = (struct sockaddr_un *) &addr;
+	int			fd;
+	int			bufSize;
+
+	/* the socket to receive from the senders on the same host */
+	fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	getLocalListenerAddr(&addr, &addr_len, MyProcPid, listenerPort);
+	if (fd < 0 || !pg_set_noblock(fd) ||
+		bind(fd, (struct sockaddr *) &addr, addr_len) < 0)
+	{
+		elog(DEBUG1, "could not set up local interconnect listener socket: %m");
+		if (fd >= 0)
+			closesocket(fd);
+		return;
+	}
+	bufSize = ic_control_info.socketRecvBufferSize;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (const char *) &bufSize, sizeof(bufSize));
+	ICLocalListenerSocket = fd;
+
+	/*
+	 * The socket to send to the receivers on the same host, named after the
+	 * address of the UDP sender socket.  A wildcard address is replaced by
+	 * the loopback address, for the receivers to send their acks to.
+	 */
+	MemSet(&udp_addr, 0, sizeof(udp_addr));
+	udp_addr_len = sizeof(udp_addr);
+	if (getsockname(ICSenderSocket, (struct sockaddr *) &udp_addr, &udp_addr_len) < 0 ||
+		udp_addr.ss_family != listenerFamily)
+		return;
+
+	if (udp_addr.ss_family == AF_INET)
+	{
+		struct sockaddr_in *in = (struct sockaddr_in *) &udp_addr;
+
+		if (in->sin_addr.s_addr == htonl(INADDR_ANY))
+			in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	}
+#ifdef HAVE_IPV6
+	else if (udp_addr.ss_family == AF_INET6)
+	{
+		struct sockaddr_in6 *in6 = (struct sockaddr_in6 *) &udp_addr;
+
+		if (IN6_IS_ADDR_UNSPECIFIED(&in6->sin6_addr))
+			in6->sin6_addr = in6addr_loopback;
+	}
+#endif
+	else
+		return;
+
+	if (1 + IC_LOCAL_SENDER_PREFIX_LEN + udp_addr_len > sizeof(un->sun_path))
+		return;
+
+	MemSet(&addr, 0, sizeof(addr));
+	un->sun_family = AF_UNIX;
+	memcpy(un->sun_path + 1, IC_LOCAL_SENDER_PREFIX, IC_LOCAL_SENDER_PREFIX_LEN);
+	memcpy(un->sun_path + 1 + IC_LOCAL_SENDER_PREFIX_LEN, &udp_addr, udp_addr_len);
+	addr_len = offsetof(struct sockaddr_un, sun_path) + 1 + IC_LOCAL_SENDER_PREFIX_LEN + udp_addr_len;
+
+	fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (fd < 0 || !pg_set_noblock(fd) ||
+		bind(fd, (struct sockaddr *) &addr, addr_len) < 0)
+	{
+		elog(DEBUG1, "could not set up local interconnect sender socket: %m");
+		if (fd >= 0)
+			closesocket(fd);
+		return;
+	}
+	bufSize = ic_control_info.socketSendBufferSize;
+	setsockopt(fd, SOL_SOCKET, SO_SNDBUF, (const char *) &bufSize, sizeof(bufSize));
+	ICLocalSenderSocket = fd;
+#endif
+}
+
+/*
+ * isLocalPeer
+ * 		Is the receiving process on the same host as we are?
+ *
+ * Processes on the same host have the same listener address, as long as the
+ * segments of the host are configured with the same address.
+ */
+static bool
+isLocalPeer(ChunkTransportStateEntry *pEntry, CdbProcess *cdbProc)
+{
+	ListCell   *cell;
+
+	if (!gp_interconnect_local_sockets || ICLocalSenderSocket < 0 ||
+		cdbProc->listenerAddr == NULL)
+		return false;
+
+	foreach(cell, pEntry->sendSlice->primaryProcesses)
+	{
+		CdbProcess *self = (CdbProcess *) lfirst(cell);
+
+		if (self != NULL && self->pid == MyProcPid)
+			return self->listenerAddr != NULL &&
+				strcmp(self->listenerAddr, cdbProc->listenerAddr) == 0;
+	}
+
+	return false;
+}
+
+/*
+ * getLocalSenderAckAddr
+ * 		Replace the address of a local sender socket with the address of the
+ * 		UDP socket to send the acks to, which is in its name.
+ *
+ * Returns false if it's not the address of a sender socket.  Called by the
+ * rx thread.
+ */
+static bool
+getLocalSenderAckAddr(struct sockaddr_storage *peer, socklen_t *peer_len)
+{
+#ifdef IC_LOCAL_SOCKETS
+	const struct sockaddr_un *un = (const struct sockaddr_un *) peer;
+	struct sockaddr_storage addr;
+	int			name_len = (int) *peer_len - (int) offsetof(struct sockaddr_un, sun_path);
+	int			addr_len = name_len - 1 - (int) IC_LOCAL_SENDER_PREFIX_LEN;
+
+	if (addr_len < (int) sizeof(struct sockaddr_in) || addr_len > (int) sizeof(addr) ||
+		un->sun_path[0] != '\0' ||
+		memcmp(un->sun_path + 1, IC_LOCAL_SENDER_PREFIX, IC_LOCAL_SENDER_PREFIX_LEN) != 0)
+		return false;
+
+	MemSet(&addr, 0, sizeof(addr));
+	memcpy(&addr, un->sun_path + 1 + IC_LOCAL_SENDER_PREFIX_LEN, addr_len);
+	if (addr.ss_family != AF_INET && addr.ss_family != AF_INET6)
+		return false;
+
+	memcpy(peer, &addr, sizeof(addr));
+	*peer_len = addr_len;
+	return true;
+#else
+	return false;
+#endif
+}
+
 /*
  * InitMutex
  * 		Initialize mutex.
@@ -1385,6 +1622,7 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	 */
 	setupUDPListeningSocket(listenerSocketFd, listenerPort, &txFamily);
 	setupUDPListeningSocket(&ICSenderSocket, &ICSenderPort, &ICSenderFamily);
+	setupLocalSockets(*listenerPort, txFamily);
 
 	/* Initialize receive control data. */
 	resetMainThreadWaiting(&rx_control_info.mainWaitingState);
@@ -1395,9 +1633,9 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	rx_control_info.lastTornIcId = 0;
 	initCursorICHistoryTable(&rx_control_info.cursorHistoryTable);
 
-	/* Initialize receive buffer pool */
+	/* Initialize receive buffer pool, with the buffers of the rx thread */
 	rx_buffer_pool.count = 0;
-	rx_buffer_pool.maxCount = 1;
+	rx_buffer_pool.maxCount = UDPIC_RX_BATCH_SIZE;
 	rx_buffer_pool.freeList = NULL;
 
 	/* Initialize send control data */
@@ -1486,6 +1724,13 @@ CleanupMotionUDPIFC(void)
 	ICSenderPort = 0;
 	ICSenderFamily = 0;
 
+	if (ICLocalListenerSocket >= 0)
+		closesocket(ICLocalListenerSocket);
+	ICLocalListenerSocket = -1;
+	if (ICLocalSenderSocket >= 0)
+		closesocket(ICLocalSenderSocket);
+	ICLocalSenderSocket = -1;
+
 #ifdef USE_ASSERT_CHECKING
 
 	/*
@@ -2759,6 +3004,15 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 
 	Assert(conn->peer.ss_family == AF_INET || conn->peer.ss_family == AF_INET6);
 
+	/*
+	 * Data packets to a receiver on the same host go through its Unix domain
+	 * socket, control messages and acks still go through UDP.
+	 */
+	conn->localPeer_len = 0;
+	if (isLocalPeer(pEntry, cdbProc))
+		getLocalListenerAddr(&conn->localPeer, &conn->localPeer_len,
+							 cdbProc->pid, cdbProc->listenerPort);
+
 	{
 #ifdef USE_ASSERT_CHECKING
 		{
@@ -3676,6 +3930,8 @@ receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEn
 
 			pthread_mutex_unlock(&ic_control_info.lock);
 
+			decompressPacket(rxconn);
+
 			elog(DEBUG2, "got data with length %d", rxconn->recvBytes);
 			/* successfully read into this connection's buffer. */
 			tcItem = RecvTupleChunk(rxconn, pTransportStates);
@@ -3819,6 +4075,8 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 	{
 		pthread_mutex_unlock(&ic_control_info.lock);
 
+		decompressPacket(conn);
+
 		tcItem = RecvTupleChunk(conn, transportStates);
 		*srcRoute = conn->route;
 		pEntry->scanStart = index + 1;
@@ -3935,6 +4193,8 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 
 		pthread_mutex_unlock(&ic_control_info.lock);
 
+		decompressPacket(conn);
+
 		TupleChunkListItem tcItem = NULL;
 
 		tcItem = RecvTupleChunk(conn, transportStates);
@@ -4424,12 +4684,146 @@ checkCRC(icpkthdr *pkt)
 }
 
 
+#ifdef HAVE_LIBZSTD
+/*
+ * Compression state for the packets, allocated on first use.  The buffer
+ * holds the compressed or decompressed data of one packet.
+ */
+static ZSTD_CCtx *ic_compress_cxt = NULL;
+static ZSTD_DCtx *ic_decompress_cxt = NULL;
+static char *ic_compress_buf = NULL;
+static size_t ic_compress_buf_size = 0;
+
+static void
+initCompressBuffer(void)
+{
+	if (ic_compress_buf != NULL)
+		return;
+
+	ic_compress_buf_size = ZSTD_compressBound(Gp_max_packet_size);
+	ic_compress_buf = malloc(ic_compress_buf_size);
+	if (ic_compress_buf == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed to allocate the interconnect compression buffer.")));
+}
+#endif
+
+/*
+ * compressPacket
+ * 		Compress the data of the packet in place.
+ *
+ * The packet is left as it is if it doesn't compress well; the receiver
+ * knows a compressed packet by UDPIC_FLAGS_COMPRESSED.
+ */
+static void
+compressPacket(icpkthdr *pkt)
+{
+#ifdef HAVE_LIBZSTD
+	char	   *data = (char *) pkt + sizeof(icpkthdr);
+	size_t		len = pkt->len - sizeof(icpkthdr);
+	size_t		compressed_len;
+
+	if (len < IC_COMPRESS_MIN_SIZE)
+		return;
+
+	if (ic_compress_cxt == NULL)
+	{
+		ic_compress_cxt = ZSTD_createCCtx();
+		if (ic_compress_cxt == NULL)
+			return;
+	}
+	initCompressBuffer();
+
+	compressed_len = ZSTD_compressCCtx(ic_compress_cxt,
+									   ic_compress_buf, ic_compress_buf_size,
+									   data, len,
+									   IC_COMPRESS_LEVEL);
+	if (ZSTD_isError(compressed_len) || compressed_len > len - len / 8)
+		return;
+
+	memcpy(data, ic_compress_buf, compressed_len);
+	pkt->len = sizeof(icpkthdr) + compressed_len;
+	pkt->flags |= UDPIC_FLAGS_COMPRESSED;
+#endif
+}
+
+/*
+ * decompressPacket
+ * 		Decompress the data of the packet about to be read, in place.
+ *
+ * Called by the main thread once the packet is prepared for reading, the rx
+ * thread doesn't touch it anymore.
+ */
+static void
+decompressPacket(MotionConn *conn)
+{
+	icpkthdr   *pkt = (icpkthdr *) conn->pBuff;
+
+	if ((pkt->flags & UDPIC_FLAGS_COMPRESSED) == 0)
+		return;
+
+#ifdef HAVE_LIBZSTD
+	{
+		char	   *data = (char *) pkt + sizeof(icpkthdr);
+		size_t		len = pkt->len - sizeof(icpkthdr);
+		unsigned long long raw_len;
+		size_t		n;
+
+		if (ic_decompress_cxt == NULL)
+		{
+			ic_decompress_cxt = ZSTD_createDCtx();
+			if (ic_decompress_cxt == NULL)
+				ereport(ERROR,
+						(errcode(ERRCODE_OUT_OF_MEMORY),
+						 errmsg("out of memory"),
+						 errdetail("Failed to create the interconnect decompression context.")));
+		}
+		initCompressBuffer();
+
+		raw_len = ZSTD_getFrameContentSize(data, len);
+		if (raw_len == ZSTD_CONTENTSIZE_UNKNOWN ||
+			raw_len == ZSTD_CONTENTSIZE_ERROR ||
+			raw_len > Gp_max_packet_size - sizeof(icpkthdr))
+			ereport(ERROR,
+					(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+					 errmsg("interconnect error: invalid compressed packet"),
+					 errdetail("From process %d, seq %u, length %d.",
+							   pkt->srcPid, pkt->seq, pkt->len)));
+
+		n = ZSTD_decompressDCtx(ic_decompress_cxt,
+								ic_compress_buf, ic_compress_buf_size,
+								data, len);
+		if (ZSTD_isError(n) || n != raw_len)
+			ereport(ERROR,
+					(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+					 errmsg("interconnect error: could not decompress packet"),
+					 errdetail("From process %d, seq %u, length %d: %s",
+							   pkt->srcPid, pkt->seq, pkt->len,
+							   ZSTD_isError(n) ? ZSTD_getErrorName(n) : "unexpected size")));
+
+		memcpy(data, ic_compress_buf, n);
+		pkt->len = sizeof(icpkthdr) + n;
+		pkt->flags &= ~UDPIC_FLAGS_COMPRESSED;
+
+		conn->msgSize = pkt->len;
+		conn->recvBytes = conn->msgSize;
+	}
+#else
+	ereport(ERROR,
+			(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+			 errmsg("interconnect error: received a compressed packet, "
+					"but interconnect compression is not supported by this build")));
+#endif
+}
+
 /*
  * prepareXmit
  * 		Prepare connection for transmit.
  */
 static inline void
-prepareXmit(MotionConn *conn)
+prepareXmit(MotionConn *conn, bool compress)
 {
 	Assert(conn != NULL);
 
@@ -4441,6 +4835,9 @@ prepareXmit(MotionConn *conn)
 	/* increase the sequence no */
 	conn->conn_info.seq++;
 
+	if (compress)
+		compressPacket((icpkthdr *) conn->pBuff);
+
 	if (gp_interconnect_full_crc)
 	{
 		icpkthdr   *pkt = (icpkthdr *) conn->pBuff;
@@ -4469,8 +4866,12 @@ sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
 #endif
 
 xmit_retry:
-	n = sendto(pEntry->txfd, buf->pkt, buf->pkt->len, 0,
-			   (struct sockaddr *) &conn->peer, conn->peer_len);
+	if (conn->localPeer_len > 0)
+		n = sendto(ICLocalSenderSocket, buf->pkt, buf->pkt->len, 0,
+				   (struct sockaddr *) &conn->localPeer, conn->localPeer_len);
+	else
+		n = sendto(pEntry->txfd, buf->pkt, buf->pkt->len, 0,
+				   (struct sockaddr *) &conn->peer, conn->peer_len);
 	if (n < 0)
 	{
 		if (errno == EINTR)
@@ -4479,6 +4880,19 @@ xmit_retry:
 		if (errno == EAGAIN)	/* no space ? not an error. */
 			return;
 
+		/* the receiver has no local socket, fall back to UDP */
+		if (conn->localPeer_len > 0 &&
+			(errno == ECONNREFUSED || errno == ENOENT))
+		{
+			elog(DEBUG1, "local interconnect socket of %s is not available: %m",
+				 conn->remoteHostAndPort);
+			conn->localPeer_len = 0;
+			goto xmit_retry;
+		}
+
+		if (conn->localPeer_len > 0 && errno == ENOBUFS)
+			return;
+
 		/*
 		 * If Linux iptables (nf_conntrack?) drops an outgoing packet, it may
 		 * return an EPERM to the application. This might be simply because of
@@ -4518,6 +4932,89 @@ xmit_retry:
 	return;
 }
 
+/*
+ * sendBatch
+ * 		Send packets of a connection.
+ *
+ * They are sent with as few sendmmsg() calls as possible.  A packet that
+ * sendmmsg() fails to send is left to sendOnce(), which retries it and
+ * handles the error, and so are the ones after it.
+ */
+static void
+sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, ICBuffer **bufs, int nbufs)
+{
+	int			sent = 0;
+
+#ifdef IC_MMSG
+	struct mmsghdr msgs[UDPIC_TX_BATCH_SIZE];
+	struct iovec iovs[UDPIC_TX_BATCH_SIZE];
+	bool		batched = true;
+
+	Assert(nbufs <= UDPIC_TX_BATCH_SIZE);
+
+#ifdef USE_ASSERT_CHECKING
+	/* sendOnce() throws away the packets one at a time */
+	if (gp_udpic_dropxmit_percent > 0)
+		batched = false;
+#endif
+
+	while (batched && nbufs - sent > 1)
+	{
+		int			fd;
+		struct sockaddr *addr;
+		socklen_t	addrlen;
+		int			n = nbufs - sent;
+		int			i;
+
+		if (conn->localPeer_len > 0)
+		{
+			fd = ICLocalSenderSocket;
+			addr = (struct sockaddr *) &conn->localPeer;
+			addrlen = conn->localPeer_len;
+		}
+		else
+		{
+			fd = pEntry->txfd;
+			addr = (struct sockaddr *) &conn->peer;
+			addrlen = conn->peer_len;
+		}
+
+		memset(msgs, 0, n * sizeof(struct mmsghdr));
+		for (i = 0; i < n; i++)
+		{
+			icpkthdr   *pkt = bufs[sent + i]->pkt;
+
+			iovs[i].iov_base = pkt;
+			iovs[i].iov_len = pkt->len;
+			msgs[i].msg_hdr.msg_name = addr;
+			msgs[i].msg_hdr.msg_namelen = addrlen;
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		n = sendmmsg(fd, msgs, n, 0);
+		if (n <= 0)
+			break;
+
+		for (i = 0; i < n; i++)
+		{
+			icpkthdr   *pkt = bufs[sent + i]->pkt;
+
+			if (msgs[i].msg_len != pkt->len && DEBUG1 >= log_min_messages)
+				write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %u) during sendmmsg() call."
+						  "For Remote Connection: contentId=%d at %s", pkt->seq, pkt->len, msgs[i].msg_len,
+						  conn->remoteContentId,
+						  conn->remoteHostAndPort);
+		}
+
+		sent += n;
+	}
+#endif							/* IC_MMSG */
+
+	for (; sent < nbufs; sent++)
+		sendOnce(transportStates, pEntry, bufs[sent], conn);
+}
+
 
 /*
  * handleStopMsgs
@@ -4565,7 +5062,7 @@ handleStopMsgs(ChunkTransportState *transportStates, ChunkTransportStateEntry *p
 			conn->pBuff[conn->msgSize] = 'S';
 			conn->msgSize += 1;
 
-			prepareXmit(conn);
+			prepareXmit(conn, pEntry->compressPackets);
 
 			/* now ready to actually send */
 			if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
@@ -4627,6 +5124,9 @@ handleStopMsgs(ChunkTransportState *transportStates, ChunkTransportStateEntry *p
 static void
 sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn)
 {
+	ICBuffer   *batch[UDPIC_TX_BATCH_SIZE];
+	int			nbatch = 0;
+
 	if (!conn->stillActive)
 		return;
 
@@ -4668,7 +5168,7 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		}
 
 		/*
-		 * Note the place of sendOnce here. If we send before appending it to
+		 * Note the place of sendBatch here. If we send before appending it to
 		 * the unack queue and putting it into unack queue ring, and there is
 		 * a network error occurred in the sendOnce function, error message
 		 * will be output. In the time of error message output, interrupts is
@@ -4679,7 +5179,12 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		updateStats(TPE_DATA_PKT_SEND, conn, buf->pkt);
 #endif
 
-		sendOnce(transportStates, pEntry, buf, conn);
+		batch[nbatch++] = buf;
+		if (nbatch == UDPIC_TX_BATCH_SIZE)
+		{
+			sendBatch(transportStates, pEntry, conn, batch, nbatch);
+			nbatch = 0;
+		}
 		ic_statistics.sndPktNum++;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -4688,6 +5193,9 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 
 		buf->conn->sentSeq = buf->pkt->seq;
 	}
+
+	if (nbatch > 0)
+		sendBatch(transportStates, pEntry, conn, batch, nbatch);
 }
 
 /*
@@ -5316,7 +5824,7 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 
 	if (conn->msgSize + length <= Gp_max_packet_size)
 	{
-		memcpy(conn->pBuff + conn->msgSize, tcItem->chunk_data, tcItem->chunk_length);
+		CopyChunkToBuffer(conn->pBuff + conn->msgSize, tcItem);
 		conn->msgSize += length;
 
 		conn->tupleCount++;
@@ -5330,7 +5838,7 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 
 	/* try to send it */
 
-	prepareXmit(conn);
+	prepareXmit(conn, pEntry->compressPackets);
 
 	icBufferListAppend(&conn->sndQueue, conn->curBuff);
 	sendBuffers(transportStates, pEntry, conn);
@@ -5392,7 +5900,7 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 	conn->msgSize = sizeof(conn->conn_info);
 
 	/* now we can copy the input to the new buffer */
-	memcpy(conn->pBuff + conn->msgSize, tcItem->chunk_data, tcItem->chunk_length);
+	CopyChunkToBuffer(conn->pBuff + conn->msgSize, tcItem);
 	conn->msgSize += length;
 
 	conn->tupleCount++;
@@ -5467,7 +5975,7 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 			if (pEntry->sendingEos)
 				conn->conn_info.flags |= UDPIC_FLAGS_EOS;
 
-			prepareXmit(conn);
+			prepareXmit(conn, pEntry->compressPackets);
 
 			/* place it into the send queue */
 			icBufferListAppend(&conn->sndQueue, conn->curBuff);
@@ -6022,15 +6530,18 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 static void *
 rxThreadFunc(void *arg)
 {
-	icpkthdr   *pkt = NULL;
+	icpkthdr   *pkts[UDPIC_RX_BATCH_SIZE];
+	int			npkts = 0;		/* rx buffers in pkts */
 	bool		skip_poll = false;
 	uint32		expected = 1;
+	int			rxfd = UDP_listenerFd;	/* socket to read next */
 
 	gp_set_thread_sigmasks();
 
 	for (;;)
 	{
-		struct pollfd nfd;
+		struct pollfd nfd[2];
+		int			nfds = 1;
 		int			n;
 
 		/* check shutdown condition */
@@ -6044,14 +6555,21 @@ rxThreadFunc(void *arg)
 			break;
 		}
 
-		/* Try to get a buffer */
-		if (pkt == NULL)
+		/* Try to get buffers for all the packets read at once, at least one */
+		if (npkts < UDPIC_RX_BATCH_SIZE)
 		{
 			pthread_mutex_lock(&ic_control_info.lock);
-			pkt = getRxBuffer(&rx_buffer_pool);
+			while (npkts < UDPIC_RX_BATCH_SIZE)
+			{
+				icpkthdr   *buf = getRxBuffer(&rx_buffer_pool);
+
+				if (buf == NULL)
+					break;
+				pkts[npkts++] = buf;
+			}
 			pthread_mutex_unlock(&ic_control_info.lock);
 
-			if (pkt == NULL)
+			if (npkts == 0)
 			{
 				setRxThreadError(ENOMEM);
 				continue;
@@ -6061,10 +6579,18 @@ rxThreadFunc(void *arg)
 		if (!skip_poll)
 		{
 			/* Do we have inbound traffic to handle ? */
-			nfd.fd = UDP_listenerFd;
-			nfd.events = POLLIN;
+			nfd[0].fd = UDP_listenerFd;
+			nfd[0].events = POLLIN;
+			nfd[0].revents = 0;
+			if (ICLocalListenerSocket >= 0)
+			{
+				nfd[1].fd = ICLocalListenerSocket;
+				nfd[1].events = POLLIN;
+				nfd[1].revents = 0;
+				nfds = 2;
+			}
 
-			n = poll(&nfd, 1, RX_THREAD_POLL_TIMEOUT);
+			n = poll(nfd, nfds, RX_THREAD_POLL_TIMEOUT);
 
 			expected = 1;
 			if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 0))
@@ -6095,22 +6621,28 @@ rxThreadFunc(void *arg)
 
 			if (n == 0)
 				continue;
+
+			/* take turns if both sockets are readable */
+			if (nfds == 1 || nfd[1].revents == 0)
+				rxfd = UDP_listenerFd;
+			else if (nfd[0].revents == 0)
+				rxfd = ICLocalListenerSocket;
+			else
+				rxfd = (rxfd == UDP_listenerFd) ? ICLocalListenerSocket : UDP_listenerFd;
 		}
 
-		if (skip_poll || (n == 1 && (nfd.events & POLLIN)))
 		{
 			/* we've got something interesting to read */
 			/* handle incoming */
 			/* ready to read on our socket */
-			MotionConn *conn = NULL;
-			int			read_count = 0;
+			struct sockaddr_storage peers[UDPIC_RX_BATCH_SIZE];
+			socklen_t	peerlens[UDPIC_RX_BATCH_SIZE];
+			int			read_counts[UDPIC_RX_BATCH_SIZE];
+			int			nread;
+			int			i;
+			int			j;
 
-			struct sockaddr_storage peer;
-			socklen_t	peerlen;
-
-			peerlen = sizeof(peer);
-			read_count = recvfrom(UDP_listenerFd, (char *) pkt, Gp_max_packet_size, 0,
-								  (struct sockaddr *) &peer, &peerlen);
+			nread = receivePackets(rxfd, pkts, npkts, peers, peerlens, read_counts);
 
 			expected = 1;
 			if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 0))
@@ -6122,10 +6654,7 @@ rxThreadFunc(void *arg)
 				break;
 			}
 
-			if (DEBUG5 >= log_min_messages)
-				write_log("received inbound len %d", read_count);
-
-			if (read_count < 0)
+			if (nread < 0)
 			{
 				skip_poll = false;
 
@@ -6146,126 +6675,225 @@ rxThreadFunc(void *arg)
 				continue;
 			}
 
-			if (read_count < sizeof(icpkthdr))
-			{
-				if (DEBUG1 >= log_min_messages)
-					write_log("Interconnect error: short conn receive (%d)", read_count);
-				continue;
-			}
-
 			/*
 			 * when we get a "good" recvfrom() result, we can skip poll()
-			 * until we get a bad one.
+			 * until we get a bad one.  Unless there is the local socket as
+			 * well, which must not starve.
 			 */
-			skip_poll = true;
+			skip_poll = (ICLocalListenerSocket < 0);
 
-			/* length must be >= 0 */
-			if (pkt->len < 0)
+			for (i = 0; i < nread; i++)
 			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound with negative length");
-				continue;
-			}
+				if (DEBUG5 >= log_min_messages)
+					write_log("received inbound len %d", read_counts[i]);
 
-			if (pkt->len != read_count)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
-				continue;
+				if (handleRxPacket(rxfd, pkts[i], read_counts[i], &peers[i], &peerlens[i]))
+					pkts[i] = NULL;
 			}
 
-			/*
-			 * check the CRC of the payload.
-			 */
-			if (gp_interconnect_full_crc)
+			/* keep the buffers that weren't consumed */
+			for (i = 0, j = 0; i < npkts; i++)
 			{
-				if (!checkCRC(pkt))
-				{
-					pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
-					if (DEBUG2 >= log_min_messages)
-						write_log("received network data error, dropping bad packet, user data unaffected.");
-					continue;
-				}
+				if (pkts[i] != NULL)
+					pkts[j++] = pkts[i];
 			}
+			npkts = j;
+		}
 
-#ifdef AMS_VERBOSE_LOGGING
-			logPkt("GOT MESSAGE", pkt);
+		/* pthread_yield(); */
+	}
+
+	/* Before return, we release the packets. */
+	if (npkts > 0)
+	{
+		int			i;
+
+		pthread_mutex_lock(&ic_control_info.lock);
+		for (i = 0; i < npkts; i++)
+			freeRxBuffer(&rx_buffer_pool, pkts[i]);
+		npkts = 0;
+		pthread_mutex_unlock(&ic_control_info.lock);
+	}
+
+	/* nothing to return */
+	return NULL;
+}
+
+/*
+ * receivePackets
+ * 		Read the packets waiting on the socket into the buffers, at most one
+ * 		per buffer. Returns the number read, or -1 with errno set.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ */
+static int
+receivePackets(int fd, icpkthdr **pkts, int npkts, struct sockaddr_storage *peers, socklen_t *peerlens, int *lens)
+{
+#ifdef IC_MMSG
+	struct mmsghdr msgs[UDPIC_RX_BATCH_SIZE];
+	struct iovec iovs[UDPIC_RX_BATCH_SIZE];
+	int			n;
+	int			i;
+
+	memset(msgs, 0, npkts * sizeof(struct mmsghdr));
+	for (i = 0; i < npkts; i++)
+	{
+		iovs[i].iov_base = pkts[i];
+		iovs[i].iov_len = Gp_max_packet_size;
+		msgs[i].msg_hdr.msg_name = &peers[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	n = recvmmsg(fd, msgs, npkts, MSG_DONTWAIT, NULL);
+
+	for (i = 0; i < n; i++)
+	{
+		lens[i] = msgs[i].msg_len;
+		peerlens[i] = msgs[i].msg_hdr.msg_namelen;
+	}
+
+	return n;
+#else
+	peerlens[0] = sizeof(peers[0]);
+	lens[0] = recvfrom(fd, (char *) pkts[0], Gp_max_packet_size, 0,
+					   (struct sockaddr *) &peers[0], &peerlens[0]);
+
+	return (lens[0] < 0) ? -1 : 1;
 #endif
+}
 
-			bool		wakeup_mainthread = false;
-			AckSendParam param;
+/*
+ * handleRxPacket
+ * 		Check a packet read by the rx thread, and hand it to its connection.
+ * 		Returns true if the buffer of the packet was kept.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * elog is NOT thread-safe.  Developers should instead use something like:
+ *
+ *	if (DEBUG3 >= log_min_messages)
+ *		write_log("my brilliant log statement here.");
+ *
+ * NOTE: In threads, we cannot use palloc/pfree, because it's not thread safe.
+ */
+static bool
+handleRxPacket(int rxfd, icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t *peerlen)
+{
+	MotionConn *conn = NULL;
+	bool		consumed = false;
 
-			memset(&param, 0, sizeof(AckSendParam));
+	if (read_count < sizeof(icpkthdr))
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("Interconnect error: short conn receive (%d)", read_count);
+		return false;
+	}
 
-			/*
-			 * Get the connection for the pkt.
-			 *
-			 * The connection hash table should be locked until finishing the
-			 * processing of the packet to avoid the connection
-			 * addition/removal from the hash table during the mean time.
-			 */
+	/*
+	 * Packets from the senders on the same host are acked through
+	 * UDP, at the address in the name of their local socket.
+	 */
+	if (rxfd != UDP_listenerFd && !getLocalSenderAckAddr(peer, peerlen))
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound packet from unknown local socket");
+		return false;
+	}
 
-			pthread_mutex_lock(&ic_control_info.lock);
-			conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+	/* length must be >= 0 */
+	if (pkt->len < 0)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound with negative length");
+		return false;
+	}
 
-			if (conn != NULL)
-			{
-				/* Handling a regular packet */
-				if (handleDataPacket(conn, pkt, &peer, &peerlen, &param, &wakeup_mainthread))
-					pkt = NULL;
-				ic_statistics.recvPktNum++;
-			}
-			else
-			{
-				/*
-				 * There may have two kinds of Mismatched packets: a) Past
-				 * packets from previous command after I was torn down b)
-				 * Future packets from current command before my connections
-				 * are built.
-				 *
-				 * The handling logic is to "Ack the past and Nak the future".
-				 */
-				if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
-				{
-					if (DEBUG1 >= log_min_messages)
-						write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
+	if (pkt->len != read_count)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
+		return false;
+	}
+
+	/*
+	 * check the CRC of the payload.
+	 */
+	if (gp_interconnect_full_crc)
+	{
+		if (!checkCRC(pkt))
+		{
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
+			if (DEBUG2 >= log_min_messages)
+				write_log("received network data error, dropping bad packet, user data unaffected.");
+			return false;
+		}
+	}
 
 #ifdef AMS_VERBOSE_LOGGING
-					logPkt("Got a Mismatched Packet", pkt);
+	logPkt("GOT MESSAGE", pkt);
 #endif
 
-					if (handleMismatch(pkt, &peer, peerlen))
-						pkt = NULL;
-					ic_statistics.mismatchNum++;
-				}
-			}
-			pthread_mutex_unlock(&ic_control_info.lock);
+	bool		wakeup_mainthread = false;
+	AckSendParam param;
 
-			if (wakeup_mainthread)
-				SetLatch(&ic_control_info.latch);
+	memset(&param, 0, sizeof(AckSendParam));
 
-			/*
-			 * real ack sending is after lock release to decrease the lock
-			 * holding time.
-			 */
-			if (param.msg.len != 0)
-				sendAckWithParam(&param);
-		}
+	/*
+	 * Get the connection for the pkt.
+	 *
+	 * The connection hash table should be locked until finishing the
+	 * processing of the packet to avoid the connection
+	 * addition/removal from the hash table during the mean time.
+	 */
 
-		/* pthread_yield(); */
-	}
+	pthread_mutex_lock(&ic_control_info.lock);
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
 
-	/* Before return, we release the packet. */
-	if (pkt)
+	if (conn != NULL)
 	{
-		pthread_mutex_lock(&ic_control_info.lock);
-		freeRxBuffer(&rx_buffer_pool, pkt);
-		pkt = NULL;
-		pthread_mutex_unlock(&ic_control_info.lock);
+		/* Handling a regular packet */
+		if (handleDataPacket(conn, pkt, peer, peerlen, &param, &wakeup_mainthread))
+			consumed = true;
+		ic_statistics.recvPktNum++;
 	}
+	else
+	{
+		/*
+		 * There may have two kinds of Mismatched packets: a) Past
+		 * packets from previous command after I was torn down b)
+		 * Future packets from current command before my connections
+		 * are built.
+		 *
+		 * The handling logic is to "Ack the past and Nak the future".
+		 */
+		if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
+		{
+			if (DEBUG1 >= log_min_messages)
+				write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
 
-	/* nothing to return */
-	return NULL;
+#ifdef AMS_VERBOSE_LOGGING
+			logPkt("Got a Mismatched Packet", pkt);
+#endif
+
+			if (handleMismatch(pkt, peer, *peerlen))
+				consumed = true;
+			ic_statistics.mismatchNum++;
+		}
+	}
+	pthread_mutex_unlock(&ic_control_info.lock);
+
+	if (wakeup_mainthread)
+		SetLatch(&ic_control_info.latch);
+
+	/*
+	 * real ack sending is after lock release to decrease the lock
+	 * holding time.
+	 */
+	if (param.msg.len != 0)
+		sendAckWithParam(&param);
+
+	return consumed;
 }
 
 /*
@@ -53,6 +53,7 @@
 static MemoryContext s_tupSerMemCtxt = NULL;
 
 static void addByteStringToChunkList(TupleChunkList tcList, char *data, int datalen, TupleChunkListCache *cache);
+static void addByteStringRefToChunkList(TupleChunkList tcList, char *data, int datalen, TupleChunkListCache *cache);
 
 #define addCharToChunkList(tcList, x, c)							\
 	do															\
@@ -288,6 +289,57 @@ addByteStringToChunkList(TupleChunkList tcList, char *data, int datalen, TupleCh
 	return;
 }
 
+/*
+ * Like addByteStringToChunkList(), but the chunks that the data fills refer
+ * to it rather than holding a copy, so that it's only copied once, into the
+ * packets.  The data must stay valid until the chunks are sent.  The last
+ * piece is copied, so that padding can follow it.
+ *
+ * The list must have only its first chunk, with no data yet.  The chunks
+ * are the same as addByteStringToChunkList() makes.
+ */
+static void
+addByteStringRefToChunkList(TupleChunkList tcList, char *data, int datalen, TupleChunkListCache *chunkCache)
+{
+	TupleChunkListItem tcItem;
+	int			capacity = tcList->max_chunk_length - TUPLE_CHUNK_HEADER_SIZE;
+
+	AssertArg(tcList != NULL);
+	AssertArg(tcList->p_last != NULL);
+	AssertArg(tcList->p_last->chunk_length == TUPLE_CHUNK_HEADER_SIZE);
+	AssertArg(data != NULL);
+
+	tcItem = tcList->p_last;
+
+	while (datalen > capacity)
+	{
+		tcItem->sendref = data;
+		tcItem->chunk_length = tcList->max_chunk_length;
+		SetChunkDataSize(tcItem->chunk_data, capacity);
+		tcList->serialized_data_length += capacity;
+
+		data += capacity;
+		datalen -= capacity;
+
+		tcItem = getChunkFromCache(chunkCache);
+		if (tcItem == NULL)
+		{
+			ereport(FATAL,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("could not allocate space for new chunk"),
+					 errdetail("%d of %d bytes in %d chunks",
+							   tcList->serialized_data_length,
+							   tcList->serialized_data_length + datalen,
+							   tcList->num_chunks)));
+		}
+		tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
+		SetChunkType(tcItem->chunk_data, TC_PARTIAL_MID);
+		appendChunkToTCList(tcList, tcItem);
+	}
+
+	addByteStringToChunkList(tcList, data, datalen, chunkCache);
+}
+
 typedef struct TupSerHeader
 {
 	uint32		tuplen;
@@ -502,7 +554,14 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 
 		AssertState(s_tupSerMemCtxt != NULL);
 
-		addByteStringToChunkList(tcList, (char *) tuple, memtuple_get_size(tuple), &pSerInfo->chunkCache);
+		/*
+		 * The tuple of the slot is sent from where it is.  One that has been
+		 * re-formed is gone when the context is reset below.
+		 */
+		if (need_toast)
+			addByteStringToChunkList(tcList, (char *) tuple, memtuple_get_size(tuple), &pSerInfo->chunkCache);
+		else
+			addByteStringRefToChunkList(tcList, (char *) tuple, memtuple_get_size(tuple), &pSerInfo->chunkCache);
 		addPadding(tcList, &pSerInfo->chunkCache, memtuple_get_size(tuple));
 
 		MemoryContextReset(s_tupSerMemCtxt);
@@ -1017,6 +1076,19 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 		{
 			uint32		tuplen = memtuple_size_from_uint32(tshp->tuplen);
 
+			if (tuplen > serData.len)
+				ereport(ERROR,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("interconnect error: cannot convert chunks to a memtuple"),
+						 errdetail("Tuple len %u > data len %d", tuplen, serData.len)));
+
+			/*
+			 * A memtuple is sent as it is, so the buffer its chunks were
+			 * reassembled in is the tuple.
+			 */
+			if (serDataMustFree)
+				return (GenericTuple) serData.data;
+
 			tup = (GenericTuple) palloc(tuplen);
 			memcpy(tup, pos, tuplen);
 
@@ -89,19 +89,23 @@ eval_part_qual(ExprContext *econtext, TupleTableSlot *inputTuple, List *qualList
  *		If no such a child partitionRule is found, return NULL.
  *
  *		Input parameters:
+ *		node: PartitionSelectorState
  *		pn: parent PartitionNode
- *		accessMethods: PartitionAccessMethods
- *		root_oid: root table Oid
  *		value: partition key value
  *		exprTypid: type of the expression
  *
+ *		The descriptor of the root table, and the arrays to pass the key
+ *		value in, are set up for the first tuple and kept in the node, so that
+ *		the root table isn't opened again for each tuple in join partition
+ *		elimination.
+ *
  * ----------------------------------------------------------------
  */
 static PartitionRule *
-partition_selection(PartitionNode *pn, PartitionAccessMethods *accessMethods, Oid root_oid, Datum value, Oid exprTypid, bool isNull)
+partition_selection(PartitionSelectorState *node, PartitionNode *pn, Datum value, Oid exprTypid, bool isNull)
 {
 	Assert(NULL != pn);
-	Assert(NULL != accessMethods);
+	Assert(NULL != node->accessMethods);
 	Partition  *part = pn->part;
 
 	Assert(1 == part->parnatts);
@@ -109,25 +113,33 @@ partition_selection(PartitionNode *pn, PartitionAccessMethods *accessMethods, Oi
 
 	Assert(0 < partAttno);
 
-	Relation	rel = relation_open(root_oid, NoLock);
-	TupleDesc	tupDesc = RelationGetDescr(rel);
-
-	Assert(tupDesc->natts >= partAttno);
+	if (NULL == node->rootTupDesc)
+	{
+		PartitionSelector *ps = (PartitionSelector *) node->ps.plan;
+		MemoryContext oldcxt = MemoryContextSwitchTo(node->ps.state->es_query_cxt);
+		Relation	rel = relation_open(ps->relid, NoLock);
+		int			i;
+
+		node->rootTupDesc = CreateTupleDescCopy(RelationGetDescr(rel));
+		node->partKeyValues = palloc0(node->rootTupDesc->natts * sizeof(Datum));
+		node->partKeyIsnull = palloc(node->rootTupDesc->natts * sizeof(bool));
+		for (i = 0; i < node->rootTupDesc->natts; i++)
+			node->partKeyIsnull[i] = true;
+
+		relation_close(rel, NoLock);
+		MemoryContextSwitchTo(oldcxt);
+	}
 
-	int			i;
-	Datum	   *values = palloc0(partAttno * sizeof(Datum));
-	bool	   *isnull = palloc(partAttno * sizeof(bool));
+	Assert(node->rootTupDesc->natts >= partAttno);
 
-	for (i = 0; i < partAttno - 1; i++)
-		isnull[i] = true;
-	isnull[partAttno - 1] = isNull;
-	values[partAttno - 1] = value;
+	node->partKeyIsnull[partAttno - 1] = isNull;
+	node->partKeyValues[partAttno - 1] = value;
 
-	PartitionRule *result = get_next_level_matched_partition(pn, values, isnull, tupDesc, accessMethods, exprTypid);
+	PartitionRule *result = get_next_level_matched_partition(pn, node->partKeyValues, node->partKeyIsnull,
+															 node->rootTupDesc, node->accessMethods, exprTypid);
 
-	pfree(values);
-	pfree(isnull);
-	relation_close(rel, NoLock);
+	/* the other levels may be keyed by another attribute */
+	node->partKeyIsnull[partAttno - 1] = true;
 
 	return result;
 }
@@ -206,9 +218,7 @@ partition_rules_for_equality_predicate(PartitionSelectorState *node, int level,
 	Assert(NULL != node);
 	Assert(NULL != node->ps.plan);
 	Assert(NULL != parentNode);
-	PartitionSelector *ps = (PartitionSelector *) node->ps.plan;
-
-	Assert(level < ps->nLevels);
+	Assert(level < ((PartitionSelector *) node->ps.plan)->nLevels);
 
 	/* evaluate equalityPredicate to get partition identifier value */
 	ExprState  *exprState = (ExprState *) lfirst(list_nth_cell(node->levelEqExprStates, level));
@@ -230,7 +240,7 @@ partition_rules_for_equality_predicate(PartitionSelectorState *node, int level,
 	 */
 	Oid			exprTypid = exprType((Node *) exprState->expr);
 
-	return partition_selection(parentNode, node->accessMethods, ps->relid, value, exprTypid, isNull);
+	return partition_selection(node, parentNode, value, exprTypid, isNull);
 }
 
 /* ----------------------------------------------------------------
@@ -21,7 +21,7 @@ test__BufferedReadInit__IsConsistent(void **state)
 	/*
 	 * Call the function so as to set the above values.
 	 */
-	BufferedReadInit(bufferedRead, memory, memoryLen, maxBufferLen, maxLargeReadLen, relname);
+	BufferedReadInit(bufferedRead, memory, memoryLen, maxBufferLen, maxLargeReadLen, 0, relname);
 	/*
 	 * Check for consistency
 	 */
@@ -50,7 +50,7 @@ test__BufferedReadUseBeforeBuffer__IsNextReadLenZero(void **state)
 	/*
 	 * Initialize the buffer
 	 */
-	BufferedReadInit(bufferedRead, memory, memoryLen, maxBufferLen, maxLargeReadLen, relname);
+	BufferedReadInit(bufferedRead, memory, memoryLen, maxBufferLen, maxLargeReadLen, 0, relname);
 	/*
 	 * filling up the bufferedRead struct
 	 */
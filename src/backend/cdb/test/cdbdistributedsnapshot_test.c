@@ -23,6 +23,7 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 		dslm.minCachedLocalXid = InvalidTransactionId;
 		dslm.maxCachedLocalXid = InvalidTransactionId;
 		dslm.currentLocalXidsCount = 0;
+		dslm.lastCommittedLocalXid = InvalidTransactionId;
 
 		dslm.inProgressMappedLocalXids =
 			(TransactionId*)malloc(5 * sizeof(TransactionId));
@@ -123,15 +124,15 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
 	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
 
-	/* Now lets simulate we got tuple with xid=5 */
+	/* Now lets simulate we got tuple with xid=5, the cache stays sorted */
 	retval = DistributedSnapshotWithLocalMapping_CommittedTest(&dslm, 5, false);
 	assert_true(retval == DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS);
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
 
 	/*
 	 * Lets revalidate that local cache is working and
@@ -143,9 +144,9 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
 
 	/*
 	 * Test where local cache should not be touched, if distributedXid is not
@@ -156,9 +157,17 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
+
+	assert_true(dslm.lastCommittedLocalXid == 15);
+
+	/* The last visible xid is answered without looking it up again */
+	retval = DistributedSnapshotWithLocalMapping_CommittedTest(&dslm, 15, false);
+	assert_true(retval == DISTRIBUTEDSNAPSHOT_COMMITTED_VISIBLE);
+	assert_true(dslm.currentLocalXidsCount == 3);
+	assert_true(dslm.lastCommittedLocalXid == 15);
 
 	free(ds->inProgressXidArray);
 	free(dslm.inProgressMappedLocalXids);
@@ -88,6 +88,7 @@
 #include "catalog/indexing.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_inherits_fn.h"
+#include "catalog/pg_exttable.h"
 #include "catalog/pg_namespace.h"
 #include "commands/dbcommands.h"
 #include "commands/tablecmds.h"
@@ -165,6 +166,9 @@ typedef struct AnlIndexData
 /* Default statistics target (GUC parameter) */
 int			default_statistics_target = 100;
 
+/* Columns to compute the functional dependencies between (GUC parameter) */
+int			gp_statistics_dependency_columns = 16;
+
 /* A few variables that don't seem worth passing around as parameters */
 static MemoryContext anl_context = NULL;
 static BufferAccessStrategy vac_strategy;
@@ -196,10 +200,15 @@ static void update_attstats(Oid relid, bool inh,
 				int natts, VacAttrStats **vacattrstats);
 static Datum std_fetch_func(VacAttrStatsP stats, int rownum, bool *isNull);
 static Datum ind_fetch_func(VacAttrStatsP stats, int rownum, bool *isNull);
+static void compute_dependency_stats(VacAttrStats **vacattrstats,
+						 int attr_cnt, int numrows);
 
 static void analyze_rel_internal(Oid relid, VacuumStmt *vacstmt,
 			bool in_outer_xact, BufferAccessStrategy bstrategy);
 static void acquire_hll_by_query(Relation onerel, int nattrs, VacAttrStats **attrstats, int elevel);
+static int acquire_sample_rows_external(Relation onerel, int elevel,
+										HeapTuple *rows, int targrows,
+										double *totalrows, double *totaldeadrows);
 
 /*
  *	analyze_rel() -- analyze one relation
@@ -369,6 +378,16 @@ analyze_rel_internal(Oid relid, VacuumStmt *vacstmt,
 			return;
 		}
 	}
+	else if (RelationIsExternal(onerel) &&
+			 !GetExtTableEntry(RelationGetRelid(onerel))->iswritable)
+	{
+		/*
+		 * A readable external table is sampled by scanning it, there are no
+		 * blocks to sample.  Keep the size estimate it has.
+		 */
+		acquirefunc = acquire_sample_rows_external;
+		relpages = onerel->rd_rel->relpages;
+	}
 	else
 	{
 		/* No need for a WARNING if we already complained during VACUUM */
@@ -473,6 +492,7 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 	int			save_nestlevel;
 	Bitmapset **colLargeRowIndexes;
 	bool		sample_needed;
+	int64		modcount = -1;
 
 	if (inh)
 		ereport(elevel,
@@ -496,6 +516,16 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 										ALLOCSET_DEFAULT_MAXSIZE);
 	caller_context = MemoryContextSwitchTo(anl_context);
 
+	/*
+	 * For ANALYZE of the root partition to skip a leaf partition until it
+	 * changes, find out how much it has been modified before it is sampled,
+	 * see leaf_parts_changed().
+	 */
+	if (optimizer_analyze_changed_partitions_only && !inh &&
+		vacstmt->va_cols == NIL && Gp_role == GP_ROLE_DISPATCH &&
+		rel_part_status(RelationGetRelid(onerel)) == PART_STATUS_LEAF)
+		modcount = get_leaf_part_modcount(RelationGetRelid(onerel));
+
 	/*
 	 * Switch to the table owner's userid, so that any index functions are run
 	 * as that user.  Also lock down security-restricted operations and
@@ -839,6 +869,12 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 			MemoryContextResetAndDeleteChildren(col_context);
 		}
 
+		if (sample_needed && gp_statistics_dependency_columns > 1)
+		{
+			compute_dependency_stats(vacattrstats, attr_cnt, numrows);
+			MemoryContextResetAndDeleteChildren(col_context);
+		}
+
 		/*
 		 * Datums exceeding WIDTH_THRESHOLD are masked as NULL in the sample, and
 		 * are used as is to evaluate index statistics. It is less likely to have
@@ -950,7 +986,7 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 	 */
 	if (!inh)
 		pgstat_report_analyze(onerel, totalrows, totaldeadrows,
-							  (vacstmt->va_cols == NIL));
+							  (vacstmt->va_cols == NIL), modcount);
 
 	/* If this isn't part of VACUUM ANALYZE, let index AMs do cleanup */
 	if (!(vacstmt->options & VACOPT_VACUUM))
@@ -1835,6 +1871,150 @@ acquire_sample_rows(Relation onerel, int elevel,
 		elog(ERROR, "unsupported table type");
 }
 
+/*
+ * Collect a sample of rows from a readable external table.
+ *
+ * The table is read with a query, like a user would, so that the rows come
+ * from all the segments or gpfdist servers that serve it.  Only
+ * gp_external_analyze_sample_fraction of the rows are read: the scans on the
+ * segments return rows at that rate, and protocols that can, such as s3,
+ * fetch only that part of their data in the first place.  The total row count
+ * is extrapolated from the rows read.
+ */
+static int
+acquire_sample_rows_external(Relation onerel, int elevel,
+							 HeapTuple *rows, int targrows,
+							 double *totalrows, double *totaldeadrows)
+{
+	TupleDesc	tupdesc = RelationGetDescr(onerel);
+	double		fraction = gp_external_analyze_sample_fraction;
+	StringInfoData str;
+	MemoryContext oldcxt;
+	MemoryContext spicxt;
+	SPIPlanPtr	plan;
+	Portal		portal;
+	Datum	   *values;
+	bool	   *nulls;
+	double		rstate;
+	int			numrows = 0;	/* # rows now in reservoir */
+	double		samplerows = 0; /* total # rows collected */
+	double		rowstoskip = -1;	/* -1 means not set yet */
+
+	values = (Datum *) palloc(tupdesc->natts * sizeof(Datum));
+	nulls = (bool *) palloc(tupdesc->natts * sizeof(bool));
+
+	initStringInfo(&str);
+	appendStringInfo(&str, "select * from only %s.%s",
+					 quote_identifier(get_namespace_name(RelationGetNamespace(onerel))),
+					 quote_identifier(RelationGetRelationName(onerel)));
+
+	oldcxt = CurrentMemoryContext;
+
+	if (SPI_OK_CONNECT != SPI_connect())
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("unable to connect to execute internal query")));
+
+	/* SET is dispatched, so the scans on the segments see it */
+	if (fraction < 1.0)
+	{
+		char		setstr[100];
+
+		snprintf(setstr, sizeof(setstr),
+				 "set local gp_external_scan_sample_fraction to %g", fraction);
+		SPI_execute(setstr, false, 0);
+	}
+
+	elog(elevel, "Executing SQL: %s", str.data);
+
+	plan = SPI_prepare(str.data, 0, NULL);
+	if (plan == NULL)
+		elog(ERROR, "SPI_prepare failed: %s", SPI_result_code_string(SPI_result));
+	portal = SPI_cursor_open(NULL, plan, NULL, NULL, false);
+
+	/* Prepare for sampling rows */
+	rstate = anl_init_selection_state(targrows);
+
+	for (;;)
+	{
+		int			i;
+
+		SPI_cursor_fetch(portal, true, 1000);
+		if (SPI_processed == 0)
+			break;
+
+		for (i = 0; i < SPI_processed; i++)
+		{
+			HeapTuple	spitup = SPI_tuptable->vals[i];
+			int			spiattno = 1;
+			int			attno;
+			int			k = -1;
+
+			/* as in acquire_sample_rows_ao */
+			if (numrows < targrows)
+				k = numrows++;
+			else
+			{
+				if (rowstoskip < 0)
+					rowstoskip = anl_get_next_S(samplerows, targrows,
+												&rstate);
+				if (rowstoskip <= 0)
+				{
+					k = (int) (targrows * anl_random_fract());
+					Assert(k >= 0 && k < targrows);
+					heap_freetuple(rows[k]);
+				}
+				rowstoskip -= 1;
+			}
+			samplerows += 1;
+
+			if (k < 0)
+				continue;
+
+			/* "select *" leaves out the dropped columns */
+			for (attno = 0; attno < tupdesc->natts; attno++)
+			{
+				if (tupdesc->attrs[attno]->attisdropped)
+				{
+					values[attno] = (Datum) 0;
+					nulls[attno] = true;
+				}
+				else
+					values[attno] = SPI_getbinval(spitup, SPI_tuptable->tupdesc,
+												  spiattno++, &nulls[attno]);
+			}
+
+			spicxt = MemoryContextSwitchTo(oldcxt);
+			rows[k] = heap_form_tuple(tupdesc, values, nulls);
+			MemoryContextSwitchTo(spicxt);
+		}
+
+		SPI_freetuptable(SPI_tuptable);
+	}
+
+	SPI_cursor_close(portal);
+
+	if (fraction < 1.0)
+		SPI_execute("set local gp_external_scan_sample_fraction to default",
+					false, 0);
+
+	SPI_finish();
+
+	*totalrows = floor(samplerows / fraction + 0.5);
+	*totaldeadrows = 0;
+
+	ereport(elevel,
+			(errmsg("\"%s\": read %.0f rows, %d rows in sample, "
+					"%.0f estimated total rows",
+					RelationGetRelationName(onerel),
+					samplerows, numrows, *totalrows)));
+
+	pfree(values);
+	pfree(nulls);
+
+	return numrows;
+}
+
 /* Select a random value R uniformly distributed in (0 - 1) */
 double
 anl_random_fract(void)
@@ -4378,6 +4558,348 @@ merge_leaf_stats(VacAttrStatsP stats,
 	pfree(heaptupleStats);
 	pfree(relTuples);
 }
+
+/*
+ *	merge_leaf_ndistinct() -- number of distinct values of a column of a
+ *	partitioned table, merged from the HLL counters of its leaf partitions.
+ *
+ *	This lets the planner see the NDV of the root as of the latest ANALYZE of
+ *	each leaf, without the root being analyzed.  The counters of full scans
+ *	merge into the NDV directly, those of samples only tell that all the
+ *	values are distinct.  Returns -1 if the NDV can't be merged, e.g. because
+ *	a leaf that has rows has no counter.  Otherwise *nullfrac and *width are
+ *	set to the averages over the leaves as well.
+ */
+double
+merge_leaf_ndistinct(Oid rootOid, AttrNumber attnum, float4 *nullfrac,
+					 int32 *width)
+{
+	PartitionNode *pn;
+	List	   *oid_list;
+	ListCell   *lc;
+	char	   *attname;
+	GpHLLCounter finalHLL = NULL;
+	GpHLLCounter finalHLLFull = NULL;
+	int			fullhll_count = 0;
+	int			samplehll_count = 0;
+	double		sampleCount = 0;
+	double		totalTuples = 0;
+	double		nullCount = 0;
+	double		totalWidth = 0;
+	double		ndistinct = -1;
+	bool		complete = true;
+
+	pn = get_parts(rootOid, 0 /* level */ , 0 /* parent */ ,
+				   false /* inctemplate */ , true /* includesubparts */ );
+	if (pn == NULL)
+		return -1;
+
+	attname = get_relid_attribute_name(rootOid, attnum);
+	oid_list = all_leaf_partition_relids(pn);
+
+	foreach(lc, oid_list)
+	{
+		Oid			relid = lfirst_oid(lc);
+		AttrNumber	child_attno = get_attnum(relid, attname);
+		double		reltuples = get_rel_reltuples(relid);
+		HeapTuple	statsTuple;
+		AttStatsSlot hllSlot;
+
+		if (reltuples <= 0)
+			continue;
+
+		statsTuple = get_att_stats(relid, child_attno);
+		if (!HeapTupleIsValid(statsTuple))
+		{
+			complete = false;
+			break;
+		}
+
+		totalTuples += reltuples;
+		nullCount += ((Form_pg_statistic) GETSTRUCT(statsTuple))->stanullfrac * reltuples;
+		totalWidth += ((Form_pg_statistic) GETSTRUCT(statsTuple))->stawidth * reltuples;
+
+		if (get_attstatsslot(&hllSlot, statsTuple, STATISTIC_KIND_FULLHLL,
+							 InvalidOid, ATTSTATSSLOT_VALUES) &&
+			hllSlot.nvalues > 0)
+		{
+			GpHLLCounter merged;
+
+			merged = gp_hyperloglog_merge_counters(finalHLLFull,
+												   (GpHLLCounter) DatumGetByteaP(hllSlot.values[0]));
+			if (finalHLLFull != NULL)
+				pfree(finalHLLFull);
+			finalHLLFull = merged;
+			fullhll_count++;
+		}
+		else if (get_attstatsslot(&hllSlot, statsTuple, STATISTIC_KIND_HLL,
+								  InvalidOid, ATTSTATSSLOT_VALUES) &&
+				 hllSlot.nvalues > 0)
+		{
+			GpHLLCounter hllcounter = (GpHLLCounter) DatumGetByteaP(hllSlot.values[0]);
+			GpHLLCounter merged;
+
+			sampleCount += hllcounter->samplerows;
+			merged = gp_hyperloglog_merge_counters(finalHLL, hllcounter);
+			if (finalHLL != NULL)
+				pfree(finalHLL);
+			finalHLL = merged;
+			samplehll_count++;
+		}
+		else
+			complete = false;
+
+		free_attstatsslot(&hllSlot);
+		heap_freetuple(statsTuple);
+
+		if (!complete)
+			break;
+	}
+
+	if (complete && totalTuples > 0)
+	{
+		if (samplehll_count == 0 && finalHLLFull != NULL)
+			ndistinct = gp_hyperloglog_estimate(finalHLLFull);
+		else if (fullhll_count == 0 && finalHLL != NULL && sampleCount > 0)
+		{
+			double		sampleDistinct = gp_hyperloglog_estimate(finalHLL);
+
+			if (fabs(sampleCount - sampleDistinct) / sampleCount < GP_HLL_ERROR_MARGIN)
+				ndistinct = totalTuples * (1.0 - nullCount / totalTuples);
+		}
+
+		if (ndistinct >= 0)
+		{
+			*nullfrac = (float4) (nullCount / totalTuples);
+			*width = (int32) (totalWidth / totalTuples);
+		}
+	}
+
+	if (finalHLLFull != NULL)
+		pfree(finalHLLFull);
+	if (finalHLL != NULL)
+		pfree(finalHLL);
+
+	return ndistinct;
+}
+
+/*
+ * qsort_arg comparator for sorting ScalarItems by value only
+ */
+static int
+compare_dependency_values(const void *a, const void *b, void *arg)
+{
+	return ApplySortComparator(((const ScalarItem *) a)->value, false,
+							   ((const ScalarItem *) b)->value, false,
+							   (SortSupport) arg);
+}
+
+/*
+ * qsort comparator for sorting the keys of dependency_degree()
+ */
+static int
+compare_dependency_keys(const void *a, const void *b)
+{
+	uint64		ka = *(const uint64 *) a;
+	uint64		kb = *(const uint64 *) b;
+
+	if (ka < kb)
+		return -1;
+	if (ka > kb)
+		return 1;
+	return 0;
+}
+
+/*
+ * Number the distinct values of a column in the sample: return the number of
+ * the group of equal values each sample row is in, 0 for NULLs.
+ */
+static uint32 *
+dependency_group_ids(VacAttrStats *stats, int numrows)
+{
+	StdAnalyzeData *mystats = (StdAnalyzeData *) stats->extra_data;
+	ScalarItem *values;
+	uint32	   *ids;
+	SortSupportData ssup;
+	int			nvalues = 0;
+	uint32		id = 0;
+	int			i;
+
+	ids = (uint32 *) palloc0(numrows * sizeof(uint32));
+	values = (ScalarItem *) palloc(numrows * sizeof(ScalarItem));
+
+	for (i = 0; i < numrows; i++)
+	{
+		bool		isnull;
+		Datum		value = std_fetch_func(stats, i, &isnull);
+
+		if (isnull)
+			continue;
+		values[nvalues].value = value;
+		values[nvalues].tupno = i;
+		nvalues++;
+	}
+
+	memset(&ssup, 0, sizeof(ssup));
+	ssup.ssup_cxt = CurrentMemoryContext;
+	/* We always use the default collation for statistics */
+	ssup.ssup_collation = DEFAULT_COLLATION_OID;
+	ssup.ssup_nulls_first = false;
+
+	PrepareSortSupportFromOrderingOp(mystats->ltopr, &ssup);
+
+	qsort_arg((void *) values, nvalues, sizeof(ScalarItem),
+			  compare_dependency_values, (void *) &ssup);
+
+	for (i = 0; i < nvalues; i++)
+	{
+		if (i == 0 ||
+			ApplySortComparator(values[i - 1].value, false,
+								values[i].value, false, &ssup) != 0)
+			id++;
+		ids[values[i].tupno] = id;
+	}
+
+	pfree(values);
+
+	return ids;
+}
+
+/*
+ * The degree of the dependency of a column on another one, given the group
+ * numbers of their values in the sample rows: the fraction of the rows in
+ * groups of equal values of the first column that all have the same value of
+ * the second.  keys is an array of numrows to work in.
+ */
+static float4
+dependency_degree(uint32 *groups_a, uint32 *groups_b, uint64 *keys,
+				  int numrows)
+{
+	int			supporting = 0;
+	int			start;
+	int			i;
+
+	for (i = 0; i < numrows; i++)
+		keys[i] = ((uint64) groups_a[i] << 32) | groups_b[i];
+
+	qsort(keys, numrows, sizeof(uint64), compare_dependency_keys);
+
+	for (start = 0; start < numrows; start = i)
+	{
+		bool		consistent = true;
+
+		for (i = start + 1; i < numrows && (keys[i] >> 32) == (keys[start] >> 32); i++)
+		{
+			if (keys[i] != keys[start])
+				consistent = false;
+		}
+
+		if (consistent)
+			supporting += i - start;
+	}
+
+	return (float4) supporting / numrows;
+}
+
+/*
+ *	compute_dependency_stats() -- compute the functional dependencies between
+ *	the columns of the sample
+ *
+ *	The degree of the dependency of column b on column a is the fraction of
+ *	the sample rows in groups of equal values of a that all have the same
+ *	value of b; it's 1 if a determines b.  A STATISTIC_KIND_DEPENDENCY slot
+ *	in the statistics of a stores the degrees of the dependencies of the other
+ *	columns on it, so that the optimizer can tell correlated filters from
+ *	independent ones.
+ *
+ *	Each pair of columns costs a sort of the sample, so only the first
+ *	gp_statistics_dependency_columns columns with scalar statistics and a
+ *	free slot are looked at.
+ */
+static void
+compute_dependency_stats(VacAttrStats **vacattrstats, int attr_cnt,
+						 int numrows)
+{
+	VacAttrStats **columns;
+	int		   *slots;
+	uint32	  **groups;
+	uint64	   *keys;
+	int			ncolumns = 0;
+	int			a,
+				b,
+				i;
+
+	if (numrows <= 0)
+		return;
+
+	columns = (VacAttrStats **) palloc(attr_cnt * sizeof(VacAttrStats *));
+	slots = (int *) palloc(attr_cnt * sizeof(int));
+	groups = (uint32 **) palloc(attr_cnt * sizeof(uint32 *));
+
+	for (i = 0; i < attr_cnt && ncolumns < gp_statistics_dependency_columns; i++)
+	{
+		VacAttrStats *stats = vacattrstats[i];
+		int			k;
+
+		if (!stats->stats_valid || stats->compute_stats != compute_scalar_stats)
+			continue;
+
+		for (k = 0; k < STATISTIC_NUM_SLOTS; k++)
+		{
+			if (stats->stakind[k] == 0)
+				break;
+		}
+		if (k == STATISTIC_NUM_SLOTS)
+			continue;
+
+		columns[ncolumns] = stats;
+		slots[ncolumns] = k;
+		groups[ncolumns] = dependency_group_ids(stats, numrows);
+		ncolumns++;
+	}
+
+	if (ncolumns < 2)
+		return;
+
+	keys = (uint64 *) palloc(numrows * sizeof(uint64));
+
+	for (a = 0; a < ncolumns; a++)
+	{
+		VacAttrStats *stats = columns[a];
+		int			k = slots[a];
+		MemoryContext old_context;
+		Datum	   *attnums;
+		float4	   *degrees;
+		int			n = 0;
+
+		old_context = MemoryContextSwitchTo(stats->anl_context);
+		attnums = (Datum *) palloc((ncolumns - 1) * sizeof(Datum));
+		degrees = (float4 *) palloc((ncolumns - 1) * sizeof(float4));
+		MemoryContextSwitchTo(old_context);
+
+		for (b = 0; b < ncolumns; b++)
+		{
+			if (b == a)
+				continue;
+
+			attnums[n] = Int16GetDatum(columns[b]->attr->attnum);
+			degrees[n] = dependency_degree(groups[a], groups[b], keys, numrows);
+			n++;
+		}
+
+		stats->stakind[k] = STATISTIC_KIND_DEPENDENCY;
+		stats->staop[k] = InvalidOid;
+		stats->stanumbers[k] = degrees;
+		stats->numnumbers[k] = n;
+		stats->stavalues[k] = attnums;
+		stats->numvalues[k] = n;
+		stats->statypid[k] = INT2OID;
+		stats->statyplen[k] = sizeof(int16);
+		stats->statypbyval[k] = true;
+		stats->statypalign[k] = 's';
+	}
+}
+
 /*
  * qsort_arg comparator for sorting ScalarItems
  *
@@ -1,6 +1,7 @@
 #include "postgres.h"
 
 #include "access/aocssegfiles.h"
+#include "access/aosegfiles.h"
 #include "access/tuptoaster.h"
 #include "catalog/pg_appendonly_fn.h"
 #include "catalog/pg_type.h"
@@ -8,6 +9,7 @@
 #include "cdb/cdbaocsam.h"
 #include "cdb/cdbvars.h"
 #include "commands/vacuum.h"
+#include "pgstat.h"
 #include "storage/bufmgr.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
@@ -400,3 +402,81 @@ gp_acquire_sample_rows_col_type(Oid typid)
 	}
 	return typid;
 }
+
+/*
+ * gp_relation_modcount - count the modifications of a table on this segment.
+ *
+ * ANALYZE of a partitioned table uses it to skip the leaf partitions that
+ * haven't changed since they were last analyzed, see leaf_parts_changed().
+ * The count only needs to change whenever the table does, it is never reset:
+ *
+ * - for an append-only table, it's the sum of the modcounts of its segment
+ *   files, which every INSERT, UPDATE and DELETE increment.
+ * - for a heap table, it's the number of tuples inserted, updated and
+ *   deleted, according to the stats collector.  NULL if it isn't counting.
+ *
+ * The relfilenode is added to it, for a TRUNCATE or a rewrite of the table
+ * to change it too.  Other kinds of tables return NULL, they are considered
+ * changed.
+ */
+Datum
+gp_relation_modcount(PG_FUNCTION_ARGS)
+{
+	Oid			relOid = PG_GETARG_OID(0);
+	Relation	onerel;
+	int64		modcount = 0;
+	int			totalsegs;
+	int			i;
+
+	onerel = try_relation_open(relOid, AccessShareLock, false);
+	if (!onerel)
+		PG_RETURN_NULL();
+
+	if (RelationIsAoRows(onerel))
+	{
+		FileSegInfo **allseg;
+
+		allseg = GetAllFileSegInfo(onerel, GetActiveSnapshot(), &totalsegs);
+		for (i = 0; i < totalsegs; i++)
+			modcount += allseg[i]->modcount;
+		if (allseg)
+		{
+			FreeAllSegFileInfo(allseg, totalsegs);
+			pfree(allseg);
+		}
+	}
+	else if (RelationIsAoCols(onerel))
+	{
+		AOCSFileSegInfo **allseg;
+
+		allseg = GetAllAOCSFileSegInfo(onerel, GetActiveSnapshot(), &totalsegs);
+		for (i = 0; i < totalsegs; i++)
+			modcount += allseg[i]->modcount;
+		if (allseg)
+		{
+			FreeAllAOCSSegFileInfo(allseg, totalsegs);
+			pfree(allseg);
+		}
+	}
+	else if (RelationIsHeap(onerel) && pgstat_track_counts)
+	{
+		PgStat_StatTabEntry *tabentry;
+
+		tabentry = pgstat_fetch_stat_tabentry(relOid);
+		if (tabentry)
+			modcount = tabentry->tuples_inserted +
+				tabentry->tuples_updated +
+				tabentry->tuples_deleted;
+	}
+	else
+	{
+		relation_close(onerel, AccessShareLock);
+		PG_RETURN_NULL();
+	}
+
+	modcount += onerel->rd_node.relNode;
+
+	relation_close(onerel, AccessShareLock);
+
+	PG_RETURN_INT64(modcount);
+}
@@ -11,17 +11,25 @@
 #include "postgres.h"
 
 #include "access/heapam.h"
+#include "access/htup_details.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_statistic.h"
+#include "cdb/cdbdisp_query.h"
+#include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbhash.h"
 #include "cdb/cdbpartition.h"
+#include "cdb/cdbvars.h"
 #include "commands/analyzeutils.h"
 #include "commands/vacuum.h"
 #include "lib/binaryheap.h"
+#include "lib/stringinfo.h"
+#include "libpq-fe.h"
 #include "miscadmin.h"
 #include "parser/parse_oper.h"
+#include "pgstat.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
+#include "utils/int8.h"
 #include "utils/lsyscache.h"
 #include "utils/syscache.h"
 #include "utils/hsearch.h"
@@ -1128,3 +1136,213 @@ leaf_parts_analyzed(Oid attrelid, Oid relid_exclude, List *va_cols, int elevel)
 
 	return !all_parts_empty;
 }
+
+/*
+ * Get the modification counts of tables from the segments, summed over them,
+ * see gp_relation_modcount().  -1 for the tables a segment doesn't know it
+ * for.
+ */
+static void
+get_relation_modcounts(Oid *relids, int nrels, int64 *modcounts)
+{
+	CdbPgResults cdb_pgresults = {NULL, 0};
+	StringInfoData sql;
+	bool	   *unknown;
+	int			i;
+	int			j;
+
+	Assert(Gp_role == GP_ROLE_DISPATCH);
+
+	initStringInfo(&sql);
+	appendStringInfoString(&sql, "select n, pg_catalog.gp_relation_modcount(relid) "
+						   "from pg_catalog.unnest('{");
+	for (i = 0; i < nrels; i++)
+		appendStringInfo(&sql, "%s%u", (i > 0) ? "," : "", relids[i]);
+	appendStringInfoString(&sql, "}'::pg_catalog.oid[]) with ordinality u(relid, n)");
+
+	CdbDispatchCommand(sql.data, DF_WITH_SNAPSHOT, &cdb_pgresults);
+
+	unknown = (bool *) palloc0(nrels * sizeof(bool));
+	memset(modcounts, 0, nrels * sizeof(int64));
+
+	for (i = 0; i < cdb_pgresults.numResults; i++)
+	{
+		struct pg_result *pgresult = cdb_pgresults.pg_results[i];
+
+		if (PQresultStatus(pgresult) != PGRES_TUPLES_OK)
+		{
+			cdbdisp_clearCdbPgResults(&cdb_pgresults);
+			ereport(ERROR,
+					(errmsg("unexpected result from segment: %d",
+							PQresultStatus(pgresult))));
+		}
+		if (PQntuples(pgresult) != nrels || PQnfields(pgresult) != 2)
+		{
+			cdbdisp_clearCdbPgResults(&cdb_pgresults);
+			ereport(ERROR,
+					(errmsg("unexpected shape of result from segment (%d rows, %d cols)",
+							PQntuples(pgresult), PQnfields(pgresult))));
+		}
+
+		for (j = 0; j < nrels; j++)
+		{
+			int			rel = atoi(PQgetvalue(pgresult, j, 0)) - 1;
+
+			if (rel < 0 || rel >= nrels)
+			{
+				cdbdisp_clearCdbPgResults(&cdb_pgresults);
+				ereport(ERROR,
+						(errmsg("unexpected table number from segment: %d",
+								rel + 1)));
+			}
+
+			if (PQgetisnull(pgresult, j, 1))
+				unknown[rel] = true;
+			else
+				modcounts[rel] += DatumGetInt64(DirectFunctionCall1(int8in,
+										CStringGetDatum(PQgetvalue(pgresult, j, 1))));
+		}
+	}
+
+	cdbdisp_clearCdbPgResults(&cdb_pgresults);
+
+	for (i = 0; i < nrels; i++)
+	{
+		if (unknown[i])
+			modcounts[i] = -1;
+	}
+
+	pfree(unknown);
+	pfree(sql.data);
+}
+
+/*
+ * get_leaf_part_modcount
+ *   Get the modification count of a leaf partition from the segments, summed
+ *   over them.  -1 if it is unknown.
+ *
+ *   ANALYZE records it with the statistics of the leaf partition, for
+ *   leaf_parts_changed() to skip it as long as it hasn't changed.
+ */
+int64
+get_leaf_part_modcount(Oid relid)
+{
+	int64		modcount;
+
+	get_relation_modcounts(&relid, 1, &modcount);
+
+	return modcount;
+}
+
+/*
+ * Are there statistics for all the columns of a leaf partition that ANALYZE is
+ * asked to analyze, va_cols being their names, NIL for all of them?
+ */
+static bool
+leaf_part_has_stats(Oid relid, List *va_cols)
+{
+	AttrNumber	natts = get_relnatts(relid);
+	AttrNumber	attnum;
+	ListCell   *lc;
+
+	if (va_cols != NIL)
+	{
+		foreach(lc, va_cols)
+		{
+			attnum = get_attnum(relid, strVal(lfirst(lc)));
+
+			if (attnum == InvalidAttrNumber ||
+				!SearchSysCacheExists3(STATRELATTINH,
+									   ObjectIdGetDatum(relid),
+									   Int16GetDatum(attnum),
+									   BoolGetDatum(false)))
+				return false;
+		}
+		return true;
+	}
+
+	for (attnum = 1; attnum <= natts; attnum++)
+	{
+		HeapTuple	attTuple;
+		Form_pg_attribute attr;
+		bool		analyzed;
+
+		attTuple = SearchSysCache2(ATTNUM,
+								   ObjectIdGetDatum(relid),
+								   Int16GetDatum(attnum));
+		if (!HeapTupleIsValid(attTuple))
+			return false;
+		attr = (Form_pg_attribute) GETSTRUCT(attTuple);
+
+		/* as in examine_attribute(), these columns never have statistics */
+		analyzed = (attr->attisdropped || attr->attstattarget == 0 ||
+					SearchSysCacheExists3(STATRELATTINH,
+										  ObjectIdGetDatum(relid),
+										  Int16GetDatum(attnum),
+										  BoolGetDatum(false)));
+		ReleaseSysCache(attTuple);
+
+		if (!analyzed)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * leaf_parts_changed
+ *   Leave out the leaf partitions that haven't changed since ANALYZE last
+ *   collected the statistics of all their columns.
+ *
+ *   Their statistics are still up to date, and the root partition can merge
+ *   them with the statistics of the other leaf partitions.  Whether a leaf
+ *   partition has changed is told by the modification count the segments have
+ *   for it, which ANALYZE records in the stats collector. A leaf partition the
+ *   count is unknown for is considered changed.
+ *   va_cols - names of the columns to be analyzed, NIL for all of them.
+ */
+List *
+leaf_parts_changed(List *leaf_oids, List *va_cols, int elevel)
+{
+	List	   *result = NIL;
+	Oid		   *relids;
+	int64	   *modcounts;
+	int			nrels = list_length(leaf_oids);
+	int			i;
+	ListCell   *lc;
+
+	/* ANALYZE can't have recorded the modification counts */
+	if (nrels == 0 || !pgstat_track_counts || Gp_role != GP_ROLE_DISPATCH)
+		return leaf_oids;
+
+	relids = (Oid *) palloc(nrels * sizeof(Oid));
+	modcounts = (int64 *) palloc(nrels * sizeof(int64));
+
+	i = 0;
+	foreach(lc, leaf_oids)
+		relids[i++] = lfirst_oid(lc);
+
+	get_relation_modcounts(relids, nrels, modcounts);
+
+	for (i = 0; i < nrels; i++)
+	{
+		PgStat_StatTabEntry *tabentry = pgstat_fetch_stat_tabentry(relids[i]);
+
+		if (modcounts[i] >= 0 && tabentry != NULL &&
+			tabentry->analyze_modcount == modcounts[i] &&
+			leaf_part_has_stats(relids[i], va_cols))
+		{
+			ereport(elevel,
+					(errmsg("skipping \"%s\" --- not changed since it was last analyzed",
+							get_rel_name(relids[i]))));
+			continue;
+		}
+
+		result = lappend_oid(result, relids[i]);
+	}
+
+	pfree(relids);
+	pfree(modcounts);
+
+	return result;
+}
@@ -220,6 +220,7 @@ static void CopyInitDataParser(CopyState cstate);
 static void setEncodingConversionProc(CopyState cstate, int encoding, bool iswritable);
 
 static GpDistributionData *InitDistributionData(CopyState cstate, EState *estate);
+static void InitQEInputFlags(CopyState cstate, GpPolicy *policy);
 static void FreeDistributionData(GpDistributionData *distData);
 static GpDistributionData *GetDistributionPolicyForPartition(CopyState cstate,
 								  EState *estate,
@@ -3704,6 +3705,18 @@ CopyFrom(CopyState cstate)
 		cstate->dispatch_msgbuf = makeStringInfo();
 		enlargeStringInfo(cstate->dispatch_msgbuf, sizeof(copy_from_dispatch_row));
 
+		/*
+		 * The QD only needs the values of the distribution key columns, to
+		 * compute the target segment. Leave the input functions of the other
+		 * columns to the QEs, so that they are run in parallel rather than
+		 * all in the QD. Not with partitioned tables, which need the values
+		 * of the partitioning key and of mapped columns too, and not with
+		 * single row error handling, which only the QD does for data errors.
+		 */
+		if (gp_enable_segment_copy_parsing && !cstate->binary &&
+			!estate->es_result_partitions && !cstate->cdbsreh)
+			InitQEInputFlags(cstate, distData->policy);
+
 		/*
 		 * prepare to COPY data into segDBs:
 		 * - set table partitioning information
@@ -5066,6 +5079,18 @@ NextCopyFromX(CopyState cstate, ExprContext *econtext,
 				}
 			}
 
+			if (string != NULL && cstate->qe_input_flags &&
+				cstate->qe_input_flags[m])
+			{
+				/*
+				 * The QE runs the input function, pass on the string, see
+				 * SendCopyFromForwardedTuple().
+				 */
+				values[m] = CStringGetDatum(string);
+				nulls[m] = false;
+				continue;
+			}
+
 			cstate->cur_attname = NameStr(attr[m]->attname);
 			cstate->cur_attval = string;
 			values[m] = InputFunctionCall(&in_functions[m],
@@ -5197,14 +5222,13 @@ NextCopyFromDispatch(CopyState cstate, ExprContext *econtext,
 					 Datum *values, bool *nulls, Oid *tupleOid)
 {
 	/*
-	 * GPDB_91_MERGE_FIXME: The idea here would be to only call the
-	 * input function for the fields we need in the QD. But for now,
-	 * screw performance.
+	 * Only the input functions of the fields we need in the QD are called
+	 * here, if cstate->qe_input_flags is set; the QEs call the others.
 	 *
 	 * Note: There used to be code in InitDistributionData(), to compute
 	 * the last field number that's needed for to determine which partition
-	 * a row belongs to. If you resurrect this optimization, you'll probably
-	 * need to resurrect that, too.
+	 * a row belongs to. If you extend this optimization to partitioned
+	 * tables, you'll probably need to resurrect that, too.
 	 */
 	return NextCopyFrom(cstate, econtext, values, nulls, tupleOid);
 }
@@ -5325,6 +5349,41 @@ retry:
 			ereport(ERROR,
 					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
 					 errmsg("unexpected EOF in COPY data")));
+		if (attnum < 0 && -attnum <= num_phys_attrs)
+		{
+			char	   *p;
+
+			/*
+			 * The QD left the input function of this column to us, see
+			 * SendCopyFromForwardedTuple().
+			 */
+			m = -attnum - 1;
+			cstate->cur_attname = NameStr(attr[m]->attname);
+
+			if (CopyGetData(cstate, &len, sizeof(len)) != sizeof(len))
+				ereport(ERROR,
+						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+						 errmsg("unexpected EOF in COPY data")));
+			if (len < 0)
+				elog(ERROR, "invalid input string length received from QD: %d", len);
+			p = palloc(len + 1);
+			if (CopyGetData(cstate, p, len) != len)
+				ereport(ERROR,
+						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+						 errmsg("unexpected EOF in COPY data")));
+			p[len] = '\0';
+
+			cstate->cur_attval = p;
+			values[m] = InputFunctionCall(&cstate->in_functions[m],
+										  p,
+										  cstate->typioparams[m],
+										  attr[m]->atttypmod);
+			nulls[m] = false;
+			cstate->cur_attname = NULL;
+			cstate->cur_attval = NULL;
+			continue;
+		}
+
 		if (attnum < 1 || attnum > num_phys_attrs)
 			elog(ERROR, "invalid attnum received from QD: %d", attnum);
 		m = attnum - 1;
@@ -5538,6 +5597,33 @@ SendCopyFromForwardedTuple(CopyState cstate,
 		if (nulls[i])
 			continue;
 
+		/*
+		 * The input string of a column whose input function is run in the
+		 * QE. It is sent like a cstring, with the attribute number negated.
+		 */
+		if (cstate->qe_input_flags && cstate->qe_input_flags[i])
+		{
+			int16		rawattnum = -attnum;
+			char	   *ptr = DatumGetCString(values[i]);
+			size_t		slen = strlen(ptr);
+			int32		len;
+
+			if (slen > PG_INT32_MAX)
+			{
+				elog(ERROR, "attribute %d is too long (%lld bytes)",
+					 attnum, (long long) slen);
+			}
+			len = (int32) slen;
+
+			ENLARGE_MSGBUF(msgbuf, sizeof(int16) + sizeof(int32));
+			APPEND_MSGBUF_NOCHECK(msgbuf, &rawattnum, sizeof(int16));
+			APPEND_MSGBUF_NOCHECK(msgbuf, &len, sizeof(int32));
+			APPEND_MSGBUF(msgbuf, ptr, len);
+
+			num_sent_fields++;
+			continue;
+		}
+
 		/*
 		 * Make sure we have room for the attribute number. While we're at it,
 		 * also reserve room for the Datum, if it's a by-value datatype, or for
@@ -7233,6 +7319,34 @@ InitDistributionData(CopyState cstate, EState *estate)
 	return distData;
 }
 
+/*
+ * Mark the columns whose input function can be run in the QE, rather than in
+ * the QD: the ones read from the input that are not distribution key
+ * columns.
+ */
+static void
+InitQEInputFlags(CopyState cstate, GpPolicy *policy)
+{
+	int			num_phys_attrs = RelationGetDescr(cstate->rel)->natts;
+	ListCell   *cur;
+	int			i;
+
+	/* rows of tables that are not on the segments are stored in the QD */
+	if (policy == NULL || GpPolicyIsEntry(policy))
+		return;
+
+	cstate->qe_input_flags = (bool *) palloc0(num_phys_attrs * sizeof(bool));
+
+	foreach(cur, cstate->attnumlist)
+		cstate->qe_input_flags[lfirst_int(cur) - 1] = true;
+
+	if (GpPolicyIsPartitioned(policy))
+	{
+		for (i = 0; i < policy->nattrs; i++)
+			cstate->qe_input_flags[policy->attrs[i] - 1] = false;
+	}
+}
+
 static void
 FreeDistributionData(GpDistributionData *distData)
 {
@@ -68,6 +68,7 @@ typedef struct
 	CommandId	output_cid;		/* cmin to insert in output tuples */
 	int			hi_options;		/* heap_insert performance options */
 	BulkInsertState bistate;	/* bulk insert state */
+	double		expected_rows;	/* planner's estimate of rows on this segment */
 
 	struct AppendOnlyInsertDescData *ao_insertDesc; /* descriptor to AO tables */
 	struct AOCSInsertDescData *aocs_insertDes;      /* descriptor for aocs */
@@ -681,6 +682,14 @@ intorel_initplan(struct QueryDesc *queryDesc, int eflags)
 		(XLogIsNeeded() ? 0 : HEAP_INSERT_SKIP_WAL);
 	myState->bistate = GetBulkInsertState();
 
+	/*
+	 * The rows of the plan are estimated for the whole cluster, each segment
+	 * writes its share of them.
+	 */
+	myState->expected_rows = queryDesc->plannedstmt->planTree->plan_rows;
+	if (Gp_role == GP_ROLE_EXECUTE)
+		myState->expected_rows /= Max(getgpsegmentCount(), 1);
+
 	/* Not using WAL requires smgr_targblock be initially invalid */
 	Assert(RelationGetTargetBlock(intoRelationDesc) == InvalidBlockNumber);
 }
@@ -701,7 +710,11 @@ intorel_receive(TupleTableSlot *slot, DestReceiver *self)
 
 		tuple = ExecCopySlotMemTuple(slot);
 		if (myState->ao_insertDesc == NULL)
+		{
 			myState->ao_insertDesc = appendonly_insert_init(into_rel, RESERVED_SEGNO, false);
+			appendonly_insert_set_expected_rows(myState->ao_insertDesc,
+												myState->expected_rows);
+		}
 
 		appendonly_insert(myState->ao_insertDesc, tuple, InvalidOid, &aoTupleId);
 		pfree(tuple);
@@ -709,7 +722,11 @@ intorel_receive(TupleTableSlot *slot, DestReceiver *self)
 	else if (RelationIsAoCols(into_rel))
 	{
 		if(myState->aocs_insertDes == NULL)
+		{
 			myState->aocs_insertDes = aocs_insert_init(into_rel, RESERVED_SEGNO, false);
+			aocs_insert_set_expected_rows(myState->aocs_insertDes,
+										  myState->expected_rows);
+		}
 
 		aocs_insert(myState->aocs_insertDes, slot);
 	}
@@ -42,6 +42,9 @@
 #include "executor/execDynamicScan.h"
 
 #ifdef USE_ORCA
+#include "optimizer/orca.h"
+#include "optimizer/orcafeedback.h"
+
 extern char *SerializeDXLPlan(Query *parse);
 extern const char *OptVersion();
 #endif
@@ -73,6 +76,7 @@ static void report_triggers(ResultRelInfo *rInfo, bool show_relname,
 static void ExplainDXL(Query *query, ExplainState *es,
 							const char *queryString,
 							ParamListInfo params);
+static void ExplainOptimizerStats(ExplainState *es);
 #endif
 static double elapsed_time(instr_time *starttime);
 static void ExplainPreScanNode(PlanState *planstate, Bitmapset **rels_used);
@@ -195,6 +199,8 @@ ExplainQuery(ExplainStmt *stmt, const char *queryString,
 		}
 		else if (strcmp(opt->defname, "dxl") == 0)
 			es.dxl = defGetBoolean(opt);
+		else if (strcmp(opt->defname, "optimizer_stats") == 0)
+			es.optimizer_stats = defGetBoolean(opt);
 		else
 			ereport(ERROR,
 					(errcode(ERRCODE_SYNTAX_ERROR),
@@ -349,12 +355,14 @@ ExplainDXL(Query *query, ExplainState *es, const char *queryString,
 
 	/* enable plan enumeration before calling optimizer */
 	optimizer_enumerate_plans = true;
+	AdvanceConfigGeneration();
 
 	/* optimize query using optimizer and get generated plan in DXL format */
 	dxl = SerializeDXLPlan(query);
 
 	/* restore old value of enumerate plans GUC */
 	optimizer_enumerate_plans = save_enumerate;
+	AdvanceConfigGeneration();
 
 	if (dxl == NULL)
 		elog(NOTICE, "Optimizer failed to produce plan");
@@ -368,6 +376,74 @@ ExplainDXL(Query *query, ExplainState *es, const char *queryString,
 	/* Free the memory we used. */
 	MemoryContextSwitchTo(oldcxt);
 }
+
+/*
+ * ExplainOptimizerStats -
+ *	  print out where GPORCA spent the time planning the query
+ *
+ * Nothing is printed if the query wasn't planned by GPORCA.
+ */
+static void
+ExplainOptimizerStats(ExplainState *es)
+{
+	OptimizerStats *stats = &optimizer_last_stats;
+
+	if (stats->num_optimizations == 0)
+		return;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfo(es->str,
+						 "Optimizer phases: translation=%.3f ms search=%.3f ms plan generation=%.3f ms missing statistics check=%.3f ms\n",
+						 stats->translate_time, stats->search_time,
+						 stats->plan_time, stats->missing_stats_time);
+		appendStringInfo(es->str,
+						 "Optimizer metadata: fetches=" INT64_FORMAT " time=%.3f ms peak memory=" INT64_FORMAT "kB\n",
+						 stats->num_mdfetches, stats->mdfetch_time,
+						 (stats->peak_memory + 1023) / 1024);
+		appendStringInfo(es->str,
+						 "Optimizer allocations: translation=" INT64_FORMAT " (" INT64_FORMAT "kB) search=" INT64_FORMAT " (" INT64_FORMAT "kB) plan generation=" INT64_FORMAT " (" INT64_FORMAT "kB) metadata=" INT64_FORMAT " (" INT64_FORMAT "kB)\n",
+						 stats->translate_allocs, (stats->translate_alloc_bytes + 1023) / 1024,
+						 stats->search_allocs, (stats->search_alloc_bytes + 1023) / 1024,
+						 stats->plan_allocs, (stats->plan_alloc_bytes + 1023) / 1024,
+						 stats->mdfetch_allocs, (stats->mdfetch_alloc_bytes + 1023) / 1024);
+		if (stats->join_relations > 1)
+			appendStringInfo(es->str,
+							 "Optimizer join search: relations=%d pairs=" INT64_FORMAT "%s search=%s\n",
+							 stats->join_relations,
+							 Min(stats->join_pairs, (int64) optimizer_join_search_budget),
+							 stats->join_pairs > optimizer_join_search_budget ? "+" : "",
+							 stats->join_search_dp ? "dynamic programming" : "default");
+		if (stats->memory_limit_hits > 0)
+			appendStringInfo(es->str,
+							 "Optimizer memory limit: %dkB exceeded, planned by the Postgres planner\n",
+							 optimizer_memory_limit);
+	}
+	else
+	{
+		ExplainOpenGroup("Optimizer Statistics", "Optimizer Statistics", true, es);
+		ExplainPropertyFloat("Translation Time", stats->translate_time, 3, es);
+		ExplainPropertyFloat("Search Time", stats->search_time, 3, es);
+		ExplainPropertyFloat("Plan Generation Time", stats->plan_time, 3, es);
+		ExplainPropertyFloat("Missing Statistics Check Time", stats->missing_stats_time, 3, es);
+		ExplainPropertyLong("Metadata Fetches", (long) stats->num_mdfetches, es);
+		ExplainPropertyFloat("Metadata Fetch Time", stats->mdfetch_time, 3, es);
+		ExplainPropertyLong("Peak Memory", (long) ((stats->peak_memory + 1023) / 1024), es);
+		ExplainPropertyLong("Translation Allocations", (long) stats->translate_allocs, es);
+		ExplainPropertyLong("Translation Allocated Memory", (long) ((stats->translate_alloc_bytes + 1023) / 1024), es);
+		ExplainPropertyLong("Search Allocations", (long) stats->search_allocs, es);
+		ExplainPropertyLong("Search Allocated Memory", (long) ((stats->search_alloc_bytes + 1023) / 1024), es);
+		ExplainPropertyLong("Plan Generation Allocations", (long) stats->plan_allocs, es);
+		ExplainPropertyLong("Plan Generation Allocated Memory", (long) ((stats->plan_alloc_bytes + 1023) / 1024), es);
+		ExplainPropertyLong("Metadata Fetch Allocations", (long) stats->mdfetch_allocs, es);
+		ExplainPropertyLong("Metadata Fetch Allocated Memory", (long) ((stats->mdfetch_alloc_bytes + 1023) / 1024), es);
+		ExplainPropertyLong("Memory Limit Hits", (long) stats->memory_limit_hits, es);
+		ExplainPropertyInteger("Join Relations", stats->join_relations, es);
+		ExplainPropertyLong("Join Pairs", (long) stats->join_pairs, es);
+		ExplainPropertyText("Join Search", stats->join_search_dp ? "Dynamic Programming" : "Default", es);
+		ExplainCloseGroup("Optimizer Statistics", "Optimizer Statistics", true, es);
+	}
+}
 #endif
 
 /*
@@ -404,6 +480,12 @@ ExplainOneQuery(Query *query, IntoClause *into, ExplainState *es,
 		instr_time	planstart,
 					planduration;
 
+#ifdef USE_ORCA
+		/* the statistics are filled in if GPORCA plans the query */
+		if (es->optimizer_stats)
+			MemSet(&optimizer_last_stats, 0, sizeof(optimizer_last_stats));
+#endif
+
 		INSTR_TIME_SET_CURRENT(planstart);
 
 		/* plan the query */
@@ -626,6 +708,11 @@ ExplainOnePlan(PlannedStmt *plannedstmt, IntoClause *into, ExplainState *es,
 			ExplainPropertyFloat("Planning Time", 1000.0 * plantime, 3, es);
 	}
 
+#ifdef USE_ORCA
+	if (es->optimizer_stats && planduration)
+		ExplainOptimizerStats(es);
+#endif
+
 	/* Print info about runtime of triggers */
 	if (es->analyze)
 		ExplainPrintTriggers(es, queryDesc);
@@ -734,6 +821,18 @@ ExplainPrintPlan(ExplainState *es, QueryDesc *queryDesc)
                                      estate->dispatcherState->primaryResults,
                                      LocallyExecutingSliceIndex(estate),
                                      es->showstatctx);
+
+#ifdef USE_ORCA
+		/* Remember the rows returned by the scans of a plan of GPORCA. */
+		if (optimizer_cardinality_feedback &&
+			queryDesc->plannedstmt->planGen == PLANGEN_OPTIMIZER)
+			OrcaFeedbackRecord(queryDesc);
+
+		/* And the estimates of its nodes next to their statistics. */
+		if (optimizer_plan_trace &&
+			queryDesc->plannedstmt->planGen == PLANGEN_OPTIMIZER)
+			OrcaPlanTraceRecord(queryDesc);
+#endif
 	}
 
 	ExplainPreScanNode(queryDesc->planstate, &rels_used);
@@ -2441,6 +2540,10 @@ show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
 	show_sort_group_keys((PlanState *) sortstate, SortKeystr,
 						 plan->numCols, plan->sortColIdx,
 						 ancestors, es);
+	if (plan->numPresortedCols > 0)
+		show_sort_group_keys((PlanState *) sortstate, "Presorted Key",
+							 plan->numPresortedCols, plan->sortColIdx,
+							 ancestors, es);
 }
 
 static void
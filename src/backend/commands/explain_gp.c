@@ -99,12 +99,18 @@ typedef struct CdbExplain_StatInst
 	double		firsttuple;		/* Time for first tuple of this cycle */
 	double		startup;		/* Total startup time (in seconds) */
 	double		total;			/* Total total time (in seconds) */
+	double		cputime;		/* of which on CPU (in seconds) */
 	double		ntuples;		/* Total tuples produced */
 	double		nloops;			/* # of run cycles for this node */
 	double		execmemused;	/* executor memory used (bytes) */
 	double		workmemused;	/* work_mem actually used (bytes) */
 	double		workmemwanted;	/* work_mem to avoid workfile i/o (bytes) */
 	bool		workfileCreated;	/* workfile created in this node */
+	double		workfileBytes;	/* bytes written to workfiles */
+	double		workfileDiskBytes;	/* of which reached the disk */
+	double		workfileWriteTime;	/* seconds spent writing workfiles */
+	double		bloomProbes;	/* outer rows checked against bloom filter */
+	double		bloomRejects;	/* of which the bloom filter discarded */
 	instr_time	firststart;		/* Start time of first iteration of node */
 	double		peakMemBalance; /* Max mem account balance */
 	int			numPartScanned; /* Number of part tables scanned */
@@ -175,6 +181,12 @@ typedef struct CdbExplain_NodeSummary
 	CdbExplain_Agg workmemused;
 	CdbExplain_Agg workmemwanted;
 	CdbExplain_Agg totalWorkfileCreated;
+	CdbExplain_Agg workfileBytes;
+	CdbExplain_Agg workfileDiskBytes;
+	CdbExplain_Agg workfileWriteTime;
+	CdbExplain_Agg bloomProbes;
+	CdbExplain_Agg bloomRejects;
+	CdbExplain_Agg cputime;
 	CdbExplain_Agg peakMemBalance;
 	/* Used for DynamicSeqScan, DynamicIndexScan and DynamicBitmapHeapScan */
 	CdbExplain_Agg totalPartTableScanned;
@@ -969,12 +981,18 @@ cdbexplain_collectStatsFromNode(PlanState *planstate, CdbExplain_SendStatCtx *ct
 	si->firsttuple = instr->firsttuple;
 	si->startup = instr->startup;
 	si->total = instr->total;
+	si->cputime = instr->cputime;
 	si->ntuples = instr->ntuples;
 	si->nloops = instr->nloops;
 	si->execmemused = instr->execmemused;
 	si->workmemused = instr->workmemused;
 	si->workmemwanted = instr->workmemwanted;
 	si->workfileCreated = instr->workfileCreated;
+	si->workfileBytes = instr->workfileBytes;
+	si->workfileDiskBytes = instr->workfileDiskBytes;
+	si->workfileWriteTime = instr->workfileWriteTime;
+	si->bloomProbes = instr->bloomProbes;
+	si->bloomRejects = instr->bloomRejects;
 	si->peakMemBalance = MemoryAccounting_GetAccountPeakBalance(planstate->memoryAccountId);
 	si->firststart = instr->firststart;
 	si->numPartScanned = instr->numPartScanned;
@@ -1102,6 +1120,12 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 	CdbExplain_DepStatAcc workmemused;
 	CdbExplain_DepStatAcc workmemwanted;
 	CdbExplain_DepStatAcc totalWorkfileCreated;
+	CdbExplain_DepStatAcc workfileBytes;
+	CdbExplain_DepStatAcc workfileDiskBytes;
+	CdbExplain_DepStatAcc workfileWriteTime;
+	CdbExplain_DepStatAcc bloomProbes;
+	CdbExplain_DepStatAcc bloomRejects;
+	CdbExplain_DepStatAcc cputime;
 	CdbExplain_DepStatAcc peakmemused;
 	CdbExplain_DepStatAcc vmem_reserved;
 	CdbExplain_DepStatAcc memory_accounting_global_peak;
@@ -1130,6 +1154,12 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 	cdbexplain_depStatAcc_init0(&workmemused);
 	cdbexplain_depStatAcc_init0(&workmemwanted);
 	cdbexplain_depStatAcc_init0(&totalWorkfileCreated);
+	cdbexplain_depStatAcc_init0(&workfileBytes);
+	cdbexplain_depStatAcc_init0(&workfileDiskBytes);
+	cdbexplain_depStatAcc_init0(&workfileWriteTime);
+	cdbexplain_depStatAcc_init0(&bloomProbes);
+	cdbexplain_depStatAcc_init0(&bloomRejects);
+	cdbexplain_depStatAcc_init0(&cputime);
 	cdbexplain_depStatAcc_init0(&peakMemBalance);
 	cdbexplain_depStatAcc_init0(&totalPartTableScanned);
 	for (int idx = 0; idx < NUM_SORT_METHOD; ++idx)
@@ -1174,6 +1204,13 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 		cdbexplain_depStatAcc_upd(&workmemused, rsi->workmemused, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&workmemwanted, rsi->workmemwanted, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&totalWorkfileCreated, (rsi->workfileCreated ? 1 : 0), rsh, rsi, nsi);
+		cdbexplain_depStatAcc_upd(&workfileBytes, rsi->workfileBytes, rsh, rsi, nsi);
+		cdbexplain_depStatAcc_upd(&workfileDiskBytes, rsi->workfileDiskBytes, rsh, rsi, nsi);
+		cdbexplain_depStatAcc_upd(&workfileWriteTime, rsi->workfileWriteTime, rsh, rsi, nsi);
+		cdbexplain_depStatAcc_upd(&bloomProbes, rsi->bloomProbes, rsh, rsi, nsi);
+		cdbexplain_depStatAcc_upd(&bloomRejects, rsi->bloomRejects, rsh, rsi, nsi);
+		if (rsi->nloops > 0)
+			cdbexplain_depStatAcc_upd(&cputime, rsi->cputime, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&peakMemBalance, rsi->peakMemBalance, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&totalPartTableScanned, rsi->numPartScanned, rsh, rsi, nsi);
 		if (rsi->sortMethod < NUM_SORT_METHOD && rsi->sortMethod != UNINITIALIZED_SORT && rsi->sortSpaceType != UNINITIALIZED_SORT_SPACE_TYPE)
@@ -1194,6 +1231,12 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 	ns->workmemused = workmemused.agg;
 	ns->workmemwanted = workmemwanted.agg;
 	ns->totalWorkfileCreated = totalWorkfileCreated.agg;
+	ns->workfileBytes = workfileBytes.agg;
+	ns->workfileDiskBytes = workfileDiskBytes.agg;
+	ns->workfileWriteTime = workfileWriteTime.agg;
+	ns->bloomProbes = bloomProbes.agg;
+	ns->bloomRejects = bloomRejects.agg;
+	ns->cputime = cputime.agg;
 	ns->peakMemBalance = peakMemBalance.agg;
 	ns->totalPartTableScanned = totalPartTableScanned.agg;
 	for (int idx = 0; idx < NUM_SORT_METHOD; ++idx)
@@ -1263,6 +1306,79 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 }								/* cdbexplain_depositStatsToNode */
 
 
+/*
+ * cdbexplain_getRowsPerLoop
+ *	  Rows the node produced per loop on each of the workers that ran it,
+ *	  summed over the workers, and the most of any one worker.
+ *
+ * Returns false if the statistics of the node haven't been deposited yet.
+ */
+bool
+cdbexplain_getRowsPerLoop(struct PlanState *planstate, double *sum, double *max)
+{
+	Instrumentation *instr = planstate->instrument;
+	CdbExplain_NodeSummary *ns;
+	int			i;
+
+	if (!instr || !instr->cdbNodeSummary)
+		return false;
+
+	ns = instr->cdbNodeSummary;
+	*sum = 0;
+	*max = 0;
+	for (i = 0; i < ns->ninst; i++)
+	{
+		CdbExplain_StatInst *nsi = &ns->insts[i];
+		double		rows;
+
+		if (nsi->nloops <= 0)
+			continue;
+
+		rows = nsi->ntuples / nsi->nloops;
+		*sum += rows;
+		*max = Max(*max, rows);
+	}
+
+	return true;
+}								/* cdbexplain_getRowsPerLoop */
+
+
+/*
+ * cdbexplain_getTimePerLoop
+ *	  The most time any one of the workers that ran the node spent in it per
+ *	  loop.
+ *
+ * Returns false if the statistics of the node haven't been deposited yet, or
+ * if no worker ran it.
+ */
+bool
+cdbexplain_getTimePerLoop(struct PlanState *planstate, double *max)
+{
+	Instrumentation *instr = planstate->instrument;
+	CdbExplain_NodeSummary *ns;
+	bool		found = false;
+	int			i;
+
+	if (!instr || !instr->cdbNodeSummary)
+		return false;
+
+	ns = instr->cdbNodeSummary;
+	*max = 0;
+	for (i = 0; i < ns->ninst; i++)
+	{
+		CdbExplain_StatInst *nsi = &ns->insts[i];
+
+		if (nsi->nloops <= 0)
+			continue;
+
+		*max = Max(*max, nsi->total / nsi->nloops);
+		found = true;
+	}
+
+	return found;
+}								/* cdbexplain_getTimePerLoop */
+
+
 /*
  * cdbexplain_collectExtraText
  *	  Allow a node to supply additional text for its EXPLAIN ANALYZE report.
@@ -1652,6 +1768,108 @@ cdbexplain_showExecStats(struct PlanState *planstate, ExplainState *es)
 		}
 	}
 
+	/*
+	 * How much of the time of the node its processes spent on the CPU, and
+	 * how much waiting, for I/O, locks or, in a Motion, for tuples from the
+	 * interconnect.  The times include those of the nodes below.
+	 */
+	if (es->analyze && es->verbose && es->timing && ns->cputime.vcnt > 0 &&
+		ns->cputime.vmax > 0)
+	{
+		double		total = 0;
+		double		cpu_avg = cdbexplain_agg_avg(&ns->cputime);
+		double		wait_avg;
+		int			i;
+
+		for (i = 0; i < ns->ninst; i++)
+		{
+			if (ns->insts[i].nloops > 0)
+				total += ns->insts[i].total;
+		}
+		wait_avg = Max(total / ns->cputime.vcnt - cpu_avg, 0.0);
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str,
+							 "CPU time: avg %.3f ms, max %.3f ms (seg%d)  Wait time: avg %.3f ms\n",
+							 1000.0 * cpu_avg,
+							 1000.0 * ns->cputime.vmax,
+							 ns->cputime.imax,
+							 1000.0 * wait_avg);
+		}
+		else
+		{
+			ExplainOpenGroup("CPU", "CPU", true, es);
+			ExplainPropertyFloat("Avg CPU Time", 1000.0 * cpu_avg, 3, es);
+			ExplainPropertyFloat("Max CPU Time", 1000.0 * ns->cputime.vmax, 3, es);
+			ExplainPropertyInteger("Max CPU Time Segment", ns->cputime.imax, es);
+			ExplainPropertyFloat("Avg Wait Time", 1000.0 * wait_avg, 3, es);
+			ExplainCloseGroup("CPU", "CPU", true, es);
+		}
+	}
+
+	/*
+	 * Bytes spilled to workfiles, how well they compressed, and how fast
+	 * they were written.
+	 */
+	if (es->analyze && es->verbose && ns->workfileBytes.vcnt > 0)
+	{
+		double		ratio = 1.0;
+		double		rate = 0.0;
+
+		if (ns->workfileDiskBytes.vsum > 0)
+			ratio = ns->workfileBytes.vsum / ns->workfileDiskBytes.vsum;
+		if (ns->workfileWriteTime.vsum > 0)
+			rate = ns->workfileDiskBytes.vsum / (1024.0 * 1024.0) / ns->workfileWriteTime.vsum;
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str,
+							 "Workfile written: %ldkB  On disk: %ldkB  Compression ratio: %.2f  Segments: %d  Max: %ldkB (segment %d)  Rate: %.1fMB/s\n",
+							 (long) kb(ns->workfileBytes.vsum),
+							 (long) kb(ns->workfileDiskBytes.vsum),
+							 ratio,
+							 ns->workfileBytes.vcnt,
+							 (long) kb(ns->workfileBytes.vmax),
+							 ns->workfileBytes.imax,
+							 rate);
+		}
+		else
+		{
+			ExplainOpenGroup("Workfile", "Workfile", true, es);
+			ExplainPropertyLong("Written", (long) kb(ns->workfileBytes.vsum), es);
+			ExplainPropertyLong("On Disk", (long) kb(ns->workfileDiskBytes.vsum), es);
+			ExplainPropertyFloat("Compression Ratio", ratio, 2, es);
+			ExplainPropertyInteger("Segments", ns->workfileBytes.vcnt, es);
+			ExplainPropertyLong("Max Written", (long) kb(ns->workfileBytes.vmax), es);
+			ExplainPropertyInteger("Max Written Segment", ns->workfileBytes.imax, es);
+			ExplainPropertyFloat("Write Rate", rate, 1, es);
+			ExplainCloseGroup("Workfile", "Workfile", true, es);
+		}
+	}
+
+	/* Outer rows discarded by a hash join's bloom filter. */
+	if (es->analyze && es->verbose && ns->bloomProbes.vsum > 0)
+	{
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str,
+							 "Bloom filter discarded %.0f of %.0f outer rows.\n",
+							 ns->bloomRejects.vsum,
+							 ns->bloomProbes.vsum);
+		}
+		else
+		{
+			ExplainOpenGroup("Bloom Filter", "Bloom Filter", true, es);
+			ExplainPropertyFloat("Outer Rows Checked", ns->bloomProbes.vsum, 0, es);
+			ExplainPropertyFloat("Outer Rows Discarded", ns->bloomRejects.vsum, 0, es);
+			ExplainCloseGroup("Bloom Filter", "Bloom Filter", true, es);
+		}
+	}
+
 	if (es->verbose && EXPLAIN_MEMORY_VERBOSITY_SUPPRESS < explain_memory_verbosity)
 	{
 		/*
@@ -1681,7 +1899,8 @@ cdbexplain_showExecStats(struct PlanState *planstate, ExplainState *es)
 	 * Print number of partitioned tables scanned for dynamic scans.
 	 */
 	if (0 <= ns->totalPartTableScanned.vcnt && (T_DynamicSeqScanState == planstate->type
-												|| T_DynamicIndexScanState == planstate->type))
+												|| T_DynamicIndexScanState == planstate->type
+												|| T_DynamicBitmapHeapScanState == planstate->type))
 	{
 		/*
 		 * FIXME: Only displayed in TEXT format
@@ -1693,15 +1912,13 @@ cdbexplain_showExecStats(struct PlanState *planstate, ExplainState *es)
 
 			if (0 == nPartTableScanned_avg)
 			{
-				if (T_DynamicBitmapHeapScanState == planstate->type)
-				{
-					int			numTotalLeafParts = cdbexplain_countLeafPartTables(planstate);
+				/* all the partitions were eliminated */
+				int			numTotalLeafParts = cdbexplain_countLeafPartTables(planstate);
 
-					appendStringInfoSpaces(es->str, es->indent * 2);
-					appendStringInfo(es->str,
-									 "Partitions scanned:  0 (out of %d).\n",
-									 numTotalLeafParts);
-				}
+				appendStringInfoSpaces(es->str, es->indent * 2);
+				appendStringInfo(es->str,
+								 "Partitions scanned:  0 (out of %d).\n",
+								 numTotalLeafParts);
 			}
 			else
 			{
@@ -2329,7 +2546,8 @@ static int
 cdbexplain_countLeafPartTables(PlanState *planstate)
 {
 	Assert(IsA(planstate, DynamicSeqScanState) ||
-		   IsA(planstate, DynamicIndexScanState));
+		   IsA(planstate, DynamicIndexScanState) ||
+		   IsA(planstate, DynamicBitmapHeapScanState));
 	Scan	   *scan = (Scan *) planstate->plan;
 
 	Oid			root_oid = getrelid(scan->scanrelid, planstate->state->es_range_table);
@@ -1110,6 +1110,17 @@ get_rel_oids(Oid relid, VacuumStmt *vacstmt, int stmttype)
 				{
 					oid_list = all_leaf_partition_relids(pn); /* all leaves */
 
+					/*
+					 * The statistics of the leaves that haven't changed are
+					 * still good, also to merge into the root's.
+					 */
+					if (optimizer_analyze_changed_partitions_only)
+					{
+						int		elevel = ((vacstmt->options & VACOPT_VERBOSE) ? INFO : DEBUG2);
+
+						oid_list = leaf_parts_changed(oid_list, vacstmt->va_cols, elevel);
+					}
+
 					if (optimizer_analyze_midlevel_partition)
 					{
 						oid_list = list_concat(oid_list, all_interior_partition_relids(pn)); /* interior partitions */
@@ -1194,6 +1205,7 @@ get_rel_oids(Oid relid, VacuumStmt *vacstmt, int stmttype)
 		HeapTuple	tuple;
 		Oid candidateOid;
 		List	   *rootParts = NIL;
+		List	   *leafParts = NIL;
 
 		pgclass = heap_open(RelationRelationId, AccessShareLock);
 
@@ -1242,6 +1254,9 @@ get_rel_oids(Oid relid, VacuumStmt *vacstmt, int stmttype)
 			oldcontext = MemoryContextSwitchTo(vac_context);
 			if (ps == PART_STATUS_ROOT)
 				rootParts = lappend_oid(rootParts, candidateOid);
+			else if (ps == PART_STATUS_LEAF && stmttype == VACOPT_ANALYZE &&
+					 optimizer_analyze_changed_partitions_only)
+				leafParts = lappend_oid(leafParts, candidateOid);
 			else
 				oid_list = lappend_oid(oid_list, candidateOid);
 			MemoryContextSwitchTo(oldcontext);
@@ -1255,6 +1270,14 @@ get_rel_oids(Oid relid, VacuumStmt *vacstmt, int stmttype)
 		 * have already been analyzed.
 		 */
 		oldcontext = MemoryContextSwitchTo(vac_context);
+		if (leafParts != NIL)
+		{
+			int		elevel = ((vacstmt->options & VACOPT_VERBOSE) ? INFO : DEBUG2);
+
+			/* leave out the leaves that haven't changed, like above */
+			oid_list = list_concat(oid_list,
+								   leaf_parts_changed(leafParts, NIL, elevel));
+		}
 		oid_list = list_concat(oid_list, rootParts);
 		MemoryContextSwitchTo(oldcontext);
 
@@ -118,14 +118,25 @@ typedef enum InputRecordType
 #define HAVE_FREESPACE(hashtable) \
 		(AVAIL_MEM(hashtable) > 0)
 
-/* Actual memory needed per bucket = entry pointer + bloom value */
-#define OVERHEAD_PER_BUCKET (sizeof(HashAggBucket) + sizeof(uint64))
+/* Actual memory needed per slot of the open addressing hash table */
+#define OVERHEAD_PER_BUCKET (sizeof(HashAggSlot))
 
-#define BLOOMVAL(hashkey) ((uint64)1) << (((hashkey) >> 23) & 0x3f);
+/*
+ * The slots are never filled beyond this fraction, so that the linear
+ * probing sequences stay short.
+ */
+#define HASHAGG_MAX_FILL_FACTOR 0.75
+
+#define MAX_SLOT_ENTRIES(nbuckets) \
+		((uint64) ((nbuckets) * HASHAGG_MAX_FILL_FACTOR))
 
 #define BUCKET_IDX(hashtable, hashkey) \
 		(((hashkey) >> (hashtable)->pshift) & ((hashtable)->nbuckets - 1))
 
+/* Spill file of an entry, picked by the low bits of its slot number */
+#define SPILL_FILE_IDX(hashtable, spill_set, hashkey) \
+		(((hashkey) >> (hashtable)->pshift) & ((spill_set)->num_spill_files - 1))
+
 #define LOG2(x) (ceil(log((x)) / log(2)))
 
 /* Methods that handle batch files */
@@ -295,7 +306,6 @@ makeHashAggEntryForInput(AggState *aggstate, TupleTableSlot *inputslot, uint32 h
 	entry->tuple_and_aggs = NULL;
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
-	entry->next = NULL;
 
 	/*
 	 * Calculate the tup_len we need.
@@ -405,7 +415,6 @@ makeHashAggEntryForGroup(AggState *aggstate, void *tuple_and_aggs,
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
 	entry->tuple_and_aggs = copy_tuple_and_aggs;
-	entry->next = NULL;
 
 	/* Initialize per group data */
 	adjustInputGroup(aggstate, entry->tuple_and_aggs);
@@ -463,7 +472,7 @@ lookup_agg_hash_entry(AggState *aggstate,
 	Agg *agg = (Agg*)aggstate->ss.ps.plan;
 	MemoryContext oldcxt;
 	unsigned int bucket_idx;
-	uint64 bloomval;			/* bloom filter value */
+	HashAggSlot *slot;
    
 	Assert(mt_bind != NULL);
 
@@ -472,28 +481,31 @@ lookup_agg_hash_entry(AggState *aggstate,
 
 	oldcxt = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
 
-	bucket_idx = BUCKET_IDX(hashtable, hashkey);
-	bloomval = BLOOMVAL(hashkey);
-	entry = (0 == (hashtable->bloom[bucket_idx] & bloomval) ? NULL :
-			 hashtable->buckets[bucket_idx]);
-
 	/*
-	 * Search entry chain for the bucket. If such an entry found in the
-	 * chain, move it to the front of the chain. Otherwise, if there
-	 * are any space left, create a new entry, and insert it in
-	 * the front of the chain.
+	 * Probe the slots linearly from the one of the hash key, until the
+	 * matching entry or an empty slot is found. Only the entries whose
+	 * hash value in the slot is equal to the hash key are compared.
 	 */
-	while (entry != NULL)
+	bucket_idx = BUCKET_IDX(hashtable, hashkey);
+	entry = NULL;
+
+	for (;;)
 	{
-		MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
+		MemTuple mtup;
 		int i;
 		bool match = true;
 
-		if (hashkey != entry->hashvalue)
+		slot = &hashtable->buckets[bucket_idx];
+		if (slot->entry == NULL)
+			break;
+
+		if (hashkey != slot->hashvalue)
 		{
-			entry = entry->next;
+			bucket_idx = (bucket_idx + 1) & (hashtable->nbuckets - 1);
 			continue;
 		}
+
+		mtup = (MemTuple) slot->entry->tuple_and_aggs;
 		
 		for (i = 0; match && i < agg->numCols; i++)
 		{
@@ -527,13 +539,38 @@ lookup_agg_hash_entry(AggState *aggstate,
 		
 		/* Break if found an existing matching entry. */
 		if (match)
+		{
+			entry = slot->entry;
 			break;
+		}
 
-		entry = entry->next;
+		bucket_idx = (bucket_idx + 1) & (hashtable->nbuckets - 1);
 	}
 
 	if (entry == NULL)
 	{
+		/*
+		 * The table is as full as allowed; grow it if possible, or else
+		 * report that there is no room so that the caller spills.
+		 */
+		if (hashtable->num_entries >= MAX_SLOT_ENTRIES(hashtable->nbuckets))
+		{
+			if (hashtable->expandable)
+				expand_hash_table(aggstate);
+
+			if (hashtable->num_entries >= MAX_SLOT_ENTRIES(hashtable->nbuckets))
+			{
+				(void) MemoryContextSwitchTo(oldcxt);
+				return NULL;
+			}
+
+			/* Find the empty slot again, in the expanded table */
+			bucket_idx = BUCKET_IDX(hashtable, hashkey);
+			while (hashtable->buckets[bucket_idx].entry != NULL)
+				bucket_idx = (bucket_idx + 1) & (hashtable->nbuckets - 1);
+			slot = &hashtable->buckets[bucket_idx];
+		}
+
 		/* Entry not found! Create a new matching entry. */
 		switch(input_type)
 		{
@@ -549,18 +586,8 @@ lookup_agg_hash_entry(AggState *aggstate,
 			
 		if (entry != NULL)
 		{
-			if (hashtable->expandable &&
-					hashtable->num_entries >= (hashtable->nbuckets * gp_hashagg_groups_per_bucket))
-			{
-				/* The hashtable is denser than envisioned; increase the number of buckets */
-				expand_hash_table(aggstate);
-				/* Recompute bucket_idx in case nbuckets changed */
-				bucket_idx = BUCKET_IDX(hashtable, hashkey);
-			}
-
-			entry->next = hashtable->buckets[bucket_idx];
-			hashtable->buckets[bucket_idx] = entry;
-			hashtable->bloom[bucket_idx] |= bloomval;
+			slot->hashvalue = hashkey;
+			slot->entry = entry;
 			
 			++hashtable->num_ht_groups;
 			++hashtable->num_entries;
@@ -615,7 +642,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	Assert(ngroups >= 0);
 
 	/* Estimate the overhead per entry in the hash table */
-	entrysize = entrywidth + OVERHEAD_PER_BUCKET / (double) gp_hashagg_groups_per_bucket;
+	entrysize = entrywidth + OVERHEAD_PER_BUCKET / HASHAGG_MAX_FILL_FACTOR;
 
 	elog(HHA_MSG_LVL, "HashAgg: ngroups = %g, memquota = %g, entrysize = %g",
 		 ngroups, memquota, entrysize);
@@ -664,8 +691,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	/* Yet, allocate only as many as needed */
 	nentries = Min(ngroups, nentries);
 
-	/* but at least a few hash entries as required */
-	nentries = Max(nentries, gp_hashagg_groups_per_bucket);
+	/* but at least one hash entry as required */
+	nentries = Max(nentries, 1);
 	entries_mem = nentries * entrywidth;
 
 	/* In resource group the memory quota could be dynamically enlarged */
@@ -689,8 +716,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 
 	memquota -= entries_mem;
 
-	/* Determine the number of buckets */
-	nbuckets = ceil(nentries / gp_hashagg_groups_per_bucket);
+	/* Determine the number of slots, to hold the entries below the fill factor */
+	nbuckets = ceil(nentries / HASHAGG_MAX_FILL_FACTOR);
 
 	/* Use only as many allowed by memory */
 	nbuckets = Min(nbuckets, floor(memquota / OVERHEAD_PER_BUCKET));
@@ -708,9 +735,9 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	}
 
 	/*
-	 * Always set nbuckets greater than gp_hashagg_default_nbatches since
-	 * the spilling relies on this fact to choose which files to spill
-	 * groups to.
+	 * Always set nbuckets greater than gp_hashagg_default_nbatches, so that
+	 * a table that spills holds at least as many entries as there are spill
+	 * files.
 	 * Note: gp_hashagg_default_nbatches must be a power of two
 	 */
 	nbuckets = Max(nbuckets, gp_hashagg_default_nbatches);
@@ -733,8 +760,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 		elog(HHA_MSG_LVL, "HashAgg: not enough memory for the hash table parameters chosen:");
 		elog(HHA_MSG_LVL, "HashAgg: nbuckets = %d, nentries = %d, nbatches = %d",
 			 (int)nbuckets, (int)nentries, (int)nbatches);
-		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d, gp_hashagg_groups_per_bucket = %d",
-			 (int)ngroups, (int)gp_hashagg_groups_per_bucket);
+		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d", (int)ngroups);
 		return false;
 	}
 
@@ -871,10 +897,9 @@ create_agg_hash_table(AggState *aggstate)
 		elog(ERROR, ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY);
 	}
 
-	/* Initialize the hash buckets */
+	/* Initialize the hash slots */
 	hashtable->nbuckets = hashtable->hats.nbuckets;
-	hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+	hashtable->buckets = (HashAggSlot *) palloc0(hashtable->nbuckets * sizeof(HashAggSlot));
 
 	hashtable->pshift = 0;
 	hashtable->expandable = true;
@@ -1043,6 +1068,7 @@ agg_hash_initial_pass(AggState *aggstate)
 		advance_aggregates(aggstate, hashtable->groupaggs->aggs);
 		
 		hashtable->num_tuples++;
+		hashtable->num_stream_tuples++;
 
 		/* Reset per-input-tuple context after each tuple */
 		ResetExprContext(tmpcontext);
@@ -1093,6 +1119,22 @@ agg_hash_initial_pass(AggState *aggstate)
 	if(tuple_remaining) 
 		elog(HHA_MSG_LVL, "HashAgg: streaming out the intermediate results.");
 
+	/*
+	 * The lower stage only reduces what goes through the motion above it.  If
+	 * the hash table filled up with hardly fewer groups than tuples, it isn't
+	 * worth it: have the rest of tuples passed through instead.
+	 */
+	if (tuple_remaining && aggstate->passthrough_ok &&
+		hashtable->num_stream_tuples > 0 &&
+		(double) hashtable->num_ht_groups >
+		gp_hashagg_passthrough_ratio * (double) hashtable->num_stream_tuples)
+	{
+		elog(HHA_MSG_LVL,
+			 "HashAgg: " INT64_FORMAT " groups of " INT64_FORMAT " tuples, passing through the rest of tuples",
+			 hashtable->num_ht_groups, hashtable->num_stream_tuples);
+		hashtable->passthrough = true;
+	}
+
 	return tuple_remaining;
 }
 
@@ -1352,11 +1394,10 @@ obtain_spill_set(HashAggTable *hashtable)
 /* Spill all entries from the hash table to file in order to make room
  * for new hash entries.
  *
- * We want to maximize the sequential writes to each spill file. Since
- * the number of buckets and the number of batches (#batches) are the power of 2,
- * We simply write bucket 0, #batches, 2 * #batches, ... to the batch 0;
- * write bucket 1, (#batches + 1), (2 * #batches + 1), ... to the batch 1;
- * and etc.
+ * The entries are partitioned by the radix of their hash value: the hash
+ * bits right above pshift pick the spill file, and a reload of the file
+ * shifts past them. All the spill files are opened first, and then the
+ * slots are written out in a single pass.
  */
 static void
 spill_hash_table(AggState *aggstate)
@@ -1365,7 +1406,7 @@ spill_hash_table(AggState *aggstate)
 	elog(HHA_MSG_LVL, "Spilling hash table at %ld entries", hashtable->num_entries);
 	SpillSet *spill_set;
 	SpillFile *spill_file;
-	int bucket_no;
+	unsigned bucket_no;
 	int file_no;
 	MemoryContext oldcxt;
 	uint64 old_num_spill_groups = hashtable->num_spill_groups;
@@ -1386,7 +1427,7 @@ spill_hash_table(AggState *aggstate)
 	Assert(hashtable->nbuckets > spill_set->num_spill_files);
 
 	/*
-	 * Write each spill file. Write the last spill file first, since it will
+	 * Open each spill file. Open the last spill file first, since it will
 	 * be processed the last.
 	 */
 	for (file_no = spill_set->num_spill_files - 1; file_no >= 0; file_no--)
@@ -1405,6 +1446,7 @@ spill_hash_table(AggState *aggstate)
 		 */
 		spill_file = getSpillFile(hashtable->work_set, spill_set, file_no, &alloc_size);
 		Assert(spill_file != NULL);
+		BufFileSetInstrument(spill_file->file_info->wfile, aggstate->ss.ps.instrument);
 			
 		hashtable->mem_for_metadata += alloc_size;
 		if (alloc_size > 0)
@@ -1415,36 +1457,28 @@ spill_hash_table(AggState *aggstate)
 			
 			CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
 		}
+	}
 
-		for (bucket_no = file_no; bucket_no < hashtable->nbuckets;
-			 bucket_no += spill_set->num_spill_files)
-		{
-			HashAggEntry *entry = hashtable->buckets[bucket_no];
-			
-			/* Ignore empty chains. */
-			if (entry == NULL) continue;
-			
-			/* Write all entries in the hash chain. */
-			while ( entry  != NULL )
-			{
-				HashAggEntry *spill_entry = entry;
-				entry = spill_entry->next;
-
-				if (spill_entry != NULL)
-				{
-					int32 written_bytes;
-					
-					written_bytes = writeHashEntry(aggstate, spill_file->file_info, spill_entry);
-					spill_file->file_info->ntuples++;
-					spill_file->file_info->total_bytes += written_bytes;
-
-					hashtable->num_spill_groups++;
-				}
-			}
+	/* Write all the entries in the slots. */
+	for (bucket_no = 0; bucket_no < hashtable->nbuckets; bucket_no++)
+	{
+		HashAggSlot *slot = &hashtable->buckets[bucket_no];
+		int32 written_bytes;
 
-			hashtable->buckets[bucket_no] = NULL;
-			hashtable->bloom[bucket_no] = 0;
-		}
+		/* Ignore empty slots. */
+		if (slot->entry == NULL)
+			continue;
+
+		spill_file = &spill_set->spill_files[SPILL_FILE_IDX(hashtable, spill_set,
+															slot->hashvalue)];
+
+		written_bytes = writeHashEntry(aggstate, spill_file->file_info, slot->entry);
+		spill_file->file_info->ntuples++;
+		spill_file->file_info->total_bytes += written_bytes;
+
+		hashtable->num_spill_groups++;
+
+		slot->entry = NULL;
 	}
 
 	/* Reset the buffer */
@@ -1463,9 +1497,7 @@ static void
 expand_hash_table(AggState *aggstate)
 {
 	unsigned mem_needed, old_nbuckets, bucket_idx, new_bucket_idx;
-	uint32 hashkey;
-	uint64 bloomval;
-	HashAggEntry *entry, *nextentry;
+	HashAggSlot *old_buckets;
 	HashAggTable *hashtable = aggstate->hhashtable;
 
 #ifdef USE_ASSERT_CHECKING
@@ -1475,11 +1507,11 @@ expand_hash_table(AggState *aggstate)
 	Assert(hashtable);
 	old_nbuckets = hashtable->nbuckets;
 
-	/* Make sure there is memory available for additional buckets */
+	/* Make sure there is memory available for additional slots */
 	mem_needed = old_nbuckets * OVERHEAD_PER_BUCKET;
 	if (mem_needed > AVAIL_MEM(hashtable) || hashtable->nbuckets > (UINT_MAX / 2))
 	{
-		/* Cannot double the buckets if there is not enough space */
+		/* Cannot double the slots if there is not enough space */
 		elog(HHA_MSG_LVL, "HashAgg: cannot grow the number of buckets!");
 		elog(HHA_MSG_LVL, "HashAgg: mem needed = %d available = %d; nbuckets = %d",
 				mem_needed, (unsigned) AVAIL_MEM(hashtable), hashtable->nbuckets);
@@ -1499,42 +1531,32 @@ expand_hash_table(AggState *aggstate)
 
 	Assert(GET_TOTAL_USED_SIZE(hashtable) < hashtable->max_mem);
 
-	hashtable->buckets = (HashAggBucket *) repalloc(hashtable->buckets,
-		hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom =  (uint64 *) repalloc(hashtable->bloom,
-		hashtable->nbuckets * sizeof(uint64));
-
-	memset(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
-	memset(hashtable->buckets + old_nbuckets, 0, old_nbuckets * sizeof(HashAggBucket));
+	old_buckets = hashtable->buckets;
+	hashtable->buckets = (HashAggSlot *)
+		MemoryContextAllocZero(GetMemoryChunkContext(old_buckets),
+							   hashtable->nbuckets * sizeof(HashAggSlot));
 
-	/* Iterate all the entries from the hashtable move them as needed */
-	for(bucket_idx=0; bucket_idx < old_nbuckets; ++bucket_idx)
+	/* Insert all the entries again, into the slots of the larger table */
+	for (bucket_idx = 0; bucket_idx < old_nbuckets; ++bucket_idx)
 	{
-		entry = hashtable->buckets[bucket_idx];
-		hashtable->buckets[bucket_idx] = NULL;
+		HashAggSlot *slot = &old_buckets[bucket_idx];
 
-		while(entry != NULL)
-		{
-			nextentry = entry->next;
-			hashkey = entry->hashvalue;
-			bloomval = BLOOMVAL(hashkey);
-
-			new_bucket_idx = BUCKET_IDX(hashtable, hashkey);
+		if (slot->entry == NULL)
+			continue;
 
-			Assert(new_bucket_idx == bucket_idx ||
-					new_bucket_idx == bucket_idx + old_nbuckets);
+		new_bucket_idx = BUCKET_IDX(hashtable, slot->hashvalue);
+		while (hashtable->buckets[new_bucket_idx].entry != NULL)
+			new_bucket_idx = (new_bucket_idx + 1) & (hashtable->nbuckets - 1);
 
-			/* Insert this at the head of the bucket */
-			entry->next = hashtable->buckets[new_bucket_idx];
-			hashtable->buckets[new_bucket_idx] = entry;
-			hashtable->bloom[new_bucket_idx] |= bloomval;
+		hashtable->buckets[new_bucket_idx] = *slot;
 
-			entry = nextentry;
 #ifdef USE_ASSERT_CHECKING
-			++nentries;
+		++nentries;
 #endif
-		}
 	}
+
+	pfree(old_buckets);
+
 	hashtable->num_expansions++;
 	Assert(hashtable->mem_for_metadata > 0);
 	Assert(nentries == hashtable->num_entries);
@@ -1635,8 +1657,9 @@ writeHashEntry(AggState *aggstate, BatchFileInfo *file_info,
 
 /*
  * agg_hash_table_stat_upd
- *   Collect buckets and hash chain statistics of the in-memory hash table for
- *   EXPLAIN ANALYZE
+ *   Collect slots and probe length statistics of the in-memory hash table for
+ *   EXPLAIN ANALYZE. The probe length of an entry is the number of slots
+ *   visited to find it.
  */
 static void
 agg_hash_table_stat_upd(HashAggTable *hashtable)
@@ -1645,13 +1668,13 @@ agg_hash_table_stat_upd(HashAggTable *hashtable)
 
 	for (i = 0; i < hashtable->nbuckets; i++)
 	{
-		HashAggEntry   *entry = hashtable->buckets[i];
-		int             chainlength = 0;
+		HashAggSlot    *slot = &hashtable->buckets[i];
+		int             chainlength;
 
-		if (entry)
+		if (slot->entry)
 		{
-			for (chainlength = 0; entry; chainlength++)
-				entry = entry->next;
+			chainlength = ((i - BUCKET_IDX(hashtable, slot->hashvalue)) &
+						   (hashtable->nbuckets - 1)) + 1;
 			cdbexplain_agg_upd(&hashtable->chainlength, chainlength, i);
 		}
 	}
@@ -1670,7 +1693,6 @@ void init_agg_hash_iter(HashAggTable* hashtable)
 	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
 	
 	hashtable->curr_bucket_idx = -1;
-	hashtable->next_entry = NULL;
 }
 
 /* Function: agg_hash_iter
@@ -1686,7 +1708,7 @@ HashAggEntry *
 agg_hash_iter(AggState *aggstate)
 {
 	HashAggTable* hashtable = aggstate->hhashtable;
-	HashAggEntry *entry = hashtable->next_entry;
+	HashAggEntry *entry = NULL;
 	SpillSet *spill_set = hashtable->spill_set;
 	MemoryContext oldcxt;
 
@@ -1697,10 +1719,9 @@ agg_hash_iter(AggState *aggstate)
 	
 	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
 
-	while (entry == NULL &&
-		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
+	while (hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
 	{
-		entry = hashtable->buckets[hashtable->curr_bucket_idx];
+		entry = hashtable->buckets[hashtable->curr_bucket_idx].entry;
 		if (entry != NULL)
 		{
 			Assert(entry->is_primodial);
@@ -1709,11 +1730,7 @@ agg_hash_iter(AggState *aggstate)
 	}
 
 	if (entry != NULL)
-	{
 		hashtable->num_output_groups++;
-		hashtable->next_entry = entry->next;
-		entry->next = NULL;
-	}
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -1789,6 +1806,7 @@ agg_hash_stream(AggState *aggstate)
 		"HashAgg: streaming");
 
 	reset_agg_hash_table(aggstate, 0 /* don't reallocate buckets */);
+	aggstate->hhashtable->num_stream_tuples = 0;
 	
 	return agg_hash_initial_pass(aggstate);
 }
@@ -2210,6 +2228,11 @@ agg_hash_explain(AggState *aggstate)
 	HashAggTable *hashtable = aggstate->hhashtable;
 	StringInfo hbuf = aggstate->ss.ps.cdbexplainbuf;
 
+	if (hashtable->num_passthru_tuples > 0)
+		appendStringInfo(hbuf,
+				INT64_FORMAT " rows passed through without aggregating.\n",
+				hashtable->num_passthru_tuples);
+
 	/* If the hash table spilled */
 	if (hashtable->num_spill_groups > 0 )
 	{
@@ -2251,7 +2274,7 @@ Gpmon_ResetAggHashTable(AggState* aggstate)
 
 /* Function: reset_agg_hash_table
  *
- * Clear the hash table content anchored by the bucket array.
+ * Clear the hash table content anchored by the slot array.
  */
 void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 {
@@ -2265,7 +2288,7 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		"HashAgg: resetting " INT64_FORMAT "-entry hash table",
 		hashtable->num_ht_groups);
 
-	Assert(hashtable->buckets && hashtable->bloom);
+	Assert(hashtable->buckets);
 
 	/*
 	 * Determine whether to reallocate buckets. Especially avoid re-allocation if
@@ -2297,10 +2320,8 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		hashtable->hats.nentries = hats.nentries;
 
 		pfree(hashtable->buckets);
-		pfree(hashtable->bloom);
 
-		hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-		hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+		hashtable->buckets = (HashAggSlot *) palloc0(hashtable->nbuckets * sizeof(HashAggSlot));
 
 		hashtable->expandable = true;
 
@@ -2313,8 +2334,7 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 	else
 	{
 		/* No need to reallocated buckets. Reset to zero. */
-		MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggBucket));
-		MemSet(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
+		MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggSlot));
 	}
 
 	Assert(hashtable->mem_for_metadata > 0);
@@ -2352,7 +2372,6 @@ void destroy_agg_hash_table(AggState *aggstate)
 
 		/* destroy_batches(aggstate->hhashtable); */
 		pfree(aggstate->hhashtable->buckets);
-		pfree(aggstate->hhashtable->bloom);
 		if (aggstate->hhashtable->hashkey_buf)
 			pfree(aggstate->hhashtable->hashkey_buf);
 
@@ -72,6 +72,7 @@
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
+#include "optimizer/orcaplancache.h"
 #include "parser/parsetree.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
@@ -99,6 +100,7 @@
 
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbaocsam.h"
+#include "cdb/cdbbroadcastcache.h"
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbexplain.h"             /* cdbexplain_sendExecStats() */
@@ -299,6 +301,10 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 	if (query_info_collect_hook)
 		(*query_info_collect_hook)(METRICS_QUERY_START, queryDesc);
 
+	/* GPDB: time the plans of GPORCA that are compared with a baseline */
+	if (Gp_role == GP_ROLE_DISPATCH)
+		OrcaPlanBaselineStartExecution(queryDesc, eflags);
+
 	/**
 	 * Distribute memory to operators.
 	 */
@@ -327,6 +333,10 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 					PolicyEagerFreeAssignOperatorMemoryKB(queryDesc->plannedstmt,
 														  queryDesc->plannedstmt->query_mem);
 					break;
+				case RESMANAGER_MEMORY_POLICY_ESTIMATE:
+					PolicyEstimateAssignOperatorMemoryKB(queryDesc->plannedstmt,
+														 queryDesc->plannedstmt->query_mem);
+					break;
 				default:
 					Assert(IsResManagerMemoryPolicyNone());
 					break;
@@ -513,6 +523,7 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 
 			estate->es_sliceTable = sliceTable;
 			estate->es_cursorPositions = ddesc->cursorPositions;
+			estate->es_broadcastCacheKeys = ddesc->broadcastCacheKeys;
 
 			estate->currentSliceIdInPlan = slice->rootIndex;
 			estate->currentExecutingSliceId = slice->rootIndex;
@@ -659,6 +670,7 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 			{
 				queryDesc->ddesc->sliceTable = estate->es_sliceTable;
 				queryDesc->ddesc->oidAssignments = GetAssignedOidsForDispatch();
+				queryDesc->ddesc->broadcastCacheKeys = BroadcastCacheDispatchKeys(queryDesc);
 			}
 
 			/*
@@ -1153,6 +1165,9 @@ standard_ExecutorEnd(QueryDesc *queryDesc)
 
 	START_MEMORY_ACCOUNT(queryDesc->memoryAccountId);
 
+	if (Gp_role == GP_ROLE_DISPATCH)
+		OrcaPlanBaselineEndExecution(queryDesc);
+
 	if (DEBUG1 >= log_min_messages)
 	{
 		char		msec_str[32];
@@ -61,6 +61,7 @@
 #include "pgstat.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/typcache.h"
@@ -2540,6 +2541,281 @@ no_function_result:
 	return rsinfo.setResult;
 }
 
+/*
+ * State of a table function whose rows are returned as the function produces
+ * them, rather than materialized first.
+ */
+struct TableFunctionStream
+{
+	ExprContext *econtext;
+	TupleDesc	expectedDesc;
+	FunctionCallInfoData fcinfo;
+	ReturnSetInfo rsinfo;
+	bool		returnsTuple;
+	bool		first_call;
+	bool		done;			/* no more rows */
+	Oid			rowtypeid;		/* of the rows, if returnsTuple */
+	int32		rowtypmod;
+	Tuplestorestate *tupstore;	/* if the function materialized after all */
+};
+
+/*
+ *		ExecBeginTableFunctionStream
+ *
+ * Prepare to return the rows of a table function one by one, like
+ * ExecMakeTableFunctionResult() does before materializing them.  That's only
+ * possible for a call of a set-returning function, NULL is returned for other
+ * expressions.  The function may still materialize its result, which is then
+ * returned from its tuplestore.  The arguments of the function are evaluated
+ * in argContext, which must not be reset until the stream is ended.
+ */
+TableFunctionStream *
+ExecBeginTableFunctionStream(ExprState *funcexpr,
+							 ExprContext *econtext,
+							 MemoryContext argContext,
+							 TupleDesc expectedDesc)
+{
+	TableFunctionStream *stream;
+	FuncExprState *fcache;
+	ExprDoneCond argDone;
+	MemoryContext oldcontext;
+
+	if (funcexpr == NULL || !IsA(funcexpr, FuncExprState) ||
+		!IsA(funcexpr->expr, FuncExpr))
+		return NULL;
+
+	fcache = (FuncExprState *) funcexpr;
+	if (fcache->func.fn_oid == InvalidOid)
+	{
+		FuncExpr   *func = (FuncExpr *) fcache->xprstate.expr;
+
+		init_fcache(func->funcid, func->inputcollid, fcache,
+					econtext->ecxt_per_query_memory, false);
+	}
+
+	if (!fcache->func.fn_retset)
+		return NULL;
+
+	stream = (TableFunctionStream *)
+		MemoryContextAllocZero(econtext->ecxt_per_query_memory,
+							   sizeof(TableFunctionStream));
+	stream->econtext = econtext;
+	stream->expectedDesc = expectedDesc;
+	stream->returnsTuple = type_is_rowtype(exprType((Node *) funcexpr->expr));
+	stream->first_call = true;
+
+	/*
+	 * Prefer materialization, as ExecMakeTableFunctionResult() does, so that
+	 * SQL functions don't run their queries lazily, interleaved with ours.
+	 */
+	stream->rsinfo.type = T_ReturnSetInfo;
+	stream->rsinfo.econtext = econtext;
+	stream->rsinfo.expectedDesc = expectedDesc;
+	stream->rsinfo.allowedModes = (int) (SFRM_ValuePerCall | SFRM_Materialize | SFRM_Materialize_Preferred);
+	stream->rsinfo.returnMode = SFRM_ValuePerCall;
+	stream->rsinfo.setResult = NULL;
+	stream->rsinfo.setDesc = NULL;
+
+	InitFunctionCallInfoData(stream->fcinfo, &(fcache->func),
+							 list_length(fcache->args),
+							 fcache->fcinfo_data.fncollation,
+							 NULL, (Node *) &stream->rsinfo);
+
+	MemoryContextReset(argContext);
+	oldcontext = MemoryContextSwitchTo(argContext);
+	argDone = ExecEvalFuncArgs(&stream->fcinfo, fcache->args, econtext);
+	MemoryContextSwitchTo(oldcontext);
+
+	/* We don't allow sets in the arguments of the table function */
+	if (argDone != ExprSingleResult)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+
+	/* A strict function returns an empty set for NULL arguments */
+	if (fcache->func.fn_strict)
+	{
+		int			i;
+
+		for (i = 0; i < stream->fcinfo.nargs; i++)
+		{
+			if (stream->fcinfo.argnull[i])
+				stream->done = true;
+		}
+	}
+
+	return stream;
+}
+
+/*
+ *		ExecTableFunctionStreamNext
+ *
+ * Store the next row of the table function in the slot, whose descriptor is
+ * expectedDesc.  Returns false, with the slot cleared, after the last row.
+ */
+bool
+ExecTableFunctionStreamNext(TableFunctionStream *stream, TupleTableSlot *slot)
+{
+	ExprContext *econtext = stream->econtext;
+	PgStat_FunctionCallUsage fcusage;
+	MemoryContext oldcontext;
+	Datum		result;
+
+	ExecClearTuple(slot);
+
+	if (stream->done)
+		return false;
+
+	if (stream->tupstore != NULL)
+	{
+		if (!tuplestore_gettupleslot(stream->tupstore, true, false, slot))
+		{
+			stream->done = true;
+			return false;
+		}
+		return true;
+	}
+
+	CHECK_FOR_INTERRUPTS();
+
+	if (QueryFinishPending)
+	{
+		stream->done = true;
+		return false;
+	}
+
+	/* the caller resets the per-tuple context between the rows */
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	pgstat_init_function_usage(&stream->fcinfo, &fcusage);
+
+	stream->fcinfo.isnull = false;
+	stream->rsinfo.isDone = ExprSingleResult;
+	result = FunctionCallInvoke(&stream->fcinfo);
+
+	pgstat_end_function_usage(&fcusage,
+							  stream->rsinfo.isDone != ExprMultipleResult);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (stream->rsinfo.returnMode == SFRM_Materialize)
+	{
+		/* check we're on the same page as the function author */
+		if (!stream->first_call || stream->rsinfo.isDone != ExprSingleResult)
+			ereport(ERROR,
+					(errcode(ERRCODE_E_R_I_E_SRF_PROTOCOL_VIOLATED),
+					 errmsg("table-function protocol for materialize mode was not followed")));
+
+		if (stream->rsinfo.setDesc)
+		{
+			tupledesc_match(stream->expectedDesc, stream->rsinfo.setDesc);
+			if (stream->rsinfo.setDesc->tdrefcount == -1)
+				FreeTupleDesc(stream->rsinfo.setDesc);
+			stream->rsinfo.setDesc = NULL;
+		}
+
+		stream->first_call = false;
+		stream->tupstore = stream->rsinfo.setResult;
+		if (stream->tupstore == NULL)
+		{
+			stream->done = true;
+			return false;
+		}
+
+		tuplestore_rescan(stream->tupstore);
+		return ExecTableFunctionStreamNext(stream, slot);
+	}
+	else if (stream->rsinfo.returnMode != SFRM_ValuePerCall)
+		ereport(ERROR,
+				(errcode(ERRCODE_E_R_I_E_SRF_PROTOCOL_VIOLATED),
+				 errmsg("unrecognized table-function returnMode: %d",
+						(int) stream->rsinfo.returnMode)));
+
+	if (stream->rsinfo.isDone == ExprEndResult)
+	{
+		stream->done = true;
+		return false;
+	}
+
+	if (stream->returnsTuple)
+	{
+		HeapTupleHeader td;
+		HeapTupleData tmptup;
+
+		if (stream->fcinfo.isnull)
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("function returning set of rows cannot return null value")));
+
+		td = DatumGetHeapTupleHeader(result);
+
+		/*
+		 * Check the type of the first row against the expected one, and that
+		 * the others have the same, in case the type is RECORD.
+		 */
+		if (stream->first_call)
+		{
+			TupleDesc	tupdesc;
+
+			stream->rowtypeid = HeapTupleHeaderGetTypeId(td);
+			stream->rowtypmod = HeapTupleHeaderGetTypMod(td);
+
+			tupdesc = lookup_rowtype_tupdesc(stream->rowtypeid,
+											 stream->rowtypmod);
+			tupledesc_match(stream->expectedDesc, tupdesc);
+			ReleaseTupleDesc(tupdesc);
+		}
+		else if (HeapTupleHeaderGetTypeId(td) != stream->rowtypeid ||
+				 HeapTupleHeaderGetTypMod(td) != stream->rowtypmod)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATATYPE_MISMATCH),
+					 errmsg("rows returned by function are not all of the same row type")));
+
+		tmptup.t_len = HeapTupleHeaderGetDatumLength(td);
+		tmptup.t_data = td;
+
+		heap_deform_tuple(&tmptup, slot->tts_tupleDescriptor,
+						  slot->PRIVATE_tts_values, slot->PRIVATE_tts_isnull);
+	}
+	else
+	{
+		slot->PRIVATE_tts_values[0] = result;
+		slot->PRIVATE_tts_isnull[0] = stream->fcinfo.isnull;
+	}
+
+	stream->first_call = false;
+
+	/* a function returning set may still return its only row this way */
+	if (stream->rsinfo.isDone != ExprMultipleResult)
+		stream->done = true;
+
+	ExecStoreVirtualTuple(slot);
+
+	return true;
+}
+
+/*
+ *		ExecEndTableFunctionStream
+ *
+ * Release a stream, also when the function hasn't returned all its rows.
+ */
+void
+ExecEndTableFunctionStream(TableFunctionStream *stream)
+{
+	if (stream->tupstore != NULL)
+		tuplestore_end(stream->tupstore);
+	else if (!stream->done || stream->first_call)
+	{
+		/*
+		 * A function that didn't return its last row keeps its state until
+		 * the shutdown callbacks of the expression context are called.
+		 */
+		ReScanExprContext(stream->econtext);
+	}
+
+	pfree(stream);
+}
+
 
 /* ----------------------------------------------------------------
  *		ExecEvalFunc
@@ -2728,6 +3004,35 @@ static Datum ExecEvalFPStrict2_Int8Eq(FuncExprState *fstate, ExprContext *ctxt,
 	return BoolGetDatum(fstate->fp_datum[0] == fstate->fp_datum[1]);
 }
 
+/*
+ * The other comparisons of integers.  Like the equalities, they can't fail,
+ * so the fast paths can't differ from the functions.
+ */
+#define FP_STRICT2_CMP(name, type, op) \
+static Datum ExecEvalFPStrict2_##name(FuncExprState *fstate, ExprContext *ctxt, bool *isNull, ExprDoneCond *isDone) \
+{ \
+	ExecEvalFPStrict2Arg(fstate, ctxt, isNull, isDone); \
+	return BoolGetDatum( \
+			DatumGet##type(fstate->fp_datum[0]) op DatumGet##type(fstate->fp_datum[1]) \
+			); \
+}
+
+FP_STRICT2_CMP(Int2Ne, Int16, !=)
+FP_STRICT2_CMP(Int2Lt, Int16, <)
+FP_STRICT2_CMP(Int2Le, Int16, <=)
+FP_STRICT2_CMP(Int2Gt, Int16, >)
+FP_STRICT2_CMP(Int2Ge, Int16, >=)
+FP_STRICT2_CMP(Int4Ne, Int32, !=)
+FP_STRICT2_CMP(Int4Lt, Int32, <)
+FP_STRICT2_CMP(Int4Le, Int32, <=)
+FP_STRICT2_CMP(Int4Gt, Int32, >)
+FP_STRICT2_CMP(Int4Ge, Int32, >=)
+FP_STRICT2_CMP(Int8Ne, Int64, !=)
+FP_STRICT2_CMP(Int8Lt, Int64, <)
+FP_STRICT2_CMP(Int8Le, Int64, <=)
+FP_STRICT2_CMP(Int8Gt, Int64, >)
+FP_STRICT2_CMP(Int8Ge, Int64, >=)
+
 /* Some Oids that we want to fast path.  See pg_proc.h */
 #define INT2EQ_OID 63
 #define INT4EQ_OID 65
@@ -2750,12 +3055,37 @@ static void FastPathStrict2Func(Oid funcoid, FuncExprState *fstate)
 		INT4EQ_OID,
 		DATE_EQ_OID,
 		INT8EQ_OID,
+		F_INT2NE, F_INT2LT, F_INT2LE, F_INT2GT, F_INT2GE,
+		F_INT4NE, F_INT4LT, F_INT4LE, F_INT4GT, F_INT4GE,
+		F_DATE_NE, F_DATE_LT, F_DATE_LE, F_DATE_GT, F_DATE_GE,
+		F_INT8NE, F_INT8LT, F_INT8LE, F_INT8GT, F_INT8GE,
 	};
 	static ExprStateEvalFunc strict2func[] = {
 		(ExprStateEvalFunc) ExecEvalFPStrict2_Int2Eq,
 		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Eq,
 		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Eq, /* date_eq is int4 eq */
 		(ExprStateEvalFunc) ExecEvalFPStrict2_Int8Eq,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int2Ne,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int2Lt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int2Le,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int2Gt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int2Ge,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Ne,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Lt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Le,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Gt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Ge,
+		/* the date comparisons are int4 comparisons */
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Ne,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Lt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Le,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Gt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int4Ge,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int8Ne,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int8Lt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int8Le,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int8Gt,
+		(ExprStateEvalFunc) ExecEvalFPStrict2_Int8Ge,
 	};
 
 	int i;
@@ -2774,6 +3104,103 @@ static void FastPathStrict2Func(Oid funcoid, FuncExprState *fstate)
 	}
 }
 
+/*
+ * Constant arrays of the fast path with at least this many elements are
+ * sorted and deduplicated, and searched by binary search instead of a linear
+ * scan.  The order is arbitrary, the element only needs to be found.
+ */
+#define FP_SCALARARRAY_BSEARCH_MIN 16
+
+typedef struct FPScalarArrayStr
+{
+	int			len;
+	Datum		datum;
+} FPScalarArrayStr;
+
+static int
+fp_str_cmp(const char *a, int alen, const char *b, int blen)
+{
+	if (alen != blen)
+		return alen < blen ? -1 : 1;
+	return memcmp(a, b, alen);
+}
+
+static int
+fp_datum_qsort_cmp(const void *a, const void *b)
+{
+	Datum		da = *(const Datum *) a;
+	Datum		db = *(const Datum *) b;
+
+	if (da == db)
+		return 0;
+	return da < db ? -1 : 1;
+}
+
+static int
+fp_str_qsort_cmp(const void *a, const void *b)
+{
+	const FPScalarArrayStr *sa = (const FPScalarArrayStr *) a;
+	const FPScalarArrayStr *sb = (const FPScalarArrayStr *) b;
+
+	return fp_str_cmp(DatumGetPointer(sa->datum), sa->len,
+					  DatumGetPointer(sb->datum), sb->len);
+}
+
+/* Sort and deduplicate the elements of a large fast path array */
+static void
+FastPathScalarArraySort(ScalarArrayOpExprState *sstate, bool isstr)
+{
+	int			n = 0;
+	int			i;
+
+	if (sstate->fp_n < FP_SCALARARRAY_BSEARCH_MIN)
+		return;
+
+	if (!isstr)
+	{
+		qsort(sstate->fp_datum, sstate->fp_n, sizeof(Datum), fp_datum_qsort_cmp);
+
+		for (i = 0; i < sstate->fp_n; i++)
+		{
+			if (n == 0 || sstate->fp_datum[i] != sstate->fp_datum[n - 1])
+				sstate->fp_datum[n++] = sstate->fp_datum[i];
+		}
+	}
+	else
+	{
+		FPScalarArrayStr *elems;
+
+		elems = (FPScalarArrayStr *) palloc(sizeof(FPScalarArrayStr) * sstate->fp_n);
+		for (i = 0; i < sstate->fp_n; i++)
+		{
+			elems[i].len = sstate->fp_len[i];
+			elems[i].datum = sstate->fp_datum[i];
+		}
+
+		qsort(elems, sstate->fp_n, sizeof(FPScalarArrayStr), fp_str_qsort_cmp);
+
+		for (i = 0; i < sstate->fp_n; i++)
+		{
+			if (n > 0 && fp_str_qsort_cmp(&elems[i], &elems[n - 1]) == 0)
+				continue;
+			elems[n++] = elems[i];
+		}
+
+		for (i = 0; i < n; i++)
+		{
+			sstate->fp_len[i] = elems[i].len;
+			sstate->fp_datum[i] = elems[i].datum;
+		}
+		pfree(elems);
+	}
+
+	/*
+	 * The evaluation functions go back to the linear scan if deduplication
+	 * left a small array.
+	 */
+	sstate->fp_n = n;
+}
+
 static Datum
 ExecEvalFPScalarArrayInt(ScalarArrayOpExprState *sstate,
 					  ExprContext *econtext,
@@ -2810,6 +3237,26 @@ ExecEvalFPScalarArrayInt(ScalarArrayOpExprState *sstate,
 		d = Int16GetDatum(DatumGetInt16(d));
 	}
 
+	if (sstate->fp_n >= FP_SCALARARRAY_BSEARCH_MIN)
+	{
+		int			lo = 0;
+		int			hi = sstate->fp_n - 1;
+
+		while (lo <= hi)
+		{
+			int			mid = lo + (hi - lo) / 2;
+
+			if (d == sstate->fp_datum[mid])
+				return BoolGetDatum(true);
+			if (d < sstate->fp_datum[mid])
+				hi = mid - 1;
+			else
+				lo = mid + 1;
+		}
+
+		return BoolGetDatum(false);
+	}
+
 	for(i=0; i<sstate->fp_n; ++i)
 	{
 		if(d == sstate->fp_datum[i])
@@ -2862,6 +3309,35 @@ ExecEvalFPScalarArrayStr(ScalarArrayOpExprState *sstate,
 			--len;
 	}
 
+	if (sstate->fp_n >= FP_SCALARARRAY_BSEARCH_MIN)
+	{
+		int			lo = 0;
+		int			hi = sstate->fp_n - 1;
+
+		while (lo <= hi)
+		{
+			int			mid = lo + (hi - lo) / 2;
+			int			cmp;
+
+			cmp = fp_str_cmp(p, len, DatumGetPointer(sstate->fp_datum[mid]),
+							 sstate->fp_len[mid]);
+			if (cmp == 0)
+			{
+				ret = BoolGetDatum(true);
+				break;
+			}
+			if (cmp < 0)
+				hi = mid - 1;
+			else
+				lo = mid + 1;
+		}
+
+		if(tofree)
+			pfree(tofree);
+
+		return ret;
+	}
+
 	for(i=0; i<sstate->fp_n; ++i)
 	{
 		if(sstate->fp_len[i] != len)
@@ -3025,9 +3501,15 @@ static void FastPathScalarArrayOp(ScalarArrayOpExpr *opexpr, ScalarArrayOpExprSt
 
 	/* Now we are sure we can fast path this */
 	if (fnoid == INT2EQ_OID || fnoid == INT4EQ_OID || fnoid == INT8EQ_OID || fnoid == DATE_EQ_OID)
+	{
+		FastPathScalarArraySort(sstate, false);
 		sstate->fxprstate.xprstate.evalfunc = (ExprStateEvalFunc) ExecEvalFPScalarArrayInt;
+	}
 	else if (fnoid == TEXTEQ_OID || fnoid == BPCHAREQ_OID)
+	{
+		FastPathScalarArraySort(sstate, true);
 		sstate->fxprstate.xprstate.evalfunc = (ExprStateEvalFunc) ExecEvalFPScalarArrayStr;
+	}
 	else
 		Assert(!"Wrong optimize_funcoid");
 }
@@ -3213,6 +3695,279 @@ ExecEvalScalarArrayOp(ScalarArrayOpExprState *sstate,
 	return result;
 }
 
+/*
+ * Constant arrays of x = ANY (array) with at least this many elements are
+ * put into a hash table, or sorted if the operator isn't hashable, when the
+ * expression is initialized.
+ */
+#define SCALARARRAY_LOOKUP_MIN 16
+
+static int
+saop_lookup_sort_cmp(const void *a, const void *b, void *arg)
+{
+	ScalarArrayOpExprState *sstate = (ScalarArrayOpExprState *) arg;
+	ScalarArrayOpExpr *opexpr = (ScalarArrayOpExpr *) sstate->fxprstate.xprstate.expr;
+
+	return DatumGetInt32(FunctionCall2Coll(&sstate->lookup_rhs_proc,
+										   opexpr->inputcollid,
+										   *(const Datum *) a,
+										   *(const Datum *) b));
+}
+
+/* Call the operator of the expression on the scalar and an element */
+static bool
+saop_lookup_equal(ScalarArrayOpExprState *sstate, Datum scalar, Datum elem)
+{
+	FunctionCallInfo fcinfo = &sstate->fxprstate.fcinfo_data;
+	Datum		result;
+
+	fcinfo->arg[0] = scalar;
+	fcinfo->arg[1] = elem;
+	fcinfo->argnull[0] = false;
+	fcinfo->argnull[1] = false;
+	fcinfo->isnull = false;
+	result = FunctionCallInvoke(fcinfo);
+
+	return !fcinfo->isnull && DatumGetBool(result);
+}
+
+/*
+ * ExecEvalScalarArrayOpLookup
+ *
+ * Evaluate "scalar op ANY (constant array)" by looking the scalar up among
+ * the elements prepared by InitScalarArrayOpLookup.
+ */
+static Datum
+ExecEvalScalarArrayOpLookup(ScalarArrayOpExprState *sstate,
+							ExprContext *econtext,
+							bool *isNull, ExprDoneCond *isDone)
+{
+	ScalarArrayOpExpr *opexpr = (ScalarArrayOpExpr *) sstate->fxprstate.xprstate.expr;
+	ExprState  *arg = linitial(sstate->fxprstate.args);
+	ExprDoneCond argDone;
+	Datum		scalar;
+	bool		scalarnull;
+	bool		found = false;
+
+	*isNull = false;
+	if (isDone)
+		*isDone = ExprSingleResult;
+
+	scalar = ExecEvalExpr(arg, econtext, &scalarnull, &argDone);
+	if (argDone != ExprSingleResult)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+			   errmsg("op ANY/ALL (array) does not support set arguments")));
+
+	/* The operator is strict, and the array isn't empty */
+	if (scalarnull)
+	{
+		*isNull = true;
+		return (Datum) 0;
+	}
+
+	if (sstate->lookup_hashed)
+	{
+		uint32		mask = sstate->lookup_n - 1;
+		uint32		hash;
+		uint32		i;
+
+		hash = DatumGetUInt32(FunctionCall1Coll(&sstate->lookup_lhs_proc,
+												opexpr->inputcollid,
+												scalar));
+		for (i = hash & mask; sstate->lookup_used[i]; i = (i + 1) & mask)
+		{
+			if (sstate->lookup_hashes[i] == hash &&
+				saop_lookup_equal(sstate, scalar, sstate->lookup_elems[i]))
+			{
+				found = true;
+				break;
+			}
+		}
+	}
+	else
+	{
+		int			lo = 0;
+		int			hi = sstate->lookup_n - 1;
+
+		while (lo <= hi)
+		{
+			int			mid = lo + (hi - lo) / 2;
+			int32		cmp;
+
+			cmp = DatumGetInt32(FunctionCall2Coll(&sstate->lookup_lhs_proc,
+												  opexpr->inputcollid,
+												  scalar,
+												  sstate->lookup_elems[mid]));
+			if (cmp == 0)
+			{
+				found = saop_lookup_equal(sstate, scalar,
+										  sstate->lookup_elems[mid]);
+				break;
+			}
+			if (cmp < 0)
+				hi = mid - 1;
+			else
+				lo = mid + 1;
+		}
+	}
+
+	if (found)
+		return BoolGetDatum(true);
+
+	/* Not found, the NULL elements make the result unknown */
+	if (sstate->lookup_has_nulls)
+	{
+		*isNull = true;
+		return (Datum) 0;
+	}
+
+	return BoolGetDatum(false);
+}
+
+/*
+ * InitScalarArrayOpLookup
+ *
+ * Evaluate "scalar op ANY (constant array)" of a large array with a hash
+ * table of the elements, or by binary search after sorting them with the
+ * btree opfamily of the operator if it isn't hashable.  Either is built
+ * once here, in the memory of the expression state, instead of scanning the
+ * array for each row.
+ */
+static void
+InitScalarArrayOpLookup(ScalarArrayOpExpr *opexpr, ScalarArrayOpExprState *sstate)
+{
+	ExprState  *argstate;
+	Const	   *argconst;
+	ArrayType  *arr;
+	Oid			lhs_proc = InvalidOid;
+	Oid			rhs_proc = InvalidOid;
+	bool		hashed;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems;
+	int			n = 0;
+	int			i;
+
+	if (!opexpr->useOr || list_length(sstate->fxprstate.args) != 2)
+		return;
+
+	argstate = (ExprState *) lsecond(sstate->fxprstate.args);
+	if (argstate->evalfunc != ExecEvalConst)
+		return;
+
+	argconst = (Const *) argstate->expr;
+	if (argconst->constisnull)
+		return;
+
+	arr = DatumGetArrayTypeP(argconst->constvalue);
+	if (ArrayGetNItems(ARR_NDIM(arr), ARR_DIMS(arr)) < SCALARARRAY_LOOKUP_MIN)
+		return;
+
+	/* NULL elements could only match an operator that isn't strict */
+	if (!func_strict(opexpr->opfuncid))
+		return;
+
+	hashed = get_op_hash_functions(opexpr->opno, &lhs_proc, &rhs_proc);
+	if (!hashed)
+	{
+		ListCell   *lc;
+
+		foreach(lc, get_op_btree_interpretation(opexpr->opno))
+		{
+			OpBtreeInterpretation *interp = (OpBtreeInterpretation *) lfirst(lc);
+
+			if (interp->strategy != BTEqualStrategyNumber)
+				continue;
+
+			lhs_proc = get_opfamily_proc(interp->opfamily_id,
+										 interp->oplefttype,
+										 interp->oprighttype,
+										 BTORDER_PROC);
+			rhs_proc = get_opfamily_proc(interp->opfamily_id,
+										 interp->oprighttype,
+										 interp->oprighttype,
+										 BTORDER_PROC);
+			if (OidIsValid(lhs_proc) && OidIsValid(rhs_proc))
+				break;
+		}
+
+		if (!OidIsValid(lhs_proc) || !OidIsValid(rhs_proc))
+			return;
+	}
+
+	init_fcache(opexpr->opfuncid, opexpr->inputcollid, &sstate->fxprstate,
+				CurrentMemoryContext, true);
+	fmgr_info(lhs_proc, &sstate->lookup_lhs_proc);
+	fmgr_info(rhs_proc, &sstate->lookup_rhs_proc);
+
+	get_typlenbyvalalign(ARR_ELEMTYPE(arr),
+						 &sstate->typlen,
+						 &sstate->typbyval,
+						 &sstate->typalign);
+	sstate->element_type = ARR_ELEMTYPE(arr);
+	deconstruct_array(arr, sstate->element_type, sstate->typlen,
+					  sstate->typbyval, sstate->typalign,
+					  &elems, &nulls, &nelems);
+
+	sstate->lookup_hashed = hashed;
+	sstate->lookup_has_nulls = false;
+
+	if (hashed)
+	{
+		uint32		mask;
+
+		/* keep the table at most half full */
+		sstate->lookup_n = 1;
+		while (sstate->lookup_n < 2 * nelems)
+			sstate->lookup_n <<= 1;
+		mask = sstate->lookup_n - 1;
+
+		sstate->lookup_elems = (Datum *) palloc(sizeof(Datum) * sstate->lookup_n);
+		sstate->lookup_hashes = (uint32 *) palloc(sizeof(uint32) * sstate->lookup_n);
+		sstate->lookup_used = (bool *) palloc0(sizeof(bool) * sstate->lookup_n);
+
+		for (i = 0; i < nelems; i++)
+		{
+			uint32		hash;
+			uint32		slot;
+
+			if (nulls[i])
+			{
+				sstate->lookup_has_nulls = true;
+				continue;
+			}
+
+			hash = DatumGetUInt32(FunctionCall1Coll(&sstate->lookup_rhs_proc,
+													opexpr->inputcollid,
+													elems[i]));
+			for (slot = hash & mask; sstate->lookup_used[slot]; slot = (slot + 1) & mask)
+				;
+			sstate->lookup_used[slot] = true;
+			sstate->lookup_hashes[slot] = hash;
+			sstate->lookup_elems[slot] = elems[i];
+		}
+		pfree(elems);
+	}
+	else
+	{
+		for (i = 0; i < nelems; i++)
+		{
+			if (nulls[i])
+				sstate->lookup_has_nulls = true;
+			else
+				elems[n++] = elems[i];
+		}
+
+		qsort_arg(elems, n, sizeof(Datum), saop_lookup_sort_cmp, sstate);
+		sstate->lookup_elems = elems;
+		sstate->lookup_n = n;
+	}
+	pfree(nulls);
+
+	sstate->fxprstate.xprstate.evalfunc = (ExprStateEvalFunc) ExecEvalScalarArrayOpLookup;
+}
+
 /* ----------------------------------------------------------------
  *		ExecEvalNot
  *		ExecEvalOr
@@ -5560,6 +6315,8 @@ ExecInitExpr(Expr *node, PlanState *parent)
 				sstate->element_type = InvalidOid;		/* ditto */
 
 				FastPathScalarArrayOp(opexpr, sstate);
+				if (sstate->fxprstate.xprstate.evalfunc == (ExprStateEvalFunc) ExecEvalScalarArrayOp)
+					InitScalarArrayOpLookup(opexpr, sstate);
 				state = (ExprState *) sstate;
 			}
 			break;
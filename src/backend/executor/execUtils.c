@@ -50,9 +50,12 @@
 #include "access/relscan.h"
 #include "access/transam.h"
 #include "catalog/index.h"
+#include "catalog/pg_type.h"
 #include "executor/execdebug.h"
 #include "executor/execUtils.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/walkers.h"
 #include "parser/parsetree.h"
 #include "storage/lmgr.h"
 #include "utils/memutils.h"
@@ -1763,6 +1766,91 @@ ShouldPrefetchJoinQual(EState *estate, Join *join)
 							 estate->currentSliceIdInPlan));
 }
 
+/*
+ * Can results computed from parameter values of this type be cached, keyed
+ * by the parameter values?
+ *
+ * The plan must not be able to tell apart parameter values that the hash
+ * table considers equal, so only accept types whose equal values are
+ * identical.  (Numerics 1.0 and 1.00 are equal but print differently, for
+ * example.)
+ */
+bool
+ExecIsMemoizableType(Oid typid)
+{
+	switch (typid)
+	{
+		case BOOLOID:
+		case CHAROID:
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case OIDOID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case TEXTOID:
+		case VARCHAROID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+typedef struct VolatileWalkerContext
+{
+	plan_tree_base_prefix base;
+	bool		inexpr;			/* already checked the enclosing expression */
+} VolatileWalkerContext;
+
+/*
+ * contain_volatile_functions() searches each expression but doesn't descend
+ * into SubPlans, so we call it once per expression of a plan node, and only
+ * look for SubPlans below that.
+ */
+static bool
+contain_volatile_functions_plan_walker(Node *node,
+									   VolatileWalkerContext *context)
+{
+	bool		inexpr = context->inexpr;
+	bool		result;
+
+	if (node == NULL)
+		return false;
+
+	if (is_plan_node(node))
+		context->inexpr = false;
+	else if (!inexpr && !IsA(node, List) && !IsA(node, IntList) &&
+			 !IsA(node, OidList) && !IsA(node, Flow))
+	{
+		if (contain_volatile_functions(node))
+			return true;
+		context->inexpr = true;
+	}
+
+	result = plan_tree_walker(node, contain_volatile_functions_plan_walker,
+							  context);
+	context->inexpr = inexpr;
+
+	return result;
+}
+
+/*
+ * Does a plan tree, or any of the subplans and expressions in it, call a
+ * volatile function?  Such a plan may return different rows each time it
+ * is run, even with the same parameter values.
+ */
+bool
+ExecPlanContainsVolatileFunctions(EState *estate, Plan *plan)
+{
+	VolatileWalkerContext context;
+
+	exec_init_plan_tree_base(&context.base, estate->es_plannedstmt);
+	context.inexpr = false;
+
+	return contain_volatile_functions_plan_walker((Node *) plan, &context);
+}
+
 /* ----------------------------------------------------------------
  *		CDB Slice Table utilities
  * ----------------------------------------------------------------
@@ -15,6 +15,7 @@
  */
 #include "postgres.h"
 
+#include <time.h>
 #include <unistd.h>
 
 #include "cdb/cdbvars.h"
@@ -68,16 +69,61 @@ InstrAlloc(int n, int instrument_options)
 	return instr;
 }
 
+/*
+ * CPU time of the process in seconds, or 0 if the platform can't tell.
+ * The executor of a process runs on a single thread.
+ */
+static double
+InstrCpuTime(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+		return (double) ts.tv_sec + (double) ts.tv_nsec / 1000000000.0;
+#endif
+	return 0.0;
+}
+
+/*
+ * Estimate the time of all the calls of a run cycle from the timed ones,
+ * given the time of the first call, which is always timed because it
+ * usually includes the startup of the node.
+ */
+static double
+InstrExtrapolate(Instrumentation *instr, double timed, double first)
+{
+	if (instr->nsampled <= 1 || instr->nsampled >= instr->ncalls)
+		return timed;
+
+	return first + (timed - first) * (double) (instr->ncalls - 1) /
+		(double) (instr->nsampled - 1);
+}
+
 /* Entry to a plan node */
 void
 InstrStartNode(Instrumentation *instr)
 {
 	if (instr->need_timer)
 	{
-		if (INSTR_TIME_IS_ZERO(instr->starttime))
-			INSTR_TIME_SET_CURRENT(instr->starttime);
-		else
-			elog(ERROR, "InstrStartNode called twice in a row");
+		/*
+		 * CDB: with gp_explain_timing_sample_rate, only the first call and
+		 * every Nth call after it are timed.
+		 */
+		instr->sampled = (instr->ncalls == 0 ||
+						  instr->ncalls % gp_explain_timing_sample_rate == 0);
+		instr->ncalls++;
+
+		if (instr->sampled)
+		{
+			if (INSTR_TIME_IS_ZERO(instr->starttime))
+			{
+				INSTR_TIME_SET_CURRENT(instr->starttime);
+				instr->cpustart = InstrCpuTime();
+			}
+			else
+				elog(ERROR, "InstrStartNode called twice in a row");
+		}
 	}
 
 	/* save buffer usage totals at node entry, if needed */
@@ -98,15 +144,18 @@ InstrStopNode(Instrumentation *instr, uint64 nTuples)
 	instr->tuplecount += nTuples;
 
 	/* let's update the time only if the timer was requested */
-	if (instr->need_timer)
+	if (instr->need_timer && instr->sampled)
 	{
 		if (INSTR_TIME_IS_ZERO(instr->starttime))
 			elog(ERROR, "InstrStopNode called without start");
 
 		INSTR_TIME_SET_CURRENT(endtime);
 		INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
+		instr->cpucounter += InstrCpuTime() - instr->cpustart;
+		instr->nsampled++;
 
 		INSTR_TIME_SET_ZERO(instr->starttime);
+		instr->sampled = false;
 	}
 
 	/* Add delta of buffer usage since entry to node's totals */
@@ -121,6 +170,8 @@ InstrStopNode(Instrumentation *instr, uint64 nTuples)
 		instr->firsttuple = INSTR_TIME_GET_DOUBLE(instr->counter);
 		/* CDB: save this start time as the first start */
 		instr->firststart = starttime;
+		/* CDB: and the CPU time of the first call, to extrapolate */
+		instr->cpufirst = instr->cpucounter;
 	}
 }
 
@@ -138,13 +189,15 @@ InstrEndLoop(Instrumentation *instr)
 		elog(ERROR, "InstrEndLoop called on running node");
 
 	/* Accumulate per-cycle statistics into totals */
-	totaltime = INSTR_TIME_GET_DOUBLE(instr->counter);
+	totaltime = InstrExtrapolate(instr, INSTR_TIME_GET_DOUBLE(instr->counter),
+								 instr->firsttuple);
 
 	/* CDB: Report startup time from only the first cycle. */
 	if (instr->nloops == 0)
 		instr->startup = instr->firsttuple;
 
 	instr->total += totaltime;
+	instr->cputime += InstrExtrapolate(instr, instr->cpucounter, instr->cpufirst);
 	instr->ntuples += instr->tuplecount;
 	instr->nloops += 1;
 
@@ -154,6 +207,11 @@ InstrEndLoop(Instrumentation *instr)
 	INSTR_TIME_SET_ZERO(instr->counter);
 	instr->firsttuple = 0;
 	instr->tuplecount = 0;
+	instr->sampled = false;
+	instr->ncalls = 0;
+	instr->nsampled = 0;
+	instr->cpucounter = 0;
+	instr->cpufirst = 0;
 }
 
 /* dst += add - sub */
@@ -128,6 +128,8 @@
 #include "executor/executor.h"
 #include "executor/execHHashagg.h"
 #include "executor/nodeAgg.h"
+#include "executor/nodeExternalscan.h"
+#include "executor/nodeIndexonlyscan.h"
 #include "lib/stringinfo.h"             /* StringInfo */
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
@@ -138,6 +140,7 @@
 #include "parser/parse_coerce.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
@@ -185,10 +188,12 @@ static void finalize_aggregate(AggState *aggstate,
 				   AggStatePerGroup pergroupstate,
 				   Datum *resultVal, bool *resultIsNull);
 static Bitmapset *find_unaggregated_cols(AggState *aggstate);
+static ExternalScanAggType get_external_scan_agg_type(AggState *aggstate);
 static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void clear_agg_object(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_passthrough(AggState *aggstate);
 static void ExecAggExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static void ExecEagerFreeAgg(AggState *node);
 
@@ -468,6 +473,67 @@ invoke_agg_trans_func(AggState *aggstate,
 		}
 	}
 
+#ifdef USE_FLOAT8_BYVAL
+	/*
+	 * The transition functions of COUNT and of SUM of int2 and int4 are
+	 * computed here rather than called through the function manager for
+	 * each input row.  Their transition values are int8, so these must do
+	 * exactly what int8inc(), int8inc_any(), int2_sum() and int4_sum() do
+	 * when int8 is passed by value.
+	 */
+	switch (transfn->fn_oid)
+	{
+		case F_INT8INC:
+		case F_INT8INC_ANY:
+			{
+				/* strict, so neither the input nor the count is NULL here */
+				int64		arg = DatumGetInt64(transValue);
+				int64		result = arg + 1;
+
+				/* Overflow check */
+				if (result < 0 && arg > 0)
+					ereport(ERROR,
+							(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+							 errmsg("bigint out of range")));
+
+				fcinfo->isnull = false;
+				*transValueIsNull = false;
+				*noTransvalue = false;
+				return Int64GetDatum(result);
+			}
+
+		case F_INT2_SUM:
+		case F_INT4_SUM:
+			{
+				int64		newval;
+
+				if (fcinfo->argnull[1])
+				{
+					/* leave the sum unchanged, NULL if there's none yet */
+					fcinfo->isnull = *transValueIsNull;
+					if (!fcinfo->isnull)
+						*noTransvalue = false;
+					return transValue;
+				}
+
+				if (transfn->fn_oid == F_INT2_SUM)
+					newval = (int64) DatumGetInt16(fcinfo->arg[1]);
+				else
+					newval = (int64) DatumGetInt32(fcinfo->arg[1]);
+				if (!*transValueIsNull)
+					newval += DatumGetInt64(transValue);
+
+				fcinfo->isnull = false;
+				*transValueIsNull = false;
+				*noTransvalue = false;
+				return Int64GetDatum(newval);
+			}
+
+		default:
+			break;
+	}
+#endif
+
 	/* We run the transition functions in per-input-tuple memory context */
 	oldContext = MemoryContextSwitchTo(tuplecontext);
 
@@ -990,6 +1056,56 @@ find_unaggregated_cols(AggState *aggstate)
 	return colnos;
 }
 
+/*
+ * get_external_scan_agg_type
+ *	  Check if the aggregates of the Agg are only COUNT(*), or only MIN and
+ *	  MAX of input columns, computed in one group over all the input rows.
+ */
+static ExternalScanAggType
+get_external_scan_agg_type(AggState *aggstate)
+{
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	bool		count_only = true;
+	bool		minmax_only = true;
+	int			aggno;
+
+	if (node->aggstrategy != AGG_PLAIN || node->numCols != 0 ||
+		node->combineStates || node->inputHasGrouping ||
+		aggstate->numaggs == 0 || !bms_is_empty(find_unaggregated_cols(aggstate)))
+		return EXTSCAN_AGG_NONE;
+
+	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+	{
+		Aggref	   *aggref = aggstate->peragg[aggno].aggref;
+		HeapTuple	aggTuple;
+		Oid			aggsortop;
+
+		if (aggref->aggdistinct != NIL || aggref->aggorder != NIL ||
+			aggref->aggfilter != NULL || aggref->aggkind != AGGKIND_NORMAL)
+			return EXTSCAN_AGG_NONE;
+
+		if (!aggref->aggstar || aggref->aggfnoid != COUNT_STAR_OID)
+			count_only = false;
+
+		/* MIN and MAX are the aggregates with a sort operator */
+		aggTuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+		if (!HeapTupleIsValid(aggTuple))
+			elog(ERROR, "cache lookup failed for aggregate %u",
+				 aggref->aggfnoid);
+		aggsortop = ((Form_pg_aggregate) GETSTRUCT(aggTuple))->aggsortop;
+		ReleaseSysCache(aggTuple);
+
+		if (!OidIsValid(aggsortop) || list_length(aggref->args) != 1 ||
+			!IsA(((TargetEntry *) linitial(aggref->args))->expr, Var))
+			minmax_only = false;
+
+		if (!count_only && !minmax_only)
+			return EXTSCAN_AGG_NONE;
+	}
+
+	return count_only ? EXTSCAN_AGG_COUNT : EXTSCAN_AGG_MINMAX;
+}
+
 static bool
 find_unaggregated_cols_walker(Node *node, Bitmapset **colnos)
 {
@@ -1168,7 +1284,8 @@ ExecAgg(AggState *node)
 		 */
 		for (;;)
 		{
-			if (!node->hhashtable->is_spilling)
+			if (!node->hhashtable->is_spilling &&
+				node->hashaggstatus != HASHAGG_PASSTHROUGH)
 			{
 				tuple = agg_retrieve_hash_table(node);
 				node->agg_done = false; /* Not done 'til batches used up. */
@@ -1204,10 +1321,20 @@ ExecAgg(AggState *node)
 
 				case HASHAGG_STREAMING:
 					Assert(streaming);
-					if (!agg_hash_stream(node))
+					if (node->hhashtable->passthrough)
+						node->hashaggstatus = HASHAGG_PASSTHROUGH;
+					else if (!agg_hash_stream(node))
 						node->hashaggstatus = HASHAGG_END_OF_PASSES;
 					continue;
 
+				case HASHAGG_PASSTHROUGH:
+					Assert(streaming);
+					tuple = agg_retrieve_passthrough(node);
+					if (tuple != NULL)
+						return tuple;
+					node->hashaggstatus = HASHAGG_END_OF_PASSES;
+					continue;
+
 				case HASHAGG_BEFORE_FIRST_PASS:
 				default:
 					elog(ERROR, "hybrid hash aggregation sequencing error");
@@ -1829,6 +1956,88 @@ agg_retrieve_hash_table(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * ExecAgg for hashed case: pass the remaining input tuples through, each one
+ * as a group of its own.  The lower stage of a streaming aggregate switches to
+ * this when its hash table hardly reduces the input, see agg_hash_initial_pass.
+ *
+ * The transition values only live in the per-input-tuple memory, until the
+ * next call.
+ */
+static TupleTableSlot *
+agg_retrieve_passthrough(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	Datum	   *aggvalues = econtext->ecxt_aggvalues;
+	bool	   *aggnulls = econtext->ecxt_aggnulls;
+	AggStatePerGroup pergroup = aggstate->pergroup;
+	TupleTableSlot *outerslot;
+	int			aggno;
+
+	Assert(aggstate->passthrough_ok && pergroup != NULL);
+
+	aggstate->mem_manager.alloc = cxt_alloc;
+	aggstate->mem_manager.free = cxt_free;
+	aggstate->mem_manager.manager = tmpcontext->ecxt_per_tuple_memory;
+	aggstate->mem_manager.realloc_ratio = 1;
+
+	for (;;)
+	{
+		/* The tuple the hash table had no room for comes first */
+		if (hashtable->prev_slot != NULL)
+		{
+			outerslot = hashtable->prev_slot;
+			hashtable->prev_slot = NULL;
+		}
+		else
+			outerslot = ExecProcNode(outerPlanState(aggstate));
+
+		if (TupIsNull(outerslot))
+			return NULL;
+
+		ResetExprContext(econtext);
+		ResetExprContext(tmpcontext);
+
+		/* The old transition values are gone with the per-tuple memory */
+		MemSet(pergroup, 0, sizeof(AggStatePerGroupData) * aggstate->numaggs);
+
+		tmpcontext->ecxt_outertuple = outerslot;
+		initialize_aggregates(aggstate, aggstate->peragg, pergroup);
+		advance_aggregates(aggstate, pergroup);
+
+		hashtable->num_tuples++;
+		hashtable->num_passthru_tuples++;
+
+		for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+			finalize_aggregate(aggstate, &aggstate->peragg[aggno], &pergroup[aggno],
+							   &aggvalues[aggno], &aggnulls[aggno]);
+
+		econtext->ecxt_outertuple = outerslot;
+		econtext->group_id = node->rollupGSTimes;
+		econtext->grouping = node->grouping;
+
+		if (ExecQual(aggstate->ss.ps.qual, econtext, false))
+		{
+			TupleTableSlot *result;
+			ExprDoneCond isDone;
+
+			result = ExecProject(aggstate->ss.ps.ps_ProjInfo, &isDone);
+
+			if (isDone != ExprEndResult)
+			{
+				aggstate->ps_TupFromTlist =
+					(isDone == ExprMultipleResult);
+				return result;
+			}
+		}
+		else
+			InstrCountFiltered1(aggstate, 1);
+	}
+}
+
 /* -----------------
  * ExecInitAgg
  *
@@ -1868,6 +2077,7 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->pergroup = NULL;
 	aggstate->grp_firstTuple = NULL;
 	aggstate->hashtable = NULL;
+	aggstate->passthrough_ok = false;
 
 	/*
 	 * Create expression contexts.  We need two, one for per-input-tuple
@@ -1964,6 +2174,15 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		numaggs = 1;
 	}
 
+	/*
+	 * Without aggregates, sorted grouping on a single column only needs the
+	 * first tuple of each group, an index-only scan below can skip the rest.
+	 */
+	if (node->aggstrategy == AGG_SORTED && aggstate->numaggs == 0 &&
+		node->numCols == 1 && !node->inputHasGrouping)
+		ExecIndexOnlyScanSkipDistinct(outerPlanState(aggstate),
+									  node->grpColIdx[0], eflags);
+
 	/*
 	 * If we are grouping, precompute fmgr lookup data for inner loop. We need
 	 * both equality and hashing functions to do it by hashing, but only
@@ -1996,6 +2215,17 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	if (node->aggstrategy == AGG_HASHED)
 	{
 		aggstate->hash_needed = find_hash_columns(aggstate);
+
+		/*
+		 * A streaming lower stage may pass input tuples through, using
+		 * pergroup for each of them.  Not with aggregates that keep their
+		 * state in the aggcontext, checked below.
+		 */
+		aggstate->passthrough_ok = node->streaming && !node->inputHasGrouping &&
+			gp_hashagg_passthrough_ratio < 1.0;
+		if (aggstate->passthrough_ok)
+			aggstate->pergroup = (AggStatePerGroup)
+				palloc0(sizeof(AggStatePerGroupData) * numaggs);
 	}
 	else
 	{
@@ -2239,6 +2469,8 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		 */
 		if (aggtranstype == INTERNALOID)
 		{
+			aggstate->passthrough_ok = false;
+
 			/*
 			 * The planner should only have generated a serialize agg node if
 			 * every aggregate with an INTERNAL state has a serialization
@@ -2452,6 +2684,13 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	/* Update numaggs to match number of unique aggregates found */
 	aggstate->numaggs = aggno + 1;
 
+	/*
+	 * COUNT(*), MIN and MAX without grouping may be answered by the protocol
+	 * of an external scan below, from the statistics of its data.
+	 */
+	ExecExternalScanPushdownAggs(outerPlanState(aggstate),
+								 get_external_scan_agg_type(aggstate));
+
 	/* MPP */
 	aggstate->hhashtable = NULL;
 
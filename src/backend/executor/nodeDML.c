@@ -22,11 +22,22 @@
 #include "executor/execDML.h"
 #include "executor/instrument.h"
 #include "executor/nodeDML.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 
 /* DML default memory */
 #define DML_MEM 1
 
+/* Tuples buffered for a target partition */
+typedef struct DMLBatchPart
+{
+	ResultRelInfo *resultRelInfo;	/* hash key, must be first */
+	List	   *tuples;				/* HeapTuples, in input order */
+} DMLBatchPart;
+
+static void ExecDMLBufferInsert(DMLState *node);
+static void ExecDMLFlushInserts(DMLState *node);
+
 /*
  * Estimated Memory Usage of DML Node.
  * */
@@ -55,6 +66,8 @@ ExecDML(DMLState *node)
 
 	if (TupIsNull(slot))
 	{
+		if (node->batchInserts)
+			ExecDMLFlushInserts(node);
 		return NULL;
 	}
 
@@ -115,13 +128,16 @@ ExecDML(DMLState *node)
 		 * actions depending on the type of plan (constraint enforcement and
 		 * triggers.)
 		 */
-		ExecInsert(node->cleanedUpSlot,
-				   NULL,
-				   node->ps.state,
-				   true, /* GPDB_91_MERGE_FIXME: canSetTag, where to get this? */
-				   PLANGEN_OPTIMIZER /* Plan origin */,
-				   isUpdate,
-				   InvalidOid);
+		if (node->batchInserts)
+			ExecDMLBufferInsert(node);
+		else
+			ExecInsert(node->cleanedUpSlot,
+					   NULL,
+					   node->ps.state,
+					   true, /* GPDB_91_MERGE_FIXME: canSetTag, where to get this? */
+					   PLANGEN_OPTIMIZER /* Plan origin */,
+					   isUpdate,
+					   InvalidOid);
 	}
 	else /* DML_DELETE */
 	{
@@ -147,6 +163,97 @@ ExecDML(DMLState *node)
 	return slot;
 }
 
+/*
+ * Buffer the tuple in cleanedUpSlot for its target partition.
+ *
+ * Inserting the tuples of a partitioned table one by one, as they come,
+ * keeps switching the segment file and the column encoders being appended
+ * to.  The tuples are buffered per partition instead, and the buffers are
+ * inserted one partition after the other once gp_dml_insert_batch_mem is
+ * used up, so that each partition gets appended a block of tuples at a time.
+ */
+static void
+ExecDMLBufferInsert(DMLState *node)
+{
+	ResultRelInfo *resultRelInfo;
+	DMLBatchPart *part;
+	MemoryContext oldcxt;
+	HeapTuple	tuple;
+	bool		found;
+
+	/* errors out if the tuple has no partition, just as ExecInsert would */
+	resultRelInfo = slot_get_partition(node->cleanedUpSlot, node->ps.state);
+
+	oldcxt = MemoryContextSwitchTo(node->batchContext);
+
+	if (node->batchHash == NULL)
+	{
+		HASHCTL		hash_ctl;
+
+		MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+		hash_ctl.keysize = sizeof(ResultRelInfo *);
+		hash_ctl.entrysize = sizeof(DMLBatchPart);
+		hash_ctl.hash = tag_hash;
+		hash_ctl.hcxt = node->batchContext;
+		node->batchHash = hash_create("DML insert batch", 64, &hash_ctl,
+									  HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+	}
+
+	part = (DMLBatchPart *) hash_search(node->batchHash, &resultRelInfo,
+										HASH_ENTER, &found);
+	if (!found)
+	{
+		part->tuples = NIL;
+		node->batchParts = lappend(node->batchParts, part);
+	}
+
+	tuple = ExecCopySlotHeapTuple(node->cleanedUpSlot);
+	part->tuples = lappend(part->tuples, tuple);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	node->batchBytes += HEAPTUPLESIZE + tuple->t_len;
+	if (node->batchBytes >= (Size) gp_dml_insert_batch_mem * 1024L)
+		ExecDMLFlushInserts(node);
+}
+
+/*
+ * Insert all the buffered tuples, partition by partition.
+ */
+static void
+ExecDMLFlushInserts(DMLState *node)
+{
+	ListCell   *lc;
+
+	foreach(lc, node->batchParts)
+	{
+		DMLBatchPart *part = (DMLBatchPart *) lfirst(lc);
+		ListCell   *lct;
+
+		foreach(lct, part->tuples)
+		{
+			HeapTuple	tuple = (HeapTuple) lfirst(lct);
+
+			ExecStoreHeapTuple(tuple, node->cleanedUpSlot, InvalidBuffer, false);
+			ExecInsert(node->cleanedUpSlot,
+					   NULL,
+					   node->ps.state,
+					   true,
+					   PLANGEN_OPTIMIZER,
+					   false,
+					   InvalidOid);
+		}
+	}
+
+	ExecClearTuple(node->cleanedUpSlot);
+
+	/* the hash table and the lists are in the batch context as well */
+	MemoryContextReset(node->batchContext);
+	node->batchHash = NULL;
+	node->batchParts = NIL;
+	node->batchBytes = 0;
+}
+
 /**
  * Init nodeDML, which initializes the insert TupleTableSlot.
  * */
@@ -217,6 +324,24 @@ ExecInitDML(DML *node, EState *estate, int eflags)
 	ReleaseTupleDesc(dmlstate->junkfilter->jf_cleanTupType);
 	dmlstate->junkfilter->jf_cleanTupType = cleanTupType;
 
+	/*
+	 * Batch the inserts into a partitioned table, unless the planner has put
+	 * a Sort below us, in which case the tuples of a partition already come
+	 * together (see optimizer_parts_to_force_sort_on_insert).
+	 */
+	if (operation == CMD_INSERT &&
+		estate->es_result_partitions != NULL &&
+		gp_dml_insert_batch_mem > 0 &&
+		!IsA(outerPlan, Sort))
+	{
+		dmlstate->batchInserts = true;
+		dmlstate->batchContext = AllocSetContextCreate(CurrentMemoryContext,
+													   "DML insert batch",
+													   ALLOCSET_DEFAULT_MINSIZE,
+													   ALLOCSET_DEFAULT_INITSIZE,
+													   ALLOCSET_DEFAULT_MAXSIZE);
+	}
+
 	if (estate->es_instrument && (estate->es_instrument & INSTRUMENT_CDB))
 	{
 	        dmlstate->ps.cdbexplainbuf = makeStringInfo();
@@ -253,6 +378,8 @@ ExecEndDML(DMLState *node)
 	ExecFreeExprContext(&node->ps);
 	ExecClearTuple(node->ps.ps_ResultTupleSlot);
 	ExecClearTuple(node->cleanedUpSlot);
+	if (node->batchContext != NULL)
+		MemoryContextDelete(node->batchContext);
 	ExecEndNode(outerPlanState(node));
 	EndPlanStateGpmonPkt(&node->ps);
 }
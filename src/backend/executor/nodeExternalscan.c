@@ -130,6 +130,7 @@ ExternalNext(ExternalScanState *node)
 
 	if (gp_external_enable_filter_pushdown)
 		externalSelectDesc->filter_quals = node->ss.ps.plan->qual;
+	externalSelectDesc->agg_type = node->ess_AggType;
 	/*
 	 * get the next tuple from the file access methods
 	 */
@@ -355,6 +356,52 @@ ExecEagerFreeExternalScan(ExternalScanState *node)
 	external_endscan(node->ess_ScanDesc);
 }
 
+/* ----------------------------------------------------------------
+*		ExecExternalScanPushdownAggs
+*
+*		Called by an Agg that computes agg_type aggregates of all the rows
+*		of planstate.  If planstate is an external scan, the protocol is told
+*		about them so that it may answer them from the statistics of its data,
+*		see ExternalScanAggType.
+*
+*		Every row read must reach the Agg, so there must be no filter qual,
+*		no constraint and no single row error handling dropping rows, and
+*		MIN and MAX need the columns themselves, not expressions over them.
+* ----------------------------------------------------------------
+*/
+void
+ExecExternalScanPushdownAggs(PlanState *planstate, ExternalScanAggType agg_type)
+{
+	ExternalScanState *node;
+	ExternalScan *plan;
+	ListCell   *lc;
+
+	if (!gp_external_enable_agg_pushdown || agg_type == EXTSCAN_AGG_NONE ||
+		planstate == NULL || !IsA(planstate, ExternalScanState))
+		return;
+
+	node = (ExternalScanState *) planstate;
+	plan = (ExternalScan *) planstate->plan;
+
+	if (plan->scan.plan.qual != NIL || plan->rejLimit != -1 ||
+		node->cdb_want_ctid ||
+		(node->ess_ScanDesc != NULL && node->ess_ScanDesc->fs_hasConstraints))
+		return;
+
+	if (agg_type == EXTSCAN_AGG_MINMAX)
+	{
+		foreach(lc, plan->scan.plan.targetlist)
+		{
+			TargetEntry *tle = (TargetEntry *) lfirst(lc);
+
+			if (!IsA(tle->expr, Var) || ((Var *) tle->expr)->varattno <= 0)
+				return;
+		}
+	}
+
+	node->ess_AggType = agg_type;
+}
+
 /* ----------------------------------------------------------------
 *		ExecSquelchExternalScan
 *
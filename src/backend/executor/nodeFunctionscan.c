@@ -46,6 +46,7 @@ typedef struct FunctionScanPerFuncState
 	TupleDesc	tupdesc;		/* desc of the function result type */
 	int			colcount;		/* expected number of result columns */
 	Tuplestorestate *tstore;	/* holds the function result set */
+	struct TableFunctionStream *stream; /* or returns it row by row */
 	int64		rowcount;		/* # of rows in result set, -1 if not known */
 	TupleTableSlot *func_slot;	/* function result slot (or NULL) */
 } FunctionScanPerFuncState;
@@ -91,12 +92,29 @@ FunctionNext_guts(FunctionScanState *node)
 		 * into the scan result slot. No need to update ordinality or
 		 * rowcounts either.
 		 */
-		Tuplestorestate *tstore = node->funcstates[0].tstore;
+		FunctionScanPerFuncState *fs = &node->funcstates[0];
+		Tuplestorestate *tstore = fs->tstore;
 
 		/*
-		 * If first time through, read all tuples from function and put them
-		 * in a tuplestore. Subsequent calls just fetch tuples from
-		 * tuplestore.
+		 * If the scan never goes back, a set-returning function's rows are
+		 * returned as it produces them, unless it materializes them itself.
+		 */
+		if (tstore == NULL && fs->stream == NULL &&
+			(node->eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_REWIND | EXEC_FLAG_MARK)) == 0)
+			fs->stream = ExecBeginTableFunctionStream(fs->funcexpr,
+													  node->ss.ps.ps_ExprContext,
+													  node->argcontext,
+													  fs->tupdesc);
+		if (fs->stream != NULL)
+		{
+			(void) ExecTableFunctionStreamNext(fs->stream, scanslot);
+			return scanslot;
+		}
+
+		/*
+		 * Otherwise, if first time through, read all tuples from function
+		 * and put them in a tuplestore. Subsequent calls just fetch tuples
+		 * from tuplestore.
 		 */
 		if (tstore == NULL)
 		{
@@ -424,9 +442,10 @@ ExecInitFunctionScan(FunctionScan *node, EState *estate, int eflags)
 		/*
 		 * Don't allocate the tuplestores; the actual calls to the functions
 		 * do that.  NULL means that we have not called the function yet (or
-		 * need to call it again after a rescan).
+		 * need to call it again after a rescan).  The same goes for the stream.
 		 */
 		fs->tstore = NULL;
+		fs->stream = NULL;
 		fs->rowcount = -1;
 
 		/*
@@ -699,6 +718,16 @@ ExecReScanFunctionScan(FunctionScanState *node)
 		}
 	}
 
+	/* A streamed function can't be rewound, so it is always called again */
+	for (i = 0; i < node->nfuncs; i++)
+	{
+		if (node->funcstates[i].stream != NULL)
+		{
+			ExecEndTableFunctionStream(node->funcstates[i].stream);
+			node->funcstates[i].stream = NULL;
+		}
+	}
+
 	/* Reset ordinality counter */
 	node->ordinal = 0;
 
@@ -730,6 +759,12 @@ ExecEagerFreeFunctionScan(FunctionScanState *node)
 			tuplestore_end(node->funcstates[i].tstore);
 			fs->tstore = NULL;
 		}
+
+		if (fs->stream != NULL)
+		{
+			ExecEndTableFunctionStream(fs->stream);
+			fs->stream = NULL;
+		}
 	}
 }
 
@@ -46,13 +46,18 @@
 #include "cdb/cdbvars.h"
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
+static void ExecHashBuildBloom(HashJoinTable hashtable, HashJoinState *hjstate,
+				   double ntuples);
 static void ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node,
 					  int mcvsToUse);
+static void ExecHashBuildSkewBuckets(HashJoinTable hashtable, Datum *values,
+						 int mcvsToUse);
 static void ExecHashSkewTableInsert(HashState *hashState, HashJoinTable hashtable,
 						TupleTableSlot *slot,
 						uint32 hashvalue,
 						int bucketNumber);
 static void ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable);
+static void *dense_alloc(HashJoinTable hashtable, Size size);
 
 static void ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static void
@@ -142,6 +147,15 @@ MultiExecHash(HashState *node)
 				ExecHashTableInsert(node, hashtable, slot, hashvalue);
 			}
 			hashtable->totalTuples += 1;
+
+			if (hashtable->bloom != NULL)
+			{
+				uint32		bit1 = (hashvalue * 0x9E3779B1) >> (32 - hashtable->log2_bloombits);
+				uint32		bit2 = (hashvalue * 0x85EBCA6B) >> (32 - hashtable->log2_bloombits);
+
+				hashtable->bloom[bit1 / 64] |= UINT64CONST(1) << (bit1 % 64);
+				hashtable->bloom[bit2 / 64] |= UINT64CONST(1) << (bit2 % 64);
+			}
 		}
 
 		if (hashkeys_null)
@@ -159,6 +173,17 @@ MultiExecHash(HashState *node)
 	/* Now we have set up all the initial batches & primary overflow batches. */
 	hashtable->nbatch_outstart = hashtable->nbatch;
 
+	/*
+	 * With fewer than 4 bits for each inner tuple, too many outer tuples
+	 * would pass the bloom filter for it to be worth testing them.
+	 */
+	if (hashtable->bloom != NULL &&
+		hashtable->totalTuples > (UINT64CONST(1) << hashtable->log2_bloombits) / 4)
+	{
+		pfree(hashtable->bloom);
+		hashtable->bloom = NULL;
+	}
+
 	/* must provide our own instrumentation support */
 	if (node->ps.instrument)
 		InstrStopNode(node->ps.instrument, hashtable->totalTuples);
@@ -339,6 +364,11 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 	hashtable->eagerlyReleased = false;
 	hashtable->hjstate = hjstate;
 	hashtable->first_pass = true;
+	hashtable->bloom = NULL;
+	hashtable->log2_bloombits = 0;
+	hashtable->bloomProbes = 0;
+	hashtable->bloomRejects = 0;
+	hashtable->chunks = NULL;
 
 	/*
 	 * Create temporary memory contexts in which to keep the hashtable working
@@ -402,6 +432,8 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 		hashtable->outerBatchFile = (BufFile **) palloc0(nbatch * sizeof(BufFile *));
 	}
 
+	ExecHashBuildBloom(hashtable, hjstate, outerNode->plan_rows);
+
 	/*
 	 * Prepare context for the first-scan space allocations; allocate the
 	 * hashbucket array therein, and set each bucket "empty".
@@ -426,6 +458,83 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 }
 
 
+/*
+ * ExecHashBuildBloom
+ *		allocate the bloom filter of the inner hash values, if the join can
+ *		use one.
+ *
+ * Only the joins that never return an outer tuple without a match can
+ * discard outer tuples by the bloom.  It's sized for about 8 bits for each
+ * of the estimated inner tuples, with two bits set for each of them, but it
+ * takes no more than 1/16 of the memory of the hash join.
+ */
+static void
+ExecHashBuildBloom(HashJoinTable hashtable, HashJoinState *hjstate,
+				   double ntuples)
+{
+	double		nbits;
+	int			log2_bloombits;
+
+	if (!gp_hashjoin_bloomfilter || hjstate == NULL)
+		return;
+
+	if (hjstate->js.jointype != JOIN_INNER &&
+		hjstate->js.jointype != JOIN_SEMI &&
+		hjstate->js.jointype != JOIN_RIGHT)
+		return;
+
+	/* num tuples is a global number, like in ExecChooseHashTableSize */
+	if (Gp_role == GP_ROLE_EXECUTE)
+		ntuples = ntuples / getgpsegmentCount();
+	if (ntuples <= 0.0)
+		ntuples = 1000.0;
+
+	nbits = Min(ntuples * 8, (double) hashtable->spaceAllowed / 16 * 8);
+	log2_bloombits = 13;
+	while (log2_bloombits < 27 && (double) (1 << log2_bloombits) < nbits)
+		log2_bloombits++;
+
+	hashtable->log2_bloombits = log2_bloombits;
+	hashtable->bloom = (uint64 *) palloc0((Size) 1 << (log2_bloombits - 3));
+}
+
+/*
+ * ExecHashBloomTest
+ *		test if an outer tuple of the hash value may have a match.
+ *
+ * Returns false only if no inner tuple has the hash value.  The bloom is
+ * dropped once it turns out to discard few of the outer tuples, which then
+ * are not worth the test.
+ */
+bool
+ExecHashBloomTest(HashJoinTable hashtable, uint32 hashvalue)
+{
+	uint32		bit1;
+	uint32		bit2;
+
+	if (hashtable->bloom == NULL)
+		return true;
+
+	hashtable->bloomProbes++;
+	if ((hashtable->bloomProbes % 4096) == 0 &&
+		hashtable->bloomRejects < hashtable->bloomProbes / 8)
+	{
+		pfree(hashtable->bloom);
+		hashtable->bloom = NULL;
+		return true;
+	}
+
+	bit1 = (hashvalue * 0x9E3779B1) >> (32 - hashtable->log2_bloombits);
+	bit2 = (hashvalue * 0x85EBCA6B) >> (32 - hashtable->log2_bloombits);
+
+	if ((hashtable->bloom[bit1 / 64] & (UINT64CONST(1) << (bit1 % 64))) &&
+		(hashtable->bloom[bit2 / 64] & (UINT64CONST(1) << (bit2 % 64))))
+		return true;
+
+	hashtable->bloomRejects++;
+	return false;
+}
+
 /*
  * Compute appropriate size for hashtable given the estimated size of the
  * relation to be hashed (number of rows and average row width).
@@ -709,6 +818,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	Size		spaceUsedBefore = hashtable->spaceUsed;
 	Size		spaceFreed = 0;
 	HashJoinTableStats *stats = hashtable->stats;
+	HashMemoryChunk oldchunks;
 
 	/* do nothing if we've decided to shut off growth */
 	if (!hashtable->growEnabled)
@@ -768,38 +878,47 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 
 	/*
 	 * Scan through the existing hash table entries and dump out any that are
-	 * no longer of the current batch.
+	 * no longer of the current batch.  We walk the chunks rather than the
+	 * buckets, copying the tuples we keep into new chunks, so that each old
+	 * chunk can be freed once done with.
 	 */
 	ninmemory = nfreed = 0;
 
-	for (i = 0; i < hashtable->nbuckets; i++)
-	{
-		HashJoinTuple prevtuple;
-		HashJoinTuple tuple;
+	MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashJoinTuple));
 
-		prevtuple = NULL;
-		tuple = hashtable->buckets[i];
+	oldchunks = hashtable->chunks;
+	hashtable->chunks = NULL;
 
-		while (tuple != NULL)
+	while (oldchunks != NULL)
+	{
+		HashMemoryChunk nextchunk = oldchunks->next;
+		Size		idx = 0;
+
+		for (i = 0; i < oldchunks->ntuples; i++)
 		{
-			/* save link in case we delete */
-			HashJoinTuple nexttuple = tuple->next;
+			HashJoinTuple tuple = (HashJoinTuple) (oldchunks->data + idx);
+			Size		spaceTuple;
 			int			bucketno;
 			int			batchno;
 
+			spaceTuple = HJTUPLE_OVERHEAD + memtuple_get_size(HJTUPLE_MINTUPLE(tuple));
+
 			ninmemory++;
 			ExecHashGetBucketAndBatch(hashtable, tuple->hashvalue,
 									  &bucketno, &batchno);
-			Assert(bucketno == i);
 			if (batchno == curbatch)
 			{
-				/* keep tuple */
-				prevtuple = tuple;
+				/* keep tuple, in the new chunks */
+				HashJoinTuple copyTuple;
+
+				copyTuple = (HashJoinTuple) dense_alloc(hashtable, spaceTuple);
+				memcpy(copyTuple, tuple, spaceTuple);
+
+				copyTuple->next = hashtable->buckets[bucketno];
+				hashtable->buckets[bucketno] = copyTuple;
 			}
 			else
 			{
-				Size    spaceTuple;
-
 				/* dump it out */
 				Assert(batchno > curbatch);
 				ExecHashJoinSaveTuple(NULL, HJTUPLE_MINTUPLE(tuple),
@@ -807,27 +926,22 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 									  hashtable,
 									  &hashtable->innerBatchFile[batchno],
 									  hashtable->bfCxt);
-				/* and remove from hash table */
-				if (prevtuple)
-					prevtuple->next = nexttuple;
-				else
-					hashtable->buckets[i] = nexttuple;
-				/* prevtuple doesn't change */
-				spaceTuple = HJTUPLE_OVERHEAD + memtuple_get_size(HJTUPLE_MINTUPLE(tuple));
 				hashtable->spaceUsed -= spaceTuple;
 				spaceFreed += spaceTuple;
 				if (stats)
 					stats->batchstats[batchno].spillspace_in += spaceTuple;
 
-				pfree(tuple);
 				nfreed++;
 			}
 
-			tuple = nexttuple;
+			idx += MAXALIGN(spaceTuple);
 
 			/* allow this loop to be cancellable */
 			CHECK_FOR_INTERRUPTS();
 		}
+
+		pfree(oldchunks);
+		oldchunks = nextchunk;
 	}
 
 #ifdef HJDEBUG
@@ -904,8 +1018,7 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		HashJoinTuple hashTuple;
 
 		/* Create the HashJoinTuple */
-		hashTuple = (HashJoinTuple) MemoryContextAlloc(hashtable->batchCxt,
-													   hashTupleSize);
+		hashTuple = (HashJoinTuple) dense_alloc(hashtable, hashTupleSize);
 		hashTuple->hashvalue = hashvalue;
 		memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, memtuple_get_size(tuple));
 
@@ -1289,6 +1402,7 @@ ExecHashTableReset(HashState *hashState, HashJoinTable hashtable)
 	 * reinitialize the context for a new pass.
 	 */
 	MemoryContextReset(hashtable->batchCxt);
+	hashtable->chunks = NULL;
 	oldcxt = MemoryContextSwitchTo(hashtable->batchCxt);
 
 	/* Reallocate and reinitialize the hash bucket headers. */
@@ -1480,6 +1594,10 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 				"Secondary Overflow");
     }
 
+    /* Report outer tuples discarded by the bloom filter. */
+    jinstrument->bloomProbes += (double) hashtable->bloomProbes;
+    jinstrument->bloomRejects += (double) hashtable->bloomRejects;
+
     /* Report hash chain statistics. */
     total_buckets = stats->nonemptybatches * hashtable->nbuckets;
     if (total_buckets > 0)
@@ -1724,6 +1842,111 @@ ExecHashTableExplainBatchEnd(HashState *hashState, HashJoinTable hashtable)
 }                               /* ExecHashTableExplainBatchEnd */
 
 
+/*
+ * ExecHashBuildSkewBuckets
+ *
+ *		Make the skew hash buckets for the hash values of the MCVs, which are
+ *		in order of decreasing frequency.
+ */
+static void
+ExecHashBuildSkewBuckets(HashJoinTable hashtable, Datum *values, int mcvsToUse)
+{
+	int			nbuckets;
+	FmgrInfo   *hashfunctions;
+	int			i;
+
+	/*
+	 * Okay, set up the skew hashtable.
+	 *
+	 * skewBucket[] is an open addressing hashtable with a power of 2 size
+	 * that is greater than the number of MCV values.  (This ensures there
+	 * will be at least one null entry, so searches will always
+	 * terminate.)
+	 *
+	 * Note: this code could fail if mcvsToUse exceeds INT_MAX/8 or
+	 * MaxAllocSize/sizeof(void *)/8, but that is not currently possible
+	 * since we limit pg_statistic entries to much less than that.
+	 */
+	nbuckets = 2;
+	while (nbuckets <= mcvsToUse)
+		nbuckets <<= 1;
+	/* use two more bits just to help avoid collisions */
+	nbuckets <<= 2;
+
+	hashtable->skewEnabled = true;
+	hashtable->skewBucketLen = nbuckets;
+
+	/*
+	 * We allocate the bucket memory in the hashtable's batch context. It
+	 * is only needed during the first batch, and this ensures it will be
+	 * automatically removed once the first batch is done.
+	 */
+	hashtable->skewBucket = (HashSkewBucket **)
+		MemoryContextAllocZero(hashtable->batchCxt,
+							   nbuckets * sizeof(HashSkewBucket *));
+	hashtable->skewBucketNums = (int *)
+		MemoryContextAllocZero(hashtable->batchCxt,
+							   mcvsToUse * sizeof(int));
+
+	hashtable->spaceUsed += nbuckets * sizeof(HashSkewBucket *)
+		+ mcvsToUse * sizeof(int);
+	hashtable->spaceUsedSkew += nbuckets * sizeof(HashSkewBucket *)
+		+ mcvsToUse * sizeof(int);
+	if (hashtable->spaceUsed > hashtable->spacePeak)
+		hashtable->spacePeak = hashtable->spaceUsed;
+
+	/*
+	 * Create a skew bucket for each MCV hash value.
+	 *
+	 * Note: it is very important that we create the buckets in order of
+	 * decreasing MCV frequency.  If we have to remove some buckets, they
+	 * must be removed in reverse order of creation (see notes in
+	 * ExecHashRemoveNextSkewBucket) and we want the least common MCVs to
+	 * be removed first.
+	 */
+	hashfunctions = hashtable->outer_hashfunctions;
+
+	for (i = 0; i < mcvsToUse; i++)
+	{
+		uint32		hashvalue;
+		int			bucket;
+
+		hashvalue = DatumGetUInt32(FunctionCall1(&hashfunctions[0],
+												 values[i]));
+
+		/*
+		 * While we have not hit a hole in the hashtable and have not hit
+		 * the desired bucket, we have collided with some previous hash
+		 * value, so try the next bucket location.  NB: this code must
+		 * match ExecHashGetSkewBucket.
+		 */
+		bucket = hashvalue & (nbuckets - 1);
+		while (hashtable->skewBucket[bucket] != NULL &&
+			   hashtable->skewBucket[bucket]->hashvalue != hashvalue)
+			bucket = (bucket + 1) & (nbuckets - 1);
+
+		/*
+		 * If we found an existing bucket with the same hashvalue, leave
+		 * it alone.  It's okay for two MCVs to share a hashvalue.
+		 */
+		if (hashtable->skewBucket[bucket] != NULL)
+			continue;
+
+		/* Okay, create a new skew bucket for this hashvalue. */
+		hashtable->skewBucket[bucket] = (HashSkewBucket *)
+			MemoryContextAlloc(hashtable->batchCxt,
+							   sizeof(HashSkewBucket));
+		hashtable->skewBucket[bucket]->hashvalue = hashvalue;
+		hashtable->skewBucket[bucket]->tuples = NULL;
+		hashtable->skewBucketNums[hashtable->nSkewBuckets] = bucket;
+		hashtable->nSkewBuckets++;
+		hashtable->spaceUsed += SKEW_BUCKET_OVERHEAD;
+		hashtable->spaceUsedSkew += SKEW_BUCKET_OVERHEAD;
+		if (hashtable->spaceUsed > hashtable->spacePeak)
+			hashtable->spacePeak = hashtable->spaceUsed;
+	}
+}
+
 /*
  * ExecHashBuildSkewHash
  *
@@ -1745,6 +1968,31 @@ ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node, int mcvsToUse)
 	if (mcvsToUse <= 0)
 		return;
 
+	/*
+	 * CDB: the segments have no statistics, the MCVs come with the plan.
+	 * Whether they are common enough to be worth it was checked when they
+	 * were put there.
+	 */
+	if (node->skewValues != NIL)
+	{
+		Datum	   *values;
+		ListCell   *lc;
+		int			i = 0;
+
+		mcvsToUse = Min(mcvsToUse, list_length(node->skewValues));
+		values = (Datum *) palloc(mcvsToUse * sizeof(Datum));
+		foreach(lc, node->skewValues)
+		{
+			if (i >= mcvsToUse)
+				break;
+			values[i++] = ((Const *) lfirst(lc))->constvalue;
+		}
+
+		ExecHashBuildSkewBuckets(hashtable, values, mcvsToUse);
+		pfree(values);
+		return;
+	}
+
 	/*
 	 * Try to find the MCV statistics for the outer relation's join key.
 	 */
@@ -1760,8 +2008,6 @@ ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node, int mcvsToUse)
 						 ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
 	{
 		double		frac;
-		int			nbuckets;
-		FmgrInfo   *hashfunctions;
 		int			i;
 
 		if (mcvsToUse > sslot.nvalues)
@@ -1782,96 +2028,7 @@ ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node, int mcvsToUse)
 			return;
 		}
 
-		/*
-		 * Okay, set up the skew hashtable.
-		 *
-		 * skewBucket[] is an open addressing hashtable with a power of 2 size
-		 * that is greater than the number of MCV values.  (This ensures there
-		 * will be at least one null entry, so searches will always
-		 * terminate.)
-		 *
-		 * Note: this code could fail if mcvsToUse exceeds INT_MAX/8 or
-		 * MaxAllocSize/sizeof(void *)/8, but that is not currently possible
-		 * since we limit pg_statistic entries to much less than that.
-		 */
-		nbuckets = 2;
-		while (nbuckets <= mcvsToUse)
-			nbuckets <<= 1;
-		/* use two more bits just to help avoid collisions */
-		nbuckets <<= 2;
-
-		hashtable->skewEnabled = true;
-		hashtable->skewBucketLen = nbuckets;
-
-		/*
-		 * We allocate the bucket memory in the hashtable's batch context. It
-		 * is only needed during the first batch, and this ensures it will be
-		 * automatically removed once the first batch is done.
-		 */
-		hashtable->skewBucket = (HashSkewBucket **)
-			MemoryContextAllocZero(hashtable->batchCxt,
-								   nbuckets * sizeof(HashSkewBucket *));
-		hashtable->skewBucketNums = (int *)
-			MemoryContextAllocZero(hashtable->batchCxt,
-								   mcvsToUse * sizeof(int));
-
-		hashtable->spaceUsed += nbuckets * sizeof(HashSkewBucket *)
-			+ mcvsToUse * sizeof(int);
-		hashtable->spaceUsedSkew += nbuckets * sizeof(HashSkewBucket *)
-			+ mcvsToUse * sizeof(int);
-		if (hashtable->spaceUsed > hashtable->spacePeak)
-			hashtable->spacePeak = hashtable->spaceUsed;
-
-		/*
-		 * Create a skew bucket for each MCV hash value.
-		 *
-		 * Note: it is very important that we create the buckets in order of
-		 * decreasing MCV frequency.  If we have to remove some buckets, they
-		 * must be removed in reverse order of creation (see notes in
-		 * ExecHashRemoveNextSkewBucket) and we want the least common MCVs to
-		 * be removed first.
-		 */
-		hashfunctions = hashtable->outer_hashfunctions;
-
-		for (i = 0; i < mcvsToUse; i++)
-		{
-			uint32		hashvalue;
-			int			bucket;
-
-			hashvalue = DatumGetUInt32(FunctionCall1(&hashfunctions[0],
-													 sslot.values[i]));
-
-			/*
-			 * While we have not hit a hole in the hashtable and have not hit
-			 * the desired bucket, we have collided with some previous hash
-			 * value, so try the next bucket location.  NB: this code must
-			 * match ExecHashGetSkewBucket.
-			 */
-			bucket = hashvalue & (nbuckets - 1);
-			while (hashtable->skewBucket[bucket] != NULL &&
-				   hashtable->skewBucket[bucket]->hashvalue != hashvalue)
-				bucket = (bucket + 1) & (nbuckets - 1);
-
-			/*
-			 * If we found an existing bucket with the same hashvalue, leave
-			 * it alone.  It's okay for two MCVs to share a hashvalue.
-			 */
-			if (hashtable->skewBucket[bucket] != NULL)
-				continue;
-
-			/* Okay, create a new skew bucket for this hashvalue. */
-			hashtable->skewBucket[bucket] = (HashSkewBucket *)
-				MemoryContextAlloc(hashtable->batchCxt,
-								   sizeof(HashSkewBucket));
-			hashtable->skewBucket[bucket]->hashvalue = hashvalue;
-			hashtable->skewBucket[bucket]->tuples = NULL;
-			hashtable->skewBucketNums[hashtable->nSkewBuckets] = bucket;
-			hashtable->nSkewBuckets++;
-			hashtable->spaceUsed += SKEW_BUCKET_OVERHEAD;
-			hashtable->spaceUsedSkew += SKEW_BUCKET_OVERHEAD;
-			if (hashtable->spaceUsed > hashtable->spacePeak)
-				hashtable->spacePeak = hashtable->spaceUsed;
-		}
+		ExecHashBuildSkewBuckets(hashtable, sslot.values, mcvsToUse);
 
 		free_attstatsslot(&sslot);
 	}
@@ -2018,8 +2175,14 @@ ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable)
 		if (batchno == hashtable->curbatch)
 		{
 			/* Move the tuple to the main hash table */
-			hashTuple->next = hashtable->buckets[bucketno];
-			hashtable->buckets[bucketno] = hashTuple;
+			HashJoinTuple copyTuple;
+
+			copyTuple = (HashJoinTuple) dense_alloc(hashtable, tupleSize);
+			memcpy(copyTuple, hashTuple, tupleSize);
+			pfree(hashTuple);
+
+			copyTuple->next = hashtable->buckets[bucketno];
+			hashtable->buckets[bucketno] = copyTuple;
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
 		}
@@ -2075,3 +2238,76 @@ ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable)
 		hashtable->spaceUsedSkew = 0;
 	}
 }
+
+/*
+ * Allocate space for a tuple of the main hash table, in the chunks.
+ */
+static void *
+dense_alloc(HashJoinTable hashtable, Size size)
+{
+	HashMemoryChunk newChunk;
+	char	   *ptr;
+
+	/* just in case the size is not already aligned properly */
+	size = MAXALIGN(size);
+
+	/*
+	 * If tuple size is larger than of 1/4 of chunk size, allocate a separate
+	 * chunk.
+	 */
+	if (size > HASH_CHUNK_THRESHOLD)
+	{
+		/* allocate new chunk and put it at the beginning of the list */
+		newChunk = (HashMemoryChunk) MemoryContextAlloc(hashtable->batchCxt,
+								 offsetof(HashMemoryChunkData, data) + size);
+		newChunk->maxlen = size;
+		newChunk->used = size;
+		newChunk->ntuples = 1;
+
+		/*
+		 * Add this chunk to the list after the first existing chunk, so that
+		 * we don't lose the remaining space in the "current" chunk.
+		 */
+		if (hashtable->chunks != NULL)
+		{
+			newChunk->next = hashtable->chunks->next;
+			hashtable->chunks->next = newChunk;
+		}
+		else
+		{
+			newChunk->next = hashtable->chunks;
+			hashtable->chunks = newChunk;
+		}
+
+		return newChunk->data;
+	}
+
+	/*
+	 * See if we have enough space for it in the current chunk (if any). If
+	 * not, allocate a fresh chunk.
+	 */
+	if ((hashtable->chunks == NULL) ||
+		(hashtable->chunks->maxlen - hashtable->chunks->used) < size)
+	{
+		/* allocate new chunk and put it at the beginning of the list */
+		newChunk = (HashMemoryChunk) MemoryContextAlloc(hashtable->batchCxt,
+					   offsetof(HashMemoryChunkData, data) + HASH_CHUNK_SIZE);
+
+		newChunk->maxlen = HASH_CHUNK_SIZE;
+		newChunk->used = size;
+		newChunk->ntuples = 1;
+
+		newChunk->next = hashtable->chunks;
+		hashtable->chunks = newChunk;
+
+		return newChunk->data;
+	}
+
+	/* There is enough space in the current chunk, let's add the tuple */
+	ptr = hashtable->chunks->data + hashtable->chunks->used;
+	hashtable->chunks->used += size;
+	hashtable->chunks->ntuples += 1;
+
+	/* return pointer to the start of the tuple memory */
+	return ptr;
+}
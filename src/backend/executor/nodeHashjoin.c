@@ -832,12 +832,18 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 				/* remember outer relation is not empty for possible rescan */
 				hjstate->hj_OuterNotEmpty = true;
 
-				return slot;
+				/*
+				 * Discard the tuple without probing the hash table or
+				 * spilling it to a batch file, if the bloom filter tells it
+				 * has no match.
+				 */
+				if (ExecHashBloomTest(hashtable, *hashvalue))
+					return slot;
 			}
 
 			/*
-			 * That tuple couldn't match because of a NULL, so discard it and
-			 * continue with the next one.
+			 * That tuple couldn't match because of a NULL or by the bloom
+			 * filter, so discard it and continue with the next one.
 			 */
 			slot = ExecProcNode(outerNode);
 		}
@@ -1104,6 +1110,7 @@ ExecHashJoinSaveTuple(PlanState *ps, MemTuple tuple, uint32 hashvalue,
 		Assert(hashtable->work_set != NULL);
 		file = BufFileCreateTempInSet(hashtable->work_set, false /* interXact */);
 		BufFilePledgeSequential(file);	/* allow compression */
+		BufFileSetInstrument(file, hashtable->hjstate->js.ps.instrument);
 		*fileptr = file;
 
 		elog(gp_workfile_caching_loglevel, "create batch file %s",
@@ -21,16 +21,23 @@
  *		ExecEndIndexOnlyScan		releases all storage.
  *		ExecIndexOnlyMarkPos		marks scan position.
  *		ExecIndexOnlyRestrPos		restores scan position.
+ *		ExecIndexOnlyScanSkipDistinct	skips to the next distinct value.
  */
 #include "postgres.h"
 
+#include "access/nbtree.h"
 #include "access/relscan.h"
 #include "access/visibilitymap.h"
+#include "catalog/pg_am.h"
+#include "cdb/cdbvars.h"
 #include "executor/execdebug.h"
 #include "executor/nodeIndexonlyscan.h"
 #include "executor/nodeIndexscan.h"
+#include "parser/parsetree.h"
 #include "storage/bufmgr.h"
 #include "storage/predicate.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
 
@@ -38,6 +45,10 @@
 static TupleTableSlot *IndexOnlyNext(IndexOnlyScanState *node);
 static void StoreIndexTuple(TupleTableSlot *slot, IndexTuple itup,
 				TupleDesc itupdesc);
+static void IndexOnlySkip(IndexOnlyScanState *node, ScanDirection direction);
+static bool IndexOnlySkipToNulls(IndexOnlyScanState *node, ScanDirection direction);
+static void IndexOnlyRememberSkipValue(IndexOnlyScanState *node,
+						   TupleTableSlot *slot);
 
 
 /* ----------------------------------------------------------------
@@ -69,7 +80,14 @@ IndexOnlyNext(IndexOnlyScanState *node)
 		else if (ScanDirectionIsBackward(direction))
 			direction = ForwardScanDirection;
 	}
-	scandesc = node->ioss_ScanDesc;
+	/* skip the rest of the tuples of the value returned last */
+	if (node->ioss_SkipPending)
+	{
+		node->ioss_SkipPending = false;
+		IndexOnlySkip(node, direction);
+	}
+
+	scandesc = node->ioss_Skipping ? node->ioss_SkipScanDesc : node->ioss_ScanDesc;
 	econtext = node->ss.ps.ps_ExprContext;
 	slot = node->ss.ss_ScanTupleSlot;
 
@@ -177,9 +195,19 @@ IndexOnlyNext(IndexOnlyScanState *node)
 							  ItemPointerGetBlockNumber(tid),
 							  estate->es_snapshot);
 
+		if (node->ioss_SkipDistinct)
+			IndexOnlyRememberSkipValue(node, slot);
+
 		return slot;
 	}
 
+	/*
+	 * The skip key excludes the NULLs; if they come after the other values,
+	 * read them now.
+	 */
+	if (node->ioss_Skipping && IndexOnlySkipToNulls(node, direction))
+		return IndexOnlyNext(node);
+
 	/*
 	 * if we get here it means the index scan failed so we are at the end of
 	 * the scan..
@@ -217,6 +245,111 @@ StoreIndexTuple(TupleTableSlot *slot, IndexTuple itup, TupleDesc itupdesc)
 	ExecStoreVirtualTuple(slot);
 }
 
+/*
+ * IndexOnlyRememberSkipValue
+ *		Remember the leading column of a returned tuple, to skip the other
+ *		tuples of its value.
+ *
+ * The tuples of a NULL are not skipped, they are read one by one.
+ */
+static void
+IndexOnlyRememberSkipValue(IndexOnlyScanState *node, TupleTableSlot *slot)
+{
+	Form_pg_attribute att = slot->tts_tupleDescriptor->attrs[0];
+	MemoryContext oldcxt;
+	Datum		value;
+	bool		isnull;
+
+	value = slot_getattr(slot, 1, &isnull);
+	if (isnull)
+		return;
+
+	MemoryContextReset(node->ioss_SkipContext);
+	oldcxt = MemoryContextSwitchTo(node->ioss_SkipContext);
+	node->ioss_SkipValue = datumCopy(value, att->attbyval, att->attlen);
+	MemoryContextSwitchTo(oldcxt);
+
+	node->ioss_SkipPending = true;
+}
+
+/*
+ * IndexOnlySkip
+ *		Restart the scan at the first entry past ioss_SkipValue.
+ *
+ * The skip scan has a key on the leading column, > or < the value in the
+ * order the scan returns the values, in front of the keys of the index
+ * quals.  The btree descends to the first entry satisfying all of them.
+ */
+static void
+IndexOnlySkip(IndexOnlyScanState *node, ScanDirection direction)
+{
+	Relation	indexRel = node->ioss_RelationDesc;
+	ScanKey		keys = node->ioss_SkipKeys;
+	bool		ascending;
+
+	ascending = (ScanDirectionIsForward(direction) ==
+				 ((indexRel->rd_indoption[0] & INDOPTION_DESC) == 0));
+
+	ScanKeyEntryInitializeWithInfo(&keys[0],
+								   0,
+								   1,
+								   ascending ? BTGreaterStrategyNumber : BTLessStrategyNumber,
+								   indexRel->rd_opcintype[0],
+								   indexRel->rd_indcollation[0],
+								   ascending ? &node->ioss_SkipGtFn : &node->ioss_SkipLtFn,
+								   node->ioss_SkipValue);
+	if (node->ioss_NumScanKeys > 0)
+		memcpy(&keys[1], node->ioss_ScanKeys,
+			   node->ioss_NumScanKeys * sizeof(ScanKeyData));
+
+	index_rescan(node->ioss_SkipScanDesc,
+				 keys, node->ioss_NumScanKeys + 1,
+				 NULL, 0);
+	node->ioss_Skipping = true;
+}
+
+/*
+ * IndexOnlySkipToNulls
+ *		Once the skip scan has returned the last non-NULL value, restart it
+ *		at the NULLs of the leading column, if they come after the other
+ *		values in the direction of the scan.
+ *
+ * Returns false if there is nothing left to read.  The NULLs are not
+ * skipped, so this happens at most once per scan.
+ */
+static bool
+IndexOnlySkipToNulls(IndexOnlyScanState *node, ScanDirection direction)
+{
+	Relation	indexRel = node->ioss_RelationDesc;
+	ScanKey		keys = node->ioss_SkipKeys;
+	bool		nullsFirst;
+
+	if (node->ioss_SkipNulls)
+		return false;
+
+	nullsFirst = (indexRel->rd_indoption[0] & INDOPTION_NULLS_FIRST) != 0;
+	if (ScanDirectionIsForward(direction) == nullsFirst)
+		return false;
+
+	ScanKeyEntryInitialize(&keys[0],
+						   SK_ISNULL | SK_SEARCHNULL,
+						   1,
+						   InvalidStrategy,
+						   InvalidOid,
+						   InvalidOid,
+						   InvalidOid,
+						   (Datum) 0);
+	if (node->ioss_NumScanKeys > 0)
+		memcpy(&keys[1], node->ioss_ScanKeys,
+			   node->ioss_NumScanKeys * sizeof(ScanKeyData));
+
+	index_rescan(node->ioss_SkipScanDesc,
+				 keys, node->ioss_NumScanKeys + 1,
+				 NULL, 0);
+	node->ioss_SkipNulls = true;
+	return true;
+}
+
 /*
  * IndexOnlyRecheck -- access method routine to recheck a tuple in EvalPlanQual
  *
@@ -282,6 +415,11 @@ ExecReScanIndexOnlyScan(IndexOnlyScanState *node)
 	}
 	node->ioss_RuntimeKeysReady = true;
 
+	/* start over without skipping */
+	node->ioss_SkipPending = false;
+	node->ioss_Skipping = false;
+	node->ioss_SkipNulls = false;
+
 	/* reset index scan */
 	index_rescan(node->ioss_ScanDesc,
 				 node->ioss_ScanKeys, node->ioss_NumScanKeys,
@@ -336,6 +474,8 @@ ExecEndIndexOnlyScan(IndexOnlyScanState *node)
 	 */
 	if (indexScanDesc)
 		index_endscan(indexScanDesc);
+	if (node->ioss_SkipScanDesc)
+		index_endscan(node->ioss_SkipScanDesc);
 	if (indexRelationDesc)
 		index_close(indexRelationDesc, NoLock);
 
@@ -531,6 +671,11 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
 	/* Set it up for index-only scan */
 	indexstate->ioss_ScanDesc->xs_want_itup = true;
 	indexstate->ioss_VMBuffer = InvalidBuffer;
+	indexstate->ioss_SkipDistinct = false;
+	indexstate->ioss_SkipPending = false;
+	indexstate->ioss_Skipping = false;
+	indexstate->ioss_SkipScanDesc = NULL;
+	indexstate->ioss_SkipNulls = false;
 
 	/*
 	 * If no run-time keys to calculate, go ahead and pass the scankeys to the
@@ -548,3 +693,83 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
 	 */
 	return indexstate;
 }
+
+/* ----------------------------------------------------------------
+ *		ExecIndexOnlyScanSkipDistinct
+ *
+ *		Called by a parent node that only uses the first tuple of each
+ *		value of its attno'th input column, an Agg without aggregates or a
+ *		Unique on the column.  If planstate is an index-only scan of a btree
+ *		whose leading column is that column, the scan skips to the next
+ *		value of the column once it has returned a tuple, rather than
+ *		reading all the entries of the value.
+ *
+ *		Tuples are only skipped after they passed all the quals of the
+ *		scan, so there must be no filter qual on top of the index quals.
+ * ----------------------------------------------------------------
+ */
+void
+ExecIndexOnlyScanSkipDistinct(PlanState *planstate, AttrNumber attno, int eflags)
+{
+	IndexOnlyScanState *node;
+	IndexOnlyScan *plan;
+	Relation	indexRel;
+	TargetEntry *tle;
+	Var		   *var;
+	Oid			gtop;
+	Oid			ltop;
+
+	if (!gp_enable_index_skip_scan ||
+		planstate == NULL || !IsA(planstate, IndexOnlyScanState))
+		return;
+
+	node = (IndexOnlyScanState *) planstate;
+	plan = (IndexOnlyScan *) planstate->plan;
+	indexRel = node->ioss_RelationDesc;
+
+	/* nothing to do when only doing EXPLAIN */
+	if (node->ioss_ScanDesc == NULL)
+		return;
+
+	if ((eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) != 0 ||
+		plan->scan.plan.qual != NIL ||
+		node->ioss_NumOrderByKeys != 0 ||
+		indexRel->rd_rel->relam != BTREE_AM_OID)
+		return;
+
+	tle = get_tle_by_resno(plan->scan.plan.targetlist, attno);
+	if (tle == NULL || !IsA(tle->expr, Var))
+		return;
+	var = (Var *) tle->expr;
+	if (var->varno != INDEX_VAR || var->varattno != 1)
+		return;
+
+	gtop = get_opfamily_member(indexRel->rd_opfamily[0],
+							   indexRel->rd_opcintype[0],
+							   indexRel->rd_opcintype[0],
+							   BTGreaterStrategyNumber);
+	ltop = get_opfamily_member(indexRel->rd_opfamily[0],
+							   indexRel->rd_opcintype[0],
+							   indexRel->rd_opcintype[0],
+							   BTLessStrategyNumber);
+	if (!OidIsValid(gtop) || !OidIsValid(ltop))
+		return;
+
+	fmgr_info(get_opcode(gtop), &node->ioss_SkipGtFn);
+	fmgr_info(get_opcode(ltop), &node->ioss_SkipLtFn);
+
+	node->ioss_SkipKeys = (ScanKey)
+		palloc((node->ioss_NumScanKeys + 1) * sizeof(ScanKeyData));
+	node->ioss_SkipContext = AllocSetContextCreate(CurrentMemoryContext,
+												   "IndexOnlyScanSkip",
+												   ALLOCSET_SMALL_MINSIZE,
+												   ALLOCSET_SMALL_INITSIZE,
+												   ALLOCSET_SMALL_MAXSIZE);
+	node->ioss_SkipScanDesc = index_beginscan(node->ss.ss_currentRelation,
+											  indexRel,
+											  planstate->state->es_snapshot,
+											  node->ioss_NumScanKeys + 1,
+											  0);
+	node->ioss_SkipScanDesc->xs_want_itup = true;
+	node->ioss_SkipDistinct = true;
+}
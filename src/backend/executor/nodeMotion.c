@@ -17,6 +17,7 @@
 
 #include "access/heapam.h"
 #include "nodes/execnodes.h"	/* Slice, SliceTable */
+#include "cdb/cdbbroadcastcache.h"
 #include "cdb/cdbmotion.h"
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
@@ -25,7 +26,7 @@
 #include "executor/execdebug.h"
 #include "executor/execUtils.h"
 #include "executor/nodeMotion.h"
-#include "lib/binaryheap.h"
+#include "lib/losertree.h"
 #include "utils/tuplesort.h"
 #include "utils/tuplesort_mk_details.h"
 #include "miscadmin.h"
@@ -38,6 +39,12 @@
 #include <unistd.h>				/* gettimeofday */
 #endif
 
+/*
+ * Redistribute Motions with gp_motion_skew_threshold set check how many of
+ * their first rows go to each segment.
+ */
+#define MOTION_SKEW_SAMPLE_SIZE 10000
+
 /* #define CDB_MOTION_DEBUG */
 
 #ifdef CDB_MOTION_DEBUG
@@ -102,6 +109,7 @@ static void CdbMergeComparator_DestroyContext(CdbMergeComparatorContext *ctx);
  */
 static TupleTableSlot *execMotionSender(MotionState *node);
 static TupleTableSlot *execMotionUnsortedReceiver(MotionState *node);
+static TupleTableSlot *execMotionCachedReceiver(MotionState *node);
 static TupleTableSlot *execMotionSortedReceiver(MotionState *node);
 static TupleTableSlot *execMotionSortedReceiver_mk(MotionState *node);
 
@@ -112,6 +120,7 @@ static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, CdbHash *h);
 
 static void doSendEndOfStream(Motion *motion, MotionState *node);
 static void doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot);
+static void checkMotionSkew(Motion *motion, MotionState *node, int16 targetRoute);
 
 
 /*=========================================================================
@@ -389,6 +398,9 @@ execMotionUnsortedReceiver(MotionState *node)
 		return NULL;
 	}
 
+	if (node->bcache != NULL && node->bcache->hit)
+		return execMotionCachedReceiver(node);
+
 	tuple = RecvTupleFrom(node->ps.state->motionlayer_context,
 						  node->ps.state->interconnect_context,
 						  motion->motionID, ANY_ROUTE);
@@ -402,9 +414,15 @@ execMotionUnsortedReceiver(MotionState *node)
 		Assert(node->numTuplesFromAMS == node->numTuplesToParent);
 		Assert(node->numTuplesFromChild == 0);
 		Assert(node->numTuplesToAMS == 0);
+
+		if (node->bcache != NULL)
+			BroadcastCacheEndOfStream(node->bcache);
 		return NULL;
 	}
 
+	if (node->bcache != NULL)
+		BroadcastCacheAddTuple(node->bcache, tuple);
+
 	node->numTuplesFromAMS++;
 	node->numTuplesToParent++;
 
@@ -431,6 +449,35 @@ execMotionUnsortedReceiver(MotionState *node)
 	return slot;
 }
 
+/*
+ * Replay the tuples of a broadcast that the broadcast cache has, instead of
+ * receiving them again.
+ */
+static TupleTableSlot *
+execMotionCachedReceiver(MotionState *node)
+{
+	Motion	   *motion = (Motion *) node->ps.plan;
+	GenericTuple tuple;
+
+	/* the senders needn't send what we have */
+	if (!node->bcache->stopSent)
+	{
+		SendStopMessage(node->ps.state->motionlayer_context,
+						node->ps.state->interconnect_context,
+						motion->motionID);
+		node->bcache->stopSent = true;
+	}
+
+	tuple = BroadcastCacheNext(node->bcache);
+	if (tuple == NULL)
+		return NULL;
+
+	node->numTuplesToParent++;
+
+	/* the tuple belongs to the cache */
+	return ExecStoreGenericTuple(tuple, node->ps.ps_ResultTupleSlot, false);
+}
+
 
 
 /*
@@ -644,7 +691,7 @@ static TupleTableSlot *
 execMotionSortedReceiver(MotionState *node)
 {
 	TupleTableSlot *slot;
-	binaryheap *hp = node->tupleheap;
+	losertree *hp = node->tupleheap;
 	GenericTuple tuple,
 				inputTuple;
 	Motion	   *motion = (Motion *) node->ps.plan;
@@ -677,7 +724,7 @@ execMotionSortedReceiver(MotionState *node)
 	else
 	{
 		/* Old element is still at the head of the pq. */
-		Assert(DatumGetInt32(binaryheap_first(hp)) == node->routeIdNext);
+		Assert(DatumGetInt32(losertree_first(hp)) == node->routeIdNext);
 
 		/* Receive the successor of the tuple that we returned last time. */
 		inputTuple = RecvTupleFrom(node->ps.state->motionlayer_context,
@@ -704,7 +751,7 @@ execMotionSortedReceiver(MotionState *node)
 											node->tupleheap_cxt->tupDesc,
 											&info->isnull1);
 
-			binaryheap_replace_first(hp, Int32GetDatum(node->routeIdNext));
+			losertree_replace_first(hp, Int32GetDatum(node->routeIdNext));
 
 			node->numTuplesFromAMS++;
 
@@ -727,12 +774,12 @@ execMotionSortedReceiver(MotionState *node)
 		}
 
 		/* At EOS, drop this sender from the priority queue. */
-		else if (!binaryheap_empty(hp))
-			binaryheap_remove_first(hp);
+		else if (!losertree_empty(hp))
+			losertree_remove_first(hp);
 	}
 
 	/* Finished if all senders have returned EOS. */
-	if (binaryheap_empty(hp))
+	if (losertree_empty(hp))
 	{
 		Assert(node->numTuplesFromAMS == node->numTuplesToParent);
 		Assert(node->numTuplesFromChild == 0);
@@ -749,7 +796,7 @@ execMotionSortedReceiver(MotionState *node)
 	 * are called, to avoid an unnecessary rearrangement of the priority
 	 * queue.
 	 */
-	node->routeIdNext = binaryheap_first(hp);
+	node->routeIdNext = losertree_first(hp);
 	tupHeapInfo = &node->tupleheap_entries[node->routeIdNext];
 	tuple = tupHeapInfo->tuple;
 
@@ -789,7 +836,7 @@ void
 execMotionSortedReceiverFirstTime(MotionState *node)
 {
 	GenericTuple inputTuple;
-	binaryheap *hp = node->tupleheap;
+	losertree *hp = node->tupleheap;
 	Motion	   *motion = (Motion *) node->ps.plan;
 	int			iSegIdx;
 	ListCell   *lcProcess;
@@ -800,7 +847,7 @@ execMotionSortedReceiverFirstTime(MotionState *node)
 	Assert(sendSlice->sliceIndex == motion->motionID);
 
 	/*
-	 * Get the first tuple from every sender, and stick it into the heap.
+	 * Get the first tuple from every sender, and stick it into the tree.
 	 */
 	foreach_with_count(lcProcess, sendSlice->primaryProcesses, iSegIdx)
 	{
@@ -821,7 +868,7 @@ execMotionSortedReceiverFirstTime(MotionState *node)
 
 			info->tuple = inputTuple;
 
-			binaryheap_add_unordered(hp, iSegIdx);
+			losertree_add_unordered(hp, iSegIdx);
 
 			if (is_memtuple(inputTuple))
 				info->datum1 = memtuple_getattr((MemTuple) inputTuple,
@@ -857,11 +904,11 @@ execMotionSortedReceiverFirstTime(MotionState *node)
 	Assert(iSegIdx == node->numInputSegs);
 
 	/*
-	 * Done adding the elements, now arrange the heap to satisfy the heap
-	 * property. This is quicker than inserting the initial elements one by
-	 * one.
+	 * Done adding the elements, now play all the matches of the tree once,
+	 * bottom up.  After that, each tuple returned only replays the matches
+	 * of its sender, with one comparison per level of the tree.
 	 */
-	binaryheap_build(hp);
+	losertree_build(hp);
 
 	node->tupleheapReady = true;
 }								/* execMotionSortedReceiverFirstTime */
@@ -976,6 +1023,10 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 		motionstate->isExplictGatherMotion = true;
 	}
 
+	/* The planner expects this motion to send a lot, compress its packets */
+	if (motionstate->mstype == MOTIONSTATE_SEND && node->compressTuples)
+		CompressMotionPackets(estate->interconnect_context, node->motionID);
+
 	motionstate->tupleheapReady = false;
 	motionstate->sentEndOfStream = false;
 
@@ -1057,6 +1108,15 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 		}
 
 		motionstate->cdbhash = makeCdbHash(numsegments, nkeys, node->hashFuncs);
+
+		if (gp_motion_skew_threshold > 0)
+		{
+			motionstate->skewSampleCounts = palloc0(numsegments * sizeof(int));
+
+			/* The skew found is reported in EXPLAIN ANALYZE too. */
+			if (estate->es_instrument && (estate->es_instrument & INSTRUMENT_CDB))
+				motionstate->ps.cdbexplainbuf = makeStringInfo();
+		}
 	}
 
 	/* Merge Receive: Set up the key comparator and priority queue. */
@@ -1069,7 +1129,7 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 			/* Allocate context object for the key comparator. */
 			motionstate->tupleheap_entries =
 				palloc(motionstate->numInputSegs * sizeof(CdbTupleHeapInfo));
-			/* Create the priority queue structure. */
+			/* Create the loser tree that merges the senders. */
 			motionstate->tupleheap_cxt =
 				CdbMergeComparator_CreateContext(motionstate->tupleheap_entries,
 												 tupDesc,
@@ -1079,7 +1139,7 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 												 node->collations,
 												 node->nullsFirst);
 			motionstate->tupleheap =
-				binaryheap_allocate(motionstate->numInputSegs,
+				losertree_allocate(motionstate->numInputSegs,
 									CdbMergeComparator,
 									motionstate->tupleheap_cxt);
 		}
@@ -1093,6 +1153,11 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 						  node->sendSorted,
 						  tupDesc);
 
+	/* A broadcast this segment has cached needn't be received again */
+	if (motionstate->mstype == MOTIONSTATE_RECV &&
+		estate->es_broadcastCacheKeys != NIL)
+		motionstate->bcache = BroadcastCacheBeginMotion(estate, node, tupDesc);
+
 
 #ifdef CDB_MOTION_DEBUG
 	motionstate->outputFunArray = (Oid *) palloc(tupDesc->natts * sizeof(Oid));
@@ -1191,7 +1256,7 @@ ExecEndMotion(MotionState *node)
 	/* Merge Receive: Free the priority queue and associated structures. */
 	if (node->tupleheap != NULL)
 	{
-		binaryheap_free(node->tupleheap);
+		losertree_free(node->tupleheap);
 
 		CdbMergeComparator_DestroyContext(node->tupleheap_cxt);
 		node->tupleheap = NULL;
@@ -1208,6 +1273,17 @@ ExecEndMotion(MotionState *node)
 		pfree(node->cdbhash);
 		node->cdbhash = NULL;
 	}
+	if (node->skewSampleCounts != NULL)
+	{
+		pfree(node->skewSampleCounts);
+		node->skewSampleCounts = NULL;
+	}
+
+	if (node->bcache != NULL)
+	{
+		BroadcastCacheEndMotion(node->bcache);
+		node->bcache = NULL;
+	}
 
 	/*
 	 * Free up this motion node's resources in the Motion Layer.
@@ -1516,6 +1592,9 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 		 * is passed around our system a fair amount!).
 		 */
 		Assert(targetRoute != BROADCAST_SEGIDX);
+
+		if (node->skewSampleCounts != NULL)
+			checkMotionSkew(motion, node, targetRoute);
 	}
 	else						/* ExplicitRedistribute */
 	{
@@ -1568,6 +1647,54 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 }
 
 
+/*
+ * checkMotionSkew
+ *
+ * Count a row of the sample sent to the target route by a Redistribute
+ * Motion.  Once the sample is complete, report it if more than
+ * gp_motion_skew_threshold of the rows went to a single segment: the
+ * segment will get most of the work of the slice receiving them.
+ */
+static void
+checkMotionSkew(Motion *motion, MotionState *node, int16 targetRoute)
+{
+	int			numsegments = node->cdbhash->numsegs;
+	int			maxRoute = 0;
+	int			i;
+
+	node->skewSampleCounts[targetRoute]++;
+
+	if (node->numTuplesFromChild < MOTION_SKEW_SAMPLE_SIZE)
+		return;
+
+	for (i = 1; i < numsegments; i++)
+	{
+		if (node->skewSampleCounts[i] > node->skewSampleCounts[maxRoute])
+			maxRoute = i;
+	}
+
+	if (node->skewSampleCounts[maxRoute] >
+		gp_motion_skew_threshold * MOTION_SKEW_SAMPLE_SIZE)
+	{
+		ereport(LOG,
+				(errmsg("Redistribute Motion %d sent %d of its first %d rows to segment %d",
+						motion->motionID, node->skewSampleCounts[maxRoute],
+						MOTION_SKEW_SAMPLE_SIZE, maxRoute),
+				 errhint("The values of the redistribution keys are skewed.")));
+
+		if (node->ps.cdbexplainbuf)
+			appendStringInfo(node->ps.cdbexplainbuf,
+							 "Skew: %d of the first %d rows sent to seg%d.\n",
+							 node->skewSampleCounts[maxRoute],
+							 MOTION_SKEW_SAMPLE_SIZE, maxRoute);
+	}
+
+	/* Only the first rows are sampled. */
+	pfree(node->skewSampleCounts);
+	node->skewSampleCounts = NULL;
+}
+
+
 /*
  * ExecReScanMotion
  *
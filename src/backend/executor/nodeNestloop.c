@@ -25,12 +25,77 @@
 
 #include "executor/execdebug.h"
 #include "executor/nodeNestloop.h"
+#include "lib/ilist.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/typcache.h"
+
+/*
+ * When the inner side is parameterized by the outer rows (nestParams), outer
+ * rows with the same parameter values would rescan the inner side for the
+ * same rows.  The inner rows for recent parameter values are kept in an LRU
+ * cache bounded by work_mem, and replayed instead of rescanning the inner
+ * plan.  If the hit rate turns out to be low, the cache is dropped and the
+ * join passes through to the inner plan for the rest of the scan.
+ */
+typedef struct NestLoopCacheEntryData
+{
+	TupleHashEntryData shared;	/* common header for hash table entries */
+	dlist_node	lru_node;		/* position in the LRU list */
+	List	   *tuples;			/* inner rows for these parameter values */
+	Size		size;			/* memory used by the entry */
+} NestLoopCacheEntryData;
+
+typedef NestLoopCacheEntryData *NestLoopCacheEntry;
+
+typedef struct NestLoopCache
+{
+	TupleHashTable hashtable;	/* entries, keyed by nestParams values */
+	MemoryContext tablecxt;		/* memory context containing hashtable */
+	MemoryContext tempcxt;		/* temp memory context for hashtable */
+	int			numKeys;
+	AttrNumber *keyColIdx;
+	FmgrInfo   *eqfuncs;
+	FmgrInfo   *hashfuncs;
+	TupleTableSlot *keyslot;	/* nestParams values of the outer row */
+	TupleTableSlot *evictslot;	/* key of the entry being evicted */
+	TupleTableSlot *innerslot;	/* inner row returned from the cache */
+	dlist_head	lru;			/* entries, least recently used first */
+	Size		used;			/* memory used by all entries */
+	Size		limit;
+
+	/* when replaying the cached inner rows for the current outer row: */
+	NestLoopCacheEntry replay;
+	ListCell   *next;
+
+	/* when recording the inner rows for the current outer row: */
+	bool		recording;
+	List	   *recorded;
+	Size		recordedsize;
+
+	long		lookups;
+	long		hits;
+	bool		disabled;		/* hit rate was too low */
+} NestLoopCache;
+
+/* lookups to do before judging the hit rate, and the lowest one we accept */
+#define NESTLOOP_CACHE_MIN_LOOKUPS	1000
+#define NESTLOOP_CACHE_MIN_HIT_RATE	0.1
 
 static void splitJoinQualExpr(NestLoopState *nlstate);
 static void extractFuncExprArgs(FuncExprState *fstate, List **lclauses, List **rclauses);
+static void initNestLoopCache(NestLoopState *nlstate, NestLoop *node,
+				  EState *estate);
+static void resetNestLoopCache(NestLoopCache *cache);
+static bool lookupNestLoopCache(NestLoopCache *cache, List *nestParams,
+					ExprContext *econtext);
+static TupleTableSlot *nextCachedInner(NestLoopCache *cache);
+static void evictNestLoopCache(NestLoopCache *cache);
+static void recordInner(NestLoopCache *cache, TupleTableSlot *slot);
 
 /* ----------------------------------------------------------------
  *		ExecNestLoop(node)
@@ -205,13 +270,22 @@ ExecNestLoop_guts(NestLoopState *node)
 			}
 
 			/*
-			 * now rescan the inner plan
+			 * now rescan the inner plan, unless we have its rows for these
+			 * parameter values cached
 			 */
-			ENL1_printf("rescanning inner plan");
-			if (node->require_inner_reset || node->reset_inner)
+			if (node->nl_cache != NULL &&
+				lookupNestLoopCache(node->nl_cache, nl->nestParams, econtext))
 			{
-				ExecReScan(innerPlan);
-				node->reset_inner = false;
+				ENL1_printf("replaying cached inner tuples");
+			}
+			else
+			{
+				ENL1_printf("rescanning inner plan");
+				if (node->require_inner_reset || node->reset_inner)
+				{
+					ExecReScan(innerPlan);
+					node->reset_inner = false;
+				}
 			}
 		}
 
@@ -220,7 +294,14 @@ ExecNestLoop_guts(NestLoopState *node)
 		 */
 		ENL1_printf("getting new inner tuple");
 
-		innerTupleSlot = ExecProcNode(innerPlan);
+		if (node->nl_cache != NULL && node->nl_cache->replay != NULL)
+			innerTupleSlot = nextCachedInner(node->nl_cache);
+		else
+		{
+			innerTupleSlot = ExecProcNode(innerPlan);
+			if (node->nl_cache != NULL && node->nl_cache->recording)
+				recordInner(node->nl_cache, innerTupleSlot);
+		}
 
 		node->reset_inner = true;
 		econtext->ecxt_innertuple = innerTupleSlot;
@@ -462,6 +543,8 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 	 */
 	ExecInitResultTupleSlot(estate, &nlstate->js.ps);
 
+	initNestLoopCache(nlstate, node, estate);
+
 	switch (node->join.jointype)
 	{
 		case JOIN_INNER:
@@ -555,6 +638,20 @@ void
 ExecReScanNestLoop(NestLoopState *node)
 {
 	PlanState  *outerPlan = outerPlanState(node);
+	PlanState  *innerPlan = innerPlanState(node);
+
+	/*
+	 * The cached inner rows are only valid as long as the inner plan's other
+	 * parameters stay the same.
+	 */
+	if (node->nl_cache != NULL &&
+		bms_overlap(node->js.ps.chgParam, innerPlan->plan->allParam))
+	{
+		resetNestLoopCache(node->nl_cache);
+		node->nl_cache->lookups = 0;
+		node->nl_cache->hits = 0;
+		node->nl_cache->disabled = false;
+	}
 
 	/*
 	 * If outerPlan->chgParam is not null then plan will be automatically
@@ -673,3 +770,286 @@ extractFuncExprArgs(FuncExprState *fstate, List **lclauses, List **rclauses)
 		*rclauses = lappend(*rclauses, lsecond(fstate->args));
 	}
 }
+
+/* ----------------------------------------------------------------
+ * initNestLoopCache
+ *
+ * Set up the cache of inner rows by nestParams values, if the inner plan
+ * returns the same rows whenever it gets the same parameter values.
+ * ----------------------------------------------------------------
+ */
+static void
+initNestLoopCache(NestLoopState *nlstate, NestLoop *node, EState *estate)
+{
+	NestLoopCache *cache;
+	List	   *paramvals = NIL;
+	Oid		   *eqOperators;
+	TupleDesc	tupDesc;
+	ListCell   *lc;
+	int			i;
+
+	nlstate->nl_cache = NULL;
+
+	/* with a single outer row, there is nothing to reuse */
+	if (!gp_enable_nestloop_cache ||
+		node->nestParams == NIL ||
+		node->singleton_outer)
+		return;
+
+	foreach(lc, node->nestParams)
+	{
+		NestLoopParam *nlp = (NestLoopParam *) lfirst(lc);
+
+		if (!ExecIsMemoizableType(exprType((Node *) nlp->paramval)))
+			return;
+		paramvals = lappend(paramvals, nlp->paramval);
+	}
+
+	if (ExecPlanContainsVolatileFunctions(estate, innerPlan(node)))
+		return;
+
+	cache = (NestLoopCache *) palloc0(sizeof(NestLoopCache));
+	cache->numKeys = list_length(paramvals);
+	cache->keyColIdx = (AttrNumber *) palloc(cache->numKeys * sizeof(AttrNumber));
+	eqOperators = (Oid *) palloc(cache->numKeys * sizeof(Oid));
+	i = 0;
+	foreach(lc, paramvals)
+	{
+		TypeCacheEntry *typentry;
+
+		typentry = lookup_type_cache(exprType((Node *) lfirst(lc)),
+									 TYPECACHE_EQ_OPR);
+		eqOperators[i] = typentry->eq_opr;
+		cache->keyColIdx[i] = i + 1;
+		i++;
+	}
+	execTuplesHashPrepare(cache->numKeys, eqOperators,
+						  &cache->eqfuncs, &cache->hashfuncs);
+	pfree(eqOperators);
+
+	cache->tablecxt = AllocSetContextCreate(CurrentMemoryContext,
+											"NestLoop Cache Context",
+											ALLOCSET_DEFAULT_MINSIZE,
+											ALLOCSET_DEFAULT_INITSIZE,
+											ALLOCSET_DEFAULT_MAXSIZE);
+	cache->tempcxt = AllocSetContextCreate(CurrentMemoryContext,
+										   "NestLoop Cache Temp Context",
+										   ALLOCSET_SMALL_MINSIZE,
+										   ALLOCSET_SMALL_INITSIZE,
+										   ALLOCSET_SMALL_MAXSIZE);
+
+	tupDesc = ExecTypeFromExprList(paramvals);
+	cache->keyslot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(cache->keyslot, tupDesc);
+	cache->evictslot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(cache->evictslot, tupDesc);
+	cache->innerslot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(cache->innerslot,
+						  ExecGetResultType(innerPlanState(nlstate)));
+
+	cache->limit = (Size) work_mem * 1024L;
+	dlist_init(&cache->lru);
+
+	nlstate->nl_cache = cache;
+}
+
+/*
+ * resetNestLoopCache
+ *
+ * Forget all cached inner rows.
+ */
+static void
+resetNestLoopCache(NestLoopCache *cache)
+{
+	MemoryContextReset(cache->tablecxt);
+	cache->hashtable = NULL;
+	dlist_init(&cache->lru);
+	cache->used = 0;
+	cache->replay = NULL;
+	cache->next = NULL;
+	cache->recording = false;
+	cache->recorded = NIL;
+	cache->recordedsize = 0;
+}
+
+/*
+ * lookupNestLoopCache
+ *
+ * Look up the inner rows for the nestParams values of a new outer row, which
+ * the caller has just computed.  On a hit, set up to replay them and return
+ * true.  Otherwise, set up to record the rows of the inner scan.
+ */
+static bool
+lookupNestLoopCache(NestLoopCache *cache, List *nestParams,
+					ExprContext *econtext)
+{
+	NestLoopCacheEntry entry;
+	Datum	   *values;
+	bool	   *isnull;
+	ListCell   *lc;
+	int			i;
+
+	cache->replay = NULL;
+	cache->next = NULL;
+
+	/* the inner scan for the previous outer row was cut short */
+	if (cache->recording)
+	{
+		list_free_deep(cache->recorded);
+		cache->recorded = NIL;
+		cache->recordedsize = 0;
+		cache->recording = false;
+	}
+
+	if (cache->disabled)
+		return false;
+
+	ExecClearTuple(cache->keyslot);
+	values = slot_get_values(cache->keyslot);
+	isnull = slot_get_isnull(cache->keyslot);
+	i = 0;
+	foreach(lc, nestParams)
+	{
+		NestLoopParam *nlp = (NestLoopParam *) lfirst(lc);
+		ParamExecData *prm = &(econtext->ecxt_param_exec_vals[nlp->paramno]);
+
+		values[i] = prm->value;
+		isnull[i] = prm->isnull;
+		i++;
+	}
+	ExecStoreVirtualTuple(cache->keyslot);
+
+	if (cache->hashtable == NULL)
+		cache->hashtable = BuildTupleHashTable(cache->numKeys,
+											   cache->keyColIdx,
+											   cache->eqfuncs,
+											   cache->hashfuncs,
+											   256,
+											   sizeof(NestLoopCacheEntryData),
+											   cache->tablecxt,
+											   cache->tempcxt);
+
+	entry = (NestLoopCacheEntry) LookupTupleHashEntry(cache->hashtable,
+													  cache->keyslot, NULL);
+	MemoryContextReset(cache->tempcxt);
+	cache->lookups++;
+
+	if (entry != NULL)
+	{
+		cache->hits++;
+		dlist_delete(&entry->lru_node);
+		dlist_push_tail(&cache->lru, &entry->lru_node);
+		cache->replay = entry;
+		cache->next = list_head(entry->tuples);
+		return true;
+	}
+
+	if (cache->lookups >= NESTLOOP_CACHE_MIN_LOOKUPS &&
+		cache->hits < cache->lookups * NESTLOOP_CACHE_MIN_HIT_RATE)
+	{
+		resetNestLoopCache(cache);
+		cache->disabled = true;
+		return false;
+	}
+
+	cache->recording = true;
+	return false;
+}
+
+/*
+ * nextCachedInner
+ *
+ * Return the next cached inner row for the current outer row, or an empty
+ * slot at the end.
+ */
+static TupleTableSlot *
+nextCachedInner(NestLoopCache *cache)
+{
+	MemTuple	tuple;
+
+	if (cache->next == NULL)
+		return ExecClearTuple(cache->innerslot);
+
+	tuple = (MemTuple) lfirst(cache->next);
+	cache->next = lnext(cache->next);
+
+	return ExecStoreMinimalTuple(tuple, cache->innerslot, false);
+}
+
+/*
+ * evictNestLoopCache
+ *
+ * Remove the least recently used entry from the cache.
+ */
+static void
+evictNestLoopCache(NestLoopCache *cache)
+{
+	NestLoopCacheEntry entry;
+	MemTuple	key;
+
+	entry = dlist_container(NestLoopCacheEntryData, lru_node,
+							dlist_pop_head_node(&cache->lru));
+	list_free_deep(entry->tuples);
+	cache->used -= entry->size;
+
+	key = entry->shared.firstTuple;
+	ExecStoreMinimalTuple(key, cache->evictslot, false);
+	RemoveTupleHashEntry(cache->hashtable, cache->evictslot);
+	MemoryContextReset(cache->tempcxt);
+	ExecClearTuple(cache->evictslot);
+	pfree(key);
+}
+
+/*
+ * recordInner
+ *
+ * Remember a row of the inner scan for the current outer row.  At the end of
+ * the scan, add the rows to the cache, evicting old entries to make room.
+ */
+static void
+recordInner(NestLoopCache *cache, TupleTableSlot *slot)
+{
+	MemoryContext oldcontext;
+	NestLoopCacheEntry entry;
+	Size		size;
+	bool		isnew;
+
+	if (!TupIsNull(slot))
+	{
+		MemTuple	tuple;
+
+		oldcontext = MemoryContextSwitchTo(cache->tablecxt);
+		tuple = ExecCopySlotMemTuple(slot);
+		cache->recorded = lappend(cache->recorded, tuple);
+		cache->recordedsize += GetMemoryChunkSpace(tuple) + sizeof(ListCell);
+		MemoryContextSwitchTo(oldcontext);
+
+		/* too big to cache at all */
+		if (cache->recordedsize > cache->limit)
+		{
+			list_free_deep(cache->recorded);
+			cache->recorded = NIL;
+			cache->recordedsize = 0;
+			cache->recording = false;
+		}
+		return;
+	}
+
+	size = cache->recordedsize + sizeof(NestLoopCacheEntryData);
+	while (cache->used + size > cache->limit && !dlist_is_empty(&cache->lru))
+		evictNestLoopCache(cache);
+
+	entry = (NestLoopCacheEntry) LookupTupleHashEntry(cache->hashtable,
+													  cache->keyslot, &isnew);
+	MemoryContextReset(cache->tempcxt);
+	Assert(isnew);
+
+	entry->tuples = cache->recorded;
+	entry->size = size + GetMemoryChunkSpace(entry->shared.firstTuple);
+	cache->used += entry->size;
+	dlist_push_tail(&cache->lru, &entry->lru_node);
+
+	cache->recorded = NIL;
+	cache->recordedsize = 0;
+	cache->recording = false;
+}
@@ -204,6 +204,14 @@ ExecPartitionSelector(PartitionSelectorState *node)
 		List	   *oids;
 		ListCell   *lc;
 
+		/*
+		 * Without input, the keys are computed once from the parameters of
+		 * the query. Make sure there is an entry for the scan even if no
+		 * partition is selected, like at the end of the input above.
+		 */
+		if (NULL == outerPlanState(node))
+			InsertPidIntoDynamicTableScanInfo(estate, ps->scanId, InvalidOid, ps->selectorId);
+
 		slot = ExecProject(node->partTabProj, NULL);
 		slot_getallattrs(slot);
 
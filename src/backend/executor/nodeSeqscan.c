@@ -27,6 +27,8 @@
 #include "access/relscan.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSeqscan.h"
+#include "optimizer/clauses.h"
+#include "optimizer/var.h"
 #include "utils/rel.h"
 
 #include "cdb/cdbappendonlyam.h"
@@ -37,6 +39,7 @@ static void InitScanRelation(SeqScanState *node, EState *estate, int eflags, Rel
 static TupleTableSlot *SeqNext(SeqScanState *node);
 
 static void InitAOCSScanOpaque(SeqScanState *scanState, Relation currentRelation);
+static void InitAOCSLateQuals(SeqScanState *scanState);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -184,6 +187,11 @@ InitScanRelation(SeqScanState *node, EState *estate, int eflags, Relation curren
 						   appendOnlyMetaDataSnapshot,
 						   NULL /* relationTupleDesc */,
 						   node->ss_aocs_proj);
+		aocs_set_zonemap_quals(node->ss_currentScanDesc_aocs,
+							   node->ss.ps.plan->qual);
+		aocs_set_dictionary_quals(node->ss_currentScanDesc_aocs,
+								  node->ss.ps.plan->qual);
+		InitAOCSLateQuals(node);
 	}
 	else
 	{
@@ -396,3 +404,42 @@ InitAOCSScanOpaque(SeqScanState *scanstate, Relation currentRelation)
 	scanstate->ss_aocs_ncol = ncol;
 	scanstate->ss_aocs_proj = proj;
 }
+
+/*
+ * Let the AOCS scan read the columns the quals don't use only for the rows
+ * that satisfy the quals, see aocs_set_late_quals().
+ */
+static void
+InitAOCSLateQuals(SeqScanState *scanstate)
+{
+	Node	   *quals = (Node *) scanstate->ss.ps.plan->qual;
+	bool	   *qualCols;
+	List	   *vars;
+	ListCell   *lc;
+
+	if (quals == NULL ||
+		contain_volatile_functions(quals) || contain_subplans(quals))
+		return;
+
+	qualCols = palloc0(scanstate->ss_aocs_ncol * sizeof(bool));
+	vars = pull_var_clause(quals, PVC_RECURSE_AGGREGATES,
+						   PVC_RECURSE_PLACEHOLDERS);
+	foreach(lc, vars)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+
+		/* the system columns and the whole row are set when it's returned */
+		if (var->varattno <= 0)
+		{
+			list_free(vars);
+			pfree(qualCols);
+			return;
+		}
+		qualCols[var->varattno - 1] = true;
+	}
+	list_free(vars);
+
+	aocs_set_late_quals(scanstate->ss_currentScanDesc_aocs, qualCols,
+						scanstate->ss.ps.qual, scanstate->ss.ps.ps_ExprContext);
+	pfree(qualCols);
+}
@@ -26,9 +26,19 @@
 #include "utils/workfile_mgr.h"
 #include "executor/instrument.h"
 #include "utils/faultinjector.h"
+#include "utils/lsyscache.h"
+
+/*
+ * An incremental sort ends a run at the first change of the presorted keys
+ * after this many rows, so that runs of a few rows don't each pay for the
+ * setup of a tuplesort.
+ */
+#define INCREMENTAL_SORT_MIN_RUN	32
 
 static void ExecSortExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static void ExecEagerFreeSort(SortState *node);
+static void ExecSortPlanBound(SortState *node, bool *bounded, int64 *bound);
+static TupleTableSlot *ExecIncrementalSort(SortState *node);
 
 /* ----------------------------------------------------------------
  *		ExecSort
@@ -54,6 +64,11 @@ ExecSort(SortState *node)
 	Sort 		*plannode = NULL;
 	PlanState  *outerNode = NULL;
 	TupleDesc	tupDesc = NULL;
+	bool		bounded;
+	int64		bound;
+
+	if (node->presortedCols > 0)
+		return ExecIncrementalSort(node);
 
 	/*
 	 * get state info from node
@@ -140,8 +155,11 @@ ExecSort(SortState *node)
 												  node->randomAccess);
 		}
 
-		if (node->bounded)
-			tuplesort_set_bound(tuplesortstate, node->bound);
+		bounded = node->bounded;
+		bound = node->bound;
+		ExecSortPlanBound(node, &bounded, &bound);
+		if (bounded)
+			tuplesort_set_bound(tuplesortstate, bound);
 		node->tuplesortstate->sortstore = tuplesortstate;
 
 		/* CDB */
@@ -255,6 +273,146 @@ ExecSort(SortState *node)
 	return slot;
 }
 
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Sorts an input that is already sorted on the leading sort keys.
+ *		The input is read in runs of rows with equal values in those keys,
+ *		and each run is sorted on its own and returned before the next one
+ *		is read.  A run thus only needs the memory of its own rows, and the
+ *		first rows are returned without reading the whole input.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(SortState *node)
+{
+	EState	   *estate = node->ss.ps.state;
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	TupleTableSlot *pivot = node->presortedPivot;
+	MemoryContext evalContext = node->ss.ps.ps_ExprContext->ecxt_per_tuple_memory;
+	Tuplesortstate *tuplesortstate;
+	ScanDirection dir;
+	int64		remaining = 0;
+	int64		ntuples;
+
+	if (!node->sort_Done)
+	{
+		bool		bounded = node->bounded;
+		int64		bound = node->bound;
+
+		ExecSortPlanBound(node, &bounded, &bound);
+		node->bounded_Done = bounded;
+		node->bound_Done = bound;
+		node->tuplesortstate->sortstore = NULL;
+		node->presortedPending = false;
+		node->presortedInputDone = false;
+		node->presortedEmitted = 0;
+		ExecClearTuple(pivot);
+		node->sort_Done = true;
+	}
+
+	for (;;)
+	{
+		if (node->bounded_Done)
+			remaining = node->bound_Done - node->presortedEmitted;
+
+		/* return the rows of the current run */
+		tuplesortstate = node->tuplesortstate->sortstore;
+		if (tuplesortstate != NULL)
+		{
+			if (!node->bounded_Done || remaining > 0)
+			{
+				(void) tuplesort_gettupleslot(tuplesortstate, true, slot);
+				if (!TupIsNull(slot))
+				{
+					node->presortedEmitted++;
+					return slot;
+				}
+			}
+
+			tuplesort_end(tuplesortstate);
+			node->tuplesortstate->sortstore = NULL;
+		}
+
+		if (node->presortedInputDone ||
+			(node->bounded_Done && remaining <= 0))
+		{
+			ExecClearTuple(slot);
+			if (!node->delayEagerFree)
+				ExecEagerFreeSort(node);
+			return slot;
+		}
+
+		/* read and sort the next run */
+		tuplesortstate = tuplesort_begin_heap(&node->ss,
+											  ExecGetResultType(outerNode),
+											  plannode->numCols,
+											  plannode->sortColIdx,
+											  plannode->sortOperators,
+											  plannode->collations,
+											  plannode->nullsFirst,
+											  PlanStateOperatorMemKB((PlanState *) node),
+											  false);
+		if (node->bounded_Done)
+			tuplesort_set_bound(tuplesortstate, remaining);
+		cdb_tuplesort_init(tuplesortstate, 0, gp_sort_flags,
+						   gp_sort_max_distinct);
+		tuplesort_set_gpmon(tuplesortstate, &node->ss.ps.gpmon_pkt,
+							&node->ss.ps.gpmon_plan_tick);
+		node->tuplesortstate->sortstore = tuplesortstate;
+
+		dir = estate->es_direction;
+		estate->es_direction = ForwardScanDirection;
+
+		ntuples = 0;
+		if (node->presortedPending)
+		{
+			tuplesort_puttupleslot(tuplesortstate, pivot);
+			node->presortedPending = false;
+			ntuples++;
+		}
+
+		for (;;)
+		{
+			TupleTableSlot *outerslot = ExecProcNode(outerNode);
+
+			if (TupIsNull(outerslot))
+			{
+				node->presortedInputDone = true;
+				break;
+			}
+
+			if (ntuples == 0)
+				ExecCopySlot(pivot, outerslot);
+			else if (!execTuplesMatch(pivot, outerslot,
+									  node->presortedCols,
+									  plannode->sortColIdx,
+									  node->presortedEqfunctions,
+									  evalContext))
+			{
+				ExecCopySlot(pivot, outerslot);
+
+				/* the row starts the next run */
+				if (ntuples >= INCREMENTAL_SORT_MIN_RUN)
+				{
+					node->presortedPending = true;
+					break;
+				}
+			}
+
+			tuplesort_puttupleslot(tuplesortstate, outerslot);
+			ntuples++;
+		}
+
+		tuplesort_performsort(tuplesortstate);
+		estate->es_direction = dir;
+
+		CheckSendPlanStateGpmonPkt(&node->ss.ps);
+	}
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSort
  *
@@ -306,6 +464,10 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	/* CDB */ /* evaluate a limit as part of the sort */
 	{
 		sortstate->noduplicates = node->noduplicates;
+		sortstate->limitOffset = ExecInitExpr((Expr *) node->limitOffset,
+											  (PlanState *) sortstate);
+		sortstate->limitCount = ExecInitExpr((Expr *) node->limitCount,
+											 (PlanState *) sortstate);
 	}
 
 	/*
@@ -389,6 +551,42 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 		snEntry->shareState = (Node *)sortstate;
 	}
 
+	/*
+	 * Sort the input in runs of equal presorted keys, if it is already sorted
+	 * on some of the keys.  The runs are discarded as they are returned, so
+	 * this can't be done if the output might be read again.
+	 */
+	sortstate->presortedCols = 0;
+	if (node->numPresortedCols > 0 && node->share_type == SHARE_NOTSHARED &&
+		!node->noduplicates && !sortstate->randomAccess)
+	{
+		FmgrInfo   *eqfunctions;
+		int			i;
+
+		Assert(node->numPresortedCols <= node->numCols);
+		eqfunctions = (FmgrInfo *) palloc(node->numPresortedCols * sizeof(FmgrInfo));
+		for (i = 0; i < node->numPresortedCols; i++)
+		{
+			Oid			eqop;
+
+			eqop = get_equality_op_for_ordering_op(node->sortOperators[i], NULL);
+			if (!OidIsValid(eqop))
+				break;
+			fmgr_info(get_opcode(eqop), &eqfunctions[i]);
+		}
+
+		if (i == node->numPresortedCols)
+		{
+			sortstate->presortedCols = node->numPresortedCols;
+			sortstate->presortedEqfunctions = eqfunctions;
+			sortstate->presortedPivot = ExecInitExtraTupleSlot(estate);
+			ExecSetSlotDescriptor(sortstate->presortedPivot,
+								  ExecGetResultType(outerPlanState(sortstate)));
+		}
+		else
+			pfree(eqfunctions);
+	}
+
 	SO1_printf("ExecInitSort: %s\n",
 			   "sort node initialized");
 
@@ -474,11 +672,13 @@ ExecReScanSort(SortState *node)
 	/*
 	 * If subnode is to be rescanned then we forget previous sort results; we
 	 * have to re-read the subplan and re-sort.  Also must re-sort if the
-	 * bounded-sort parameters changed or we didn't select randomAccess.
+	 * bounded-sort parameters changed, including the parameters of the bound
+	 * in the plan, or we didn't select randomAccess.
 	 *
 	 * Otherwise we can just rewind and rescan the sorted output.
 	 */
 	if (node->ss.ps.lefttree->chgParam != NULL ||
+		(node->limitCount != NULL && node->ss.ps.chgParam != NULL) ||
 		node->bounded != node->bounded_Done ||
 		node->bound != node->bound_Done ||
 		!node->randomAccess ||
@@ -489,6 +689,7 @@ ExecReScanSort(SortState *node)
 		if (NULL != node->tuplesortstate->sortstore)
 		{
 			tuplesort_end(node->tuplesortstate->sortstore);
+			node->tuplesortstate->sortstore = NULL;
 		}
 
 		/*
@@ -503,6 +704,59 @@ ExecReScanSort(SortState *node)
 }
 
 
+/*
+ * ExecSortPlanBound
+ *		Apply the bound of the plan to the bound passed down by a Limit above.
+ *
+ * A Limit on the other side of a Motion can't pass its bound down at run time,
+ * so the planner leaves a copy of its LIMIT/OFFSET in the Sort.  The Limit
+ * checks the values and reports errors, we just don't use a bound if the
+ * values are not usable.
+ */
+static void
+ExecSortPlanBound(SortState *node, bool *bounded, int64 *bound)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	Datum		val;
+	bool		isNull;
+	int64		count;
+	int64		offset = 0;
+	int64		tuples_needed;
+
+	if (node->limitCount == NULL || !gp_enable_sort_limit)
+		return;
+
+	val = ExecEvalExprSwitchContext(node->limitCount, econtext, &isNull, NULL);
+	/* NULL count is LIMIT ALL */
+	if (isNull)
+		return;
+	count = DatumGetInt64(val);
+	if (count < 0)
+		return;
+
+	if (node->limitOffset)
+	{
+		val = ExecEvalExprSwitchContext(node->limitOffset, econtext,
+										&isNull, NULL);
+		/* NULL offset is no offset */
+		if (!isNull)
+			offset = DatumGetInt64(val);
+		if (offset < 0)
+			return;
+	}
+
+	/* negative test checks for overflow */
+	tuples_needed = count + offset;
+	if (tuples_needed < 0)
+		return;
+
+	if (!*bounded || tuples_needed < *bound)
+	{
+		*bounded = true;
+		*bound = tuples_needed;
+	}
+}
+
 /*
  * ExecSortExplainEnd
  *      Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
@@ -26,11 +26,15 @@
 #include "access/htup_details.h"
 #include "executor/executor.h"
 #include "executor/nodeSubplan.h"
+#include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "optimizer/clauses.h"
 #include "utils/array.h"
+#include "utils/datum.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/typcache.h"
 #include "access/heapam.h"
 #include "cdb/cdbexplain.h"             /* cdbexplain_recvExecStats */
 #include "cdb/cdbvars.h"
@@ -54,6 +58,23 @@ static bool findPartialMatch(TupleHashTable hashtable, TupleTableSlot *slot,
 				 FmgrInfo *eqfunctions);
 static bool slotAllNulls(TupleTableSlot *slot);
 static bool slotNoNulls(TupleTableSlot *slot);
+static void initSubPlanMemo(SubPlanState *sstate, EState *estate);
+static bool lookupSubPlanMemo(SubPlanState *node, ExprContext *econtext,
+				  Datum *result, bool *isNull);
+static void saveSubPlanMemo(SubPlanState *node, Datum result, bool isNull);
+
+/*
+ * Entry of the cache of a correlated subplan's results.  The hash key is the
+ * tuple of parParam values.
+ */
+typedef struct SubPlanMemoEntryData
+{
+	TupleHashEntryData shared;	/* common header for hash table entries */
+	Datum		result;			/* subplan result for these parameters */
+	bool		isnull;
+} SubPlanMemoEntryData;
+
+typedef SubPlanMemoEntryData *SubPlanMemoEntry;
 
 
 /* ----------------------------------------------------------------
@@ -266,9 +287,23 @@ ExecScanSubPlan(SubPlanState *node,
 											   econtext,
 											   &(prm->isnull),
 											   NULL);
-		planstate->chgParam = bms_add_member(planstate->chgParam, paramid);
 	}
 
+	/*
+	 * If we have already run the subplan with these parameter values, just
+	 * return the result we got then.
+	 */
+	if (node->memoslot != NULL &&
+		lookupSubPlanMemo(node, econtext, &result, isNull))
+	{
+		MemoryContextSwitchTo(oldcontext);
+		return result;
+	}
+
+	foreach(l, subplan->parParam)
+		planstate->chgParam = bms_add_member(planstate->chgParam,
+											 lfirst_int(l));
+
 	/*
 	 * Now that we've set up its parameters, we can reset the subplan.
 	 */
@@ -449,9 +484,207 @@ ExecScanSubPlan(SubPlanState *node,
 		}
 	}
 
+	if (node->memoslot != NULL)
+		saveSubPlanMemo(node, result, *isNull);
+
 	return result;
 }
 
+/*
+ * initSubPlanMemo: set up caching of the results of a correlated subplan by
+ * the values of its parameters, if that is safe.
+ *
+ * When the same parameter values come up again, the cached result is returned
+ * without rescanning the subplan.  This makes a correlated subquery whose
+ * correlation values repeat cost about as much as a join.  The hash table
+ * reuses the hashtablecxt, keyColIdx and tab_*_funcs fields, which are
+ * otherwise only used by hashed ANY subplans.
+ */
+static void
+initSubPlanMemo(SubPlanState *sstate, EState *estate)
+{
+	SubPlan    *subplan = (SubPlan *) sstate->xprstate.expr;
+	int			ncols = list_length(subplan->args);
+	Oid		   *eqOperators;
+	TupleDesc	tupDesc;
+	ListCell   *l;
+	int			i;
+
+	if (!gp_enable_subplan_cache ||
+		subplan->useHashTable ||
+		subplan->parParam == NIL ||
+		subplan->setParam != NIL)
+		return;
+
+	/*
+	 * The result of ANY, ALL and ROWCOMPARE sublinks also depends on the
+	 * lefthand expressions, which are evaluated in the parent.
+	 */
+	switch (subplan->subLinkType)
+	{
+		case EXISTS_SUBLINK:
+		case NOT_EXISTS_SUBLINK:
+			sstate->memotyplen = sizeof(bool);
+			sstate->memotypbyval = true;
+			break;
+		case EXPR_SUBLINK:
+			get_typlenbyval(subplan->firstColType,
+							&sstate->memotyplen, &sstate->memotypbyval);
+			break;
+		case ARRAY_SUBLINK:
+			sstate->memotyplen = -1;
+			sstate->memotypbyval = false;
+			break;
+		default:
+			return;
+	}
+
+	foreach(l, subplan->args)
+	{
+		if (!ExecIsMemoizableType(exprType((Node *) lfirst(l))))
+			return;
+	}
+
+	/* a volatile subplan must be rerun, even with the same parameters */
+	if (ExecPlanContainsVolatileFunctions(estate, sstate->planstate->plan))
+		return;
+
+	eqOperators = (Oid *) palloc(ncols * sizeof(Oid));
+	sstate->keyColIdx = (AttrNumber *) palloc(ncols * sizeof(AttrNumber));
+	i = 0;
+	foreach(l, subplan->args)
+	{
+		TypeCacheEntry *typentry;
+
+		typentry = lookup_type_cache(exprType((Node *) lfirst(l)),
+									 TYPECACHE_EQ_OPR);
+		eqOperators[i] = typentry->eq_opr;
+		sstate->keyColIdx[i] = i + 1;
+		i++;
+	}
+	execTuplesHashPrepare(ncols, eqOperators,
+						  &sstate->tab_eq_funcs, &sstate->tab_hash_funcs);
+	pfree(eqOperators);
+
+	foreach(l, subplan->parParam)
+		sstate->memoparams = bms_add_member(sstate->memoparams, lfirst_int(l));
+
+	sstate->hashtablecxt =
+		AllocSetContextCreate(CurrentMemoryContext,
+							  "Subplan Cache Context",
+							  ALLOCSET_DEFAULT_MINSIZE,
+							  ALLOCSET_DEFAULT_INITSIZE,
+							  ALLOCSET_DEFAULT_MAXSIZE);
+	sstate->hashtempcxt =
+		AllocSetContextCreate(CurrentMemoryContext,
+							  "Subplan Cache Temp Context",
+							  ALLOCSET_SMALL_MINSIZE,
+							  ALLOCSET_SMALL_INITSIZE,
+							  ALLOCSET_SMALL_MAXSIZE);
+
+	tupDesc = ExecTypeFromExprList(subplan->args);
+	sstate->memoslot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(sstate->memoslot, tupDesc);
+}
+
+/*
+ * lookupSubPlanMemo: look for a cached result for the current parParam
+ * values, which the caller has just computed.
+ */
+static bool
+lookupSubPlanMemo(SubPlanState *node, ExprContext *econtext,
+				  Datum *result, bool *isNull)
+{
+	SubPlan    *subplan = (SubPlan *) node->xprstate.expr;
+	PlanState  *planstate = node->planstate;
+	TupleTableSlot *slot = node->memoslot;
+	Datum	   *values;
+	bool	   *isnull;
+	SubPlanMemoEntry entry;
+	ListCell   *l;
+	int			i;
+
+	/*
+	 * The results are only valid as long as the subplan's other parameters
+	 * stay the same.  Our parent marks any that change in chgParam.
+	 */
+	if (!bms_is_subset(planstate->chgParam, node->memoparams))
+	{
+		MemoryContextReset(node->hashtablecxt);
+		node->memotable = NULL;
+		node->memofull = false;
+	}
+
+	ExecClearTuple(slot);
+	values = slot_get_values(slot);
+	isnull = slot_get_isnull(slot);
+	i = 0;
+	foreach(l, subplan->parParam)
+	{
+		ParamExecData *prm = &(econtext->ecxt_param_exec_vals[lfirst_int(l)]);
+
+		values[i] = prm->value;
+		isnull[i] = prm->isnull;
+		i++;
+	}
+	ExecStoreVirtualTuple(slot);
+
+	if (node->memotable == NULL)
+	{
+		node->memotable = BuildTupleHashTable(list_length(subplan->parParam),
+											  node->keyColIdx,
+											  node->tab_eq_funcs,
+											  node->tab_hash_funcs,
+											  256,
+											  sizeof(SubPlanMemoEntryData),
+											  node->hashtablecxt,
+											  node->hashtempcxt);
+		return false;
+	}
+
+	entry = (SubPlanMemoEntry) LookupTupleHashEntry(node->memotable, slot, NULL);
+	MemoryContextReset(node->hashtempcxt);
+	if (entry == NULL)
+		return false;
+
+	*result = entry->result;
+	*isNull = entry->isnull;
+	return true;
+}
+
+/*
+ * saveSubPlanMemo: remember the result of the subplan for the parameter
+ * values in memoslot, unless the cache has used up work_mem.
+ */
+static void
+saveSubPlanMemo(SubPlanState *node, Datum result, bool isNull)
+{
+	SubPlanMemoEntry entry;
+	MemoryContext oldcontext;
+	bool		isnew;
+
+	if (node->memofull)
+		return;
+
+	if (MemoryContextGetCurrentSpace(node->hashtablecxt) >= (Size) work_mem * 1024L)
+	{
+		node->memofull = true;
+		return;
+	}
+
+	entry = (SubPlanMemoEntry) LookupTupleHashEntry(node->memotable,
+													node->memoslot, &isnew);
+	MemoryContextReset(node->hashtempcxt);
+	if (!isnew)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(node->hashtablecxt);
+	entry->isnull = isNull;
+	entry->result = isNull ? (Datum) 0 :
+		datumCopy(result, node->memotypbyval, node->memotyplen);
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * buildSubPlanHash: load hash table by scanning subplan output.
  */
@@ -716,6 +949,10 @@ ExecInitSubPlan(SubPlan *subplan, PlanState *parent)
 	sstate->tab_eq_funcs = NULL;
 	sstate->lhs_hash_funcs = NULL;
 	sstate->cur_eq_funcs = NULL;
+	sstate->memotable = NULL;
+	sstate->memoslot = NULL;
+	sstate->memoparams = NULL;
+	sstate->memofull = false;
 
 	/*
 	 * If this plan is un-correlated or undirect correlated one and want to
@@ -917,6 +1154,8 @@ ExecInitSubPlan(SubPlan *subplan, PlanState *parent)
 													slot,
 													NULL);
 	}
+	else
+		initSubPlanMemo(sstate, estate);
 
 	return sstate;
 }
@@ -35,6 +35,7 @@
 
 #include "cdb/cdbvars.h"
 #include "executor/executor.h"
+#include "executor/nodeIndexonlyscan.h"
 #include "executor/nodeUnique.h"
 #include "utils/memutils.h"
 
@@ -162,6 +163,11 @@ ExecInitUnique(Unique *node, EState *estate, int eflags)
 		execTuplesMatchPrepare(node->numCols,
 							   node->uniqOperators);
 
+	/* only the first tuple of each value is used, let an index scan skip */
+	if (node->numCols == 1)
+		ExecIndexOnlyScanSkipDistinct(outerPlanState(uniquestate),
+									  node->uniqColIdx[0], eflags);
+
 	return uniquestate;
 }
 
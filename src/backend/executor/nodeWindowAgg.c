@@ -37,6 +37,7 @@
 #include "catalog/objectaccess.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "executor/executor.h"
 #include "executor/nodeWindowAgg.h"
 #include "miscadmin.h"
@@ -58,6 +59,12 @@
 
 #include "parser/parse_expr.h" // for exprType
 
+/*
+ * Smallest ROWS frame for which the aggregates without an inverse transition
+ * function are evaluated from partial states, see frame_allows_sliding().
+ */
+#define SLIDING_AGG_MIN_FRAME_ROWS	8
+
 /*
  * All the window function APIs are called with this object, which is passed
  * to window functions as fcinfo->context.
@@ -112,6 +119,7 @@ typedef struct WindowStatePerAggData
 	Oid			transfn_oid;
 	Oid			invtransfn_oid; /* may be InvalidOid */
 	Oid			finalfn_oid;	/* may be InvalidOid */
+	Oid			combinefn_oid;	/* valid only for sliding aggregates */
 
 	/*
 	 * fmgr lookup data for transition functions --- only valid when
@@ -121,6 +129,7 @@ typedef struct WindowStatePerAggData
 	FmgrInfo	transfn;
 	FmgrInfo	invtransfn;
 	FmgrInfo	finalfn;
+	FmgrInfo	combinefn;
 
 	int			numFinalArgs;	/* number of arguments to pass to finalfn */
 
@@ -177,8 +186,21 @@ typedef struct WindowStatePerAggData
 
 	int64		transValueCount;	/* number of currently-aggregated rows */
 
+	/*
+	 * Sliding aggregates keep the rows of the frame before the ones in
+	 * transValue as a stack of partial states, see eval_windowaggregates().
+	 * slideValues[0] is the state of the last of those rows alone, and
+	 * slideValues[slideTop - 1] the state of all of them, from the frame head.
+	 */
+	bool		sliding;		/* use partial states instead of restarting? */
+	Datum	   *slideValues;
+	bool	   *slideNulls;
+	int64		slideTop;		/* number of partial states */
+	int64		slideSize;		/* allocated length of the arrays */
+
 	/* Data local to eval_windowaggregates() */
 	bool		restart;		/* need to restart this agg in this cycle? */
+	bool		slideRebuild;	/* need to rebuild the partial states? */
 } WindowStatePerAggData;
 
 static void initialize_windowaggregate(WindowAggState *winstate,
@@ -194,6 +216,18 @@ static void call_transfunc(WindowAggState *winstate,
 			   WindowStatePerFunc perfuncstate,
 			   WindowStatePerAgg peraggstate,
 			   FunctionCallInfo fcinfo);
+static void combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						MemoryContext aggcontext,
+						Datum *transValue, bool *transValueIsNull,
+						Datum value, bool isnull);
+static void reset_windowaggregate_transvalue(WindowStatePerAgg peraggstate);
+static void rebuild_sliding_windowaggregates(WindowAggState *winstate);
+static void finalize_sliding_windowaggregate(WindowAggState *winstate,
+								 WindowStatePerFunc perfuncstate,
+								 WindowStatePerAgg peraggstate,
+								 Datum *result, bool *isnull);
 static void finalize_windowaggregate(WindowAggState *winstate,
 						 WindowStatePerFunc perfuncstate,
 						 WindowStatePerAgg peraggstate,
@@ -217,6 +251,8 @@ static WindowStatePerAggData *initialize_peragg(WindowAggState *winstate,
 				  WindowFunc *wfunc,
 				  WindowStatePerAgg peraggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
+static bool frame_allows_sliding(WindowAgg *node);
+static int64 sliding_max_states(WindowStatePerAgg peraggstate);
 
 static bool are_peers(WindowAggState *winstate, TupleTableSlot *slot1,
 		  TupleTableSlot *slot2);
@@ -268,6 +304,12 @@ initialize_windowaggregate(WindowAggState *winstate,
 	peraggstate->resultValue = (Datum) 0;
 	peraggstate->resultValueIsNull = true;
 
+	/* the partial states were in the aggcontext reset above */
+	peraggstate->slideValues = NULL;
+	peraggstate->slideNulls = NULL;
+	peraggstate->slideTop = 0;
+	peraggstate->slideSize = 0;
+
 	if (peraggstate->isDistinct)
 	{
 		peraggstate->distinctSortState =
@@ -641,6 +683,77 @@ advance_windowaggregate_base(WindowAggState *winstate,
 	return true;
 }
 
+/*
+ * combine_windowaggregate
+ * Combine the partial state of later rows into the partial state of earlier
+ * ones, with the aggregate's combine function.
+ *
+ * The result replaces *transValue, and is copied into aggcontext if
+ * pass-by-ref, like in call_transfunc.
+ */
+static void
+combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						MemoryContext aggcontext,
+						Datum *transValue, bool *transValueIsNull,
+						Datum value, bool isnull)
+{
+	FunctionCallInfoData fcinfo;
+	Datum		newVal;
+	MemoryContext oldContext;
+
+	if (peraggstate->combinefn.fn_strict)
+	{
+		/* an empty state doesn't change the other one */
+		if (isnull)
+			return;
+
+		if (*transValueIsNull)
+		{
+			oldContext = MemoryContextSwitchTo(aggcontext);
+			*transValue = datumCopy(value,
+									peraggstate->transtypeByVal,
+									peraggstate->transtypeLen);
+			*transValueIsNull = false;
+			MemoryContextSwitchTo(oldContext);
+			return;
+		}
+	}
+
+	oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+
+	InitFunctionCallInfoData(fcinfo, &(peraggstate->combinefn),
+							 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+	fcinfo.arg[0] = *transValue;
+	fcinfo.argnull[0] = *transValueIsNull;
+	fcinfo.arg[1] = value;
+	fcinfo.argnull[1] = isnull;
+	winstate->curaggcontext = aggcontext;
+	newVal = FunctionCallInvoke(&fcinfo);
+	winstate->curaggcontext = NULL;
+
+	if (!peraggstate->transtypeByVal &&
+		DatumGetPointer(newVal) != DatumGetPointer(*transValue))
+	{
+		if (!fcinfo.isnull)
+		{
+			MemoryContextSwitchTo(aggcontext);
+			newVal = datumCopy(newVal,
+							   peraggstate->transtypeByVal,
+							   peraggstate->transtypeLen);
+		}
+		if (!*transValueIsNull)
+			pfree(DatumGetPointer(*transValue));
+	}
+
+	MemoryContextSwitchTo(oldContext);
+	*transValue = newVal;
+	*transValueIsNull = fcinfo.isnull;
+}
+
 /*
  * Call transition function for a DISTINCT-qualified aggregate.
  *
@@ -794,6 +907,188 @@ finalize_windowaggregate(WindowAggState *winstate,
 	MemoryContextSwitchTo(oldContext);
 }
 
+/*
+ * Set the transition value of an aggregate back to the initial value,
+ * without releasing the previous one.
+ */
+static void
+reset_windowaggregate_transvalue(WindowStatePerAgg peraggstate)
+{
+	MemoryContext oldContext;
+
+	if (peraggstate->initValueIsNull)
+		peraggstate->transValue = peraggstate->initValue;
+	else
+	{
+		oldContext = MemoryContextSwitchTo(peraggstate->aggcontext);
+		peraggstate->transValue = datumCopy(peraggstate->initValue,
+											peraggstate->transtypeByVal,
+											peraggstate->transtypeLen);
+		MemoryContextSwitchTo(oldContext);
+	}
+	peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+	peraggstate->transValueCount = 0;
+}
+
+/*
+ * rebuild_sliding_windowaggregates
+ * Make the rows from the frame head to aggregatedupto the partial states of
+ * the sliding aggregates marked for it.
+ *
+ * Their partial states must be empty, and their transValue, which holds all
+ * of those rows, is emptied.  Each row is aggregated alone, then combined
+ * with the state of the rows after it, so that the state of the rows from
+ * any of them to the last one is at hand.
+ */
+static void
+rebuild_sliding_windowaggregates(WindowAggState *winstate)
+{
+	WindowObject agg_winobj = winstate->agg_winobj;
+	TupleTableSlot *temp_slot = winstate->temp_slot_1;
+	int64		nrows = winstate->aggregatedupto - winstate->frameheadpos;
+	int64		pos;
+	int64		k;
+	int			i;
+
+	Assert(nrows > 0);
+
+	for (i = 0; i < winstate->numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		if (!peraggstate->slideRebuild)
+			continue;
+
+		Assert(peraggstate->slideTop == 0);
+
+		if (!peraggstate->transtypeByVal && !peraggstate->transValueIsNull)
+			pfree(DatumGetPointer(peraggstate->transValue));
+
+		if (peraggstate->slideSize < nrows)
+		{
+			if (peraggstate->slideValues)
+			{
+				pfree(peraggstate->slideValues);
+				pfree(peraggstate->slideNulls);
+			}
+			peraggstate->slideValues = (Datum *)
+				MemoryContextAlloc(peraggstate->aggcontext, nrows * sizeof(Datum));
+			peraggstate->slideNulls = (bool *)
+				MemoryContextAlloc(peraggstate->aggcontext, nrows * sizeof(bool));
+			peraggstate->slideSize = nrows;
+		}
+	}
+
+	/* the state of each row alone, the last row first */
+	for (pos = winstate->frameheadpos; pos < winstate->aggregatedupto; pos++)
+	{
+		if (!window_gettupleslot(agg_winobj, pos, temp_slot))
+			elog(ERROR, "could not re-fetch previously fetched frame row");
+
+		/* Set tuple context for evaluation of aggregate arguments */
+		winstate->tmpcontext->ecxt_outertuple = temp_slot;
+
+		k = winstate->aggregatedupto - 1 - pos;
+		for (i = 0; i < winstate->numaggs; i++)
+		{
+			WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+			if (!peraggstate->slideRebuild)
+				continue;
+
+			reset_windowaggregate_transvalue(peraggstate);
+			advance_windowaggregate(winstate,
+									&winstate->perfunc[peraggstate->wfuncno],
+									peraggstate);
+			peraggstate->slideValues[k] = peraggstate->transValue;
+			peraggstate->slideNulls[k] = peraggstate->transValueIsNull;
+		}
+
+		ResetExprContext(winstate->tmpcontext);
+		ExecClearTuple(temp_slot);
+	}
+
+	/* combine each of them with the state of the rows after it */
+	for (i = 0; i < winstate->numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		if (!peraggstate->slideRebuild)
+			continue;
+
+		for (k = 1; k < nrows; k++)
+		{
+			combine_windowaggregate(winstate,
+									&winstate->perfunc[peraggstate->wfuncno],
+									peraggstate,
+									peraggstate->aggcontext,
+									&peraggstate->slideValues[k],
+									&peraggstate->slideNulls[k],
+									peraggstate->slideValues[k - 1],
+									peraggstate->slideNulls[k - 1]);
+			ResetExprContext(winstate->tmpcontext);
+		}
+
+		peraggstate->slideTop = nrows;
+		reset_windowaggregate_transvalue(peraggstate);
+		peraggstate->slideRebuild = false;
+	}
+}
+
+/*
+ * finalize_sliding_windowaggregate
+ * finalize_windowaggregate for a sliding aggregate with partial states
+ *
+ * The state of the frame is the partial state of the rows from the frame
+ * head, combined with transValue, which holds the rows after them.
+ */
+static void
+finalize_sliding_windowaggregate(WindowAggState *winstate,
+								 WindowStatePerFunc perfuncstate,
+								 WindowStatePerAgg peraggstate,
+								 Datum *result, bool *isnull)
+{
+	MemoryContext tmpcontext = winstate->tmpcontext->ecxt_per_tuple_memory;
+	Datum		transValue = peraggstate->transValue;
+	bool		transValueIsNull = peraggstate->transValueIsNull;
+	Datum		value;
+	bool		valueIsNull;
+
+	Assert(peraggstate->slideTop > 0);
+
+	value = peraggstate->slideValues[peraggstate->slideTop - 1];
+	valueIsNull = peraggstate->slideNulls[peraggstate->slideTop - 1];
+
+	/*
+	 * The combine function may modify its first argument, so combine a copy,
+	 * the partial state is needed for the next rows.
+	 */
+	if (peraggstate->transValueCount > 0)
+	{
+		if (!valueIsNull)
+		{
+			MemoryContext oldContext = MemoryContextSwitchTo(tmpcontext);
+
+			value = datumCopy(value,
+							  peraggstate->transtypeByVal,
+							  peraggstate->transtypeLen);
+			MemoryContextSwitchTo(oldContext);
+		}
+		combine_windowaggregate(winstate, perfuncstate, peraggstate,
+								tmpcontext, &value, &valueIsNull,
+								transValue, transValueIsNull);
+	}
+
+	peraggstate->transValue = value;
+	peraggstate->transValueIsNull = valueIsNull;
+	finalize_windowaggregate(winstate, perfuncstate, peraggstate,
+							 result, isnull);
+	peraggstate->transValue = transValue;
+	peraggstate->transValueIsNull = transValueIsNull;
+
+	ResetExprContext(winstate->tmpcontext);
+}
+
 /*
  * eval_windowaggregates
  * evaluate plain aggregates being used as window functions
@@ -812,6 +1107,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	int			wfuncno,
 				numaggs,
 				numaggs_restart,
+				numaggs_sliding,
 				i;
 	int64		aggregatedupto_nonrestarted;
 	MemoryContext oldContext;
@@ -860,6 +1156,18 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * must perform the aggregation all over again for all tuples within the
 	 * new frame boundaries.
 	 *
+	 * That makes the aggregates without an inverse transition function, like
+	 * min() and max(), cost O(frame length) for each row.  If such an
+	 * aggregate has a combine function, and the frame is wide enough, it is
+	 * evaluated as a "sliding" aggregate instead: the rows that enter the
+	 * frame are accumulated into the transition value as usual, and when the
+	 * frame head moves past the first of them, all the rows of the frame are
+	 * turned into a stack of partial states, the state of each row combined
+	 * with the state of the rows after it.  The rows that leave the frame are
+	 * popped off the stack, and the value of the frame is the top of the
+	 * stack combined with the transition value.  Each row is thus aggregated
+	 * twice and combined once or twice, whatever the length of the frame.
+	 *
 	 * In many common cases, multiple rows share the same frame and hence the
 	 * same aggregate value. (In particular, if there's no ORDER BY in a RANGE
 	 * window, then all rows are peers and so they all have window frame equal
@@ -966,7 +1274,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * We restart the aggregation:
 	 *	 - if we're processing the first row in the partition, or
 	 *	 - if the frame's head moved and we cannot use an inverse
-	 *	   transition function, or
+	 *	   transition function or partial states, or
 	 *	 - if the new frame doesn't overlap the old one
 	 *
 	 * Note that we don't strictly need to restart in the last case, but if
@@ -975,12 +1283,15 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *----------
 	 */
 	numaggs_restart = 0;
+	numaggs_sliding = 0;
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
+		peraggstate->slideRebuild = false;
 		if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
-			 !OidIsValid(peraggstate->invtransfn_oid)) ||
+			 !OidIsValid(peraggstate->invtransfn_oid) &&
+			 !peraggstate->sliding) ||
 			winstate->aggregatedupto <= winstate->frameheadpos ||
 			frame_head_moved_backwards ||
 			frame_tail_moved_backwards)
@@ -989,7 +1300,67 @@ eval_windowaggregates(WindowAggState *winstate)
 			numaggs_restart++;
 		}
 		else
+		{
 			peraggstate->restart = false;
+			if (peraggstate->sliding)
+				numaggs_sliding++;
+		}
+	}
+
+	/*
+	 * Pop the rows that fell off the top of the frame from the partial states
+	 * of the sliding aggregates.  If the frame head moved past all of them,
+	 * the rows left in the frame, which the transition value holds, are made
+	 * the partial states, unless there would be too many of them to keep in
+	 * work_mem.  The aggregate is restarted then.
+	 */
+	if (numaggs_sliding > 0 &&
+		winstate->aggregatedbase < winstate->frameheadpos)
+	{
+		int64		nremove = winstate->frameheadpos - winstate->aggregatedbase;
+		int64		nrows = winstate->aggregatedupto - winstate->frameheadpos;
+		bool		rebuild = false;
+
+		for (i = 0; i < numaggs; i++)
+		{
+			peraggstate = &winstate->peragg[i];
+			if (!peraggstate->sliding || peraggstate->restart)
+				continue;
+
+			if (!peraggstate->transtypeByVal)
+			{
+				int64		k;
+
+				for (k = Max(peraggstate->slideTop - nremove, 0);
+					 k < peraggstate->slideTop; k++)
+				{
+					if (!peraggstate->slideNulls[k])
+						pfree(DatumGetPointer(peraggstate->slideValues[k]));
+				}
+			}
+
+			if (nremove <= peraggstate->slideTop)
+			{
+				peraggstate->slideTop -= nremove;
+				continue;
+			}
+			peraggstate->slideTop = 0;
+
+			if (nrows > sliding_max_states(peraggstate))
+			{
+				peraggstate->restart = true;
+				numaggs_restart++;
+				numaggs_sliding--;
+			}
+			else
+			{
+				peraggstate->slideRebuild = true;
+				rebuild = true;
+			}
+		}
+
+		if (rebuild)
+			rebuild_sliding_windowaggregates(winstate);
 	}
 
 	/*
@@ -999,7 +1370,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * i.e. advance_windowaggregate_base() can return false, in which case
 	 * we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart + numaggs_sliding < numaggs &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -1022,7 +1393,7 @@ eval_windowaggregates(WindowAggState *winstate)
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart || peraggstate->sliding)
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -1183,10 +1554,16 @@ eval_windowaggregates(WindowAggState *winstate)
 		wfuncno = peraggstate->wfuncno;
 		result = &econtext->ecxt_aggvalues[wfuncno];
 		isnull = &econtext->ecxt_aggnulls[wfuncno];
-		finalize_windowaggregate(winstate,
-								 &winstate->perfunc[wfuncno],
-								 peraggstate,
-								 result, isnull);
+		if (peraggstate->slideTop > 0)
+			finalize_sliding_windowaggregate(winstate,
+											 &winstate->perfunc[wfuncno],
+											 peraggstate,
+											 result, isnull);
+		else
+			finalize_windowaggregate(winstate,
+									 &winstate->perfunc[wfuncno],
+									 peraggstate,
+									 result, isnull);
 
 		/*
 		 * save the result in case next row shares the same frame.
@@ -2657,7 +3034,8 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	bool		finalextra;
 	Expr	   *transfnexpr,
 			   *invtransfnexpr,
-			   *finalfnexpr;
+			   *finalfnexpr,
+			   *combinefnexpr;
 	Datum		textInitVal;
 	int			i;
 	ListCell   *lc;
@@ -2707,6 +3085,30 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
 
+	/*
+	 * Without an inverse transition function, the aggregate is evaluated
+	 * again whenever the frame head moves, unless it can be a sliding
+	 * aggregate.  That requires a combine function, and a transition state
+	 * that can be copied, to combine the partial states without changing
+	 * them.  The arguments mustn't contain volatile functions, for they are
+	 * evaluated twice for each row.
+	 */
+	if (!OidIsValid(invtransfn_oid) &&
+		OidIsValid(aggform->aggcombinefn) &&
+		aggtranstype != INTERNALOID &&
+		!wfunc->windistinct &&
+		!contain_volatile_functions((Node *) wfunc) &&
+		frame_allows_sliding((WindowAgg *) winstate->ss.ps.plan))
+	{
+		peraggstate->sliding = true;
+		peraggstate->combinefn_oid = aggform->aggcombinefn;
+	}
+	else
+	{
+		peraggstate->sliding = false;
+		peraggstate->combinefn_oid = InvalidOid;
+	}
+
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
 	 * ... but we still need to check the component functions
@@ -2751,6 +3153,16 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							   get_func_name(finalfn_oid));
 			InvokeFunctionExecuteHook(finalfn_oid);
 		}
+
+		if (OidIsValid(peraggstate->combinefn_oid))
+		{
+			aclresult = pg_proc_aclcheck(peraggstate->combinefn_oid, aggOwner,
+										 ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				aclcheck_error(aclresult, ACL_KIND_PROC,
+							   get_func_name(peraggstate->combinefn_oid));
+			InvokeFunctionExecuteHook(peraggstate->combinefn_oid);
+		}
 	}
 
 	/* Detect how many arguments to pass to the finalfn */
@@ -2777,11 +3189,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							transfn_oid,
 							invtransfn_oid,
 							finalfn_oid,
-							InvalidOid,             /* prelim */
+							peraggstate->combinefn_oid,
 							&transfnexpr,
 							&invtransfnexpr,
 							&finalfnexpr,
-							NULL);
+							&combinefnexpr);
 
 	/* set up infrastructure for calling the transfn(s) and finalfn */
 	fmgr_info(transfn_oid, &peraggstate->transfn);
@@ -2799,6 +3211,12 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		fmgr_info_set_expr((Node *) finalfnexpr, &peraggstate->finalfn);
 	}
 
+	if (OidIsValid(peraggstate->combinefn_oid))
+	{
+		fmgr_info(peraggstate->combinefn_oid, &peraggstate->combinefn);
+		fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+	}
+
 	/* get info about relevant datatypes */
 	get_typlenbyval(wfunc->wintype,
 					&peraggstate->resulttypeLen,
@@ -2897,8 +3315,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	 * make the memory allocation rules for moving aggregates different than
 	 * they have historically been for plain aggregates, but that seems grotty
 	 * and likely to lead to memory leaks.
+	 *
+	 * Sliding aggregates keep their partial states in their own aggcontext
+	 * for the same reason.
 	 */
-	if (OidIsValid(invtransfn_oid))
+	if (OidIsValid(invtransfn_oid) || peraggstate->sliding)
 		peraggstate->aggcontext =
 			AllocSetContextCreate(CurrentMemoryContext,
 								  "WindowAgg_AggregatePrivate",
@@ -2929,6 +3350,86 @@ GetAggInitVal(Datum textInitVal, Oid transtype)
 	return initVal;
 }
 
+/*
+ * frame_allows_sliding
+ * Is it worth to evaluate the aggregates without an inverse transition
+ * function of a window as sliding aggregates?
+ *
+ * The frame head must move, but never backwards, and the frame must be
+ * wide enough for evaluating the aggregates again for each row to cost more
+ * than keeping partial states.  The width of RANGE frames is unknown, they
+ * are assumed to be wide.
+ */
+static bool
+frame_allows_sliding(WindowAgg *node)
+{
+	int			frameOptions = node->frameOptions;
+	int64		start;
+	int64		end;
+
+	if (!(frameOptions & (FRAMEOPTION_START_VALUE | FRAMEOPTION_START_CURRENT_ROW)))
+		return false;
+
+	if (contain_var_clause(node->startOffset) ||
+		contain_volatile_functions(node->startOffset) ||
+		contain_var_clause(node->endOffset) ||
+		contain_volatile_functions(node->endOffset))
+		return false;
+
+	if (!(frameOptions & FRAMEOPTION_ROWS) ||
+		(frameOptions & FRAMEOPTION_END_UNBOUNDED_FOLLOWING))
+		return true;
+
+	/* the offsets of a ROWS frame are int8 */
+	if (frameOptions & FRAMEOPTION_START_VALUE)
+	{
+		Const	   *offset = (Const *) node->startOffset;
+
+		if (!IsA(offset, Const) || offset->consttype != INT8OID ||
+			offset->constisnull)
+			return true;
+		start = DatumGetInt64(offset->constvalue);
+		if (frameOptions & FRAMEOPTION_START_VALUE_PRECEDING)
+			start = -start;
+	}
+	else
+		start = 0;
+
+	if (frameOptions & FRAMEOPTION_END_VALUE)
+	{
+		Const	   *offset = (Const *) node->endOffset;
+
+		if (!IsA(offset, Const) || offset->consttype != INT8OID ||
+			offset->constisnull)
+			return true;
+		end = DatumGetInt64(offset->constvalue);
+		if (frameOptions & FRAMEOPTION_END_VALUE_PRECEDING)
+			end = -end;
+	}
+	else
+		end = 0;
+
+	return end - start + 1 >= SLIDING_AGG_MIN_FRAME_ROWS;
+}
+
+/*
+ * sliding_max_states
+ * The number of partial states of a sliding aggregate that fit in work_mem.
+ */
+static int64
+sliding_max_states(WindowStatePerAgg peraggstate)
+{
+	Size		width = sizeof(Datum) + sizeof(bool);
+
+	/* guess the size of a pass-by-ref state, and of its chunk header */
+	if (!peraggstate->transtypeByVal)
+		width += MAXALIGN(peraggstate->transtypeLen > 0 ?
+						  peraggstate->transtypeLen : 32) + 16;
+
+	return Min((int64) work_mem * 1024L / width,
+			   (int64) (MaxAllocSize / sizeof(Datum)));
+}
+
 /*
  * are_peers
  * compare two rows to see if they are equal according to the ORDER BY clause
@@ -30,6 +30,7 @@
 
 #include "gpopt/gpdbwrappers.h"
 #include "catalog/pg_collation.h"
+#include "catalog/pg_statistic.h"
 
 #include "utils/ext_alloc.h"
 
@@ -823,6 +824,78 @@ gpdb::GetAttStats
 	return NULL;
 }
 
+void
+gpdb::GetRelAttrWidthsAndDefaults
+	(
+	Relation rel,
+	int32 *widths,
+	Node **defaults
+	)
+{
+	GP_WRAP_START;
+	{
+		TupleDesc tupdesc = RelationGetDescr(rel);
+
+		for (int i = 0; i < tupdesc->natts; i++)
+		{
+			Form_pg_attribute att = tupdesc->attrs[i];
+
+			/* catalog tables: pg_statistic */
+			HeapTuple stats_tup = get_att_stats(RelationGetRelid(rel), att->attnum);
+			widths[i] = -1;
+			if (HeapTupleIsValid(stats_tup))
+			{
+				widths[i] = ((Form_pg_statistic) GETSTRUCT(stats_tup))->stawidth;
+				heap_freetuple(stats_tup);
+			}
+
+			defaults[i] = NULL;
+			if (att->attisdropped)
+			{
+				continue;
+			}
+
+			if (NULL != tupdesc->constr)
+			{
+				for (int j = 0; j < tupdesc->constr->num_defval; j++)
+				{
+					if (att->attnum == tupdesc->constr->defval[j].adnum)
+					{
+						defaults[i] = (Node *) stringToNode(tupdesc->constr->defval[j].adbin);
+						break;
+					}
+				}
+			}
+
+			if (NULL == defaults[i])
+			{
+				/* catalog tables: pg_type */
+				defaults[i] = get_typdefault(att->atttypid);
+			}
+		}
+		return;
+	}
+	GP_WRAP_END;
+}
+
+double
+gpdb::MergeLeafNDistinct
+	(
+	Oid relid,
+	AttrNumber attnum,
+	float4 *null_frac,
+	int32 *width
+	)
+{
+	GP_WRAP_START;
+	{
+		/* catalog tables: pg_partition, pg_class, pg_statistic */
+		return merge_leaf_ndistinct(relid, attnum, null_frac, width);
+	}
+	GP_WRAP_END;
+	return -1;
+}
+
 Oid
 gpdb::GetCommutatorOp
 	(
@@ -1013,7 +1086,7 @@ gpdb::GetRelationPartContraints
 	GP_WRAP_START;
 	{
 		/* catalog tables: pg_partition, pg_partition_rule, pg_constraint */
-		return get_relation_part_constraints(rel_oid, default_levels);
+		return orca_get_relation_part_constraints(rel_oid, default_levels);
 	}
 	GP_WRAP_END;
 	return NULL;
@@ -1396,6 +1469,17 @@ gpdb::GetGPSegmentCount(void)
 	return 0;
 }
 
+uint64
+gpdb::GetConfigGeneration(void)
+{
+	GP_WRAP_START;
+	{
+		return ::GetConfigGeneration();
+	}
+	GP_WRAP_END;
+	return 0;
+}
+
 bool
 gpdb::HeapAttIsNull
 	(
@@ -1734,6 +1818,21 @@ gpdb::ListMemberOid
 	return false;
 }
 
+bool
+gpdb::ListMemberInt
+	(
+	List *list,
+	int datum
+	)
+{
+	GP_WRAP_START;
+	{
+		return list_member_int(list, datum);
+	}
+	GP_WRAP_END;
+	return false;
+}
+
 void
 gpdb::ListFree
 	(
@@ -2228,6 +2327,36 @@ gpdb::WalkQueryOrExpressionTree
 	return false;
 }
 
+bool
+gpdb::ContainsVolatileFunctions
+	(
+	Node *node
+	)
+{
+	GP_WRAP_START;
+	{
+		/* catalog tables: pg_proc */
+		return contain_volatile_functions(node);
+	}
+	GP_WRAP_END;
+	return false;
+}
+
+bool
+gpdb::ContainsVarsOfLevelOrAbove
+	(
+	Node *node,
+	int levelsup
+	)
+{
+	GP_WRAP_START;
+	{
+		return contain_vars_of_level_or_above(node, levelsup);
+	}
+	GP_WRAP_END;
+	return false;
+}
+
 Node *
 gpdb::MutateQueryOrExpressionTree
 	(
@@ -2426,7 +2555,7 @@ gpdb::CdbEstimatePartitionedNumTuples
 {
 	GP_WRAP_START;
 	{
-		return cdb_estimate_partitioned_numtuples(rel, stats_missing_p);
+		return orca_estimate_partitioned_numtuples(rel, stats_missing_p);
 	}
 	GP_WRAP_END;
 }
@@ -2460,6 +2589,107 @@ gpdb::GetRelationIndexes
 	return NIL;
 }
 
+/*
+ * Logical indexes of the partitioned tables, by root relation, and their
+ * indexes by oid. Building them walks all the parts of a table, and they are
+ * needed for the table and each of its indexes, so they are kept until the
+ * next catalog change seen by MDCacheNeedsReset().
+ */
+typedef struct LogicalIndexesCacheEntry
+{
+	Oid			relid;
+	LogicalIndexes *logical_indexes;	/* NULL if the table has none */
+} LogicalIndexesCacheEntry;
+
+typedef struct LogicalIndexInfoCacheEntry
+{
+	Oid			index_oid;
+	LogicalIndexInfo *index_info;
+} LogicalIndexInfoCacheEntry;
+
+static MemoryContext logical_indexes_cache_context = NULL;
+static HTAB *logical_indexes_cache = NULL;
+static HTAB *logical_index_info_cache = NULL;
+
+static void
+reset_logical_indexes_cache(void)
+{
+	if (NULL != logical_indexes_cache_context)
+	{
+		MemoryContextDelete(logical_indexes_cache_context);
+		logical_indexes_cache_context = NULL;
+		logical_indexes_cache = NULL;
+		logical_index_info_cache = NULL;
+	}
+}
+
+static HTAB *
+create_logical_indexes_hash(const char *name, Size entrysize)
+{
+	HASHCTL		ctl;
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = entrysize;
+	ctl.hash = oid_hash;
+	ctl.hcxt = logical_indexes_cache_context;
+
+	return hash_create(name, 64, &ctl, HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+}
+
+static LogicalIndexes *
+lookup_logical_indexes(Oid relid)
+{
+	LogicalIndexesCacheEntry *entry;
+	bool		found;
+
+	if (NULL == logical_indexes_cache_context)
+	{
+		logical_indexes_cache_context = AllocSetContextCreate(CacheMemoryContext,
+															  "ORCA logical indexes cache",
+															  ALLOCSET_DEFAULT_MINSIZE,
+															  ALLOCSET_DEFAULT_INITSIZE,
+															  ALLOCSET_DEFAULT_MAXSIZE);
+		logical_indexes_cache =
+			create_logical_indexes_hash("ORCA logical indexes",
+										sizeof(LogicalIndexesCacheEntry));
+		logical_index_info_cache =
+			create_logical_indexes_hash("ORCA logical index info",
+										sizeof(LogicalIndexInfoCacheEntry));
+	}
+
+	entry = (LogicalIndexesCacheEntry *)
+		hash_search(logical_indexes_cache, &relid, HASH_FIND, NULL);
+	if (NULL != entry)
+		return entry->logical_indexes;
+
+	MemoryContext oldcxt = MemoryContextSwitchTo(logical_indexes_cache_context);
+	LogicalIndexes *logical_indexes = BuildLogicalIndexInfo(relid);
+	MemoryContextSwitchTo(oldcxt);
+
+	entry = (LogicalIndexesCacheEntry *)
+		hash_search(logical_indexes_cache, &relid, HASH_ENTER, &found);
+	entry->logical_indexes = logical_indexes;
+
+	for (int i = 0; NULL != logical_indexes && i < logical_indexes->numLogicalIndexes; i++)
+	{
+		LogicalIndexInfo *index_info = logical_indexes->logicalIndexInfo[i];
+		LogicalIndexInfoCacheEntry *info_entry;
+
+		/*
+		 * An index on a default part may have the same oid as another
+		 * logical index, the first one is found, as by a scan of the array.
+		 */
+		info_entry = (LogicalIndexInfoCacheEntry *)
+			hash_search(logical_index_info_cache, &index_info->logicalIndexOid,
+						HASH_ENTER, &found);
+		if (!found)
+			info_entry->index_info = index_info;
+	}
+
+	return logical_indexes;
+}
+
 LogicalIndexes *
 gpdb::GetLogicalPartIndexes
 	(
@@ -2469,7 +2699,29 @@ gpdb::GetLogicalPartIndexes
 	GP_WRAP_START;
 	{
 		/* catalog tables: pg_partition, pg_partition_rule, pg_index */
-		return BuildLogicalIndexInfo(oid);
+		return lookup_logical_indexes(oid);
+	}
+	GP_WRAP_END;
+	return NULL;
+}
+
+LogicalIndexInfo *
+gpdb::GetLogicalPartIndexInfo
+	(
+	Oid root_oid,
+	Oid index_oid
+	)
+{
+	GP_WRAP_START;
+	{
+		/* catalog tables: pg_partition, pg_partition_rule, pg_index */
+		if (NULL == lookup_logical_indexes(root_oid))
+			return NULL;
+
+		LogicalIndexInfoCacheEntry *entry = (LogicalIndexInfoCacheEntry *)
+			hash_search(logical_index_info_cache, &index_oid, HASH_FIND, NULL);
+
+		return (NULL != entry) ? entry->index_info : NULL;
 	}
 	GP_WRAP_END;
 	return NULL;
@@ -3020,7 +3272,7 @@ gpdb::CountLeafPartTables
 	GP_WRAP_START;
 	{
 		/* catalog tables: pg_partition, pg_partition_rules */
-		return countLeafPartTables(rel_oid);
+		return orca_count_leaf_part_tables(rel_oid);
 	}
 	GP_WRAP_END;
 
@@ -3028,16 +3280,20 @@ gpdb::CountLeafPartTables
 }
 
 /*
- * To detect changes to catalog tables that require resetting the Metadata
- * Cache, we use the normal PostgreSQL catalog cache invalidation mechanism.
- * We register a callback to a cache on all the catalog tables that contain
- * information that's contained in the ORCA metadata cache.
-
- * There is no fine-grained mechanism in the metadata cache for invalidating
- * individual entries ATM, so we just blow the whole cache whenever anything
- * changes. The callback simply increments a counter. Whenever we start
- * planning a query, we check the counter to see if it has changed since the
- * last planned query, and reset the whole cache if it has.
+ * To detect changes to catalog tables that require evicting entries of the
+ * Metadata Cache, we use the normal PostgreSQL catalog cache invalidation
+ * mechanism. We register a callback to a cache on all the catalog tables that
+ * contain information that's contained in the ORCA metadata cache.
+ *
+ * The callbacks remember the invalidation events. Whenever we start planning
+ * a query, the pending events are matched against the objects fetched into
+ * the metadata cache, which are tracked in terms of the catalogs they come
+ * from, and only the matching objects are evicted. A relcache invalidation
+ * evicts the relation or index, and the statistics of the relation. Syscache
+ * invalidations are matched by recomputing the hash values of the catalog
+ * keys of the tracked objects. Changes to the other catalogs are rare, and
+ * objects depend on them in ways that are hard to track, so they still blow
+ * the whole cache, and so do too many pending events.
  *
  * To make sure we've covered all catalog tables that contain information
  * that's stored in the metadata cache, there are "catalog tables: xxx"
@@ -3046,20 +3302,56 @@ gpdb::CountLeafPartTables
  * anything fetched via the wrapper functions in this file can end up in the
  * metadata cache and hence need to have an invalidation callback registered.
  */
-static bool mdcache_invalidation_counter_registered = false;
-static int64 mdcache_invalidation_counter = 0;
-static int64 last_mdcache_invalidation_counter = 0;
+#define MDCACHE_MAX_PENDING_INVALIDATIONS 1024
+
+typedef struct MDCachePendingInvalidation
+{
+	int			cacheid;		/* -1 for a relcache invalidation */
+	uint32		hashvalue;
+	Oid			relid;
+} MDCachePendingInvalidation;
+
+static bool mdcache_invalidation_registered = false;
+static HTAB *mdcache_tracked_objects = NULL;
+static MDCachePendingInvalidation mdcache_pending_invalidations[MDCACHE_MAX_PENDING_INVALIDATIONS];
+static int mdcache_num_pending_invalidations = 0;
+static bool mdcache_reset_pending = false;
+
+static void
+mdcache_add_pending_invalidation(int cacheid, uint32 hashvalue, Oid relid)
+{
+	MDCachePendingInvalidation *inval;
+
+	if (mdcache_num_pending_invalidations >= MDCACHE_MAX_PENDING_INVALIDATIONS)
+	{
+		mdcache_reset_pending = true;
+		return;
+	}
+
+	inval = &mdcache_pending_invalidations[mdcache_num_pending_invalidations++];
+	inval->cacheid = cacheid;
+	inval->hashvalue = hashvalue;
+	inval->relid = relid;
+}
 
 static void
-mdsyscache_invalidation_counter_callback(Datum arg, int cacheid, uint32 hashvalue)
+mdsyscache_invalidation_callback(Datum arg, int cacheid, uint32 hashvalue)
 {
-	mdcache_invalidation_counter++;
+	/* a zero hash value means all entries of the cache */
+	if (0 == hashvalue)
+		mdcache_reset_pending = true;
+	else
+		mdcache_add_pending_invalidation(cacheid, hashvalue, InvalidOid);
 }
 
 static void
-mdrelcache_invalidation_counter_callback(Datum arg, Oid relid)
+mdrelcache_invalidation_callback(Datum arg, Oid relid)
 {
-	mdcache_invalidation_counter++;
+	/* InvalidOid means all relations */
+	if (!OidIsValid(relid))
+		mdcache_reset_pending = true;
+	else
+		mdcache_add_pending_invalidation(-1, 0, relid);
 }
 
 static void
@@ -3121,49 +3413,483 @@ register_mdcache_invalidation_callbacks(void)
 	for (i = 0; i < lengthof(metadata_caches); i++)
 	{
 		CacheRegisterSyscacheCallback(metadata_caches[i],
-									  &mdsyscache_invalidation_counter_callback,
+									  &mdsyscache_invalidation_callback,
 									  (Datum) 0);
 	}
 
 	/* also register the relcache callback */
-	CacheRegisterRelcacheCallback(&mdrelcache_invalidation_counter_callback,
+	CacheRegisterRelcacheCallback(&mdrelcache_invalidation_callback,
 								  (Datum) 0);
 }
 
-// Has there been any catalog changes since last call?
+static HTAB *
+create_mdcache_tracked_objects(void)
+{
+	HASHCTL		ctl;
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(gpdb::MDCacheObject);
+	ctl.entrysize = sizeof(gpdb::MDCacheObject);
+	ctl.hash = tag_hash;
+	ctl.hcxt = CacheMemoryContext;
+
+	return hash_create("ORCA metadata cache objects", 1024, &ctl,
+					   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+}
+
+/*
+ * Can invalidations of the syscache be matched to the objects? They are the
+ * ones that come with DDL of tables, such as the row type of a new temporary
+ * table, and with ANALYZE.
+ */
+static bool
+mdcache_is_tracked_syscache(int cacheid)
+{
+	switch (cacheid)
+	{
+		case CASTSOURCETARGET:
+		case CONSTROID:
+		case STATRELATTINH:
+		case TYPEOID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static int
+mdcache_pending_invalidation_cmp(const void *a, const void *b)
+{
+	const MDCachePendingInvalidation *inval_a = (const MDCachePendingInvalidation *) a;
+	const MDCachePendingInvalidation *inval_b = (const MDCachePendingInvalidation *) b;
+
+	if (inval_a->cacheid != inval_b->cacheid)
+		return (inval_a->cacheid < inval_b->cacheid) ? -1 : 1;
+
+	return 0;
+}
+
+/* hash value of the catalog key of the object in the syscache */
+static uint32
+mdcache_object_hash_value(const gpdb::MDCacheObject *object, int cacheid)
+{
+	switch (cacheid)
+	{
+		case CASTSOURCETARGET:
+			return GetSysCacheHashValue2(CASTSOURCETARGET,
+										 ObjectIdGetDatum(object->oids[0]),
+										 ObjectIdGetDatum(object->oids[1]));
+		case STATRELATTINH:
+			return GetSysCacheHashValue3(STATRELATTINH,
+										 ObjectIdGetDatum(object->oids[0]),
+										 Int16GetDatum(object->attno),
+										 BoolGetDatum(false));
+		default:
+			return GetSysCacheHashValue1(cacheid,
+										 ObjectIdGetDatum(object->oids[0]));
+	}
+}
+
+/* Is the object changed by any of the invalidations, sorted by cache id? */
+static bool
+mdcache_object_is_invalid(const gpdb::MDCacheObject *object,
+						  const MDCachePendingInvalidation *invals, int num_invals)
+{
+	int			hash_cacheid = -1;
+	uint32		hashvalue = 0;
+	int			i;
+
+	for (i = 0; i < num_invals; i++)
+	{
+		const MDCachePendingInvalidation *inval = &invals[i];
+		int			cacheid = inval->cacheid;
+
+		if (cacheid < 0)
+		{
+			/* a relation or index, and the statistics of the relation */
+			if ((object->kind == gpdb::MDCacheObjectGPDB ||
+				 object->kind == gpdb::MDCacheObjectRelStats ||
+				 object->kind == gpdb::MDCacheObjectColStats) &&
+				object->oids[0] == inval->relid)
+				return true;
+			continue;
+		}
+
+		/* scalar comparisons are looked up through casts as well */
+		if (cacheid == CASTSOURCETARGET && object->kind == gpdb::MDCacheObjectScCmp)
+			return true;
+
+		if (!((cacheid == CASTSOURCETARGET && object->kind == gpdb::MDCacheObjectCast) ||
+			  (cacheid == STATRELATTINH && object->kind == gpdb::MDCacheObjectColStats) ||
+			  ((cacheid == CONSTROID || cacheid == TYPEOID) &&
+			   object->kind == gpdb::MDCacheObjectGPDB)))
+			continue;
+
+		if (cacheid != hash_cacheid)
+		{
+			hashvalue = mdcache_object_hash_value(object, cacheid);
+			hash_cacheid = cacheid;
+		}
+
+		if (hashvalue == inval->hashvalue)
+			return true;
+	}
+
+	return false;
+}
+
+// Remember an object fetched into the metadata cache, to evict it when the
+// catalogs it comes from change.
+void
+gpdb::MDCacheTrackObject
+	(
+	const MDCacheObject *object
+	)
+{
+	GP_WRAP_START;
+	{
+		if (NULL == mdcache_tracked_objects)
+		{
+			mdcache_tracked_objects = create_mdcache_tracked_objects();
+		}
+		hash_search(mdcache_tracked_objects, object, HASH_ENTER, NULL);
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Has there been any catalog changes since last call, that require the whole
+// metadata cache to be reset? If not, the objects to be evicted from it are
+// returned in a palloc'd array.
 bool
 gpdb::MDCacheNeedsReset
-		(
-			void
-		)
+	(
+	MDCacheObject **invalid_objects,
+	int *num_invalid_objects
+	)
 {
 	GP_WRAP_START;
 	{
-		if (!mdcache_invalidation_counter_registered)
+		/*
+		 * The statistics of tables whose row counts seen by EXPLAIN ANALYZE
+		 * have grown are evicted as if the tables had changed.
+		 */
+		int			num_feedback_rels;
+		Oid		   *feedback_rels = OrcaFeedbackGetChangedRels(&num_feedback_rels);
+
+		for (int j = 0; j < num_feedback_rels; j++)
+			mdcache_add_pending_invalidation(-1, 0, feedback_rels[j]);
+		if (NULL != feedback_rels)
+			pfree(feedback_rels);
+
+		MDCachePendingInvalidation *invals;
+		int			num_invals = mdcache_num_pending_invalidations;
+		bool		reset = mdcache_reset_pending;
+		int			i;
+
+		*invalid_objects = NULL;
+		*num_invalid_objects = 0;
+
+		if (!mdcache_invalidation_registered)
 		{
 			register_mdcache_invalidation_callbacks();
-			mdcache_invalidation_counter_registered = true;
+			mdcache_invalidation_registered = true;
+			reset = true;
+		}
+
+		/*
+		 * Any catalog change may change the logical indexes of a table, an
+		 * index created on a part only invalidates the part.
+		 */
+		if (reset || 0 < num_invals)
+			reset_logical_indexes_cache();
+
+		for (i = 0; i < num_invals && !reset; i++)
+		{
+			int			cacheid = mdcache_pending_invalidations[i].cacheid;
+
+			if (cacheid >= 0 && !mdcache_is_tracked_syscache(cacheid))
+				reset = true;
 		}
-		if (last_mdcache_invalidation_counter == mdcache_invalidation_counter)
+
+		if (reset || NULL == mdcache_tracked_objects)
+		{
+			if (NULL != mdcache_tracked_objects)
+			{
+				hash_destroy(mdcache_tracked_objects);
+				mdcache_tracked_objects = NULL;
+			}
+			mdcache_num_pending_invalidations = 0;
+			mdcache_reset_pending = false;
+
+			return reset;
+		}
+
+		if (0 == num_invals)
 			return false;
-		else
+
+		/*
+		 * Computing the hash values may open catalogs, and more invalidations
+		 * may arrive meanwhile. Only the ones seen so far are consumed.
+		 */
+		invals = (MDCachePendingInvalidation *)
+			palloc(num_invals * sizeof(MDCachePendingInvalidation));
+		memcpy(invals, mdcache_pending_invalidations,
+			   num_invals * sizeof(MDCachePendingInvalidation));
+		mdcache_num_pending_invalidations = 0;
+		qsort(invals, num_invals, sizeof(MDCachePendingInvalidation),
+			  mdcache_pending_invalidation_cmp);
+
+		HASH_SEQ_STATUS status;
+		MDCacheObject *object;
+		long		max_objects = hash_get_num_entries(mdcache_tracked_objects);
+
+		*invalid_objects = (MDCacheObject *)
+			palloc(Max(max_objects, 1) * sizeof(MDCacheObject));
+
+		hash_seq_init(&status, mdcache_tracked_objects);
+		while ((object = (MDCacheObject *) hash_seq_search(&status)) != NULL)
 		{
-			last_mdcache_invalidation_counter = mdcache_invalidation_counter;
-			return true;
+			if (mdcache_object_is_invalid(object, invals, num_invals))
+			{
+				(*invalid_objects)[(*num_invalid_objects)++] = *object;
+				hash_search(mdcache_tracked_objects, object, HASH_REMOVE, NULL);
+			}
 		}
+
+		pfree(invals);
+
+		return false;
 	}
 	GP_WRAP_END;
 
 	return true;
 }
 
+// Catalog version of the metadata cache shared by the backends
+uint64
+gpdb::SharedMDCacheGetVersion
+	(
+	void
+	)
+{
+	GP_WRAP_START;
+	{
+		return ::SharedMDCacheGetVersion();
+	}
+	GP_WRAP_END;
+
+	return 0;
+}
+
+// Copy the DXL of a metadata object out of the shared metadata cache
+char *
+gpdb::SharedMDCacheLookup
+	(
+	uint64 version,
+	const char *key,
+	Size *len
+	)
+{
+	GP_WRAP_START;
+	{
+		return ::SharedMDCacheLookup(version, key, len);
+	}
+	GP_WRAP_END;
+
+	return NULL;
+}
+
+// Store the DXL of a metadata object into the shared metadata cache
+void
+gpdb::SharedMDCacheStore
+	(
+	uint64 version,
+	const char *key,
+	const char *data,
+	Size len
+	)
+{
+	GP_WRAP_START;
+	{
+		::SharedMDCacheStore(version, key, data, len);
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Store the DXL of a built-in metadata object into the shared metadata cache
+void
+gpdb::SharedMDCacheStoreBuiltin
+	(
+	const char *key,
+	const char *data,
+	Size len
+	)
+{
+	GP_WRAP_START;
+	{
+		::SharedMDCacheStoreBuiltin(key, data, len);
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Plan of the normalized query from the template in the plan cache
+PlannedStmt *
+gpdb::OrcaPlanCacheLookup
+	(
+	const Query *query,
+	OrcaPlanCacheQuery **cache_query
+	)
+{
+	GP_WRAP_START;
+	{
+		return ::OrcaPlanCacheLookup(query, cache_query);
+	}
+	GP_WRAP_END;
+
+	return NULL;
+}
+
+// Store the custom plan optimized for the query in the plan cache
+void
+gpdb::OrcaPlanCacheStore
+	(
+	OrcaPlanCacheQuery *cache_query,
+	PlannedStmt *plan
+	)
+{
+	GP_WRAP_START;
+	{
+		::OrcaPlanCacheStore(cache_query, plan);
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Drop all the plans of the plan cache
+void
+gpdb::OrcaPlanCacheReset
+	(
+	void
+	)
+{
+	GP_WRAP_START;
+	{
+		::OrcaPlanCacheReset();
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Plan to run for the normalized query, the optimized one or its baseline
+PlannedStmt *
+gpdb::OrcaPlanBaselineChoose
+	(
+	OrcaPlanCacheQuery *cache_query,
+	PlannedStmt *plan
+	)
+{
+	GP_WRAP_START;
+	{
+		return ::OrcaPlanBaselineChoose(cache_query, plan);
+	}
+	GP_WRAP_END;
+
+	return plan;
+}
+
+// Most rows EXPLAIN ANALYZE has seen a scan of the relation return
+bool
+gpdb::GetCardinalityFeedback
+	(
+	Oid relid,
+	double *numtuples
+	)
+{
+	GP_WRAP_START;
+	{
+		return OrcaFeedbackLookup(relid, numtuples);
+	}
+	GP_WRAP_END;
+
+	return false;
+}
+
+// Cost model parameters calibrated by gpcalibratecost
+OrcaCostParam *
+gpdb::GetOrcaCostParams
+	(
+	int *num_params
+	)
+{
+	GP_WRAP_START;
+	{
+		return OrcaCostParamsGet(num_params);
+	}
+	GP_WRAP_END;
+
+	*num_params = 0;
+	return NULL;
+}
+
+// Filter damping factor implied by the functional dependencies between the
+// filtered columns of the query
+double
+gpdb::GetFilterDampingFactor
+	(
+	Query *query,
+	double damping
+	)
+{
+	GP_WRAP_START;
+	{
+		return orca_filter_damping_factor(query, damping);
+	}
+	GP_WRAP_END;
+
+	return damping;
+}
+
+void
+gpdb::CaptureOptimization
+	(
+	double optimization_time,
+	const char *minidump
+	)
+{
+	GP_WRAP_START;
+	{
+		orca_capture_optimization(optimization_time, minidump);
+		return;
+	}
+	GP_WRAP_END;
+}
+
 // Functions for ORCA's memory consumption to be tracked by GPDB
+//
+// Most allocations fit in the Vmem already reserved by this process, and
+// are made without the PG_TRY of GP_WRAP_START, as they cannot raise an
+// error. Only the ones that reserve or release Vmem go through the wrapper.
 void *
 gpdb::OptimizerAlloc
 		(
 			size_t size
 		)
 {
+	// GPOS raises an out of memory error when it gets no memory
+	if (Ext_OptimizerExceedsMemoryLimit(size))
+	{
+		return NULL;
+	}
+
+	void *ptr = Ext_OptimizerAllocReserved(size);
+	if (NULL != ptr)
+	{
+		return ptr;
+	}
+
 	GP_WRAP_START;
 	{
 		return Ext_OptimizerAlloc(size);
@@ -3179,6 +3905,11 @@ gpdb::OptimizerFree
 			void *ptr
 		)
 {
+	if (Ext_OptimizerFreeReserved(ptr))
+	{
+		return;
+	}
+
 	GP_WRAP_START;
 	{
 		Ext_OptimizerFree(ptr);
@@ -3186,6 +3917,31 @@ gpdb::OptimizerFree
 	GP_WRAP_END;
 }
 
+void
+gpdb::SetOptimizerMemoryLimit
+		(
+			uint64 bytes
+		)
+{
+	// No GP_WRAP_START/END needed here, it only sets counters
+	Ext_OptimizerSetMemoryLimit(bytes);
+}
+
+uint64
+gpdb::GetOptimizerAllocations
+		(
+			uint64 *bytes
+		)
+{
+	GP_WRAP_START;
+	{
+		return ::GetOptimizerAllocations(bytes);
+	}
+	GP_WRAP_END;
+
+	return 0;
+}
+
 // returns true if a query cancel is requested in GPDB
 bool
 gpdb::IsAbortRequested
@@ -3236,4 +3992,99 @@ gpdb::HashText(Datum d)
 	GP_WRAP_END;
 }
 
+// Bytes of the collation sort key, and of the source string, that go into
+// the statistics key of a text value
+#define GPDB_TEXT_STATS_KEY_PREFIX 6
+#define GPDB_TEXT_STATS_KEY_SOURCE 32
+
+// The first bytes of the sort key of the value in the collation, with the low
+// bits of its hash to tell apart the values sharing them. Keys sort like the
+// values as long as the values differ in those first bytes, and are equal for
+// equal values.
+int64
+gpdb::TextStatsKey(Datum d, bool is_bpchar, Oid collation)
+{
+	GP_WRAP_START;
+	{
+		text *t = DatumGetTextPP(d);
+		const char *data = VARDATA_ANY(t);
+		int len = VARSIZE_ANY_EXHDR(t);
+		uint32 hash;
+		uint64 key = 0;
+
+		if (is_bpchar)
+		{
+			// trailing spaces of bpchar are insignificant
+			while (len > 0 && data[len - 1] == ' ')
+				len--;
+			hash = DatumGetUInt32(DirectFunctionCall1(hashbpchar, d));
+		}
+		else
+		{
+			hash = DatumGetUInt32(DirectFunctionCall1(hashtext, d));
+		}
+
+		// the leading bytes of the sort key only depend on the leading
+		// characters, so only those are transformed
+		len = pg_mbcliplen(data, len, GPDB_TEXT_STATS_KEY_SOURCE);
+
+		char *str = (char *) palloc(len + 1);
+		memcpy(str, data, len);
+		str[len] = '\0';
+
+		if (!OidIsValid(collation))
+		{
+			collation = DEFAULT_COLLATION_OID;
+		}
+
+		char *sortkey = str;
+		size_t sortkey_len = len;
+		if (!lc_collate_is_c(collation))
+		{
+			pg_locale_t locale = 0;
+			if (collation != DEFAULT_COLLATION_OID)
+			{
+				locale = pg_newlocale_from_collation(collation);
+			}
+
+#ifdef HAVE_LOCALE_T
+			if (locale)
+			{
+				sortkey_len = strxfrm_l(NULL, str, 0, locale);
+				sortkey = (char *) palloc(sortkey_len + 1);
+				strxfrm_l(sortkey, str, sortkey_len + 1, locale);
+			}
+			else
+#endif
+			{
+				sortkey_len = strxfrm(NULL, str, 0);
+				sortkey = (char *) palloc(sortkey_len + 1);
+				strxfrm(sortkey, str, sortkey_len + 1);
+			}
+		}
+
+		for (int i = 0; i < GPDB_TEXT_STATS_KEY_PREFIX; i++)
+		{
+			key <<= 8;
+			if ((size_t) i < sortkey_len)
+			{
+				key |= (unsigned char) sortkey[i];
+			}
+		}
+		key = (key << 16) | (hash & 0xFFFF);
+
+		if (sortkey != str)
+		{
+			pfree(sortkey);
+		}
+		pfree(str);
+
+		// flip the sign bit, so that signed comparisons of keys are the
+		// unsigned comparisons of the bytes
+		return (int64) (key ^ (UINT64CONST(1) << 63));
+	}
+	GP_WRAP_END;
+	return 0;
+}
+
 // EOF
@@ -15,11 +15,27 @@
 //---------------------------------------------------------------------------
 
 #include "postgres.h"
+#include "access/transam.h"
+#include "miscadmin.h"
+#include "utils/sharedmdcache.h"
+
+#include "gpopt/gpdbwrappers.h"
 #include "gpopt/relcache/CMDProviderRelcache.h"
 #include "gpopt/translate/CTranslatorRelcacheToDXL.h"
 #include "gpopt/mdcache/CMDAccessor.h"
 
+#include "gpos/common/CWallClock.h"
+
 #include "naucrates/dxl/CDXLUtils.h"
+#include "naucrates/md/CMDIdCast.h"
+#include "naucrates/md/CMDIdColStats.h"
+#include "naucrates/md/CMDIdGPDB.h"
+#include "naucrates/md/CMDIdRelStats.h"
+#include "naucrates/md/CMDIdScCmp.h"
+#include "naucrates/md/IMDCast.h"
+#include "naucrates/md/IMDColumn.h"
+#include "naucrates/md/IMDRelation.h"
+#include "naucrates/md/IMDScCmp.h"
 
 #include "naucrates/exception.h"
 
@@ -37,20 +53,347 @@ using namespace gpmd;
 //---------------------------------------------------------------------------
 CMDProviderRelcache::CMDProviderRelcache
 	(
-	CMemoryPool *mp
+	CMemoryPool *mp,
+	BOOL use_shared_cache,
+	uint64 shared_cache_version
 	)
 	:
-	m_mp(mp)
+	m_mp(mp),
+	m_use_shared_cache(use_shared_cache),
+	m_shared_cache_version(shared_cache_version),
+	m_num_fetches(0),
+	m_fetch_time_us(0),
+	m_fetch_allocs(0),
+	m_fetch_alloc_bytes(0)
 {
 	GPOS_ASSERT(NULL != m_mp);
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::GetSharedCacheKey
+//
+//	@doc:
+//		Key of the object in the shared metadata cache, the oid of the
+//		database followed by the serialized mdid, as the oids of objects in
+//		different databases collide. Returns false if it is too long or not
+//		plain ASCII
+//
+//---------------------------------------------------------------------------
+BOOL
+CMDProviderRelcache::GetSharedCacheKey
+	(
+	IMDId *md_id,
+	CHAR *key,
+	ULONG size
+	)
+{
+	const WCHAR *buffer = md_id->GetBuffer();
+	INT prefix_len = snprintf(key, size, "%u.", MyDatabaseId);
+
+	if (0 > prefix_len || (ULONG) prefix_len >= size)
+	{
+		return false;
+	}
+
+	for (ULONG ul = prefix_len; ul < size; ul++)
+	{
+		WCHAR wc = buffer[ul - prefix_len];
+		if (0 > wc || 127 < wc)
+		{
+			return false;
+		}
+
+		key[ul] = (CHAR) wc;
+		if ('\0' == key[ul])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// is the mdid missing or that of an object created by initdb
+static BOOL
+IsBuiltinMdId
+	(
+	IMDId *md_id
+	)
+{
+	if (NULL == md_id || !md_id->IsValid())
+	{
+		return true;
+	}
+
+	return IMDId::EmdidGPDB == md_id->MdidType() &&
+			CMDIdGPDB::CastMdid(md_id)->Oid() < FirstNormalObjectId;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::IsBuiltinObject
+//
+//	@doc:
+//		Is the object a type, operator, function or aggregate created by
+//		initdb, or a cast or comparison between such types done by such
+//		functions and operators. Those stay the same across catalog versions,
+//		until the shared metadata cache drops them because one changes
+//
+//---------------------------------------------------------------------------
+BOOL
+CMDProviderRelcache::IsBuiltinObject
+	(
+	const IMDCacheObject *md_obj
+	)
+{
+	switch (md_obj->MDType())
+	{
+		case IMDCacheObject::EmdtType:
+		case IMDCacheObject::EmdtOp:
+		case IMDCacheObject::EmdtFunc:
+		case IMDCacheObject::EmdtAgg:
+			return IsBuiltinMdId(md_obj->MDId());
+
+		case IMDCacheObject::EmdtCastFunc:
+		{
+			const IMDCast *md_cast = dynamic_cast<const IMDCast *>(md_obj);
+			return IsBuiltinMdId(md_cast->MdidSrc()) &&
+					IsBuiltinMdId(md_cast->MdidDest()) &&
+					IsBuiltinMdId(md_cast->GetCastFuncMdId());
+		}
+
+		case IMDCacheObject::EmdtScCmp:
+		{
+			const IMDScCmp *md_sccmp = dynamic_cast<const IMDScCmp *>(md_obj);
+			return IsBuiltinMdId(md_sccmp->GetLeftMdid()) &&
+					IsBuiltinMdId(md_sccmp->GetRightMdid()) &&
+					IsBuiltinMdId(md_sccmp->MdIdOp());
+		}
+
+		default:
+			return false;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::TrackObject
+//
+//	@doc:
+//		Remember the object fetched into the metadata cache in terms of the
+//		catalogs it comes from, so that it can be evicted when they change
+//
+//---------------------------------------------------------------------------
+void
+CMDProviderRelcache::TrackObject
+	(
+	CMDAccessor *md_accessor,
+	IMDId *md_id
+	)
+{
+	gpdb::MDCacheObject object;
+	memset(&object, 0, sizeof(object));
+
+	switch (md_id->MdidType())
+	{
+		case IMDId::EmdidGPDB:
+			object.kind = gpdb::MDCacheObjectGPDB;
+			object.oids[0] = CMDIdGPDB::CastMdid(md_id)->Oid();
+			break;
+
+		case IMDId::EmdidRelStats:
+			object.kind = gpdb::MDCacheObjectRelStats;
+			object.oids[0] = CMDIdGPDB::CastMdid(CMDIdRelStats::CastMdid(md_id)->GetRelMdId())->Oid();
+			break;
+
+		case IMDId::EmdidColStats:
+		{
+			CMDIdColStats *mdid_col_stats = CMDIdColStats::CastMdid(md_id);
+			IMDId *mdid_rel = mdid_col_stats->GetRelMdId();
+			const IMDRelation *md_rel = md_accessor->RetrieveRel(mdid_rel);
+
+			object.kind = gpdb::MDCacheObjectColStats;
+			object.oids[0] = CMDIdGPDB::CastMdid(mdid_rel)->Oid();
+			object.num = mdid_col_stats->Position();
+			object.attno = md_rel->GetMdCol(mdid_col_stats->Position())->AttrNum();
+			break;
+		}
+
+		case IMDId::EmdidCastFunc:
+		{
+			CMDIdCast *mdid_cast = CMDIdCast::CastMdid(md_id);
+
+			object.kind = gpdb::MDCacheObjectCast;
+			object.oids[0] = CMDIdGPDB::CastMdid(mdid_cast->MdidSrc())->Oid();
+			object.oids[1] = CMDIdGPDB::CastMdid(mdid_cast->MdidDest())->Oid();
+			break;
+		}
+
+		case IMDId::EmdidScCmp:
+		{
+			CMDIdScCmp *mdid_scalar_cmp = CMDIdScCmp::CastMdid(md_id);
+
+			object.kind = gpdb::MDCacheObjectScCmp;
+			object.oids[0] = CMDIdGPDB::CastMdid(mdid_scalar_cmp->GetLeftMdid())->Oid();
+			object.oids[1] = CMDIdGPDB::CastMdid(mdid_scalar_cmp->GetRightMdid())->Oid();
+			object.num = mdid_scalar_cmp->ParseCmpType();
+			break;
+		}
+
+		default:
+			// not retrieved from the relcache
+			return;
+	}
+
+	gpdb::MDCacheTrackObject(&object);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::EncodeUTF8
+//
+//	@doc:
+//		UTF-8 encoding of the DXL string, with a terminating zero. DXL is
+//		almost all ASCII, so it takes a quarter of the space of the wide
+//		characters
+//
+//---------------------------------------------------------------------------
+CHAR *
+CMDProviderRelcache::EncodeUTF8
+	(
+	CMemoryPool *mp,
+	const CWStringBase *str,
+	ULONG *len
+	)
+{
+	const WCHAR *wcstr = str->GetBuffer();
+	const ULONG num_chars = str->Length();
+
+	CHAR *data = GPOS_NEW_ARRAY(mp, CHAR, num_chars * 4 + 1);
+	ULONG pos = 0;
+	for (ULONG ul = 0; ul < num_chars; ul++)
+	{
+		ULONG code = (ULONG) wcstr[ul];
+
+		if (0x80 > code)
+		{
+			data[pos++] = (CHAR) code;
+		}
+		else if (0x800 > code)
+		{
+			data[pos++] = (CHAR) (0xC0 | (code >> 6));
+			data[pos++] = (CHAR) (0x80 | (code & 0x3F));
+		}
+		else if (0x10000 > code)
+		{
+			data[pos++] = (CHAR) (0xE0 | (code >> 12));
+			data[pos++] = (CHAR) (0x80 | ((code >> 6) & 0x3F));
+			data[pos++] = (CHAR) (0x80 | (code & 0x3F));
+		}
+		else if (0x110000 > code)
+		{
+			data[pos++] = (CHAR) (0xF0 | (code >> 18));
+			data[pos++] = (CHAR) (0x80 | ((code >> 12) & 0x3F));
+			data[pos++] = (CHAR) (0x80 | ((code >> 6) & 0x3F));
+			data[pos++] = (CHAR) (0x80 | (code & 0x3F));
+		}
+		else
+		{
+			GPOS_DELETE_ARRAY(data);
+			return NULL;
+		}
+	}
+	data[pos++] = '\0';
+
+	*len = pos;
+	return data;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::DecodeUTF8
+//
+//	@doc:
+//		DXL string of the UTF-8 encoding made by EncodeUTF8
+//
+//---------------------------------------------------------------------------
+CWStringDynamic *
+CMDProviderRelcache::DecodeUTF8
+	(
+	CMemoryPool *mp,
+	const CHAR *data,
+	ULONG len
+	)
+{
+	if (0 == len || '\0' != data[len - 1])
+	{
+		return NULL;
+	}
+
+	// no more characters than bytes
+	WCHAR *wcstr = GPOS_NEW_ARRAY(mp, WCHAR, len);
+	ULONG num_chars = 0;
+	ULONG pos = 0;
+	while (pos < len - 1)
+	{
+		const BYTE lead = (BYTE) data[pos];
+		ULONG code = 0;
+		ULONG num_cont = 0;
+
+		if (0x80 > lead)
+		{
+			code = lead;
+		}
+		else if (0xC0 == (lead & 0xE0))
+		{
+			code = lead & 0x1F;
+			num_cont = 1;
+		}
+		else if (0xE0 == (lead & 0xF0))
+		{
+			code = lead & 0x0F;
+			num_cont = 2;
+		}
+		else if (0xF0 == (lead & 0xF8))
+		{
+			code = lead & 0x07;
+			num_cont = 3;
+		}
+		else
+		{
+			GPOS_DELETE_ARRAY(wcstr);
+			return NULL;
+		}
+
+		pos++;
+		for (ULONG ul = 0; ul < num_cont; ul++, pos++)
+		{
+			if (pos >= len - 1 || 0x80 != (((BYTE) data[pos]) & 0xC0))
+			{
+				GPOS_DELETE_ARRAY(wcstr);
+				return NULL;
+			}
+			code = (code << 6) | (((BYTE) data[pos]) & 0x3F);
+		}
+
+		wcstr[num_chars++] = (WCHAR) code;
+	}
+	wcstr[num_chars] = GPOS_WSZ_LIT('\0');
+
+	CWStringDynamic *str = GPOS_NEW(mp) CWStringDynamic(mp, wcstr);
+	GPOS_DELETE_ARRAY(wcstr);
+
+	return str;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMDProviderRelcache::GetMDObjDXLStr
 //
 //	@doc:
-//		Returns the DXL of the requested object in the provided memory pool
+//		Returns the DXL of the requested object in the provided memory pool,
+//		and counts the fetch, the time it took and its allocations
 //
 //---------------------------------------------------------------------------
 CWStringBase *
@@ -62,15 +405,108 @@ CMDProviderRelcache::GetMDObjDXLStr
 	)
 	const
 {
+	CWallClock timer;
+	uint64 alloc_bytes_before;
+	uint64 allocs_before = gpdb::GetOptimizerAllocations(&alloc_bytes_before);
+
+	CWStringBase *str = RetrieveMDObjDXLStr(mp, md_accessor, md_id);
+
+	uint64 alloc_bytes;
+	uint64 allocs = gpdb::GetOptimizerAllocations(&alloc_bytes);
+
+	m_num_fetches++;
+	m_fetch_time_us += timer.ElapsedUS();
+	m_fetch_allocs += allocs - allocs_before;
+	m_fetch_alloc_bytes += alloc_bytes - alloc_bytes_before;
+
+	return str;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::RetrieveMDObjDXLStr
+//
+//	@doc:
+//		Returns the DXL of the requested object in the provided memory pool.
+//		The DXL another backend has stored in the shared metadata cache at
+//		the same catalog version, or for a built-in object at any version,
+//		is used if there is one
+//
+//---------------------------------------------------------------------------
+CWStringBase *
+CMDProviderRelcache::RetrieveMDObjDXLStr
+	(
+	CMemoryPool *mp,
+	CMDAccessor *md_accessor,
+	IMDId *md_id
+	)
+	const
+{
+	CHAR key[SHARED_MDCACHE_KEY_LEN];
+	BOOL use_shared_cache = m_use_shared_cache && GetSharedCacheKey(md_id, key, GPOS_ARRAY_SIZE(key));
+
+	// relation statistics corrected by cardinality feedback are private to
+	// the backend
+	if (use_shared_cache && IMDId::EmdidRelStats == md_id->MdidType())
+	{
+		double feedback_rows = 0.0;
+		OID rel_oid = CMDIdGPDB::CastMdid(CMDIdRelStats::CastMdid(md_id)->GetRelMdId())->Oid();
+		use_shared_cache = !gpdb::GetCardinalityFeedback(rel_oid, &feedback_rows);
+	}
+
+	if (use_shared_cache)
+	{
+		Size len = 0;
+		CHAR *dxl = gpdb::SharedMDCacheLookup(m_shared_cache_version, key, &len);
+		CWStringDynamic *str = NULL;
+		if (NULL != dxl)
+		{
+			str = DecodeUTF8(m_mp, dxl, (ULONG) len);
+			gpdb::GPDBFree(dxl);
+		}
+
+		if (NULL != str)
+		{
+			TrackObject(md_accessor, md_id);
+
+#ifdef FAULT_INJECTOR
+			// the catalogs would have been accessed without the shared cache
+			gpdb::InjectFaultInOptTasks("opt_relcache_translator_catalog_access");
+#endif // FAULT_INJECTOR
+
+			return str;
+		}
+	}
+
 	IMDCacheObject *md_obj = CTranslatorRelcacheToDXL::RetrieveObject(mp, md_accessor, md_id);
 
 	GPOS_ASSERT(NULL != md_obj);
 
 	CWStringDynamic *str = CDXLUtils::SerializeMDObj(m_mp, md_obj, true /*fSerializeHeaders*/, false /*findent*/);
 
+	BOOL is_builtin = IsBuiltinObject(md_obj);
+
 	// cleanup DXL object
 	md_obj->Release();
 
+	TrackObject(md_accessor, md_id);
+
+	ULONG len = 0;
+	CHAR *dxl = use_shared_cache ? EncodeUTF8(m_mp, str, &len) : NULL;
+	if (NULL != dxl)
+	{
+		// built-in objects are kept across catalog versions
+		if (is_builtin)
+		{
+			gpdb::SharedMDCacheStoreBuiltin(key, dxl, len);
+		}
+		else
+		{
+			gpdb::SharedMDCacheStore(m_shared_cache_version, key, dxl, len);
+		}
+		GPOS_DELETE_ARRAY(dxl);
+	}
+
 	return str;
 }
 
@@ -35,8 +35,8 @@ CDXLTranslateContext::CDXLTranslateContext
 	m_mp(mp),
 	m_is_child_agg_node(is_child_agg_node)
 {
-	// initialize hash table
-	m_colid_to_target_entry_map = GPOS_NEW(m_mp) ULongToTargetEntryMap(m_mp);
+	// the target entry hash map is allocated with the first mapping
+	m_colid_to_target_entry_map = NULL;
 	m_colid_to_paramid_map = GPOS_NEW(m_mp) ULongToColParamMap(m_mp);
 }
 
@@ -45,7 +45,8 @@ CDXLTranslateContext::CDXLTranslateContext
 //		CDXLTranslateContext::CDXLTranslateContext
 //
 //	@doc:
-//		Ctor
+//		Ctor, the params hashmap of the parent context is shared until a
+//		mapping is inserted in either of them
 //
 //---------------------------------------------------------------------------
 CDXLTranslateContext::CDXLTranslateContext
@@ -58,9 +59,9 @@ CDXLTranslateContext::CDXLTranslateContext
 	m_mp(mp),
 	m_is_child_agg_node(is_child_agg_node)
 {
-	m_colid_to_target_entry_map = GPOS_NEW(m_mp) ULongToTargetEntryMap(m_mp);
-	m_colid_to_paramid_map = GPOS_NEW(m_mp) ULongToColParamMap(m_mp);
-	CopyParamHashmap(original);
+	m_colid_to_target_entry_map = NULL;
+	original->AddRef();
+	m_colid_to_paramid_map = original;
 }
 
 //---------------------------------------------------------------------------
@@ -73,7 +74,7 @@ CDXLTranslateContext::CDXLTranslateContext
 //---------------------------------------------------------------------------
 CDXLTranslateContext::~CDXLTranslateContext()
 {
-	m_colid_to_target_entry_map->Release();
+	CRefCount::SafeRelease(m_colid_to_target_entry_map);
 	m_colid_to_paramid_map->Release();
 }
 
@@ -133,6 +134,11 @@ CDXLTranslateContext::GetTargetEntry
 	)
 	const
 {
+	if (NULL == m_colid_to_target_entry_map)
+	{
+		return NULL;
+	}
+
 	return m_colid_to_target_entry_map->Find(&colid);
 }
 
@@ -169,10 +175,18 @@ CDXLTranslateContext::InsertMapping
 	TargetEntry *target_entry
 	)
 {
+	GPOS_ASSERT(NULL != target_entry);
+
+	if (NULL == m_colid_to_target_entry_map)
+	{
+		m_colid_to_target_entry_map = GPOS_NEW(m_mp) ULongToTargetEntryMap(m_mp);
+	}
+
 	// copy key
 	ULONG *key = GPOS_NEW(m_mp) ULONG(colid);
 
-	// insert colid->target entry mapping in the hash map
+	// insert colid->target entry mapping in the hash map, the first mapping
+	// of a ColId is kept
 	BOOL result = m_colid_to_target_entry_map->Insert(key, target_entry);
 
 	if (!result)
@@ -196,6 +210,16 @@ CDXLTranslateContext::FInsertParamMapping
 	CMappingElementColIdParamId *colidparamid
 	)
 {
+	// the params hashmap may be shared with the parent or child contexts,
+	// which must not see the new mapping, so take a private copy first
+	if (1 < m_colid_to_paramid_map->RefCount())
+	{
+		ULongToColParamMap *shared_map = m_colid_to_paramid_map;
+		m_colid_to_paramid_map = GPOS_NEW(m_mp) ULongToColParamMap(m_mp);
+		CopyParamHashmap(shared_map);
+		shared_map->Release();
+	}
+
 	// copy key
 	ULONG *key = GPOS_NEW(m_mp) ULONG(colid);
 
@@ -23,6 +23,7 @@
 #include "naucrates/dxl/CDXLUtils.h"
 #include "naucrates/md/IMDIndex.h"
 
+#include "gpos/common/clibwrapper.h"
 #include "gpos/error/CAutoTrace.h"
 
 #include "gpopt/gpdbwrappers.h"
@@ -30,6 +31,9 @@
 using namespace gpdxl;
 using namespace gpmd;
 
+// number of slots of a new mapping, a power of 2
+#define GPDXL_VAR_COLID_INITIAL_SLOTS 256
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMappingVarColId::CMappingVarColId
@@ -43,11 +47,127 @@ CMappingVarColId::CMappingVarColId
 	CMemoryPool *mp
 	)
 	:
-	m_mp(mp)
+	m_mp(mp),
+	m_slots(NULL),
+	m_num_slots(GPDXL_VAR_COLID_INITIAL_SLOTS),
+	m_num_mappings(0)
+{
+	m_slots = GPOS_NEW_ARRAY(m_mp, SGPDBAttOptCol, m_num_slots);
+	clib::Memset(m_slots, 0, m_num_slots * sizeof(SGPDBAttOptCol));
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMappingVarColId::CMappingVarColId
+//
+//	@doc:
+//		Ctor with the number of slots to start with
+//
+//---------------------------------------------------------------------------
+CMappingVarColId::CMappingVarColId
+	(
+	CMemoryPool *mp,
+	ULONG num_slots
+	)
+	:
+	m_mp(mp),
+	m_slots(NULL),
+	m_num_slots(num_slots),
+	m_num_mappings(0)
+{
+	GPOS_ASSERT(0 < num_slots && 0 == (num_slots & (num_slots - 1)));
+
+	m_slots = GPOS_NEW_ARRAY(m_mp, SGPDBAttOptCol, m_num_slots);
+	clib::Memset(m_slots, 0, m_num_slots * sizeof(SGPDBAttOptCol));
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMappingVarColId::~CMappingVarColId
+//
+//	@doc:
+//		Dtor
+//
+//---------------------------------------------------------------------------
+CMappingVarColId::~CMappingVarColId()
+{
+	for (ULONG ul = 0; ul < m_num_slots; ul++)
+	{
+		if (0 != m_slots[ul].m_var_no)
+		{
+			GPOS_DELETE(m_slots[ul].m_colname);
+		}
+	}
+
+	GPOS_DELETE_ARRAY(m_slots);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMappingVarColId::FindSlot
+//
+//	@doc:
+//		Return the slot of the gpdb att, or the empty slot where it would be
+//		inserted
+//
+//---------------------------------------------------------------------------
+ULONG
+CMappingVarColId::FindSlot
+	(
+	ULONG query_level,
+	ULONG var_no,
+	INT attno
+	)
+	const
+{
+	ULONG hash = (query_level * 0x9E3779B1) ^ (var_no * 0x85EBCA6B) ^ (ULONG(attno) * 0xC2B2AE35);
+	hash ^= hash >> 16;
+
+	// linear probing, there always is an empty slot
+	ULONG mask = m_num_slots - 1;
+	ULONG slot = hash & mask;
+	while (0 != m_slots[slot].m_var_no)
+	{
+		const SGPDBAttOptCol *mapping = &m_slots[slot];
+		if (mapping->m_var_no == var_no && mapping->m_attno == attno &&
+			mapping->m_query_level == query_level)
+		{
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMappingVarColId::Grow
+//
+//	@doc:
+//		Double the number of slots
+//
+//---------------------------------------------------------------------------
+void
+CMappingVarColId::Grow()
 {
-	// This map can have many entries if there are many tables with many columns
-	// in the query, so use a larger hash map to minimize collisions
-	m_gpdb_att_opt_col_mapping = GPOS_NEW(m_mp) GPDBAttOptColHashMap(m_mp, 2047);
+	SGPDBAttOptCol *old_slots = m_slots;
+	ULONG old_num_slots = m_num_slots;
+
+	m_num_slots = old_num_slots * 2;
+	m_slots = GPOS_NEW_ARRAY(m_mp, SGPDBAttOptCol, m_num_slots);
+	clib::Memset(m_slots, 0, m_num_slots * sizeof(SGPDBAttOptCol));
+
+	for (ULONG ul = 0; ul < old_num_slots; ul++)
+	{
+		const SGPDBAttOptCol *mapping = &old_slots[ul];
+		if (0 != mapping->m_var_no)
+		{
+			m_slots[FindSlot(mapping->m_query_level, mapping->m_var_no, mapping->m_attno)] = *mapping;
+		}
+	}
+
+	GPOS_DELETE_ARRAY(old_slots);
 }
 
 //---------------------------------------------------------------------------
@@ -58,7 +178,7 @@ CMappingVarColId::CMappingVarColId
 //		Given a gpdb attribute, return the mapping info to opt col
 //
 //---------------------------------------------------------------------------
-const CGPDBAttOptCol *
+const CMappingVarColId::SGPDBAttOptCol *
 CMappingVarColId::GetGPDBAttOptColMapping
 	(
 	ULONG current_query_level,
@@ -82,17 +202,15 @@ CMappingVarColId::GetGPDBAttOptColMapping
 		var_no = OUTER_VAR;
 	}
 
-	CGPDBAttInfo *gpdb_att_info = GPOS_NEW(m_mp) CGPDBAttInfo(abs_query_level, var_no, var->varattno);
-	CGPDBAttOptCol *gpdb_att_opt_col_info = m_gpdb_att_opt_col_mapping->Find(gpdb_att_info);
+	const SGPDBAttOptCol *mapping = &m_slots[FindSlot(abs_query_level, var_no, var->varattno)];
 	
-	if (NULL == gpdb_att_opt_col_info)
+	if (0 == mapping->m_var_no)
 	{
 		// TODO: Sept 09 2013, remove temporary fix (revert exception to assert) to avoid crash during algebrization
 		GPOS_RAISE(gpdxl::ExmaDXL, gpdxl::ExmiQuery2DXLError, GPOS_WSZ_LIT("No variable"));
 	}
 
-	gpdb_att_info->Release();
-	return gpdb_att_opt_col_info;
+	return mapping;
 }
 
 //---------------------------------------------------------------------------
@@ -112,7 +230,7 @@ CMappingVarColId::GetOptColName
 	)
 	const
 {
-	return GetGPDBAttOptColMapping(current_query_level, var, plstmt_physical_op_type)->GetOptColInfo()->GetOptColName();
+	return GetGPDBAttOptColMapping(current_query_level, var, plstmt_physical_op_type)->m_colname;
 }
 
 //---------------------------------------------------------------------------
@@ -132,7 +250,7 @@ CMappingVarColId::GetColId
 	)
 	const
 {
-	return GetGPDBAttOptColMapping(current_query_level, var, plstmt_physical_op_type)->GetOptColInfo()->GetColId();
+	return GetGPDBAttOptColMapping(current_query_level, var, plstmt_physical_op_type)->m_colid;
 }
 
 //---------------------------------------------------------------------------
@@ -140,7 +258,7 @@ CMappingVarColId::GetColId
 //		CMappingVarColId::Insert
 //
 //	@doc:
-//		Insert a single entry into the hash map
+//		Insert a single entry into the hash table
 //
 //---------------------------------------------------------------------------
 void
@@ -156,23 +274,29 @@ CMappingVarColId::Insert
 	// GPDB agg node uses 0 in Var, but that should've been taken care of
 	// by translator
 	GPOS_ASSERT(var_no > 0);
+	GPOS_ASSERT(NULL != column_name);
 
-	// create key
-	CGPDBAttInfo *gpdb_att_info = GPOS_NEW(m_mp) CGPDBAttInfo(query_level, var_no, attrnum);
-
-	// create value
-	COptColInfo *opt_col_info = GPOS_NEW(m_mp) COptColInfo(colid, column_name);
-
-	// key is part of value, bump up refcount
-	gpdb_att_info->AddRef();
-	CGPDBAttOptCol *gpdb_att_opt_col_info = GPOS_NEW(m_mp) CGPDBAttOptCol(gpdb_att_info, opt_col_info);
+	// keep the slots at most half full
+	if (2 * (m_num_mappings + 1) > m_num_slots)
+	{
+		Grow();
+	}
 
-#ifdef GPOS_DEBUG
-	BOOL result =
-#endif // GPOS_DEBUG
-			m_gpdb_att_opt_col_mapping->Insert(gpdb_att_info, gpdb_att_opt_col_info);
+	SGPDBAttOptCol *mapping = &m_slots[FindSlot(query_level, var_no, attrnum)];
+	GPOS_ASSERT(0 == mapping->m_var_no);
+	if (0 != mapping->m_var_no)
+	{
+		// keep the first mapping, as the hash map did
+		GPOS_DELETE(column_name);
+		return;
+	}
 
-	GPOS_ASSERT(result);
+	mapping->m_query_level = query_level;
+	mapping->m_var_no = var_no;
+	mapping->m_attno = attrnum;
+	mapping->m_colid = colid;
+	mapping->m_colname = column_name;
+	m_num_mappings++;
 }
 
 //---------------------------------------------------------------------------
@@ -452,43 +576,54 @@ CMappingVarColId::LoadProjectElements
 
 //---------------------------------------------------------------------------
 //	@function:
-//		CMappingVarColId::CopyMapColId
+//		CMappingVarColId::Copy
 //
 //	@doc:
-//		Create a deep copy
+//		Create a deep copy of the mappings up to the query level, or of all of
+//		them if max_query_level is NULL.  The slots are copied as they are when
+//		all mappings are, only the column names need allocating.
 //
 //---------------------------------------------------------------------------
 CMappingVarColId *
-CMappingVarColId::CopyMapColId
+CMappingVarColId::Copy
 	(
-	ULONG query_level
+	CMemoryPool *mp,
+	const ULONG *max_query_level
 	)
 	const
 {
-	CMappingVarColId *var_colid_mapping = GPOS_NEW(m_mp) CMappingVarColId(m_mp);
+	CMappingVarColId *var_colid_mapping = GPOS_NEW(mp) CMappingVarColId(mp, m_num_slots);
 
-	// iterate over full map
-	GPDBAttOptColHashMapIter col_map_iterator(this->m_gpdb_att_opt_col_mapping);
-	while (col_map_iterator.Advance())
+	if (NULL == max_query_level)
 	{
-		const CGPDBAttOptCol *gpdb_att_opt_col_info = col_map_iterator.Value();
-		const CGPDBAttInfo *gpdb_att_info = gpdb_att_opt_col_info->GetGPDBAttInfo();
-		const COptColInfo *opt_col_info = gpdb_att_opt_col_info->GetOptColInfo();
+		clib::Memcpy(var_colid_mapping->m_slots, m_slots, m_num_slots * sizeof(SGPDBAttOptCol));
+		for (ULONG ul = 0; ul < m_num_slots; ul++)
+		{
+			if (0 != m_slots[ul].m_var_no)
+			{
+				var_colid_mapping->m_slots[ul].m_colname = GPOS_NEW(mp) CWStringConst(mp, m_slots[ul].m_colname->GetBuffer());
+			}
+		}
+		var_colid_mapping->m_num_mappings = m_num_mappings;
 
-		if (gpdb_att_info->GetQueryLevel() <= query_level)
+		return var_colid_mapping;
+	}
+
+	for (ULONG ul = 0; ul < m_num_slots; ul++)
+	{
+		const SGPDBAttOptCol *mapping = &m_slots[ul];
+
+		// include all variables defined at same query level or before
+		if (0 != mapping->m_var_no && mapping->m_query_level <= *max_query_level)
 		{
-			// include all variables defined at same query level or before
-			CGPDBAttInfo *gpdb_att_info_new = GPOS_NEW(m_mp) CGPDBAttInfo(gpdb_att_info->GetQueryLevel(), gpdb_att_info->GetVarNo(), gpdb_att_info->GetAttNo());
-			COptColInfo *opt_col_info_new = GPOS_NEW(m_mp) COptColInfo(opt_col_info->GetColId(), GPOS_NEW(m_mp) CWStringConst(m_mp, opt_col_info->GetOptColName()->GetBuffer()));
-			gpdb_att_info_new->AddRef();
-			CGPDBAttOptCol *gpdb_att_opt_col_new = GPOS_NEW(m_mp) CGPDBAttOptCol(gpdb_att_info_new, opt_col_info_new);
-
-			// insert into hashmap
-#ifdef GPOS_DEBUG
-			BOOL result =
-#endif // GPOS_DEBUG
-					var_colid_mapping->m_gpdb_att_opt_col_mapping->Insert(gpdb_att_info_new, gpdb_att_opt_col_new);
-			GPOS_ASSERT(result);
+			var_colid_mapping->Insert
+					(
+					mapping->m_query_level,
+					mapping->m_var_no,
+					mapping->m_attno,
+					mapping->m_colid,
+					GPOS_NEW(mp) CWStringConst(mp, mapping->m_colname->GetBuffer())
+					);
 		}
 	}
 
@@ -506,34 +641,29 @@ CMappingVarColId::CopyMapColId
 CMappingVarColId *
 CMappingVarColId::CopyMapColId
 	(
-	CMemoryPool *mp
+	ULONG query_level
 	)
 	const
 {
-	CMappingVarColId *var_colid_mapping = GPOS_NEW(mp) CMappingVarColId(mp);
-
-	// iterate over full map
-	GPDBAttOptColHashMapIter col_map_iterator(this->m_gpdb_att_opt_col_mapping);
-	while (col_map_iterator.Advance())
-	{
-		const CGPDBAttOptCol *gpdb_att_opt_col_info = col_map_iterator.Value();
-		const CGPDBAttInfo *gpdb_att_info = gpdb_att_opt_col_info->GetGPDBAttInfo();
-		const COptColInfo *opt_col_info = gpdb_att_opt_col_info->GetOptColInfo();
-
-		CGPDBAttInfo *gpdb_att_info_new = GPOS_NEW(mp) CGPDBAttInfo(gpdb_att_info->GetQueryLevel(), gpdb_att_info->GetVarNo(), gpdb_att_info->GetAttNo());
-		COptColInfo *opt_col_info_new = GPOS_NEW(mp) COptColInfo(opt_col_info->GetColId(), GPOS_NEW(mp) CWStringConst(mp, opt_col_info->GetOptColName()->GetBuffer()));
-		gpdb_att_info_new->AddRef();
-		CGPDBAttOptCol *gpdb_att_opt_col_new = GPOS_NEW(mp) CGPDBAttOptCol(gpdb_att_info_new, opt_col_info_new);
-
-		// insert into hashmap
-#ifdef GPOS_DEBUG
-	BOOL result =
-#endif // GPOS_DEBUG
-		var_colid_mapping->m_gpdb_att_opt_col_mapping->Insert(gpdb_att_info_new, gpdb_att_opt_col_new);
-		GPOS_ASSERT(result);
-	}
+	return Copy(m_mp, &query_level);
+}
 
-	return var_colid_mapping;
+//---------------------------------------------------------------------------
+//	@function:
+//		CMappingVarColId::CopyMapColId
+//
+//	@doc:
+//		Create a deep copy
+//
+//---------------------------------------------------------------------------
+CMappingVarColId *
+CMappingVarColId::CopyMapColId
+	(
+	CMemoryPool *mp
+	)
+	const
+{
+	return Copy(mp, NULL);
 }
 
 //---------------------------------------------------------------------------
@@ -560,32 +690,21 @@ CMappingVarColId::CopyRemapColId
 	// construct a mapping old cols -> new cols
 	UlongToUlongMap *old_new_col_mapping = CTranslatorUtils::MakeNewToOldColMapping(mp, old_colids, new_colids);
 		
-	CMappingVarColId *var_colid_mapping = GPOS_NEW(mp) CMappingVarColId(mp);
+	CMappingVarColId *var_colid_mapping = Copy(mp, NULL);
 
-	GPDBAttOptColHashMapIter col_map_iterator(this->m_gpdb_att_opt_col_mapping);
-	while (col_map_iterator.Advance())
+	for (ULONG ul = 0; ul < var_colid_mapping->m_num_slots; ul++)
 	{
-		const CGPDBAttOptCol *gpdb_att_opt_col_info = col_map_iterator.Value();
-		const CGPDBAttInfo *gpdb_att_info = gpdb_att_opt_col_info->GetGPDBAttInfo();
-		const COptColInfo *opt_col_info = gpdb_att_opt_col_info->GetOptColInfo();
+		SGPDBAttOptCol *mapping = &var_colid_mapping->m_slots[ul];
+		if (0 == mapping->m_var_no)
+		{
+			continue;
+		}
 
-		CGPDBAttInfo *gpdb_att_info_new = GPOS_NEW(mp) CGPDBAttInfo(gpdb_att_info->GetQueryLevel(), gpdb_att_info->GetVarNo(), gpdb_att_info->GetAttNo());
-		ULONG colid = opt_col_info->GetColId();
-		ULONG *new_colid = old_new_col_mapping->Find(&colid);
+		ULONG *new_colid = old_new_col_mapping->Find(&mapping->m_colid);
 		if (NULL != new_colid)
 		{
-			colid = *new_colid;
+			mapping->m_colid = *new_colid;
 		}
-		
-		COptColInfo *opt_col_info_new = GPOS_NEW(mp) COptColInfo(colid, GPOS_NEW(mp) CWStringConst(mp, opt_col_info->GetOptColName()->GetBuffer()));
-		gpdb_att_info_new->AddRef();
-		CGPDBAttOptCol *gpdb_att_opt_col_new = GPOS_NEW(mp) CGPDBAttOptCol(gpdb_att_info_new, opt_col_info_new);
-
-#ifdef GPOS_DEBUG
-		BOOL result =
-#endif // GPOS_DEBUG
-		var_colid_mapping->m_gpdb_att_opt_col_mapping->Insert(gpdb_att_info_new, gpdb_att_opt_col_new);
-		GPOS_ASSERT(result);
 	}
 	
 	old_new_col_mapping->Release();
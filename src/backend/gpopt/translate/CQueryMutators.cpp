@@ -160,15 +160,12 @@ CQueryMutators::NormalizeGroupByProjList
 	const Query *query
 	)
 {
-	Query *query_copy = (Query *) gpdb::CopyObject(const_cast<Query*>(query));
-
-	if (!NeedsProjListNormalization(query_copy))
+	if (!NeedsProjListNormalization(query))
 	{
-		return query_copy;
+		return (Query *) gpdb::CopyObject(const_cast<Query*>(query));
 	}
 
-	Query *new_query = ConvertToDerivedTable(query_copy, false /*should_fix_target_list*/, true /*should_fix_having_qual*/);
-	gpdb::GPDBFree(query_copy);
+	Query *new_query = ConvertToDerivedTable(query, false /*should_fix_target_list*/, true /*should_fix_having_qual*/);
 
 	GPOS_ASSERT(1 == gpdb::ListLength(new_query->rtable));
 	Query *derived_table_query = (Query *) ((RangeTblEntry *) gpdb::ListNth(new_query->rtable, 0))->subquery;
@@ -443,6 +440,68 @@ CQueryMutators::NeedsLevelsUpCorrection
 	return cte_levels_up >= context->m_current_query_level;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CQueryMutators::RunLevelsUpWalker
+//
+//	@doc:
+//		Find the outer references fixed by RunIncrLevelsUpMutator and the
+//		CTE range table entries fixed by RunFixCTELevelsUpMutator, so that
+//		the mutators can be skipped when there are none
+//---------------------------------------------------------------------------
+BOOL
+CQueryMutators::RunLevelsUpWalker
+	(
+	Node *node,
+	SContextLevelsUpWalker *context
+	)
+{
+	if (NULL == node)
+	{
+		return false;
+	}
+
+	if (IsA(node, Var))
+	{
+		if (((Var *) node)->varlevelsup > context->m_current_query_level)
+		{
+			context->m_has_outer_refs = true;
+		}
+
+		return context->m_has_outer_refs && context->m_has_cte_refs;
+	}
+
+	if (IsA(node, RangeTblEntry))
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) node;
+		if (RTE_CTE == rte->rtekind && rte->ctelevelsup >= context->m_current_query_level)
+		{
+			context->m_has_cte_refs = true;
+		}
+
+		// returning false continues into the contents of the entry
+		return context->m_has_outer_refs && context->m_has_cte_refs;
+	}
+
+	// queries of sublinks, CTEs and derived tables are one level down
+	if (IsA(node, Query))
+	{
+		context->m_current_query_level++;
+		BOOL result = gpdb::WalkQueryOrExpressionTree
+							(
+							node,
+							(LevelsUpWalkerFn) CQueryMutators::RunLevelsUpWalker,
+							context,
+							QTW_EXAMINE_RTES
+							);
+		context->m_current_query_level--;
+
+		return result;
+	}
+
+	return gpdb::WalkExpressionTree(node, (LevelsUpWalkerFn) CQueryMutators::RunLevelsUpWalker, context);
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CQueryMutators::RunGroupingColMutator
@@ -1030,15 +1089,12 @@ CQueryMutators::NormalizeHaving
 	const Query *query
 	)
 {
-	Query *query_copy = (Query *) gpdb::CopyObject(const_cast<Query*>(query));
-
 	if (NULL == query->havingQual)
 	{
-		return query_copy;
+		return (Query *) gpdb::CopyObject(const_cast<Query*>(query));
 	}
 
-	Query *new_query = ConvertToDerivedTable(query_copy, true /*should_fix_target_list*/, false /*should_fix_having_qual*/);
-	gpdb::GPDBFree(query_copy);
+	Query *new_query = ConvertToDerivedTable(query, true /*should_fix_target_list*/, false /*should_fix_having_qual*/);
 
 	RangeTblEntry *rte = ((RangeTblEntry *) gpdb::ListNth(new_query->rtable, 0));
 	Query *derived_table_query = (Query *) rte->subquery;
@@ -1137,27 +1193,48 @@ CQueryMutators::NormalizeQuery
 	)
 {
 	// flatten join alias vars defined at the current level of the query
-	Query *pqueryResolveJoinVarReferences = gpdb::FlattenJoinAliasVar(const_cast<Query*>(query), query_level);
+	Query *normalized_query = gpdb::FlattenJoinAliasVar(const_cast<Query*>(query), query_level);
+
+	// Each of the steps below returns a new copy of the query, so a step is
+	// only run when there is something for it to normalize. The checks are
+	// cheap compared to copying the whole query tree, which may hold many
+	// levels of derived tables.
 
 	// eliminate distinct clause
-	Query *pqueryEliminateDistinct = CQueryMutators::EliminateDistinctClause(pqueryResolveJoinVarReferences);
-	GPOS_ASSERT(NULL == pqueryEliminateDistinct->distinctClause);
-	gpdb::GPDBFree(pqueryResolveJoinVarReferences);
+	if (0 < gpdb::ListLength(normalized_query->distinctClause))
+	{
+		Query *pqueryEliminateDistinct = CQueryMutators::EliminateDistinctClause(normalized_query);
+		gpdb::GPDBFree(normalized_query);
+		normalized_query = pqueryEliminateDistinct;
+	}
+	GPOS_ASSERT(NULL == normalized_query->distinctClause);
 
 	// normalize window operator's project list
-	Query *pqueryWindowPlNormalized = CQueryMutators::NormalizeWindowProjList(mp, md_accessor, pqueryEliminateDistinct);
-	gpdb::GPDBFree(pqueryEliminateDistinct);
+	if (NeedsProjListWindowNormalization(normalized_query))
+	{
+		Query *pqueryWindowPlNormalized = CQueryMutators::NormalizeWindowProjList(mp, md_accessor, normalized_query);
+		gpdb::GPDBFree(normalized_query);
+		normalized_query = pqueryWindowPlNormalized;
+	}
 
 	// pull-up having quals into a select
-	Query *pqueryHavingNormalized = CQueryMutators::NormalizeHaving(mp, md_accessor, pqueryWindowPlNormalized);
-	GPOS_ASSERT(NULL == pqueryHavingNormalized->havingQual);
-	gpdb::GPDBFree(pqueryWindowPlNormalized);
+	if (NULL != normalized_query->havingQual)
+	{
+		Query *pqueryHavingNormalized = CQueryMutators::NormalizeHaving(mp, md_accessor, normalized_query);
+		gpdb::GPDBFree(normalized_query);
+		normalized_query = pqueryHavingNormalized;
+	}
+	GPOS_ASSERT(NULL == normalized_query->havingQual);
 
 	// normalize the group by project list
-	Query *new_query = CQueryMutators::NormalizeGroupByProjList(mp, md_accessor, pqueryHavingNormalized);
-	gpdb::GPDBFree(pqueryHavingNormalized);
+	if (NeedsProjListNormalization(normalized_query))
+	{
+		Query *new_query = CQueryMutators::NormalizeGroupByProjList(mp, md_accessor, normalized_query);
+		gpdb::GPDBFree(normalized_query);
+		normalized_query = new_query;
+	}
 
-	return new_query;
+	return normalized_query;
 }
 
 //---------------------------------------------------------------------------
@@ -1239,13 +1316,25 @@ CQueryMutators::ConvertToDerivedTable
 		query_copy->havingQual = NULL;
 	}
 
+	// find out in one walk which of the levels up fixes below have anything to
+	// do, each of the mutators copies the whole query again
+	SContextLevelsUpWalker walker_context;
+	(void) gpdb::WalkQueryOrExpressionTree
+					(
+					(Node *) query_copy,
+					(LevelsUpWalkerFn) CQueryMutators::RunLevelsUpWalker,
+					&walker_context,
+					QTW_EXAMINE_RTES
+					);
+
 	// fix outer references
-	Query *derived_table_query;
+	Query *derived_table_query = query_copy;
+	if (walker_context.m_has_outer_refs)
 	{
 		SContextIncLevelsupMutator context(0, should_fix_target_list);
 		derived_table_query = (Query *) RunIncrLevelsUpMutator((Node*) query_copy, &context);
+		gpdb::GPDBFree(query_copy);
 	}
-	gpdb::GPDBFree(query_copy);
 
 	// fix the CTE levels up -- while the old query is converted into a derived table, its cte list
 	// is re-assigned to the new top-level query. The references to the ctes listed in the old query
@@ -1254,13 +1343,16 @@ CQueryMutators::ConvertToDerivedTable
 	List *original_cte_list = derived_table_query->cteList;
 	derived_table_query->cteList = NIL;
 
-	Query *new_derived_table_query;
+	if (walker_context.m_has_cte_refs)
 	{
-		SContextIncLevelsupMutator context(0 /*starting level */, should_fix_target_list);
-		new_derived_table_query  = (Query *) RunFixCTELevelsUpMutator( (Node *) derived_table_query, &context);
+		Query *new_derived_table_query;
+		{
+			SContextIncLevelsupMutator context(0 /*starting level */, should_fix_target_list);
+			new_derived_table_query  = (Query *) RunFixCTELevelsUpMutator( (Node *) derived_table_query, &context);
+		}
+		gpdb::GPDBFree(derived_table_query);
+		derived_table_query = new_derived_table_query;
 	}
-	gpdb::GPDBFree(derived_table_query);
-	derived_table_query = new_derived_table_query;
 
 	// create a range table entry for the query node
 	RangeTblEntry *rte = MakeNode(RangeTblEntry);
@@ -1455,17 +1547,14 @@ CQueryMutators::NormalizeWindowProjList
 	const Query *query
 	)
 {
-	Query *query_copy = (Query *) gpdb::CopyObject(const_cast<Query*>(query));
-
 	if (!NeedsProjListWindowNormalization(query))
 	{
-		return query_copy;
+		return (Query *) gpdb::CopyObject(const_cast<Query*>(query));
 	}
 
 	// we do not fix target list of the derived table since we will be mutating it below
 	// to ensure that it does not have operations with window function
-	Query *new_query = ConvertToDerivedTable(query_copy, false /*should_fix_target_list*/, true /*should_fix_having_qual*/);
-	gpdb::GPDBFree(query_copy);
+	Query *new_query = ConvertToDerivedTable(query, false /*should_fix_target_list*/, true /*should_fix_having_qual*/);
 
 	GPOS_ASSERT(1 == gpdb::ListLength(new_query->rtable));
 	Query *derived_table_query = (Query *) ((RangeTblEntry *) gpdb::ListNth(new_query->rtable, 0))->subquery;
@@ -263,7 +263,7 @@ CTranslatorDXLToPlStmt::GetPlannedStmtFromDXL
 				GPOS_ASSERT(gpdb::IsMotionGather(motion));
 				
 				motion->plan.directDispatch.isDirectDispatch = true;
-				motion->plan.directDispatch.contentIds = plan->directDispatch.contentIds;
+				motion->plan.directDispatch.contentIds = gpdb::ListCopy(plan->directDispatch.contentIds);
 			}
 		}
 	}
@@ -300,7 +300,82 @@ CTranslatorDXLToPlStmt::TranslateDXLOperatorToPlan
 		GPOS_RAISE(gpdxl::ExmaDXL, gpdxl::ExmiDXL2PlStmtConversion, dxlnode->GetOperator()->GetOpNameStr()->GetBuffer());
 	}
 
-	return (this->* dxlnode_to_logical_funct)(dxlnode, output_context, ctxt_translation_prev_siblings);
+	Plan *plan = (this->* dxlnode_to_logical_funct)(dxlnode, output_context, ctxt_translation_prev_siblings);
+
+	// link the estimates of the plan to its runtime statistics, see
+	// optimizer_plan_trace
+	if (NULL != plan && 0 == plan->plan_fingerprint)
+	{
+		plan->plan_fingerprint = FingerprintDXL(dxlnode);
+	}
+
+	return plan;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorDXLToPlStmt::FingerprintDXL
+//
+//	@doc:
+//		Hash the operators of a DXL tree, physical and scalar, and the tables
+//		and indexes that its scans and DMLs read. Constants and column ids are
+//		left out, so that the same plan shape gets the same fingerprint in
+//		every optimization of a query, whatever its parameters.
+//
+//---------------------------------------------------------------------------
+ULONG
+CTranslatorDXLToPlStmt::FingerprintDXL
+	(
+	const CDXLNode *dxlnode
+	)
+{
+	CDXLOperator *dxlop = dxlnode->GetOperator();
+	ULONG op_id = (ULONG) dxlop->GetDXLOperator();
+	ULONG hash = gpos::HashValue<ULONG>(&op_id);
+
+	const CDXLTableDescr *table_descr = NULL;
+	switch (dxlop->GetDXLOperator())
+	{
+		case EdxlopPhysicalTableScan:
+		case EdxlopPhysicalExternalScan:
+			table_descr = CDXLPhysicalTableScan::Cast(dxlop)->GetDXLTableDescr();
+			break;
+		case EdxlopPhysicalIndexScan:
+			table_descr = CDXLPhysicalIndexScan::Cast(dxlop)->GetDXLTableDescr();
+			hash = gpos::CombineHashes(hash, CDXLPhysicalIndexScan::Cast(dxlop)->GetDXLIndexDescr()->MDId()->HashValue());
+			break;
+		case EdxlopPhysicalDynamicTableScan:
+			table_descr = CDXLPhysicalDynamicTableScan::Cast(dxlop)->GetDXLTableDescr();
+			break;
+		case EdxlopPhysicalDynamicIndexScan:
+			table_descr = CDXLPhysicalDynamicIndexScan::Cast(dxlop)->GetDXLTableDescr();
+			hash = gpos::CombineHashes(hash, CDXLPhysicalDynamicIndexScan::Cast(dxlop)->GetDXLIndexDescr()->MDId()->HashValue());
+			break;
+		case EdxlopPhysicalBitmapTableScan:
+			table_descr = CDXLPhysicalBitmapTableScan::Cast(dxlop)->GetDXLTableDescr();
+			break;
+		case EdxlopPhysicalDynamicBitmapTableScan:
+			table_descr = CDXLPhysicalDynamicBitmapTableScan::Cast(dxlop)->GetDXLTableDescr();
+			break;
+		case EdxlopPhysicalDML:
+			table_descr = CDXLPhysicalDML::Cast(dxlop)->GetDXLTableDescr();
+			break;
+		default:
+			break;
+	}
+
+	if (NULL != table_descr)
+	{
+		hash = gpos::CombineHashes(hash, table_descr->MDId()->HashValue());
+	}
+
+	const ULONG arity = dxlnode->Arity();
+	for (ULONG ul = 0; ul < arity; ul++)
+	{
+		hash = gpos::CombineHashes(hash, FingerprintDXL((*dxlnode)[ul]));
+	}
+
+	return hash;
 }
 
 //---------------------------------------------------------------------------
@@ -1005,12 +1080,104 @@ CTranslatorDXLToPlStmt::TranslateDXLLimit
 	plan->nMotionNodes = left_plan->nMotionNodes;
 	SetParamIds(plan);
 
+	PushLimitBelowGatherMotion(limit, left_plan);
+
 	// cleanup
 	child_contexts->Release();
 
 	return  (Plan *) limit;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorDXLToPlStmt::PushLimitBelowGatherMotion
+//
+//	@doc:
+//		A limit can't pass its bound down to a sort on the other side of a
+//		gather motion at run time. If the motion merges the sorted output of
+//		the segments, copy the limit count and offset into the sort, so that
+//		each segment only keeps the top count + offset tuples
+//
+//---------------------------------------------------------------------------
+void
+CTranslatorDXLToPlStmt::PushLimitBelowGatherMotion
+	(
+	Limit *limit,
+	Plan *child_plan
+	)
+{
+	if (NULL == limit->limitCount || !IsA(child_plan, Motion))
+	{
+		return;
+	}
+
+	Motion *motion = (Motion *) child_plan;
+	Plan *sort_plan = motion->plan.lefttree;
+
+	if (MOTIONTYPE_FIXED != motion->motionType || motion->isBroadcast ||
+		!motion->sendSorted || NULL == sort_plan || !IsA(sort_plan, Sort))
+	{
+		return;
+	}
+
+	if (!FExprEvaluableOnSegments(limit->limitCount) ||
+		!FExprEvaluableOnSegments(limit->limitOffset))
+	{
+		return;
+	}
+
+	Sort *sort = (Sort *) sort_plan;
+
+	// the sort may already be bounded by a limit of its own
+	if (NULL != sort->limitCount || SHARE_NOTSHARED != sort->share_type)
+	{
+		return;
+	}
+
+	sort->limitCount = (Node *) gpdb::CopyObject(limit->limitCount);
+	sort->limitOffset = (Node *) gpdb::CopyObject(limit->limitOffset);
+	SetParamIds(sort_plan);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorDXLToPlStmt::FExprEvaluableOnSegments
+//
+//	@doc:
+//		Can the expression be evaluated on the segments, i.e. it contains no
+//		subplans and no parameters other than those dispatched with the query
+//
+//---------------------------------------------------------------------------
+BOOL
+CTranslatorDXLToPlStmt::FExprEvaluableOnSegments
+	(
+	Node *expr
+	)
+{
+	if (NULL == expr)
+	{
+		return true;
+	}
+
+	if (NIL != gpdb::ExtractNodesExpression(expr, T_SubPlan, true /*descend_into_subqueries*/))
+	{
+		return false;
+	}
+
+	ListCell *lc = NULL;
+	List *params = gpdb::ExtractNodesExpression(expr, T_Param, true /*descend_into_subqueries*/);
+	ForEach (lc, params)
+	{
+		Param *param = (Param *) lfirst(lc);
+		if (PARAM_EXTERN != param->paramkind)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorDXLToPlStmt::TranslateDXLHashJoin
@@ -1850,6 +2017,9 @@ CTranslatorDXLToPlStmt::TranslateDXLMotion
 		&(plan->plan_width)
 		);
 
+	// compress the packets of the motions that send a lot of data
+	motion->compressTuples = GpInterconnectCompressMotion(plan->plan_rows, plan->plan_width);
+
 	CDXLNode *project_list_dxlnode = (*motion_dxlnode)[EdxlgmIndexProjList];
 	CDXLNode *filter_dxlnode = (*motion_dxlnode)[EdxlgmIndexFilter];
 	CDXLNode *sort_col_list_dxl = (*motion_dxlnode)[EdxlgmIndexSortColList];
@@ -2251,6 +2421,32 @@ CTranslatorDXLToPlStmt::TranslateDXLAgg
 
 	agg->streaming = dxl_phy_agg_dxlop->IsStreamSafe();
 
+	// the local stage of a two-stage hash aggregation streams its groups into
+	// the motion instead of spilling, the global stage combines duplicates
+	if (!agg->streaming && AGG_HASHED == agg->aggstrategy && gp_hashagg_streambottom)
+	{
+		BOOL has_partial_agg = false;
+		BOOL has_other_agg = false;
+		ListCell *lc = NULL;
+
+		ForEach (lc, plan->targetlist)
+		{
+			TargetEntry *target_entry = (TargetEntry *) lfirst(lc);
+
+			if (IsA(target_entry->expr, Aggref) &&
+				AGGSTAGE_PARTIAL == ((Aggref *) target_entry->expr)->aggstage)
+			{
+				has_partial_agg = true;
+			}
+			else if (IsA(target_entry->expr, Aggref))
+			{
+				has_other_agg = true;
+			}
+		}
+
+		agg->streaming = has_partial_agg && !has_other_agg;
+	}
+
 	// translate grouping cols
 	const ULongPtrArray *grouping_colid_array = dxl_phy_agg_dxlop->GetGroupingColidArray();
 	agg->numCols = grouping_colid_array->Size();
@@ -3916,25 +4112,29 @@ CTranslatorDXLToPlStmt::TranslateDXLDirectDispatchInfo
 		return NIL;
 	}
 	
-	CDXLDatumArray *dxl_datum_array = (*dispatch_identifier_datum_arrays)[0];
-	GPOS_ASSERT(0 < dxl_datum_array->Size());
-		
-	ULONG hash_code = GetDXLDatumGPDBHash(dxl_datum_array);
+	// each value of the distribution key, as in an IN list, is dispatched to
+	// the segment it hashes to
+	List *segids_list = NIL;
 	const ULONG length = dispatch_identifier_datum_arrays->Size();
 	for (ULONG ul = 0; ul < length; ul++)
 	{
 		CDXLDatumArray *dispatch_identifier_datum_array = (*dispatch_identifier_datum_arrays)[ul];
 		GPOS_ASSERT(0 < dispatch_identifier_datum_array->Size());
-		ULONG hash_code_new = GetDXLDatumGPDBHash(dispatch_identifier_datum_array);
-		
-		if (hash_code != hash_code_new)
+		ULONG hash_code = GetDXLDatumGPDBHash(dispatch_identifier_datum_array);
+
+		if (!gpdb::ListMemberInt(segids_list, hash_code))
 		{
-			// values don't hash to the same segment
-			return NIL;
+			segids_list = gpdb::LAppendInt(segids_list, hash_code);
 		}
 	}
-	
-	List *segids_list = gpdb::LAppendInt(NIL, hash_code);
+
+	if ((ULONG) gpdb::ListLength(segids_list) >= m_num_of_segments)
+	{
+		// the values hash to every segment, don't bother
+		gpdb::ListFree(segids_list);
+		return NIL;
+	}
+
 	return segids_list;
 }
 
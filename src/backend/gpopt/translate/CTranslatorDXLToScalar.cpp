@@ -19,6 +19,9 @@
 #include "nodes/makefuncs.h"
 #include "catalog/pg_collation.h"
 #include "utils/datum.h"
+#include "utils/guc.h"
+#include "access/htup_details.h"
+#include "miscadmin.h"
 
 #include "gpos/base.h"
 
@@ -702,7 +705,90 @@ CTranslatorDXLToScalar::TranslateDXLScalarSubplanToScalar
 	// translate other subplan params
 	TranslateSubplanParams(subplan, &subplan_translate_ctxt, outer_refs, colid_var);
 
-	return (Expr *)subplan;
+	return TranslateHashedSubplan(subplan, plan_child);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorDXLToScalar::TranslateHashedSubplan
+//
+//	@doc:
+//		Let an uncorrelated IN or NOT IN subplan load the result of its
+//		child plan into a hash table once, and probe it for each outer row
+//		instead of scanning the whole result, as make_subplan does for the
+//		planner. The executor only hashes ANY subplans, so x <> ALL (...)
+//		is translated into NOT (x = ANY (...)), which is equivalent for
+//		NULLs too. Returns the expression to use in place of the subplan
+//
+//---------------------------------------------------------------------------
+Expr *
+CTranslatorDXLToScalar::TranslateHashedSubplan
+	(
+	SubPlan *subplan,
+	Plan *plan_child
+	)
+{
+	if (!optimizer_enable_hashed_subplans ||
+		(ANY_SUBLINK != subplan->subLinkType && ALL_SUBLINK != subplan->subLinkType) ||
+		NIL != subplan->parParam ||
+		NULL == subplan->testexpr ||
+		!IsA(subplan->testexpr, OpExpr))
+	{
+		return (Expr *) subplan;
+	}
+
+	// the result of the child plan must fit in work_mem, see subplan_is_hashable
+	double subquery_size = plan_child->plan_rows *
+		(MAXALIGN(plan_child->plan_width) + MAXALIGN(sizeof(HeapTupleHeaderData)));
+	if (subquery_size > (double) planner_work_mem * 1024L)
+	{
+		return (Expr *) subplan;
+	}
+
+	OpExpr *op_expr = (OpExpr *) subplan->testexpr;
+	GPOS_ASSERT(2 == gpdb::ListLength(op_expr->args));
+
+	CMDIdGPDB *mdid_op = GPOS_NEW(m_mp) CMDIdGPDB(op_expr->opno);
+	const IMDScalarOp *md_scalar_op = m_md_accessor->RetrieveScOp(mdid_op);
+	mdid_op->Release();
+
+	if (ALL_SUBLINK == subplan->subLinkType)
+	{
+		// x <> ALL (...) is NOT (x = ANY (...))
+		IMDId *mdid_inverse_op = md_scalar_op->GetInverseOpMdid();
+		if (NULL == mdid_inverse_op || !mdid_inverse_op->IsValid())
+		{
+			return (Expr *) subplan;
+		}
+		md_scalar_op = m_md_accessor->RetrieveScOp(mdid_inverse_op);
+	}
+
+	// the combining operator must be hashable and strict, see hash_ok_operator
+	Oid opno = CMDIdGPDB::CastMdid(md_scalar_op->MDId())->Oid();
+	Oid left_type = gpdb::ExprType((Node *) gpdb::ListNth(op_expr->args, 0));
+	if (!md_scalar_op->ReturnsNullOnNullInput() ||
+		!gpdb::IsOpHashJoinable(opno, left_type))
+	{
+		return (Expr *) subplan;
+	}
+
+	subplan->useHashTable = true;
+
+	if (ANY_SUBLINK == subplan->subLinkType)
+	{
+		return (Expr *) subplan;
+	}
+
+	op_expr->opno = opno;
+	op_expr->opfuncid = CMDIdGPDB::CastMdid(md_scalar_op->FuncMdId())->Oid();
+	subplan->subLinkType = ANY_SUBLINK;
+
+	BoolExpr *not_expr = MakeNode(BoolExpr);
+	not_expr->boolop = NOT_EXPR;
+	not_expr->args = gpdb::LAppend(NIL, subplan);
+	not_expr->location = -1;
+
+	return (Expr *) not_expr;
 }
 
 inline BOOL FDXLCastedId(CDXLNode *dxl_node)
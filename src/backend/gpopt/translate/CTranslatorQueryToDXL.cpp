@@ -65,6 +65,8 @@ extern bool optimizer_enable_dml;
 extern bool optimizer_enable_dml_triggers;
 extern bool optimizer_enable_dml_constraints;
 extern bool optimizer_enable_multiple_distinct_aggs;
+extern bool optimizer_enable_rollup_agg;
+extern bool optimizer_enable_shared_subqueries;
 
 // OIDs of variants of LEAD window function
 static const OID lead_func_oids[] =
@@ -225,6 +227,11 @@ CTranslatorQueryToDXL::CTranslatorQueryToDXL
 	// first normalize the query
 	m_query = CQueryMutators::NormalizeQuery(m_mp, m_md_accessor, query, query_level);
 
+	if (optimizer_enable_shared_subqueries)
+	{
+		PromoteSharedSubqueriesToCTEs();
+	}
+
 	if (NULL != m_query->cteList)
 	{
 		ConstructCTEProducerList(m_query->cteList, query_level);
@@ -2266,7 +2273,20 @@ CTranslatorQueryToDXL::TranslateGroupingSets
 		
 		return result_dxlnode;
 	}
-	
+
+	// The union below aggregates the input once per grouping set. When some
+	// of the grouping sets nest, leave the query to the planner, whose rollup
+	// aggregates compute a whole chain of nested grouping sets in one pass.
+	if (optimizer_enable_rollup_agg &&
+		CTranslatorUtils::GetNumRollupsForGroupingSets(m_mp, bitset_array) < num_of_grouping_sets)
+	{
+		bitset_array->Release();
+		unique_grp_cols_bitset->Release();
+		grpcol_index_to_colid_mapping->Release();
+
+		GPOS_RAISE(gpdxl::ExmaDXL, gpdxl::ExmiQuery2DXLUnsupportedFeature, GPOS_WSZ_LIT("Grouping sets that nest into rollups"));
+	}
+
 	CDXLNode *result_dxlnode = CreateDXLUnionAllForGroupingSets
 			(
 			from_expr,
@@ -2524,50 +2544,66 @@ CTranslatorQueryToDXL::TranslateSetOpToDXL
 
 	EdxlSetOpType setop_type = CTranslatorUtils::GetSetOpType(psetopstmt->op, psetopstmt->all);
 
-	// translate the left and right child
-	ULongPtrArray *leftchild_array = GPOS_NEW(m_mp) ULongPtrArray(m_mp);
-	ULongPtrArray *rightchild_array = GPOS_NEW(m_mp) ULongPtrArray(m_mp);
-	IMdIdArray *mdid_array_leftchild = GPOS_NEW(m_mp) IMdIdArray(m_mp);
-	IMdIdArray *mdid_array_rightchild = GPOS_NEW(m_mp) IMdIdArray(m_mp);
+	// a chain of unions of the same kind is translated into a single set
+	// operation over all of their inputs
+	List *inputs = FlattenSetOpInputs(psetopstmt);
+	GPOS_ASSERT(2 <= gpdb::ListLength(inputs));
+
+	ULongPtr2dArray *input_colids = GPOS_NEW(m_mp) ULongPtr2dArray(m_mp);
+	CDXLNodeArray *children_dxlnodes = GPOS_NEW(m_mp) CDXLNodeArray(m_mp);
+	IMdIdArray *mdid_array_firstchild = NULL;
+	BOOL is_cast_across_input = false;
+
+	ListCell *lc_input = NULL;
+	ForEach (lc_input, inputs)
+	{
+		ULongPtrArray *child_array = GPOS_NEW(m_mp) ULongPtrArray(m_mp);
+		IMdIdArray *mdid_array_child = GPOS_NEW(m_mp) IMdIdArray(m_mp);
+
+		CDXLNode *child_dxlnode = TranslateSetOpChild((Node *) lfirst(lc_input), child_array, mdid_array_child, target_list);
+		input_colids->Append(child_array);
+		children_dxlnodes->Append(child_dxlnode);
 
-	CDXLNode *left_child_dxlnode = TranslateSetOpChild(psetopstmt->larg, leftchild_array, mdid_array_leftchild, target_list);
-	CDXLNode *right_child_dxlnode = TranslateSetOpChild(psetopstmt->rarg, rightchild_array, mdid_array_rightchild, target_list);
+		// once an input needs a cast, the others need not be checked
+		is_cast_across_input = is_cast_across_input || SetOpNeedsCast(target_list, mdid_array_child);
 
-	// mark outer references in input columns from left child
-	ULONG *colid = GPOS_NEW_ARRAY(m_mp, ULONG, leftchild_array->Size());
-	BOOL *outer_ref_array = GPOS_NEW_ARRAY(m_mp, BOOL, leftchild_array->Size());
-	const ULONG size = leftchild_array->Size();
+		if (NULL == mdid_array_firstchild)
+		{
+			mdid_array_firstchild = mdid_array_child;
+		}
+		else
+		{
+			mdid_array_child->Release();
+		}
+	}
+	gpdb::ListFree(inputs);
+
+	// mark outer references in input columns from the first child
+	ULongPtrArray *firstchild_array = (*input_colids)[0];
+	ULONG *colid = GPOS_NEW_ARRAY(m_mp, ULONG, firstchild_array->Size());
+	BOOL *outer_ref_array = GPOS_NEW_ARRAY(m_mp, BOOL, firstchild_array->Size());
+	const ULONG size = firstchild_array->Size();
 	for (ULONG ul = 0; ul < size; ul++)
 	{
-		colid[ul] =  *(*leftchild_array)[ul];
+		colid[ul] =  *(*firstchild_array)[ul];
 		outer_ref_array[ul] = true;
 	}
-	CTranslatorUtils::MarkOuterRefs(colid, outer_ref_array, size, left_child_dxlnode);
+	CTranslatorUtils::MarkOuterRefs(colid, outer_ref_array, size, (*children_dxlnodes)[0]);
 
-	ULongPtr2dArray *input_colids = GPOS_NEW(m_mp) ULongPtr2dArray(m_mp);
-	input_colids->Append(leftchild_array);
-	input_colids->Append(rightchild_array);
-	
 	ULongPtrArray *output_colids =  CTranslatorUtils::GenerateColIds
 												(
 												m_mp,
 												target_list,
-												mdid_array_leftchild,
-												leftchild_array,
+												mdid_array_firstchild,
+												firstchild_array,
 												outer_ref_array,
 												m_context->m_colid_counter
 												);
- 	GPOS_ASSERT(output_colids->Size() == leftchild_array->Size());
+ 	GPOS_ASSERT(output_colids->Size() == firstchild_array->Size());
 
  	GPOS_DELETE_ARRAY(colid);
  	GPOS_DELETE_ARRAY(outer_ref_array);
 
-	BOOL is_cast_across_input = SetOpNeedsCast(target_list, mdid_array_leftchild) || SetOpNeedsCast(target_list, mdid_array_rightchild);
-	
-	CDXLNodeArray *children_dxlnodes  = GPOS_NEW(m_mp) CDXLNodeArray(m_mp);
-	children_dxlnodes->Append(left_child_dxlnode);
-	children_dxlnodes->Append(right_child_dxlnode);
-
 	CDXLNode *dxlnode = CreateDXLSetOpFromColumns
 						(
 						setop_type,
@@ -2602,12 +2638,83 @@ CTranslatorQueryToDXL::TranslateSetOpToDXL
 
 	// clean up
 	output_colids->Release();
-	mdid_array_leftchild->Release();
-	mdid_array_rightchild->Release();
+	mdid_array_firstchild->Release();
 
 	return dxlnode;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::FlattenSetOpInputs
+//
+//	@doc:
+//		Return the inputs of a set operation, in order. The inputs of union
+//		operations of the same kind below a union are its inputs too, so
+//		that a query with thousands of UNION ALL branches, which the parser
+//		turns into a left-deep chain, becomes a single set operation. The
+//		chain is walked iteratively, prepending the right input of each
+//		level, so that it takes linear time and no stack per branch.
+//
+//---------------------------------------------------------------------------
+List *
+CTranslatorQueryToDXL::FlattenSetOpInputs
+	(
+	SetOperationStmt *setop_stmt
+	)
+	const
+{
+	if (SETOP_UNION != setop_stmt->op)
+	{
+		return ListMake2(setop_stmt->larg, setop_stmt->rarg);
+	}
+
+	List *inputs = NIL;
+	Node *node = (Node *) setop_stmt;
+	while (IsSameSetOp(node, setop_stmt))
+	{
+		SetOperationStmt *child_setop_stmt = (SetOperationStmt *) node;
+
+		if (IsSameSetOp(child_setop_stmt->rarg, setop_stmt))
+		{
+			// parenthesized on the right, which is rare
+			List *rarg_inputs = FlattenSetOpInputs((SetOperationStmt *) child_setop_stmt->rarg);
+			inputs = gpdb::ListConcat(rarg_inputs, inputs);
+		}
+		else
+		{
+			inputs = gpdb::LPrepend(child_setop_stmt->rarg, inputs);
+		}
+
+		node = child_setop_stmt->larg;
+	}
+
+	return gpdb::LPrepend(node, inputs);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::IsSameSetOp
+//
+//	@doc:
+//		Is the node a set operation of the same kind as the given one
+//
+//---------------------------------------------------------------------------
+BOOL
+CTranslatorQueryToDXL::IsSameSetOp
+	(
+	Node *node,
+	SetOperationStmt *setop_stmt
+	)
+{
+	if (!IsA(node, SetOperationStmt))
+	{
+		return false;
+	}
+
+	SetOperationStmt *other_setop_stmt = (SetOperationStmt *) node;
+	return other_setop_stmt->op == setop_stmt->op && other_setop_stmt->all == setop_stmt->all;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorQueryToDXL::PdxlSetOp
@@ -4391,6 +4498,132 @@ CTranslatorQueryToDXL::ConstructCTEProducerList
 	}
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::IsShareableSubquery
+//
+//	@doc:
+//		Can the derived table of the range table entry be computed once for
+//		all of its occurrences in the query: it is not lateral, does not
+//		refer to the enclosing queries and has no volatile functions
+//
+//---------------------------------------------------------------------------
+BOOL
+CTranslatorQueryToDXL::IsShareableSubquery
+	(
+	const RangeTblEntry *rte
+	)
+{
+	if (RTE_SUBQUERY != rte->rtekind || rte->lateral || rte->security_barrier)
+	{
+		return false;
+	}
+
+	Query *subquery = rte->subquery;
+
+	return CMD_SELECT == subquery->commandType &&
+		NULL == subquery->rowMarks &&
+		!subquery->hasModifyingCTE &&
+		!gpdb::ContainsVarsOfLevelOrAbove((Node *) subquery, 1) &&
+		!gpdb::ContainsVolatileFunctions((Node *) subquery);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::PromoteSharedSubqueriesToCTEs
+//
+//	@doc:
+//		Turn the derived tables of the query that occur more than once, for
+//		instance when the same view is joined twice, into references to a
+//		common table expression added to the CTE list of the query, so that
+//		the optimizer can choose between computing them once and inlining
+//		them, as it does for a WITH clause
+//
+//---------------------------------------------------------------------------
+void
+CTranslatorQueryToDXL::PromoteSharedSubqueriesToCTEs()
+{
+	// the inputs of a set operation are translated as derived tables
+	if (CMD_SELECT != m_query->commandType || NULL != m_query->setOperations)
+	{
+		return;
+	}
+
+	ListCell *lc = NULL;
+	ULONG rt_index = 0;
+
+	ForEach (lc, m_query->rtable)
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+		rt_index++;
+
+		if (!IsShareableSubquery(rte))
+		{
+			continue;
+		}
+
+		// find the later occurrences of the same derived table; equal()
+		// doesn't compare the locations in the query text
+		List *occurrences = NIL;
+		for (ListCell *lc_other = lnext(lc); NULL != lc_other; lc_other = lnext(lc_other))
+		{
+			RangeTblEntry *rte_other = (RangeTblEntry *) lfirst(lc_other);
+
+			if (IsShareableSubquery(rte_other) &&
+				gpdb::Equals(rte->subquery, rte_other->subquery))
+			{
+				occurrences = gpdb::LAppend(occurrences, rte_other);
+			}
+		}
+
+		if (NIL == occurrences)
+		{
+			continue;
+		}
+
+		CHAR cte_name[NAMEDATALEN];
+		snprintf(cte_name, sizeof(cte_name), "shared_subquery_%u", rt_index);
+
+		BOOL is_name_taken = false;
+		ListCell *lc_cte = NULL;
+		ForEach (lc_cte, m_query->cteList)
+		{
+			CommonTableExpr *cte = (CommonTableExpr *) lfirst(lc_cte);
+			is_name_taken = is_name_taken || (0 == strcmp(cte->ctename, cte_name));
+		}
+
+		if (is_name_taken)
+		{
+			gpdb::ListFree(occurrences);
+			continue;
+		}
+
+		CommonTableExpr *cte = MakeNode(CommonTableExpr);
+		cte->ctename = PStrDup(cte_name);
+		cte->ctequery = (Node *) rte->subquery;
+		cte->cterecursive = false;
+		cte->cterefcount = gpdb::ListLength(occurrences) + 1;
+		cte->ctecolnames = (List *) gpdb::CopyObject(rte->eref->colnames);
+		m_query->cteList = gpdb::LAppend(m_query->cteList, cte);
+
+		occurrences = gpdb::LPrepend(rte, occurrences);
+
+		ListCell *lc_occurrence = NULL;
+		ForEach (lc_occurrence, occurrences)
+		{
+			RangeTblEntry *rte_cte = (RangeTblEntry *) lfirst(lc_occurrence);
+
+			rte_cte->rtekind = RTE_CTE;
+			rte_cte->subquery = NULL;
+			rte_cte->ctename = cte->ctename;
+			rte_cte->ctelevelsup = 0;
+			rte_cte->self_reference = false;
+		}
+
+		gpdb::ListFree(occurrences);
+	}
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorQueryToDXL::ConstructCTEAnchors
@@ -412,9 +412,7 @@ CTranslatorRelcacheToDXL::RetrievePartTableIndexInfo
 		LogicalIndexInfo *index_info = (logical_indexes->logicalIndexInfo)[ul];
 		index_info_list = gpdb::LAppend(index_info_list, index_info);
 	}
-	
-	gpdb::GPDBFree(logical_indexes);
-	
+
 	return index_info_list;
 }
 
@@ -743,7 +741,14 @@ CTranslatorRelcacheToDXL::RetrieveRelColumns
 {
 	CMDColumnArray *mdcol_array = GPOS_NEW(mp) CMDColumnArray(mp);
 
-	for (ULONG ul = 0;  ul < (ULONG) rel->rd_att->natts; ul++)
+	// look up the statistics widths and default values of all columns at once,
+	// instead of crossing the wrapper boundary several times per column
+	const ULONG num_atts = (ULONG) rel->rd_att->natts;
+	int32 *stats_widths = GPOS_NEW_ARRAY(mp, int32, num_atts + 1);
+	Node **defaults = GPOS_NEW_ARRAY(mp, Node *, num_atts + 1);
+	gpdb::GetRelAttrWidthsAndDefaults(rel, stats_widths, defaults);
+
+	for (ULONG ul = 0;  ul < num_atts; ul++)
 	{
 		Form_pg_attribute att = rel->rd_att->attrs[ul];
 		CMDName *md_colname = CDXLUtils::CreateMDNameFromCharArray(mp, NameStr(att->attname));
@@ -751,29 +756,31 @@ CTranslatorRelcacheToDXL::RetrieveRelColumns
 		// translate the default column value
 		CDXLNode *dxl_default_col_val = NULL;
 		
-		if (!att->attisdropped)
+		if (NULL != defaults[ul])
 		{
-			dxl_default_col_val = GetDefaultColumnValue(mp, md_accessor, rel->rd_att, att->attnum);
+			dxl_default_col_val = CTranslatorScalarToDXL::TranslateStandaloneExprToDXL
+									(
+									mp,
+									md_accessor,
+									NULL, /* var_colid_mapping --- subquery or external variable are not supported in default expression */
+									(Expr *) defaults[ul]
+									);
 		}
 
 		ULONG col_len = gpos::ulong_max;
 		CMDIdGPDB *mdid_col = GPOS_NEW(mp) CMDIdGPDB(att->atttypid);
-		HeapTuple stats_tup = gpdb::GetAttStats(rel->rd_id, ul+1);
 
 		// Column width priority:
 		// 1. If there is average width kept in the stats for that column, pick that value.
 		// 2. If not, if it is a fixed length text type, pick the size of it. E.g if it is
 		//    varchar(10), assign 10 as the column length.
 		// 3. Else if it not dropped and a fixed length type such as int4, assign the fixed
-		//    length.
+		//    length, which is the length of the type kept in the attribute.
 		// 4. Otherwise, assign it to default column width which is 8.
-		if(HeapTupleIsValid(stats_tup))
+		if (0 <= stats_widths[ul])
 		{
-			Form_pg_statistic form_pg_stats = (Form_pg_statistic) GETSTRUCT(stats_tup);
-
 			// column width
-			col_len = form_pg_stats->stawidth;
-			gpdb::FreeHeapTuple(stats_tup);
+			col_len = (ULONG) stats_widths[ul];
 		}
 		else if ((mdid_col->Equals(&CMDIdGPDB::m_mdid_bpchar) || mdid_col->Equals(&CMDIdGPDB::m_mdid_varchar)) && (VARHDRSZ < att->atttypmod))
 		{
@@ -784,14 +791,9 @@ CTranslatorRelcacheToDXL::RetrieveRelColumns
 			DOUBLE width = CStatistics::DefaultColumnWidth.Get();
 			col_len = (ULONG) width;
 
-			if (!att->attisdropped)
+			if (!att->attisdropped && 0 < att->attlen)
 			{
-				IMDType *md_type = CTranslatorRelcacheToDXL::RetrieveType(mp, mdid_col);
-				if(md_type->IsFixedLength())
-				{
-					col_len = md_type->Length();
-				}
-				md_type->Release();
+				col_len = (ULONG) att->attlen;
 			}
 		}
 
@@ -810,6 +812,9 @@ CTranslatorRelcacheToDXL::RetrieveRelColumns
 		mdcol_array->Append(md_col);
 	}
 
+	GPOS_DELETE_ARRAY(stats_widths);
+	GPOS_DELETE_ARRAY(defaults);
+
 	// add system columns
 	if (RelHasSystemColumns(rel->rd_rel->relkind))
 	{
@@ -821,63 +826,6 @@ CTranslatorRelcacheToDXL::RetrieveRelColumns
 	return mdcol_array;
 }
 
-//---------------------------------------------------------------------------
-//	@function:
-//		CTranslatorRelcacheToDXL::GetDefaultColumnValue
-//
-//	@doc:
-//		Return the dxl representation of column's default value
-//
-//---------------------------------------------------------------------------
-CDXLNode *
-CTranslatorRelcacheToDXL::GetDefaultColumnValue
-	(
-	CMemoryPool *mp,
-	CMDAccessor *md_accessor,
-	TupleDesc rd_att,
-	AttrNumber attno
-	)
-{
-	GPOS_ASSERT(attno > 0);
-
-	Node *node = NULL;
-
-	// Scan to see if relation has a default for this column
-	if (NULL != rd_att->constr && 0 < rd_att->constr->num_defval)
-	{
-		AttrDefault *defval = rd_att->constr->defval;
-		INT	num_def = rd_att->constr->num_defval;
-
-		GPOS_ASSERT(NULL != defval);
-		for (ULONG ul = 0; ul < (ULONG) num_def; ul++)
-		{
-			if (attno == defval[ul].adnum)
-			{
-				// found it, convert string representation to node tree.
-				node = gpdb::StringToNode(defval[ul].adbin);
-				break;
-			}
-		}
-	}
-
-	if (NULL == node)
-	{
-		// get the default value for the type
-		Form_pg_attribute att_tup = rd_att->attrs[attno - 1];
-		node = gpdb::GetTypeDefault(att_tup->atttypid);
-	}
-
-	if (NULL == node)
-	{
-		return NULL;
-	}
-
-	// translate the default value expression
-	return CTranslatorScalarToDXL::TranslateStandaloneExprToDXL(mp, md_accessor,
-								    NULL, /* var_colid_mapping --- subquery or external variable are not supported in default expression */
-								    (Expr *) node);
-}
-
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorRelcacheToDXL::GetRelDistribution
@@ -1098,13 +1046,7 @@ CTranslatorRelcacheToDXL::RetrieveIndex
 	
 		if (md_rel->IsPartitioned())
 		{
-			LogicalIndexes *logical_indexes = gpdb::GetLogicalPartIndexes(rel_oid);
-			GPOS_ASSERT(NULL != logical_indexes);
-
-			IMDIndex *index = RetrievePartTableIndex(mp, md_accessor, mdid_index, md_rel, logical_indexes);
-
-			// cleanup
-			gpdb::GPDBFree(logical_indexes);
+			IMDIndex *index = RetrievePartTableIndex(mp, md_accessor, mdid_index, md_rel);
 
 			if (NULL != index)
 			{
@@ -1187,7 +1129,8 @@ CTranslatorRelcacheToDXL::RetrieveIndex
 //
 //	@doc:
 //		Retrieve an index over a partitioned table from the relcache given its 
-//		mdid
+//		mdid. The logical indexes of the table are shared with its relation,
+//		see gpdb::GetLogicalPartIndexes
 //
 //---------------------------------------------------------------------------
 IMDIndex *
@@ -1196,16 +1139,13 @@ CTranslatorRelcacheToDXL::RetrievePartTableIndex
 	CMemoryPool *mp,
 	CMDAccessor *md_accessor,
 	IMDId *mdid_index,
-	const IMDRelation *md_rel,
-	LogicalIndexes *logical_indexes
+	const IMDRelation *md_rel
 	)
 {
-	GPOS_ASSERT(NULL != logical_indexes);
-	GPOS_ASSERT(0 < logical_indexes->numLogicalIndexes);
-	
+	OID rel_oid = CMDIdGPDB::CastMdid(md_rel->MDId())->Oid();
 	OID oid = CMDIdGPDB::CastMdid(mdid_index)->Oid();
 	
-	LogicalIndexInfo *index_info = LookupLogicalIndexById(logical_indexes, oid);
+	LogicalIndexInfo *index_info = gpdb::GetLogicalPartIndexInfo(rel_oid, oid);
 	if (NULL == index_info)
 	{
 		 return NULL;
@@ -1214,38 +1154,6 @@ CTranslatorRelcacheToDXL::RetrievePartTableIndex
 	return RetrievePartTableIndex(mp, md_accessor, index_info, mdid_index, md_rel);
 }
 
-//---------------------------------------------------------------------------
-//	@function:
-//		CTranslatorRelcacheToDXL::LookupLogicalIndexById
-//
-//	@doc:
-//		Lookup an index given its id from the logical indexes structure
-//
-//---------------------------------------------------------------------------
-LogicalIndexInfo *
-CTranslatorRelcacheToDXL::LookupLogicalIndexById
-	(
-	LogicalIndexes *logical_indexes,
-	OID oid
-	)
-{
-	GPOS_ASSERT(NULL != logical_indexes && 0 <= logical_indexes->numLogicalIndexes);
-	
-	const ULONG num_index = logical_indexes->numLogicalIndexes;
-	
-	for (ULONG ul = 0; ul < num_index; ul++)
-	{
-		LogicalIndexInfo *index_info = (logical_indexes->logicalIndexInfo)[ul];
-		
-		if (oid == index_info->logicalIndexOid)
-		{
-			return index_info;
-		}
-	}
-	
-	return NULL;
-}
-
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorRelcacheToDXL::RetrievePartTableIndex
@@ -2281,6 +2189,14 @@ CTranslatorRelcacheToDXL::RetrieveRelStats
 
 		num_rows = gpdb::CdbEstimatePartitionedNumTuples(rel, &stats_empty);
 
+		// scans of EXPLAIN ANALYZE may have seen more rows than the estimate,
+		// the statistics are stale then
+		double feedback_rows = 0.0;
+		if (gpdb::GetCardinalityFeedback(rel_oid, &feedback_rows) && feedback_rows > num_rows)
+		{
+			num_rows = feedback_rows;
+		}
+
 		m_rel_stats_mdid->AddRef();
 		gpdb::CloseRelation(rel);
 	}
@@ -2346,6 +2262,8 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 	// extract column name and type
 	CMDName *md_colname = GPOS_NEW(mp) CMDName(mp, md_col->Mdname().GetMDName());
 	OID att_type = CMDIdGPDB::CastMdid(md_col->MdidType())->Oid();
+	// the histogram bounds are sorted in the collation of the column
+	OID att_collation = (0 < attno) ? rel->rd_att->attrs[attno - 1]->attcollation : InvalidOid;
 	gpdb::CloseRelation(rel);
 
 	CDXLBucketArray *dxl_stats_bucket_array = GPOS_NEW(mp) CDXLBucketArray(mp);
@@ -2366,9 +2284,40 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 				);
 	}
 
+	// the NDV of a partitioned table is merged from the HLL counters of its
+	// leaves, so it's as recent as their last ANALYZE even if the root's
+	// statistics are older or missing
+	float4 leaf_null_freq = 0.0;
+	int32 leaf_width = 0;
+	double leaf_num_distinct = -1;
+	if (gpdb::RelPartIsRoot(rel_oid))
+	{
+		leaf_num_distinct = gpdb::MergeLeafNDistinct(rel_oid, attno, &leaf_null_freq, &leaf_width);
+	}
+
 	// extract out histogram and mcv information from pg_statistic
 	HeapTuple stats_tup = gpdb::GetAttStats(rel_oid, attno);
 
+	// if there is no colstats, use the NDV of the leaves if there is one
+	if (!HeapTupleIsValid(stats_tup) && 0 <= leaf_num_distinct)
+	{
+		CDouble leaf_freq = CDouble(1.0) - CDouble(leaf_null_freq);
+
+		mdid_col_stats->AddRef();
+		return GPOS_NEW(mp) CDXLColStats
+							(
+							mp,
+							mdid_col_stats,
+							md_colname,
+							CDouble(leaf_width),
+							CDouble(leaf_null_freq),
+							CDouble(leaf_num_distinct).Ceil(),
+							std::max(CDouble(0.0), leaf_freq),
+							dxl_stats_bucket_array,
+							false /* is_col_stats_missing */
+							);
+	}
+
 	// if there is no colstats
 	if (!HeapTupleIsValid(stats_tup))
 	{
@@ -2405,7 +2354,11 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 
 	// calculate total number of distinct values
 	CDouble num_distinct(1.0);
-	if (form_pg_stats->stadistinct < 0)
+	if (0 <= leaf_num_distinct)
+	{
+		num_distinct = CDouble(leaf_num_distinct);
+	}
+	else if (form_pg_stats->stadistinct < 0)
 	{
 		GPOS_ASSERT(form_pg_stats->stadistinct > -1.01);
 		num_distinct = num_rows * (1 - null_freq ) * CDouble(-form_pg_stats->stadistinct);
@@ -2519,6 +2472,7 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 	(
 	 mp,
 	 att_type,
+	 att_collation,
 	 num_distinct,
 	 null_freq,
 	 mcv_slot.values,
@@ -2834,6 +2788,7 @@ CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 	(
 	CMemoryPool *mp,
 	OID att_type,
+	OID att_collation,
 	CDouble num_distinct,
 	CDouble null_freq,
 	const Datum *mcv_values,
@@ -2853,7 +2808,8 @@ CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 							md_type,
 							mcv_values,
 							mcv_frequencies,
-							num_mcv_values
+							num_mcv_values,
+							att_collation
 							);
 
 	GPOS_ASSERT(gpdb_mcv_hist->IsValid());
@@ -2867,10 +2823,7 @@ CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 		hist_freq = CDouble(1.0) - null_freq - mcv_freq;
 	}
 	
-	BOOL is_text_type = mdid_atttype->Equals(&CMDIdGPDB::m_mdid_varchar)
-			 || mdid_atttype->Equals(&CMDIdGPDB::m_mdid_bpchar)
-			 || mdid_atttype->Equals(&CMDIdGPDB::m_mdid_text);
-	BOOL has_hist = !is_text_type && 1 < num_hist_values && CStatistics::Epsilon < hist_freq;
+	BOOL has_hist = 1 < num_hist_values && CStatistics::Epsilon < hist_freq;
 
 	CHistogram *histogram = NULL;
 
@@ -2885,7 +2838,8 @@ CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 						hist_values,
 						num_hist_values,
 						num_distinct,
-						hist_freq
+						hist_freq,
+						att_collation
 						);
 		if (0 == histogram->Buckets())
 		{
@@ -2947,7 +2901,8 @@ CTranslatorRelcacheToDXL::TransformMcvToOrcaHistogram
 	const IMDType *md_type,
 	const Datum *mcv_values,
 	const float4 *mcv_frequencies,
-	ULONG num_mcv_values
+	ULONG num_mcv_values,
+	OID collation
 	)
 {
 	IDatumArray *datums = GPOS_NEW(mp) IDatumArray(mp);
@@ -2956,7 +2911,7 @@ CTranslatorRelcacheToDXL::TransformMcvToOrcaHistogram
 	for (ULONG ul = 0; ul < num_mcv_values; ul++)
 	{
 		Datum datumMCV = mcv_values[ul];
-		IDatum *datum = CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum(mp, md_type, false /* is_null */, datumMCV);
+		IDatum *datum = CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum(mp, md_type, false /* is_null */, datumMCV, collation);
 		datums->Append(datum);
 		freqs->Append(GPOS_NEW(mp) CDouble(mcv_frequencies[ul]));
 
@@ -3000,7 +2955,8 @@ CTranslatorRelcacheToDXL::TransformHistToOrcaHistogram
 	const Datum *hist_values,
 	ULONG num_hist_values,
 	CDouble num_distinct,
-	CDouble hist_freq
+	CDouble hist_freq,
+	OID collation
 	)
 {
 	GPOS_ASSERT(1 < num_hist_values);
@@ -3014,8 +2970,8 @@ CTranslatorRelcacheToDXL::TransformHistToOrcaHistogram
 	CBucketArray *buckets = GPOS_NEW(mp) CBucketArray(mp);
 	for (ULONG ul = 0; ul < num_buckets; ul++)
 	{
-		IDatum *min_datum = CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum(mp, md_type, false /* is_null */, hist_values[ul]);
-		IDatum *max_datum = CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum(mp, md_type, false /* is_null */, hist_values[ul + 1]);
+		IDatum *min_datum = CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum(mp, md_type, false /* is_null */, hist_values[ul], collation);
+		IDatum *max_datum = CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum(mp, md_type, false /* is_null */, hist_values[ul + 1], collation);
 		BOOL is_lower_closed, is_upper_closed;
 
 		if (min_datum->StatsAreEqual(max_datum))
@@ -3060,7 +3016,8 @@ CTranslatorRelcacheToDXL::TransformHistToOrcaHistogram
 		if (!min_datum->StatsAreComparable(max_datum) || !min_datum->StatsAreLessThan(max_datum))
 		{
 			// if less than operation is not supported on this datum,
-			// or the translated histogram does not conform to GPDB sort order (e.g. text column in Linux platform),
+			// or the translated histogram does not conform to GPDB sort order (e.g. text values
+			// sharing the prefix of their sort keys),
 			// then no point building a histogram. return an empty histogram
 
 			// TODO: 03/01/2014 translate histogram into Orca even if sort
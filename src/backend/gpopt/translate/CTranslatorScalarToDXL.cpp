@@ -654,7 +654,8 @@ CTranslatorScalarToDXL::TranslateConstToDXL
  	// translate gpdb datum into a DXL datum
 	CDXLDatum *datum_dxl = CTranslatorScalarToDXL::TranslateDatumToDXL(mp, md_type, constant->consttypmod, constant->constisnull,
 															 constant->constlen,
-															 constant->constvalue);
+															 constant->constvalue,
+															 constant->constcollid);
 
 	return datum_dxl;
 }
@@ -2097,7 +2098,8 @@ CTranslatorScalarToDXL::TranslateDatumToDXL
 	INT type_modifier,
 	BOOL is_null,
 	ULONG len,
-	Datum datum
+	Datum datum,
+	OID collation
 	)
 {
 	static const SDXLDatumTranslatorElem translators[] =
@@ -2125,7 +2127,7 @@ CTranslatorScalarToDXL::TranslateDatumToDXL
 	if (NULL == func_ptr)
 	{
 		// generate a datum of generic type
-		return TranslateGenericDatumToDXL(mp, md_type, type_modifier, is_null, len, datum);
+		return TranslateGenericDatumToDXL(mp, md_type, type_modifier, is_null, len, datum, collation);
 	}
 	else
 	{
@@ -2148,7 +2150,8 @@ CTranslatorScalarToDXL::TranslateGenericDatumToDXL
 	INT type_modifier,
 	BOOL is_null,
 	ULONG len,
-	Datum datum
+	Datum datum,
+	OID collation
 	)
 {
 	CMDIdGPDB *mdid_old = CMDIdGPDB::CastMdid(md_type->MDId());
@@ -2171,7 +2174,7 @@ CTranslatorScalarToDXL::TranslateGenericDatumToDXL
 	LINT lint_value = 0;
 	if (CMDTypeGenericGPDB::HasByte2IntMapping(mdid))
 	{
-		lint_value = ExtractLintValueFromDatum(mdid, is_null, bytes, length);
+		lint_value = ExtractLintValueFromDatum(mdid, is_null, bytes, length, collation);
 	}
 
 	return CMDTypeGenericGPDB::CreateDXLDatumVal(mp, mdid, type_modifier, is_const_by_val, is_null, bytes, length, lint_value, double_value);
@@ -2432,7 +2435,8 @@ CTranslatorScalarToDXL::ExtractLintValueFromDatum
 	IMDId *mdid,
 	BOOL is_null,
 	BYTE *bytes,
-	ULONG length
+	ULONG length,
+	OID collation
 	)
 {
 	GPOS_ASSERT(CMDTypeGenericGPDB::HasByte2IntMapping(mdid));
@@ -2454,25 +2458,14 @@ CTranslatorScalarToDXL::ExtractLintValueFromDatum
 	}
 	else
 	{
-		// use hash value
-		ULONG hash = 0;
-		if (is_null)
-		{
-			hash = gpos::HashValue<ULONG>(&hash);
-		}
-		else
-		{
-			if (mdid->Equals(&CMDIdGPDB::m_mdid_bpchar))
-			{
-				hash = gpdb::HashBpChar((Datum) bytes);
-			}
-			else
-			{
-				hash = gpdb::HashText((Datum) bytes);
-			}
-		}
-
-		lint_value = (LINT) hash;
+		// use a key that sorts like the values, so that the histograms of
+		// text columns can be used
+		lint_value = (LINT) gpdb::TextStatsKey
+									(
+									(Datum) bytes,
+									mdid->Equals(&CMDIdGPDB::m_mdid_bpchar),
+									collation
+									);
 	}
 
 	return lint_value;
@@ -2492,7 +2485,8 @@ CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum
 	CMemoryPool *mp,
 	const IMDType *md_type,
 	BOOL is_null,
-	Datum gpdb_datum
+	Datum gpdb_datum,
+	OID collation
 	)
 {
 	ULONG length = md_type->Length();
@@ -2503,7 +2497,7 @@ CTranslatorScalarToDXL::CreateIDatumFromGpdbDatum
 	}
 	GPOS_ASSERT(is_null || length > 0);
 
-	CDXLDatum *datum_dxl = CTranslatorScalarToDXL::TranslateDatumToDXL(mp, md_type, gpmd::default_type_modifier, is_null, length, gpdb_datum);
+	CDXLDatum *datum_dxl = CTranslatorScalarToDXL::TranslateDatumToDXL(mp, md_type, gpmd::default_type_modifier, is_null, length, gpdb_datum, collation);
 	IDatum *datum = md_type->GetDatumForDXLDatum(mp, datum_dxl);
 	datum_dxl->Release();
 	return datum;
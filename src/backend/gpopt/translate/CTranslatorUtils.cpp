@@ -1221,6 +1221,71 @@ CTranslatorUtils::GetColumnAttnosForGroupBy
 	return col_attnos_arr;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorUtils::GetNumRollupsForGroupingSets
+//
+//	@doc:
+//		Count the rollups that cover the given grouping sets. A rollup is a
+//		chain of grouping sets where each one contains the next, such as
+//		(a,b) ==> (a) ==> (), and can be aggregated in one pass over input
+//		sorted on its largest grouping set. The sets are placed greedily,
+//		largest first, at the end of the first rollup whose smallest set
+//		contains them, so the count may exceed the minimum
+//
+//---------------------------------------------------------------------------
+ULONG
+CTranslatorUtils::GetNumRollupsForGroupingSets
+	(
+	CMemoryPool *mp,
+	CBitSetArray *grouping_sets
+	)
+{
+	GPOS_ASSERT(NULL != grouping_sets);
+
+	const ULONG num_grouping_sets = grouping_sets->Size();
+	ULONG max_size = 0;
+	for (ULONG ul = 0; ul < num_grouping_sets; ul++)
+	{
+		if (max_size < (*grouping_sets)[ul]->Size())
+		{
+			max_size = (*grouping_sets)[ul]->Size();
+		}
+	}
+
+	// the smallest grouping set of each rollup
+	CBitSet **rollup_tails = GPOS_NEW_ARRAY(mp, CBitSet *, num_grouping_sets);
+	ULONG num_rollups = 0;
+
+	for (ULONG size = max_size + 1; size > 0; size--)
+	{
+		for (ULONG ul = 0; ul < num_grouping_sets; ul++)
+		{
+			CBitSet *grouping_set = (*grouping_sets)[ul];
+			if (grouping_set->Size() != size - 1)
+			{
+				continue;
+			}
+
+			ULONG rollup = 0;
+			while (rollup < num_rollups && !rollup_tails[rollup]->ContainsAll(grouping_set))
+			{
+				rollup++;
+			}
+
+			if (rollup == num_rollups)
+			{
+				num_rollups++;
+			}
+			rollup_tails[rollup] = grouping_set;
+		}
+	}
+
+	GPOS_DELETE_ARRAY(rollup_tails);
+
+	return num_rollups;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorUtils::CreateGroupingSetsForRollup
@@ -51,6 +51,25 @@ CConstExprEvaluatorProxy::CEmptyMappingColIdVar::VarFromDXLNodeScId
 	return NULL;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CConstExprEvaluatorProxy::MakeConstValueNode
+//
+//	@doc:
+//		Return a DXL constant value of a GPDB Const. The Const is not
+//		released.
+//
+//---------------------------------------------------------------------------
+CDXLNode *
+CConstExprEvaluatorProxy::MakeConstValueNode
+	(
+	Const *constant
+	)
+{
+	CDXLDatum *datum_dxl = CTranslatorScalarToDXL::TranslateConstToDXL(m_mp, m_md_accessor, constant);
+	return GPOS_NEW(m_mp) CDXLNode(m_mp, GPOS_NEW(m_mp) CDXLScalarConstValue(m_mp, datum_dxl));
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CConstExprEvaluatorProxy::EvaluateExpr
@@ -70,23 +89,59 @@ CConstExprEvaluatorProxy::EvaluateExpr
 	Expr *expr = m_dxl2scalar_translator.TranslateDXLToScalar(dxl_expr, &m_emptymapcidvar);
 	GPOS_ASSERT(NULL != expr);
 
-	// Evaluate the expression
-	Expr *result = gpdb::EvaluateExpr(expr,
-						gpdb::ExprType((Node *)expr),
-						gpdb::ExprTypeMod((Node *)expr));
+	// A constant, or a binary compatible cast of one, is folded without the executor
+	if (IsA(expr, RelabelType) && IsA(((RelabelType *) expr)->arg, Const))
+	{
+		RelabelType *relabel = (RelabelType *) expr;
+		Const *constant = (Const *) relabel->arg;
+
+		constant->consttype = relabel->resulttype;
+		constant->consttypmod = relabel->resulttypmod;
+		constant->constcollid = relabel->resultcollid;
+
+		CDXLNode *dxl_result = MakeConstValueNode(constant);
+		gpdb::GPDBFree(constant);
+		gpdb::GPDBFree(expr);
+
+		return dxl_result;
+	}
 
-	if (!IsA(result, Const))
+	if (IsA(expr, Const))
+	{
+		CDXLNode *dxl_result = MakeConstValueNode((Const *) expr);
+		gpdb::GPDBFree(expr);
+
+		return dxl_result;
+	}
+
+	// Evaluate the expression, unless it was evaluated before
+	CHAR *key = gpdb::NodeToString(expr);
+	Const *const_result = m_evaluated_exprs->Find(key);
+
+	if (NULL == const_result)
+	{
+		Expr *result = gpdb::EvaluateExpr(expr,
+							gpdb::ExprType((Node *)expr),
+							gpdb::ExprTypeMod((Node *)expr));
+
+		if (!IsA(result, Const))
+		{
+			#ifdef GPOS_DEBUG
+			elog(NOTICE, "Expression did not evaluate to Const, but to an expression of type %d", result->type);
+			#endif
+			GPOS_RAISE(gpdxl::ExmaConstExprEval, gpdxl::ExmiConstExprEvalNonConst);
+		}
+
+		// the key and the result are kept for later lookups
+		const_result = (Const *) result;
+		m_evaluated_exprs->Insert(key, const_result);
+	}
+	else
 	{
-		#ifdef GPOS_DEBUG
-		elog(NOTICE, "Expression did not evaluate to Const, but to an expression of type %d", result->type);
-		#endif
-		GPOS_RAISE(gpdxl::ExmaConstExprEval, gpdxl::ExmiConstExprEvalNonConst);
+		gpdb::GPDBFree(key);
 	}
 
-	Const *const_result = (Const *)result;
-	CDXLDatum *datum_dxl = CTranslatorScalarToDXL::TranslateConstToDXL(m_mp, m_md_accessor, const_result);
-	CDXLNode *dxl_result = GPOS_NEW(m_mp) CDXLNode(m_mp, GPOS_NEW(m_mp) CDXLScalarConstValue(m_mp, datum_dxl));
-	gpdb::GPDBFree(result);
+	CDXLNode *dxl_result = MakeConstValueNode(const_result);
 	gpdb::GPDBFree(expr);
 
 	return dxl_result;
@@ -38,9 +38,11 @@
 
 #include "gpos/_api.h"
 #include "gpos/common/CAutoP.h"
+#include "gpos/common/CWallClock.h"
 #include "gpos/io/COstreamFile.h"
 #include "gpos/io/COstreamString.h"
 #include "gpos/memory/CAutoMemoryPool.h"
+#include "gpos/memory/CCacheAccessor.h"
 #include "gpos/task/CAutoTraceFlag.h"
 #include "gpos/common/CAutoP.h"
 
@@ -53,7 +55,9 @@
 #include "gpopt/engine/CCTEConfig.h"
 #include "gpopt/mdcache/CAutoMDAccessor.h"
 #include "gpopt/mdcache/CMDCache.h"
+#include "gpopt/mdcache/CMDKey.h"
 #include "gpopt/minidump/CMinidumperUtils.h"
+#include "gpopt/minidump/CSerializableOptimizerConfig.h"
 #include "gpopt/optimizer/COptimizer.h"
 #include "gpopt/optimizer/COptimizerConfig.h"
 #include "gpopt/xforms/CXformFactory.h"
@@ -65,6 +69,7 @@
 #include "naucrates/base/CQueryToDXLResult.h"
 
 #include "naucrates/md/IMDId.h"
+#include "naucrates/md/CMDIdColStats.h"
 #include "naucrates/md/CMDIdRelStats.h"
 
 #include "naucrates/md/CSystemId.h"
@@ -95,6 +100,9 @@ using namespace gpdbcost;
 // definition of default AutoMemoryPool
 #define AUTO_MEM_POOL(amp) CAutoMemoryPool amp(CAutoMemoryPool::ElcExc, CMemoryPoolManager::EatTracker, false /* fThreadSafe */)
 
+// AutoMemoryPool whose allocations beyond capacity bytes raise an out of memory error
+#define AUTO_MEM_POOL_LIMITED(amp, capacity) CAutoMemoryPool amp(CAutoMemoryPool::ElcExc, CMemoryPoolManager::EatTracker, false /* fThreadSafe */, capacity)
+
 // default id for the source system
 const CSystemId default_sysid(IMDId::EmdidGPDB, GPOS_WSZ_STR_LENGTH("GPDB"));
 
@@ -123,6 +131,108 @@ const ULONG expected_dxl_errors[] =
 		gpdxl::ExmiQuery2DXLNotNullViolation,	// not null violation
 	};
 
+// number of optimization failures after which the metadata cache was kept,
+// and after which it was rebuilt because it may be corrupt
+static ULLONG mdcache_num_kept = 0;
+static ULLONG mdcache_num_rebuilt = 0;
+
+// search strategy loaded from optimizer_search_strategy_path, kept across
+// queries in a memory pool of its own until the path changes
+static CMemoryPool *search_strategy_mp = NULL;
+static BOOL search_strategy_loaded = false;
+static CHAR *search_strategy_path = NULL;
+static CSearchStageArray *search_strategy_loaded_arr = NULL;
+
+// trace flags packed from the GUCs and the disabled xforms, kept across
+// queries in a memory pool of its own until either changes
+static CMemoryPool *trace_flags_mp = NULL;
+static CBitSet *trace_flags_packed = NULL;
+static uint64 trace_flags_guc_generation = 0;
+static ULLONG trace_flags_xform_generation = 0;
+
+// bumped whenever SetXform changes optimizer_xforms
+static ULLONG xform_generation = 0;
+
+// number of optimizations that ran out of the optimization time budget
+static ULLONG search_time_budget_num_hits = 0;
+
+// number of optimizations that ran out of optimizer_memory_limit
+static ULLONG memory_limit_num_hits = 0;
+
+// milliseconds since the timer was started, at microsecond resolution
+static double
+GetElapsedMS
+	(
+	CWallClock &timer
+	)
+{
+	return timer.ElapsedUS() / 1000.0;
+}
+
+// add the allocations made since the ones counted by *allocs and *alloc_bytes
+// to those of a phase, and make them the ones to count from
+static void
+AddPhaseAllocations
+	(
+	uint64 *allocs,
+	uint64 *alloc_bytes,
+	int64 *phase_allocs,
+	int64 *phase_alloc_bytes
+	)
+{
+	uint64 bytes;
+	uint64 num = gpdb::GetOptimizerAllocations(&bytes);
+
+	*phase_allocs += num - *allocs;
+	*phase_alloc_bytes += bytes - *alloc_bytes;
+	*allocs = num;
+	*alloc_bytes = bytes;
+}
+
+// fractions of the bytes that a motion between all the segments, and a gather
+// to the master, move between two instances of the same host, taking the rows
+// to be spread evenly over the primaries of gp_segment_configuration
+static void
+GetIntraHostMotionFractions
+	(
+	double *segments_fraction,
+	double *gather_fraction
+	)
+{
+	CdbComponentDatabases *cdbs = gpdb::GetComponentDatabases();
+	double num_primaries = 0.0;
+	double num_pairs = 0.0;
+	double num_master_host = 0.0;
+
+	for (int i = 0; i < cdbs->total_segment_dbs; i++)
+	{
+		CdbComponentDatabaseInfo *cdbinfo = &cdbs->segment_db_info[i];
+
+		if (!SEGMENT_IS_ACTIVE_PRIMARY(cdbinfo))
+			continue;
+
+		// every primary sends to the hostSegs primaries of its own host
+		num_primaries += 1.0;
+		num_pairs += cdbinfo->hostSegs;
+	}
+
+	for (int i = 0; i < cdbs->total_entry_dbs; i++)
+	{
+		CdbComponentDatabaseInfo *cdbinfo = &cdbs->entry_db_info[i];
+
+		if (SEGMENT_IS_ACTIVE_PRIMARY(cdbinfo))
+			num_master_host = cdbinfo->hostSegs;
+	}
+
+	*segments_fraction = 0.0;
+	*gather_fraction = 0.0;
+	if (0.0 < num_primaries)
+	{
+		*segments_fraction = num_pairs / (num_primaries * num_primaries);
+		*gather_fraction = num_master_host / num_primaries;
+	}
+}
+
 
 //---------------------------------------------------------------------------
 //	@function:
@@ -142,7 +252,8 @@ SOptContext::SOptContext()
 	m_should_serialize_plan_dxl(false),
 	m_is_unexpected_failure(false),
 	m_should_error_out(false),
-	m_error_msg(NULL)
+	m_error_msg(NULL),
+	m_search_time_budget_hits(0)
 {}
 
 //---------------------------------------------------------------------------
@@ -421,6 +532,495 @@ COptTasks::LoadSearchStrategy
 	return search_strategy_arr;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::GetSearchStrategy
+//
+//	@doc:
+//		Search strategy from given file, which is only loaded again once the
+//		path changes. NULL if the default search strategy is to be used.
+//		Search stages keep the best plan of the optimization they are used
+//		for, so the stages returned are copies in the given memory pool
+//
+//---------------------------------------------------------------------------
+CSearchStageArray *
+COptTasks::GetSearchStrategy
+	(
+	CMemoryPool *mp,
+	char *path
+	)
+{
+	BOOL same_path = (NULL == path && NULL == search_strategy_path) ||
+		(NULL != path && NULL != search_strategy_path && 0 == strcmp(path, search_strategy_path));
+
+	if (!search_strategy_loaded || !same_path)
+	{
+		if (NULL == search_strategy_mp)
+		{
+			search_strategy_mp = CMemoryPoolManager::GetMemoryPoolMgr()->Create(CMemoryPoolManager::EatTracker, false /* fThreadSafe */, gpos::ullong_max);
+		}
+
+		CRefCount::SafeRelease(search_strategy_loaded_arr);
+		search_strategy_loaded_arr = NULL;
+		if (NULL != search_strategy_path)
+		{
+			GPOS_DELETE_ARRAY(search_strategy_path);
+			search_strategy_path = NULL;
+		}
+		search_strategy_loaded = false;
+
+		search_strategy_loaded_arr = LoadSearchStrategy(search_strategy_mp, path);
+		if (NULL != path)
+		{
+			ULONG len = strlen(path);
+			search_strategy_path = GPOS_NEW_ARRAY(search_strategy_mp, CHAR, len + 1);
+			memcpy(search_strategy_path, path, len + 1);
+		}
+		search_strategy_loaded = true;
+	}
+
+	if (NULL == search_strategy_loaded_arr)
+	{
+		return NULL;
+	}
+
+	CSearchStageArray *search_strategy_arr = GPOS_NEW(mp) CSearchStageArray(mp);
+	const ULONG num_stages = search_strategy_loaded_arr->Size();
+	for (ULONG ul = 0; ul < num_stages; ul++)
+	{
+		CSearchStage *search_stage = (*search_strategy_loaded_arr)[ul];
+		CXformSet *xform_set = search_stage->GetXformSet();
+		xform_set->AddRef();
+		search_strategy_arr->Append(GPOS_NEW(mp) CSearchStage(xform_set, search_stage->TimeThreshold(), search_stage->CostThreshold()));
+	}
+
+	return search_strategy_arr;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::GetTraceFlags
+//
+//	@doc:
+//		Trace flags of the GUCs and of the xforms disabled by disable_xform(),
+//		which are only packed again once a GUC or an xform changes. Trace
+//		flags are only read once set, so the bitset returned is shared, and
+//		the caller releases its reference
+//
+//---------------------------------------------------------------------------
+CBitSet *
+COptTasks::GetTraceFlags()
+{
+	uint64 guc_generation = gpdb::GetConfigGeneration();
+
+	if (NULL == trace_flags_packed ||
+		guc_generation != trace_flags_guc_generation ||
+		xform_generation != trace_flags_xform_generation)
+	{
+		if (NULL == trace_flags_mp)
+		{
+			trace_flags_mp = CMemoryPoolManager::GetMemoryPoolMgr()->Create(CMemoryPoolManager::EatTracker, false /* fThreadSafe */, gpos::ullong_max);
+		}
+
+		CRefCount::SafeRelease(trace_flags_packed);
+		trace_flags_packed = NULL;
+
+		trace_flags_packed = CConfigParamMapping::PackConfigParamInBitset(trace_flags_mp, CXform::ExfSentinel);
+		trace_flags_guc_generation = guc_generation;
+		trace_flags_xform_generation = xform_generation;
+	}
+
+	trace_flags_packed->AddRef();
+
+	return trace_flags_packed;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::UseDPv2JoinOrder
+//
+//	@doc:
+//		Copy the trace flags of the exhaustive join order, with those of the
+//		exhaustive2 join order instead, for a query whose large joins fit in
+//		optimizer_join_search_budget. The reference to the given flags is
+//		passed on to the copy
+//
+//---------------------------------------------------------------------------
+CBitSet *
+COptTasks::UseDPv2JoinOrder
+	(
+	CMemoryPool *mp,
+	CBitSet *trace_flags
+	)
+{
+	CBitSet *exhaustive_bitset = CXform::PbsJoinOrderOnExhaustiveXforms(mp);
+	CBitSet *exhaustive2_bitset = CXform::PbsJoinOrderOnExhaustive2Xforms(mp);
+
+	// enable the xforms that only exhaustive2 enables, and disable the ones
+	// it disables
+	CBitSet *result = GPOS_NEW(mp) CBitSet(mp, *trace_flags);
+	exhaustive_bitset->Difference(exhaustive2_bitset);
+	result->Difference(exhaustive_bitset);
+	result->Union(exhaustive2_bitset);
+
+	exhaustive_bitset->Release();
+	exhaustive2_bitset->Release();
+	trace_flags->Release();
+
+	return result;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::ApplySearchTimeBudget
+//
+//	@doc:
+//		Cap the time threshold of each search stage at the optimization time
+//		budget, so that a stage stops with the best plan found so far once it
+//		expires. The budget is per stage, the default search strategy has a
+//		single stage. The default search strategy is used if none is given
+//
+//---------------------------------------------------------------------------
+CSearchStageArray *
+COptTasks::ApplySearchTimeBudget
+	(
+	CMemoryPool *mp,
+	CSearchStageArray *search_strategy_arr,
+	ULONG budget_ms
+	)
+{
+	if (0 == budget_ms)
+	{
+		return search_strategy_arr;
+	}
+
+	if (NULL == search_strategy_arr)
+	{
+		search_strategy_arr = CSearchStage::PdrgpssDefault(mp);
+	}
+
+	CSearchStageArray *budget_search_strategy_arr = GPOS_NEW(mp) CSearchStageArray(mp);
+	const ULONG num_stages = search_strategy_arr->Size();
+	for (ULONG ul = 0; ul < num_stages; ul++)
+	{
+		CSearchStage *search_stage = (*search_strategy_arr)[ul];
+		ULONG time_threshold = search_stage->TimeThreshold();
+		if (time_threshold > budget_ms)
+		{
+			time_threshold = budget_ms;
+		}
+
+		CXformSet *xform_set = search_stage->GetXformSet();
+		xform_set->AddRef();
+		budget_search_strategy_arr->Append(GPOS_NEW(mp) CSearchStage(xform_set, time_threshold, search_stage->CostThreshold()));
+	}
+	search_strategy_arr->Release();
+
+	return budget_search_strategy_arr;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::SearchTimeBudgetHit
+//
+//	@doc:
+//		Did a search stage run out of the optimization time budget? The timer
+//		of a stage restarts as the search enters it, so a stage ran from its
+//		elapsed time until that of the next one. The stages the search didn't
+//		get to were made before it started, and have been running longer
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::SearchTimeBudgetHit
+	(
+	CSearchStageArray *search_strategy_arr,
+	ULONG budget_ms
+	)
+{
+	const ULONG num_stages = search_strategy_arr->Size();
+	for (ULONG ul = 0; ul < num_stages; ul++)
+	{
+		ULONG elapsed_ms = (*search_strategy_arr)[ul]->UlElapsedTime();
+		ULONG next_elapsed_ms = 0;
+		if (ul + 1 < num_stages)
+		{
+			next_elapsed_ms = (*search_strategy_arr)[ul + 1]->UlElapsedTime();
+		}
+
+		// the last stage the search got to ran until the end of the search
+		BOOL is_last = next_elapsed_ms > elapsed_ms;
+		if (is_last)
+		{
+			next_elapsed_ms = 0;
+		}
+
+		if (elapsed_ms - next_elapsed_ms >= budget_ms)
+		{
+			return true;
+		}
+
+		if (is_last)
+		{
+			break;
+		}
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::RecordSearchStageStats
+//
+//	@doc:
+//		Count, for each stage of the search strategy an optimization used,
+//		whether the stage found a plan and whether that plan was the cheapest
+//		one of the search, for gp_optimizer_search_stages(). The counts start
+//		over when the number of stages of the search strategy changes
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::RecordSearchStageStats
+	(
+	CSearchStageArray *search_strategy_arr
+	)
+{
+	ULONG num_stages = search_strategy_arr->Size();
+	if (num_stages > OPTIMIZER_MAX_SEARCH_STAGES)
+	{
+		num_stages = OPTIMIZER_MAX_SEARCH_STAGES;
+	}
+
+	if ((int) num_stages != optimizer_num_search_stages)
+	{
+		memset(optimizer_search_stage_stats, 0, sizeof(optimizer_search_stage_stats));
+		optimizer_num_search_stages = (int) num_stages;
+	}
+
+	ULONG best_stage = gpos::ulong_max;
+	for (ULONG ul = 0; ul < num_stages; ul++)
+	{
+		CSearchStage *search_stage = (*search_strategy_arr)[ul];
+		OptimizerSearchStageStats *stage_stats = &optimizer_search_stage_stats[ul];
+
+		stage_stats->num_xforms = (int) search_stage->GetXformSet()->Size();
+		stage_stats->num_searches++;
+		stage_stats->last_cost = -1;
+
+		// the stages the search didn't get to have no plan either
+		if (NULL != search_stage->PexprBest())
+		{
+			stage_stats->num_plans++;
+			stage_stats->last_cost = search_stage->CostBest().Get();
+
+			if (gpos::ulong_max == best_stage ||
+				stage_stats->last_cost < optimizer_search_stage_stats[best_stage].last_cost)
+			{
+				best_stage = ul;
+			}
+		}
+	}
+
+	if (gpos::ulong_max != best_stage)
+	{
+		optimizer_search_stage_stats[best_stage].num_best++;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PrefetchMDObjects
+//
+//	@doc:
+//		Load the statistics of the relations of the query, and of the columns
+//		its quals, grouping and sorting refer to, before the search starts,
+//		instead of one at a time whenever the search derives statistics.
+//		Columns only in the target list are left to be fetched on demand, the
+//		search doesn't look at the histograms of most of them
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::PrefetchMDObjects
+	(
+	CMemoryPool *mp,
+	CMDAccessor *md_accessor,
+	Query *query
+	)
+{
+	SContextPrefetchMD context;
+	context.m_mp = mp;
+	context.m_md_accessor = md_accessor;
+	context.m_rtable = query->rtable;
+
+	ListCell *lc = NULL;
+	ForEach (lc, query->rtable)
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+		if (RTE_RELATION == rte->rtekind)
+		{
+			CMDIdRelStats *rel_stats_mdid = GPOS_NEW(mp) CMDIdRelStats(GPOS_NEW(mp) CMDIdGPDB(rte->relid));
+			(void) md_accessor->Pmdrelstats(rel_stats_mdid);
+			rel_stats_mdid->Release();
+		}
+		else if (RTE_SUBQUERY == rte->rtekind)
+		{
+			PrefetchMDObjects(mp, md_accessor, rte->subquery);
+		}
+	}
+
+	ForEach (lc, query->cteList)
+	{
+		CommonTableExpr *cte = (CommonTableExpr *) lfirst(lc);
+		PrefetchMDObjects(mp, md_accessor, (Query *) cte->ctequery);
+	}
+
+	(void) PrefetchMDWalker((Node *) query->jointree, &context);
+	(void) PrefetchMDWalker(query->havingQual, &context);
+
+	// target entries the grouping, sorting, distinct and window clauses
+	// refer to
+	ForEach (lc, query->targetList)
+	{
+		TargetEntry *target_entry = (TargetEntry *) lfirst(lc);
+		if (0 != target_entry->ressortgroupref)
+		{
+			(void) PrefetchMDWalker((Node *) target_entry->expr, &context);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PrefetchMDWalker
+//
+//	@doc:
+//		Load the statistics of the columns of the query's relations that the
+//		expression refers to. Subqueries are prefetched with their own range
+//		table, outer references are skipped
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::PrefetchMDWalker
+	(
+	Node *node,
+	SContextPrefetchMD *context
+	)
+{
+	if (NULL == node)
+	{
+		return false;
+	}
+
+	if (IsA(node, Query))
+	{
+		PrefetchMDObjects(context->m_mp, context->m_md_accessor, (Query *) node);
+		return false;
+	}
+
+	if (IsA(node, Var))
+	{
+		Var *var = (Var *) node;
+		if (0 == var->varlevelsup && 0 < var->varattno &&
+			0 < var->varno && var->varno <= (Index) gpdb::ListLength(context->m_rtable))
+		{
+			RangeTblEntry *rte = (RangeTblEntry *) gpdb::ListNth(context->m_rtable, var->varno - 1);
+			if (RTE_RELATION == rte->rtekind)
+			{
+				PrefetchColStats(context->m_mp, context->m_md_accessor, rte->relid, var->varattno);
+			}
+		}
+
+		return false;
+	}
+
+	return gpdb::WalkExpressionTree(node, (BOOL (*)()) COptTasks::PrefetchMDWalker, context);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PrefetchColStats
+//
+//	@doc:
+//		Load the statistics of the column with the given attribute number
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::PrefetchColStats
+	(
+	CMemoryPool *mp,
+	CMDAccessor *md_accessor,
+	OID rel_oid,
+	INT attno
+	)
+{
+	CMDIdGPDB *rel_mdid = GPOS_NEW(mp) CMDIdGPDB(rel_oid);
+	const IMDRelation *md_rel = md_accessor->RetrieveRel(rel_mdid);
+
+	// statistics of columns are identified by their position in the relation
+	const ULONG num_cols = md_rel->ColumnCount();
+	for (ULONG ul = 0; ul < num_cols; ul++)
+	{
+		const IMDColumn *md_col = md_rel->GetMdCol(ul);
+		if (attno == md_col->AttrNum() && !md_col->IsDropped())
+		{
+			rel_mdid->AddRef();
+			CMDIdColStats *col_stats_mdid = GPOS_NEW(mp) CMDIdColStats(rel_mdid, ul);
+			(void) md_accessor->Pmdcolstats(col_stats_mdid);
+			col_stats_mdid->Release();
+			break;
+		}
+	}
+
+	rel_mdid->Release();
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::CaptureOptimization
+//
+//	@doc:
+//		Keep the minidump of a slow optimization: the optimizer configuration,
+//		the metadata it looked up, the query and the plan, in the format of
+//		the minidumps written for optimizer_minidump, so that it can be
+//		replayed offline
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::CaptureOptimization
+	(
+	CMemoryPool *mp,
+	CMDAccessor *md_accessor,
+	const CDXLNode *query_dxl,
+	const CDXLNodeArray *query_output_dxlnode_array,
+	const CDXLNodeArray *cte_dxlnode_array,
+	const CDXLNode *plan_dxl,
+	COptimizerConfig *optimizer_config,
+	double optimization_time
+	)
+{
+	CWStringDynamic minidump_str(mp);
+	COstreamString oss(&minidump_str);
+
+	oss << GPOS_WSZ_LIT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n")
+		<< GPOS_WSZ_LIT("<dxl:DXLMessage xmlns:dxl=\"http://greenplum.com/dxl/2010/12/\">\n")
+		<< GPOS_WSZ_LIT("<dxl:Thread Id=\"0\">\n");
+
+	// the configuration goes first, as in the minidumps of optimizer_minidump
+	CSerializableOptimizerConfig serializable_optimizer_config(mp, optimizer_config);
+	serializable_optimizer_config.Serialize(oss);
+
+	md_accessor->Serialize(oss);
+	CDXLUtils::SerializeQuery(mp, oss, query_dxl, query_output_dxlnode_array, cte_dxlnode_array, false /*serialize_header_footer*/, true /*indentation*/);
+	CDXLUtils::SerializePlan(mp, oss, plan_dxl, optimizer_config->GetEnumeratorCfg()->GetPlanId(), optimizer_config->GetEnumeratorCfg()->GetPlanSpaceSize(), false /*serialize_header_footer*/, true /*indentation*/);
+
+	oss << GPOS_WSZ_LIT("</dxl:Thread>\n")
+		<< GPOS_WSZ_LIT("</dxl:DXLMessage>\n");
+
+	CHAR *minidump = CreateMultiByteCharStringFromWCString(minidump_str.GetBuffer());
+	gpdb::CaptureOptimization(optimization_time, minidump);
+	gpdb::GPDBFree(minidump);
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::CreateOptimizerConfig
@@ -433,7 +1033,8 @@ COptimizerConfig *
 COptTasks::CreateOptimizerConfig
 	(
 	CMemoryPool *mp,
-	ICostModel *cost_model
+	ICostModel *cost_model,
+	Query *query
 	)
 {
 	// get chosen plan number, cost threshold
@@ -442,6 +1043,10 @@ COptTasks::CreateOptimizerConfig
 	DOUBLE cost_threshold = (DOUBLE) optimizer_cost_threshold;
 
 	DOUBLE damping_factor_filter = (DOUBLE) optimizer_damping_factor_filter;
+	if (optimizer_enable_dependency_damping)
+	{
+		damping_factor_filter = (DOUBLE) gpdb::GetFilterDampingFactor(query, optimizer_damping_factor_filter);
+	}
 	DOUBLE damping_factor_join = (DOUBLE) optimizer_damping_factor_join;
 	DOUBLE damping_factor_groupby = (DOUBLE) optimizer_damping_factor_groupby;
 
@@ -550,6 +1155,32 @@ COptTasks::ShouldErrorOut
 		FoundException(exc, expected_dxl_errors, GPOS_ARRAY_SIZE(expected_dxl_errors));
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::IsMDCacheIntact
+//
+//	@doc:
+//		Check if the metadata cache can be kept after the given exception.
+//		Errors raised by the optimizer, the translators and GPDB, including
+//		the expected fallbacks to the planner, leave it intact; system errors
+//		such as out of memory or failed assertions may have left it corrupt
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::IsMDCacheIntact
+	(
+	gpos::CException &exc
+	)
+{
+	ULONG major = exc.Major();
+
+	return
+		gpopt::ExmaGPOPT == major ||
+		gpdxl::ExmaDXL == major ||
+		gpdxl::ExmaMD == major ||
+		gpdxl::ExmaGPDB == major;
+}
+
 //---------------------------------------------------------------------------
 //		@function:
 //			COptTasks::SetCostModelParams
@@ -566,6 +1197,28 @@ COptTasks::SetCostModelParams
 {
 	GPOS_ASSERT(NULL != cost_model);
 
+	if (OPTIMIZER_GPDB_CALIBRATED == optimizer_cost_model)
+	{
+		// parameters fitted to the cluster by gpcalibratecost, the factors
+		// below apply on top of them
+		int num_params = 0;
+		OrcaCostParam *params = gpdb::GetOrcaCostParams(&num_params);
+
+		for (int i = 0; i < num_params; i++)
+		{
+			ICostModelParams::SCostParam *cost_param = cost_model->GetCostModelParams()->PcpLookup(params[i].name);
+
+			if (NULL == cost_param)
+			{
+				elog(DEBUG1, "[OPT]: Ignoring unknown cost model parameter \"%s\"", params[i].name);
+				continue;
+			}
+
+			CDouble factor(params[i].factor);
+			cost_model->GetCostModelParams()->SetParam(cost_param->Id(), cost_param->Get() * factor, cost_param->GetLowerBoundVal() * factor, cost_param->GetUpperBoundVal() * factor);
+		}
+	}
+
 	if (optimizer_nestloop_factor > 1.0)
 	{
 		// change NLJ cost factor
@@ -594,6 +1247,95 @@ COptTasks::SetCostModelParams
 			cost_model->GetCostModelParams()->SetParam(cost_param->Id(), cost_param->Get() * optimizer_sort_factor, cost_param->GetLowerBoundVal() * optimizer_sort_factor, cost_param->GetUpperBoundVal() * optimizer_sort_factor);
 		}
 	}
+
+	if (gp_interconnect_compression && optimizer_compressed_motion_cost_factor < 1.0 &&
+		OPTIMIZER_GPDB_CALIBRATED == optimizer_cost_model)
+	{
+		// compressed motions send fewer bytes, at the price of CPU spent on
+		// the compression, which is not costed separately
+		const ULONG motion_cost_params[] =
+		{
+			CCostModelParamsGPDB::EcpGatherSendCostUnit,
+			CCostModelParamsGPDB::EcpGatherRecvCostUnit,
+			CCostModelParamsGPDB::EcpRedistributeSendCostUnit,
+			CCostModelParamsGPDB::EcpRedistributeRecvCostUnit,
+			CCostModelParamsGPDB::EcpBroadcastSendCostUnit,
+			CCostModelParamsGPDB::EcpBroadcastRecvCostUnit
+		};
+
+		for (ULONG ul = 0; ul < GPOS_ARRAY_SIZE(motion_cost_params); ul++)
+		{
+			ICostModelParams::SCostParam *cost_param = cost_model->GetCostModelParams()->PcpLookup(motion_cost_params[ul]);
+
+			cost_model->GetCostModelParams()->SetParam(cost_param->Id(), cost_param->Get() * optimizer_compressed_motion_cost_factor, cost_param->GetLowerBoundVal() * optimizer_compressed_motion_cost_factor, cost_param->GetUpperBoundVal() * optimizer_compressed_motion_cost_factor);
+		}
+	}
+
+	if ((optimizer_hashagg_cost_factor > 1.0 || optimizer_hashagg_cost_factor < 1.0) &&
+		OPTIMIZER_GPDB_CALIBRATED == optimizer_cost_model)
+	{
+		// change hash aggregate cost factor, the hash table of the executor
+		// probes its slots without following chains of entries
+		const ULONG hashagg_cost_params[] =
+		{
+			CCostModelParamsGPDB::EcpHashAggInputTupColumnCostUnit,
+			CCostModelParamsGPDB::EcpHashAggInputTupWidthCostUnit,
+			CCostModelParamsGPDB::EcpHashAggOutputTupWidthCostUnit
+		};
+
+		for (ULONG ul = 0; ul < GPOS_ARRAY_SIZE(hashagg_cost_params); ul++)
+		{
+			ICostModelParams::SCostParam *cost_param = cost_model->GetCostModelParams()->PcpLookup(hashagg_cost_params[ul]);
+
+			cost_model->GetCostModelParams()->SetParam(cost_param->Id(), cost_param->Get() * optimizer_hashagg_cost_factor, cost_param->GetLowerBoundVal() * optimizer_hashagg_cost_factor, cost_param->GetUpperBoundVal() * optimizer_hashagg_cost_factor);
+		}
+	}
+
+	if ((optimizer_cte_sharing_cost_factor > 1.0 || optimizer_cte_sharing_cost_factor < 1.0) &&
+		0 < gp_shareinput_shmem_size &&
+		OPTIMIZER_GPDB_CALIBRATED == optimizer_cost_model)
+	{
+		// change materialize cost factor, shared CTEs that fit are kept in
+		// shared memory instead of workfiles, which makes sharing a CTE
+		// cheaper compared to inlining it
+		ICostModelParams::SCostParam *cost_param = cost_model->GetCostModelParams()->PcpLookup(CCostModelParamsGPDB::EcpMaterializeCostUnit);
+
+		cost_model->GetCostModelParams()->SetParam(cost_param->Id(), cost_param->Get() * optimizer_cte_sharing_cost_factor, cost_param->GetLowerBoundVal() * optimizer_cte_sharing_cost_factor, cost_param->GetUpperBoundVal() * optimizer_cte_sharing_cost_factor);
+	}
+
+	if (optimizer_intra_host_motion_cost_factor < 1.0 &&
+		OPTIMIZER_GPDB_CALIBRATED == optimizer_cost_model)
+	{
+		// change motion cost factors by the topology of the cluster, the
+		// bytes a motion moves between segments of the same host don't
+		// cross the network, and cost optimizer_intra_host_motion_cost_factor
+		// times the bytes that do
+		double segments_fraction;
+		double gather_fraction;
+
+		GetIntraHostMotionFractions(&segments_fraction, &gather_fraction);
+
+		const ULONG motion_cost_params[] =
+		{
+			CCostModelParamsGPDB::EcpGatherSendCostUnit,
+			CCostModelParamsGPDB::EcpGatherRecvCostUnit,
+			CCostModelParamsGPDB::EcpRedistributeSendCostUnit,
+			CCostModelParamsGPDB::EcpRedistributeRecvCostUnit,
+			CCostModelParamsGPDB::EcpBroadcastSendCostUnit,
+			CCostModelParamsGPDB::EcpBroadcastRecvCostUnit
+		};
+
+		for (ULONG ul = 0; ul < GPOS_ARRAY_SIZE(motion_cost_params); ul++)
+		{
+			ICostModelParams::SCostParam *cost_param = cost_model->GetCostModelParams()->PcpLookup(motion_cost_params[ul]);
+			BOOL is_gather = CCostModelParamsGPDB::EcpGatherSendCostUnit == motion_cost_params[ul] ||
+							 CCostModelParamsGPDB::EcpGatherRecvCostUnit == motion_cost_params[ul];
+			double local_fraction = is_gather ? gather_fraction : segments_fraction;
+			double factor = 1.0 - local_fraction * (1.0 - optimizer_intra_host_motion_cost_factor);
+
+			cost_model->GetCostModelParams()->SetParam(cost_param->Id(), cost_param->Get() * factor, cost_param->GetLowerBoundVal() * factor, cost_param->GetUpperBoundVal() * factor);
+		}
+	}
 }
 
 
@@ -627,6 +1369,84 @@ COptTasks::GetCostModel
 	return cost_model;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::CreateMDCacheObjectMdid
+//
+//	@doc:
+//		Create the mdid of an object tracked for invalidation of the
+//		metadata cache
+//
+//---------------------------------------------------------------------------
+IMDId *
+COptTasks::CreateMDCacheObjectMdid
+	(
+	CMemoryPool *mp,
+	const gpdb::MDCacheObject *object
+	)
+{
+	switch (object->kind)
+	{
+		case gpdb::MDCacheObjectGPDB:
+			return GPOS_NEW(mp) CMDIdGPDB(object->oids[0]);
+
+		case gpdb::MDCacheObjectRelStats:
+			return GPOS_NEW(mp) CMDIdRelStats(GPOS_NEW(mp) CMDIdGPDB(object->oids[0]));
+
+		case gpdb::MDCacheObjectColStats:
+			return GPOS_NEW(mp) CMDIdColStats(GPOS_NEW(mp) CMDIdGPDB(object->oids[0]), object->num);
+
+		case gpdb::MDCacheObjectCast:
+			return GPOS_NEW(mp) CMDIdCast(GPOS_NEW(mp) CMDIdGPDB(object->oids[0]), GPOS_NEW(mp) CMDIdGPDB(object->oids[1]));
+
+		case gpdb::MDCacheObjectScCmp:
+			return GPOS_NEW(mp) CMDIdScCmp(GPOS_NEW(mp) CMDIdGPDB(object->oids[0]), GPOS_NEW(mp) CMDIdGPDB(object->oids[1]), (IMDType::ECmpType) object->num);
+
+		default:
+			GPOS_ASSERT(!"Unexpected metadata cache object");
+			return NULL;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::EvictMDCacheObjects
+//
+//	@doc:
+//		Evict the objects invalidated by catalog changes from the metadata
+//		cache
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::EvictMDCacheObjects
+	(
+	CMemoryPool *mp,
+	const gpdb::MDCacheObject *objects,
+	ULONG num_objects
+	)
+{
+	for (ULONG ul = 0; ul < num_objects; ul++)
+	{
+		IMDId *mdid = CreateMDCacheObjectMdid(mp, &objects[ul]);
+		if (NULL == mdid)
+		{
+			continue;
+		}
+
+		{
+			CMDKey md_key(mdid);
+			CCacheAccessor<IMDCacheObject *, CMDKey *> accessor(CMDCache::Pcache());
+
+			for (IMDCacheObject *md_obj = accessor.Lookup(&md_key); NULL != md_obj; md_obj = accessor.Next())
+			{
+				accessor.MarkForDeletion();
+			}
+		}
+
+		mdid->Release();
+	}
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::OptimizeTask
@@ -648,16 +1468,39 @@ COptTasks::OptimizeTask
 	GPOS_ASSERT(NULL == opt_ctxt->m_plan_dxl);
 	GPOS_ASSERT(NULL == opt_ctxt->m_plan_stmt);
 
-	AUTO_MEM_POOL(amp);
+	// The memory of the optimization is limited, not that of the metadata
+	// cache, which is kept in memory pools of its own, unless GPDB's
+	// allocators enforce the limit, see below
+	ULLONG memory_limit = gpos::ullong_max;
+	if (0 < optimizer_memory_limit)
+	{
+		memory_limit = (ULLONG) optimizer_memory_limit * 1024;
+	}
+
+	AUTO_MEM_POOL_LIMITED(amp, memory_limit);
 	CMemoryPool *mp = amp.Pmp();
 
-	// Does the metadatacache need to be reset?
+	// Take the catalog version of the metadata cache shared by the backends.
+	// It processes pending invalidations, so it's done before checking if
+	// the metadata cache needs to be reset. DXL of multi-level partitioned
+	// tables depends on a GUC, so it's not shared if they are disabled.
+	BOOL use_shared_mdcache = optimizer_metadata_caching && optimizer_multilevel_partitioning && 0 < optimizer_mdcache_shared_size;
+	uint64 shared_mdcache_version = 0;
+	if (use_shared_mdcache)
+	{
+		shared_mdcache_version = gpdb::SharedMDCacheGetVersion();
+	}
+
+	// Does the metadatacache need to be reset, or just some of its objects
+	// be evicted?
 	//
 	// On the first call, before the cache has been initialized, we
 	// don't care about the return value of MDCacheNeedsReset(). But
 	// we need to call it anyway, to give it a chance to initialize
 	// the invalidation mechanism.
-	bool reset_mdcache = gpdb::MDCacheNeedsReset();
+	gpdb::MDCacheObject *invalid_objects = NULL;
+	int num_invalid_objects = 0;
+	bool reset_mdcache = gpdb::MDCacheNeedsReset(&invalid_objects, &num_invalid_objects);
 
 	// initialize metadata cache, or purge if needed, or change size if requested
 	if (!CMDCache::FInitialized())
@@ -670,31 +1513,62 @@ COptTasks::OptimizeTask
 		CMDCache::Reset();
 		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
 	}
-	else if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
+	else
 	{
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		EvictMDCacheObjects(mp, invalid_objects, num_invalid_objects);
+
+		if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
+		{
+			CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		}
+	}
+
+	// cached plans may depend on any of the invalidated objects
+	if (reset_mdcache || 0 < num_invalid_objects)
+	{
+		gpdb::OrcaPlanCacheReset();
+	}
+
+	if (NULL != invalid_objects)
+	{
+		gpdb::GPDBFree(invalid_objects);
 	}
 
 
-	// load search strategy
-	CSearchStageArray *search_strategy_arr = LoadSearchStrategy(mp, optimizer_search_strategy_path);
+	// load search strategy, and limit it to the optimization time budget
+	ULONG search_time_budget = (ULONG) optimizer_search_time_budget;
+	CSearchStageArray *search_strategy_arr = GetSearchStrategy(mp, optimizer_search_strategy_path);
+	search_strategy_arr = ApplySearchTimeBudget(mp, search_strategy_arr, search_time_budget);
 
 	CBitSet *trace_flags = NULL;
 	CBitSet *enabled_trace_flags = NULL;
 	CBitSet *disabled_trace_flags = NULL;
 	CDXLNode *plan_dxl = NULL;
+	CSearchStageArray *searched_stages_arr = NULL;
 
 	IMdIdArray *col_stats = NULL;
 	MdidHashSet *rel_stats = NULL;
 
+	// GPDB's allocators don't know the capacity of the pool they allocate
+	// for, so they enforce the limit themselves, on the metadata cache too
+	BOOL is_allocator_limited = optimizer_use_gpdb_allocators && gpos::ullong_max != memory_limit;
+	if (is_allocator_limited)
+	{
+		gpdb::SetOptimizerMemoryLimit(memory_limit);
+	}
+
 	GPOS_TRY
 	{
 		// set trace flags
-		trace_flags = CConfigParamMapping::PackConfigParamInBitset(mp, CXform::ExfSentinel);
+		trace_flags = GetTraceFlags();
+		if (optimizer_last_stats.join_search_dp)
+		{
+			trace_flags = UseDPv2JoinOrder(mp, trace_flags);
+		}
 		SetTraceflags(mp, trace_flags, &enabled_trace_flags, &disabled_trace_flags);
 
 		// set up relcache MD provider
-		CMDProviderRelcache *relcache_provider = GPOS_NEW(mp) CMDProviderRelcache(mp);
+		CMDProviderRelcache *relcache_provider = GPOS_NEW(mp) CMDProviderRelcache(mp, use_shared_mdcache, shared_mdcache_version);
 
 		{
 			// scope for MD accessor
@@ -707,6 +1581,11 @@ COptTasks::OptimizeTask
 				num_segments_for_costing = num_segments;
 			}
 
+			// time and allocations of the phases, for EXPLAIN (OPTIMIZER_STATS)
+			CWallClock phase_timer;
+			uint64 alloc_bytes;
+			uint64 allocs = gpdb::GetOptimizerAllocations(&alloc_bytes);
+
 			CAutoP<CTranslatorQueryToDXL> query_to_dxl_translator;
 			query_to_dxl_translator = CTranslatorQueryToDXL::QueryToDXLInstance
 							(
@@ -714,72 +1593,161 @@ COptTasks::OptimizeTask
 							&mda,
 							(Query*) opt_ctxt->m_query
 							);
+			optimizer_last_stats.translate_time += GetElapsedMS(phase_timer);
+			AddPhaseAllocations(&allocs, &alloc_bytes, &optimizer_last_stats.translate_allocs, &optimizer_last_stats.translate_alloc_bytes);
 
-			ICostModel *cost_model = GetCostModel(mp, num_segments_for_costing);
-			COptimizerConfig *optimizer_config = CreateOptimizerConfig(mp, cost_model);
-			CConstExprEvaluatorProxy expr_eval_proxy(mp, &mda);
-			IConstExprEvaluator *expr_evaluator =
-					GPOS_NEW(mp) CConstExprEvaluatorDXL(mp, &mda, &expr_eval_proxy);
-
-			CDXLNode *query_dxl = query_to_dxl_translator->TranslateQueryToDXL();
-			CDXLNodeArray *query_output_dxlnode_array = query_to_dxl_translator->GetQueryOutputCols();
-			CDXLNodeArray *cte_dxlnode_array = query_to_dxl_translator->GetCTEs();
-			GPOS_ASSERT(NULL != query_output_dxlnode_array);
-
-			BOOL is_master_only = !optimizer_enable_motions ||
-						(!optimizer_enable_motions_masteronly_queries && !query_to_dxl_translator->HasDistributedTables());
-			CAutoTraceFlag atf(EopttraceDisableMotions, is_master_only);
-
-			plan_dxl = COptimizer::PdxlnOptimize
-									(
-									mp,
-									&mda,
-									query_dxl,
-									query_output_dxlnode_array,
-									cte_dxlnode_array,
-									expr_evaluator,
-									num_segments,
-									gp_session_id,
-									gp_command_count,
-									search_strategy_arr,
-									optimizer_config
-									);
-
-			if (opt_ctxt->m_should_serialize_plan_dxl)
+			// Plans are cached by the normalized query, the template of a
+			// query optimized many times is filled in with its constants
+			OrcaPlanCacheQuery *plan_cache_query = NULL;
+			if (opt_ctxt->m_should_generate_plan_stmt && !opt_ctxt->m_should_serialize_plan_dxl)
 			{
-				// serialize DXL to xml
-				CWStringDynamic plan_str(mp);
-				COstreamString oss(&plan_str);
-				CDXLUtils::SerializePlan(mp, oss, plan_dxl, optimizer_config->GetEnumeratorCfg()->GetPlanId(), optimizer_config->GetEnumeratorCfg()->GetPlanSpaceSize(), true /*serialize_header_footer*/, true /*indentation*/);
-				opt_ctxt->m_plan_dxl = CreateMultiByteCharStringFromWCString(plan_str.GetBuffer());
+				opt_ctxt->m_plan_stmt = gpdb::OrcaPlanCacheLookup(query_to_dxl_translator->Pquery(), &plan_cache_query);
 			}
 
-			// translate DXL->PlStmt only when needed
-			if (opt_ctxt->m_should_generate_plan_stmt)
+			if (NULL == opt_ctxt->m_plan_stmt)
 			{
-				// always use opt_ctxt->m_query->can_set_tag as the query_to_dxl_translator->Pquery() is a mutated Query object
-				// that may not have the correct can_set_tag
-			  opt_ctxt->m_plan_stmt = (PlannedStmt *) gpdb::CopyObject(ConvertToPlanStmtFromDXL(mp, &mda, plan_dxl, opt_ctxt->m_query->canSetTag, query_to_dxl_translator->GetDistributionHashOpsKind()));
-			}
+				ICostModel *cost_model = GetCostModel(mp, num_segments_for_costing);
+				COptimizerConfig *optimizer_config = CreateOptimizerConfig(mp, cost_model, opt_ctxt->m_query);
+				CConstExprEvaluatorProxy expr_eval_proxy(mp, &mda);
+				IConstExprEvaluator *expr_evaluator =
+						GPOS_NEW(mp) CConstExprEvaluatorDXL(mp, &mda, &expr_eval_proxy);
+
+				phase_timer.Restart();
+				allocs = gpdb::GetOptimizerAllocations(&alloc_bytes);
+				CDXLNode *query_dxl = query_to_dxl_translator->TranslateQueryToDXL();
+				CDXLNodeArray *query_output_dxlnode_array = query_to_dxl_translator->GetQueryOutputCols();
+				CDXLNodeArray *cte_dxlnode_array = query_to_dxl_translator->GetCTEs();
+				GPOS_ASSERT(NULL != query_output_dxlnode_array);
+				optimizer_last_stats.translate_time += GetElapsedMS(phase_timer);
+				AddPhaseAllocations(&allocs, &alloc_bytes, &optimizer_last_stats.translate_allocs, &optimizer_last_stats.translate_alloc_bytes);
+
+				if (optimizer_prefetch_metadata)
+				{
+					PrefetchMDObjects(mp, &mda, (Query *) query_to_dxl_translator->Pquery());
+				}
 
-			CStatisticsConfig *stats_conf = optimizer_config->GetStatsConf();
-			col_stats = GPOS_NEW(mp) IMdIdArray(mp);
-			stats_conf->CollectMissingStatsColumns(col_stats);
+				BOOL is_master_only = !optimizer_enable_motions ||
+							(!optimizer_enable_motions_masteronly_queries && !query_to_dxl_translator->HasDistributedTables());
+				CAutoTraceFlag atf(EopttraceDisableMotions, is_master_only);
+
+				// the optimizer releases the search stages, they are kept
+				// to count what each of them found
+				if (NULL == search_strategy_arr)
+				{
+					search_strategy_arr = CSearchStage::PdrgpssDefault(mp);
+				}
+				search_strategy_arr->AddRef();
+				searched_stages_arr = search_strategy_arr;
+
+				CWallClock search_timer;
+				allocs = gpdb::GetOptimizerAllocations(&alloc_bytes);
+				plan_dxl = COptimizer::PdxlnOptimize
+										(
+										mp,
+										&mda,
+										query_dxl,
+										query_output_dxlnode_array,
+										cte_dxlnode_array,
+										expr_evaluator,
+										num_segments,
+										gp_session_id,
+										gp_command_count,
+										search_strategy_arr,
+										optimizer_config
+										);
+				optimizer_last_stats.search_time += GetElapsedMS(search_timer);
+				AddPhaseAllocations(&allocs, &alloc_bytes, &optimizer_last_stats.search_allocs, &optimizer_last_stats.search_alloc_bytes);
+
+				RecordSearchStageStats(searched_stages_arr);
+
+				// a search stage cut off by the budget returned its best plan
+				if (0 < search_time_budget && SearchTimeBudgetHit(searched_stages_arr, search_time_budget))
+				{
+					opt_ctxt->m_search_time_budget_hits++;
+					search_time_budget_num_hits++;
+					elog(DEBUG1, "[OPT]: Search time budget of %u ms hit, %llu times in the session",
+						 search_time_budget, search_time_budget_num_hits);
+				}
+				searched_stages_arr->Release();
+				searched_stages_arr = NULL;
 
-			rel_stats = GPOS_NEW(mp) MdidHashSet(mp);
-			PrintMissingStatsWarning(mp, &mda, col_stats, rel_stats);
+				// keep what's needed to reproduce a slow optimization
+				double optimization_time = optimizer_last_stats.translate_time + optimizer_last_stats.search_time;
+				if (0 < optimizer_capture_threshold && optimization_time >= (double) optimizer_capture_threshold)
+				{
+					CaptureOptimization(mp, &mda, query_dxl, query_output_dxlnode_array, cte_dxlnode_array, plan_dxl, optimizer_config, optimization_time);
+				}
 
-			rel_stats->Release();
-			col_stats->Release();
+				if (opt_ctxt->m_should_serialize_plan_dxl)
+				{
+					// serialize DXL to xml
+					CWStringDynamic plan_str(mp);
+					COstreamString oss(&plan_str);
+					CDXLUtils::SerializePlan(mp, oss, plan_dxl, optimizer_config->GetEnumeratorCfg()->GetPlanId(), optimizer_config->GetEnumeratorCfg()->GetPlanSpaceSize(), true /*serialize_header_footer*/, true /*indentation*/);
+					opt_ctxt->m_plan_dxl = CreateMultiByteCharStringFromWCString(plan_str.GetBuffer());
+				}
 
-			expr_evaluator->Release();
-			query_dxl->Release();
-			optimizer_config->Release();
-			plan_dxl->Release();
+				// translate DXL->PlStmt only when needed
+				if (opt_ctxt->m_should_generate_plan_stmt)
+				{
+					phase_timer.Restart();
+					allocs = gpdb::GetOptimizerAllocations(&alloc_bytes);
+
+					// always use opt_ctxt->m_query->can_set_tag as the query_to_dxl_translator->Pquery() is a mutated Query object
+					// that may not have the correct can_set_tag.
+					// The plan is built in the caller's memory context, and the
+					// translator doesn't share nodes between parts of the plan,
+					// so it's used as it is rather than copied
+					opt_ctxt->m_plan_stmt = ConvertToPlanStmtFromDXL(mp, &mda, plan_dxl, opt_ctxt->m_query->canSetTag, query_to_dxl_translator->GetDistributionHashOpsKind());
+					optimizer_last_stats.plan_time += GetElapsedMS(phase_timer);
+					AddPhaseAllocations(&allocs, &alloc_bytes, &optimizer_last_stats.plan_allocs, &optimizer_last_stats.plan_alloc_bytes);
+
+					if (NULL != plan_cache_query)
+					{
+						gpdb::OrcaPlanCacheStore(plan_cache_query, opt_ctxt->m_plan_stmt);
+
+						// a plan of another shape than the baseline of the
+						// query is only run when it's tried
+						opt_ctxt->m_plan_stmt = gpdb::OrcaPlanBaselineChoose(plan_cache_query, opt_ctxt->m_plan_stmt);
+					}
+				}
+
+				phase_timer.Restart();
+				CStatisticsConfig *stats_conf = optimizer_config->GetStatsConf();
+				col_stats = GPOS_NEW(mp) IMdIdArray(mp);
+				stats_conf->CollectMissingStatsColumns(col_stats);
+
+				rel_stats = GPOS_NEW(mp) MdidHashSet(mp);
+				PrintMissingStatsWarning(mp, &mda, col_stats, rel_stats);
+				optimizer_last_stats.missing_stats_time += GetElapsedMS(phase_timer);
+
+				rel_stats->Release();
+				col_stats->Release();
+
+				expr_evaluator->Release();
+				query_dxl->Release();
+				optimizer_config->Release();
+				plan_dxl->Release();
+			}
+			else
+			{
+				// otherwise released by the optimizer
+				CRefCount::SafeRelease(search_strategy_arr);
+			}
+
+			optimizer_last_stats.num_mdfetches += relcache_provider->GetNumFetches();
+			optimizer_last_stats.mdfetch_time += relcache_provider->GetFetchTimeUS() / 1000.0;
+			optimizer_last_stats.mdfetch_allocs += relcache_provider->GetFetchAllocs();
+			optimizer_last_stats.mdfetch_alloc_bytes += relcache_provider->GetFetchAllocBytes();
 		}
 	}
 	GPOS_CATCH_EX(ex)
 	{
+		if (is_allocator_limited)
+		{
+			gpdb::SetOptimizerMemoryLimit(0);
+		}
+
 		ResetTraceflags(enabled_trace_flags, disabled_trace_flags);
 		CRefCount::SafeRelease(rel_stats);
 		CRefCount::SafeRelease(col_stats);
@@ -787,18 +1755,60 @@ COptTasks::OptimizeTask
 		CRefCount::SafeRelease(disabled_trace_flags);
 		CRefCount::SafeRelease(trace_flags);
 		CRefCount::SafeRelease(plan_dxl);
-		CMDCache::Shutdown();
+		CRefCount::SafeRelease(searched_stages_arr);
+
+		// Running out of the memory limit is an expected fallback to the
+		// planner. Unless the allocators enforce it, the pool of the
+		// optimization is the only one limited
+		BOOL is_memory_limit_hit =
+			gpos::ullong_max != memory_limit &&
+			GPOS_MATCH_EX(ex, CException::ExmaSystem, CException::ExmiOOM);
+
+		// keep the metadata cache warm unless it may be corrupt, fallbacks
+		// are common for some workloads
+		if ((is_memory_limit_hit && !is_allocator_limited) || IsMDCacheIntact(ex))
+		{
+			mdcache_num_kept++;
+		}
+		else
+		{
+			CMDCache::Shutdown();
+			mdcache_num_rebuilt++;
+		}
+		elog(DEBUG1, "[OPT]: Metadata cache kept after %llu optimization failures, rebuilt after %llu",
+			 mdcache_num_kept, mdcache_num_rebuilt);
 
 		IErrorContext *errctxt = CTask::Self()->GetErrCtxt();
 
 		opt_ctxt->m_should_error_out = ShouldErrorOut(ex);
-		opt_ctxt->m_is_unexpected_failure = IsUnexpectedFailure(ex);
-		opt_ctxt->m_error_msg = CreateMultiByteCharStringFromWCString(errctxt->GetErrorMsg());
+		if (is_memory_limit_hit)
+		{
+			optimizer_last_stats.memory_limit_hits++;
+			memory_limit_num_hits++;
+			elog(DEBUG1, "[OPT]: Optimizer memory limit of %d kB hit, %llu times in the session",
+				 optimizer_memory_limit, memory_limit_num_hits);
+
+			const ULONG error_msg_len = 128;
+			opt_ctxt->m_is_unexpected_failure = false;
+			opt_ctxt->m_error_msg = (CHAR *) gpdb::GPDBAlloc(error_msg_len);
+			snprintf(opt_ctxt->m_error_msg, error_msg_len,
+					 "GPORCA exceeded optimizer_memory_limit of %d kB", optimizer_memory_limit);
+		}
+		else
+		{
+			opt_ctxt->m_is_unexpected_failure = IsUnexpectedFailure(ex);
+			opt_ctxt->m_error_msg = CreateMultiByteCharStringFromWCString(errctxt->GetErrorMsg());
+		}
 
 		GPOS_RETHROW(ex);
 	}
 	GPOS_CATCH_END;
 
+	if (is_allocator_limited)
+	{
+		gpdb::SetOptimizerMemoryLimit(0);
+	}
+
 	// cleanup
 	ResetTraceflags(enabled_trace_flags, disabled_trace_flags);
 	CRefCount::SafeRelease(enabled_trace_flags);
@@ -958,6 +1968,7 @@ COptTasks::SetXform
 	if (NULL != xform)
 	{
 		optimizer_xforms[xform->Exfid()] = should_disable;
+		xform_generation++;
 
 		return true;
 	}
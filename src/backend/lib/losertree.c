@@ -0,0 +1,223 @@
+/*-------------------------------------------------------------------------
+ *
+ * losertree.c
+ *	  A tree of losers, for merging sorted streams
+ *
+ * A binary heap takes up to two comparisons per level to sift a replaced
+ * first element down, and walks a different path of the array each time.  A
+ * tree of losers replays the matches of one leaf with one comparison per
+ * level, against the losers stored on the path from the leaf to the root,
+ * which is the same path every time that leaf wins.  That makes it the
+ * cheaper structure for k-way merges, where the first element is replaced by
+ * the next element of the stream it came from far more often than anything
+ * else happens.
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	  src/backend/lib/losertree.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "lib/losertree.h"
+
+/*
+ * Does leaf a win against leaf b?  Removed leaves lose against everything,
+ * and ties go to the lower leaf, so that the merge is stable.
+ */
+static inline bool
+leaf_wins(losertree *tree, int a, int b)
+{
+	int			cmp;
+
+	if (tree->lt_removed[a] || tree->lt_removed[b])
+		return !tree->lt_removed[a] && (tree->lt_removed[b] || a < b);
+
+	cmp = tree->lt_compare(tree->lt_leaves[a], tree->lt_leaves[b],
+						   tree->lt_arg);
+	return cmp > 0 || (cmp == 0 && a < b);
+}
+
+/*
+ * Replay the matches from a leaf up to the root, after its element changed.
+ * The leaves are the nodes lt_size .. 2 * lt_size - 1 of the tree.
+ */
+static void
+replay(losertree *tree, int leaf)
+{
+	int			winner = leaf;
+	int			node;
+
+	for (node = (leaf + tree->lt_size) / 2; node > 0; node /= 2)
+	{
+		int			loser = tree->lt_nodes[node];
+
+		if (leaf_wins(tree, loser, winner))
+		{
+			tree->lt_nodes[node] = winner;
+			winner = loser;
+		}
+	}
+	tree->lt_nodes[0] = winner;
+}
+
+/*
+ * losertree_allocate
+ *
+ * Returns a pointer to a newly-allocated tree that has the capacity to merge
+ * the given number of streams, in the order defined by the given comparator
+ * function, which will be invoked with the additional argument specified by
+ * 'arg'.
+ */
+losertree *
+losertree_allocate(int capacity, losertree_comparator compare, void *arg)
+{
+	losertree  *tree;
+
+	tree = (losertree *) palloc(sizeof(losertree));
+	tree->lt_space = capacity;
+	tree->lt_compare = compare;
+	tree->lt_arg = arg;
+	tree->lt_leaves = (Datum *) palloc(Max(capacity, 1) * sizeof(Datum));
+	tree->lt_removed = (bool *) palloc(Max(capacity, 1) * sizeof(bool));
+	tree->lt_nodes = (int *) palloc(Max(capacity, 1) * sizeof(int));
+
+	tree->lt_size = 0;
+	tree->lt_active = 0;
+	tree->lt_built = false;
+
+	return tree;
+}
+
+/*
+ * losertree_free
+ *
+ * Releases memory used by the given losertree.
+ */
+void
+losertree_free(losertree *tree)
+{
+	pfree(tree->lt_leaves);
+	pfree(tree->lt_removed);
+	pfree(tree->lt_nodes);
+	pfree(tree);
+}
+
+/*
+ * losertree_add_unordered
+ *
+ * Adds the first element of another stream to the tree, without playing its
+ * matches.  losertree_build() must be called before the tree is used.
+ */
+void
+losertree_add_unordered(losertree *tree, Datum d)
+{
+	if (tree->lt_size >= tree->lt_space)
+		elog(ERROR, "out of loser tree slots");
+
+	tree->lt_built = false;
+	tree->lt_leaves[tree->lt_size] = d;
+	tree->lt_removed[tree->lt_size] = false;
+	tree->lt_size++;
+	tree->lt_active++;
+}
+
+/*
+ * losertree_build
+ *
+ * Plays all the matches of the tree, bottom up.  O(n).
+ */
+void
+losertree_build(losertree *tree)
+{
+	int			size = tree->lt_size;
+	int		   *winners;
+	int			node;
+
+	if (size == 0)
+	{
+		tree->lt_built = true;
+		return;
+	}
+
+	/* winners[node] is the winner of the matches below node */
+	winners = (int *) palloc(2 * size * sizeof(int));
+	for (node = 0; node < size; node++)
+		winners[size + node] = node;
+
+	for (node = size - 1; node > 0; node--)
+	{
+		int			left = winners[2 * node];
+		int			right = winners[2 * node + 1];
+
+		if (leaf_wins(tree, left, right))
+		{
+			winners[node] = left;
+			tree->lt_nodes[node] = right;
+		}
+		else
+		{
+			winners[node] = right;
+			tree->lt_nodes[node] = left;
+		}
+	}
+	tree->lt_nodes[0] = (size > 1) ? winners[1] : 0;
+
+	pfree(winners);
+	tree->lt_built = true;
+}
+
+/*
+ * losertree_first
+ *
+ * Returns the greatest element of the tree.  The caller must ensure that
+ * this routine is not used on an empty tree.  O(1).
+ */
+Datum
+losertree_first(losertree *tree)
+{
+	Assert(!losertree_empty(tree) && tree->lt_built);
+	return tree->lt_leaves[tree->lt_nodes[0]];
+}
+
+/*
+ * losertree_remove_first
+ *
+ * Removes the greatest element of the tree, when its stream has ended, and
+ * returns it.  O(log n).
+ */
+Datum
+losertree_remove_first(losertree *tree)
+{
+	int			leaf;
+
+	Assert(!losertree_empty(tree) && tree->lt_built);
+
+	leaf = tree->lt_nodes[0];
+	tree->lt_removed[leaf] = true;
+	tree->lt_active--;
+	replay(tree, leaf);
+
+	return tree->lt_leaves[leaf];
+}
+
+/*
+ * losertree_replace_first
+ *
+ * Replaces the greatest element of the tree with the next element of the
+ * same stream.  One comparison per level, O(log n).
+ */
+void
+losertree_replace_first(losertree *tree, Datum d)
+{
+	int			leaf;
+
+	Assert(!losertree_empty(tree) && tree->lt_built);
+
+	leaf = tree->lt_nodes[0];
+	tree->lt_leaves[leaf] = d;
+	replay(tree, leaf);
+}
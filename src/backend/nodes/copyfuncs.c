@@ -146,6 +146,7 @@ _copyQueryDispatchDesc(const QueryDispatchDesc *from)
 	COPY_NODE_FIELD(oidAssignments);
 	COPY_NODE_FIELD(cursorPositions);
 	COPY_SCALAR_FIELD(useChangedAOOpts);
+	COPY_NODE_FIELD(broadcastCacheKeys);
 
 	return newnode;
 }
@@ -165,6 +166,19 @@ _copyOidAssignment(const OidAssignment *from)
 	return newnode;
 }
 
+static BroadcastCacheKey *
+_copyBroadcastCacheKey(const BroadcastCacheKey *from)
+{
+	BroadcastCacheKey *newnode = makeNode(BroadcastCacheKey);
+
+	COPY_SCALAR_FIELD(motionID);
+	COPY_SCALAR_FIELD(relid);
+	COPY_SCALAR_FIELD(version);
+	COPY_SCALAR_FIELD(overflowVersion);
+
+	return newnode;
+}
+
 /*
  * CopyPlanFields
  *
@@ -180,6 +194,7 @@ CopyPlanFields(const Plan *from, Plan *newnode)
 	COPY_SCALAR_FIELD(total_cost);
 	COPY_SCALAR_FIELD(plan_rows);
 	COPY_SCALAR_FIELD(plan_width);
+	COPY_SCALAR_FIELD(plan_fingerprint);
 	COPY_NODE_FIELD(targetlist);
 	COPY_NODE_FIELD(qual);
 	COPY_NODE_FIELD(lefttree);
@@ -1035,6 +1050,9 @@ _copySort(const Sort *from)
 
     /* CDB */
 	COPY_SCALAR_FIELD(noduplicates);
+	COPY_SCALAR_FIELD(numPresortedCols);
+	COPY_NODE_FIELD(limitOffset);
+	COPY_NODE_FIELD(limitCount);
 
 	COPY_SCALAR_FIELD(share_type);
 	COPY_SCALAR_FIELD(share_id);
@@ -1155,6 +1173,7 @@ _copyHash(const Hash *from)
 	COPY_SCALAR_FIELD(skewInherit);
 	COPY_SCALAR_FIELD(skewColType);
 	COPY_SCALAR_FIELD(skewColTypmod);
+	COPY_NODE_FIELD(skewValues);
 
 	return newnode;
 }
@@ -1309,6 +1328,8 @@ _copyMotion(const Motion *from)
 
 	COPY_SCALAR_FIELD(segidColIdx);
 
+	COPY_SCALAR_FIELD(compressTuples);
+
 	return newnode;
 }
 
@@ -5117,6 +5138,9 @@ copyObject(const void *from)
 		case T_OidAssignment:
 			retval = _copyOidAssignment(from);
 			break;
+		case T_BroadcastCacheKey:
+			retval = _copyBroadcastCacheKey(from);
+			break;
 		case T_Plan:
 			retval = _copyPlan(from);
 			break;
@@ -287,6 +287,7 @@ _outPlanInfo(StringInfo str, const Plan *node)
 	WRITE_FLOAT_FIELD(total_cost, "%.2f");
 	WRITE_FLOAT_FIELD(plan_rows, "%.0f");
 	WRITE_INT_FIELD(plan_width);
+	WRITE_UINT_FIELD(plan_fingerprint);
 
 	WRITE_NODE_FIELD(targetlist);
 	WRITE_NODE_FIELD(qual);
@@ -509,6 +510,9 @@ _outSort(StringInfo str, Sort *node)
 
     /* CDB */
     WRITE_BOOL_FIELD(noduplicates);
+	WRITE_INT_FIELD(numPresortedCols);
+	WRITE_NODE_FIELD(limitOffset);
+	WRITE_NODE_FIELD(limitCount);
 
 	WRITE_ENUM_FIELD(share_type, ShareType);
 	WRITE_INT_FIELD(share_id);
@@ -588,6 +592,8 @@ _outMotion(StringInfo str, Motion *node)
 
 	WRITE_INT_FIELD(segidColIdx);
 
+	WRITE_BOOL_FIELD(compressTuples);
+
 	_outPlanInfo(str, (Plan *) node);
 }
 
@@ -1316,6 +1322,9 @@ _outNode(StringInfo str, void *obj)
 			case T_OidAssignment:
 				_outOidAssignment(str,obj);
 				break;
+			case T_BroadcastCacheKey:
+				_outBroadcastCacheKey(str,obj);
+				break;
 			case T_Plan:
 				_outPlan(str, obj);
 				break;
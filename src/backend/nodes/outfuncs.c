@@ -337,6 +337,7 @@ _outQueryDispatchDesc(StringInfo str, const QueryDispatchDesc *node)
 	WRITE_NODE_FIELD(sliceTable);
 	WRITE_NODE_FIELD(cursorPositions);
 	WRITE_BOOL_FIELD(useChangedAOOpts);
+	WRITE_NODE_FIELD(broadcastCacheKeys);
 }
 
 static void
@@ -352,6 +353,17 @@ _outOidAssignment(StringInfo str, const OidAssignment *node)
 	WRITE_OID_FIELD(oid);
 }
 
+static void
+_outBroadcastCacheKey(StringInfo str, const BroadcastCacheKey *node)
+{
+	WRITE_NODE_TYPE("BROADCASTCACHEKEY");
+
+	WRITE_INT_FIELD(motionID);
+	WRITE_OID_FIELD(relid);
+	WRITE_UINT64_FIELD(version);
+	WRITE_UINT64_FIELD(overflowVersion);
+}
+
 #ifndef COMPILING_BINARY_FUNCS
 /*
  * print the basic stuff of all nodes that inherit from Plan
@@ -365,6 +377,7 @@ _outPlanInfo(StringInfo str, const Plan *node)
 	WRITE_FLOAT_FIELD(total_cost, "%.2f");
 	WRITE_FLOAT_FIELD(plan_rows, "%.0f");
 	WRITE_INT_FIELD(plan_width);
+	WRITE_UINT_FIELD(plan_fingerprint);
 
 	WRITE_NODE_FIELD(targetlist);
 	WRITE_NODE_FIELD(qual);
@@ -1022,6 +1035,9 @@ _outSort(StringInfo str, const Sort *node)
 
 	/* CDB */
     WRITE_BOOL_FIELD(noduplicates);
+	WRITE_INT_FIELD(numPresortedCols);
+	WRITE_NODE_FIELD(limitOffset);
+	WRITE_NODE_FIELD(limitCount);
 
 	WRITE_ENUM_FIELD(share_type, ShareType);
 	WRITE_INT_FIELD(share_id);
@@ -1065,6 +1081,7 @@ _outHash(StringInfo str, const Hash *node)
 	WRITE_BOOL_FIELD(skewInherit);
 	WRITE_OID_FIELD(skewColType);
 	WRITE_INT_FIELD(skewColTypmod);
+	WRITE_NODE_FIELD(skewValues);
 
 	WRITE_BOOL_FIELD(rescannable);          /*CDB*/
 }
@@ -1188,6 +1205,8 @@ _outMotion(StringInfo str, const Motion *node)
 
 	WRITE_INT_FIELD(segidColIdx);
 
+	WRITE_BOOL_FIELD(compressTuples);
+
 	_outPlanInfo(str, (Plan *) node);
 }
 #endif /* COMPILING_BINARY_FUNCS */
@@ -4682,6 +4701,9 @@ _outNode(StringInfo str, const void *obj)
 			case T_OidAssignment:
 				_outOidAssignment(str, obj);
 				break;
+			case T_BroadcastCacheKey:
+				_outBroadcastCacheKey(str, obj);
+				break;
 			case T_Plan:
 				_outPlan(str, obj);
 				break;
@@ -1446,6 +1446,7 @@ _readQueryDispatchDesc(void)
 	READ_NODE_FIELD(sliceTable);
 	READ_NODE_FIELD(cursorPositions);
 	READ_BOOL_FIELD(useChangedAOOpts);
+	READ_NODE_FIELD(broadcastCacheKeys);
 	READ_DONE();
 }
 
@@ -1463,6 +1464,18 @@ _readOidAssignment(void)
 	READ_DONE();
 }
 
+static BroadcastCacheKey *
+_readBroadcastCacheKey(void)
+{
+	READ_LOCALS(BroadcastCacheKey);
+
+	READ_INT_FIELD(motionID);
+	READ_OID_FIELD(relid);
+	READ_UINT64_FIELD(version);
+	READ_UINT64_FIELD(overflowVersion);
+	READ_DONE();
+}
+
 /*
  * _readPlan
  */
@@ -2092,6 +2105,9 @@ _readSort(void)
 
     /* CDB */
 	READ_BOOL_FIELD(noduplicates);
+	READ_INT_FIELD(numPresortedCols);
+	READ_NODE_FIELD(limitOffset);
+	READ_NODE_FIELD(limitCount);
 
 	READ_ENUM_FIELD(share_type, ShareType);
 	READ_INT_FIELD(share_id);
@@ -2206,6 +2222,7 @@ _readHash(void)
 	READ_BOOL_FIELD(skewInherit);
 	READ_OID_FIELD(skewColType);
 	READ_INT_FIELD(skewColTypmod);
+	READ_NODE_FIELD(skewValues);
 
     READ_BOOL_FIELD(rescannable);           /*CDB*/
 
@@ -2261,6 +2278,8 @@ _readMotion(void)
 
 	READ_INT_FIELD(segidColIdx);
 
+	READ_BOOL_FIELD(compressTuples);
+
 	readPlanInfo((Plan *)local_node);
 
 	READ_DONE();
@@ -2400,6 +2419,7 @@ void readPlanInfo(Plan *local_node)
 	READ_FLOAT_FIELD(total_cost);
 	READ_FLOAT_FIELD(plan_rows);
 	READ_INT_FIELD(plan_width);
+	READ_UINT_FIELD(plan_fingerprint);
 
 	READ_NODE_FIELD(targetlist);
 	READ_NODE_FIELD(qual);
@@ -3072,6 +3092,9 @@ readNodeBinary(void)
 			case T_OidAssignment:
 				return_value = _readOidAssignment();
 				break;
+			case T_BroadcastCacheKey:
+				return_value = _readBroadcastCacheKey();
+				break;
 			case T_Plan:
 					return_value = _readPlan();
 					break;
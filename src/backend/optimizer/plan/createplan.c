@@ -841,6 +841,7 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path)
 	List	   *tlist = build_path_tlist(root, &best_path->path);
 	List	   *subplans = NIL;
 	ListCell   *subpaths;
+	Plan	   *partition_selector;
 
 	/*
 	 * The subpaths list could be empty, if every child was proven empty by
@@ -861,6 +862,16 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path)
 									NULL);
 	}
 
+	/*
+	 * If the partitions of a partitioned table can be selected when the
+	 * execution starts, by the parameters of the query, put the Partition
+	 * Selector first.
+	 */
+	partition_selector = create_partition_selector_for_params(root,
+															  best_path->path.parent);
+	if (partition_selector)
+		subplans = lappend(subplans, partition_selector);
+
 	/* Build the plan for each child */
 	foreach(subpaths, best_path->subpaths)
 	{
@@ -5683,6 +5694,10 @@ make_motion(PlannerInfo *root, Plan *lefttree,
 
 	node->sendSorted = (numSortCols > 0);
 
+	/* compress the packets of the motions that send a lot of data */
+	node->compressTuples = GpInterconnectCompressMotion(plan->plan_rows,
+														plan->plan_width);
+
 	plan->extParam = bms_copy(lefttree->extParam);
 	plan->allParam = bms_copy(lefttree->allParam);
 
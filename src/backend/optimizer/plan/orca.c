@@ -22,54 +22,334 @@
 #include "postgres.h"
 
 #include "cdb/cdbmutate.h"		/* apply_shareinput */
+#include "cdb/cdbpartition.h"
 #include "cdb/cdbvars.h"
 #include "nodes/makefuncs.h"
 #include "optimizer/orca.h"
+#include "optimizer/orcacse.h"
+#include "optimizer/orcahashskew.h"
+#include "optimizer/orcaincrsort.h"
+#include "optimizer/orcajoinsearch.h"
+#include "optimizer/orcaindexonly.h"
+#include "optimizer/orcamatview.h"
+#include "optimizer/orcapartjoin.h"
+#include "optimizer/orcaslots.h"
+#include "optimizer/orcawindowsort.h"
 #include "optimizer/paths.h"
+#include "optimizer/plancat.h"
 #include "optimizer/planmain.h"
 #include "optimizer/planner.h"
 #include "optimizer/transform.h"
 #include "portability/instr_time.h"
+#include "tcop/tcopprot.h"
+#include "utils/ext_alloc.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
 #include "utils/lsyscache.h"
+#include "utils/memaccounting.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/timestamp.h"
 
 /* GPORCA entry point */
 extern PlannedStmt * GPOPTOptimizedPlan(Query *parse, bool *had_unexpected_failure);
 
+OptimizerStats optimizer_last_stats;
+OptimizerStats optimizer_total_stats;
+
+OptimizerSearchStageStats optimizer_search_stage_stats[OPTIMIZER_MAX_SEARCH_STAGES];
+int			optimizer_num_search_stages = 0;
+
+/*
+ * Facts about the relations of the current optimization that are costly to
+ * compute. ORCA asks for the row count of a relation for the relation and
+ * again for every column it needs the statistics of, and for the partition
+ * constraints of a partitioned table for the table and again for each of its
+ * indexes. Each of them may walk all the partitions of the table.
+ */
+typedef struct RelFactsEntry
+{
+	Oid			relid;			/* hash key, must be first */
+
+	bool		has_numtuples;
+	double		numtuples;
+	bool		stats_missing;
+
+	bool		has_num_leaf_parts;
+	int			num_leaf_parts;
+
+	bool		has_part_constraints;
+	Node	   *part_constraints;
+	List	   *default_levels;
+} RelFactsEntry;
+
+static MemoryContext relfacts_context = NULL;
+static HTAB *relfacts_cache = NULL;
+
+/*
+ * Ring of the latest slow optimizations, in TopMemoryContext. The oldest one
+ * is at next_capture once the ring is full.
+ */
+static OptimizerCapture captures[OPTIMIZER_NUM_CAPTURES];
+static int	num_captures = 0;
+static int	next_capture = 0;
+
+static void
+reset_relfacts_cache(void)
+{
+	if (relfacts_context != NULL)
+	{
+		MemoryContextDelete(relfacts_context);
+		relfacts_context = NULL;
+		relfacts_cache = NULL;
+	}
+}
+
+static RelFactsEntry *
+get_relfacts_entry(Oid relid)
+{
+	RelFactsEntry *entry;
+	bool		found;
+
+	if (relfacts_cache == NULL)
+	{
+		HASHCTL		info;
+
+		relfacts_context = AllocSetContextCreate(TopMemoryContext,
+												 "ORCA relation facts",
+												 ALLOCSET_DEFAULT_MINSIZE,
+												 ALLOCSET_DEFAULT_INITSIZE,
+												 ALLOCSET_DEFAULT_MAXSIZE);
+
+		MemSet(&info, 0, sizeof(info));
+		info.keysize = sizeof(Oid);
+		info.entrysize = sizeof(RelFactsEntry);
+		info.hash = oid_hash;
+		info.hcxt = relfacts_context;
+
+		relfacts_cache = hash_create("ORCA relation facts", 64, &info,
+									 HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+	}
+
+	entry = (RelFactsEntry *) hash_search(relfacts_cache, &relid,
+										  HASH_ENTER, &found);
+	if (!found)
+	{
+		entry->has_numtuples = false;
+		entry->has_num_leaf_parts = false;
+		entry->has_part_constraints = false;
+	}
+
+	return entry;
+}
+
+/*
+ * orca_estimate_partitioned_numtuples
+ *	  cdb_estimate_partitioned_numtuples(), computed once per relation in an
+ *	  optimization.
+ */
+double
+orca_estimate_partitioned_numtuples(Relation rel, bool *stats_missing)
+{
+	RelFactsEntry *entry = get_relfacts_entry(RelationGetRelid(rel));
+
+	if (!entry->has_numtuples)
+	{
+		entry->numtuples = cdb_estimate_partitioned_numtuples(rel,
+															  &entry->stats_missing);
+		entry->has_numtuples = true;
+	}
+
+	*stats_missing = entry->stats_missing;
+	return entry->numtuples;
+}
+
+/*
+ * orca_count_leaf_part_tables
+ *	  countLeafPartTables(), computed once per table in an optimization.
+ */
+int
+orca_count_leaf_part_tables(Oid rootOid)
+{
+	RelFactsEntry *entry = get_relfacts_entry(rootOid);
+
+	if (!entry->has_num_leaf_parts)
+	{
+		entry->num_leaf_parts = countLeafPartTables(rootOid);
+		entry->has_num_leaf_parts = true;
+	}
+
+	return entry->num_leaf_parts;
+}
+
+/*
+ * orca_get_relation_part_constraints
+ *	  get_relation_part_constraints(), computed once per table in an
+ *	  optimization. The caller gets its own copy of the result.
+ */
+Node *
+orca_get_relation_part_constraints(Oid rootOid, List **defaultLevels)
+{
+	RelFactsEntry *entry = get_relfacts_entry(rootOid);
+
+	if (!entry->has_part_constraints)
+	{
+		List	   *default_levels = NIL;
+		Node	   *part_constraints;
+		MemoryContext oldcontext;
+
+		part_constraints = get_relation_part_constraints(rootOid,
+														 &default_levels);
+
+		oldcontext = MemoryContextSwitchTo(relfacts_context);
+		entry->part_constraints = copyObject(part_constraints);
+		entry->default_levels = list_copy(default_levels);
+		MemoryContextSwitchTo(oldcontext);
+
+		entry->has_part_constraints = true;
+	}
+
+	*defaultLevels = list_concat(*defaultLevels,
+								 list_copy(entry->default_levels));
+	return copyObject(entry->part_constraints);
+}
+
+/*
+ * Keep the minidump of an optimization that took longer than
+ * optimizer_capture_threshold, in place of the oldest one kept.
+ */
+void
+orca_capture_optimization(double optimization_time, const char *minidump)
+{
+	OptimizerCapture *capture = &captures[next_capture];
+
+	if (capture->minidump != NULL)
+	{
+		if (capture->query_text != NULL)
+			pfree(capture->query_text);
+		pfree(capture->minidump);
+	}
+
+	capture->captured_at = GetCurrentTimestamp();
+	capture->optimization_time = optimization_time;
+	capture->query_text = debug_query_string ?
+		MemoryContextStrdup(TopMemoryContext, debug_query_string) : NULL;
+	capture->minidump = MemoryContextStrdup(TopMemoryContext, minidump);
+
+	next_capture = (next_capture + 1) % OPTIMIZER_NUM_CAPTURES;
+	num_captures = Min(num_captures + 1, OPTIMIZER_NUM_CAPTURES);
+
+	elog(LOG, "GPORCA took %.3f ms to optimize the query, minidump kept for gp_optimizer_captures()",
+		 optimization_time);
+}
+
+/*
+ * The n-th oldest slow optimization kept, or NULL if there are fewer.
+ */
+const OptimizerCapture *
+orca_get_capture(int n)
+{
+	if (n < 0 || n >= num_captures)
+		return NULL;
+
+	return &captures[(next_capture - num_captures + n + OPTIMIZER_NUM_CAPTURES) %
+					 OPTIMIZER_NUM_CAPTURES];
+}
+
+/*
+ * Add the statistics of the last optimization to the ones of the backend
+ */
+static void
+accumulate_optimizer_stats(void)
+{
+	OptimizerStats *last = &optimizer_last_stats;
+	OptimizerStats *total = &optimizer_total_stats;
+
+	total->num_optimizations += last->num_optimizations;
+	total->translate_time += last->translate_time;
+	total->search_time += last->search_time;
+	total->plan_time += last->plan_time;
+	total->missing_stats_time += last->missing_stats_time;
+	total->num_mdfetches += last->num_mdfetches;
+	total->mdfetch_time += last->mdfetch_time;
+	total->peak_memory = Max(total->peak_memory, last->peak_memory);
+	total->memory_limit_hits += last->memory_limit_hits;
+	total->translate_allocs += last->translate_allocs;
+	total->translate_alloc_bytes += last->translate_alloc_bytes;
+	total->search_allocs += last->search_allocs;
+	total->search_alloc_bytes += last->search_alloc_bytes;
+	total->plan_allocs += last->plan_allocs;
+	total->plan_alloc_bytes += last->plan_alloc_bytes;
+	total->mdfetch_allocs += last->mdfetch_allocs;
+	total->mdfetch_alloc_bytes += last->mdfetch_alloc_bytes;
+}
+
+/*
+ * Detail of the log messages of an optimization: where the time went, and
+ * the peak memory.
+ */
+static int
+errdetail_optimizer_stats(void)
+{
+	OptimizerStats *stats = &optimizer_last_stats;
+
+	return errdetail("Optimizer phases: translation=%.3f ms search=%.3f ms plan generation=%.3f ms, peak memory=" INT64_FORMAT "kB",
+					 stats->translate_time, stats->search_time,
+					 stats->plan_time, (stats->peak_memory + 1023) / 1024);
+}
+
 /*
  * Logging of optimization outcome
  */
 static void
 log_optimizer(PlannedStmt *plan, bool fUnexpectedFailure)
 {
+	/*
+	 * Optimizations that ran out of memory are always logged, they are
+	 * pathological queries the memory limit protects the master from.
+	 */
+	if (optimizer_last_stats.memory_limit_hits > 0)
+		ereport(LOG,
+				(errmsg("GPORCA exceeded optimizer_memory_limit of %d kB, falling back to planner",
+						optimizer_memory_limit),
+				 errdetail_optimizer_stats()));
+
 	/* optimizer logging is not enabled */
 	if (!optimizer_log)
 		return;
 
 	if (plan != NULL)
 	{
-		elog(DEBUG1, "GPORCA produced plan");
+		ereport(DEBUG1,
+				(errmsg("GPORCA produced plan"),
+				 errdetail_optimizer_stats()));
 		return;
 	}
 
 	/* optimizer failed to produce a plan, log failure */
 	if (OPTIMIZER_ALL_FAIL == optimizer_log_failure)
 	{
-		elog(LOG, "Planner produced plan :%d", fUnexpectedFailure);
+		ereport(LOG,
+				(errmsg("Planner produced plan :%d", fUnexpectedFailure),
+				 errdetail_optimizer_stats()));
 		return;
 	}
 
 	if (fUnexpectedFailure && OPTIMIZER_UNEXPECTED_FAIL == optimizer_log_failure)
 	{
 		/* unexpected fall back */
-		elog(LOG, "Planner produced plan :%d", fUnexpectedFailure);
+		ereport(LOG,
+				(errmsg("Planner produced plan :%d", fUnexpectedFailure),
+				 errdetail_optimizer_stats()));
 		return;
 	}
 
 	if (!fUnexpectedFailure && OPTIMIZER_EXPECTED_FAIL == optimizer_log_failure)
 	{
 		/* expected fall back */
-		elog(LOG, "Planner produced plan :%d", fUnexpectedFailure);
+		ereport(LOG,
+				(errmsg("Planner produced plan :%d", fUnexpectedFailure),
+				 errdetail_optimizer_stats()));
 	}
 }
 
@@ -138,8 +418,39 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	 */
 	pqueryCopy = preprocess_query_optimizer(root, pqueryCopy, boundParams);
 
-	/* Ok, invoke ORCA. */
-	result = GPOPTOptimizedPlan(pqueryCopy, &fUnexpectedFailure);
+	/* Answer the query from a materialized view of its table, if one matches */
+	if (optimizer_enable_matview_rewrite)
+		pqueryCopy = orca_rewrite_matview(pqueryCopy);
+
+	/* Ok, invoke ORCA. It fills in the phase times of the statistics. */
+	MemSet(&optimizer_last_stats, 0, sizeof(optimizer_last_stats));
+	optimizer_last_stats.num_optimizations = 1;
+
+	/* Search the join orders of large joins with DP, if within the budget */
+	orca_choose_join_search(pqueryCopy);
+
+	/* the facts found by an earlier optimization may be stale */
+	reset_relfacts_cache();
+
+	OrcaSlotAcquire();
+	PG_TRY();
+	{
+		result = GPOPTOptimizedPlan(pqueryCopy, &fUnexpectedFailure);
+	}
+	PG_CATCH();
+	{
+		OrcaSlotRelease();
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	OrcaSlotRelease();
+
+	reset_relfacts_cache();
+
+	Ext_OptimizerFlushAccounting();
+	optimizer_last_stats.peak_memory =
+		MemoryAccounting_GetAccountPeakBalance(ActiveMemoryAccountId);
+	accumulate_optimizer_stats();
 
 	log_optimizer(result, fUnexpectedFailure);
 
@@ -156,6 +467,23 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	 * Post-process the plan.
 	 */
 
+	/* These add range table entries, so do them before copying them out. */
+	if (optimizer_enable_partition_wise_join)
+		orca_partition_wise_joins(result);
+	if (optimizer_enable_partition_merge_append)
+		orca_partition_merge_appends(result);
+
+	if (optimizer_enable_indexonlyscan)
+		orca_index_only_scans(result);
+	if (optimizer_enable_shared_window_sort)
+		orca_shared_window_sorts(result);
+	if (optimizer_enable_incremental_sort)
+		orca_incremental_sorts(result);
+	if (optimizer_enable_hashjoin_skew)
+		orca_hash_join_skew(result);
+	if (optimizer_enable_common_subexpressions)
+		orca_common_subexpressions(result);
+
 	/*
 	 * ORCA filled in the final range table and subplans directly in the
 	 * PlannedStmt. We might need to modify them still, so copy them out to
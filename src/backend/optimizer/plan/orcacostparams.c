@@ -0,0 +1,109 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcacostparams.c
+ *	  Calibrated parameters of the GPORCA cost model, from the
+ *	  gp_optimizer_cost_params catalog.
+ *
+ * The defaults of the calibrated cost model were fitted on hardware that is
+ * nothing like every cluster.  gpcalibratecost runs probe queries, fits the
+ * parameters of the cost model to the runtimes it measured, and stores the
+ * factors to multiply the defaults by in gp_optimizer_cost_params.
+ *
+ * The catalog is read once per backend, the first time GPORCA builds a cost
+ * model, so sessions started after a calibration use its parameters.  Only
+ * the master optimizes queries, so the catalog isn't kept on the segments.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcacostparams.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "catalog/gp_optimizer_cost_params.h"
+#include "optimizer/orcacostparams.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+static OrcaCostParam *OrcaCostParams = NULL;
+static int	OrcaNumCostParams = 0;
+static bool OrcaCostParamsLoaded = false;
+
+static void
+OrcaCostParamsLoad(void)
+{
+	Relation	rel;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	OrcaCostParam *params;
+	int			num_params = 0;
+	int			max_params = 16;
+
+	params = (OrcaCostParam *) palloc(max_params * sizeof(OrcaCostParam));
+
+	rel = heap_open(GpOptimizerCostParamsRelationId, AccessShareLock);
+	scan = systable_beginscan(rel, InvalidOid, false, NULL, 0, NULL);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_gp_optimizer_cost_params form =
+			(Form_gp_optimizer_cost_params) GETSTRUCT(tuple);
+
+		/* a factor that isn't positive would make the costs meaningless */
+		if (!(form->factor > 0.0))
+		{
+			elog(DEBUG1, "ignoring cost parameter \"%s\" with factor %g",
+				 NameStr(form->paramname), form->factor);
+			continue;
+		}
+
+		if (num_params == max_params)
+		{
+			max_params *= 2;
+			params = (OrcaCostParam *)
+				repalloc(params, max_params * sizeof(OrcaCostParam));
+		}
+
+		strlcpy(params[num_params].name, NameStr(form->paramname),
+				NAMEDATALEN);
+		params[num_params].factor = form->factor;
+		num_params++;
+	}
+
+	systable_endscan(scan);
+	heap_close(rel, AccessShareLock);
+
+	if (num_params > 0)
+	{
+		OrcaCostParams = (OrcaCostParam *)
+			MemoryContextAlloc(TopMemoryContext,
+							   num_params * sizeof(OrcaCostParam));
+		memcpy(OrcaCostParams, params, num_params * sizeof(OrcaCostParam));
+	}
+	OrcaNumCostParams = num_params;
+	OrcaCostParamsLoaded = true;
+
+	pfree(params);
+}
+
+/*
+ * OrcaCostParamsGet -- return the calibrated cost model parameters, and their
+ * number in *num_params.
+ *
+ * The array belongs to this module, callers mustn't modify or free it.
+ */
+OrcaCostParam *
+OrcaCostParamsGet(int *num_params)
+{
+	if (!OrcaCostParamsLoaded)
+		OrcaCostParamsLoad();
+
+	*num_params = OrcaNumCostParams;
+	return OrcaCostParams;
+}
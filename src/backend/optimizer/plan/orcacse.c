@@ -0,0 +1,317 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcacse.c
+ *	  Evaluate the expressions that the filter and the target list of a
+ *	  GPORCA scan share once per row.
+ *
+ * GPORCA translates the projection and the filter of a scan independently,
+ * so a query like
+ *
+ *		SELECT lower(url) FROM t WHERE lower(url) LIKE 'a%'
+ *
+ * evaluates lower(url) once in the qual of the scan, and again in its target
+ * list for each row that passes.  When optimizer_enable_common_subexpressions
+ * is on, the expressions that a conjunct of the qual always evaluates, and
+ * that the target list or the following conjuncts evaluate too, are computed
+ * once by the target list of the scan, and a Result node above it evaluates
+ * the rest of the qual and the target list on top of them.
+ *
+ * The conjuncts before the first one with such an expression stay in the
+ * scan, so the shared expressions are computed for the same rows as before,
+ * and an expression that raises an error for a row that an earlier conjunct
+ * rejects is still not evaluated for it.  Expressions under conditional
+ * constructs like CASE or OR are not computed ahead for the same reason.
+ * Column-oriented tables keep their qual, for it lets them read the other
+ * columns only for the rows that pass, see aocs_set_late_quals().
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcacse.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "catalog/pg_class.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/orcacse.h"
+#include "parser/parsetree.h"
+#include "utils/lsyscache.h"
+
+typedef struct
+{
+	List	   *tlist;			/* the expressions to look for */
+	List	   *found;			/* the ones found, in no particular order */
+} SharedExprContext;
+
+typedef struct
+{
+	Index		scanrelid;
+	List	   *exprs;			/* the shared expressions */
+	List	   *vars;			/* the Vars of the scan returned after them */
+} ReplaceContext;
+
+/* Returns true if the node is equal to a node of the expression */
+static bool
+contains_equal_walker(Node *node, Node *target)
+{
+	if (node == NULL)
+		return false;
+	if (equal(node, target))
+		return true;
+	return expression_tree_walker(node, contains_equal_walker, (void *) target);
+}
+
+/*
+ * Collect the subexpressions that the conjunct always evaluates, which are
+ * worth to compute once and that the target list evaluates too.
+ */
+static bool
+shared_exprs_walker(Node *node, SharedExprContext *context)
+{
+	if (node == NULL)
+		return false;
+
+	/* the arguments of these are evaluated for some rows only */
+	if (IsA(node, BoolExpr) || IsA(node, CaseExpr) ||
+		IsA(node, CoalesceExpr) || IsA(node, RowCompareExpr))
+		return false;
+
+	if (!IsA(node, Var) && !IsA(node, Const) && !IsA(node, Param) &&
+		!IsA(node, RelabelType) && !IsA(node, List) &&
+		contains_equal_walker((Node *) context->tlist, node) &&
+		!contain_volatile_functions(node) &&
+		!expression_returns_set(node))
+	{
+		if (!list_member(context->found, node))
+			context->found = lappend(context->found, node);
+		return false;
+	}
+
+	return expression_tree_walker(node, shared_exprs_walker, (void *) context);
+}
+
+/* Returns true if the expression has a Var that's not of the scanned table */
+static bool
+foreign_var_walker(Node *node, Index *scanrelid)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Var))
+		return ((Var *) node)->varno != *scanrelid ||
+			((Var *) node)->varlevelsup != 0;
+	return expression_tree_walker(node, foreign_var_walker, (void *) scanrelid);
+}
+
+/*
+ * Make an expression of the scan evaluate on the output of the scan instead:
+ * the shared expressions and the Vars of the table refer to the columns of
+ * the new target list of the scan.
+ */
+static Node *
+replace_mutator(Node *node, ReplaceContext *context)
+{
+	ListCell   *lc;
+	AttrNumber	attno;
+
+	if (node == NULL)
+		return NULL;
+
+	attno = 1;
+	foreach(lc, context->exprs)
+	{
+		if (equal(node, lfirst(lc)))
+			return (Node *) makeVar(OUTER_VAR, attno,
+									exprType(node),
+									exprTypmod(node),
+									exprCollation(node),
+									0);
+		attno++;
+	}
+
+	if (IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
+		Var		   *outer;
+
+		foreach(lc, context->vars)
+		{
+			if (equal(var, lfirst(lc)))
+				break;
+			attno++;
+		}
+		if (lc == NULL)
+			context->vars = lappend(context->vars, copyObject(var));
+
+		outer = makeVar(OUTER_VAR, attno, var->vartype, var->vartypmod,
+						var->varcollid, 0);
+		outer->varnoold = var->varno;
+		outer->varoattno = var->varattno;
+		return (Node *) outer;
+	}
+
+	return expression_tree_mutator(node, replace_mutator, (void *) context);
+}
+
+/*
+ * If the filter and the target list of the scan share expressions, compute
+ * them once in the scan, and return the Result node above it that evaluates
+ * the rest.  Otherwise return the scan as it is.
+ */
+static Plan *
+cse_scan(PlannedStmt *stmt, SeqScan *scan)
+{
+	Plan	   *plan = &scan->plan;
+	RangeTblEntry *rte;
+	SharedExprContext shared;
+	ReplaceContext replace;
+	List	   *scanqual = NIL;
+	List	   *restqual = NIL;
+	List	   *tlist;
+	ListCell   *lc;
+	Result	   *result;
+	AttrNumber	attno;
+
+	if (plan->qual == NIL || plan->targetlist == NIL)
+		return plan;
+
+	rte = rt_fetch(scan->scanrelid, stmt->rtable);
+	if (rte->rtekind != RTE_RELATION ||
+		get_rel_relstorage(rte->relid) == RELSTORAGE_AOCOLS)
+		return plan;
+
+	if (foreign_var_walker((Node *) plan->qual, &scan->scanrelid) ||
+		foreign_var_walker((Node *) plan->targetlist, &scan->scanrelid) ||
+		contain_subplans((Node *) plan->qual) ||
+		contain_subplans((Node *) plan->targetlist) ||
+		expression_returns_set((Node *) plan->targetlist))
+		return plan;
+
+	/*
+	 * Find the first conjunct with expressions that the target list, or the
+	 * conjuncts after it, evaluate too.
+	 */
+	shared.found = NIL;
+	foreach(lc, plan->qual)
+	{
+		Node	   *conjunct = (Node *) lfirst(lc);
+
+		shared.tlist = list_concat(list_copy(plan->targetlist),
+								   list_copy_tail(plan->qual,
+												  list_length(scanqual) + 1));
+		shared_exprs_walker(conjunct, &shared);
+		list_free(shared.tlist);
+
+		if (shared.found != NIL)
+		{
+			restqual = list_copy_tail(plan->qual, list_length(scanqual));
+			break;
+		}
+		scanqual = lappend(scanqual, conjunct);
+	}
+
+	if (shared.found == NIL)
+	{
+		list_free(scanqual);
+		return plan;
+	}
+
+	replace.scanrelid = scan->scanrelid;
+	replace.exprs = shared.found;
+	replace.vars = NIL;
+
+	result = makeNode(Result);
+	result->plan.qual = (List *) replace_mutator((Node *) restqual, &replace);
+	result->plan.targetlist = (List *) replace_mutator((Node *) plan->targetlist,
+													   &replace);
+
+	/* the scan returns the shared expressions, then the Vars the rest needs */
+	tlist = NIL;
+	attno = 1;
+	foreach(lc, replace.exprs)
+	{
+		tlist = lappend(tlist, makeTargetEntry((Expr *) copyObject(lfirst(lc)),
+											   attno++, NULL, false));
+	}
+	foreach(lc, replace.vars)
+	{
+		tlist = lappend(tlist, makeTargetEntry((Expr *) lfirst(lc),
+											   attno++, NULL, false));
+	}
+
+	plan->qual = scanqual;
+	plan->targetlist = tlist;
+
+	result->plan.lefttree = plan;
+	result->plan.startup_cost = plan->startup_cost;
+	result->plan.total_cost = plan->total_cost;
+	result->plan.plan_rows = plan->plan_rows;
+	result->plan.plan_width = plan->plan_width;
+	result->plan.extParam = bms_copy(plan->extParam);
+	result->plan.allParam = bms_copy(plan->allParam);
+	result->plan.flow = copyObject(plan->flow);
+
+	return (Plan *) result;
+}
+
+static Plan *cse_walk(PlannedStmt *stmt, Plan *plan);
+
+static void
+cse_walk_list(PlannedStmt *stmt, List *plans)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+		lfirst(lc) = cse_walk(stmt, (Plan *) lfirst(lc));
+}
+
+static Plan *
+cse_walk(PlannedStmt *stmt, Plan *plan)
+{
+	if (plan == NULL)
+		return NULL;
+
+	plan->lefttree = cse_walk(stmt, plan->lefttree);
+	plan->righttree = cse_walk(stmt, plan->righttree);
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			cse_walk_list(stmt, ((Append *) plan)->appendplans);
+			break;
+		case T_MergeAppend:
+			cse_walk_list(stmt, ((MergeAppend *) plan)->mergeplans);
+			break;
+		case T_Sequence:
+			cse_walk_list(stmt, ((Sequence *) plan)->subplans);
+			break;
+		case T_ModifyTable:
+			cse_walk_list(stmt, ((ModifyTable *) plan)->plans);
+			break;
+		case T_SubqueryScan:
+			((SubqueryScan *) plan)->subplan =
+				cse_walk(stmt, ((SubqueryScan *) plan)->subplan);
+			break;
+		case T_SeqScan:
+			return cse_scan(stmt, (SeqScan *) plan);
+		default:
+			break;
+	}
+
+	return plan;
+}
+
+/*
+ * orca_common_subexpressions -- compute the expressions shared by the filter
+ * and the target list of the scans of a plan made by GPORCA once per row.
+ */
+void
+orca_common_subexpressions(PlannedStmt *stmt)
+{
+	stmt->planTree = cse_walk(stmt, stmt->planTree);
+	cse_walk_list(stmt, stmt->subplans);
+}
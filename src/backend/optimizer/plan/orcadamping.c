@@ -0,0 +1,228 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcadamping.c
+ *	  Derive the filter damping factor of GPORCA from the functional
+ *	  dependencies between the filtered columns.
+ *
+ * GPORCA doesn't assume the filters on the columns of a table to be
+ * independent: the scale factor of the n'th filter is multiplied by
+ * optimizer_damping_factor_filter^n.  That is a guess, too small for
+ * columns that are independent, and much too large for columns that depend
+ * on each other, like (country, city, zip).  ANALYZE computes the degrees of
+ * the functional dependencies between the columns of a table, see
+ * compute_dependency_stats().  When optimizer_enable_dependency_damping is
+ * on, and a query has equality filters on two columns of a table with such
+ * statistics, the damping factor of the query is the one that makes the
+ * selectivity GPORCA estimates for the second filter the one the dependency
+ * implies: with a degree d of the dependency of b on a, the rows that pass
+ * a = x pass b = y with a probability of d + (1 - d) * sel(b).
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcadamping.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/htup_details.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_statistic.h"
+#include "catalog/pg_type.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/orcadamping.h"
+#include "parser/parsetree.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/syscache.h"
+
+/*
+ * Collect the Vars of the equality filters of a conjunction, compared to a
+ * constant or a parameter.
+ */
+static bool
+equality_filters_walker(Node *node, List **filters)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, OpExpr))
+	{
+		OpExpr	   *op = (OpExpr *) node;
+		Node	   *left;
+		Node	   *right;
+		Var		   *var = NULL;
+
+		if (list_length(op->args) != 2 || get_oprrest(op->opno) != F_EQSEL)
+			return false;
+
+		left = (Node *) linitial(op->args);
+		right = (Node *) lsecond(op->args);
+		if (IsA(left, RelabelType))
+			left = (Node *) ((RelabelType *) left)->arg;
+		if (IsA(right, RelabelType))
+			right = (Node *) ((RelabelType *) right)->arg;
+
+		if (IsA(left, Var) && (IsA(right, Const) || IsA(right, Param)))
+			var = (Var *) left;
+		else if (IsA(right, Var) && (IsA(left, Const) || IsA(left, Param)))
+			var = (Var *) right;
+
+		if (var != NULL && var->varlevelsup == 0 && var->varattno > 0)
+			*filters = lappend(*filters, var);
+		return false;
+	}
+
+	/* only the conjuncts of the WHERE clause and of inner joins filter */
+	if (IsA(node, BoolExpr))
+	{
+		if (((BoolExpr *) node)->boolop != AND_EXPR)
+			return false;
+	}
+	else if (IsA(node, JoinExpr))
+	{
+		if (((JoinExpr *) node)->jointype != JOIN_INNER)
+			return false;
+	}
+	else if (!IsA(node, List) && !IsA(node, FromExpr))
+		return false;
+
+	return expression_tree_walker(node, equality_filters_walker,
+								  (void *) filters);
+}
+
+/*
+ * Number of distinct values of a table column, 0 if unknown.
+ */
+static double
+column_ndistinct(Oid relid, HeapTuple statsTuple)
+{
+	double		ndistinct;
+
+	ndistinct = ((Form_pg_statistic) GETSTRUCT(statsTuple))->stadistinct;
+	if (ndistinct < 0)
+	{
+		HeapTuple	classTuple;
+
+		classTuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+		if (!HeapTupleIsValid(classTuple))
+			return 0;
+		ndistinct = -ndistinct * ((Form_pg_class) GETSTRUCT(classTuple))->reltuples;
+		ReleaseSysCache(classTuple);
+	}
+
+	return ndistinct;
+}
+
+/*
+ * The damping factor the dependency of column b on column a implies, or -1
+ * if there are no statistics of it.
+ */
+static double
+dependency_damping(Oid relid, AttrNumber a, AttrNumber b)
+{
+	HeapTuple	statsTuple;
+	AttStatsSlot sslot;
+	double		degree = -1;
+	double		ndistinct;
+	double		sel;
+	int			i;
+
+	statsTuple = SearchSysCache3(STATRELATTINH,
+								 ObjectIdGetDatum(relid),
+								 Int16GetDatum(a),
+								 BoolGetDatum(false));
+	if (!HeapTupleIsValid(statsTuple))
+		return -1;
+
+	if (get_attstatsslot(&sslot, statsTuple,
+						 STATISTIC_KIND_DEPENDENCY, InvalidOid,
+						 ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+	{
+		for (i = 0; sslot.valuetype == INT2OID &&
+			 i < sslot.nvalues && i < sslot.nnumbers; i++)
+		{
+			if (DatumGetInt16(sslot.values[i]) == b)
+			{
+				degree = sslot.numbers[i];
+				break;
+			}
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	ReleaseSysCache(statsTuple);
+
+	if (degree < 0)
+		return -1;
+
+	statsTuple = SearchSysCache3(STATRELATTINH,
+								 ObjectIdGetDatum(relid),
+								 Int16GetDatum(b),
+								 BoolGetDatum(false));
+	if (!HeapTupleIsValid(statsTuple))
+		return -1;
+	ndistinct = column_ndistinct(relid, statsTuple);
+	ReleaseSysCache(statsTuple);
+
+	if (ndistinct <= 1)
+		return -1;
+
+	/*
+	 * GPORCA multiplies the scale factor 1 / sel of the second filter by
+	 * damping^2, the dependency makes it 1 / (d + (1 - d) * sel).
+	 */
+	sel = 1.0 / ndistinct;
+	return sqrt(sel / (degree + (1 - degree) * sel));
+}
+
+/*
+ * orca_filter_damping_factor -- the filter damping factor to optimize a
+ * query with, given the one configured.
+ *
+ * It's the smallest one any two equality filters on the columns of a table
+ * of the query imply, which is the one of the most dependent columns.
+ */
+double
+orca_filter_damping_factor(Query *query, double damping)
+{
+	List	   *filters = NIL;
+	ListCell   *lc1;
+	ListCell   *lc2;
+	double		result = -1;
+
+	if (query->jointree == NULL)
+		return damping;
+
+	equality_filters_walker((Node *) query->jointree, &filters);
+
+	foreach(lc1, filters)
+	{
+		Var		   *var1 = (Var *) lfirst(lc1);
+		RangeTblEntry *rte = rt_fetch(var1->varno, query->rtable);
+
+		if (rte->rtekind != RTE_RELATION)
+			continue;
+
+		foreach(lc2, filters)
+		{
+			Var		   *var2 = (Var *) lfirst(lc2);
+			double		d;
+
+			if (var2->varno != var1->varno || var2->varattno == var1->varattno)
+				continue;
+
+			d = dependency_damping(rte->relid, var1->varattno, var2->varattno);
+			if (d >= 0 && (result < 0 || d < result))
+				result = d;
+		}
+	}
+
+	list_free(filters);
+
+	return result < 0 ? damping : result;
+}
@@ -0,0 +1,277 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcafeedback.c
+ *	  Row counts of tables observed by EXPLAIN ANALYZE, for the estimates of
+ *	  GPORCA.
+ *
+ * The worst misestimates come from tables whose statistics are stale, like
+ * tables loaded after they were last analyzed.  However a scan ends, the rows
+ * it returned per loop are a lower bound of the rows of the table.  So when
+ * optimizer_cardinality_feedback is on, EXPLAIN ANALYZE of a plan of GPORCA
+ * records the most rows a sequential scan of each table returned, summed over
+ * the segments, and GPORCA estimates the table to have at least as many rows.
+ *
+ * The row counts are private to the backend.  A row count is forgotten when
+ * the relcache entry of its table is invalidated, as happens when the table
+ * is analyzed or truncated.  When a larger row count is recorded, the
+ * statistics of the table are evicted from the metadata cache of GPORCA, and
+ * with them the plan cache is reset.
+ *
+ * When optimizer_plan_trace is on, the estimated and actual rows and time of
+ * each node of the plan are also kept, in place of the oldest ones, and
+ * returned by gp_optimizer_plan_trace().  The nodes are identified by the
+ * fingerprint of the shape of the plan below them, which is the same in all
+ * the plans of that shape, so that systematic misestimates can be found
+ * across the queries of the workload.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcafeedback.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "catalog/gp_policy.h"
+#include "cdb/cdbexplain.h"
+#include "executor/executor.h"
+#include "nodes/print.h"
+#include "optimizer/orcafeedback.h"
+#include "parser/parsetree.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/timestamp.h"
+
+typedef struct OrcaFeedbackEntry
+{
+	Oid			relid;			/* hash key, must be first */
+	double		numtuples;		/* most rows returned by a scan of it */
+	bool		changed;		/* not yet evicted from the metadata cache */
+} OrcaFeedbackEntry;
+
+static HTAB *OrcaFeedbackHash = NULL;
+static bool OrcaFeedbackCallbackRegistered = false;
+
+static OrcaPlanTraceEntry *OrcaPlanTrace = NULL;
+static int	OrcaPlanTraceNext = 0;
+static int	OrcaPlanTraceCount = 0;
+
+static void
+OrcaFeedbackRelcacheCallback(Datum arg, Oid relid)
+{
+	if (OrcaFeedbackHash == NULL)
+		return;
+
+	/* InvalidOid means all relations */
+	if (!OidIsValid(relid))
+	{
+		hash_destroy(OrcaFeedbackHash);
+		OrcaFeedbackHash = NULL;
+	}
+	else
+		hash_search(OrcaFeedbackHash, &relid, HASH_REMOVE, NULL);
+}
+
+static void
+OrcaFeedbackInit(void)
+{
+	HASHCTL		info;
+
+	if (!OrcaFeedbackCallbackRegistered)
+	{
+		CacheRegisterRelcacheCallback(OrcaFeedbackRelcacheCallback, (Datum) 0);
+		OrcaFeedbackCallbackRegistered = true;
+	}
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(Oid);
+	info.entrysize = sizeof(OrcaFeedbackEntry);
+	info.hash = oid_hash;
+	info.hcxt = TopMemoryContext;
+
+	OrcaFeedbackHash = hash_create("GPORCA cardinality feedback", 64, &info,
+								   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+}
+
+static void
+OrcaFeedbackStore(Oid relid, double numtuples)
+{
+	OrcaFeedbackEntry *entry;
+	bool		found;
+
+	if (OrcaFeedbackHash == NULL)
+		OrcaFeedbackInit();
+
+	entry = (OrcaFeedbackEntry *) hash_search(OrcaFeedbackHash, &relid,
+											  HASH_ENTER, &found);
+	if (!found || entry->numtuples < numtuples)
+	{
+		entry->numtuples = numtuples;
+		entry->changed = true;
+	}
+}
+
+static CdbVisitOpt
+OrcaFeedbackWalker(PlanState *planstate, void *context)
+{
+	ScanState  *scanstate;
+	Relation	rel;
+	double		sum;
+	double		max;
+
+	if (!IsA(planstate, SeqScanState))
+		return CdbVisit_Walk;
+
+	scanstate = (ScanState *) planstate;
+	rel = scanstate->ss_currentRelation;
+	if (rel == NULL ||
+		!cdbexplain_getRowsPerLoop(planstate, &sum, &max) ||
+		max <= 0)
+		return CdbVisit_Walk;
+
+	/* every segment scans all the rows of a replicated table */
+	OrcaFeedbackStore(RelationGetRelid(rel),
+					  GpPolicyIsReplicated(rel->rd_cdbpolicy) ? max : sum);
+
+	return CdbVisit_Walk;
+}
+
+/*
+ * OrcaFeedbackRecord -- record the rows returned by the scans of an executed
+ * plan.
+ *
+ * The statistics of EXPLAIN ANALYZE must have been received already.
+ */
+void
+OrcaFeedbackRecord(QueryDesc *queryDesc)
+{
+	if (queryDesc->planstate == NULL)
+		return;
+
+	planstate_walk_node(queryDesc->planstate, OrcaFeedbackWalker, NULL);
+}
+
+/*
+ * OrcaFeedbackLookup -- the most rows a scan of the table has returned.
+ *
+ * Returns false if nothing is recorded for the table, or if the feedback is
+ * disabled.
+ */
+bool
+OrcaFeedbackLookup(Oid relid, double *numtuples)
+{
+	OrcaFeedbackEntry *entry;
+
+	if (!optimizer_cardinality_feedback || OrcaFeedbackHash == NULL)
+		return false;
+
+	entry = (OrcaFeedbackEntry *) hash_search(OrcaFeedbackHash, &relid,
+											  HASH_FIND, NULL);
+	if (entry == NULL)
+		return false;
+
+	*numtuples = entry->numtuples;
+	return true;
+}
+
+/*
+ * OrcaFeedbackGetChangedRels -- return a palloc'd array of the tables whose
+ * row counts have grown since the last call, or NULL if there are none.
+ */
+Oid *
+OrcaFeedbackGetChangedRels(int *num_rels)
+{
+	HASH_SEQ_STATUS status;
+	OrcaFeedbackEntry *entry;
+	Oid		   *relids = NULL;
+
+	*num_rels = 0;
+
+	if (OrcaFeedbackHash == NULL)
+		return NULL;
+
+	hash_seq_init(&status, OrcaFeedbackHash);
+	while ((entry = (OrcaFeedbackEntry *) hash_seq_search(&status)) != NULL)
+	{
+		if (!entry->changed)
+			continue;
+
+		if (relids == NULL)
+			relids = (Oid *) palloc(hash_get_num_entries(OrcaFeedbackHash) * sizeof(Oid));
+		relids[(*num_rels)++] = entry->relid;
+		entry->changed = false;
+	}
+
+	return relids;
+}
+
+static CdbVisitOpt
+OrcaPlanTraceWalker(PlanState *planstate, void *context)
+{
+	TimestampTz recorded_at = *(TimestampTz *) context;
+	Plan	   *plan = planstate->plan;
+	OrcaPlanTraceEntry *entry;
+	double		sum;
+	double		max;
+	double		time;
+
+	if (plan->plan_fingerprint == 0 ||
+		!cdbexplain_getTimePerLoop(planstate, &time) ||
+		!cdbexplain_getRowsPerLoop(planstate, &sum, &max))
+		return CdbVisit_Walk;
+
+	entry = &OrcaPlanTrace[OrcaPlanTraceNext];
+	entry->recorded_at = recorded_at;
+	entry->fingerprint = plan->plan_fingerprint;
+	entry->node_type = plannode_type(plan);
+	entry->plan_rows = plan->plan_rows;
+	entry->actual_rows = sum;
+	entry->total_cost = plan->total_cost;
+	entry->actual_time = 1000.0 * time;
+
+	OrcaPlanTraceNext = (OrcaPlanTraceNext + 1) % ORCA_PLAN_TRACE_SIZE;
+	OrcaPlanTraceCount = Min(OrcaPlanTraceCount + 1, ORCA_PLAN_TRACE_SIZE);
+
+	return CdbVisit_Walk;
+}
+
+/*
+ * OrcaPlanTraceRecord -- keep the estimated and actual statistics of the
+ * nodes of an executed plan.
+ *
+ * The statistics of EXPLAIN ANALYZE must have been received already.
+ */
+void
+OrcaPlanTraceRecord(QueryDesc *queryDesc)
+{
+	TimestampTz recorded_at = GetCurrentTimestamp();
+
+	if (queryDesc->planstate == NULL)
+		return;
+
+	if (OrcaPlanTrace == NULL)
+		OrcaPlanTrace = (OrcaPlanTraceEntry *)
+			MemoryContextAllocZero(TopMemoryContext,
+								   ORCA_PLAN_TRACE_SIZE * sizeof(OrcaPlanTraceEntry));
+
+	planstate_walk_node(queryDesc->planstate, OrcaPlanTraceWalker, &recorded_at);
+}
+
+/*
+ * OrcaPlanTraceGet -- the n-th oldest plan node kept, or NULL if there are
+ * fewer.
+ */
+const OrcaPlanTraceEntry *
+OrcaPlanTraceGet(int n)
+{
+	if (n < 0 || n >= OrcaPlanTraceCount)
+		return NULL;
+
+	return &OrcaPlanTrace[(OrcaPlanTraceNext - OrcaPlanTraceCount + n + ORCA_PLAN_TRACE_SIZE) %
+						  ORCA_PLAN_TRACE_SIZE];
+}
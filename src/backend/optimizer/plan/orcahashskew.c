@@ -0,0 +1,248 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcahashskew.c
+ *	  Let the hash joins of GPORCA plans keep the most common values of the
+ *	  outer side in memory.
+ *
+ * When a hash join spills, the inner tuples that match the most common
+ * values of the outer join key can still be kept in memory, in the skew
+ * buckets of the hash table, so that the outer tuples of those values are
+ * joined at once instead of being written to a batch file, see
+ * ExecHashBuildSkewHash().  GPORCA plans don't say what the outer join key
+ * is, and the segments have no statistics to find its most common values by
+ * anyway.  So when optimizer_enable_hashjoin_skew is on, the outer join key
+ * of each hash join with a single hash clause is traced down to the column
+ * of a table, and the most common values of that column, which are the ones
+ * GPORCA estimated the join with, are stored in the Hash node.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcahashskew.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "catalog/pg_statistic.h"
+#include "executor/hashjoin.h"
+#include "nodes/makefuncs.h"
+#include "optimizer/orcahashskew.h"
+#include "parser/parsetree.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
+#include "utils/syscache.h"
+
+/*
+ * Follow a column of the output of a plan down to the table column it is
+ * read from.  Returns false if it is computed, or not read from a table.
+ */
+static bool
+table_column(PlannedStmt *stmt, Plan *plan, AttrNumber attno,
+			 Oid *relid, AttrNumber *colno, bool *inh)
+{
+	while (plan != NULL)
+	{
+		TargetEntry *tle;
+		Node	   *expr;
+		Var		   *var;
+
+		if (attno < 1 || attno > list_length(plan->targetlist))
+			return false;
+
+		tle = (TargetEntry *) list_nth(plan->targetlist, attno - 1);
+		expr = (Node *) tle->expr;
+		if (IsA(expr, RelabelType))
+			expr = (Node *) ((RelabelType *) expr)->arg;
+		if (!IsA(expr, Var))
+			return false;
+
+		var = (Var *) expr;
+		if (var->varlevelsup != 0)
+			return false;
+
+		if (var->varno == OUTER_VAR)
+			plan = plan->lefttree;
+		else if (var->varno == INNER_VAR)
+			plan = plan->righttree;
+		else if (IsA(plan, SeqScan) || IsA(plan, DynamicSeqScan) ||
+				 IsA(plan, IndexScan) || IsA(plan, DynamicIndexScan) ||
+				 IsA(plan, BitmapHeapScan) || IsA(plan, DynamicBitmapHeapScan))
+		{
+			RangeTblEntry *rte;
+
+			if (var->varno != ((Scan *) plan)->scanrelid || var->varattno <= 0)
+				return false;
+
+			rte = rt_fetch(var->varno, stmt->rtable);
+			if (rte->rtekind != RTE_RELATION)
+				return false;
+
+			*relid = rte->relid;
+			*colno = var->varattno;
+			*inh = rte->inh;
+			return true;
+		}
+		else
+			return false;
+
+		attno = var->varattno;
+	}
+
+	return false;
+}
+
+/*
+ * The most common values of a table column, as Consts of the given type,
+ * most common first.  NIL if there are none, or if they are too rare for the
+ * skew buckets to be worth it.
+ */
+static List *
+most_common_values(Oid relid, AttrNumber colno, bool inh,
+				   Oid type, int32 typmod, Oid collation)
+{
+	HeapTuple	statsTuple;
+	AttStatsSlot sslot;
+	List	   *result = NIL;
+
+	statsTuple = SearchSysCache3(STATRELATTINH,
+								 ObjectIdGetDatum(relid),
+								 Int16GetDatum(colno),
+								 BoolGetDatum(inh));
+	if (!HeapTupleIsValid(statsTuple))
+		return NIL;
+
+	if (get_attstatsslot(&sslot, statsTuple,
+						 STATISTIC_KIND_MCV, InvalidOid,
+						 ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+	{
+		double		frac = 0;
+		int16		typlen;
+		bool		typbyval;
+		int			i;
+
+		for (i = 0; i < sslot.nvalues; i++)
+			frac += sslot.numbers[i];
+
+		/* the values of the statistics are of the type of the column */
+		if (frac >= SKEW_MIN_OUTER_FRACTION &&
+			sslot.valuetype == type)
+		{
+			get_typlenbyval(type, &typlen, &typbyval);
+
+			for (i = 0; i < sslot.nvalues; i++)
+				result = lappend(result,
+								 makeConst(type, typmod, collation, typlen,
+										   datumCopy(sslot.values[i],
+													 typbyval, typlen),
+										   false, typbyval));
+		}
+
+		free_attstatsslot(&sslot);
+	}
+
+	ReleaseSysCache(statsTuple);
+
+	return result;
+}
+
+static void
+hashskew_join(PlannedStmt *stmt, HashJoin *hj)
+{
+	Hash	   *hash = (Hash *) hj->join.plan.righttree;
+	OpExpr	   *clause;
+	Node	   *outerkey;
+	Var		   *var;
+	Oid			relid;
+	AttrNumber	colno;
+	bool		inh;
+
+	/* as in create_hashjoin_plan, only a single hash clause can use them */
+	if (!IsA(hash, Hash) || OidIsValid(hash->skewTable) ||
+		list_length(hj->hashclauses) != 1)
+		return;
+
+	clause = (OpExpr *) linitial(hj->hashclauses);
+	if (!IsA(clause, OpExpr) || list_length(clause->args) != 2)
+		return;
+
+	outerkey = (Node *) linitial(clause->args);
+	if (IsA(outerkey, RelabelType))
+		outerkey = (Node *) ((RelabelType *) outerkey)->arg;
+	if (!IsA(outerkey, Var) || ((Var *) outerkey)->varno != OUTER_VAR)
+		return;
+
+	var = (Var *) outerkey;
+	if (!table_column(stmt, hj->join.plan.lefttree, var->varattno,
+					  &relid, &colno, &inh))
+		return;
+
+	hash->skewValues = most_common_values(relid, colno, inh, var->vartype,
+										  var->vartypmod, var->varcollid);
+	if (hash->skewValues == NIL)
+		return;
+
+	hash->skewTable = relid;
+	hash->skewColumn = colno;
+	hash->skewInherit = inh;
+	hash->skewColType = var->vartype;
+	hash->skewColTypmod = var->vartypmod;
+}
+
+static void hashskew_walk(PlannedStmt *stmt, Plan *plan);
+
+static void
+hashskew_walk_list(PlannedStmt *stmt, List *plans)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+		hashskew_walk(stmt, (Plan *) lfirst(lc));
+}
+
+static void
+hashskew_walk(PlannedStmt *stmt, Plan *plan)
+{
+	if (plan == NULL)
+		return;
+
+	hashskew_walk(stmt, plan->lefttree);
+	hashskew_walk(stmt, plan->righttree);
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			hashskew_walk_list(stmt, ((Append *) plan)->appendplans);
+			break;
+		case T_MergeAppend:
+			hashskew_walk_list(stmt, ((MergeAppend *) plan)->mergeplans);
+			break;
+		case T_Sequence:
+			hashskew_walk_list(stmt, ((Sequence *) plan)->subplans);
+			break;
+		case T_ModifyTable:
+			hashskew_walk_list(stmt, ((ModifyTable *) plan)->plans);
+			break;
+		case T_SubqueryScan:
+			hashskew_walk(stmt, ((SubqueryScan *) plan)->subplan);
+			break;
+		case T_HashJoin:
+			hashskew_join(stmt, (HashJoin *) plan);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * orca_hash_join_skew -- give the hash joins of a plan made by GPORCA the
+ * most common values of their outer join key.
+ */
+void
+orca_hash_join_skew(PlannedStmt *stmt)
+{
+	hashskew_walk(stmt, stmt->planTree);
+	hashskew_walk_list(stmt, stmt->subplans);
+}
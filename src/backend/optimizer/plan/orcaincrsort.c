@@ -0,0 +1,310 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaincrsort.c
+ *	  Turn the sorts of GPORCA plans into incremental sorts.
+ *
+ * GPORCA sorts the whole input of a Sort, even when the input is already
+ * sorted on some of the leading sort keys, such as an index scan on (a)
+ * below a sort on (a, b).  When optimizer_enable_incremental_sort is on, the
+ * order of the input of each Sort is derived from the plan below it, and the
+ * number of leading keys it already provides is stored in the Sort.  The
+ * executor then sorts each run of rows with equal values in those keys on
+ * its own, see ExecIncrementalSort().
+ *
+ * The order is derived from a Sort, a sorted Motion or a MergeAppend, and
+ * from btree index scans, through the nodes that return the rows of their
+ * outer plan in order with at most a projection.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcaincrsort.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/nbtree.h"
+#include "catalog/pg_am.h"
+#include "optimizer/orcaincrsort.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+
+/*
+ * If the column of the plan's target list is a column of the given plan
+ * below, return the column number there, otherwise 0.
+ */
+static AttrNumber
+source_column(Plan *plan, AttrNumber attno, Index varno)
+{
+	TargetEntry *tle;
+	Var		   *var;
+
+	if (attno < 1 || attno > list_length(plan->targetlist))
+		return 0;
+
+	tle = (TargetEntry *) list_nth(plan->targetlist, attno - 1);
+	if (!IsA(tle->expr, Var))
+		return 0;
+
+	var = (Var *) tle->expr;
+	if (var->varno != varno || var->varlevelsup != 0)
+		return 0;
+
+	return var->varattno;
+}
+
+/*
+ * The number of leading keys that the sort order given by the arrays shares
+ * with the keys of the Sort, which have been mapped to the columns of the
+ * plan with that order.
+ */
+static int
+common_prefix(Sort *sort, AttrNumber *keys, int nkeys, int numCols,
+			  AttrNumber *colIdx, Oid *operators, Oid *collations,
+			  bool *nullsFirst)
+{
+	int			i;
+
+	for (i = 0; i < nkeys && i < numCols; i++)
+	{
+		if (keys[i] != colIdx[i] ||
+			sort->sortOperators[i] != operators[i] ||
+			sort->collations[i] != collations[i] ||
+			sort->nullsFirst[i] != nullsFirst[i])
+			break;
+	}
+
+	return i;
+}
+
+/*
+ * The number of leading keys of the Sort that an index scan returns its rows
+ * in.  The keys have been mapped to table columns, or for an index-only scan
+ * to index columns.
+ */
+static int
+index_prefix(Sort *sort, AttrNumber *keys, int nkeys, Oid indexid,
+			 ScanDirection dir, bool indexonly)
+{
+	Relation	index;
+	int			i;
+
+	index = index_open(indexid, AccessShareLock);
+	if (index->rd_rel->relam != BTREE_AM_OID)
+	{
+		index_close(index, NoLock);
+		return 0;
+	}
+
+	for (i = 0; i < nkeys && i < index->rd_index->indnatts; i++)
+	{
+		bool		desc = (index->rd_indoption[i] & INDOPTION_DESC) != 0;
+		bool		nulls_first = (index->rd_indoption[i] & INDOPTION_NULLS_FIRST) != 0;
+		int16		strategy;
+		Oid			op;
+
+		if (indexonly)
+		{
+			if (keys[i] != i + 1)
+				break;
+		}
+		else if (keys[i] != index->rd_index->indkey.values[i] || keys[i] == 0)
+			break;
+
+		if (ScanDirectionIsBackward(dir))
+		{
+			desc = !desc;
+			nulls_first = !nulls_first;
+		}
+
+		strategy = desc ? BTGreaterStrategyNumber : BTLessStrategyNumber;
+		op = get_opfamily_member(index->rd_opfamily[i],
+								 index->rd_opcintype[i],
+								 index->rd_opcintype[i],
+								 strategy);
+
+		if (sort->sortOperators[i] != op ||
+			sort->collations[i] != index->rd_indcollation[i] ||
+			sort->nullsFirst[i] != nulls_first)
+			break;
+	}
+
+	index_close(index, NoLock);
+
+	return i;
+}
+
+/*
+ * The number of leading keys of the Sort that its input is already sorted
+ * on.
+ */
+static int
+presorted_prefix(Sort *sort)
+{
+	AttrNumber *keys;
+	Plan	   *plan;
+	int			nkeys = sort->numCols;
+	int			result = 0;
+	int			i;
+
+	keys = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+	memcpy(keys, sort->sortColIdx, nkeys * sizeof(AttrNumber));
+
+	/* follow the keys down through the nodes that keep the order */
+	plan = (Plan *) sort;
+	for (;;)
+	{
+		Plan	   *child = plan->lefttree;
+		int			nmapped;
+
+		for (nmapped = 0; nmapped < nkeys; nmapped++)
+		{
+			keys[nmapped] = source_column(plan, keys[nmapped], OUTER_VAR);
+			if (keys[nmapped] == 0)
+				break;
+		}
+		nkeys = nmapped;
+
+		if (nkeys == 0 || child == NULL)
+			break;
+
+		if (IsA(child, Result) || IsA(child, Material) ||
+			IsA(child, WindowAgg) || IsA(child, Limit))
+		{
+			if (child->lefttree == NULL)
+				break;
+			plan = child;
+			continue;
+		}
+
+		if (IsA(child, Sort))
+		{
+			Sort	   *below = (Sort *) child;
+
+			result = common_prefix(sort, keys, nkeys, below->numCols,
+								   below->sortColIdx, below->sortOperators,
+								   below->collations, below->nullsFirst);
+		}
+		else if (IsA(child, Motion) && ((Motion *) child)->sendSorted)
+		{
+			Motion	   *motion = (Motion *) child;
+
+			result = common_prefix(sort, keys, nkeys, motion->numSortCols,
+								   motion->sortColIdx, motion->sortOperators,
+								   motion->collations, motion->nullsFirst);
+		}
+		else if (IsA(child, MergeAppend))
+		{
+			MergeAppend *merge = (MergeAppend *) child;
+
+			result = common_prefix(sort, keys, nkeys, merge->numCols,
+								   merge->sortColIdx, merge->sortOperators,
+								   merge->collations, merge->nullsFirst);
+		}
+		else if (IsA(child, IndexScan))
+		{
+			IndexScan  *scan = (IndexScan *) child;
+
+			for (i = 0; i < nkeys; i++)
+			{
+				keys[i] = source_column(child, keys[i], scan->scan.scanrelid);
+				if (keys[i] == 0)
+					break;
+			}
+			result = index_prefix(sort, keys, i, scan->indexid,
+								  scan->indexorderdir, false);
+		}
+		else if (IsA(child, IndexOnlyScan))
+		{
+			IndexOnlyScan *scan = (IndexOnlyScan *) child;
+
+			for (i = 0; i < nkeys; i++)
+			{
+				keys[i] = source_column(child, keys[i], INDEX_VAR);
+				if (keys[i] == 0)
+					break;
+			}
+			result = index_prefix(sort, keys, i, scan->indexid,
+								  scan->indexorderdir, true);
+		}
+		break;
+	}
+
+	pfree(keys);
+
+	return result;
+}
+
+static void incrsort_walk(Plan *plan);
+
+static void
+incrsort_walk_list(List *plans)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+		incrsort_walk((Plan *) lfirst(lc));
+}
+
+static void
+incrsort_walk(Plan *plan)
+{
+	if (plan == NULL)
+		return;
+
+	incrsort_walk(plan->lefttree);
+	incrsort_walk(plan->righttree);
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			incrsort_walk_list(((Append *) plan)->appendplans);
+			break;
+		case T_MergeAppend:
+			incrsort_walk_list(((MergeAppend *) plan)->mergeplans);
+			break;
+		case T_Sequence:
+			incrsort_walk_list(((Sequence *) plan)->subplans);
+			break;
+		case T_ModifyTable:
+			incrsort_walk_list(((ModifyTable *) plan)->plans);
+			break;
+		case T_SubqueryScan:
+			incrsort_walk(((SubqueryScan *) plan)->subplan);
+			break;
+		case T_Sort:
+			{
+				Sort	   *sort = (Sort *) plan;
+				int			npresorted;
+
+				if (sort->noduplicates || sort->share_type != SHARE_NOTSHARED)
+					break;
+
+				/*
+				 * If the input is sorted on all of the keys, the runs each
+				 * hold the rows of equal keys, which is no cheaper than a
+				 * full sort, so leave those alone.
+				 */
+				npresorted = presorted_prefix(sort);
+				if (npresorted < sort->numCols)
+					sort->numPresortedCols = npresorted;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * orca_incremental_sorts -- mark the Sorts of a plan made by GPORCA whose
+ * input is already sorted on some of their keys.
+ */
+void
+orca_incremental_sorts(PlannedStmt *stmt)
+{
+	incrsort_walk(stmt->planTree);
+	incrsort_walk_list(stmt->subplans);
+}
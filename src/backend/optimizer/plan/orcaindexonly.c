@@ -0,0 +1,224 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaindexonly.c
+ *	  Turn the index scans of GPORCA plans into index-only scans.
+ *
+ * GPORCA has no index-only scan operator, so an index scan that only needs
+ * the columns of its index still visits the heap for every row.  When
+ * optimizer_enable_indexonlyscan is on, an index scan of a heap table is
+ * replaced by an index-only scan if its target list and filter only reference
+ * key columns of a btree index.  The index-only scan returns the rows from the
+ * index, and only visits the heap pages that the visibility map doesn't know
+ * to be all-visible.
+ *
+ * The scan is left alone if none of the pages of the table were all-visible
+ * when it was last vacuumed or analyzed, as then an index-only scan would
+ * check the visibility map for nothing before visiting the heap anyway.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcaindexonly.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "catalog/pg_am.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/orcaindexonly.h"
+#include "parser/parsetree.h"
+#include "utils/rel.h"
+
+typedef struct IndexOnlyContext
+{
+	Index		scanrelid;
+	Relation	index;
+	bool		failed;
+} IndexOnlyContext;
+
+/*
+ * Replace the Vars of the table with Vars of the index columns, as
+ * set_indexonlyscan_references() does.
+ */
+static Node *
+index_var_mutator(Node *node, IndexOnlyContext *context)
+{
+	if (node == NULL || context->failed)
+		return node;
+
+	if (IsA(node, Var) && ((Var *) node)->varno == context->scanrelid)
+	{
+		Var		   *var = (Var *) node;
+		Form_pg_index index = context->index->rd_index;
+		int			i;
+
+		for (i = 0; i < index->indnatts; i++)
+		{
+			if (index->indkey.values[i] == var->varattno && var->varattno > 0)
+			{
+				Var		   *newvar = (Var *) copyObject(var);
+
+				newvar->varno = INDEX_VAR;
+				newvar->varattno = i + 1;
+				return (Node *) newvar;
+			}
+		}
+
+		/* not covered by the index */
+		context->failed = true;
+		return node;
+	}
+
+	return expression_tree_mutator(node, index_var_mutator, (void *) context);
+}
+
+static List *
+make_index_tlist(Index scanrelid, Relation heap, Relation index)
+{
+	List	   *tlist = NIL;
+	int			i;
+
+	for (i = 0; i < index->rd_index->indnatts; i++)
+	{
+		AttrNumber	attno = index->rd_index->indkey.values[i];
+		Form_pg_attribute att = heap->rd_att->attrs[attno - 1];
+		Var		   *var;
+
+		var = makeVar(scanrelid, attno, att->atttypid, att->atttypmod,
+					  att->attcollation, 0);
+		tlist = lappend(tlist, makeTargetEntry((Expr *) var, i + 1, NULL,
+											   false));
+	}
+
+	return tlist;
+}
+
+/*
+ * Return an index-only scan equivalent to the index scan, or NULL.
+ */
+static Plan *
+make_index_only_scan(IndexScan *scan, PlannedStmt *stmt)
+{
+	RangeTblEntry *rte = rt_fetch(scan->scan.scanrelid, stmt->rtable);
+	IndexOnlyContext context;
+	IndexOnlyScan *result = NULL;
+	Relation	heap;
+	List	   *tlist;
+	List	   *qual;
+	int			i;
+
+	heap = relation_open(rte->relid, AccessShareLock);
+	if (!RelationIsHeap(heap) || heap->rd_rel->relallvisible <= 0)
+	{
+		relation_close(heap, NoLock);
+		return NULL;
+	}
+
+	context.scanrelid = scan->scan.scanrelid;
+	context.index = index_open(scan->indexid, AccessShareLock);
+	context.failed = (context.index->rd_rel->relam != BTREE_AM_OID);
+
+	/* expression columns can't be returned */
+	for (i = 0; i < context.index->rd_index->indnatts; i++)
+	{
+		if (context.index->rd_index->indkey.values[i] == 0)
+			context.failed = true;
+	}
+
+	tlist = (List *) index_var_mutator((Node *) scan->scan.plan.targetlist,
+									   &context);
+	qual = (List *) index_var_mutator((Node *) scan->scan.plan.qual,
+									  &context);
+
+	if (!context.failed)
+	{
+		result = makeNode(IndexOnlyScan);
+		memcpy(&result->scan, &scan->scan, sizeof(Scan));
+		result->scan.plan.type = T_IndexOnlyScan;
+		result->scan.plan.targetlist = tlist;
+		result->scan.plan.qual = qual;
+		result->indexid = scan->indexid;
+		/* the quals of GPORCA already reference the index columns */
+		result->indexqual = scan->indexqual;
+		result->indexqualorig = scan->indexqualorig;
+		result->indexorderby = NIL;
+		result->indextlist = make_index_tlist(scan->scan.scanrelid, heap,
+											  context.index);
+		result->indexorderdir = scan->indexorderdir;
+	}
+
+	index_close(context.index, NoLock);
+	relation_close(heap, NoLock);
+
+	return (Plan *) result;
+}
+
+static Plan *indexonly_mutate(Plan *plan, PlannedStmt *stmt);
+
+static List *
+indexonly_mutate_list(List *plans, PlannedStmt *stmt)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+		lfirst(lc) = indexonly_mutate((Plan *) lfirst(lc), stmt);
+
+	return plans;
+}
+
+static Plan *
+indexonly_mutate(Plan *plan, PlannedStmt *stmt)
+{
+	if (plan == NULL)
+		return NULL;
+
+	if (IsA(plan, IndexScan))
+	{
+		Plan	   *newplan = make_index_only_scan((IndexScan *) plan, stmt);
+
+		return newplan != NULL ? newplan : plan;
+	}
+
+	plan->lefttree = indexonly_mutate(plan->lefttree, stmt);
+	plan->righttree = indexonly_mutate(plan->righttree, stmt);
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			indexonly_mutate_list(((Append *) plan)->appendplans, stmt);
+			break;
+		case T_MergeAppend:
+			indexonly_mutate_list(((MergeAppend *) plan)->mergeplans, stmt);
+			break;
+		case T_Sequence:
+			indexonly_mutate_list(((Sequence *) plan)->subplans, stmt);
+			break;
+		case T_ModifyTable:
+			indexonly_mutate_list(((ModifyTable *) plan)->plans, stmt);
+			break;
+		case T_SubqueryScan:
+			((SubqueryScan *) plan)->subplan =
+				indexonly_mutate(((SubqueryScan *) plan)->subplan, stmt);
+			break;
+		default:
+			break;
+	}
+
+	return plan;
+}
+
+/*
+ * orca_index_only_scans -- replace the index scans of a plan made by GPORCA
+ * with index-only scans, where the index covers them.
+ */
+void
+orca_index_only_scans(PlannedStmt *stmt)
+{
+	stmt->planTree = indexonly_mutate(stmt->planTree, stmt);
+	indexonly_mutate_list(stmt->subplans, stmt);
+}
@@ -0,0 +1,423 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcajoinsearch.c
+ *	  Choose how GPORCA searches the join orders of a large join.
+ *
+ * GPORCA enumerates the join orders of a join of up to
+ * optimizer_join_order_threshold relations exhaustively, and only greedily
+ * for larger joins.  How much work an exhaustive enumeration takes depends
+ * on the shape of the join graph rather than the number of relations: a
+ * dynamic programming enumerator that only joins connected subgraphs, such
+ * as DPccp or DPhyp, considers each pair of a connected subgraph and a
+ * connected complement joined to it once.  There are (n^3 - n) / 6 such
+ * pairs for a chain of n relations, but (n - 1) * 2^(n - 2) for a star.
+ *
+ * Before a query is optimized, the pairs of the inner join graphs of its
+ * joins are counted, with the DPccp enumeration, up to
+ * optimizer_join_search_budget.  A join above the threshold whose pairs fit
+ * in the budget is searched with GPORCA's second dynamic programming join
+ * enumerator (the exhaustive2 setting of optimizer_join_order), which keeps
+ * the best few alternatives of each size; larger ones are still searched
+ * greedily.  The counts are kept in the optimizer statistics.
+ *
+ * See Guido Moerkotte and Thomas Neumann, "Analysis of Two Existing and One
+ * New Dynamic Programming Algorithm for the Generation of Optimal Bushy Join
+ * Trees without Cross Products".
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcajoinsearch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/orca.h"
+#include "optimizer/orcajoinsearch.h"
+#include "optimizer/var.h"
+#include "parser/parsetree.h"
+#include "utils/guc.h"
+
+/* the enumeration uses 64-bit sets of relations */
+#define JOIN_SEARCH_MAX_RELS	64
+
+typedef struct JoinGraph
+{
+	int			nrels;
+	Relids		members[JOIN_SEARCH_MAX_RELS];	/* range table indexes */
+	uint64		neighbors[JOIN_SEARCH_MAX_RELS];
+	bool		overflow;		/* more than JOIN_SEARCH_MAX_RELS */
+} JoinGraph;
+
+typedef struct PairCount
+{
+	uint64	   *neighbors;
+	int64		npairs;
+	int64		budget;
+} PairCount;
+
+static void count_join_pairs_in_query(Query *query, OptimizerStats *stats);
+
+/* the lowest relation of a non-empty set */
+static inline int
+lowest_rel(uint64 set)
+{
+	int			i = 0;
+
+	while ((set & ((uint64) 1 << i)) == 0)
+		i++;
+	return i;
+}
+
+/* all the relations numbered up to i */
+static inline uint64
+rels_upto(int i)
+{
+	return (i >= 63) ? ~(uint64) 0 : (((uint64) 1 << (i + 1)) - 1);
+}
+
+static uint64
+neighborhood(PairCount *count, uint64 set, uint64 excluded)
+{
+	uint64		result = 0;
+	uint64		rest;
+
+	for (rest = set; rest != 0; rest &= rest - 1)
+		result |= count->neighbors[lowest_rel(rest)];
+
+	return result & ~set & ~excluded;
+}
+
+static inline bool
+over_budget(PairCount *count)
+{
+	return count->npairs > count->budget;
+}
+
+/* Count the connected complements that extend s2, for s1 */
+static void
+enumerate_cmp_rec(PairCount *count, uint64 s1, uint64 s2, uint64 excluded)
+{
+	uint64		n = neighborhood(count, s2, excluded);
+	uint64		sub;
+
+	if (n == 0)
+		return;
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* every extension of s2 is still adjacent to s1 */
+	for (sub = n; sub != 0 && !over_budget(count); sub = (sub - 1) & n)
+		count->npairs++;
+
+	for (sub = n; sub != 0 && !over_budget(count); sub = (sub - 1) & n)
+		enumerate_cmp_rec(count, s1, s2 | sub, excluded | n);
+}
+
+/* Count the pairs of a connected subgraph and its connected complements */
+static void
+emit_csg(PairCount *count, uint64 s1)
+{
+	uint64		excluded = s1 | rels_upto(lowest_rel(s1));
+	uint64		n = neighborhood(count, s1, excluded);
+	int			i;
+
+	for (i = JOIN_SEARCH_MAX_RELS - 1; i >= 0 && !over_budget(count); i--)
+	{
+		uint64		s2 = (uint64) 1 << i;
+
+		if ((n & s2) == 0)
+			continue;
+
+		count->npairs++;
+		enumerate_cmp_rec(count, s1, s2, excluded | (n & rels_upto(i)));
+	}
+}
+
+static void
+enumerate_csg_rec(PairCount *count, uint64 s, uint64 excluded)
+{
+	uint64		n = neighborhood(count, s, excluded);
+	uint64		sub;
+
+	if (n == 0)
+		return;
+
+	CHECK_FOR_INTERRUPTS();
+
+	for (sub = n; sub != 0 && !over_budget(count); sub = (sub - 1) & n)
+		emit_csg(count, s | sub);
+
+	for (sub = n; sub != 0 && !over_budget(count); sub = (sub - 1) & n)
+		enumerate_csg_rec(count, s | sub, excluded | n);
+}
+
+/*
+ * Count the csg-cmp pairs of the join graph, up to one past the budget.  The
+ * enumeration requires the relations to be numbered breadth first.
+ */
+static int64
+count_join_pairs(JoinGraph *graph, int64 budget)
+{
+	uint64		neighbors[JOIN_SEARCH_MAX_RELS];
+	int			order[JOIN_SEARCH_MAX_RELS];
+	int			position[JOIN_SEARCH_MAX_RELS];
+	int			nordered = 0;
+	int			i;
+	PairCount	count;
+
+	/* number the relations breadth first, one component after the other */
+	for (i = 0; i < graph->nrels; i++)
+		position[i] = -1;
+	for (i = 0; i < graph->nrels; i++)
+	{
+		int			next = nordered;
+
+		if (position[i] >= 0)
+			continue;
+
+		position[i] = nordered;
+		order[nordered++] = i;
+		while (next < nordered)
+		{
+			int			rel = order[next++];
+			int			j;
+
+			for (j = 0; j < graph->nrels; j++)
+			{
+				if ((graph->neighbors[rel] & ((uint64) 1 << j)) && position[j] < 0)
+				{
+					position[j] = nordered;
+					order[nordered++] = j;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < graph->nrels; i++)
+	{
+		uint64		renumbered = 0;
+		int			j;
+
+		for (j = 0; j < graph->nrels; j++)
+		{
+			if (graph->neighbors[order[i]] & ((uint64) 1 << j))
+				renumbered |= (uint64) 1 << position[j];
+		}
+		neighbors[i] = renumbered;
+	}
+
+	count.neighbors = neighbors;
+	count.npairs = 0;
+	count.budget = budget;
+
+	for (i = graph->nrels - 1; i >= 0 && !over_budget(&count); i--)
+	{
+		uint64		s = (uint64) 1 << i;
+
+		emit_csg(&count, s);
+		enumerate_csg_rec(&count, s, rels_upto(i));
+	}
+
+	return count.npairs;
+}
+
+/* Add a relation, or an outer join treated as one, to the join graph */
+static void
+add_join_rel(JoinGraph *graph, Relids relids)
+{
+	if (graph->nrels == JOIN_SEARCH_MAX_RELS)
+	{
+		graph->overflow = true;
+		return;
+	}
+
+	graph->members[graph->nrels] = relids;
+	graph->neighbors[graph->nrels] = 0;
+	graph->nrels++;
+}
+
+/* Connect the relations that a qual references */
+static void
+add_join_qual(JoinGraph *graph, Node *qual)
+{
+	Relids		varnos = pull_varnos(qual);
+	uint64		rels = 0;
+	int			i;
+
+	for (i = 0; i < graph->nrels; i++)
+	{
+		if (bms_overlap(graph->members[i], varnos))
+			rels |= (uint64) 1 << i;
+	}
+
+	for (i = 0; i < graph->nrels; i++)
+	{
+		if (rels & ((uint64) 1 << i))
+			graph->neighbors[i] |= rels & ~((uint64) 1 << i);
+	}
+
+	bms_free(varnos);
+}
+
+static Relids
+jointree_relids(Node *jtnode)
+{
+	Relids		result = NULL;
+	ListCell   *lc;
+
+	if (IsA(jtnode, RangeTblRef))
+		return bms_make_singleton(((RangeTblRef *) jtnode)->rtindex);
+
+	if (IsA(jtnode, FromExpr))
+	{
+		foreach(lc, ((FromExpr *) jtnode)->fromlist)
+			result = bms_join(result, jointree_relids((Node *) lfirst(lc)));
+		return result;
+	}
+
+	if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *join = (JoinExpr *) jtnode;
+
+		result = bms_join(jointree_relids(join->larg), jointree_relids(join->rarg));
+		if (join->rtindex > 0)
+			result = bms_add_member(result, join->rtindex);
+		return result;
+	}
+
+	return NULL;
+}
+
+/*
+ * Collect the relations and quals of the inner join that a join tree node
+ * belongs to.  Outer joins are leaves of the inner join, and are counted as
+ * joins of their own.
+ */
+static void
+collect_inner_join(Node *jtnode, JoinGraph *graph, List **quals,
+				   List **outer_joins)
+{
+	ListCell   *lc;
+
+	if (IsA(jtnode, RangeTblRef))
+		add_join_rel(graph, jointree_relids(jtnode));
+	else if (IsA(jtnode, FromExpr))
+	{
+		FromExpr   *from = (FromExpr *) jtnode;
+
+		foreach(lc, from->fromlist)
+			collect_inner_join((Node *) lfirst(lc), graph, quals, outer_joins);
+		if (from->quals)
+			*quals = list_concat(*quals,
+								 make_ands_implicit((Expr *) from->quals));
+	}
+	else if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *join = (JoinExpr *) jtnode;
+
+		if (join->jointype == JOIN_INNER)
+		{
+			collect_inner_join(join->larg, graph, quals, outer_joins);
+			collect_inner_join(join->rarg, graph, quals, outer_joins);
+			if (join->quals)
+				*quals = list_concat(*quals,
+									 make_ands_implicit((Expr *) join->quals));
+		}
+		else
+		{
+			add_join_rel(graph, jointree_relids(jtnode));
+			*outer_joins = lappend(*outer_joins, join->larg);
+			*outer_joins = lappend(*outer_joins, join->rarg);
+		}
+	}
+}
+
+/* Count the pairs of the inner join of a join tree node, and those below */
+static void
+count_join_pairs_in_jointree(Node *jtnode, OptimizerStats *stats)
+{
+	JoinGraph	graph;
+	List	   *quals = NIL;
+	List	   *outer_joins = NIL;
+	ListCell   *lc;
+
+	graph.nrels = 0;
+	graph.overflow = false;
+	collect_inner_join(jtnode, &graph, &quals, &outer_joins);
+
+	if (graph.overflow)
+	{
+		stats->join_relations = Max(stats->join_relations, JOIN_SEARCH_MAX_RELS + 1);
+		stats->join_pairs = Max(stats->join_pairs, optimizer_join_search_budget + 1);
+	}
+	else if (graph.nrels > 1)
+	{
+		foreach(lc, quals)
+			add_join_qual(&graph, (Node *) lfirst(lc));
+
+		stats->join_relations = Max(stats->join_relations, graph.nrels);
+		stats->join_pairs = Max(stats->join_pairs,
+								count_join_pairs(&graph, optimizer_join_search_budget));
+	}
+
+	foreach(lc, outer_joins)
+		count_join_pairs_in_jointree((Node *) lfirst(lc), stats);
+
+	list_free(quals);
+	list_free(outer_joins);
+}
+
+static bool
+count_join_pairs_walker(Node *node, OptimizerStats *stats)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Query))
+	{
+		count_join_pairs_in_query((Query *) node, stats);
+		return false;
+	}
+
+	return expression_tree_walker(node, count_join_pairs_walker, (void *) stats);
+}
+
+static void
+count_join_pairs_in_query(Query *query, OptimizerStats *stats)
+{
+	if (query->jointree)
+		count_join_pairs_in_jointree((Node *) query->jointree, stats);
+
+	/* the joins of subqueries, CTEs and sublinks */
+	(void) query_tree_walker(query, count_join_pairs_walker, (void *) stats, 0);
+}
+
+/*
+ * orca_choose_join_search -- count the join pairs of the joins of the query,
+ * and decide whether GPORCA searches them with dynamic programming.
+ */
+void
+orca_choose_join_search(Query *query)
+{
+	OptimizerStats *stats = &optimizer_last_stats;
+
+	stats->join_relations = 0;
+	stats->join_pairs = 0;
+	stats->join_search_dp = false;
+
+	if (optimizer_join_search_budget <= 0 ||
+		optimizer_join_order != JOIN_ORDER_EXHAUSTIVE_SEARCH)
+		return;
+
+	count_join_pairs_in_query(query, stats);
+
+	stats->join_search_dp =
+		stats->join_relations > optimizer_join_order_threshold &&
+		stats->join_pairs <= optimizer_join_search_budget;
+}
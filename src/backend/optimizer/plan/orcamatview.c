@@ -0,0 +1,738 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcamatview.c
+ *	  Answer aggregate queries of GPORCA from materialized views.
+ *
+ * Reports aggregate large tables that often have a materialized view rolling
+ * them up by day or by customer already.  When
+ * optimizer_enable_matview_rewrite is on, a query that aggregates a single
+ * table is rewritten to scan a materialized view of the table instead, before
+ * it's handed to GPORCA, if the view:
+ *
+ * - aggregates the same table, grouping by all the expressions the query
+ *	 groups by, and maybe more,
+ * - filters the table with a subset of the conditions of the query, the other
+ *	 conditions of the query involving only expressions the view groups by,
+ * - and outputs the aggregates of the query.  When the view groups by more
+ *	 expressions than the query, the aggregates must be sums, counts, minimums
+ *	 or maximums, which the query rolls up from the view.
+ *
+ * GPORCA itself can't be taught new kinds of metadata objects or
+ * transformations from this tree, so the matching is done on the Query.
+ *
+ * A materialized view holds the rows of its last refresh.  The rewrite is off
+ * by default, because it makes the query return the aggregates as of that
+ * refresh rather than of the current rows of the table.  Views that aren't
+ * populated are never used, and queries of CREATE TABLE AS and REFRESH
+ * MATERIALIZED VIEW are never rewritten, so a view isn't refreshed from
+ * itself.  When several views match, the smallest one is scanned.
+ *
+ * The definitions of the materialized views of a table are looked up the
+ * first time a query of the table is matched, and kept for the backend.  They
+ * are forgotten on any relcache invalidation, or change of a rewrite rule, as
+ * happens when a materialized view is created, dropped or refreshed.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcamatview.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "catalog/dependency.h"
+#include "catalog/indexing.h"
+#include "catalog/pg_aggregate.h"
+#include "catalog/pg_depend.h"
+#include "catalog/pg_namespace.h"
+#include "catalog/pg_rewrite.h"
+#include "catalog/pg_type.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/orcamatview.h"
+#include "optimizer/tlist.h"
+#include "optimizer/var.h"
+#include "parser/parse_coerce.h"
+#include "parser/parse_func.h"
+#include "parser/parse_relation.h"
+#include "parser/parser.h"
+#include "parser/parsetree.h"
+#include "rewrite/rewriteManip.h"
+#include "utils/acl.h"
+#include "utils/fmgroids.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+
+/*
+ * Definition of a materialized view, with the Vars of its table renumbered to
+ * range table index 1, like in the queries that are matched against it.
+ */
+typedef struct MatviewDef
+{
+	Oid			mvoid;			/* the materialized view */
+	List	   *outputs;		/* MatviewOutputs of its columns */
+	List	   *groupexprs;		/* expressions it groups by */
+	List	   *quals;			/* implicitly ANDed conditions on the table */
+} MatviewDef;
+
+typedef struct MatviewOutput
+{
+	Expr	   *expr;			/* expression computed by the view */
+	AttrNumber	attno;			/* column of the view holding it */
+	bool		isgroupexpr;	/* is it one of the grouping expressions? */
+} MatviewOutput;
+
+typedef struct MatviewCacheEntry
+{
+	Oid			relid;			/* hash key, must be first */
+	List	   *matviews;		/* MatviewDefs of the views of the table */
+} MatviewCacheEntry;
+
+typedef struct MatviewMatchContext
+{
+	MatviewDef *def;
+	Relation	mvrel;
+	bool		rollup;			/* the view groups by more than the query */
+	bool		failed;
+} MatviewMatchContext;
+
+static MemoryContext MatviewCacheContext = NULL;
+static HTAB *MatviewCache = NULL;
+static bool MatviewCallbacksRegistered = false;
+
+static void
+MatviewCacheReset(void)
+{
+	if (MatviewCacheContext != NULL)
+	{
+		MemoryContextDelete(MatviewCacheContext);
+		MatviewCacheContext = NULL;
+		MatviewCache = NULL;
+	}
+}
+
+static void
+MatviewRelcacheCallback(Datum arg, Oid relid)
+{
+	MatviewCacheReset();
+}
+
+static void
+MatviewSyscacheCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	MatviewCacheReset();
+}
+
+/*
+ * Is the query a SELECT that aggregates a single table, with nothing else
+ * that would have to be matched?  Returns the range table index of the
+ * table, or 0.
+ */
+static Index
+simple_aggregate_query(Query *query)
+{
+	RangeTblRef *rtr;
+	ListCell   *lc;
+
+	if (query->commandType != CMD_SELECT ||
+		query->utilityStmt != NULL ||
+		!query->hasAggs ||
+		query->hasWindowFuncs ||
+		query->hasSubLinks ||
+		query->hasForUpdate ||
+		query->cteList != NIL ||
+		query->havingQual != NULL ||
+		query->distinctClause != NIL ||
+		query->scatterClause != NIL ||
+		query->rowMarks != NIL ||
+		query->setOperations != NULL ||
+		list_length(query->jointree->fromlist) != 1)
+		return 0;
+
+	rtr = (RangeTblRef *) linitial(query->jointree->fromlist);
+	if (!IsA(rtr, RangeTblRef) ||
+		rt_fetch(rtr->rtindex, query->rtable)->rtekind != RTE_RELATION)
+		return 0;
+
+	/* no grouping sets */
+	foreach(lc, query->groupClause)
+	{
+		if (!IsA(lfirst(lc), SortGroupClause))
+			return 0;
+	}
+
+	return rtr->rtindex;
+}
+
+static bool
+expr_list_member(List *list, Node *node)
+{
+	ListCell   *lc;
+
+	foreach(lc, list)
+	{
+		if (equal(lfirst(lc), node))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Turn the definition of a materialized view into a MatviewDef, if it
+ * aggregates a single table.
+ */
+static MatviewDef *
+make_matview_def(Oid mvoid, Query *viewquery, Oid relid)
+{
+	MatviewDef *def;
+	Index		rti;
+	ListCell   *lc;
+
+	rti = simple_aggregate_query(viewquery);
+	if (rti == 0 ||
+		rt_fetch(rti, viewquery->rtable)->relid != relid ||
+		viewquery->limitCount != NULL ||
+		viewquery->limitOffset != NULL)
+		return NULL;
+
+	viewquery = copyObject(viewquery);
+	ChangeVarNodes((Node *) viewquery->targetList, rti, 1, 0);
+	ChangeVarNodes(viewquery->jointree->quals, rti, 1, 0);
+
+	def = (MatviewDef *) palloc0(sizeof(MatviewDef));
+	def->mvoid = mvoid;
+
+	/* fold the constants, like in the queries to match */
+	foreach(lc, viewquery->targetList)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+
+		tle->expr = (Expr *) eval_const_expressions(NULL, (Node *) tle->expr);
+	}
+
+	foreach(lc, viewquery->groupClause)
+	{
+		SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
+
+		def->groupexprs = lappend(def->groupexprs,
+								  get_sortgroupclause_expr(sgc,
+														   viewquery->targetList));
+	}
+
+	foreach(lc, viewquery->targetList)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+		MatviewOutput *output;
+
+		if (tle->resjunk)
+			continue;
+
+		output = (MatviewOutput *) palloc(sizeof(MatviewOutput));
+		output->expr = tle->expr;
+		output->attno = tle->resno;
+		output->isgroupexpr = expr_list_member(def->groupexprs,
+											   (Node *) tle->expr);
+		def->outputs = lappend(def->outputs, output);
+	}
+
+	def->quals = make_ands_implicit((Expr *)
+									eval_const_expressions(NULL,
+														   viewquery->jointree->quals));
+	if (contain_volatile_functions((Node *) def->quals))
+		return NULL;
+
+	return def;
+}
+
+/*
+ * Return the relation a rule is defined on.
+ */
+static Oid
+rule_event_relation(Oid ruleoid)
+{
+	Relation	rel;
+	ScanKeyData skey[1];
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	Oid			result = InvalidOid;
+
+	rel = heap_open(RewriteRelationId, AccessShareLock);
+
+	ScanKeyInit(&skey[0],
+				ObjectIdAttributeNumber,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(ruleoid));
+
+	scan = systable_beginscan(rel, RewriteOidIndexId, true, NULL, 1, skey);
+	tuple = systable_getnext(scan);
+	if (HeapTupleIsValid(tuple))
+		result = ((Form_pg_rewrite) GETSTRUCT(tuple))->ev_class;
+
+	systable_endscan(scan);
+	heap_close(rel, AccessShareLock);
+
+	return result;
+}
+
+/*
+ * Find the materialized views of a table, from the dependencies of their
+ * rules on it.
+ */
+static List *
+load_matviews(Oid relid)
+{
+	Relation	deprel;
+	ScanKeyData skey[2];
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	List	   *mvoids = NIL;
+	List	   *result = NIL;
+	ListCell   *lc;
+
+	deprel = heap_open(DependRelationId, AccessShareLock);
+
+	ScanKeyInit(&skey[0],
+				Anum_pg_depend_refclassid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(RelationRelationId));
+	ScanKeyInit(&skey[1],
+				Anum_pg_depend_refobjid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(relid));
+
+	scan = systable_beginscan(deprel, DependReferenceIndexId, true,
+							  NULL, 2, skey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_depend dep = (Form_pg_depend) GETSTRUCT(tuple);
+		Oid			mvoid;
+
+		if (dep->classid != RewriteRelationId ||
+			dep->deptype != DEPENDENCY_NORMAL)
+			continue;
+
+		mvoid = rule_event_relation(dep->objid);
+		if (OidIsValid(mvoid) &&
+			get_rel_relkind(mvoid) == RELKIND_MATVIEW)
+			mvoids = list_append_unique_oid(mvoids, mvoid);
+	}
+
+	systable_endscan(scan);
+	heap_close(deprel, AccessShareLock);
+
+	foreach(lc, mvoids)
+	{
+		Oid			mvoid = lfirst_oid(lc);
+		Relation	mvrel;
+		int			i;
+
+		mvrel = try_relation_open(mvoid, AccessShareLock, false);
+		if (mvrel == NULL)
+			continue;
+
+		for (i = 0; mvrel->rd_rules != NULL && i < mvrel->rd_rules->numLocks; i++)
+		{
+			RewriteRule *rule = mvrel->rd_rules->rules[i];
+			MatviewDef *def;
+
+			if (rule->event != CMD_SELECT || list_length(rule->actions) != 1)
+				continue;
+
+			def = make_matview_def(mvoid, (Query *) linitial(rule->actions),
+								   relid);
+			if (def != NULL)
+				result = lappend(result, def);
+		}
+
+		relation_close(mvrel, AccessShareLock);
+	}
+
+	return result;
+}
+
+static MatviewDef *
+copy_matview_def(MatviewDef *def)
+{
+	MatviewDef *result = (MatviewDef *) palloc0(sizeof(MatviewDef));
+	ListCell   *lc;
+
+	result->mvoid = def->mvoid;
+	foreach(lc, def->outputs)
+	{
+		MatviewOutput *output = (MatviewOutput *) palloc(sizeof(MatviewOutput));
+
+		*output = *(MatviewOutput *) lfirst(lc);
+		output->expr = copyObject(output->expr);
+		result->outputs = lappend(result->outputs, output);
+	}
+	result->groupexprs = copyObject(def->groupexprs);
+	result->quals = copyObject(def->quals);
+
+	return result;
+}
+
+static List *
+get_matviews(Oid relid)
+{
+	MatviewCacheEntry *entry;
+	List	   *matviews;
+	MemoryContext oldcxt;
+	ListCell   *lc;
+
+	if (MatviewCache != NULL)
+	{
+		entry = (MatviewCacheEntry *) hash_search(MatviewCache, &relid,
+												  HASH_FIND, NULL);
+		if (entry != NULL)
+			return entry->matviews;
+	}
+
+	/*
+	 * Opening the catalogs may process invalidations that reset the cache,
+	 * so look the views up before creating it.
+	 */
+	matviews = load_matviews(relid);
+
+	if (!MatviewCallbacksRegistered)
+	{
+		CacheRegisterRelcacheCallback(MatviewRelcacheCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(RULERELNAME, MatviewSyscacheCallback,
+									  (Datum) 0);
+		MatviewCallbacksRegistered = true;
+	}
+
+	if (MatviewCache == NULL)
+	{
+		HASHCTL		info;
+
+		MatviewCacheContext = AllocSetContextCreate(CacheMemoryContext,
+													"GPORCA materialized views",
+													ALLOCSET_SMALL_MINSIZE,
+													ALLOCSET_SMALL_INITSIZE,
+													ALLOCSET_DEFAULT_MAXSIZE);
+
+		MemSet(&info, 0, sizeof(info));
+		info.keysize = sizeof(Oid);
+		info.entrysize = sizeof(MatviewCacheEntry);
+		info.hash = oid_hash;
+		info.hcxt = MatviewCacheContext;
+
+		MatviewCache = hash_create("GPORCA materialized views", 64, &info,
+								   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+	}
+
+	entry = (MatviewCacheEntry *) hash_search(MatviewCache, &relid,
+											  HASH_ENTER, NULL);
+	oldcxt = MemoryContextSwitchTo(MatviewCacheContext);
+	entry->matviews = NIL;
+	foreach(lc, matviews)
+		entry->matviews = lappend(entry->matviews,
+								  copy_matview_def((MatviewDef *) lfirst(lc)));
+	MemoryContextSwitchTo(oldcxt);
+
+	return entry->matviews;
+}
+
+static Var *
+make_output_var(MatviewOutput *output)
+{
+	return makeVar(1, output->attno,
+				   exprType((Node *) output->expr),
+				   exprTypmod((Node *) output->expr),
+				   exprCollation((Node *) output->expr),
+				   0);
+}
+
+/*
+ * Roll up an aggregate of the query from the column of the view holding the
+ * same aggregate of the groups of the view.
+ */
+static Node *
+rollup_aggref(Aggref *aggref, Var *var, MatviewMatchContext *context)
+{
+	char	   *aggname;
+	Aggref	   *result;
+	Node	   *expr;
+	Oid			sumoid;
+	Oid			argtype = var->vartype;
+
+	if (aggref->aggdistinct != NIL ||
+		aggref->aggorder != NIL ||
+		aggref->aggdirectargs != NIL ||
+		aggref->aggfilter != NULL ||
+		aggref->aggkind != AGGKIND_NORMAL ||
+		get_func_namespace(aggref->aggfnoid) != PG_CATALOG_NAMESPACE)
+		return NULL;
+
+	aggname = get_func_name(aggref->aggfnoid);
+
+	/* the minimum of the minimums is the minimum, and so on */
+	if (strcmp(aggname, "min") == 0 || strcmp(aggname, "max") == 0)
+	{
+		result = copyObject(aggref);
+		result->args = list_make1(makeTargetEntry((Expr *) var, 1, NULL,
+												  false));
+		result->aggstar = false;
+		result->location = -1;
+		return (Node *) result;
+	}
+
+	if (strcmp(aggname, "sum") != 0 && strcmp(aggname, "count") != 0)
+		return NULL;
+
+	/* sums and counts are summed, and cast back to the type of the query */
+	sumoid = LookupFuncName(SystemFuncName("sum"), 1, &argtype, true);
+	if (!OidIsValid(sumoid))
+		return NULL;
+
+	result = makeNode(Aggref);
+	result->aggfnoid = sumoid;
+	result->aggtype = get_func_rettype(sumoid);
+	result->aggcollid = InvalidOid;
+	result->inputcollid = InvalidOid;
+	result->args = list_make1(makeTargetEntry((Expr *) var, 1, NULL, false));
+	result->aggkind = AGGKIND_NORMAL;
+	result->location = -1;
+
+	expr = coerce_to_target_type(NULL, (Node *) result, result->aggtype,
+								 aggref->aggtype, exprTypmod((Node *) aggref),
+								 COERCION_EXPLICIT, COERCE_IMPLICIT_CAST, -1);
+	if (expr == NULL)
+		return NULL;
+
+	/* the sum of no counts is null rather than zero */
+	if (strcmp(aggname, "count") == 0)
+	{
+		CoalesceExpr *coalesce = makeNode(CoalesceExpr);
+
+		coalesce->coalescetype = aggref->aggtype;
+		coalesce->coalescecollid = InvalidOid;
+		coalesce->args = list_make2(expr,
+									makeConst(INT8OID, -1, InvalidOid,
+											  sizeof(int64), Int64GetDatum(0),
+											  false, FLOAT8PASSBYVAL));
+		coalesce->location = -1;
+		expr = (Node *) coalesce;
+	}
+
+	return expr;
+}
+
+/*
+ * Replace the expressions of the query with the columns of the view that hold
+ * them.  Sets context->failed if some Var of the table remains.
+ */
+static Node *
+matview_output_mutator(Node *node, MatviewMatchContext *context)
+{
+	ListCell   *lc;
+
+	if (node == NULL || context->failed)
+		return node;
+
+	foreach(lc, context->def->outputs)
+	{
+		MatviewOutput *output = (MatviewOutput *) lfirst(lc);
+		Var		   *var;
+
+		/* when rolling up, only the grouping expressions can be read as is */
+		if (context->rollup && !output->isgroupexpr &&
+			!(IsA(node, Aggref) && IsA(output->expr, Aggref)))
+			continue;
+
+		if (!equal(node, output->expr))
+			continue;
+
+		var = make_output_var(output);
+		if (context->rollup && !output->isgroupexpr)
+		{
+			Node	   *result = rollup_aggref((Aggref *) node, var, context);
+
+			if (result == NULL)
+				context->failed = true;
+			return result;
+		}
+		return (Node *) var;
+	}
+
+	if (IsA(node, Var) || IsA(node, Aggref))
+	{
+		context->failed = true;
+		return node;
+	}
+
+	return expression_tree_mutator(node, matview_output_mutator,
+								   (void *) context);
+}
+
+/*
+ * Rewrite the query to scan the materialized view, or return NULL if the
+ * view doesn't match it.  The query has the table at range table index 1.
+ */
+static Query *
+match_matview(Query *query, MatviewDef *def, Oid userid,
+			  BlockNumber *relpages)
+{
+	MatviewMatchContext context;
+	RangeTblEntry *rte = rt_fetch(1, query->rtable);
+	RangeTblEntry *mvrte;
+	RangeTblRef *rtr;
+	List	   *groupexprs = NIL;
+	List	   *quals;
+	List	   *restquals = NIL;
+	Query	   *result;
+	ListCell   *lc;
+	Bitmapset  *selectedCols = NULL;
+
+	/* the view must group by a superset of the query */
+	foreach(lc, query->groupClause)
+	{
+		Node	   *expr = get_sortgroupclause_expr((SortGroupClause *) lfirst(lc),
+													query->targetList);
+
+		if (!expr_list_member(def->groupexprs, expr))
+			return NULL;
+		groupexprs = lappend(groupexprs, expr);
+	}
+
+	/* and filter by a subset of the conditions of the query */
+	quals = make_ands_implicit((Expr *) query->jointree->quals);
+	foreach(lc, def->quals)
+	{
+		if (!expr_list_member(quals, lfirst(lc)))
+			return NULL;
+	}
+	foreach(lc, quals)
+	{
+		if (!expr_list_member(def->quals, lfirst(lc)))
+			restquals = lappend(restquals, lfirst(lc));
+	}
+	if (contain_volatile_functions((Node *) restquals))
+		return NULL;
+
+	MemSet(&context, 0, sizeof(context));
+	context.def = def;
+	context.rollup = false;
+	foreach(lc, def->groupexprs)
+	{
+		if (!expr_list_member(groupexprs, lfirst(lc)))
+			context.rollup = true;
+	}
+
+	if (pg_class_aclcheck(def->mvoid, userid, ACL_SELECT) != ACLCHECK_OK)
+		return NULL;
+
+	context.mvrel = try_relation_open(def->mvoid, AccessShareLock, false);
+	if (context.mvrel == NULL)
+		return NULL;
+	if (!RelationIsPopulated(context.mvrel))
+	{
+		relation_close(context.mvrel, AccessShareLock);
+		return NULL;
+	}
+
+	result = copyObject(query);
+	result->targetList = (List *) matview_output_mutator((Node *) result->targetList,
+														 &context);
+	restquals = (List *) matview_output_mutator((Node *) restquals, &context);
+	if (context.failed)
+	{
+		relation_close(context.mvrel, AccessShareLock);
+		return NULL;
+	}
+
+	/* a view grouped like the query has one row per group already */
+	if (!context.rollup)
+	{
+		result->groupClause = NIL;
+		result->hasAggs = false;
+	}
+
+	mvrte = addRangeTableEntryForRelation(NULL, context.mvrel, NULL, false,
+										  true);
+	mvrte->checkAsUser = rte->checkAsUser;
+	pull_varattnos((Node *) result->targetList, 1, &selectedCols);
+	pull_varattnos((Node *) restquals, 1, &selectedCols);
+	mvrte->selectedCols = selectedCols;
+
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = 1;
+
+	result->rtable = list_make1(mvrte);
+	result->jointree = makeFromExpr(list_make1(rtr),
+									restquals != NIL ?
+									(Node *) make_ands_explicit(restquals) :
+									NULL);
+
+	*relpages = context.mvrel->rd_rel->relpages;
+
+	/* keep the lock until the end of the transaction */
+	relation_close(context.mvrel, NoLock);
+
+	return result;
+}
+
+/*
+ * orca_rewrite_matview -- rewrite an aggregate query to scan a materialized
+ * view of its table, if one matches.
+ *
+ * Returns the rewritten query, or the query as is.
+ */
+Query *
+orca_rewrite_matview(Query *query)
+{
+	RangeTblEntry *rte;
+	Oid			userid;
+	Query	   *result = query;
+	BlockNumber best_relpages = InvalidBlockNumber;
+	ListCell   *lc;
+
+	if (query->parentStmtType != PARENTSTMTTYPE_NONE ||
+		InSecurityRestrictedOperation() ||
+		list_length(query->rtable) != 1 ||
+		simple_aggregate_query(query) != 1)
+		return query;
+
+	rte = rt_fetch(1, query->rtable);
+	userid = OidIsValid(rte->checkAsUser) ? rte->checkAsUser : GetUserId();
+
+	/* the query mustn't read what it couldn't have read from the table */
+	if (pg_class_aclcheck(rte->relid, userid, ACL_SELECT) != ACLCHECK_OK)
+		return query;
+
+	foreach(lc, get_matviews(rte->relid))
+	{
+		MatviewDef *def = (MatviewDef *) lfirst(lc);
+		Query	   *rewritten;
+		BlockNumber relpages;
+
+		rewritten = match_matview(query, def, userid, &relpages);
+		if (rewritten == NULL)
+			continue;
+
+		if (result == query || relpages < best_relpages)
+		{
+			result = rewritten;
+			best_relpages = relpages;
+		}
+	}
+
+	if (result != query)
+		elog(DEBUG1, "answering query of \"%s\" from materialized view \"%s\"",
+			 get_rel_name(rte->relid),
+			 get_rel_name(rt_fetch(1, result->rtable)->relid));
+
+	return result;
+}
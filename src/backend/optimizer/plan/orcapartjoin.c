@@ -0,0 +1,1043 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcapartjoin.c
+ *	  Split GPORCA hash joins of co-partitioned tables into joins of their
+ *	  partitions, and sorts of partitioned tables into merges of ordered
+ *	  scans of their partitions.
+ *
+ * GPORCA joins two partitioned tables with one hash table over all the
+ * selected partitions of the inner table, even when both tables have the
+ * same partition bounds and are joined on their partition keys.  Then rows
+ * of a partition can only match rows of the partition with the same bounds
+ * on the other side, and the join can be done as an Append of joins of the
+ * pairs of partitions: each hash table holds a single partition, and pairs
+ * in which one of the partitions isn't selected are left out.
+ *
+ * This runs on the finished plan, when optimizer_enable_partition_wise_join
+ * is on, and only rewrites a shape it fully understands: an inner or semi
+ * Hash Join whose sides are dynamic scans of single level partitioned tables,
+ * possibly below the Sequence of their static partition selectors and below
+ * partition selectors for dynamic elimination, with no Motion in between.
+ * Dynamic elimination selectors are dropped, the pairing prunes at least as
+ * much.  Everything else is left as GPORCA planned it.
+ *
+ * Likewise, GPORCA has no order-preserving append of partitions, so a top-N
+ * query of a partitioned table with an index on the sort key, like ORDER BY
+ * ts LIMIT 100, sorts all the selected partitions.  When
+ * optimizer_enable_partition_merge_append is on, a bounded Sort of a dynamic
+ * scan, below a Limit or with a bound of its own, is replaced by a
+ * MergeAppend of index scans of the selected partitions, if each of them has
+ * a btree index that returns the rows in the order of the sort.  Then only
+ * the first rows of each partition are read.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcapartjoin.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/skey.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_index.h"
+#include "cdb/cdbpartition.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/orcapartjoin.h"
+#include "parser/parsetree.h"
+#include "rewrite/rewriteManip.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/relcache.h"
+
+/* A side of a hash join, down to the dynamic scan of its table */
+typedef struct PartJoinSide
+{
+	DynamicSeqScan *scan;
+	Index		rti;			/* range table index of the scan */
+	List	   *tlist;			/* output of the side, over the scan */
+	bool		restricted;		/* static selectors chose partOids */
+	List	   *partOids;
+	PartitionNode *pn;
+} PartJoinSide;
+
+static Plan *partwise_mutate(Plan *plan, PlannedStmt *stmt);
+static Plan *mergeappend_mutate(Plan *plan, PlannedStmt *stmt);
+
+/* The plan node whose rows a pass-through node returns */
+static Plan *
+passthrough_input(Plan *plan)
+{
+	if (IsA(plan, Sequence))
+		return (Plan *) llast(((Sequence *) plan)->subplans);
+	return plan->lefttree;
+}
+
+/*
+ * Express the target list of the first node of chain as expressions over
+ * scan, at the bottom of chain.  Each node of chain must only pass through
+ * columns of its input.
+ */
+static bool
+flatten_side_tlist(List *chain, Plan *scan, List **tlist)
+{
+	Plan	   *top = (chain != NIL) ? (Plan *) linitial(chain) : scan;
+	List	   *result = NIL;
+	ListCell   *lc;
+
+	foreach(lc, top->targetlist)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+		Expr	   *expr = tle->expr;
+		ListCell   *lcn;
+
+		foreach(lcn, chain)
+		{
+			Plan	   *input = passthrough_input((Plan *) lfirst(lcn));
+			Var		   *var = (Var *) expr;
+
+			if (!IsA(var, Var) || var->varno != OUTER_VAR ||
+				var->varattno < 1 ||
+				var->varattno > list_length(input->targetlist))
+				return false;
+
+			expr = ((TargetEntry *) list_nth(input->targetlist,
+											 var->varattno - 1))->expr;
+		}
+
+		result = lappend(result,
+						 makeTargetEntry((Expr *) copyObject(expr),
+										 list_length(result) + 1,
+										 tle->resname, tle->resjunk));
+	}
+
+	*tlist = result;
+	return true;
+}
+
+/*
+ * Match a side of a hash join: [Hash ->] [PartitionSelector ->]*
+ * [Sequence(static PartitionSelectors, ...) ->] DynamicSeqScan.  The
+ * selectors found are added to *selectors.
+ */
+static bool
+match_join_side(Plan *plan, bool inner, PartJoinSide *side, List **selectors)
+{
+	List	   *chain = NIL;
+	Plan	   *p = plan;
+	ListCell   *lc;
+
+	MemSet(side, 0, sizeof(PartJoinSide));
+
+	if (inner)
+	{
+		if (!IsA(p, Hash))
+			return false;
+		chain = lappend(chain, p);
+		p = p->lefttree;
+	}
+
+	while (IsA(p, PartitionSelector))
+	{
+		if (((PartitionSelector *) p)->staticSelection || p->lefttree == NULL)
+			return false;
+		*selectors = lappend(*selectors, p);
+		chain = lappend(chain, p);
+		p = p->lefttree;
+	}
+
+	if (IsA(p, Sequence))
+	{
+		DynamicSeqScan *last = (DynamicSeqScan *) passthrough_input(p);
+
+		if (!IsA(last, DynamicSeqScan))
+			return false;
+
+		foreach(lc, ((Sequence *) p)->subplans)
+		{
+			PartitionSelector *ps = (PartitionSelector *) lfirst(lc);
+			ListCell   *lcs;
+
+			if ((DynamicSeqScan *) ps == last)
+				break;
+			if (!IsA(ps, PartitionSelector) || !ps->staticSelection ||
+				ps->scanId != last->partIndex)
+				return false;
+			foreach(lcs, ps->staticScanIds)
+			{
+				if (lfirst_int(lcs) != last->partIndex)
+					return false;
+			}
+
+			if (!side->restricted)
+				side->partOids = list_copy(ps->staticPartOids);
+			else
+			{
+				List	   *both = NIL;
+
+				foreach(lcs, side->partOids)
+				{
+					if (list_member_oid(ps->staticPartOids, lfirst_oid(lcs)))
+						both = lappend_oid(both, lfirst_oid(lcs));
+				}
+				side->partOids = both;
+			}
+			side->restricted = true;
+			*selectors = lappend(*selectors, ps);
+		}
+		chain = lappend(chain, p);
+		p = (Plan *) last;
+	}
+
+	if (!IsA(p, DynamicSeqScan) || p->initPlan != NIL)
+		return false;
+
+	foreach(lc, chain)
+	{
+		Plan	   *node = (Plan *) lfirst(lc);
+
+		if (node->qual != NIL || node->initPlan != NIL)
+			return false;
+	}
+
+	side->scan = (DynamicSeqScan *) p;
+	side->rti = side->scan->seqscan.scanrelid;
+
+	return flatten_side_tlist(chain, p, &side->tlist);
+}
+
+/* Is expr, over the scan of side, its partition key? */
+static bool
+is_partition_key(Expr *expr, PartJoinSide *side)
+{
+	Var		   *var;
+
+	while (IsA(expr, RelabelType))
+		expr = ((RelabelType *) expr)->arg;
+
+	var = (Var *) expr;
+	return IsA(var, Var) && var->varno == side->rti &&
+		var->varattno == side->pn->part->paratts[0];
+}
+
+/* Does a hash clause equate the partition keys of the two sides? */
+static bool
+joins_partition_keys(List *hashclauses, PartJoinSide *outer, PartJoinSide *inner)
+{
+	Oid			opfamily = get_opclass_family(outer->pn->part->parclass[0]);
+	Oid			keytype = get_opclass_input_type(outer->pn->part->parclass[0]);
+	ListCell   *lc;
+
+	foreach(lc, hashclauses)
+	{
+		OpExpr	   *op = (OpExpr *) lfirst(lc);
+		Var		   *left;
+		Var		   *right;
+		Var		   *outervar;
+		Var		   *innervar;
+
+		if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+			continue;
+		left = (Var *) linitial(op->args);
+		right = (Var *) lsecond(op->args);
+		if (!IsA(left, Var) || !IsA(right, Var))
+			continue;
+
+		if (left->varno == OUTER_VAR && right->varno == INNER_VAR)
+		{
+			outervar = left;
+			innervar = right;
+		}
+		else if (left->varno == INNER_VAR && right->varno == OUTER_VAR)
+		{
+			outervar = right;
+			innervar = left;
+		}
+		else
+			continue;
+
+		if (outervar->varattno < 1 ||
+			outervar->varattno > list_length(outer->tlist) ||
+			innervar->varattno < 1 ||
+			innervar->varattno > list_length(inner->tlist))
+			continue;
+
+		if (op->opno == get_opfamily_member(opfamily, keytype, keytype,
+											BTEqualStrategyNumber) &&
+			is_partition_key(((TargetEntry *) list_nth(outer->tlist,
+													   outervar->varattno - 1))->expr,
+							 outer) &&
+			is_partition_key(((TargetEntry *) list_nth(inner->tlist,
+													   innervar->varattno - 1))->expr,
+							 inner))
+			return true;
+	}
+
+	return false;
+}
+
+static bool
+partition_rules_equal(PartitionRule *a, PartitionRule *b)
+{
+	return a->parisdefault == b->parisdefault &&
+		equal(a->parrangestart, b->parrangestart) &&
+		a->parrangestartincl == b->parrangestartincl &&
+		equal(a->parrangeend, b->parrangeend) &&
+		a->parrangeendincl == b->parrangeendincl &&
+		equal(a->parlistvalues, b->parlistvalues);
+}
+
+/* Is the partitioning of the table scanned by side usable for pairing? */
+static bool
+single_level_partitioning(PartJoinSide *side, Oid relid)
+{
+	ListCell   *lc;
+
+	side->pn = RelationBuildPartitionDescByOid(relid, false);
+	if (side->pn == NULL || side->pn->part->parnatts != 1)
+		return false;
+
+	foreach(lc, side->pn->rules)
+	{
+		if (((PartitionRule *) lfirst(lc))->children != NULL)
+			return false;
+	}
+	if (side->pn->default_part && side->pn->default_part->children != NULL)
+		return false;
+
+	return true;
+}
+
+/*
+ * Can a leaf be scanned with a plain SeqScan, using the expressions of the
+ * dynamic scan of the root?  Its columns must be where they are in the root.
+ */
+static bool
+leaf_matches_root(Oid leafOid, TupleDesc rootdesc)
+{
+	Relation	leaf;
+	TupleDesc	leafdesc;
+	bool		result;
+	int			i;
+
+	leaf = heap_open(leafOid, AccessShareLock);
+	leafdesc = RelationGetDescr(leaf);
+
+	result = !RelationIsExternal(leaf) &&
+		leaf->rd_rel->relkind == RELKIND_RELATION &&
+		leafdesc->natts == rootdesc->natts;
+
+	for (i = 0; result && i < rootdesc->natts; i++)
+	{
+		Form_pg_attribute rootatt = rootdesc->attrs[i];
+		Form_pg_attribute leafatt = leafdesc->attrs[i];
+
+		if (rootatt->attisdropped != leafatt->attisdropped ||
+			(!rootatt->attisdropped && rootatt->atttypid != leafatt->atttypid))
+			result = false;
+	}
+
+	heap_close(leaf, NoLock);
+
+	return result;
+}
+
+/* Is a leaf among the partitions side scans? */
+static bool
+leaf_selected(PartJoinSide *side, Oid leafOid)
+{
+	return !side->restricted || list_member_oid(side->partOids, leafOid);
+}
+
+/*
+ * Pair up the partitions of the two sides that have equal bounds.  Returns
+ * false if a partition of one side has no partition with the same bounds on
+ * the other.  Only pairs of partitions that are both selected are returned.
+ */
+static bool
+pair_partitions(PartJoinSide *outer, PartJoinSide *inner,
+				List **outerOids, List **innerOids)
+{
+	PartitionNode *opn = outer->pn;
+	PartitionNode *ipn = inner->pn;
+	ListCell   *lc;
+
+	*outerOids = NIL;
+	*innerOids = NIL;
+
+	if (opn->part->parkind != ipn->part->parkind ||
+		opn->part->parclass[0] != ipn->part->parclass[0] ||
+		list_length(opn->rules) != list_length(ipn->rules) ||
+		(opn->default_part == NULL) != (ipn->default_part == NULL))
+		return false;
+
+	foreach(lc, opn->rules)
+	{
+		PartitionRule *orule = (PartitionRule *) lfirst(lc);
+		PartitionRule *irule = NULL;
+		ListCell   *lci;
+
+		foreach(lci, ipn->rules)
+		{
+			if (partition_rules_equal(orule, (PartitionRule *) lfirst(lci)))
+			{
+				irule = (PartitionRule *) lfirst(lci);
+				break;
+			}
+		}
+		if (irule == NULL)
+			return false;
+
+		if (leaf_selected(outer, orule->parchildrelid) &&
+			leaf_selected(inner, irule->parchildrelid))
+		{
+			*outerOids = lappend_oid(*outerOids, orule->parchildrelid);
+			*innerOids = lappend_oid(*innerOids, irule->parchildrelid);
+		}
+	}
+
+	/* the default partitions hold the rest of the same values */
+	if (opn->default_part &&
+		leaf_selected(outer, opn->default_part->parchildrelid) &&
+		leaf_selected(inner, ipn->default_part->parchildrelid))
+	{
+		*outerOids = lappend_oid(*outerOids, opn->default_part->parchildrelid);
+		*innerOids = lappend_oid(*innerOids, ipn->default_part->parchildrelid);
+	}
+
+	return true;
+}
+
+/* Copy the estimates and the MPP fields of src, for a share of its rows */
+static void
+copy_plan_info(Plan *dst, Plan *src, double share)
+{
+	dst->startup_cost = src->startup_cost;
+	dst->total_cost = src->startup_cost +
+		(src->total_cost - src->startup_cost) * share;
+	dst->plan_rows = src->plan_rows * share;
+	dst->plan_width = src->plan_width;
+	dst->extParam = bms_copy(src->extParam);
+	dst->allParam = bms_copy(src->allParam);
+	dst->flow = copyObject(src->flow);
+	dst->motionNode = src->motionNode;
+}
+
+/* A target list returning the columns of the outer input as they are */
+static List *
+make_outer_tlist(List *tlist)
+{
+	List	   *result = NIL;
+	ListCell   *lc;
+
+	foreach(lc, tlist)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+		Var		   *var;
+
+		var = makeVar(OUTER_VAR, tle->resno,
+					  exprType((Node *) tle->expr),
+					  exprTypmod((Node *) tle->expr),
+					  exprCollation((Node *) tle->expr),
+					  0);
+		result = lappend(result,
+						 makeTargetEntry((Expr *) var, tle->resno,
+										 tle->resname, tle->resjunk));
+	}
+
+	return result;
+}
+
+/* Scan a leaf of the table side scans, with its target list and filter */
+static Plan *
+make_leaf_scan(PlannedStmt *stmt, PartJoinSide *side, Oid leafOid,
+			   double share)
+{
+	SeqScan    *scan = makeNode(SeqScan);
+	RangeTblEntry *rte;
+	Index		rti;
+
+	/* permissions are checked on the root's entry */
+	rte = (RangeTblEntry *) copyObject(rt_fetch(side->rti, stmt->rtable));
+	rte->relid = leafOid;
+	rte->inh = false;
+	rte->requiredPerms = 0;
+	stmt->rtable = lappend(stmt->rtable, rte);
+	rti = list_length(stmt->rtable);
+
+	copy_plan_info(&scan->plan, &side->scan->seqscan.plan, share);
+	scan->scanrelid = rti;
+	scan->plan.targetlist = (List *) copyObject(side->tlist);
+	scan->plan.qual = (List *) copyObject(side->scan->seqscan.plan.qual);
+	ChangeVarNodes((Node *) scan->plan.targetlist, side->rti, rti, 0);
+	ChangeVarNodes((Node *) scan->plan.qual, side->rti, rti, 0);
+
+	return (Plan *) scan;
+}
+
+/*
+ * Join a pair of partitions, like join joins the tables.
+ */
+static Plan *
+make_pair_join(PlannedStmt *stmt, HashJoin *join,
+			   PartJoinSide *outer, Oid outerOid,
+			   PartJoinSide *inner, Oid innerOid, double share)
+{
+	Hash	   *hash = (Hash *) join->join.plan.righttree;
+	HashJoin   *pairjoin = makeNode(HashJoin);
+	Hash	   *pairhash = makeNode(Hash);
+	Plan	   *outerscan;
+	Plan	   *innerscan;
+
+	outerscan = make_leaf_scan(stmt, outer, outerOid, share);
+	innerscan = make_leaf_scan(stmt, inner, innerOid, share);
+
+	copy_plan_info(&pairhash->plan, &hash->plan, share);
+	pairhash->plan.targetlist = make_outer_tlist(innerscan->targetlist);
+	pairhash->plan.lefttree = innerscan;
+	pairhash->rescannable = hash->rescannable;
+	pairhash->skewTable = hash->skewTable;
+	pairhash->skewColumn = hash->skewColumn;
+	pairhash->skewInherit = hash->skewInherit;
+	pairhash->skewColType = hash->skewColType;
+	pairhash->skewColTypmod = hash->skewColTypmod;
+
+	copy_plan_info(&pairjoin->join.plan, &join->join.plan, share);
+	pairjoin->join.plan.targetlist = (List *) copyObject(join->join.plan.targetlist);
+	pairjoin->join.plan.qual = (List *) copyObject(join->join.plan.qual);
+	pairjoin->join.plan.lefttree = outerscan;
+	pairjoin->join.plan.righttree = (Plan *) pairhash;
+	pairjoin->join.jointype = join->join.jointype;
+	pairjoin->join.joinqual = (List *) copyObject(join->join.joinqual);
+	pairjoin->join.prefetch_inner = join->join.prefetch_inner;
+	pairjoin->join.prefetch_joinqual = join->join.prefetch_joinqual;
+	pairjoin->hashclauses = (List *) copyObject(join->hashclauses);
+	pairjoin->hashqualclauses = (List *) copyObject(join->hashqualclauses);
+
+	return (Plan *) pairjoin;
+}
+
+/* Do the selectors found account for all the selectors of their scans? */
+static bool
+selectors_all_found(PlannedStmt *stmt, List *selectors, int scanId)
+{
+	int			found = 0;
+	ListCell   *lc;
+
+	foreach(lc, selectors)
+	{
+		if (((PartitionSelector *) lfirst(lc))->scanId == scanId)
+			found++;
+	}
+
+	if (scanId < list_length(stmt->numSelectorsPerScanId))
+		return found == list_nth_int(stmt->numSelectorsPerScanId, scanId);
+	return found == 0;
+}
+
+static void
+forget_selectors(PlannedStmt *stmt, int scanId)
+{
+	if (scanId < list_length(stmt->numSelectorsPerScanId))
+		lfirst_int(list_nth_cell(stmt->numSelectorsPerScanId, scanId)) = 0;
+}
+
+/*
+ * Rewrite join into an Append of joins of pairs of partitions, if it joins
+ * co-partitioned tables on their partition keys.  Returns NULL if it can't.
+ */
+static Plan *
+partition_wise_join(HashJoin *join, PlannedStmt *stmt)
+{
+	Plan	   *plan = (Plan *) join;
+	PartJoinSide outer;
+	PartJoinSide inner;
+	List	   *selectors = NIL;
+	List	   *outerOids;
+	List	   *innerOids;
+	Relation	outerrel;
+	Relation	innerrel;
+	bool		ok;
+	int			npairs;
+	Append	   *append;
+	ListCell   *lco;
+	ListCell   *lci;
+	ListCell   *lc;
+
+	if (join->join.jointype != JOIN_INNER && join->join.jointype != JOIN_SEMI)
+		return NULL;
+	if (plan->initPlan != NIL)
+		return NULL;
+
+	if (!match_join_side(plan->lefttree, false, &outer, &selectors) ||
+		!match_join_side(plan->righttree, true, &inner, &selectors))
+		return NULL;
+	if (outer.scan->partIndex == inner.scan->partIndex)
+		return NULL;
+
+	/* dropping selectors of other scans would lose their elimination */
+	foreach(lc, selectors)
+	{
+		int			scanId = ((PartitionSelector *) lfirst(lc))->scanId;
+
+		if (scanId != outer.scan->partIndex && scanId != inner.scan->partIndex)
+			return NULL;
+	}
+	if (!selectors_all_found(stmt, selectors, outer.scan->partIndex) ||
+		!selectors_all_found(stmt, selectors, inner.scan->partIndex))
+		return NULL;
+
+	if (!single_level_partitioning(&outer, rt_fetch(outer.rti, stmt->rtable)->relid) ||
+		!single_level_partitioning(&inner, rt_fetch(inner.rti, stmt->rtable)->relid))
+		return NULL;
+
+	if (!joins_partition_keys(join->hashclauses, &outer, &inner))
+		return NULL;
+
+	if (!pair_partitions(&outer, &inner, &outerOids, &innerOids))
+		return NULL;
+
+	npairs = list_length(outerOids);
+	if (npairs == 0)
+		return NULL;
+
+	outerrel = heap_open(rt_fetch(outer.rti, stmt->rtable)->relid, AccessShareLock);
+	innerrel = heap_open(rt_fetch(inner.rti, stmt->rtable)->relid, AccessShareLock);
+	ok = true;
+	forboth(lco, outerOids, lci, innerOids)
+	{
+		if (!leaf_matches_root(lfirst_oid(lco), RelationGetDescr(outerrel)) ||
+			!leaf_matches_root(lfirst_oid(lci), RelationGetDescr(innerrel)))
+		{
+			ok = false;
+			break;
+		}
+	}
+	heap_close(outerrel, NoLock);
+	heap_close(innerrel, NoLock);
+	if (!ok)
+		return NULL;
+
+	append = makeNode(Append);
+	copy_plan_info(&append->plan, plan, 1.0);
+	append->plan.targetlist = make_outer_tlist(plan->targetlist);
+	append->plan.dispatch = plan->dispatch;
+	append->plan.directDispatch = plan->directDispatch;
+	append->plan.nMotionNodes = plan->nMotionNodes;
+	append->plan.nInitPlans = plan->nInitPlans;
+
+	forboth(lco, outerOids, lci, innerOids)
+	{
+		append->appendplans = lappend(append->appendplans,
+									  make_pair_join(stmt, join,
+													 &outer, lfirst_oid(lco),
+													 &inner, lfirst_oid(lci),
+													 1.0 / npairs));
+	}
+
+	forget_selectors(stmt, outer.scan->partIndex);
+	forget_selectors(stmt, inner.scan->partIndex);
+
+	elog(DEBUG1, "split hash join of partitioned tables into %d joins of partitions",
+		 npairs);
+
+	return (Plan *) append;
+}
+
+static List *
+partwise_mutate_list(List *plans, PlannedStmt *stmt)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+		lfirst(lc) = partwise_mutate((Plan *) lfirst(lc), stmt);
+
+	return plans;
+}
+
+static Plan *
+partwise_mutate(Plan *plan, PlannedStmt *stmt)
+{
+	if (plan == NULL)
+		return NULL;
+
+	if (IsA(plan, HashJoin))
+	{
+		Plan	   *newplan = partition_wise_join((HashJoin *) plan, stmt);
+
+		if (newplan != NULL)
+			return newplan;
+	}
+
+	plan->lefttree = partwise_mutate(plan->lefttree, stmt);
+	plan->righttree = partwise_mutate(plan->righttree, stmt);
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			partwise_mutate_list(((Append *) plan)->appendplans, stmt);
+			break;
+		case T_MergeAppend:
+			partwise_mutate_list(((MergeAppend *) plan)->mergeplans, stmt);
+			break;
+		case T_Sequence:
+			partwise_mutate_list(((Sequence *) plan)->subplans, stmt);
+			break;
+		case T_ModifyTable:
+			partwise_mutate_list(((ModifyTable *) plan)->plans, stmt);
+			break;
+		case T_SubqueryScan:
+			((SubqueryScan *) plan)->subplan =
+				partwise_mutate(((SubqueryScan *) plan)->subplan, stmt);
+			break;
+		default:
+			break;
+	}
+
+	return plan;
+}
+
+/*
+ * orca_partition_wise_joins -- split the hash joins of co-partitioned tables
+ * in a plan made by GPORCA into joins of their partitions.
+ *
+ * New range table entries for the partitions are added to stmt->rtable.
+ */
+void
+orca_partition_wise_joins(PlannedStmt *stmt)
+{
+	stmt->planTree = partwise_mutate(stmt->planTree, stmt);
+	partwise_mutate_list(stmt->subplans, stmt);
+}
+
+/*
+ * Find a btree index of a leaf that returns its rows in the order of the
+ * sort, whose keys are the columns keyattnos of the leaf.  Sets *backward
+ * if the index must be scanned backward.
+ */
+static Oid
+find_ordered_index(Oid leafOid, Sort *sort, AttrNumber *keyattnos,
+				   bool *backward)
+{
+	Relation	leaf;
+	List	   *indexoids;
+	ListCell   *lc;
+	Oid			result = InvalidOid;
+
+	/* only heap tables can be scanned with plain index scans */
+	leaf = heap_open(leafOid, AccessShareLock);
+	indexoids = RelationIsHeap(leaf) ? RelationGetIndexList(leaf) : NIL;
+	heap_close(leaf, NoLock);
+
+	foreach(lc, indexoids)
+	{
+		Relation	index = index_open(lfirst_oid(lc), AccessShareLock);
+		bool		ok;
+		int			i;
+
+		ok = index->rd_rel->relam == BTREE_AM_OID &&
+			IndexIsValid(index->rd_index) &&
+			index->rd_index->indnatts >= sort->numCols &&
+			RelationGetIndexPredicate(index) == NIL;
+
+		for (i = 0; ok && i < sort->numCols; i++)
+		{
+			Oid			opfamily;
+			Oid			opcintype;
+			int16		strategy;
+			bool		desc;
+			bool		nullsfirst;
+
+			if (index->rd_index->indkey.values[i] != keyattnos[i] ||
+				index->rd_indcollation[i] != sort->collations[i] ||
+				!get_ordering_op_properties(sort->sortOperators[i], &opfamily,
+											&opcintype, &strategy) ||
+				opfamily != index->rd_opfamily[i])
+			{
+				ok = false;
+				break;
+			}
+
+			/* the direction of a backward scan is the reverse of the index */
+			desc = (index->rd_indoption[i] & INDOPTION_DESC) != 0;
+			nullsfirst = (index->rd_indoption[i] & INDOPTION_NULLS_FIRST) != 0;
+			if (i == 0)
+				*backward = (desc != (strategy == BTGreaterStrategyNumber));
+			if ((desc != *backward) != (strategy == BTGreaterStrategyNumber) ||
+				(nullsfirst != *backward) != sort->nullsFirst[i])
+				ok = false;
+		}
+
+		index_close(index, NoLock);
+
+		if (ok)
+		{
+			result = lfirst_oid(lc);
+			break;
+		}
+	}
+
+	list_free(indexoids);
+
+	return result;
+}
+
+/* Scan a leaf of the table side scans with an index, in its order */
+static Plan *
+make_leaf_index_scan(PlannedStmt *stmt, PartJoinSide *side, Oid leafOid,
+					 Oid indexOid, bool backward, List *tlist, double share)
+{
+	IndexScan  *scan = makeNode(IndexScan);
+	RangeTblEntry *rte;
+	Index		rti;
+
+	/* permissions are checked on the root's entry */
+	rte = (RangeTblEntry *) copyObject(rt_fetch(side->rti, stmt->rtable));
+	rte->relid = leafOid;
+	rte->inh = false;
+	rte->requiredPerms = 0;
+	stmt->rtable = lappend(stmt->rtable, rte);
+	rti = list_length(stmt->rtable);
+
+	copy_plan_info(&scan->scan.plan, &side->scan->seqscan.plan, share);
+	scan->scan.scanrelid = rti;
+	scan->scan.plan.targetlist = (List *) copyObject(tlist);
+	scan->scan.plan.qual = (List *) copyObject(side->scan->seqscan.plan.qual);
+	ChangeVarNodes((Node *) scan->scan.plan.targetlist, side->rti, rti, 0);
+	ChangeVarNodes((Node *) scan->scan.plan.qual, side->rti, rti, 0);
+	scan->indexid = indexOid;
+	scan->indexorderdir = backward ? BackwardScanDirection : ForwardScanDirection;
+
+	return (Plan *) scan;
+}
+
+/*
+ * Rewrite a bounded sort of a dynamic scan into a MergeAppend of ordered
+ * index scans of the selected partitions.  Returns NULL if it can't.
+ */
+static Plan *
+partition_merge_append(Sort *sort, PlannedStmt *stmt)
+{
+	Plan	   *plan = (Plan *) sort;
+	PartJoinSide side;
+	List	   *selectors = NIL;
+	List	   *tlist = NIL;
+	AttrNumber *keyattnos;
+	AttrNumber *keycols;
+	PartitionNode *pn;
+	List	   *leafOids = NIL;
+	List	   *indexOids = NIL;
+	List	   *directions = NIL;
+	Relation	rootrel;
+	MergeAppend *mergeappend;
+	ListCell   *lc;
+	ListCell   *lci;
+	ListCell   *lcd;
+	int			nleaves;
+	int			i;
+
+	if (sort->noduplicates || sort->share_type != SHARE_NOTSHARED ||
+		plan->qual != NIL || plan->initPlan != NIL)
+		return NULL;
+
+	if (!match_join_side(plan->lefttree, false, &side, &selectors))
+		return NULL;
+	foreach(lc, selectors)
+	{
+		if (((PartitionSelector *) lfirst(lc))->scanId != side.scan->partIndex)
+			return NULL;
+	}
+	if (!selectors_all_found(stmt, selectors, side.scan->partIndex))
+		return NULL;
+
+	/* the output of the sort, over the scan */
+	foreach(lc, plan->targetlist)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+		Var		   *var = (Var *) tle->expr;
+
+		if (!IsA(var, Var) || var->varno != OUTER_VAR ||
+			var->varattno < 1 || var->varattno > list_length(side.tlist))
+			return NULL;
+		tlist = lappend(tlist,
+						makeTargetEntry((Expr *) copyObject(((TargetEntry *) list_nth(side.tlist, var->varattno - 1))->expr),
+										tle->resno, tle->resname, tle->resjunk));
+	}
+
+	/* the columns of the table it sorts by, and where they are in tlist */
+	keyattnos = (AttrNumber *) palloc(sort->numCols * sizeof(AttrNumber));
+	keycols = (AttrNumber *) palloc(sort->numCols * sizeof(AttrNumber));
+	for (i = 0; i < sort->numCols; i++)
+	{
+		AttrNumber	col = sort->sortColIdx[i];
+		Var		   *var;
+
+		if (col < 1 || col > list_length(side.tlist))
+			return NULL;
+		var = (Var *) ((TargetEntry *) list_nth(side.tlist, col - 1))->expr;
+		if (!IsA(var, Var) || var->varno != side.rti || var->varattno < 1)
+			return NULL;
+		keyattnos[i] = var->varattno;
+
+		keycols[i] = 0;
+		foreach(lc, plan->targetlist)
+		{
+			TargetEntry *tle = (TargetEntry *) lfirst(lc);
+
+			if (((Var *) tle->expr)->varattno == col)
+			{
+				keycols[i] = tle->resno;
+				break;
+			}
+		}
+		if (keycols[i] == 0)
+			return NULL;
+	}
+
+	pn = RelationBuildPartitionDescByOid(rt_fetch(side.rti, stmt->rtable)->relid,
+										 false);
+	if (pn == NULL)
+		return NULL;
+
+	rootrel = heap_open(rt_fetch(side.rti, stmt->rtable)->relid, AccessShareLock);
+	foreach(lc, all_leaf_partition_relids(pn))
+	{
+		Oid			leafOid = lfirst_oid(lc);
+		Oid			indexOid;
+		bool		backward = false;
+
+		if (!leaf_selected(&side, leafOid))
+			continue;
+
+		if (!leaf_matches_root(leafOid, RelationGetDescr(rootrel)))
+			break;
+		indexOid = find_ordered_index(leafOid, sort, keyattnos, &backward);
+		if (!OidIsValid(indexOid))
+			break;
+
+		leafOids = lappend_oid(leafOids, leafOid);
+		indexOids = lappend_oid(indexOids, indexOid);
+		directions = lappend_int(directions, backward);
+	}
+	heap_close(rootrel, NoLock);
+	if (lc != NULL)
+		return NULL;
+
+	nleaves = list_length(leafOids);
+	if (nleaves == 0)
+		return NULL;
+
+	mergeappend = makeNode(MergeAppend);
+	copy_plan_info(&mergeappend->plan, plan, 1.0);
+	mergeappend->plan.targetlist = make_outer_tlist(tlist);
+	mergeappend->plan.dispatch = plan->dispatch;
+	mergeappend->plan.directDispatch = plan->directDispatch;
+	mergeappend->plan.nMotionNodes = plan->nMotionNodes;
+	mergeappend->plan.nInitPlans = plan->nInitPlans;
+	mergeappend->numCols = sort->numCols;
+	mergeappend->sortColIdx = keycols;
+	mergeappend->sortOperators = sort->sortOperators;
+	mergeappend->collations = sort->collations;
+	mergeappend->nullsFirst = sort->nullsFirst;
+
+	forthree(lc, leafOids, lci, indexOids, lcd, directions)
+	{
+		mergeappend->mergeplans =
+			lappend(mergeappend->mergeplans,
+					make_leaf_index_scan(stmt, &side, lfirst_oid(lc),
+										 lfirst_oid(lci), lfirst_int(lcd) != 0,
+										 tlist, 1.0 / nleaves));
+	}
+
+	forget_selectors(stmt, side.scan->partIndex);
+
+	elog(DEBUG1, "replaced sort of partitioned table by merge of %d index scans",
+		 nleaves);
+
+	return (Plan *) mergeappend;
+}
+
+static List *
+mergeappend_mutate_list(List *plans, PlannedStmt *stmt)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+		lfirst(lc) = mergeappend_mutate((Plan *) lfirst(lc), stmt);
+
+	return plans;
+}
+
+static Plan *
+mergeappend_mutate(Plan *plan, PlannedStmt *stmt)
+{
+	if (plan == NULL)
+		return NULL;
+
+	/* a sort is only worth replacing if few of its rows are needed */
+	if (IsA(plan, Limit) && plan->lefttree != NULL &&
+		IsA(plan->lefttree, Sort))
+	{
+		Plan	   *newplan = partition_merge_append((Sort *) plan->lefttree,
+													 stmt);
+
+		if (newplan != NULL)
+		{
+			plan->lefttree = newplan;
+			return plan;
+		}
+	}
+	else if (IsA(plan, Sort) && ((Sort *) plan)->limitCount != NULL)
+	{
+		Plan	   *newplan = partition_merge_append((Sort *) plan, stmt);
+
+		if (newplan != NULL)
+			return newplan;
+	}
+
+	plan->lefttree = mergeappend_mutate(plan->lefttree, stmt);
+	plan->righttree = mergeappend_mutate(plan->righttree, stmt);
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			mergeappend_mutate_list(((Append *) plan)->appendplans, stmt);
+			break;
+		case T_MergeAppend:
+			mergeappend_mutate_list(((MergeAppend *) plan)->mergeplans, stmt);
+			break;
+		case T_Sequence:
+			mergeappend_mutate_list(((Sequence *) plan)->subplans, stmt);
+			break;
+		case T_ModifyTable:
+			mergeappend_mutate_list(((ModifyTable *) plan)->plans, stmt);
+			break;
+		case T_SubqueryScan:
+			((SubqueryScan *) plan)->subplan =
+				mergeappend_mutate(((SubqueryScan *) plan)->subplan, stmt);
+			break;
+		default:
+			break;
+	}
+
+	return plan;
+}
+
+/*
+ * orca_partition_merge_appends -- replace the bounded sorts of partitioned
+ * tables in a plan made by GPORCA with merges of ordered index scans of their
+ * partitions.
+ *
+ * New range table entries for the partitions are added to stmt->rtable.
+ */
+void
+orca_partition_merge_appends(PlannedStmt *stmt)
+{
+	stmt->planTree = mergeappend_mutate(stmt->planTree, stmt);
+	mergeappend_mutate_list(stmt->subplans, stmt);
+}
@@ -0,0 +1,1157 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaplancache.c
+ *	  Cache of the plans produced by GPORCA, keyed by the query shape.
+ *
+ * GPORCA can't optimize queries with parameters, so a cached plan can't be a
+ * generic plan in the sense of plancache.c.  Instead, the constants of the
+ * normalized query are replaced by parameters to form the key, and the plans
+ * produced for the key are turned into a template by replacing the constants
+ * of the query found in them with the same parameters.  As long as all the
+ * plans optimized for the key give the same template, the constants only
+ * show up in the plan where the query has them, and the template can be
+ * filled in with the constants of the next query instead of optimizing it.
+ *
+ * Like in plancache.c, the first plans of a key are custom plans, optimized
+ * for their constants.  After that the template is used, if the highest cost
+ * estimated for it is not more than the average cost of the custom plans by
+ * much, that is if the constants don't change the estimates much.  Constants
+ * that had the same value in all the custom plans can't be told apart from
+ * the ones GPORCA put in the plan by itself, so a query with another value
+ * for them is optimized again.
+ *
+ * Plans that depend on the values of the constants beyond the places where
+ * they appear, such as plans dispatched to some of the segments only, or
+ * plans of queries on partitioned tables, which may be pruned statically,
+ * are not cached.  Neither are queries of CREATE TABLE AS or COPY.
+ *
+ * The cache is private to the backend.  It's reset whenever objects of the
+ * metadata cache of GPORCA are invalidated, so it follows the same catalog
+ * changes.  Changes to the optimizer settings don't invalidate it.
+ *
+ * When optimizer_plan_baselines is set, the template of the first plan of a
+ * key is also kept as its baseline, which isn't reset with the cache, but
+ * only when the definitions of the relations of the plan change.  A plan of
+ * another shape, as may come after ANALYZE, is then not used right away:
+ * the baseline is filled in with the constants instead, and only every few
+ * executions the new plan is tried.  Once it has been tried a few times, it
+ * becomes the baseline if the trials ran faster on average than the baseline
+ * does, and it's given up otherwise, so that a single noisy trial doesn't
+ * decide.  The executions are timed from ExecutorStart to ExecutorEnd on
+ * the master.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcaplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "catalog/gp_policy.h"
+#include "cdb/cdbllize.h"
+#include "cdb/cdbpartition.h"
+#include "cdb/cdbplan.h"
+#include "executor/executor.h"
+#include "lib/ilist.h"
+#include "lib/stringinfo.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/orcaplancache.h"
+#include "utils/datum.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/relcache.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+
+/* Custom plans to optimize for a key before its template may be used */
+#define ORCA_PLAN_CACHE_NUM_CUSTOM_PLANS 5
+
+/* How much more the template may cost than the average custom plan */
+#define ORCA_PLAN_CACHE_COST_FACTOR 1.1
+
+/* Executions of the baseline between the trials of a plan of another shape */
+#define ORCA_PLAN_BASELINE_TRIAL_INTERVAL 10
+
+/* Trials of a plan of another shape before it's compared with the baseline */
+#define ORCA_PLAN_BASELINE_NUM_TRIALS 3
+
+struct OrcaPlanCacheQuery
+{
+	char	   *key;			/* query with Params, without locations */
+	uint32		hashvalue;
+	int			num_consts;
+	Const	  **consts;			/* constants of the query, by paramid - 1 */
+};
+
+typedef struct OrcaCachedPlan
+{
+	uint32		hashvalue;		/* hash key, must be first */
+	char	   *key;
+	MemoryContext context;		/* holds all the data of the entry */
+	int			num_consts;
+	Const	  **first_consts;	/* of the first custom plan */
+	bool	   *varied;			/* has the constant had other values? */
+	PlannedStmt *template_plan;	/* NULL until a custom plan is templated */
+	char	   *template_str;	/* the template without estimates */
+	bool		unusable;		/* the plans depend on the constants */
+	int			num_custom_plans;
+	double		total_custom_cost;
+	double		max_custom_cost;
+	dlist_node	lru_node;		/* most recently used first */
+} OrcaCachedPlan;
+
+typedef struct OrcaPlanBaseline
+{
+	uint32		hashvalue;		/* hash key, must be first */
+	char	   *key;
+	MemoryContext context;		/* holds the key and the contexts below */
+	uint32		fingerprint;	/* of the relations of the plans */
+	uint64		generation;		/* changes with the plans */
+	MemoryContext plan_context;	/* holds the baseline */
+	PlannedStmt *template_plan;
+	char	   *template_str;
+	int			num_runs;		/* timed executions of the baseline */
+	double		total_time;		/* their total time, in ms */
+	int			runs_since_trial;
+	MemoryContext candidate_context;	/* holds the plan of another shape */
+	PlannedStmt *candidate_plan;	/* NULL until one is optimized */
+	char	   *candidate_str;
+	bool		candidate_rejected;	/* lost the trials */
+	int			num_trials;
+	double		total_trial_time;
+	dlist_node	lru_node;		/* most recently used first */
+} OrcaPlanBaseline;
+
+typedef struct
+{
+	List	   *consts;
+} parameterize_context;
+
+typedef struct
+{
+	plan_tree_base_prefix base;
+	OrcaPlanCacheQuery *cache_query;
+	bool	   *found;			/* constants found in the plan */
+	bool		dependent;		/* plan depends on the values otherwise */
+} template_context;
+
+typedef struct
+{
+	plan_tree_base_prefix base;
+	OrcaPlanCacheQuery *cache_query;
+} instantiate_context;
+
+static MemoryContext OrcaPlanCacheContext = NULL;
+static HTAB *OrcaPlanCacheHash = NULL;
+static dlist_head OrcaPlanCacheLRU = DLIST_STATIC_INIT(OrcaPlanCacheLRU);
+
+static MemoryContext OrcaPlanBaselineContext = NULL;
+static HTAB *OrcaPlanBaselineHash = NULL;
+static dlist_head OrcaPlanBaselineLRU = DLIST_STATIC_INIT(OrcaPlanBaselineLRU);
+static uint64 OrcaPlanBaselineGeneration = 0;
+
+/* The plan last returned by OrcaPlanBaselineChoose(), to time it */
+static PlannedStmt *TimedPlan = NULL;
+static uint32 TimedPlanHashValue;
+static uint64 TimedPlanGeneration;
+static bool TimedPlanIsTrial;
+static TimestampTz TimedPlanStart = 0;	/* 0 until its execution starts */
+
+/* fields of nodeToString() output left out of the keys */
+static const char *const query_key_skipped_fields[] = {
+	"location"
+};
+
+/* fields of nodeToString() output left out when templates are compared */
+static const char *const template_skipped_fields[] = {
+	"location",
+	"startup_cost",
+	"total_cost",
+	"plan_rows",
+	"plan_width",
+	"numGroups"
+};
+
+/*
+ * Copy the output of nodeToString(), without the fields of the names and
+ * their values.
+ */
+static char *
+strip_node_fields(const char *str, const char *const *fields, int num_fields)
+{
+	StringInfoData buf;
+	const char *p = str;
+
+	initStringInfo(&buf);
+
+	while (*p != '\0')
+	{
+		if (p[0] == ' ' && p[1] == ':')
+		{
+			const char *name = p + 2;
+			size_t		len = strcspn(name, " ");
+			int			i;
+
+			for (i = 0; i < num_fields; i++)
+			{
+				if (strlen(fields[i]) == len && strncmp(name, fields[i], len) == 0)
+					break;
+			}
+
+			if (i < num_fields)
+			{
+				/* the values of the fields are single tokens */
+				p = name + len;
+				if (*p == ' ')
+				{
+					p++;
+					p += strcspn(p, " )}");
+				}
+				continue;
+			}
+		}
+
+		appendStringInfoChar(&buf, *p++);
+	}
+
+	return buf.data;
+}
+
+static bool
+consts_are_equal(const Const *a, const Const *b)
+{
+	if (a->consttype != b->consttype || a->constisnull != b->constisnull)
+		return false;
+
+	if (a->constisnull)
+		return true;
+
+	return datumIsEqual(a->constvalue, b->constvalue, a->constbyval, a->constlen);
+}
+
+static bool
+query_has_partitioned_tables_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, RangeTblEntry))
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) node;
+
+		return rte->rtekind == RTE_RELATION && rel_is_partitioned(rte->relid);
+	}
+
+	if (IsA(node, Query))
+		return query_tree_walker((Query *) node,
+								 query_has_partitioned_tables_walker,
+								 context, QTW_EXAMINE_RTES);
+
+	return expression_tree_walker(node, query_has_partitioned_tables_walker,
+								  context);
+}
+
+static Node *
+parameterize_query_mutator(Node *node, parameterize_context *context)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Const))
+	{
+		Const	   *con = (Const *) node;
+		Param	   *param = makeNode(Param);
+
+		context->consts = lappend(context->consts, copyObject(con));
+
+		param->paramkind = PARAM_EXTERN;
+		param->paramid = list_length(context->consts);
+		param->paramtype = con->consttype;
+		param->paramtypmod = con->consttypmod;
+		param->paramcollid = con->constcollid;
+		param->location = -1;
+
+		return (Node *) param;
+	}
+
+	if (IsA(node, Query))
+		return (Node *) query_tree_mutator((Query *) node,
+										   parameterize_query_mutator,
+										   (void *) context, 0);
+
+	return expression_tree_mutator(node, parameterize_query_mutator,
+								   (void *) context);
+}
+
+/*
+ * Replace the constants of the query in a plan with Params.
+ */
+static Node *
+template_plan_mutator(Node *node, template_context *context)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Const))
+	{
+		Const	   *con = (Const *) node;
+		int			i;
+
+		for (i = 0; i < context->cache_query->num_consts; i++)
+		{
+			if (consts_are_equal(con, context->cache_query->consts[i]))
+			{
+				Param	   *param = makeNode(Param);
+
+				param->paramkind = PARAM_EXTERN;
+				param->paramid = i + 1;
+				param->paramtype = con->consttype;
+				param->paramtypmod = con->consttypmod;
+				param->paramcollid = con->constcollid;
+				param->location = -1;
+
+				context->found[i] = true;
+
+				return (Node *) param;
+			}
+		}
+	}
+
+	/* the segments to dispatch to are computed from the constants */
+	if (is_plan_node(node) && ((Plan *) node)->directDispatch.isDirectDispatch)
+		context->dependent = true;
+
+	return plan_tree_mutator(node, template_plan_mutator, (void *) context);
+}
+
+/*
+ * Replace the Params of a template with the constants of the query.
+ */
+static Node *
+instantiate_plan_mutator(Node *node, instantiate_context *context)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Param) && ((Param *) node)->paramkind == PARAM_EXTERN)
+	{
+		Param	   *param = (Param *) node;
+		Const	   *con;
+
+		Assert(param->paramid >= 1 &&
+			   param->paramid <= context->cache_query->num_consts);
+
+		con = (Const *) copyObject(context->cache_query->consts[param->paramid - 1]);
+		con->consttypmod = param->paramtypmod;
+		con->constcollid = param->paramcollid;
+		con->location = -1;
+
+		return (Node *) con;
+	}
+
+	return plan_tree_mutator(node, instantiate_plan_mutator, (void *) context);
+}
+
+/*
+ * The plan of a template for the constants of the query.
+ */
+static PlannedStmt *
+instantiate_template_plan(PlannedStmt *template_plan,
+						  OrcaPlanCacheQuery *cache_query)
+{
+	instantiate_context context;
+	PlannedStmt *plan;
+
+	plan = (PlannedStmt *) copyObject(template_plan);
+
+	exec_init_plan_tree_base(&context.base, plan);
+	context.cache_query = cache_query;
+	plan->planTree = (Plan *) instantiate_plan_mutator((Node *) plan->planTree,
+													   &context);
+
+	return plan;
+}
+
+/*
+ * Template of the plan for the constants of the query, or NULL if it can't
+ * be made.  *dependent is set if the plan depends on the values of the
+ * constants in ways the template can't follow.
+ */
+static PlannedStmt *
+make_template_plan(OrcaPlanCacheQuery *cache_query, PlannedStmt *plan,
+				   bool *dependent)
+{
+	template_context context;
+	PlannedStmt *template_plan;
+	int			i;
+	int			j;
+
+	*dependent = false;
+
+	/* constants of the same value can't be told apart in the plan */
+	for (i = 0; i < cache_query->num_consts; i++)
+	{
+		for (j = i + 1; j < cache_query->num_consts; j++)
+		{
+			if (consts_are_equal(cache_query->consts[i], cache_query->consts[j]))
+				return NULL;
+		}
+	}
+
+	template_plan = (PlannedStmt *) copyObject(plan);
+
+	exec_init_plan_tree_base(&context.base, template_plan);
+	context.cache_query = cache_query;
+	context.found = (bool *) palloc0(Max(cache_query->num_consts, 1) * sizeof(bool));
+	context.dependent = false;
+
+	template_plan->planTree = (Plan *) template_plan_mutator((Node *) template_plan->planTree,
+															 &context);
+
+	/*
+	 * A constant missing from the plan has been folded away, or been used to
+	 * rule something out.
+	 */
+	for (i = 0; i < cache_query->num_consts && !context.dependent; i++)
+	{
+		if (!context.found[i])
+			context.dependent = true;
+	}
+
+	pfree(context.found);
+
+	if (context.dependent)
+	{
+		*dependent = true;
+		return NULL;
+	}
+
+	return template_plan;
+}
+
+static char *
+template_plan_string(PlannedStmt *template_plan)
+{
+	char	   *plan_str;
+	char	   *subplans_str;
+	char	   *result;
+
+	plan_str = strip_node_fields(nodeToString(template_plan->planTree),
+								 template_skipped_fields,
+								 lengthof(template_skipped_fields));
+	subplans_str = strip_node_fields(nodeToString(template_plan->subplans),
+									 template_skipped_fields,
+									 lengthof(template_skipped_fields));
+
+	result = psprintf("%s %s", plan_str, subplans_str);
+
+	pfree(plan_str);
+	pfree(subplans_str);
+
+	return result;
+}
+
+/*
+ * Can the template be used for the constants of the query, rather than a
+ * custom plan?  This follows choose_custom_plan() in plancache.c.
+ */
+static bool
+choose_template_plan(OrcaCachedPlan *entry, OrcaPlanCacheQuery *cache_query)
+{
+	double		avg_custom_cost;
+	int			i;
+
+	if (entry->unusable || entry->template_plan == NULL)
+		return false;
+
+	if (entry->num_custom_plans < ORCA_PLAN_CACHE_NUM_CUSTOM_PLANS)
+		return false;
+
+	avg_custom_cost = entry->total_custom_cost / entry->num_custom_plans;
+	if (entry->max_custom_cost > avg_custom_cost * ORCA_PLAN_CACHE_COST_FACTOR)
+		return false;
+
+	for (i = 0; i < entry->num_consts; i++)
+	{
+		if (!entry->varied[i] &&
+			!consts_are_equal(cache_query->consts[i], entry->first_consts[i]))
+			return false;
+	}
+
+	return true;
+}
+
+static void
+remove_cached_plan(OrcaCachedPlan *entry)
+{
+	dlist_delete(&entry->lru_node);
+	MemoryContextDelete(entry->context);
+	hash_search(OrcaPlanCacheHash, &entry->hashvalue, HASH_REMOVE, NULL);
+}
+
+static void
+init_cached_plan(OrcaCachedPlan *entry, OrcaPlanCacheQuery *cache_query)
+{
+	MemoryContext oldcontext;
+	int			i;
+
+	entry->context = AllocSetContextCreate(OrcaPlanCacheContext,
+										   "ORCA cached plan",
+										   ALLOCSET_SMALL_MINSIZE,
+										   ALLOCSET_SMALL_INITSIZE,
+										   ALLOCSET_DEFAULT_MAXSIZE);
+
+	oldcontext = MemoryContextSwitchTo(entry->context);
+
+	entry->key = pstrdup(cache_query->key);
+	entry->num_consts = cache_query->num_consts;
+	entry->first_consts = (Const **) palloc(Max(entry->num_consts, 1) * sizeof(Const *));
+	entry->varied = (bool *) palloc0(Max(entry->num_consts, 1) * sizeof(bool));
+	for (i = 0; i < entry->num_consts; i++)
+		entry->first_consts[i] = (Const *) copyObject(cache_query->consts[i]);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	entry->template_plan = NULL;
+	entry->template_str = NULL;
+	entry->unusable = false;
+	entry->num_custom_plans = 0;
+	entry->total_custom_cost = 0;
+	entry->max_custom_cost = 0;
+
+	dlist_push_head(&OrcaPlanCacheLRU, &entry->lru_node);
+}
+
+/*
+ * Fingerprint of the definitions of the relations of a plan, which changes
+ * with DDL on them, but not with ANALYZE.  The pg_class row of a relation is
+ * only updated in place by ANALYZE, in the same place, while DDL replaces
+ * it, except for some changes of the columns and the indexes, which are
+ * added separately.
+ */
+static uint32
+relations_fingerprint(List *relationOids)
+{
+	StringInfoData buf;
+	ListCell   *lc;
+	uint32		result;
+
+	initStringInfo(&buf);
+
+	foreach(lc, relationOids)
+	{
+		Oid			relid = lfirst_oid(lc);
+		HeapTuple	tuple;
+		Relation	rel;
+		List	   *indexes;
+		ListCell   *lci;
+		int			i;
+
+		appendBinaryStringInfo(&buf, (char *) &relid, sizeof(Oid));
+
+		tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+		if (!HeapTupleIsValid(tuple))
+			continue;
+		appendBinaryStringInfo(&buf, (char *) &tuple->t_self, sizeof(ItemPointerData));
+		ReleaseSysCache(tuple);
+
+		rel = RelationIdGetRelation(relid);
+		if (!RelationIsValid(rel))
+			continue;
+
+		for (i = 0; i < rel->rd_att->natts; i++)
+		{
+			Form_pg_attribute attr = rel->rd_att->attrs[i];
+
+			appendBinaryStringInfo(&buf, (char *) &attr->atttypid, sizeof(Oid));
+			appendBinaryStringInfo(&buf, (char *) &attr->atttypmod, sizeof(int32));
+			appendBinaryStringInfo(&buf, (char *) &attr->attisdropped, sizeof(bool));
+		}
+
+		indexes = RelationGetIndexList(rel);
+		foreach(lci, indexes)
+		{
+			Oid			indexoid = lfirst_oid(lci);
+
+			appendBinaryStringInfo(&buf, (char *) &indexoid, sizeof(Oid));
+		}
+		list_free(indexes);
+
+		if (rel->rd_cdbpolicy != NULL)
+		{
+			GpPolicy   *policy = rel->rd_cdbpolicy;
+
+			appendBinaryStringInfo(&buf, (char *) &policy->ptype, sizeof(GpPolicyType));
+			appendBinaryStringInfo(&buf, (char *) &policy->numsegments, sizeof(int));
+			appendBinaryStringInfo(&buf, (char *) policy->attrs,
+								   policy->nattrs * sizeof(AttrNumber));
+		}
+
+		RelationClose(rel);
+	}
+
+	result = DatumGetUInt32(hash_any((unsigned char *) buf.data, buf.len));
+	pfree(buf.data);
+
+	return result;
+}
+
+static OrcaPlanBaseline *
+find_baseline(OrcaPlanCacheQuery *cache_query)
+{
+	OrcaPlanBaseline *entry;
+
+	if (OrcaPlanBaselineHash == NULL)
+		return NULL;
+
+	entry = (OrcaPlanBaseline *) hash_search(OrcaPlanBaselineHash,
+											 &cache_query->hashvalue,
+											 HASH_FIND, NULL);
+	if (entry == NULL || strcmp(entry->key, cache_query->key) != 0)
+		return NULL;
+
+	return entry;
+}
+
+/*
+ * May a template of the plan cache be used, rather than optimizing the query
+ * and comparing the plan with the baseline?
+ */
+static bool
+baseline_allows_template(OrcaPlanCacheQuery *cache_query,
+						 const char *template_str)
+{
+	OrcaPlanBaseline *entry;
+
+	if (optimizer_plan_baselines <= 0)
+		return true;
+
+	entry = find_baseline(cache_query);
+
+	return entry == NULL || strcmp(entry->template_str, template_str) == 0;
+}
+
+static void
+remove_baseline(OrcaPlanBaseline *entry)
+{
+	dlist_delete(&entry->lru_node);
+	MemoryContextDelete(entry->context);
+	hash_search(OrcaPlanBaselineHash, &entry->hashvalue, HASH_REMOVE, NULL);
+}
+
+/*
+ * Copy a template and its string into a new child context of the entry.
+ */
+static MemoryContext
+copy_baseline_plan(OrcaPlanBaseline *entry, PlannedStmt *template_plan,
+				   const char *template_str, PlannedStmt **plan_copy,
+				   char **str_copy)
+{
+	MemoryContext context;
+	MemoryContext oldcontext;
+
+	context = AllocSetContextCreate(entry->context,
+									"ORCA plan baseline plan",
+									ALLOCSET_SMALL_MINSIZE,
+									ALLOCSET_SMALL_INITSIZE,
+									ALLOCSET_DEFAULT_MAXSIZE);
+
+	oldcontext = MemoryContextSwitchTo(context);
+	*plan_copy = (PlannedStmt *) copyObject(template_plan);
+	*str_copy = pstrdup(template_str);
+	MemoryContextSwitchTo(oldcontext);
+
+	return context;
+}
+
+static void
+set_baseline_plan(OrcaPlanBaseline *entry, PlannedStmt *template_plan,
+				  const char *template_str)
+{
+	if (entry->plan_context != NULL)
+		MemoryContextDelete(entry->plan_context);
+
+	entry->plan_context = copy_baseline_plan(entry, template_plan, template_str,
+											 &entry->template_plan,
+											 &entry->template_str);
+	entry->num_runs = 0;
+	entry->total_time = 0;
+	entry->runs_since_trial = 0;
+	entry->generation = ++OrcaPlanBaselineGeneration;
+}
+
+static void
+set_candidate_plan(OrcaPlanBaseline *entry, PlannedStmt *template_plan,
+				   const char *template_str)
+{
+	if (entry->candidate_context != NULL)
+		MemoryContextDelete(entry->candidate_context);
+
+	entry->candidate_context = copy_baseline_plan(entry, template_plan,
+												  template_str,
+												  &entry->candidate_plan,
+												  &entry->candidate_str);
+	entry->candidate_rejected = false;
+	entry->num_trials = 0;
+	entry->total_trial_time = 0;
+	entry->generation = ++OrcaPlanBaselineGeneration;
+}
+
+static void
+init_baseline(OrcaPlanBaseline *entry, OrcaPlanCacheQuery *cache_query,
+			  uint32 fingerprint)
+{
+	entry->context = AllocSetContextCreate(OrcaPlanBaselineContext,
+										   "ORCA plan baseline",
+										   ALLOCSET_SMALL_MINSIZE,
+										   ALLOCSET_SMALL_INITSIZE,
+										   ALLOCSET_DEFAULT_MAXSIZE);
+	entry->key = MemoryContextStrdup(entry->context, cache_query->key);
+	entry->fingerprint = fingerprint;
+	entry->plan_context = NULL;
+	entry->template_plan = NULL;
+	entry->template_str = NULL;
+	entry->candidate_context = NULL;
+	entry->candidate_plan = NULL;
+	entry->candidate_str = NULL;
+
+	dlist_push_head(&OrcaPlanBaselineLRU, &entry->lru_node);
+}
+
+/*
+ * Time the execution of the plan returned to the planner.
+ */
+static PlannedStmt *
+time_plan(OrcaPlanBaseline *entry, PlannedStmt *plan, bool trial)
+{
+	TimedPlan = plan;
+	TimedPlanHashValue = entry->hashvalue;
+	TimedPlanGeneration = entry->generation;
+	TimedPlanIsTrial = trial;
+	TimedPlanStart = 0;
+
+	return plan;
+}
+
+/*
+ * OrcaPlanCacheLookup -- plan of the query from its template, if it should
+ * be used, or NULL if the query has to be optimized.
+ *
+ * The normalized query is passed in.  If the plan optimized for it may be
+ * cached, *cache_query is set to pass to OrcaPlanCacheStore(), otherwise to
+ * NULL.
+ */
+PlannedStmt *
+OrcaPlanCacheLookup(const Query *query, OrcaPlanCacheQuery **cache_query)
+{
+	parameterize_context context;
+	OrcaPlanCacheQuery *result;
+	OrcaCachedPlan *entry;
+	Query	   *param_query;
+	PlannedStmt *plan;
+	ListCell   *lc;
+	char	   *query_str;
+	int			i;
+
+	*cache_query = NULL;
+
+	if (optimizer_plan_cache_size <= 0)
+	{
+		OrcaPlanCacheReset();
+
+		/* the normalized query is still needed for the baselines */
+		if (optimizer_plan_baselines <= 0)
+			return NULL;
+	}
+
+	if (query->commandType != CMD_SELECT ||
+		query->utilityStmt != NULL ||
+		query->parentStmtType != PARENTSTMTTYPE_NONE ||
+		query_has_partitioned_tables_walker((Node *) query, NULL))
+		return NULL;
+
+	context.consts = NIL;
+	param_query = (Query *) parameterize_query_mutator((Node *) query, &context);
+
+	result = (OrcaPlanCacheQuery *) palloc(sizeof(OrcaPlanCacheQuery));
+	query_str = nodeToString(param_query);
+	result->key = strip_node_fields(query_str, query_key_skipped_fields,
+									lengthof(query_key_skipped_fields));
+	result->hashvalue = string_hash(result->key, strlen(result->key) + 1);
+	result->num_consts = list_length(context.consts);
+	result->consts = (Const **) palloc(Max(result->num_consts, 1) * sizeof(Const *));
+	i = 0;
+	foreach(lc, context.consts)
+		result->consts[i++] = (Const *) lfirst(lc);
+
+	pfree(query_str);
+	list_free(context.consts);
+
+	*cache_query = result;
+
+	if (OrcaPlanCacheHash == NULL)
+		return NULL;
+
+	entry = (OrcaCachedPlan *) hash_search(OrcaPlanCacheHash, &result->hashvalue,
+										   HASH_FIND, NULL);
+	if (entry == NULL || strcmp(entry->key, result->key) != 0)
+		return NULL;
+
+	dlist_move_head(&OrcaPlanCacheLRU, &entry->lru_node);
+
+	if (!choose_template_plan(entry, result))
+		return NULL;
+
+	/* a plan of another shape has to become the baseline first */
+	if (!baseline_allows_template(result, entry->template_str))
+		return NULL;
+
+	plan = instantiate_template_plan(entry->template_plan, result);
+
+	*cache_query = NULL;
+
+	return plan;
+}
+
+/*
+ * OrcaPlanCacheStore -- remember the custom plan optimized for the query.
+ */
+void
+OrcaPlanCacheStore(OrcaPlanCacheQuery *cache_query, PlannedStmt *plan)
+{
+	OrcaCachedPlan *entry;
+	PlannedStmt *template_plan;
+	MemoryContext oldcontext;
+	char	   *template_str;
+	double		cost;
+	bool		dependent;
+	bool		found;
+	int			i;
+
+	if (optimizer_plan_cache_size <= 0 || plan->planTree == NULL)
+		return;
+
+	if (OrcaPlanCacheHash == NULL)
+	{
+		HASHCTL		ctl;
+
+		OrcaPlanCacheContext = AllocSetContextCreate(CacheMemoryContext,
+													 "ORCA plan cache",
+													 ALLOCSET_DEFAULT_MINSIZE,
+													 ALLOCSET_DEFAULT_INITSIZE,
+													 ALLOCSET_DEFAULT_MAXSIZE);
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(uint32);
+		ctl.entrysize = sizeof(OrcaCachedPlan);
+		ctl.hash = tag_hash;
+		ctl.hcxt = OrcaPlanCacheContext;
+
+		OrcaPlanCacheHash = hash_create("ORCA plan cache", 256, &ctl,
+										HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+		dlist_init(&OrcaPlanCacheLRU);
+	}
+
+	entry = (OrcaCachedPlan *) hash_search(OrcaPlanCacheHash, &cache_query->hashvalue,
+										   HASH_ENTER, &found);
+	if (found && strcmp(entry->key, cache_query->key) != 0)
+	{
+		/* another query of the same hash value, replace it */
+		dlist_delete(&entry->lru_node);
+		MemoryContextDelete(entry->context);
+		found = false;
+	}
+
+	if (!found)
+	{
+		init_cached_plan(entry, cache_query);
+
+		while (hash_get_num_entries(OrcaPlanCacheHash) > optimizer_plan_cache_size)
+			remove_cached_plan(dlist_tail_element(OrcaCachedPlan, lru_node,
+												  &OrcaPlanCacheLRU));
+	}
+	else
+		dlist_move_head(&OrcaPlanCacheLRU, &entry->lru_node);
+
+	if (entry->unusable)
+		return;
+
+	template_plan = make_template_plan(cache_query, plan, &dependent);
+	if (template_plan == NULL)
+	{
+		if (dependent)
+		{
+			entry->unusable = true;
+			entry->template_plan = NULL;
+			entry->template_str = NULL;
+		}
+		return;
+	}
+
+	template_str = template_plan_string(template_plan);
+
+	if (entry->template_plan == NULL)
+	{
+		oldcontext = MemoryContextSwitchTo(entry->context);
+		entry->template_plan = (PlannedStmt *) copyObject(template_plan);
+		entry->template_str = pstrdup(template_str);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else if (strcmp(entry->template_str, template_str) != 0)
+	{
+		/* the constants changed the plan */
+		entry->unusable = true;
+		entry->template_plan = NULL;
+		entry->template_str = NULL;
+		return;
+	}
+
+	for (i = 0; i < entry->num_consts; i++)
+	{
+		if (!consts_are_equal(cache_query->consts[i], entry->first_consts[i]))
+			entry->varied[i] = true;
+	}
+
+	cost = plan->planTree->total_cost;
+	entry->num_custom_plans++;
+	entry->total_custom_cost += cost;
+	entry->max_custom_cost = Max(entry->max_custom_cost, cost);
+}
+
+/*
+ * OrcaPlanCacheReset -- drop all the cached plans.
+ */
+void
+OrcaPlanCacheReset(void)
+{
+	if (OrcaPlanCacheContext == NULL)
+		return;
+
+	MemoryContextDelete(OrcaPlanCacheContext);
+	OrcaPlanCacheContext = NULL;
+	OrcaPlanCacheHash = NULL;
+	dlist_init(&OrcaPlanCacheLRU);
+}
+
+/*
+ * OrcaPlanBaselineChoose -- the plan to run for the query, given the plan
+ * optimized for it.
+ *
+ * That's the optimized plan, unless it differs from the baseline of the
+ * query, in which case the baseline is used, except for the trials of the
+ * optimized plan.  cache_query is from OrcaPlanCacheLookup(), there's no
+ * baseline if it's NULL.
+ */
+PlannedStmt *
+OrcaPlanBaselineChoose(OrcaPlanCacheQuery *cache_query, PlannedStmt *plan)
+{
+	OrcaPlanBaseline *entry;
+	PlannedStmt *template_plan;
+	char	   *template_str;
+	uint32		fingerprint;
+	bool		dependent;
+	bool		found;
+
+	if (optimizer_plan_baselines <= 0)
+	{
+		OrcaPlanBaselineReset();
+		return plan;
+	}
+
+	if (cache_query == NULL || plan->planTree == NULL)
+		return plan;
+
+	template_plan = make_template_plan(cache_query, plan, &dependent);
+	if (template_plan == NULL)
+		return plan;
+
+	template_str = template_plan_string(template_plan);
+	fingerprint = relations_fingerprint(plan->relationOids);
+
+	if (OrcaPlanBaselineHash == NULL)
+	{
+		HASHCTL		ctl;
+
+		OrcaPlanBaselineContext = AllocSetContextCreate(CacheMemoryContext,
+														"ORCA plan baselines",
+														ALLOCSET_DEFAULT_MINSIZE,
+														ALLOCSET_DEFAULT_INITSIZE,
+														ALLOCSET_DEFAULT_MAXSIZE);
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(uint32);
+		ctl.entrysize = sizeof(OrcaPlanBaseline);
+		ctl.hash = tag_hash;
+		ctl.hcxt = OrcaPlanBaselineContext;
+
+		OrcaPlanBaselineHash = hash_create("ORCA plan baselines", 256, &ctl,
+										   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+		dlist_init(&OrcaPlanBaselineLRU);
+	}
+
+	entry = (OrcaPlanBaseline *) hash_search(OrcaPlanBaselineHash,
+											 &cache_query->hashvalue,
+											 HASH_ENTER, &found);
+	if (found &&
+		(strcmp(entry->key, cache_query->key) != 0 ||
+		 entry->fingerprint != fingerprint))
+	{
+		/* another query of the same hash value, or its relations changed */
+		dlist_delete(&entry->lru_node);
+		MemoryContextDelete(entry->context);
+		found = false;
+	}
+
+	if (!found)
+	{
+		init_baseline(entry, cache_query, fingerprint);
+		set_baseline_plan(entry, template_plan, template_str);
+
+		while (hash_get_num_entries(OrcaPlanBaselineHash) > optimizer_plan_baselines)
+			remove_baseline(dlist_tail_element(OrcaPlanBaseline, lru_node,
+											   &OrcaPlanBaselineLRU));
+
+		return time_plan(entry, plan, false);
+	}
+
+	dlist_move_head(&OrcaPlanBaselineLRU, &entry->lru_node);
+
+	if (strcmp(entry->template_str, template_str) == 0)
+		return time_plan(entry, plan, false);
+
+	/* a plan of another shape */
+	if (entry->candidate_str == NULL ||
+		strcmp(entry->candidate_str, template_str) != 0)
+		set_candidate_plan(entry, template_plan, template_str);
+
+	if (!entry->candidate_rejected && entry->num_runs > 0 &&
+		entry->runs_since_trial >= ORCA_PLAN_BASELINE_TRIAL_INTERVAL)
+	{
+		entry->runs_since_trial = 0;
+		return time_plan(entry, plan, true);
+	}
+
+	entry->runs_since_trial++;
+
+	return time_plan(entry,
+					 instantiate_template_plan(entry->template_plan, cache_query),
+					 false);
+}
+
+/*
+ * OrcaPlanBaselineStartExecution -- called by ExecutorStart.
+ */
+void
+OrcaPlanBaselineStartExecution(QueryDesc *queryDesc, int eflags)
+{
+	if (TimedPlan == NULL || queryDesc->plannedstmt != TimedPlan ||
+		TimedPlanStart != 0)
+		return;
+
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+	{
+		TimedPlan = NULL;
+		return;
+	}
+
+	TimedPlanStart = GetCurrentTimestamp();
+}
+
+/*
+ * OrcaPlanBaselineEndExecution -- called by ExecutorEnd, records the time of
+ * the execution of the baseline or of the trial.
+ */
+void
+OrcaPlanBaselineEndExecution(QueryDesc *queryDesc)
+{
+	OrcaPlanBaseline *entry;
+	long		secs;
+	int			usecs;
+	double		ms;
+
+	if (TimedPlan == NULL || queryDesc->plannedstmt != TimedPlan ||
+		TimedPlanStart == 0)
+		return;
+
+	TimedPlan = NULL;
+
+	TimestampDifference(TimedPlanStart, GetCurrentTimestamp(), &secs, &usecs);
+	ms = secs * 1000.0 + usecs / 1000.0;
+
+	if (OrcaPlanBaselineHash == NULL)
+		return;
+
+	entry = (OrcaPlanBaseline *) hash_search(OrcaPlanBaselineHash,
+											 &TimedPlanHashValue,
+											 HASH_FIND, NULL);
+	if (entry == NULL || entry->generation != TimedPlanGeneration)
+		return;
+
+	if (!TimedPlanIsTrial)
+	{
+		entry->num_runs++;
+		entry->total_time += ms;
+		return;
+	}
+
+	entry->num_trials++;
+	entry->total_trial_time += ms;
+
+	if (entry->num_trials < ORCA_PLAN_BASELINE_NUM_TRIALS)
+		return;
+
+	if (entry->total_trial_time / entry->num_trials >=
+		entry->total_time / entry->num_runs)
+	{
+		ereport(DEBUG1,
+				(errmsg("plan of another shape rejected"),
+				 errdetail("Its trials took %.3f ms on average, the baseline %.3f ms.",
+						   entry->total_trial_time / entry->num_trials,
+						   entry->total_time / entry->num_runs)));
+		entry->candidate_rejected = true;
+	}
+	else
+	{
+		ereport(DEBUG1,
+				(errmsg("plan of another shape accepted"),
+				 errdetail("Its trials took %.3f ms on average, the baseline %.3f ms.",
+						   entry->total_trial_time / entry->num_trials,
+						   entry->total_time / entry->num_runs)));
+
+		MemoryContextDelete(entry->plan_context);
+		entry->plan_context = entry->candidate_context;
+		entry->template_plan = entry->candidate_plan;
+		entry->template_str = entry->candidate_str;
+		entry->num_runs = entry->num_trials;
+		entry->total_time = entry->total_trial_time;
+		entry->runs_since_trial = 0;
+		entry->generation = ++OrcaPlanBaselineGeneration;
+
+		entry->candidate_context = NULL;
+		entry->candidate_plan = NULL;
+		entry->candidate_str = NULL;
+	}
+}
+
+/*
+ * OrcaPlanBaselineReset -- drop all the baselines.
+ */
+void
+OrcaPlanBaselineReset(void)
+{
+	TimedPlan = NULL;
+
+	if (OrcaPlanBaselineContext == NULL)
+		return;
+
+	MemoryContextDelete(OrcaPlanBaselineContext);
+	OrcaPlanBaselineContext = NULL;
+	OrcaPlanBaselineHash = NULL;
+	dlist_init(&OrcaPlanBaselineLRU);
+}
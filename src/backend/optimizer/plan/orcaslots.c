@@ -0,0 +1,283 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaslots.c
+ *	  Limit on the number of GPORCA optimizations running at once.
+ *
+ * Every backend on the master runs GPORCA in its own process, so a burst of
+ * concurrent queries runs as many optimizations at once, each with its own
+ * search memory and CPU.  When optimizer_max_concurrent_optimizations is set,
+ * a backend takes one of that many slots for the duration of an optimization
+ * and waits for one to be released if there is none, so at most that many
+ * optimizations compete for the master.
+ *
+ * Optimizations don't take heavyweight locks of their own, the relations are
+ * locked before, so a backend holding a slot never waits for one waiting for
+ * a slot.  The backends waiting for a slot queue up and sleep on their
+ * latches; releasing a slot wakes the first of them.  An optimization that
+ * starts another one, to plan a query a function runs while it evaluates a
+ * constant expression, runs that one in the slot it holds.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcaslots.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
+#include "optimizer/orcaslots.h"
+#include "pgstat.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/guc.h"
+
+typedef struct OrcaSlotsData
+{
+	slock_t		mutex;
+	int			active;			/* optimizations holding a slot */
+	int			nwaiters;		/* backends waiting for a slot */
+	int			waiters[1];		/* their pgprocnos, first come first, VARIABLE
+								 * LENGTH ARRAY */
+} OrcaSlotsData;
+
+static volatile OrcaSlotsData *OrcaSlots = NULL;
+
+/* does this backend hold a slot */
+static bool holding_slot = false;
+/* nesting of the optimizations of this backend */
+static int	slot_depth = 0;
+static bool exit_callback_registered = false;
+
+/*
+ * OrcaSlotsShmemSize -- estimate size the optimization slots need in shared
+ * memory.
+ */
+Size
+OrcaSlotsShmemSize(void)
+{
+	return add_size(offsetof(OrcaSlotsData, waiters),
+					mul_size(MaxBackends, sizeof(int)));
+}
+
+/*
+ * OrcaSlotsShmemInit -- initialize the optimization slots.
+ */
+void
+OrcaSlotsShmemInit(void)
+{
+	bool		found;
+
+	OrcaSlots = (OrcaSlotsData *)
+		ShmemInitStruct("ORCA Optimization Slots", OrcaSlotsShmemSize(),
+						&found);
+	if (!found)
+	{
+		SpinLockInit(&OrcaSlots->mutex);
+		OrcaSlots->active = 0;
+		OrcaSlots->nwaiters = 0;
+	}
+}
+
+static void
+OrcaSlotsExitCallback(int code, Datum arg)
+{
+	if (slot_depth > 0)
+	{
+		slot_depth = 1;
+		OrcaSlotRelease();
+	}
+}
+
+/* Position of the backend among the waiters, or -1, with the mutex held */
+static int
+orca_slots_find(int pgprocno)
+{
+	int			i;
+
+	for (i = 0; i < OrcaSlots->nwaiters; i++)
+	{
+		if (OrcaSlots->waiters[i] == pgprocno)
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Remove the backend from the waiters, with the mutex held.  Returns false if
+ * it isn't one of them.
+ */
+static bool
+orca_slots_dequeue(int pgprocno)
+{
+	int			i = orca_slots_find(pgprocno);
+
+	if (i < 0)
+		return false;
+
+	for (; i + 1 < OrcaSlots->nwaiters; i++)
+		OrcaSlots->waiters[i] = OrcaSlots->waiters[i + 1];
+	OrcaSlots->nwaiters--;
+	return true;
+}
+
+/*
+ * Remove the first waiter to wake it up, with the mutex held.  Returns its
+ * pgprocno, or -1 if there is no waiter.
+ */
+static int
+orca_slots_dequeue_first(void)
+{
+	int			pgprocno;
+
+	if (OrcaSlots->nwaiters == 0)
+		return -1;
+
+	pgprocno = OrcaSlots->waiters[0];
+	orca_slots_dequeue(pgprocno);
+	return pgprocno;
+}
+
+static void
+orca_slots_wake(int pgprocno)
+{
+	if (pgprocno >= 0)
+		SetLatch(&ProcGlobal->allProcs[pgprocno].procLatch);
+}
+
+/*
+ * Stop waiting for a slot, as the backend is interrupted.  A release that
+ * woke it up was meant for the next waiter then.
+ */
+static void
+orca_slots_cancel_wait(void)
+{
+	int			next = -1;
+
+	SpinLockAcquire(&OrcaSlots->mutex);
+	if (!orca_slots_dequeue(MyProc->pgprocno) &&
+		OrcaSlots->active < optimizer_max_concurrent_optimizations)
+		next = orca_slots_dequeue_first();
+	SpinLockRelease(&OrcaSlots->mutex);
+
+	orca_slots_wake(next);
+}
+
+/*
+ * OrcaSlotAcquire -- wait until this backend may start an optimization.
+ *
+ * Does nothing if the number of optimizations isn't limited, or if the
+ * backend is already optimizing: a nested optimization runs in the slot of
+ * the one that started it.  Each call must be matched by OrcaSlotRelease(),
+ * also when the optimization errors out.
+ */
+void
+OrcaSlotAcquire(void)
+{
+	bool		waiting = false;
+
+	if (slot_depth > 0)
+	{
+		slot_depth++;
+		return;
+	}
+
+	Assert(!holding_slot);
+
+	if (OrcaSlots == NULL || optimizer_max_concurrent_optimizations <= 0)
+	{
+		slot_depth = 1;
+		return;
+	}
+
+	if (!exit_callback_registered)
+	{
+		before_shmem_exit(OrcaSlotsExitCallback, 0);
+		exit_callback_registered = true;
+	}
+
+	for (;;)
+	{
+		int			rc;
+
+		SpinLockAcquire(&OrcaSlots->mutex);
+		if (OrcaSlots->active < optimizer_max_concurrent_optimizations)
+		{
+			OrcaSlots->active++;
+			orca_slots_dequeue(MyProc->pgprocno);
+			holding_slot = true;
+		}
+		else if (orca_slots_find(MyProc->pgprocno) < 0)
+		{
+			/* new, or woken up but beaten to the slot */
+			Assert(OrcaSlots->nwaiters < MaxBackends);
+			OrcaSlots->waiters[OrcaSlots->nwaiters++] = MyProc->pgprocno;
+		}
+		SpinLockRelease(&OrcaSlots->mutex);
+
+		if (holding_slot)
+			break;
+
+		if (!waiting)
+		{
+			gpstat_report_waiting(PGBE_WAITING_OPTIMIZER);
+			waiting = true;
+		}
+
+		rc = WaitLatch(&MyProc->procLatch, WL_LATCH_SET | WL_POSTMASTER_DEATH, -1);
+		ResetLatch(&MyProc->procLatch);
+
+		if (rc & WL_POSTMASTER_DEATH)
+		{
+			orca_slots_cancel_wait();
+			proc_exit(1);
+		}
+
+		if (InterruptPending)
+		{
+			orca_slots_cancel_wait();
+			gpstat_report_waiting(PGBE_WAITING_NONE);
+			CHECK_FOR_INTERRUPTS();
+			gpstat_report_waiting(PGBE_WAITING_OPTIMIZER);
+		}
+	}
+
+	if (waiting)
+		gpstat_report_waiting(PGBE_WAITING_NONE);
+
+	slot_depth = 1;
+}
+
+/*
+ * OrcaSlotRelease -- end an optimization, releasing the slot of this backend
+ * if it holds one and the optimization isn't nested, and waking up the first
+ * backend waiting for one.
+ */
+void
+OrcaSlotRelease(void)
+{
+	int			next;
+
+	if (slot_depth == 0 || --slot_depth > 0)
+		return;
+
+	if (!holding_slot)
+		return;
+
+	SpinLockAcquire(&OrcaSlots->mutex);
+	Assert(OrcaSlots->active > 0);
+	OrcaSlots->active--;
+	next = orca_slots_dequeue_first();
+	SpinLockRelease(&OrcaSlots->mutex);
+
+	holding_slot = false;
+
+	orca_slots_wake(next);
+}
@@ -0,0 +1,222 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcawindowsort.c
+ *	  Share the sorts of stacked window functions in GPORCA plans.
+ *
+ * GPORCA plans each window specification of a query as its own Window node,
+ * with its own Sort below it, even when the data is already sorted suitably
+ * for it by the Sort of the Window node below.  When
+ * optimizer_enable_shared_window_sort is on, the Sort of a Window node that
+ * sits on other Window nodes, with nothing in between that could reorder the
+ * rows, is removed when its keys are a prefix of the Sort below, for example
+ * with OVER (PARTITION BY a) above OVER (PARTITION BY a ORDER BY b).  When it
+ * is the other way round, the keys of the Sort below are extended with the
+ * keys of the one above instead, so that both specifications are satisfied by
+ * a single sort.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcawindowsort.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "nodes/primnodes.h"
+#include "optimizer/orcawindowsort.h"
+
+/*
+ * If the column of the plan's target list is a column of its outer plan,
+ * return the column number in the outer plan, otherwise 0.
+ */
+static AttrNumber
+outer_column(Plan *plan, AttrNumber attno)
+{
+	TargetEntry *tle;
+	Var		   *var;
+
+	if (attno < 1 || attno > list_length(plan->targetlist))
+		return 0;
+
+	tle = (TargetEntry *) list_nth(plan->targetlist, attno - 1);
+	if (!IsA(tle->expr, Var))
+		return 0;
+
+	var = (Var *) tle->expr;
+	if (var->varno != OUTER_VAR || var->varlevelsup != 0)
+		return 0;
+
+	return var->varattno;
+}
+
+/* Can the Sort be removed, with its outer plan taking its place? */
+static bool
+is_plain_sort(Sort *sort)
+{
+	int			i;
+
+	if (sort->noduplicates || sort->share_type != SHARE_NOTSHARED ||
+		sort->limitCount != NULL || sort->limitOffset != NULL ||
+		sort->plan.qual != NIL || sort->plan.initPlan != NIL)
+		return false;
+
+	/* it must not project, or rearrange the columns */
+	if (list_length(sort->plan.targetlist) !=
+		list_length(sort->plan.lefttree->targetlist))
+		return false;
+
+	for (i = 1; i <= list_length(sort->plan.targetlist); i++)
+	{
+		if (outer_column((Plan *) sort, i) != i)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Remove the Sort, if the Sort below the Window nodes under it already sorts
+ * the rows in its order, or can be made to.
+ */
+static Plan *
+share_window_sort(Sort *sort)
+{
+	AttrNumber *keys;
+	Plan	   *plan;
+	Sort	   *below;
+	int			ncommon;
+	int			i;
+
+	if (!is_plain_sort(sort) || !IsA(sort->plan.lefttree, WindowAgg))
+		return (Plan *) sort;
+
+	/* find the Sort below, and where the keys of this Sort come from in it */
+	keys = (AttrNumber *) palloc(sort->numCols * sizeof(AttrNumber));
+	memcpy(keys, sort->sortColIdx, sort->numCols * sizeof(AttrNumber));
+
+	plan = (Plan *) sort;
+	do
+	{
+		for (i = 0; i < sort->numCols; i++)
+		{
+			keys[i] = outer_column(plan, keys[i]);
+			if (keys[i] == 0)
+			{
+				pfree(keys);
+				return (Plan *) sort;
+			}
+		}
+		plan = plan->lefttree;
+	} while (IsA(plan, WindowAgg));
+
+	if (!IsA(plan, Sort) || !is_plain_sort((Sort *) plan))
+	{
+		pfree(keys);
+		return (Plan *) sort;
+	}
+	below = (Sort *) plan;
+
+	/* the keys must agree up to the shorter of the two */
+	ncommon = Min(sort->numCols, below->numCols);
+	for (i = 0; i < ncommon; i++)
+	{
+		if (keys[i] != below->sortColIdx[i] ||
+			sort->sortOperators[i] != below->sortOperators[i] ||
+			sort->collations[i] != below->collations[i] ||
+			sort->nullsFirst[i] != below->nullsFirst[i])
+		{
+			pfree(keys);
+			return (Plan *) sort;
+		}
+	}
+
+	if (sort->numCols > below->numCols)
+	{
+		int			numCols = sort->numCols;
+
+		below->sortColIdx = (AttrNumber *)
+			repalloc(below->sortColIdx, numCols * sizeof(AttrNumber));
+		below->sortOperators = (Oid *)
+			repalloc(below->sortOperators, numCols * sizeof(Oid));
+		below->collations = (Oid *)
+			repalloc(below->collations, numCols * sizeof(Oid));
+		below->nullsFirst = (bool *)
+			repalloc(below->nullsFirst, numCols * sizeof(bool));
+
+		for (i = below->numCols; i < numCols; i++)
+		{
+			below->sortColIdx[i] = keys[i];
+			below->sortOperators[i] = sort->sortOperators[i];
+			below->collations[i] = sort->collations[i];
+			below->nullsFirst[i] = sort->nullsFirst[i];
+		}
+		below->numCols = numCols;
+	}
+
+	pfree(keys);
+
+	return sort->plan.lefttree;
+}
+
+static Plan *windowsort_mutate(Plan *plan);
+
+static List *
+windowsort_mutate_list(List *plans)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+		lfirst(lc) = windowsort_mutate((Plan *) lfirst(lc));
+
+	return plans;
+}
+
+static Plan *
+windowsort_mutate(Plan *plan)
+{
+	if (plan == NULL)
+		return NULL;
+
+	/* bottom-up, so that the Sorts below have been shared already */
+	plan->lefttree = windowsort_mutate(plan->lefttree);
+	plan->righttree = windowsort_mutate(plan->righttree);
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			windowsort_mutate_list(((Append *) plan)->appendplans);
+			break;
+		case T_MergeAppend:
+			windowsort_mutate_list(((MergeAppend *) plan)->mergeplans);
+			break;
+		case T_Sequence:
+			windowsort_mutate_list(((Sequence *) plan)->subplans);
+			break;
+		case T_ModifyTable:
+			windowsort_mutate_list(((ModifyTable *) plan)->plans);
+			break;
+		case T_SubqueryScan:
+			((SubqueryScan *) plan)->subplan =
+				windowsort_mutate(((SubqueryScan *) plan)->subplan);
+			break;
+		case T_Sort:
+			return share_window_sort((Sort *) plan);
+		default:
+			break;
+	}
+
+	return plan;
+}
+
+/*
+ * orca_shared_window_sorts -- remove the Sorts of stacked Window nodes of a
+ * plan made by GPORCA, which the Sort below them can do.
+ */
+void
+orca_shared_window_sorts(PlannedStmt *stmt)
+{
+	stmt->planTree = windowsort_mutate(stmt->planTree);
+	windowsort_mutate_list(stmt->subplans);
+}
@@ -23,12 +23,17 @@
 #include "cdb/cdbpartition.h"
 #include "cdb/cdbplan.h"
 #include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
 #include "utils/lsyscache.h"
 #include "cdb/cdbvars.h"
 #include "parser/parse_oper.h"
 
 static Expr *FindEqKey(PlannerInfo *root, Bitmapset *inner_relids, DynamicScanInfo *dyninfo, int partKeyAttno);
 
+static Expr *FindParamKey(PlannerInfo *root, DynamicScanInfo *dyninfo, int partKeyAttno);
+
+static bool non_extern_params_walker(Node *node, bool *has_params);
+
 static void add_restrictinfos(PlannerInfo *root, DynamicScanInfo *dsinfo, Bitmapset *childrelids);
 
 static bool IsPartKeyVar(Expr *expr, int partVarno, int partKeyAttno);
@@ -39,6 +44,12 @@ static Path *create_partition_selector_path(PlannerInfo *root,
 							   List *partKeyExprs,
 							   List *partKeyAttnos);
 
+static PartitionSelector *make_partition_selector(PlannerInfo *root,
+						DynamicScanInfo *dsinfo,
+						Plan *subplan,
+						List *partKeyExprs,
+						List *partKeyAttnos);
+
 
 /*
  * Try to perform "partition selection" on a join.
@@ -274,6 +285,91 @@ inject_partition_selectors_for_join(PlannerInfo *root, JoinPath *join_path,
 		return false;
 }
 
+/*
+ * Try to perform "partition selection" with the parameters of the query.
+ *
+ * A generic plan of a prepared statement like
+ *
+ *		SELECT * FROM sales WHERE day = $1
+ *
+ * scans all the partitions of the table, because constraint exclusion
+ * doesn't know the value of $1 when planning. So if the partitioning key is
+ * equal to an expression of the parameters of the query, we make the Append
+ * of the partitions this:
+ *
+ * Append
+ *   -> Partition Selector for sales
+ *      Filter: $1
+ *   -> Result
+ *      One-Time Filter: PartSelected
+ *         -> Seq Scan partition1
+ *   -> Result
+ *      One-Time Filter: PartSelected
+ *         -> Seq Scan partition2
+ *
+ * The Partition Selector has no input. It is the first child of the Append,
+ * so it computes the expression and selects the partitions that can contain
+ * the value before any partition is scanned, and returns no rows. A single
+ * cached plan then skips the same partitions as a plan for the value.
+ *
+ * Returns the Partition Selector, or NULL. Like in
+ * inject_partition_selectors_for_join(), the PartSelectedExpr gates are
+ * added to the RelOptInfos of the partitions, so this must be called just
+ * before creating the plans of the partitions.
+ */
+Plan *
+create_partition_selector_for_params(PlannerInfo *root, RelOptInfo *rel)
+{
+	DynamicScanInfo *dyninfo = NULL;
+	List	   *partKeyAttnos = NIL;
+	List	   *partKeyExprs = NIL;
+	ListCell   *lc;
+
+	if (Gp_role != GP_ROLE_DISPATCH || !root->config->gp_dynamic_partition_pruning)
+		return NULL;
+
+	if (rel->reloptkind != RELOPT_BASEREL)
+		return NULL;
+
+	foreach(lc, root->dynamicScans)
+	{
+		DynamicScanInfo *dsinfo = (DynamicScanInfo *) lfirst(lc);
+
+		if (dsinfo->rtindex == rel->relid)
+		{
+			dyninfo = dsinfo;
+			break;
+		}
+	}
+
+	/* a join above already selects the partitions */
+	if (dyninfo == NULL || dyninfo->hasSelector)
+		return NULL;
+
+	foreach(lc, dyninfo->partKeyAttnos)
+	{
+		int			partKeyAttno = lfirst_int(lc);
+		Expr	   *expr;
+
+		expr = FindParamKey(root, dyninfo, partKeyAttno);
+
+		if (expr)
+		{
+			partKeyAttnos = lappend_int(partKeyAttnos, partKeyAttno);
+			partKeyExprs = lappend(partKeyExprs, expr);
+		}
+	}
+
+	if (partKeyExprs == NIL)
+		return NULL;
+
+	dyninfo->hasSelector = true;
+	add_restrictinfos(root, dyninfo, dyninfo->children);
+
+	return (Plan *) make_partition_selector(root, dyninfo, NULL,
+											partKeyExprs, partKeyAttnos);
+}
+
 /*
  * Create a PartitionSelectorPath, for the inner side of a join.
  */
@@ -386,6 +482,88 @@ FindEqKey(PlannerInfo *root, Bitmapset *inner_relids,
 	return NULL;
 }
 
+/*
+ * Returns true if the expression has Params other than the ones of the query,
+ * or SubPlans. The values of the Params of the query are dispatched with it,
+ * while the others are set by other nodes of the plan, maybe in another
+ * slice. Sets *has_params if the expression has any Params.
+ */
+static bool
+non_extern_params_walker(Node *node, bool *has_params)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param))
+	{
+		*has_params = true;
+		return ((Param *) node)->paramkind != PARAM_EXTERN;
+	}
+	if (IsA(node, SubPlan) || IsA(node, AlternativeSubPlan))
+		return true;
+	return expression_tree_walker(node, non_extern_params_walker,
+								  (void *) has_params);
+}
+
+/*
+ * Find an expression of the parameters of the query that the partitioning
+ * key is equal to.
+ */
+static Expr *
+FindParamKey(PlannerInfo *root, DynamicScanInfo *dyninfo, int partKeyAttno)
+{
+	Oid			partKeyType = get_atttype(dyninfo->parentOid, partKeyAttno);
+	ListCell   *lec;
+	ListCell   *lem;
+
+	foreach(lec, root->eq_classes)
+	{
+		EquivalenceClass *cur_ec = (EquivalenceClass *) lfirst(lec);
+		bool		has_key = false;
+
+		if (!cur_ec->ec_has_const || cur_ec->ec_has_volatile)
+			continue;
+
+		if (!bms_is_member(dyninfo->rtindex, cur_ec->ec_relids))
+			continue;
+
+		foreach(lem, cur_ec->ec_members)
+		{
+			EquivalenceMember *part_em = (EquivalenceMember *) lfirst(lem);
+
+			if (IsPartKeyVar(part_em->em_expr, dyninfo->rtindex, partKeyAttno))
+			{
+				has_key = true;
+				break;
+			}
+		}
+		if (!has_key)
+			continue;
+
+		foreach(lem, cur_ec->ec_members)
+		{
+			EquivalenceMember *const_em = (EquivalenceMember *) lfirst(lem);
+			bool		has_params = false;
+
+			if (!const_em->em_is_const)
+				continue;
+			if (non_extern_params_walker((Node *) const_em->em_expr, &has_params) ||
+				!has_params)
+				continue;
+			/*
+			 * The value is put in the partitioning key column of a tuple of
+			 * the table, so it must be of the same type. A cross-type
+			 * equality, like date = timestamp, doesn't qualify.
+			 */
+			if (exprType((Node *) const_em->em_expr) != partKeyType)
+				continue;
+
+			return const_em->em_expr;
+		}
+	}
+
+	return NULL;
+}
+
 /*
  * Create a PartitionSelector plan from a Path.
  *
@@ -395,21 +573,41 @@ FindEqKey(PlannerInfo *root, Bitmapset *inner_relids,
 Plan *
 create_partition_selector_plan(PlannerInfo *root, PartitionSelectorPath *best_path)
 {
-	PartitionSelector *ps;
 	Plan	   *subplan;
+
+	subplan = create_plan_recurse(root, best_path->subpath);
+
+	return (Plan *) make_partition_selector(root,
+											best_path->dsinfo,
+											subplan,
+											best_path->partKeyExprs,
+											best_path->partKeyAttnos);
+}
+
+/*
+ * Make a PartitionSelector that selects the partitions of a dynamic scan,
+ * with the partitioning keys computed by the given expressions. They are
+ * computed for each row of the subplan, or once if there is no subplan.
+ */
+static PartitionSelector *
+make_partition_selector(PlannerInfo *root,
+						DynamicScanInfo *dsinfo,
+						Plan *subplan,
+						List *partKeyExprs,
+						List *partKeyAttnos)
+{
+	PartitionSelector *ps;
 	ListCell   *lc_attno;
 	ListCell   *lc_expr;
 	List	   *partTabTargetlist;
 	int			max_attr;
 	int			attno;
-	Expr	  **partKeyExprs;
-
-	subplan = create_plan_recurse(root, best_path->subpath);
+	Expr	  **partKeyExprArray;
 
-	max_attr = find_base_rel(root, best_path->dsinfo->rtindex)->max_attr;
-	partKeyExprs = palloc0((max_attr + 1) * sizeof(Expr *));
+	max_attr = find_base_rel(root, dsinfo->rtindex)->max_attr;
+	partKeyExprArray = palloc0((max_attr + 1) * sizeof(Expr *));
 
-	forboth(lc_attno, best_path->partKeyAttnos, lc_expr, best_path->partKeyExprs)
+	forboth(lc_attno, partKeyAttnos, lc_expr, partKeyExprs)
 	{
 		int			partKeyAttno = lfirst_int(lc_attno);
 		Expr	   *partKeyExpr = (Expr *) lfirst(lc_expr);
@@ -417,13 +615,13 @@ create_partition_selector_plan(PlannerInfo *root, PartitionSelectorPath *best_pa
 		if (partKeyAttno > max_attr)
 			elog(ERROR, "invalid partitioning key attribute number");
 
-		partKeyExprs[partKeyAttno] = partKeyExpr;
+		partKeyExprArray[partKeyAttno] = partKeyExpr;
 	}
 
 	partTabTargetlist = NIL;
 	for (attno = 1; attno <= max_attr; attno++)
 	{
-		Expr	   *expr = partKeyExprs[attno];
+		Expr	   *expr = partKeyExprArray[attno];
 		char		attname[20];
 
 		if (!expr)
@@ -439,24 +637,36 @@ create_partition_selector_plan(PlannerInfo *root, PartitionSelectorPath *best_pa
 	}
 
 	ps = makeNode(PartitionSelector);
-	ps->plan.targetlist = subplan->targetlist;
 	ps->plan.qual = NIL;
 	ps->plan.lefttree = subplan;
 	ps->plan.righttree = NULL;
 
-	ps->plan.startup_cost = subplan->startup_cost;
-	ps->plan.total_cost = subplan->total_cost;
-	ps->plan.plan_rows = subplan->plan_rows;
-	ps->plan.plan_width = subplan->plan_width;
+	if (subplan)
+	{
+		ps->plan.targetlist = subplan->targetlist;
+		ps->plan.startup_cost = subplan->startup_cost;
+		ps->plan.total_cost = subplan->total_cost;
+		ps->plan.plan_rows = subplan->plan_rows;
+		ps->plan.plan_width = subplan->plan_width;
+	}
+	else
+	{
+		/* it returns no rows */
+		ps->plan.targetlist = NIL;
+		ps->plan.startup_cost = 0;
+		ps->plan.total_cost = 0;
+		ps->plan.plan_rows = 0;
+		ps->plan.plan_width = 0;
+	}
 
-	ps->relid = best_path->dsinfo->parentOid;
+	ps->relid = dsinfo->parentOid;
 	ps->nLevels = 1;
-	ps->scanId = best_path->dsinfo->dynamicScanId;
+	ps->scanId = dsinfo->dynamicScanId;
 	ps->selectorId = -1;
 	ps->partTabTargetlist = partTabTargetlist;
 	ps->levelExpressions = NIL;
 	ps->residualPredicate = NULL;
-	ps->printablePredicate = (Node *) best_path->partKeyExprs;
+	ps->printablePredicate = (Node *) partKeyExprs;
 	ps->staticSelection = false;
 	ps->staticPartOids = NIL;
 	ps->staticScanIds = NIL;
@@ -464,7 +674,7 @@ create_partition_selector_plan(PlannerInfo *root, PartitionSelectorPath *best_pa
 	ps->propagationExpression = (Node *)
 		makeConst(INT4OID, -1, InvalidOid, 4, Int32GetDatum(ps->scanId), false, true);
 
-	return (Plan *) ps;
+	return ps;
 }
 
 /*
@@ -902,8 +902,24 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 		case T_PartitionSelector:
 			{
 				PartitionSelector *ps = (PartitionSelector *) plan;
-				indexed_tlist *childplan_itlist =
-					build_tlist_index(plan->lefttree->targetlist);
+				indexed_tlist *childplan_itlist;
+
+				/*
+				 * Without a subplan, the keys are computed from the
+				 * parameters of the query, see
+				 * create_partition_selector_for_params().
+				 */
+				if (plan->lefttree == NULL)
+				{
+					Assert(plan->targetlist == NIL);
+					ps->printablePredicate =
+						fix_scan_expr(root, ps->printablePredicate, rtoffset);
+					ps->partTabTargetlist = (List *)
+						fix_scan_expr(root, (Node *) ps->partTabTargetlist, rtoffset);
+					break;
+				}
+
+				childplan_itlist = build_tlist_index(plan->lefttree->targetlist);
 
 				set_upper_references(root, plan, rtoffset);
 
@@ -2740,6 +2740,13 @@ finalize_plan(PlannerInfo *root, Plan *plan, Bitmapset *valid_params,
 							  &context);
 			break;
 
+		case T_Sort:
+			finalize_primnode(((Sort *) plan)->limitOffset,
+							  &context);
+			finalize_primnode(((Sort *) plan)->limitCount,
+							  &context);
+			break;
+
 		case T_PartitionSelector:
 			finalize_primnode((Node *) ((PartitionSelector *) plan)->levelEqExpressions,
 							  &context);
@@ -2805,7 +2812,6 @@ finalize_plan(PlannerInfo *root, Plan *plan, Bitmapset *valid_params,
 		case T_Hash:
 		case T_ExternalScan:
 		case T_Material:
-		case T_Sort:
 		case T_ShareInputScan:
 		case T_Unique:
 		case T_SetOp:
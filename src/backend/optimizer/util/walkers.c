@@ -347,6 +347,10 @@ plan_tree_walker(Node *node,
 		case T_Sort:
 			if (walk_plan_node_fields((Plan *) node, walker, context))
 				return true;
+			if (walker((Node *) (((Sort *) node)->limitCount), context))
+				return true;
+			if (walker((Node *) (((Sort *) node)->limitOffset), context))
+				return true;
 			/* Other fields are simple counts and lists of indexes and oids. */
 			break;
 
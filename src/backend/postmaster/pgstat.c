@@ -1405,12 +1405,14 @@ pgstat_report_vacuum(Oid tableoid, bool shared,
  *
  * Caller must provide new live- and dead-tuples estimates, as well as a
  * flag indicating whether to reset the changes_since_analyze counter.
+ * In GPDB, also the modification count of the segments for the table, -1 if
+ * unknown.
  * --------
  */
 void
 pgstat_report_analyze(Relation rel,
 					  PgStat_Counter livetuples, PgStat_Counter deadtuples,
-					  bool resetcounter)
+					  bool resetcounter, PgStat_Counter modcount)
 {
 	PgStat_MsgAnalyze msg;
 
@@ -1451,6 +1453,7 @@ pgstat_report_analyze(Relation rel,
 	msg.m_analyzetime = GetCurrentTimestamp();
 	msg.m_live_tuples = livetuples;
 	msg.m_dead_tuples = deadtuples;
+	msg.m_modcount = modcount;
 	pgstat_send(&msg, sizeof(msg));
 }
 
@@ -3721,6 +3724,7 @@ pgstat_get_tab_entry(PgStat_StatDBEntry *dbentry, Oid tableoid, bool create)
 		result->analyze_count = 0;
 		result->autovac_analyze_timestamp = 0;
 		result->autovac_analyze_count = 0;
+		result->analyze_modcount = -1;
 	}
 
 	return result;
@@ -4934,6 +4938,7 @@ pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
 			tabentry->analyze_count = 0;
 			tabentry->autovac_analyze_timestamp = 0;
 			tabentry->autovac_analyze_count = 0;
+			tabentry->analyze_modcount = -1;
 		}
 		else
 		{
@@ -5225,6 +5230,7 @@ pgstat_recv_analyze(PgStat_MsgAnalyze *msg, int len)
 	 */
 	if (msg->m_resetcounter)
 		tabentry->changes_since_analyze = 0;
+	tabentry->analyze_modcount = msg->m_modcount;
 
 	if (msg->m_autovacuum)
 	{
@@ -103,6 +103,9 @@ struct BufFile
 
 	char        *buffer;        /* GPDB: PG upstream uses PGAlignedBlock */
 
+	/* Node to account the writes to, for EXPLAIN ANALYZE, or NULL */
+	Instrumentation *instrument;
+
 	/*
 	 * Current stage, if this is a sequential BufFile. A sequential BufFile
 	 * can be written to once, and read once after that. Without compression,
@@ -137,6 +140,7 @@ struct BufFile
 
 static BufFile *makeBufFile(File firstfile);
 static void BufFileUpdateSize(BufFile *buffile);
+static int	BufFileWriteFile(BufFile *file, char *buffer, int amount);
 
 static void BufFileStartCompression(BufFile *file);
 static void BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes);
@@ -366,6 +370,34 @@ BufFileLoadBuffer(BufFile *file, void* buffer, size_t bufsize)
 	return nb;
 }
 
+/*
+ * BufFileWriteFile
+ *
+ * Write to the underlying file, accounting the bytes that reach it, and the
+ * time it took, to the node the file was created for.
+ */
+static int
+BufFileWriteFile(BufFile *file, char *buffer, int amount)
+{
+	instr_time	starttime;
+	instr_time	endtime;
+	int			wrote;
+
+	if (file->instrument == NULL)
+		return FileWrite(file->file, buffer, amount);
+
+	INSTR_TIME_SET_CURRENT(starttime);
+	wrote = FileWrite(file->file, buffer, amount);
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_SUBTRACT(endtime, starttime);
+
+	file->instrument->workfileWriteTime += INSTR_TIME_GET_DOUBLE(endtime);
+	if (wrote > 0)
+		file->instrument->workfileDiskBytes += wrote;
+
+	return wrote;
+}
+
 /*
  * BufFileDumpBuffer
  *
@@ -392,7 +424,7 @@ BufFileDumpBuffer(BufFile *file, const void* buffer, Size nbytes)
 			elog(ERROR, "could not seek in temporary file: %m");
 		}
 
-		wrote = FileWrite(file->file, (char *)buffer + wpos, (int)bytestowrite);
+		wrote = BufFileWriteFile(file, (char *)buffer + wpos, (int)bytestowrite);
 		if (wrote != bytestowrite)
 			elog(ERROR, "could not write %d bytes to temporary file: %m", (int) bytestowrite);
 		file->offset += wrote;
@@ -402,6 +434,9 @@ BufFileDumpBuffer(BufFile *file, const void* buffer, Size nbytes)
 	}
 	file->dirty = false;
 
+	if (file->instrument)
+		file->instrument->workfileBytes += nbytes;
+
 	/*
 	 * Now we can set the buffer empty without changing the logical position
 	 */
@@ -796,6 +831,27 @@ BufFileSeekBlock(BufFile *file, int64 blknum)
 	return BufFileSeek(file, 0 /* fileno */, blknum * BLCKSZ, SEEK_SET);
 }
 
+/*
+ * BufFilePrefetchBlock --- initiate an asynchronous read of the n'th block
+ *
+ * This is only a hint that the block will be read soon, the logical position
+ * is not moved.  Nothing is done for sequential files, or for a block that is
+ * in the buffer.
+ */
+void
+BufFilePrefetchBlock(BufFile *file, int64 blknum)
+{
+	int64		offset = blknum * BLCKSZ;
+
+	if (file->state != BFS_RANDOM_ACCESS || file->buffer == NULL)
+		return;
+
+	if (offset + BLCKSZ > file->offset && offset < file->offset + file->nbytes)
+		return;
+
+	(void) FilePrefetch(file->file, offset, BLCKSZ);
+}
+
 /*
  * BufFileUpdateSize
  *
@@ -939,6 +995,19 @@ BufFilePledgeSequential(BufFile *buffile)
 		BufFileStartCompression(buffile);
 }
 
+/*
+ * BufFileSetInstrument
+ *
+ * Account the writes to the file to the given plan node, so that EXPLAIN
+ * ANALYZE can show how much the node spilled, how well it compressed, and
+ * how fast it was written.
+ */
+void
+BufFileSetInstrument(BufFile *buffile, Instrumentation *instr)
+{
+	buffile->instrument = instr;
+}
+
 /*
  * The rest of the code is only needed when compression support is compiled in.
  */
@@ -999,6 +1068,8 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 	ZSTD_inBuffer input;
 
 	file->uncompressed_bytes += nbytes;
+	if (file->instrument)
+		file->instrument->workfileBytes += nbytes;
 
 	/*
 	 * Call ZSTD_compressStream() until all the input has been consumed.
@@ -1023,7 +1094,7 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 		{
 			int			wrote;
 
-			wrote = FileWrite(file->file, output.dst, output.pos);
+			wrote = BufFileWriteFile(file, output.dst, output.pos);
 			if (wrote != output.pos)
 				elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) output.pos);
 			file->maxoffset += wrote;
@@ -1052,7 +1123,7 @@ BufFileEndCompression(BufFile *file)
 		if (ZSTD_isError(ret))
 			elog(ERROR, "%s", ZSTD_getErrorName(ret));
 
-		wrote = FileWrite(file->file, output.dst, output.pos);
+		wrote = BufFileWriteFile(file, output.dst, output.pos);
 		if (wrote != output.pos)
 			elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) output.pos);
 		file->maxoffset += wrote;
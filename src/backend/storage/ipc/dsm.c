@@ -40,6 +40,7 @@
 #include "storage/ipc.h"
 #include "storage/lwlock.h"
 #include "storage/pg_shmem.h"
+#include "utils/faultinjector.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
@@ -452,13 +453,18 @@ dsm_set_control_handle(dsm_handle h)
 
 /*
  * Create a new dynamic shared memory segment.
+ *
+ * With DSM_CREATE_NULL_IF_MAXSEGMENTS, NULL is returned instead of raising
+ * an error when all the segment slots are in use.
  */
 dsm_segment *
-dsm_create(Size size)
+dsm_create(Size size, int flags)
 {
 	dsm_segment *seg = dsm_create_descriptor();
 	uint32		i;
 	uint32		nitems;
+	uint32		maxitems;
+	bool		simulate_full = false;
 
 	/* Unsafe in postmaster (and pointless in a stand-alone backend). */
 	Assert(IsUnderPostmaster);
@@ -476,11 +482,18 @@ dsm_create(Size size)
 			break;
 	}
 
+#ifdef FAULT_INJECTOR
+	/* pretend that all the slots are in use */
+	if (SIMPLE_FAULT_INJECTOR("dsm_create_max_segments") == FaultInjectorTypeSkip)
+		simulate_full = true;
+#endif
+
 	/* Lock the control segment so we can register the new segment. */
 	LWLockAcquire(DynamicSharedMemoryControlLock, LW_EXCLUSIVE);
 
 	/* Search the control segment for an unused slot. */
-	nitems = dsm_control->nitems;
+	nitems = simulate_full ? 0 : dsm_control->nitems;
+	maxitems = simulate_full ? 0 : dsm_control->maxitems;
 	for (i = 0; i < nitems; ++i)
 	{
 		if (dsm_control->item[i].refcnt == 0)
@@ -495,10 +508,23 @@ dsm_create(Size size)
 	}
 
 	/* Verify that we can support an additional mapping. */
-	if (nitems >= dsm_control->maxitems)
+	if (nitems >= maxitems)
+	{
+		if ((flags & DSM_CREATE_NULL_IF_MAXSEGMENTS) != 0)
+		{
+			LWLockRelease(DynamicSharedMemoryControlLock);
+			dsm_impl_op(DSM_OP_DESTROY, seg->handle, 0, &seg->impl_private,
+						&seg->mapped_address, &seg->mapped_size, WARNING);
+			if (seg->resowner != NULL)
+				ResourceOwnerForgetDSM(seg->resowner, seg);
+			dlist_delete(&seg->node);
+			pfree(seg);
+			return NULL;
+		}
 		ereport(ERROR,
 				(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
 				 errmsg("too many dynamic shared memory segments")));
+	}
 
 	/* Enter the handle into a new array slot. */
 	dsm_control->item[nitems].handle = seg->handle;
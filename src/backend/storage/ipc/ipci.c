@@ -64,6 +64,10 @@
 #include "executor/spi.h"
 #include "utils/workfile_mgr.h"
 #include "utils/session_state.h"
+#include "utils/sharedmdcache.h"
+#include "utils/tuplestorenew.h"
+#include "optimizer/orcaslots.h"
+#include "cdb/cdbbroadcastcache.h"
 
 shmem_startup_hook_type shmem_startup_hook = NULL;
 
@@ -179,6 +183,10 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, CheckpointerShmemSize());
 		size = add_size(size, CancelBackendMsgShmemSize());
 		size = add_size(size, WorkFileShmemSize());
+		size = add_size(size, SharedMDCacheShmemSize());
+		size = add_size(size, ntuplestore_shmem_size());
+		size = add_size(size, OrcaSlotsShmemSize());
+		size = add_size(size, BroadcastCacheShmemSize());
 
 #ifdef FAULT_INJECTOR
 		size = add_size(size, FaultInjector_ShmemSize());
@@ -340,6 +348,10 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	AsyncShmemInit();
 	BackendCancelShmemInit();
 	WorkFileShmemInit();
+	SharedMDCacheShmemInit();
+	ntuplestore_shmem_init();
+	OrcaSlotsShmemInit();
+	BroadcastCacheShmemInit();
 
 	/*
 	 * Set up Instrumentation free list
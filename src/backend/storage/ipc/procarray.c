@@ -1544,6 +1544,7 @@ SnapshotResetDslm(Snapshot snapshot)
 	dslm->currentLocalXidsCount = 0;
 	dslm->minCachedLocalXid = InvalidTransactionId;
 	dslm->maxCachedLocalXid = InvalidTransactionId;
+	dslm->lastCommittedLocalXid = InvalidTransactionId;
 	if (dslm->inProgressMappedLocalXids == NULL)
 	{
 		dslm->inProgressMappedLocalXids =
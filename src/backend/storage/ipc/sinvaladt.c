@@ -176,6 +176,12 @@ typedef struct SISeg
 	int			lastBackend;	/* index of last active procState entry, +1 */
 	int			maxBackends;	/* size of procState array */
 
+	/*
+	 * Number of messages ever inserted.  Unlike maxMsgNum it is never
+	 * wrapped around, so it serves as a version of the catalogs.
+	 */
+	uint64		numInserted;
+
 	slock_t		msgnumLock;		/* spinlock protecting maxMsgNum */
 
 	/*
@@ -240,6 +246,7 @@ CreateSharedInvalidationState(void)
 	shmInvalBuffer->nextThreshold = CLEANUP_MIN;
 	shmInvalBuffer->lastBackend = 0;
 	shmInvalBuffer->maxBackends = MaxBackends;
+	shmInvalBuffer->numInserted = 0;
 	SpinLockInit(&shmInvalBuffer->msgnumLock);
 
 	/* The buffer[] array is initially all unused, so we need not fill it */
@@ -497,6 +504,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 			volatile SISeg *vsegP = segP;
 
 			SpinLockAcquire(&vsegP->msgnumLock);
+			vsegP->numInserted += max - vsegP->maxMsgNum;
 			vsegP->maxMsgNum = max;
 			SpinLockRelease(&vsegP->msgnumLock);
 		}
@@ -640,6 +648,27 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 	return n;
 }
 
+/*
+ * SIGetInsertedCount
+ *		Number of messages inserted so far.
+ *
+ * Any catalog change committed before the messages counted were inserted is
+ * seen by a backend once it has processed them.
+ */
+uint64
+SIGetInsertedCount(void)
+{
+	/* use volatile pointer to prevent code rearrangement */
+	volatile SISeg *vsegP = shmInvalBuffer;
+	uint64		count;
+
+	SpinLockAcquire(&vsegP->msgnumLock);
+	count = vsegP->numInserted;
+	SpinLockRelease(&vsegP->msgnumLock);
+
+	return count;
+}
+
 /*
  * SICleanupQueue
  *		Remove messages that have been consumed by all active backends
@@ -28,6 +28,7 @@
 
 #include "access/heapam.h"
 #include "catalog/namespace.h"
+#include "cdb/cdbbroadcastcache.h"
 #include "cdb/cdbvars.h"
 #include "utils/lsyscache.h"        /* CDB: get_rel_namespace() */
 #include "utils/guc.h"
@@ -102,6 +103,9 @@ LockRelationOid(Oid relid, LOCKMODE lockmode)
 
 	res = LockAcquireExtended(&tag, lockmode, false, false, true, &locallock);
 
+	/* CDB: the broadcast cache of the segments must not serve it anymore */
+	BroadcastCacheNoteLock(relid, lockmode);
+
 	/*
 	 * Now that we have the lock, check for invalidation messages, so that we
 	 * will update or flush any stale relcache entry before we try to use it.
@@ -148,6 +152,8 @@ ConditionalLockRelationOid(Oid relid, LOCKMODE lockmode)
 	if (res == LOCKACQUIRE_NOT_AVAIL)
 		return false;
 
+	BroadcastCacheNoteLock(relid, lockmode);
+
 	/*
 	 * Now that we have the lock, check for invalidation messages; see notes
 	 * in LockRelationOid.
@@ -212,6 +218,8 @@ LockRelation(Relation relation, LOCKMODE lockmode)
 
 	res = LockAcquireExtended(&tag, lockmode, false, false, true, &locallock);
 
+	BroadcastCacheNoteLock(relation->rd_lockInfo.lockRelId.relId, lockmode);
+
 	/*
 	 * Now that we have the lock, check for invalidation messages; see notes
 	 * in LockRelationOid.
@@ -242,6 +250,9 @@ LockRelationNoWait(Relation relation, LOCKMODE lockmode)
 
 	res = LockAcquire(&tag, lockmode, false, true);
 
+	if (res != LOCKACQUIRE_NOT_AVAIL)
+		BroadcastCacheNoteLock(relation->rd_lockInfo.lockRelId.relId, lockmode);
+
 	/*
 	 * Now that we have the lock, check for invalidation messages; see notes
 	 * in LockRelationOid.
@@ -275,6 +286,8 @@ ConditionalLockRelation(Relation relation, LOCKMODE lockmode)
 	if (res == LOCKACQUIRE_NOT_AVAIL)
 		return false;
 
+	BroadcastCacheNoteLock(relation->rd_lockInfo.lockRelId.relId, lockmode);
+
 	/*
 	 * Now that we have the lock, check for invalidation messages; see notes
 	 * in LockRelationOid.
@@ -77,6 +77,7 @@
 #include "utils/faultinjector.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/plancache.h"
 #include "utils/ps_status.h"
 #include "utils/snapmgr.h"
 #include "utils/timeout.h"
@@ -1120,7 +1121,7 @@ exec_mpp_query(const char *query_string,
      */
 	if (serializedPlantree != NULL && serializedPlantreelen > 0)
 	{
-		plan = (PlannedStmt *) deserializeNode(serializedPlantree,serializedPlantreelen);
+		plan = (PlannedStmt *) deserializeNodeCached(serializedPlantree,serializedPlantreelen);
 		if (!plan || !IsA(plan, PlannedStmt))
 			elog(ERROR, "MPPEXEC: receive invalid planned statement");
     }
@@ -5148,6 +5149,15 @@ PostgresMain(int argc, char *argv[],
 
 			ReadyForQuery(whereToSendOutput);
 			send_ready_for_query = false;
+
+			/*
+			 * Replan prepared statements that catalog changes such as
+			 * ANALYZE have invalidated now, instead of on their next
+			 * execution.
+			 */
+			if (gp_replan_when_idle && Gp_role == GP_ROLE_DISPATCH &&
+				!IsTransactionOrTransactionBlock())
+				RebuildInvalidCachedPlans();
 		}
 
 		/*
@@ -8,13 +8,33 @@
  *
  * gp_opt_version: This function wraps LibraryVersion. 
  *
+ * gp_optimizer_stats: This function returns the time spent in each phase of
+ * the optimizer, summed over the session.
+ *
+ * gp_optimizer_search_stages: This function returns how often each stage of
+ * the search strategy found a plan, and the cheapest one, over the session.
+ *
+ * gp_optimizer_captures: This function returns the minidumps of the latest
+ * optimizations of the session that took longer than
+ * optimizer_capture_threshold.
+ *
+ * gp_optimizer_plan_trace: This function returns the estimated and actual
+ * statistics of the latest plan nodes kept by optimizer_plan_trace.
+ *
  * Copyright(c) 2012 - present, EMC/Greenplum
  */
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
 #include "funcapi.h"
 #include "utils/builtins.h"
+#include "utils/timestamp.h"
+
+#ifdef USE_ORCA
+#include "optimizer/orca.h"
+#include "optimizer/orcafeedback.h"
+#endif
 
 extern Datum EnableXform(PG_FUNCTION_ARGS);
 
@@ -60,3 +80,195 @@ gp_opt_version(PG_FUNCTION_ARGS __attribute__((unused)))
 	return CStringGetTextDatum("Server has been compiled without ORCA");
 #endif
 }
+
+/*
+* Returns the time spent in each phase of the optimizer over the session.
+*/
+Datum
+gp_optimizer_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[8];
+	bool		nulls[8];
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(values, 0, sizeof(values));
+
+#ifdef USE_ORCA
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(optimizer_total_stats.num_optimizations);
+	values[1] = Float8GetDatum(optimizer_total_stats.translate_time);
+	values[2] = Float8GetDatum(optimizer_total_stats.search_time);
+	values[3] = Float8GetDatum(optimizer_total_stats.plan_time);
+	values[4] = Float8GetDatum(optimizer_total_stats.missing_stats_time);
+	values[5] = Int64GetDatum(optimizer_total_stats.num_mdfetches);
+	values[6] = Float8GetDatum(optimizer_total_stats.mdfetch_time);
+	values[7] = Int64GetDatum(optimizer_total_stats.peak_memory);
+#else
+	/* nothing to report without ORCA */
+	memset(nulls, true, sizeof(nulls));
+#endif
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+* Returns the outcome of each stage of the search strategy over the session.
+*/
+Datum
+gp_optimizer_search_stages(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+#ifdef USE_ORCA
+	if ((int) funcctx->call_cntr < optimizer_num_search_stages)
+	{
+		const OptimizerSearchStageStats *stats =
+			&optimizer_search_stage_stats[funcctx->call_cntr];
+		Datum		values[6];
+		bool		nulls[6];
+		HeapTuple	tuple;
+
+		MemSet(nulls, 0, sizeof(nulls));
+		values[0] = Int32GetDatum((int32) funcctx->call_cntr);
+		values[1] = Int32GetDatum(stats->num_xforms);
+		values[2] = Int64GetDatum(stats->num_searches);
+		values[3] = Int64GetDatum(stats->num_plans);
+		values[4] = Int64GetDatum(stats->num_best);
+		if (stats->last_cost >= 0)
+			values[5] = Float8GetDatum(stats->last_cost);
+		else
+			nulls[5] = true;
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+#endif
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+* Returns the slow optimizations of the session kept, oldest first.
+*/
+Datum
+gp_optimizer_captures(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+#ifdef USE_ORCA
+	{
+		const OptimizerCapture *capture = orca_get_capture((int) funcctx->call_cntr);
+
+		if (capture != NULL)
+		{
+			Datum		values[4];
+			bool		nulls[4];
+			HeapTuple	tuple;
+
+			MemSet(nulls, 0, sizeof(nulls));
+			values[0] = TimestampTzGetDatum(capture->captured_at);
+			values[1] = Float8GetDatum(capture->optimization_time);
+			if (capture->query_text != NULL)
+				values[2] = CStringGetTextDatum(capture->query_text);
+			else
+				nulls[2] = true;
+			values[3] = CStringGetTextDatum(capture->minidump);
+
+			tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+			SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+		}
+	}
+#endif
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+* Returns the plan nodes of the session kept, oldest first.
+*/
+Datum
+gp_optimizer_plan_trace(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+#ifdef USE_ORCA
+	{
+		const OrcaPlanTraceEntry *entry = OrcaPlanTraceGet((int) funcctx->call_cntr);
+
+		if (entry != NULL)
+		{
+			Datum		values[7];
+			bool		nulls[7];
+			HeapTuple	tuple;
+
+			MemSet(nulls, 0, sizeof(nulls));
+			values[0] = TimestampTzGetDatum(entry->recorded_at);
+			values[1] = Int64GetDatum((int64) entry->fingerprint);
+			values[2] = CStringGetTextDatum(entry->node_type);
+			values[3] = Float8GetDatum(entry->plan_rows);
+			values[4] = Float8GetDatum(entry->actual_rows);
+			values[5] = Float8GetDatum(entry->total_cost);
+			values[6] = Float8GetDatum(entry->actual_time);
+
+			tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+			SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+		}
+	}
+#endif
+
+	SRF_RETURN_DONE(funcctx);
+}
@@ -0,0 +1,346 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_tdigest.c
+ *	  Approximate percentiles with t-digests.
+ *
+ * A t-digest summarizes a set of values as a sorted list of centroids (mean
+ * and weight), which are small near the extremes and large in the middle, so
+ * that percentiles near 0 and 1 stay accurate.  Values are buffered, and the
+ * buffer is merged into the centroids when it fills up.  Two digests are
+ * combined by merging their centroids the same way, which is what lets the
+ * approx_percentile() aggregate run in two stages, with only the digests
+ * crossing the motion between them.
+ *
+ * The digest is a fixed size bytea, so that the transition function can add
+ * values to it in place.
+ *
+ * See Ted Dunning and Otmar Ertl, "Computing Extremely Accurate Quantiles
+ * Using t-Digests".
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/adt/gp_tdigest.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "fmgr.h"
+#include "utils/builtins.h"
+
+/* compression: the digest keeps at most about this many centroids */
+#define TDIGEST_COMPRESSION		100
+#define TDIGEST_MAX_CENTROIDS	(2 * TDIGEST_COMPRESSION)
+#define TDIGEST_BUFFER_SIZE		200
+
+typedef struct TDigestCentroid
+{
+	double		mean;
+	double		weight;
+} TDigestCentroid;
+
+typedef struct TDigest
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	int32		ncentroids;
+	int32		nbuffered;
+	int32		padding;
+	double		fraction;		/* percentile to compute, in [0, 1] */
+	double		weight;			/* total weight of the centroids */
+	double		min;
+	double		max;
+	TDigestCentroid centroids[TDIGEST_MAX_CENTROIDS];
+	double		buffer[TDIGEST_BUFFER_SIZE];
+} TDigest;
+
+static TDigest *
+tdigest_create(MemoryContext mcxt, double fraction)
+{
+	TDigest    *digest;
+
+	digest = (TDigest *) MemoryContextAllocZero(mcxt, sizeof(TDigest));
+	SET_VARSIZE(digest, sizeof(TDigest));
+	digest->fraction = fraction;
+	digest->min = get_float8_infinity();
+	digest->max = -get_float8_infinity();
+
+	return digest;
+}
+
+static TDigest *
+tdigest_check(bytea *value)
+{
+	if (VARSIZE(value) != sizeof(TDigest))
+		elog(ERROR, "invalid t-digest of size %u", VARSIZE(value));
+
+	return (TDigest *) value;
+}
+
+static int
+centroid_cmp(const void *a, const void *b)
+{
+	double		ma = ((const TDigestCentroid *) a)->mean;
+	double		mb = ((const TDigestCentroid *) b)->mean;
+
+	if (ma < mb)
+		return -1;
+	if (ma > mb)
+		return 1;
+	return 0;
+}
+
+/*
+ * The k1 scale function.  Centroids may span at most 1 in k, which keeps
+ * the ones near q = 0 and q = 1 small.
+ */
+static double
+tdigest_scale(double q)
+{
+	return TDIGEST_COMPRESSION / (2.0 * M_PI) * asin(2.0 * q - 1.0);
+}
+
+/*
+ * Merge the centroids and the buffer of a digest, and any extra centroids
+ * (of another digest), into the digest's centroids.
+ */
+static void
+tdigest_compress(TDigest *digest, const TDigestCentroid *extra, int nextra)
+{
+	TDigestCentroid *items;
+	TDigestCentroid cur;
+	double		total;
+	double		weightsofar;
+	int			nitems = 0;
+	int			i;
+
+	if (digest->nbuffered == 0 && nextra == 0)
+		return;
+
+	items = (TDigestCentroid *)
+		palloc((digest->ncentroids + digest->nbuffered + nextra) *
+			   sizeof(TDigestCentroid));
+
+	total = digest->weight;
+	for (i = 0; i < digest->ncentroids; i++)
+		items[nitems++] = digest->centroids[i];
+	for (i = 0; i < digest->nbuffered; i++)
+	{
+		items[nitems].mean = digest->buffer[i];
+		items[nitems].weight = 1.0;
+		nitems++;
+		total += 1.0;
+	}
+	for (i = 0; i < nextra; i++)
+	{
+		items[nitems++] = extra[i];
+		total += extra[i].weight;
+	}
+
+	qsort(items, nitems, sizeof(TDigestCentroid), centroid_cmp);
+
+	digest->ncentroids = 0;
+	weightsofar = 0;
+	cur = items[0];
+	for (i = 1; i < nitems; i++)
+	{
+		double		proposed = cur.weight + items[i].weight;
+
+		if (tdigest_scale((weightsofar + proposed) / total) -
+			tdigest_scale(weightsofar / total) <= 1.0)
+		{
+			cur.mean += (items[i].mean - cur.mean) * items[i].weight / proposed;
+			cur.weight = proposed;
+		}
+		else
+		{
+			Assert(digest->ncentroids < TDIGEST_MAX_CENTROIDS);
+			digest->centroids[digest->ncentroids++] = cur;
+			weightsofar += cur.weight;
+			cur = items[i];
+		}
+	}
+	Assert(digest->ncentroids < TDIGEST_MAX_CENTROIDS);
+	digest->centroids[digest->ncentroids++] = cur;
+
+	digest->weight = total;
+	digest->nbuffered = 0;
+	pfree(items);
+}
+
+/*
+ * Estimate the value at the given fraction of a compressed digest, like
+ * percentile_cont() would.  The values are ranked from 0 to weight - 1, each
+ * centroid is taken to sit at the middle rank of its values, and the values
+ * between centroids are interpolated linearly.  This is exact while all the
+ * centroids are single values.
+ */
+static double
+tdigest_quantile(TDigest *digest, double q)
+{
+	TDigestCentroid *c = digest->centroids;
+	int			n = digest->ncentroids;
+	double		target = q * (digest->weight - 1.0);
+	double		center;
+	double		weightsofar = 0;
+	int			i;
+
+	Assert(n > 0 && digest->nbuffered == 0);
+
+	/* before the middle of the first centroid */
+	center = (c[0].weight - 1.0) / 2.0;
+	if (target <= center)
+	{
+		if (center <= 0)
+			return c[0].mean;
+		return digest->min + (c[0].mean - digest->min) * target / center;
+	}
+
+	for (i = 0; i < n - 1; i++)
+	{
+		double		next;
+
+		next = weightsofar + c[i].weight + (c[i + 1].weight - 1.0) / 2.0;
+		if (target <= next)
+			return c[i].mean + (c[i + 1].mean - c[i].mean) *
+				(target - center) / (next - center);
+		weightsofar += c[i].weight;
+		center = next;
+	}
+
+	/* after the middle of the last centroid */
+	return c[n - 1].mean + (digest->max - c[n - 1].mean) *
+		(target - center) / (digest->weight - 1.0 - center);
+}
+
+/*
+ * gp_tdigest_add
+ *	  transition function of approx_percentile(value, fraction)
+ */
+Datum
+gp_tdigest_add(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	TDigest    *digest;
+	double		value;
+	double		fraction;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "gp_tdigest_add called in non-aggregate context");
+
+	if (PG_ARGISNULL(1) || PG_ARGISNULL(2))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	value = PG_GETARG_FLOAT8(1);
+	fraction = PG_GETARG_FLOAT8(2);
+
+	if (fraction < 0 || fraction > 1 || isnan(fraction))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1",
+						fraction)));
+
+	if (PG_ARGISNULL(0))
+		digest = tdigest_create(aggcontext, fraction);
+	else
+	{
+		/* we own the state, so we can scribble on it */
+		digest = tdigest_check(PG_GETARG_BYTEA_P(0));
+		if (digest->fraction != fraction)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("percentile of approx_percentile must be the same for all rows")));
+	}
+
+	/* NaNs and infinities can't be averaged, leave them out */
+	if (isnan(value) || isinf(value))
+		PG_RETURN_BYTEA_P(digest);
+
+	if (digest->nbuffered == TDIGEST_BUFFER_SIZE)
+		tdigest_compress(digest, NULL, 0);
+	digest->buffer[digest->nbuffered++] = value;
+	digest->min = Min(digest->min, value);
+	digest->max = Max(digest->max, value);
+
+	PG_RETURN_BYTEA_P(digest);
+}
+
+/*
+ * gp_tdigest_merge
+ *	  combine function of approx_percentile(value, fraction)
+ */
+Datum
+gp_tdigest_merge(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	TDigest    *digest;
+	TDigest    *other;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "gp_tdigest_merge called in non-aggregate context");
+
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		digest = (TDigest *) MemoryContextAlloc(aggcontext, sizeof(TDigest));
+		memcpy(digest, tdigest_check(PG_GETARG_BYTEA_P(1)), sizeof(TDigest));
+		PG_RETURN_BYTEA_P(digest);
+	}
+
+	/*
+	 * The other digest comes from a tuple, where its doubles might not be
+	 * aligned, and compressing its buffer turns the buffered values into
+	 * centroids of weight 1.
+	 */
+	other = (TDigest *) palloc(sizeof(TDigest));
+	memcpy(other, tdigest_check(PG_GETARG_BYTEA_P(1)), sizeof(TDigest));
+	tdigest_compress(other, NULL, 0);
+
+	digest = tdigest_check(PG_GETARG_BYTEA_P(0));
+	if (digest->fraction != other->fraction)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("percentile of approx_percentile must be the same for all rows")));
+
+	tdigest_compress(digest, other->centroids, other->ncentroids);
+	digest->min = Min(digest->min, other->min);
+	digest->max = Max(digest->max, other->max);
+	pfree(other);
+
+	PG_RETURN_BYTEA_P(digest);
+}
+
+/*
+ * gp_tdigest_percentile
+ *	  final function of approx_percentile(value, fraction)
+ */
+Datum
+gp_tdigest_percentile(PG_FUNCTION_ARGS)
+{
+	TDigest    *digest;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	/* compress a copy, the state belongs to the aggregate */
+	digest = (TDigest *) palloc(sizeof(TDigest));
+	memcpy(digest, tdigest_check(PG_GETARG_BYTEA_P(0)), sizeof(TDigest));
+	tdigest_compress(digest, NULL, 0);
+
+	if (digest->ncentroids == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_FLOAT8(tdigest_quantile(digest, digest->fraction));
+}
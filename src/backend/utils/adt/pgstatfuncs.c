@@ -150,6 +150,8 @@ pgstat_waiting_string(char reason)
 			return "replication";
 		case PGBE_WAITING_RESGROUP:
 			return "resgroup";
+		case PGBE_WAITING_OPTIMIZER:
+			return "optimizer";
 		default:
 			return NULL;
 	}
@@ -2224,7 +2224,6 @@ get_relname_relid(const char *relname, Oid relnamespace)
 						   ObjectIdGetDatum(relnamespace));
 }
 
-#ifdef NOT_USED
 /*
  * get_relnatts
  *
@@ -2248,7 +2247,6 @@ get_relnatts(Oid relid)
 	else
 		return InvalidAttrNumber;
 }
-#endif
 
 /*
  * get_rel_name
@@ -50,6 +50,7 @@
 #include <limits.h>
 
 #include "access/transam.h"
+#include "access/xact.h"
 #include "catalog/namespace.h"
 #include "executor/executor.h"
 #include "executor/spi.h"
@@ -60,6 +61,7 @@
 #include "parser/analyze.h"
 #include "parser/parsetree.h"
 #include "storage/lmgr.h"
+#include "storage/sinvaladt.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
 #include "utils/inval.h"
@@ -86,6 +88,7 @@
 static CachedPlanSource *first_saved_plan = NULL;
 
 static void ReleaseGenericPlan(CachedPlanSource *plansource);
+static CachedPlan *BuildGenericPlan(CachedPlanSource *plansource, List *qlist);
 static List *RevalidateCachedQuery(CachedPlanSource *plansource, IntoClause *intoClause);
 static bool CheckCachedPlan(CachedPlanSource *plansource);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
@@ -1169,27 +1172,7 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 		else
 		{
 			/* Build a new generic plan */
-			plan = BuildCachedPlan(plansource, qlist, NULL, NULL);
-			/* Just make real sure plansource->gplan is clear */
-			ReleaseGenericPlan(plansource);
-			/* Link the new generic plan into the plansource */
-			plansource->gplan = plan;
-			plan->refcount++;
-			/* Immediately reparent into appropriate context */
-			if (plansource->is_saved)
-			{
-				/* saved plans all live under CacheMemoryContext */
-				MemoryContextSetParent(plan->context, CacheMemoryContext);
-				plan->is_saved = true;
-			}
-			else
-			{
-				/* otherwise, it should be a sibling of the plansource */
-				MemoryContextSetParent(plan->context,
-								MemoryContextGetParent(plansource->context));
-			}
-			/* Update generic_cost whenever we make a new generic plan */
-			plansource->generic_cost = cached_plan_cost(plan, false);
+			plan = BuildGenericPlan(plansource, qlist);
 
 			/*
 			 * If, based on the now-known value of generic_cost, we'd not have
@@ -1247,6 +1230,105 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 	return plan;
 }
 
+/*
+ * BuildGenericPlan: build a new generic plan, and link it into the
+ * plansource in place of the old one.
+ */
+static CachedPlan *
+BuildGenericPlan(CachedPlanSource *plansource, List *qlist)
+{
+	CachedPlan *plan;
+
+	plan = BuildCachedPlan(plansource, qlist, NULL, NULL);
+	/* Just make real sure plansource->gplan is clear */
+	ReleaseGenericPlan(plansource);
+	/* Link the new generic plan into the plansource */
+	plansource->gplan = plan;
+	plan->refcount++;
+	/* Immediately reparent into appropriate context */
+	if (plansource->is_saved)
+	{
+		/* saved plans all live under CacheMemoryContext */
+		MemoryContextSetParent(plan->context, CacheMemoryContext);
+		plan->is_saved = true;
+	}
+	else
+	{
+		/* otherwise, it should be a sibling of the plansource */
+		MemoryContextSetParent(plan->context,
+							   MemoryContextGetParent(plansource->context));
+	}
+	/* Update generic_cost whenever we make a new generic plan */
+	plansource->generic_cost = cached_plan_cost(plan, false);
+
+	return plan;
+}
+
+/*
+ * RebuildInvalidCachedPlans: rebuild the generic plans of saved plans that
+ * have been invalidated by catalog changes.
+ *
+ * This is called by an idle backend, outside of any transaction, so that the
+ * next execution of a prepared statement finds a valid plan instead of having
+ * to plan the query again first.  Only the plans that have had a generic plan
+ * are rebuilt, the others are planned for their parameters when executed
+ * anyway.  Errors are ignored, the execution runs into them again.
+ */
+void
+RebuildInvalidCachedPlans(void)
+{
+	static uint64 last_inval_count = 0;
+	uint64		inval_count;
+	CachedPlanSource *plansource;
+	MemoryContext oldcontext = CurrentMemoryContext;
+
+	/* nothing can have been invalidated since the last check */
+	inval_count = SIGetInsertedCount();
+	if (inval_count == last_inval_count)
+		return;
+	last_inval_count = inval_count;
+
+	for (plansource = first_saved_plan; plansource; plansource = plansource->next_saved)
+	{
+		if (plansource->gplan)
+			break;
+	}
+	if (plansource == NULL)
+		return;
+
+	/* starting the transaction processes the pending invalidations */
+	StartTransactionCommand();
+
+	PG_TRY();
+	{
+		for (plansource = first_saved_plan; plansource; plansource = plansource->next_saved)
+		{
+			List	   *qlist;
+
+			Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+
+			if (plansource->gplan == NULL ||
+				(plansource->is_valid && plansource->gplan->is_valid))
+				continue;
+
+			qlist = RevalidateCachedQuery(plansource, NULL);
+			if (!CheckCachedPlan(plansource))
+				BuildGenericPlan(plansource, qlist);
+		}
+
+		CommitTransactionCommand();
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(oldcontext);
+		FlushErrorState();
+		AbortCurrentTransaction();
+	}
+	PG_END_TRY();
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * ReleaseCachedPlan: release active use of a cached plan.
  *
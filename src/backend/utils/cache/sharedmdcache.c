@@ -0,0 +1,467 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedmdcache.c
+ *	  Metadata cache of GPORCA shared by the backends on the master.
+ *
+ * GPORCA keeps the metadata objects it has looked up in a cache private to
+ * the backend, so every new session has to translate relations, types,
+ * operators and statistics from the catalogs to DXL again.  This cache keeps
+ * the serialized DXL of those objects in shared memory, so that a backend can
+ * parse the DXL another backend has produced instead.
+ *
+ * Entries are only valid for the catalog version they were produced at: the
+ * number of shared invalidation messages inserted so far.  A backend takes
+ * the version before it processes pending invalidations, after which its
+ * catalog lookups are at least as new as the version.  Once a newer version
+ * is stored, all the entries of older versions are dropped at once, so the
+ * data area is simply filled from the start until it's full.
+ *
+ * Readers hold SharedMDCacheLock in shared mode while they copy an entry out,
+ * so they don't block each other; it is held exclusively only to add entries.
+ *
+ * The DXL is stored compressed when that makes it smaller, statistics with
+ * their histograms compress well.  It's compressed before the lock is taken,
+ * and copied out compressed, so the lock isn't held while doing either.
+ *
+ * Built-in types, operators, functions, aggregates, casts and comparisons,
+ * those of objects created by initdb, don't change with the catalog version,
+ * and are needed by nearly every query a new session optimizes.  They are
+ * kept in an area of their own, which is not dropped with the entries of an
+ * older version, so that they are only translated once after startup.  The
+ * few commands that can change them, such as ALTER FUNCTION on a built-in
+ * function or CREATE OPERATOR CLASS, drop that area when their invalidations
+ * are processed, and a store begun before that is discarded.  The catalogs
+ * of those objects are per database, so the keys the callers make start
+ * with the oid of the database, and the whole area is dropped on a change
+ * in any database: only the backends of that database see its invalidations.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/cache/sharedmdcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/transam.h"
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/sinvaladt.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+#include "utils/pg_lzcompress.h"
+#include "utils/sharedmdcache.h"
+#include "utils/syscache.h"
+
+/* Expected size of the DXL of an object, to size the hash table */
+#define SHARED_MDCACHE_AVG_ENTRY_SIZE 2048
+
+/* The area of built-in objects is this fraction of the data area */
+#define SHARED_MDCACHE_BUILTIN_FRACTION 4
+
+typedef struct SharedMDCacheEntry
+{
+	char		key[SHARED_MDCACHE_KEY_LEN];	/* hash key, must be first */
+	Size		offset;			/* of the DXL in the data area */
+	Size		len;			/* bytes in the data area */
+	bool		compressed;		/* data is a PGLZ_Header and its data */
+	bool		builtin;		/* in the area of built-in objects */
+} SharedMDCacheEntry;
+
+/*
+ * The data area starts with the built-in objects, the entries of the version
+ * fill the rest.
+ */
+typedef struct SharedMDCacheData
+{
+	uint64		version;		/* catalog version of the entries */
+	Size		used;			/* end of the data area in use */
+	Size		size;			/* bytes of the data area */
+	uint64		builtin_generation;	/* bumped when built-in objects change */
+	Size		builtin_used;	/* end of the built-in area in use */
+	Size		builtin_size;	/* bytes of the built-in area */
+	char		data[1];		/* VARIABLE LENGTH ARRAY */
+} SharedMDCacheData;
+
+static SharedMDCacheData *SharedMDCache = NULL;
+static HTAB *SharedMDCacheHash = NULL;
+
+/* Generation of the built-in objects when the catalog version was taken */
+static uint64 builtin_generation_seen = 0;
+
+/* Hash values of the built-in oids in the syscaches, sorted, built on demand */
+typedef struct BuiltinHashValues
+{
+	int			cacheid;
+	uint32	   *hashvalues;
+} BuiltinHashValues;
+
+static BuiltinHashValues builtin_hash_values[] = {
+	{TYPEOID, NULL},
+	{PROCOID, NULL},
+	{OPEROID, NULL},
+	{AGGFNOID, NULL},
+};
+
+static bool
+SharedMDCacheEnabled(void)
+{
+	return Gp_role == GP_ROLE_DISPATCH && optimizer_mdcache_shared_size > 0;
+}
+
+static Size
+SharedMDCacheDataSize(void)
+{
+	return mul_size((Size) optimizer_mdcache_shared_size, 1024);
+}
+
+static long
+SharedMDCacheMaxEntries(void)
+{
+	return Max(SharedMDCacheDataSize() / SHARED_MDCACHE_AVG_ENTRY_SIZE, 1);
+}
+
+/*
+ * SharedMDCacheShmemSize -- estimate size the shared metadata cache will need
+ * in shared memory.
+ */
+Size
+SharedMDCacheShmemSize(void)
+{
+	Size		size;
+
+	if (!SharedMDCacheEnabled())
+		return 0;
+
+	size = add_size(offsetof(SharedMDCacheData, data), SharedMDCacheDataSize());
+	size = add_size(size, hash_estimate_size(SharedMDCacheMaxEntries(),
+											 sizeof(SharedMDCacheEntry)));
+
+	return size;
+}
+
+/*
+ * SharedMDCacheShmemInit -- initialize the shared metadata cache.
+ */
+void
+SharedMDCacheShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (!SharedMDCacheEnabled())
+		return;
+
+	SharedMDCache = (SharedMDCacheData *)
+		ShmemInitStruct("Shared MD Cache Data",
+						add_size(offsetof(SharedMDCacheData, data),
+								 SharedMDCacheDataSize()),
+						&found);
+	if (!found)
+	{
+		SharedMDCache->size = SharedMDCacheDataSize();
+		SharedMDCache->builtin_size =
+			MAXALIGN_DOWN(SharedMDCache->size / SHARED_MDCACHE_BUILTIN_FRACTION);
+		SharedMDCache->builtin_used = 0;
+		SharedMDCache->builtin_generation = 0;
+		SharedMDCache->version = 0;
+		SharedMDCache->used = SharedMDCache->builtin_size;
+	}
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = SHARED_MDCACHE_KEY_LEN;
+	info.entrysize = sizeof(SharedMDCacheEntry);
+
+	SharedMDCacheHash = ShmemInitHash("Shared MD Cache Hash",
+									  SharedMDCacheMaxEntries(),
+									  SharedMDCacheMaxEntries(),
+									  &info,
+									  HASH_ELEM);
+}
+
+/*
+ * SharedMDCacheGetVersion -- catalog version for the objects the caller is
+ * going to look up.
+ *
+ * Pending invalidations are processed after the version is taken, so every
+ * catalog change counted by the version is seen by the caller.
+ */
+uint64
+SharedMDCacheGetVersion(void)
+{
+	uint64		version = SIGetInsertedCount();
+
+	AcceptInvalidationMessages();
+
+	/*
+	 * Built-in objects changed by the invalidations have been dropped, the
+	 * ones the caller stores are discarded if they change again meanwhile.
+	 */
+	if (SharedMDCache != NULL)
+	{
+		LWLockAcquire(SharedMDCacheLock, LW_SHARED);
+		builtin_generation_seen = SharedMDCache->builtin_generation;
+		LWLockRelease(SharedMDCacheLock);
+	}
+
+	return version;
+}
+
+/*
+ * SharedMDCacheLookup -- return a palloc'd copy of the DXL of the object
+ * stored for the key at the version, or as a built-in object, or NULL if
+ * there is none.
+ */
+char *
+SharedMDCacheLookup(uint64 version, const char *key, Size *len)
+{
+	SharedMDCacheEntry *entry;
+	char	   *result = NULL;
+	bool		compressed = false;
+
+	if (SharedMDCache == NULL || strlen(key) >= SHARED_MDCACHE_KEY_LEN)
+		return NULL;
+
+	LWLockAcquire(SharedMDCacheLock, LW_SHARED);
+
+	entry = (SharedMDCacheEntry *) hash_search(SharedMDCacheHash, key,
+											   HASH_FIND, NULL);
+	if (entry != NULL && (entry->builtin || SharedMDCache->version == version))
+	{
+		result = palloc(entry->len);
+		memcpy(result, SharedMDCache->data + entry->offset, entry->len);
+		*len = entry->len;
+		compressed = entry->compressed;
+	}
+
+	LWLockRelease(SharedMDCacheLock);
+
+	if (compressed)
+	{
+		PGLZ_Header *lz = (PGLZ_Header *) result;
+
+		*len = PGLZ_RAW_SIZE(lz);
+		result = palloc(*len);
+		pglz_decompress(lz, result);
+		pfree(lz);
+	}
+
+	return result;
+}
+
+/*
+ * Add an entry for the key, to the area of built-in objects or to that of
+ * the version.  Entries of older versions are dropped first.  Nothing is
+ * stored if a newer version has been stored already, if built-in objects
+ * have changed since the caller took its version, or if the area is full.
+ */
+static void
+SharedMDCacheInsert(uint64 version, bool builtin, const char *key,
+					const char *data, Size len)
+{
+	SharedMDCacheEntry *entry;
+	bool		found;
+	PGLZ_Header *lz = NULL;
+	bool		compressed = false;
+
+	if (SharedMDCache == NULL || strlen(key) >= SHARED_MDCACHE_KEY_LEN)
+		return;
+
+	/* store the DXL compressed, unless it doesn't compress */
+	if (len <= PGLZ_strategy_default->max_input_size)
+	{
+		lz = (PGLZ_Header *) palloc(PGLZ_MAX_OUTPUT(len));
+		if (pglz_compress(data, (int32) len, lz, PGLZ_strategy_default))
+		{
+			data = (const char *) lz;
+			len = VARSIZE(lz);
+			compressed = true;
+		}
+	}
+
+	LWLockAcquire(SharedMDCacheLock, LW_EXCLUSIVE);
+
+	if (!builtin && SharedMDCache->version < version)
+	{
+		HASH_SEQ_STATUS status;
+
+		hash_seq_init(&status, SharedMDCacheHash);
+		while ((entry = (SharedMDCacheEntry *) hash_seq_search(&status)) != NULL)
+		{
+			if (!entry->builtin)
+				hash_search(SharedMDCacheHash, entry->key, HASH_REMOVE, NULL);
+		}
+
+		SharedMDCache->version = version;
+		SharedMDCache->used = SharedMDCache->builtin_size;
+	}
+
+	if ((builtin ? (SharedMDCache->builtin_generation == builtin_generation_seen &&
+					len <= SharedMDCache->builtin_size - SharedMDCache->builtin_used) :
+		 (SharedMDCache->version == version &&
+		  len <= SharedMDCache->size - SharedMDCache->used)) &&
+		hash_get_num_entries(SharedMDCacheHash) < SharedMDCacheMaxEntries())
+	{
+		entry = (SharedMDCacheEntry *) hash_search(SharedMDCacheHash, key,
+												   HASH_ENTER_NULL, &found);
+		if (entry != NULL && !found)
+		{
+			Size	   *used = builtin ? &SharedMDCache->builtin_used : &SharedMDCache->used;
+			Size		end = builtin ? SharedMDCache->builtin_size : SharedMDCache->size;
+
+			entry->offset = *used;
+			entry->len = len;
+			entry->compressed = compressed;
+			entry->builtin = builtin;
+			memcpy(SharedMDCache->data + entry->offset, data, len);
+			*used += MAXALIGN(len);
+			*used = Min(*used, end);
+		}
+	}
+
+	LWLockRelease(SharedMDCacheLock);
+
+	if (lz != NULL)
+		pfree(lz);
+}
+
+/*
+ * SharedMDCacheStore -- store the DXL of the object produced at the version.
+ *
+ * Entries of older versions are dropped first.  Nothing is stored if a newer
+ * version has been stored already, or if the cache is full.
+ */
+void
+SharedMDCacheStore(uint64 version, const char *key, const char *data, Size len)
+{
+	SharedMDCacheInsert(version, false, key, data, len);
+}
+
+/*
+ * SharedMDCacheStoreBuiltin -- store the DXL of a built-in object, which
+ * stays valid for all versions.
+ */
+void
+SharedMDCacheStoreBuiltin(const char *key, const char *data, Size len)
+{
+	SharedMDCacheInsert(0, true, key, data, len);
+}
+
+/*
+ * Drop the built-in objects, and discard the ones being produced.
+ */
+static void
+SharedMDCacheResetBuiltin(void)
+{
+	HASH_SEQ_STATUS status;
+	SharedMDCacheEntry *entry;
+
+	LWLockAcquire(SharedMDCacheLock, LW_EXCLUSIVE);
+
+	hash_seq_init(&status, SharedMDCacheHash);
+	while ((entry = (SharedMDCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		if (entry->builtin)
+			hash_search(SharedMDCacheHash, entry->key, HASH_REMOVE, NULL);
+	}
+
+	SharedMDCache->builtin_used = 0;
+	SharedMDCache->builtin_generation++;
+
+	LWLockRelease(SharedMDCacheLock);
+}
+
+static int
+uint32_cmp(const void *a, const void *b)
+{
+	uint32		va = *(const uint32 *) a;
+	uint32		vb = *(const uint32 *) b;
+
+	if (va != vb)
+		return (va < vb) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Can the invalidation of the syscache be of a built-in object?  Objects are
+ * only known by the hash values of their keys, so those of all the oids below
+ * FirstNormalObjectId are computed, the first time an object of the cache is
+ * invalidated.
+ */
+static bool
+IsBuiltinHashValue(int cacheid, uint32 hashvalue)
+{
+	BuiltinHashValues *values = NULL;
+	int			i;
+
+	for (i = 0; i < lengthof(builtin_hash_values); i++)
+	{
+		if (builtin_hash_values[i].cacheid == cacheid)
+			values = &builtin_hash_values[i];
+	}
+
+	/* the other catalogs are keyed by more than an oid, any change counts */
+	if (values == NULL)
+		return true;
+
+	if (values->hashvalues == NULL)
+	{
+		uint32	   *hashvalues;
+		Oid			oid;
+
+		hashvalues = (uint32 *) MemoryContextAlloc(TopMemoryContext,
+												   FirstNormalObjectId * sizeof(uint32));
+		for (oid = 0; oid < FirstNormalObjectId; oid++)
+			hashvalues[oid] = GetSysCacheHashValue1(cacheid, ObjectIdGetDatum(oid));
+		qsort(hashvalues, FirstNormalObjectId, sizeof(uint32), uint32_cmp);
+
+		values->hashvalues = hashvalues;
+	}
+
+	return bsearch(&hashvalue, values->hashvalues, FirstNormalObjectId,
+				   sizeof(uint32), uint32_cmp) != NULL;
+}
+
+static void
+SharedMDCacheSyscacheCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	if (SharedMDCache == NULL)
+		return;
+
+	/* a zero hash value means all entries of the cache */
+	if (hashvalue == 0 || IsBuiltinHashValue(cacheid, hashvalue))
+		SharedMDCacheResetBuiltin();
+}
+
+/*
+ * InitSharedMDCache -- hook into the invalidations of the catalogs of the
+ * built-in objects, during InitPostgres.
+ *
+ * Every backend does it, so that the command changing a built-in object
+ * drops them as soon as its invalidations are processed, whether or not its
+ * backend uses GPORCA.  Relation invalidations don't matter to them.
+ */
+void
+InitSharedMDCache(void)
+{
+	int			caches[] = {
+		TYPEOID,				/* pg_type */
+		PROCOID,				/* pg_proc */
+		OPEROID,				/* pg_operator */
+		AGGFNOID,				/* pg_aggregate */
+		AMOPOPID,				/* pg_amop */
+		OPFAMILYOID,			/* pg_opfamily */
+		CASTSOURCETARGET,		/* pg_cast */
+	};
+	int			i;
+
+	for (i = 0; i < lengthof(caches); i++)
+		CacheRegisterSyscacheCallback(caches[i], SharedMDCacheSyscacheCallback,
+									  (Datum) 0);
+}
@@ -302,7 +302,17 @@ datumstreamwrite_put(
 					 bool null,
 					 void **toFree)
 {
-	return DatumStreamBlockWrite_Put(&acc->blockWrite, d, null, toFree);
+	int			result;
+
+	result = DatumStreamBlockWrite_Put(&acc->blockWrite, d, null, toFree);
+
+	if (acc->keepZoneMap && result >= 0)
+		AppendOnlyBlockDirectory_ZoneMapAdd(
+			&acc->zoneMap,
+			null ? 0 : AppendOnlyBlockDirectory_ZoneMapValue(acc->typeInfo.typid, d),
+			null);
+
+	return result;
 }
 
 int
@@ -537,6 +547,8 @@ create_datumstreamwrite(
 			sa.comptype = acc->ao_attr.compressType;
 			sa.complevel = acc->ao_attr.compressLevel;
 			sa.blocksize = acc->maxAoBlockSize;
+			sa.relid = attr->attrelid;
+			sa.attnum = attr->attnum;
 
 			compressionState =
 				callCompressionConstructor(
@@ -570,6 +582,10 @@ create_datumstreamwrite(
 	acc->ao_write.verifyWriteCompressionState = verifyBlockCompressionState;
 	acc->title = title;
 
+	acc->keepZoneMap = gp_appendonly_zone_maps &&
+		AppendOnlyBlockDirectory_ZoneMapType(attr->atttypid);
+	acc->zoneMap.flags = ZONEMAP_VALID;
+
 	/*
 	 * Temporarily set the firstRowNum for the block so that we can
 	 * calculate the correct header length.
@@ -616,6 +632,7 @@ create_datumstreamwrite(
 							   acc->datumStreamVersion,
 							   acc->rle_want_compression,
 							   acc->delta_want_compression,
+							   gp_appendonly_dictionary_encoding,
 							   initialMaxDatumPerBlock,
 							   maxDatumPerBlock,
 							   acc->maxAoBlockSize - acc->maxAoHeaderSize,
@@ -674,6 +691,8 @@ create_datumstreamread(
 			sa.comptype = acc->ao_attr.compressType;
 			sa.complevel = acc->ao_attr.compressLevel;
 			sa.blocksize = acc->maxAoBlockSize;
+			sa.relid = attr->attrelid;
+			sa.attnum = attr->attnum;
 
 			compressionState =
 				callCompressionConstructor(
@@ -992,14 +1011,19 @@ datumstreamwrite_block(DatumStreamWrite *acc,
 	}
 
 	/* Insert an entry to the block directory */
-	AppendOnlyBlockDirectory_InsertEntry(
+	AppendOnlyBlockDirectory_InsertEntryWithZoneMap(
 		blockDirectory,
 		columnGroupNo,
 		acc->blockFirstRowNum,
 		AppendOnlyStorageWrite_LogicalBlockStartOffset(&acc->ao_write),
 		itemCount,
+		acc->keepZoneMap ? &acc->zoneMap : NULL,
 		addColAction);
 
+	/* Start the zone map of the next block */
+	MemSet(&acc->zoneMap, 0, sizeof(MinipageZoneMap));
+	acc->zoneMap.flags = ZONEMAP_VALID;
+
 	return writesz;
 }
 
@@ -1414,6 +1438,62 @@ datumstreamread_find(DatumStreamRead * datumStream,
 	Assert(rowNumInBlock == DatumStreamBlockRead_Nth(&datumStream->blockRead));
 }
 
+/*
+ * Skip the rows before rowNum in a sequential scan, without reading the
+ * content of the blocks that only have rows before it. The next
+ * datumstreamread_advance() returns rowNum, or the first row after it if
+ * rowNum doesn't exist. Returns false if there are no rows left in the file.
+ *
+ * If fileOffset isn't -1, it is the offset of a block with first row number
+ * firstRowNum that is at or before the block of rowNum, usually found in the
+ * block directory. Reading then continues from there if the current block is
+ * before it, so not even the headers of the blocks in between are read.
+ *
+ * This only works with blocks that have their first row numbers stored.
+ */
+bool
+datumstreamread_skip_to_row(DatumStreamRead * acc,
+							int64 rowNum,
+							int64 fileOffset,
+							int64 firstRowNum)
+{
+	Assert(acc);
+
+	if (fileOffset >= 0 && fileOffset < acc->eof &&
+		firstRowNum > acc->blockFirstRowNum &&
+		firstRowNum <= rowNum)
+	{
+		AppendOnlyStorageRead_SetTemporaryRange(&acc->ao_read,
+												fileOffset,
+												acc->eof);
+		acc->blockFirstRowNum = firstRowNum;
+		acc->blockRowCount = 0;
+	}
+
+	while (acc->blockFirstRowNum + acc->blockRowCount <= rowNum)
+	{
+		if (!datumstreamread_block_info(acc))
+			return false;
+
+		Assert(acc->getBlockInfo.firstRow >= 0);
+
+		if (acc->blockFirstRowNum + acc->blockRowCount <= rowNum)
+			AppendOnlyStorageRead_SkipCurrentBlock(&acc->ao_read);
+		else
+		{
+			datumstreamread_block_content(acc);
+			if (rowNum <= acc->blockFirstRowNum)
+				return true;
+		}
+	}
+
+	/* rowNum is in the current block, stop at the row before it */
+	if (rowNum > acc->blockFirstRowNum)
+		datumstreamread_find(acc, (int32) (rowNum - acc->blockFirstRowNum - 1));
+
+	return true;
+}
+
 /*
  * Find the block that contains the given row.
  */
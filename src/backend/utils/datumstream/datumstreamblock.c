@@ -13,6 +13,7 @@
  */
 
 #include "postgres.h"
+#include "access/hash.h"
 #include "access/tupmacs.h"
 #include "access/tuptoaster.h"
 #include "utils/datumstreamblock.h"
@@ -42,6 +43,8 @@ static void DatumStreamBlock_IntegrityCheckDense(
 									 void *errdetailArg,
 							 int (*errcontextCallback) (void *errcontextArg),
 									 void *errcontextArg);
+static void DatumStreamBlockRead_GetReadyDictionary(
+										DatumStreamBlockRead * dsr);
 
 /* Proper align with zero padding */
 static inline char *
@@ -609,6 +612,86 @@ DatumStreamBlockRead_ResetDense(DatumStreamBlockRead * dsr)
 
 	dsr->delta_block_was_compressed = false;
 	dsr->delta_item = false;
+
+	dsr->dictionary_block_was_compressed = false;
+	dsr->dictionary_count = 0;
+	dsr->dictionary_code_size = 0;
+	dsr->dictionary_codesp = NULL;
+	dsr->dictionary_code = -1;
+}
+
+/*
+ * Locate the datums of a block with dictionary compression, the items of the
+ * codes.
+ */
+static void
+DatumStreamBlockRead_GetReadyDictionary(DatumStreamBlockRead * dsr)
+{
+	uint8	   *p;
+	int32		i;
+
+	if (dsr->dictionary_count <= 0 ||
+		dsr->dictionary_count > DATUMSTREAM_DICTIONARY_MAXCOUNT ||
+		(dsr->dictionary_code_size != 1 && dsr->dictionary_code_size != 2))
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream dictionary (dictionary count %d, code size %d)",
+						dsr->dictionary_count,
+						dsr->dictionary_code_size),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
+
+	if (dsr->dictionary_items_maxcount < dsr->dictionary_count)
+	{
+		MemoryContext oldCtxt;
+
+		oldCtxt = MemoryContextSwitchTo(dsr->memctxt);
+		if (dsr->dictionary_items != NULL)
+			pfree(dsr->dictionary_items);
+		dsr->dictionary_items_maxcount = dsr->dictionary_count;
+		dsr->dictionary_items =
+			palloc(dsr->dictionary_items_maxcount * sizeof(uint8 *));
+		MemoryContextSwitchTo(oldCtxt);
+	}
+
+	/*
+	 * Walk the datums the same way DatumStreamBlockRead_AdvanceDense walks
+	 * the physical items of other blocks.
+	 */
+	p = dsr->datum_beginp;
+	for (i = 0; i < dsr->dictionary_count; i++)
+	{
+		if (p >= dsr->datum_afterp)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream block read dictionary item %d out of bounds "
+							"(dictionary count %d, physical data size %d)",
+							i,
+							dsr->dictionary_count,
+							dsr->physical_data_size),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+		}
+
+		/*
+		 * Skip any possible zero paddings AFTER previous varlena data.
+		 */
+		if (i > 0 && *p == 0)
+			p = (uint8 *) att_align_nominal(p, dsr->typeInfo.align);
+
+		dsr->dictionary_items[i] = p;
+		p += VARSIZE_ANY(p);
+	}
+
+	if (p > dsr->datum_afterp)
+	{
+		ereport(ERROR,
+				(errmsg("Datum stream block read dictionary items exceed physical data size %d",
+						dsr->physical_data_size),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
 }
 
 void
@@ -630,6 +713,7 @@ DatumStreamBlockRead_GetReadyDense(
 	DatumStreamBlock_Dense *blockDense;
 	DatumStreamBlock_Rle_Extension *rleExtension;
 	DatumStreamBlock_Delta_Extension *deltaExtension;
+	DatumStreamBlock_Dictionary_Extension *dictionaryExtension;
 
 	/*
 	 * PERFORMANCE EXPERIMENT: Only do integrity and trace checking for DEBUG
@@ -718,6 +802,18 @@ DatumStreamBlockRead_GetReadyDense(
 		deltaExtension = NULL;
 	}
 
+	/* Dictionary */
+	dsr->dictionary_block_was_compressed = ((blockDense->orig_4_bytes.flags & DSB_HAS_DICTIONARY_COMPRESSION) != 0);
+	if (dsr->dictionary_block_was_compressed)
+	{
+		dictionaryExtension = (DatumStreamBlock_Dictionary_Extension *) p;
+		p += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+		dsr->dictionary_count = dictionaryExtension->dictionary_count;
+		dsr->dictionary_code_size = dictionaryExtension->code_size;
+	}
+	dsr->dictionary_code = -1;
+
 	/* Set up acc */
 	dsr->nth = -1;				/* put it before first entry.  Caller will
 								 * advance */
@@ -942,6 +1038,29 @@ DatumStreamBlockRead_GetReadyDense(
 					 errcontext_datumstreamblockread(dsr)));
 		}
 	}
+
+	if (dsr->dictionary_block_was_compressed)
+	{
+		/*
+		 * The codes of the physical items follow the rest of the meta-data.
+		 */
+		Assert(dsr->typeInfo.datumlen == -1);
+		Assert(!dsr->delta_block_was_compressed);
+
+		dsr->dictionary_codesp = p;
+		p += dsr->physical_datum_count * dsr->dictionary_code_size;
+
+		unalignedHeaderSize = p - dsr->buffer_beginp;
+		alignedHeaderSize = MAXALIGN(unalignedHeaderSize);
+
+		/*
+		 * Skip over alignment padding.
+		 */
+		dsr->datum_beginp = dsr->buffer_beginp + alignedHeaderSize;
+		dsr->datum_afterp = dsr->datum_beginp + dsr->physical_data_size;
+
+		DatumStreamBlockRead_GetReadyDictionary(dsr);
+	}
 	dsr->datump = dsr->datum_beginp;
 }
 
@@ -3763,6 +3882,159 @@ DatumStreamBlockWrite_BlockOrig(
 	return writesz;
 }
 
+/*
+ * Make the dictionary of the physical items of the block: its distinct items
+ * in dictionary_buffer, and the code of each item in dictionary_codes.
+ *
+ * Returns false if the block would not get smaller with the dictionary.
+ */
+static bool
+DatumStreamBlockWrite_MakeDictionary(
+									 DatumStreamBlockWrite * dsw,
+				   DatumStreamBlock_Dictionary_Extension * dictionary_extension,
+									 int32 * dictionarySize)
+{
+	int32		physicalDataSize;
+	int32		maxCount;
+	int32		hashSize;
+	int32	   *hashTable;
+	uint8	  **items;
+	int32	   *itemLens;
+	int32		count;
+	int32		codeSize;
+	uint8	   *p;
+	uint8	   *dictp;
+	uint8	   *dict_afterp;
+	int32		i;
+	bool		result;
+
+	Assert(dsw->dictionary_want_compression);
+	Assert(dsw->typeInfo->datumlen == -1);
+
+	if (dsw->physical_datum_count < 2)
+		return false;
+
+	physicalDataSize = dsw->datump - dsw->datum_buffer;
+
+	if (dsw->dictionary_codes_maxcount < dsw->physical_datum_count)
+	{
+		MemoryContext oldCtxt;
+
+		oldCtxt = MemoryContextSwitchTo(dsw->memctxt);
+		if (dsw->dictionary_codes != NULL)
+			pfree(dsw->dictionary_codes);
+		dsw->dictionary_codes_maxcount = dsw->physical_datum_count;
+		dsw->dictionary_codes =
+			palloc(dsw->dictionary_codes_maxcount * sizeof(uint16));
+		MemoryContextSwitchTo(oldCtxt);
+	}
+
+	/*
+	 * Open addressing hash table of the distinct items, by code + 1.
+	 */
+	hashSize = 16;
+	while (hashSize < 2 * dsw->physical_datum_count)
+		hashSize <<= 1;
+	hashTable = palloc0(hashSize * sizeof(int32));
+
+	maxCount = Min(dsw->physical_datum_count, DATUMSTREAM_DICTIONARY_MAXCOUNT);
+	items = palloc(maxCount * sizeof(uint8 *));
+	itemLens = palloc(maxCount * sizeof(int32));
+
+	count = 0;
+	result = true;
+	dictp = dsw->dictionary_buffer;
+	dict_afterp = dsw->dictionary_buffer + dsw->datum_buffer_size;
+
+	p = dsw->datum_buffer;
+	for (i = 0; i < dsw->physical_datum_count; i++)
+	{
+		int32		len;
+		uint32		slot;
+
+		/*
+		 * Skip any possible zero paddings AFTER previous varlena data.
+		 */
+		if (i > 0 && *p == 0)
+			p = (uint8 *) att_align_nominal(p, dsw->typeInfo->align);
+
+		len = VARSIZE_ANY(p);
+
+		slot = DatumGetUInt32(hash_any(p, len)) & (hashSize - 1);
+		while (hashTable[slot] != 0)
+		{
+			int32		code = hashTable[slot] - 1;
+
+			if (itemLens[code] == len && memcmp(items[code], p, len) == 0)
+				break;
+			slot = (slot + 1) & (hashSize - 1);
+		}
+
+		if (hashTable[slot] == 0)
+		{
+			/*
+			 * New distinct item, stored aligned like the items are.
+			 */
+			if (count >= maxCount)
+			{
+				result = false;
+				break;
+			}
+
+			if (!VARATT_IS_1B(p))
+			{
+				if ((uint8 *) att_align_nominal(dictp, dsw->typeInfo->align) + len > dict_afterp)
+				{
+					result = false;
+					break;
+				}
+				dictp = (uint8 *) att_align_zero((char *) dictp, dsw->typeInfo->align);
+			}
+			else if (dictp + len > dict_afterp)
+			{
+				result = false;
+				break;
+			}
+
+			memcpy(dictp, p, len);
+			dictp += len;
+
+			items[count] = p;
+			itemLens[count] = len;
+			hashTable[slot] = ++count;
+		}
+
+		dsw->dictionary_codes[i] = (uint16) (hashTable[slot] - 1);
+		p += len;
+	}
+
+	pfree(hashTable);
+	pfree(items);
+	pfree(itemLens);
+
+	if (!result)
+		return false;
+
+	Assert(p == dsw->datump);
+
+	codeSize = (count <= 0x100 ? 1 : 2);
+
+	/*
+	 * The worst case alignment padding of the meta-data is charged too, so
+	 * that the block never gets larger.
+	 */
+	if (sizeof(DatumStreamBlock_Dictionary_Extension) +
+		codeSize * dsw->physical_datum_count +
+		(dictp - dsw->dictionary_buffer) + MAXIMUM_ALIGNOF > physicalDataSize)
+		return false;
+
+	dictionary_extension->dictionary_count = count;
+	dictionary_extension->code_size = codeSize;
+	*dictionarySize = dictp - dsw->dictionary_buffer;
+
+	return true;
+}
+
 static int64
 DatumStreamBlockWrite_BlockDense(
 								 DatumStreamBlockWrite * dsw,
@@ -3773,10 +4045,14 @@ DatumStreamBlockWrite_BlockDense(
 	DatumStreamBlock_Dense dense;
 	DatumStreamBlock_Rle_Extension rle_extension;
 	DatumStreamBlock_Delta_Extension delta_extension;
+	DatumStreamBlock_Dictionary_Extension dictionary_extension;
+	bool		dictionary_has_compression;
+	int32		dictionarySize = 0;
 	int32		headerSize;
 	int32		nullSize;
 	int32		rleSize;
 	int32		deltaSize;
+	int32		dictionaryCodesSize;
 	int32		metadataSize;
 	int32		metadataMaxAlignSize;
 	int32		nullPadSize;
@@ -3814,6 +4090,16 @@ DatumStreamBlockWrite_BlockDense(
 		dense.orig_4_bytes.flags |= DSB_HAS_DELTA_COMPRESSION;
 	}
 
+	dictionary_has_compression =
+		(dsw->dictionary_want_compression &&
+		 DatumStreamBlockWrite_MakeDictionary(dsw,
+											  &dictionary_extension,
+											  &dictionarySize));
+	if (dictionary_has_compression)
+	{
+		dense.orig_4_bytes.flags |= DSB_HAS_DICTIONARY_COMPRESSION;
+	}
+
 	dense.logical_row_count = dsw->nth;
 	dense.physical_datum_count = dsw->physical_datum_count;
 	dense.physical_data_size = dsw->datump - dsw->datum_buffer;
@@ -3915,10 +4201,31 @@ DatumStreamBlockWrite_BlockDense(
 		deltaSize = 0;
 	}
 
+	/*
+	 * Add in extra DatumStreamBlock_Dictionary struct and codes, the datums
+	 * become the distinct items.
+	 */
+	if (dictionary_has_compression)
+	{
+		headerSize += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+		dictionaryCodesSize =
+			dictionary_extension.code_size * dsw->physical_datum_count;
+
+		dsw->savings += dense.physical_data_size - dictionarySize -
+			(sizeof(DatumStreamBlock_Dictionary_Extension) + dictionaryCodesSize);
+
+		dense.physical_data_size = dictionarySize;
+	}
+	else
+	{
+		dictionaryCodesSize = 0;
+	}
+
 	/*
 	 * Align headers and meta-data (e.g. NULL bit-maps, etc).
 	 */
-	metadataSize = headerSize + nullSize + rleSize + deltaSize;
+	metadataSize = headerSize + nullSize + rleSize + deltaSize + dictionaryCodesSize;
 	metadataMaxAlignSize = MAXALIGN(metadataSize);
 
 	memcpy(p, &dense, sizeof(DatumStreamBlock_Dense));
@@ -3936,6 +4243,12 @@ DatumStreamBlockWrite_BlockDense(
 		p += sizeof(DatumStreamBlock_Delta_Extension);
 	}
 
+	if (dictionary_has_compression)
+	{
+		memcpy(p, &dictionary_extension, sizeof(DatumStreamBlock_Dictionary_Extension));
+		p += sizeof(DatumStreamBlock_Dictionary_Extension);
+	}
+
 	if (dsw->has_null)
 	{
 		memcpy(p, dsw->null_bitmap_buffer, DatumStreamBitMapWrite_Size(&dsw->null_bitmap));
@@ -3999,6 +4312,19 @@ DatumStreamBlockWrite_BlockDense(
 		}
 	}
 
+	/* Add dictionary codes */
+	if (dictionary_has_compression)
+	{
+		int			i;
+
+		for (i = 0; i < dsw->physical_datum_count; i++)
+		{
+			*(p++) = dsw->dictionary_codes[i] & 0xFF;
+			if (dictionary_extension.code_size == 2)
+				*(p++) = dsw->dictionary_codes[i] >> 8;
+		}
+	}
+
 	/*
 	 * Were our meta-data size calculations correct?
 	 */
@@ -4040,7 +4366,9 @@ DatumStreamBlockWrite_BlockDense(
 				 errcontext_datumstreamblockwrite(dsw)));
 	}
 
-	memcpy(p, dsw->datum_buffer, dense.physical_data_size);
+	memcpy(p,
+		   (dictionary_has_compression ? dsw->dictionary_buffer : dsw->datum_buffer),
+		   dense.physical_data_size);
 	p += dense.physical_data_size;
 
 	/* Calculate write size. */
@@ -4174,6 +4502,18 @@ DatumStreamBlockWrite_BlockDense(
 					 errdetail_datumstreamblockwrite(dsw),
 					 errcontext_datumstreamblockwrite(dsw)));
 		}
+
+		if (dictionary_has_compression)
+		{
+			ereport(LOG,
+					(errmsg("Datum stream write Dense block formatted RLE_TYPE with DICTIONARY compression "
+							"(dictionary count %d, code size %d, dictionary size %d)",
+							dictionary_extension.dictionary_count,
+							dictionary_extension.code_size,
+							dictionarySize),
+					 errdetail_datumstreamblockwrite(dsw),
+					 errcontext_datumstreamblockwrite(dsw)));
+		}
 	}
 
 #ifdef USE_ASSERT_CHECKING
@@ -4234,6 +4574,7 @@ DatumStreamBlockWrite_Init(
 						   DatumStreamVersion datumStreamVersion,
 						   bool rle_want_compression,
 						   bool delta_want_compression,
+						   bool dictionary_want_compression,
 						   int32 initialMaxDatumPerBlock,
 						   int32 maxDatumPerBlock,
 						   int32 maxDataBlockSize,
@@ -4251,6 +4592,17 @@ DatumStreamBlockWrite_Init(
 	dsw->rle_want_compression = rle_want_compression;
 	dsw->delta_want_compression = delta_want_compression;
 
+	/*
+	 * Dictionary compression is only done for variable-length items of
+	 * RLE_TYPE compressed blocks.
+	 */
+	dsw->dictionary_want_compression =
+		(dictionary_want_compression &&
+		 rle_want_compression &&
+		 !delta_want_compression &&
+		 datumStreamVersion == DatumStreamVersion_Dense_Enhanced &&
+		 typeInfo->datumlen == -1);
+
 	dsw->initialMaxDatumPerBlock = initialMaxDatumPerBlock;
 	dsw->maxDatumPerBlock = maxDatumPerBlock;
 
@@ -4398,6 +4750,15 @@ DatumStreamBlockWrite_Init(
 				Assert(dsw->delta_sign == NULL);
 			}
 
+			if (dsw->dictionary_want_compression)
+			{
+				/*
+				 * The distinct items never take more space than the items.
+				 * The codes buffer is sized when the block is formatted.
+				 */
+				dsw->dictionary_buffer = palloc(dsw->datum_buffer_size);
+			}
+
 			if (Debug_appendonly_print_insert)
 			{
 				ereport(LOG,
@@ -4460,6 +4821,12 @@ DatumStreamBlockWrite_Finish(
 	if (dsw->delta_sign != NULL)
 		pfree(dsw->delta_sign);
 
+	if (dsw->dictionary_buffer != NULL)
+		pfree(dsw->dictionary_buffer);
+
+	if (dsw->dictionary_codes != NULL)
+		pfree(dsw->dictionary_codes);
+
 	MemoryContextSwitchTo(oldCtxt);
 }
 
@@ -4876,6 +5243,82 @@ DatumStreamBlock_IntegrityCheckDenseDelta(
 	}
 }
 
+/*
+ * Verify the dictionary extension and the codes at p, which is headerSize
+ * bytes into the block.
+ */
+static void
+DatumStreamBlock_IntegrityCheckDenseDictionary(
+				   DatumStreamBlock_Dictionary_Extension * dictionaryExtension,
+											   uint8 * p,
+											   int32 bufferSize,
+											   int32 headerSize,
+											   int32 physicalDatumCount,
+											   int32 physicalDataSize,
+							   int (*errdetailCallback) (void *errdetailArg),
+											   void *errdetailArg,
+							 int (*errcontextCallback) (void *errcontextArg),
+											   void *errcontextArg)
+{
+	int32		codesSize;
+	int32		i;
+
+	if (dictionaryExtension->dictionary_count <= 0 ||
+		dictionaryExtension->dictionary_count > physicalDatumCount ||
+		dictionaryExtension->dictionary_count > physicalDataSize ||
+		dictionaryExtension->dictionary_count > DATUMSTREAM_DICTIONARY_MAXCOUNT)
+	{
+		ereport(ERROR,
+				(errmsg("DICTIONARY count %d is expected to be greater than 0 and at most the physical datum count %d",
+						dictionaryExtension->dictionary_count,
+						physicalDatumCount),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	if (dictionaryExtension->code_size != 1 && dictionaryExtension->code_size != 2)
+	{
+		ereport(ERROR,
+				(errmsg("DICTIONARY code size %d is expected to be 1 or 2",
+						dictionaryExtension->code_size),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	codesSize = dictionaryExtension->code_size * physicalDatumCount;
+	if (bufferSize < MAXALIGN(headerSize + codesSize) + physicalDataSize)
+	{
+		ereport(ERROR,
+				(errmsg("Expected DICTIONARY header size %d including codes and physical data size %d is larger than buffer size %d",
+						(int) MAXALIGN(headerSize + codesSize),
+						physicalDataSize,
+						bufferSize),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	for (i = 0; i < physicalDatumCount; i++)
+	{
+		int32		code;
+
+		if (dictionaryExtension->code_size == 1)
+			code = p[i];
+		else
+			code = p[2 * i] | (p[2 * i + 1] << 8);
+
+		if (code >= dictionaryExtension->dictionary_count)
+		{
+			ereport(ERROR,
+					(errmsg("DICTIONARY code %d of physical item %d is out of range (dictionary count %d)",
+							code,
+							i,
+							dictionaryExtension->dictionary_count),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+	}
+}
+
 static void
 DatumStreamBlock_IntegrityCheckDense(
 									 uint8 * buffer,
@@ -4898,14 +5341,17 @@ DatumStreamBlock_IntegrityCheckDense(
 	bool		hasNull;
 	bool		hasRleCompression;
 	bool		hasDeltaCompression;
+	bool		hasDictionaryCompression;
 
 	int32		alignedHeaderSize;
 	int32		deltaOnCount;
 	DatumStreamBlock_Delta_Extension *deltaExtension;
 	DatumStreamBlock_Rle_Extension *rleExtension;
+	DatumStreamBlock_Dictionary_Extension *dictionaryExtension;
 
 	deltaExtension = NULL;
 	rleExtension = NULL;
+	dictionaryExtension = NULL;
 
 	alignedHeaderSize = 0;
 
@@ -4944,6 +5390,19 @@ DatumStreamBlock_IntegrityCheckDense(
 	hasNull = ((blockDense->orig_4_bytes.flags & DSB_HAS_NULLBITMAP) != 0);
 	hasRleCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_RLE_COMPRESSION) != 0);
 	hasDeltaCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_DELTA_COMPRESSION) != 0);
+	hasDictionaryCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_DICTIONARY_COMPRESSION) != 0);
+
+	if (hasDictionaryCompression &&
+		(hasDeltaCompression || typeInfo->datumlen != -1))
+	{
+		ereport(ERROR,
+				(errmsg("Datum stream Dense block has DICTIONARY compression with DELTA compression or fixed-length items "
+						"(flags 0x%x, datum length %d)",
+						blockDense->orig_4_bytes.flags,
+						typeInfo->datumlen),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
 
 	/*
 	 * Verify logical row count.
@@ -5020,8 +5479,11 @@ DatumStreamBlock_IntegrityCheckDense(
 
 		/*
 		 * This check will make it safer to do multiplication of datum count and datum length.
+		 *
+		 * The datums of a block with DICTIONARY compression are only its distinct items.
 		 */
-		if (blockDense->physical_datum_count > blockDense->physical_data_size)
+		if (!hasDictionaryCompression &&
+			blockDense->physical_datum_count > blockDense->physical_data_size)
 		{
 			ereport(ERROR,
 					(errmsg("More physical items %d than physical bytes %d",
@@ -5095,6 +5557,24 @@ DatumStreamBlock_IntegrityCheckDense(
 		}
 		total_datum_count = blockDense->physical_datum_count + deltaOnCount;
 
+		if (hasDictionaryCompression)
+		{
+			headerSize += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+			if (bufferSize < headerSize)
+			{
+				ereport(ERROR,
+						(errmsg("Bad datum stream DICTIONARY block header extension size. Found %d and expected the size to be at least %d",
+								bufferSize,
+								headerSize),
+						 errdetailCallback(errdetailArg),
+						 errcontextCallback(errcontextArg)));
+			}
+
+			dictionaryExtension = (DatumStreamBlock_Dictionary_Extension *) p;
+			p += sizeof(DatumStreamBlock_Dictionary_Extension);
+		}
+
 		if (!hasNull)
 		{
 			alignedHeaderSize = MAXALIGN(headerSize);
@@ -5268,6 +5748,24 @@ DatumStreamBlock_IntegrityCheckDense(
 			p += sizeof(DatumStreamBlock_Delta_Extension);
 		}
 
+		if (hasDictionaryCompression)
+		{
+			headerSize += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+			if (bufferSize < headerSize)
+			{
+				ereport(ERROR,
+						(errmsg("Bad datum stream RLE_TYPE DICTIONARY block header extension size. Found %d and expected the size to be at least %d",
+								bufferSize,
+								headerSize),
+						 errdetailCallback(errdetailArg),
+						 errcontextCallback(errcontextArg)));
+			}
+
+			dictionaryExtension = (DatumStreamBlock_Dictionary_Extension *) p;
+			p += sizeof(DatumStreamBlock_Dictionary_Extension);
+		}
+
 		if (!hasNull)
 		{
 			actualNullOnCount = 0;
@@ -5432,13 +5930,35 @@ DatumStreamBlock_IntegrityCheckDense(
 												  errcontextArg);
 	}
 
+	if (hasDictionaryCompression)
+	{
+		DatumStreamBlock_IntegrityCheckDenseDictionary(
+													   dictionaryExtension,
+													   p,
+													   bufferSize,
+													   headerSize,
+										  blockDense->physical_datum_count,
+											 blockDense->physical_data_size,
+													   errdetailCallback,
+													   errdetailArg,
+													   errcontextCallback,
+													   errcontextArg);
+
+		/*
+		 * The datums follow the codes.
+		 */
+		headerSize += dictionaryExtension->code_size * blockDense->physical_datum_count;
+		alignedHeaderSize = MAXALIGN(headerSize);
+	}
+
 	if (typeInfo->datumlen == -1)
 	{
 		/*
 		 * Variable-length items.
 		 */
+		int32		varlenaCount;
 
-		DatumStreamBlock_IntegrityCheckVarlena(
+		varlenaCount = DatumStreamBlock_IntegrityCheckVarlena(
 											   buffer + alignedHeaderSize,
 											   blockDense->physical_data_size,
 											blockDense->orig_4_bytes.version,
@@ -5447,6 +5967,17 @@ DatumStreamBlock_IntegrityCheckDense(
 											   errdetailArg,
 											   errcontextCallback,
 											   errcontextArg);
+
+		if (hasDictionaryCompression &&
+			varlenaCount != dictionaryExtension->dictionary_count)
+		{
+			ereport(ERROR,
+					(errmsg("DICTIONARY item count does not match.  Found %d, expected %d",
+							varlenaCount,
+							dictionaryExtension->dictionary_count),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
 	}
 }
 
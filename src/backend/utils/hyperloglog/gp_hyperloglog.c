@@ -1070,6 +1070,7 @@ PG_FUNCTION_INFO_V1(gp_hyperloglog_add_item_agg_default);
 
 PG_FUNCTION_INFO_V1(gp_hyperloglog_merge);
 PG_FUNCTION_INFO_V1(gp_hyperloglog_get_estimate);
+PG_FUNCTION_INFO_V1(gp_hyperloglog_get_count);
 
 PG_FUNCTION_INFO_V1(gp_hyperloglog_in);
 PG_FUNCTION_INFO_V1(gp_hyperloglog_out);
@@ -1080,6 +1081,7 @@ PG_FUNCTION_INFO_V1(gp_hyperloglog_comp);
 extern Datum gp_hyperloglog_add_item_agg_default(PG_FUNCTION_ARGS);
 
 extern Datum gp_hyperloglog_get_estimate(PG_FUNCTION_ARGS);
+extern Datum gp_hyperloglog_get_count(PG_FUNCTION_ARGS);
 extern Datum gp_hyperloglog_merge(PG_FUNCTION_ARGS);
 
 extern Datum gp_hyperloglog_in(PG_FUNCTION_ARGS);
@@ -1193,6 +1195,20 @@ gp_hyperloglog_get_estimate(PG_FUNCTION_ARGS)
 	PG_RETURN_FLOAT8(estimate);
 }
 
+Datum
+gp_hyperloglog_get_count(PG_FUNCTION_ARGS)
+{
+	double estimate;
+	GpHLLCounter hyperloglog = PG_GETARG_HLL_P_COPY(0);
+
+	estimate = gp_hyperloglog_estimate(hyperloglog);
+
+	pfree(hyperloglog);
+
+	/* the final function of approx_count_distinct() */
+	PG_RETURN_INT64((int64) rint(estimate));
+}
+
 Datum
 gp_hyperloglog_out(PG_FUNCTION_ARGS)
 {
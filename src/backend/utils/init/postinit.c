@@ -67,6 +67,7 @@
 #include "utils/ps_status.h"
 #include "utils/relcache.h"
 #include "utils/resscheduler.h"
+#include "utils/sharedmdcache.h"
 #include "utils/sharedsnapshot.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
@@ -696,6 +697,7 @@ InitPostgres(const char *in_dbname, Oid dboid, const char *username,
 	RelationCacheInitialize();
 	InitCatalogCache();
 	InitPlanCache();
+	InitSharedMDCache();
 
 	/* Initialize portal manager */
 	EnablePortalManager();
@@ -240,6 +240,116 @@ static int bz_file_open(gfile_t *fd)
 }
 #endif
 
+#ifdef HAVE_LIBZSTD
+/* ZSTD */
+struct zstdlib_stuff
+{
+	ZSTD_DCtx  *dctx;
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	size_t		out_pos;
+	size_t		hint;			/* 0 once a frame has been decoded and flushed */
+	int			eof;
+	char		in_buf[COMPRESSION_BUFFER_SIZE];
+	char		out_buf[COMPRESSION_BUFFER_SIZE];
+};
+
+static ssize_t
+zstd_file_read(gfile_t *fd, void *ptr, size_t len)
+{
+	struct zstdlib_stuff *z = fd->u.zstd;
+
+	for (;;)
+	{
+		ssize_t		s = z->out.pos - z->out_pos;
+		int			flushed = z->out.pos < z->out.size;
+
+		if (s > 0 || z->eof)
+		{
+			if (s > len)
+				s = len;
+			memcpy(ptr, z->out_buf + z->out_pos, s);
+			z->out_pos += s;
+
+			return s;
+		}
+
+		z->out.pos = 0;
+		z->out_pos = 0;
+
+		/*
+		 * read more input only once the decoder has no output left for the
+		 * input it has, i.e. when it didn't fill the whole output buffer
+		 */
+		if (z->in.pos == z->in.size && flushed)
+		{
+			s = read_and_retry(fd, z->in_buf, sizeof z->in_buf);
+			if (s < 0)
+				return -1;
+
+			if (s == 0)
+			{
+				/* a file may hold several frames, the last must be complete */
+				if (z->hint != 0)
+				{
+					gfile_printf_then_putc_newline("zstd file is truncated");
+					return -1;
+				}
+				z->eof = 1;
+				continue;
+			}
+
+			z->in.size = s;
+			z->in.pos = 0;
+		}
+
+		z->hint = ZSTD_decompressStream(z->dctx, &z->out, &z->in);
+		if (ZSTD_isError(z->hint))
+		{
+			gfile_printf_then_putc_newline("ZSTD_decompressStream failed: %s",
+										   ZSTD_getErrorName(z->hint));
+			return -1;
+		}
+	}
+}
+
+static int
+zstd_file_close(gfile_t *fd)
+{
+	ZSTD_freeDCtx(fd->u.zstd->dctx);
+	gfile_free(fd->u.zstd);
+
+	return 0;
+}
+
+static int
+zstd_file_open(gfile_t *fd)
+{
+	if (!(fd->u.zstd = gfile_malloc(sizeof *fd->u.zstd)))
+	{
+		gfile_printf_then_putc_newline("Out of memory");
+		return 1;
+	}
+
+	memset(fd->u.zstd, 0, sizeof *fd->u.zstd);
+
+	if (!(fd->u.zstd->dctx = ZSTD_createDCtx()))
+	{
+		gfile_printf_then_putc_newline("ZSTD_createDCtx failed");
+		gfile_free(fd->u.zstd);
+		return 1;
+	}
+
+	fd->u.zstd->in.src = fd->u.zstd->in_buf;
+	fd->u.zstd->out.dst = fd->u.zstd->out_buf;
+	fd->u.zstd->out.size = sizeof fd->u.zstd->out_buf;
+	fd->read = zstd_file_read;
+	fd->close = zstd_file_close;
+
+	return 0;
+}
+#endif
+
 #ifdef HAVE_LIBZ
 /* GZ */
 struct zlib_stuff
@@ -979,6 +1089,18 @@ int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, co
 			gfile_printf_then_putc_newline(".bz2 not yet supported for writable tables");
 
 		return bz_file_open(fd);
+#endif
+	}
+	else if (s && strcasecmp(s,".zst")==0)
+	{
+#ifndef HAVE_LIBZSTD
+		gfile_printf_then_putc_newline(".zst not supported");
+#else
+		fd->compression = ZSTD_COMPRESSION;
+		if (flags != GFILE_OPEN_FOR_READ)
+			gfile_printf_then_putc_newline(".zst not yet supported for writable tables");
+
+		return zstd_file_open(fd);
 #endif
 	}
 	else if (s && strcasecmp(s,".z") == 0)
@@ -1014,7 +1136,8 @@ gfile_close(gfile_t*fd)
 		 * for the compressed data implementation we need to call the "close" callback. Other implementations
 		 * didn't use to call this callback here and it will remain so.
 		 */
-		if (  fd->compression == GZ_COMPRESSION ) 
+		if (  fd->compression == GZ_COMPRESSION ||
+			  fd->compression == ZSTD_COMPRESSION )
 		{
 			fd->close(fd);
 		}
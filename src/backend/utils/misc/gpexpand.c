@@ -14,6 +14,7 @@
 #include "postgres.h"
 
 #include "catalog/gp_configuration_history.h"
+#include "catalog/gp_optimizer_cost_params.h"
 #include "catalog/pg_auth_time_constraint.h"
 #include "catalog/pg_description.h"
 #include "catalog/pg_namespace.h"
@@ -126,6 +127,7 @@ gp_expand_protect_catalog_changes(Relation relation)
 	{
 		case GpSegmentConfigRelationId:
 		case GpConfigHistoryRelationId:
+		case GpOptimizerCostParamsRelationId:
 		case DescriptionRelationId:
 		case PartitionRelationId:
 		case PartitionRuleRelationId:
@@ -3642,6 +3642,8 @@ static bool reporting_enabled;	/* TRUE to enable GUC_REPORT */
 
 static int	GUCNestLevel = 0;	/* 1 when in main transaction */
 
+static uint64 guc_generation = 0;	/* bumped whenever a value changes */
+
 
 static int	guc_var_compare(const void *a, const void *b);
 static int	guc_name_compare(const char *namea, const char *nameb);
@@ -4794,6 +4796,7 @@ ResetAllOptions(void)
 
 		gconf->source = gconf->reset_source;
 		gconf->scontext = gconf->reset_scontext;
+		guc_generation++;
 
 		if (gconf->flags & GUC_REPORT)
 			ReportGUCOption(gconf);
@@ -5180,6 +5183,9 @@ AtEOXact_GUC(bool isCommit, int nestLevel)
 			gconf->stack = prev;
 			pfree(stack);
 
+			if (changed)
+				guc_generation++;
+
 			/* Report new value if we changed it */
 			if (changed && (gconf->flags & GUC_REPORT))
 				ReportGUCOption(gconf);
@@ -6520,6 +6526,9 @@ set_config_option(const char *name, const char *value,
 			}
 	}
 
+	if (changeVal)
+		guc_generation++;
+
 	if (changeVal && (record->flags & GUC_REPORT))
 		ReportGUCOption(record);
 
@@ -8348,6 +8357,26 @@ GetNumConfigOptions(void)
 	return num_guc_variables;
 }
 
+/*
+ * Return a counter that changes whenever the value of a GUC variable may have
+ * changed, for caches of values derived from them
+ */
+uint64
+GetConfigGeneration(void)
+{
+	return guc_generation;
+}
+
+/*
+ * Advance the counter returned by GetConfigGeneration, for code that assigns
+ * a GUC variable directly rather than through set_config_option
+ */
+void
+AdvanceConfigGeneration(void)
+{
+	guc_generation++;
+}
+
 /*
  * show_config_by_name - equiv to SHOW X command but implemented as
  * a function.
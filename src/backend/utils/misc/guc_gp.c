@@ -77,6 +77,7 @@ static bool check_verify_gpfdists_cert(bool *newval, void **extra, GucSource sou
 static bool check_dispatch_log_stats(bool *newval, void **extra, GucSource source);
 static bool check_gp_hashagg_default_nbatches(int *newval, void **extra, GucSource source);
 static bool check_gp_workfile_compression(bool *newval, void **extra, GucSource source);
+static bool check_gp_interconnect_compression(bool *newval, void **extra, GucSource source);
 
 /* Helper function for guc setter */
 bool gpvars_check_gp_resqueue_priority_default_value(char **newval,
@@ -96,6 +97,7 @@ extern struct config_generic *find_option(const char *name, bool create_placehol
 extern bool enable_partition_rules;
 
 extern int listenerBacklog;
+extern int tcpConnectionPoolSize;
 
 /* GUC lists for gp_guc_list_show().  (List of struct config_generic) */
 List	   *gp_guc_list_for_explain;
@@ -132,6 +134,10 @@ bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_compaction = true;
 int			gp_appendonly_compaction_threshold = 0;
+int			gp_appendonly_read_ahead = 0;
+bool		gp_appendonly_dictionary_encoding = false;
+bool		gp_appendonly_late_materialization = true;
+bool		gp_appendonly_bulk_load = false;
 bool		gp_heap_require_relhasoids_match = true;
 bool		gp_local_distributed_cache_stats = false;
 bool		debug_xlog_record_read = false;
@@ -172,6 +178,8 @@ bool		Debug_dtm_action_primary = DEBUG_DTM_ACTION_PRIMARY_DEFAULT;
 
 bool		gp_log_optimization_time = false;
 
+bool		gp_replan_when_idle = false;
+
 int			Debug_dtm_action = DEBUG_DTM_ACTION_NONE;
 
 #define DEBUG_DTM_ACTION_TARGET_DEFAULT DEBUG_DTM_ACTION_TARGET_NONE
@@ -268,6 +276,10 @@ bool		gp_enable_multiphase_agg = true;
 bool		gp_enable_preunique = TRUE;
 bool		gp_eager_preunique = FALSE;
 bool		gp_hashagg_streambottom = true;
+double		gp_hashagg_passthrough_ratio = 0.9;
+double		gp_motion_skew_threshold = 0;
+int			gp_broadcast_cache_relations = 0;
+int			gp_broadcast_cache_size = 16384;
 bool		gp_enable_agg_distinct = true;
 bool		gp_enable_dqa_pruning = true;
 bool		gp_eager_dqa_pruning = FALSE;
@@ -279,6 +291,8 @@ bool		gp_dynamic_partition_pruning = true;
 bool		gp_log_dynamic_partition_pruning = false;
 bool		gp_cte_sharing = false;
 bool		gp_enable_relsize_collection = false;
+bool		gp_enable_subplan_cache = true;
+bool		gp_enable_nestloop_cache = true;
 bool		gp_recursive_cte = true;
 
 /* Optimizer related gucs */
@@ -291,7 +305,17 @@ bool		optimizer_partition_selection_log;
 int			optimizer_minidump;
 int			optimizer_cost_model;
 bool		optimizer_metadata_caching;
+bool		optimizer_prefetch_metadata;
 int			optimizer_mdcache_size;
+int			optimizer_mdcache_shared_size;
+int			optimizer_max_concurrent_optimizations;
+int			optimizer_plan_cache_size;
+int			optimizer_plan_baselines;
+bool		optimizer_cardinality_feedback;
+bool		optimizer_plan_trace;
+int			optimizer_search_time_budget;
+int			optimizer_capture_threshold;
+int			optimizer_memory_limit;
 bool		optimizer_use_gpdb_allocators;
 
 /* Optimizer debugging GUCs */
@@ -340,6 +364,18 @@ bool		optimizer_enable_dml;
 bool		optimizer_enable_dml_triggers;
 bool		optimizer_enable_dml_constraints;
 bool		optimizer_enable_master_only_queries;
+bool		optimizer_enable_partition_wise_join;
+bool		optimizer_enable_partition_merge_append;
+bool		optimizer_enable_matview_rewrite;
+bool		optimizer_enable_indexonlyscan;
+bool		optimizer_enable_incremental_sort;
+bool		optimizer_enable_hashjoin_skew;
+bool		optimizer_enable_common_subexpressions;
+bool		optimizer_enable_dependency_damping;
+bool		optimizer_enable_hashed_subplans;
+bool		optimizer_enable_rollup_agg;
+bool		optimizer_enable_shared_subqueries;
+bool		optimizer_enable_shared_window_sort;
 bool		optimizer_enable_hashjoin;
 bool		optimizer_enable_dynamictablescan;
 bool		optimizer_enable_indexscan;
@@ -370,11 +406,16 @@ int			optimizer_penalize_broadcast_threshold;
 double		optimizer_cost_threshold;
 double		optimizer_nestloop_factor;
 double		optimizer_sort_factor;
+double		optimizer_compressed_motion_cost_factor;
+double		optimizer_hashagg_cost_factor;
+double		optimizer_cte_sharing_cost_factor;
+double		optimizer_intra_host_motion_cost_factor;
 
 /* Optimizer hints */
 int			optimizer_join_arity_for_associativity_commutativity;
 int         optimizer_array_expansion_threshold;
 int         optimizer_join_order_threshold;
+int			optimizer_join_search_budget;
 int			optimizer_join_order;
 int			optimizer_cte_inlining_bound;
 int			optimizer_push_group_by_below_setop_threshold;
@@ -399,6 +440,7 @@ bool		optimizer_enable_eageragg;
 /* Analyze related GUCs for Optimizer */
 bool		optimizer_analyze_root_partition;
 bool		optimizer_analyze_midlevel_partition;
+bool		optimizer_analyze_changed_partitions_only;
 
 /* GUCs for replicated table */
 bool		optimizer_replicated_table_insert;
@@ -412,6 +454,7 @@ static char *gp_server_version_string;
 
 /* Query Metrics */
 bool		gp_enable_query_metrics = false;
+int			gp_explain_timing_sample_rate = 1;
 int			gp_instrument_shmem_size = 5120;
 
 /* Security */
@@ -419,6 +462,7 @@ bool		gp_reject_internal_tcp_conn = true;
 
 /* copy */
 bool		gp_enable_segment_copy_checking = true;
+bool		gp_enable_segment_copy_parsing = true;
 /*
  * Default storage options GUC.  Value is comma-separated name=value
  * pairs.  E.g. "appendonly=true,orientation=column"
@@ -428,10 +472,14 @@ char	   *gp_default_storage_options = NULL;
 int			writable_external_table_bufsize = 64;
 
 bool		gp_external_enable_filter_pushdown = true;
+bool		gp_external_enable_agg_pushdown = true;
+double		gp_external_analyze_sample_fraction = 1.0;
+double		gp_external_scan_sample_fraction = 1.0;
 
 /* Executor */
 bool		gp_enable_mk_sort = true;
 bool		gp_enable_motion_mk_sort = true;
+bool		gp_materialize_compression = true;
 
 /* Enable GDD */
 bool		gp_enable_global_deadlock_detector = false;
@@ -536,6 +584,7 @@ static const struct config_enum_entry gp_resqueue_memory_policies[] = {
 	{"none", RESMANAGER_MEMORY_POLICY_NONE},
 	{"auto", RESMANAGER_MEMORY_POLICY_AUTO},
 	{"eager_free", RESMANAGER_MEMORY_POLICY_EAGER_FREE},
+	{"estimate", RESMANAGER_MEMORY_POLICY_ESTIMATE},
 	{NULL, 0}
 };
 
@@ -654,6 +703,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_enable_qe_plan_cache", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable the QEs to keep the last plans they received deserialized."),
+			gettext_noop("A plan received again, like that of a prepared statement, is copied instead of read again."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_enable_qe_plan_cache,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_predicate_propagation", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("When two expressions are equivalent (such as with "
@@ -1037,6 +1096,50 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_bulk_load", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Skip the WAL record of every write to append-only segment files created in the same transaction."),
+			gettext_noop("The completed segment files are logged for the mirror in large records when they are closed."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_bulk_load,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_dictionary_encoding", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Dictionary encode the variable-length columns of column-oriented tables with RLE_TYPE compression."),
+			gettext_noop("Scans check comparisons of such columns with constants once for each distinct value of a block."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_dictionary_encoding,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_late_materialization", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Read the columns of column-oriented tables that the quals of a scan don't use only for the rows that satisfy them."),
+			NULL,
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_late_materialization,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_zone_maps", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Keep zone maps of column-oriented tables, and skip blocks with them in scans."),
+			gettext_noop("The zone maps are stored in the block directory, so only tables with indexes have them."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_zone_maps,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_heap_require_relhasoids_match", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Issue an error on discovery of a mismatch between relhasoids and a tuple header."),
@@ -1113,6 +1216,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		check_gp_workfile_compression, NULL, NULL
 	},
 
+	{
+		{"gp_materialize_compression", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Compresses the tuples of a Materialize node in memory before spilling them to disk."),
+			NULL,
+			GUC_GPDB_ADDOPT
+		},
+		&gp_materialize_compression,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_reraise_signal", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Do we attempt to dump core when a serious problem occurs."),
@@ -1134,6 +1248,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_replan_when_idle", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Rebuild the plans of prepared statements invalidated by catalog changes while the session is idle."),
+			NULL
+		},
+		&gp_replan_when_idle,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_enable_fast_sri", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Enable single-slice single-row inserts."),
@@ -1155,6 +1279,29 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_compression", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Compresses the interconnect packets of motions that send large amounts of data."),
+			gettext_noop("Only used by the UDPIFC interconnect, for the motions estimated to send "
+						 "at least gp_interconnect_compression_threshold of data."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_interconnect_compression,
+		false,
+		check_gp_interconnect_compression, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_local_sockets", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sends the interconnect packets to the segments on the same host through Unix domain sockets."),
+			gettext_noop("Only used by the UDPIFC interconnect on Linux. Other packets are sent through UDP."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_interconnect_local_sockets,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_log_stats", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Emit statistics from the UDP-IC at the end of every statement."),
@@ -1176,6 +1323,28 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_hashjoin_bloomfilter", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Discard outer tuples of hash joins that have no match by a bloom filter of the inner tuples."),
+			gettext_noop("The filter is only used by inner, semi and right joins."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_hashjoin_bloomfilter,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_index_skip_scan", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables index-only scans to skip to the next distinct value of the leading index column."),
+			gettext_noop("Used below DISTINCT and GROUP BY without aggregates on the leading column of a btree index."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_enable_index_skip_scan,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"resource_scheduler", PGC_POSTMASTER, RESOURCES_MGM,
 			gettext_noop("Enable resource scheduling."),
@@ -1890,6 +2059,28 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_enable_subplan_cache", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable caching the results of correlated subqueries by their correlation values."),
+			gettext_noop("A correlated subquery is only rerun for correlation values it has not seen before, "
+						 "until the cache uses up work_mem.")
+		},
+		&gp_enable_subplan_cache,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_nestloop_cache", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable caching the inner rows of parameterized nested loop joins by their parameter values."),
+			gettext_noop("Outer rows with the same join keys reuse the inner rows of an earlier one instead of "
+						 "rescanning the inner side, as long as the cache fits in work_mem.")
+		},
+		&gp_enable_nestloop_cache,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_log_dynamic_partition_pruning", PGC_USERSET, LOGGING_WHAT,
 			gettext_noop("This guc enables debug messages related to dynamic partition pruning."),
@@ -2054,6 +2245,37 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_cardinality_feedback", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Use the rows returned by the scans of EXPLAIN ANALYZE in later estimates of GPORCA."),
+			gettext_noop("A table is estimated to have at least as many rows as were returned from it in the session.")
+		},
+		&optimizer_cardinality_feedback,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_plan_trace", PGC_USERSET, STATS_MONITORING,
+			gettext_noop("Keep the estimated and actual rows and time of the nodes of the plans of GPORCA run by EXPLAIN ANALYZE."),
+			gettext_noop("The latest nodes kept are returned by gp_optimizer_plan_trace().")
+		},
+		&optimizer_plan_trace,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_prefetch_metadata", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Load the statistics used by the query into the metadata cache before the optimizer search starts."),
+			NULL,
+			GUC_GPDB_ADDOPT
+		},
+		&optimizer_prefetch_metadata,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"optimizer_print_missing_stats", PGC_USERSET, LOGGING_WHAT,
 			gettext_noop("Print columns with missing statistics."),
@@ -2345,6 +2567,126 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_enable_partition_wise_join", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Split GPORCA hash joins of co-partitioned tables into joins of their partitions."),
+			NULL
+		},
+		&optimizer_enable_partition_wise_join,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_partition_merge_append", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Replace GPORCA top-N sorts of partitioned tables with merges of ordered index scans of their partitions."),
+			NULL
+		},
+		&optimizer_enable_partition_merge_append,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_matview_rewrite", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Answer GPORCA aggregate queries from materialized views of their table."),
+			gettext_noop("The materialized views are read as of their last refresh.")
+		},
+		&optimizer_enable_matview_rewrite,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_indexonlyscan", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Replace GPORCA index scans covered by their index with index-only scans."),
+			NULL
+		},
+		&optimizer_enable_indexonlyscan,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_incremental_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Let GPORCA sorts of inputs already sorted on their leading keys sort each run of equal leading keys on its own."),
+			NULL
+		},
+		&optimizer_enable_incremental_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_hashjoin_skew", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Let spilling GPORCA hash joins keep the inner rows of the most common outer join keys in memory."),
+			NULL
+		},
+		&optimizer_enable_hashjoin_skew,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_common_subexpressions", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Compute the expressions shared by the filter and the target list of a GPORCA scan once per row."),
+			NULL
+		},
+		&optimizer_enable_common_subexpressions,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_hashed_subplans", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Let the uncorrelated IN and NOT IN subplans of GPORCA plans probe a hash table of their result."),
+			NULL
+		},
+		&optimizer_enable_hashed_subplans,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_dependency_damping", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Derive the filter damping factor of GPORCA from the functional dependencies between the filtered columns."),
+			NULL
+		},
+		&optimizer_enable_dependency_damping,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_rollup_agg", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Plan grouping sets that nest into rollups with the planner's rollup aggregates instead of a GPORCA union of one aggregate per grouping set."),
+			NULL
+		},
+		&optimizer_enable_rollup_agg,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_shared_subqueries", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Let GPORCA compute the identical derived tables of a query once, like a common table expression."),
+			NULL
+		},
+		&optimizer_enable_shared_subqueries,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_enable_shared_window_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Let stacked GPORCA window functions with compatible specifications share one sort."),
+			NULL
+		},
+		&optimizer_enable_shared_window_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"optimizer_enable_hashjoin", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enables the optimizer's use of hash join plans."),
@@ -2623,6 +2965,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_analyze_changed_partitions_only", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("Skip the leaf partitions that haven't changed since they were last analyzed during ANALYZE of a partitioned table"),
+			NULL
+		},
+		&optimizer_analyze_changed_partitions_only,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"optimizer_enable_constant_expression_evaluation", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable constant expression evaluation in the optimizer"),
@@ -2866,6 +3218,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_enable_segment_copy_parsing", PGC_USERSET, CUSTOM_OPTIONS,
+			gettext_noop("Let the segments convert the columns that are not distribution keys in \"COPY FROM\"."),
+			NULL
+		},
+		&gp_enable_segment_copy_parsing,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_ignore_error_table", PGC_USERSET, COMPAT_OPTIONS_PREVIOUS,
 			gettext_noop("Ignore INTO error-table in external table and COPY (Deprecated)."),
@@ -2916,6 +3278,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_external_enable_agg_pushdown", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Enable passing of COUNT(*), MIN and MAX aggregates to external table providers"),
+			gettext_noop("Only aggregates without grouping right above an external scan without filters are passed."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_external_enable_agg_pushdown,
+		true, NULL, NULL
+	},
+
 	{
 		{"gp_resource_group_bypass", PGC_USERSET, RESOURCES,
 			gettext_noop("If the value is true, the query in this session will not be limited by resource group."),
@@ -3141,6 +3513,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_read_ahead", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets the number of large reads of an append-optimized segment file to prefetch ahead of the current one."),
+			gettext_noop("Zero disables read-ahead."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_read_ahead,
+		0, 0, 64,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_max_entries", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the maximum number of entries that can be stored in the workfile directory"),
@@ -3185,6 +3568,28 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_shareinput_shmem_size", PGC_SIGHUP, RESOURCES,
+			gettext_noop("Maximum shared memory (in KB) used per segment to share materialized results across slices."),
+			gettext_noop("Results that don't fit are written to workfiles. 0 always writes them to workfiles."),
+			GUC_UNIT_KB
+		},
+		&gp_shareinput_shmem_size,
+		65536, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_dml_insert_batch_mem", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the memory (in KB) used to buffer the rows inserted into a partitioned table by a GPORCA plan."),
+			gettext_noop("Rows are buffered per partition and inserted one partition after the other. 0 inserts each row as it comes."),
+			GUC_UNIT_KB
+		},
+		&gp_dml_insert_batch_mem,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_idle_resource_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release gangs on the segment DBs to free resources."),
@@ -3396,6 +3801,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_compression_threshold", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the estimated data size above which the packets of a motion are compressed."),
+			gettext_noop("The size is the estimated number of rows times their width."),
+			GUC_UNIT_KB | GUC_GPDB_ADDOPT
+		},
+		&gp_interconnect_compression_threshold,
+		65536, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_debug_retry_interval", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the interval by retry times to record a debug message for retry."),
@@ -3528,6 +3944,28 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_broadcast_cache_relations", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of tables whose writes the master tracks for the broadcast cache of the segments."),
+			gettext_noop("Zero disables the broadcast cache."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_broadcast_cache_relations,
+		0, 0, INT_MAX / 2,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_broadcast_cache_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the memory each process of a session on the segments may use to keep the tuples of small broadcast tables."),
+			gettext_noop("Zero disables the broadcast cache of the session."),
+			GUC_UNIT_KB | GUC_GPDB_ADDOPT
+		},
+		&gp_broadcast_cache_size,
+		16384, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 
 	{
 #ifdef USE_ASSERT_CHECKING
@@ -3606,6 +4044,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_tcp_connection_pool_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Maximum number of TCP interconnect connections each session process keeps open for its next queries."),
+			gettext_noop("0 closes the connections at the end of each query."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&tcpConnectionPoolSize,
+		0, 0, 65535,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_snapshotadd_timeout", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Timeout (in seconds) on setup of new connection snapshot"),
@@ -3725,17 +4174,6 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
-	{
-		{"gp_hashagg_groups_per_bucket", PGC_USERSET, GP_ARRAY_TUNING,
-			gettext_noop("Target density of hashtable used by Hashagg during execution"),
-			gettext_noop("A smaller value will tend to produce larger hashtables, which increases agg performance"),
-			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL | GUC_GPDB_ADDOPT
-		},
-		&gp_hashagg_groups_per_bucket,
-		5, 1, 25,
-		NULL, NULL, NULL
-	},
-
 	{
 		{"gp_hashagg_default_nbatches", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Default number of batches for hashagg's (re-)spilling phases."),
@@ -3800,6 +4238,18 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_explain_timing_sample_rate", PGC_USERSET, STATS_MONITORING,
+			gettext_noop("Times one in this many calls of each plan node in EXPLAIN ANALYZE."),
+			gettext_noop("The time of the other calls is estimated from the timed ones, "
+						 "which lowers the overhead of timing nodes that return many rows."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_explain_timing_sample_rate,
+		1, 1, 1000000,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_protect_limit", PGC_POSTMASTER, RESOURCES_MEM,
 			gettext_noop("Virtual memory limit (in MB) of Greenplum memory protection."),
@@ -3840,6 +4290,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_statistics_dependency_columns", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("Sets the number of columns of a table ANALYZE computes the functional dependencies between."),
+			gettext_noop("0 or 1 disables them.")
+		},
+		&gp_statistics_dependency_columns,
+		16, 0, 64,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_distinct_grouping_sets_threshold", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Threshold for the number of grouping sets whose distinct-qualified "
@@ -4058,6 +4518,38 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_join_search_budget", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Maximum number of joinable pairs of connected subgraphs for which GPORCA searches a join above optimizer_join_order_threshold with dynamic programming."),
+			gettext_noop("0 searches all joins above optimizer_join_order_threshold greedily.")
+		},
+		&optimizer_join_search_budget,
+		100000, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_search_time_budget", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the time GPORCA may spend in each stage of the search for the plan of a query."),
+			gettext_noop("The best plan found so far is used when it expires. Zero disables the limit."),
+			GUC_UNIT_MS
+		},
+		&optimizer_search_time_budget,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_capture_threshold", PGC_USERSET, LOGGING_WHEN,
+			gettext_noop("Sets the optimization time above which GPORCA keeps the minidump of a query."),
+			gettext_noop("The latest minidumps kept are returned by gp_optimizer_captures(). Zero disables keeping them."),
+			GUC_UNIT_MS
+		},
+		&optimizer_capture_threshold,
+		10000, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"optimizer_join_arity_for_associativity_commutativity", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Maximum number of children n-ary-join have without disabling commutativity and associativity transform"),
@@ -4091,6 +4583,60 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_mdcache_shared_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the MDCache shared by the sessions on the master."),
+			gettext_noop("Zero disables the shared MDCache."),
+			GUC_UNIT_KB
+		},
+		&optimizer_mdcache_shared_size,
+		16384, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_memory_limit", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the memory GPORCA may use to optimize a query."),
+			gettext_noop("The query is planned by the Postgres planner if GPORCA needs more. Zero disables the limit."),
+			GUC_UNIT_KB
+		},
+		&optimizer_memory_limit,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_max_concurrent_optimizations", PGC_SIGHUP, RESOURCES_MEM,
+			gettext_noop("Sets the maximum number of GPORCA optimizations running at once on the master."),
+			gettext_noop("Sessions wait for one of the running optimizations to finish beyond it. Zero means no limit.")
+		},
+		&optimizer_max_concurrent_optimizations,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_plan_cache_size", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the maximum number of queries whose plans are cached by GPORCA."),
+			gettext_noop("Zero disables the plan cache."),
+			GUC_GPDB_ADDOPT
+		},
+		&optimizer_plan_cache_size,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_plan_baselines", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the maximum number of queries whose baseline plans are kept by GPORCA."),
+			gettext_noop("Zero disables the plan baselines."),
+			GUC_GPDB_ADDOPT
+		},
+		&optimizer_plan_baselines,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"memory_profiler_dataset_size", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Set the size in GB"),
@@ -4198,6 +4744,28 @@ struct config_real ConfigureNamesReal_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_external_analyze_sample_fraction", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Sets the fraction of the data of an external table that ANALYZE reads."),
+			gettext_noop("Protocols that can, such as s3, read only this fraction of their files; "
+						 "the row count is extrapolated from it.")
+		},
+		&gp_external_analyze_sample_fraction,
+		1.0, 0.0001, 1.0,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_external_scan_sample_fraction", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Sets the fraction of the rows an external scan returns."),
+			gettext_noop("Set by ANALYZE of an external table."),
+			GUC_GPDB_ADDOPT | GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL
+		},
+		&gp_external_scan_sample_fraction,
+		1.0, 0.0001, 1.0,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_motion_cost_per_row", PGC_USERSET, QUERY_TUNING_COST,
 			gettext_noop("Sets the planner's estimate of the cost of "
@@ -4221,6 +4789,33 @@ struct config_real ConfigureNamesReal_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_hashagg_passthrough_ratio", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the fraction of groups per input row above which the bottom stage "
+						 "of a streaming hashagg stops aggregating."),
+			gettext_noop("When the hash table fills up with more groups than this fraction of the "
+						 "rows put in it, the remaining rows are passed through as groups of their "
+						 "own. 1 never passes rows through."),
+			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL | GUC_GPDB_ADDOPT
+		},
+		&gp_hashagg_passthrough_ratio,
+		0.9, 0.0, 1.0,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_motion_skew_threshold", PGC_USERSET, LOGGING_WHAT,
+			gettext_noop("Sets the fraction of rows sent to one segment above which a "
+						 "Redistribute Motion logs skew."),
+			gettext_noop("The first rows of each Redistribute Motion are sampled. Zero disables "
+						 "the check."),
+			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL | GUC_GPDB_ADDOPT
+		},
+		&gp_motion_skew_threshold,
+		0.0, 0.0, 1.0,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_resqueue_priority_cpucores_per_segment", PGC_POSTMASTER, RESOURCES_MGM,
 			gettext_noop("Number of processing units associated with a segment."),
@@ -4316,6 +4911,50 @@ struct config_real ConfigureNamesReal_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_compressed_motion_cost_factor", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Set the factor of the cost of sending tuples through motions in the optimizer, when gp_interconnect_compression is on."),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_compressed_motion_cost_factor,
+		0.5, 0.0, 1.0,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_hashagg_cost_factor", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Set the hash aggregate cost factor in the optimizer, 1.0 means same as default, > 1.0 means more costly than default, < 1.0 means less costly than default"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_hashagg_cost_factor,
+		1.0, 0.0, DBL_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_cte_sharing_cost_factor", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Set the cost factor of materializing a shared CTE in the optimizer when it can be kept in shared memory, 1.0 means same as default, > 1.0 means more costly than default, < 1.0 means less costly than default"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_cte_sharing_cost_factor,
+		1.0, 0.0, DBL_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_intra_host_motion_cost_factor", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Set the cost of moving a byte between two segments of the same host relative to moving it between hosts in the optimizer, 1.0 means the same cost, < 1.0 means less costly"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_intra_host_motion_cost_factor,
+		1.0, 0.0, 1.0,
+		NULL, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, 0.0, 0.0, 0.0, NULL, NULL
@@ -4701,7 +5340,7 @@ struct config_enum ConfigureNamesEnum_gp[] =
 	{
 		{"gp_resqueue_memory_policy", PGC_SUSET, RESOURCES_MGM,
 			gettext_noop("Sets the policy for memory allocation of queries."),
-			gettext_noop("Valid values are NONE, AUTO, EAGER_FREE.")
+			gettext_noop("Valid values are NONE, AUTO, EAGER_FREE, ESTIMATE.")
 		},
 		&gp_resqueue_memory_policy,
 		RESMANAGER_MEMORY_POLICY_NONE, gp_resqueue_memory_policies,
@@ -4711,7 +5350,7 @@ struct config_enum ConfigureNamesEnum_gp[] =
 	{
 		{"gp_resgroup_memory_policy", PGC_SUSET, RESOURCES_MGM,
 			gettext_noop("Sets the policy for memory allocation of queries."),
-			gettext_noop("Valid values are AUTO, EAGER_FREE.")
+			gettext_noop("Valid values are AUTO, EAGER_FREE, ESTIMATE.")
 		},
 		&gp_resgroup_memory_policy,
 		RESMANAGER_MEMORY_POLICY_EAGER_FREE, gp_resqueue_memory_policies, NULL, NULL
@@ -5059,3 +5698,16 @@ check_gp_workfile_compression(bool *newval, void **extra, GucSource source)
 #endif
 	return true;
 }
+
+static bool
+check_gp_interconnect_compression(bool *newval, void **extra, GucSource source)
+{
+#ifndef HAVE_LIBZSTD
+	if (*newval)
+	{
+		GUC_check_errmsg("interconnect compression is not supported by this build");
+		return false;
+	}
+#endif
+	return true;
+}
@@ -26,6 +26,69 @@
  */
 uint64 OptimizerOutstandingMemoryBalance = 0;
 
+/*
+ * Number and total size of the allocations made by Orca so far, they are
+ * never decremented.  The optimizer takes their difference over each of its
+ * phases, see GetOptimizerAllocations().
+ */
+static uint64 OptimizerNumAllocations = 0;
+static uint64 OptimizerAllocatedBytes = 0;
+
+/*
+ * GPOS makes many small allocations, so they are not recorded in the memory
+ * account one by one.  Their sizes, less the sizes freed, are summed up in
+ * OptimizerUnaccountedBytes, and recorded in the account they were made in
+ * once the sum reaches OPTIMIZER_ACCOUNTING_BATCH either way, when the active
+ * account changes, or when Ext_OptimizerFlushAccounting() is called before
+ * the account is read.  The peak of the account is therefore only accurate
+ * to within the batch.
+ */
+static int64 OptimizerUnaccountedBytes = 0;
+static MemoryAccountIdType OptimizerUnaccountedAccountId = MEMORY_OWNER_TYPE_Undefined;
+
+/*
+ * While an optimization is limited by optimizer_memory_limit, Orca may have
+ * at most OptimizerMemoryLimit bytes outstanding beyond the balance it had
+ * when the limit was set.  0 means no limit.
+ */
+static uint64 OptimizerMemoryLimit = 0;
+static uint64 OptimizerMemoryLimitBase = 0;
+
+/*
+ * Record the allocations and frees not yet recorded in their memory account.
+ */
+void
+Ext_OptimizerFlushAccounting(void)
+{
+	/* only counters are updated, so this raises no error */
+	if (OptimizerUnaccountedBytes > 0)
+		MemoryAccounting_Allocate(OptimizerUnaccountedAccountId,
+								  OptimizerUnaccountedBytes);
+	else if (OptimizerUnaccountedBytes < 0)
+		MemoryAccounting_Free(OptimizerUnaccountedAccountId,
+							  -OptimizerUnaccountedBytes);
+
+	OptimizerUnaccountedBytes = 0;
+	OptimizerUnaccountedAccountId = MEMORY_OWNER_TYPE_Undefined;
+}
+
+static inline void
+OptimizerAccount(int64 size)
+{
+	if (OptimizerUnaccountedAccountId != ActiveMemoryAccountId)
+	{
+		Ext_OptimizerFlushAccounting();
+		OptimizerUnaccountedAccountId = ActiveMemoryAccountId;
+	}
+
+	OptimizerUnaccountedBytes += size;
+	OptimizerOutstandingMemoryBalance += size;
+
+	if (OptimizerUnaccountedBytes >= OPTIMIZER_ACCOUNTING_BATCH ||
+		OptimizerUnaccountedBytes <= -OPTIMIZER_ACCOUNTING_BATCH)
+		Ext_OptimizerFlushAccounting();
+}
+
 /*
  * Allocation & Deallocation functions for GPOS
  *
@@ -35,14 +98,40 @@ uint64 OptimizerOutstandingMemoryBalance = 0;
 void*
 Ext_OptimizerAlloc(size_t size)
 {
+	void	   *ptr;
+
 #ifdef USE_ASSERT_CHECKING
 	MemoryAccount *account = MemoryAccounting_ConvertIdToAccount(ActiveMemoryAccountId);
 	Assert(account->ownerType == MEMORY_OWNER_TYPE_Optimizer);
 #endif
 
-	MemoryAccounting_Allocate(ActiveMemoryAccountId, size);
-	OptimizerOutstandingMemoryBalance += size;
-	return gp_malloc(size);
+	ptr = gp_malloc(size);
+
+	OptimizerAccount(size);
+	OptimizerNumAllocations++;
+	OptimizerAllocatedBytes += size;
+	return ptr;
+}
+
+/*
+ * Like Ext_OptimizerAlloc(), but only from the Vmem this process has already
+ * reserved, so that it never raises an error, and the caller needs no
+ * PG_TRY() around it.  Returns NULL if Ext_OptimizerAlloc() is to be called
+ * instead.
+ */
+void*
+Ext_OptimizerAllocReserved(size_t size)
+{
+	void	   *ptr;
+
+	ptr = gp_malloc_reserved(size);
+	if (ptr == NULL)
+		return NULL;
+
+	OptimizerAccount(size);
+	OptimizerNumAllocations++;
+	OptimizerAllocatedBytes += size;
+	return ptr;
 }
 
 void
@@ -50,14 +139,66 @@ Ext_OptimizerFree(void *ptr)
 {
 	void *malloc_pointer = UserPtr_GetVmemPtr(ptr);
 	size_t freed_size = VmemPtr_GetUserPtrSize((VmemHeader*) malloc_pointer);
-	MemoryAccounting_Free(ActiveMemoryAccountId, freed_size);
-	OptimizerOutstandingMemoryBalance -= freed_size;
+	OptimizerAccount(-(int64) freed_size);
 	gp_free(ptr);
 }
 
+/*
+ * Like Ext_OptimizerFree(), the counterpart of Ext_OptimizerAllocReserved().
+ * Returns false, freeing nothing, if Ext_OptimizerFree() is to be called
+ * instead.
+ */
+bool
+Ext_OptimizerFreeReserved(void *ptr)
+{
+	void *malloc_pointer = UserPtr_GetVmemPtr(ptr);
+	size_t freed_size = VmemPtr_GetUserPtrSize((VmemHeader*) malloc_pointer);
+
+	if (!gp_free_reserved(ptr))
+		return false;
+
+	OptimizerAccount(-(int64) freed_size);
+	return true;
+}
+
+/*
+ * Limit the bytes Orca may allocate from now on, less those it frees, to
+ * limit.  0 removes the limit.
+ */
+void
+Ext_OptimizerSetMemoryLimit(uint64 limit)
+{
+	OptimizerMemoryLimit = limit;
+	OptimizerMemoryLimitBase = OptimizerOutstandingMemoryBalance;
+}
+
+/*
+ * Would an allocation of size bytes exceed the limit set by
+ * Ext_OptimizerSetMemoryLimit()?  Only counters are read, so this raises no
+ * error.
+ */
+bool
+Ext_OptimizerExceedsMemoryLimit(size_t size)
+{
+	return OptimizerMemoryLimit > 0 &&
+		OptimizerOutstandingMemoryBalance + size >
+		OptimizerMemoryLimitBase + OptimizerMemoryLimit;
+}
+
 uint64
 GetOptimizerOutstandingMemoryBalance()
 {
 	return OptimizerOutstandingMemoryBalance;
 }
 
+/*
+ * Return the number of allocations Orca has made so far, and their total
+ * size in *bytes.
+ */
+uint64
+GetOptimizerAllocations(uint64 *bytes)
+{
+	*bytes = OptimizerAllocatedBytes;
+	return OptimizerNumAllocations;
+}
+
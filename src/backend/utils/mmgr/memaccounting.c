@@ -572,6 +572,8 @@ MemoryAccounting_ExplainCurrentOptimizerAccountInfo(void)
 	MemoryAccountIdType		shortLivingArrayIdx;
 	MemoryAccountExplain   *exp = NULL;
 
+	Ext_OptimizerFlushAccounting();
+
 	for (shortLivingArrayIdx = 0; shortLivingArrayIdx < shortLivingCount; ++shortLivingArrayIdx)
 	{
 		MemoryAccount *shortLivingAccount = shortLivingMemoryAccountArray->allAccounts[shortLivingArrayIdx];
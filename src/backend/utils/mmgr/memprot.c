@@ -482,3 +482,62 @@ void gp_free(void *user_pointer)
 	free(malloc_pointer);
 	VmemTracker_ReleaseVmem(UserPtrSize_GetVmemPtrSize(usable_size));
 }
+
+/*
+ * Allocates sz bytes from the vmem this process has already reserved.  Unlike
+ * gp_malloc, it never raises an error: it returns NULL if more vmem would have
+ * to be reserved, or if malloc fails, and the caller is to retry with
+ * gp_malloc.
+ */
+void *gp_malloc_reserved(int64 sz)
+{
+	Assert(!gp_mp_inited || MemoryProtection_IsOwnerThread());
+
+	void *ret;
+
+	if(!gp_mp_inited)
+	{
+		return malloc_and_store_metadata(sz);
+	}
+
+	size_t size_with_overhead = UserPtrSize_GetVmemPtrSize(sz);
+
+	if (!VmemTracker_ReserveVmemInChunks(size_with_overhead))
+	{
+		return NULL;
+	}
+
+	ret = malloc_and_store_metadata(sz);
+	if (!ret)
+	{
+		/* gives back no chunk, as it was reserved from the chunks held */
+		VmemTracker_ReleaseVmemInChunks(size_with_overhead);
+	}
+
+	return ret;
+}
+
+/*
+ * Frees memory allocated by gp_malloc if that doesn't release any vmem chunk,
+ * so that it doesn't touch shared state.  Returns false, freeing nothing,
+ * otherwise, and the caller is to call gp_free.
+ */
+bool gp_free_reserved(void *user_pointer)
+{
+	Assert(!gp_mp_inited || MemoryProtection_IsOwnerThread());
+	Assert(NULL != user_pointer);
+
+	void *malloc_pointer = UserPtr_GetVmemPtr(user_pointer);
+	size_t usable_size = VmemPtr_GetUserPtrSize((VmemHeader*) malloc_pointer);
+	Assert(usable_size > 0);
+
+	if (gp_mp_inited &&
+		!VmemTracker_ReleaseVmemInChunks(UserPtrSize_GetVmemPtrSize(usable_size)))
+	{
+		return false;
+	}
+
+	UserPtr_VerifyChecksum(user_pointer);
+	free(malloc_pointer);
+	return true;
+}
@@ -251,6 +251,7 @@ test__MemoryAccounting_Optimizer_Oustanding_Balance_Rollover(void **state)
 
 	MemoryAccounting_SwitchAccount(optimizerAccountId);
 	void *ptr = Ext_OptimizerAlloc(1);
+	Ext_OptimizerFlushAccounting();
 	assert_true(GetOptimizerOutstandingMemoryBalance()==1);
 
 	MemoryAccounting_SwitchAccount(tempParentAccountId);
@@ -264,6 +265,76 @@ test__MemoryAccounting_Optimizer_Oustanding_Balance_Rollover(void **state)
 
 }
 
+/*
+ * Tests that the allocations of the optimizer are recorded in their account
+ * in batches, and when the active account changes.
+ */
+void
+test__MemoryAccounting_Optimizer_Batched_Accounting(void **state)
+{
+	MemoryAccountIdType optimizerAccountId = CreateMemoryAccountImpl(0, MEMORY_OWNER_TYPE_Optimizer, ActiveMemoryAccountId);
+	MemoryAccountIdType tempParentAccountId = CreateMemoryAccountImpl(0, MEMORY_OWNER_TYPE_Exec_Hash, optimizerAccountId);
+	MemoryAccount *optimizerAccount = MemoryAccounting_ConvertIdToAccount(optimizerAccountId);
+	uint64 allocated = optimizerAccount->allocated;
+
+	MemoryAccounting_SwitchAccount(optimizerAccountId);
+	void *ptr = Ext_OptimizerAlloc(1);
+	assert_true(optimizerAccount->allocated == allocated);
+
+	Ext_OptimizerFlushAccounting();
+	assert_true(optimizerAccount->allocated == allocated + 1);
+
+	/* a batch is recorded at once */
+	void *ptr2 = Ext_OptimizerAlloc(OPTIMIZER_ACCOUNTING_BATCH);
+	assert_true(optimizerAccount->allocated == allocated + 1 + OPTIMIZER_ACCOUNTING_BATCH);
+
+	Ext_OptimizerFree(ptr);
+	Ext_OptimizerFree(ptr2);
+	assert_true(optimizerAccount->freed == 1 + OPTIMIZER_ACCOUNTING_BATCH);
+
+	/* what is not recorded yet goes to the account it was made in */
+	MemoryAccountIdType optimizerAccountId2 = CreateMemoryAccountImpl(0, MEMORY_OWNER_TYPE_Optimizer, tempParentAccountId);
+	ptr = Ext_OptimizerAlloc(1);
+	MemoryAccounting_SwitchAccount(optimizerAccountId2);
+	ptr2 = Ext_OptimizerAlloc(1);
+	assert_true(optimizerAccount->allocated == allocated + 2 + OPTIMIZER_ACCOUNTING_BATCH);
+
+	Ext_OptimizerFree(ptr);
+	Ext_OptimizerFree(ptr2);
+	Ext_OptimizerFlushAccounting();
+}
+
+/*
+ * Tests that the memory limit of the optimizer counts the bytes allocated
+ * since it was set, less the bytes freed.
+ */
+void
+test__MemoryAccounting_Optimizer_Memory_Limit(void **state)
+{
+	MemoryAccountIdType optimizerAccountId = CreateMemoryAccountImpl(0, MEMORY_OWNER_TYPE_Optimizer, ActiveMemoryAccountId);
+
+	MemoryAccounting_SwitchAccount(optimizerAccountId);
+	void *ptr = Ext_OptimizerAlloc(100);
+	assert_false(Ext_OptimizerExceedsMemoryLimit(1024 * 1024));
+
+	/* what was allocated before doesn't count */
+	Ext_OptimizerSetMemoryLimit(1000);
+	assert_false(Ext_OptimizerExceedsMemoryLimit(1000));
+	assert_true(Ext_OptimizerExceedsMemoryLimit(1001));
+
+	void *ptr2 = Ext_OptimizerAlloc(600);
+	assert_true(Ext_OptimizerExceedsMemoryLimit(401));
+
+	/* what is freed is available again, even from before the limit */
+	Ext_OptimizerFree(ptr2);
+	Ext_OptimizerFree(ptr);
+	assert_false(Ext_OptimizerExceedsMemoryLimit(1100));
+
+	Ext_OptimizerSetMemoryLimit(0);
+	assert_false(Ext_OptimizerExceedsMemoryLimit(1024 * 1024));
+	Ext_OptimizerFlushAccounting();
+}
+
 /*
  * Checks whether the regular account creation charges the overhead
  * in the MemoryAccountMemoryAccount and SharedChunkHeadersMemoryAccount.
@@ -1380,6 +1451,8 @@ main(int argc, char* argv[])
 		unit_test_setup_teardown(test__ConvertIdToUniversalArrayIndex__Validate, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_GetAccountCurrentBalance__ResetPeakBalance, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_Optimizer_Oustanding_Balance_Rollover, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_Optimizer_Batched_Accounting, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_Optimizer_Memory_Limit, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 	};
 
 	return run_tests(tests);
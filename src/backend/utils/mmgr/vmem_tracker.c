@@ -632,6 +632,58 @@ VmemTracker_ReleaseVmem(int64 toBeFreedRequested)
 	}
 }
 
+/*
+ * Reserve newly_requested bytes from the chunks this process has already
+ * reserved.
+ *
+ * This is the cheap check of VmemTracker_ReserveVmem(): it touches no shared
+ * state, and never raises an error.  Returns false, reserving nothing, if a
+ * new chunk would have to be reserved, in which case the caller goes through
+ * VmemTracker_ReserveVmem().
+ */
+bool
+VmemTracker_ReserveVmemInChunks(int64 newlyRequestedBytes)
+{
+	if (!VmemTrackerIsActivated())
+	{
+		Assert(0 == trackedVmemChunks);
+		return true;
+	}
+
+	Assert(newlyRequestedBytes >= 0);
+
+	if (((trackedBytes + newlyRequestedBytes) >> VmemTracker_GetChunkSizeInBits()) > trackedVmemChunks)
+		return false;
+
+	trackedBytes += newlyRequestedBytes;
+	return true;
+}
+
+/*
+ * Release to_be_freed bytes if that doesn't release any chunk, the cheap
+ * counterpart of VmemTracker_ReleaseVmem().  Returns false, releasing
+ * nothing, otherwise.
+ */
+bool
+VmemTracker_ReleaseVmemInChunks(int64 toBeFreed)
+{
+	if (!vmemTrackerInited ||
+	   (IsResGroupEnabled() &&
+		!IsResGroupActivated()))
+	{
+		Assert(0 == trackedVmemChunks);
+		return true;
+	}
+
+	/* see VmemTracker_ReleaseVmem() for freeing more than was reserved */
+	if (toBeFreed > trackedBytes ||
+		((trackedBytes - toBeFreed) >> VmemTracker_GetChunkSizeInBits()) < trackedVmemChunks)
+		return false;
+
+	trackedBytes -= toBeFreed;
+	return true;
+}
+
 /*
  * Request additional VMEM bytes beyond per-session or system vmem limit for
  * OOM error handling.
@@ -15,6 +15,7 @@
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
 #include "cdb/memquota.h"
 #include "cdb/cdbllize.h"
 #include "storage/lwlock.h"
@@ -85,6 +86,14 @@ typedef struct OperatorGroupNode
 	uint64 maxNumConcNonMemIntenseOps;
 	uint64 maxNumConcMemIntenseOps;
 
+	/*
+	 * The estimated working set of the memory-intensive operators in the
+	 * group, and the maximal one of those in all child groups which might be
+	 * active concurrently, in KB.
+	 */
+	double memIntenseOpsKB;
+	double maxConcMemIntenseOpsKB;
+
 	/* The list of child groups */
 	List *childGroups;
 
@@ -107,6 +116,7 @@ typedef struct PolicyEagerFreeContext
 	OperatorGroupNode *groupNode; /* the current group node in the group tree */
 	uint32 nextGroupId; /* the group id for a new group node */
 	uint64 queryMemKB; /* the query memory limit */
+	bool useEstimates; /* distribute by the estimated working sets? */
 	PlannedStmt *plannedStmt; /* pointer to the planned statement */
 } PolicyEagerFreeContext;
 
@@ -496,6 +506,28 @@ CreateOperatorGroupNode(uint32 groupId, OperatorGroupNode *parentGroup)
 	return node;
 }
 
+/*
+ * EstimatedWorkingSetKB
+ *    Estimate the memory a memory-intensive operator needs not to spill, in KB.
+ *
+ * The operators hold the rows they return, or in the case of a Hash, the rows
+ * of the inner side it returns to the join, so this is the estimated number
+ * of rows times their size as minimal tuples.  The estimates of the operators
+ * that hold few rows are raised to the memory of a non-memory-intensive
+ * operator, for they still need some to work with.
+ */
+static double
+EstimatedWorkingSetKB(Node *node)
+{
+	Plan *plan = (Plan *) node;
+	const uint64 nonMemIntenseOpMemKB = (uint64)(*gp_resmanager_memory_policy_auto_fixed_mem);
+
+	double workingSetKB = plan->plan_rows *
+		(Max(plan->plan_width, 0) + MAXALIGN(offsetof(MinimalTupleData, t_bits))) / 1024.0;
+
+	return Max(workingSetKB, (double) nonMemIntenseOpMemKB);
+}
+
 /*
  * IncrementOperatorCount
  *    Increment the count of operators in the current group based
@@ -510,6 +542,7 @@ IncrementOperatorCount(Node *node, OperatorGroupNode *groupNode, PlannedStmt *st
 	if (IsMemoryIntensiveOperator(node, stmt))
 	{
 		groupNode->numMemIntenseOps++;
+		groupNode->memIntenseOpsKB += EstimatedWorkingSetKB(node);
 	}
 	else
 	{
@@ -651,18 +684,47 @@ ComputeAvgMemKBForMemIntenseOp(OperatorGroupNode *groupNode)
 			groupNode->numMemIntenseOps);
 }
 
+/*
+ * ComputeEstimateMemKBForMemIntenseOp
+ *    Compute the memory limit for a memory-intensive operator in a given
+ * group, in proportion to its estimated working set.
+ *
+ * When the memory of the group doesn't cover the working sets of all of its
+ * memory-intensive operators, each of them gets the same fraction of its
+ * working set, so that a small operator doesn't get memory it cannot use
+ * while a large one spills. Otherwise, what is left over is distributed the
+ * same way, as a margin for the estimates that are too low.
+ */
+static uint64
+ComputeEstimateMemKBForMemIntenseOp(OperatorGroupNode *groupNode, Node *node)
+{
+	if (groupNode->numMemIntenseOps == 0)
+	{
+		return 0;
+	}
+
+	Assert(groupNode->memIntenseOpsKB > 0);
+
+	const uint64 nonMemIntenseOpMemKB = (uint64)(*gp_resmanager_memory_policy_auto_fixed_mem);
+
+	return (((double)groupNode->groupMemKB -
+			 (double)groupNode->numNonMemIntenseOps * nonMemIntenseOpMemKB) *
+			EstimatedWorkingSetKB(node) / groupNode->memIntenseOpsKB);
+}
+
 /*
  * ComputeMemLimitForChildGroups
  *    compute the query memory limit for all child groups of a given
  * parent group if it has not been computed before.
  */
 static void
-ComputeMemLimitForChildGroups(OperatorGroupNode *parentGroupNode)
+ComputeMemLimitForChildGroups(OperatorGroupNode *parentGroupNode, bool useEstimates)
 {
 	Assert(parentGroupNode != NULL);
 
 	uint64 totalNumMemIntenseOps = 0;
 	uint64 totalNumNonMemIntenseOps = 0;
+	double totalMemIntenseOpsKB = 0;
 
 	ListCell *lc;
 	foreach(lc, parentGroupNode->childGroups)
@@ -681,6 +743,8 @@ ComputeMemLimitForChildGroups(OperatorGroupNode *parentGroupNode)
 			Max(childGroup->maxNumConcMemIntenseOps, childGroup->numMemIntenseOps);
 		totalNumNonMemIntenseOps +=
 			Max(childGroup->maxNumConcNonMemIntenseOps, childGroup->numNonMemIntenseOps);
+		totalMemIntenseOpsKB +=
+			Max(childGroup->maxConcMemIntenseOpsKB, childGroup->memIntenseOpsKB);
 	}
 
 	const uint64 nonMemIntenseOpMemKB = (uint64)(*gp_resmanager_memory_policy_auto_fixed_mem);
@@ -726,6 +790,22 @@ ComputeMemLimitForChildGroups(OperatorGroupNode *parentGroupNode)
 				  	  	  	  	  	  	  Max(childGroup->maxNumConcMemIntenseOps, childGroup->numMemIntenseOps) +
 				  	  	  	  	  	  	  nonMemIntenseOpMemKB *
 				  	  	  	  	  	  	  Max(childGroup->maxNumConcNonMemIntenseOps, childGroup->numNonMemIntenseOps));
+
+		/*
+		 * With the estimate-driven policy, the memory for the memory-intensive
+		 * operators is divided among the child groups in proportion to the
+		 * estimated working sets of those instead of their number.
+		 */
+		if (useEstimates && totalMemIntenseOpsKB > 0)
+		{
+			childGroup->groupMemKB = (uint64)
+				((double)(parentGroupNode->groupMemKB -
+						  totalNumNonMemIntenseOps * nonMemIntenseOpMemKB) *
+				 Max(childGroup->maxConcMemIntenseOpsKB, childGroup->memIntenseOpsKB) /
+				 totalMemIntenseOpsKB +
+				 nonMemIntenseOpMemKB *
+				 Max(childGroup->maxNumConcNonMemIntenseOps, childGroup->numNonMemIntenseOps));
+		}
 	}
 }
 
@@ -787,6 +867,7 @@ PolicyEagerFreePrelimWalker(Node *node, PolicyEagerFreeContext *context)
 
 		uint64 maxNumConcNonMemIntenseOps = 0;
 		uint64 maxNumConcMemIntenseOps = 0;
+		double maxConcMemIntenseOpsKB = 0;
 
 		ListCell *lc;
 		foreach(lc, context->groupNode->childGroups)
@@ -796,12 +877,15 @@ PolicyEagerFreePrelimWalker(Node *node, PolicyEagerFreeContext *context)
 				Max(childGroup->maxNumConcNonMemIntenseOps, childGroup->numNonMemIntenseOps);
 			maxNumConcMemIntenseOps +=
 				Max(childGroup->maxNumConcMemIntenseOps, childGroup->numMemIntenseOps);
+			maxConcMemIntenseOpsKB +=
+				Max(childGroup->maxConcMemIntenseOpsKB, childGroup->memIntenseOpsKB);
 		}
 
 		Assert(context->groupNode->maxNumConcNonMemIntenseOps == 0 &&
 			   context->groupNode->maxNumConcMemIntenseOps == 0);
 		context->groupNode->maxNumConcNonMemIntenseOps = maxNumConcNonMemIntenseOps;
 		context->groupNode->maxNumConcMemIntenseOps = maxNumConcMemIntenseOps;
+		context->groupNode->maxConcMemIntenseOpsKB = maxConcMemIntenseOpsKB;
 
 		/* Reset the groupNode to point to its parentGroupNode */
 		context->groupNode = GetParentOperatorGroup(context->groupNode);
@@ -840,7 +924,8 @@ PolicyEagerFreeAssignWalker(Node *node, PolicyEagerFreeContext *context)
 		if (IsRootOperatorInGroup(node) &&
 			GetParentOperatorGroup(context->groupNode) != NULL)
 		{
-			ComputeMemLimitForChildGroups(GetParentOperatorGroup(context->groupNode));
+			ComputeMemLimitForChildGroups(GetParentOperatorGroup(context->groupNode),
+										  context->useEstimates);
 		}
 
 		if (!IsMemoryIntensiveOperator(node, context->plannedStmt))
@@ -850,10 +935,12 @@ PolicyEagerFreeAssignWalker(Node *node, PolicyEagerFreeContext *context)
 		else
 		{
 			/*
-			 * Evenly distribute the remaining memory among all memory-intensive
-			 * operators.
+			 * Distribute the remaining memory among all memory-intensive
+			 * operators, evenly or by their estimated working sets.
 			 */
-			uint64 memKB = ComputeAvgMemKBForMemIntenseOp(context->groupNode);
+			uint64 memKB = context->useEstimates ?
+				ComputeEstimateMemKBForMemIntenseOp(context->groupNode, node) :
+				ComputeAvgMemKBForMemIntenseOp(context->groupNode);
 
 			planNode->operatorMemKB = memKB;
 
@@ -867,7 +954,9 @@ PolicyEagerFreeAssignWalker(Node *node, PolicyEagerFreeContext *context)
 			if (IsRootOperatorInGroup(node) &&
 				parentGroupNode != NULL)
 			{
-				uint64 memKBInParentGroup = ComputeAvgMemKBForMemIntenseOp(parentGroupNode);
+				uint64 memKBInParentGroup = context->useEstimates ?
+					ComputeEstimateMemKBForMemIntenseOp(parentGroupNode, node) :
+					ComputeAvgMemKBForMemIntenseOp(parentGroupNode);
 
 				if (memKBInParentGroup < planNode->operatorMemKB)
 				{
@@ -893,15 +982,13 @@ PolicyEagerFreeAssignWalker(Node *node, PolicyEagerFreeContext *context)
 }
 
 /*
- * PolicyEagerFreeAssignOperatorMemoryKB
- *    Main entry point for memory quota OPTIMIZE. This function distributes the memory
- * among all operators in a more optimized way than the AUTO policy.
- *
- * This function considers not all memory-intensive operators will be active concurrently,
- * and distributes the memory accordingly.
+ * PolicyEagerFreeAssign
+ *    Distribute the memory among the operator groups of the plan, and among
+ * the operators in each group: evenly, or in proportion to the estimated
+ * working sets if useEstimates is true.
  */
-void
-PolicyEagerFreeAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memAvailableBytes)
+static void
+PolicyEagerFreeAssign(PlannedStmt *stmt, uint64 memAvailableBytes, bool useEstimates)
 {
 	PolicyEagerFreeContext ctx;
 	exec_init_plan_tree_base(&ctx.base, stmt);
@@ -909,6 +996,7 @@ PolicyEagerFreeAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memAvailableByte
 	ctx.groupNode = NULL;
 	ctx.nextGroupId = 0;
 	ctx.queryMemKB = memAvailableBytes / 1024;
+	ctx.useEstimates = useEstimates;
 	ctx.plannedStmt = stmt;
 
 #ifdef USE_ASSERT_CHECKING
@@ -953,6 +1041,34 @@ PolicyEagerFreeAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memAvailableByte
 	Assert(!result);
 }
 
+/*
+ * PolicyEagerFreeAssignOperatorMemoryKB
+ *    Main entry point for memory quota OPTIMIZE. This function distributes the memory
+ * among all operators in a more optimized way than the AUTO policy.
+ *
+ * This function considers not all memory-intensive operators will be active concurrently,
+ * and distributes the memory accordingly.
+ */
+void
+PolicyEagerFreeAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memAvailableBytes)
+{
+	PolicyEagerFreeAssign(stmt, memAvailableBytes, false);
+}
+
+/*
+ * PolicyEstimateAssignOperatorMemoryKB
+ *    Main entry point for memory quota ESTIMATE. This function divides the plan
+ * into operator groups like the EAGER_FREE policy does, but gives the
+ * memory-intensive operators memory in proportion to the number of rows and
+ * the row width the optimizer estimated for them, instead of the same amount
+ * to each, so that a large hash table gets what a small one doesn't need.
+ */
+void
+PolicyEstimateAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memAvailableBytes)
+{
+	PolicyEagerFreeAssign(stmt, memAvailableBytes, true);
+}
+
 /*
  * Calculate the amount of memory reserved for the query
  */
@@ -593,7 +593,8 @@ ResLockPortal(Portal portal, QueryDesc *qDesc)
 				if (!IsResManagerMemoryPolicyNone())
 				{
 					Assert(IsResManagerMemoryPolicyAuto() ||
-						   IsResManagerMemoryPolicyEagerFree());
+						   IsResManagerMemoryPolicyEagerFree() ||
+						   IsResManagerMemoryPolicyEstimate());
 					
 					uint64 queryMemory = qDesc->plannedstmt->query_mem;
 					Assert(queryMemory > 0);
@@ -632,7 +633,8 @@ ResLockPortal(Portal portal, QueryDesc *qDesc)
 				if (!IsResManagerMemoryPolicyNone())
 				{
 					Assert(IsResManagerMemoryPolicyAuto() ||
-						   IsResManagerMemoryPolicyEagerFree());
+						   IsResManagerMemoryPolicyEagerFree() ||
+						   IsResManagerMemoryPolicyEstimate());
 					
 					uint64 queryMemory = qDesc->plannedstmt->query_mem;
 					Assert(queryMemory > 0);
@@ -157,6 +157,7 @@ static void ltsWriteBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer);
 static void ltsReadBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer);
 static long ltsGetFreeBlock(LogicalTapeSet *lts);
 static void ltsReleaseBlock(LogicalTapeSet *lts, int64 blocknum);
+static void ltsPrefetchNextBlock(LogicalTapeSet *lts, LogicalTape *lt);
 
 /*
  * Writes state of a LogicalTapeSet to a state file
@@ -272,6 +273,21 @@ ltsReadBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer)
 	}
 }
 
+/*
+ * Start reading the block after the current one of a tape being read.
+ *
+ * A merge reads its input tapes in turns, and their blocks are scattered over
+ * the file, so the OS can't read ahead for them.  Asking for the next block
+ * of a tape when reading one lets the reads of all the tapes proceed while
+ * the merge consumes the current blocks.
+ */
+static void
+ltsPrefetchNextBlock(LogicalTapeSet *lts, LogicalTape *lt)
+{
+	if (lt->currBlk.next_blk != -1L)
+		BufFilePrefetchBlock(lts->pfile, lt->currBlk.next_blk);
+}
+
 /*
  * qsort comparator for sorting freeBlocks[] into decreasing order.
  */
@@ -432,6 +448,15 @@ LogicalTapeSetCreate_File(BufFile *ewfile, int ntapes)
 	return lts;
 }
 
+/*
+ * Account the writes to the tape set's file to a plan node.
+ */
+void
+LogicalTapeSetInstrument(LogicalTapeSet *lts, struct Instrumentation *instr)
+{
+	BufFileSetInstrument(lts->pfile, instr);
+}
+
 /*
  * Close a logical tape set and release all resources.
  */
@@ -536,6 +561,7 @@ LogicalTapeRewind(LogicalTapeSet *lts, LogicalTape *lt, bool forWrite)
 
 				if(lt->currPos.blkNum != lt->firstBlkNum)
 					ltsReadBlock(lts, lt->firstBlkNum, &lt->currBlk);
+				ltsPrefetchNextBlock(lts, lt);
 			}
 			
 			lt->currPos.blkNum = lt->firstBlkNum;
@@ -550,7 +576,10 @@ LogicalTapeRewind(LogicalTapeSet *lts, LogicalTape *lt, bool forWrite)
 			 */
 			Assert(lt->frozen);
 			if(lt->currPos.blkNum != lt->firstBlkNum)
+			{
 				ltsReadBlock(lts, lt->firstBlkNum, &lt->currBlk);
+				ltsPrefetchNextBlock(lts, lt);
+			}
 
 			lt->currPos.blkNum = lt->firstBlkNum;
 			lt->currPos.offset = 0;
@@ -605,6 +634,7 @@ LogicalTapeRead(LogicalTapeSet *lts, LogicalTape *lt,
 			lt->currPos.blkNum = lt->currBlk.next_blk;
 			lt->currPos.offset = 0;
 			ltsReadBlock(lts, lt->currBlk.next_blk, &lt->currBlk);
+			ltsPrefetchNextBlock(lts, lt);
 
 			if(!lt->frozen)
 			{
@@ -2068,6 +2068,8 @@ inittapes(Tuplesortstate *state, const char* rwfile_prefix)
 		state->tapeset = LogicalTapeSetCreate_File(tape_file, maxTapes);
 	}
 
+	LogicalTapeSetInstrument(state->tapeset, state->instrument);
+
 	state->mergeactive = (bool *) palloc0(maxTapes * sizeof(bool));
 	state->mergenext = (int *) palloc0(maxTapes * sizeof(int));
 	state->mergelast = (int *) palloc0(maxTapes * sizeof(int));
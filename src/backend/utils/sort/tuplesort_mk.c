@@ -113,11 +113,13 @@
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "utils/datum.h"
+#include "utils/date.h"
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
 #include "utils/syscache.h"
+#include "utils/timestamp.h"
 #include "utils/tuplesort.h"
 #include "utils/pg_locale.h"
 #include "utils/builtins.h"
@@ -517,6 +519,7 @@ static void tuplesort_inmem_limit_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_inmem_nolimit_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_heap_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_limit_sort(Tuplesortstate_mk *state);
+static void tuplesort_sort_entries(Tuplesortstate_mk *state);
 
 static void tupsort_refcnt(void *vp, int ref);
 
@@ -686,6 +689,8 @@ create_mksort_context(MKContext *mkctxt,
 
 	lc_guess_strxfrm_scaling_factor(&mkctxt->strxfrmScaleFactor, &mkctxt->strxfrmConstantFactor);
 
+	mkctxt->radixable = (tupdesc != NULL);
+
 	for (i = 0; i < nkeys; ++i)
 	{
 		Oid			sortFunction;
@@ -753,6 +758,21 @@ create_mksort_context(MKContext *mkctxt,
 				else if (sinfo->scanKey.sk_func.fn_addr == bttextcmp)
 					sinfo->lvtype = MKLV_TYPE_TEXT;
 			}
+
+			/*
+			 * Integers, and the types stored as ones, whose comparison
+			 * function is their natural order can be radix sorted.
+			 */
+			if (sinfo->typByVal &&
+				(sinfo->scanKey.sk_func.fn_addr == btint2cmp ||
+				 sinfo->scanKey.sk_func.fn_addr == btint4cmp ||
+				 sinfo->scanKey.sk_func.fn_addr == btint8cmp ||
+				 sinfo->scanKey.sk_func.fn_addr == date_cmp
+#ifdef HAVE_INT64_TIMESTAMP
+				 || sinfo->scanKey.sk_func.fn_addr == timestamp_cmp
+#endif
+					))
+				sinfo->radixable = true;
 		}
 		else
 		{
@@ -760,6 +780,9 @@ create_mksort_context(MKContext *mkctxt,
 			sinfo->typLen = tlen;
 		}
 		sinfo->mkctxt = mkctxt;
+
+		if (!sinfo->radixable)
+			mkctxt->radixable = false;
 	}
 }
 
@@ -1381,7 +1404,7 @@ tuplesort_performsort_mk(Tuplesortstate_mk *state)
 			 * amount of memory.  Just qsort 'em and we're done.
 			 */
 			if (!state->mkctxt.bounded)
-				mk_qsort(state->entries, state->entry_count, &state->mkctxt);
+				tuplesort_sort_entries(state);
 			else
 				tuplesort_limit_sort(state);
 
@@ -1899,6 +1922,8 @@ inittapes_mk(Tuplesortstate_mk *state, const char *rwfile_prefix)
 		state->tapeset = LogicalTapeSetCreate_File(tape_file, maxTapes);
 	}
 
+	LogicalTapeSetInstrument(state->tapeset, state->instrument);
+
 	state->mergeactive = (bool *) palloc0(maxTapes * sizeof(bool));
 	state->mergenext = (int *) palloc0(maxTapes * sizeof(int));
 	state->mergelast = (int *) palloc0(maxTapes * sizeof(int));
@@ -3735,6 +3760,24 @@ tuplesort_heap_insert(Tuplesortstate_mk *state, MKEntry *e)
 	}
 }
 
+/*
+ * Sort the entries in memory, with a radix sort when the keys allow it and
+ * its buffers fit in the remaining memory, and with mk_qsort otherwise.
+ */
+static void
+tuplesort_sort_entries(Tuplesortstate_mk *state)
+{
+	if (state->mkctxt.radixable &&
+		!state->mkctxt.unique &&
+		!state->mkctxt.enforceUnique &&
+		state->entry_count >= MK_RADIX_MIN_ENTRIES &&
+		state->memAllowed - (int64) MemoryContextGetCurrentSpace(state->sortcontext) >=
+		(int64) mk_radix_sort_space(state->entry_count, &state->mkctxt))
+		mk_radix_sort(state->entries, state->entry_count, &state->mkctxt);
+	else
+		mk_qsort(state->entries, state->entry_count, &state->mkctxt);
+}
+
 static void
 tuplesort_limit_sort(Tuplesortstate_mk *state)
 {
@@ -20,6 +20,7 @@
 
 #include "postgres.h"
 #include "access/genam.h"
+#include "access/nbtree.h"
 #include "utils/tuplesort.h"
 #include "utils/tuplesort_mk.h"
 #include "utils/tuplesort_mk_details.h"
@@ -350,6 +351,222 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 #endif
 }
 
+/*
+ * Memory mk_radix_sort allocates to sort n entries.
+ */
+Size
+mk_radix_sort_space(int n, MKContext *ctxt)
+{
+	return (Size) n * (2 * sizeof(uint64) + 3 * sizeof(int32));
+}
+
+/*
+ * Normalize a datum of a radixable level, so that the unsigned order of
+ * the keys is the order of the level.
+ */
+static inline uint64
+mk_radix_key(Datum d, MKLvContext *lvctxt, uint64 *mask)
+{
+	uint64		key;
+
+	switch (lvctxt->typLen)
+	{
+		case 2:
+			key = (uint16) DatumGetInt16(d) ^ UINT64CONST(0x8000);
+			*mask = UINT64CONST(0xFFFF);
+			break;
+		case 4:
+			key = (uint32) DatumGetInt32(d) ^ UINT64CONST(0x80000000);
+			*mask = UINT64CONST(0xFFFFFFFF);
+			break;
+		case 8:
+			key = (uint64) DatumGetInt64(d) ^ UINT64CONST(0x8000000000000000);
+			*mask = ~UINT64CONST(0);
+			break;
+		default:
+			elog(ERROR, "unexpected length %d of radix sort key", lvctxt->typLen);
+			return 0;
+	}
+
+	if ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0)
+		key = *mask - key;
+
+	return key;
+}
+
+/*
+ * LSD radix sort of entries whose levels are all radixable.
+ *
+ * The levels are sorted from the last to the first, each with a stable
+ * radix sort of its datums normalized to unsigned keys, one byte at a time,
+ * so no comparison function is called. Bytes that are the same in all the
+ * keys are skipped. The nulls of a level are kept in order at the front or
+ * at the back. The resulting permutation is applied to the entries at the
+ * end, which are left prepared at level 0 like mk_qsort leaves them.
+ */
+void
+mk_radix_sort(MKEntry *a, int n, MKContext *ctxt)
+{
+	uint64	   *keys = (uint64 *) palloc(n * sizeof(uint64));
+	uint64	   *keys2 = (uint64 *) palloc(n * sizeof(uint64));
+	int32	   *perm = (int32 *) palloc(n * sizeof(int32));
+	int32	   *idx = (int32 *) palloc(n * sizeof(int32));
+	int32	   *idx2 = (int32 *) palloc(n * sizeof(int32));
+	int			counts[sizeof(uint64)][256];
+	int			i;
+	int			lv;
+
+	Assert(ctxt->radixable && !ctxt->unique && !ctxt->enforceUnique);
+	Assert(ctxt->fetchForPrep != NULL);
+
+	for (i = 0; i < n; i++)
+		perm[i] = i;
+
+	for (lv = ctxt->total_lv - 1; lv >= 0; lv--)
+	{
+		MKLvContext *lvctxt = ctxt->lvctxt + lv;
+		uint64		mask = 0;
+		int			nnulls = 0;
+		int			nvalues = 0;
+		int			byte;
+		uint64	   *src_keys = keys;
+		uint64	   *dst_keys = keys2;
+		int32	   *src_idx = idx;
+		int32	   *dst_idx = idx2;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (QueryFinishPending)
+			break;
+
+		memset(counts, 0, sizeof(counts));
+
+		/*
+		 * Collect the keys in the current order. The nulls are moved to the
+		 * front of perm as they are found, which keeps their order.
+		 */
+		for (i = 0; i < n; i++)
+		{
+			MKEntry    *e = a + perm[i];
+			Datum		d;
+			bool		isnull;
+			uint64		key;
+
+			if (lv == 0)
+			{
+				tupsort_prepare(e, ctxt, 0);
+				mke_set_lv(e, 0);
+				d = e->d;
+				isnull = mke_is_null(e);
+			}
+			else
+				d = (ctxt->fetchForPrep) (e, ctxt, lvctxt, &isnull);
+
+			if (isnull)
+			{
+				perm[nnulls++] = perm[i];
+				continue;
+			}
+
+			key = mk_radix_key(d, lvctxt, &mask);
+			for (byte = 0; byte < lvctxt->typLen; byte++)
+				counts[byte][(key >> (byte * 8)) & 0xFF]++;
+
+			keys[nvalues] = key;
+			idx[nvalues] = perm[i];
+			nvalues++;
+		}
+
+		/* Stable counting sort by each byte, from the least significant */
+		for (byte = 0; byte < lvctxt->typLen && nvalues > 1; byte++)
+		{
+			int			offset = 0;
+			int			digit;
+
+			if (counts[byte][(src_keys[0] >> (byte * 8)) & 0xFF] == nvalues)
+				continue;
+
+			for (digit = 0; digit < 256; digit++)
+			{
+				int			count = counts[byte][digit];
+
+				counts[byte][digit] = offset;
+				offset += count;
+			}
+
+			for (i = 0; i < nvalues; i++)
+			{
+				int			pos = counts[byte][(src_keys[i] >> (byte * 8)) & 0xFF]++;
+
+				dst_keys[pos] = src_keys[i];
+				dst_idx[pos] = src_idx[i];
+			}
+
+			/* The sorted keys are the input of the next byte */
+			{
+				uint64	   *tmp_keys = src_keys;
+				int32	   *tmp_idx = src_idx;
+
+				src_keys = dst_keys;
+				dst_keys = tmp_keys;
+				src_idx = dst_idx;
+				dst_idx = tmp_idx;
+			}
+		}
+
+		if ((lvctxt->scanKey.sk_flags & SK_BT_NULLS_FIRST) != 0)
+			memcpy(perm + nnulls, src_idx, nvalues * sizeof(int32));
+		else
+		{
+			memmove(perm + nvalues, perm, nnulls * sizeof(int32));
+			memcpy(perm, src_idx, nvalues * sizeof(int32));
+		}
+	}
+
+	/*
+	 * Move the entries into place, following the cycles of the permutation:
+	 * the entry at perm[i] goes to i.
+	 */
+	if (!QueryFinishPending)
+	{
+		for (i = 0; i < n; i++)
+		{
+			MKEntry		tmp;
+			int			j;
+
+			if (perm[i] < 0 || perm[i] == i)
+				continue;
+
+			tmp = a[i];
+			j = i;
+			for (;;)
+			{
+				int			k = perm[j];
+
+				perm[j] = -1;
+				if (k == i)
+				{
+					a[j] = tmp;
+					break;
+				}
+				a[j] = a[k];
+				j = k;
+			}
+		}
+	}
+
+	pfree(keys);
+	pfree(keys2);
+	pfree(perm);
+	pfree(idx);
+	pfree(idx2);
+
+#ifdef MKQSORT_VERIFY 
+	if (!QueryFinishPending)
+		mkqsort_verify(a, 0, n - 1, ctxt);
+#endif
+}
+
 #ifdef MKQSORT_VERIFY 
 static int mkqsort_comp_entry_all_lv(MKEntry *a, MKEntry *b, MKContext *mkctxt)
 {
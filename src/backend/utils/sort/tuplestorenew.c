@@ -17,12 +17,36 @@
  *		Each page's slot table grows from end to beginning (using the same byte
  *		array) and the data grows from beginning to end. Therefore, all the slot
  *		indexes are negative.
+ *
+ *		A store shared across slices (readerwriter) is written to files by the
+ *		writer, for the readers to read.  If all of it still fits in the memory
+ *		of the writer when it's flushed, the pages are copied into a dynamic
+ *		shared memory segment instead, as long as the segment stays under
+ *		gp_shareinput_shmem_size with the segments of other stores.  The files
+ *		are only created once the writer runs out of memory.  The segment of a
+ *		store is found by the readers by its file name, in a hash table in
+ *		shared memory.
+ *
+ *		When gp_materialize_compression is on, the pages an ordinary store
+ *		evicts are compressed with pglz and kept in memory instead of being
+ *		written to the file, for up to 3/4 of the memory of the store.  The
+ *		tuples of a page often share their values with the ones next to them,
+ *		which makes the pages compress well, so several times more tuples fit
+ *		in memory before the store spills, and rescans read them from there.
+ *		A page that doesn't compress, or doesn't fit, goes to the file, at the
+ *		same offset as without compression.
  */
 
 #include "postgres.h"
 #include "access/heapam.h"
 #include "executor/instrument.h"
+#include "miscadmin.h"
 #include "storage/buffile.h"
+#include "storage/dsm.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/hsearch.h"
+#include "utils/pg_lzcompress.h"
 #include "utils/tuplestorenew.h"
 #include "utils/memutils.h"
 
@@ -231,6 +255,24 @@ static inline void update_page_slot_entry(NTupleStorePage *page, int len)
 #define NTS_IS_WRITER 2
 #define NTS_IS_READER 3
 
+/* Stores in shared memory, by file name */
+#define NTS_SHMEM_NAME_LEN 64
+
+typedef struct NTupleStoreShmemEntry
+{
+	char name[NTS_SHMEM_NAME_LEN];	/* hash key, must be first */
+	dsm_handle handle;				/* segment holding the pages */
+	Size size;						/* bytes of the segment */
+} NTupleStoreShmemEntry;
+
+typedef struct NTupleStoreShmemData
+{
+	Size used;						/* bytes of all the segments */
+} NTupleStoreShmemData;
+
+static NTupleStoreShmemData *NTupleStoreShmem = NULL;
+static HTAB *NTupleStoreShmemHash = NULL;
+
 struct NTupleStore
 {
 	int page_max;   /* max page the store can use */
@@ -250,6 +292,17 @@ struct NTupleStore
 	BufFile *pfile; 	/* underlying backed file */
 	BufFile *plobfile;  /* underlying backed file for lobs (entries does not fit one page) */
 	int64     lobbytes;  /* number of bytes written to lob file */
+	char *rwfilename;	/* name of the files of a writer, created on demand */
+
+	dsm_segment *shm_seg;	/* shared memory holding the pages of readerwriter */
+	char *shm_pages;		/* pages in shm_seg, for a reader */
+	long shm_nblocks;		/* number of pages in shm_seg */
+
+	bool compress;			/* keep the evicted pages compressed in memory */
+	PGLZ_Header **zpages;	/* compressed pages by blockn on disk, or NULL */
+	long zpages_size;		/* allocated length of zpages */
+	Size zbytes;			/* bytes of the compressed pages */
+	PGLZ_Header *zbuf;		/* buffer to compress a page into */
 
 	List *accessors;    /* all current accessors of the store */
 	bool fwacc; 		/* if I had already has a write acc */
@@ -288,6 +341,8 @@ struct NTupleStoreAccessor
 
 static void ntuplestore_init_reader(NTupleStore *store, int maxBytes);
 static void ntuplestore_create_spill_files(NTupleStore *nts);
+static bool ntuplestore_publish_shmem(NTupleStore *nts);
+static bool ntuplestore_attach_shmem(NTupleStore *nts, const char *filename);
 
 void ntuplestore_setinstrument(NTupleStore *st, struct Instrumentation *instr)
 {
@@ -393,13 +448,26 @@ static bool ntsReadBlock(NTupleStore *ts, int blockn, NTupleStorePage *page)
 {
 	long diskblockn = blockn - ts->first_ondisk_blockn;
 
-	if(!ts->pfile)
+	if(!ts->pfile && !ts->shm_pages && !ts->zpages)
 		return false;
 	
 	Assert(ts->first_ondisk_blockn >= 0);
 	Assert(ts && diskblockn >= 0 && page);
-	if (BufFileSeek(ts->pfile, 0 /* fileno */, diskblockn * BLCKSZ, SEEK_SET) != 0 ||
-		BufFileRead(ts->pfile, page, BLCKSZ) != BLCKSZ)
+	if (diskblockn < ts->zpages_size && ts->zpages[diskblockn])
+	{
+		Assert(PGLZ_RAW_SIZE(ts->zpages[diskblockn]) == BLCKSZ);
+		pglz_decompress(ts->zpages[diskblockn], (char *) page);
+	}
+	else if (ts->shm_pages)
+	{
+		if (diskblockn >= ts->shm_nblocks)
+			return false;
+
+		memcpy(page, ts->shm_pages + diskblockn * BLCKSZ, BLCKSZ);
+	}
+	else if (!ts->pfile ||
+			 BufFileSeek(ts->pfile, 0 /* fileno */, diskblockn * BLCKSZ, SEEK_SET) != 0 ||
+			 BufFileRead(ts->pfile, page, BLCKSZ) != BLCKSZ)
 	{
 		return false;
 	}
@@ -414,6 +482,60 @@ static bool ntsReadBlock(NTupleStore *ts, int blockn, NTupleStorePage *page)
 	return true;
 }
 
+/*
+ * Keep a page compressed in memory instead of writing it, if it compresses
+ * and fits in 3/4 of the memory of the store.  Returns false otherwise.
+ */
+static bool
+ntsCompressBlock(NTupleStore *ts, NTupleStorePage *page, long blocknum)
+{
+	Size		zlen;
+	Size		zbytes_max;
+
+	if (!ts->compress)
+		return false;
+
+	Assert(ts->rwflag == NTS_NOT_READERWRITER);
+
+	/* the free space between the data and the slots may hold old data */
+	memset(nts_page_next_slot_data_ptr(page), 0, nts_page_avail_bytes(page));
+
+	if (ts->zbuf == NULL)
+		ts->zbuf = (PGLZ_Header *) MemoryContextAlloc(ts->mcxt, PGLZ_MAX_OUTPUT(BLCKSZ));
+
+	if (!pglz_compress((char *) page, BLCKSZ, ts->zbuf, PGLZ_strategy_default))
+		return false;
+
+	zlen = VARSIZE(ts->zbuf);
+	zbytes_max = (Size) (ts->page_max - (ts->page_max >> 2)) * BLCKSZ;
+	if (ts->zbytes + zlen > zbytes_max)
+		return false;
+
+	if (blocknum >= ts->zpages_size)
+	{
+		long		newsize = Max(blocknum + 1, ts->zpages_size * 2);
+
+		if (ts->zpages == NULL)
+			ts->zpages = (PGLZ_Header **)
+				MemoryContextAllocZero(ts->mcxt, newsize * sizeof(PGLZ_Header *));
+		else
+		{
+			ts->zpages = (PGLZ_Header **)
+				repalloc(ts->zpages, newsize * sizeof(PGLZ_Header *));
+			memset(ts->zpages + ts->zpages_size, 0,
+				   (newsize - ts->zpages_size) * sizeof(PGLZ_Header *));
+		}
+		ts->zpages_size = newsize;
+	}
+
+	Assert(ts->zpages[blocknum] == NULL);
+	ts->zpages[blocknum] = (PGLZ_Header *) MemoryContextAlloc(ts->mcxt, zlen);
+	memcpy(ts->zpages[blocknum], ts->zbuf, zlen);
+	ts->zbytes += zlen;
+
+	return true;
+}
+
 /* write a page */
 static void
 ntsWriteBlock(NTupleStore *ts, NTupleStorePage *page)
@@ -435,6 +557,11 @@ ntsWriteBlock(NTupleStore *ts, NTupleStorePage *page)
 	nts_page_set_dirty(page, false);
 
 	blocknum = nts_page_blockn(page) - ts->first_ondisk_blockn;
+	if (ntsCompressBlock(ts, page, blocknum))
+		return;
+
+	ntuplestore_create_spill_files(ts);
+
 	if (BufFileSeek(ts->pfile, 0 /* fileno */, blocknum * BLCKSZ, SEEK_SET) != 0 ||
 		BufFileWrite(ts->pfile, page, BLCKSZ) != BLCKSZ)
 	{
@@ -476,6 +603,9 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 	/* use 1/4 of max allowed if we are working with a disk file */
 	if(nts->pfile)
 		page_max >>= 2;
+	/* the compressed pages take the memory of as many pages, up to 3/4 */
+	else if(nts->zbytes > 0)
+		page_max -= (nts->zbytes + BLCKSZ - 1) / BLCKSZ;
 
 	if(nts->page_cnt >= page_max)
 	{
@@ -491,8 +621,6 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 
 				if(nts_page_is_dirty(page_next))
 				{
-					ntuplestore_create_spill_files(nts);
-
 					Assert(nts->rwflag != NTS_IS_READER);
 					ntsWriteBlock(nts, page_next);
 				}
@@ -527,7 +655,7 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 
 	if(nts->instrument && nts->instrument->need_cdb)
 	{
-		nts->instrument->workmemused = Max(nts->instrument->workmemused, nts->page_cnt * BLCKSZ); 
+		nts->instrument->workmemused = Max(nts->instrument->workmemused, nts->page_cnt * BLCKSZ + nts->zbytes); 
 		if(nts->last_page)
 		{
 			long pagewanted = nts_page_blockn(nts->last_page) - nts_page_blockn(nts->first_page) + 1;
@@ -678,6 +806,24 @@ ntuplestore_destroy(NTupleStore *ts)
 		p = pnext;
 	}
 
+	if(ts->zpages)
+	{
+		long		i;
+
+		for (i = 0; i < ts->zpages_size; i++)
+		{
+			if (ts->zpages[i])
+				pfree(ts->zpages[i]);
+		}
+		pfree(ts->zpages);
+		ts->zpages = NULL;
+	}
+	if(ts->zbuf)
+	{
+		pfree(ts->zbuf);
+		ts->zbuf = NULL;
+	}
+
 	if(ts->pfile)
 	{
 		BufFileClose(ts->pfile);
@@ -688,6 +834,12 @@ ntuplestore_destroy(NTupleStore *ts)
 		BufFileClose(ts->plobfile);
 		ts->plobfile = NULL;
 	}
+	if(ts->shm_seg)
+	{
+		dsm_detach(ts->shm_seg);
+		ts->shm_seg = NULL;
+		ts->shm_pages = NULL;
+	}
 
 	if (ts->work_set != NULL)
 	{
@@ -709,6 +861,17 @@ ntuplestore_create_common(int64 maxBytes, char *operation_name)
 
 	store->plobfile = NULL;
 	store->lobbytes = 0;
+	store->rwfilename = NULL;
+
+	store->shm_seg = NULL;
+	store->shm_pages = NULL;
+	store->shm_nblocks = 0;
+
+	store->compress = false;
+	store->zpages = NULL;
+	store->zpages_size = 0;
+	store->zbytes = 0;
+	store->zbuf = NULL;
 
 	store->work_set = NULL;
 	store->operation_name = operation_name;
@@ -746,6 +909,9 @@ ntuplestore_create_common(int64 maxBytes, char *operation_name)
  *
  *   filename must be a unique name that identifies the share.
  *   filename does not include the pgsql_tmp/ prefix
+ *
+ * The files of the writer are created when it first runs out of memory, or
+ * when it's flushed and can't be put in shared memory.
  */
 NTupleStore *
 ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWriter)
@@ -760,25 +926,25 @@ ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWri
 		store = ntuplestore_create_common(maxBytes, "SharedTupleStore");
 		store->rwflag = NTS_IS_WRITER;
 		store->lobbytes = 0;
-		store->work_set = workfile_mgr_create_set(store->operation_name, filename);
-		store->pfile = BufFileCreateNamedTemp(filename,
-											  false /* interXact */,
-											  store->work_set);
-		store->plobfile = BufFileCreateNamedTemp(filenamelob,
-												 false /* interXact */,
-												 store->work_set);
+		store->rwfilename = pstrdup(filename);
 	}
 	else
 	{
 		store = (NTupleStore *) palloc(sizeof(NTupleStore));
 		store->mcxt = CurrentMemoryContext;
 		store->work_set = NULL;
+		store->rwfilename = NULL;
+		store->pfile = NULL;
+		store->plobfile = NULL;
 
-		store->pfile = BufFileOpenNamedTemp(filename,
-											false /* interXact */);
+		if (!ntuplestore_attach_shmem(store, filename))
+		{
+			store->pfile = BufFileOpenNamedTemp(filename,
+												false /* interXact */);
 
-		store->plobfile = BufFileOpenNamedTemp(filenamelob,
-											false /* interXact */);
+			store->plobfile = BufFileOpenNamedTemp(filenamelob,
+												false /* interXact */);
+		}
 
 		ntuplestore_init_reader(store, maxBytes);
 	}
@@ -794,13 +960,19 @@ static void
 ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 {
 	Assert(NULL != store);
-	Assert(NULL != store->pfile);
-	Assert(NULL != store->plobfile);
+	Assert(NULL != store->shm_pages || NULL != store->pfile);
+	Assert(NULL != store->shm_pages || NULL != store->plobfile);
 	
 	store->first_ondisk_blockn = 0;
 	store->rwflag = NTS_IS_READER;
 	store->lobbytes = 0;
 
+	store->compress = false;
+	store->zpages = NULL;
+	store->zpages_size = 0;
+	store->zbytes = 0;
+	store->zbuf = NULL;
+
 	Assert(maxBytes >= 0);
 	store->page_max = maxBytes / BLCKSZ;
 	/* give me at least 16 pages */
@@ -846,6 +1018,7 @@ ntuplestore_create(int64 maxBytes, char *operation_name)
 	/* The work set will be created on demand */
 	store->work_set = NULL;
 	store->rwflag = NTS_NOT_READERWRITER;
+	store->compress = gp_materialize_compression;
 
 	return store;
 }
@@ -856,7 +1029,11 @@ ntuplestore_flush(NTupleStore *ts)
 	NTupleStorePage *p = ts->first_page;
 
 	Assert(ts->rwflag != NTS_IS_READER || !"Flush attempted for Reader");
-	Assert(ts->pfile);
+
+	if (ts->rwflag == NTS_IS_WRITER && ntuplestore_publish_shmem(ts))
+		return;
+
+	ntuplestore_create_spill_files(ts);
 
 	while(p)
 	{
@@ -1382,21 +1559,228 @@ ntuplestore_create_spill_files(NTupleStore *nts)
 	}
 
 	Assert(!nts->work_set);
-	nts->work_set = workfile_mgr_create_set(nts->operation_name, NULL);
+	Assert(!nts->shm_seg);
 
 	oldcxt = MemoryContextSwitchTo(nts->mcxt);
 
-	nts->pfile = BufFileCreateNamedTemp("data",
-										false /* interXact */,
-										nts->work_set);
-	nts->plobfile = BufFileCreateNamedTemp("lob",
-										   false /* interXact */,
-										   nts->work_set);
+	if (nts->rwflag == NTS_IS_WRITER)
+	{
+		char		filenamelob[MAXPGPATH];
+
+		snprintf(filenamelob, sizeof(filenamelob), "%s_LOB", nts->rwfilename);
+
+		nts->work_set = workfile_mgr_create_set(nts->operation_name, nts->rwfilename);
+		nts->pfile = BufFileCreateNamedTemp(nts->rwfilename,
+											false /* interXact */,
+											nts->work_set);
+		nts->plobfile = BufFileCreateNamedTemp(filenamelob,
+											   false /* interXact */,
+											   nts->work_set);
+	}
+	else
+	{
+		nts->work_set = workfile_mgr_create_set(nts->operation_name, NULL);
+		nts->pfile = BufFileCreateNamedTemp("data",
+											false /* interXact */,
+											nts->work_set);
+		nts->plobfile = BufFileCreateNamedTemp("lob",
+											   false /* interXact */,
+											   nts->work_set);
+	}
 
 	MemoryContextSwitchTo(oldcxt);
 
+	BufFileSetInstrument(nts->pfile, nts->instrument);
+	BufFileSetInstrument(nts->plobfile, nts->instrument);
+
 	if (nts->instrument)
 		nts->instrument->workfileCreated = true;
 }
 
+/*
+ * Size of the shared memory to look up the stores in shared memory.
+ */
+Size
+ntuplestore_shmem_size(void)
+{
+	if (dynamic_shared_memory_type == DSM_IMPL_NONE)
+		return 0;
+
+	return add_size(MAXALIGN(sizeof(NTupleStoreShmemData)),
+					hash_estimate_size(MaxBackends, sizeof(NTupleStoreShmemEntry)));
+}
+
+void
+ntuplestore_shmem_init(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (dynamic_shared_memory_type == DSM_IMPL_NONE)
+		return;
+
+	NTupleStoreShmem = (NTupleStoreShmemData *)
+		ShmemInitStruct("Shared Tuplestore Data", sizeof(NTupleStoreShmemData), &found);
+	if (!found)
+		NTupleStoreShmem->used = 0;
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = NTS_SHMEM_NAME_LEN;
+	info.entrysize = sizeof(NTupleStoreShmemEntry);
+
+	NTupleStoreShmemHash = ShmemInitHash("Shared Tuplestore Hash",
+										 MaxBackends, MaxBackends,
+										 &info, HASH_ELEM);
+}
+
+/*
+ * Forget the store in shared memory once the writer detaches its segment,
+ * the readers still attached keep the segment itself.
+ */
+static void
+ntuplestore_shmem_detach_callback(dsm_segment *seg, Datum arg)
+{
+	NTupleStoreShmemEntry *entry = (NTupleStoreShmemEntry *) DatumGetPointer(arg);
+
+	LWLockAcquire(NTupleStoreShmemLock, LW_EXCLUSIVE);
+	NTupleStoreShmem->used -= entry->size;
+	hash_search(NTupleStoreShmemHash, entry->name, HASH_REMOVE, NULL);
+	LWLockRelease(NTupleStoreShmemLock);
+}
+
+/*
+ * Copy the pages of a writer into shared memory for the readers, if none of
+ * them has been written out.  Return false if the store must be written to
+ * the files instead.
+ */
+static bool
+ntuplestore_publish_shmem(NTupleStore *nts)
+{
+	NTupleStorePage *page;
+	NTupleStoreShmemEntry *entry;
+	dsm_segment *seg;
+	char	   *dst;
+	long		nblocks = 0;
+	Size		size;
+	Size		limit = (Size) gp_shareinput_shmem_size * 1024;
+	bool		found;
+
+	Assert(nts->rwflag == NTS_IS_WRITER);
+
+	if (nts->shm_seg)
+		return true;
+
+	if (NTupleStoreShmem == NULL || nts->pfile || nts->lobbytes > 0 ||
+		strlen(nts->rwfilename) >= NTS_SHMEM_NAME_LEN)
+		return false;
+
+	/* Without files no page has been evicted, the first one may be empty */
+	for (page = nts->first_page; page; page = nts_page_next(page))
+	{
+		Assert(nts_page_blockn(page) == nblocks);
+		if (nblocks > 0 && nts_page_slot_cnt(page) == 0)
+			break;
+		nblocks++;
+	}
+
+	size = (Size) nblocks * BLCKSZ;
+
+	/* don't bother creating the segment if it can't fit */
+	if (size > limit || NTupleStoreShmem->used > limit - size)
+		return false;
+
+	/* other users may have taken all the segment slots */
+	seg = dsm_create(size, DSM_CREATE_NULL_IF_MAXSEGMENTS);
+	if (seg == NULL)
+		return false;
+
+	dst = dsm_segment_address(seg);
+	for (page = nts->first_page; nblocks > 0; page = nts_page_next(page), nblocks--)
+	{
+		NTupleStorePage *copy = (NTupleStorePage *) dst;
+
+		memcpy(copy, page, BLCKSZ);
+		nts_page_set_dirty(copy, false);
+		dst += BLCKSZ;
+	}
+
+	LWLockAcquire(NTupleStoreShmemLock, LW_EXCLUSIVE);
+
+	entry = NULL;
+	if (NTupleStoreShmem->used <= limit - size)
+	{
+		entry = (NTupleStoreShmemEntry *) hash_search(NTupleStoreShmemHash,
+													  nts->rwfilename,
+													  HASH_ENTER_NULL, &found);
+		if (entry != NULL && found)
+			entry = NULL;
+	}
+
+	if (entry != NULL)
+	{
+		entry->handle = dsm_segment_handle(seg);
+		entry->size = size;
+		NTupleStoreShmem->used += size;
+	}
+
+	LWLockRelease(NTupleStoreShmemLock);
+
+	if (entry == NULL)
+	{
+		dsm_detach(seg);
+		return false;
+	}
+
+	on_dsm_detach(seg, ntuplestore_shmem_detach_callback, PointerGetDatum(entry));
+	nts->shm_seg = seg;
+	nts->shm_nblocks = (long) (size / BLCKSZ);
+
+	return true;
+}
+
+/*
+ * Attach a reader to the pages its writer put in shared memory.  Return false
+ * if the writer wrote them to the files.
+ */
+static bool
+ntuplestore_attach_shmem(NTupleStore *nts, const char *filename)
+{
+	NTupleStoreShmemEntry *entry;
+	dsm_handle	handle = 0;
+	Size		size = 0;
+	dsm_segment *seg;
+
+	nts->shm_seg = NULL;
+	nts->shm_pages = NULL;
+	nts->shm_nblocks = 0;
+
+	if (NTupleStoreShmem == NULL || strlen(filename) >= NTS_SHMEM_NAME_LEN)
+		return false;
+
+	LWLockAcquire(NTupleStoreShmemLock, LW_SHARED);
+	entry = (NTupleStoreShmemEntry *) hash_search(NTupleStoreShmemHash, filename,
+												  HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		handle = entry->handle;
+		size = entry->size;
+	}
+	LWLockRelease(NTupleStoreShmemLock);
+
+	if (entry == NULL)
+		return false;
+
+	/* the writer keeps the segment until all the readers are done */
+	seg = dsm_attach(handle);
+	if (seg == NULL)
+		elog(ERROR, "could not attach to shared memory of shared tuplestore \"%s\"",
+			 filename);
+
+	nts->shm_seg = seg;
+	nts->shm_pages = dsm_segment_address(seg);
+	nts->shm_nblocks = (long) (size / BLCKSZ);
+
+	return true;
+}
+
 /* EOF */
@@ -33,6 +33,8 @@ extern bool AppendOnlyCompaction_ShouldCompact(
 								   int64 segmentTotalTupcount,
 								   bool isFull,
 								   Snapshot appendOnlyMetaDataSnapshot);
+extern void AppendOnlyCompaction_DelayPoint(double bytesRead,
+								double bytesWritten);
 extern void AppendOnlyThrowAwayTuple(Relation rel,
 						 TupleTableSlot *slot, MemTupleBinding *mt_bind);
 extern void AppendOnlyTruncateToEOF(Relation aorel);
@@ -35,6 +35,18 @@
 #define APPENDONLY_VISIMAP_MAX_RANGE 32768
 #define APPENDONLY_VISIMAP_MAX_BITMAP_SIZE 4096
 
+/*
+ * Decompressed bitmap of a visibility map entry, kept by the visibility
+ * map cache.
+ */
+typedef struct AppendOnlyVisimapCacheEntry
+{
+	int64		firstRowNum;
+
+	/* Bits of the hidden rows, never empty */
+	Bitmapset  *bitmap;
+} AppendOnlyVisimapCacheEntry;
+
 /*
  * Data structure for the ao visibility map processing.
  *
@@ -57,6 +69,17 @@ typedef struct AppendOnlyVisimap
 	 */
 	AppendOnlyVisimapStore visimapStore;
 
+	/*
+	 * The entries with hidden rows of one segment file, loaded at once by
+	 * AppendOnlyVisimap_LoadSegmentFile() for scans. Sorted by first row
+	 * number. cacheSegno is -1 if no segment file is loaded.
+	 */
+	MemoryContext cacheContext;
+	int32		cacheSegno;
+	AppendOnlyVisimapCacheEntry *cacheEntries;
+	int			numCacheEntries;
+	int			currentCacheEntry;	/* last one looked up */
+
 } AppendOnlyVisimap;
 
 /*
@@ -113,6 +136,15 @@ void AppendOnlyVisimap_Finish(
 						 AppendOnlyVisimap *visiMap,
 						 LOCKMODE lockmode);
 
+void AppendOnlyVisimap_LoadSegmentFile(
+								  AppendOnlyVisimap *visiMap,
+								  int segno);
+
+int64 AppendOnlyVisimap_GetNextVisibleRowNum(
+									   AppendOnlyVisimap *visiMap,
+									   int segno,
+									   int64 rowNum);
+
 void AppendOnlyVisimap_DeleteSegmentFile(
 									AppendOnlyVisimap *visiMap,
 									int segno);
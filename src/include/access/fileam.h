@@ -56,6 +56,16 @@ typedef struct ExternalSelectDescData
 {
 	ProjectionInfo *projInfo;   /* Information for column projection */
 	List *filter_quals;         /* Information for filter pushdown */
+	ExternalScanAggType agg_type;	/* Information for aggregate pushdown */
+
+	/*
+	 * Fraction of the rows the scan should return, 1.0 for all of them.  A
+	 * protocol that can read only a part of its data cheaply may do so when
+	 * opened, and set sample_read_fraction to the fraction it reads; the
+	 * scan then returns rows at the rate that makes up the difference.
+	 */
+	double		sample_fraction;
+	double		sample_read_fraction;
 
 } ExternalSelectDescData;
 
@@ -105,6 +105,7 @@ typedef struct FileScanDescData
 	char	   *fs_uri;			/* the URI string */
 	bool		fs_noop;		/* no op. this segdb has no file to scan */
 	uint32      fs_scancounter;	/* copied from struct ExternalScan in plan */
+	double		fs_sample_keep;	/* probability of returning a row read */
 	
 	/* current file parse state */
 	struct CopyStateData *fs_pstate;
@@ -49,6 +49,9 @@ typedef FormData_gp_fastsequence *Form_gp_fastsequence;
 
 #define NUM_FAST_SEQUENCES					 100
 
+/* Most sequences an insert asks for at a time, when it expects many rows */
+#define MAX_NUM_FAST_SEQUENCES				 100000
+
 /* No initial content */
 
 /*
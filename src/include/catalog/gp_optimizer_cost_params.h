@@ -0,0 +1,66 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_optimizer_cost_params.h
+ *	  calibrated parameters of the GPORCA cost model
+ *
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/catalog/gp_optimizer_cost_params.h
+ *
+ * NOTES
+ *	  the genbki.sh script reads this file and generates .bki
+ *	  information from the DATA() statements.
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef _GP_OPTIMIZER_COST_PARAMS_H_
+#define _GP_OPTIMIZER_COST_PARAMS_H_
+
+#include "catalog/genbki.h"
+
+/*
+ * Defines for gp_optimizer_cost_params table
+ *
+ * Written by gpcalibratecost, which fits the parameters of the calibrated
+ * cost model of GPORCA (optimizer_cost_model = calibrated) to the runtimes of
+ * probe queries measured on the cluster.  Each row holds a factor that the
+ * default value and bounds of the named parameter are multiplied by, in the
+ * same way as the optimizer_*_factor GUCs.
+ */
+
+#define GpOptimizerCostParamsRelName		"gp_optimizer_cost_params"
+
+/* ----------------
+ *		gp_optimizer_cost_params definition.  cpp turns this into
+ *		typedef struct FormData_gp_optimizer_cost_params
+ * ----------------
+ */
+#define GpOptimizerCostParamsRelationId	5004
+
+CATALOG(gp_optimizer_cost_params,5004) BKI_SHARED_RELATION BKI_WITHOUT_OIDS
+{
+	NameData	paramname;		/* name of the cost model parameter */
+	float8		factor;			/* multiplier of its default value */
+} FormData_gp_optimizer_cost_params;
+
+/* no foreign keys */
+
+/* ----------------
+ *		Form_gp_optimizer_cost_params corresponds to a pointer to a tuple with
+ *		the format of gp_optimizer_cost_params relation.
+ * ----------------
+ */
+typedef FormData_gp_optimizer_cost_params *Form_gp_optimizer_cost_params;
+
+/* ----------------
+ *		compiler constants for gp_optimizer_cost_params
+ * ----------------
+ */
+#define Natts_gp_optimizer_cost_params				2
+#define Anum_gp_optimizer_cost_params_paramname		1
+#define Anum_gp_optimizer_cost_params_factor		2
+
+#endif /*_GP_OPTIMIZER_COST_PARAMS_H_*/
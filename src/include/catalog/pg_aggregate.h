@@ -349,6 +349,10 @@ DATA(insert ( 3545	n 0 bytea_string_agg_transfn		bytea_string_agg_finalfn				-	-
 
 /* hyperloglog */
 DATA(insert ( 7164	n 0 gp_hyperloglog_add_item_agg_default gp_hyperloglog_comp		gp_hyperloglog_merge	-	-	-		-		-		f f 0	7157	0	0		0	_null_ _null_ ));
+DATA(insert ( 7002	n 0 gp_hyperloglog_add_item_agg_default gp_hyperloglog_get_count	gp_hyperloglog_merge	-	-	-		-		-		f f 0	7157	0	0		0	_null_ _null_ ));
+
+/* t-digest */
+DATA(insert ( 7006	n 0 gp_tdigest_add					gp_tdigest_percentile					gp_tdigest_merge	-	-	-		-		-		f f 0	17		4848	0		0	_null_ _null_ ));
 
 /* json */
 DATA(insert ( 3175	n 0 json_agg_transfn				json_agg_finalfn						-	-	-	-		-		-		f f 0	2281	0	0		0	_null_ _null_ ));
@@ -101,6 +101,8 @@ typedef struct StorageAttributes
 	int complevel; /* compresslevel field */
 	size_t blocksize; /* blocksize field */
 	Oid	typid; /* Oid of the type being compressed */
+	Oid	relid; /* Oid of the relation being compressed, if known */
+	AttrNumber attnum; /* its column, or 0 for whole rows */
 } StorageAttributes;
 
 extern CompressionState *callCompressionConstructor(PGFunction constructor,
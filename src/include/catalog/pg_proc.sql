@@ -193,6 +193,7 @@
 
 -- Analyze related
  CREATE FUNCTION gp_acquire_sample_rows(oid, int4, bool) RETURNS SETOF record LANGUAGE internal VOLATILE STRICT EXECUTE ON ALL SEGMENTS AS 'gp_acquire_sample_rows' WITH (OID=6038, DESCRIPTION="Collect a random sample of rows from table" );
+ CREATE FUNCTION gp_relation_modcount(oid) RETURNS int8 LANGUAGE internal VOLATILE STRICT AS 'gp_relation_modcount' WITH (OID=6095, DESCRIPTION="Count of the modifications of a table on this segment");
 
 -- Backoff related
  CREATE FUNCTION gp_adjust_priority(int4, int4, int4) RETURNS int4 LANGUAGE internal VOLATILE STRICT AS 'gp_adjust_priority_int' WITH (OID=5040, DESCRIPTION="change weight of all the backends for a given session id");
@@ -304,6 +305,14 @@
  CREATE FUNCTION enable_xform(text) RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'enable_xform' WITH (OID=6088, DESCRIPTION="enables transformations in the optimizer");
 
  CREATE FUNCTION gp_opt_version() RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'gp_opt_version' WITH (OID=6089, DESCRIPTION="Returns the optimizer and gpos library versions");
+
+ CREATE FUNCTION gp_optimizer_stats(OUT num_optimizations int8, OUT translate_time float8, OUT search_time float8, OUT plan_time float8, OUT missing_stats_time float8, OUT num_mdfetches int8, OUT mdfetch_time float8, OUT peak_memory int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_optimizer_stats' WITH (OID=6090, DESCRIPTION="statistics: time spent by the optimizer in each phase, cumulative for the session");
+
+ CREATE FUNCTION gp_optimizer_captures(OUT captured_at timestamptz, OUT optimization_time float8, OUT query text, OUT minidump text) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_optimizer_captures' WITH (OID=6091, DESCRIPTION="minidumps of the slow optimizations of the session");
+
+ CREATE FUNCTION gp_optimizer_plan_trace(OUT recorded_at timestamptz, OUT fingerprint int8, OUT node_type text, OUT plan_rows float8, OUT actual_rows float8, OUT total_cost float8, OUT actual_time float8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_optimizer_plan_trace' WITH (OID=6094, DESCRIPTION="estimated and actual statistics of the plan nodes of GPORCA run by EXPLAIN ANALYZE in the session");
+
+ CREATE FUNCTION gp_optimizer_search_stages(OUT stage int4, OUT num_xforms int4, OUT num_searches int8, OUT num_plans int8, OUT num_best int8, OUT last_cost float8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_optimizer_search_stages' WITH (OID=6096, DESCRIPTION="statistics: outcome of each search stage of the optimizer, cumulative for the session");
  
  
   -- functions for the complex data type
@@ -421,6 +430,19 @@ CREATE FUNCTION gp_hyperloglog_add_item_agg_default(counter gp_hyperloglog_estim
 
 CREATE FUNCTION gp_hyperloglog_accum(anyelement) RETURNS gp_hyperloglog_estimator LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=7164, proisagg="t", DESCRIPTION="Adds every data value to a gp_hyperloglog counter and returns the counter");
 
+CREATE FUNCTION gp_hyperloglog_get_count(counter gp_hyperloglog_estimator) RETURNS int8  LANGUAGE internal IMMUTABLE STRICT AS 'gp_hyperloglog_get_count' WITH (OID=7001, DESCRIPTION="Estimates the number of distinct values stored in a gp_hyperloglog counter, rounded to an integer");
+
+CREATE FUNCTION approx_count_distinct(anyelement) RETURNS int8 LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=7002, proisagg="t", DESCRIPTION="Estimates the number of distinct input values with a gp_hyperloglog counter");
+
+-- t-digest for approximate percentiles
+CREATE FUNCTION gp_tdigest_add(digest bytea, value float8, fraction float8) RETURNS bytea LANGUAGE internal IMMUTABLE AS 'gp_tdigest_add' WITH (OID=7003, DESCRIPTION="aggregate transition function");
+
+CREATE FUNCTION gp_tdigest_merge(digest1 bytea, digest2 bytea) RETURNS bytea LANGUAGE internal IMMUTABLE AS 'gp_tdigest_merge' WITH (OID=7004, DESCRIPTION="aggregate combine function");
+
+CREATE FUNCTION gp_tdigest_percentile(digest bytea) RETURNS float8 LANGUAGE internal IMMUTABLE STRICT AS 'gp_tdigest_percentile' WITH (OID=7005, DESCRIPTION="aggregate final function");
+
+CREATE FUNCTION approx_percentile(float8, float8) RETURNS float8 LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=7006, proisagg="t", DESCRIPTION="Estimates a percentile of the input values with a t-digest");
+
 CREATE FUNCTION pg_get_table_distributedby(oid) RETURNS text LANGUAGE internal STABLE STRICT AS 'pg_get_table_distributedby' WITH (OID=6232, DESCRIPTION="deparse DISTRIBUTED BY clause for a given relation");
 
 -- hash functions for a few built-in datatypes that are missing hash support
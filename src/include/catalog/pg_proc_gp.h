@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Wed May 29 10:02:27 2019
+   on Wed Oct 14 14:02:41 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -399,6 +399,10 @@ DESCR("Greenplum fault testing only");
 DATA(insert OID = 6038 ( gp_acquire_sample_rows  PGNSP PGUID 12 1 1000 0 0 f f f f t t v 3 0 2249 "26 23 16" _null_ _null_ _null_ _null_ gp_acquire_sample_rows _null_ _null_ _null_ n s ));
 DESCR("Collect a random sample of rows from table");
 
+/* gp_relation_modcount(oid) => int8 */
+DATA(insert OID = 6095 ( gp_relation_modcount  PGNSP PGUID 12 1 0 0 0 f f f f t f v 1 0 20 "26" _null_ _null_ _null_ _null_ gp_relation_modcount _null_ _null_ _null_ n a ));
+DESCR("Count of the modifications of a table on this segment");
+
 
 /* Backoff related */
 /* gp_adjust_priority(int4, int4, int4) => int4 */
@@ -619,6 +623,22 @@ DESCR("enables transformations in the optimizer");
 DATA(insert OID = 6089 ( gp_opt_version  PGNSP PGUID 12 1 0 0 0 f f f f t f i 0 0 25 "" _null_ _null_ _null_ _null_ gp_opt_version _null_ _null_ _null_ n a ));
 DESCR("Returns the optimizer and gpos library versions");
 
+/* gp_optimizer_stats(OUT num_optimizations int8, OUT translate_time float8, OUT search_time float8, OUT plan_time float8, OUT missing_stats_time float8, OUT num_mdfetches int8, OUT mdfetch_time float8, OUT peak_memory int8) => pg_catalog.record */
+DATA(insert OID = 6090 ( gp_optimizer_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v 0 0 2249 "" "{20,701,701,701,701,20,701,20}" "{o,o,o,o,o,o,o,o}" "{num_optimizations,translate_time,search_time,plan_time,missing_stats_time,num_mdfetches,mdfetch_time,peak_memory}" _null_ gp_optimizer_stats _null_ _null_ _null_ n a ));
+DESCR("statistics: time spent by the optimizer in each phase, cumulative for the session");
+
+/* gp_optimizer_captures(OUT captured_at timestamptz, OUT optimization_time float8, OUT query text, OUT minidump text) => SETOF pg_catalog.record */
+DATA(insert OID = 6091 ( gp_optimizer_captures  PGNSP PGUID 12 1 1000 0 0 f f f f f t v 0 0 2249 "" "{1184,701,25,25}" "{o,o,o,o}" "{captured_at,optimization_time,query,minidump}" _null_ gp_optimizer_captures _null_ _null_ _null_ n a ));
+DESCR("minidumps of the slow optimizations of the session");
+
+/* gp_optimizer_plan_trace(OUT recorded_at timestamptz, OUT fingerprint int8, OUT node_type text, OUT plan_rows float8, OUT actual_rows float8, OUT total_cost float8, OUT actual_time float8) => SETOF pg_catalog.record */
+DATA(insert OID = 6094 ( gp_optimizer_plan_trace  PGNSP PGUID 12 1 1000 0 0 f f f f f t v 0 0 2249 "" "{1184,20,25,701,701,701,701}" "{o,o,o,o,o,o,o}" "{recorded_at,fingerprint,node_type,plan_rows,actual_rows,total_cost,actual_time}" _null_ gp_optimizer_plan_trace _null_ _null_ _null_ n a ));
+DESCR("estimated and actual statistics of the plan nodes of GPORCA run by EXPLAIN ANALYZE in the session");
+
+/* gp_optimizer_search_stages(OUT stage int4, OUT num_xforms int4, OUT num_searches int8, OUT num_plans int8, OUT num_best int8, OUT last_cost float8) => SETOF pg_catalog.record */
+DATA(insert OID = 6096 ( gp_optimizer_search_stages  PGNSP PGUID 12 1 16 0 0 f f f f f t v 0 0 2249 "" "{23,23,20,20,20,701}" "{o,o,o,o,o,o}" "{stage,num_xforms,num_searches,num_plans,num_best,last_cost}" _null_ gp_optimizer_search_stages _null_ _null_ _null_ n a ));
+DESCR("statistics: outcome of each search stage of the optimizer, cumulative for the session");
+
 
   /* functions for the complex data type */
 /* complex_in(cstring) => complex */
@@ -833,6 +853,32 @@ DESCR("Includes a data value into a gp_hyperloglog counter");
 DATA(insert OID = 7164 ( gp_hyperloglog_accum  PGNSP PGUID 12 1 0 0 0 t f f f f f i 1 0 7157 "2283" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
 DESCR("Adds every data value to a gp_hyperloglog counter and returns the counter");
 
+/* gp_hyperloglog_get_count(counter gp_hyperloglog_estimator) => int8 */
+DATA(insert OID = 7001 ( gp_hyperloglog_get_count  PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 20 "7157" _null_ _null_ "{counter}" _null_ gp_hyperloglog_get_count _null_ _null_ _null_ n a ));
+DESCR("Estimates the number of distinct values stored in a gp_hyperloglog counter, rounded to an integer");
+
+/* approx_count_distinct(anyelement) => int8 */
+DATA(insert OID = 7002 ( approx_count_distinct  PGNSP PGUID 12 1 0 0 0 t f f f f f i 1 0 20 "2283" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
+DESCR("Estimates the number of distinct input values with a gp_hyperloglog counter");
+
+
+/* t-digest for approximate percentiles */
+/* gp_tdigest_add(digest bytea, value float8, fraction float8) => bytea */
+DATA(insert OID = 7003 ( gp_tdigest_add  PGNSP PGUID 12 1 0 0 0 f f f f f f i 3 0 17 "17 701 701" _null_ _null_ "{digest,value,fraction}" _null_ gp_tdigest_add _null_ _null_ _null_ n a ));
+DESCR("aggregate transition function");
+
+/* gp_tdigest_merge(digest1 bytea, digest2 bytea) => bytea */
+DATA(insert OID = 7004 ( gp_tdigest_merge  PGNSP PGUID 12 1 0 0 0 f f f f f f i 2 0 17 "17 17" _null_ _null_ "{digest1,digest2}" _null_ gp_tdigest_merge _null_ _null_ _null_ n a ));
+DESCR("aggregate combine function");
+
+/* gp_tdigest_percentile(digest bytea) => float8 */
+DATA(insert OID = 7005 ( gp_tdigest_percentile  PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 701 "17" _null_ _null_ "{digest}" _null_ gp_tdigest_percentile _null_ _null_ _null_ n a ));
+DESCR("aggregate final function");
+
+/* approx_percentile(float8, float8) => float8 */
+DATA(insert OID = 7006 ( approx_percentile  PGNSP PGUID 12 1 0 0 0 t f f f f f i 2 0 701 "701 701" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
+DESCR("Estimates a percentile of the input values with a t-digest");
+
 /* pg_get_table_distributedby(oid) => text */
 DATA(insert OID = 6232 ( pg_get_table_distributedby  PGNSP PGUID 12 1 0 0 0 f f f f t f s 1 0 25 "26" _null_ _null_ _null_ _null_ pg_get_table_distributedby _null_ _null_ _null_ n a ));
 DESCR("deparse DISTRIBUTED BY clause for a given relation");
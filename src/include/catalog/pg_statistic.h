@@ -315,4 +315,15 @@ typedef FormData_pg_statistic *Form_pg_statistic;
  */
 #define STATISTIC_KIND_FULLHLL  98
 
+/*
+ * A "dependency" slot describes the functional dependencies of the other
+ * columns of the table on this one.  stavalues contains the attnums of the
+ * other columns (as int2), and stanumbers the degree of the dependency of
+ * each of them on this column: the fraction of the sample rows in groups of
+ * equal values of this column that all have the same value of the other one.
+ * A degree of 1 means that this column determines the other one.  staop is
+ * unused.
+ */
+#define STATISTIC_KIND_DEPENDENCY  97
+
 #endif   /* PG_STATISTIC_H */
@@ -51,6 +51,7 @@ typedef struct AOCSInsertDescData
 	int64		rowCount; /* total row count before insert */
 	int64		numSequences; /* total number of available sequences */
 	int64		lastSequence; /* last used sequence */
+	int64		sequenceBatch; /* sequences to request at a time */
 	int32		cur_segno;
 
 	char *compType;
@@ -126,6 +127,39 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Zone map pruning, see aocs_set_zonemap_quals(). The rows of the
+	 * current segment file in the skip ranges are skipped without reading
+	 * their blocks. The entries of the projected columns in the block
+	 * directory tell where to continue reading after a range.
+	 */
+	List	   *zonemapQuals;
+	MemoryContext zonemapContext;	/* for the state of the segment file */
+	int64	   *skipRanges;		/* first and last row number of each range */
+	int			numSkipRanges;
+	int			nextSkipRange;
+	MinipageEntry **skipEntries;	/* by column number */
+	int		   *numSkipEntries;
+
+	/*
+	 * Quals checked once for each code of the dictionary-compressed blocks,
+	 * see aocs_set_dictionary_quals().
+	 */
+	List	   *dictionaryQuals;
+	MemoryContext dictionaryContext;	/* to evaluate the quals in */
+
+	/*
+	 * Late materialization, see aocs_set_late_quals(). The columns of the
+	 * quals are read first, the others only for the rows that satisfy them.
+	 */
+	List	   *lateQuals;		/* ExprStates of the quals */
+	struct ExprContext *lateEcontext;	/* to evaluate them in */
+	int		   *qual_atts;		/* projected columns the quals use */
+	int			num_qual_atts;
+	int		   *late_atts;		/* the other projected columns */
+	int			num_late_atts;
+	bool		lateMaterialize;	/* used for the current segment file? */
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
@@ -208,11 +242,16 @@ extern AOCSScanDesc aocs_beginrangescan(Relation relation, Snapshot snapshot,
 		int *segfile_no_arr, int segfile_count,
 	TupleDesc relationTupleDesc, bool *proj);
 
+extern void aocs_set_zonemap_quals(AOCSScanDesc scan, List *quals);
+extern void aocs_set_dictionary_quals(AOCSScanDesc scan, List *quals);
+extern void aocs_set_late_quals(AOCSScanDesc scan, bool *qualCols,
+					List *qualstate, struct ExprContext *econtext);
 extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
 
 extern bool aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
+extern void aocs_insert_set_expected_rows(AOCSInsertDesc desc, double rows);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
 {
@@ -70,6 +70,7 @@ typedef struct AppendOnlyInsertDescData
 	int64           rowCount; /* total row count before insert */
 	int64           numSequences; /* total number of available sequences */
 	int64           lastSequence; /* last used sequence */
+	int64           sequenceBatch; /* sequences to request at a time */
 	BlockNumber		cur_segno;
 	FileSegInfo     *fsInfo;
 	VarBlockMaker	varBlockMaker;
@@ -257,6 +258,36 @@ typedef struct AppendOnlyFetchDetail
 } AppendOnlyFetchDetail;
 
 
+/*
+ * The number of blocks a fetch keeps the contents of, see
+ * AppendOnlyFetchCachedBlock.
+ */
+#define APPENDONLY_FETCH_CACHED_BLOCKS 8
+
+/*
+ * A block whose contents were read, and decompressed, by a fetch. The fetches
+ * of the rows of the blocks read last use their contents, without reading
+ * and decompressing them again: the rows an index or a bitmap points to are
+ * often in the same few blocks, e.g. when a bitmap scan is rescanned for
+ * each outer row of a join.
+ */
+typedef struct AppendOnlyFetchCachedBlock
+{
+	bool			valid;
+	int				segmentFileNum;
+	int				formatVersion;
+	int64			firstRowNum;
+	int64			lastRowNum;
+	int				executorBlockKind;
+
+	uint8			*data;
+	int32			dataLen;
+	int32			dataBufferLen;	/* allocated for data */
+	VarBlockReader	varBlockReader;
+
+	uint64			lastUsed;		/* to replace the least recently used */
+} AppendOnlyFetchCachedBlock;
+
 /*
  * Used for fetch individual tuples from specified by TID of append only relations 
  * using the AO Block Directory, BufferedRead and VarBlocks
@@ -312,6 +343,9 @@ typedef struct AppendOnlyFetchDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	AppendOnlyFetchCachedBlock cachedBlocks[APPENDONLY_FETCH_CACHED_BLOCKS];
+	uint64			cachedBlockClock;
+
 }	AppendOnlyFetchDescData;
 
 typedef AppendOnlyFetchDescData *AppendOnlyFetchDesc;
@@ -350,6 +384,7 @@ extern bool appendonly_fetch(
 	TupleTableSlot *slot);
 extern void appendonly_fetch_finish(AppendOnlyFetchDesc aoFetchDesc);
 extern AppendOnlyInsertDesc appendonly_insert_init(Relation rel, int segno, bool update_mode);
+extern void appendonly_insert_set_expected_rows(AppendOnlyInsertDesc aoInsertDesc, double rows);
 extern Oid appendonly_insert(
 		AppendOnlyInsertDesc aoInsertDesc, 
 		MemTuple instup, 
@@ -21,6 +21,7 @@
 
 extern int gp_blockdirectory_entry_min_range;
 extern int gp_blockdirectory_minipage_size;
+extern bool gp_appendonly_zone_maps;
 
 typedef struct AppendOnlyBlockDirectoryEntry
 {
@@ -48,6 +49,30 @@ typedef struct MinipageEntry
 	int64 rowCount;
 } MinipageEntry;
 
+/*
+ * The zone map of a minipage entry: the smallest and the largest value of
+ * the column in the blocks the entry covers. Only kept for the types whose
+ * values map to an int64 in their sort order, see
+ * AppendOnlyBlockDirectory_ZoneMapValue().
+ */
+typedef struct MinipageZoneMap
+{
+	int64 minValue;
+	int64 maxValue;
+	int32 flags;
+} MinipageZoneMap;
+
+#define ZONEMAP_VALID		0x01	/* describes all the blocks of the entry */
+#define ZONEMAP_HAS_VALUES	0x02	/* minValue and maxValue are set */
+#define ZONEMAP_HAS_NULLS	0x04	/* some of the values are NULL */
+
+/*
+ * Versions of the minipage format. From MINIPAGE_VERSION_ZONEMAP on, an
+ * array of nEntry MinipageZoneMaps follows the entries.
+ */
+#define MINIPAGE_VERSION_ORIGINAL	0
+#define MINIPAGE_VERSION_ZONEMAP	1
+
 /*
  * Define a varlena type for a minipage.
  */
@@ -69,6 +94,7 @@ typedef struct Minipage
 typedef struct MinipagePerColumnGroup
 {
 	Minipage *minipage;
+	MinipageZoneMap *zonemaps;	/* one for each entry of the minipage */
 	uint32 numMinipageEntries;
 	ItemPointerData tupleTid;
 } MinipagePerColumnGroup;
@@ -199,6 +225,14 @@ extern bool AppendOnlyBlockDirectory_InsertEntry(
 	int64 fileOffset,
 	int64 rowCount,
 	bool addColAction);
+extern bool AppendOnlyBlockDirectory_InsertEntryWithZoneMap(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo,
+	int64 firstRowNum,
+	int64 fileOffset,
+	int64 rowCount,
+	MinipageZoneMap *zonemap,
+	bool addColAction);
 extern bool AppendOnlyBlockDirectory_addCol_InsertEntry(
 	AppendOnlyBlockDirectory *blockDirectory,
 	int columnGroupNo,
@@ -218,6 +252,20 @@ extern void AppendOnlyBlockDirectory_End_forSearch(
 	AppendOnlyBlockDirectory *blockDirectory);
 extern void AppendOnlyBlockDirectory_End_addCol(
 	AppendOnlyBlockDirectory *blockDirectory);
+extern MinipageEntry *AppendOnlyBlockDirectory_GetSegmentEntries(
+	Relation aoRel,
+	Snapshot appendOnlyMetaDataSnapshot,
+	int segno,
+	int columnGroupNo,
+	int64 eof,
+	MinipageZoneMap **zonemaps,
+	int *numEntries);
+extern bool AppendOnlyBlockDirectory_ZoneMapType(Oid typid);
+extern int64 AppendOnlyBlockDirectory_ZoneMapValue(Oid typid, Datum value);
+extern void AppendOnlyBlockDirectory_ZoneMapAdd(
+	MinipageZoneMap *zonemap,
+	int64 value,
+	bool isnull);
 extern void AppendOnlyBlockDirectory_DeleteSegmentFile(
 	Relation aoRel,
 		Snapshot snapshot,
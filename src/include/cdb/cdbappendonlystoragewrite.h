@@ -176,6 +176,13 @@ typedef struct AppendOnlyStorageWrite
 
 	bool needsWAL;
 
+	/*
+	 * In bulk load mode, needsWAL is off and the writes are not WAL-logged
+	 * one by one.  Instead, the part of the segment file written is logged at
+	 * once when the file is closed, if bulkLoadNeedsWAL.
+	 */
+	bool bulkLoadNeedsWAL;
+
 } AppendOnlyStorageWrite;
 
 extern void AppendOnlyStorageWrite_Init(AppendOnlyStorageWrite *storageWrite,
@@ -186,6 +193,7 @@ extern void AppendOnlyStorageWrite_Init(AppendOnlyStorageWrite *storageWrite,
 										AppendOnlyStorageAttributes *storageAttributes,
 										bool needsWAL);
 extern void AppendOnlyStorageWrite_FinishSession(AppendOnlyStorageWrite *storageWrite);
+extern void AppendOnlyStorageWrite_SetBulkLoad(AppendOnlyStorageWrite *storageWrite);
 
 extern void AppendOnlyStorageWrite_TransactionCreateFile(AppendOnlyStorageWrite *storageWrite,
 											 RelFileNodeBackend *relFileNode,
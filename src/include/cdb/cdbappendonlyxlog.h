@@ -51,6 +51,9 @@ typedef struct
 
 extern void xlog_ao_insert(RelFileNode relFileNode, int32 segmentFileNum,
 			   int64 offset, void *buffer, int32 bufferLen);
+extern void xlog_ao_insert_file(File file, RelFileNode relFileNode,
+					int32 segmentFileNum, int64 startOffset, int64 endOffset,
+					char *filePathName);
 extern void xlog_ao_truncate(RelFileNode relFileNode, int32 segmentFileNum, int64 offset);
 
 
@@ -0,0 +1,48 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbbroadcastcache.h
+ *	  Cache of the tuples of small broadcast relations on the segments.
+ *
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbbroadcastcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef CDBBROADCASTCACHE_H
+#define CDBBROADCASTCACHE_H
+
+#include "access/htup.h"
+#include "executor/execdesc.h"
+#include "nodes/execnodes.h"
+#include "nodes/plannodes.h"
+#include "storage/lock.h"
+
+/* State of a receiving broadcast Motion that the cache serves */
+typedef struct BroadcastCacheState
+{
+	struct BroadcastCacheEntry *entry;	/* entry replayed, or being filled */
+	bool		hit;			/* replaying the entry instead of receiving */
+	bool		stopSent;		/* the senders have been told to stop */
+	int			next;			/* next tuple of the entry to replay */
+} BroadcastCacheState;
+
+/* On the master */
+extern Size BroadcastCacheShmemSize(void);
+extern void BroadcastCacheShmemInit(void);
+extern void BroadcastCacheNoteLock(Oid relid, LOCKMODE lockmode);
+extern List *BroadcastCacheDispatchKeys(QueryDesc *queryDesc);
+
+/* On the segments */
+extern BroadcastCacheState *BroadcastCacheBeginMotion(EState *estate,
+													  Motion *motion,
+													  TupleDesc tupdesc);
+extern GenericTuple BroadcastCacheNext(BroadcastCacheState *state);
+extern void BroadcastCacheAddTuple(BroadcastCacheState *state,
+								   GenericTuple tuple);
+extern void BroadcastCacheEndOfStream(BroadcastCacheState *state);
+extern void BroadcastCacheEndMotion(BroadcastCacheState *state);
+
+#endif   /* CDBBROADCASTCACHE_H */
@@ -76,6 +76,14 @@ typedef struct BufferedRead
 	bool				haveTemporaryLimitInEffect;
 	int64				temporaryLimitFileLen;
 
+	/*
+	 * Read-ahead support.  The kernel is asked to read this many large reads
+	 * after the current one in the background, and has been asked up to
+	 * prefetchPosition already.
+	 */
+	int32				readAheadCount;
+	int64				prefetchPosition;
+
 } BufferedRead;
 
 /*
@@ -92,6 +100,9 @@ extern int32 BufferedReadMemoryLen(
  *
  * Use the BufferedReadMemoryLen procedure to
  * determine the amount of memory to supply.
+ *
+ * If readAheadCount is greater than 0, that many large reads after the
+ * current one are prefetched asynchronously.
  */
 extern void BufferedReadInit(
     BufferedRead         *bufferedRead,
@@ -99,6 +110,7 @@ extern void BufferedReadInit(
     int32                memoryLen,
     int32                maxBufferLen,
     int32                maxLargeReadLen,
+    int32                readAheadCount,
     char				 *relationName);
 
 /*
@@ -55,12 +55,21 @@ typedef struct DistributedSnapshotWithLocalMapping
 
 	/*
 	 * Cache to perform quick check for localXid, populated after reverse
-	 * mapping distributed xid to local xid.
+	 * mapping distributed xid to local xid.  inProgressMappedLocalXids is
+	 * kept sorted, so that it can be binary searched.
 	 */
 	TransactionId minCachedLocalXid;
 	TransactionId maxCachedLocalXid;
 	int32 currentLocalXidsCount;
 	TransactionId *inProgressMappedLocalXids;
+
+	/*
+	 * The last local xid found visible or to be ignored, and which of the
+	 * two.  The tuples of a heap page are mostly written by a few
+	 * transactions, so this saves the lookups of the same xid over again.
+	 */
+	TransactionId lastCommittedLocalXid;
+	int32 lastCommittedResult;
 } DistributedSnapshotWithLocalMapping;
 
 typedef enum
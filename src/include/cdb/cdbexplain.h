@@ -107,6 +107,25 @@ cdbexplain_recvExecStats(struct PlanState              *planstate,
                          int                            sliceIndex,
                          struct CdbExplain_ShowStatCtx *showstatctx);
 
+/*
+ * cdbexplain_getRowsPerLoop
+ *    Called by qDisp, after the statistics have been received, to get the
+ *    rows a node produced per loop, summed over the qExecs that ran it, and
+ *    the most of any one of them.  Returns false if the node has no
+ *    statistics.
+ */
+bool
+cdbexplain_getRowsPerLoop(struct PlanState *planstate, double *sum, double *max);
+
+/*
+ * cdbexplain_getTimePerLoop
+ *    Called by qDisp, after the statistics have been received, to get the
+ *    most time in seconds a qExec spent in a node per loop.  Returns false
+ *    if the node has no statistics or no qExec ran it.
+ */
+bool
+cdbexplain_getTimePerLoop(struct PlanState *planstate, double *max);
+
 /*
  * cdbexplain_showExecStatsBegin
  *    Called by qDisp process to create a CdbExplain_ShowStatCtx structure
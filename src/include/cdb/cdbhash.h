@@ -30,6 +30,12 @@ typedef enum
 	REDUCE_JUMP_HASH
 } CdbHashReduce;
 
+/*
+ * Hash function of a built-in hash opclass, called directly rather than
+ * through fmgr.  It returns the same value as the SQL-callable function.
+ */
+typedef uint32 (*CdbHashFastFunc) (Datum datum);
+
 /*
  * Structure that holds Greenplum Database hashing information.
  */
@@ -43,6 +49,7 @@ typedef struct CdbHash
 
 	int			natts;
 	FmgrInfo   *hashfuncs;
+	CdbHashFastFunc *fasthashfuncs; /* per attribute, NULL to use fmgr */
 } CdbHash;
 
 /*
@@ -260,6 +260,14 @@ struct MotionConn
 	 */
 	bool		stopRequested;
 
+	/*
+	 * TCP: the receiver has answered the EOS message with a reuse message,
+	 * so the socket can be kept open for the next query of the session, see
+	 * gp_interconnect_tcp_connection_pool_size.  Set on the incoming
+	 * connections taken from the pool until they register again, too.
+	 */
+	bool		reusable;
+
     MotionConnState state;
 
 	uint64		wakeup_ms;
@@ -274,6 +282,10 @@ struct MotionConn
 	struct sockaddr_storage peer;		/* Allow for IPv4 or IPv6 */
 	socklen_t peer_len;					/* And remember the actual length */
 
+	/* UDPIFC: Unix domain socket of a peer on the same host */
+	struct sockaddr_storage localPeer;
+	socklen_t localPeer_len;			/* 0 if data goes through UDP */
+
 	/* a queue of maximum length Gp_interconnect_queue_depth */
 	int			pkt_q_capacity;			/*max capacity of the queue*/
 	int			pkt_q_size;				/*number of packets in the queue*/
@@ -342,6 +354,9 @@ typedef struct ChunkTransportStateEntry
 
 	bool		sendingEos;
 
+	/* compress the packets we send, see CompressMotionPackets() */
+	bool		compressPackets;
+
 	/* Statistics info for this motion on the interconnect level */
 	uint64 stat_total_ack_time;
 	uint64 stat_count_acks;
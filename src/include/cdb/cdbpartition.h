@@ -41,7 +41,10 @@ typedef struct PartitionRangeState
 	FmgrInfo *ltfuncs_inverse; /* comparator partRule < expr */
 	FmgrInfo *lefuncs_inverse; /* comparator partRule <= expr */
 	int last_rule; /* cache offset to the last rule and test if it matches */
-	PartitionRule **rules;
+	PartitionRule **rules; /* rules of rules_node, as an array */
+	PartitionNode *rules_node;
+	int nrules;
+	int rules_size; /* allocated length of rules */
 } PartitionRangeState;
 
 /* likewise, for list */
@@ -22,5 +22,6 @@
 
 extern char *serializeNode(Node *node, int *size, int *uncompressed_size);
 extern Node *deserializeNode(const char *strNode, int size);
+extern Node *deserializeNodeCached(const char *strNode, int size);
 
 #endif   /* CDBSRLZ_H */
@@ -409,6 +409,29 @@ extern bool gp_interconnect_aggressive_retry; /* fast-track app-level retry */
  */
 extern bool gp_interconnect_full_crc;
 
+/*
+ * Parameters gp_interconnect_compression and
+ * gp_interconnect_compression_threshold
+ *
+ * Compress the UDP packets of the Motions estimated to send at least the
+ * threshold (in kB) of tuple data.  Decided by the planner for each Motion.
+ */
+extern bool gp_interconnect_compression;
+extern int	gp_interconnect_compression_threshold;
+
+#define GpInterconnectCompressMotion(rows, width) \
+	(gp_interconnect_compression && \
+	 (double) (rows) * (double) (width) >= \
+	 (double) gp_interconnect_compression_threshold * 1024.0)
+
+/*
+ * Parameter gp_interconnect_local_sockets
+ *
+ * Send the UDPIFC data packets to the receivers on the same host through Unix
+ * domain sockets rather than UDP.
+ */
+extern bool gp_interconnect_local_sockets;
+
 /*
  * Parameter gp_interconnect_log_stats
  *
@@ -470,6 +493,9 @@ extern bool gp_enable_fast_sri;
 /* Enable single-mirror pair dispatch. */
 extern bool gp_enable_direct_dispatch;
 
+/* Keep the last plans received deserialized on the QEs. */
+extern bool gp_enable_qe_plan_cache;
+
 /* Name of pseudo-function to access any table as if it was randomly distributed. */
 #define GP_DIST_RANDOM_NAME "GP_DIST_RANDOM"
 
@@ -565,7 +591,17 @@ extern bool gp_adjust_selectivity_for_outerjoins;
  * Target density for hash-node (HJ).
  */
 extern int gp_hashjoin_tuples_per_bucket;
-extern int gp_hashagg_groups_per_bucket;
+
+/*
+ * Discard outer tuples of a hash join by a bloom filter of the inner ones.
+ */
+extern bool gp_hashjoin_bloomfilter;
+
+/*
+ * Let an index-only scan skip to the next value of its leading column, when
+ * its parent only needs one tuple of each value.
+ */
+extern bool gp_enable_index_skip_scan;
 
 /*
  * Damping of selectivities of clauses which pertain to the same base
@@ -717,6 +753,9 @@ extern bool gp_enable_sort_distinct;
 extern bool gp_enable_mk_sort;
 extern bool gp_enable_motion_mk_sort;
 
+/* Compress the pages of Materialize in memory before spilling them */
+extern bool gp_materialize_compression;
+
 #ifdef USE_ASSERT_CHECKING
 extern bool gp_mk_sort_check;
 #endif
@@ -755,6 +794,26 @@ extern int gp_max_plan_size;
 /* If we use two stage hashagg, we can stream the bottom half */
 extern bool gp_hashagg_streambottom;
 
+/*
+ * The bottom stage of a streaming hashagg passes its input tuples through
+ * once its hash table holds more than this fraction of groups per tuple.
+ */
+extern double gp_hashagg_passthrough_ratio;
+
+/*
+ * A Redistribute Motion logs skew when more than this fraction of its first
+ * rows go to one segment.
+ */
+extern double gp_motion_skew_threshold;
+
+/*
+ * The master tracks the writes of up to gp_broadcast_cache_relations tables,
+ * and each process of a session on the segments keeps up to
+ * gp_broadcast_cache_size kB of the tuples of the tables broadcast to it.
+ */
+extern int gp_broadcast_cache_relations;
+extern int gp_broadcast_cache_size;
+
 /* The default number of batches to use when the hybrid hashed aggregation
  * algorithm (re-)spills in-memory groups to disk.
  */
@@ -778,6 +837,9 @@ extern int gp_gpperfmon_send_interval;
 extern bool gp_enable_query_metrics;
 extern int gp_instrument_shmem_size;
 
+/* Time only one in these many calls of a node in EXPLAIN ANALYZE */
+extern int gp_explain_timing_sample_rate;
+
 extern bool dml_ignore_target_partition_check;
 
 /* gpmon alert level, control log alert level used by gpperfmon */
@@ -795,6 +857,8 @@ extern int gpperfmon_log_alert_level;
 extern int gp_workfile_limit_per_segment;
 extern int gp_workfile_limit_per_query;
 extern int gp_workfile_limit_files_per_query;
+extern int gp_shareinput_shmem_size;
+extern int gp_dml_insert_batch_mem;
 extern int gp_workfile_caching_loglevel;
 extern int gp_sessionstate_loglevel;
 extern int gp_workfile_bytes_to_checksum;
@@ -847,6 +911,7 @@ extern bool gp_cost_hashjoin_chainwalk;
 
 extern int cdb_total_slices;
 extern int cdb_max_slices;
+extern int cdb_total_direct_dispatch_plans;
 
 typedef struct GpId
 {
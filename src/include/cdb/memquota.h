@@ -22,7 +22,8 @@ typedef enum ResManagerMemoryPolicy
 {
 	RESMANAGER_MEMORY_POLICY_NONE,
 	RESMANAGER_MEMORY_POLICY_AUTO,
-	RESMANAGER_MEMORY_POLICY_EAGER_FREE
+	RESMANAGER_MEMORY_POLICY_EAGER_FREE,
+	RESMANAGER_MEMORY_POLICY_ESTIMATE
 } ResManagerMemoryPolicy;
 
 extern ResManagerMemoryPolicy gp_resmanager_memory_policy_default;
@@ -40,12 +41,14 @@ extern bool						*gp_resmanager_print_operator_memory_limits;
 #define IsResManagerMemoryPolicyNone() (*gp_resmanager_memory_policy == RESMANAGER_MEMORY_POLICY_NONE)
 #define IsResManagerMemoryPolicyAuto() (*gp_resmanager_memory_policy == RESMANAGER_MEMORY_POLICY_AUTO)
 #define IsResManagerMemoryPolicyEagerFree() (*gp_resmanager_memory_policy == RESMANAGER_MEMORY_POLICY_EAGER_FREE)
+#define IsResManagerMemoryPolicyEstimate() (*gp_resmanager_memory_policy == RESMANAGER_MEMORY_POLICY_ESTIMATE)
 
 #define LogResManagerMemory() (*gp_log_resmanager_memory == true)
 #define ResManagerPrintOperatorMemoryLimits() (*gp_resmanager_print_operator_memory_limits == true)
 
 extern void PolicyAutoAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memoryAvailable);
 extern void PolicyEagerFreeAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memoryAvailable);
+extern void PolicyEstimateAssignOperatorMemoryKB(PlannedStmt *stmt, uint64 memoryAvailable);
 
 /**
  * Inverse for explain analyze.
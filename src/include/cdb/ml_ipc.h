@@ -212,6 +212,16 @@ extern void DeregisterReadInterest(ChunkTransportState *transportStates,
 								   int                  srcRoute,
 								   const char          *reason);
 
+/*
+ * The CompressMotionPackets() function is used on the sending side of a
+ * motion to compress the packets it sends.
+ *
+ * PARAMTERS:
+ *	 - motNodeID: motion node id that this applies to.
+ */
+extern void CompressMotionPackets(ChunkTransportState *transportStates,
+								  int motNodeID);
+
 extern void readPacket(MotionConn *conn, ChunkTransportState *transportStates);
 
 /* 
@@ -312,6 +322,7 @@ extern TupleChunkListItem RecvTupleChunk(MotionConn *conn, ChunkTransportState *
 extern void InitMotionTCP(int *listenerSocketFd, uint16 *listenerPort);
 extern void InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort);
 extern void markUDPConnInactiveIFC(MotionConn *conn);
+extern void markTCPConnInactive(MotionConn *conn);
 extern void CleanupMotionTCP(void);
 extern void CleanupMotionUDPIFC(void);
 extern void WaitInterconnectQuitUDPIFC(void);
@@ -48,6 +48,13 @@ typedef struct TupleChunkListItemData
 	 */
 	char	   *inplace;
 
+	/*
+	 * For a chunk being sent, the data that follows the header in
+	 * chunk_data, if it was not copied there.  It must stay valid until the
+	 * chunk is sent.
+	 */
+	char	   *sendref;
+
 	/* Variable-length data portion of the struct. */
 	uint8		chunk_data[];
 } TupleChunkListItemData,
@@ -85,6 +92,21 @@ typedef struct TupleChunkListData
 } TupleChunkListData,
 		   *TupleChunkList;
 
+/*
+ * Copy a chunk being sent to a buffer, including the data it refers to.
+ */
+#define CopyChunkToBuffer(dest, tcItem) \
+	do { \
+		if ((tcItem)->sendref != NULL) \
+		{ \
+			memcpy((dest), (tcItem)->chunk_data, TUPLE_CHUNK_HEADER_SIZE); \
+			memcpy((char *) (dest) + TUPLE_CHUNK_HEADER_SIZE, (tcItem)->sendref, \
+				   (tcItem)->chunk_length - TUPLE_CHUNK_HEADER_SIZE); \
+		} \
+		else \
+			memcpy((dest), (tcItem)->chunk_data, (tcItem)->chunk_length); \
+	} while (0)
+
 extern TupleChunkListItem makeTupleChunkListItem(TupleChunkType chunkType,
 					   void *pChunkData, uint16 chunkDataSize);
 
@@ -55,5 +55,7 @@ extern int aggregate_leaf_partition_histograms(Oid relationOid,
 											   void **result);
 extern bool needs_sample(VacAttrStats **vacattrstats, int attr_cnt);
 extern bool leaf_parts_analyzed(Oid attrelid, Oid relid_exclude, List *va_cols, int elevel);
+extern int64 get_leaf_part_modcount(Oid relid);
+extern List *leaf_parts_changed(List *leaf_oids, List *va_cols, int elevel);
 
 #endif  /* ANALYZEUTILS_H */
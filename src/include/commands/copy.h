@@ -190,6 +190,8 @@ typedef struct CopyStateData
 
 	StringInfo	dispatch_msgbuf; /* used in COPY_DISPATCH mode, to construct message
 								  * to send to QE. */
+	bool	   *qe_input_flags;	/* per-column flags, used in COPY_DISPATCH mode:
+								 * the input function is run in the QE */
 	
 	/* Error handling options */
 	CopyErrMode	errMode;
@@ -40,6 +40,7 @@ typedef struct ExplainState
 	bool		costs;			/* print estimated costs */
 	bool		buffers;		/* print buffer usage */
 	bool		dxl;			/* CDB: print DXL */
+	bool		optimizer_stats;	/* CDB: print GPORCA phase times */
 	bool		timing;			/* print detailed node timing */
 	bool		summary;		/* print total planning and execution timing */
 	ExplainFormat format;		/* output format */
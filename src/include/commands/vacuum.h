@@ -165,6 +165,7 @@ typedef struct VPgClassStats
 /* GUC parameters */
 extern PGDLLIMPORT int default_statistics_target;		/* PGDLLIMPORT for
 														 * PostGIS */
+extern int	gp_statistics_dependency_columns;
 extern int	vacuum_freeze_min_age;
 extern int	vacuum_freeze_table_age;
 extern int	vacuum_multixact_freeze_min_age;
@@ -223,6 +224,8 @@ extern bool std_typanalyze(VacAttrStats *stats);
 extern double anl_random_fract(void);
 extern double anl_init_selection_state(int n);
 extern double anl_get_next_S(double t, int n, double *stateptr);
+extern double merge_leaf_ndistinct(Oid rootOid, AttrNumber attnum,
+								   float4 *nullfrac, int32 *width);
 
 extern int acquire_sample_rows(Relation onerel, int elevel,
 							   HeapTuple *rows, int targrows,
@@ -234,5 +237,6 @@ extern int acquire_inherited_sample_rows(Relation onerel, int elevel,
 /* in commands/analyzefuncs.c */
 extern Datum gp_acquire_sample_rows(PG_FUNCTION_ARGS);
 extern Oid gp_acquire_sample_rows_col_type(Oid typid);
+extern Datum gp_relation_modcount(PG_FUNCTION_ARGS);
 
 #endif   /* VACUUM_H */
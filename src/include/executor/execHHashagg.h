@@ -40,13 +40,22 @@ typedef struct BatchFileInfo BatchFileInfo;
  */
 typedef struct HashAggEntry
 {
-	struct HashAggEntry *next; /* Next entry in chain. */
 	void *tuple_and_aggs; /* grouping keys and aggregate values.*/
 	HashKey hashvalue;
 	bool is_primodial; /* indicates if this entry is there before spilling. */
 } HashAggEntry;
 
-typedef HashAggEntry* HashAggBucket;
+/* A slot of the open addressing Agg hash table.
+ *
+ * The hash value of the entry is repeated in the slot, so that probing
+ * only has to visit the entries, allocated from the group buffer, whose
+ * hash value matches.  An empty slot has a NULL entry.
+ */
+typedef struct HashAggSlot
+{
+	HashKey hashvalue;
+	HashAggEntry *entry;
+} HashAggSlot;
 
 /* A SpillFile controls access to a temporary file used to hold  
  * transition tuples spilled from the hash table in order to free 
@@ -119,7 +128,7 @@ typedef struct SpillSet
 
 typedef struct HashAggTableSizes
 {
-	unsigned  nbuckets;   /* Calculated # of hash buckets. */
+	unsigned  nbuckets;   /* Calculated # of hash table slots. */
 	unsigned  nentries;   /* Calculated # of hash entries. */
 	unsigned  nbatches;   /* Calculated # of passes. */
 	double    hashentry_width; /* Estimated hash entry size */
@@ -153,11 +162,10 @@ typedef struct HashAggTable
 	/* Hash table */
 	MemoryContext   entry_cxt;	/* memory context for hash table entries */
 
-	unsigned nbuckets;
-	HashAggBucket  *buckets;
-	uint64 *bloom;
+	unsigned nbuckets;	/* # of slots, a power of 2 */
+	HashAggSlot    *buckets;
 
-	/* hashkey bitshift amount to determine bucket - used when spilling */
+	/* hashkey bitshift amount to determine slot and spill file */
 	unsigned pshift;
 
 	/* Overflow batches */
@@ -180,7 +188,6 @@ typedef struct HashAggTable
 
 	/* Variables during iteration */
 	int curr_bucket_idx;
-	HashAggEntry *next_entry;
 
 	/* buffer for calculating the hashkey */
 	HashKey *hashkey_buf;
@@ -204,11 +211,16 @@ typedef struct HashAggTable
 	uint32 num_expansions; /* number of times hash table is expanded */
 
 	bool is_spilling; /* indicate that spilling happened for this batch. */
-	bool expandable;  /* hash table buckets still have space to grow */
+	bool expandable;  /* hash table slots still have space to grow */
 	struct TupleTableSlot *prev_slot; /* a slot that is read previously. */
 
+	/* Streaming: stop aggregating when the hash table hardly reduces input */
+	uint64 num_stream_tuples; /* input tuples since the table was emptied */
+	uint64 num_passthru_tuples; /* tuples passed through without the table */
+	bool passthrough; /* pass the remaining input tuples through */
+
 	/* Statistics used for EXPLAIN ANALYZE */
-	CdbExplain_Agg      chainlength;
+	CdbExplain_Agg      chainlength; /* probe length of the entries */
 	uint64 total_buckets; /* total of nbuckets across spills and reloads */
 } HashAggTable;
 
@@ -193,6 +193,12 @@ typedef struct QueryDispatchDesc
 	 * set, use default reloptions + gp_default_storage_options.
 	 */
 	bool useChangedAOOpts;
+
+	/*
+	 * Broadcast Motions whose tuples a segment may replay from its broadcast
+	 * cache, a list of BroadcastCacheKeys.  See cdbbroadcastcache.c.
+	 */
+	List	   *broadcastCacheKeys;
 } QueryDispatchDesc;
 
 /*
@@ -217,6 +223,21 @@ typedef struct
 
 } OidAssignment;
 
+/*
+ * The version of the relation that a broadcast Motion of the slice table
+ * sends.  Receivers that have cached the tuples of the same version of the
+ * same plan replay them instead.
+ */
+typedef struct BroadcastCacheKey
+{
+	NodeTag		type;
+
+	int			motionID;		/* Motion node the tuples come from */
+	Oid			relid;			/* the broadcast relation */
+	uint64		version;		/* write version of the relation */
+	uint64		overflowVersion;	/* of the relations not in the hash */
+} BroadcastCacheKey;
+
 /* ----------------
  *		query descriptor:
  *
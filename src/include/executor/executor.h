@@ -168,6 +168,8 @@ extern TupleHashEntry FindTupleHashEntry(TupleHashTable hashtable,
 				   TupleTableSlot *slot,
 				   FmgrInfo *eqfunctions,
 				   FmgrInfo *hashfunctions);
+extern void RemoveTupleHashEntry(TupleHashTable hashtable,
+					 TupleTableSlot *slot);
 
 /*
  * prototypes from functions in execJunk.c
@@ -331,6 +333,14 @@ extern Tuplestorestate *ExecMakeTableFunctionResult(ExprState *funcexpr,
 							TupleDesc expectedDesc,
 							bool randomAccess,
 							uint64 operatorMemKB);
+typedef struct TableFunctionStream TableFunctionStream;
+extern TableFunctionStream *ExecBeginTableFunctionStream(ExprState *funcexpr,
+							 ExprContext *econtext,
+							 MemoryContext argContext,
+							 TupleDesc expectedDesc);
+extern bool ExecTableFunctionStreamNext(TableFunctionStream *stream,
+							TupleTableSlot *slot);
+extern void ExecEndTableFunctionStream(TableFunctionStream *stream);
 extern Datum ExecEvalExprSwitchContext(ExprState *expression, ExprContext *econtext,
 						  bool *isNull, ExprDoneCond *isDone);
 extern ExprState *ExecInitExpr(Expr *node, PlanState *parent);
@@ -473,6 +483,9 @@ extern ShareNodeEntry * ExecGetShareNodeEntry(EState *estate, int shareid, bool
 extern bool ExecPrefetchJoinQual(JoinState *node);
 extern bool ShouldPrefetchJoinQual(EState *estate, Join *join);
 
+extern bool ExecIsMemoizableType(Oid typid);
+extern bool ExecPlanContainsVolatileFunctions(EState *estate, Plan *plan);
+
 /* ResultRelInfo and Append Only segment assignment */
 void ResultRelInfoSetSegno(ResultRelInfo *resultRelInfo, List *mapping);
 
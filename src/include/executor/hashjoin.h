@@ -79,6 +79,31 @@ typedef struct HashJoinTupleData
 #define HJTUPLE_MINTUPLE(hjtup)  \
 	((MemTuple) ((char *) (hjtup) + HJTUPLE_OVERHEAD))
 
+/*
+ * The tuples of the main hash table are densely packed into chunks, rather
+ * than palloc'd one by one: that saves the palloc overhead for each tuple,
+ * keeps the tuples of the batch together in memory, and lets
+ * ExecHashIncreaseNumBatches walk the tuples sequentially.  Tuples larger
+ * than HASH_CHUNK_THRESHOLD get a chunk of their own.  Tuples of the skew
+ * hash table are still palloc'd separately, as they are freed one by one.
+ */
+typedef struct HashMemoryChunkData
+{
+	int			ntuples;		/* number of tuples stored in this chunk */
+	Size		maxlen;			/* size of the buffer holding the tuples */
+	Size		used;			/* number of buffer bytes already used */
+
+	struct HashMemoryChunkData *next;	/* pointer to the next chunk (linked
+										 * list) */
+
+	char		data[1];		/* buffer allocated at the end */
+}	HashMemoryChunkData;
+
+typedef struct HashMemoryChunkData *HashMemoryChunk;
+
+#define HASH_CHUNK_SIZE			(32 * 1024L)
+#define HASH_CHUNK_THRESHOLD	(HASH_CHUNK_SIZE / 4)
+
 /*
  * If the outer relation's distribution is sufficiently nonuniform, we attempt
  * to optimize the join by treating the hash values corresponding to the outer
@@ -199,8 +224,20 @@ typedef struct HashJoinTableData
 	Size		spaceUsedSkew;	/* skew hash table's current space usage */
 	Size		spaceAllowedSkew;		/* upper limit for skew hashtable */
 
+	/*
+	 * Bloom filter of the hash values of all inner tuples, to discard outer
+	 * tuples that can't have a match before they are spilled or probed.  It
+	 * is NULL if the join can't use one, or once it proved not selective.
+	 */
+	uint64	   *bloom;			/* bitmap of 1 << log2_bloombits bits */
+	int			log2_bloombits;
+	uint64		bloomProbes;	/* # outer tuples tested against the bloom */
+	uint64		bloomRejects;	/* # outer tuples discarded by the bloom */
+
 	MemoryContext hashCxt;		/* context for whole-hash-join storage */
 	MemoryContext batchCxt;		/* context for this-batch-only storage */
+
+	HashMemoryChunk chunks;		/* tuples of the main table, in batchCxt */
 	MemoryContext bfCxt;		/* CDB */ /* context for temp buf file */
 
     HashJoinTableStats *stats;  /* statistics workarea for EXPLAIN ANALYZE */
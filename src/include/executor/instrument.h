@@ -62,9 +62,16 @@ typedef struct Instrumentation
 	double		firsttuple;		/* Time for first tuple of this cycle */
 	uint64		tuplecount;		/* Tuples emitted so far this cycle */
 	BufferUsage	bufusage_start;	/* Buffer usage at start */
+	bool		sampled;		/* CDB: is the current call timed */
+	uint64		ncalls;			/* CDB: calls so far this cycle */
+	uint64		nsampled;		/* CDB: of which were timed */
+	double		cpustart;		/* CDB: CPU time at start of timed call */
+	double		cpucounter;		/* CDB: CPU time of timed calls this cycle */
+	double		cpufirst;		/* CDB: CPU time of the first call */
 	/* Accumulated statistics across all completed cycles: */
 	double		startup;		/* Total startup time (in seconds) */
 	double		total;			/* Total total time (in seconds) */
+	double		cputime;		/* CDB: of which on CPU (in seconds) */
 	uint64		ntuples;		/* Total tuples produced */
 	uint64		nloops;			/* # of run cycles for this node */
 	double		nfiltered1;		/* # tuples removed by scanqual or joinqual */
@@ -77,6 +84,12 @@ typedef struct Instrumentation
 	instr_time	firststart;		/* CDB: Start time of first iteration of node */
 	bool		workfileCreated;	/* TRUE if workfiles are created in this
 									 * node */
+	double		workfileBytes;	/* CDB: bytes written to workfiles */
+	double		workfileDiskBytes;	/* CDB: of which reached the disk, after
+									 * compression */
+	double		workfileWriteTime;	/* CDB: seconds spent writing workfiles */
+	double		bloomProbes;	/* CDB: outer rows checked against bloom filter */
+	double		bloomRejects;	/* CDB: of which the bloom filter discarded */
 	int			numPartScanned; /* Number of part tables scanned */
 	const char *sortMethod;		/* CDB: Type of sort */
 	const char *sortSpaceType;	/* CDB: Sort space type (Memory / Disk) */
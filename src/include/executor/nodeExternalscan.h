@@ -21,5 +21,6 @@ extern TupleTableSlot *ExecExternalScan(ExternalScanState *node);
 extern void ExecEndExternalScan(ExternalScanState *node);
 extern void ExecReScanExternal(ExternalScanState *node);
 extern void ExecSquelchExternalScan(ExternalScanState *node);
+extern void ExecExternalScanPushdownAggs(PlanState *planstate, ExternalScanAggType agg_type);
 
 #endif   /* NODEEXTERNALSCAN_H */
@@ -40,6 +40,7 @@ extern bool ExecHashGetHashValue(HashState *hashState, HashJoinTable hashtable,
 					 bool keep_nulls,
 					 uint32 *hashvalue,
 					 bool *hashkeys_null);
+extern bool ExecHashBloomTest(HashJoinTable hashtable, uint32 hashvalue);
 extern void ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 						  uint32 hashvalue,
 						  int *bucketno,
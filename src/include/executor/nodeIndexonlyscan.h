@@ -22,5 +22,7 @@ extern void ExecEndIndexOnlyScan(IndexOnlyScanState *node);
 extern void ExecIndexOnlyMarkPos(IndexOnlyScanState *node);
 extern void ExecIndexOnlyRestrPos(IndexOnlyScanState *node);
 extern void ExecReScanIndexOnlyScan(IndexOnlyScanState *node);
+extern void ExecIndexOnlyScanSkipDistinct(PlanState *planstate, AttrNumber attno,
+							  int eflags);
 
 #endif   /* NODEINDEXONLYSCAN_H */
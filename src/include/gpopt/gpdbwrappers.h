@@ -54,6 +54,9 @@ struct Motion;
 struct Var;
 struct Const;
 struct ArrayExpr;
+struct PlannedStmt;
+struct OrcaPlanCacheQuery;
+struct OrcaCostParam;
 
 namespace gpdb {
 
@@ -191,6 +194,14 @@ namespace gpdb {
 	// attribute statistics
 	HeapTuple GetAttStats(Oid relid, AttrNumber attnum);
 
+	// average widths from the statistics, -1 if there are none, and default
+	// values of all attributes of a relation, looked up in one guarded region
+	void GetRelAttrWidthsAndDefaults(Relation rel, int32 *widths, Node **defaults);
+
+	// NDV of a column of a partitioned table merged from the HLL counters of
+	// its leaves, -1 if not available
+	double MergeLeafNDistinct(Oid relid, AttrNumber attnum, float4 *null_frac, int32 *width);
+
 	// does a function exist with the given oid
 	bool FunctionExists(Oid oid);
 
@@ -317,6 +328,9 @@ namespace gpdb {
 	// number of GP segments
 	int GetGPSegmentCount(void);
 
+	// counter that changes whenever a GUC may have changed
+	uint64 GetConfigGeneration(void);
+
 	// heap attribute is null
 	bool HeapAttIsNull(HeapTuple tup, int attnum);
 
@@ -386,6 +400,9 @@ namespace gpdb {
 	// check whether the given oid is a member of the given list
 	bool ListMemberOid(List *list, Oid oid);
 
+	// check whether the given integer is a member of the given list
+	bool ListMemberInt(List *list, int datum);
+
 	// free list
 	void ListFree(List *list);
 	
@@ -479,6 +496,12 @@ namespace gpdb {
 	// query or expression tree walker
 	bool WalkQueryOrExpressionTree(Node *node, bool(*walker)(), void *context, int flags);
 
+	// does the expression or query contain volatile functions
+	bool ContainsVolatileFunctions(Node *node);
+
+	// does the expression or query refer to the given query level or above
+	bool ContainsVarsOfLevelOrAbove(Node *node, int levelsup);
+
 	// modify a query tree
 	Query *MutateQueryTree(Query *query, Node *(*mutator)(), void *context, int flags);
 
@@ -525,8 +548,13 @@ namespace gpdb {
 	// close the given relation
 	void CloseRelation(Relation rel);
 
-	// return the logical indexes for a partitioned table
+	// return the logical indexes for a partitioned table, they are cached
+	// until the next catalog change and must not be freed
 	LogicalIndexes *GetLogicalPartIndexes(Oid oid);
+
+	// return the logical index of a partitioned table by its oid, NULL if the
+	// table has no such index
+	LogicalIndexInfo *GetLogicalPartIndexInfo(Oid root_oid, Oid index_oid);
 	
 	// return the logical info structure for a given logical index oid
 	LogicalIndexInfo *GetLogicalIndexInfo(Oid root_oid, Oid index_oid);
@@ -640,15 +668,85 @@ namespace gpdb {
 	// return the number of leaf partition for a given table oid
 	gpos::ULONG CountLeafPartTables(Oid oidRelation);
 
+	// kinds of objects in the metadata cache
+	enum MDCacheObjectKind
+	{
+		MDCacheObjectGPDB,			// relation, index, type, operator, ...
+		MDCacheObjectRelStats,
+		MDCacheObjectColStats,
+		MDCacheObjectCast,
+		MDCacheObjectScCmp
+	};
+
+	// object in the metadata cache, in terms of the catalogs it comes from
+	struct MDCacheObject
+	{
+		int kind;				// MDCacheObjectKind
+		Oid oids[2];			// object, relation of stats, or types of casts and comparisons
+		uint32 num;				// position of column stats, or comparison type
+		int32 attno;			// attribute number of column stats
+	};
+
+	// remember an object fetched into the metadata cache
+	void MDCacheTrackObject(const MDCacheObject *object);
+
 	// Does the metadata cache need to be reset (because of a catalog
-	// table has been changed?)
-	bool MDCacheNeedsReset(void);
+	// table has been changed?) Otherwise the objects to be evicted are
+	// returned
+	bool MDCacheNeedsReset(MDCacheObject **invalid_objects, int *num_invalid_objects);
+
+	// catalog version of the metadata cache shared by the backends, pending
+	// invalidations are processed after it is taken
+	uint64 SharedMDCacheGetVersion(void);
+
+	// DXL of a metadata object in the shared metadata cache, NULL if missing
+	char *SharedMDCacheLookup(uint64 version, const char *key, Size *len);
+
+	// store the DXL of a metadata object in the shared metadata cache
+	void SharedMDCacheStore(uint64 version, const char *key, const char *data, Size len);
+
+	// store the DXL of a built-in metadata object, valid for all versions
+	void SharedMDCacheStoreBuiltin(const char *key, const char *data, Size len);
+
+	// plan of the normalized query from the plan cache, NULL if it has to be
+	// optimized, in which case the plan may be stored for cache_query
+	PlannedStmt *OrcaPlanCacheLookup(const Query *query, OrcaPlanCacheQuery **cache_query);
+
+	// store the plan optimized for the query in the plan cache
+	void OrcaPlanCacheStore(OrcaPlanCacheQuery *cache_query, PlannedStmt *plan);
+
+	// drop all the plans of the plan cache
+	void OrcaPlanCacheReset(void);
+
+	// plan to run for the normalized query, the optimized plan unless its
+	// shape differs from the baseline of the query
+	PlannedStmt *OrcaPlanBaselineChoose(OrcaPlanCacheQuery *cache_query, PlannedStmt *plan);
+
+	// most rows EXPLAIN ANALYZE has seen a scan of the relation return, false
+	// if there are none or cardinality feedback is disabled
+	bool GetCardinalityFeedback(Oid relid, double *numtuples);
+
+	// cost model parameters calibrated by gpcalibratecost
+	OrcaCostParam *GetOrcaCostParams(int *num_params);
+
+	// filter damping factor implied by the functional dependencies between
+	// the filtered columns of the query, the given one if there are none
+	double GetFilterDampingFactor(Query *query, double damping);
+
+	// keep the minidump of a slow optimization
+	void CaptureOptimization(double optimization_time, const char *minidump);
 
 	// functions for tracking ORCA memory consumption
 	void *OptimizerAlloc(size_t size);
 
 	void OptimizerFree(void *ptr);
 
+	// limit the bytes ORCA may allocate from now on, 0 for no limit
+	void SetOptimizerMemoryLimit(uint64 bytes);
+
+	// number of allocations ORCA has made so far, and their size in bytes
+	uint64 GetOptimizerAllocations(uint64 *bytes);
+
 	// returns true if a query cancel is requested in GPDB
 	bool IsAbortRequested(void);
 
@@ -660,6 +758,10 @@ namespace gpdb {
 
 	uint32 HashText(Datum d);
 
+	// order preserving key of a text or bpchar value in a collation, for the
+	// statistics
+	int64 TextStatsKey(Datum d, bool is_bpchar, Oid collation);
+
 } //namespace gpdb
 
 #define ForEach(cell, l)	\
@@ -20,6 +20,7 @@
 
 #include "gpos/base.h"
 #include "gpos/string/CWStringBase.h"
+#include "gpos/string/CWStringDynamic.h"
 
 #include "naucrates/md/CSystemId.h"
 #include "naucrates/md/IMDId.h"
@@ -49,13 +50,56 @@ namespace gpmd
 			// memory pool
 			CMemoryPool *m_mp;
 
+			// is the metadata cache shared by the backends to be used
+			BOOL m_use_shared_cache;
+
+			// catalog version of the objects in the shared metadata cache
+			uint64 m_shared_cache_version;
+
+			// number of objects fetched, and the time it took in microseconds
+			mutable ULONG m_num_fetches;
+			mutable ULLONG m_fetch_time_us;
+
+			// allocations made by the fetches, and their size in bytes
+			mutable ULLONG m_fetch_allocs;
+			mutable ULLONG m_fetch_alloc_bytes;
+
 			// private copy ctor
 			CMDProviderRelcache(const CMDProviderRelcache&);
 
+			// key of the object in the shared metadata cache, false if it
+			// can't be cached there
+			static
+			BOOL GetSharedCacheKey(IMDId *md_id, CHAR *key, ULONG size);
+
+			// is the object made only of objects created by initdb, so that
+			// it stays the same across catalog versions
+			static
+			BOOL IsBuiltinObject(const IMDCacheObject *md_obj);
+
+			// UTF-8 encoding of a DXL string, to keep it compact in the shared
+			// metadata cache. Returns NULL if it has no UTF-8 encoding
+			static
+			CHAR *EncodeUTF8(CMemoryPool *mp, const CWStringBase *str, ULONG *len);
+
+			// DXL string of a UTF-8 encoding made by EncodeUTF8, NULL if it
+			// isn't valid
+			static
+			CWStringDynamic *DecodeUTF8(CMemoryPool *mp, const CHAR *data, ULONG len);
+
+			// remember the object in the metadata cache, to evict it when
+			// the catalogs change
+			static
+			void TrackObject(CMDAccessor *md_accessor, IMDId *md_id);
+
+			// the DXL string of the object, from the shared metadata cache or
+			// the catalogs
+			CWStringBase *RetrieveMDObjDXLStr(CMemoryPool *mp, CMDAccessor *md_accessor, IMDId *md_id) const;
+
 		public:
 			// ctor/dtor
 			explicit
-			CMDProviderRelcache(CMemoryPool *mp);
+			CMDProviderRelcache(CMemoryPool *mp, BOOL use_shared_cache = false, uint64 shared_cache_version = 0);
 
 			~CMDProviderRelcache()
 			{
@@ -65,6 +109,30 @@ namespace gpmd
 			virtual
 			CWStringBase *GetMDObjDXLStr(CMemoryPool *mp, CMDAccessor *md_accessor, IMDId *md_id) const;
 
+			// number of objects fetched so far
+			ULONG GetNumFetches() const
+			{
+				return m_num_fetches;
+			}
+
+			// time spent fetching objects so far, in microseconds
+			ULLONG GetFetchTimeUS() const
+			{
+				return m_fetch_time_us;
+			}
+
+			// allocations made fetching objects so far
+			ULLONG GetFetchAllocs() const
+			{
+				return m_fetch_allocs;
+			}
+
+			// bytes allocated fetching objects so far
+			ULLONG GetFetchAllocBytes() const
+			{
+				return m_fetch_alloc_bytes;
+			}
+
 			// return the mdid for the requested type
 			virtual
 			IMDId *MDId
@@ -62,10 +62,12 @@ namespace gpdxl
 			// private copy ctor
 			CDXLTranslateContext(const CDXLTranslateContext&);
 
-			// mappings ColId->TargetEntry used for intermediate DXL nodes
+			// mappings ColId->TargetEntry used for intermediate DXL nodes, NULL
+			// until the first mapping is inserted
 			ULongToTargetEntryMap *m_colid_to_target_entry_map;
 
-			// mappings ColId->ParamId used for outer refs in subplans
+			// mappings ColId->ParamId used for outer refs in subplans, shared
+			// with the parent context until a mapping is inserted
 			ULongToColParamMap *m_colid_to_paramid_map;
 
 			// is the node for which this context is built a child of an aggregate node
@@ -20,12 +20,6 @@
 #define GPDXL_CMappingVarColId_H
 
 
-#include "gpopt/translate/CGPDBAttInfo.h"
-#include "gpopt/translate/CGPDBAttOptCol.h"
-
-#include "gpos/common/CHashMap.h"
-#include "gpos/common/CHashMapIter.h"
-
 #include "naucrates/dxl/operators/dxlops.h"
 #include "naucrates/dxl/CIdGenerator.h"
 
@@ -40,6 +34,8 @@ namespace gpmd
 
 namespace gpdxl
 {
+	using namespace gpos;
+
 	// physical operator types used in planned statements
 	enum EPlStmtPhysicalOpType
 	{
@@ -75,28 +71,47 @@ namespace gpdxl
 	class CMappingVarColId
 	{
 		private:
+			// mapping of a gpdb att (query level, varno, attno) to an
+			// optimizer col, a slot of the open addressing hash table
+			struct SGPDBAttOptCol
+			{
+				ULONG m_query_level;
+				ULONG m_var_no;		// 0 for an empty slot
+				INT m_attno;
+				ULONG m_colid;
+				CWStringBase *m_colname;	// owned by the mapping
+			};
+
 			// memory pool
 			CMemoryPool *m_mp;
 
-			// hash map structure to store gpdb att -> opt col information
-			typedef CHashMap<CGPDBAttInfo, CGPDBAttOptCol, HashGPDBAttInfo, EqualGPDBAttInfo,
-							CleanupRelease, CleanupRelease > GPDBAttOptColHashMap;
+			// slots of the hash table, a power of 2 of them
+			SGPDBAttOptCol *m_slots;
+			ULONG m_num_slots;
 
-			// iterator
-			typedef CHashMapIter<CGPDBAttInfo, CGPDBAttOptCol, HashGPDBAttInfo, EqualGPDBAttInfo,
-							CleanupRelease, CleanupRelease > GPDBAttOptColHashMapIter;
+			// number of mappings in the slots
+			ULONG m_num_mappings;
 
-			// map from gpdb att to optimizer col
-			GPDBAttOptColHashMap	*m_gpdb_att_opt_col_mapping;
+			// ctor with the number of slots to start with
+			CMappingVarColId(CMemoryPool *mp, ULONG num_slots);
 
-			// insert mapping entry
+			// slot of the gpdb att, or the empty slot it goes to
+			ULONG FindSlot(ULONG query_level, ULONG var_no, INT attno) const;
+
+			// insert mapping entry, the mapping takes over the column name
 			void Insert(ULONG, ULONG, INT, ULONG, CWStringBase *str);
 
+			// double the number of slots
+			void Grow();
+
+			// copy the mappings up to the query level, all of them if NULL
+			CMappingVarColId *Copy(CMemoryPool *mp, const ULONG *max_query_level) const;
+
 			// no copy constructor
 			CMappingVarColId(const CMappingVarColId &);
 
 			// helper function to access mapping
-			const CGPDBAttOptCol *GetGPDBAttOptColMapping
+			const SGPDBAttOptCol *GetGPDBAttOptColMapping
 								(
 								ULONG current_query_level,
 								const Var *var,
@@ -112,10 +127,7 @@ namespace gpdxl
 
 			// dtor
 			virtual
-			~CMappingVarColId()
-			{
-				m_gpdb_att_opt_col_mapping->Release();
-			}
+			~CMappingVarColId();
 
 			// given a gpdb attribute, return a column name in optimizer world
 			virtual
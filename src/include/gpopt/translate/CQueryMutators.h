@@ -54,6 +54,7 @@ namespace gpdxl
 	{
 		typedef Node *(*MutatorWalkerFn) ();
 		typedef BOOL (*FallbackWalkerFn) ();
+		typedef BOOL (*LevelsUpWalkerFn) ();
 
 		typedef struct SContextGrpbyPlMutator
 		{
@@ -133,6 +134,36 @@ namespace gpdxl
 
 		} CContextIncLevelsupMutator;
 
+		// context for walker that finds the references whose levels up change
+		// when a query is converted into a derived table
+		typedef struct SContextLevelsUpWalker
+		{
+			public:
+
+				// the current query level
+				ULONG m_current_query_level;
+
+				// is there a var referring to a query above the top level
+				BOOL m_has_outer_refs;
+
+				// is there a CTE range table entry defined at the top level or above
+				BOOL m_has_cte_refs;
+
+				// ctor
+				SContextLevelsUpWalker()
+					:
+					m_current_query_level(0),
+					m_has_outer_refs(false),
+					m_has_cte_refs(false)
+				{
+				}
+
+				// dtor
+				~SContextLevelsUpWalker()
+				{}
+
+		} CContextLevelsUpWalker;
+
 		// context for walker that iterates over the expression in the target entry
 		typedef struct SContextTLWalker
 				{
@@ -226,6 +257,10 @@ namespace gpdxl
 			static
 			Node *RunFixCTELevelsUpMutator(Node *node, SContextIncLevelsupMutator *context);
 
+			// find the outer references and CTE references the above mutators would fix
+			static
+			BOOL RunLevelsUpWalker(Node *node, SContextLevelsUpWalker *context);
+
 			// mutate the grouping columns, fix levels up when necessary
 			static
 			Node *RunGroupingColMutator(Node *node, SContextGrpbyPlMutator *context);
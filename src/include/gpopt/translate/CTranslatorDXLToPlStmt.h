@@ -192,6 +192,12 @@ namespace gpdxl
 			// Set the bitmapset of a plan to the list of param_ids defined by the plan
 			void SetParamIds(Plan *);
 
+			// Leave the bound of a limit in the sort below its gather motion
+			void PushLimitBelowGatherMotion(Limit *limit, Plan *child_plan);
+
+			// Can the expression be evaluated on the segments
+			static BOOL FExprEvaluableOnSegments(Node *expr);
+
 			// Set the qDispSliceId in the subplans defining an initplan
 			void SetInitPlanSliceInformation(SubPlan *);
 
@@ -537,6 +543,10 @@ namespace gpdxl
 				INT *width_out
 				);
 
+			// hash of the operators of a DXL tree and of the relations they
+			// read, the same for the same plan shape in every optimization
+			static ULONG FingerprintDXL(const CDXLNode *dxlnode);
+
 			// shortcut for translating both the projection list and the filter
 			void TranslateProjListAndFilter
 				(
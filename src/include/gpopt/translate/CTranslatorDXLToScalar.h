@@ -227,6 +227,13 @@ namespace gpdxl
 				CContextDXLToPlStmt *dxl_to_plstmt_ctxt
 				);
 
+			// make an uncorrelated IN or NOT IN subplan probe a hash table
+			Expr *TranslateHashedSubplan
+				(
+				SubPlan *subplan,
+				Plan *plan_child
+				);
+
 			// translate subplan test expression
 			Expr *TranslateDXLSubplanTestExprToScalar
 				(
@@ -23,6 +23,8 @@
 #include "gpopt/translate/CTranslatorUtils.h"
 
 #include "gpos/base.h"
+#include "gpos/common/CHashMap.h"
+#include "gpos/common/CHashMapIter.h"
 
 #include "naucrates/dxl/operators/CDXLNode.h"
 
@@ -207,6 +209,13 @@ namespace gpdxl
 			// translate the child of a set operation
 			CDXLNode *TranslateSetOpChild(Node *child_node, ULongPtrArray *pdrgpul, IMdIdArray *input_col_mdids, List *target_list);
 
+			// return the inputs of a set operation, flattening chains of unions
+			List *FlattenSetOpInputs(SetOperationStmt *setop_stmt) const;
+
+			// is the node a set operation of the same kind as the given one
+			static
+			BOOL IsSameSetOp(Node *node, SetOperationStmt *setop_stmt);
+
 			// return a dummy const table get
 			CDXLNode *DXLDummyConstTableGet() const;
 
@@ -440,6 +449,13 @@ namespace gpdxl
 			// translate a grouping func expression
 			CDXLNode *TranslateGroupingFuncToDXL(const Expr *expr, CBitSet *bitset, UlongToUlongMap *grpcol_index_to_colid_mapping) const;
 
+			// can the derived table of the range table entry be shared by its occurrences
+			static
+			BOOL IsShareableSubquery(const RangeTblEntry *rte);
+
+			// turn the derived tables occurring more than once into references to a CTE
+			void PromoteSharedSubqueriesToCTEs();
+
 			// construct a list of CTE producers from the query's CTE list
 			void ConstructCTEProducerList(List *cte_list, ULONG query_level);
 			
@@ -217,7 +217,8 @@ namespace gpdxl
 								const IMDType *md_type,
 								const Datum *mcv_values,
 								const float4 *mcv_frequencies,
-								ULONG num_mcv_values
+								ULONG num_mcv_values,
+								OID collation
 								);
 
 			// transform GPDB's hist information to optimizer's histogram structure
@@ -229,7 +230,8 @@ namespace gpdxl
 								const Datum *hist_values,
 								ULONG num_hist_values,
 								CDouble num_distinct,
-								CDouble hist_freq
+								CDouble hist_freq,
+								OID collation
 								);
 
 			// histogram to array of dxl buckets
@@ -247,6 +249,7 @@ namespace gpdxl
 								(
 								CMemoryPool *mp,
 								OID att_type,
+								OID att_collation,
 								CDouble num_distinct,
 								CDouble null_freq,
 								const Datum *mcv_values,
@@ -276,10 +279,6 @@ namespace gpdxl
 			static
 			CMDColumnArray *RetrieveRelColumns(CMemoryPool *mp, CMDAccessor *md_accessor, Relation rel, IMDRelation::Erelstoragetype rel_storage_type);
 
-			// return the dxl representation of the column's default value
-			static
-			CDXLNode *GetDefaultColumnValue(CMemoryPool *mp, CMDAccessor *md_accessor, TupleDesc rd_att, AttrNumber attrno);
-
 
 			// get the distribution columns
 			static
@@ -351,11 +350,7 @@ namespace gpdxl
 
 			// retrieve an index over a partitioned table from the relcache
 			static
-			IMDIndex *RetrievePartTableIndex(CMemoryPool *mp, CMDAccessor *md_accessor, IMDId *mdid_index, const IMDRelation *md_rel, LogicalIndexes *logical_indexes);
-			
-			// lookup an index given its id from the logical indexes structure
-			static
-			LogicalIndexInfo *LookupLogicalIndexById(LogicalIndexes *logical_indexes, OID oid);
+			IMDIndex *RetrievePartTableIndex(CMemoryPool *mp, CMDAccessor *md_accessor, IMDId *mdid_index, const IMDRelation *md_rel);
 			
 			// construct an MD cache index object given its logical index representation
 			static
@@ -431,7 +431,8 @@ namespace gpdxl
 				const Const *constant
 				);
 
-			// translate GPDB datum to CDXLDatum
+			// translate GPDB datum to CDXLDatum, collation is that of the
+			// comparisons of its statistics
 			static
 			CDXLDatum *TranslateDatumToDXL
 				(
@@ -440,7 +441,8 @@ namespace gpdxl
 				INT type_modifier,
 				BOOL is_null,
 				ULONG len,
-				Datum datum
+				Datum datum,
+				OID collation
 				);
 
 			// translate GPDB datum to IDatum
@@ -450,7 +452,8 @@ namespace gpdxl
 				CMemoryPool *mp,
 				const IMDType *md_type,
 				BOOL is_null,
-				Datum datum
+				Datum datum,
+				OID collation
 				);
 
 			// extract the byte array value of the datum
@@ -480,7 +483,8 @@ namespace gpdxl
 				IMDId *mdid,
 				BOOL is_null,
 				BYTE *bytes,
-				ULONG len
+				ULONG len,
+				OID collation
 				);
 
 			// pair of DXL datum type and translator function
@@ -554,7 +558,8 @@ namespace gpdxl
 				INT type_modifier,
 				BOOL is_null,
 				ULONG len,
-				Datum datum
+				Datum datum,
+				OID collation
 				);
 	};
 }
@@ -230,6 +230,11 @@ namespace gpdxl
 			static
 			CBitSetArray *GetColumnAttnosForGroupBy(CMemoryPool *mp, List *group_clause, ULONG num_cols, UlongToUlongMap *group_col_pos, CBitSet *group_cold);
 
+			// number of rollups, i.e., chains of nested grouping sets, that
+			// cover the given grouping sets
+			static
+			ULONG GetNumRollupsForGroupingSets(CMemoryPool *mp, CBitSetArray *grouping_sets);
+
 			// return a copy of the query with constant of unknown type being coerced
 			// to the common data type of the output target list
 			static
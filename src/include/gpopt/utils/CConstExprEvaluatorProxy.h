@@ -16,12 +16,16 @@
 #define GPDXL_CConstExprEvaluator_H
 
 #include "gpos/base.h"
+#include "gpos/common/CHashMap.h"
 
 #include "gpopt/eval/IConstDXLNodeEvaluator.h"
 #include "gpopt/mdcache/CMDAccessor.h"
+#include "gpopt/translate/CCTEListEntry.h"
 #include "gpopt/translate/CMappingColIdVar.h"
 #include "gpopt/translate/CTranslatorDXLToScalar.h"
 
+struct Const;
+
 namespace gpdxl
 {
 	class CDXLNode;
@@ -38,6 +42,10 @@ namespace gpdxl
 	//		creating an instance of this class and should not be released before
 	//		the destructor of this class.
 	//
+	//		The same expressions are evaluated many times during an optimization,
+	//		so the results are remembered for the lifetime of the instance, keyed
+	//		by the string representation of the translated expression.
+	//
 	//---------------------------------------------------------------------------
 	class CConstExprEvaluatorProxy : public gpopt::IConstDXLNodeEvaluator
 	{
@@ -86,6 +94,14 @@ namespace gpdxl
 			// translator for the DXL input -> GPDB Expr
 			CTranslatorDXLToScalar m_dxl2scalar_translator;
 
+			// map of evaluated expressions to their results, both allocated by GPDB
+			typedef CHashMap<CHAR, Const, HashStr, StrEqual, CleanupNULL, CleanupNULL> ExprToConstMap;
+
+			ExprToConstMap *m_evaluated_exprs;
+
+			// return a DXL constant value of a GPDB Const
+			CDXLNode *MakeConstValueNode(Const *constant);
+
 		public:
 			// ctor
 			CConstExprEvaluatorProxy
@@ -97,14 +113,17 @@ namespace gpdxl
 				m_mp(mp),
 				m_emptymapcidvar(m_mp),
 				m_md_accessor(md_accessor),
-				m_dxl2scalar_translator(m_mp, m_md_accessor, 0)
+				m_dxl2scalar_translator(m_mp, m_md_accessor, 0),
+				m_evaluated_exprs(NULL)
 			{
+				m_evaluated_exprs = GPOS_NEW(m_mp) ExprToConstMap(m_mp);
 			}
 
 			// dtor
 			virtual
 			~CConstExprEvaluatorProxy()
 			{
+				m_evaluated_exprs->Release();
 			}
 
 			// evaluate given constant expressionand return the DXL representation of the result.
@@ -21,6 +21,7 @@
 
 #include "gpopt/base/CColRef.h"
 #include "gpopt/search/CSearchStage.h"
+#include "naucrates/dxl/operators/CDXLNode.h"
 
 
 
@@ -45,6 +46,11 @@ namespace gpopt
 	class ICostModel;
 }
 
+namespace gpdb
+{
+	struct MDCacheObject;
+}
+
 struct PlannedStmt;
 struct Query;
 struct List;
@@ -97,6 +103,10 @@ struct SOptContext
 	// buffer for optimizer error messages
 	CHAR *m_error_msg;
 
+	// number of times the optimization time budget expired, the best plan
+	// found so far was returned then
+	ULONG m_search_time_budget_hits;
+
 	// ctor
 	SOptContext();
 
@@ -120,6 +130,20 @@ class COptTasks
 {
 	private:
 
+		// context of the walker prefetching the statistics used by a query
+		typedef struct SContextPrefetchMD
+		{
+			// memory pool
+			CMemoryPool *m_mp;
+
+			// metadata accessor to load the objects into
+			CMDAccessor *m_md_accessor;
+
+			// range table of the query being walked
+			List *m_rtable;
+
+		} SContextPrefetchMD;
+
 		// execute a task given the argument
 		static
 		void Execute ( void *(*func) (void *), void *func_arg);
@@ -130,7 +154,15 @@ class COptTasks
 
 		// create optimizer configuration object
 		static
-		COptimizerConfig *CreateOptimizerConfig(CMemoryPool *mp, ICostModel *cost_model);
+		COptimizerConfig *CreateOptimizerConfig(CMemoryPool *mp, ICostModel *cost_model, Query *query);
+
+		// create the mdid of an object tracked for invalidation of the metadata cache
+		static
+		IMDId *CreateMDCacheObjectMdid(CMemoryPool *mp, const gpdb::MDCacheObject *object);
+
+		// evict the objects invalidated by catalog changes from the metadata cache
+		static
+		void EvictMDCacheObjects(CMemoryPool *mp, const gpdb::MDCacheObject *objects, ULONG num_objects);
 
 		// optimize a query to a physical DXL
 		static
@@ -144,6 +176,60 @@ class COptTasks
 		static
 		CSearchStageArray *LoadSearchStrategy(CMemoryPool *mp, char *path);
 
+		// search strategy from given path, loaded once for as long as the
+		// path doesn't change
+		static
+		CSearchStageArray *GetSearchStrategy(CMemoryPool *mp, char *path);
+
+		// trace flags of the GUCs and the disabled xforms, packed again only
+		// once either changes
+		static
+		CBitSet *GetTraceFlags();
+
+		// trace flags that search the join orders with the exhaustive2
+		// xforms instead of the exhaustive ones
+		static
+		CBitSet *UseDPv2JoinOrder(CMemoryPool *mp, CBitSet *trace_flags);
+
+		// limit the search stages to the optimization time budget
+		static
+		CSearchStageArray *ApplySearchTimeBudget(CMemoryPool *mp, CSearchStageArray *search_strategy_arr, ULONG budget_ms);
+
+		// did a search stage run out of the optimization time budget
+		static
+		BOOL SearchTimeBudgetHit(CSearchStageArray *search_strategy_arr, ULONG budget_ms);
+
+		// count the outcome of each stage of the search strategy of an optimization
+		static
+		void RecordSearchStageStats(CSearchStageArray *search_strategy_arr);
+
+		// load the statistics of the relations and columns used by a query
+		// into the metadata cache before the search starts
+		static
+		void PrefetchMDObjects(CMemoryPool *mp, CMDAccessor *md_accessor, Query *query);
+
+		// walker of the expressions of a query for PrefetchMDObjects
+		static
+		BOOL PrefetchMDWalker(Node *node, SContextPrefetchMD *context);
+
+		// load the statistics of a column of a relation
+		static
+		void PrefetchColStats(CMemoryPool *mp, CMDAccessor *md_accessor, OID rel_oid, INT attno);
+
+		// keep the minidump of an optimization that took longer than optimizer_capture_threshold
+		static
+		void CaptureOptimization
+			(
+			CMemoryPool *mp,
+			CMDAccessor *md_accessor,
+			const CDXLNode *query_dxl,
+			const CDXLNodeArray *query_output_dxlnode_array,
+			const CDXLNodeArray *cte_dxlnode_array,
+			const CDXLNode *plan_dxl,
+			COptimizerConfig *optimizer_config,
+			double optimization_time
+			);
+
 		// helper for converting wide character string to regular string
 		static
 		CHAR *CreateMultiByteCharStringFromWCString(const WCHAR *wcstr);
@@ -160,6 +246,10 @@ class COptTasks
 		static
 		BOOL ShouldErrorOut(gpos::CException &exc);
 
+		// check if the metadata cache can be kept after given exception
+		static
+		BOOL IsMDCacheIntact(gpos::CException &exc);
+
 		// set cost model parameters
 		static
 		void SetCostModelParams(ICostModel *cost_model);
@@ -28,12 +28,16 @@ extern "C" {
 #include "executor/execdesc.h"
 #include "executor/nodeMotion.h"
 #include "parser/parsetree.h"
+#include "utils/hsearch.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/syscache.h"
 #include "utils/datum.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/pg_locale.h"
+#include "mb/pg_wchar.h"
 #include "optimizer/walkers.h"
 #include "parser/parse_expr.h"
 #include "parser/parse_relation.h"
@@ -48,10 +52,13 @@ extern "C" {
 #include "cdb/cdbutil.h"
 #include "cdb/cdbmutate.h"
 #include "commands/defrem.h"
+#include "commands/vacuum.h"
 #include "utils/typcache.h"
 #include "utils/numeric.h"
 #include "optimizer/tlist.h"
 #include "optimizer/planmain.h"
+#include "optimizer/clauses.h"
+#include "optimizer/var.h"
 #include "nodes/makefuncs.h"
 #include "catalog/pg_operator.h"
 #include "lib/stringinfo.h"
@@ -65,6 +72,12 @@ extern "C" {
 #include "commands/trigger.h"
 #include "parser/parse_coerce.h"
 #include "utils/selfuncs.h"
+#include "utils/sharedmdcache.h"
+#include "optimizer/orca.h"
+#include "optimizer/orcaplancache.h"
+#include "optimizer/orcafeedback.h"
+#include "optimizer/orcacostparams.h"
+#include "optimizer/orcadamping.h"
 #include "utils/faultinjector.h"
 #include "funcapi.h"
 
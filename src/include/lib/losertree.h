@@ -0,0 +1,65 @@
+/*
+ * losertree.h
+ *
+ * A tree of losers, for merging sorted streams
+ *
+ * Portions Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * src/include/lib/losertree.h
+ */
+
+#ifndef LOSERTREE_H
+#define LOSERTREE_H
+
+/*
+ * Like for a max-heap, the first node is the greatest, the comparator must
+ * return <0 iff a < b, 0 iff a == b, and >0 iff a > b.
+ */
+typedef int (*losertree_comparator) (Datum a, Datum b, void *arg);
+
+/*
+ * losertree
+ *
+ * Each leaf of the tree holds the current element of one input stream.  Each
+ * internal node holds the leaf that lost the match played there, and node 0
+ * the leaf that won the whole tournament.  When the element of the winning
+ * leaf is replaced, only the matches on the path from that leaf to the root
+ * are replayed, with one comparison per level, against the losers stored on
+ * the path.
+ *
+ *		lt_size			how many leaves have been added
+ *		lt_space		how many leaves can be stored
+ *		lt_active		how many leaves haven't been removed
+ *		lt_built		no unordered operations since the tree was built
+ *		lt_compare		comparison function defining the order
+ *		lt_arg			user data for comparison function
+ *		lt_leaves		element of each leaf
+ *		lt_removed		has the leaf been removed?
+ *		lt_nodes		winner, then the loser of each internal node
+ */
+typedef struct losertree
+{
+	int			lt_size;
+	int			lt_space;
+	int			lt_active;
+	bool		lt_built;
+	losertree_comparator lt_compare;
+	void	   *lt_arg;
+	Datum	   *lt_leaves;
+	bool	   *lt_removed;
+	int		   *lt_nodes;
+} losertree;
+
+extern losertree *losertree_allocate(int capacity,
+				   losertree_comparator compare,
+				   void *arg);
+extern void losertree_free(losertree *tree);
+extern void losertree_add_unordered(losertree *tree, Datum d);
+extern void losertree_build(losertree *tree);
+extern Datum losertree_first(losertree *tree);
+extern Datum losertree_remove_first(losertree *tree);
+extern void losertree_replace_first(losertree *tree, Datum d);
+
+#define losertree_empty(t)			((t)->lt_active == 0)
+
+#endif   /* LOSERTREE_H */
@@ -602,6 +602,9 @@ typedef struct EState
 	/* Current positions of cursors used in CURRENT OF expressions */
 	List	   *es_cursorPositions;
 
+	/* BroadcastCacheKeys of the Motions the broadcast cache may serve */
+	List	   *es_broadcastCacheKeys;
+
 	/* Data structure for node sharing */
 	List	  **es_sharenode;
 
@@ -1006,6 +1009,21 @@ typedef struct ScalarArrayOpExprState
 	int			fp_n;
 	int		   *fp_len;
 	Datum	   *fp_datum;
+
+	/*
+	 * Lookup of x = ANY (large constant array), in a hash table of
+	 * lookup_n slots, or among lookup_n sorted elements if not hashed.  The
+	 * procs are the hash functions, or the btree comparison functions of
+	 * scalar vs element and element vs element.
+	 */
+	bool		lookup_hashed;
+	bool		lookup_has_nulls;	/* array has NULL elements */
+	int			lookup_n;
+	Datum	   *lookup_elems;
+	uint32	   *lookup_hashes;	/* hash of the element in each slot */
+	bool	   *lookup_used;	/* slot has an element */
+	FmgrInfo	lookup_lhs_proc;
+	FmgrInfo	lookup_rhs_proc;
 } ScalarArrayOpExprState;
 
 /* ----------------
@@ -1126,6 +1144,13 @@ typedef struct SubPlanState
 	FmgrInfo   *tab_eq_funcs;	/* equality functions for table datatype(s) */
 	FmgrInfo   *lhs_hash_funcs; /* hash functions for lefthand datatype(s) */
 	FmgrInfo   *cur_eq_funcs;	/* equality functions for LHS vs. table */
+	/* these are used when caching results by the correlation values: */
+	TupleHashTable memotable;	/* cached results, keyed by parParam values */
+	TupleTableSlot *memoslot;	/* slot holding the current parParam values */
+	Bitmapset  *memoparams;		/* set of parParam ids */
+	bool		memofull;		/* TRUE if memotable has used up work_mem */
+	int16		memotyplen;		/* type of the cached results */
+	bool		memotypbyval;
 } SubPlanState;
 
 /* ----------------
@@ -1804,6 +1829,18 @@ typedef struct DynamicIndexScanState
  *		ScanDesc		   index scan descriptor
  *		VMBuffer		   buffer in use for visibility map testing, if any
  *		HeapFetches		   number of tuples we were forced to fetch from heap
+ *		SkipDistinct	   skip to the next value of the leading column once
+ *						   a tuple is returned (for a parent that only needs
+ *						   one tuple of each value)
+ *		SkipPending		   skip before fetching the next tuple
+ *		Skipping		   SkipScanDesc is the scan in use
+ *		SkipValue		   leading column value to skip past
+ *		SkipContext		   memory context holding SkipValue
+ *		SkipKeys		   key on SkipValue, followed by ScanKeys
+ *		SkipGtFn/SkipLtFn  > and < of the leading column
+ *		SkipScanDesc	   index scan descriptor for SkipKeys
+ *		SkipNulls		   SkipScanDesc is reading the NULLs, which the skip
+ *						   key excludes, after the other values
  * ----------------
  */
 typedef struct IndexOnlyScanState
@@ -1822,6 +1859,16 @@ typedef struct IndexOnlyScanState
 	IndexScanDesc ioss_ScanDesc;
 	Buffer		ioss_VMBuffer;
 	long		ioss_HeapFetches;
+	bool		ioss_SkipDistinct;
+	bool		ioss_SkipPending;
+	bool		ioss_Skipping;
+	Datum		ioss_SkipValue;
+	MemoryContext ioss_SkipContext;
+	ScanKey		ioss_SkipKeys;
+	FmgrInfo	ioss_SkipGtFn;
+	FmgrInfo	ioss_SkipLtFn;
+	IndexScanDesc ioss_SkipScanDesc;
+	bool		ioss_SkipNulls;
 } IndexOnlyScanState;
 
 /* ----------------
@@ -2161,14 +2208,35 @@ typedef struct ForeignScanState
  *	 ExternalScan nodes are used to scan external tables
  *
  *	 ess_ScanDesc                the state of the file data scan
+ *	 ess_AggType                 the aggregates computed right above the scan
  * ----------------
  */
+
+/*
+ * The aggregates an Agg right above an external scan computes, passed on to
+ * the protocol so that it may answer them from the statistics of the data
+ * rather than from all of its rows.  The rows the protocol returns instead
+ * must give the same results:
+ *
+ *	 EXTSCAN_AGG_COUNT	 only COUNT(*): as many rows as the data has, with any
+ *						 values
+ *	 EXTSCAN_AGG_MINMAX	 only MIN and MAX of columns: rows whose minimum and
+ *						 maximum of each column are those of the data
+ */
+typedef enum ExternalScanAggType
+{
+	EXTSCAN_AGG_NONE = 0,
+	EXTSCAN_AGG_COUNT,
+	EXTSCAN_AGG_MINMAX
+} ExternalScanAggType;
+
 typedef struct ExternalScanState
 {
 	ScanState	ss;
 	struct FileScanDescData *ess_ScanDesc;
 	bool		cdb_want_ctid;
 	ItemPointerData cdb_fake_ctid;
+	ExternalScanAggType ess_AggType;
 } ExternalScanState;
 
 /*
@@ -2274,6 +2342,7 @@ typedef struct NestLoopState
 	List	   *nl_OuterJoinKeys;        /* list of ExprState nodes */
 	bool		nl_innerSideScanned;      /* set to true once we've scanned all inner tuples the first time */
 	bool		nl_qualResultForNull;     /* the value of the join condition when one of the sides contains a NULL */
+	struct NestLoopCache *nl_cache;       /* cache of inner tuples by nestParams values, or NULL */
 } NestLoopState;
 
 /* ----------------
@@ -2473,12 +2542,22 @@ typedef struct SortState
 	int64		bound_Done;		/* value of bound we did the sort with */
 	GenericTupStore *tuplesortstate; /* private state of tuplesort.c */
 	bool		noduplicates;	/* true if discard duplicate rows */
+	ExprState  *limitOffset;	/* OFFSET parameter, or NULL if none */
+	ExprState  *limitCount;		/* COUNT parameter, or NULL if none */
 
 	bool		delayEagerFree;		/* is is safe to free memory used by this node,
 									 * when this node has outputted its last row? */
 
 	void	   *share_lk_ctxt;
 
+	/* incremental sort, of runs of rows with equal presorted keys */
+	int			presortedCols;	/* number of presorted keys, or 0 */
+	FmgrInfo   *presortedEqfunctions;	/* equality fns of presorted keys */
+	TupleTableSlot *presortedPivot; /* first row of the current keys */
+	bool		presortedPending;	/* pivot not yet added to a run? */
+	bool		presortedInputDone; /* read all of the input? */
+	int64		presortedEmitted;	/* rows returned so far */
+
 } SortState;
 
 /* ---------------------
@@ -2503,6 +2582,7 @@ typedef enum HashAggStatus
 	HASHAGG_IN_A_PASS,
 	HASHAGG_BETWEEN_PASSES,
 	HASHAGG_STREAMING,
+	HASHAGG_PASSTHROUGH,
 	HASHAGG_END_OF_PASSES
 } HashAggStatus;
 
@@ -2535,6 +2615,7 @@ typedef struct AggState
 	struct HashAggTable *hhashtable;
 	HashAggStatus hashaggstatus;
 	MemoryManagerContainer mem_manager;
+	bool		passthrough_ok; /* streaming, may pass input tuples through */
 
 	/* ROLLUP */
 	AggStatePerGroup perpassthru; /* per-Aggref-per-pass-through-tuple working state */
@@ -2785,6 +2866,16 @@ typedef struct DMLState
 	PlanState	ps;
 	JunkFilter *junkfilter;			/* filter that removes junk and dropped attributes */
 	TupleTableSlot *cleanedUpSlot;	/* holds 'final' tuple which matches the target relation schema */
+
+	/*
+	 * Inserts into a partitioned table are buffered per target partition
+	 * when batchInserts is set, see ExecDML.
+	 */
+	bool		batchInserts;
+	MemoryContext batchContext;		/* holds the buffered tuples */
+	HTAB	   *batchHash;			/* buffer of each partition, or NULL */
+	List	   *batchParts;			/* the buffers, in order of first tuple */
+	Size		batchBytes;			/* bytes of the buffered tuples */
 } DMLState;
 
 /*
@@ -2852,6 +2943,8 @@ typedef struct MotionState
 	bool		sentEndOfStream;	/* set when end-of-stream has successfully been sent */
 	List	   *hashExprs;		/* state struct used for evaluating the hash expressions */
 	struct CdbHash *cdbhash;	/* hash api object */
+	int		   *skewSampleCounts;	/* rows of the skew sample sent to each
+									 * segment, NULL if not sampling */
 
 	/* For Motion recv */
 	int			routeIdNext;	/* for a sorted motion node, the routeId to get next (same as
@@ -2862,10 +2955,13 @@ typedef struct MotionState
 	/* For sorted Motion recv */
 	struct MotionMKHeapContext *tupleheap_mk;		/* data structure for match merge in sorted motion node */
 
-	struct binaryheap *tupleheap;
+	struct losertree *tupleheap;	/* merges the senders, by their next tuple */
 	struct CdbTupleHeapInfo *tupleheap_entries;
 	struct CdbMergeComparatorContext *tupleheap_cxt;
 
+	/* For broadcast Motion recv served by the broadcast cache, or NULL */
+	struct BroadcastCacheState *bcache;
+
 	/* The following can be used for debugging, usage stats, etc.  */
 	int			numTuplesFromChild;	/* Number of tuples received from child */
 	int			numTuplesToAMS;		/* Number of tuples from child that were sent to AMS */
@@ -2906,6 +3002,10 @@ typedef struct PartitionSelectorState
 	TupleDesc	partTabDesc;
 	TupleTableSlot *partTabSlot;
 	ProjectionInfo *partTabProj;
+
+	TupleDesc	rootTupDesc;                            /* root table's, for equality predicates */
+	Datum	   *partKeyValues;                          /* partition key value of a level ... */
+	bool	   *partKeyIsnull;                          /* ... indexed by attribute of the root */
 } PartitionSelectorState;
 
 #endif   /* EXECNODES_H */
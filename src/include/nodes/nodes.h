@@ -47,6 +47,7 @@ typedef enum NodeTag
 	T_PartitionState,
 	T_QueryDispatchDesc,
 	T_OidAssignment,
+	T_BroadcastCacheKey,
 
 	/*
 	 * TAGS FOR PLAN NODES (plannodes.h)
@@ -200,6 +200,13 @@ typedef struct Plan
 	double		plan_rows;		/* number of rows plan is expected to emit */
 	int			plan_width;		/* average row width in bytes */
 
+	/*
+	 * CDB: hash of the shape of the GPORCA plan below this node, to match
+	 * its estimates with the runtime statistics of plans of the same shape.
+	 * 0 for the plans of the Postgres planner.
+	 */
+	uint32		plan_fingerprint;
+
 	/*
 	 * Common structural data for all Plan types.
 	 */
@@ -1008,6 +1015,19 @@ typedef struct Sort
     /* CDB */
 	bool		noduplicates;   /* TRUE if sort should discard duplicates */
 
+	/*
+	 * Number of leading sort keys that the input is already sorted on.  If
+	 * not 0, each run of rows with equal values in them is sorted on its own.
+	 */
+	int			numPresortedCols;
+
+	/*
+	 * Bound of a Limit above a Motion, the sort needs to return no more than
+	 * limitCount + limitOffset tuples.  NULL if there is no such bound.
+	 */
+	Node	   *limitOffset;	/* OFFSET parameter, or NULL if none */
+	Node	   *limitCount;		/* COUNT parameter, or NULL if none */
+
 	/* Sort node can be shared */
 	ShareType 	share_type;
 	int 		share_id;
@@ -1185,6 +1205,9 @@ typedef struct Unique
  * skewTable/skewColumn/skewInherit identify the outer relation's join key
  * column, from which the relevant MCV statistics can be fetched.  Also, its
  * type information is provided to save a lookup.
+ *
+ * CDB: the segments have no statistics, so the MCVs can also come with the
+ * plan, in skewValues.
  * ----------------
  */
 typedef struct Hash
@@ -1196,6 +1219,8 @@ typedef struct Hash
 	bool		skewInherit;	/* is outer join rel an inheritance tree? */
 	Oid			skewColType;	/* datatype of the outer key column */
 	int32		skewColTypmod;	/* typmod of the outer key column */
+	List	   *skewValues;		/* CDB: Consts of the MCVs of the outer key,
+								 * most common first, or NIL to look them up */
 	/* all other info is in the parent HashJoin node */
 } Hash;
 
@@ -1303,6 +1328,9 @@ typedef struct Motion
 	/* For Explicit */
 	AttrNumber segidColIdx;			/* index of the segid column in the target list */
 
+	/* compress the interconnect packets, see gp_interconnect_compression */
+	bool		compressTuples;
+
 	/* The following field is only used when sendSorted == true */
 	int			numSortCols;	/* number of sort-key columns */
 	AttrNumber *sortColIdx;		/* their indexes in the target list */
@@ -18,10 +18,95 @@
 #define ORCA_H
 
 #include "pg_config.h"
+#include "datatype/timestamp.h"
+#include "utils/relcache.h"
+
+/*
+ * Where the time of GPORCA goes. Times are in milliseconds, the metadata
+ * fetches overlap the translation and the search.
+ */
+typedef struct OptimizerStats
+{
+	int64		num_optimizations;
+	double		translate_time;		/* Query to DXL, normalization included */
+	double		search_time;		/* search of the plan */
+	double		plan_time;			/* DXL to PlannedStmt */
+	double		missing_stats_time;	/* check for missing statistics */
+	int64		num_mdfetches;		/* objects missing from the metadata cache */
+	double		mdfetch_time;
+	int64		peak_memory;		/* bytes, of the optimizer memory account */
+	int64		memory_limit_hits;	/* fell back, optimizer_memory_limit hit */
+
+	/*
+	 * Allocations made by the phases, and their total size in bytes.  Those
+	 * of the metadata fetches are included in the phases they happen in.
+	 */
+	int64		translate_allocs;
+	int64		translate_alloc_bytes;
+	int64		search_allocs;
+	int64		search_alloc_bytes;
+	int64		plan_allocs;
+	int64		plan_alloc_bytes;
+	int64		mdfetch_allocs;
+	int64		mdfetch_alloc_bytes;
+
+	/*
+	 * The join search: relations of the largest join, pairs of connected
+	 * subgraphs a connected-subgraph enumerator would join (up to one past
+	 * optimizer_join_search_budget), and whether a join above
+	 * optimizer_join_order_threshold was searched with dynamic programming.
+	 */
+	int			join_relations;
+	int64		join_pairs;
+	bool		join_search_dp;
+} OptimizerStats;
+
+/* of the last optimization, and of all the ones of the backend so far */
+extern OptimizerStats optimizer_last_stats;
+extern OptimizerStats optimizer_total_stats;
+
+/* Number of stages of the search strategy the backend keeps counts of */
+#define OPTIMIZER_MAX_SEARCH_STAGES 16
+
+/*
+ * The outcome of a stage of the search strategy, over the optimizations of
+ * the backend that used a search strategy with as many stages.
+ */
+typedef struct OptimizerSearchStageStats
+{
+	int			num_xforms;		/* transformations the stage may apply */
+	int64		num_searches;	/* optimizations the stage was part of */
+	int64		num_plans;		/* the ones the stage found a plan in */
+	int64		num_best;		/* the ones its plan was the cheapest in */
+	double		last_cost;		/* of its plan in the last one, -1 if none */
+} OptimizerSearchStageStats;
+
+extern OptimizerSearchStageStats optimizer_search_stage_stats[OPTIMIZER_MAX_SEARCH_STAGES];
+extern int	optimizer_num_search_stages;
+
+/* Number of slow optimizations the backend keeps the minidump of */
+#define OPTIMIZER_NUM_CAPTURES 8
+
+/* An optimization that took longer than optimizer_capture_threshold */
+typedef struct OptimizerCapture
+{
+	TimestampTz	captured_at;
+	double		optimization_time;	/* translation and search, in ms */
+	char	   *query_text;
+	char	   *minidump;			/* DXL of the metadata, query and plan */
+} OptimizerCapture;
 
 #ifdef USE_ORCA
 
 extern PlannedStmt * optimize_query(Query *parse, ParamListInfo boundParams);
+extern double orca_estimate_partitioned_numtuples(Relation rel,
+												  bool *stats_missing);
+extern int	orca_count_leaf_part_tables(Oid rootOid);
+extern Node *orca_get_relation_part_constraints(Oid rootOid,
+												List **defaultLevels);
+extern void orca_capture_optimization(double optimization_time,
+									  const char *minidump);
+extern const OptimizerCapture *orca_get_capture(int n);
 
 #else
 
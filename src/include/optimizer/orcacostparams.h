@@ -0,0 +1,25 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcacostparams.h
+ *	  Calibrated parameters of the GPORCA cost model, from the
+ *	  gp_optimizer_cost_params catalog.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcacostparams.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCACOSTPARAMS_H
+#define ORCACOSTPARAMS_H
+
+typedef struct OrcaCostParam
+{
+	char		name[NAMEDATALEN];	/* name of the cost model parameter */
+	double		factor;			/* multiplier of its default value */
+} OrcaCostParam;
+
+extern OrcaCostParam *OrcaCostParamsGet(int *num_params);
+
+#endif   /* ORCACOSTPARAMS_H */
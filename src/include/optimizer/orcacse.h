@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcacse.h
+ *	  Evaluate the expressions that the filter and the target list of a
+ *	  GPORCA scan share once per row.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcacse.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCACSE_H
+#define ORCACSE_H
+
+#include "nodes/plannodes.h"
+
+extern void orca_common_subexpressions(PlannedStmt *stmt);
+
+#endif   /* ORCACSE_H */
@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcadamping.h
+ *	  Derive the filter damping factor of GPORCA from the functional
+ *	  dependencies between the filtered columns.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcadamping.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCADAMPING_H
+#define ORCADAMPING_H
+
+#include "nodes/parsenodes.h"
+
+extern double orca_filter_damping_factor(Query *query, double damping);
+
+#endif   /* ORCADAMPING_H */
@@ -0,0 +1,42 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcafeedback.h
+ *	  Row counts of tables observed by EXPLAIN ANALYZE, for the estimates of
+ *	  GPORCA.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcafeedback.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAFEEDBACK_H
+#define ORCAFEEDBACK_H
+
+#include "datatype/timestamp.h"
+#include "executor/execdesc.h"
+
+/* Number of plan nodes the backend keeps the statistics of */
+#define ORCA_PLAN_TRACE_SIZE 1024
+
+/* Estimated and actual statistics of a node of an executed plan of GPORCA */
+typedef struct OrcaPlanTraceEntry
+{
+	TimestampTz	recorded_at;
+	uint32		fingerprint;	/* Plan.plan_fingerprint */
+	const char *node_type;
+	double		plan_rows;		/* estimated rows, over all segments */
+	double		actual_rows;	/* rows per loop, summed over the segments */
+	Cost		total_cost;
+	double		actual_time;	/* most time per loop of a segment, in ms */
+} OrcaPlanTraceEntry;
+
+extern void OrcaFeedbackRecord(QueryDesc *queryDesc);
+extern bool OrcaFeedbackLookup(Oid relid, double *numtuples);
+extern Oid *OrcaFeedbackGetChangedRels(int *num_rels);
+
+extern void OrcaPlanTraceRecord(QueryDesc *queryDesc);
+extern const OrcaPlanTraceEntry *OrcaPlanTraceGet(int n);
+
+#endif   /* ORCAFEEDBACK_H */
@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcahashskew.h
+ *	  Let the hash joins of GPORCA plans keep the most common values of the
+ *	  outer side in memory.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcahashskew.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAHASHSKEW_H
+#define ORCAHASHSKEW_H
+
+#include "nodes/plannodes.h"
+
+extern void orca_hash_join_skew(PlannedStmt *stmt);
+
+#endif   /* ORCAHASHSKEW_H */
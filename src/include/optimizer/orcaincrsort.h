@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaincrsort.h
+ *	  Turn the sorts of GPORCA plans into incremental sorts.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcaincrsort.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAINCRSORT_H
+#define ORCAINCRSORT_H
+
+#include "nodes/plannodes.h"
+
+extern void orca_incremental_sorts(PlannedStmt *stmt);
+
+#endif   /* ORCAINCRSORT_H */
@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaindexonly.h
+ *	  Turn the index scans of GPORCA plans into index-only scans.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcaindexonly.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAINDEXONLY_H
+#define ORCAINDEXONLY_H
+
+#include "nodes/plannodes.h"
+
+extern void orca_index_only_scans(PlannedStmt *stmt);
+
+#endif   /* ORCAINDEXONLY_H */
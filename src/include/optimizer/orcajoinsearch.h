@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcajoinsearch.h
+ *	  Choose how GPORCA searches the join orders of a large join.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcajoinsearch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAJOINSEARCH_H
+#define ORCAJOINSEARCH_H
+
+#include "nodes/parsenodes.h"
+
+extern void orca_choose_join_search(Query *query);
+
+#endif   /* ORCAJOINSEARCH_H */
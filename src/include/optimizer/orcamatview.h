@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcamatview.h
+ *	  Answer aggregate queries of GPORCA from materialized views.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcamatview.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAMATVIEW_H
+#define ORCAMATVIEW_H
+
+#include "nodes/parsenodes.h"
+
+extern Query *orca_rewrite_matview(Query *query);
+
+#endif   /* ORCAMATVIEW_H */
@@ -0,0 +1,23 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcapartjoin.h
+ *	  Split GPORCA hash joins of co-partitioned tables into joins of their
+ *	  partitions, and sorts of partitioned tables into merges of ordered
+ *	  scans of their partitions.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcapartjoin.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAPARTJOIN_H
+#define ORCAPARTJOIN_H
+
+#include "nodes/plannodes.h"
+
+extern void orca_partition_wise_joins(PlannedStmt *stmt);
+extern void orca_partition_merge_appends(PlannedStmt *stmt);
+
+#endif   /* ORCAPARTJOIN_H */
@@ -0,0 +1,35 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaplancache.h
+ *	  Cache of the plans produced by GPORCA, keyed by the query shape.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcaplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAPLANCACHE_H
+#define ORCAPLANCACHE_H
+
+#include "executor/execdesc.h"
+#include "nodes/parsenodes.h"
+#include "nodes/plannodes.h"
+
+/* A query with its constants extracted, opaque outside orcaplancache.c */
+typedef struct OrcaPlanCacheQuery OrcaPlanCacheQuery;
+
+extern PlannedStmt *OrcaPlanCacheLookup(const Query *query,
+										OrcaPlanCacheQuery **cache_query);
+extern void OrcaPlanCacheStore(OrcaPlanCacheQuery *cache_query,
+							   PlannedStmt *plan);
+extern void OrcaPlanCacheReset(void);
+
+extern PlannedStmt *OrcaPlanBaselineChoose(OrcaPlanCacheQuery *cache_query,
+										   PlannedStmt *plan);
+extern void OrcaPlanBaselineStartExecution(QueryDesc *queryDesc, int eflags);
+extern void OrcaPlanBaselineEndExecution(QueryDesc *queryDesc);
+extern void OrcaPlanBaselineReset(void);
+
+#endif   /* ORCAPLANCACHE_H */
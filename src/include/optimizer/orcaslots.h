@@ -0,0 +1,22 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaslots.h
+ *	  Limit on the number of GPORCA optimizations running at once.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcaslots.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCASLOTS_H
+#define ORCASLOTS_H
+
+extern Size OrcaSlotsShmemSize(void);
+extern void OrcaSlotsShmemInit(void);
+
+extern void OrcaSlotAcquire(void);
+extern void OrcaSlotRelease(void);
+
+#endif   /* ORCASLOTS_H */
@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcawindowsort.h
+ *	  Share the sorts of stacked window functions in GPORCA plans.
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	    src/include/optimizer/orcawindowsort.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ORCAWINDOWSORT_H
+#define ORCAWINDOWSORT_H
+
+#include "nodes/plannodes.h"
+
+extern void orca_shared_window_sorts(PlannedStmt *stmt);
+
+#endif   /* ORCAWINDOWSORT_H */
@@ -25,6 +25,8 @@ extern bool inject_partition_selectors_for_join(PlannerInfo *root,
 
 extern Plan *create_partition_selector_plan(PlannerInfo *root, PartitionSelectorPath *pspath);
 
+extern Plan *create_partition_selector_for_params(PlannerInfo *root, RelOptInfo *rel);
+
 extern RestrictInfo *make_mergeclause(Node *outer, Node *inner);
 
 #endif /* PLANPARTITION_H */
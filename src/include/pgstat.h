@@ -381,6 +381,7 @@ typedef struct PgStat_MsgAnalyze
 	TimestampTz m_analyzetime;
 	PgStat_Counter m_live_tuples;
 	PgStat_Counter m_dead_tuples;
+	PgStat_Counter m_modcount;	/* GPDB: see analyze_modcount */
 } PgStat_MsgAnalyze;
 
 
@@ -576,7 +577,7 @@ typedef union PgStat_Msg
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9C
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9D
 
 /* ----------
  * PgStat_StatDBEntry			The collector's data per database
@@ -651,6 +652,12 @@ typedef struct PgStat_StatTabEntry
 	PgStat_Counter analyze_count;
 	TimestampTz autovac_analyze_timestamp;		/* autovacuum initiated */
 	PgStat_Counter autovac_analyze_count;
+
+	/*
+	 * GPDB: the modification count of the segments for the table at the last
+	 * ANALYZE of all its columns, -1 if unknown.  See gp_relation_modcount().
+	 */
+	PgStat_Counter analyze_modcount;
 } PgStat_StatTabEntry;
 
 
@@ -771,6 +778,7 @@ typedef enum BackendState
 #define PGBE_WAITING_LOCK			'l'
 #define PGBE_WAITING_REPLICATION	'r'
 #define PGBE_WAITING_RESGROUP		'g'
+#define PGBE_WAITING_OPTIMIZER		'o'
 #define PGBE_WAITING_NONE			'\0'
 
 /* ----------
@@ -937,7 +945,7 @@ extern void pgstat_report_vacuum(Oid tableoid, bool shared,
 					 PgStat_Counter livetuples, PgStat_Counter deadtuples);
 extern void pgstat_report_analyze(Relation rel,
 					  PgStat_Counter livetuples, PgStat_Counter deadtuples,
-					  bool resetcounter);
+					  bool resetcounter, PgStat_Counter modcount);
 
 extern void pgstat_report_recovery_conflict(int reason);
 extern void pgstat_report_deadlock(void);
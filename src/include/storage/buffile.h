@@ -33,6 +33,7 @@
 typedef struct BufFile BufFile;
 
 struct workfile_set;
+struct Instrumentation;
 
 /*
  * prototypes for functions in buffile.c
@@ -50,6 +51,7 @@ extern Size BufFileWrite(BufFile *file, const void *ptr, Size size);
 extern int	BufFileSeek(BufFile *file, int fileno, off_t offset, int whence);
 extern void BufFileTell(BufFile *file, int *fileno, off_t *offset);
 extern int	BufFileSeekBlock(BufFile *file, int64 blknum);
+extern void BufFilePrefetchBlock(BufFile *file, int64 blknum);
 extern void BufFileFlush(BufFile *file);
 extern int64 BufFileGetSize(BufFile *buffile);
 
@@ -62,5 +64,6 @@ extern void BufFileResume(BufFile *buffile);
 
 extern bool gp_workfile_compression;
 extern void BufFilePledgeSequential(BufFile *buffile);
+extern void BufFileSetInstrument(BufFile *buffile, struct Instrumentation *instr);
 
 #endif   /* BUFFILE_H */
@@ -140,7 +140,11 @@ extern PGDLLIMPORT LWLockPadded *MainLWLockArray;
 #define RelfilenodeGenLock			(&MainLWLockArray[PG_NUM_INDIVIDUAL_LWLOCKS + 8].lock)
 #define WorkFileManagerLock			(&MainLWLockArray[PG_NUM_INDIVIDUAL_LWLOCKS + 9].lock)
 #define DistributedLogTruncateLock	(&MainLWLockArray[PG_NUM_INDIVIDUAL_LWLOCKS + 10].lock)
-#define GP_NUM_INDIVIDUAL_LWLOCKS		10
+#define SharedMDCacheLock			(&MainLWLockArray[PG_NUM_INDIVIDUAL_LWLOCKS + 11].lock)
+#define NTupleStoreShmemLock		(&MainLWLockArray[PG_NUM_INDIVIDUAL_LWLOCKS + 12].lock)
+#define BroadcastCacheLock			(&MainLWLockArray[PG_NUM_INDIVIDUAL_LWLOCKS + 13].lock)
+/* the locks above start at offset 1 */
+#define GP_NUM_INDIVIDUAL_LWLOCKS		14
 
 /*
  * It would probably be better to allocate separate LWLock tranches
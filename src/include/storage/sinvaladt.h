@@ -36,6 +36,7 @@ extern void BackendIdGetTransactionIds(int backendID, TransactionId *xid, Transa
 
 extern void SIInsertDataEntries(const SharedInvalidationMessage *data, int n);
 extern int	SIGetDataEntries(SharedInvalidationMessage *data, int datasize);
+extern uint64 SIGetInsertedCount(void);
 extern void SICleanupQueue(bool callerHasWriteLock, int minFree);
 
 extern LocalTransactionId GetNextLocalTransactionId(void);
@@ -1376,6 +1376,11 @@ extern Datum dummy_compression_validator(PG_FUNCTION_ARGS);
 extern Datum percentile_cont_trans(PG_FUNCTION_ARGS);
 extern Datum percentile_disc_trans(PG_FUNCTION_ARGS);
 
+/* gp_tdigest.c */
+extern Datum gp_tdigest_add(PG_FUNCTION_ARGS);
+extern Datum gp_tdigest_merge(PG_FUNCTION_ARGS);
+extern Datum gp_tdigest_percentile(PG_FUNCTION_ARGS);
+
 /* gp_partition_functions.c */
 struct EState;
 extern void dumpDynamicTableScanPidIndex(struct EState *estate, int index);
@@ -1386,6 +1391,10 @@ extern Datum enable_xform(PG_FUNCTION_ARGS);
 
 /* Optimizer's version */
 extern Datum gp_opt_version(PG_FUNCTION_ARGS);
+extern Datum gp_optimizer_stats(PG_FUNCTION_ARGS);
+extern Datum gp_optimizer_search_stages(PG_FUNCTION_ARGS);
+extern Datum gp_optimizer_captures(PG_FUNCTION_ARGS);
+extern Datum gp_optimizer_plan_trace(PG_FUNCTION_ARGS);
 
 /* query_metrics.c */
 extern Datum gp_instrument_shmem_summary(PG_FUNCTION_ARGS);
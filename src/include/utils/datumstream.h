@@ -16,6 +16,7 @@
 #define DATUMSTREAM_H
 
 #include "catalog/pg_attribute.h"
+#include "cdb/cdbappendonlyblockdirectory.h"
 #include "utils/datumstreamblock.h"
 
 /*
@@ -65,6 +66,14 @@ typedef struct DatumStreamWrite
 
 	DatumStreamBlockWrite blockWrite;
 
+	/*
+	 * Zone map of the values put into the current block. Only kept if the
+	 * type has zone maps and gp_appendonly_zone_maps was on when the stream
+	 * was created.
+	 */
+	bool		keepZoneMap;
+	MinipageZoneMap zoneMap;
+
 	/*
 	 * EOFs of current segment file.
 	 */
@@ -225,6 +234,28 @@ datumstreamread_advance(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Dictionary code of the current item, or -1 if its block doesn't have
+ * dictionary compression.  The items of a block with the same code are
+ * equal, the codes of a block are less than
+ * datumstreamread_dictionary_count.  Not meaningful for NULL items.
+ */
+inline static int32
+datumstreamread_dictionary_code(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState != DatumStreamLargeObjectState_None ||
+		!acc->blockRead.dictionary_block_was_compressed)
+		return -1;
+
+	return acc->blockRead.dictionary_code;
+}
+
+inline static int32
+datumstreamread_dictionary_count(DatumStreamRead * acc)
+{
+	return acc->blockRead.dictionary_count;
+}
+
 extern int	datumstreamread_nthlarge(DatumStreamRead * ds);
 inline static int
 datumstreamread_nth(DatumStreamRead * acc)
@@ -311,6 +342,10 @@ extern int	datumstreamread_block(DatumStreamRead * ds,
 								  int colGroupNo);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
+extern bool datumstreamread_skip_to_row(DatumStreamRead * datumStream,
+							int64 rowNum,
+							int64 fileOffset,
+							int64 firstRowNum);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
 extern bool datumstreamread_find_block(DatumStreamRead * datumStream,
 						   DatumStreamFetchDesc datumStreamFetchDesc,
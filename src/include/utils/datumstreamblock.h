@@ -196,6 +196,30 @@ typedef struct DatumStreamBlock_Delta_Extension
 	 */
 }	DatumStreamBlock_Delta_Extension;
 
+/*
+ * Datum Stream Block extension to DatumStreamBlock_Dense with dictionary
+ * compression of variable-length items.  It follows the other extensions.
+ * 8 bytes more.
+ *
+ * The datums of the block are then its distinct items, and each physical
+ * item is a code, the index of its datum.  The codes follow the rest of the
+ * meta-data, before the alignment padding.
+ */
+typedef struct DatumStreamBlock_Dictionary_Extension
+{
+	int32		dictionary_count;
+	/*
+	 * Number of distinct items, the datums of the block.
+	 */
+
+	int32		code_size;
+	/*
+	 * Byte length of each code, 1 or 2.
+	 */
+}	DatumStreamBlock_Dictionary_Extension;
+
+#define DATUMSTREAM_DICTIONARY_MAXCOUNT 0x10000
+
 
 /* Flags */
 enum
@@ -203,6 +227,7 @@ enum
 	DSB_HAS_NULLBITMAP = 0x1,
 	DSB_HAS_RLE_COMPRESSION = 0x2,
 	DSB_HAS_DELTA_COMPRESSION = 0x4,
+	DSB_HAS_DICTIONARY_COMPRESSION = 0x8,
 };
 
 typedef struct DatumStreamBitMapWrite
@@ -1008,6 +1033,7 @@ typedef struct DatumStreamBlockWrite
 
 	bool		rle_want_compression;
 	bool		delta_want_compression;
+	bool		dictionary_want_compression;
 
 	int32		initialMaxDatumPerBlock;
 	int32		maxDatumPerBlock;
@@ -1082,6 +1108,11 @@ typedef struct DatumStreamBlockWrite
 	bool	   *delta_sign;
 	int32		deltas_maxcount;
 
+	/* Dictionary buffers, filled when the block is formatted */
+	uint8	   *dictionary_buffer;
+	uint16	   *dictionary_codes;
+	int32		dictionary_codes_maxcount;
+
 	/* EOF of current file */
 	int64		savings;
 	int64		remember_savings;
@@ -1164,6 +1195,16 @@ typedef struct DatumStreamBlockRead
 	bool		delta_block_was_compressed;
 	DatumStreamBitMapRead delta_bitmap;
 
+	/* Dictionary variables */
+	bool		dictionary_block_was_compressed;
+	int32		dictionary_count;
+	int32		dictionary_code_size;
+	uint8	   *dictionary_codesp;
+	int32		dictionary_code;	/* of the current physical item */
+
+	uint8	  **dictionary_items;	/* by code */
+	int32		dictionary_items_maxcount;
+
 	/*
 	 * Keep less frequently accessed fields down here for possible better CPU data cache
 	 * performance.
@@ -1918,6 +1959,43 @@ DatumStreamBlockRead_AdvanceDense(DatumStreamBlockRead * dsr)
 		}
 	}
 
+	if (dsr->dictionary_block_was_compressed)
+	{
+		uint8	   *codep;
+		int32		code;
+
+		/*
+		 * The item is the datum of its code.
+		 */
+		++dsr->physical_datum_index;
+		Assert(dsr->physical_datum_index < dsr->physical_datum_count);
+
+		codep = dsr->dictionary_codesp +
+			dsr->physical_datum_index * dsr->dictionary_code_size;
+		if (dsr->dictionary_code_size == 1)
+			code = codep[0];
+		else
+			code = codep[0] | (codep[1] << 8);
+
+		if (code >= dsr->dictionary_count)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream block read dictionary code %d out of range "
+							"(nth %d, logical row count %d, dictionary count %d)",
+							code,
+							dsr->nth,
+							dsr->logical_row_count,
+							dsr->dictionary_count),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+		}
+
+		dsr->dictionary_code = code;
+		dsr->datump = dsr->dictionary_items[code];
+
+		return 1;
+	}
+
 	Assert(dsr->datump >= dsr->datum_beginp);
 	Assert(dsr->datump < dsr->datum_afterp);
 
@@ -2152,6 +2230,7 @@ extern void DatumStreamBlockWrite_Init(
 						   DatumStreamVersion datumStreamVersion,
 						   bool rle_want_compression,
 						   bool delta_want_compression,
+						   bool dictionary_want_compression,
 						   int32 initialMaxDatumPerBlock,
 						   int32 maxDatumPerBlock,
 						   int32 maxDataBlockSize,
@@ -15,6 +15,12 @@
 extern "C" {
 #endif
 
+/*
+ * The allocations of the optimizer are recorded in their memory account once
+ * this many bytes are allocated or freed, see ext_alloc.c.
+ */
+#define OPTIMIZER_ACCOUNTING_BATCH (64 * 1024)
+
 extern uint64 OptimizerOustandingMemoryBalance;
 
 extern void
@@ -23,9 +29,27 @@ Ext_OptimizerFree(void *ptr);
 extern void*
 Ext_OptimizerAlloc(size_t size);
 
+extern bool
+Ext_OptimizerFreeReserved(void *ptr);
+
+extern void*
+Ext_OptimizerAllocReserved(size_t size);
+
+extern void
+Ext_OptimizerFlushAccounting(void);
+
+extern void
+Ext_OptimizerSetMemoryLimit(uint64 limit);
+
+extern bool
+Ext_OptimizerExceedsMemoryLimit(size_t size);
+
 extern uint64
 GetOptimizerOutstandingMemoryBalance(void);
 
+extern uint64
+GetOptimizerAllocations(uint64 *bytes);
+
 
 #ifdef __cplusplus
 }
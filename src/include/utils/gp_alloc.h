@@ -53,6 +53,8 @@ typedef struct VmemHeader
 extern void *gp_malloc(int64 sz);
 extern void *gp_realloc(void *ptr, int64 newsz);
 extern void gp_free(void *ptr);
+extern void *gp_malloc_reserved(int64 sz);
+extern bool gp_free_reserved(void *ptr);
 
 /* Gets the actual usable payload address of a vmem pointer */
 static inline
@@ -270,6 +270,10 @@ extern bool gp_appendonly_compaction;
  * 10% of the tuples are hidden.
  */
 extern int  gp_appendonly_compaction_threshold;
+extern int  gp_appendonly_read_ahead;
+extern bool gp_appendonly_dictionary_encoding;
+extern bool gp_appendonly_late_materialization;
+extern bool gp_appendonly_bulk_load;
 extern bool gp_heap_require_relhasoids_match;
 extern bool	debug_xlog_record_read;
 extern bool Debug_cancel_print;
@@ -308,6 +312,7 @@ extern bool gp_ignore_error_table;
 extern bool	Debug_dtm_action_primary;
 
 extern bool gp_log_optimization_time;
+extern bool gp_replan_when_idle;
 extern bool log_parser_stats;
 extern bool log_planner_stats;
 extern bool log_executor_stats;
@@ -338,6 +343,8 @@ extern int gp_max_partition_level;
 extern bool gp_perfmon_print_packet_info;
 
 extern bool gp_enable_relsize_collection;
+extern bool gp_enable_subplan_cache;
+extern bool gp_enable_nestloop_cache;
 
 /* Debug DTM Action */
 typedef enum
@@ -417,7 +424,17 @@ extern bool	optimizer_trace_fallback;
 extern int optimizer_minidump;
 extern int  optimizer_cost_model;
 extern bool optimizer_metadata_caching;
+extern bool optimizer_prefetch_metadata;
 extern int	optimizer_mdcache_size;
+extern int	optimizer_mdcache_shared_size;
+extern int	optimizer_max_concurrent_optimizations;
+extern int	optimizer_plan_cache_size;
+extern int	optimizer_plan_baselines;
+extern bool optimizer_cardinality_feedback;
+extern bool optimizer_plan_trace;
+extern int	optimizer_search_time_budget;
+extern int	optimizer_capture_threshold;
+extern int	optimizer_memory_limit;
 
 /* Optimizer debugging GUCs */
 extern bool optimizer_print_query;
@@ -465,6 +482,18 @@ extern bool optimizer_enable_dml_triggers;
 extern bool	optimizer_enable_dml_constraints;
 extern bool optimizer_enable_direct_dispatch;
 extern bool optimizer_enable_master_only_queries;
+extern bool optimizer_enable_partition_wise_join;
+extern bool optimizer_enable_partition_merge_append;
+extern bool optimizer_enable_matview_rewrite;
+extern bool optimizer_enable_indexonlyscan;
+extern bool optimizer_enable_incremental_sort;
+extern bool optimizer_enable_hashjoin_skew;
+extern bool optimizer_enable_common_subexpressions;
+extern bool optimizer_enable_dependency_damping;
+extern bool optimizer_enable_hashed_subplans;
+extern bool optimizer_enable_rollup_agg;
+extern bool optimizer_enable_shared_subqueries;
+extern bool optimizer_enable_shared_window_sort;
 extern bool optimizer_enable_hashjoin;
 extern bool optimizer_enable_dynamictablescan;
 extern bool optimizer_enable_indexscan;
@@ -496,10 +525,15 @@ extern int optimizer_penalize_broadcast_threshold;
 extern double optimizer_cost_threshold;
 extern double optimizer_nestloop_factor;
 extern double optimizer_sort_factor;
+extern double optimizer_compressed_motion_cost_factor;
+extern double optimizer_hashagg_cost_factor;
+extern double optimizer_cte_sharing_cost_factor;
+extern double optimizer_intra_host_motion_cost_factor;
 
 /* Optimizer hints */
 extern int optimizer_array_expansion_threshold;
 extern int optimizer_join_order_threshold;
+extern int optimizer_join_search_budget;
 extern int optimizer_join_order;
 extern int optimizer_join_arity_for_associativity_commutativity;
 extern int optimizer_cte_inlining_bound;
@@ -524,6 +558,7 @@ extern bool optimizer_enable_associativity;
 /* Analyze related GUCs for Optimizer */
 extern bool optimizer_analyze_root_partition;
 extern bool optimizer_analyze_midlevel_partition;
+extern bool optimizer_analyze_changed_partitions_only;
 
 extern bool optimizer_use_gpdb_allocators;
 
@@ -551,12 +586,20 @@ extern char  *gp_default_storage_options;
 
 /* copy GUC */
 extern bool gp_enable_segment_copy_checking;
+extern bool gp_enable_segment_copy_parsing;
 
 extern int writable_external_table_bufsize;
 
 /* Enable passing of query constraints to external table providers */
 extern bool gp_external_enable_filter_pushdown;
 
+/* Enable passing of COUNT(*), MIN and MAX to external table providers */
+extern bool gp_external_enable_agg_pushdown;
+
+/* Fractions of the data of an external table ANALYZE reads, and a scan returns */
+extern double gp_external_analyze_sample_fraction;
+extern double gp_external_scan_sample_fraction;
+
 /* Enable the Global Deadlock Detector */
 extern bool gp_enable_global_deadlock_detector;
 
@@ -679,6 +722,8 @@ extern void AlterSystemSetConfigFile(AlterSystemStmt *setstmt);
 extern char *GetConfigOptionByName(const char *name, const char **varname);
 extern void GetConfigOptionByNum(int varnum, const char **values, bool *noshow);
 extern int	GetNumConfigOptions(void);
+extern uint64 GetConfigGeneration(void);
+extern void AdvanceConfigGeneration(void);
 
 extern void SetPGVariable(const char *name, List *args, bool is_local);
 extern void SetPGVariableOptDispatch(const char *name, List *args, bool is_local, bool gp_dispatch);
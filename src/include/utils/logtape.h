@@ -38,6 +38,7 @@ extern LogicalTape *LogicalTapeCreate(LogicalTapeSet *lts, LogicalTape *lt);
 extern LogicalTapeSet *LogicalTapeSetCreate(int ntapes);
 extern LogicalTapeSet *LogicalTapeSetCreate_File(BufFile *ewfile, int ntapes);
 extern LogicalTapeSet *LoadLogicalTapeSetState(BufFile *pfile, BufFile *tapefile);
+extern void LogicalTapeSetInstrument(LogicalTapeSet *lts, struct Instrumentation *instr);
 
 extern void LogicalTapeSetClose(LogicalTapeSet *lts, workfile_set *workset);
 extern void LogicalTapeSetForgetFreeSpace(LogicalTapeSet *lts);
@@ -154,6 +154,7 @@ extern bool get_func_leakproof(Oid funcid);
 extern float4 get_func_cost(Oid funcid);
 extern float4 get_func_rows(Oid funcid);
 extern Oid	get_relname_relid(const char *relname, Oid relnamespace);
+extern int	get_relnatts(Oid relid);
 extern char *get_rel_name(Oid relid);
 extern char *get_rel_name_partition(Oid relid);
 extern Oid	get_rel_namespace(Oid relid);
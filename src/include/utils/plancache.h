@@ -140,6 +140,7 @@ typedef struct CachedPlan
 
 extern void InitPlanCache(void);
 extern void ResetPlanCache(void);
+extern void RebuildInvalidCachedPlans(void);
 
 extern CachedPlanSource *CreateCachedPlan(Node *raw_parse_tree,
 				 const char *query_string,
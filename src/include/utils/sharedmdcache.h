@@ -0,0 +1,32 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedmdcache.h
+ *	  Metadata cache of GPORCA shared by the backends on the master.
+ *
+ *
+ * Copyright (c) 2026-Present Pivotal Software, Inc.
+ *
+ * src/include/utils/sharedmdcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef SHAREDMDCACHE_H
+#define SHAREDMDCACHE_H
+
+/* Longest key of an object, including the terminating zero */
+#define SHARED_MDCACHE_KEY_LEN 128
+
+extern Size SharedMDCacheShmemSize(void);
+extern void SharedMDCacheShmemInit(void);
+
+extern uint64 SharedMDCacheGetVersion(void);
+extern char *SharedMDCacheLookup(uint64 version, const char *key, Size *len);
+extern void SharedMDCacheStore(uint64 version, const char *key,
+							   const char *data, Size len);
+extern void SharedMDCacheStoreBuiltin(const char *key, const char *data,
+									  Size len);
+
+extern void InitSharedMDCache(void);
+
+#endif   /* SHAREDMDCACHE_H */
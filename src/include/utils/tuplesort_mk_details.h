@@ -234,6 +234,9 @@ typedef struct MKLvContext
     /* type of datums in this level, converted to our MKLvType enumeration */
     MKLvType lvtype;
 
+    /* datums in this level are signed integers of typLen bytes, in their natural order */
+    bool radixable;
+
 	ScanKeyData	scanKey;
 
     int16 attno;
@@ -293,6 +296,9 @@ typedef struct MKContext {
     /* Unique sort: should the sort discard duplicate values?  */
     bool unique;
 
+    /* All the levels are radixable, so mk_radix_sort can sort the entries */
+    bool radixable;
+
     /* enforce Unique, for index build */
     bool enforceUnique;
 
@@ -333,6 +339,11 @@ static inline void mk_qsort(MKEntry* a, int n, MKContext *ctxt)
     mk_qsort_impl(a, 0, n-1, 0, true, ctxt, false);
 }
 
+/* MK radix sort stuff, only for a non unique sort of radixable levels */
+#define MK_RADIX_MIN_ENTRIES 256
+extern Size mk_radix_sort_space(int n, MKContext *ctxt);
+extern void mk_radix_sort(MKEntry *a, int n, MKContext *ctxt);
+
 /* MK Heap stuff */
 typedef bool (*MKFlagPtrReader) (void *ctxt, MKEntry *e);
 typedef struct MKHeapReader
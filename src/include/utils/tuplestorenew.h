@@ -31,6 +31,10 @@ extern bool ntuplestore_is_readerwriter_reader(NTupleStore* nts);
 extern void ntuplestore_flush(NTupleStore *ts);
 extern void ntuplestore_destroy(NTupleStore *ts);
 
+/* Shared memory for the readerwriter stores */
+extern Size ntuplestore_shmem_size(void);
+extern void ntuplestore_shmem_init(void);
+
 /* Tuple store accessor method 
  * Create Accessor: current we support 1 writer, many reader per store.  After created, the accessor
  * is positioned at the first tuple or eof (if there is no tuple).
@@ -0,0 +1,38 @@
+-- Tests of the bulk load mode of AO tables (gp_appendonly_bulk_load): the
+-- segment files written by a load into a table created in the transaction
+-- are only logged when they are closed, and crash recovery must rebuild
+-- them from those records.
+
+-- Skip the checkpoints on the primaries, so that the loads are replayed by
+-- the recovery after the immediate shutdown below.
+1: SELECT gp_inject_fault_infinite('checkpoint', 'skip', dbid) FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+
+1: SET gp_appendonly_bulk_load = on;
+1: CREATE TABLE ao_bulk_row WITH (appendonly=true) AS SELECT i AS a, repeat('x', 100) AS b FROM generate_series(1, 100000) i DISTRIBUTED BY (a);
+1: CREATE TABLE ao_bulk_column WITH (appendonly=true, orientation=column) AS SELECT i AS a, repeat('x', 100) AS b FROM generate_series(1, 100000) i DISTRIBUTED BY (a);
+1: BEGIN;
+1: CREATE TABLE ao_bulk_txn (a int, b text) WITH (appendonly=true) DISTRIBUTED BY (a);
+1: INSERT INTO ao_bulk_txn SELECT i, repeat('y', 100) FROM generate_series(1, 100000) i;
+1: COMMIT;
+-- a load after TRUNCATE goes to a new relfilenode too
+1: BEGIN;
+1: TRUNCATE ao_bulk_column;
+1: INSERT INTO ao_bulk_column SELECT i, repeat('z', 50) FROM generate_series(1, 50000) i;
+1: COMMIT;
+1q:
+
+-- start_ignore
+! gpstop -rai;
+-- end_ignore
+
+2: SELECT count(*), sum(a), sum(length(b)) FROM ao_bulk_row;
+2: SELECT count(*), sum(a), sum(length(b)) FROM ao_bulk_column;
+2: SELECT count(*), sum(a), sum(length(b)) FROM ao_bulk_txn;
+
+-- the tables can still be written after the recovery
+2: INSERT INTO ao_bulk_row VALUES (0, 'x');
+2: SELECT count(*) FROM ao_bulk_row;
+
+2: DROP TABLE ao_bulk_row;
+2: DROP TABLE ao_bulk_column;
+2: DROP TABLE ao_bulk_txn;
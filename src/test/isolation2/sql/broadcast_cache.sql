@@ -0,0 +1,50 @@
+-- Tests of the cache of broadcast tables on the segments: the tuples a
+-- session has cached must not be replayed once the table is written, be it
+-- by a command the master runs or by a function running on the segments.
+
+-- start_ignore
+! gpconfig -c gp_broadcast_cache_relations -v 100;
+! gpstop -rai;
+-- end_ignore
+
+CREATE TABLE bc_big (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE bc_small (k int, v int) DISTRIBUTED BY (k);
+CREATE TABLE bc_driver (k int) DISTRIBUTED BY (k);
+INSERT INTO bc_big SELECT i, i % 3 FROM generate_series(1, 3000) i;
+INSERT INTO bc_small VALUES (0, 0), (1, 10), (2, 20);
+INSERT INTO bc_driver VALUES (1);
+ANALYZE bc_big;
+ANALYZE bc_small;
+
+CREATE FUNCTION bc_bump(i int) RETURNS int AS $$
+BEGIN
+  UPDATE bc_small SET v = v + 100 WHERE k = i;
+  RETURN i;
+END
+$$ LANGUAGE plpgsql VOLATILE;
+
+-- the second time the tuples of bc_small come from the cache
+1: SELECT s.v, count(*) FROM bc_big b JOIN bc_small s ON b.b = s.k GROUP BY s.v ORDER BY s.v;
+1: SELECT s.v, count(*) FROM bc_big b JOIN bc_small s ON b.b = s.k GROUP BY s.v ORDER BY s.v;
+
+-- written by the master
+2: UPDATE bc_small SET v = v + 1;
+1: SELECT s.v, count(*) FROM bc_big b JOIN bc_small s ON b.b = s.k GROUP BY s.v ORDER BY s.v;
+
+-- written by a function on the segment of bc_driver's row, which the master
+-- doesn't lock
+2: SELECT bc_bump(k) FROM bc_driver;
+1: SELECT s.v, count(*) FROM bc_big b JOIN bc_small s ON b.b = s.k GROUP BY s.v ORDER BY s.v;
+
+1q:
+2q:
+
+DROP FUNCTION bc_bump(int);
+DROP TABLE bc_driver;
+DROP TABLE bc_small;
+DROP TABLE bc_big;
+
+-- start_ignore
+! gpconfig -r gp_broadcast_cache_relations;
+! gpstop -rai;
+-- end_ignore
@@ -69,6 +69,8 @@ SET ROLE TO role1_memory_test;
 set gp_resgroup_print_operator_memory_limits=on;
 set enable_hashjoin = false;
 set enable_nestloop = true;
+-- The rows of test_mat_large compress well enough to not spill.
+set gp_materialize_compression = off;
 -- ORCA doesn't honor enable_nestloop/enable_hashjoin, so this won't produce
 -- the kind of plan we're looking for.
 set optimizer=off;
@@ -0,0 +1,7 @@
+--
+-- Time GPORCA producing large plans, a DML on each of the partitions
+--
+SET optimizer = on;
+SELECT explain_repeatedly('UPDATE large_plan_parts SET c = c || ''y''', 20);
+SELECT explain_repeatedly('DELETE FROM large_plan_parts WHERE c = ''y''', 20);
+SELECT explain_repeatedly('INSERT INTO large_plan_parts SELECT * FROM large_plan_parts', 20);
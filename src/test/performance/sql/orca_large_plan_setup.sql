@@ -0,0 +1,23 @@
+--
+-- Create a table with many partitions, the plans of DML on it have a
+-- subplan for each partition
+--
+SET client_min_messages = warning;
+CREATE TABLE large_plan_parts (a int, b int, c text) DISTRIBUTED BY (a)
+PARTITION BY RANGE (b) (START (0) END (1000) EVERY (1));
+INSERT INTO large_plan_parts SELECT i, i % 1000, 'x' FROM generate_series(1, 100000) i;
+ANALYZE large_plan_parts;
+
+--
+-- Plan a query repeatedly, without the output of EXPLAIN
+--
+CREATE FUNCTION explain_repeatedly(query text, n int) RETURNS void AS $$
+DECLARE
+	line text;
+BEGIN
+	FOR i IN 1..n LOOP
+		FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+		END LOOP;
+	END LOOP;
+END;
+$$ LANGUAGE plpgsql;
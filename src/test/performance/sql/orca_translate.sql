@@ -0,0 +1,14 @@
+--
+-- Time the phases of GPORCA, from Query to DXL, the metadata fetched from
+-- the relcache and DXL to PlannedStmt, for queries that stress each of them.
+-- The averages are left in orca_translate_results.
+--
+SELECT orca_translate_bench('wide_select', 'SELECT * FROM translate_wide WHERE c1 = 1', 20);
+SELECT orca_translate_bench('wide_join', 'SELECT * FROM translate_wide w1 JOIN translate_wide w2 ON w1.c1000 = w2.c1', 10);
+SELECT orca_translate_bench('parts_select', 'SELECT * FROM translate_parts WHERE c = ''x''', 20);
+SELECT orca_translate_bench('parts_update', 'UPDATE translate_parts SET c = c || ''y''', 10);
+SELECT orca_translate_bench('nested_20', nested_query(20), 20);
+SELECT orca_translate_bench('nested_50', nested_query(50), 10);
+SELECT orca_translate_bench('in_list_1000', in_list_query(1000), 20);
+SELECT orca_translate_bench('in_list_10000', in_list_query(10000), 10);
+SELECT count(*) FROM orca_translate_results;
@@ -0,0 +1,105 @@
+--
+-- Create the tables that stress the translation of GPORCA: a wide table, a
+-- table with many partitions, and one to nest subqueries and IN lists on
+--
+SET client_min_messages = warning;
+
+DO $$
+DECLARE
+	cols text := '';
+BEGIN
+	FOR i IN 1..1000 LOOP
+		cols := cols || ', c' || i || ' int';
+	END LOOP;
+	EXECUTE 'CREATE TABLE translate_wide (a int' || cols || ') DISTRIBUTED BY (a)';
+END;
+$$;
+INSERT INTO translate_wide (a, c1, c1000) SELECT i, i, i FROM generate_series(1, 1000) i;
+ANALYZE translate_wide;
+
+CREATE TABLE translate_parts (a int, b int, c text) DISTRIBUTED BY (a)
+PARTITION BY RANGE (b) (START (0) END (1000) EVERY (1));
+INSERT INTO translate_parts SELECT i, i % 1000, 'x' FROM generate_series(1, 100000) i;
+ANALYZE translate_parts;
+
+CREATE TABLE translate_small (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO translate_small SELECT i, i FROM generate_series(1, 10000) i;
+ANALYZE translate_small;
+
+--
+-- Results of the benchmark, the average of each phase over the runs
+--
+CREATE TABLE orca_translate_results (
+	name text,
+	runs int,
+	translate_ms float8,
+	search_ms float8,
+	plan_ms float8,
+	mdfetch_ms float8,
+	translate_allocs float8,
+	translate_kb float8,
+	search_allocs float8,
+	search_kb float8,
+	plan_allocs float8,
+	plan_kb float8,
+	mdfetch_allocs float8,
+	mdfetch_kb float8
+) DISTRIBUTED RANDOMLY;
+
+--
+-- Plan a query n times with GPORCA, and record the average time and
+-- allocations of its phases. The metadata cache is disabled, so that each
+-- run translates the relcache objects it needs as well.
+--
+CREATE FUNCTION orca_translate_bench(name text, query text, n int) RETURNS void AS $$
+DECLARE
+	plan text;
+	stats json;
+	r orca_translate_results%ROWTYPE;
+BEGIN
+	r := ROW(name, n, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	FOR i IN 1..n LOOP
+		EXECUTE 'EXPLAIN (OPTIMIZER_STATS, FORMAT JSON) ' || query INTO plan;
+		stats := plan::json->0->'Optimizer Statistics';
+		IF stats IS NULL THEN
+			RAISE EXCEPTION 'query "%" was not planned by GPORCA', name;
+		END IF;
+		r.translate_ms := r.translate_ms + (stats->>'Translation Time')::float8 / n;
+		r.search_ms := r.search_ms + (stats->>'Search Time')::float8 / n;
+		r.plan_ms := r.plan_ms + (stats->>'Plan Generation Time')::float8 / n;
+		r.mdfetch_ms := r.mdfetch_ms + (stats->>'Metadata Fetch Time')::float8 / n;
+		r.translate_allocs := r.translate_allocs + (stats->>'Translation Allocations')::float8 / n;
+		r.translate_kb := r.translate_kb + (stats->>'Translation Allocated Memory')::float8 / n;
+		r.search_allocs := r.search_allocs + (stats->>'Search Allocations')::float8 / n;
+		r.search_kb := r.search_kb + (stats->>'Search Allocated Memory')::float8 / n;
+		r.plan_allocs := r.plan_allocs + (stats->>'Plan Generation Allocations')::float8 / n;
+		r.plan_kb := r.plan_kb + (stats->>'Plan Generation Allocated Memory')::float8 / n;
+		r.mdfetch_allocs := r.mdfetch_allocs + (stats->>'Metadata Fetch Allocations')::float8 / n;
+		r.mdfetch_kb := r.mdfetch_kb + (stats->>'Metadata Fetch Allocated Memory')::float8 / n;
+	END LOOP;
+	INSERT INTO orca_translate_results VALUES (r.*);
+END;
+$$ LANGUAGE plpgsql SET optimizer = on SET optimizer_metadata_caching = off;
+
+--
+-- A query nesting n subqueries in the FROM clause
+--
+CREATE FUNCTION nested_query(n int) RETURNS text AS $$
+DECLARE
+	q text := 'SELECT a, b FROM translate_small';
+BEGIN
+	FOR i IN 1..n LOOP
+		q := 'SELECT a + 1 AS a, b FROM (' || q || ') s' || i || ' WHERE b > ' || i;
+	END LOOP;
+	RETURN q;
+END;
+$$ LANGUAGE plpgsql;
+
+--
+-- A query with an IN list of n constants
+--
+CREATE FUNCTION in_list_query(n int) RETURNS text AS $$
+	SELECT 'SELECT * FROM translate_small WHERE b IN (' ||
+		string_agg(i::text, ', ') || ')'
+	FROM generate_series(1, n) i;
+$$ LANGUAGE sql;
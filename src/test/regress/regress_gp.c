@@ -62,6 +62,10 @@ extern Datum multiset_setof_value(PG_FUNCTION_ARGS);
 extern Datum multiset_materialize_good(PG_FUNCTION_ARGS);
 extern Datum multiset_materialize_bad(PG_FUNCTION_ARGS);
 
+/* functionscan_stream test */
+extern Datum value_per_call_srf(PG_FUNCTION_ARGS);
+extern Datum mixed_row_types_srf(PG_FUNCTION_ARGS);
+
 /* table functions + dynamic type support */
 extern Datum sessionize(PG_FUNCTION_ARGS);
 extern Datum describe(PG_FUNCTION_ARGS);
@@ -341,6 +345,76 @@ multiset_materialize_bad(PG_FUNCTION_ARGS)
 	PG_RETURN_NULL();
 }
 
+/*
+ * Returns 1 to n in value-per-call mode, with a notice for each row, so that
+ * the calls can be counted.
+ */
+PG_FUNCTION_INFO_V1(value_per_call_srf);
+Datum
+value_per_call_srf(PG_FUNCTION_ARGS)
+{
+	FuncCallContext		*fctx;
+	int32				 n = PG_GETARG_INT32(0);
+	int32				 value;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		fctx = SRF_FIRSTCALL_INIT();
+	}
+	fctx = SRF_PERCALL_SETUP();
+
+	if (fctx->call_cntr < n)
+	{
+		value = (int32) fctx->call_cntr + 1;
+		elog(NOTICE, "value_per_call_srf(%d) returns %d", n, value);
+		SRF_RETURN_NEXT(fctx, Int32GetDatum(value));
+	}
+	else
+	{
+		SRF_RETURN_DONE(fctx);
+	}
+}
+
+/*
+ * Returns two rows of RECORD type in value-per-call mode, which differ in the
+ * name of their second column, so that they are not of the same row type.
+ */
+PG_FUNCTION_INFO_V1(mixed_row_types_srf);
+Datum
+mixed_row_types_srf(PG_FUNCTION_ARGS)
+{
+	FuncCallContext		*fctx;
+	TupleDesc			 tupdesc;
+	HeapTuple			 tuple;
+	Datum				 values[2];
+	bool				 nulls[2];
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		fctx = SRF_FIRSTCALL_INIT();
+	}
+	fctx = SRF_PERCALL_SETUP();
+
+	if (fctx->call_cntr < 2)
+	{
+		tupdesc = CreateTemplateTupleDesc(2, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "a", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2,
+						   fctx->call_cntr == 0 ? "b" : "c", INT4OID, -1, 0);
+		tupdesc = BlessTupleDesc(tupdesc);
+
+		values[0] = values[1] = Int32GetDatum((int32) fctx->call_cntr + 1);
+		nulls[0] = nulls[1] = false;
+		tuple = heap_form_tuple(tupdesc, values, nulls);
+
+		SRF_RETURN_NEXT(fctx, HeapTupleGetDatum(tuple));
+	}
+	else
+	{
+		SRF_RETURN_DONE(fctx);
+	}
+}
+
 PG_FUNCTION_INFO_V1(multiset_example);
 Datum
 multiset_example(PG_FUNCTION_ARGS)
@@ -0,0 +1,37 @@
+--
+-- Dictionary encoding of the variable-length columns of column-oriented
+-- tables with RLE_TYPE compression.
+--
+SET gp_appendonly_dictionary_encoding = on;
+
+CREATE TABLE aocs_dictionary (a int,
+	d text ENCODING (compresstype=rle_type),
+	e varchar(10) ENCODING (compresstype=rle_type))
+WITH (appendonly=true, orientation=column) DISTRIBUTED BY (a);
+
+INSERT INTO aocs_dictionary
+SELECT i, 'v' || (i % 10), CASE WHEN i % 4 = 0 THEN 'x' ELSE 'y' END
+FROM generate_series(1, 100000) i;
+INSERT INTO aocs_dictionary VALUES (100001, NULL, NULL);
+
+SELECT count(*) FROM aocs_dictionary WHERE d = 'v3';
+SELECT count(*) FROM aocs_dictionary WHERE 'v5' = d;
+SELECT count(*) FROM aocs_dictionary WHERE d <> 'v3';
+SELECT count(*) FROM aocs_dictionary WHERE d IN ('v1', 'v2', NULL);
+SELECT count(*) FROM aocs_dictionary WHERE d = 'v3' AND a < 100;
+SELECT count(*) FROM aocs_dictionary WHERE e = 'x';
+SELECT count(*) FROM aocs_dictionary WHERE d IS NULL;
+SELECT d, count(*) FROM aocs_dictionary GROUP BY d ORDER BY d;
+
+-- Blocks written without dictionary encoding are read as before
+SET gp_appendonly_dictionary_encoding = off;
+INSERT INTO aocs_dictionary SELECT i + 200000, 'v3', 'x' FROM generate_series(1, 1000) i;
+SET gp_appendonly_dictionary_encoding = on;
+SELECT count(*) FROM aocs_dictionary WHERE d = 'v3';
+
+-- Deleted rows stay invisible
+DELETE FROM aocs_dictionary WHERE a <= 100;
+SELECT count(*) FROM aocs_dictionary WHERE d = 'v3';
+
+DROP TABLE aocs_dictionary;
+RESET gp_appendonly_dictionary_encoding;
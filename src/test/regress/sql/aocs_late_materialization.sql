@@ -0,0 +1,30 @@
+--
+-- Late materialization of column-oriented tables: the columns of the quals
+-- are read first, the others only for the rows that satisfy them.
+--
+SET gp_appendonly_late_materialization = on;
+
+CREATE TABLE aocs_late (a int, b int, c text, d text)
+WITH (appendonly=true, orientation=column, compresstype=zlib) DISTRIBUTED BY (a);
+
+INSERT INTO aocs_late
+SELECT i, i, 'c ' || i, 'd ' || i FROM generate_series(1, 100000) i;
+
+SELECT a, c FROM aocs_late WHERE b = 54321;
+SELECT count(*), sum(length(c)), max(d) FROM aocs_late WHERE b % 1000 = 7;
+SELECT count(*) FROM aocs_late WHERE b > 99990 AND c LIKE '%5';
+
+-- Deleted rows stay invisible
+DELETE FROM aocs_late WHERE a BETWEEN 1000 AND 1999;
+SELECT count(*), min(c) FROM aocs_late WHERE b % 1000 = 7;
+
+-- NULLs of the other columns
+INSERT INTO aocs_late VALUES (100001, 7, NULL, NULL);
+SELECT count(*), count(c), count(d) FROM aocs_late WHERE b = 7;
+
+-- The same rows without it
+SET gp_appendonly_late_materialization = off;
+SELECT count(*), min(c) FROM aocs_late WHERE b % 1000 = 7;
+
+DROP TABLE aocs_late;
+RESET gp_appendonly_late_materialization;
@@ -0,0 +1,33 @@
+--
+-- Zone maps of column-oriented tables. They are kept in the block directory,
+-- so the table needs an index.
+--
+SET gp_appendonly_zone_maps = on;
+
+CREATE TABLE aocs_zonemap (a int, b bigint, c date, d text)
+WITH (appendonly=true, orientation=column) DISTRIBUTED BY (a);
+CREATE INDEX aocs_zonemap_d ON aocs_zonemap (d);
+
+INSERT INTO aocs_zonemap
+SELECT i, i, date '2000-01-01' + i, 'row ' || i FROM generate_series(1, 100000) i;
+INSERT INTO aocs_zonemap VALUES (100001, NULL, NULL, 'null row');
+
+SELECT count(*) FROM aocs_zonemap WHERE b < 100;
+SELECT count(*) FROM aocs_zonemap WHERE b BETWEEN 5000 AND 5100;
+SELECT count(*) FROM aocs_zonemap WHERE 99990 < a;
+SELECT count(*) FROM aocs_zonemap WHERE c = date '2000-01-01' + 77777;
+SELECT count(*) FROM aocs_zonemap WHERE b IS NULL;
+SELECT d FROM aocs_zonemap WHERE b = 54321;
+
+-- Blocks written without zone maps are always read
+SET gp_appendonly_zone_maps = off;
+INSERT INTO aocs_zonemap SELECT i, i, NULL, NULL FROM generate_series(1, 1000) i;
+SET gp_appendonly_zone_maps = on;
+SELECT count(*) FROM aocs_zonemap WHERE b < 100;
+
+-- Deleted rows in blocks that are read stay invisible
+DELETE FROM aocs_zonemap WHERE a BETWEEN 50 AND 59;
+SELECT count(*) FROM aocs_zonemap WHERE b < 100;
+
+DROP TABLE aocs_zonemap;
+RESET gp_appendonly_zone_maps;
@@ -0,0 +1,44 @@
+--
+-- Approximate aggregates: approx_count_distinct() and approx_percentile()
+--
+create table approx_t (i int, f float8, t text) distributed by (i);
+insert into approx_t
+  select i, i % 50000 + 1, 'value ' || (i % 50000) from generate_series(1, 100000) i;
+insert into approx_t values (NULL, NULL, NULL);
+analyze approx_t;
+
+-- The estimates are within a few percent of the exact counts, NULLs are
+-- left out.
+select abs(approx_count_distinct(i) - 100000) < 100000 * 0.05 as i_ok,
+       abs(approx_count_distinct(f) - 50000) < 50000 * 0.05 as f_ok,
+       abs(approx_count_distinct(t) - 50000) < 50000 * 0.05 as t_ok
+from approx_t;
+select i % 3 as g, abs(approx_count_distinct(f) - 50000) < 50000 * 0.05 as ok
+from approx_t where i is not null group by 1 order by 1;
+select approx_count_distinct(i % 10) between 9 and 11 as ok from approx_t;
+
+-- With few values, approx_percentile() is exact.
+select fraction, approx_percentile(f, fraction),
+       percentile_cont(fraction) within group (order by f)
+from approx_t, (values (0), (0.25), (0.5), (0.9), (1)) p(fraction)
+where i <= 50
+group by fraction order by fraction;
+
+-- Otherwise the rank of the estimate is within a fraction of a percent, and
+-- the extremes are exact.
+select abs(approx_percentile(f, 0.5) - 25000.5) < 50000 * 0.005 as median_ok,
+       abs(approx_percentile(f, 0.01) - 500.99) < 50000 * 0.005 as p01_ok,
+       abs(approx_percentile(f, 0.99) - 49500.01) < 50000 * 0.005 as p99_ok,
+       approx_percentile(f, 0) as min,
+       approx_percentile(f, 1) as max
+from approx_t;
+
+-- The NULL rows are left out, no rows give NULL.
+select approx_percentile(f, 0.5) from approx_t where i is null;
+select approx_percentile(f, 0.5) from approx_t where false;
+
+-- The fraction must be between 0 and 1, and the same for all the rows.
+select approx_percentile(f, 1.5) from approx_t;
+select approx_percentile(f, i / 100000.0) from approx_t;
+
+drop table approx_t;
@@ -590,6 +590,22 @@ INSERT INTO float4_array_table VALUES ('{1.1,2.1,3.1}');
 CREATE TEMP TABLE float8_array_table (f1 float8[]) DISTRIBUTED BY (f1);
 INSERT INTO float8_array_table VALUES ('{1.1,2.1,3.1}');
 
+-- Large IN lists of constants are searched by binary search, check that
+-- duplicates and negative values are found.
+CREATE TEMP TABLE in_list_table (a int2, b int4, c int8, t text, bp char(4)) DISTRIBUTED RANDOMLY;
+INSERT INTO in_list_table SELECT i, i, i, i, i FROM generate_series(-20, 40) i;
+SELECT count(*) FROM in_list_table WHERE a IN (-20, -5, -1, 0, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 3, 5, -5, 40);
+SELECT count(*) FROM in_list_table WHERE b IN (-20, -5, -1, 0, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 3, 5, -5, 40);
+SELECT count(*) FROM in_list_table WHERE c IN (-20, -5, -1, 0, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 3, 5, -5, 40);
+SELECT count(*) FROM in_list_table WHERE b = ANY ('{-20,-5,-1,0,1,2,3,5,8,13,21,34,55,89,3,5,-5,40}'::int4[]);
+SELECT count(*) FROM in_list_table WHERE t IN ('-20', '-5', '-1', '0', '1', '2', '3', '5', '8', '13', '21', '34', '55', '89', '3', '5', '-5', '40', 'x');
+SELECT count(*) FROM in_list_table WHERE bp IN ('-20', '-5', '-1', '0', '1', '2', '3', '5  ', '8', '13', '21', '34', '55', '89', '3', '5', '-5', '40', 'x');
+
+-- Large IN lists of other types are looked up in a hash table.
+SELECT count(*) FROM in_list_table WHERE b::numeric IN (-20, -5, -1, 0, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 3, 5, -5, 40.0);
+SELECT count(*) FROM in_list_table WHERE (b::numeric IN (-20, -5, -1, 0, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 3, 5, -5, 40.0, NULL)) IS NULL;
+SELECT count(*) FROM in_list_table WHERE t::varchar IN ('-20', '-5', '-1', '0', '1', '2', '3', '5', '8', '13', '21', '34', '55', '89', '3', '5', '-5', '40', 'x') AND a::numeric = ANY ('{-20,-5,-1,0,1,2,3,5,8,13,21,34,55,89,3,5,-5,40}');
+
 -- clean up
 -- start_ignore
 -- Drop above three functions
@@ -66,6 +66,12 @@ select * from dd_singlecol_1 where (a,b) in ((10,2),(11,3));
 
 select * from dd_singlecol_1 where a between 10 and 11;
 
+-- single column distr key, IN list spanning some but not all segments
+select * from dd_singlecol_1 where a in (1, 2);
+
+-- IN list covering every segment, dispatched to all of them
+select * from dd_singlecol_1 where a in (1, 2, 10);
+
 -- partitioned tables
 
 create table dd_part_singlecol(a int, b int, c int) distributed by (a) partition by range (b) 
@@ -0,0 +1,72 @@
+--
+-- Cardinality feedback of EXPLAIN ANALYZE to GPORCA
+-- (optimizer_cardinality_feedback)
+--
+-- The tables are analyzed while small and loaded afterwards, so their
+-- statistics underestimate them until EXPLAIN ANALYZE of a GPORCA plan has
+-- seen their rows.  The Postgres planner takes no feedback.
+--
+create function cf_estimate(tbl text) returns int as $$
+declare
+  line text;
+begin
+  for line in execute 'explain select * from ' || tbl loop
+    if line like '%Seq Scan on ' || tbl || ' %' then
+      return substring(line from 'rows=([0-9]+)')::int;
+    end if;
+  end loop;
+  return null;
+end;
+$$ language plpgsql;
+create function cf_analyze(query text) returns void as $$
+declare
+  line text;
+begin
+  for line in execute 'explain analyze ' || query loop
+  end loop;
+end;
+$$ language plpgsql;
+create table cf (a int, b int) distributed by (a);
+insert into cf select g, g from generate_series(1, 10) g;
+analyze cf;
+insert into cf select g, g from generate_series(11, 10000) g;
+set optimizer_cardinality_feedback = on;
+
+select cf_estimate('cf') > 1000 as big_estimate;
+select cf_analyze('select * from cf');
+select cf_estimate('cf') > 1000 as big_estimate;
+
+-- Only while the GUC is on
+set optimizer_cardinality_feedback = off;
+select cf_estimate('cf') > 1000 as big_estimate;
+set optimizer_cardinality_feedback = on;
+select cf_estimate('cf') > 1000 as big_estimate;
+
+-- ANALYZE drops what was seen
+delete from cf where a > 10;
+analyze cf;
+insert into cf select g, g from generate_series(11, 10000) g;
+select cf_estimate('cf') > 1000 as big_estimate;
+
+-- Scans that return fewer rows than estimated are no correction
+create table cf_shrunk (a int, b int) distributed by (a);
+insert into cf_shrunk select g, g from generate_series(1, 10000) g;
+analyze cf_shrunk;
+delete from cf_shrunk where a > 10;
+select cf_analyze('select * from cf_shrunk');
+select cf_estimate('cf_shrunk') > 1000 as big_estimate;
+
+-- Nor are the plans of the Postgres planner
+create table cf_planner (a int, b int) distributed by (a);
+insert into cf_planner select g, g from generate_series(1, 10) g;
+analyze cf_planner;
+insert into cf_planner select g, g from generate_series(11, 10000) g;
+set optimizer = off;
+select cf_analyze('select * from cf_planner');
+reset optimizer;
+select cf_estimate('cf_planner') > 1000 as big_estimate;
+
+reset optimizer_cardinality_feedback;
+drop table cf, cf_shrunk, cf_planner;
+drop function cf_estimate(text);
+drop function cf_analyze(text);
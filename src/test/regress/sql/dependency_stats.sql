@@ -0,0 +1,62 @@
+--
+-- Functional dependencies between columns, computed by ANALYZE, and the
+-- filter damping factor GPORCA derives from them
+-- (optimizer_enable_dependency_damping)
+--
+-- Each zip is in one city, so of the rows of zip = 35 all pass city = 3,
+-- and the 100 rows of zip 35 are all returned.  The Postgres planner, and
+-- GPORCA without the dependency, estimate far fewer.
+--
+create function fd_rows(query text) returns float8 as $$
+declare
+  doc text;
+begin
+  execute 'explain (format json) ' || query into doc;
+  return ((doc::json)->0->'Plan'->>'Plan Rows')::float8;
+end;
+$$ language plpgsql;
+create table fd (city int, zip int) distributed by (zip);
+insert into fd select (g % 100) / 10, g % 100 from generate_series(1, 10000) g;
+analyze fd;
+
+-- The degree of the dependency of each column on the other
+select a.attname,
+       case 97 when stakind1 then stanumbers1 when stakind2 then stanumbers2
+               when stakind3 then stanumbers3 when stakind4 then stanumbers4
+               when stakind5 then stanumbers5 end as degrees
+from pg_statistic s join pg_attribute a
+  on a.attrelid = s.starelid and a.attnum = s.staattnum
+where s.starelid = 'fd'::regclass order by a.attname;
+
+select count(*) from fd where city = 3 and zip = 35;
+select fd_rows('select * from fd where city = 3 and zip = 35') >= 50 as dependent;
+
+-- Not with the GUC off
+set optimizer_enable_dependency_damping = off;
+select fd_rows('select * from fd where city = 3 and zip = 35') >= 50 as dependent;
+reset optimizer_enable_dependency_damping;
+
+-- Nor without the statistics
+set gp_statistics_dependency_columns = 0;
+analyze fd;
+select count(*) from pg_statistic where starelid = 'fd'::regclass
+  and 97 in (stakind1, stakind2, stakind3, stakind4, stakind5);
+select fd_rows('select * from fd where city = 3 and zip = 35') >= 50 as dependent;
+reset gp_statistics_dependency_columns;
+
+-- Independent columns keep their estimate
+create table fd_ind (a int, b int) distributed by (a);
+insert into fd_ind select g % 10, (g / 10) % 100 from generate_series(1, 10000) g;
+analyze fd_ind;
+select a.attname,
+       case 97 when stakind1 then stanumbers1 when stakind2 then stanumbers2
+               when stakind3 then stanumbers3 when stakind4 then stanumbers4
+               when stakind5 then stanumbers5 end as degrees
+from pg_statistic s join pg_attribute a
+  on a.attrelid = s.starelid and a.attnum = s.staattnum
+where s.starelid = 'fd_ind'::regclass order by a.attname;
+select count(*) from fd_ind where a = 3 and b = 35;
+select fd_rows('select * from fd_ind where a = 3 and b = 35') >= 50 as dependent;
+
+drop table fd, fd_ind;
+drop function fd_rows(text);
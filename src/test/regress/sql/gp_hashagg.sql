@@ -89,3 +89,18 @@ set enable_sort=off;
 -- use a Sort + Group, because nohash_int type is not hashable.
 select normal_int from hashagg_test2 group by normal_int;
 select nohash_int from hashagg_test2 group by nohash_int;
+
+-- Streaming bottom stage of a two-stage hash agg. With a ratio of 0, it
+-- passes the rest of its input through once the hash table gets full.
+create table hashagg_stream (a int, b int) distributed randomly;
+insert into hashagg_stream select g % 50000, g from generate_series(1, 100000) g;
+analyze hashagg_stream;
+set statement_mem = '1000kB';
+set gp_hashagg_passthrough_ratio = 0;
+select count(*), sum(c), sum(s), min(mn), max(mx)
+from (select a, count(*) c, sum(b) s, min(b) mn, max(b) mx from hashagg_stream group by a) t;
+select count(*) from (select a from hashagg_stream group by a having count(*) = 2) t;
+reset gp_hashagg_passthrough_ratio;
+select count(*), sum(c), sum(s), min(mn), max(mx)
+from (select a, count(*) c, sum(b) s, min(b) mn, max(b) mx from hashagg_stream group by a) t;
+reset statement_mem;
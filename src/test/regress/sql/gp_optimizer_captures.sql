@@ -0,0 +1,54 @@
+--
+-- Minidumps of slow optimizations, gp_optimizer_captures()
+--
+-- With optimizer_capture_threshold set to 1 ms, every optimization of a join
+-- of six tables is slow enough to be kept, in a ring of the last 8.
+--
+create table goc (a int, b int) distributed by (a);
+
+-- Nothing is kept by default
+select count(*) from goc t1 join goc t2 using (a) join goc t3 using (a)
+  join goc t4 using (a) join goc t5 using (a) join goc t6 using (a);
+select count(*) from gp_optimizer_captures();
+
+set optimizer_capture_threshold = 1;
+select count(*) from goc t1 join goc t2 using (a) join goc t3 using (a)
+  join goc t4 using (a) join goc t5 using (a) join goc t6 using (a);
+reset optimizer_capture_threshold;
+select count(*) from gp_optimizer_captures();
+select query like 'select count(*) from goc t1 join goc t2%' as query,
+       minidump like '<?xml%<dxl:Thread Id="0">%<dxl:Query>%<dxl:Plan %' as minidump,
+       minidump like '%<dxl:OptimizerConfig>%' as config,
+       optimization_time >= 1 and captured_at <= now() as timed
+from gp_optimizer_captures();
+
+-- Only the last 8 are kept, oldest first
+set optimizer_capture_threshold = 1;
+do $$
+begin
+  for i in 1 .. 9 loop
+    execute 'select count(*) from goc t1 join goc t2 using (a) join goc t3 using (a)
+      join goc t4 using (a) join goc t5 using (a) join goc t6 using (a) where t1.b = ' || i;
+  end loop;
+end;
+$$;
+reset optimizer_capture_threshold;
+select count(*), bool_and(query like 'do %') as from_do from gp_optimizer_captures();
+select bool_and(captured_at >= prev) as oldest_first from (
+  select captured_at, lag(captured_at) over () as prev from gp_optimizer_captures()) s;
+
+-- Errors
+set optimizer_capture_threshold = -1;
+select * from gp_optimizer_captures(1);
+
+-- The Postgres planner keeps nothing
+set optimizer = off;
+set optimizer_capture_threshold = 1;
+create temp table goc_before as select captured_at from gp_optimizer_captures() distributed randomly;
+select count(*) from goc t1 join goc t2 using (a) join goc t3 using (a)
+  join goc t4 using (a) join goc t5 using (a) join goc t6 using (a);
+reset optimizer_capture_threshold;
+select count(*) from gp_optimizer_captures() where captured_at > all (select captured_at from goc_before);
+reset optimizer;
+
+drop table goc;
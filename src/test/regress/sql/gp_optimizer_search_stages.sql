@@ -0,0 +1,25 @@
+--
+-- The outcome of each stage of the search strategy of GPORCA,
+-- gp_optimizer_search_stages()
+--
+-- The default search strategy has a single stage, with all the
+-- transformations, that finds the plan of every optimization.
+--
+create table goss (a int, b int) distributed by (a);
+select count(*) from goss g1 join goss g2 using (a) where g1.b > 0;
+select stage, num_xforms > 0 as has_xforms, num_searches > 0 as searched,
+       num_plans = num_searches as always_planned,
+       num_best = num_plans as always_best, last_cost > 0 as costed
+from gp_optimizer_search_stages();
+
+-- The Postgres planner doesn't count
+set optimizer = off;
+create temp table goss_before as select * from gp_optimizer_search_stages() distributed randomly;
+select count(*) from goss g1 join goss g2 using (a) where g1.b > 0;
+select s.stage, s.num_searches = b.num_searches as unchanged
+from gp_optimizer_search_stages() s join goss_before b using (stage);
+reset optimizer;
+
+select * from gp_optimizer_search_stages(1);
+
+drop table goss;
@@ -0,0 +1,53 @@
+--
+-- EXPLAIN (OPTIMIZER_STATS) and gp_optimizer_stats()
+--
+-- Where GPORCA spent the time planning a query.  The times vary from run to
+-- run, so only the shape of the output is checked.
+--
+create table gos (a int, b int) distributed by (a);
+create function gos_explain(options text, query text) returns setof text as $$
+declare
+  line text;
+begin
+  for line in execute 'explain (costs off, ' || options || ') ' || query loop
+    if line like 'Optimizer phases:%' or line like 'Optimizer metadata:%' then
+      return next regexp_replace(line, '[0-9]+(\.[0-9]+)?', 'N', 'g');
+    end if;
+  end loop;
+end;
+$$ language plpgsql;
+create function gos_json_keys(query text) returns setof text as $$
+declare
+  doc text;
+begin
+  execute 'explain (costs off, optimizer_stats, format json) ' || query into doc;
+  return query select json_object_keys((doc::json)->0->'Optimizer Statistics');
+end;
+$$ language plpgsql;
+
+-- Printed only when GPORCA plans the query
+select * from gos_explain('optimizer_stats', 'select a, count(*) from gos group by a');
+select * from gos_explain('optimizer_stats off', 'select a, count(*) from gos group by a');
+select * from gos_json_keys('select a, count(*) from gos group by a');
+explain (optimizer_stats maybe) select * from gos;
+
+-- The totals of the session
+select num_optimizations > 0 as optimized, peak_memory > 0 as peak_memory,
+       translate_time >= 0 and search_time >= 0 and plan_time >= 0 and
+       missing_stats_time >= 0 and mdfetch_time >= 0 as timed
+from gp_optimizer_stats();
+select * from gp_optimizer_stats(1);
+
+-- With optimizer off, the planner plans the queries and the totals stay
+set optimizer = off;
+create temp table gos_before as select * from gp_optimizer_stats() distributed randomly;
+select * from gos_explain('optimizer_stats', 'select a, count(*) from gos group by a');
+select * from gos_json_keys('select a, count(*) from gos group by a');
+select count(*) from gos;
+select s.num_optimizations = b.num_optimizations as unchanged
+from gp_optimizer_stats() s, gos_before b;
+reset optimizer;
+
+drop function gos_explain(text, text);
+drop function gos_json_keys(text);
+drop table gos;
@@ -0,0 +1,55 @@
+--
+-- COPY FROM with the columns that are not distribution keys converted on the
+-- segments.
+--
+SET gp_enable_segment_copy_parsing = on;
+
+CREATE TABLE copy_seg_parse (a int, b text, c numeric(10,2), d date,
+	e varchar(3), f int[], g int DEFAULT 42) DISTRIBUTED BY (a);
+
+COPY copy_seg_parse (a, b, c, d, e, f) FROM stdin;
+1	one	1.5	2020-01-01	abc	{1,2}
+2	\N	2.25	2020-01-02	de	{}
+3	three	\N	\N	\N	\N
+4	back\\slash	-4	2020-01-04	f	{4}
+\.
+
+COPY copy_seg_parse (a, b, c, d, e, f) FROM stdin CSV FORCE NOT NULL b;
+5,,5,2020-01-05,g,"{5,5}"
+6,"six, quoted",6.125,2020-01-06,hi,{6}
+\.
+
+SELECT * FROM copy_seg_parse ORDER BY a;
+
+-- Conversion errors are reported by the segments
+COPY copy_seg_parse (a, b, c, d, e, f) FROM stdin;
+7	seven	7	2020-01-07	toolong	{7}
+\.
+COPY copy_seg_parse (a, b, c, d, e, f) FROM stdin;
+8	eight	8	notadate	h	{8}
+\.
+
+-- Errors of the distribution key columns are still reported by the master
+COPY copy_seg_parse (a, b, c, d, e, f) FROM stdin;
+nine	nine	9	2020-01-09	i	{9}
+\.
+
+-- The same rows without it
+SET gp_enable_segment_copy_parsing = off;
+CREATE TABLE copy_seg_parse2 (LIKE copy_seg_parse INCLUDING DEFAULTS) DISTRIBUTED BY (a);
+COPY copy_seg_parse2 (a, b, c, d, e, f) FROM stdin;
+1	one	1.5	2020-01-01	abc	{1,2}
+2	\N	2.25	2020-01-02	de	{}
+3	three	\N	\N	\N	\N
+4	back\\slash	-4	2020-01-04	f	{4}
+\.
+COPY copy_seg_parse2 (a, b, c, d, e, f) FROM stdin CSV FORCE NOT NULL b;
+5,,5,2020-01-05,g,"{5,5}"
+6,"six, quoted",6.125,2020-01-06,hi,{6}
+\.
+
+SELECT count(*) FROM (SELECT * FROM copy_seg_parse EXCEPT ALL SELECT * FROM copy_seg_parse2) d;
+
+DROP TABLE copy_seg_parse;
+DROP TABLE copy_seg_parse2;
+RESET gp_enable_segment_copy_parsing;
@@ -2118,6 +2118,12 @@ CREATE TABLE fbar (c, d) AS (VALUES (1, 42), (2, 43), (4, 45), (5, 46)) DISTRIBU
 
 SELECT d FROM ffoo FULL OUTER JOIN fbar ON a = c WHERE b BETWEEN 5 and 9;
 
+-- the same derived table joined twice is shared like a common table expression
+CREATE TABLE shared_sq (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO shared_sq SELECT i % 5, i FROM generate_series(1, 20) i;
+CREATE VIEW shared_sq_v AS SELECT a, sum(b) AS s FROM shared_sq GROUP BY a;
+SELECT v1.a, v1.s, v2.s FROM shared_sq_v v1, shared_sq_v v2 WHERE v1.a = v2.a + 1 ORDER BY 1;
+
 -- start_ignore
 DROP SCHEMA orca CASCADE;
 -- end_ignore
@@ -0,0 +1,51 @@
+--
+-- Tests of the metadata cache GPORCA shares between the backends on the
+-- master
+--
+
+-- A database copied from a template has the same object oids as the
+-- template, the metadata of one must not be used for the other.
+CREATE DATABASE gporca_mdcache_db1;
+\c gporca_mdcache_db1
+CREATE TABLE mdcache_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO mdcache_t SELECT 1, i FROM generate_series(1, 10) i;
+CREATE FUNCTION uses_hash_join() RETURNS bool AS $$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN SELECT * FROM mdcache_t t1 JOIN mdcache_t t2 ON t1.b = t2.b' LOOP
+    IF line LIKE '%Hash Join%' THEN
+      RETURN true;
+    END IF;
+  END LOOP;
+  RETURN false;
+END
+$$ LANGUAGE plpgsql;
+
+\c regression
+CREATE DATABASE gporca_mdcache_db2 TEMPLATE gporca_mdcache_db1;
+\c gporca_mdcache_db2
+ALTER TABLE mdcache_t SET DISTRIBUTED BY (b);
+
+-- Stores the metadata of the table distributed by a.
+\c gporca_mdcache_db1
+SELECT a, count(*) FROM mdcache_t GROUP BY a;
+
+-- The rows of a group are on different segments, they have to be
+-- redistributed to be grouped.
+\c gporca_mdcache_db2
+SELECT a, count(*) FROM mdcache_t GROUP BY a;
+
+-- The built-in objects are per database too: once int4 = can't be used
+-- for hash joins in one database, the other still uses it.
+\c gporca_mdcache_db2
+SET allow_system_table_mods = true;
+UPDATE pg_operator SET oprcanhash = false WHERE oid = '=(int4, int4)'::regoperator;
+\c gporca_mdcache_db1
+SELECT uses_hash_join();
+\c gporca_mdcache_db2
+SELECT uses_hash_join();
+
+\c regression
+DROP DATABASE gporca_mdcache_db1;
+DROP DATABASE gporca_mdcache_db2;
@@ -0,0 +1,43 @@
+--
+-- optimizer_memory_limit: a query whose optimization needs more memory than
+-- the limit is planned by the Postgres planner instead.
+--
+create table oml_t (a int, b int) distributed by (a);
+insert into oml_t select i, i % 10 from generate_series(1, 100) i;
+analyze oml_t;
+
+-- The memory limit line of EXPLAIN (optimizer_stats), and who planned the
+-- query
+create function oml_explain(query text) returns setof text as
+$$
+declare
+  explainrow text;
+begin
+  for explainrow in execute 'explain (optimizer_stats, costs off) ' || query
+  loop
+    if explainrow like 'Optimizer memory limit:%' then
+      return next explainrow;
+    elsif explainrow like 'Optimizer: Pivotal Optimizer%' then
+      return next 'planned by GPORCA';
+    elsif explainrow like 'Optimizer: Postgres query optimizer%' then
+      return next 'planned by the Postgres planner';
+    end if;
+  end loop;
+end;
+$$ language plpgsql;
+
+set optimizer_memory_limit = '100kB';
+select * from oml_explain('select count(*) from oml_t t1 join oml_t t2 using (a) join oml_t t3 using (a) join oml_t t4 on t4.b = t1.b');
+select count(*) from oml_t t1 join oml_t t2 using (a) join oml_t t3 using (a) join oml_t t4 on t4.b = t1.b;
+
+set optimizer_memory_limit = '1GB';
+select * from oml_explain('select count(*) from oml_t t1 join oml_t t2 using (a) join oml_t t3 using (a) join oml_t t4 on t4.b = t1.b');
+select count(*) from oml_t t1 join oml_t t2 using (a) join oml_t t3 using (a) join oml_t t4 on t4.b = t1.b;
+
+-- 0 is no limit
+set optimizer_memory_limit = 0;
+select * from oml_explain('select count(*) from oml_t t1 join oml_t t2 using (a) join oml_t t3 using (a) join oml_t t4 on t4.b = t1.b');
+reset optimizer_memory_limit;
+
+drop function oml_explain(text);
+drop table oml_t;
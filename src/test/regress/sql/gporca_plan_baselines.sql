@@ -0,0 +1,63 @@
+--
+-- Plan baselines of GPORCA (optimizer_plan_baselines)
+--
+-- A plan of another shape than the baseline is only tried every few
+-- executions, and is compared with the baseline once all its trials have
+-- run.  The plans of the query below are made to differ by disabling hash
+-- joins, the nested loop joins being much slower on these tables.  With the
+-- Postgres planner, there are no baselines and no messages.
+--
+create table bl_outer (a int, b int) distributed by (a);
+create table bl_inner (a int, b int) distributed by (b);
+insert into bl_outer select i, i from generate_series(1, 3000) i;
+insert into bl_inner select i, i from generate_series(1, 3000) i;
+analyze bl_outer;
+analyze bl_inner;
+
+-- Run the query n times, optimizing it each time.
+create function bl_run(query text, n int) returns void as $$
+begin
+  for i in 1..n loop
+    execute query;
+  end loop;
+end;
+$$ language plpgsql;
+
+set optimizer_plan_cache_size = 0;
+set optimizer_plan_baselines = 10;
+\set VERBOSITY terse
+
+-- The baseline is a hash join, the nested loop join loses its trials.
+set client_min_messages = debug1;
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.a = i.a', 1);
+set optimizer_enable_hashjoin = off;
+-- two trials, no decision yet
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.a = i.a', 22);
+-- the third trial decides
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.a = i.a', 11);
+-- it's not tried anymore
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.a = i.a', 22);
+
+-- The baseline is a nested loop join, the hash join wins its trials.
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.b = i.b', 1);
+reset optimizer_enable_hashjoin;
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.b = i.b', 22);
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.b = i.b', 11);
+-- it is the baseline now
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.b = i.b', 22);
+reset client_min_messages;
+
+-- Without baselines, the plan of the query is used right away.
+set optimizer_plan_baselines = 0;
+set client_min_messages = debug1;
+set optimizer_enable_hashjoin = off;
+select bl_run('select count(*) from bl_outer o join bl_inner i on o.a = i.a', 34);
+reset optimizer_enable_hashjoin;
+reset client_min_messages;
+
+\set VERBOSITY default
+reset optimizer_plan_baselines;
+reset optimizer_plan_cache_size;
+drop function bl_run(text, int);
+drop table bl_outer;
+drop table bl_inner;
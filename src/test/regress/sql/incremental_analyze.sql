@@ -797,3 +797,24 @@ INSERT INTO incr_analyze_test SELECT s, md5(s::varchar), '2018-01-02' FROM gener
 ANALYZE incr_analyze_test_1_prt_2;
 SELECT tablename, attname, null_frac, n_distinct, most_common_vals, most_common_freqs, histogram_bounds FROM pg_stats WHERE tablename like 'incr_analyze_test%' ORDER BY attname,tablename;
 SELECT relname, relpages, reltuples FROM pg_class WHERE relname LIKE 'incr_analyze_test%' ORDER BY relname;
+
+-- Test that ANALYZE skips the leaf partitions that haven't changed
+DROP TABLE IF EXISTS incr_analyze_changed;
+CREATE TABLE incr_analyze_changed (a int, b int) WITH (appendonly=true) DISTRIBUTED BY (a)
+	PARTITION BY RANGE (b) (START (0) END (3) EVERY (1));
+INSERT INTO incr_analyze_changed SELECT i, i % 3 FROM generate_series(1, 300) i;
+SET optimizer_analyze_changed_partitions_only = on;
+ANALYZE incr_analyze_changed;
+CREATE TEMP TABLE incr_analyze_changed_times AS
+	SELECT objid::regclass AS relname, statime FROM pg_stat_last_operation
+	WHERE staactionname = 'ANALYZE' AND objid IN (SELECT inhrelid FROM pg_inherits WHERE inhparent = 'incr_analyze_changed'::regclass)
+	DISTRIBUTED RANDOMLY;
+INSERT INTO incr_analyze_changed VALUES (301, 1);
+-- let the stats collector receive the report of the first ANALYZE
+SELECT pg_sleep(1);
+ANALYZE incr_analyze_changed;
+SELECT t.relname, o.statime = t.statime AS skipped
+	FROM incr_analyze_changed_times t JOIN pg_stat_last_operation o
+	ON o.objid = t.relname::oid AND o.staactionname = 'ANALYZE' ORDER BY 1;
+SELECT tablename, attname, n_distinct FROM pg_stats WHERE tablename = 'incr_analyze_changed' AND attname = 'b';
+RESET optimizer_analyze_changed_partitions_only;
@@ -0,0 +1,52 @@
+--
+-- Incremental sorts of GPORCA plans (optimizer_enable_incremental_sort)
+--
+-- The outer sort on (a, b) gets its input sorted on a from the Gather
+-- Motion, and sorts the rows of each value of a on their own.  With the
+-- Postgres planner, the sort is a full one.
+--
+create table incrsort_t (a int, b int) distributed by (b);
+insert into incrsort_t select i % 3, i from generate_series(1, 120) i;
+analyze incrsort_t;
+
+explain (costs off)
+select * from (select a, b from incrsort_t order by a limit 100) s order by a, b;
+
+-- Rows around the end of the run of a = 0
+select * from (select a, b from incrsort_t order by a limit 100) s
+order by a, b limit 6 offset 37;
+select * from (select a, b from incrsort_t order by a limit 100) s
+order by a, b desc limit 6 offset 37;
+
+-- All the rows must come in order.
+create function incrsort_check(query text) returns bigint as $$
+declare
+  r record;
+  prev record;
+  n bigint := 0;
+begin
+  for r in execute query loop
+    if n > 0 then
+      if r.a < prev.a or (r.a = prev.a and r.b < prev.b) then
+        raise exception 'row (%, %) after (%, %)', r.a, r.b, prev.a, prev.b;
+      end if;
+    end if;
+    prev := r;
+    n := n + 1;
+  end loop;
+  return n;
+end;
+$$ language plpgsql;
+
+select incrsort_check('select * from (select a, b from incrsort_t order by a limit 100) s order by a, b');
+select incrsort_check('select * from (select a, b from incrsort_t order by a limit 120) s order by a, b limit 50');
+
+set optimizer_enable_incremental_sort = off;
+explain (costs off)
+select * from (select a, b from incrsort_t order by a limit 100) s order by a, b;
+select * from (select a, b from incrsort_t order by a limit 100) s
+order by a, b limit 6 offset 37;
+reset optimizer_enable_incremental_sort;
+
+drop function incrsort_check(text);
+drop table incrsort_t;
@@ -434,3 +434,28 @@ reset enable_nestloop;
 reset enable_material;
 reset enable_seqscan;
 reset enable_bitmapscan;
+
+--
+-- Test the bloom filter of hash joins, outer rows without a match are
+-- discarded by it in inner, semi and right joins only.
+--
+create table bloom_fact (a int, b int) distributed by (a);
+create table bloom_dim (a int, b int) distributed by (a);
+insert into bloom_fact select i, i % 1000 from generate_series(1, 100000) i;
+insert into bloom_dim select i, i from generate_series(1, 10) i;
+insert into bloom_dim values (11, 5000);
+analyze bloom_fact;
+analyze bloom_dim;
+set enable_nestloop = off;
+set enable_mergejoin = off;
+select count(*) from bloom_fact f join bloom_dim d on f.b = d.b;
+select count(*) from bloom_fact f where f.b in (select b from bloom_dim);
+select count(*) from bloom_fact f right join bloom_dim d on f.b = d.b;
+select count(*) from bloom_fact f left join bloom_dim d on f.b = d.b;
+select count(*) from bloom_fact f where not exists (select 1 from bloom_dim d where d.b = f.b);
+set gp_hashjoin_bloomfilter = off;
+select count(*) from bloom_fact f join bloom_dim d on f.b = d.b;
+reset gp_hashjoin_bloomfilter;
+reset enable_nestloop;
+reset enable_mergejoin;
+drop table bloom_fact, bloom_dim;
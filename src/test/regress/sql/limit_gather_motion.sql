@@ -0,0 +1,51 @@
+--
+-- LIMIT and OFFSET above a Gather Motion that merges the sorted output of the
+-- segments.  The Sort on the segments only needs to keep the first
+-- LIMIT + OFFSET rows.
+--
+create table lgm_t (a int, b int) distributed by (a);
+-- Analyze while the table is small, so that ORCA doesn't add a Limit on the
+-- segments of its own.
+insert into lgm_t select i, (i * 37) % 1000 from generate_series(1, 3) i;
+analyze lgm_t;
+insert into lgm_t select i, (i * 37) % 1000 from generate_series(4, 1000) i;
+
+-- The sort method the Sort used on the segments
+create function lgm_sort_method(query text) returns setof text as
+$$
+declare
+  explainrow text;
+begin
+  for explainrow in execute 'explain analyze ' || query
+  loop
+    if explainrow like '%Sort Method:%' then
+      return next regexp_replace(trim(explainrow), '  (Memory|Disk): .*', '');
+    end if;
+  end loop;
+end;
+$$ language plpgsql;
+
+explain (costs off) select * from lgm_t order by b limit 5 offset 5;
+select * from lgm_t order by b limit 5 offset 5;
+select lgm_sort_method('select * from lgm_t order by b limit 5 offset 5');
+
+-- Parameters of the query can be evaluated on the segments too.
+prepare lgm_p(int, int) as select * from lgm_t order by b limit $1 offset $2;
+execute lgm_p(3, 10);
+select lgm_sort_method('execute lgm_p(3, 10)');
+deallocate lgm_p;
+
+-- A subquery in the LIMIT is only evaluated by the Limit on the QD.
+select * from lgm_t order by b limit (select 2) offset (select 1);
+
+-- No bound without a LIMIT, or with LIMIT ALL
+select * from lgm_t order by b offset 995;
+select count(*) from (select * from lgm_t order by b limit null offset 10) s;
+
+set gp_enable_sort_limit = off;
+select * from lgm_t order by b limit 5 offset 5;
+select lgm_sort_method('select * from lgm_t order by b limit 5 offset 5');
+reset gp_enable_sort_limit;
+
+drop function lgm_sort_method(text);
+drop table lgm_t;
@@ -0,0 +1,73 @@
+--
+-- Answering aggregate queries of GPORCA from materialized views
+-- (optimizer_enable_matview_rewrite)
+--
+-- The Postgres planner never rewrites the queries, so it always scans the
+-- table and gets the current aggregates.
+--
+set optimizer_enable_matview_rewrite = on;
+
+-- The relations the plan of a query scans
+create function mvr_scanned(query text) returns text as $$
+declare
+  line text;
+  result text := '';
+begin
+  for line in execute 'explain ' || query loop
+    if line ~ 'Scan on ' then
+      result := result || substring(line from 'Scan on (\w+)') || ' ';
+    end if;
+  end loop;
+  return rtrim(result);
+end;
+$$ language plpgsql;
+
+create table mvr_sales (day int, cust int, amount int) distributed by (cust);
+insert into mvr_sales select g % 7, g % 5, g from generate_series(1, 70) g;
+analyze mvr_sales;
+create materialized view mvr_by_day_cust as
+  select day, cust, sum(amount) as total, count(*) as n, min(amount) as lo, max(amount) as hi
+  from mvr_sales group by day, cust distributed by (day);
+analyze mvr_by_day_cust;
+
+-- Same grouping: the rows of the view are the groups
+explain (costs off) select day, cust, sum(amount) from mvr_sales group by day, cust;
+select day, cust, sum(amount) from mvr_sales where day = 1 group by day, cust order by cust;
+
+-- Coarser grouping: the sums, counts, minimums and maximums are rolled up
+select mvr_scanned('select day, sum(amount), count(*), min(amount), max(amount) from mvr_sales group by day');
+select day, sum(amount), count(*), min(amount), max(amount) from mvr_sales group by day order by day;
+select count(*) from mvr_sales where day = 3;
+
+-- Not answered from the view: an average can't be rolled up, and the view
+-- has no amounts to filter by
+select mvr_scanned('select day, avg(amount) from mvr_sales group by day');
+select mvr_scanned('select day, sum(amount) from mvr_sales where amount > 10 group by day');
+select day, avg(amount) from mvr_sales where day < 2 group by day order by day;
+
+-- The view holds the rows of its last refresh
+insert into mvr_sales values (1, 1, 1000);
+select day, sum(amount) from mvr_sales where day = 1 group by day;
+refresh materialized view mvr_by_day_cust;
+select day, sum(amount) from mvr_sales where day = 1 group by day;
+
+-- A user who can't read the view gets the query of the table
+create role mvr_user;
+grant select on mvr_sales to mvr_user;
+set role mvr_user;
+select mvr_scanned('select day, sum(amount) from mvr_sales group by day');
+select day, sum(amount) from mvr_sales where day = 1 group by day;
+reset role;
+grant select on mvr_by_day_cust to mvr_user;
+set role mvr_user;
+select mvr_scanned('select day, sum(amount) from mvr_sales group by day');
+reset role;
+
+set optimizer_enable_matview_rewrite = off;
+select mvr_scanned('select day, sum(amount), count(*), min(amount), max(amount) from mvr_sales group by day');
+reset optimizer_enable_matview_rewrite;
+
+drop materialized view mvr_by_day_cust;
+drop table mvr_sales;
+drop role mvr_user;
+drop function mvr_scanned(text);
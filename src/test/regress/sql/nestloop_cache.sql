@@ -0,0 +1,61 @@
+--
+-- Cache of the inner rows of parameterized nested loop joins
+-- (gp_enable_nestloop_cache)
+--
+-- The function raises a notice whenever the inner side is actually scanned.
+-- The Postgres planner joins the functions below laterally, with a nested
+-- loop join passing the outer values as parameters.
+--
+set optimizer = off;
+
+create function nl_rows(int) returns setof int as $$
+begin
+  raise notice 'nl_rows(%)', $1;
+  if $1 is null then
+    return next 0;
+  else
+    return next $1;
+    return next $1 * 10;
+  end if;
+end;
+$$ language plpgsql immutable;
+
+create function nl_rows_volatile(int) returns setof int as $$
+begin
+  raise notice 'nl_rows_volatile(%)', $1;
+  return next $1;
+end;
+$$ language plpgsql volatile;
+
+create function nl_add(int, int) returns setof int as $$
+begin
+  raise notice 'nl_add(%, %)', $1, $2;
+  return next $1 + $2;
+end;
+$$ language plpgsql immutable;
+
+-- Repeated outer values replay the cached inner rows, NULLs included.
+select * from (values (1), (2), (1), (NULL), (2), (NULL)) v(r), nl_rows(r) s;
+
+-- A volatile inner side is scanned for every outer row.
+select * from (values (1), (2), (1)) v(r), nl_rows_volatile(r) s;
+
+-- The cache is kept when the join is rescanned with parameters that only
+-- the outer side uses...
+select y, (select array_agg(s) from (values (1), (2), (1)) v(r), nl_rows(r) s
+           where r < y)
+from (values (2), (3)) w(y);
+
+-- ... and dropped when the inner side uses them.
+select y, (select array_agg(s) from (values (1), (2), (1)) v(r), nl_add(r, y) s)
+from (values (10), (20)) w(y);
+
+-- Without the cache, the inner side is scanned for every outer row.
+set gp_enable_nestloop_cache = off;
+select * from (values (1), (2), (1), (NULL), (2), (NULL)) v(r), nl_rows(r) s;
+reset gp_enable_nestloop_cache;
+
+reset optimizer;
+drop function nl_rows(int);
+drop function nl_rows_volatile(int);
+drop function nl_add(int, int);
@@ -0,0 +1,54 @@
+--
+-- Estimated and actual rows of the nodes of GPORCA plans
+-- (optimizer_plan_trace, gp_optimizer_plan_trace())
+--
+-- EXPLAIN ANALYZE keeps the estimates of each node of a GPORCA plan next
+-- to the rows it returned.  Nodes of plans of the same shape share their
+-- fingerprint, whatever the constants of the query.
+--
+create function pt_explain(options text, query text) returns void as $$
+declare
+  line text;
+begin
+  for line in execute 'explain (' || options || ') ' || query loop
+  end loop;
+end;
+$$ language plpgsql;
+create table pt (a int, b int) distributed by (a);
+insert into pt select g, g from generate_series(1, 1000) g;
+analyze pt;
+-- analyzed while small
+create table pt_stale (a int, b int) distributed by (a);
+insert into pt_stale select g, g from generate_series(1, 10) g;
+analyze pt_stale;
+insert into pt_stale select g, g from generate_series(11, 1000) g;
+
+set optimizer_plan_trace = on;
+select pt_explain('analyze', 'select * from pt where b <= 100');
+select pt_explain('analyze', 'select * from pt where b <= 500');
+select pt_explain('analyze', 'select * from pt_stale where b <= 1000');
+select node_type, actual_rows, plan_rows > 0 as estimated,
+       total_cost > 0 as costed, actual_time >= 0 as timed
+from gp_optimizer_plan_trace();
+select node_type, count(*), count(distinct fingerprint) as fingerprints
+from gp_optimizer_plan_trace() group by node_type order by node_type;
+-- the nodes of the stale table are underestimated
+select node_type, actual_rows from gp_optimizer_plan_trace()
+where actual_rows > 10 * plan_rows;
+
+-- Nothing is kept without ANALYZE, with the GUC off, or for the plans of
+-- the Postgres planner
+select pt_explain('costs off', 'select * from pt where b <= 100');
+select count(*) from gp_optimizer_plan_trace();
+set optimizer_plan_trace = off;
+select pt_explain('analyze', 'select * from pt where b <= 100');
+select count(*) from gp_optimizer_plan_trace();
+set optimizer_plan_trace = on;
+set optimizer = off;
+select pt_explain('analyze', 'select * from pt where b <= 100');
+reset optimizer;
+select count(*) from gp_optimizer_plan_trace();
+reset optimizer_plan_trace;
+
+drop table pt, pt_stale;
+drop function pt_explain(text, text);
@@ -0,0 +1,39 @@
+--
+-- Index-only scans of GPORCA plans (optimizer_enable_indexonlyscan)
+--
+-- An index scan of GPORCA that only needs the columns of a btree index is
+-- run as an index-only scan, once VACUUM has marked pages of the table
+-- all-visible.
+--
+create table ios (a int, b int, c text) distributed by (a);
+create index ios_b on ios (b);
+insert into ios select g, g, 'c' || g from generate_series(1, 10000) g;
+analyze ios;
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+set optimizer_enable_tablescan = off;
+set optimizer_enable_bitmapscan = off;
+
+-- No page is all-visible yet, so GPORCA keeps the index scan
+select relallvisible > 0 as all_visible from pg_class where relname = 'ios';
+explain (costs off) select b from ios where b < 10;
+select count(*), sum(b) from ios where b < 10;
+
+vacuum ios;
+select relallvisible > 0 as all_visible from pg_class where relname = 'ios';
+explain (costs off) select b from ios where b < 10;
+select count(*), sum(b) from ios where b < 10;
+
+-- The index doesn't cover column c
+explain (costs off) select c from ios where b < 10;
+
+set optimizer_enable_indexonlyscan = off;
+explain (costs off) select b from ios where b < 10;
+select count(*), sum(b) from ios where b < 10;
+reset optimizer_enable_indexonlyscan;
+
+reset enable_seqscan;
+reset enable_bitmapscan;
+reset optimizer_enable_tablescan;
+reset optimizer_enable_bitmapscan;
+drop table ios;
@@ -0,0 +1,45 @@
+--
+-- Merges of ordered index scans of partitions for top-N queries of GPORCA
+-- plans (optimizer_enable_partition_merge_append)
+--
+-- With the GUC on, the bounded Sort of a partitioned table becomes a Merge
+-- Append of index scans of its partitions, like the Postgres planner does.
+--
+set optimizer_enable_partition_merge_append = on;
+
+create table pma (k int, ts int) distributed by (k)
+partition by range (ts) (start (0) end (300) every (100));
+create index pma_p1_ts on pma_1_prt_1 (ts);
+create index pma_p2_ts on pma_1_prt_2 (ts);
+create index pma_p3_ts on pma_1_prt_3 (ts);
+-- the second partition stays empty
+insert into pma select g, g from generate_series(0, 99) g;
+insert into pma select g, g from generate_series(200, 299) g;
+analyze pma;
+
+explain (costs off) select * from pma order by ts limit 5;
+select * from pma order by ts limit 5;
+-- across the empty partition
+select ts from pma order by ts limit 5 offset 98;
+select min(ts), max(ts), count(*) from (select ts from pma order by ts limit 150) s;
+
+-- Descending, with backward index scans
+explain (costs off) select * from pma order by ts desc limit 3;
+select * from pma order by ts desc limit 3;
+
+-- With the pruned partitions left out
+explain (costs off) select * from pma where ts >= 150 order by ts limit 3;
+select * from pma where ts >= 150 order by ts limit 3;
+
+-- A partition without an index is sorted by GPORCA as a whole
+drop index pma_p3_ts;
+explain (costs off) select * from pma order by ts limit 5;
+select * from pma order by ts limit 5;
+create index pma_p3_ts on pma_1_prt_3 (ts);
+
+set optimizer_enable_partition_merge_append = off;
+explain (costs off) select * from pma order by ts limit 5;
+select ts from pma order by ts limit 5 offset 98;
+reset optimizer_enable_partition_merge_append;
+
+drop table pma;
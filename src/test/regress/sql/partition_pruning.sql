@@ -870,4 +870,16 @@ select get_selected_parts('explain analyze select * from bar where j is distinct
 -- 8 parts: NULL is shared with others on p1. So, all 8 parts.
 select get_selected_parts('explain analyze select * from bar where j is distinct from NULL;');
 
+-- A function's query is planned without the values of its parameters. The
+-- partitions to scan are selected by them when the execution starts.
+create table param_sel (a int, dd date) distributed by (a)
+partition by range (dd) (start ('2020-01-01') end ('2020-01-05') every (interval '1 day'));
+insert into param_sel select i, '2020-01-01'::date + i % 4 from generate_series(1, 100) i;
+create function param_sel_count(d date) returns bigint as
+$$ select count(*) from param_sel where dd = $1 $$ language sql;
+select param_sel_count('2020-01-02');
+select param_sel_count('2020-01-04');
+select param_sel_count('2020-01-05');
+select param_sel_count(null);
+
 RESET ALL;
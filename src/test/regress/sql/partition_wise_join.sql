@@ -0,0 +1,83 @@
+--
+-- Partition-wise hash joins of GPORCA plans (optimizer_enable_partition_wise_join)
+--
+-- A hash join of two tables with the same partition bounds, on their
+-- partition keys, becomes an Append of joins of the pairs of partitions.
+-- The Postgres planner joins the Appends of the partitions as it always did.
+--
+set optimizer_enable_partition_wise_join = on;
+
+-- Number of hash joins in the plan of a query
+create function pwj_joins(query text) returns int as $$
+declare
+  line text;
+  n int := 0;
+begin
+  for line in execute 'explain ' || query loop
+    if line like '%Hash%Join%' then
+      n := n + 1;
+    end if;
+  end loop;
+  return n;
+end;
+$$ language plpgsql;
+
+create table pwj_a (a int, b int) distributed by (a)
+partition by range (a) (start (0) end (30) every (10), default partition other);
+create table pwj_b (a int, b int) distributed by (a)
+partition by range (a) (start (0) end (30) every (10), default partition other);
+insert into pwj_a select g, g from generate_series(-5, 39) g;
+insert into pwj_b select g, g * 2 from generate_series(0, 44) g;
+analyze pwj_a;
+analyze pwj_b;
+
+-- Co-partitioned equi-join: one join per pair, the default partitions too
+explain (costs off)
+select * from pwj_a join pwj_b on pwj_a.a = pwj_b.a;
+select pwj_joins('select * from pwj_a join pwj_b on pwj_a.a = pwj_b.a');
+select count(*), sum(pwj_b.b) from pwj_a join pwj_b on pwj_a.a = pwj_b.a;
+select pwj_a.a, pwj_b.b from pwj_a join pwj_b on pwj_a.a = pwj_b.a where pwj_b.b >= 60 order by 1;
+
+-- Pairs with a partition that is not selected are left out
+explain (costs off)
+select * from pwj_a join pwj_b on pwj_a.a = pwj_b.a where pwj_a.a in (5, 12);
+select * from pwj_a join pwj_b on pwj_a.a = pwj_b.a where pwj_a.a in (5, 12) order by 1;
+
+-- Tables that are not partitioned alike are joined as they were
+create table pwj_nodef (a int, b int) distributed by (a)
+partition by range (a) (start (0) end (30) every (10));
+insert into pwj_nodef select g, g * 3 from generate_series(0, 29) g;
+create table pwj_c (a int, b int) distributed by (a)
+partition by range (a) (start (0) end (30) every (15), default partition other);
+insert into pwj_c select g, g from generate_series(0, 44) g;
+create table pwj_ml_a (a int, b int) distributed by (a)
+partition by range (a) subpartition by list (b)
+subpartition template (subpartition even values (0), subpartition odd values (1))
+(partition p1 start (0) end (20), partition p2 start (20) end (40));
+create table pwj_ml_b (a int, b int) distributed by (a)
+partition by range (a) subpartition by list (b)
+subpartition template (subpartition even values (0), subpartition odd values (1))
+(partition p1 start (0) end (20), partition p2 start (20) end (40));
+insert into pwj_ml_a select g, g % 2 from generate_series(0, 39) g;
+insert into pwj_ml_b select g, g % 2 from generate_series(0, 39) g;
+analyze pwj_nodef;
+analyze pwj_c;
+analyze pwj_ml_a;
+analyze pwj_ml_b;
+-- A default partition on one side only
+select pwj_joins('select * from pwj_a join pwj_nodef on pwj_a.a = pwj_nodef.a');
+select count(*), sum(pwj_nodef.b) from pwj_a join pwj_nodef on pwj_a.a = pwj_nodef.a;
+-- Different bounds
+select pwj_joins('select * from pwj_a join pwj_c on pwj_a.a = pwj_c.a');
+select count(*), sum(pwj_c.b) from pwj_a join pwj_c on pwj_a.a = pwj_c.a;
+-- Multi-level partitioning
+select pwj_joins('select * from pwj_ml_a join pwj_ml_b on pwj_ml_a.a = pwj_ml_b.a');
+select count(*), sum(pwj_ml_b.b) from pwj_ml_a join pwj_ml_b on pwj_ml_a.a = pwj_ml_b.a;
+
+set optimizer_enable_partition_wise_join = off;
+select pwj_joins('select * from pwj_a join pwj_b on pwj_a.a = pwj_b.a');
+select count(*), sum(pwj_b.b) from pwj_a join pwj_b on pwj_a.a = pwj_b.a;
+reset optimizer_enable_partition_wise_join;
+
+drop function pwj_joins(text);
+drop table pwj_a, pwj_b, pwj_nodef, pwj_c, pwj_ml_a, pwj_ml_b;
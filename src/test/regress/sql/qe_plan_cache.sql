@@ -0,0 +1,44 @@
+--
+-- The plans that the QEs keep deserialized (gp_enable_qe_plan_cache)
+--
+-- A QE that receives the bytes of a plan it kept copies it instead of
+-- reading it again.  Plans that differ only in a constant have the same
+-- length, and must not be taken for one another.
+--
+create table qpc (a int, b int, c text) distributed by (a);
+insert into qpc select g, g % 10, 'v' || (g % 10) from generate_series(1, 1000) g;
+analyze qpc;
+create function qpc_sums(n int) returns table (k int, total bigint) as $$
+begin
+  for i in 1 .. n loop
+    k := i;
+    total := (select sum(a) from qpc where b = i);
+    return next;
+  end loop;
+end;
+$$ language plpgsql;
+
+select sum(a) from qpc where b = 1;
+select sum(a) from qpc where b = 1;
+-- a different plan of the same length
+select sum(a) from qpc where b = 2;
+select sum(a) from qpc where c = 'v3';
+select sum(a) from qpc where c = 'v4';
+select sum(a) from qpc where b = 1;
+-- the generic plan of the later executions, with other parameters
+select * from qpc_sums(8);
+
+set gp_enable_qe_plan_cache = off;
+select sum(a) from qpc where b = 1;
+select sum(a) from qpc where b = 1;
+-- a different plan of the same length
+select sum(a) from qpc where b = 2;
+select sum(a) from qpc where c = 'v3';
+select sum(a) from qpc where c = 'v4';
+select sum(a) from qpc where b = 1;
+-- the generic plan of the later executions, with other parameters
+select * from qpc_sums(8);
+reset gp_enable_qe_plan_cache;
+
+drop function qpc_sums(int);
+drop table qpc;
@@ -62,3 +62,32 @@ SELECT 1 IS NOT DISTINCT FROM 2 as "no";
 SELECT 2 IS NOT DISTINCT FROM 2 as "yes";
 SELECT 2 IS NOT DISTINCT FROM null as "no";
 SELECT null IS NOT DISTINCT FROM null as "yes";
+
+--
+-- DISTINCT and GROUP BY on the leading column of an index, read by an
+-- index-only scan that skips to the next value.
+--
+CREATE TABLE skipscan_tbl (a int, b int) DISTRIBUTED BY (b);
+INSERT INTO skipscan_tbl SELECT i % 7, i FROM generate_series(1, 7000) i;
+INSERT INTO skipscan_tbl SELECT NULL, i FROM generate_series(1, 10) i;
+CREATE INDEX skipscan_tbl_a ON skipscan_tbl (a);
+VACUUM ANALYZE skipscan_tbl;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET enable_hashagg = off;
+SELECT DISTINCT a FROM skipscan_tbl ORDER BY a;
+SELECT a FROM skipscan_tbl WHERE a > 3 GROUP BY a ORDER BY a;
+SELECT DISTINCT a FROM skipscan_tbl ORDER BY a DESC;
+SET gp_enable_index_skip_scan = off;
+SELECT DISTINCT a FROM skipscan_tbl ORDER BY a;
+RESET gp_enable_index_skip_scan;
+-- NULLs first in the index, so the backward scan reads them last
+DROP INDEX skipscan_tbl_a;
+CREATE INDEX skipscan_tbl_a ON skipscan_tbl (a NULLS FIRST);
+SELECT DISTINCT a FROM skipscan_tbl ORDER BY a NULLS FIRST;
+SELECT DISTINCT a FROM skipscan_tbl ORDER BY a DESC NULLS LAST;
+SELECT a FROM skipscan_tbl WHERE a < 3 GROUP BY a ORDER BY a DESC NULLS LAST;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+RESET enable_hashagg;
+DROP TABLE skipscan_tbl;
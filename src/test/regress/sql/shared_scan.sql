@@ -27,3 +27,18 @@ SELECT * FROM
         JOIN bar ON b = c
         ) AS XY
         JOIN jazz on c = e AND b = f;
+
+-- A writer that can't get a dynamic shared memory segment for its store,
+-- because all the slots are in use, writes it to files for the readers.
+SET gp_cte_sharing = on;
+SELECT gp_inject_fault_infinite('dsm_create_max_segments', 'skip', dbid) FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+
+WITH cte AS (SELECT * FROM bar)
+SELECT * FROM cte c1 JOIN cte c2 ON c1.d = c2.d ORDER BY 1;
+
+SELECT gp_wait_until_triggered_fault('dsm_create_max_segments', 1, dbid) FROM gp_segment_configuration WHERE role = 'p' AND content = 0;
+SELECT gp_inject_fault('dsm_create_max_segments', 'reset', dbid) FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+
+WITH cte AS (SELECT * FROM bar)
+SELECT * FROM cte c1 JOIN cte c2 ON c1.d = c2.d ORDER BY 1;
+RESET gp_cte_sharing;
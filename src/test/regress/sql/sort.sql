@@ -124,3 +124,16 @@ select * from colltest order by t COLLATE "C" NULLS FIRST;
 set gp_enable_motion_mk_sort=off;
 select * from colltest order by t COLLATE "C";
 select * from colltest order by t COLLATE "C" NULLS FIRST;
+
+--
+-- Test sorting fixed width keys with the radix sort of mk sort, with
+-- NULLS FIRST/LAST, DESC and several keys
+--
+set gp_enable_mk_sort = on;
+create table radixsort (i int, b int8, d date, ts timestamp) distributed by (i);
+insert into radixsort select i, (i * 7919) % 2000 - 1000, date '2000-01-01' + i % 10, timestamp '2000-01-01' + i * interval '1 minute' from generate_series(1, 2000) i;
+insert into radixsort select null, null, null, null from generate_series(1, 10);
+
+select count(*) from (select b, row_number() over (order by b desc nulls first) rn from radixsort) s where (b is null and rn > 10) or rn <> 1010 - b;
+select count(*) from (select b, row_number() over (order by b) rn from radixsort) s where (b is null and rn <= 2000) or rn <> b + 1001;
+select count(*) from (select i, row_number() over (order by d, ts desc) rn from radixsort where i is not null) s where rn <> (i % 10) * 200 + (2000 - i) / 10 + 1;
@@ -0,0 +1,56 @@
+--
+-- Cache of the results of correlated subplans (gp_enable_subplan_cache)
+--
+-- The functions raise a notice whenever the subplan actually runs.  The
+-- Postgres planner keeps the subqueries below as correlated subplans.
+--
+set optimizer = off;
+
+create function sc_square(int) returns int as $$
+begin
+  raise notice 'sc_square(%)', $1;
+  return $1 * $1;
+end;
+$$ language plpgsql immutable;
+
+create function sc_square_volatile(int) returns int as $$
+begin
+  raise notice 'sc_square_volatile(%)', $1;
+  return $1 * $1;
+end;
+$$ language plpgsql volatile;
+
+create function sc_add(int, int) returns int as $$
+begin
+  raise notice 'sc_add(%, %)', $1, $2;
+  return $1 + $2;
+end;
+$$ language plpgsql immutable;
+
+-- Repeated parameter values are looked up in the cache.
+select x, (select sc_square(x)) from (values (1), (2), (1), (2), (3)) v(x);
+select x from (values (1), (2), (1), (2), (3)) v(x)
+where exists (select 1 where sc_square(x) > 1);
+select x, array(select sc_square(x) union all select sc_square(x + 10))
+from (values (1), (1), (2)) v(x);
+
+-- NULL parameter values are cached like the others.
+select x, (select sc_square(x)) from (values (NULL), (1), (NULL), (1)) v(x);
+
+-- A volatile subplan runs for every row.
+select x, (select sc_square_volatile(x)) from (values (1), (2), (1), (2)) v(x);
+
+-- The cache is dropped when another parameter of the subplan changes.
+select y, (select array_agg((select sc_add(x, y)))
+           from (values (1), (1), (2)) w(x))
+from (values (10), (20), (10)) v(y);
+
+-- Without the cache, the subplan runs for every row.
+set gp_enable_subplan_cache = off;
+select x, (select sc_square(x)) from (values (1), (2), (1), (2), (3)) v(x);
+reset gp_enable_subplan_cache;
+
+reset optimizer;
+drop function sc_square(int);
+drop function sc_square_volatile(int);
+drop function sc_add(int, int);
@@ -775,3 +775,27 @@ select relname from pg_class where exists(select * from init_main_plan_parallel)
 -- case2: init plan is not parallel, main plan is parallel
 select * from init_main_plan_parallel where exists (select * from pg_class);
 
+-- Uncorrelated IN and NOT IN subplans, hashed or not, with NULLs on both sides
+create table hashed_subplan_outer (a int, b int);
+create table hashed_subplan_inner (c int);
+insert into hashed_subplan_outer values (1, 1), (2, 2), (3, NULL), (NULL, 4);
+insert into hashed_subplan_inner values (1), (NULL), (5);
+select a from hashed_subplan_outer where a in (select c from hashed_subplan_inner) or b = 4 order by 1;
+select a from hashed_subplan_outer where a not in (select c from hashed_subplan_inner where c is not null) or b = 2 order by 1;
+select a from hashed_subplan_outer where a not in (select c from hashed_subplan_inner) or b = 2 order by 1;
+
+-- The subplans of an uncorrelated IN are hashed by both optimizers. GPORCA
+-- rewrites <> ALL into NOT (= ANY) to hash it as well, the planner does not.
+set optimizer_enforce_subplans = on;
+explain (costs off) select a from hashed_subplan_outer where a in (select c from hashed_subplan_inner) or b = 4;
+explain (costs off) select a from hashed_subplan_outer where a <> all (select c from hashed_subplan_inner) or b = 2;
+select a from hashed_subplan_outer where a <> all (select c from hashed_subplan_inner where c is not null) or b = 2 order by 1;
+-- Nothing is hashed when the result of the subquery would not fit in work_mem
+create table hashed_subplan_big (c int) distributed by (c);
+insert into hashed_subplan_big select g from generate_series(1, 10000) g;
+analyze hashed_subplan_big;
+set work_mem = '64kB';
+explain (costs off) select a from hashed_subplan_outer where a in (select c from hashed_subplan_big) or b = 4;
+select a from hashed_subplan_outer where a in (select c from hashed_subplan_big) or b = 4 order by 1;
+reset work_mem;
+reset optimizer_enforce_subplans;
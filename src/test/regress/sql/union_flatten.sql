@@ -0,0 +1,69 @@
+--
+-- Chains of UNION ALL, or of UNION, translated into a single set operation
+-- for GPORCA
+--
+-- The parser makes a left-deep chain of set operations of the branches.  A
+-- chain of unions of one kind becomes one Append, like the Postgres planner
+-- makes it.  Unions of different kinds are not merged.
+--
+create table su_a (x int) distributed by (x);
+create table su_b (x int) distributed by (x);
+create table su_c (x int) distributed by (x);
+insert into su_a values (1), (2);
+insert into su_b values (2), (3);
+insert into su_c values (3), (4);
+analyze su_a;
+analyze su_b;
+analyze su_c;
+create function su_appends(query text) returns int as $$
+declare
+  line text;
+  n int := 0;
+begin
+  for line in execute 'explain (costs off) ' || query loop
+    if line like '%Append%' then
+      n := n + 1;
+    end if;
+  end loop;
+  return n;
+end;
+$$ language plpgsql;
+
+select su_appends('select x from su_a union all select x from su_b union all select x from su_c');
+select x from su_a union all select x from su_b union all select x from su_c order by 1;
+select su_appends('select x from su_a union select x from su_b union select x from su_c');
+select x from su_a union select x from su_b union select x from su_c order by 1;
+-- parenthesized on the right
+select su_appends('select x from su_a union all (select x from su_b union all select x from su_c)');
+select x from su_a union all (select x from su_b union all select x from su_c) order by 1;
+
+-- Unions of different kinds
+select su_appends('select x from su_a union all select x from su_b union select x from su_c');
+select x from su_a union all select x from su_b union select x from su_c order by 1;
+select su_appends('select x from su_a union select x from su_b union all select x from su_c');
+select x from su_a union select x from su_b union all select x from su_c order by 1;
+-- and other set operations
+select x from su_a union select x from su_b except select x from su_c order by 1;
+select x from su_a union all select x from su_b intersect select x from su_c order by 1;
+
+-- The types of all the branches are merged
+select x, pg_typeof(x) from (select 1 as x union all select 2::bigint
+  union all select 3.5) s order by x;
+
+-- Many branches
+select su_appends((select string_agg('select x from su_a', ' union all ')
+                   from generate_series(1, 100)));
+do $$
+declare
+  q text;
+  n bigint;
+begin
+  select string_agg('select x from su_a', ' union all ') into q
+    from generate_series(1, 100);
+  execute 'select count(*) from (' || q || ') s' into n;
+  raise notice 'rows: %', n;
+end;
+$$;
+
+drop function su_appends(text);
+drop table su_a, su_b, su_c;
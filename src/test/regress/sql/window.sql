@@ -788,3 +788,13 @@ SELECT to_char(SUM(n::float8) OVER (ORDER BY i ROWS BETWEEN CURRENT ROW AND 1 FO
 SELECT i, b, bool_and(b) OVER w, bool_or(b) OVER w
   FROM (VALUES (1,true), (2,true), (3,false), (4,false), (5,true)) v(i,b)
   WINDOW w AS (ORDER BY i ROWS BETWEEN CURRENT ROW AND 1 FOLLOWING);
+
+-- aggregates without an inverse transition function are evaluated from
+-- partial states over wide frames
+SELECT i, v, min(v) OVER w, max(v) OVER w,
+       max(v) FILTER (WHERE i % 2 = 0) OVER w AS max_even,
+       max(v::text) OVER w AS max_text
+  FROM (SELECT i, CASE WHEN i % 5 = 0 THEN NULL ELSE (i * 7) % 11 END AS v
+          FROM generate_series(1, 20) i) t
+  WINDOW w AS (ORDER BY i ROWS BETWEEN 3 PRECEDING AND 4 FOLLOWING)
+  ORDER BY i;
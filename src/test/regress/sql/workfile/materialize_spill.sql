@@ -57,6 +57,8 @@ SET statement_mem=1024;
 set gp_resqueue_print_operator_memory_limits=on;
 set enable_hashjoin = false;
 set enable_nestloop = true;
+-- The rows of test_mat_large compress well enough to not spill.
+set gp_materialize_compression = off;
 -- ORCA doesn't honor enable_nestloop/enable_hashjoin, so this won't produce
 -- the kind of plan we're looking for.
 set optimizer=off;
@@ -83,4 +85,9 @@ from num_workfiles_created($$
   select * FROM test_mat_small as t1 left outer join test_mat_large AS t2 on t1.i1=t2.i2 limit 10
 $$) as n;
 
+-- With compression, the Materialize keeps the rows compressed in memory, and
+-- returns the same ones.
+set gp_materialize_compression = on;
+select * FROM test_mat_small as t1 left outer join test_mat_large AS t2 on t1.i1=t2.i2 order by 1;
+
 drop schema materialize_spill cascade;